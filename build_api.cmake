@@ -31,7 +31,8 @@ endmacro()
 # add_unit_host_test(NAME test_name
 #					 SOURCES test_sources_files...
 #					 [DEPENDS list_of_dependencies...]
-#					 [INC_DIRS list_of_include_directories...])
+#					 [INC_DIRS list_of_include_directories...]
+#					 [DEFINITIONS list_of_compile_definitions...])
 function(add_unit_host_test)
 	# All test can use most recent standart
 	set(CMAKE_CXX_STANDARD 14)
@@ -45,7 +46,7 @@ function(add_unit_host_test)
 			UNIT_TEST
 			"OPTIONAL"
 			"NAME"
-			"SOURCES;DEPENDS;INC_DIRS"
+			"SOURCES;DEPENDS;INC_DIRS;DEFINITIONS"
 			${ARGN}
 			)
 
@@ -76,7 +77,302 @@ function(add_unit_host_test)
 				${UNIT_TEST_INC_DIRS})
 		endif()
 
+		if(UNIT_TEST_DEFINITIONS)
+			message("	Test definitions: ${UNIT_TEST_DEFINITIONS}")
+			target_compile_definitions(
+				${UNIT_TEST_NAME}
+				PRIVATE
+				${UNIT_TEST_DEFINITIONS})
+		endif()
+
 		target_include_directories(${UNIT_TEST_NAME} PRIVATE ${CPPUTEST_INCLUDE_DIRS})
 		message("-----------------------------------------------")
 	endif()
 endfunction()
+
+# Aggregate target, building all benchmarks. Benchmarks are not part
+# of the default build.
+macro(__ensure_benchmarks_target)
+	if (NOT TARGET benchmarks)
+		add_custom_target(benchmarks)
+	endif()
+endmacro()
+
+# Creates benchmark executable with name bench_${bench_name}.
+# Used by add_host_benchmark() and add_target_benchmark().
+# Main is provided by the bench library of the platform, it runs all
+# benchmarks, registered with ECL_BENCH(), and reports results.
+function(__add_benchmark BENCH_NAME BENCH_SOURCES BENCH_DEPENDS BENCH_INC_DIRS)
+	set(BENCH_TARGET bench_${BENCH_NAME})
+	message("-----------------------------------------------")
+	message("	Benchmark added: ${BENCH_TARGET}")
+	message("	Benchmark sources: ${BENCH_SOURCES}")
+
+	add_executable(${BENCH_TARGET} EXCLUDE_FROM_ALL
+		${BENCH_SOURCES}
+		${CORE_DIR}/lib/bench/${PLATFORM_NAME}/main.cpp)
+
+	set_target_properties(${BENCH_TARGET} PROPERTIES CXX_STANDARD 14)
+
+	# Measurements are meaningful only for optimized code,
+	# regardless of the project build type
+	target_compile_options(${BENCH_TARGET} PRIVATE -O2)
+	target_compile_definitions(${BENCH_TARGET} PRIVATE -DNDEBUG)
+
+	target_link_libraries(${BENCH_TARGET} bench)
+
+	if (BENCH_DEPENDS)
+		message("	Benchmark dependencies: ${BENCH_DEPENDS}")
+		target_link_libraries(${BENCH_TARGET} ${BENCH_DEPENDS})
+	endif()
+
+	if (BENCH_INC_DIRS)
+		message("	Benchmark includes: ${BENCH_INC_DIRS}")
+		target_include_directories(${BENCH_TARGET} PRIVATE ${BENCH_INC_DIRS})
+	endif()
+
+	__ensure_benchmarks_target()
+	add_dependencies(benchmarks ${BENCH_TARGET})
+	message("-----------------------------------------------")
+endfunction()
+
+# Creates a host benchmark with name bench_${bench_name}.
+# Benchmark is built only if not cross-compiling. Results are printed
+# to stdout, first argument filters benchmarks by name.
+#
+# Syntax:
+# add_host_benchmark(NAME bench_name
+#					 SOURCES bench_sources_files...
+#					 [DEPENDS list_of_dependencies...]
+#					 [INC_DIRS list_of_include_directories...])
+function(add_host_benchmark)
+	if (${CMAKE_HOST_SYSTEM_NAME} STREQUAL ${CMAKE_SYSTEM_NAME})
+		cmake_parse_arguments(BENCH "" "NAME" "SOURCES;DEPENDS;INC_DIRS" ${ARGN})
+
+		if (NOT DEFINED BENCH_NAME OR NOT DEFINED BENCH_SOURCES)
+			message(FATAL_ERROR "Benchmark sources and name must be defined!")
+		endif()
+
+		__add_benchmark(${BENCH_NAME} "${BENCH_SOURCES}"
+			"${BENCH_DEPENDS}" "${BENCH_INC_DIRS}")
+	endif()
+endfunction()
+
+# Creates a target benchmark with name bench_${bench_name}.
+# Benchmark is built only when cross-compiling, as firmware image linked
+# with the core. Results are printed to the console, see ecl::cout.
+#
+# Syntax:
+# add_target_benchmark(NAME bench_name
+#					   SOURCES bench_sources_files...
+#					   [DEPENDS list_of_dependencies...]
+#					   [INC_DIRS list_of_include_directories...])
+function(add_target_benchmark)
+	if (CMAKE_CROSSCOMPILING)
+		cmake_parse_arguments(BENCH "" "NAME" "SOURCES;DEPENDS;INC_DIRS" ${ARGN})
+
+		if (NOT DEFINED BENCH_NAME OR NOT DEFINED BENCH_SOURCES)
+			message(FATAL_ERROR "Benchmark sources and name must be defined!")
+		endif()
+
+		__add_benchmark(${BENCH_NAME} "${BENCH_SOURCES}"
+			"the_core;libcpp;${BENCH_DEPENDS}" "${BENCH_INC_DIRS}")
+	endif()
+endfunction()
+
+
+# Applies build profile, selected by CONFIG_BUILD_PROFILE, to all targets
+# created in the current directory and below. Profile overrides optimization
+# flags of the toolchain and CMAKE_BUILD_TYPE:
+#	size         - everything is built with -Os, except hot modules,
+#	               see build_profile_hot()
+#	speed        - everything is built with -O2
+#	speed_lto    - same as speed, with link-time optimization
+#	pgo_generate - host only, -O2 with instrumentation. Running the tests
+#	               or benchmarks writes profiles to CONFIG_BUILD_PGO_DIR
+#	pgo_use      - host only, -O2 guided by profiles from CONFIG_BUILD_PGO_DIR
+# Macro, so flags set here are seen by subdirectories.
+macro(apply_build_profile)
+	message(STATUS "Checking [CONFIG_BUILD_PROFILE]...")
+
+	if (NOT DEFINED CONFIG_BUILD_PGO_DIR)
+		set(CONFIG_BUILD_PGO_DIR ${CMAKE_BINARY_DIR}/pgo)
+	endif()
+
+	if (NOT DEFINED CONFIG_BUILD_PROFILE)
+		message(STATUS "CONFIG_BUILD_PROFILE is not set, toolchain flags are used")
+	elseif (CONFIG_BUILD_PROFILE STREQUAL "size")
+		add_compile_options(-Os -fno-lto)
+	elseif (CONFIG_BUILD_PROFILE STREQUAL "speed")
+		add_compile_options(-O2 -fno-lto)
+	elseif (CONFIG_BUILD_PROFILE STREQUAL "speed_lto")
+		add_compile_options(-O2 -flto -ffat-lto-objects)
+		set(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} -flto")
+
+		# Archives must keep LTO symbol tables, otherwise linker silently
+		# falls back to the fat objects
+		find_program(BUILD_PROFILE_GCC_AR NAMES ${CMAKE_C_COMPILER}-ar gcc-ar)
+		if (BUILD_PROFILE_GCC_AR)
+			set(CMAKE_AR ${BUILD_PROFILE_GCC_AR})
+		endif()
+	elseif (CONFIG_BUILD_PROFILE MATCHES "^pgo_(generate|use)$")
+		if (CMAKE_CROSSCOMPILING)
+			message(FATAL_ERROR "${CONFIG_BUILD_PROFILE} profile is available on host only")
+		endif()
+
+		if (CONFIG_BUILD_PROFILE STREQUAL "pgo_generate")
+			set(BUILD_PROFILE_PGO_FLAGS -fprofile-generate -fprofile-dir=${CONFIG_BUILD_PGO_DIR})
+		else()
+			# Code, changed after profiling, is compiled without the profile
+			set(BUILD_PROFILE_PGO_FLAGS -fprofile-use -fprofile-dir=${CONFIG_BUILD_PGO_DIR}
+				-fprofile-correction -Wno-missing-profile)
+		endif()
+
+		add_compile_options(-O2 -fno-lto ${BUILD_PROFILE_PGO_FLAGS})
+		string(REPLACE ";" " " BUILD_PROFILE_PGO_FLAGS "${BUILD_PROFILE_PGO_FLAGS}")
+		set(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} ${BUILD_PROFILE_PGO_FLAGS}")
+	else()
+		message(FATAL_ERROR "Unknown build profile: ${CONFIG_BUILD_PROFILE}")
+	endif()
+
+	if (DEFINED CONFIG_BUILD_PROFILE)
+		message(STATUS "Build profile: ${CONFIG_BUILD_PROFILE}")
+	endif()
+endmacro()
+
+# Marks target as a hot module, i.e. data paths, that are worth the size.
+# Hot modules are built for speed in the size profile, other profiles
+# are not affected.
+#
+# Syntax:
+# build_profile_hot(target)
+function(build_profile_hot BUILD_TARGET)
+	if (CONFIG_BUILD_PROFILE STREQUAL "size")
+		# Last optimization flag wins
+		target_compile_options(${BUILD_TARGET} PRIVATE -O2)
+	endif()
+
+	add_size_report(${BUILD_TARGET})
+endfunction()
+
+# Adds target to the size report, see add_size_report_target().
+#
+# Syntax:
+# add_size_report(target)
+function(add_size_report BUILD_TARGET)
+	set_property(GLOBAL APPEND PROPERTY SIZE_REPORT_TARGETS ${BUILD_TARGET})
+endfunction()
+
+# Creates 'size_report' target. It writes sizes of the project executable,
+# see register_project(), and of targets added by add_size_report() to
+# size-${CONFIG_BUILD_PROFILE}.txt in the build directory, so profiles
+# can be compared side by side. Called once, after all targets are created.
+function(add_size_report_target)
+	if (NOT CMAKE_SIZE)
+		find_program(CMAKE_SIZE size)
+		if (NOT CMAKE_SIZE)
+			message(STATUS "size utility is not found, size report is disabled")
+			return()
+		endif()
+	endif()
+
+	if (DEFINED CONFIG_BUILD_PROFILE)
+		set(SIZE_REPORT ${CMAKE_BINARY_DIR}/size-${CONFIG_BUILD_PROFILE}.txt)
+	else()
+		set(SIZE_REPORT ${CMAKE_BINARY_DIR}/size-default.txt)
+	endif()
+
+	get_property(SIZE_REPORT_TARGETS GLOBAL PROPERTY SIZE_REPORT_TARGETS)
+
+	set(SIZE_REPORT_FILES)
+	foreach (SIZE_TARGET ${SIZE_REPORT_TARGETS})
+		list(APPEND SIZE_REPORT_FILES $<TARGET_FILE:${SIZE_TARGET}>)
+	endforeach()
+
+	# Sections of the image and totals of every archive object
+	set(SIZE_REPORT_CMDS)
+	if (EXEC_PATH)
+		list(APPEND SIZE_REPORT_CMDS COMMAND ${CMAKE_SIZE} -A ${EXEC_PATH} > ${SIZE_REPORT})
+	else()
+		list(APPEND SIZE_REPORT_CMDS COMMAND ${CMAKE_COMMAND} -E remove ${SIZE_REPORT})
+	endif()
+
+	if (SIZE_REPORT_FILES)
+		list(APPEND SIZE_REPORT_CMDS COMMAND ${CMAKE_SIZE} -t ${SIZE_REPORT_FILES} >> ${SIZE_REPORT})
+	endif()
+
+	add_custom_target(size_report
+		${SIZE_REPORT_CMDS}
+		COMMENT "Writing size report to ${SIZE_REPORT}")
+
+	if (SIZE_REPORT_TARGETS)
+		add_dependencies(size_report ${SIZE_REPORT_TARGETS})
+	endif()
+endfunction()
+
+# Creates 'footprint' target. It attributes .text, .data and .bss of the
+# project executable, see register_project(), to libraries and to template
+# instantiations, using scripts/footprint.py. Report is printed and saved to
+# footprint.json in the build directory. If CONFIG_FOOTPRINT_BASELINE points
+# to a report, saved earlier, differences are printed as well.
+# Per-library sizes require a map file next to the image, <image>.map.
+function(add_footprint_target)
+	if (NOT EXEC_PATH)
+		return()
+	endif()
+
+	find_package(PythonInterp 3)
+	if (NOT PYTHONINTERP_FOUND)
+		message(STATUS "Python 3 is not found, footprint report is disabled")
+		return()
+	endif()
+
+	if (NOT CMAKE_NM)
+		find_program(CMAKE_NM nm)
+	endif()
+
+	set(FOOTPRINT_ARGS --elf ${EXEC_PATH} --nm ${CMAKE_NM}
+		--save ${CMAKE_BINARY_DIR}/footprint.json)
+
+	if (CMAKE_CROSSCOMPILING)
+		list(APPEND FOOTPRINT_ARGS --map ${EXEC_PATH}.map)
+	endif()
+
+	if (CONFIG_FOOTPRINT_BASELINE)
+		list(APPEND FOOTPRINT_ARGS --baseline ${CONFIG_FOOTPRINT_BASELINE})
+	endif()
+
+	add_custom_target(footprint
+		COMMAND ${PYTHON_EXECUTABLE} ${CORE_DIR}/scripts/footprint.py ${FOOTPRINT_ARGS}
+		COMMENT "Footprint of ${EXEC_PATH}")
+endfunction()
+
+# Creates 'bench_compare' target. It compares benchmark logs, listed in
+# CONFIG_BENCH_COMPARE as label=path entries, i.e. captured from images
+# built by GCC and Clang, using scripts/bench_compare.py. The first entry
+# is the reference. Sizes of images, listed in CONFIG_BENCH_COMPARE_IMAGES
+# the same way, are printed as well.
+function(add_bench_compare_target)
+	if (NOT CONFIG_BENCH_COMPARE)
+		return()
+	endif()
+
+	find_package(PythonInterp 3)
+	if (NOT PYTHONINTERP_FOUND)
+		message(STATUS "Python 3 is not found, benchmark comparison is disabled")
+		return()
+	endif()
+
+	if (NOT CMAKE_SIZE)
+		find_program(CMAKE_SIZE size)
+	endif()
+
+	set(BENCH_COMPARE_ARGS ${CONFIG_BENCH_COMPARE})
+	if (CONFIG_BENCH_COMPARE_IMAGES)
+		list(APPEND BENCH_COMPARE_ARGS --size ${CMAKE_SIZE} --elf ${CONFIG_BENCH_COMPARE_IMAGES})
+	endif()
+
+	add_custom_target(bench_compare
+		COMMAND ${PYTHON_EXECUTABLE} ${CORE_DIR}/scripts/bench_compare.py ${BENCH_COMPARE_ARGS}
+		COMMENT "Comparing benchmark results")
+endfunction()
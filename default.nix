@@ -15,6 +15,6 @@ let
 in with pkgs; {
   coreEnv = stdenv.mkDerivation {
     name = "thecore";
-    buildInputs = [ cmake gcc5 cppcheck cpputest gcc-arm-embedded doxygen ];
+    buildInputs = [ cmake gcc5 cppcheck cpputest gcc-arm-embedded doxygen python3 ];
   };
 }
@@ -0,0 +1,163 @@
+// Benchmarks of the generic bus.
+//
+// Bus type is taken from bench_bus.hpp: zero-latency loopback on host,
+// real SPI or USART with MOSI wired to MISO (TX to RX) on target. Results
+// are time per call, thus:
+//
+//  - xfer_1 is the fixed overhead of a transfer, its reciprocal is
+//    the maximum transaction rate;
+//  - xfer_256 minus xfer_1, divided by 256, is the time per byte;
+//  - chain_4x64 vs separate_4x64 shows what scatter-gather saves;
+//  - submit_64 vs xfer_64 shows the cost of the transaction queue;
+//  - async_64 vs xfer_64 shows the cost of the async path;
+//  - async_latency is the time from the start of a 1-byte xfer till
+//    the user handler gets the final event.
+
+#include <bench_bus.hpp>
+#include <dev/bus_pipe.hpp>
+
+#include <ecl/bench.hpp>
+
+namespace
+{
+
+constexpr size_t buf_size = 256;
+constexpr size_t seg_size = 64;
+
+uint8_t tx_buf[buf_size];
+uint8_t rx_buf[buf_size];
+
+const ecl::bus_segment chain[] = {
+    { tx_buf,                  rx_buf,                  seg_size, 0xff },
+    { tx_buf + seg_size,       rx_buf + seg_size,       seg_size, 0xff },
+    { tx_buf + seg_size * 2,   rx_buf + seg_size * 2,   seg_size, 0xff },
+    { tx_buf + seg_size * 3,   rx_buf + seg_size * 3,   seg_size, 0xff },
+};
+
+constexpr ecl::bench::options bus_options = { 3, 15, 100 };
+
+// Bus is inited lazily: static members of the bus template are constructed
+// in unspecified order relative to objects of this file. Init of inited
+// bus is a single branch and doesn't affect results.
+void lock()
+{
+    bench_bus::init();
+    bench_bus::lock();
+}
+
+void xfer_locked(size_t size)
+{
+    lock();
+    bench_bus::set_buffers(tx_buf, rx_buf, size);
+    bench_bus::xfer();
+    bench_bus::unlock();
+}
+
+void async_handler(ecl::bus_channel, ecl::bus_event, size_t) { }
+
+ecl::bench::clock::rep handled_at;
+
+void stamp_handler(ecl::bus_channel ch, ecl::bus_event type, size_t)
+{
+    if (ch == ecl::bus_channel::meta && type == ecl::bus_event::tc) {
+        handled_at = ecl::bench::clock::now();
+    }
+}
+
+volatile int completed;
+
+void on_complete(ecl::bus_transaction &)
+{
+    completed = completed + 1;
+}
+
+ecl::bus_transaction trans = { tx_buf, rx_buf, seg_size, 0, on_complete,
+                               ecl::err::ok, 0, 0, nullptr };
+
+} // namespace
+
+ECL_BENCH_OPTS(xfer_1, bus_options)
+{
+    xfer_locked(1);
+}
+
+ECL_BENCH_OPTS(xfer_64, bus_options)
+{
+    xfer_locked(seg_size);
+}
+
+ECL_BENCH_OPTS(xfer_256, bus_options)
+{
+    xfer_locked(buf_size);
+}
+
+ECL_BENCH_OPTS(fill_256, bus_options)
+{
+    lock();
+    bench_bus::set_buffers(buf_size);
+    bench_bus::xfer();
+    bench_bus::unlock();
+}
+
+ECL_BENCH_OPTS(chain_4x64, bus_options)
+{
+    lock();
+    bench_bus::set_buffers(chain, 4);
+    bench_bus::xfer();
+    bench_bus::unlock();
+}
+
+ECL_BENCH_OPTS(separate_4x64, bus_options)
+{
+    bench_bus::lock();
+    for (auto &seg : chain) {
+        bench_bus::set_buffers(seg.tx, seg.rx, seg.size);
+        bench_bus::xfer();
+    }
+    bench_bus::unlock();
+}
+
+ECL_BENCH_OPTS(submit_64, bus_options)
+{
+    int expected = completed + 1;
+
+    bench_bus::init();
+    bench_bus::submit(trans);
+
+    // Transaction ends asynchronously when the bus is real
+    while (completed != expected) { }
+}
+
+ECL_BENCH_OPTS(async_64, bus_options)
+{
+    lock();
+    bench_bus::set_buffers(tx_buf, rx_buf, seg_size);
+    bench_bus::xfer(async_handler);
+    // Unlocking makes next lock() to wait for the completion
+    bench_bus::unlock();
+}
+
+ECL_BENCH_MANUAL(async_latency, bus_options)
+{
+    lock();
+    bench_bus::set_buffers(tx_buf, rx_buf, 1);
+
+    auto start = ecl::bench::clock::now();
+    bench_bus::xfer(stamp_handler);
+    bench_bus::unlock();
+
+    // Handler has been run once bus is acquired again
+    bench_bus::lock();
+    bench_bus::unlock();
+
+    return handled_at - start;
+}
+
+ECL_BENCH_OPTS(pipe_write_256, bus_options)
+{
+    static ecl::bus_pipe< bench_bus > pipe;
+
+    pipe.init();
+    auto ret = pipe.write(tx_buf, buf_size);
+    ecl::bench::do_not_optimize(ret);
+}
@@ -0,0 +1,13 @@
+#ifndef DEV_BUS_BENCH_HOST_BENCH_BUS_HPP_
+#define DEV_BUS_BENCH_HOST_BENCH_BUS_HPP_
+
+// Bus under benchmark. On host it is the loopback mock, so the results
+// show the cost of the generic bus alone.
+// Target projects provide own bench_bus.hpp, see dev/bus/CMakeLists.txt.
+
+#include <dev/bus.hpp>
+#include <loopback_bus.hpp>
+
+using bench_bus = ecl::generic_bus< loopback_bus >;
+
+#endif // DEV_BUS_BENCH_HOST_BENCH_BUS_HPP_
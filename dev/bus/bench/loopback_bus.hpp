@@ -0,0 +1,119 @@
+#ifndef DEV_BUS_BENCH_LOOPBACK_BUS_HPP_
+#define DEV_BUS_BENCH_LOOPBACK_BUS_HPP_
+
+//!
+//! \file
+//! \brief Zero-latency platform bus, used to measure generic bus itself.
+//! Transmitted data is looped back to the receive buffer and all events
+//! are delivered right from do_xfer(), as if DMA and IRQ took no time.
+//!
+
+#include <ecl/err.hpp>
+#include <platform/common/bus.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//!
+//! \brief Platform bus with MOSI wired to MISO and infinitely fast wire.
+//!
+class loopback_bus
+{
+public:
+    using channel    = ecl::bus_channel;
+    using event      = ecl::bus_event;
+    using handler_fn = ecl::bus_handler;
+
+    loopback_bus()
+        :m_tx{nullptr}
+        ,m_rx{nullptr}
+        ,m_tx_size{0}
+        ,m_rx_size{0}
+        ,m_fill{0xff}
+        ,m_handler{}
+        ,m_xfers{0}
+    { }
+
+    loopback_bus(const loopback_bus &) = delete;
+    loopback_bus &operator=(const loopback_bus &) = delete;
+
+    ecl::err init() { return ecl::err::ok; }
+
+    void reset_buffers()
+    {
+        m_tx = nullptr;
+        m_rx = nullptr;
+        m_tx_size = m_rx_size = 0;
+    }
+
+    void set_tx(const uint8_t *tx, size_t size)
+    {
+        m_tx = tx;
+        m_tx_size = tx ? size : 0;
+    }
+
+    void set_rx(uint8_t *rx, size_t size)
+    {
+        m_rx = rx;
+        m_rx_size = rx ? size : 0;
+    }
+
+    void set_tx(size_t size, uint8_t fill_byte)
+    {
+        m_tx = nullptr;
+        m_tx_size = size;
+        m_fill = fill_byte;
+    }
+
+    void set_handler(const handler_fn &handler) { m_handler = handler; }
+    void reset_handler() { m_handler = handler_fn{}; }
+
+    ecl::err do_xfer()
+    {
+        if (m_rx) {
+            if (m_tx) {
+                memcpy(m_rx, m_tx, m_rx_size);
+            } else {
+                memset(m_rx, m_fill, m_rx_size);
+            }
+        }
+
+        ++m_xfers;
+
+        // Same order as DMA-driven buses deliver events
+        if (m_tx_size) {
+            m_handler(channel::tx, event::tc, m_tx_size);
+        }
+
+        if (m_rx_size) {
+            m_handler(channel::rx, event::tc, m_rx_size);
+        }
+
+        m_handler(channel::meta, event::tc, 0);
+
+        return ecl::err::ok;
+    }
+
+    // Streaming never ends on its own, thus cannot be delivered synchronously
+    void set_double_buffers(const uint8_t *, const uint8_t *, uint8_t *, uint8_t *, size_t) { }
+    ecl::err do_stream() { return ecl::err::notsup; }
+    ecl::err stop_stream() { return ecl::err::perm; }
+
+    ecl::err set_clock(uint32_t) { return ecl::err::ok; }
+    ecl::err set_mode(uint16_t, uint16_t) { return ecl::err::ok; }
+
+    //! Gets amount of do_xfer() calls, i.e. how many times DMA was started.
+    uint32_t xfers() const { return m_xfers; }
+
+private:
+    const uint8_t   *m_tx;      //!< Data to transmit.
+    uint8_t         *m_rx;      //!< Buffer to receive a data.
+    size_t          m_tx_size;  //!< Size of transmitted data.
+    size_t          m_rx_size;  //!< Size of received data.
+    uint8_t         m_fill;     //!< Fill byte, if no data is transmitted.
+    handler_fn      m_handler;  //!< Handler of generic bus.
+    uint32_t        m_xfers;    //!< Amount of started xfers.
+};
+
+#endif // DEV_BUS_BENCH_LOOPBACK_BUS_HPP_
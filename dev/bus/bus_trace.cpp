@@ -0,0 +1,62 @@
+#include <dev/bus_trace.hpp>
+
+#if __STDC_HOSTED__
+#include <chrono>
+#endif
+
+ecl::bus_trace_log ecl_bus_trace;
+
+namespace ecl
+{
+
+uint8_t bus_trace::attach(const void *pbus)
+{
+    static uint8_t buses;
+
+    if (ecl_bus_trace.hdr.magic != bus_trace_magic) {
+        bus_trace_clock_init();
+
+        ecl_bus_trace.hdr.version  = bus_trace_version;
+        ecl_bus_trace.hdr.capacity = CONFIG_BUS_TRACE_SIZE;
+        ecl_bus_trace.hdr.clock_hz = bus_trace_clock_hz();
+        ecl_bus_trace.hdr.magic    = bus_trace_magic;
+    }
+
+    auto id = buses++;
+    record(id, bus_trace_event::init, reinterpret_cast< uintptr_t >(pbus), 0);
+
+    return id;
+}
+
+void bus_trace::reset()
+{
+    for (auto &r : ecl_bus_trace.records) {
+        r = bus_trace_record{};
+    }
+
+    ecl_bus_trace.hdr.head = 0;
+}
+
+#if __STDC_HOSTED__
+// Default clock of hosted builds, in microseconds.
+// Platforms and tests override it.
+
+__attribute__((weak)) void bus_trace_clock_init()
+{
+}
+
+__attribute__((weak)) uint32_t bus_trace_clock()
+{
+    using namespace std::chrono;
+
+    auto now = steady_clock::now().time_since_epoch();
+    return duration_cast< microseconds >(now).count();
+}
+
+__attribute__((weak)) uint32_t bus_trace_clock_hz()
+{
+    return 1000000;
+}
+#endif
+
+} // namespace ecl
@@ -0,0 +1,463 @@
+#ifndef DEV_BUS_DEV_BUFFERED_BUS_PIPE_HPP_
+#define DEV_BUS_DEV_BUFFERED_BUS_PIPE_HPP_
+
+//!
+//! \file
+//! \brief      Buffered bus pipe module.
+//! \copyright
+//!
+
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+#include <ecl/thread/mutex.hpp>
+
+#include <platform/common/bus.hpp>
+
+#include "byte_ring.hpp"
+
+#include <atomic>
+
+namespace ecl
+{
+
+//!
+//! \brief Buffered bus pipe (non-blocking) adapter.
+//! Unlike bus_pipe, writer is not blocked until data will be transferred.
+//! Data is copied to the ring and then drained by async bus xfers,
+//! directly from the ring storage. When one portion of data is transferred,
+//! next one is started from the bus event handler, without involving a writer.
+//! Received data is staged in another ring, so reader can consume it
+//! in portions of any size.
+//! Both rings can be also accessed in place, with no copies involved.
+//! \sa acquire_write()
+//! \sa peek_read()
+//! \tparam GBus Generic bus driver.
+//! \tparam N    Size of each ring. Must be a power of two.
+//! \sa generic_bus
+//! \sa bus_pipe
+//!
+template< class GBus, size_t N >
+class buffered_bus_pipe
+{
+public:
+    //!
+    //! \brief Constructs a pipe.
+    //!
+    buffered_bus_pipe();
+    //!
+    //! \brief Destructs a pipe.
+    //!
+    ~buffered_bus_pipe();
+
+    //!
+    //! \brief Inits a pipe.
+    //! Lazy initialization. Inis a bus.
+    //! \return Status of operation.
+    //!
+    ecl::err init();
+
+    //!
+    //! \brief Writes a data to a pipe.
+    //! Data is copied to the ring and transferred in background. If ring
+    //! hasn't enough space, only part of data is copied.
+    //! Errors that occur during background transfer are reported by
+    //! \sa last_error() call.
+    //! \pre Bus is initialized.
+    //! \param[in]  data     Data to write. Must not be null.
+    //! \param[in]  count    Count of bytes that must be written to a pipe.
+    //!                      Can be zero.
+    //! \return     Value indicating either error if negative or
+    //!             amount of bytes accepted if positive. If ring is full,
+    //!             -1 is returned and last error is set to err::again.
+    //!
+    ssize_t write(const uint8_t *data, size_t count);
+
+    //!
+    //! \brief Reads a data from a pipe.
+    //! Data that was staged previously is returned first. If there is no such
+    //! data then caller is blocked until bus will receive it. No more than
+    //! size bytes are requested from the bus, so slave is never clocked
+    //! for data nobody asked for.
+    //! \pre Bus is initialized and buffer is valid.
+    //! \param[out] buffer     Data buffer to read to. Must not be null.
+    //! \param[in]  size       Size of a buffer. Can be zero.
+    //! \return     Value indicating an error if negative or bytes stored
+    //!             to a buffer if positive.
+    //!
+    ssize_t read(uint8_t *buffer, size_t size);
+
+    //!
+    //! \brief Reads a data from a pipe, without blocking.
+    //! Only data that was staged previously is returned, bus xfer is never
+    //! started. Suitable for polling, i.e. by ecl::istream::readsome().
+    //! \pre Bus is initialized and buffer is valid.
+    //! \param[out] buffer     Data buffer to read to. Must not be null.
+    //! \param[in]  size       Size of a buffer. Can be zero.
+    //! \return     Bytes stored to a buffer. If nothing is staged or other
+    //!             reader is active, -1 is returned and last error is set
+    //!             to err::again.
+    //!
+    ssize_t try_read(uint8_t *buffer, size_t size);
+
+    //!
+    //! \brief Lends contiguous span of the tx ring to fill it in place.
+    //! Unlike write(), data is not copied: caller formats it directly
+    //! in the pipe storage and then passes it to the bus by commit() call.
+    //! Writers are serialized until commit() is called, thus acquire_write()
+    //! and commit() must always be used in pairs by the same thread.
+    //! \pre Bus is initialized.
+    //! \param[in] size Amount of bytes required. Must not be zero.
+    //! \return Pointer to the span or nullptr if there is no contiguous
+    //!         space of given size. In latter case, last error is set
+    //!         to err::again and commit() must not be called.
+    //!
+    uint8_t *acquire_write(size_t size);
+
+    //!
+    //! \brief Passes data placed to the span lent by acquire_write() to the bus.
+    //! \pre Span is acquired by acquire_write().
+    //! \param[in] count Amount of bytes written to the span. Must not be
+    //!                  greater than size requested. Can be zero.
+    //!
+    void commit(size_t count);
+
+    //!
+    //! \brief Lends contiguous span of received data.
+    //! Unlike read(), data is not copied: caller parses it in place
+    //! and then releases it by consume() call.
+    //! If there is no data staged then caller is blocked until bus
+    //! will receive it, same as for read().
+    //! Readers are serialized until consume() is called, thus peek_read()
+    //! and consume() must always be used in pairs by the same thread.
+    //! \pre Bus is initialized.
+    //! \param[in]  size Most bytes to receive, if nothing is staged.
+    //!                  Must not be zero.
+    //! \param[out] len  Length of the span.
+    //! \return Pointer to the span or nullptr if error occurred before xfer
+    //!         has started. In latter case consume() must not be called.
+    //!
+    const uint8_t *peek_read(size_t size, size_t &len);
+
+    //!
+    //! \brief Releases data lent by peek_read().
+    //! \pre Span is lent by peek_read().
+    //! \param[in] count Amount of bytes to release. Must not be greater
+    //!                  than length of the span. Can be zero.
+    //!
+    void consume(size_t count);
+
+    //!
+    //! \brief Checks if all written data is transferred.
+    //! \retval true  Nothing left to transfer.
+    //! \retval false Data is being transferred.
+    //!
+    bool flushed() const;
+
+    //!
+    //! \brief Gets last error occurred.
+    //! \return Error defined in ecl::err
+    //!
+    ecl::err last_error() const;
+
+private:
+    //!
+    //! \brief Starts async xfer of data contained in the tx ring.
+    //! \pre Transfer is marked as active.
+    //!
+    void start_tx();
+
+    //!
+    //! \brief Starts async xfer, unless it is already running.
+    //!
+    void kick_tx();
+
+    //!
+    //! \brief Stages data to the rx ring, if it is empty.
+    //! Caller is blocked until xfer is completed.
+    //! \pre Readers are serialized.
+    //! \param[in] size Most bytes to receive.
+    //! \retval true  Data is staged or ring wasn't empty.
+    //! \retval false Error occurred before xfer has started.
+    //!
+    bool fill_rx(size_t size);
+
+    //!
+    //! \brief Handles bus events of the async xfer.
+    //! Executed in ISR context.
+    //!
+    void tx_handler(bus_channel ch, bus_event type, size_t total);
+
+    GBus                m_gbus;         //!< Generic bus.
+    err                 m_last;         //!< Last bus error.
+    byte_ring< N >      m_tx;           //!< Data to transmit.
+    byte_ring< N >      m_rx;           //!< Data received.
+    ecl::mutex          m_wlock;        //!< Serializes writers.
+    ecl::mutex          m_rlock;        //!< Serializes readers.
+    std::atomic_bool    m_tx_active;    //!< Async xfer is in progress.
+    size_t              m_tx_len;       //!< Length of span being transferred.
+};
+
+template< class GBus, size_t N >
+buffered_bus_pipe< GBus, N >::buffered_bus_pipe()
+    :m_gbus{}
+    ,m_last{err::ok}
+    ,m_tx{}
+    ,m_rx{}
+    ,m_wlock{}
+    ,m_rlock{}
+    ,m_tx_active{false}
+    ,m_tx_len{0}
+{
+
+}
+
+template< class GBus, size_t N >
+buffered_bus_pipe< GBus, N >::~buffered_bus_pipe()
+{
+
+}
+
+template< class GBus, size_t N >
+ecl::err buffered_bus_pipe< GBus, N >::init()
+{
+    return (m_last = m_gbus.init());
+}
+
+template< class GBus, size_t N >
+ssize_t buffered_bus_pipe< GBus, N >::write(const uint8_t *data, size_t count)
+{
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, data);
+
+    if (!count)
+        return count;
+
+    m_wlock.lock();
+    auto copied = m_tx.write(data, count);
+    m_wlock.unlock();
+
+    if (!copied) {
+        m_last = err::again;
+        return -1;
+    }
+
+    kick_tx();
+
+    return copied;
+}
+
+template< class GBus, size_t N >
+ssize_t buffered_bus_pipe< GBus, N >::read(uint8_t *buffer, size_t size)
+{
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, buffer);
+
+    if (!size)
+        return size;
+
+    m_rlock.lock();
+
+    if (!fill_rx(size)) {
+        m_rlock.unlock();
+        return -1;
+    }
+
+    auto ret = m_rx.read(buffer, size);
+
+    m_rlock.unlock();
+
+    return ret;
+}
+
+template< class GBus, size_t N >
+ssize_t buffered_bus_pipe< GBus, N >::try_read(uint8_t *buffer, size_t size)
+{
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, buffer);
+
+    if (!size)
+        return size;
+
+    if (!m_rlock.try_lock()) {
+        m_last = err::again;
+        return -1;
+    }
+
+    auto ret = m_rx.read(buffer, size);
+
+    m_rlock.unlock();
+
+    if (!ret) {
+        m_last = err::again;
+        return -1;
+    }
+
+    return ret;
+}
+
+template< class GBus, size_t N >
+uint8_t *buffered_bus_pipe< GBus, N >::acquire_write(size_t size)
+{
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, size);
+
+    size_t len;
+
+    m_wlock.lock();
+
+    auto span = m_tx.write_span(len);
+
+    if (len < size) {
+        m_wlock.unlock();
+        m_last = err::again;
+        return nullptr;
+    }
+
+    return span;
+}
+
+template< class GBus, size_t N >
+void buffered_bus_pipe< GBus, N >::commit(size_t count)
+{
+    m_tx.commit(count);
+    m_wlock.unlock();
+
+    if (count) {
+        kick_tx();
+    }
+}
+
+template< class GBus, size_t N >
+const uint8_t *buffered_bus_pipe< GBus, N >::peek_read(size_t size, size_t &len)
+{
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, size);
+
+    m_rlock.lock();
+
+    if (!fill_rx(size)) {
+        m_rlock.unlock();
+        len = 0;
+        return nullptr;
+    }
+
+    return m_rx.read_span(len);
+}
+
+template< class GBus, size_t N >
+void buffered_bus_pipe< GBus, N >::consume(size_t count)
+{
+    m_rx.consume(count);
+    m_rlock.unlock();
+}
+
+template< class GBus, size_t N >
+bool buffered_bus_pipe< GBus, N >::flushed() const
+{
+    return !m_tx_active.load() && m_tx.empty();
+}
+
+template< class GBus, size_t N >
+err buffered_bus_pipe< GBus, N >::last_error() const
+{
+    return m_last;
+}
+
+//------------------------------------------------------------------------------
+
+template< class GBus, size_t N >
+void buffered_bus_pipe< GBus, N >::start_tx()
+{
+    auto span = m_tx.read_span(m_tx_len);
+
+    m_gbus.lock();
+    m_gbus.set_buffers(span, nullptr, m_tx_len);
+
+    auto rc = m_gbus.xfer([this](bus_channel ch, bus_event type, size_t total) {
+        tx_handler(ch, type, total);
+    });
+
+    m_gbus.unlock();
+
+    if (is_error(rc)) {
+        m_last = rc;
+        m_tx_active = false;
+    }
+}
+
+template< class GBus, size_t N >
+void buffered_bus_pipe< GBus, N >::kick_tx()
+{
+    // Handler may be draining the ring at this moment. It will pick up
+    // new data by itself.
+    if (!m_tx_active.exchange(true)) {
+        start_tx();
+    }
+}
+
+template< class GBus, size_t N >
+bool buffered_bus_pipe< GBus, N >::fill_rx(size_t size)
+{
+    if (!m_rx.empty()) {
+        return true;
+    }
+
+    size_t len;
+    size_t received = 0;
+    auto span = m_rx.write_span(len);
+
+    if (len > size) {
+        len = size;
+    }
+
+    m_gbus.lock();
+    m_gbus.set_buffers(nullptr, span, len);
+
+    m_last = m_gbus.xfer(nullptr, &received);
+
+    m_gbus.unlock();
+
+    m_rx.commit(received);
+
+    // Error occur, right at the start
+    return !(is_error(m_last) && m_last != err::io);
+}
+
+template< class GBus, size_t N >
+void buffered_bus_pipe< GBus, N >::tx_handler(bus_channel ch, bus_event type, size_t total)
+{
+    (void) total;
+
+    if (type == bus_event::err) {
+        m_last = err::io;
+
+        // Continuation is failed, nothing will be transferred further
+        if (ch == bus_channel::meta) {
+            m_tx_active = false;
+        }
+
+        return;
+    }
+
+    if (ch != bus_channel::meta || type != bus_event::tc) {
+        return;
+    }
+
+    m_tx.consume(m_tx_len);
+
+    auto span = m_tx.read_span(m_tx_len);
+
+    if (!m_tx_len) {
+        m_tx_active = false;
+
+        // Writer could put data right before flag was cleared, without
+        // starting a xfer. Check it once again.
+        span = m_tx.read_span(m_tx_len);
+        if (!m_tx_len || m_tx_active.exchange(true)) {
+            return;
+        }
+    }
+
+    if (is_error(GBus::set_next_buffers(span, nullptr, m_tx_len))) {
+        m_tx_active = false;
+    }
+}
+
+} // namespace ecl
+
+#endif // DEV_BUS_DEV_BUFFERED_BUS_PIPE_HPP_
@@ -10,16 +10,99 @@
 
 #include <ecl/err.hpp>
 #include <ecl/thread/mutex.hpp>
-#include <ecl/thread/semaphore.hpp>
+#include <ecl/thread/completion.hpp>
+#include <ecl/thread/sleep_lock.hpp>
 #include <ecl/assert.h>
+#include <ecl/prof.hpp>
 
 #include <platform/common/bus.hpp>
 
+#ifdef CONFIG_BUS_TRACE
+#include <dev/bus_trace.hpp>
+#endif
+
 #include <atomic>
+#include <functional>
+
+#ifndef CONFIG_BUS_RETRIES
+//! Default amount of retries of failed blocking xfer, see bus_retry_policy.
+#define CONFIG_BUS_RETRIES 0
+#endif
 
 namespace ecl
 {
 
+//! \brief Retry policy of the generic bus.
+//!
+//! Blocking xfer, that started but failed, is repeated as a whole,
+//! segment chain included. Thus, retries make sense only if device tolerates
+//! repeated xfers, e.g. display data or commands, that are re-sent
+//! by the protocol itself.
+//! \sa generic_bus::set_retry_policy()
+//!
+struct bus_retry_policy
+{
+    uint8_t     retries;    //!< Amount of retries. Zero disables retries.
+
+    //! Called before each retry with the number of this retry, starting
+    //! from 1. Optional. Executed in thread context, thus allowed to sleep.
+    void        (*backoff)(unsigned retry);
+};
+
+//! \brief Error counters of the generic bus.
+//! \sa generic_bus::stats()
+//!
+struct bus_stats
+{
+    uint32_t    errors;     //!< Error events reported by the platform bus.
+    uint32_t    resets;     //!< Platform bus recoveries after errors.
+    uint32_t    retries;    //!< Blocking xfers repeated due to errors.
+    uint32_t    recovered;  //!< Blocking xfers succeeded after retry.
+    uint32_t    failed;     //!< Blocking xfers failed, all retries included.
+};
+
+namespace detail
+{
+
+//! Recovers platform bus after error, if bus supports it.
+template< class PBus >
+auto bus_recover(PBus &bus, int) -> decltype(bus.recover())
+{
+    return bus.recover();
+}
+
+//! Platform bus can't be recovered.
+template< class PBus >
+err bus_recover(PBus &bus, long)
+{
+    (void) bus;
+    return err::notsup;
+}
+
+} // namespace detail
+
+//! \brief Transaction, submitted to the generic bus queue.
+//!
+//! Rules for buffers are the same as for bus_segment.
+//! Transaction must remain valid until its completion callback is invoked.
+//! \sa generic_bus::submit()
+//!
+struct bus_transaction
+{
+    const uint8_t   *tx;        //!< Data to transmit. Optional.
+    uint8_t         *rx;        //!< Buffer to receive a data. Optional.
+    size_t          size;       //!< Size of buffers.
+    uint8_t         priority;   //!< Priority, higher is more urgent.
+
+    //! Completion callback. Likely executed in ISR context.
+    std::function< void(bus_transaction &t) > complete;
+
+    err             status = err::ok;   //!< Status of the transaction, set on completion.
+    size_t          sent = 0;           //!< Bytes sent, set on completion.
+    size_t          received = 0;       //!< Bytes received, set on completion.
+    bus_transaction *next = nullptr;    //!< Used internally by the queue.
+};
+
 //! \brief Generic bus interface.
 //!
 //! The generic bus is useful adapter, that allows to:
@@ -68,6 +151,20 @@ public:
     //!
     static void lock();
 
+    //! \brief Locks a bus and sets its clock.
+    //!
+    //! Clients that require different bus speed must use this overload,
+    //! so the clock requested by previous owner doesn't affect next one.
+    //! Platform bus must support clock configuration in order to use this.
+    //! Bus is locked regardless of the returned status.
+    //! \pre    Bus is inited successfully.
+    //! \post   Bus is locked.
+    //! \param[in] clk  Desired clock of the bus, in Hz.
+    //! \return Status of clock configuration.
+    //! \sa     lock()
+    //!
+    static err lock(uint32_t clk);
+
     //! \brief Unlocks a bus.
     //!
     //! Any operations beside lock() is not permitted after this method finishes.
@@ -122,6 +219,30 @@ public:
     //!
     static err set_buffers(size_t size, uint8_t fill_byte = 0xff);
 
+    //! \brief Sets a chain of segments to be transferred within single xfer.
+    //!
+    //! Segments are executed back-to-back, in given order. Next segment is
+    //! started right from the platform bus event handler (most likely from
+    //! the ISR context) when previous one is complete, so no thread wakeups
+    //! are involved between segments. Completion of the whole chain is
+    //! signalled once, as if it was single xfer.
+    //!
+    //! Byte counters, reported either via xfer() out-parameters or via
+    //! user-supplied handler, are accumulated accross the whole chain.
+    //! If error occurs in any segment, then rest of the chain is not executed.
+    //! \par Side effects:
+    //! \li Bus will remember a chain, until unlock() or set_buffers()
+    //!     will be called. Segment array must stay valid till that moment.
+    //! \pre       Bus is locked.
+    //! \post      Bus is ready to execute xfer.
+    //! \param[in] segs         Array of segments.
+    //! \param[in] n            Amount of segments in the array.
+    //! \retval    err::ok      Chain successfully set.
+    //! \retval    err::inval   Chain is empty or null.
+    //! \retval    err::again   Device is still executing async xfer.
+    //!
+    static err set_buffers(const bus_segment *segs, size_t n);
+
     //! \brief Performs xfer in blocking mode using buffers set previously.
     //!
     //! If underlying bus works in half-duplex mode then first tx transaction
@@ -138,7 +259,9 @@ public:
     //! \retval     err::ok     Data is sent successfully.
     //! \retval     err::busy   Device is still executing async xfer.
     //! \retval     err::io     Transaction started but failed.
+    //!                         Retries, if any, are exhausted.
     //! \retval     err         Any other error that can occur in platform bus
+    //! \sa         set_retry_policy()
     //!
     static err xfer(size_t *sent = nullptr, size_t *received = nullptr);
 
@@ -164,8 +287,121 @@ public:
     //!
     static err xfer(const bus_handler &handler);
 
+    //! \brief Sets double buffers for streaming xfer.
+    //!
+    //! Platform bus must support streaming in order to use this.
+    //! \sa stream()
+    //! \pre       Bus is locked.
+    //! \post      Bus is ready to execute streaming xfer.
+    //! \param[in] tx0     First buffer to transmit. Optional.
+    //! \param[in] tx1     Second buffer to transmit. Optional.
+    //! \param[in] rx0     First buffer to receive a data. Optional.
+    //! \param[in] rx1     Second buffer to receive a data. Optional.
+    //! \param[in] size    Size of each buffer.
+    //! \retval    err::ok      Buffers successfully set.
+    //! \retval    err::inval   All buffers are null.
+    //! \retval    err::again   Device is still executing async xfer.
+    //!
+    static err set_double_buffers(const uint8_t *tx0, const uint8_t *tx1,
+                                  uint8_t *rx0, uint8_t *rx1, size_t size);
+
+    //! \brief Starts continuous streaming xfer using double buffers.
+    //!
+    //! Platform bus switches between buffers without any re-arm latency.
+    //! Given handler is invoked with bus_event::ht when the first buffer
+    //! is complete and with bus_event::tc when the second is complete.
+    //! Completed buffer can be processed while the other one is in flight.
+    //! Streaming lasts until stop() is called.
+    //! \warning Bus must be kept locked during streaming, since next lock()
+    //! will wait for the stream to finish.
+    //! \pre       Bus is locked and double buffers are set.
+    //! \post      Bus remains in the same state.
+    //! \param[in] handler      User-supplied event handler.
+    //! \retval    err::ok      Streaming started.
+    //! \retval    err::busy    Device is still executing async xfer.
+    //! \retval    err          Any other error that can occur in platform bus.
+    //!
+    static err stream(const bus_handler &handler);
+
+    //! \brief Stops streaming xfer.
+    //!
+    //! Handler will receive meta-channel TC event, as for regular async xfer.
+    //! Nothing is in flight after that, so bus owner may proceed with
+    //! blocking xfers without unlocking the bus.
+    //! \pre       Bus is locked and streaming is started.
+    //! \retval    err::ok      Streaming stopped.
+    //! \retval    err::perm    Streaming is not started.
+    //!
+    static err stop();
+
+    //! \brief Gets underlying platform bus.
+    //!
+    //! Allows to use platform-specific configuration that is not covered
+    //! by the generic interface, e.g. idle-line RX mode of USART bus.
+    //! \warning Do not use it to start xfers or to change buffers and handlers.
+    //! Generic bus will lose track of the platform bus state otherwise.
+    //! \pre    Bus is inited and locked.
+    //! \return Platform bus object.
+    //!
+    static PBus &platform_bus();
+
+    //! \brief Continues async xfer with new buffers.
+    //!
+    //! Can be called only from the user-supplied async handler, when
+    //! meta-channel TC event is delivered. New xfer is started right after
+    //! the handler returns, with the same handler and without releasing
+    //! the bus. Thus, completion of the whole sequence is signalled once,
+    //! when handler doesn't request a continuation.
+    //! Rules for buffers are the same as for bus_segment.
+    //! If continuation cannot be started, handler is invoked once more,
+    //! with meta-channel error event.
+    //! \param[in] tx      Data to transmit. Optional.
+    //! \param[in] rx      Buffer to receive a data. Optional.
+    //! \param[in] size    Size of buffers.
+    //! \retval    err::ok      Continuation is scheduled.
+    //! \retval    err::perm    Not called from the handler of the final event.
+    //!
+    static err set_next_buffers(const uint8_t *tx, uint8_t *rx, size_t size);
+
+    //! \brief Submits a transaction to the bus queue.
+    //!
+    //! Transactions are executed in async mode one after another,
+    //! in priority order. Transactions of equal priority are executed
+    //! in order of submission. Next transaction is picked right from
+    //! the completion path of the previous one, without involving any thread.
+    //! Regular clients are blocked in lock() until queue is drained.
+    //! If queue is idle, caller can be blocked until bus is released
+    //! by a regular client. Submission itself is lock-free, so it is allowed
+    //! to submit a transaction from the completion callback.
+    //! \pre       Bus is inited and is not locked by the caller.
+    //! \param[in] t Transaction to execute.
+    //! \retval    err::ok Transaction is queued. Its status is reported
+    //!                    via completion callback.
+    //!
+    static err submit(bus_transaction &t);
+
+    //! \brief Sets retry policy of blocking xfers.
+    //!
+    //! Policy is shared by all clients of the bus. Initial policy
+    //! allows CONFIG_BUS_RETRIES retries without backoff.
+    //! Regardless of the policy, platform bus is recovered (if supported,
+    //! see PBus::recover()) before next xfer that follows an error.
+    //! Async xfers and streams are never retried, their errors are reported
+    //! to the user-supplied handler.
+    //! \param[in] policy New retry policy.
+    //!
+    static void set_retry_policy(const bus_retry_policy &policy);
+
+    //! \brief Gets error counters of the bus.
+    //! \return Counters, accumulated since start or since reset_stats().
+    //!
+    static bus_stats stats();
+
+    //! \brief Resets error counters of the bus.
+    static void reset_stats();
+
 private:
-    using semaphore     = ecl::binary_semaphore;
+    using completion    = ecl::completion;
     using mutex         = ecl::mutex;
     using atomic_flag   = std::atomic_flag;
 
@@ -184,6 +420,54 @@ private:
     //! \brief Performs cleanup required after unlocking and delivering an event.
     static void cleanup();
 
+    //! \brief Executes single attempt of the blocking xfer.
+    //! \sa xfer(size_t *sent, size_t *received)
+    //!
+    static err xfer_once(size_t *sent, size_t *received);
+
+    //! \brief Recovers platform bus after error.
+    static void recover();
+
+    //! \brief Passes buffers of given segment to the platform bus.
+    //! \param[in] seg Segment to use in next xfer.
+    //!
+    static void apply_segment(const bus_segment &seg);
+
+    //! \brief Starts continuation requested by set_next_buffers().
+    //! \retval true  Continuation is started.
+    //! \retval false Continuation is failed to start.
+    //!
+    static bool xfer_continue();
+
+    //! \brief Prepares counters and chain to the new xfer.
+    static void prepare_xfer();
+
+    //! \brief Starts next segment of a chain, if any.
+    //! \retval true  Next segment is started and xfer is not yet complete.
+    //! \retval false Chain is complete, or it is not a chain at all.
+    //!
+    static bool chain_next();
+
+    //! \brief Async handler, used to execute queued transactions.
+    static void queue_handler(bus_channel ch, bus_event type, size_t total);
+
+    //! \brief Moves submitted transactions to the priority queue.
+    //! \pre Called by the queue runner.
+    //!
+    static void queue_fetch();
+
+    //! \brief Gets most urgent transaction from the priority queue.
+    //! \pre Called by the queue runner.
+    //! \return Transaction or nullptr if queue is empty.
+    //!
+    static bus_transaction *queue_pop();
+
+    //! \brief Picks next transaction or marks queue as idle.
+    //! \pre Called by the queue runner.
+    //! \return Transaction or nullptr if queue is idle.
+    //!
+    static bus_transaction *queue_next();
+
     // State flags.
     //! Bus init status: set - bus initialized, reset - bus not yet initialized
     static constexpr uint8_t bus_inited     = 0x1;
@@ -197,25 +481,87 @@ private:
     //! Xfer error status: set - error(s) occurred during transfer,
     //! reset - no error occurred.
     static constexpr uint8_t xfer_error     = 0x10;
+    //! Continuation status: set - next xfer is requested from the handler,
+    //! reset - no continuation requested.
+    static constexpr uint8_t xfer_next      = 0x20;
+    //! Handler status: set - user handler is serving final event of xfer.
+    static constexpr uint8_t final_event    = 0x40;
+    //! Fault status: set - platform bus reported error and must be recovered
+    //! before next xfer.
+    static constexpr uint8_t bus_fault      = 0x80;
 
     static PBus         m_bus;      //!< Platform bus object.
     static mutex        m_lock;     //!< Lock to protect a platform bus.
-    static semaphore    m_complete; //!< Semaphore to notify about end of xfer.
+    static completion   m_complete; //!< Notifies about end of xfer. Only lock owner waits.
     static bus_handler  m_handler;  //!< User-supplied handler, used in async mode
     static size_t       m_received; //!< Bytes received during last blocking xfer.
     static size_t       m_sent;     //!< Bytes sent during last blocking xfer.
     static atomic_flag  m_cleaned;  //!< Cleanup is performed after xfer and unlock are done.
     static uint8_t      m_state;    //!< State flags.
+
+    static const bus_segment *m_segs;   //!< Segment chain, if set.
+    static size_t       m_seg_cnt;      //!< Amount of segments in the chain.
+    static size_t       m_seg_idx;      //!< Segment that is being transferred.
+    static size_t       m_sent_base;    //!< Bytes sent by completed segments.
+    static size_t       m_recv_base;    //!< Bytes received by completed segments.
+    static bus_segment  m_next;         //!< Continuation buffers.
+
+    //! Transactions submitted, but not yet queued. Lock-free stack.
+    static std::atomic< bus_transaction * > m_submitted;
+    static bus_transaction  *m_queue;       //!< Priority queue of transactions.
+    static bus_transaction  *m_current;     //!< Transaction in progress.
+    static std::atomic_bool m_queue_active; //!< Queue runner is active.
+
+    static bus_retry_policy m_retry;        //!< Retry policy of blocking xfers.
+    static bus_stats        m_stats;        //!< Error counters.
+
+#ifdef CONFIG_BUS_TRACE
+    //! \brief Records start of the xfer.
+    //! \param[in] flags Kind of the xfer, see bus_trace_flags.
+    //!
+    static void trace_xfer(uint16_t flags);
+
+    //! \brief Records completion of the xfer.
+    //! \param[in] failed Xfer is complete with error.
+    //!
+    static void trace_done(bool failed);
+
+    static uint8_t      m_trace_id;     //!< Bus id in the trace log.
+    static uint32_t     m_trace_locked; //!< Time the lock was taken at.
+    static uint32_t     m_trace_owner;  //!< Code that took the lock.
+    static uint32_t     m_trace_start;  //!< Time the xfer was started at.
+    static uint32_t     m_trace_size;   //!< Bytes to transfer, chain included.
+#endif
 };
 
 template< class PBus > PBus                     generic_bus< PBus >::m_bus{};
 template< class PBus > ecl::mutex               generic_bus< PBus >::m_lock{};
-template< class PBus > ecl::binary_semaphore    generic_bus< PBus >::m_complete{};
+template< class PBus > ecl::completion          generic_bus< PBus >::m_complete{};
 template< class PBus > bus_handler              generic_bus< PBus >::m_handler{};
 template< class PBus > size_t                   generic_bus< PBus >::m_received{};
 template< class PBus > size_t                   generic_bus< PBus >::m_sent{};
 template< class PBus > std::atomic_flag         generic_bus< PBus >::m_cleaned{};
 template< class PBus > uint8_t                  generic_bus< PBus >::m_state{};
+template< class PBus > const bus_segment        *generic_bus< PBus >::m_segs{};
+template< class PBus > size_t                   generic_bus< PBus >::m_seg_cnt{};
+template< class PBus > size_t                   generic_bus< PBus >::m_seg_idx{};
+template< class PBus > size_t                   generic_bus< PBus >::m_sent_base{};
+template< class PBus > size_t                   generic_bus< PBus >::m_recv_base{};
+template< class PBus > bus_segment              generic_bus< PBus >::m_next{};
+template< class PBus > std::atomic< bus_transaction * > generic_bus< PBus >::m_submitted{};
+template< class PBus > bus_transaction          *generic_bus< PBus >::m_queue{};
+template< class PBus > bus_transaction          *generic_bus< PBus >::m_current{};
+template< class PBus > std::atomic_bool         generic_bus< PBus >::m_queue_active{};
+template< class PBus > bus_retry_policy         generic_bus< PBus >::m_retry{CONFIG_BUS_RETRIES, nullptr};
+template< class PBus > bus_stats                generic_bus< PBus >::m_stats{};
+
+#ifdef CONFIG_BUS_TRACE
+template< class PBus > uint8_t                  generic_bus< PBus >::m_trace_id{};
+template< class PBus > uint32_t                 generic_bus< PBus >::m_trace_locked{};
+template< class PBus > uint32_t                 generic_bus< PBus >::m_trace_owner{};
+template< class PBus > uint32_t                 generic_bus< PBus >::m_trace_start{};
+template< class PBus > uint32_t                 generic_bus< PBus >::m_trace_size{};
+#endif
 
 //------------------------------------------------------------------------------
 
@@ -244,6 +590,9 @@ err generic_bus< PBus >::init()
 
     if (is_ok(rc)) {
         m_state |= bus_inited;
+#ifdef CONFIG_BUS_TRACE
+        m_trace_id = bus_trace::attach(&m_bus);
+#endif
     }
 
     return rc;
@@ -267,7 +616,13 @@ template< class PBus >
 void generic_bus< PBus >::lock()
 {
     // If bus is not initialized then pre-conditions are violated.
-    ecl_assert(m_state & bus_inited);
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_inited);
+
+    ECL_TRACE_SCOPE("bus.lock");
+
+#ifdef CONFIG_BUS_TRACE
+    auto requested = bus_trace::now();
+#endif
 
     m_lock.lock();
 
@@ -278,6 +633,23 @@ void generic_bus< PBus >::lock()
     if (m_state & async_mode) {
         m_complete.wait();
     }
+
+#ifdef CONFIG_BUS_TRACE
+    // Wait includes completion of async xfer left by previous owner
+    m_trace_locked = bus_trace::now();
+    m_trace_owner = reinterpret_cast< uintptr_t >(__builtin_return_address(0));
+    bus_trace::record(m_trace_id, bus_trace_event::lock,
+                      m_trace_locked - requested, m_trace_owner);
+#endif
+}
+
+template< class PBus >
+ecl::err generic_bus< PBus >::lock(uint32_t clk)
+{
+    lock();
+
+    // Most recent xfer is finished, so platform bus can be reconfigured
+    return m_bus.set_clock(clk);
 }
 
 template< class PBus >
@@ -285,7 +657,7 @@ void generic_bus< PBus >::unlock()
 {
     // If bus is not locked then pre-conditions are violated
     // and it is clearly a sign of a bug
-    ecl_assert(m_state & bus_locked);
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_locked);
 
     // Notify handler routine that unlock is called and it is possible to
     // do cleanup.
@@ -312,6 +684,11 @@ void generic_bus< PBus >::unlock()
         cleanup();
     }
 
+#ifdef CONFIG_BUS_TRACE
+    bus_trace::record(m_trace_id, bus_trace_event::unlock,
+                      bus_trace::now() - m_trace_locked, m_trace_owner);
+#endif
+
     m_lock.unlock();
 }
 
@@ -320,7 +697,7 @@ ecl::err generic_bus< PBus >::set_buffers(const uint8_t *tx, uint8_t *rx, size_t
 {
     // If bus is not locked then pre-conditions are violated
     // and it is clearly a sign of a bug
-    ecl_assert(m_state & bus_locked);
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_locked);
 
     if (!tx && !rx) {
         return err::inval;
@@ -330,10 +707,17 @@ ecl::err generic_bus< PBus >::set_buffers(const uint8_t *tx, uint8_t *rx, size_t
         return err::again;
     }
 
+    m_segs = nullptr;
+    m_seg_cnt = 0;
+
     m_bus.reset_buffers();
     m_bus.set_tx(tx, size);
     m_bus.set_rx(rx, size);
 
+#ifdef CONFIG_BUS_TRACE
+    m_trace_size = size;
+#endif
+
     return err::ok;
 }
 
@@ -342,14 +726,53 @@ ecl::err generic_bus< PBus >::set_buffers(size_t size, uint8_t fill_byte)
 {
     // If bus is not locked then pre-conditions are violated
     // and it is clearly a sign of a bug
-    ecl_assert(m_state & bus_locked);
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_locked);
 
     if (bus_is_busy()) {
         return err::again;
     }
 
+    m_segs = nullptr;
+    m_seg_cnt = 0;
+
     m_bus.reset_buffers();
     m_bus.set_tx(size, fill_byte);
+
+#ifdef CONFIG_BUS_TRACE
+    m_trace_size = size;
+#endif
+
+    return err::ok;
+}
+
+template< class PBus >
+ecl::err generic_bus< PBus >::set_buffers(const bus_segment *segs, size_t n)
+{
+    // If bus is not locked then pre-conditions are violated
+    // and it is clearly a sign of a bug
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_locked);
+
+    if (!segs || !n) {
+        return err::inval;
+    }
+
+    if (bus_is_busy()) {
+        return err::again;
+    }
+
+    m_segs = segs;
+    m_seg_cnt = n;
+    m_seg_idx = 0;
+
+    apply_segment(m_segs[0]);
+
+#ifdef CONFIG_BUS_TRACE
+    m_trace_size = 0;
+    for (size_t i = 0; i < n; ++i) {
+        m_trace_size += segs[i].size;
+    }
+#endif
+
     return err::ok;
 }
 
@@ -358,12 +781,45 @@ ecl::err generic_bus< PBus >::xfer(size_t *sent, size_t *received)
 {
     // If bus is not locked then pre-conditions are violated
     // and it is clearly a sign of a bug
-    ecl_assert(m_state & bus_locked);
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_locked);
+
+    ECL_TRACE_SCOPE("bus.xfer");
 
     if (bus_is_busy()) {
         return err::busy;
     }
 
+    auto rc = xfer_once(sent, received);
+
+    // Transaction failed after start, it is possible to repeat it
+    for (unsigned retry = 1; rc == err::io && retry <= m_retry.retries; ++retry) {
+        if (m_retry.backoff) {
+            m_retry.backoff(retry);
+        }
+
+        ++m_stats.retries;
+        rc = xfer_once(sent, received);
+
+        if (is_ok(rc)) {
+            ++m_stats.recovered;
+        }
+    }
+
+    if (rc == err::io) {
+        ++m_stats.failed;
+    }
+
+    return rc;
+}
+
+template< class PBus >
+ecl::err generic_bus< PBus >::xfer_once(size_t *sent, size_t *received)
+{
+    // Previous xfer failed, platform bus may be left in broken state
+    if (m_state & bus_fault) {
+        recover();
+    }
+
     // Blocking mode xfer is provided.
     m_state &= ~(async_mode);
 
@@ -373,11 +829,18 @@ ecl::err generic_bus< PBus >::xfer(size_t *sent, size_t *received)
     // Clear previous errors
     m_state &= ~(xfer_error);
 
-    // Reset binary semaphore counter
+    // Reset completion state
     m_complete.try_wait();
 
-    // Reset transfer counters
-    m_received = m_sent = 0;
+    // Reset transfer counters and rewind a chain
+    prepare_xfer();
+
+    // MCU must stay awake until the final event, see platform_handler()
+    sleep_lock::acquire();
+
+#ifdef CONFIG_BUS_TRACE
+    trace_xfer(0);
+#endif
 
     auto rc = m_bus.do_xfer();
 
@@ -403,6 +866,11 @@ ecl::err generic_bus< PBus >::xfer(size_t *sent, size_t *received)
         // Deem that xfer virtually occurs in blocking mode and thus
         // momentally served in case of error.
         m_state |= xfer_served;
+        sleep_lock::release();
+
+#ifdef CONFIG_BUS_TRACE
+        trace_done(true);
+#endif
     }
 
     return rc;
@@ -413,17 +881,39 @@ ecl::err generic_bus< PBus >::xfer(const bus_handler &handler)
 {
     // If bus is not locked then pre-conditions are violated
     // and it is clearly a sign of a bug
-    ecl_assert(m_state & bus_locked);
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_locked);
 
     // Clears IRQ flag as well.
     if (bus_is_busy()) {
         return err::busy;
     }
 
+    // Completes in other context, so only counted
+    ECL_COUNTER("bus.xfer.async");
+
+    if (m_state & bus_fault) {
+        recover();
+    }
+
     // Async mode xfer is provided
     m_state |= async_mode;
     m_handler = handler;
 
+    // Events of this particular xfer are not yet served, nor cleanup is done.
+    // Both are reset before the start: fast bus may deliver the final event
+    // before do_xfer() returns.
+    m_state &= ~(xfer_served | xfer_error);
+    m_cleaned.clear();
+
+    // Reset transfer counters and rewind a chain
+    prepare_xfer();
+
+    sleep_lock::acquire();
+
+#ifdef CONFIG_BUS_TRACE
+    trace_xfer(bus_trace_flags::async);
+#endif
+
     auto rc = m_bus.do_xfer();
 
     if (is_error(rc)) {
@@ -431,14 +921,188 @@ ecl::err generic_bus< PBus >::xfer(const bus_handler &handler)
         // momentally served in case of error.
         m_state |= xfer_served;
         m_state &= ~(async_mode);
-    } else {
-        // Events of this particular xfer is not yet served.
-        m_state &= ~(xfer_served);
+        sleep_lock::release();
+
+#ifdef CONFIG_BUS_TRACE
+        trace_done(true);
+#endif
     }
 
     return rc;
 }
 
+template< class PBus >
+ecl::err generic_bus< PBus >::set_double_buffers(const uint8_t *tx0, const uint8_t *tx1,
+                                                 uint8_t *rx0, uint8_t *rx1, size_t size)
+{
+    // If bus is not locked then pre-conditions are violated
+    // and it is clearly a sign of a bug
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_locked);
+
+    if (!tx0 && !tx1 && !rx0 && !rx1) {
+        return err::inval;
+    }
+
+    if (bus_is_busy()) {
+        return err::again;
+    }
+
+    m_segs = nullptr;
+    m_seg_cnt = 0;
+
+    m_bus.reset_buffers();
+    m_bus.set_double_buffers(tx0, tx1, rx0, rx1, size);
+
+#ifdef CONFIG_BUS_TRACE
+    m_trace_size = size;
+#endif
+
+    return err::ok;
+}
+
+template< class PBus >
+ecl::err generic_bus< PBus >::stream(const bus_handler &handler)
+{
+    // If bus is not locked then pre-conditions are violated
+    // and it is clearly a sign of a bug
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_locked);
+
+    if (bus_is_busy()) {
+        return err::busy;
+    }
+
+    if (m_state & bus_fault) {
+        recover();
+    }
+
+    // Streaming is a special case of async xfer
+    m_state |= async_mode;
+    m_handler = handler;
+
+    m_state &= ~(xfer_served | xfer_error);
+    m_cleaned.clear();
+
+    prepare_xfer();
+
+    sleep_lock::acquire();
+
+#ifdef CONFIG_BUS_TRACE
+    trace_xfer(bus_trace_flags::async | bus_trace_flags::stream);
+#endif
+
+    auto rc = m_bus.do_stream();
+
+    if (is_error(rc)) {
+        m_state |= xfer_served;
+        m_state &= ~(async_mode);
+        sleep_lock::release();
+
+#ifdef CONFIG_BUS_TRACE
+        trace_done(true);
+#endif
+    }
+
+    return rc;
+}
+
+template< class PBus >
+ecl::err generic_bus< PBus >::stop()
+{
+    // If bus is not locked then pre-conditions are violated
+    // and it is clearly a sign of a bug
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_locked);
+
+    if (!(m_state & async_mode)) {
+        return err::perm;
+    }
+
+    if (m_state & xfer_served) {
+        // Stream is over already, e.g. platform bus stopped it due to error.
+        // Nothing is in flight, blocking xfers are allowed till unlock().
+        m_state &= ~(async_mode);
+        return err::perm;
+    }
+
+    // Platform bus delivers final event either right from here, or later.
+    auto rc = m_bus.stop_stream();
+
+    if (is_ok(rc) && (m_state & xfer_served)) {
+        m_state &= ~(async_mode);
+    }
+
+    return rc;
+}
+
+template< class PBus >
+PBus &generic_bus< PBus >::platform_bus()
+{
+    // If bus is not locked then pre-conditions are violated
+    // and it is clearly a sign of a bug
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_locked);
+
+    return m_bus;
+}
+
+template< class PBus >
+ecl::err generic_bus< PBus >::set_next_buffers(const uint8_t *tx, uint8_t *rx, size_t size)
+{
+    if (!(m_state & final_event)) {
+        return err::perm;
+    }
+
+    m_next = bus_segment{tx, rx, size, 0xff};
+    m_state |= xfer_next;
+
+    return err::ok;
+}
+
+template< class PBus >
+ecl::err generic_bus< PBus >::submit(bus_transaction &t)
+{
+    // If bus is not initialized then pre-conditions are violated.
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_inited);
+
+    t.status = err::ok;
+    t.sent = t.received = 0;
+    t.next = m_submitted.load();
+
+    while (!m_submitted.compare_exchange_weak(t.next, &t)) { }
+
+    // Runner will pick up the transaction by itself
+    if (m_queue_active.exchange(true)) {
+        return err::ok;
+    }
+
+    lock();
+
+    queue_fetch();
+    auto cur = queue_pop();
+
+    while (cur) {
+        m_current = cur;
+
+        auto rc = (cur->tx || cur->rx) ? set_buffers(cur->tx, cur->rx, cur->size)
+                                       : set_buffers(cur->size);
+
+        if (is_ok(rc)) {
+            rc = xfer(queue_handler);
+        }
+
+        if (is_ok(rc)) {
+            break;
+        }
+
+        // Transaction failed to start, proceed with next one
+        cur->status = rc;
+        cur->complete(*cur);
+        cur = queue_next();
+    }
+
+    unlock();
+
+    return err::ok;
+}
+
 //------------------------------------------------------------------------------
 
 template< class PBus >
@@ -448,19 +1112,58 @@ void generic_bus< PBus >::platform_handler(bus_channel ch, bus_event type, size_
     bool last_event = (ch == bus_channel::meta && type == bus_event::tc);
 
     if (type == bus_event::err) {
-        m_state |= xfer_error;
+        m_state |= xfer_error | bus_fault;
+        ++m_stats.errors;
+    }
+
+#ifdef CONFIG_BUS_TRACE
+    if (type == bus_event::err) {
+        bus_trace::record(m_trace_id, bus_trace_event::error,
+                          static_cast< uint32_t >(ch), total);
+    }
+#endif
+
+    // Counters are accumulated accross the segment chain
+    if (ch == bus_channel::tx) {
+        m_sent = m_sent_base + total;
+        total = m_sent;
+    } else if (ch == bus_channel::rx) {
+        m_received = m_recv_base + total;
+        total = m_received;
+    }
+
+    // Segment is complete, but chain is not. Proceed without notifying
+    // anyone about intermediate completion.
+    if (last_event && chain_next()) {
+        return;
     }
 
     if (last_event) {
         // Spurious events are not allowed
-        ecl_assert(!(m_state & xfer_served));
+        ecl_assert_level(ECL_ASSERT_LEVEL_BUS, !(m_state & xfer_served));
 
         m_state |= xfer_served;
+
+#ifdef CONFIG_BUS_TRACE
+        trace_done(m_state & xfer_error);
+#endif
     }
 
     if (m_state & async_mode) {
+        if (last_event) {
+            m_state |= final_event;
+        }
+
         m_handler(ch, type, total);
 
+        m_state &= ~(final_event);
+
+        // Handler requested more data to be transferred, proceed without
+        // notifying rest of the bus about completion.
+        if (last_event && (m_state & xfer_next) && xfer_continue()) {
+            return;
+        }
+
         // Bus unlocked, it is time to check if bus cleaned.
         if (last_event && !(m_state & bus_locked)) {
 
@@ -476,23 +1179,45 @@ void generic_bus< PBus >::platform_handler(bus_channel ch, bus_event type, size_
                 cleanup();
             }
         }
-    } else {
-        // In blocking mode a bus is responcible for bytes counting
-        if (ch == bus_channel::tx) {
-            m_sent = total;
-        } else if (ch == bus_channel::rx) {
-            m_received = total;
-        }
-
-        // Don't do anything for 'meta' channel
     }
 
     if (last_event) {
+        // Nothing is left in flight, MCU may sleep
+        sleep_lock::release();
+
         // Inform rest of the bus about event handling
         m_complete.signal();
     }
 }
 
+template< class PBus >
+void generic_bus< PBus >::set_retry_policy(const bus_retry_policy &policy)
+{
+    m_retry = policy;
+}
+
+template< class PBus >
+bus_stats generic_bus< PBus >::stats()
+{
+    return m_stats;
+}
+
+template< class PBus >
+void generic_bus< PBus >::reset_stats()
+{
+    m_stats = bus_stats{};
+}
+
+template< class PBus >
+void generic_bus< PBus >::recover()
+{
+    m_state &= ~(bus_fault);
+
+    if (is_ok(detail::bus_recover(m_bus, 0))) {
+        ++m_stats.resets;
+    }
+}
+
 template< class PBus >
 bool generic_bus< PBus >::bus_is_busy()
 {
@@ -505,10 +1230,230 @@ void generic_bus< Bus >::cleanup()
 {
     m_bus.reset_buffers();
     m_handler = bus_handler{};
+    m_segs = nullptr;
+    m_seg_cnt = 0;
+    m_seg_idx = 0;
+    m_state &= ~(xfer_next);
     // When bus will be locked agian, no need to wait for events.
     m_state &= ~(async_mode);
 }
 
+template< class PBus >
+void generic_bus< PBus >::apply_segment(const bus_segment &seg)
+{
+    m_bus.reset_buffers();
+
+    if (!seg.tx && !seg.rx) {
+        m_bus.set_tx(seg.size, seg.fill_byte);
+    } else {
+        m_bus.set_tx(seg.tx, seg.size);
+        m_bus.set_rx(seg.rx, seg.size);
+    }
+}
+
+template< class PBus >
+void generic_bus< PBus >::prepare_xfer()
+{
+    m_received = m_sent = 0;
+    m_recv_base = m_sent_base = 0;
+
+    // Chain was executed previously, its first segment must be restored.
+    if (m_segs && m_seg_idx) {
+        m_seg_idx = 0;
+        apply_segment(m_segs[0]);
+    }
+}
+
+template< class PBus >
+bool generic_bus< PBus >::chain_next()
+{
+    if (!m_segs || m_seg_idx + 1 >= m_seg_cnt || (m_state & xfer_error)) {
+        return false;
+    }
+
+    m_sent_base = m_sent;
+    m_recv_base = m_received;
+
+    apply_segment(m_segs[++m_seg_idx]);
+
+    if (is_error(m_bus.do_xfer())) {
+        // Rest of the chain is dropped, error is reported as for the
+        // xfer that started but failed.
+        m_state |= xfer_error;
+        return false;
+    }
+
+    return true;
+}
+
+template< class PBus >
+bool generic_bus< PBus >::xfer_continue()
+{
+    m_state &= ~(xfer_next);
+
+    // Continuation is a brand new xfer, not a part of a chain
+    m_segs = nullptr;
+    m_seg_cnt = 0;
+    m_seg_idx = 0;
+
+    m_received = m_sent = 0;
+    m_recv_base = m_sent_base = 0;
+
+    apply_segment(m_next);
+
+    // Events of the continuation are not yet served
+    m_state &= ~(xfer_error | xfer_served);
+
+#ifdef CONFIG_BUS_TRACE
+    m_trace_size = m_next.size;
+    trace_xfer(bus_trace_flags::async | bus_trace_flags::next);
+#endif
+
+    if (is_error(m_bus.do_xfer())) {
+        m_state |= xfer_error | xfer_served;
+#ifdef CONFIG_BUS_TRACE
+        trace_done(true);
+#endif
+        m_handler(bus_channel::meta, bus_event::err, 0);
+        return false;
+    }
+
+    return true;
+}
+
+#ifdef CONFIG_BUS_TRACE
+template< class PBus >
+void generic_bus< PBus >::trace_xfer(uint16_t flags)
+{
+    if (m_segs) {
+        flags |= bus_trace_flags::chain;
+    }
+
+    m_trace_start = bus_trace::now();
+    bus_trace::record(m_trace_id, bus_trace_event::xfer, m_trace_size,
+                      m_segs ? m_seg_cnt : 1, flags);
+}
+
+template< class PBus >
+void generic_bus< PBus >::trace_done(bool failed)
+{
+    bus_trace::record(m_trace_id, bus_trace_event::done,
+                      bus_trace::now() - m_trace_start,
+                      m_sent > m_received ? m_sent : m_received,
+                      failed ? bus_trace_flags::failed : 0);
+}
+#endif
+
+template< class PBus >
+void generic_bus< PBus >::queue_handler(bus_channel ch, bus_event type, size_t total)
+{
+    auto cur = m_current;
+
+    if (type == bus_event::err) {
+        cur->status = err::io;
+    }
+
+    if (ch == bus_channel::tx) {
+        cur->sent = total;
+    } else if (ch == bus_channel::rx) {
+        cur->received = total;
+    }
+
+    if (ch != bus_channel::meta) {
+        return;
+    }
+
+    if (type != bus_event::tc) {
+        // Continuation failed to start, so nothing is in flight to run
+        // the rest of the queue. Fail it, rather than leave it stranded.
+        // Transactions submitted from callbacks meanwhile are failed too.
+        cur->complete(*cur);
+
+        while (auto t = queue_next()) {
+            t->status = err::io;
+            t->complete(*t);
+        }
+
+        return;
+    }
+
+    auto next = queue_next();
+
+    if (next) {
+        m_current = next;
+        set_next_buffers(next->tx, next->rx, next->size);
+    }
+
+    // Completion is reported after next transaction is scheduled,
+    // so callback is allowed to submit new transactions.
+    cur->complete(*cur);
+}
+
+template< class PBus >
+void generic_bus< PBus >::queue_fetch()
+{
+    auto t = m_submitted.exchange(nullptr);
+
+    // Stack holds transactions in reverse order of submission
+    bus_transaction *fifo = nullptr;
+
+    while (t) {
+        auto next = t->next;
+        t->next = fifo;
+        fifo = t;
+        t = next;
+    }
+
+    while (fifo) {
+        auto next = fifo->next;
+
+        // New transaction is placed after transactions of the same priority
+        auto pos = &m_queue;
+        while (*pos && (*pos)->priority >= fifo->priority) {
+            pos = &(*pos)->next;
+        }
+
+        fifo->next = *pos;
+        *pos = fifo;
+
+        fifo = next;
+    }
+}
+
+template< class PBus >
+bus_transaction *generic_bus< PBus >::queue_pop()
+{
+    auto t = m_queue;
+
+    if (t) {
+        m_queue = t->next;
+        t->next = nullptr;
+    }
+
+    return t;
+}
+
+template< class PBus >
+bus_transaction *generic_bus< PBus >::queue_next()
+{
+    queue_fetch();
+
+    auto t = queue_pop();
+    if (t) {
+        return t;
+    }
+
+    m_queue_active = false;
+
+    // Transaction could be submitted right before flag was cleared,
+    // without waking up a runner. Check it once again.
+    if (m_submitted.load() && !m_queue_active.exchange(true)) {
+        queue_fetch();
+        return queue_pop();
+    }
+
+    return nullptr;
+}
 }
 
 #endif
@@ -0,0 +1,327 @@
+#ifndef DEV_BUS_DEV_BUS_DEVICE_HPP_
+#define DEV_BUS_DEV_BUS_DEVICE_HPP_
+
+//!
+//! \file
+//! \brief      Bus device module.
+//! \copyright
+//!
+
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+#include <ecl/thread/mutex.hpp>
+#include <ecl/thread/semaphore.hpp>
+
+#include <platform/common/bus.hpp>
+
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Arbiter of devices sharing the same generic bus.
+//! Devices that are waiting for the bus are queued in priority order.
+//! When bus is released, ownership is passed directly to the most urgent
+//! device. Devices with equal priority are served in FIFO order.
+//! Arbiter also tracks which device was the last owner of the bus,
+//! so bus reconfiguration can be skipped if owner is not changed.
+//! \tparam GBus Generic bus driver.
+//!
+template< class GBus >
+class bus_arbiter
+{
+public:
+    //!
+    //! \brief Waiter of the bus.
+    //! Each device provides exactly one waiter.
+    //!
+    struct waiter
+    {
+        ecl::binary_semaphore   wakeup;     //!< Signalled when bus is granted.
+        uint8_t                 priority;   //!< Priority, higher is urgent.
+        waiter                  *next;      //!< Next waiter in the queue.
+    };
+
+    //!
+    //! \brief Acquires the bus on behalf of a device.
+    //! Caller is blocked until bus will be granted.
+    //! \param[in] w Waiter of a device.
+    //!
+    static void acquire(waiter &w);
+
+    //!
+    //! \brief Releases the bus and grants it to the next waiter, if any.
+    //!
+    static void release();
+
+    //!
+    //! \brief Marks given waiter as the bus owner.
+    //! \param[in] w Waiter of a device.
+    //! \retval true  Owner is changed, bus must be reconfigured.
+    //! \retval false Owner is the same as before.
+    //!
+    static bool take_ownership(const waiter &w);
+
+    //!
+    //! \brief Forgets most recent bus owner.
+    //! Next owner will reconfigure the bus unconditionally.
+    //!
+    static void reset_ownership();
+
+private:
+    static ecl::mutex   m_lock;     //!< Protects the queue.
+    static waiter       *m_head;    //!< Waiters queue.
+    static bool         m_busy;     //!< Bus is granted to a device.
+    static const waiter *m_owner;   //!< Most recent bus owner.
+};
+
+template< class GBus > ecl::mutex                               bus_arbiter< GBus >::m_lock{};
+template< class GBus > typename bus_arbiter< GBus >::waiter     *bus_arbiter< GBus >::m_head{};
+template< class GBus > bool                                     bus_arbiter< GBus >::m_busy{};
+template< class GBus > const typename bus_arbiter< GBus >::waiter *bus_arbiter< GBus >::m_owner{};
+
+//------------------------------------------------------------------------------
+
+//!
+//! \brief Device on a shared bus.
+//! Device owns its chip-select line and bus configuration, so multiple
+//! devices can share the same generic bus without knowing about each other.
+//! Bus is reconfigured only when bus is taken by a device other than
+//! most recent one.
+//! \par Device configuration
+//! Config class must provide following static constants:
+//! \li \c clk      - clock of the bus required by the device, in Hz.
+//! \li \c cpol     - clock polarity, in format of the platform bus.
+//! \li \c cpha     - clock phase, in format of the platform bus.
+//! \li \c priority - priority of a device. Higher value is more urgent.
+//! Platform bus must provide set_clock() and set_mode() methods.
+//! \warning All clients of the bus must use bus_device, otherwise bus
+//! configuration of a device can be silently changed.
+//! \tparam GBus    Generic bus driver.
+//! \tparam CS_GPIO Chip-select GPIO. Active low.
+//! \tparam config  Device configuration.
+//! \sa generic_bus
+//! \sa bus_arbiter
+//!
+template< class GBus, class CS_GPIO, class config >
+class bus_device
+{
+public:
+    //!
+    //! \brief Lazy initialization.
+    //! Inits a bus and deasserts chip-select.
+    //! \return Status of operation.
+    //!
+    static err init();
+
+    //!
+    //! \brief Locks a bus on behalf of the device and asserts chip-select.
+    //! Caller is blocked until all devices with higher priority
+    //! will release the bus.
+    //! \pre  Device is initialized.
+    //! \post Bus is locked and configured for the device.
+    //! \return Status of bus configuration.
+    //!
+    static err lock();
+
+    //!
+    //! \brief Deasserts chip-select and unlocks a bus.
+    //! \pre  Device has locked the bus and there is no xfer in progress.
+    //! \post Bus is granted to the next device, if any.
+    //!
+    static void unlock();
+
+    //!
+    //! \brief Sets RX and TX buffers.
+    //! \sa generic_bus::set_buffers()
+    //!
+    static err set_buffers(const uint8_t *tx, uint8_t *rx, size_t size);
+
+    //!
+    //! \brief Sets buffers for fill xfer.
+    //! \sa generic_bus::set_buffers()
+    //!
+    static err set_buffers(size_t size, uint8_t fill_byte = 0xff);
+
+    //!
+    //! \brief Sets scatter-gather chain.
+    //! \sa generic_bus::set_buffers()
+    //!
+    static err set_buffers(const bus_segment *segs, size_t n);
+
+    //!
+    //! \brief Performs xfer in blocking mode.
+    //! \sa generic_bus::xfer()
+    //!
+    static err xfer(size_t *sent = nullptr, size_t *received = nullptr);
+
+    //!
+    //! \brief Performs xfer in async mode.
+    //! \sa generic_bus::xfer()
+    //!
+    static err xfer(const bus_handler &handler);
+
+private:
+    using arbiter = bus_arbiter< GBus >;
+
+    static typename arbiter::waiter m_waiter;   //!< Device place in the queue.
+    static mutex                    m_lock;     //!< Serializes device users.
+};
+
+template< class GBus, class CS_GPIO, class config >
+typename bus_arbiter< GBus >::waiter bus_device< GBus, CS_GPIO, config >::m_waiter{
+    {}, config::priority, nullptr
+};
+
+template< class GBus, class CS_GPIO, class config >
+mutex bus_device< GBus, CS_GPIO, config >::m_lock{};
+
+//------------------------------------------------------------------------------
+
+template< class GBus >
+void bus_arbiter< GBus >::acquire(waiter &w)
+{
+    m_lock.lock();
+
+    if (!m_busy) {
+        m_busy = true;
+        m_lock.unlock();
+        return;
+    }
+
+    // Keep queue sorted by priority. New waiter is placed after
+    // waiters with the same priority.
+    auto pos = &m_head;
+    while (*pos && (*pos)->priority >= w.priority) {
+        pos = &(*pos)->next;
+    }
+
+    w.next = *pos;
+    *pos = &w;
+
+    m_lock.unlock();
+
+    // Bus will be granted by the previous owner
+    w.wakeup.wait();
+}
+
+template< class GBus >
+void bus_arbiter< GBus >::release()
+{
+    m_lock.lock();
+
+    auto next = m_head;
+
+    if (next) {
+        // Bus remains busy, ownership is passed directly
+        m_head = next->next;
+        next->next = nullptr;
+        next->wakeup.signal();
+    } else {
+        m_busy = false;
+    }
+
+    m_lock.unlock();
+}
+
+template< class GBus >
+bool bus_arbiter< GBus >::take_ownership(const waiter &w)
+{
+    if (m_owner == &w) {
+        return false;
+    }
+
+    m_owner = &w;
+    return true;
+}
+
+template< class GBus >
+void bus_arbiter< GBus >::reset_ownership()
+{
+    m_owner = nullptr;
+}
+
+//------------------------------------------------------------------------------
+
+template< class GBus, class CS_GPIO, class config >
+err bus_device< GBus, CS_GPIO, config >::init()
+{
+    CS_GPIO::set();
+    return GBus::init();
+}
+
+template< class GBus, class CS_GPIO, class config >
+err bus_device< GBus, CS_GPIO, config >::lock()
+{
+    auto rc = err::ok;
+
+    m_lock.lock();
+    arbiter::acquire(m_waiter);
+
+    GBus::lock();
+
+    // Reconfiguration is skipped if device hasn't been preempted
+    if (arbiter::take_ownership(m_waiter)) {
+        auto &bus = GBus::platform_bus();
+
+        rc = bus.set_mode(config::cpol, config::cpha);
+        if (is_ok(rc)) {
+            rc = bus.set_clock(config::clk);
+        }
+
+        // Bus state is unknown, try again on next lock
+        if (is_error(rc)) {
+            arbiter::reset_ownership();
+        }
+    }
+
+    CS_GPIO::reset();
+
+    return rc;
+}
+
+template< class GBus, class CS_GPIO, class config >
+void bus_device< GBus, CS_GPIO, config >::unlock()
+{
+    CS_GPIO::set();
+
+    GBus::unlock();
+
+    arbiter::release();
+    m_lock.unlock();
+}
+
+template< class GBus, class CS_GPIO, class config >
+err bus_device< GBus, CS_GPIO, config >::set_buffers(const uint8_t *tx, uint8_t *rx, size_t size)
+{
+    return GBus::set_buffers(tx, rx, size);
+}
+
+template< class GBus, class CS_GPIO, class config >
+err bus_device< GBus, CS_GPIO, config >::set_buffers(size_t size, uint8_t fill_byte)
+{
+    return GBus::set_buffers(size, fill_byte);
+}
+
+template< class GBus, class CS_GPIO, class config >
+err bus_device< GBus, CS_GPIO, config >::set_buffers(const bus_segment *segs, size_t n)
+{
+    return GBus::set_buffers(segs, n);
+}
+
+template< class GBus, class CS_GPIO, class config >
+err bus_device< GBus, CS_GPIO, config >::xfer(size_t *sent, size_t *received)
+{
+    return GBus::xfer(sent, received);
+}
+
+template< class GBus, class CS_GPIO, class config >
+err bus_device< GBus, CS_GPIO, config >::xfer(const bus_handler &handler)
+{
+    return GBus::xfer(handler);
+}
+
+} // namespace ecl
+
+#endif // DEV_BUS_DEV_BUS_DEVICE_HPP_
@@ -9,6 +9,13 @@
 //!
 
 #include <ecl/err.hpp>
+#include <ecl/result.hpp>
+#include <ecl/assert.h>
+#include <ecl/iovec.hpp>
+
+#include <platform/common/bus.hpp>
+
+#include <sys/types.h>
 
 namespace ecl
 {
@@ -24,6 +31,9 @@ template< class GBus >
 class bus_pipe
 {
 public:
+    //! Most buffers, accepted by writev() and readv().
+    static constexpr size_t iov_max = 8;
+
     //!
     //! \brief Constructs a pipe.
     //!
@@ -78,6 +88,52 @@ public:
     //!
     ssize_t read(uint8_t *buffer, size_t size);
 
+    //!
+    //! \brief Writes data, gathered from few buffers, to a pipe.
+    //! Buffers are sent back-to-back as a segment chain of a single xfer,
+    //! so a message isn't split into few bus transactions and doesn't
+    //! have to be copied into a single buffer. Errors are reported
+    //! the same way as by write().
+    //! \pre Bus is initialized.
+    //! \param[in] iov    Buffers to write. Empty buffers are skipped.
+    //! \param[in] n      Amount of buffers, no more than iov_max.
+    //! \return     Value indicating either error if negative or
+    //!             amount of bytes transferred if positive.
+    //!
+    ssize_t writev(const iovec *iov, size_t n);
+
+    //!
+    //! \brief Reads data from a pipe, scattering it to few buffers.
+    //! Buffers are filled back-to-back within a single xfer.
+    //! Errors are reported the same way as by read().
+    //! \pre Bus is initialized.
+    //! \param[in] iov    Buffers to read to. Empty buffers are skipped.
+    //! \param[in] n      Amount of buffers, no more than iov_max.
+    //! \return     Value indicating an error if negative or bytes stored
+    //!             to buffers if positive.
+    //!
+    ssize_t readv(const iovec *iov, size_t n);
+
+    //!
+    //! \brief Writes all data to a pipe.
+    //! Unlike write(), tells the error itself, so last_error() is not needed.
+    //! \pre Bus is initialized.
+    //! \param[in] data  Data to write. Must not be null.
+    //! \param[in] count Count of bytes to write. Can be zero.
+    //! \return Amount of bytes written, or error if not all of them were.
+    //!
+    result< size_t > send(const uint8_t *data, size_t count);
+
+    //!
+    //! \brief Fills a buffer with data from a pipe.
+    //! Unlike read(), tells the error itself, so last_error() is not needed.
+    //! \pre Bus is initialized.
+    //! \param[out] buffer Data buffer to read to. Must not be null.
+    //! \param[in]  size   Size of a buffer. Can be zero.
+    //! \return Amount of bytes read, or error if buffer is not filled.
+    //!
+    result< size_t > receive(uint8_t *buffer, size_t size);
+
     //!
     //! \brief Gets last error occurred.
     //! \return Error defined in ecl::err
@@ -94,12 +150,26 @@ private:
     //! \retval false Error hasn't occur at all, or occurred during xfer
     //!
     bool err_on_start() const;
+
+    //!
+    //! \brief Moves data over the bus, holding it locked.
+    //! \return Amount of bytes moved.
+    //!
+    size_t transfer(const uint8_t *tx, uint8_t *rx, size_t size);
+
+    //!
+    //! \brief Moves data of few buffers over the bus, as a segment chain.
+    //! \param[in] write  Buffers are sent if true, received otherwise.
+    //! \return Amount of bytes moved.
+    //!
+    size_t transfer(const iovec *iov, size_t n, bool write);
 };
 
 
 template< class GBus >
 bus_pipe< GBus >::bus_pipe()
     :m_gbus{}
+    ,m_last{err::ok}
 {
 
 }
@@ -119,57 +189,101 @@ ecl::err bus_pipe< GBus >::init()
 template< class GBus >
 ssize_t bus_pipe< GBus >::write(const uint8_t *data, size_t count)
 {
-    ecl_assert(data);
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, data);
 
     if (!count)
         return count;
 
-    size_t sent = 0;
-    ssize_t ret;
-
-    m_gbus.lock();
-    m_gbus.set_buffers(data, nullptr, count);
-
-    m_last = m_gbus.xfer(&sent);
-
-    m_gbus.unlock();
-
-    ret = sent;
+    size_t sent = transfer(data, nullptr, count);
 
     if (err_on_start()) {
         // Error occur, right at the start
-        ret = -1;
+        return -1;
     }
 
-    return ret;
+    return sent;
 }
 
 template< class GBus >
 ssize_t bus_pipe< GBus >::read(uint8_t *buffer, size_t size)
 {
-    ecl_assert(buffer);
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, buffer);
 
     if (!size)
         return size;
 
-    size_t read = 0;
-    ssize_t ret;
+    size_t read = transfer(nullptr, buffer, size);
 
-    m_gbus.lock();
-    m_gbus.set_buffers(nullptr, buffer, size);
+    if (err_on_start()) {
+        // Error occur, right at the start
+        return -1;
+    }
 
-    m_last = m_gbus.xfer(nullptr, &read);
+    return read;
+}
 
-    m_gbus.unlock();
+template< class GBus >
+ssize_t bus_pipe< GBus >::writev(const iovec *iov, size_t n)
+{
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, iov || !n);
 
-    ret = read;
+    size_t sent = transfer(iov, n, true);
 
     if (err_on_start()) {
         // Error occur, right at the start
-        ret = -1;
+        return -1;
     }
 
-    return ret;
+    return sent;
+}
+
+template< class GBus >
+ssize_t bus_pipe< GBus >::readv(const iovec *iov, size_t n)
+{
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, iov || !n);
+
+    size_t read = transfer(iov, n, false);
+
+    if (err_on_start()) {
+        // Error occur, right at the start
+        return -1;
+    }
+
+    return read;
+}
+
+template< class GBus >
+result< size_t > bus_pipe< GBus >::send(const uint8_t *data, size_t count)
+{
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, data);
+
+    if (!count)
+        return count;
+
+    size_t sent = transfer(data, nullptr, count);
+
+    if (is_error(m_last)) {
+        return m_last;
+    }
+
+    return sent;
+}
+
+template< class GBus >
+result< size_t > bus_pipe< GBus >::receive(uint8_t *buffer, size_t size)
+{
+    ecl_assert_level(ECL_ASSERT_LEVEL_BUS, buffer);
+
+    if (!size)
+        return size;
+
+    size_t read = transfer(nullptr, buffer, size);
+
+    if (is_error(m_last)) {
+        return m_last;
+    }
+
+    return read;
 }
 
 template< class GBus >
@@ -187,6 +301,64 @@ bool bus_pipe< GBus >::err_on_start() const
     return is_error(m_last) && !(m_last == err::io);
 }
 
+template< class GBus >
+size_t bus_pipe< GBus >::transfer(const uint8_t *tx, uint8_t *rx, size_t size)
+{
+    size_t sent = 0;
+    size_t read = 0;
+
+    m_gbus.lock();
+    m_gbus.set_buffers(tx, rx, size);
+
+    m_last = m_gbus.xfer(tx ? &sent : nullptr, rx ? &read : nullptr);
+
+    m_gbus.unlock();
+
+    return tx ? sent : read;
+}
+
+template< class GBus >
+size_t bus_pipe< GBus >::transfer(const iovec *iov, size_t n, bool write)
+{
+    if (n > iov_max) {
+        m_last = err::inval;
+        return 0;
+    }
+
+    bus_segment segs[iov_max];
+    size_t cnt = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!iov[i].iov_len) {
+            continue;
+        }
+
+        auto buf = static_cast< uint8_t* >(iov[i].iov_base);
+        segs[cnt++] = bus_segment{write ? buf : nullptr, write ? nullptr : buf,
+                                  iov[i].iov_len, 0xff};
+    }
+
+    m_last = err::ok;
+
+    if (!cnt) {
+        return 0;
+    }
+
+    size_t moved = 0;
+
+    m_gbus.lock();
+
+    m_last = m_gbus.set_buffers(segs, cnt);
+
+    if (!is_error(m_last)) {
+        m_last = m_gbus.xfer(write ? &moved : nullptr, write ? nullptr : &moved);
+    }
+
+    m_gbus.unlock();
+
+    return moved;
+}
+
 
 }
 
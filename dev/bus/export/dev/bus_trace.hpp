@@ -0,0 +1,193 @@
+#ifndef DEV_BUS_TRACE_HPP_
+#define DEV_BUS_TRACE_HPP_
+
+//!
+//! \file
+//! \brief Binary event log of generic buses.
+//!
+//! When CONFIG_BUS_TRACE is set, every generic_bus records lock
+//! acquisitions, transfers and errors into a RAM ring, without locking
+//! and without formatting, so ISRs and threads can record at any time.
+//! Log is a plain object in RAM, ecl_bus_trace, which is dumped by
+//! a debugger and decoded on host:
+//! \code
+//! (gdb) dump binary value trace.bin ecl_bus_trace
+//! $ bus_trace_decode trace.bin
+//! \endcode
+//! Log can be found in a dump of the whole RAM as well, by its magic.
+//!
+//! Timestamps are taken from the trace clock, provided by the platform.
+//! Clock is 32 bit wide, so gaps between consecutive records must be
+//! shorter than its period, i.e. 25 s for 168 MHz cycle counter.
+//!
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef CONFIG_BUS_TRACE_SIZE
+//! Amount of records in the log. Older records are overwritten.
+#define CONFIG_BUS_TRACE_SIZE 128
+#endif
+
+namespace ecl
+{
+
+//! Kinds of events in the log.
+enum class bus_trace_event : uint8_t
+{
+    init,       //!< Bus is initialized. arg0 - address of the platform bus.
+    lock,       //!< Bus is locked. arg0 - wait time, arg1 - caller address.
+    unlock,     //!< Bus is unlocked. arg0 - hold time, arg1 - caller of lock().
+    xfer,       //!< Xfer is started. arg0 - bytes to transfer, arg1 - segments.
+    done,       //!< Xfer is complete. arg0 - duration, arg1 - bytes transferred.
+    error,      //!< Error is reported. arg0 - bus_channel, arg1 - bytes so far.
+};
+
+//!
+//! \brief Flags of the xfer and done records.
+//!
+struct bus_trace_flags
+{
+    static constexpr uint16_t async     = 0x1;  //!< Xfer is asynchronous.
+    static constexpr uint16_t stream    = 0x2;  //!< Xfer is a stream.
+    static constexpr uint16_t chain     = 0x4;  //!< Xfer is a segment chain.
+    static constexpr uint16_t next      = 0x8;  //!< Xfer continues previous one.
+    static constexpr uint16_t failed    = 0x10; //!< Xfer is complete with error.
+};
+
+//!
+//! \brief Single event. Times are in ticks of the trace clock.
+//!
+struct bus_trace_record
+{
+    uint32_t    seq;    //!< Ordinal of the record. Written last, when record is complete.
+    uint32_t    time;   //!< Timestamp.
+    uint32_t    arg0;   //!< Depends on event.
+    uint32_t    arg1;   //!< Depends on event.
+    uint8_t     bus;    //!< Bus id, in order of initialization.
+    uint8_t     event;  //!< One of bus_trace_event.
+    uint16_t    flags;  //!< Depends on event, see bus_trace_flags.
+};
+
+//! Marks start of the log in a memory dump.
+constexpr uint32_t bus_trace_magic   = 0x54737542; // "BusT"
+//! Layout version of the log.
+constexpr uint16_t bus_trace_version = 1;
+
+//!
+//! \brief Log header. Layout of the log, as it appears in a dump, is:
+//! header followed by capacity records. Both are little-endian.
+//!
+struct bus_trace_header
+{
+    uint32_t    magic;      //!< bus_trace_magic, once log is started.
+    uint16_t    version;    //!< bus_trace_version.
+    uint16_t    capacity;   //!< Amount of records, power of two.
+    uint32_t    clock_hz;   //!< Rate of the trace clock.
+    uint32_t    head;       //!< Records written ever. Next one takes head % capacity.
+};
+
+static_assert(sizeof(bus_trace_record) == 20, "Record layout is a part of dump format");
+static_assert(sizeof(bus_trace_header) == 16, "Header layout is a part of dump format");
+
+//!
+//! \brief The log itself.
+//!
+struct bus_trace_log
+{
+    static_assert(CONFIG_BUS_TRACE_SIZE && !(CONFIG_BUS_TRACE_SIZE & (CONFIG_BUS_TRACE_SIZE - 1)),
+                  "Trace size must be power of two");
+    static_assert(CONFIG_BUS_TRACE_SIZE <= 0x8000, "Trace size must fit the header");
+
+    bus_trace_header    hdr;                                //!< Header.
+    bus_trace_record    records[CONFIG_BUS_TRACE_SIZE];     //!< Ring of records.
+};
+
+//!
+//! \brief Starts the trace clock. Provided by the platform.
+//!
+void bus_trace_clock_init();
+
+//!
+//! \brief Gets current tick of the trace clock. Provided by the platform.
+//! Must be callable from any context.
+//!
+uint32_t bus_trace_clock();
+
+//!
+//! \brief Gets rate of the trace clock. Provided by the platform.
+//!
+uint32_t bus_trace_clock_hz();
+
+//!
+//! \brief Writes records into the log.
+//!
+class bus_trace
+{
+public:
+    //!
+    //! \brief Registers a bus and starts the log, if not yet.
+    //! \pre Not called concurrently, i.e. buses are inited from single thread.
+    //! \param[in] pbus Platform bus, its address is recorded to tell buses apart.
+    //! \return Id of the bus.
+    //!
+    static uint8_t attach(const void *pbus);
+
+    //!
+    //! \brief Gets current timestamp.
+    //!
+    static uint32_t now() { return bus_trace_clock(); }
+
+    //!
+    //! \brief Appends a record. Lock-free, callable from any context.
+    //! Record being written concurrently with a dump is dropped by decoder.
+    //!
+    static void record(uint8_t bus, bus_trace_event ev, uint32_t arg0,
+                       uint32_t arg1, uint16_t flags = 0);
+
+    //!
+    //! \brief Discards all records.
+    //! \pre Not called concurrently with record().
+    //!
+    static void reset();
+
+    //! Gets the log.
+    static const bus_trace_log &log();
+};
+
+} // namespace ecl
+
+//! The log. Named so it is easily found by debugger.
+extern ecl::bus_trace_log ecl_bus_trace;
+
+namespace ecl
+{
+
+inline void bus_trace::record(uint8_t bus, bus_trace_event ev, uint32_t arg0,
+                              uint32_t arg1, uint16_t flags)
+{
+    auto seq = __atomic_fetch_add(&ecl_bus_trace.hdr.head, 1, __ATOMIC_RELAXED);
+    auto &r  = ecl_bus_trace.records[seq & (CONFIG_BUS_TRACE_SIZE - 1)];
+
+    // Slot can be dumped half-written, invalidate it first
+    __atomic_store_n(&r.seq, ~seq, __ATOMIC_RELAXED);
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+    r.time  = now();
+    r.arg0  = arg0;
+    r.arg1  = arg1;
+    r.bus   = bus;
+    r.event = static_cast< uint8_t >(ev);
+    r.flags = flags;
+
+    __atomic_store_n(&r.seq, seq, __ATOMIC_RELEASE);
+}
+
+inline const bus_trace_log &bus_trace::log()
+{
+    return ecl_bus_trace;
+}
+
+} // namespace ecl
+
+#endif // DEV_BUS_TRACE_HPP_
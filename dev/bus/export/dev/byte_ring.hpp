@@ -0,0 +1,233 @@
+#ifndef DEV_BUS_BYTE_RING_HPP_
+#define DEV_BUS_BYTE_RING_HPP_
+
+//!
+//! \file
+//! \brief      Lock-free single-producer single-consumer byte ring.
+//! \copyright
+//!
+
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+namespace ecl
+{
+
+//!
+//! \brief Lock-free byte ring.
+//!
+//! Ring is safe to use when exactly one producer and exactly one consumer
+//! are accessing it concurrently, e.g. thread and ISR. Besides copying
+//! routines, ring lends its own storage in form of contiguous spans, so
+//! data can be moved in and out by DMA without additional copies.
+//! \tparam N Capacity of the ring. Must be a power of two.
+//!
+template< size_t N >
+class byte_ring
+{
+    static_assert(N && !(N & (N - 1)), "Ring capacity must be a power of two");
+
+public:
+    //!
+    //! \brief Constructs empty ring.
+    //!
+    byte_ring();
+
+    //!
+    //! \brief Copies data into the ring.
+    //! Producer side.
+    //! \param[in] data  Data to copy. Must not be null.
+    //! \param[in] count Amount of bytes to copy.
+    //! \return Bytes copied. Can be less than requested, if ring is full.
+    //!
+    size_t write(const uint8_t *data, size_t count);
+
+    //!
+    //! \brief Copies data out of the ring.
+    //! Consumer side.
+    //! \param[out] data  Buffer to copy to. Must not be null.
+    //! \param[in]  count Size of the buffer.
+    //! \return Bytes copied. Can be less than requested, if ring is empty.
+    //!
+    size_t read(uint8_t *data, size_t count);
+
+    //!
+    //! \brief Gets contiguous span of free space.
+    //! Producer side. Span may be shorter than total free space,
+    //! if free space wraps around the end of the storage.
+    //! \param[out] len Length of the span.
+    //! \return Pointer to the span.
+    //!
+    uint8_t *write_span(size_t &len);
+
+    //!
+    //! \brief Makes bytes written to the write span visible to the consumer.
+    //! Producer side.
+    //! \pre Given amount is not greater than length of the write span.
+    //! \param[in] count Amount of bytes written.
+    //!
+    void commit(size_t count);
+
+    //!
+    //! \brief Gets contiguous span of data.
+    //! Consumer side. Span may be shorter than total amount of data,
+    //! if data wraps around the end of the storage.
+    //! \param[out] len Length of the span.
+    //! \return Pointer to the span.
+    //!
+    const uint8_t *read_span(size_t &len) const;
+
+    //!
+    //! \brief Releases bytes from the read span back to the producer.
+    //! Consumer side.
+    //! \pre Given amount is not greater than length of the read span.
+    //! \param[in] count Amount of bytes to release.
+    //!
+    void consume(size_t count);
+
+    //!
+    //! \brief Gets amount of bytes stored in the ring.
+    //!
+    size_t size() const;
+
+    //!
+    //! \brief Gets amount of bytes that can be stored in the ring.
+    //!
+    size_t free() const;
+
+    //!
+    //! \brief Checks if ring is empty.
+    //!
+    bool empty() const;
+
+    //!
+    //! \brief Gets capacity of the ring.
+    //!
+    static constexpr size_t capacity() { return N; }
+
+private:
+    //! Converts free-running counter to the storage index.
+    static constexpr size_t index(size_t cnt) { return cnt & (N - 1); }
+
+    std::array< uint8_t, N >    m_buf;      //!< Ring storage.
+    std::atomic_size_t          m_head;     //!< Producer counter.
+    std::atomic_size_t          m_tail;     //!< Consumer counter.
+};
+
+//------------------------------------------------------------------------------
+
+template< size_t N >
+byte_ring< N >::byte_ring()
+    :m_buf{}
+    ,m_head{0}
+    ,m_tail{0}
+{
+
+}
+
+template< size_t N >
+size_t byte_ring< N >::write(const uint8_t *data, size_t count)
+{
+    size_t copied = 0;
+    size_t len;
+
+    // Two spans at most, if free space wraps around
+    while (copied < count) {
+        auto span = write_span(len);
+        if (!len) {
+            break;
+        }
+
+        len = std::min(len, count - copied);
+        std::copy(data + copied, data + copied + len, span);
+        commit(len);
+        copied += len;
+    }
+
+    return copied;
+}
+
+template< size_t N >
+size_t byte_ring< N >::read(uint8_t *data, size_t count)
+{
+    size_t copied = 0;
+    size_t len;
+
+    // Two spans at most, if data wraps around
+    while (copied < count) {
+        auto span = read_span(len);
+        if (!len) {
+            break;
+        }
+
+        len = std::min(len, count - copied);
+        std::copy(span, span + len, data + copied);
+        consume(len);
+        copied += len;
+    }
+
+    return copied;
+}
+
+template< size_t N >
+uint8_t *byte_ring< N >::write_span(size_t &len)
+{
+    auto head = m_head.load(std::memory_order_relaxed);
+    auto tail = m_tail.load(std::memory_order_acquire);
+
+    auto free = N - (head - tail);
+    len = std::min(free, N - index(head));
+
+    return m_buf.data() + index(head);
+}
+
+template< size_t N >
+void byte_ring< N >::commit(size_t count)
+{
+    auto head = m_head.load(std::memory_order_relaxed);
+    m_head.store(head + count, std::memory_order_release);
+}
+
+template< size_t N >
+const uint8_t *byte_ring< N >::read_span(size_t &len) const
+{
+    auto tail = m_tail.load(std::memory_order_relaxed);
+    auto head = m_head.load(std::memory_order_acquire);
+
+    len = std::min(head - tail, N - index(tail));
+
+    return m_buf.data() + index(tail);
+}
+
+template< size_t N >
+void byte_ring< N >::consume(size_t count)
+{
+    auto tail = m_tail.load(std::memory_order_relaxed);
+    m_tail.store(tail + count, std::memory_order_release);
+}
+
+template< size_t N >
+size_t byte_ring< N >::size() const
+{
+    return m_head.load(std::memory_order_acquire)
+            - m_tail.load(std::memory_order_acquire);
+}
+
+template< size_t N >
+size_t byte_ring< N >::free() const
+{
+    return N - size();
+}
+
+template< size_t N >
+bool byte_ring< N >::empty() const
+{
+    return !size();
+}
+
+} // namespace ecl
+
+#endif // DEV_BUS_BYTE_RING_HPP_
@@ -0,0 +1,107 @@
+#ifndef DEV_BUS_DEV_SENDFILE_HPP_
+#define DEV_BUS_DEV_SENDFILE_HPP_
+
+//!
+//! \file
+//! \brief      File to bus streaming.
+//! Block of a file is read while previous one is transferred by the bus,
+//! so streaming runs at the speed of the slower device:
+//! \code
+//!     auto fd = fs.open("/sd/firmware.bin");
+//!     ecl::sendfile(fd, uart_pipe, image_size);
+//! \endcode
+//! \copyright
+//!
+
+#include <ecl/err.hpp>
+#include <ecl/thread/completion.hpp>
+
+#include <platform/common/bus.hpp>
+
+#include "bus_pipe.hpp"
+
+#include <algorithm>
+
+namespace ecl
+{
+
+//!
+//! \brief Sends part of a file through a bus pipe.
+//! Two block buffers are used in turn: one is filled by the file read,
+//! while the other one is transmitted by async bus xfer. Bus is locked
+//! during the whole transfer.
+//! \warning File must not reside on the same bus, since file reads
+//! would wait for the bus forever.
+//! \tparam block   Size of each block buffer. Multiple of a storage sector
+//!                 lets the filesystem read sectors in place.
+//! \tparam FilePtr Pointer to a file, i.e. fs::file_ptr.
+//! \tparam GBus    Generic bus driver of the pipe.
+//! \pre Pipe is initialized and file position is set.
+//! \param[in] file File to read from, starting from current position.
+//! \param[in] pipe Pipe to write to.
+//! \param[in] len  Amount of bytes to send. Streaming stops earlier
+//!                 at the end of the file.
+//! \return Amount of bytes sent, or -1 if error occurred before anything
+//!         was sent.
+//!
+template< size_t block = 512, class FilePtr, class GBus >
+ssize_t sendfile(const FilePtr &file, bus_pipe< GBus > &pipe, size_t len)
+{
+    static_assert(block > 0, "Block must not be empty");
+
+    (void) pipe;
+
+    // Bus lock protects buffers from concurrent streams
+    static uint8_t buffers[2][block];
+
+    ecl::completion done;
+    bool failed = false;
+    size_t sent = 0;
+    int cur = 0;
+
+    auto handler = [&done, &failed](bus_channel ch, bus_event type, size_t total) {
+        (void) total;
+
+        if (type == bus_event::err) {
+            failed = true;
+        } else if (ch == bus_channel::meta && type == bus_event::tc) {
+            done.signal();
+        }
+    };
+
+    GBus::lock();
+
+    auto rc = file->read(buffers[cur], std::min(len, block));
+
+    while (rc > 0) {
+        size_t size = rc;
+        len -= size;
+
+        GBus::set_buffers(buffers[cur], nullptr, size);
+
+        if (is_error(GBus::xfer(handler))) {
+            failed = true;
+            break;
+        }
+
+        // Next block is read while current one is in flight
+        cur ^= 1;
+        rc = len ? file->read(buffers[cur], std::min(len, block)) : 0;
+
+        done.wait();
+
+        if (failed) {
+            break;
+        }
+
+        sent += size;
+    }
+
+    GBus::unlock();
+
+    return (!sent && (rc < 0 || failed)) ? -1 : static_cast< ssize_t >(sent);
+}
+
+} // namespace ecl
+
+#endif // DEV_BUS_DEV_SENDFILE_HPP_
@@ -0,0 +1,119 @@
+#include <dev/buffered_bus_pipe.hpp>
+
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+// Generic bus, that answers with a pattern and records size of each xfer.
+struct fake_bus
+{
+    static std::vector< size_t >    xfers;
+    static uint8_t                  pattern;
+
+    ecl::err init() { return ecl::err::ok; }
+    void lock() { }
+    void unlock() { }
+
+    ecl::err set_buffers(const uint8_t *tx, uint8_t *rx, size_t size)
+    {
+        m_tx = tx;
+        m_rx = rx;
+        m_size = size;
+        return ecl::err::ok;
+    }
+
+    ecl::err xfer(size_t *tx_cnt, size_t *rx_cnt)
+    {
+        xfers.push_back(m_size);
+
+        if (m_rx) {
+            for (size_t i = 0; i < m_size; ++i) {
+                m_rx[i] = pattern++;
+            }
+        }
+
+        if (tx_cnt) {
+            *tx_cnt = m_tx ? m_size : 0;
+        }
+
+        if (rx_cnt) {
+            *rx_cnt = m_rx ? m_size : 0;
+        }
+
+        return ecl::err::ok;
+    }
+
+    const uint8_t *m_tx = nullptr;
+    uint8_t *m_rx = nullptr;
+    size_t m_size = 0;
+};
+
+std::vector< size_t > fake_bus::xfers;
+uint8_t fake_bus::pattern;
+
+using pipe_t = ecl::buffered_bus_pipe< fake_bus, 16 >;
+
+TEST_GROUP(buffered_bus_pipe)
+{
+    void setup()
+    {
+        fake_bus::xfers.clear();
+        fake_bus::pattern = 0;
+    }
+};
+
+TEST(buffered_bus_pipe, read_requests_only_size_asked)
+{
+    pipe_t pipe;
+    uint8_t buf[4] = {};
+
+    CHECK_EQUAL(1, pipe.read(buf, 1));
+    CHECK_EQUAL(0, buf[0]);
+
+    CHECK_EQUAL(3, pipe.read(buf, 3));
+    CHECK_EQUAL(1, buf[0]);
+    CHECK_EQUAL(3, buf[2]);
+
+    CHECK_EQUAL(2, fake_bus::xfers.size());
+    CHECK_EQUAL(1, fake_bus::xfers[0]);
+    CHECK_EQUAL(3, fake_bus::xfers[1]);
+}
+
+TEST(buffered_bus_pipe, read_is_bounded_by_ring)
+{
+    pipe_t pipe;
+    uint8_t buf[32] = {};
+
+    CHECK_EQUAL(16, pipe.read(buf, sizeof(buf)));
+    CHECK_EQUAL(1, fake_bus::xfers.size());
+    CHECK_EQUAL(16, fake_bus::xfers[0]);
+}
+
+TEST(buffered_bus_pipe, peek_read_requests_only_size_asked)
+{
+    pipe_t pipe;
+    size_t len = 0;
+
+    auto span = pipe.peek_read(2, len);
+    CHECK_TRUE(span);
+    CHECK_EQUAL(2, len);
+    CHECK_EQUAL(0, span[0]);
+    CHECK_EQUAL(1, span[1]);
+
+    pipe.consume(1);
+
+    // Staged data is returned without new xfer
+    span = pipe.peek_read(8, len);
+    CHECK_EQUAL(1, len);
+    CHECK_EQUAL(1, span[0]);
+    pipe.consume(len);
+
+    CHECK_EQUAL(1, fake_bus::xfers.size());
+    CHECK_EQUAL(2, fake_bus::xfers[0]);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,204 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTestExt/MockSupport.h>
+
+#include "dev/bus.hpp"
+#include "dev/bus_device.hpp"
+#include "mocks/platform_bus.hpp"
+
+using bus_t = ecl::generic_bus< platform_mock >;
+
+// Error code helper
+static SimpleString StringFrom(ecl::err err)
+{
+    return SimpleString{ecl::err_to_str(err)};
+}
+
+template< int id >
+struct cs_mock
+{
+    static void set()
+    {
+        mock("cs").actualCall("set").withParameter("id", id);
+    }
+
+    static void reset()
+    {
+        mock("cs").actualCall("reset").withParameter("id", id);
+    }
+};
+
+struct config_a
+{
+    static constexpr uint32_t   clk         = 400000;
+    static constexpr uint16_t   cpol        = 0;
+    static constexpr uint16_t   cpha        = 1;
+    static constexpr uint8_t    priority    = 1;
+};
+
+struct config_b
+{
+    static constexpr uint32_t   clk         = 8000000;
+    static constexpr uint16_t   cpol        = 2;
+    static constexpr uint16_t   cpha        = 0;
+    static constexpr uint8_t    priority    = 2;
+};
+
+constexpr uint32_t config_a::clk;
+constexpr uint16_t config_a::cpol;
+constexpr uint16_t config_a::cpha;
+constexpr uint8_t  config_a::priority;
+constexpr uint32_t config_b::clk;
+constexpr uint16_t config_b::cpol;
+constexpr uint16_t config_b::cpha;
+constexpr uint8_t  config_b::priority;
+
+using dev_a = ecl::bus_device< bus_t, cs_mock< 0 >, config_a >;
+using dev_b = ecl::bus_device< bus_t, cs_mock< 1 >, config_b >;
+
+TEST_GROUP(bus_device)
+{
+    void setup()
+    {
+        mock().disable();
+        dev_a::init();
+        dev_b::init();
+        mock().enable();
+
+        ecl::bus_arbiter< bus_t >::reset_ownership();
+    }
+
+    void teardown()
+    {
+        mock().disable();
+        bus_t::deinit();
+        mock().enable();
+
+        mock().clear();
+    }
+
+    template< class config >
+    void expect_config()
+    {
+        mock("platform_bus")
+                .expectOneCall("set_mode")
+                .withParameter("cpol", config::cpol)
+                .withParameter("cpha", config::cpha);
+        mock("platform_bus")
+                .expectOneCall("set_clock")
+                .withParameter("clk", config::clk);
+    }
+};
+
+TEST(bus_device, init)
+{
+    // Bus is inited by setup(), so platform bus would not be touched again
+    mock().disable();
+    bus_t::deinit();
+    mock().enable();
+
+    mock("cs").expectOneCall("set").withParameter("id", 0);
+    mock("platform_bus").expectOneCall("init");
+    mock("platform_bus").ignoreOtherCalls();
+
+    auto rc = dev_a::init();
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    mock().checkExpectations();
+}
+
+TEST(bus_device, chip_select)
+{
+    mock("mutex").ignoreOtherCalls();
+    mock("platform_bus").ignoreOtherCalls();
+
+    mock("cs").expectOneCall("reset").withParameter("id", 0);
+
+    dev_a::lock();
+
+    mock().checkExpectations();
+
+    mock("cs").expectOneCall("set").withParameter("id", 0);
+
+    dev_a::unlock();
+
+    mock().checkExpectations();
+}
+
+TEST(bus_device, reconfigure_on_owner_change)
+{
+    mock("mutex").ignoreOtherCalls();
+    mock("cs").ignoreOtherCalls();
+
+    // First owner always configures the bus
+    expect_config< config_a >();
+    mock("platform_bus").ignoreOtherCalls();
+
+    auto rc = dev_a::lock();
+    CHECK_EQUAL(ecl::err::ok, rc);
+    dev_a::unlock();
+
+    mock().checkExpectations();
+
+    // Same owner, no configuration required
+    mock("platform_bus").expectNoCall("set_mode");
+    mock("platform_bus").expectNoCall("set_clock");
+    mock("platform_bus").ignoreOtherCalls();
+
+    dev_a::lock();
+    dev_a::unlock();
+
+    mock().checkExpectations();
+
+    // Owner is changed
+    expect_config< config_b >();
+    mock("platform_bus").ignoreOtherCalls();
+
+    dev_b::lock();
+    dev_b::unlock();
+
+    mock().checkExpectations();
+
+    // And back again
+    expect_config< config_a >();
+    mock("platform_bus").ignoreOtherCalls();
+
+    dev_a::lock();
+    dev_a::unlock();
+
+    mock().checkExpectations();
+}
+
+TEST(bus_device, reconfigure_after_error)
+{
+    mock("mutex").ignoreOtherCalls();
+    mock("cs").ignoreOtherCalls();
+
+    mock("platform_bus")
+            .expectOneCall("set_mode")
+            .withParameter("cpol", config_a::cpol)
+            .withParameter("cpha", config_a::cpha)
+            .andReturnValue(static_cast< int >(ecl::err::busy));
+    mock("platform_bus").ignoreOtherCalls();
+
+    auto rc = dev_a::lock();
+    CHECK_EQUAL(ecl::err::busy, rc);
+    dev_a::unlock();
+
+    mock().checkExpectations();
+
+    // Failed configuration must be retried, even for the same device
+    expect_config< config_a >();
+    mock("platform_bus").ignoreOtherCalls();
+
+    rc = dev_a::lock();
+    CHECK_EQUAL(ecl::err::ok, rc);
+    dev_a::unlock();
+
+    mock().checkExpectations();
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,187 @@
+#include <dev/bus_pipe.hpp>
+
+#include <cstring>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+// Generic bus, that keeps everything sent and answers with a pattern.
+// Each xfer is recorded, so tests see how many transactions were made.
+struct fake_bus
+{
+    static std::vector< uint8_t >   sent;
+    static std::vector< size_t >    xfers;
+    static ecl::err                 result;
+    static bool                     locked;
+
+    static const ecl::bus_segment   *segs;
+    static size_t                   seg_cnt;
+
+    ecl::err init() { return ecl::err::ok; }
+    void lock() { CHECK_FALSE(locked); locked = true; }
+    void unlock() { CHECK_TRUE(locked); locked = false; }
+
+    ecl::err set_buffers(const uint8_t *tx, uint8_t *rx, size_t size)
+    {
+        one = ecl::bus_segment{tx, rx, size, 0xff};
+        return set_buffers(&one, 1);
+    }
+
+    ecl::err set_buffers(const ecl::bus_segment *s, size_t n)
+    {
+        CHECK_TRUE(locked);
+        segs = s;
+        seg_cnt = n;
+        return ecl::err::ok;
+    }
+
+    ecl::err xfer(size_t *tx_cnt, size_t *rx_cnt)
+    {
+        size_t total = 0;
+        size_t pattern = 0;
+
+        for (size_t i = 0; i < seg_cnt; ++i) {
+            const auto &s = segs[i];
+
+            if (s.tx) {
+                sent.insert(sent.end(), s.tx, s.tx + s.size);
+            }
+
+            if (s.rx) {
+                for (size_t j = 0; j < s.size; ++j) {
+                    s.rx[j] = pattern++;
+                }
+            }
+
+            total += s.size;
+        }
+
+        xfers.push_back(total);
+
+        if (tx_cnt) {
+            *tx_cnt = total;
+        }
+
+        if (rx_cnt) {
+            *rx_cnt = total;
+        }
+
+        return result;
+    }
+
+    ecl::bus_segment one;
+};
+
+std::vector< uint8_t > fake_bus::sent;
+std::vector< size_t > fake_bus::xfers;
+ecl::err fake_bus::result;
+bool fake_bus::locked;
+const ecl::bus_segment *fake_bus::segs;
+size_t fake_bus::seg_cnt;
+
+using pipe_t = ecl::bus_pipe< fake_bus >;
+
+TEST_GROUP(bus_pipe)
+{
+    void setup()
+    {
+        fake_bus::sent.clear();
+        fake_bus::xfers.clear();
+        fake_bus::result = ecl::err::ok;
+        fake_bus::locked = false;
+    }
+};
+
+TEST(bus_pipe, writev_sends_message_in_single_xfer)
+{
+    pipe_t pipe;
+    uint8_t hdr[] = { 1, 2, 3 };
+    uint8_t body[] = { 4, 5, 6, 7, 8 };
+
+    ecl::iovec iov[] = {
+        { hdr, sizeof(hdr) },
+        { nullptr, 0 },
+        { body, sizeof(body) },
+    };
+
+    CHECK_EQUAL(8, pipe.writev(iov, 3));
+
+    CHECK_EQUAL(1, fake_bus::xfers.size());
+    CHECK_EQUAL(2, fake_bus::seg_cnt);
+    CHECK_EQUAL(8, fake_bus::sent.size());
+    MEMCMP_EQUAL(hdr, fake_bus::sent.data(), sizeof(hdr));
+    MEMCMP_EQUAL(body, fake_bus::sent.data() + sizeof(hdr), sizeof(body));
+    CHECK_FALSE(fake_bus::locked);
+}
+
+TEST(bus_pipe, readv_scatters_data)
+{
+    pipe_t pipe;
+    uint8_t hdr[2] = {};
+    uint8_t body[4] = {};
+
+    ecl::iovec iov[] = {
+        { hdr, sizeof(hdr) },
+        { body, sizeof(body) },
+    };
+
+    CHECK_EQUAL(6, pipe.readv(iov, 2));
+    CHECK_EQUAL(1, fake_bus::xfers.size());
+
+    const uint8_t expected_hdr[] = { 0, 1 };
+    const uint8_t expected_body[] = { 2, 3, 4, 5 };
+
+    MEMCMP_EQUAL(expected_hdr, hdr, sizeof(hdr));
+    MEMCMP_EQUAL(expected_body, body, sizeof(body));
+}
+
+TEST(bus_pipe, empty_vectors_make_no_xfer)
+{
+    pipe_t pipe;
+    ecl::iovec iov[] = { { nullptr, 0 } };
+
+    CHECK_EQUAL(0, pipe.writev(iov, 1));
+    CHECK_EQUAL(0, pipe.readv(nullptr, 0));
+    CHECK_TRUE(fake_bus::xfers.empty());
+    CHECK_TRUE(pipe.last_error() == ecl::err::ok);
+}
+
+TEST(bus_pipe, too_many_vectors_are_rejected)
+{
+    pipe_t pipe;
+    uint8_t byte = 0;
+    ecl::iovec iov[pipe_t::iov_max + 1];
+
+    for (auto &v : iov) {
+        v = ecl::iovec{ &byte, 1 };
+    }
+
+    CHECK_EQUAL(-1, pipe.writev(iov, pipe_t::iov_max + 1));
+    CHECK_TRUE(pipe.last_error() == ecl::err::inval);
+    CHECK_TRUE(fake_bus::xfers.empty());
+
+    CHECK_EQUAL(static_cast< ssize_t >(pipe_t::iov_max), pipe.writev(iov, pipe_t::iov_max));
+}
+
+TEST(bus_pipe, errors_are_reported_like_write)
+{
+    pipe_t pipe;
+    uint8_t buf[4] = {};
+    ecl::iovec iov[] = { { buf, sizeof(buf) } };
+
+    // Error during xfer tells amount of bytes moved
+    fake_bus::result = ecl::err::io;
+    CHECK_EQUAL(4, pipe.writev(iov, 1));
+    CHECK_TRUE(pipe.last_error() == ecl::err::io);
+
+    // Error at start is negative
+    fake_bus::result = ecl::err::busy;
+    CHECK_EQUAL(-1, pipe.readv(iov, 1));
+    CHECK_TRUE(pipe.last_error() == ecl::err::busy);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
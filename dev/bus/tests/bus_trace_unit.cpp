@@ -0,0 +1,176 @@
+// Bus trace is always compiled in here, regardless of the project config
+#define CONFIG_BUS_TRACE
+
+#include <dev/bus.hpp>
+#include <dev/bus_trace.hpp>
+#include <loopback_bus.hpp>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+// Trace clock, advanced by tests. Overrides the default host clock.
+static uint32_t fake_ticks;
+
+namespace ecl
+{
+
+void bus_trace_clock_init()
+{
+}
+
+uint32_t bus_trace_clock()
+{
+    return fake_ticks++;
+}
+
+uint32_t bus_trace_clock_hz()
+{
+    return 1000;
+}
+
+} // namespace ecl
+
+using bus_t = ecl::generic_bus< loopback_bus >;
+using ecl::bus_trace;
+using ecl::bus_trace_event;
+
+static const ecl::bus_trace_record &nth(uint32_t seq)
+{
+    return bus_trace::log().records[seq % CONFIG_BUS_TRACE_SIZE];
+}
+
+static uint8_t event(uint32_t seq)
+{
+    return nth(seq).event;
+}
+
+static uint8_t ev(bus_trace_event e)
+{
+    return static_cast< uint8_t >(e);
+}
+
+TEST_GROUP(bus_trace)
+{
+    void setup()
+    {
+        fake_ticks = 0;
+        bus_trace::reset();
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(bus_trace, record_is_appended)
+{
+    bus_trace::record(3, bus_trace_event::xfer, 16, 1, ecl::bus_trace_flags::async);
+    bus_trace::record(4, bus_trace_event::done, 7, 16);
+
+    CHECK_EQUAL(2, bus_trace::log().hdr.head);
+
+    auto &r = nth(0);
+    CHECK_EQUAL(0, r.seq);
+    CHECK_EQUAL(0, r.time);
+    CHECK_EQUAL(3, r.bus);
+    CHECK_EQUAL(ev(bus_trace_event::xfer), r.event);
+    CHECK_EQUAL(16, r.arg0);
+    CHECK_EQUAL(1, r.arg1);
+    CHECK_EQUAL(ecl::bus_trace_flags::async, r.flags);
+
+    CHECK_EQUAL(1, nth(1).seq);
+    CHECK_EQUAL(1, nth(1).time);
+    CHECK_EQUAL(4, nth(1).bus);
+}
+
+TEST(bus_trace, oldest_records_are_overwritten)
+{
+    constexpr uint32_t total = CONFIG_BUS_TRACE_SIZE + 5;
+
+    for (uint32_t i = 0; i < total; ++i) {
+        bus_trace::record(0, bus_trace_event::error, i, 0);
+    }
+
+    CHECK_EQUAL(total, bus_trace::log().hdr.head);
+
+    // Slot holds the most recent record of those mapped onto it
+    for (uint32_t seq = total - CONFIG_BUS_TRACE_SIZE; seq < total; ++seq) {
+        CHECK_EQUAL(seq, nth(seq).seq);
+        CHECK_EQUAL(seq, nth(seq).arg0);
+    }
+}
+
+TEST(bus_trace, bus_activity_is_recorded)
+{
+    bus_t::init();
+
+    uint8_t tx[32] = {};
+    uint8_t rx[32];
+
+    auto start = bus_trace::log().hdr.head;
+
+    bus_t::lock();
+    CHECK_EQUAL(ecl::err::ok, bus_t::set_buffers(tx, rx, sizeof(tx)));
+    CHECK_EQUAL(ecl::err::ok, bus_t::xfer());
+    bus_t::unlock();
+
+    CHECK_EQUAL(start + 4, bus_trace::log().hdr.head);
+
+    CHECK_EQUAL(ev(bus_trace_event::lock), event(start));
+    CHECK_EQUAL(ev(bus_trace_event::xfer), event(start + 1));
+    CHECK_EQUAL(ev(bus_trace_event::done), event(start + 2));
+    CHECK_EQUAL(ev(bus_trace_event::unlock), event(start + 3));
+
+    // Size of buffers and bytes actually transferred
+    CHECK_EQUAL(sizeof(tx), nth(start + 1).arg0);
+    CHECK_EQUAL(1, nth(start + 1).arg1);
+    CHECK_EQUAL(0, nth(start + 1).flags);
+    CHECK_EQUAL(sizeof(tx), nth(start + 2).arg1);
+    CHECK_EQUAL(0, nth(start + 2).flags);
+
+    // Xfer took time between its start and completion records
+    CHECK_TRUE(nth(start + 2).arg0 > 0);
+    CHECK_TRUE(nth(start + 3).arg0 >= nth(start + 2).arg0);
+
+    // Lock and unlock both point to the lock owner
+    CHECK_EQUAL(nth(start).arg1, nth(start + 3).arg1);
+    CHECK_TRUE(nth(start).arg1 != 0);
+}
+
+TEST(bus_trace, async_chain_is_recorded)
+{
+    bus_t::init();
+
+    uint8_t buf[16] = {};
+    ecl::bus_segment segs[] = {
+        { buf, nullptr, 4, 0 },
+        { nullptr, nullptr, 8, 0xff },
+    };
+
+    bool done = false;
+    auto start = bus_trace::log().hdr.head;
+
+    bus_t::lock();
+    CHECK_EQUAL(ecl::err::ok, bus_t::set_buffers(segs, 2));
+    CHECK_EQUAL(ecl::err::ok, bus_t::xfer([&done](ecl::bus_channel ch, ecl::bus_event e, size_t) {
+        done = done || (ch == ecl::bus_channel::meta && e == ecl::bus_event::tc);
+    }));
+    bus_t::unlock();
+
+    CHECK_TRUE(done);
+
+    auto &x = nth(start + 1);
+    CHECK_EQUAL(ev(bus_trace_event::xfer), x.event);
+    CHECK_EQUAL(12, x.arg0);
+    CHECK_EQUAL(2, x.arg1);
+    CHECK_EQUAL(ecl::bus_trace_flags::async | ecl::bus_trace_flags::chain, x.flags);
+
+    // Single completion for the whole chain
+    CHECK_EQUAL(ev(bus_trace_event::done), event(start + 2));
+    CHECK_EQUAL(ev(bus_trace_event::unlock), event(start + 3));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -75,6 +75,150 @@ TEST(bus, lock_unlock)
     mock().checkExpectations();
 }
 
+TEST(bus, lock_with_clock)
+{
+    constexpr uint32_t clk = 400000;
+    ecl::err expected_ret = ecl::err::inval;
+
+    mock().disable();
+    test_bus->init();
+    mock().enable();
+
+    mock("mutex").expectOneCall("lock");
+    mock("platform_bus")
+            .expectOneCall("set_clock")
+            .withParameter("clk", clk)
+            .andReturnValue(static_cast< int >(expected_ret));
+    mock("platform_bus").expectOneCall("reset_buffers");
+    mock("mutex").expectOneCall("unlock");
+
+    auto ret = test_bus->lock(clk);
+
+    // Retval must be the same as produced by platform counterpart
+    CHECK_EQUAL(expected_ret, ret);
+
+    test_bus->unlock();
+
+    mock().checkExpectations();
+}
+
+TEST(bus, submit_priority)
+{
+    uint8_t buf[4];
+    int order[3] = {};
+    int done = 0;
+
+    auto complete = [&](ecl::bus_transaction &t) {
+        CHECK_EQUAL(ecl::err::ok, t.status);
+        order[done++] = t.priority;
+    };
+
+    ecl::bus_transaction low  = { buf, nullptr, sizeof(buf), 1, complete };
+    ecl::bus_transaction mid  = { buf, nullptr, sizeof(buf), 2, complete };
+    ecl::bus_transaction high = { buf, nullptr, sizeof(buf), 3, complete };
+
+    mock().disable();
+    test_bus->init();
+    mock().enable();
+
+    mock("mutex").ignoreOtherCalls();
+    mock("platform_bus").ignoreOtherCalls();
+
+    // Bus is idle, first transaction is started immediately
+    auto rc = test_bus->submit(mid);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    // Rest of transactions are queued
+    rc = test_bus->submit(low);
+    CHECK_EQUAL(ecl::err::ok, rc);
+    rc = test_bus->submit(high);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    CHECK_EQUAL(0, done);
+
+    for (int i = 0; i < 3; ++i) {
+        platform_mock::invoke(ecl::bus_channel::tx, ecl::bus_event::tc, sizeof(buf));
+        platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, sizeof(buf));
+    }
+
+    CHECK_EQUAL(3, done);
+    CHECK_EQUAL(2, order[0]);
+    CHECK_EQUAL(3, order[1]);
+    CHECK_EQUAL(1, order[2]);
+
+    CHECK_EQUAL(sizeof(buf), low.sent);
+    CHECK_EQUAL(sizeof(buf), high.sent);
+
+    mock().checkExpectations();
+}
+
+TEST(bus, submit_failed_continuation_drains_queue)
+{
+    uint8_t buf[4];
+    ecl::err status[3] = {};
+    int order[3] = {};
+    int done = 0;
+
+    auto complete = [&](ecl::bus_transaction &t) {
+        status[done] = t.status;
+        order[done++] = t.priority;
+    };
+
+    ecl::bus_transaction low  = { buf, nullptr, sizeof(buf), 1, complete };
+    ecl::bus_transaction mid  = { buf, nullptr, sizeof(buf), 2, complete };
+    ecl::bus_transaction high = { buf, nullptr, sizeof(buf), 3, complete };
+
+    mock().disable();
+    test_bus->init();
+    mock().enable();
+
+    mock("mutex").ignoreOtherCalls();
+    mock("platform_bus").ignoreOtherCalls();
+
+    auto rc = test_bus->submit(mid);
+    CHECK_EQUAL(ecl::err::ok, rc);
+    rc = test_bus->submit(low);
+    CHECK_EQUAL(ecl::err::ok, rc);
+    rc = test_bus->submit(high);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    // Next transaction is scheduled, but fails to start
+    mock("platform_bus").expectOneCall("do_xfer")
+            .andReturnValue(static_cast< int >(ecl::err::io));
+
+    platform_mock::invoke(ecl::bus_channel::tx, ecl::bus_event::tc, sizeof(buf));
+    platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, sizeof(buf));
+
+    // Nothing is left in the queue
+    CHECK_EQUAL(3, done);
+    CHECK_EQUAL(2, order[0]);
+    CHECK_EQUAL(3, order[1]);
+    CHECK_EQUAL(1, order[2]);
+    CHECK_EQUAL(ecl::err::ok, status[0]);
+    CHECK_EQUAL(ecl::err::io, status[1]);
+    CHECK_EQUAL(ecl::err::io, status[2]);
+
+    mock().checkExpectations();
+
+    // Queue is idle, so next transaction is started right away
+    mock("platform_bus").expectOneCall("do_xfer");
+
+    done = 0;
+    rc = test_bus->submit(low);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    mock().checkExpectations();
+
+    platform_mock::invoke(ecl::bus_channel::tx, ecl::bus_event::tc, sizeof(buf));
+    platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, sizeof(buf));
+
+    CHECK_EQUAL(1, done);
+    CHECK_EQUAL(ecl::err::ok, status[0]);
+    CHECK_EQUAL(sizeof(buf), low.sent);
+
+    mock().checkExpectations();
+}
+
 // -----------------------------------------------------------------------------
 
 TEST_GROUP(bus_is_ready)
@@ -103,6 +247,11 @@ TEST_GROUP(bus_is_ready)
         test_bus->deinit();
         mock().enable();
 
+        // Policy and counters are shared by all bus objects
+        platform_mock::set_xfer_hook({});
+        bus_t::set_retry_policy({CONFIG_BUS_RETRIES, nullptr});
+        bus_t::reset_stats();
+
         delete test_bus;
         mock().clear();
     }
@@ -226,11 +375,15 @@ TEST(bus_is_ready, async_xfer_error)
             .expectOneCall("do_xfer")
             .andReturnValue(static_cast< int >(expected_ret));
 
+    auto held = ecl::sleep_lock::held();
     auto ret = test_bus->xfer(handler);
 
     // Retval must be the same as produced by platform counterpart
     CHECK_EQUAL(expected_ret, ret);
 
+    // Failed xfer doesn't leak a sleep lock
+    CHECK_EQUAL(held, ecl::sleep_lock::held());
+
     mock().checkExpectations();
 }
 
@@ -275,7 +428,422 @@ TEST(bus_is_ready, async_xfer_valid)
     mock().checkExpectations();
 }
 
+TEST(bus_is_ready, async_xfer_keeps_mcu_awake)
+{
+    auto handler = [](ecl::bus_channel ch, ecl::bus_event e, size_t total) {
+        (void) e;
+        (void) ch;
+        (void) total;
+    };
+
+    // Other tests may leave xfers unfinished
+    auto held = ecl::sleep_lock::held();
+
+    mock("platform_bus").ignoreOtherCalls();
+
+    auto ret = test_bus->xfer(handler);
+    CHECK_EQUAL(ecl::err::ok, ret);
+
+    // Sleep is inhibited until the final event
+    CHECK_EQUAL(held + 1, ecl::sleep_lock::held());
+
+    platform_mock::invoke(ecl::bus_channel::tx, ecl::bus_event::tc, 1);
+    CHECK_EQUAL(held + 1, ecl::sleep_lock::held());
+
+    platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, 0);
+    CHECK_EQUAL(held, ecl::sleep_lock::held());
+
+    mock().checkExpectations();
+}
+
+TEST(bus_is_ready, async_xfer_in_next_lock_session)
+{
+    auto handler = [](ecl::bus_channel ch, ecl::bus_event e, size_t total) {
+        (void) e;
+        (void) ch;
+        (void) total;
+    };
+
+    mock("platform_bus").ignoreOtherCalls();
+    mock("mutex").ignoreOtherCalls();
 
+    for (int i = 0; i < 3; ++i) {
+        auto ret = test_bus->xfer(handler);
+        CHECK_EQUAL(ecl::err::ok, ret);
+
+        platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, 0);
+
+        // Bus is cleaned on unlock, thus ready for next owner
+        test_bus->unlock();
+        test_bus->lock();
+    }
+
+    mock().checkExpectations();
+}
+
+TEST(bus_is_ready, set_chain_invalid)
+{
+    ecl::bus_segment seg = { tx_buf, rx_buf, buf_size, 0xff };
+
+    auto rc = test_bus->set_buffers(nullptr, 1);
+    CHECK_EQUAL(ecl::err::inval, rc);
+
+    rc = test_bus->set_buffers(&seg, 0);
+    CHECK_EQUAL(ecl::err::inval, rc);
+
+    mock().checkExpectations();
+}
+
+TEST(bus_is_ready, set_chain)
+{
+    constexpr uint8_t fill_byte = 0xae;
+
+    ecl::bus_segment segs[] = {
+        { tx_buf,  nullptr, buf_size, 0xff },
+        { nullptr, nullptr, buf_size, fill_byte },
+    };
+
+    // Only first segment must be passed to the platform bus
+    mock("platform_bus").expectOneCall("reset_buffers");
+    mock("platform_bus")
+            .expectOneCall("set_tx")
+            .withConstPointerParameter("tx_buf", tx_buf)
+            .withParameter("size", buf_size);
+    mock("platform_bus")
+            .expectOneCall("set_rx")
+            .withParameter("rx_buf", (void *) nullptr)
+            .withParameter("size", buf_size);
+
+    auto rc = test_bus->set_buffers(segs, 2);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    mock().checkExpectations();
+}
+
+TEST(bus_is_ready, async_xfer_chain)
+{
+    constexpr uint8_t fill_byte = 0xae;
+
+    ecl::bus_segment segs[] = {
+        { tx_buf,  rx_buf,  buf_size, 0xff },
+        { nullptr, nullptr, buf_size, fill_byte },
+    };
+
+    size_t tx_total = 0;
+    size_t rx_total = 0;
+
+    auto handler = [&](ecl::bus_channel ch, ecl::bus_event e, size_t total) {
+        if (ch == ecl::bus_channel::tx) {
+            tx_total = total;
+        } else if (ch == ecl::bus_channel::rx) {
+            rx_total = total;
+        } else {
+            // Only single completion event is expected for whole chain
+            CHECK_TRUE(ecl::bus_event::tc == e);
+            mock("handler").actualCall("chain_complete");
+        }
+    };
+
+    mock().disable();
+    auto rc = test_bus->set_buffers(segs, 2);
+    mock().enable();
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    mock("platform_bus").expectOneCall("do_xfer");
+
+    rc = test_bus->xfer(handler);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    mock().checkExpectations();
+
+    // First segment completes, second must be started right away
+    mock("platform_bus").expectOneCall("reset_buffers");
+    mock("platform_bus")
+            .expectOneCall("set_tx")
+            .withParameter("rx_size", buf_size)
+            .withParameter("fill_byte", fill_byte);
+    mock("platform_bus").expectOneCall("do_xfer");
+
+    platform_mock::invoke(ecl::bus_channel::tx, ecl::bus_event::tc, buf_size);
+    platform_mock::invoke(ecl::bus_channel::rx, ecl::bus_event::tc, buf_size);
+    platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, buf_size);
+
+    mock().checkExpectations();
+
+    // Second segment completes, so does the chain
+    mock("handler").expectOneCall("chain_complete");
+
+    platform_mock::invoke(ecl::bus_channel::tx, ecl::bus_event::tc, buf_size);
+    platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, buf_size);
+
+    mock().checkExpectations();
+
+    // Counters are accumulated accross the chain
+    CHECK_EQUAL(buf_size * 2, tx_total);
+    CHECK_EQUAL(buf_size, rx_total);
+}
+
+TEST(bus_is_ready, async_xfer_chain_error)
+{
+    ecl::bus_segment segs[] = {
+        { tx_buf, nullptr, buf_size, 0xff },
+        { tx_buf, nullptr, buf_size, 0xff },
+    };
+
+    auto handler = [&](ecl::bus_channel ch, ecl::bus_event e, size_t total) {
+        (void) total;
+        if (ch == ecl::bus_channel::meta && e == ecl::bus_event::tc) {
+            mock("handler").actualCall("chain_complete");
+        }
+    };
+
+    mock().disable();
+    auto rc = test_bus->set_buffers(segs, 2);
+    mock().enable();
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    mock("platform_bus").expectOneCall("do_xfer");
+
+    rc = test_bus->xfer(handler);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    mock().checkExpectations();
+
+    // Error in the first segment breaks the chain
+    mock("handler").expectOneCall("chain_complete");
+
+    platform_mock::invoke(ecl::bus_channel::tx, ecl::bus_event::err, 0);
+    platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, 0);
+
+    mock().checkExpectations();
+}
+
+TEST(bus_is_ready, async_xfer_continue)
+{
+    int completions = 0;
+
+    auto handler = [&](ecl::bus_channel ch, ecl::bus_event e, size_t total) {
+        (void) total;
+        if (ch == ecl::bus_channel::meta && e == ecl::bus_event::tc) {
+            mock("handler").actualCall("complete");
+            // Request single continuation
+            if (!completions++) {
+                auto rc = bus_t::set_next_buffers(tx_buf, nullptr, buf_size);
+                CHECK_EQUAL(ecl::err::ok, rc);
+            }
+        }
+    };
+
+    // Continuation is not allowed outside of the handler
+    auto rc = bus_t::set_next_buffers(tx_buf, nullptr, buf_size);
+    CHECK_EQUAL(ecl::err::perm, rc);
+
+    mock().disable();
+    rc = test_bus->set_buffers(tx_buf, nullptr, buf_size);
+    mock().enable();
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    mock("platform_bus").expectOneCall("do_xfer");
+
+    rc = test_bus->xfer(handler);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    mock().checkExpectations();
+
+    // Continuation must be started with new buffers
+    mock("handler").expectOneCall("complete");
+    mock("platform_bus").expectOneCall("reset_buffers");
+    mock("platform_bus")
+            .expectOneCall("set_tx")
+            .withConstPointerParameter("tx_buf", tx_buf)
+            .withParameter("size", buf_size);
+    mock("platform_bus")
+            .expectOneCall("set_rx")
+            .withParameter("rx_buf", static_cast< uint8_t * >(nullptr))
+            .withParameter("size", buf_size);
+    mock("platform_bus").expectOneCall("do_xfer");
+
+    platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, buf_size);
+
+    mock().checkExpectations();
+
+    // Continuation completes, nothing else requested
+    mock("handler").expectOneCall("complete");
+
+    platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, buf_size);
+
+    mock().checkExpectations();
+}
+
+TEST(bus_is_ready, stream)
+{
+    uint8_t rx_buf2[buf_size];
+
+    auto handler = [&](ecl::bus_channel ch, ecl::bus_event e, size_t total) {
+        (void) total;
+        if (ch == ecl::bus_channel::rx && e == ecl::bus_event::ht) {
+            mock("handler").actualCall("first_half");
+        } else if (ch == ecl::bus_channel::rx && e == ecl::bus_event::tc) {
+            mock("handler").actualCall("second_half");
+        } else if (ch == ecl::bus_channel::meta && e == ecl::bus_event::tc) {
+            mock("handler").actualCall("stopped");
+        }
+    };
+
+    mock("platform_bus").expectOneCall("reset_buffers");
+    mock("platform_bus")
+            .expectOneCall("set_double_buffers")
+            .withConstPointerParameter("tx0", nullptr)
+            .withConstPointerParameter("tx1", nullptr)
+            .withParameter("rx0", rx_buf)
+            .withParameter("rx1", rx_buf2)
+            .withParameter("size", buf_size);
+
+    auto rc = test_bus->set_double_buffers(nullptr, nullptr, rx_buf, rx_buf2, buf_size);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    mock("platform_bus").expectOneCall("do_stream");
+
+    rc = test_bus->stream(handler);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    mock().checkExpectations();
+
+    // Streaming lasts, until explicitly stopped
+    mock("handler").expectNCalls(2, "first_half");
+    mock("handler").expectNCalls(2, "second_half");
+
+    for (int i = 0; i < 2; ++i) {
+        platform_mock::invoke(ecl::bus_channel::rx, ecl::bus_event::ht, buf_size);
+        platform_mock::invoke(ecl::bus_channel::rx, ecl::bus_event::tc, buf_size);
+    }
+
+    mock().checkExpectations();
+
+    mock("platform_bus").expectOneCall("stop_stream");
+    mock("handler").expectOneCall("stopped");
+
+    rc = test_bus->stop();
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    // Final event of the streaming
+    platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, 0);
+
+    mock().checkExpectations();
+
+    // Nothing to stop now
+    rc = test_bus->stop();
+    CHECK_EQUAL(ecl::err::perm, rc);
+}
+
+TEST(bus_is_ready, async_xfer_error_recovers_bus)
+{
+    auto handler = [](ecl::bus_channel ch, ecl::bus_event e, size_t total) {
+        (void) ch;
+        (void) e;
+        (void) total;
+    };
+
+    mock("platform_bus").expectOneCall("do_xfer");
+
+    auto rc = test_bus->xfer(handler);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    platform_mock::invoke(ecl::bus_channel::rx, ecl::bus_event::err, 0);
+    platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, 0);
+
+    mock().checkExpectations();
+    CHECK_EQUAL(1, test_bus->stats().errors);
+
+    // Async xfer is cleaned up on unlock, so next one is in a new session
+    auto next_session = [this] {
+        mock().disable();
+        test_bus->unlock();
+        test_bus->lock();
+        mock().enable();
+    };
+
+    next_session();
+
+    // Platform bus is recovered before the next xfer, only once
+    mock("platform_bus").expectOneCall("recover");
+    mock("platform_bus").expectOneCall("do_xfer");
+
+    rc = test_bus->xfer(handler);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, 0);
+
+    next_session();
+
+    mock("platform_bus").expectOneCall("do_xfer");
+
+    rc = test_bus->xfer(handler);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, 0);
+
+    mock().checkExpectations();
+    CHECK_EQUAL(1, test_bus->stats().resets);
+}
+
+TEST(bus_is_ready, xfer_retry)
+{
+    static unsigned backoffs;
+    int failures = 1;
+
+    backoffs = 0;
+
+    // First attempt fails, the second one succeeds
+    platform_mock::set_xfer_hook([&failures] {
+        if (failures-- > 0) {
+            platform_mock::invoke(ecl::bus_channel::tx, ecl::bus_event::err, 0);
+        }
+        platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, 0);
+    });
+
+    bus_t::set_retry_policy({2, [](unsigned retry) { backoffs += retry; }});
+
+    mock("platform_bus").expectNCalls(2, "do_xfer");
+    mock("platform_bus").expectOneCall("recover");
+
+    auto rc = test_bus->xfer();
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    mock().checkExpectations();
+
+    auto stats = test_bus->stats();
+    CHECK_EQUAL(1, backoffs);
+    CHECK_EQUAL(1, stats.errors);
+    CHECK_EQUAL(1, stats.resets);
+    CHECK_EQUAL(1, stats.retries);
+    CHECK_EQUAL(1, stats.recovered);
+    CHECK_EQUAL(0, stats.failed);
+}
+
+TEST(bus_is_ready, xfer_retries_exhausted)
+{
+    platform_mock::set_xfer_hook([] {
+        platform_mock::invoke(ecl::bus_channel::tx, ecl::bus_event::err, 0);
+        platform_mock::invoke(ecl::bus_channel::meta, ecl::bus_event::tc, 0);
+    });
+
+    bus_t::set_retry_policy({2, nullptr});
+
+    mock("platform_bus").expectNCalls(3, "do_xfer");
+    mock("platform_bus").expectNCalls(2, "recover");
+
+    auto rc = test_bus->xfer();
+    CHECK_EQUAL(ecl::err::io, rc);
+
+    mock().checkExpectations();
+
+    auto stats = test_bus->stats();
+    CHECK_EQUAL(3, stats.errors);
+    CHECK_EQUAL(2, stats.retries);
+    CHECK_EQUAL(0, stats.recovered);
+    CHECK_EQUAL(1, stats.failed);
+}
 
 int main(int argc, char *argv[])
 {
@@ -0,0 +1,114 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include "dev/byte_ring.hpp"
+
+using ring_t = ecl::byte_ring< 8 >;
+
+TEST_GROUP(byte_ring)
+{
+    ring_t *test_ring;
+
+    void setup()
+    {
+        test_ring = new ring_t;
+    }
+
+    void teardown()
+    {
+        delete test_ring;
+    }
+};
+
+TEST(byte_ring, empty)
+{
+    uint8_t buf[4];
+
+    CHECK_TRUE(test_ring->empty());
+    CHECK_EQUAL(0, test_ring->size());
+    CHECK_EQUAL(8, test_ring->free());
+    CHECK_EQUAL(0, test_ring->read(buf, sizeof(buf)));
+}
+
+TEST(byte_ring, write_read)
+{
+    const uint8_t data[] = { 1, 2, 3, 4, 5 };
+    uint8_t buf[sizeof(data)] = {};
+
+    CHECK_EQUAL(sizeof(data), test_ring->write(data, sizeof(data)));
+    CHECK_EQUAL(sizeof(data), test_ring->size());
+
+    CHECK_EQUAL(sizeof(data), test_ring->read(buf, sizeof(buf)));
+    MEMCMP_EQUAL(data, buf, sizeof(data));
+    CHECK_TRUE(test_ring->empty());
+}
+
+TEST(byte_ring, overflow)
+{
+    const uint8_t data[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    uint8_t buf[sizeof(data)] = {};
+
+    // Only capacity worth of bytes must be accepted
+    CHECK_EQUAL(8, test_ring->write(data, sizeof(data)));
+    CHECK_EQUAL(0, test_ring->free());
+    CHECK_EQUAL(0, test_ring->write(data, sizeof(data)));
+
+    CHECK_EQUAL(8, test_ring->read(buf, sizeof(buf)));
+    MEMCMP_EQUAL(data, buf, 8);
+}
+
+TEST(byte_ring, wrap_around)
+{
+    const uint8_t data[] = { 1, 2, 3, 4, 5, 6 };
+    uint8_t buf[sizeof(data)] = {};
+
+    // Move counters close to the end of the storage
+    test_ring->write(data, 5);
+    test_ring->read(buf, 5);
+
+    CHECK_EQUAL(sizeof(data), test_ring->write(data, sizeof(data)));
+    CHECK_EQUAL(sizeof(data), test_ring->read(buf, sizeof(buf)));
+    MEMCMP_EQUAL(data, buf, sizeof(data));
+}
+
+TEST(byte_ring, spans)
+{
+    const uint8_t data[] = { 1, 2, 3, 4, 5, 6 };
+    uint8_t buf[sizeof(data)] = {};
+    size_t len;
+
+    test_ring->write(data, 5);
+    test_ring->read(buf, 5);
+
+    // Free space wraps around, span must be limited by the end of storage
+    auto wspan = test_ring->write_span(len);
+    CHECK_EQUAL(3, len);
+
+    wspan[0] = 0xaa;
+    test_ring->commit(1);
+
+    auto rspan = test_ring->read_span(len);
+    CHECK_EQUAL(1, len);
+    CHECK_EQUAL(0xaa, rspan[0]);
+    POINTERS_EQUAL(wspan, rspan);
+
+    test_ring->consume(1);
+    CHECK_TRUE(test_ring->empty());
+
+    // Two spans at the end and at the start of the storage
+    test_ring->write(data, sizeof(data));
+
+    rspan = test_ring->read_span(len);
+    CHECK_EQUAL(2, len);
+    MEMCMP_EQUAL(data, rspan, 2);
+    test_ring->consume(len);
+
+    rspan = test_ring->read_span(len);
+    CHECK_EQUAL(4, len);
+    MEMCMP_EQUAL(data + 2, rspan, 4);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
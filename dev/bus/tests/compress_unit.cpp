@@ -0,0 +1,215 @@
+#include <iowrap/compress.hpp>
+
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Loopback device: bytes written are read back
+struct memory_dev
+{
+    ssize_t write(const uint8_t *data, size_t count)
+    {
+        bytes.insert(bytes.end(), data, data + count);
+        return count;
+    }
+
+    ssize_t read(uint8_t *buffer, size_t count)
+    {
+        if (fail) {
+            return -1;
+        }
+
+        count = std::min(count, bytes.size());
+        std::copy(bytes.begin(), bytes.begin() + count, buffer);
+        bytes.erase(bytes.begin(), bytes.begin() + count);
+        return count;
+    }
+
+    std::deque< uint8_t > bytes;
+    bool fail = false;
+};
+
+// Resembles a text log: repeated words, varying numbers
+std::vector< uint8_t > log_text(size_t lines)
+{
+    const char *words[] = { "sensor ", "temp=", "state ", "ok ", "error ", "retry " };
+    std::string text;
+
+    for (size_t i = 0; i < lines; ++i) {
+        text += std::to_string(i * 37) + ": ";
+        for (int j = 0; j < 4; ++j) {
+            text += words[rand() % 6];
+        }
+        text += std::to_string(rand() % 100) + "\n";
+    }
+
+    return {text.begin(), text.end()};
+}
+
+std::vector< uint8_t > random_bytes(size_t size)
+{
+    std::vector< uint8_t > out(size);
+    for (auto &b : out) {
+        b = rand();
+    }
+
+    return out;
+}
+
+template< class Dev >
+std::vector< uint8_t > read_all(Dev &dev, size_t chunk)
+{
+    std::vector< uint8_t > in;
+    std::vector< uint8_t > buf(chunk);
+    ssize_t rc;
+
+    while ((rc = dev.read(buf.data(), chunk)) > 0) {
+        in.insert(in.end(), buf.begin(), buf.begin() + rc);
+    }
+
+    return in;
+}
+
+template< class Codec >
+void round_trip(const std::vector< uint8_t > &data, size_t chunk)
+{
+    Codec dev;
+
+    for (size_t i = 0; i < data.size(); i += chunk) {
+        ssize_t n = std::min(chunk, data.size() - i);
+        CHECK_EQUAL(n, dev.write(data.data() + i, n));
+    }
+
+    CHECK_EQUAL(ecl::err::ok, dev.flush());
+    CHECK_TRUE(data == read_all(dev, chunk));
+}
+
+static_assert(ecl::is_iowrapper< ecl::compress< memory_dev > >::value, "");
+static_assert(ecl::is_iodev< ecl::iodev_ptr< std::shared_ptr< memory_dev > > >::value, "");
+
+} // namespace
+
+TEST_GROUP(compress)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(compress, round_trip)
+{
+    auto text = log_text(300);
+    auto noise = random_bytes(3000);
+    std::vector< uint8_t > runs(2000, 0x55);
+
+    for (size_t chunk : { 1, 7, 100, 5000 }) {
+        round_trip< ecl::compress< memory_dev > >(text, chunk);
+        round_trip< ecl::compress< memory_dev > >(noise, chunk);
+        round_trip< ecl::compress< memory_dev > >(runs, chunk);
+    }
+
+    round_trip< ecl::compress< memory_dev, 4, 2 > >(text, 13);
+    round_trip< ecl::compress< memory_dev, 12, 8 > >(text, 13);
+    round_trip< ecl::compress< memory_dev, 10, 4 > >(noise, 13);
+}
+
+TEST(compress, ratio)
+{
+    ecl::compress< memory_dev > dev;
+    auto text = log_text(300);
+    std::vector< uint8_t > runs(1000, 0);
+
+    dev.write(text.data(), text.size());
+    dev.flush();
+    CHECK_TRUE(dev.device().bytes.size() < text.size() / 2);
+
+    dev.device().bytes.clear();
+    dev.write(runs.data(), runs.size());
+    dev.flush();
+    CHECK_TRUE(dev.device().bytes.size() < runs.size() / 8);
+
+    // Incompressible data grows by an eighth at most
+    auto noise = random_bytes(1000);
+    dev.device().bytes.clear();
+    dev.write(noise.data(), noise.size());
+    dev.flush();
+    CHECK_TRUE(dev.device().bytes.size() <= 1000 * 9 / 8 + 3);
+}
+
+TEST(compress, sequence_of_streams)
+{
+    ecl::compress< memory_dev > dev;
+    auto first = log_text(10);
+    auto second = log_text(20);
+
+    // Empty flush produces nothing
+    CHECK_EQUAL(ecl::err::ok, dev.flush());
+    CHECK_TRUE(dev.device().bytes.empty());
+
+    dev.write(first.data(), first.size());
+    dev.flush();
+    dev.write(second.data(), second.size());
+    dev.flush();
+
+    auto in = read_all(dev, 64);
+    first.insert(first.end(), second.begin(), second.end());
+    CHECK_TRUE(first == in);
+}
+
+TEST(compress, partial_input)
+{
+    ecl::compress< memory_dev > enc;
+    ecl::compress< memory_dev > dec;
+    auto text = log_text(50);
+
+    enc.write(text.data(), text.size());
+    enc.flush();
+
+    // Decoder gets encoded stream in pieces, tokens are split between them
+    std::vector< uint8_t > in;
+    uint8_t buf[16];
+    ssize_t rc;
+
+    for (auto byte : enc.device().bytes) {
+        dec.device().bytes.push_back(byte);
+        while ((rc = dec.read(buf, sizeof(buf))) > 0) {
+            in.insert(in.end(), buf, buf + rc);
+        }
+        CHECK_EQUAL(0, rc);
+    }
+
+    CHECK_TRUE(text == in);
+
+    dec.device().fail = true;
+    CHECK_EQUAL(-1, dec.read(buf, sizeof(buf)));
+}
+
+TEST(compress, device_pointer)
+{
+    auto mem = std::make_shared< memory_dev >();
+    ecl::compress< ecl::iodev_ptr< std::shared_ptr< memory_dev > > > dev{mem};
+    auto text = log_text(20);
+
+    dev.write(text.data(), text.size());
+    dev.flush();
+
+    CHECK_FALSE(mem->bytes.empty());
+    CHECK_TRUE(text == read_all(dev, 32));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,361 @@
+#include <iowrap/iowrap.hpp>
+
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Loopback device: bytes written are read back
+struct memory_dev
+{
+    ssize_t write(const uint8_t *data, size_t count)
+    {
+        if (fail) {
+            return -1;
+        }
+
+        count = std::min(count, chunk);
+        bytes.insert(bytes.end(), data, data + count);
+        ++writes;
+        return count;
+    }
+
+    ssize_t read(uint8_t *buffer, size_t count)
+    {
+        count = std::min(count, bytes.size());
+        std::copy(bytes.begin(), bytes.begin() + count, buffer);
+        bytes.erase(bytes.begin(), bytes.begin() + count);
+        ++reads;
+        return count;
+    }
+
+    std::deque< uint8_t > bytes;
+    size_t chunk = SIZE_MAX;    // Longest transfer accepted at once
+    bool fail = false;
+    int writes = 0;
+    int reads = 0;
+};
+
+// Counts calls of optional members
+struct managed_dev : memory_dev
+{
+    ecl::err init() { ++inits; return ecl::err::ok; }
+    ecl::err flush() { ++flushes; return ecl::err::ok; }
+
+    int inits = 0;
+    int flushes = 0;
+};
+
+struct write_only_dev
+{
+    ssize_t write(const uint8_t *, size_t count) { return count; }
+};
+
+struct not_a_dev
+{
+    int write(int);
+};
+
+std::vector< uint8_t > drain(memory_dev &dev)
+{
+    std::vector< uint8_t > out{dev.bytes.begin(), dev.bytes.end()};
+    dev.bytes.clear();
+    return out;
+}
+
+std::vector< uint8_t > random_bytes(size_t size, int range)
+{
+    std::vector< uint8_t > out(size);
+    for (auto &b : out) {
+        b = rand() % range;
+    }
+
+    return out;
+}
+
+static_assert(ecl::is_iodev< memory_dev >::value, "");
+static_assert(ecl::is_iodev< write_only_dev >::value, "");
+static_assert(ecl::is_writable< write_only_dev >::value, "");
+static_assert(!ecl::is_readable< write_only_dev >::value, "");
+static_assert(!ecl::is_iodev< not_a_dev >::value, "");
+static_assert(!ecl::is_iodev< int >::value, "");
+
+static_assert(!ecl::is_iowrapper< memory_dev >::value, "");
+static_assert(ecl::is_iowrapper< ecl::crc< memory_dev > >::value, "");
+static_assert(ecl::is_iowrapper< ecl::buffered< ecl::framed< memory_dev > > >::value, "");
+static_assert(ecl::is_iowrapper< ecl::tee< memory_dev, write_only_dev > >::value, "");
+
+// Wrappers add nothing but their own state
+static_assert(sizeof(ecl::crc< memory_dev >) == sizeof(memory_dev) + alignof(memory_dev), "");
+static_assert(sizeof(ecl::framed< memory_dev >) == sizeof(memory_dev), "");
+
+} // namespace
+
+TEST_GROUP(iowrap)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(iowrap, optional_members_are_forwarded)
+{
+    ecl::buffered< ecl::crc< managed_dev > > dev;
+
+    CHECK_EQUAL(ecl::err::ok, dev.init());
+    CHECK_EQUAL(ecl::err::ok, dev.flush());
+    CHECK_EQUAL(1, dev.device().device().inits);
+    CHECK_EQUAL(1, dev.device().device().flushes);
+
+    // Devices without them are fine as well
+    ecl::buffered< memory_dev > plain;
+    CHECK_EQUAL(ecl::err::ok, plain.init());
+    CHECK_EQUAL(ecl::err::ok, plain.flush());
+}
+
+TEST(iowrap, buffered_write)
+{
+    ecl::buffered< memory_dev, 8 > dev;
+    uint8_t data[20];
+
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = i;
+    }
+
+    CHECK_EQUAL(3, dev.write(data, 3));
+    CHECK_EQUAL(2, dev.write(data + 3, 2));
+    CHECK_EQUAL(0, dev.device().writes);
+    CHECK_EQUAL(5, dev.pending());
+
+    // Filling the buffer sends it
+    CHECK_EQUAL(5, dev.write(data + 5, 5));
+    CHECK_EQUAL(1, dev.device().writes);
+    CHECK_EQUAL(2, dev.pending());
+
+    CHECK_EQUAL(ecl::err::ok, dev.flush());
+    CHECK_EQUAL(0, dev.pending());
+
+    // Large write bypasses empty buffer, partial writes are retried
+    dev.device().chunk = 7;
+    CHECK_EQUAL(10, dev.write(data + 10, 10));
+    CHECK_EQUAL(ecl::err::ok, dev.flush());
+
+    auto out = drain(dev.device());
+    CHECK_EQUAL(sizeof(data), out.size());
+    MEMCMP_EQUAL(data, out.data(), sizeof(data));
+}
+
+TEST(iowrap, buffered_write_error)
+{
+    ecl::buffered< memory_dev, 8 > dev;
+    uint8_t data[8] = {};
+
+    dev.device().fail = true;
+
+    CHECK_EQUAL(4, dev.write(data, 4));
+    CHECK_EQUAL(ecl::err::io, dev.flush());
+    CHECK_EQUAL(-1, dev.write(data, 8));
+}
+
+TEST(iowrap, buffered_read)
+{
+    ecl::buffered< memory_dev, 8 > dev;
+    auto data = random_bytes(30, 256);
+    std::vector< uint8_t > in;
+    uint8_t buf[16];
+
+    dev.device().bytes.assign(data.begin(), data.end());
+
+    // Small reads are served from the buffer
+    for (int i = 0; i < 8; ++i) {
+        CHECK_EQUAL(1, dev.read(buf, 1));
+        in.push_back(buf[0]);
+    }
+
+    CHECK_EQUAL(1, dev.device().reads);
+
+    ssize_t rc;
+    while ((rc = dev.read(buf, sizeof(buf))) > 0) {
+        in.insert(in.end(), buf, buf + rc);
+    }
+
+    CHECK_TRUE(data == in);
+}
+
+TEST(iowrap, crc)
+{
+    ecl::crc< memory_dev > dev;
+    auto data = random_bytes(100, 256);
+    uint8_t buf[100];
+
+    CHECK_EQUAL(60, dev.write(data.data(), 60));
+    CHECK_EQUAL(40, dev.write(data.data() + 60, 40));
+    CHECK_EQUAL(ecl::crc16(data.data(), data.size()), dev.tx_crc());
+    CHECK_EQUAL(0, dev.rx_crc());
+
+    CHECK_EQUAL(100, dev.read(buf, sizeof(buf)));
+    CHECK_EQUAL(dev.tx_crc(), dev.rx_crc());
+
+    dev.reset_crc();
+    CHECK_EQUAL(0, dev.tx_crc());
+}
+
+TEST(iowrap, framed_encoding)
+{
+    ecl::framed< memory_dev > dev;
+    const uint8_t data[] = { 1, 0xc0, 2, 0xdb, 3 };
+    const uint8_t encoded[] = { 1, 0xdb, 0xdc, 2, 0xdb, 0xdd, 3, 0xc0 };
+
+    CHECK_EQUAL(sizeof(data), dev.write(data, sizeof(data)));
+
+    auto out = drain(dev.device());
+    CHECK_EQUAL(sizeof(encoded), out.size());
+    MEMCMP_EQUAL(encoded, out.data(), sizeof(encoded));
+}
+
+TEST(iowrap, framed_frames)
+{
+    ecl::framed< memory_dev > dev;
+    uint8_t buf[300];
+
+    auto first = random_bytes(200, 256);
+    auto second = random_bytes(100, 256);
+
+    dev.write(first.data(), first.size());
+    dev.device().bytes.push_back(0xc0);
+    dev.write(second.data(), second.size());
+
+    CHECK_EQUAL(200, dev.read(buf, sizeof(buf)));
+    MEMCMP_EQUAL(first.data(), buf, first.size());
+
+    // Empty frame is skipped
+    CHECK_EQUAL(100, dev.read(buf, sizeof(buf)));
+    MEMCMP_EQUAL(second.data(), buf, second.size());
+
+    // Device has no more bytes
+    CHECK_EQUAL(-1, dev.read(buf, sizeof(buf)));
+}
+
+TEST(iowrap, framed_overflow)
+{
+    ecl::framed< memory_dev > dev;
+    const uint8_t data[] = { 1, 2, 3, 4, 5 };
+    uint8_t buf[4];
+
+    dev.write(data, sizeof(data));
+    dev.write(data, 2);
+
+    CHECK_EQUAL(-1, dev.read(buf, sizeof(buf)));
+    CHECK_EQUAL(2, dev.read(buf, sizeof(buf)));
+}
+
+TEST(iowrap, packbits_encoding)
+{
+    // Example from Apple Technical Note TN1023
+    const uint8_t data[] = {
+        0xaa, 0xaa, 0xaa, 0x80, 0x00, 0x2a, 0xaa, 0xaa, 0xaa, 0xaa,
+        0x80, 0x00, 0x2a, 0x22, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+        0xaa, 0xaa, 0xaa, 0xaa,
+    };
+    const uint8_t encoded[] = {
+        0xfe, 0xaa, 0x02, 0x80, 0x00, 0x2a, 0xfd, 0xaa, 0x03, 0x80,
+        0x00, 0x2a, 0x22, 0xf7, 0xaa,
+    };
+
+    ecl::packbits< memory_dev > dev;
+
+    CHECK_EQUAL(sizeof(data), dev.write(data, sizeof(data)));
+    CHECK_EQUAL(ecl::err::ok, dev.flush());
+
+    auto out = drain(dev.device());
+    CHECK_EQUAL(sizeof(encoded), out.size());
+    MEMCMP_EQUAL(encoded, out.data(), sizeof(encoded));
+}
+
+TEST(iowrap, packbits_round_trip)
+{
+    ecl::packbits< memory_dev > dev;
+
+    // Few distinct values give both runs and literals, some longer than 128
+    auto data = random_bytes(5000, 3);
+    data.insert(data.end(), 300, 7);
+    auto noise = random_bytes(500, 256);
+    data.insert(data.end(), noise.begin(), noise.end());
+
+    for (size_t i = 0; i < data.size(); i += 37) {
+        ssize_t n = std::min< size_t >(37, data.size() - i);
+        CHECK_EQUAL(n, dev.write(data.data() + i, n));
+    }
+
+    CHECK_EQUAL(ecl::err::ok, dev.flush());
+    CHECK_TRUE(dev.device().bytes.size() < data.size());
+
+    std::vector< uint8_t > in;
+    uint8_t buf[50];
+    ssize_t rc;
+
+    while ((rc = dev.read(buf, sizeof(buf))) > 0) {
+        in.insert(in.end(), buf, buf + rc);
+    }
+
+    CHECK_TRUE(data == in);
+}
+
+TEST(iowrap, tee)
+{
+    ecl::tee< memory_dev, memory_dev > dev;
+    const uint8_t data[] = { 1, 2, 3 };
+    uint8_t buf[3];
+
+    CHECK_EQUAL(3, dev.write(data, sizeof(data)));
+    CHECK_EQUAL(3, dev.read(buf, sizeof(buf)));
+
+    auto copy = drain(dev.sink());
+    CHECK_EQUAL(6, copy.size());
+    MEMCMP_EQUAL(data, copy.data(), 3);
+    MEMCMP_EQUAL(data, copy.data() + 3, 3);
+
+    // Sink failure doesn't affect the device
+    dev.sink().fail = true;
+    CHECK_EQUAL(3, dev.write(data, sizeof(data)));
+}
+
+TEST(iowrap, pipeline)
+{
+    // Frames are compressed, checksummed and sent in large writes
+    ecl::framed< ecl::packbits< ecl::crc< ecl::buffered< memory_dev, 32 > > > > dev;
+    auto &crc_dev = dev.device().device();
+    auto &mem = crc_dev.device().device();
+
+    auto first = random_bytes(400, 4);
+    auto second = random_bytes(100, 256);
+
+    CHECK_EQUAL(400, dev.write(first.data(), first.size()));
+    CHECK_EQUAL(100, dev.write(second.data(), second.size()));
+    CHECK_EQUAL(ecl::err::ok, dev.flush());
+
+    CHECK_TRUE(mem.writes < 50);
+
+    uint8_t buf[500];
+
+    CHECK_EQUAL(400, dev.read(buf, sizeof(buf)));
+    MEMCMP_EQUAL(first.data(), buf, first.size());
+    CHECK_EQUAL(100, dev.read(buf, sizeof(buf)));
+    MEMCMP_EQUAL(second.data(), buf, second.size());
+
+    CHECK_EQUAL(crc_dev.tx_crc(), crc_dev.rx_crc());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,13 @@
+#ifndef MOCK_ECL_THREAD_COMPLETION_
+#define MOCK_ECL_THREAD_COMPLETION_
+
+#include <ecl/thread/common/semaphore.hpp>
+
+namespace ecl
+{
+
+using completion = ecl::common::semaphore;
+
+}
+
+#endif // MOCK_ECL_THREAD_COMPLETION_
@@ -0,0 +1,23 @@
+#ifndef BUS_MOCKS_SLEEP_LOCK_HPP_
+#define BUS_MOCKS_SLEEP_LOCK_HPP_
+
+namespace ecl
+{
+
+// Tracks balance of sleep locks, rather than recording calls.
+// Tests check that no lock is leaked after xfer is complete.
+struct sleep_lock
+{
+    static void acquire() { ++held(); }
+    static void release() { --held(); }
+
+    static int &held()
+    {
+        static int locks = 0;
+        return locks;
+    }
+};
+
+}
+
+#endif // BUS_MOCKS_SLEEP_LOCK_HPP_
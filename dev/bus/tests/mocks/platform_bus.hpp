@@ -72,6 +72,64 @@ public:
     ecl::err do_xfer()
     {
         mock("platform_bus").actualCall("do_xfer");
+
+        // Bus may deliver events right from here, as polling bus does
+        if (m_xfer_hook) {
+            m_xfer_hook();
+        }
+
+        return static_cast< ecl::err >
+                (mock("platform_bus").returnIntValueOrDefault(0));
+    }
+
+    void set_double_buffers(const uint8_t *tx0, const uint8_t *tx1,
+                            uint8_t *rx0, uint8_t *rx1, size_t size)
+    {
+        mock("platform_bus")
+                .actualCall("set_double_buffers")
+                .withParameter("tx0", tx0)
+                .withParameter("tx1", tx1)
+                .withParameter("rx0", rx0)
+                .withParameter("rx1", rx1)
+                .withParameter("size", size);
+    }
+
+    ecl::err do_stream()
+    {
+        mock("platform_bus").actualCall("do_stream");
+        return static_cast< ecl::err >
+                (mock("platform_bus").returnIntValueOrDefault(0));
+    }
+
+    ecl::err stop_stream()
+    {
+        mock("platform_bus").actualCall("stop_stream");
+        return static_cast< ecl::err >
+                (mock("platform_bus").returnIntValueOrDefault(0));
+    }
+
+    ecl::err set_clock(uint32_t clk)
+    {
+        mock("platform_bus")
+                .actualCall("set_clock")
+                .withParameter("clk", clk);
+        return static_cast< ecl::err >
+                (mock("platform_bus").returnIntValueOrDefault(0));
+    }
+
+    ecl::err set_mode(uint16_t cpol, uint16_t cpha)
+    {
+        mock("platform_bus")
+                .actualCall("set_mode")
+                .withParameter("cpol", cpol)
+                .withParameter("cpha", cpha);
+        return static_cast< ecl::err >
+                (mock("platform_bus").returnIntValueOrDefault(0));
+    }
+
+    ecl::err recover()
+    {
+        mock("platform_bus").actualCall("recover");
         return static_cast< ecl::err >
                 (mock("platform_bus").returnIntValueOrDefault(0));
     }
@@ -84,11 +142,18 @@ public:
         m_handler(ch, e, total);
     }
 
+    static void set_xfer_hook(const std::function< void() > &hook)
+    {
+        m_xfer_hook = hook;
+    }
+
 private:
     static handler_fn m_handler;
+    static std::function< void() > m_xfer_hook;
 };
 
 // TODO: move it to cpp file to avoid link errors in future
 platform_mock::handler_fn platform_mock::m_handler = platform_mock::handler_fn{};
+std::function< void() > platform_mock::m_xfer_hook = std::function< void() >{};
 
 #endif
@@ -0,0 +1,255 @@
+// Decodes bus trace log, see dev/bus_trace.hpp.
+//
+// Input is a binary dump of ecl_bus_trace, or of any memory region that
+// contains it. Events are printed in order, followed by a summary per bus:
+// how long clients waited for the lock and held it, how long the bus was
+// busy transferring data, and which code held it the most. Owners are
+// addresses of the code that called lock(), use addr2line to resolve them.
+//
+//   bus_trace_decode [-s] dump.bin
+//
+// With -s only the summary is printed.
+
+#include <dev/bus_trace.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace
+{
+
+using namespace ecl;
+
+struct owner_stats
+{
+    unsigned    locks = 0;
+    double      hold = 0;
+    double      max_hold = 0;
+};
+
+struct bus_stats
+{
+    uint32_t    addr = 0;
+    unsigned    locks = 0;
+    double      wait = 0;
+    double      max_wait = 0;
+    unsigned    xfers = 0;
+    unsigned    failed = 0;
+    uint64_t    bytes = 0;
+    double      busy = 0;
+    double      max_xfer = 0;
+    unsigned    errors = 0;
+
+    std::map< uint32_t, owner_stats > owners;
+};
+
+const char *event_name(uint8_t ev)
+{
+    static const char *names[] = { "init", "lock", "unlock", "xfer", "done", "error" };
+    return ev < sizeof(names) / sizeof(names[0]) ? names[ev] : "?";
+}
+
+const char *channel_name(uint32_t ch)
+{
+    static const char *names[] = { "rx", "tx", "meta" };
+    return ch < sizeof(names) / sizeof(names[0]) ? names[ch] : "?";
+}
+
+// Finds the log in a dump, nullptr if there is none
+const uint8_t *find_log(const std::vector< uint8_t > &dump, bus_trace_header &hdr)
+{
+    for (size_t offt = 0; offt + sizeof(hdr) <= dump.size(); offt += 4) {
+        memcpy(&hdr, dump.data() + offt, sizeof(hdr));
+
+        if (hdr.magic != bus_trace_magic || hdr.version != bus_trace_version) {
+            continue;
+        }
+
+        if (!hdr.capacity || (hdr.capacity & (hdr.capacity - 1))) {
+            continue;
+        }
+
+        size_t size = sizeof(hdr) + hdr.capacity * sizeof(bus_trace_record);
+        if (offt + size <= dump.size()) {
+            return dump.data() + offt + sizeof(hdr);
+        }
+    }
+
+    return nullptr;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    bool summary_only = argc > 2 && !strcmp(argv[1], "-s");
+
+    if (argc < 2 || (argc > 2 && !summary_only)) {
+        fprintf(stderr, "Usage: %s [-s] dump.bin\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream in{argv[argc - 1], std::ios::binary};
+    if (!in) {
+        fprintf(stderr, "Can't open %s\n", argv[argc - 1]);
+        return 1;
+    }
+
+    std::vector< uint8_t > dump{std::istreambuf_iterator< char >{in},
+                                std::istreambuf_iterator< char >{}};
+
+    bus_trace_header hdr;
+    auto data = find_log(dump, hdr);
+    if (!data) {
+        fprintf(stderr, "No trace log found\n");
+        return 1;
+    }
+
+    // Only last capacity records survive
+    uint32_t first = hdr.head > hdr.capacity ? hdr.head - hdr.capacity : 0;
+    std::vector< bus_trace_record > records;
+    unsigned dropped = 0;
+
+    for (uint32_t seq = first; seq != hdr.head; ++seq) {
+        bus_trace_record r;
+        memcpy(&r, data + (seq & (hdr.capacity - 1)) * sizeof(r), sizeof(r));
+
+        // Record was being written when the dump was taken
+        if (r.seq != seq) {
+            ++dropped;
+            continue;
+        }
+
+        records.push_back(r);
+    }
+
+    printf("%u records, %u lost to overwrite, %u incomplete, clock %u Hz\n",
+           static_cast< unsigned >(records.size()), first, dropped, hdr.clock_hz);
+
+    if (records.empty() || !hdr.clock_hz) {
+        return 0;
+    }
+
+    double us_per_tick = 1e6 / hdr.clock_hz;
+    auto us = [us_per_tick](uint32_t ticks) { return ticks * us_per_tick; };
+
+    std::map< uint8_t, bus_stats > buses;
+
+    // Timestamps are unwrapped by accumulating differences. Difference can be
+    // negative, if a record was preempted between reservation and timestamp.
+    double now = 0;
+    uint32_t prev = records.front().time;
+
+    if (!summary_only) {
+        printf("%12s %4s  %-7s\n", "time, us", "bus", "event");
+    }
+
+    for (auto &r : records) {
+        now += static_cast< int32_t >(r.time - prev) * us_per_tick;
+        prev = r.time;
+
+        auto &b = buses[r.bus];
+        auto ev = static_cast< bus_trace_event >(r.event);
+
+        switch (ev) {
+        case bus_trace_event::init:
+            b.addr = r.arg0;
+            break;
+        case bus_trace_event::lock:
+            b.locks++;
+            b.wait += us(r.arg0);
+            b.max_wait = std::max(b.max_wait, us(r.arg0));
+            break;
+        case bus_trace_event::unlock: {
+            auto &o = b.owners[r.arg1];
+            o.locks++;
+            o.hold += us(r.arg0);
+            o.max_hold = std::max(o.max_hold, us(r.arg0));
+            break;
+        }
+        case bus_trace_event::xfer:
+            break;
+        case bus_trace_event::done:
+            b.xfers++;
+            b.bytes += r.arg1;
+            b.busy += us(r.arg0);
+            b.max_xfer = std::max(b.max_xfer, us(r.arg0));
+            if (r.flags & bus_trace_flags::failed) {
+                b.failed++;
+            }
+            break;
+        case bus_trace_event::error:
+            b.errors++;
+            break;
+        }
+
+        if (summary_only) {
+            continue;
+        }
+
+        printf("%12.3f %4u  %-7s ", now, r.bus, event_name(r.event));
+
+        switch (ev) {
+        case bus_trace_event::init:
+            printf("platform bus at 0x%08x", r.arg0);
+            break;
+        case bus_trace_event::lock:
+            printf("waited %.3f us, owner 0x%08x", us(r.arg0), r.arg1);
+            break;
+        case bus_trace_event::unlock:
+            printf("held %.3f us, owner 0x%08x", us(r.arg0), r.arg1);
+            break;
+        case bus_trace_event::xfer:
+            printf("%u bytes, %u segment(s)%s%s%s%s", r.arg0, r.arg1,
+                   (r.flags & bus_trace_flags::async) ? ", async" : "",
+                   (r.flags & bus_trace_flags::stream) ? ", stream" : "",
+                   (r.flags & bus_trace_flags::chain) ? ", chain" : "",
+                   (r.flags & bus_trace_flags::next) ? ", continuation" : "");
+            break;
+        case bus_trace_event::done:
+            printf("%.3f us, %u bytes%s", us(r.arg0), r.arg1,
+                   (r.flags & bus_trace_flags::failed) ? ", failed" : "");
+            break;
+        case bus_trace_event::error:
+            printf("channel %s, %u bytes", channel_name(r.arg0), r.arg1);
+            break;
+        }
+
+        printf("\n");
+    }
+
+    printf("\nSummary over %.3f us:\n", now);
+
+    for (auto &it : buses) {
+        auto &b = it.second;
+
+        printf("bus %u, platform bus at 0x%08x:\n", it.first, b.addr);
+        printf("  %u locks, wait avg %.3f us, max %.3f us\n",
+               b.locks, b.locks ? b.wait / b.locks : 0, b.max_wait);
+        printf("  %u xfers, %u failed, %u errors, %llu bytes, busy %.1f%%,"
+               " xfer avg %.3f us, max %.3f us\n",
+               b.xfers, b.failed, b.errors, static_cast< unsigned long long >(b.bytes),
+               now > 0 ? b.busy * 100 / now : 0,
+               b.xfers ? b.busy / b.xfers : 0, b.max_xfer);
+
+        // Owners that held the bus longest come first
+        std::vector< std::pair< uint32_t, owner_stats > > owners{b.owners.begin(),
+                                                                 b.owners.end()};
+        std::sort(owners.begin(), owners.end(), [](const auto &l, const auto &r) {
+            return l.second.hold > r.second.hold;
+        });
+
+        for (auto &o : owners) {
+            printf("  owner 0x%08x: %u locks, held %.3f us, %.1f%%, max %.3f us\n",
+                   o.first, o.second.locks, o.second.hold,
+                   now > 0 ? o.second.hold * 100 / now : 0, o.second.max_hold);
+        }
+    }
+
+    return 0;
+}
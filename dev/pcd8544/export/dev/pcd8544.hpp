@@ -1,34 +1,25 @@
 #ifndef DEV_PCD8544_HPP
 #define DEV_PCD8544_HPP
 
+#include <ecl/framebuffer.hpp>
 #include <ecl/thread/semaphore.hpp>
 #include <os/utils.hpp>
+#include <platform/common/bus.hpp>
 
-namespace ecl
-{
+#include <cstring>
 
-// TODO: move it somewhere
-class point
+namespace ecl
 {
-public:
-    point() :point{0, 0} { }
-    point(int x, int y) :m_coords(x, y) { }
-
-    int get_x() const { return m_coords.first; }
-    int get_y() const { return m_coords.second; }
-
-    void set_x(int x) { m_coords.first = x; }
-    void set_y(int y) { m_coords.second = y; }
-
-private:
-    std::pair< int, int > m_coords;
-};
 
+// Display RAM layout, as seen in vertical addressing mode
+using pcd8544_framebuffer = framebuffer< 84, 48, 1, fb_layout::column_pages >;
 
+// Drawing is provided by the framebuffer, driver only sends modified
+// regions of it to the display
 // TODO: add GPIO type here, instead of using special names for SPI CS
 // and LCD D/C
 template< class Spi >
-class pcd8544
+class pcd8544 : public pcd8544_framebuffer
 {
 public:
     pcd8544();
@@ -43,24 +34,23 @@ public:
     // err::ok if succeed.
     err close();
 
-    // Graphic primitive operations.
-    // err::ok if succeed
-    err set_point(const point& coord);
-    err clear_point(const point& coord);
-
-    // Sends VRAM data to a display
-    // err::ok if succeed
+    // Sends VRAM data to a display. Only regions modified since
+    // the previous flush are sent.
+    // Modified regions are copied to the front buffer and sent in
+    // background, so drawing can proceed while the frame is transferred.
+    // If previous frame is still being sent, call blocks until it is done.
+    // err::ok if transfer is started
     err flush();
-    err clear();
+
+    // Waits until the frame, sent by the most recent flush(), reaches
+    // a display.
+    // err::ok if frame is sent successfully
+    err wait();
 
 private:
     // Rows as they are represented in a device
-    static constexpr uint8_t cols   = 84;
-    static constexpr uint8_t rows   = 6;
-
-    // Logical boundaries
-    static constexpr uint8_t max_X  = 84;
-    static constexpr uint8_t max_Y  = 48;
+    static constexpr uint8_t cols   = pcd8544_framebuffer::majors;
+    static constexpr uint8_t rows   = pcd8544_framebuffer::minors;
 
     // D/C values
     enum class DC_state
@@ -126,23 +116,76 @@ private:
     // VOP mask
     static constexpr uint8_t VOP_mask           = 0b01111111;
 
-    // Blocking send
-    err send(uint8_t byte, DC_state op);
+    // Instruction set, H = 0, D/C = 0
+
+    // Addressing opcodes:
+
+    // Set Y address (bank) prefix
+    static constexpr uint8_t Y_prefix           = 0b01000000;
+    // Y address mask
+    static constexpr uint8_t Y_mask             = 0b00000111;
+    // Set X address (column) prefix
+    static constexpr uint8_t X_prefix           = 0b10000000;
+    // X address mask
+    static constexpr uint8_t X_mask             = 0b01111111;
+
+    // Cost of starting a new window, expressed in data bytes:
+    // address commands, CS and D/C toggling.
+    static constexpr unsigned window_cost       = 4;
+
+    // Sends command sequence within single bus transaction, D/C is held low
+    // Blocks until sequence is sent
+    err send_commands(const uint8_t *cmds, size_t size);
+
+    // Blocking transfer of a buffer, with CS asserted
+    // Bus must be locked
+    err write(const uint8_t *buf, size_t size, DC_state op);
+
+    // Copies a window of VRAM to the front buffer
+    void copy_window(uint8_t x, uint8_t bank, size_t size);
 
-    // Bulk data write
+    // Prepares address commands of the current window
+    void load_window();
+
+    // Handles bus events of the background transfer. Executed in ISR context.
+    void bus_handler(bus_channel ch, bus_event type);
+
+    // Ends the background transfer. Executed in ISR context.
+    void finish_xfer(err status);
+
+    // Sends dirty regions
     err internal_flush();
 
-    uint8_t                 m_array[84][6];    // TODO: magic numbers
+    uint8_t                 m_front[cols][rows];    // Front buffer, being sent
     ecl::binary_semaphore   m_sem;             // Handle bus events
+
+    // Background transfer state. Frame is sent as a sequence of windows,
+    // each window is preceded by address commands.
+    uint8_t                 m_addr[2];         // Address commands of a window
+    uint8_t                 m_win_x;           // Column of the current window
+    uint8_t                 m_win_bank;        // Bank of the current window
+    uint8_t                 m_win_left;        // Windows left, including current
+    size_t                  m_win_size;        // Size of each window
+    bool                    m_data_phase;      // Window data is being sent
+    bool                    m_in_flight;       // Transfer is not yet waited for
+    err                     m_xfer_status;     // Status of the transfer
 };
 
 
 template< class Spi >
 pcd8544< Spi >::pcd8544()
-    :m_array{0}
+    :pcd8544_framebuffer{}
+    ,m_front{0}
     ,m_sem{}
+    ,m_addr{0}
+    ,m_win_x{0}
+    ,m_win_bank{0}
+    ,m_win_left{0}
+    ,m_win_size{0}
+    ,m_data_phase{false}
+    ,m_in_flight{false}
+    ,m_xfer_status{err::ok}
 {
-
     PCD8544_CS::set();
     PCD8544_Reset::set();
     PCD8544_Mode::set();
@@ -151,7 +194,8 @@ pcd8544< Spi >::pcd8544()
 template< class Spi >
 pcd8544< Spi >::~pcd8544()
 {
-    // TODO
+    // Front buffer must outlive the transfer
+    wait();
 }
 
 template< class Spi >
@@ -182,24 +226,28 @@ template< class Spi >
 err pcd8544< Spi >::open()
 {
     // Found somewhere in the net
+    static constexpr uint8_t init_seq[] = {
+        // Extended set on
+        FS_prefix | FS_H_on,
+        // Setup VOP
+        VOP_prefix | (VOP_mask & 0x40),
+        // Setup temperature control
+        TC_prefix | 0x2,
+        //  Set bias voltage
+        BS_prefix | (BS_mask & 0x3),
+        // Vertical addressing on, back to the basic instruction set
+        FS_prefix | FS_V_on,
+        // Set normal display mode
+        normal_mode,
+    };
 
-    // Extended set on
-    send(FS_prefix | FS_H_on, DC_state::command);
-
-    // Setup VOP
-    send(VOP_prefix | (VOP_mask & 0x40), DC_state::command);
-
-    // Setup temperature control
-    send(TC_prefix | 0x2, DC_state::command);
-
-    //  Set bias voltage
-    send(BS_prefix | (BS_mask & 0x3), DC_state::command);
-
-    // Vertical addressing on, back to the basic instruction set
-    send(FS_prefix | FS_V_on, DC_state::command);
+    auto rc = send_commands(init_seq, sizeof(init_seq));
+    if (is_error(rc)) {
+        return rc;
+    }
 
-    // Set normal display mode
-    send(normal_mode, DC_state::command);
+    // Display RAM is not initialized after reset
+    mark_all_dirty();
 
     return err::ok;
 }
@@ -208,57 +256,10 @@ err pcd8544< Spi >::open()
 template< class Spi >
 err pcd8544< Spi >::close()
 {
-    // TODO
-    return err::ok;
+    return wait();
 }
 
 
-template< class Spi >
-err pcd8544< Spi >::set_point(const point& coord)
-{
-    // TODO: checks
-    // TODO: common parts (see clear_point())
-    int x = coord.get_x();
-    int y = coord.get_y();
-
-    if (x < 0 || y < 0 || x > 83 || y > 47)
-        return err::inval;
-
-    // Calculate a byte offcet
-    int y_byte = y >> 3;
-
-    // Calculate a bit offcet inside a byte
-    int y_bit = y & 0x7;
-
-    // Set appropriate bit
-    m_array[x][y_byte] |= (1 << y_bit);
-
-    return err::ok;
-}
-
-template< class Spi >
-err pcd8544< Spi >::clear_point(const point& coord)
-{
-    // TODO: checks
-    // TODO: common parts (see set_point())
-    int x = coord.get_x();
-    int y = coord.get_y();
-
-    if (x < 0 || y < 0 || x > 83 || y > 47)
-        return -1;
-
-    // Calculate a byte offcet
-    int y_byte = y >> 3;
-
-    // Calculate a bit offcet inside a byte
-    int y_bit = y & 0x7;
-
-    // Clear appropriate bit
-    m_array[x][y_byte] &= ~(1 << y_bit);
-
-    return 0;
-}
-
 template< class Spi >
 err pcd8544< Spi >::flush()
 {
@@ -266,27 +267,39 @@ err pcd8544< Spi >::flush()
 }
 
 template< class Spi >
-err pcd8544< Spi >::clear()
+err pcd8544< Spi >::wait()
 {
-    // TODO: improve error check
-    // TODO: memset
-    for (unsigned i = 0; i < 84; ++i) {
-        for (unsigned j = 0; j < 6; ++j) {
-            m_array[i][j] = 0;
-        }
+    if (!m_in_flight) {
+        return m_xfer_status;
     }
 
-    return err::ok;
+    m_sem.wait();
+    m_in_flight = false;
+
+    if (is_error(m_xfer_status)) {
+        // Display content is unknown, resend everything next time
+        mark_all_dirty();
+    }
+
+    return m_xfer_status;
 }
 
 //------------------------------------------------------------------------------
 // Private members
 
 template< class Spi >
-err pcd8544< Spi >::send(uint8_t byte, DC_state op)
+err pcd8544< Spi >::send_commands(const uint8_t *cmds, size_t size)
 {
     Spi::lock();
+    auto rc = write(cmds, size, DC_state::command);
+    Spi::unlock();
+
+    return rc;
+}
 
+template< class Spi >
+err pcd8544< Spi >::write(const uint8_t *buf, size_t size, DC_state op)
+{
     if (op == DC_state::data)
         PCD8544_Mode::set();
     else
@@ -294,77 +307,161 @@ err pcd8544< Spi >::send(uint8_t byte, DC_state op)
 
     PCD8544_CS::reset();
 
-//    auto handler = [this]() {
-//        this->DMA_handler(this->m_DMA.get_status());
-//    };
+    auto rc = Spi::set_buffers(buf, nullptr, size);
+    if (!is_error(rc)) {
+        rc = Spi::xfer();
+    }
 
-//    m_DMA.enable_IRQ(handler, DMA_t::flags::TC);
+    PCD8544_CS::set();
 
-//    m_DMA.set_origin(DMA_t::role::memory,
-//                     &byte,
-//                     sizeof(byte));
+    return rc;
+}
 
-//    int rc = m_device.write(m_DMA);
+template< class Spi >
+void pcd8544< Spi >::copy_window(uint8_t x, uint8_t bank, size_t size)
+{
+    // Both buffers are stored column by column, thus consecutive
+    // columns are adjacent in memory
+    memcpy(&m_front[x][bank], data(x, bank), size);
+}
 
-//    // Wait for transaction to be over
-//    m_sem.wait();
-//    while (!(m_DMA_status & DMA_t::flags::TC)) {}
+template< class Spi >
+void pcd8544< Spi >::load_window()
+{
+    m_addr[0] = X_prefix | (X_mask & m_win_x);
+    m_addr[1] = Y_prefix | (Y_mask & m_win_bank);
+}
 
-//    // Request completed
-//    m_DMA.complete_IRQ(m_DMA_status);
-//    m_DMA.complete();
+template< class Spi >
+void pcd8544< Spi >::bus_handler(bus_channel ch, bus_event type)
+{
+    if (type == bus_event::err) {
+        m_xfer_status = err::io;
 
-//    m_DMA_status = 0;
-    Spi::set_buffers(&byte, nullptr, 1);
-    Spi::xfer();
+        // Failed continuation is reported via meta-channel, nothing
+        // will follow it
+        if (ch == bus_channel::meta) {
+            finish_xfer(err::io);
+        }
+        return;
+    }
 
-    PCD8544_CS::set();
+    if (ch != bus_channel::meta || type != bus_event::tc) {
+        return;
+    }
 
-    Spi::unlock();
+    if (is_error(m_xfer_status)) {
+        finish_xfer(m_xfer_status);
+        return;
+    }
 
-    return err::ok;
+    if (!m_data_phase) {
+        // Address is set, proceed with window data
+        m_data_phase = true;
+        PCD8544_Mode::set();
+        Spi::set_next_buffers(&m_front[m_win_x][m_win_bank], nullptr, m_win_size);
+    } else if (--m_win_left) {
+        // Next column
+        m_data_phase = false;
+        m_win_x++;
+        load_window();
+        PCD8544_Mode::reset();
+        Spi::set_next_buffers(m_addr, nullptr, sizeof(m_addr));
+    } else {
+        finish_xfer(err::ok);
+    }
+}
+
+template< class Spi >
+void pcd8544< Spi >::finish_xfer(err status)
+{
+    // Release the device, so other bus clients can use it
+    PCD8544_CS::set();
+    PCD8544_Mode::reset();
+
+    m_xfer_status = status;
+    m_sem.signal();
 }
 
 template< class Spi >
 err pcd8544< Spi >::internal_flush()
 {
-    Spi::lock();
+    // Front buffer must not be touched while previous frame is sent.
+    // If previous frame failed, whole VRAM becomes dirty.
+    wait();
 
-    PCD8544_Mode::set();
-    PCD8544_CS::reset();
+    auto &region = dirty();
 
-//    auto handler = [this]() {
-//        this->DMA_handler(this->m_DMA.get_status());
-//    };
+    if (region.empty()) {
+        // Nothing changed since last flush
+        return err::ok;
+    }
 
-//    m_DMA.enable_IRQ(handler, DMA_t::flags::TC);
+    unsigned x0 = region.major0;
+    unsigned x1 = region.major1;
+    unsigned b0 = region.minor0;
+    unsigned b1 = region.minor1;
+
+    // In vertical addressing mode controller increments bank first and
+    // then wraps to the next column. Thus VRAM, stored column by column,
+    // can be sent either as single run, from the first dirty byte
+    // till the last one, or as a separate window per each dirty column.
+    // Cheapest way is selected.
+    unsigned columns = x1 - x0 + 1;
+    unsigned banks = b1 - b0 + 1;
+    size_t run_size = (x1 - x0) * rows + banks;
+    size_t windows_size = columns * (banks + window_cost);
+
+    m_win_x = x0;
+    m_win_bank = b0;
+
+    if (run_size + window_cost <= windows_size) {
+        m_win_left = 1;
+        m_win_size = run_size;
+        copy_window(x0, b0, run_size);
+    } else {
+        m_win_left = columns;
+        m_win_size = banks;
+        for (unsigned x = x0; x <= x1; ++x) {
+            copy_window(x, b0, banks);
+        }
+    }
 
-//    m_DMA.set_origin(DMA_t::role::memory,
-//                     reinterpret_cast< uint8_t* > (m_array),
-//                     sizeof(m_array));
+    // Drawing can continue in the back buffer since now
+    mark_clean();
 
+    m_data_phase = false;
+    m_xfer_status = err::ok;
+    load_window();
 
-//    Spi::write(m_DMA);
+    // Lock waits for other clients, including their async xfers
+    Spi::lock();
 
-//    // Wait for transaction to be over
-//    m_sem.wait();
-//    while (!(m_DMA_status & DMA_t::flags::TC)) {}
-//    while ((Spi::get_status() & spi::flags::BSY)) { }
+    PCD8544_Mode::reset();
+    PCD8544_CS::reset();
 
-//    m_DMA.complete();
+    auto handler = [this](bus_channel ch, bus_event type, size_t total) {
+        (void) total;
+        this->bus_handler(ch, type);
+    };
 
+    auto rc = Spi::set_buffers(m_addr, nullptr, sizeof(m_addr));
+    if (!is_error(rc)) {
+        rc = Spi::xfer(handler);
+    }
 
-    auto tx = reinterpret_cast< uint8_t* > (m_array);
-    Spi::set_buffers(tx, nullptr, sizeof(m_array));
-    Spi::xfer();
+    if (is_error(rc)) {
+        PCD8544_CS::set();
+        // Frame is not sent, try again next time
+        mark_all_dirty();
+    } else {
+        m_in_flight = true;
+    }
 
+    // Bus will be released for other clients once xfer is complete
     Spi::unlock();
 
-    // Release the device
-    PCD8544_CS::set();
-    PCD8544_Mode::reset();
-
-    return err::ok;
+    return rc;
 }
 
 } // namespace ecl
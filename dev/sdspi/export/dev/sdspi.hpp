@@ -3,18 +3,32 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <functional>
 #include <string.h>
 
 #include <ecl/iostream.hpp>
 #include <ecl/endian.hpp>
+#include <ecl/err.hpp>
+#include <ecl/crc.hpp>
+#include <ecl/prof.hpp>
+#include <ecl/thread/completion.hpp>
+
+#include <platform/common/bus.hpp>
 
 namespace ecl
 {
 
 // TODO: mention about 8 additional clocks before each command!!!
-template< class spi_dev, class GPIO_CS >
+// Blocks are cached in write-back LRU cache, with given amount of entries.
+// Dirty blocks are written on flush(), close() or when evicted.
+// If cache has more than one entry, sequential reads trigger read-ahead
+// of the next block in background.
+template< class spi_dev, class GPIO_CS, size_t cache_blocks = 1 >
 class sd_spi
 {
+    static_assert(cache_blocks > 0, "At least one block must be cached");
+
 public:
     sd_spi();
     ~sd_spi();
@@ -35,16 +49,62 @@ public:
     int flush();
 
     // TODO: extend it with SEEK_CUR and SEEK_END
-    // Seeks to the given position, in bytes
-    int seek(off_t offset /*, SEEK_SET */);
+    // Seeks to the given position, in bytes. Position is 64-bit wide,
+    // so cards larger than 4 GiB are addressed entirely.
+    // -1 if error or position is beyond the card, 0 otherwise
+    int seek(int64_t offset /*, SEEK_SET */);
 
     // Tell current position
     // -1 if error, valid offset otherwise
-    off_t tell() const;
+    int64_t tell() const;
 
     // Returns a length of a block
     constexpr size_t get_block_length();
 
+    // Block device interface, see fs/block.hpp ---------------------------------
+
+    // Reads n blocks, starting from given block number, directly into
+    // the buffer. Pending writes in block cache are taken into account.
+    // -1 if error, 0 otherwise.
+    int read_blocks(size_t blk_num, uint8_t *buf, size_t n);
+
+    // Writes n blocks, starting from given block number, directly from
+    // the buffer. -1 if error, 0 otherwise.
+    int write_blocks(size_t blk_num, const uint8_t *buf, size_t n);
+
+    // Erases n blocks, starting from given block number. Erased blocks are
+    // read as all zeros or all ones, depending on the card.
+    // Pending writes to these blocks are discarded. -1 if error, 0 otherwise.
+    int trim(size_t blk_num, size_t n);
+
+    // Returns amount of blocks on the card, 0 if device is not opened
+    size_t block_count() const;
+
+    // Returns preferred size of a request, in bytes. Multi-block transfers
+    // of this size and larger keep per-command overhead low.
+    constexpr size_t preferred_io_size();
+
+    // Enables or disables CRC protection of transfers. When enabled, CRC of
+    // every received block is verified and card checks CRC of commands and
+    // written blocks. Setting is applied right away if device is opened,
+    // or during next open() otherwise. -1 if error, 0 otherwise.
+    int set_crc(bool enable);
+
+    // Completion callback of async block I/O. Receives 0 if succeed,
+    // negative value otherwise. Likely executed in ISR context.
+    using async_callback = std::function< void(int status) >;
+
+    // Starts reading of n blocks, starting from given block number.
+    // Returns without waiting for the card, -1 if device is not opened or
+    // other async I/O is in progress, 0 otherwise.
+    // Buffer must stay valid until callback is invoked. Until that moment
+    // no other operations are allowed. Callback must not block.
+    int read_blocks_async(size_t blk_num, uint8_t *buf, size_t n, const async_callback &cb);
+
+    // Starts writing of n blocks, starting from given block number.
+    // Semantics are the same as for read_blocks_async().
+    int write_blocks_async(size_t blk_num, const uint8_t *buf, size_t n, const async_callback &cb);
+
     // Seek flags
     enum class seekdir
     {
@@ -57,6 +117,8 @@ private:
     // Return types.
     // Enums ommited, since it should be replaced
     // with system-wide error flags
+    static constexpr int sd_notsup   = -5;  // Operation is not supported by the bus
+    static constexpr int sd_crc_err  = -4;  // Data CRC mismatch
     static constexpr int sd_expired  = -3;  // Event expired
     static constexpr int sd_spi_err  = -2;  // SPI returns error
     static constexpr int sd_err      = -1;  // General error
@@ -64,6 +126,12 @@ private:
     static constexpr int sd_type_hc  = 1;   // The card is high capacity
     static constexpr int sd_type_sc  = 2;   // The card is standart capacity
 
+    // Bus clocks, in Hz.
+    // Card identification must be done at low speed, then bus can run
+    // at the full speed, limited by the bus itself.
+    static constexpr uint32_t sd_init_clk = 400000;
+    static constexpr uint32_t sd_data_clk = 25000000;
+
     // R1 response
     struct R1
     {
@@ -109,7 +177,7 @@ private:
 
     struct block_buffer
     {
-        block_buffer() :block{0}, origin{0}, mint{true} { }
+        block_buffer() :block{0}, origin{0}, mint{true}, valid{false}, used{0} { }
 
         // Block length is given without respect to the card type.
         // If card is Standart Capacity then block length will be set to 512,
@@ -120,6 +188,8 @@ private:
         uint8_t block[block_len];     // The block itself
         size_t  origin;               // The offset from which block was obtained
         bool    mint;                 // True if there were no writes in buffer
+        bool    valid;                // True if buffer holds a block
+        size_t  used;                 // Time of last access, for LRU eviction
     };
 
     // http://elm-chan.org/docs/mmc/mmc_e.html
@@ -138,13 +208,14 @@ private:
     int CMD8(R7 &r);
 
     // SEND_CSD                 - Read CSD register.
-    int CMD9(R1 &r, uint8_t *buf, size_t size);
+    int CMD9(R1 &r);
 
     // SEND_CID                 - Read CID register.
     int CMD10(R1 &r);
 
     // STOP_TRANSMISSION        - Stop to read data.
-    // int CMD12(R1 &r); R1b is required here
+    //                            R1b response: waits until card is not busy.
+    int CMD12(R1 &r);
 
     // SET_BLOCKLEN             - Change R/W block size.
     int CMD16(R1 &r);
@@ -153,7 +224,7 @@ private:
     int CMD17(R1 &r, uint32_t address);
 
     // READ_MULTIPLE_BLOCK      - Read multiple blocks.
-    int CMD18(R1 &r, uint32_t address, uint8_t *buf, size_t size);
+    int CMD18(R1 &r, uint32_t address);
 
     // SET_BLOCK_COUNT          - For only MMC. Define number of blocks to transfer
     //                            with next multi-block read/write command.
@@ -161,13 +232,23 @@ private:
 
     // SET_WR_BLOCK_ERASE_COUNT - For only SDC. Define number of blocks to pre-erase
     //                              with next multi-block write command.
-    int ACMD23(R1 &r, uint16_t block_count);
+    int ACMD23(R1 &r, uint32_t block_count);
 
     // WRITE_BLOCK              - Write a block.
     int CMD24(R1 &r, uint32_t address);
 
     // WRITE_MULTIPLE_BLOCK     - Write multiple blocks.
-    int CMD25(R1 &r, uint32_t address, uint8_t *buf, size_t size);
+    int CMD25(R1 &r, uint32_t address);
+
+    // ERASE_WR_BLK_START_ADDR  - For only SDC. Set first block to erase.
+    int CMD32(R1 &r, uint32_t address);
+
+    // ERASE_WR_BLK_END_ADDR    - For only SDC. Set last block to erase.
+    int CMD33(R1 &r, uint32_t address);
+
+    // ERASE                    - Erase previously selected blocks.
+    //                            R1b response: waits until card is not busy.
+    int CMD38(R1 &r);
 
     // APP_CMD                  - Leading command of ACMD<n> command.
     int CMD55(R1 &r);
@@ -175,6 +256,9 @@ private:
     // READ_OCR                 - Read OCR.
     int CMD58(R3 &r);
 
+    // CRC_ON_OFF               - Enable or disable CRC checks by the card.
+    int CMD59(R1 &r, bool enable);
+
     // Sends CMD
     template< typename R >
     int send_CMD(R &resp, uint8_t CMD_idx, const argument &arg, uint8_t crc = 0);
@@ -187,9 +271,20 @@ private:
     int init_process();
     int check_OCR();
     int obtain_card_info();
+    int obtain_capacity();
     int set_block_length();
+    block_buffer *lookup_block(size_t blk_num);
+    block_buffer &pick_victim();
+    void prefetch(size_t blk_num);
+    void prefetch_wait();
     int populate_block(size_t new_block);
-    int flush_block();
+    int flush_block(block_buffer &buf);
+    int flush_cache();
+    // Reads whole blocks directly into the buffer, bypassing block cache.
+    // Pending writes in block cache are taken into account.
+    int read_direct(size_t first_block, uint8_t *buf, size_t blocks);
+    // Writes whole blocks directly from the buffer, keeping block cache coherent
+    int write_direct(size_t first_block, const uint8_t *buf, size_t blocks);
     int traverse_data(size_t count, const std::function< void(size_t data_offt,
                                                               size_t blk_offt,
                                                               size_t amount) >& fn);
@@ -200,42 +295,164 @@ private:
     //int receive_response(R1_read &r);
 
     int receive_data(uint8_t *buf, size_t size);
-    int send_data(const uint8_t *buf, size_t size);
-
-    // Transport layer TODO: merge these three
+    int send_data(const uint8_t *buf, size_t size, uint8_t token = data_token);
+    int wait_busy();
+
+    // Waits until card is not busy, streaming dummy bytes with DMA into
+    // the scan ring. Ring halves are checked from the bus handler, so
+    // the thread sleeps while card is busy, instead of issuing an xfer
+    // per few bytes. Returns sd_notsup if bus can't stream.
+    int scan_busy();
+    void scan_handler(bus_channel ch, bus_event type);
+
+    // Data tokens
+    static constexpr uint8_t data_token         = 0xfe; // Single block, any read
+    static constexpr uint8_t data_token_multi   = 0xfc; // Multi-block write
+    static constexpr uint8_t stop_tran_token    = 0xfd; // Stop multi-block write
+
+    // Transport layer.
+    // Bytes that card sends in response are received in advance, to the
+    // response window, within the same bus xfer that carries a command or
+    // data. Byte-by-byte polling is served from the window, so every
+    // command costs one bus xfer in most cases. Receive functions drain
+    // the window first, send functions discard it.
     ssize_t spi_send(const uint8_t *buf, size_t size);
     ssize_t spi_receive(uint8_t *buf, size_t size);
     ssize_t spi_send_dummy(size_t size);
+    // Sends given segments, followed by refill of the response window.
+    ssize_t spi_transact(bus_segment *segs, size_t n);
+    // Receives a single byte, refilling the window if needed.
+    int receive_byte(uint8_t &byte);
+    // Drops bytes in the window.
+    void drop_window();
+
+    // Async I/O ----------------------------------------------------------------
+
+    // Steps of async I/O state machine. Each step is a single bus xfer,
+    // next step is started right from the bus event handler.
+    enum class async_step
+    {
+        cmd,            // Command is sent
+        r1,             // R1 response byte is received
+        token,          // Data token byte is received
+        tx_token,       // Data token is sent
+        data,           // Data block is sent or received
+        crc,            // CRC is sent or received
+        data_resp,      // Data response is received
+        block_busy,     // Card is busy, writing a block
+        stop_stuff,     // Stuff byte after CMD12 is received
+        stop_r1,        // R1 response of CMD12 is received
+        stop_token,     // Stop token of multi-block write is sent
+        stop_busy,      // Card is busy, finishing multi-block operation
+    };
+
+    int start_async(size_t blk_num, uint8_t *buf, size_t n, const async_callback &cb, bool write);
+    void async_handler(bus_channel ch, bus_event type);
+    void async_next();
+    void async_continue(async_step step, const uint8_t *tx, uint8_t *rx, size_t size);
+    void async_poll(async_step step, uint8_t *rx, size_t size, uint16_t tries);
+    void async_finish(int status);
 
     bool          m_inited;     // Inited flags
     bool          m_HC;         // High Capacity flag
     int           m_opened;     // Opened times counter
-    off_t         m_offt;       // Current offset in units of bytes
-    block_buffer  m_block;      // Buffer containing last read\write block
+    bool          m_crc;        // CRC protection is enabled
+    size_t        m_blocks;     // Amount of blocks on the card
+    size_t        m_blk;        // Current block
+    size_t        m_blk_offt;   // Current offset within the block, in bytes
+    static constexpr size_t window_len = 8;
+
+    uint8_t       m_window[window_len]; // Response window
+    size_t        m_win_pos;    // Next byte in the window
+    size_t        m_win_len;    // Valid bytes in the window
+
+    // Cache containing recently read\written blocks
+    std::array< block_buffer, cache_blocks > m_cache;
+    block_buffer  *m_block;     // Block that is currently accessed
+    size_t        m_clock;      // Cache access counter
+
+    size_t              m_read_blk;     // Block where previous read ended
+    size_t              m_read_offt;    // Offset within that block
+    block_buffer        *m_prefetch;    // Entry that is being read ahead
+    std::atomic_bool    m_prefetched;   // Read-ahead is complete
+
+    std::atomic_bool    m_async_busy;   // Async I/O in progress
+    async_step          m_async_step;   // Step of async I/O in progress
+    bool                m_async_write;  // Async I/O direction
+    bool                m_async_multi;  // Multi-block command is used
+    uint8_t             *m_async_buf;   // Next block to transfer
+    size_t              m_async_first;  // First block of async I/O
+    size_t              m_async_total;  // Amount of blocks to transfer
+    size_t              m_async_left;   // Blocks left to transfer
+    uint16_t            m_async_tries;  // Polls left for current step
+    int                 m_async_status; // Status to report on completion
+    async_callback      m_async_cb;     // User callback
+    uint8_t             m_async_cmd[7]; // Command, including leading byte
+    uint8_t             m_async_poll[8];// Polled bytes
+    uint8_t             m_async_crc[2]; // CRC, checked if protection is on
+
+    // Half of the scan ring. At full speed, it takes tens of microseconds
+    // to fill, which bounds both IRQ rate and detection latency.
+    static constexpr size_t scan_len = 128;
+    // Scan is in progress, status is not yet known
+    static constexpr int scan_pending = 1;
+
+    uint8_t             m_scan[2][scan_len]; // Scan ring, filled by DMA
+    int                 m_scan_status;  // Status of the scan
+    ecl::completion     m_scan_done;    // Scan status is known
 };
 
-template< class spi_dev, class GPIO_CS >
-sd_spi< spi_dev, GPIO_CS >::sd_spi()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+sd_spi< spi_dev, GPIO_CS, cache_blocks >::sd_spi()
     :m_inited{false}
     ,m_HC{false}
     ,m_opened{0}
-    ,m_offt{0}
-    ,m_block{}
+    ,m_crc{false}
+    ,m_blocks{0}
+    ,m_blk{0}
+    ,m_blk_offt{0}
+    ,m_window{}
+    ,m_win_pos{0}
+    ,m_win_len{0}
+    ,m_cache{}
+    ,m_block{nullptr}
+    ,m_clock{0}
+    ,m_read_blk{static_cast< size_t >(-1)}
+    ,m_read_offt{0}
+    ,m_prefetch{nullptr}
+    ,m_prefetched{false}
+    ,m_async_busy{false}
+    ,m_async_step{async_step::cmd}
+    ,m_async_write{false}
+    ,m_async_multi{false}
+    ,m_async_buf{nullptr}
+    ,m_async_first{0}
+    ,m_async_total{0}
+    ,m_async_left{0}
+    ,m_async_tries{0}
+    ,m_async_status{sd_ok}
+    ,m_async_cb{}
+    ,m_async_cmd{}
+    ,m_async_poll{}
+    ,m_async_crc{}
+    ,m_scan{}
+    ,m_scan_status{sd_ok}
+    ,m_scan_done{}
 {
 }
 
-template< class spi_dev, class GPIO_CS >
-sd_spi< spi_dev, GPIO_CS >::~sd_spi()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+sd_spi< spi_dev, GPIO_CS, cache_blocks >::~sd_spi()
 {
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::init()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::init()
 {
     if (!m_inited) {
         spi_dev::init();
 
-        spi_dev::lock();
+        spi_dev::lock(sd_init_clk);
         GPIO_CS::set();
 
         spi_dev::unlock();
@@ -247,8 +464,8 @@ int sd_spi< spi_dev, GPIO_CS >::init()
     return 0;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::open()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::open()
 {
     if (!m_inited) {
         return -1;
@@ -257,7 +474,7 @@ int sd_spi< spi_dev, GPIO_CS >::open()
     int ret = 0;
 
     if (!m_opened) {
-        spi_dev::lock();
+        spi_dev::lock(sd_init_clk);
 
 
         if (send_init() < 0) {
@@ -278,106 +495,661 @@ int sd_spi< spi_dev, GPIO_CS >::open()
     return ret;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::close()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::close()
 {
+    int ret = 0;
+
     if (!--m_opened) {
-        // TODO
+        ret = flush();
     }
 
-    return 0;
+    return ret;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::set_crc(bool enable)
+{
+    if (!m_opened) {
+        m_crc = enable;
+        return 0;
+    }
+
+    prefetch_wait();
+
+    R1 r1;
+
+    // Command must carry valid CRC in case if protection is on right now
+    m_crc = true;
+
+    spi_dev::lock(sd_data_clk);
+    GPIO_CS::reset();
+    int SD_ret = CMD59(r1, enable);
+    GPIO_CS::set();
+    spi_dev::unlock();
+
+    m_crc = enable;
+
+    return (SD_ret < 0 || !r1.ok()) ? -1 : 0;
 }
 
-template< class spi_dev, class GPIO_CS >
-ssize_t sd_spi< spi_dev, GPIO_CS >::write(const uint8_t *data, size_t count)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+ssize_t sd_spi< spi_dev, GPIO_CS, cache_blocks >::write(const uint8_t *data, size_t count)
 {
+    ECL_TRACE_SCOPE("sd.write");
+
     if (!m_opened) {
         return -1;
     }
 
+    prefetch_wait();
+
     int SD_ret;
-    auto fn = [data, this](size_t data_offt, size_t blk_offt, size_t to_copy) {
-        memcpy(this->m_block.block + blk_offt, data + data_offt, to_copy);
-        this->m_block.mint = false;
+    size_t done = 0;
+
+    auto fn = [data, &done, this](size_t data_offt, size_t blk_offt, size_t to_copy) {
+        memcpy(this->m_block->block + blk_offt, data + done + data_offt, to_copy);
+        this->m_block->mint = false;
     };
 
-    SD_ret = traverse_data(count, fn);
-    if (SD_ret < 0)
-        return SD_ret;
+    // Head, up to the block boundary, goes through the block cache
+    if (m_blk_offt) {
+        size_t head = std::min(block_buffer::block_len - m_blk_offt, count);
+
+        SD_ret = traverse_data(head, fn);
+        if (SD_ret < 0)
+            return SD_ret;
+
+        done += head;
+    }
+
+    // Whole blocks are streamed straight from user buffer
+    size_t blocks = (count - done) / block_buffer::block_len;
+    if (blocks) {
+        spi_dev::lock(sd_data_clk);
+        GPIO_CS::reset();
+        SD_ret = write_direct(m_blk, data + done, blocks);
+        GPIO_CS::set();
+        spi_dev::unlock();
+
+        if (SD_ret < 0)
+            return SD_ret;
+
+        done += blocks * block_buffer::block_len;
+        m_blk += blocks;
+    }
+
+    // Tail, if any
+    if (count - done) {
+        SD_ret = traverse_data(count - done, fn);
+        if (SD_ret < 0)
+            return SD_ret;
+    }
 
     return count;
 }
 
-template< class spi_dev, class GPIO_CS >
-ssize_t sd_spi< spi_dev, GPIO_CS >::read(uint8_t *data, size_t count)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+ssize_t sd_spi< spi_dev, GPIO_CS, cache_blocks >::read(uint8_t *data, size_t count)
 {
+    ECL_TRACE_SCOPE("sd.read");
+
     if (!m_opened) {
         return -1;
     }
 
+    prefetch_wait();
+
     int SD_ret;
-    auto fn = [data, this](size_t data_offt, size_t blk_offt, size_t to_copy) {
-        memcpy(data + data_offt, this->m_block.block + blk_offt , to_copy);
+    size_t done = 0;
+    bool sequential = (m_blk == m_read_blk && m_blk_offt == m_read_offt);
+
+    auto fn = [data, &done, this](size_t data_offt, size_t blk_offt, size_t to_copy) {
+        memcpy(data + done + data_offt, this->m_block->block + blk_offt , to_copy);
     };
 
-    SD_ret = traverse_data(count, fn);
-    if (SD_ret < 0)
-        return SD_ret;
+    // Head, up to the block boundary, goes through the block cache
+    if (m_blk_offt) {
+        size_t head = std::min(block_buffer::block_len - m_blk_offt, count);
+
+        SD_ret = traverse_data(head, fn);
+        if (SD_ret < 0)
+            return SD_ret;
+
+        done += head;
+    }
+
+    // Whole blocks are streamed straight into user buffer
+    size_t blocks = (count - done) / block_buffer::block_len;
+    if (blocks) {
+        spi_dev::lock(sd_data_clk);
+        GPIO_CS::reset();
+        SD_ret = read_direct(m_blk, data + done, blocks);
+        GPIO_CS::set();
+        spi_dev::unlock();
+
+        if (SD_ret < 0)
+            return SD_ret;
+
+        done += blocks * block_buffer::block_len;
+        m_blk += blocks;
+    }
+
+    // Tail, if any
+    if (count - done) {
+        SD_ret = traverse_data(count - done, fn);
+        if (SD_ret < 0)
+            return SD_ret;
+    }
+
+    m_read_blk  = m_blk;
+    m_read_offt = m_blk_offt;
+
+    // Next block is likely to be requested soon
+    if (sequential && count) {
+        prefetch(m_blk_offt ? m_blk + 1 : m_blk);
+    }
 
     return count;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::flush()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::flush()
 {
     int ret = 0;
 
-    spi_dev::lock();
+    prefetch_wait();
+
+    spi_dev::lock(sd_data_clk);
     GPIO_CS::reset();
 
-    if (flush_block() < 0)
+    if (flush_cache() < 0)
         ret = -1;
 
-    spi_dev::unlock();
     GPIO_CS::set();
+    spi_dev::unlock();
 
     return ret;
 }
 
-// TODO: change off_t to int
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::seek(off_t offset)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::seek(int64_t offset)
 {
-    if (!m_opened) {
+    constexpr int64_t block_len = block_buffer::block_len;
+
+    if (!m_opened || offset < 0 || offset > static_cast< int64_t >(m_blocks) * block_len) {
         return -1;
     }
 
-    m_offt = offset;
+    // Position is kept in blocks, so no byte arithmetic is done
+    // on each access
+    m_blk       = offset / block_len;
+    m_blk_offt  = offset % block_len;
     return 0;
 }
 
 
-template< class spi_dev, class GPIO_CS >
-off_t sd_spi< spi_dev, GPIO_CS >::tell() const
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int64_t sd_spi< spi_dev, GPIO_CS, cache_blocks >::tell() const
 {
     if (!m_opened) {
         return -1;
     }
 
-    return m_offt;
+    return static_cast< int64_t >(m_blk) * block_buffer::block_len + m_blk_offt;
 }
 
-template< class spi_dev, class GPIO_CS >
-constexpr size_t sd_spi< spi_dev, GPIO_CS >::get_block_length()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+constexpr size_t sd_spi< spi_dev, GPIO_CS, cache_blocks >::get_block_length()
 {
     return block_buffer::block_len;
 }
 
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::read_blocks(size_t blk_num, uint8_t *buf, size_t n)
+{
+    ECL_TRACE_SCOPE("sd.read_blocks");
+
+    if (!m_opened || blk_num + n > m_blocks) {
+        return -1;
+    }
+
+    if (!n) {
+        return 0;
+    }
+
+    ECL_COUNTER_ADD("sd.blocks_read", n);
+
+    prefetch_wait();
+
+    spi_dev::lock(sd_data_clk);
+    GPIO_CS::reset();
+    int SD_ret = read_direct(blk_num, buf, n);
+    GPIO_CS::set();
+    spi_dev::unlock();
+
+    return SD_ret < 0 ? -1 : 0;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::write_blocks(size_t blk_num, const uint8_t *buf,
+                                                           size_t n)
+{
+    ECL_TRACE_SCOPE("sd.write_blocks");
+
+    if (!m_opened || blk_num + n > m_blocks) {
+        return -1;
+    }
+
+    if (!n) {
+        return 0;
+    }
+
+    ECL_COUNTER_ADD("sd.blocks_written", n);
+
+    prefetch_wait();
+
+    spi_dev::lock(sd_data_clk);
+    GPIO_CS::reset();
+    int SD_ret = write_direct(blk_num, buf, n);
+    GPIO_CS::set();
+    spi_dev::unlock();
+
+    return SD_ret < 0 ? -1 : 0;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::trim(size_t blk_num, size_t n)
+{
+    if (!m_opened || blk_num + n > m_blocks) {
+        return -1;
+    }
+
+    if (!n) {
+        return 0;
+    }
+
+    prefetch_wait();
+
+    // Cached copies of erased blocks are stale now
+    for (auto &b : m_cache) {
+        if (b.valid && b.origin >= blk_num && b.origin < blk_num + n) {
+            b.valid = false;
+            b.mint  = true;
+        }
+    }
+
+    size_t last = blk_num + n - 1;
+    uint32_t start_addr = m_HC ? blk_num : blk_num * block_buffer::block_len;
+    uint32_t end_addr   = m_HC ? last : last * block_buffer::block_len;
+
+    R1 r1;
+    int SD_ret;
+
+    spi_dev::lock(sd_data_clk);
+    GPIO_CS::reset();
+
+    if ((SD_ret = CMD32(r1, start_addr)) >= 0 && r1.ok()
+            && (SD_ret = CMD33(r1, end_addr)) >= 0 && r1.ok()) {
+        SD_ret = CMD38(r1);
+    }
+
+    GPIO_CS::set();
+    spi_dev::unlock();
+
+    return (SD_ret < 0 || !r1.ok()) ? -1 : 0;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+size_t sd_spi< spi_dev, GPIO_CS, cache_blocks >::block_count() const
+{
+    return m_opened ? m_blocks : 0;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+constexpr size_t sd_spi< spi_dev, GPIO_CS, cache_blocks >::preferred_io_size()
+{
+    return 8 * block_buffer::block_len;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::read_blocks_async(size_t blk_num, uint8_t *buf,
+                                                                size_t n, const async_callback &cb)
+{
+    prefetch_wait();
+    return start_async(blk_num, buf, n, cb, false);
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::write_blocks_async(size_t blk_num,
+                                                                 const uint8_t *buf, size_t n,
+                                                                 const async_callback &cb)
+{
+    prefetch_wait();
+
+    // Buffer is never written by the state machine in write mode
+    return start_async(blk_num, const_cast< uint8_t * >(buf), n, cb, true);
+}
+
 // Private methods -------------------------------------------------------------
 
-template< class spi_dev, class GPIO_CS >
-ssize_t sd_spi< spi_dev, GPIO_CS >::spi_send(const uint8_t *buf, size_t size)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::start_async(size_t blk_num, uint8_t *buf, size_t n,
+                                                          const async_callback &cb, bool write)
+{
+    constexpr uint8_t CMD17_idx = 17;
+    constexpr uint8_t CMD18_idx = 18;
+    constexpr uint8_t CMD24_idx = 24;
+    constexpr uint8_t CMD25_idx = 25;
+
+    if (!m_opened || !n || m_async_busy.exchange(true)) {
+        return sd_err;
+    }
+
+    uint32_t address = m_HC ? blk_num : blk_num * block_buffer::block_len;
+    uint8_t  idx;
+
+    if (write) {
+        idx = (n > 1) ? CMD25_idx : CMD24_idx;
+
+        // Cached blocks will be overwritten, so they are updated right away
+        for (auto &b : m_cache) {
+            if (b.valid && b.origin >= blk_num && b.origin < blk_num + n) {
+                memcpy(b.block, buf + (b.origin - blk_num) * block_buffer::block_len,
+                       block_buffer::block_len);
+                b.mint = true;
+            }
+        }
+    } else {
+        idx = (n > 1) ? CMD18_idx : CMD17_idx;
+    }
+
+    m_async_write   = write;
+    m_async_multi   = n > 1;
+    m_async_buf     = buf;
+    m_async_first   = blk_num;
+    m_async_total   = n;
+    m_async_left    = n;
+    m_async_status  = sd_ok;
+    m_async_cb      = cb;
+    m_async_step    = async_step::cmd;
+
+    // Async xfers bypass the response window
+    drop_window();
+    m_async_crc[0]  = m_async_crc[1] = 0xff;
+
+    m_async_cmd[0]  = 0xff;
+    m_async_cmd[1]  = idx | 0x40;
+    m_async_cmd[2]  = address >> 24;
+    m_async_cmd[3]  = address >> 16;
+    m_async_cmd[4]  = address >> 8;
+    m_async_cmd[5]  = address;
+    m_async_cmd[6]  = (crc7(m_async_cmd + 1, 5) << 1) | 0x1; // CRC and EOT flag
+
+    auto handler = [this](bus_channel ch, bus_event type, size_t total) {
+        (void) total;
+        this->async_handler(ch, type);
+    };
+
+    spi_dev::lock(sd_data_clk);
+    GPIO_CS::reset();
+
+    spi_dev::set_buffers(m_async_cmd, nullptr, sizeof(m_async_cmd));
+    auto rc = spi_dev::xfer(handler);
+
+    if (is_error(rc)) {
+        GPIO_CS::set();
+        m_async_busy = false;
+    }
+
+    // Bus can be unlocked while async xfer is in progress. Next lock()
+    // will be blocked until whole sequence will be complete.
+    spi_dev::unlock();
+
+    return is_error(rc) ? sd_spi_err : sd_ok;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+void sd_spi< spi_dev, GPIO_CS, cache_blocks >::async_handler(bus_channel ch, bus_event type)
+{
+    // Events after completion are not interesting
+    if (ch != bus_channel::meta || !m_async_busy) {
+        return;
+    }
+
+    if (type == bus_event::err) {
+        async_finish(sd_spi_err);
+    } else if (type == bus_event::tc) {
+        async_next();
+    }
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+void sd_spi< spi_dev, GPIO_CS, cache_blocks >::async_continue(async_step step, const uint8_t *tx,
+                                                              uint8_t *rx, size_t size)
+{
+    m_async_step = step;
+
+    if (is_error(spi_dev::set_next_buffers(tx, rx, size))) {
+        async_finish(sd_spi_err);
+    }
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+void sd_spi< spi_dev, GPIO_CS, cache_blocks >::async_poll(async_step step, uint8_t *rx,
+                                                          size_t size, uint16_t tries)
+{
+    m_async_tries = tries;
+    async_continue(step, nullptr, rx, size);
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+void sd_spi< spi_dev, GPIO_CS, cache_blocks >::async_next()
+{
+    // Polling limits. Each poll is a separate xfer, so card latency
+    // is covered by IRQs and not by a thread spinning in the driver.
+    constexpr uint16_t r1_tries     = 8;
+    constexpr uint16_t token_tries  = 0xffff;
+    constexpr uint16_t resp_tries   = 32;
+    constexpr uint16_t busy_tries   = 0xffff;
+
+    static constexpr uint8_t stop_cmd[] = { 12 | 0x40, 0, 0, 0, 0, 0x61 };
+    constexpr uint8_t  busy_poll    = sizeof(m_async_poll);
+
+    auto &byte = m_async_poll[0];
+
+    switch (m_async_step) {
+    case async_step::cmd:
+        async_poll(async_step::r1, &byte, 1, r1_tries);
+        break;
+
+    case async_step::r1:
+        if (byte & R1::reserved_bit) {
+            if (--m_async_tries) {
+                async_poll(async_step::r1, &byte, 1, m_async_tries);
+            } else {
+                async_finish(sd_expired);
+            }
+        } else if (byte & ~R1::idle_state) {
+            async_finish(sd_err);
+        } else if (m_async_write) {
+            byte = m_async_multi ? data_token_multi : data_token;
+            async_continue(async_step::tx_token, &byte, nullptr, 1);
+        } else {
+            async_poll(async_step::token, &byte, 1, token_tries);
+        }
+        break;
+
+    case async_step::token:
+        if (byte == 0xff) {
+            if (--m_async_tries) {
+                async_poll(async_step::token, &byte, 1, m_async_tries);
+            } else {
+                async_finish(sd_expired);
+            }
+        } else if (byte == data_token) {
+            async_continue(async_step::data, nullptr, m_async_buf, block_buffer::block_len);
+        } else {
+            async_finish(sd_err);
+        }
+        break;
+
+    case async_step::tx_token:
+        if (m_crc) {
+            uint16_t crc = crc16(m_async_buf, block_buffer::block_len);
+            m_async_crc[0] = crc >> 8;
+            m_async_crc[1] = crc;
+        }
+
+        async_continue(async_step::data, m_async_buf, nullptr, block_buffer::block_len);
+        break;
+
+    case async_step::data:
+        if (m_async_write) {
+            async_continue(async_step::crc, m_async_crc, nullptr, sizeof(m_async_crc));
+        } else {
+            async_continue(async_step::crc, nullptr, m_async_crc, sizeof(m_async_crc));
+        }
+        break;
+
+    case async_step::crc:
+        if (m_async_write) {
+            async_poll(async_step::data_resp, &byte, 1, resp_tries);
+            break;
+        }
+
+        m_async_left--;
+
+        if (m_crc && crc16(m_async_buf, block_buffer::block_len)
+                != ((m_async_crc[0] << 8) | m_async_crc[1])) {
+            // Rest of blocks are not interesting, but transmission
+            // must be stopped anyway
+            m_async_status = sd_crc_err;
+            m_async_left = 0;
+        }
+
+        m_async_buf += block_buffer::block_len;
+
+        if (m_async_left) {
+            async_poll(async_step::token, &byte, 1, token_tries);
+        } else if (m_async_multi) {
+            async_continue(async_step::stop_stuff, stop_cmd, nullptr, sizeof(stop_cmd));
+        } else {
+            async_finish(m_async_status);
+        }
+        break;
+
+    case async_step::data_resp:
+        if ((byte & 0x11) != 0x01) {
+            if (--m_async_tries) {
+                async_poll(async_step::data_resp, &byte, 1, m_async_tries);
+            } else {
+                async_finish(sd_expired);
+            }
+        } else if ((byte & 0x0f) != 0x05) {
+            // Data is rejected
+            async_finish(sd_err);
+        } else {
+            async_poll(async_step::block_busy, m_async_poll, busy_poll, busy_tries);
+        }
+        break;
+
+    case async_step::block_busy:
+        // Card holds data line low while it is busy
+        if (!m_async_poll[busy_poll - 1]) {
+            if (--m_async_tries) {
+                async_poll(async_step::block_busy, m_async_poll, busy_poll, m_async_tries);
+            } else {
+                async_finish(sd_expired);
+            }
+            break;
+        }
+
+        m_async_buf += block_buffer::block_len;
+
+        if (--m_async_left) {
+            byte = data_token_multi;
+            async_continue(async_step::tx_token, &byte, nullptr, 1);
+        } else if (m_async_multi) {
+            // Stop token, followed by a byte before busy signal appears
+            m_async_cmd[0] = stop_tran_token;
+            m_async_cmd[1] = 0xff;
+            async_continue(async_step::stop_token, m_async_cmd, nullptr, 2);
+        } else {
+            async_finish(sd_ok);
+        }
+        break;
+
+    case async_step::stop_stuff:
+        // Skip the stuff byte that follows CMD12
+        async_poll(async_step::stop_r1, &byte, 1, r1_tries + 1);
+        break;
+
+    case async_step::stop_token:
+        async_poll(async_step::stop_busy, m_async_poll, busy_poll, busy_tries);
+        break;
+
+    case async_step::stop_r1:
+        if (byte & R1::reserved_bit) {
+            if (--m_async_tries) {
+                async_poll(async_step::stop_r1, &byte, 1, m_async_tries);
+            } else {
+                async_finish(sd_expired);
+            }
+        } else {
+            async_poll(async_step::stop_busy, m_async_poll, busy_poll, busy_tries);
+        }
+        break;
+
+    case async_step::stop_busy:
+        if (!m_async_poll[busy_poll - 1]) {
+            if (--m_async_tries) {
+                async_poll(async_step::stop_busy, m_async_poll, busy_poll, m_async_tries);
+            } else {
+                async_finish(sd_expired);
+            }
+        } else {
+            async_finish(m_async_status);
+        }
+        break;
+    }
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+void sd_spi< spi_dev, GPIO_CS, cache_blocks >::async_finish(int status)
+{
+    GPIO_CS::set();
+
+    // Cached blocks may be modified and not yet written.
+    // These are more recent than the card content.
+    if (status == sd_ok && !m_async_write) {
+        auto first_buf = m_async_buf - m_async_total * block_buffer::block_len;
+
+        for (auto &b : m_cache) {
+            if (b.valid && !b.mint
+                    && b.origin >= m_async_first
+                    && b.origin < m_async_first + m_async_total) {
+                memcpy(first_buf + (b.origin - m_async_first) * block_buffer::block_len,
+                       b.block, block_buffer::block_len);
+            }
+        }
+    }
+
+    // Busy flag is cleared before notification, so thread that
+    // is woken up by the callback can start next I/O right away.
+    auto cb = std::move(m_async_cb);
+    m_async_busy = false;
+
+    if (cb) {
+        cb(status);
+    }
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+ssize_t sd_spi< spi_dev, GPIO_CS, cache_blocks >::spi_send(const uint8_t *buf, size_t size)
 {
+    drop_window();
+
     spi_dev::set_buffers(buf, nullptr, size);
     // TODO: check error code
     spi_dev::xfer(&size, nullptr);
@@ -386,20 +1158,30 @@ ssize_t sd_spi< spi_dev, GPIO_CS >::spi_send(const uint8_t *buf, size_t size)
     return size;
 }
 
-template< class spi_dev, class GPIO_CS >
-ssize_t sd_spi< spi_dev, GPIO_CS >::spi_receive(uint8_t *buf, size_t size)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+ssize_t sd_spi< spi_dev, GPIO_CS, cache_blocks >::spi_receive(uint8_t *buf, size_t size)
 {
-    spi_dev::set_buffers(nullptr, buf, size);
-    // TODO: check error code
-    spi_dev::xfer(nullptr, &size);
+    size_t ahead = std::min(size, m_win_len - m_win_pos);
+
+    memcpy(buf, m_window + m_win_pos, ahead);
+    m_win_pos += ahead;
+
+    size_t left = size - ahead;
+    if (left) {
+        spi_dev::set_buffers(nullptr, buf + ahead, left);
+        // TODO: check error code
+        spi_dev::xfer(nullptr, &left);
+    }
 
     // TODO: verify that all data was transfered
     return size;
 }
 
-template< class spi_dev, class GPIO_CS >
-ssize_t sd_spi< spi_dev, GPIO_CS >::spi_send_dummy(size_t size)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+ssize_t sd_spi< spi_dev, GPIO_CS, cache_blocks >::spi_send_dummy(size_t size)
 {
+    drop_window();
+
     spi_dev::set_buffers(size);
     // TODO: check error code
     spi_dev::xfer(&size, nullptr);
@@ -408,8 +1190,54 @@ ssize_t sd_spi< spi_dev, GPIO_CS >::spi_send_dummy(size_t size)
     return size;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::send_init()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+ssize_t sd_spi< spi_dev, GPIO_CS, cache_blocks >::spi_transact(bus_segment *segs, size_t n)
+{
+    // Last segment is reserved for the window
+    segs[n - 1] = bus_segment{nullptr, m_window, window_len, 0xff};
+
+    spi_dev::set_buffers(segs, n);
+
+    size_t sent;
+    if (is_error(spi_dev::xfer(&sent, nullptr))) {
+        drop_window();
+        return sd_spi_err;
+    }
+
+    m_win_pos = 0;
+    m_win_len = window_len;
+
+    return sent;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::receive_byte(uint8_t &byte)
+{
+    if (m_win_pos == m_win_len) {
+        spi_dev::set_buffers(nullptr, m_window, window_len);
+
+        size_t received;
+        if (is_error(spi_dev::xfer(nullptr, &received))) {
+            drop_window();
+            return sd_spi_err;
+        }
+
+        m_win_pos = 0;
+        m_win_len = window_len;
+    }
+
+    byte = m_window[m_win_pos++];
+    return sd_ok;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+void sd_spi< spi_dev, GPIO_CS, cache_blocks >::drop_window()
+{
+    m_win_pos = m_win_len = 0;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::send_init()
 {
     /* Initialise card with >= 74 clocks on start */
     ssize_t ret = spi_send_dummy(80);
@@ -419,27 +1247,33 @@ int sd_spi< spi_dev, GPIO_CS >::send_init()
     return sd_ok;
 }
 
-template< class spi_dev, class GPIO_CS >
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
 template< typename R >
-int sd_spi< spi_dev, GPIO_CS >::send_CMD(R &resp, uint8_t CMD_idx, const argument &arg, uint8_t crc)
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::send_CMD(R &resp, uint8_t CMD_idx, const argument &arg, uint8_t crc)
 {
     ssize_t sd_ret;
 
     CMD_idx &= 0x3f; // First two bits are reserved TODO: comment
     CMD_idx |= 0x40;
 
-    crc |= 0x1; // EOT flag
+    // Comand body, preceded by a byte that inits a transaction
+    uint8_t to_send[] =
+    { 0xff, CMD_idx, arg[0], arg[1], arg[2], arg[3], crc };
 
-    // Init a transaction
-    const uint8_t dummy = 0xff;
-    sd_ret = spi_send(&dummy, 1);
+    // Card checks CRC of every command if protection is on
+    if (m_crc) {
+        to_send[6] = crc7(to_send + 1, 5) << 1;
+    }
 
-    // Comand body
-    const uint8_t to_send[] =
-    { CMD_idx, arg[0], arg[1], arg[2], arg[3], crc };
+    to_send[6] |= 0x1; // EOT flag
 
-    // Send HCS
-    sd_ret = spi_send(to_send, sizeof(to_send));
+    // Command and first bytes of a response are transferred at once
+    bus_segment segs[] = {
+        { to_send, nullptr, sizeof(to_send), 0xff },
+        { }
+    };
+
+    sd_ret = spi_transact(segs, 2);
     if (sd_ret < 0) {
         return sd_ret;
     }
@@ -455,14 +1289,14 @@ int sd_spi< spi_dev, GPIO_CS >::send_CMD(R &resp, uint8_t CMD_idx, const argumen
 
 //------------------------------------------------------------------------------
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::receive_response(R1 &r)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::receive_response(R1 &r)
 {
     uint8_t tries = 8;
     int ret;
 
     do {
-        ret = spi_receive(&r.response, 1);
+        ret = receive_byte(r.response);
         if (ret < 0)
             return ret;
 
@@ -493,8 +1327,8 @@ int sd_spi< spi_dev, GPIO_CS >::receive_response(R1 &r)
     return sd_err;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::receive_response(R3 &r)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::receive_response(R3 &r)
 {
     int SD_ret = receive_response(r.r1);
     if (SD_ret < 0)
@@ -503,12 +1337,9 @@ int sd_spi< spi_dev, GPIO_CS >::receive_response(R3 &r)
     return spi_receive((uint8_t *)&r.OCR, sizeof(r.OCR));
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::receive_data(uint8_t *buf, size_t size)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::receive_data(uint8_t *buf, size_t size)
 {
-    // Data token that returned in case of success
-    static constexpr uint8_t data_token    = 0xfe;
-
     // Flags that can be found in error token
     static constexpr uint8_t err           = 0x01;
     static constexpr uint8_t CC_err        = 0x02;
@@ -517,12 +1348,12 @@ int sd_spi< spi_dev, GPIO_CS >::receive_data(uint8_t *buf, size_t size)
     static constexpr uint8_t card_locked   = 0x10;
 
     uint8_t  token = 0;
-    uint16_t crc;
+    uint8_t  crc[2];
     uint8_t  tries = 64;
     int      SD_ret;
 
     do {
-        SD_ret = spi_receive(&token, sizeof(token));
+        SD_ret = receive_byte(token);
         if (SD_ret < 0)
             return SD_ret;
     } while (token == 0xff && --tries);
@@ -557,80 +1388,176 @@ int sd_spi< spi_dev, GPIO_CS >::receive_data(uint8_t *buf, size_t size)
             ecl::cout << "Card locked" << ecl::endl;
         }
 
-        return sd_err;
+        return sd_err;
+    }
+
+    if ((SD_ret = spi_receive(crc, sizeof(crc))) < 0) {
+        return SD_ret;
+    }
+
+    // CRC is transmitted MSB first
+    if (m_crc && crc16(buf, size) != ((crc[0] << 8) | crc[1])) {
+        ecl::cout << "Data CRC mismatch" << ecl::endl;
+        return sd_crc_err;
+    }
+
+    return SD_ret;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::send_data(const uint8_t *buf, size_t size, uint8_t token)
+{
+    // Two bits indicating data response
+    static constexpr uint8_t mask          = 0x11;
+    // Flags that can be found in data response
+    static constexpr uint8_t accepted      = 0x05;
+    static constexpr uint8_t crc_err       = 0x0b;
+    static constexpr uint8_t write_err     = 0x0d;
+
+    uint8_t  crc[2] = { 0xff, 0xff };
+    uint8_t  data_response = 0;
+    uint8_t  tries = 32;
+    int      sd_ret;
+
+    // CRC is ignored by the card unless protection is on
+    if (m_crc) {
+        uint16_t val = crc16(buf, size);
+        crc[0] = val >> 8;
+        crc[1] = val;
+    }
+
+    // Token, data itself and CRC, followed by a data response window
+    bus_segment segs[] = {
+        { &token, nullptr, sizeof(token), 0xff },
+        { buf, nullptr, size, 0xff },
+        { crc, nullptr, sizeof(crc), 0xff },
+        { }
+    };
+
+    if ((sd_ret = spi_transact(segs, 4)) < 0) {
+        return sd_ret;
+    }
+
+    // Wait for data response
+    do {
+        sd_ret = receive_byte(data_response);
+        if (sd_ret < 0)
+            return sd_ret;
+    } while (((data_response & mask) != 0x1) && --tries);
+
+    // No error occur, only 4 lower bits matters
+    if ((data_response & 0x0f) == accepted) {
+        return wait_busy();
+    }
+
+    ecl::cout << "Error in data response " << data_response << ecl::endl;
+    if (data_response & crc_err) {
+        ecl::cout << "CRC error occurs" << ecl::endl;
+    }
+    if (data_response & write_err) {
+        ecl::cout << "Write error" << ecl::endl;
+    }
+
+    return sd_err;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::wait_busy()
+{
+    // Card programs flash while busy, this is where writes spend time
+    ECL_TRACE_SCOPE("sd.wait_busy");
+
+    uint8_t  busy;
+    int      sd_ret;
+
+    // Card holds data line low while it is busy. Short busy periods
+    // end within the response window.
+    while (m_win_pos < m_win_len) {
+        if (m_window[m_win_pos++]) {
+            return sd_ok;
+        }
+    }
+
+    sd_ret = scan_busy();
+    if (sd_ret != sd_notsup) {
+        return sd_ret;
     }
 
-    return spi_receive((uint8_t *)&crc, sizeof(crc));
+    // Bus can't stream, so it is polled with regular xfers
+    do {
+        sd_ret = receive_byte(busy);
+        if (sd_ret < 0)
+            return sd_ret;
+    } while (busy == 0x0);
+
+    return sd_ok;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::send_data(const uint8_t *buf, size_t size)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::scan_busy()
 {
-    // Data token that must be sent before data chunk
-    static constexpr uint8_t data_token    = 0xfe;
-
-    // Two bits indicating data response
-    static constexpr uint8_t mask          = 0x11;
-    // Flags that can be found in data response
-    static constexpr uint8_t accepted      = 0x05;
-    static constexpr uint8_t crc_err       = 0x0b;
-    static constexpr uint8_t write_err     = 0x0d;
+    auto handler = [this](bus_channel ch, bus_event type, size_t total) {
+        (void) total;
+        this->scan_handler(ch, type);
+    };
 
-    static constexpr uint8_t crc           = 0x0;
+    m_scan_status = scan_pending;
+    m_scan_done.try_wait();
 
-    uint8_t  data_response = 0;
-    uint8_t  tries = 32;
-    int      sd_ret;
+    auto rc = spi_dev::set_double_buffers(nullptr, nullptr, m_scan[0], m_scan[1], scan_len);
 
-    // Token
-    if ((sd_ret = spi_send(&data_token, sizeof(data_token))) < 0) {
-        return sd_ret;
+    if (is_ok(rc)) {
+        rc = spi_dev::stream(handler);
     }
 
-    // Data itself
-    if ((sd_ret = spi_send(buf, size)) < 0) {
-        return sd_ret;
+    if (rc == err::notsup) {
+        return sd_notsup;
+    } else if (is_error(rc)) {
+        return sd_spi_err;
     }
 
-    // Dummy CRC
-    if ((sd_ret = spi_send(&crc, sizeof(crc))) < 0) {
-        return sd_ret;
-    }
+    m_scan_done.wait();
 
-    // Wait for data response
-    do {
-        sd_ret = spi_receive(&data_response, sizeof(data_response));
-        if (sd_ret < 0)
-            return sd_ret;
-    } while (((data_response & mask) != 0x1) && --tries);
+    // Bytes clocked after release are dummy, nothing is lost here.
+    // Rest of the window, filled before, is stale by now.
+    spi_dev::stop();
+    drop_window();
 
-    // No error occur, only 4 lower bits matters
-    if ((data_response & 0x0f) == accepted) {
-        // Wait till card is busy
-        do {
-            sd_ret = spi_receive(&data_response, sizeof(data_response));
-            if (sd_ret < 0)
-                return sd_ret;
-        } while (data_response == 0x0);
+    return m_scan_status;
+}
 
-        return sd_ok;
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+void sd_spi< spi_dev, GPIO_CS, cache_blocks >::scan_handler(bus_channel ch, bus_event type)
+{
+    // Status is reported once, events that came before stop() are dropped
+    if (m_scan_status != scan_pending) {
+        return;
     }
 
-    ecl::cout << "Error in data response " << data_response << ecl::endl;
-    if (data_response & crc_err) {
-        ecl::cout << "CRC error occurs" << ecl::endl;
+    if (type == bus_event::err) {
+        m_scan_status = sd_spi_err;
+        m_scan_done.signal();
+        return;
     }
-    if (data_response & write_err) {
-        ecl::cout << "Write error" << ecl::endl;
+
+    if (ch != bus_channel::rx) {
+        return;
     }
 
-    return sd_err;
+    // Data line stays high, once card releases it, so last byte of
+    // the completed half is enough to check
+    const uint8_t *half = (type == bus_event::ht) ? m_scan[0] : m_scan[1];
+
+    if (half[scan_len - 1]) {
+        m_scan_status = sd_ok;
+        m_scan_done.signal();
+    }
 }
 
 //------------------------------------------------------------------------------
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::CMD0(R1 &r)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD0(R1 &r)
 {
     // TODO: comments
     constexpr uint8_t  CMD0_idx = 0;
@@ -639,8 +1566,8 @@ int sd_spi< spi_dev, GPIO_CS >::CMD0(R1 &r)
     return send_CMD(r, CMD0_idx, arg, CMD0_crc);
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::CMD8(R7 &r)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD8(R7 &r)
 {
     // TODO: comments
     constexpr uint8_t   CMD8_idx = 8;
@@ -649,8 +1576,16 @@ int sd_spi< spi_dev, GPIO_CS >::CMD8(R7 &r)
     return send_CMD(r, CMD8_idx, arg, CMD8_crc);
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::CMD10(R1 &r)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD9(R1 &r)
+{
+    constexpr uint8_t   CMD9_idx   = 9;
+    constexpr argument  arg        = { 0 };
+    return send_CMD(r, CMD9_idx, arg);
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD10(R1 &r)
 {
     // TODO: comments
     constexpr uint8_t   CMD10_idx  = 10;
@@ -659,8 +1594,42 @@ int sd_spi< spi_dev, GPIO_CS >::CMD10(R1 &r)
 
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::CMD16(R1 &r)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD12(R1 &r)
+{
+    constexpr uint8_t  CMD12_idx = 12;
+    constexpr uint8_t  CMD12_crc = 0x61;
+    constexpr argument arg       = { 0, 0, 0, 0 };
+    const uint8_t to_send[] =
+    { CMD12_idx | 0x40, arg[0], arg[1], arg[2], arg[3], CMD12_crc };
+
+    uint8_t  stuff;
+    int      SD_ret;
+
+    bus_segment segs[] = {
+        { to_send, nullptr, sizeof(to_send), 0xff },
+        { }
+    };
+
+    if ((SD_ret = spi_transact(segs, 2)) < 0) {
+        return SD_ret;
+    }
+
+    // Card is still streaming when command is received.
+    // Skip the stuff byte that follows the command.
+    if ((SD_ret = receive_byte(stuff)) < 0) {
+        return SD_ret;
+    }
+
+    if ((SD_ret = receive_response(r)) < 0) {
+        return SD_ret;
+    }
+
+    return wait_busy();
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD16(R1 &r)
 {
     // TODO: comments
     constexpr uint8_t  CMD16_idx = 16;
@@ -674,8 +1643,8 @@ int sd_spi< spi_dev, GPIO_CS >::CMD16(R1 &r)
     return send_CMD(r, CMD16_idx, arg);
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::CMD17(R1 &r, uint32_t address)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD17(R1 &r, uint32_t address)
 {
     // TODO: comments
     constexpr uint8_t CMD17_idx = 17;
@@ -688,8 +1657,21 @@ int sd_spi< spi_dev, GPIO_CS >::CMD17(R1 &r, uint32_t address)
     return send_CMD(r, CMD17_idx, arg);
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::CMD24(R1 &r, uint32_t address)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD18(R1 &r, uint32_t address)
+{
+    constexpr uint8_t CMD18_idx = 18;
+    const argument arg = {
+        (uint8_t) (address >> 24),
+        (uint8_t) (address >> 16),
+        (uint8_t) (address >> 8),
+        (uint8_t) (address),
+    };
+    return send_CMD(r, CMD18_idx, arg);
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD24(R1 &r, uint32_t address)
 {
     constexpr uint8_t CMD24_idx = 24;
     const argument arg = {
@@ -701,8 +1683,62 @@ int sd_spi< spi_dev, GPIO_CS >::CMD24(R1 &r, uint32_t address)
     return send_CMD(r, CMD24_idx, arg);
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::CMD55(R1 &r)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD25(R1 &r, uint32_t address)
+{
+    constexpr uint8_t CMD25_idx = 25;
+    const argument arg = {
+        (uint8_t) (address >> 24),
+        (uint8_t) (address >> 16),
+        (uint8_t) (address >> 8),
+        (uint8_t) (address),
+    };
+    return send_CMD(r, CMD25_idx, arg);
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD32(R1 &r, uint32_t address)
+{
+    constexpr uint8_t CMD32_idx = 32;
+    const argument arg = {
+        (uint8_t) (address >> 24),
+        (uint8_t) (address >> 16),
+        (uint8_t) (address >> 8),
+        (uint8_t) (address),
+    };
+    return send_CMD(r, CMD32_idx, arg);
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD33(R1 &r, uint32_t address)
+{
+    constexpr uint8_t CMD33_idx = 33;
+    const argument arg = {
+        (uint8_t) (address >> 24),
+        (uint8_t) (address >> 16),
+        (uint8_t) (address >> 8),
+        (uint8_t) (address),
+    };
+    return send_CMD(r, CMD33_idx, arg);
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD38(R1 &r)
+{
+    constexpr uint8_t  CMD38_idx = 38;
+    constexpr argument arg       = { 0, 0, 0, 0 };
+
+    int SD_ret = send_CMD(r, CMD38_idx, arg);
+    if (SD_ret < 0) {
+        return SD_ret;
+    }
+
+    // Erase may take a while, card is busy until it is done
+    return wait_busy();
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD55(R1 &r)
 {
     // TODO: comments
     constexpr uint8_t CMD55_idx = 55;
@@ -710,8 +1746,8 @@ int sd_spi< spi_dev, GPIO_CS >::CMD55(R1 &r)
     return send_CMD(r, CMD55_idx, arg);
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::CMD58(R3 &r)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD58(R3 &r)
 {
     // TODO: comments
     constexpr uint8_t CMD58_idx = 58;
@@ -719,8 +1755,16 @@ int sd_spi< spi_dev, GPIO_CS >::CMD58(R3 &r)
     return send_CMD(r, CMD58_idx, arg);
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::ACMD41(R1 &r, bool HCS)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::CMD59(R1 &r, bool enable)
+{
+    constexpr uint8_t CMD59_idx = 59;
+    const argument arg          = { 0, 0, 0, static_cast< uint8_t >(enable) };
+    return send_CMD(r, CMD59_idx, arg);
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::ACMD41(R1 &r, bool HCS)
 {
     const uint8_t HCS_byte = HCS ? (1 << 6) : 0;
 
@@ -734,10 +1778,28 @@ int sd_spi< spi_dev, GPIO_CS >::ACMD41(R1 &r, bool HCS)
     return send_CMD(r, CMD41_idx, arg);
 }
 
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::ACMD23(R1 &r, uint32_t block_count)
+{
+    int SD_ret = CMD55(r);
+    if (SD_ret < 0)
+        return SD_ret;
+
+    // Only 23 bits of the argument are meaningful
+    constexpr uint8_t  CMD23_idx  = 23;
+    const argument     arg        = {
+        (uint8_t) ((block_count >> 24) & 0x7f),
+        (uint8_t) (block_count >> 16),
+        (uint8_t) (block_count >> 8),
+        (uint8_t) (block_count),
+    };
+    return send_CMD(r, CMD23_idx, arg);
+}
+
 //------------------------------------------------------------------------------
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::open_card()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::open_card()
 {
     int SD_ret;
     if ((SD_ret = software_reset()) < 0) {
@@ -778,15 +1840,25 @@ int sd_spi< spi_dev, GPIO_CS >::open_card()
         return SD_ret;
     }
 
-    if ((SD_ret = populate_block(m_offt)) < 0) {
-        ecl::cout << "Cannot populate initial block" << ecl::endl;
+    if ((SD_ret = obtain_capacity()) < 0) {
+        ecl::cout << "Failed to obtain card capacity" << ecl::endl;
+        return SD_ret;
+    }
+
+    // Card is reset to CRC-off state, restore the setting
+    if (m_crc) {
+        R1 r1;
+        if ((SD_ret = CMD59(r1, true)) < 0 || !r1.ok()) {
+            ecl::cout << "Failed to enable CRC" << ecl::endl;
+            return sd_err;
+        }
     }
 
     return SD_ret;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::software_reset()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::software_reset()
 {
     R1 r1;
 
@@ -802,8 +1874,8 @@ int sd_spi< spi_dev, GPIO_CS >::software_reset()
     return sd_err;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::check_conditions()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::check_conditions()
 {
     R7 r7;
 
@@ -830,8 +1902,8 @@ int sd_spi< spi_dev, GPIO_CS >::check_conditions()
     return sd_err;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::init_process()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::init_process()
 {
     //TODO: comments
     R1 r1;
@@ -856,8 +1928,8 @@ int sd_spi< spi_dev, GPIO_CS >::init_process()
     return sd_ok;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::check_OCR()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::check_OCR()
 {
     R3 r3;
     CMD58(r3);
@@ -898,8 +1970,8 @@ int sd_spi< spi_dev, GPIO_CS >::check_OCR()
     return sd_err;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::obtain_card_info()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::obtain_card_info()
 {
     R1  r1;
     int SD_ret;
@@ -936,8 +2008,50 @@ int sd_spi< spi_dev, GPIO_CS >::obtain_card_info()
     return sd_ok;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::set_block_length()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::obtain_capacity()
+{
+    R1  r1;
+    int SD_ret;
+    uint8_t csd[16];
+
+    if ((SD_ret = CMD9(r1)) < 0) {
+        return SD_ret;
+    }
+
+    if ((SD_ret = receive_data(csd, sizeof(csd))) < 0) {
+        return SD_ret;
+    }
+
+    // CSD layout depends on its version
+    switch (csd[0] >> 6) {
+    case 0: {
+        // Capacity is (C_SIZE + 1) * 2^(C_SIZE_MULT + 2) * 2^READ_BL_LEN
+        uint8_t  read_bl_len = csd[5] & 0xf;
+        uint32_t c_size      = ((csd[6] & 0x3) << 10) | (csd[7] << 2) | (csd[8] >> 6);
+        uint8_t  c_size_mult = ((csd[9] & 0x3) << 1) | (csd[10] >> 7);
+
+        m_blocks = (c_size + 1) << (c_size_mult + 2 + read_bl_len - 9);
+        break;
+    }
+    case 1: {
+        // Capacity is (C_SIZE + 1) * 512 KiB
+        uint32_t c_size = ((csd[7] & 0x3f) << 16) | (csd[8] << 8) | csd[9];
+
+        m_blocks = static_cast< size_t >(c_size + 1) * 1024;
+        break;
+    }
+    default:
+        ecl::cout << "Unknown CSD structure" << ecl::endl;
+        return sd_err;
+    }
+
+    ecl::cout << "Blocks:                " << m_blocks << ecl::endl;
+    return sd_ok;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::set_block_length()
 {
     R1 r1;
 
@@ -954,51 +2068,295 @@ int sd_spi< spi_dev, GPIO_CS >::set_block_length()
 }
 
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::populate_block(size_t new_block)
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+typename sd_spi< spi_dev, GPIO_CS, cache_blocks >::block_buffer *
+sd_spi< spi_dev, GPIO_CS, cache_blocks >::lookup_block(size_t blk_num)
+{
+    for (auto &b : m_cache) {
+        if (b.valid && b.origin == blk_num) {
+            b.used = ++m_clock;
+            return &b;
+        }
+    }
+
+    return nullptr;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+typename sd_spi< spi_dev, GPIO_CS, cache_blocks >::block_buffer &
+sd_spi< spi_dev, GPIO_CS, cache_blocks >::pick_victim()
+{
+    // Free entry is used first, then least recently used one
+    auto victim = &m_cache[0];
+    for (auto &b : m_cache) {
+        if (!b.valid) {
+            return b;
+        }
+
+        if (b.used < victim->used) {
+            victim = &b;
+        }
+    }
+
+    return *victim;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+void sd_spi< spi_dev, GPIO_CS, cache_blocks >::prefetch(size_t blk_num)
+{
+    // Single entry is always occupied by the block that is being read
+    if (cache_blocks < 2 || m_async_busy || lookup_block(blk_num)) {
+        return;
+    }
+
+    auto &victim = pick_victim();
+
+    // Read-ahead must not delay a reader with a write
+    if (victim.valid && !victim.mint) {
+        return;
+    }
+
+    victim.valid  = false;
+    victim.origin = blk_num;
+    victim.used   = ++m_clock;
+
+    m_prefetch   = &victim;
+    m_prefetched = false;
+
+    auto done = [this](int status) {
+        this->m_prefetch->valid = (status == sd_ok);
+        this->m_prefetched = true;
+    };
+
+    if (start_async(blk_num, victim.block, 1, done, false) < 0) {
+        m_prefetch = nullptr;
+    }
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+void sd_spi< spi_dev, GPIO_CS, cache_blocks >::prefetch_wait()
+{
+    if (!m_prefetch) {
+        return;
+    }
+
+    // Bus is locked only when async xfer sequence is finished
+    if (!m_prefetched) {
+        spi_dev::lock(sd_data_clk);
+        spi_dev::unlock();
+    }
+
+    m_prefetch = nullptr;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::populate_block(size_t new_block)
 {
     R1 r1;
-    off_t address = m_HC ? new_block : new_block * block_buffer::block_len;
-    int SD_ret = flush_block();
+    uint32_t address = m_HC ? new_block : new_block * block_buffer::block_len;
+    auto victim = &pick_victim();
+
+    int SD_ret = flush_block(*victim);
+    if (SD_ret < 0) {
+        return SD_ret;
+    }
+
+    // Entry content is undefined until block is read
+    victim->valid = false;
+    m_block = nullptr;
 
     if ((SD_ret = CMD17(r1, address)) < 0) {
         return SD_ret;
     }
 
-    if ((SD_ret = receive_data(m_block.block, block_buffer::block_len)) < 0) {
+    if ((SD_ret = receive_data(victim->block, block_buffer::block_len)) < 0) {
         return SD_ret;
     }
 
-    m_block.origin = new_block;
+    victim->origin = new_block;
+    victim->valid  = true;
+    victim->used   = ++m_clock;
+    m_block = victim;
+
     return SD_ret;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::flush_block()
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::flush_block(block_buffer &buf)
 {
     int SD_ret;
     R1 r1;
 
-    if (m_block.mint) {
+    if (!buf.valid || buf.mint) {
         return sd_ok;
     }
 
-    off_t address = m_HC ? m_block.origin : m_block.origin * block_buffer::block_len;
+    uint32_t address = m_HC ? buf.origin : buf.origin * block_buffer::block_len;
 
     if ((SD_ret = CMD24(r1, address)) < 0) {
         return SD_ret;
     }
 
-    if ((SD_ret = send_data(m_block.block, block_buffer::block_len)) < 0) {
+    if ((SD_ret = send_data(buf.block, block_buffer::block_len)) < 0) {
+        return SD_ret;
+    }
+
+    buf.mint = true;
+    return SD_ret;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::flush_cache()
+{
+    int SD_ret = sd_ok;
+
+    // Writes are issued in block order, which is friendlier to the card
+    block_buffer *next;
+    size_t last = 0;
+    bool first = true;
+
+    do {
+        next = nullptr;
+
+        for (auto &b : m_cache) {
+            if (b.valid && !b.mint && (first || b.origin > last)
+                    && (!next || b.origin < next->origin)) {
+                next = &b;
+            }
+        }
+
+        if (next) {
+            // Proceed with others, but report an error.
+            // Failed block remains dirty.
+            int rc = flush_block(*next);
+            if (rc < 0) {
+                SD_ret = rc;
+            }
+
+            last = next->origin;
+            first = false;
+        }
+    } while (next);
+
+    return SD_ret;
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::read_direct(size_t first_block, uint8_t *buf, size_t blocks)
+{
+    R1 r1;
+    uint32_t address = m_HC ? first_block : first_block * block_buffer::block_len;
+    int SD_ret;
+
+    // Data goes from card directly to the user buffer, without
+    // bouncing through the block cache.
+    // Single block doesn't worth a stop command
+    if (blocks == 1) {
+        if ((SD_ret = CMD17(r1, address)) < 0) {
+            return SD_ret;
+        }
+
+        SD_ret = receive_data(buf, block_buffer::block_len);
+    } else {
+        if ((SD_ret = CMD18(r1, address)) < 0) {
+            return SD_ret;
+        }
+
+        // Each block comes with its own data token and CRC
+        for (size_t i = 0; i < blocks; ++i) {
+            SD_ret = receive_data(buf + i * block_buffer::block_len,
+                                  block_buffer::block_len);
+            if (SD_ret < 0) {
+                break;
+            }
+        }
+
+        // Transmission must be stopped even if error occurs
+        int stop_ret = CMD12(r1);
+        if (SD_ret >= 0) {
+            SD_ret = stop_ret;
+        }
+    }
+
+    if (SD_ret < 0) {
         return SD_ret;
     }
 
-    m_block.mint = true;
+    // Cached blocks may be modified and not yet written. These are more recent
+    // than the card content, so they are copied over, rather than flushed.
+    for (auto &b : m_cache) {
+        if (b.valid && !b.mint
+                && b.origin >= first_block
+                && b.origin < first_block + blocks) {
+            memcpy(buf + (b.origin - first_block) * block_buffer::block_len,
+                   b.block, block_buffer::block_len);
+        }
+    }
+
     return SD_ret;
 }
 
-template< class spi_dev, class GPIO_CS >
-int sd_spi< spi_dev, GPIO_CS >::traverse_data(
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::write_direct(size_t first_block, const uint8_t *buf, size_t blocks)
+{
+    R1 r1;
+    uint32_t address = m_HC ? first_block : first_block * block_buffer::block_len;
+    int SD_ret;
+
+    // Cached blocks will be overwritten, so they are updated instead of flushing
+    for (auto &b : m_cache) {
+        if (b.valid && b.origin >= first_block && b.origin < first_block + blocks) {
+            memcpy(b.block,
+                   buf + (b.origin - first_block) * block_buffer::block_len,
+                   block_buffer::block_len);
+            b.mint = true;
+        }
+    }
+
+    if (blocks == 1) {
+        if ((SD_ret = CMD24(r1, address)) < 0) {
+            return SD_ret;
+        }
+
+        return send_data(buf, block_buffer::block_len);
+    }
+
+    // Pre-erase hint lets card prepare whole area at once.
+    // It is not mandatory, so failure is not fatal.
+    ACMD23(r1, blocks);
+
+    if ((SD_ret = CMD25(r1, address)) < 0) {
+        return SD_ret;
+    }
+
+    for (size_t i = 0; i < blocks; ++i) {
+        SD_ret = send_data(buf + i * block_buffer::block_len,
+                           block_buffer::block_len, data_token_multi);
+        if (SD_ret < 0) {
+            break;
+        }
+    }
+
+    // Transmission must be stopped even if error occurs.
+    // A byte before busy signal appears is skipped.
+    const uint8_t stop = stop_tran_token;
+    bus_segment segs[] = {
+        { &stop, nullptr, sizeof(stop), 0xff },
+        { nullptr, nullptr, 1, 0xff },
+        { }
+    };
+
+    int stop_ret = spi_transact(segs, 3);
+
+    if (stop_ret >= 0) {
+        stop_ret = wait_busy();
+    }
+
+    return (SD_ret < 0) ? SD_ret : ((stop_ret < 0) ? stop_ret : sd_ok);
+}
+
+template< class spi_dev, class GPIO_CS, size_t cache_blocks >
+int sd_spi< spi_dev, GPIO_CS, cache_blocks >::traverse_data(
         size_t count,
         const std::function< void (size_t, size_t, size_t) > &fn
         )
@@ -1006,15 +2364,16 @@ int sd_spi< spi_dev, GPIO_CS >::traverse_data(
     size_t left = count;
     int SD_ret = sd_ok;
 
-    // Intended to be optimized in right shift, sinse
-    // block length is constant and a power of two
-    size_t blk_num = m_offt / block_buffer::block_len;
-    size_t blk_offt = m_offt - blk_num  * block_buffer::block_len;
+    // Position is advanced only if whole request succeeds
+    size_t blk_num = m_blk;
+    size_t blk_offt = m_blk_offt;
     size_t data_offt = 0;
 
     while (left) {
-        if (blk_num  != m_block.origin) {
-            spi_dev::lock();
+        // Cache hit doesn't require a bus
+        m_block = lookup_block(blk_num);
+        if (!m_block) {
+            spi_dev::lock(sd_data_clk);
             GPIO_CS::reset();
             SD_ret = populate_block(blk_num);
             GPIO_CS::set();
@@ -1031,14 +2390,17 @@ int sd_spi< spi_dev, GPIO_CS >::traverse_data(
         // Advance to next free chunk
         data_offt += to_copy;
         left -= to_copy;
+        blk_offt += to_copy;
 
-        // If needed, next iteration will populate buffer again
-        blk_num ++;
-        // Next copy will occur within a new block
-        blk_offt  = 0;
+        // Block is passed, next iteration will populate buffer again
+        if (blk_offt == block_buffer::block_len) {
+            blk_num ++;
+            blk_offt = 0;
+        }
     }
 
-    m_offt += count;
+    m_blk = blk_num;
+    m_blk_offt = blk_offt;
 
     return SD_ret;
 }
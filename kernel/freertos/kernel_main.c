@@ -3,8 +3,17 @@
 
 #include <ecl/assert.h>
 
+#include <string.h>
+
 extern int main();
 
+// Kernel runs tasks on more than one core
+#if defined(configNUMBER_OF_CORES) && configNUMBER_OF_CORES > 1
+#define KERNEL_SMP 1
+#else
+#define KERNEL_SMP 0
+#endif
+
 // Somehow linker drops this function if LTO is enabled
 __attribute__((used))
 void vTaskSwitchContext( void );
@@ -33,6 +42,219 @@ void vAssertCalled(const char *file, int line)
     for(;;);
 }
 
+#if INCLUDE_xTaskGetCurrentTaskHandle
+// Gives name of the faulting thread to the crash record, see platform/crash.hpp
+void ecl_fault_thread(char *name, size_t size)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+
+    if (task) {
+        strncpy(name, pcTaskGetTaskName(task), size);
+    }
+}
+#endif
+
+// Amount of pending transactions, that keep MCU from sleeping.
+// See kernel_sleep_inhibit() and kernel_sleep_allow().
+static volatile uint32_t sleep_locks;
+
+// Can be called from ISR
+void kernel_sleep_inhibit(void)
+{
+    __atomic_add_fetch(&sleep_locks, 1, __ATOMIC_SEQ_CST);
+}
+
+// Can be called from ISR
+void kernel_sleep_allow(void)
+{
+    __atomic_sub_fetch(&sleep_locks, 1, __ATOMIC_SEQ_CST);
+}
+
+#if configUSE_TICKLESS_IDLE
+
+#ifndef configSYSTICK_CLOCK_HZ
+#define configSYSTICK_CLOCK_HZ configCPU_CLOCK_HZ
+#endif
+
+// SysTick registers, used by the port to account suppressed ticks
+#define SYST_RVR        (*(volatile uint32_t *) 0xe000e014)
+#define SYST_CVR        (*(volatile uint32_t *) 0xe000e018)
+
+// Lets platform put MCU into a deeper mode than sleep, i.e. stop mode,
+// see platform/power.hpp. Returns time spent there in microseconds,
+// or zero if MCU is left to sleep as usual.
+__attribute__((weak)) uint32_t kernel_deep_sleep(uint32_t idle_us)
+{
+    (void)idle_us;
+    return 0;
+}
+
+// Called by idle task right before MCU goes to sleep with tick suppressed.
+// FreeRTOSConfig.h must route configPRE_SLEEP_PROCESSING(x) here,
+// see CONFIG_FREERTOS_TICKLESS_IDLE.
+void kernel_pre_sleep(TickType_t *idle_ticks)
+{
+    const uint32_t counts_per_tick = configSYSTICK_CLOCK_HZ / configTICK_RATE_HZ;
+    const uint32_t us_per_tick = 1000000 / configTICK_RATE_HZ;
+
+    // DMA or bus transaction is pending. Its interrupt is expected soon,
+    // so skip this sleep. Idle task will try again once it is done.
+    if (__atomic_load_n(&sleep_locks, __ATOMIC_SEQ_CST)) {
+        *idle_ticks = 0;
+        return;
+    }
+
+    TickType_t expected = *idle_ticks;
+
+    if (expected < 2) {
+        return;
+    }
+
+    // Platform wakes up a tick before the timeout, so the port still
+    // finds SysTick running below its reload value
+    uint32_t slept_us = kernel_deep_sleep((expected - 1) * us_per_tick);
+
+    if (!slept_us) {
+        return;
+    }
+
+    TickType_t slept = slept_us / us_per_tick;
+
+    if (slept > expected - 1) {
+        slept = expected - 1;
+    }
+
+    // SysTick was halted along with the core. Port derives completed
+    // ticks from the counter, so reload it as if the slept ticks passed.
+    // Writing the counter clears it, next SysTick clock reloads it.
+    SYST_RVR = (expected - slept) * counts_per_tick - 1;
+    SYST_CVR = 0;
+
+    *idle_ticks = 0;
+}
+
+#endif // configUSE_TICKLESS_IDLE
+
+#if configGENERATE_RUN_TIME_STATS
+
+#if KERNEL_SMP
+// Each core has its own cycle counter, so counter of one core can't be
+// extended by readings of another. Port must provide a timer, shared
+// by all cores, via portGET_RUN_TIME_COUNTER_VALUE().
+#error "Cycle counter based run time stats are not supported on SMP kernels"
+#endif
+
+// Cortex-M debug registers, giving access to the cycle counter
+#define DEMCR           (*(volatile uint32_t *) 0xe000edfc)
+#define DEMCR_TRCENA    (1u << 24)
+#define DWT_CTRL        (*(volatile uint32_t *) 0xe0001000)
+#define DWT_CYCCNTENA   (1u << 0)
+#define DWT_CYCCNT      (*(volatile uint32_t *) 0xe0001004)
+
+// Run time resolution, in cycles, as a power of two.
+// Raw counter wraps in seconds, scaled one lasts much longer.
+#define STATS_CYCLES_SHIFT 6
+
+static uint32_t stats_last_cycles;
+static uint64_t stats_cycles;
+
+// Called by kernel once, when scheduler starts
+void kernel_stats_timer_init(void)
+{
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CYCCNTENA;
+}
+
+// Called by kernel on every context switch and on stats queries
+uint32_t kernel_stats_counter(void)
+{
+    // Can be preempted by context switch while updating the counter
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+
+    // Extend counter to 64 bits. Switches, tick interrupts among them,
+    // come much more often than the counter wraps.
+    uint32_t now = DWT_CYCCNT;
+    stats_cycles += now - stats_last_cycles;
+    stats_last_cycles = now;
+
+    uint32_t ret = (uint32_t) (stats_cycles >> STATS_CYCLES_SHIFT);
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+    return ret;
+}
+
+#endif // configGENERATE_RUN_TIME_STATS
+
+#ifdef KERNEL_STACK_GUARD_SIZE
+
+#if KERNEL_STACK_GUARD_SIZE < 32 || (KERNEL_STACK_GUARD_SIZE & (KERNEL_STACK_GUARD_SIZE - 1))
+#error "Stack guard size must be a power of two, 32 bytes at least"
+#endif
+
+// Second method reads the stack bottom, that is guarded
+#if configCHECK_FOR_STACK_OVERFLOW > 1
+#error "Stack guard requires configCHECK_FOR_STACK_OVERFLOW to be 0 or 1"
+#endif
+
+// Cortex-M MPU and fault control registers, see PM0214 section 4.5
+#define SHCSR               (*(volatile uint32_t *) 0xe000ed24)
+#define SHCSR_MEMFAULTENA   (1u << 16)
+#define MPU_CTRL            (*(volatile uint32_t *) 0xe000ed94)
+#define MPU_CTRL_ENABLE     (1u << 0)
+#define MPU_CTRL_PRIVDEFENA (1u << 2)
+#define MPU_RNR             (*(volatile uint32_t *) 0xe000ed98)
+#define MPU_RBAR            (*(volatile uint32_t *) 0xe000ed9c)
+#define MPU_RBAR_VALID      (1u << 4)
+#define MPU_RASR            (*(volatile uint32_t *) 0xe000eda0)
+#define MPU_RASR_ENABLE     (1u << 0)
+#define MPU_RASR_XN         (1u << 28)
+
+// Highest region takes precedence, if regions overlap
+#define STACK_GUARD_REGION  7
+
+// No access, no execution. Region size is 2^(SIZE + 1) bytes.
+#define STACK_GUARD_RASR \
+    (MPU_RASR_XN | ((__builtin_ctz(KERNEL_STACK_GUARD_SIZE) - 1) << 1) | MPU_RASR_ENABLE)
+
+// Called once, before scheduler starts
+static void kernel_stack_guard_init(void)
+{
+    // Until a thread is switched in, there is no region at all.
+    // Memory map is kept as is for privileged code, i.e. for threads.
+    MPU_RNR = STACK_GUARD_REGION;
+    MPU_RASR = 0;
+    MPU_CTRL = MPU_CTRL_PRIVDEFENA | MPU_CTRL_ENABLE;
+
+    // Violations are reported as MemManage faults, not escalated to HardFault
+    SHCSR |= SHCSR_MEMFAULTENA;
+
+    __asm volatile ("dsb\n\tisb" ::: "memory");
+}
+
+// Called by kernel on every context switch, see stack_guard.h.
+// Runs in PendSV, return from it makes new region effective.
+void kernel_stack_guard(void *stack)
+{
+    // Region must be aligned by its size, it is placed within the stack
+    uintptr_t base = ((uintptr_t) stack + KERNEL_STACK_GUARD_SIZE - 1)
+            & ~(uintptr_t) (KERNEL_STACK_GUARD_SIZE - 1);
+
+    MPU_RBAR = base | MPU_RBAR_VALID | STACK_GUARD_REGION;
+    MPU_RASR = STACK_GUARD_RASR;
+}
+
+#else
+
+#define KERNEL_STACK_GUARD_OVERHEAD 0
+
+#endif // KERNEL_STACK_GUARD_SIZE
+
+// Stack bytes and words, given to kernel threads in addition to their
+// configured stack, so the guard doesn't eat it.
+#define STACK_GUARD_WORDS   (KERNEL_STACK_GUARD_OVERHEAD / sizeof(StackType_t))
+#define MAIN_STACK_BYTES    (MAIN_STACK_SIZE + KERNEL_STACK_GUARD_OVERHEAD)
+
 // FreeRTOS doesn't require special init procedure
 void kernel_init()
 {
@@ -49,14 +271,97 @@ void freertos_main_runner(void *arg)
     for(;;);
 }
 
+#if configSUPPORT_STATIC_ALLOCATION
+
+// Main thread doesn't need heap if kernel supports static allocation
+static StaticTask_t main_tcb;
+static StackType_t  main_stack[MAIN_STACK_BYTES / sizeof(StackType_t)];
+
+// Required by FreeRTOS if static allocation is enabled
+void vApplicationGetIdleTaskMemory(StaticTask_t **tcb,
+                                   StackType_t **stack,
+                                   uint32_t *stack_size)
+{
+    static StaticTask_t idle_tcb;
+    static StackType_t  idle_stack[configMINIMAL_STACK_SIZE + STACK_GUARD_WORDS];
+
+    *tcb        = &idle_tcb;
+    *stack      = idle_stack;
+    *stack_size = configMINIMAL_STACK_SIZE + STACK_GUARD_WORDS;
+}
+
+#if KERNEL_SMP
+
+// Required by SMP kernel: every core but the first one runs its own idle task
+void vApplicationGetPassiveIdleTaskMemory(StaticTask_t **tcb,
+                                          StackType_t **stack,
+                                          uint32_t *stack_size,
+                                          BaseType_t index)
+{
+    static StaticTask_t idle_tcb[configNUMBER_OF_CORES - 1];
+    static StackType_t  idle_stack[configNUMBER_OF_CORES - 1][configMINIMAL_STACK_SIZE + STACK_GUARD_WORDS];
+
+    *tcb        = &idle_tcb[index];
+    *stack      = idle_stack[index];
+    *stack_size = configMINIMAL_STACK_SIZE + STACK_GUARD_WORDS;
+}
+
+#endif // KERNEL_SMP
+
+#if configUSE_TIMERS
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **tcb,
+                                    StackType_t **stack,
+                                    uint32_t *stack_size)
+{
+    static StaticTask_t timer_tcb;
+    static StackType_t  timer_stack[configTIMER_TASK_STACK_DEPTH + STACK_GUARD_WORDS];
+
+    *tcb        = &timer_tcb;
+    *stack      = timer_stack;
+    *stack_size = configTIMER_TASK_STACK_DEPTH + STACK_GUARD_WORDS;
+}
+
+#endif // configUSE_TIMERS
+
+#endif // configSUPPORT_STATIC_ALLOCATION
+
 void kernel_main()
 {
+#if configSUPPORT_STATIC_ALLOCATION
+    TaskHandle_t main_task = xTaskCreateStatic(freertos_main_runner,
+                                               "main",
+                                               MAIN_STACK_BYTES / sizeof(StackType_t),
+                                               NULL,
+                                               tskIDLE_PRIORITY,
+                                               main_stack,
+                                               &main_tcb);
+
+    int ret = main_task ? pdPASS : pdFAIL;
+#else
+    TaskHandle_t main_task = NULL;
     int ret = xTaskCreate(freertos_main_runner,
                           "main",
-                          MAIN_STACK_SIZE / sizeof(StackType_t),
+                          MAIN_STACK_BYTES / sizeof(StackType_t),
                           NULL,
                           tskIDLE_PRIORITY,
-                          NULL);
+                          &main_task);
+#endif
+
+#if KERNEL_SMP && configUSE_CORE_AFFINITY
+    // Platform and drivers are initialized from main. Keep it on the boot
+    // core, so interrupts it enables are routed to the core they expect.
+    // Threads, started from main, can be pinned elsewhere,
+    // see native_thread::set_affinity().
+    if (ret == pdPASS) {
+        vTaskCoreAffinitySet(main_task, 1 << 0);
+    }
+#endif
+
+#ifdef KERNEL_STACK_GUARD_SIZE
+    // Guard itself is placed by the kernel, when first thread is switched in
+    kernel_stack_guard_init();
+#endif
 
     if (ret == pdPASS) {
         vTaskStartScheduler();
@@ -0,0 +1,32 @@
+#ifndef KERNEL_FREERTOS_RUN_TIME_STATS_H_
+#define KERNEL_FREERTOS_RUN_TIME_STATS_H_
+
+// Forcibly included before FreeRTOS config, if CONFIG_FREERTOS_RUN_TIME_STATS
+// is set. Run time is measured with DWT cycle counter, see kernel_main.c.
+// Context switches are counted in the application tag of each task,
+// thus tags can't be used for anything else.
+
+#define configGENERATE_RUN_TIME_STATS   1
+#define configUSE_TRACE_FACILITY        1
+#define configUSE_APPLICATION_TASK_TAG  1
+
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() \
+    do { \
+        extern void kernel_stats_timer_init(void); \
+        kernel_stats_timer_init(); \
+    } while (0)
+
+#define portGET_RUN_TIME_COUNTER_VALUE() \
+    ({ \
+        extern uint32_t kernel_stats_counter(void); \
+        kernel_stats_counter(); \
+    })
+
+// Shared with stack_guard.h, which hooks switches as well
+#define KERNEL_STATS_SWITCHED_IN() \
+    (pxCurrentTCB->pxTaskTag = \
+        (TaskHookFunction_t) ((uintptr_t) pxCurrentTCB->pxTaskTag + 1))
+
+#define traceTASK_SWITCHED_IN() KERNEL_STATS_SWITCHED_IN()
+
+#endif // KERNEL_FREERTOS_RUN_TIME_STATS_H_
@@ -0,0 +1,46 @@
+#ifndef KERNEL_FREERTOS_STACK_GUARD_H_
+#define KERNEL_FREERTOS_STACK_GUARD_H_
+
+// Forcibly included before FreeRTOS config, if CONFIG_FREERTOS_STACK_GUARD
+// is set, after run_time_stats.h if that one is included as well.
+// MPU region, inaccessible even for privileged code, is moved to the bottom
+// of the stack of each thread, when it is switched in. Overflow then traps
+// into MemManage fault right at the offending access and is recorded as
+// a crash, see platform/crash.hpp. Thus configCHECK_FOR_STACK_OVERFLOW
+// may be set to 0, dropping stack checks from each context switch. Method 2
+// is not allowed: it reads the bottom of the stack, as well as a high water
+// mark query of the calling thread's own stack does.
+// Handlers, running on the main stack, are not guarded. Stacks, allocated
+// by the kernel itself, i.e. of idle thread if static allocation is not
+// supported, are not extended so the guard takes part of them.
+
+// Guard size in bytes: power of two, 32 at least.
+// Default is as small as MPU allows.
+#ifndef KERNEL_STACK_GUARD_SIZE
+#define KERNEL_STACK_GUARD_SIZE 32
+#endif
+
+// Stack bytes, lost to the guard and its alignment, at most.
+// Thread stacks are extended by this amount, see kernel_main.c and
+// native_thread::start().
+#define KERNEL_STACK_GUARD_OVERHEAD (2 * KERNEL_STACK_GUARD_SIZE)
+
+#define KERNEL_GUARD_SWITCHED_IN() \
+    do { \
+        extern void kernel_stack_guard(void *stack); \
+        kernel_stack_guard(pxCurrentTCB->pxStack); \
+    } while (0)
+
+#ifdef KERNEL_STATS_SWITCHED_IN
+// Switches are counted as well
+#undef traceTASK_SWITCHED_IN
+#define traceTASK_SWITCHED_IN() \
+    do { \
+        KERNEL_STATS_SWITCHED_IN(); \
+        KERNEL_GUARD_SWITCHED_IN(); \
+    } while (0)
+#else
+#define traceTASK_SWITCHED_IN() KERNEL_GUARD_SWITCHED_IN()
+#endif
+
+#endif // KERNEL_FREERTOS_STACK_GUARD_H_
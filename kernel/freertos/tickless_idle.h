@@ -0,0 +1,15 @@
+#ifndef KERNEL_FREERTOS_TICKLESS_IDLE_H_
+#define KERNEL_FREERTOS_TICKLESS_IDLE_H_
+
+// Forcibly included before FreeRTOS config, if CONFIG_FREERTOS_TICKLESS_IDLE
+// is set. Enables tickless idle and lets kernel_main.c veto sleeping.
+
+#define configUSE_TICKLESS_IDLE 1
+
+#define configPRE_SLEEP_PROCESSING(x) \
+    do { \
+        extern void kernel_pre_sleep(TickType_t *idle_ticks); \
+        kernel_pre_sleep(&(x)); \
+    } while (0)
+
+#endif // KERNEL_FREERTOS_TICKLESS_IDLE_H_
@@ -0,0 +1,58 @@
+#include <ecl/pool.hpp>
+#include <ecl/object_pool.hpp>
+#include <ecl/bench.hpp>
+
+#include <cstdint>
+
+// Allocation paths of pools, in the state they are used most of the time:
+// partially filled, so searches don't finish at the first block.
+
+namespace
+{
+
+struct descriptor
+{
+    uint32_t words[4];
+};
+
+ecl::pool< 32, 256 > blocks;
+ecl::object_pool< descriptor, 64 > objects;
+
+// Keeps pools partially filled
+struct prefill
+{
+    prefill()
+    {
+        for (int i = 0; i < 100; ++i) {
+            blocks.aligned_alloc< uint8_t >(32);
+        }
+
+        for (int i = 0; i < 32; ++i) {
+            objects.aligned_alloc< descriptor >(1);
+        }
+    }
+} prefilled;
+
+} // namespace
+
+ECL_BENCH_OPTS(pool_alloc_single, (ecl::bench::options{ 3, 15, 100 }))
+{
+    auto p = blocks.aligned_alloc< uint8_t >(32);
+    ecl::bench::do_not_optimize(p);
+    blocks.deallocate(p, 32);
+}
+
+ECL_BENCH_OPTS(pool_alloc_run, (ecl::bench::options{ 3, 15, 100 }))
+{
+    // Four consecutive blocks
+    auto p = blocks.aligned_alloc< uint8_t >(128);
+    ecl::bench::do_not_optimize(p);
+    blocks.deallocate(p, 128);
+}
+
+ECL_BENCH_OPTS(object_pool_alloc, (ecl::bench::options{ 3, 15, 100 }))
+{
+    auto p = objects.aligned_alloc< descriptor >(1);
+    ecl::bench::do_not_optimize(p);
+    objects.deallocate(p, 1);
+}
@@ -0,0 +1,168 @@
+// Fragmentation stress of pools, host only.
+//
+// Every pool, of 8 KiB each, is fed with a long random trace of each size
+// distribution, see trace.hpp. Every window of operations a line is printed:
+//
+//   ops     - operations done so far;
+//   live    - bytes requested by live buffers;
+//   used    - bytes taken from the pool by them, rounding included;
+//   waste   - share of used bytes not requested, i.e. internal fragmentation;
+//   largest - longest chunk pool can give away now;
+//   frag    - share of free bytes unreachable by a single allocation,
+//             i.e. external fragmentation;
+//   fail    - failed allocations in the window.
+//
+// Summary is printed afterwards: total failure rate and peak usage.
+// Pass the amount of operations and the seed to run other traces:
+//
+//   stress_pool [ops [seed]]
+
+#include "trace.hpp"
+
+#include <ecl/pool.hpp>
+#include <ecl/size_class_pool.hpp>
+#include <ecl/lockfree_pool.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+
+using namespace alloc_bench;
+
+constexpr size_t window = 4096;
+
+// Bytes of a pool given away and the longest chunk it can give away
+struct usage
+{
+    size_t capacity;
+    size_t used;
+    size_t largest;
+};
+
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t align >
+usage probe(const ecl::pool< blk_sz, blk_cnt, Lock, align > &p)
+{
+    auto s = p.get_stats();
+    return usage{ blk_sz * blk_cnt, s.used * blk_sz, s.largest_free * blk_sz };
+}
+
+template< class T, size_t cnt >
+usage probe(const ecl::object_pool< T, cnt > &p)
+{
+    using pool_type = ecl::object_pool< T, cnt >;
+
+    auto s = p.get_stats();
+    return usage{ pool_type::block_size * cnt, s.used * pool_type::block_size,
+                  s.largest_free * pool_type::block_size };
+}
+
+template< class... Pools >
+usage probe(const ecl::size_class_pool< Pools... > &p)
+{
+    constexpr size_t classes = sizeof...(Pools);
+    constexpr size_t sizes[] = { Pools::block_size... };
+    constexpr size_t counts[] = { Pools::block_count... };
+
+    usage u = {};
+
+    for (size_t i = 0; i < classes; ++i) {
+        auto s = p.class_stats(i);
+
+        u.capacity += sizes[i] * counts[i];
+        u.used += sizes[i] * s.used;
+
+        // Only the largest class serves chunks bigger than its block
+        size_t largest = i + 1 < classes ? (s.largest_free ? sizes[i] : 0)
+                                         : s.largest_free * sizes[i];
+        if (largest > u.largest) {
+            u.largest = largest;
+        }
+    }
+
+    return u;
+}
+
+unsigned percent(size_t part, size_t whole)
+{
+    return whole ? part * 100 / whole : 0;
+}
+
+template< class Pool >
+void stress(const char *name, Pool &pool, dist d, size_t ops, uint32_t seed)
+{
+    generator gen{d, seed};
+    replayer rep{pool};
+
+    size_t failed = 0;
+    size_t allocs = 0;
+    size_t peak = 0;
+
+    printf("%s, %s:\n", name, dist_name(d));
+    printf("%10s %8s %8s %6s %8s %6s %6s\n",
+           "ops", "live", "used", "waste", "largest", "frag", "fail");
+
+    for (size_t i = 1; i <= ops; ++i) {
+        rep.step(gen.next());
+
+        auto u = probe(pool);
+        if (u.used > peak) {
+            peak = u.used;
+        }
+
+        if (i % window) {
+            continue;
+        }
+
+        size_t free = u.capacity - u.used;
+
+        printf("%10zu %8zu %8zu %5u%% %8zu %5u%% %5u%%\n",
+               i, rep.requested(), u.used,
+               percent(u.used - rep.requested(), u.used),
+               u.largest, percent(free - u.largest, free),
+               percent(rep.failed() - failed, rep.allocs() - allocs));
+
+        failed = rep.failed();
+        allocs = rep.allocs();
+    }
+
+    printf("  failed %zu of %zu allocations, %u%%, peak use %zu of %zu bytes\n\n",
+           rep.failed(), rep.allocs(), percent(rep.failed(), rep.allocs()),
+           peak, probe(pool).capacity);
+
+    rep.release_all();
+}
+
+template< class Pool >
+void stress_all(const char *name, size_t ops, uint32_t seed)
+{
+    // Started empty for each distribution
+    for (auto d : { dist::small, dist::mixed, dist::bimodal }) {
+        Pool pool;
+        stress(name, pool, d, ops, seed);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    size_t ops = argc > 1 ? strtoul(argv[1], nullptr, 0) : 65536;
+    uint32_t seed = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+
+    stress_all< ecl::pool< 16, 512 > >("pool<16, 512>", ops, seed);
+    stress_all< ecl::pool< 32, 256 > >("pool<32, 256>", ops, seed);
+    stress_all< ecl::pool< 64, 128 > >("pool<64, 128>", ops, seed);
+
+    stress_all< ecl::size_class_pool<
+        ecl::pool< 16, 128 >,
+        ecl::pool< 64, 48 >,
+        ecl::pool< 256, 12 >
+    > >("size_class_pool<16x128, 64x48, 256x12>", ops, seed);
+
+    // Fails anything bigger than a block, which shows in the failure rate
+    stress_all< ecl::lockfree_pool< 64, 128 > >("lockfree_pool<64, 128>", ops, seed);
+
+    return 0;
+}
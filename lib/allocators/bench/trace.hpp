@@ -0,0 +1,217 @@
+#ifndef LIB_ALLOCATORS_BENCH_TRACE_HPP_
+#define LIB_ALLOCATORS_BENCH_TRACE_HPP_
+
+// Random allocation traces, shared by allocator benchmarks and
+// the fragmentation stress.
+//
+// Trace is a sequence of allocations and deallocations of byte buffers,
+// each held in one of max_live slots. Sizes follow one of distributions
+// below. Allocations prevail, so the amount of live buffers stays close
+// to max_live and allocator is churned at its steady state.
+// Traces are deterministic: same seed gives same trace on any platform.
+
+#include <ecl/pool.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace alloc_bench
+{
+
+// Buffers alive at once, at most
+constexpr size_t max_live = 64;
+
+// Sizes of allocated buffers
+enum class dist
+{
+    small,      // 8 to 64 bytes, i.e. descriptors and messages
+    mixed,      // 8 to 256 bytes, uniformly
+    bimodal,    // 16 to 32 bytes mostly, each fifth is 128 to 512 bytes
+};
+
+inline const char *dist_name(dist d)
+{
+    switch (d) {
+    case dist::small:
+        return "small";
+    case dist::mixed:
+        return "mixed";
+    case dist::bimodal:
+        return "bimodal";
+    }
+
+    return "?";
+}
+
+// Single operation of the trace
+struct op
+{
+    uint16_t    size;   // Bytes to allocate, 0 to free the slot
+    uint8_t     slot;   // Slot that holds the buffer
+};
+
+// Produces trace operations, one by one
+class generator
+{
+public:
+    generator(dist d, uint32_t seed = 1)
+        :m_dist{d}
+        ,m_seed{seed ? seed : 1}
+        ,m_live{0}
+        ,m_count{0}
+    {
+    }
+
+    // Gets next operation
+    op next()
+    {
+        bool alloc;
+
+        if (!m_count) {
+            alloc = true;
+        } else if (m_count == max_live) {
+            alloc = false;
+        } else {
+            alloc = random() % 8 < 5;
+        }
+
+        // Slot is picked at random among free or live ones, so buffers
+        // die in an order different from the one they were allocated in
+        size_t skip = random() % (alloc ? max_live - m_count : m_count);
+        size_t slot = 0;
+
+        for (;; ++slot) {
+            if (is_live(slot) != alloc && !skip--) {
+                break;
+            }
+        }
+
+        m_live ^= uint64_t{1} << slot;
+        m_count += alloc ? 1 : -1;
+
+        return op{ alloc ? size() : uint16_t{0}, static_cast< uint8_t >(slot) };
+    }
+
+    // Gets operation which frees one of live slots, false if there is none
+    bool close(op &o)
+    {
+        if (!m_count) {
+            return false;
+        }
+
+        size_t slot = __builtin_ctzll(m_live);
+
+        m_live &= ~(uint64_t{1} << slot);
+        --m_count;
+
+        o = op{ 0, static_cast< uint8_t >(slot) };
+        return true;
+    }
+
+private:
+    static_assert(max_live <= 64, "Live slots are kept in a 64-bit mask");
+
+    bool is_live(size_t slot) const
+    {
+        return m_live & (uint64_t{1} << slot);
+    }
+
+    // Xorshift, good enough and equally fast everywhere
+    uint32_t random()
+    {
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        return m_seed;
+    }
+
+    uint16_t size()
+    {
+        auto r = random();
+
+        switch (m_dist) {
+        case dist::small:
+            return 8 + r % 57;
+        case dist::mixed:
+            return 8 + r % 249;
+        case dist::bimodal:
+            return (r >> 16) % 5 ? 16 + r % 17 : 128 + r % 385;
+        }
+
+        return 0;
+    }
+
+    dist        m_dist;     // Size distribution
+    uint32_t    m_seed;     // State of random generator
+    uint64_t    m_live;     // Mask of live slots
+    size_t      m_count;    // Count of live slots
+};
+
+// Applies trace operations to a pool, and keeps track of live buffers
+class replayer
+{
+public:
+    replayer(ecl::pool_base &pool)
+        :m_pool(pool)
+        ,m_ptrs{}
+        ,m_sizes{}
+        ,m_requested{0}
+        ,m_allocs{0}
+        ,m_failed{0}
+    {
+    }
+
+    replayer(const replayer &) = delete;
+    replayer &operator=(const replayer &) = delete;
+
+    void step(const op &o)
+    {
+        auto &p = m_ptrs[o.slot];
+
+        if (o.size) {
+            p = m_pool.aligned_alloc< uint8_t >(o.size);
+            ++m_allocs;
+
+            if (p) {
+                m_sizes[o.slot] = o.size;
+                m_requested += o.size;
+            } else {
+                ++m_failed;
+            }
+        } else if (p) {
+            // Allocation of this buffer may have failed
+            m_pool.deallocate(p, m_sizes[o.slot]);
+            m_requested -= m_sizes[o.slot];
+            p = nullptr;
+        }
+    }
+
+    // Frees all live buffers
+    void release_all()
+    {
+        for (uint8_t slot = 0; slot < max_live; ++slot) {
+            step(op{ 0, slot });
+        }
+    }
+
+    // Bytes requested by live buffers
+    size_t requested() const { return m_requested; }
+
+    // Allocations done
+    size_t allocs() const { return m_allocs; }
+
+    // Allocations failed
+    size_t failed() const { return m_failed; }
+
+private:
+    ecl::pool_base  &m_pool;                // Pool under test
+    uint8_t         *m_ptrs[max_live];      // Live buffers
+    uint16_t        m_sizes[max_live];      // Sizes of live buffers
+    size_t          m_requested;            // Bytes in live buffers
+    size_t          m_allocs;               // Allocations done
+    size_t          m_failed;               // Allocations failed
+};
+
+} // namespace alloc_bench
+
+#endif // LIB_ALLOCATORS_BENCH_TRACE_HPP_
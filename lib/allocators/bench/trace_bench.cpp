@@ -0,0 +1,123 @@
+#include "trace.hpp"
+
+#include <ecl/pool.hpp>
+#include <ecl/size_class_pool.hpp>
+#include <ecl/lockfree_pool.hpp>
+#include <ecl/bench.hpp>
+
+// Time of a single operation of a random trace, allocation or deallocation,
+// at the steady state of a pool. Each sample replays whole trace, so
+// the pool is empty again when sample ends. Every pool holds 8 KiB.
+// For fragmentation and failure rates under the same traces, see stress.cpp.
+
+namespace
+{
+
+using namespace alloc_bench;
+
+// Operations of a trace, including closing ones, that free what is left
+constexpr size_t trace_ops = 2048;
+constexpr size_t trace_max = trace_ops + max_live;
+
+constexpr ecl::bench::options trace_options = { 1, 9, trace_max };
+
+ecl::pool< 16, 512 > pool16;
+ecl::pool< 32, 256 > pool32;
+ecl::pool< 64, 128 > pool64;
+
+ecl::size_class_pool<
+    ecl::pool< 16, 128 >,
+    ecl::pool< 64, 48 >,
+    ecl::pool< 256, 12 >
+> classes;
+
+ecl::lockfree_pool< 64, 128 > lockfree;
+
+// Single trace is kept at a time, to spare the RAM of a target
+struct trace
+{
+    op      ops[trace_max];
+    size_t  size;
+    dist    d;
+    bool    valid;
+} cur_trace;
+
+const trace &trace_of(dist d)
+{
+    if (!cur_trace.valid || cur_trace.d != d) {
+        generator gen{d};
+        size_t n = 0;
+
+        while (n < trace_ops) {
+            cur_trace.ops[n++] = gen.next();
+        }
+
+        while (gen.close(cur_trace.ops[n])) {
+            ++n;
+        }
+
+        // Each sample must replay the trace from the beginning
+        while (n < trace_max) {
+            cur_trace.ops[n++] = op{ 0, 0 };
+        }
+
+        cur_trace.size = n;
+        cur_trace.d = d;
+        cur_trace.valid = true;
+    }
+
+    return cur_trace;
+}
+
+// Replays a trace over a pool, single operation per call
+class player
+{
+public:
+    player(ecl::pool_base &pool, dist d)
+        :m_replayer{pool}
+        ,m_dist{d}
+        ,m_pos{0}
+    {
+    }
+
+    void step()
+    {
+        auto &t = trace_of(m_dist);
+
+        m_replayer.step(t.ops[m_pos]);
+
+        if (++m_pos == t.size) {
+            m_pos = 0;
+        }
+    }
+
+private:
+    replayer    m_replayer;
+    dist        m_dist;
+    size_t      m_pos;
+};
+
+} // namespace
+
+#define TRACE_BENCH(name, pool, d) \
+    ECL_BENCH_OPTS(name, trace_options) \
+    { \
+        static player p{pool, d}; \
+        p.step(); \
+    }
+
+TRACE_BENCH(trace_pool16_small, pool16, dist::small)
+TRACE_BENCH(trace_pool32_small, pool32, dist::small)
+TRACE_BENCH(trace_pool64_small, pool64, dist::small)
+TRACE_BENCH(trace_classes_small, classes, dist::small)
+TRACE_BENCH(trace_lockfree_small, lockfree, dist::small)
+
+TRACE_BENCH(trace_pool16_mixed, pool16, dist::mixed)
+TRACE_BENCH(trace_pool32_mixed, pool32, dist::mixed)
+TRACE_BENCH(trace_pool64_mixed, pool64, dist::mixed)
+TRACE_BENCH(trace_classes_mixed, classes, dist::mixed)
+
+TRACE_BENCH(trace_pool16_bimodal, pool16, dist::bimodal)
+TRACE_BENCH(trace_pool32_bimodal, pool32, dist::bimodal)
+TRACE_BENCH(trace_pool64_bimodal, pool64, dist::bimodal)
+TRACE_BENCH(trace_classes_bimodal, classes, dist::bimodal)
@@ -0,0 +1,178 @@
+//!
+//! \file
+//! \brief Binary allocation log of pools.
+//!
+//! Pool, given a trace with pool_base::set_trace(), records every
+//! allocation, deallocation and failure into a RAM ring: caller address,
+//! size, chunk address and timestamp, without locking and without
+//! formatting. Several pools may share a log, their records are told apart
+//! by pool id. Log is a plain object, which is dumped by a debugger and
+//! decoded on host:
+//! \code
+//! ecl::alloc_trace_log< 256 > inode_trace;
+//! ...
+//! inode_pool.set_trace(ecl::alloc_trace{inode_trace, 1, cycles, 168000000});
+//!
+//! (gdb) dump binary value trace.bin inode_trace
+//! $ alloc_trace_decode trace.bin
+//! \endcode
+//! Logs can be found in a dump of the whole RAM as well, by their magic.
+//! Decoder reports hot allocation sites and chunks that are not freed.
+//!
+//! Addresses are recorded as 32 bit values, so on 64 bit hosts they are
+//! truncated. Clock is 32 bit wide as well, gaps between consecutive
+//! records must be shorter than its period.
+//!
+
+#ifndef LIB_ALLOC_TRACE_HPP_
+#define LIB_ALLOC_TRACE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//! Kinds of events in the log.
+enum class alloc_trace_event : uint8_t
+{
+    alloc,      //!< Chunk is allocated.
+    dealloc,    //!< Chunk is deallocated.
+    fail,       //!< Allocation failed. Address is zero.
+};
+
+//!
+//! \brief Single event. Times are in ticks of the trace clock.
+//!
+struct alloc_trace_record
+{
+    uint32_t    seq;    //!< Ordinal of the record. Written last, when record is complete.
+    uint32_t    time;   //!< Timestamp.
+    uint32_t    caller; //!< Address the allocating code returns to.
+    uint32_t    addr;   //!< Address of a chunk.
+    uint32_t    size;   //!< Size of a chunk, in bytes, as requested.
+    uint8_t     pool;   //!< Pool id, given with the trace.
+    uint8_t     event;  //!< One of alloc_trace_event.
+    uint16_t    reserved;
+};
+
+//! Marks start of the log in a memory dump.
+constexpr uint32_t alloc_trace_magic   = 0x54636c41; // "AlcT"
+//! Layout version of the log.
+constexpr uint16_t alloc_trace_version = 1;
+
+//!
+//! \brief Log header. Layout of the log, as it appears in a dump, is:
+//! header followed by capacity records. Both are little-endian.
+//!
+struct alloc_trace_header
+{
+    uint32_t    magic;      //!< alloc_trace_magic, once log is started.
+    uint16_t    version;    //!< alloc_trace_version.
+    uint16_t    capacity;   //!< Amount of records, power of two.
+    uint32_t    clock_hz;   //!< Rate of the trace clock, 0 if there is no clock.
+    uint32_t    head;       //!< Records written ever. Next one takes head % capacity.
+};
+
+static_assert(sizeof(alloc_trace_record) == 24, "Record layout is a part of dump format");
+static_assert(sizeof(alloc_trace_header) == 16, "Header layout is a part of dump format");
+
+//!
+//! \brief The log itself.
+//! \tparam N Amount of records, power of two. Older records are overwritten.
+//!
+template< size_t N >
+struct alloc_trace_log
+{
+    static_assert(N && !(N & (N - 1)), "Trace size must be power of two");
+    static_assert(N <= 0x8000, "Trace size must fit the header");
+
+    alloc_trace_header  hdr;        //!< Header.
+    alloc_trace_record  records[N]; //!< Ring of records.
+};
+
+//!
+//! \brief Writes records of a pool into a log.
+//! Default-constructed trace is disabled and records nothing.
+//!
+class alloc_trace
+{
+public:
+    //! Gets current tick of the trace clock. Must be callable from any context.
+    using clock_fn = uint32_t (*)();
+
+    constexpr alloc_trace() = default;
+
+    //!
+    //! \brief Starts the log, if not yet, and binds the trace to it.
+    //! \pre Not called concurrently with records into the same log.
+    //! \param[in] log      Log to write into.
+    //! \param[in] pool     Id of a pool, to tell pools sharing the log apart.
+    //! \param[in] clock    Trace clock. If nullptr, timestamps are zero.
+    //! \param[in] clock_hz Rate of the trace clock.
+    //!
+    template< size_t N >
+    alloc_trace(alloc_trace_log< N > &log, uint8_t pool, clock_fn clock = nullptr,
+                uint32_t clock_hz = 0);
+
+    //! Checks if the trace is bound to a log.
+    explicit operator bool() const { return m_hdr; }
+
+    //!
+    //! \brief Appends a record. Lock-free, callable from any context.
+    //! Record being written concurrently with a dump is dropped by decoder.
+    //!
+    void record(alloc_trace_event ev, const void *addr, size_t size, const void *caller) const;
+
+private:
+    alloc_trace_header  *m_hdr      = nullptr;  //!< Header of the log.
+    alloc_trace_record  *m_records  = nullptr;  //!< Records of the log.
+    clock_fn            m_clock     = nullptr;  //!< Trace clock.
+    uint8_t             m_pool      = 0;        //!< Pool id.
+};
+
+//------------------------------------------------------------------------------
+
+template< size_t N >
+alloc_trace::alloc_trace(alloc_trace_log< N > &log, uint8_t pool, clock_fn clock,
+                         uint32_t clock_hz)
+    :m_hdr{&log.hdr}
+    ,m_records{log.records}
+    ,m_clock{clock}
+    ,m_pool{pool}
+{
+    if (log.hdr.magic != alloc_trace_magic) {
+        log.hdr.version  = alloc_trace_version;
+        log.hdr.capacity = N;
+        log.hdr.clock_hz = clock ? clock_hz : 0;
+        log.hdr.head     = 0;
+
+        // Tells that the log is valid, so it is set last
+        __atomic_store_n(&log.hdr.magic, alloc_trace_magic, __ATOMIC_RELEASE);
+    }
+}
+
+inline void alloc_trace::record(alloc_trace_event ev, const void *addr, size_t size,
+                                const void *caller) const
+{
+    auto seq = __atomic_fetch_add(&m_hdr->head, 1, __ATOMIC_RELAXED);
+    auto &r  = m_records[seq & (m_hdr->capacity - 1)];
+
+    // Slot can be dumped half-written, invalidate it first
+    __atomic_store_n(&r.seq, ~seq, __ATOMIC_RELAXED);
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+    r.time      = m_clock ? m_clock() : 0;
+    r.caller    = static_cast< uint32_t >(reinterpret_cast< uintptr_t >(caller));
+    r.addr      = static_cast< uint32_t >(reinterpret_cast< uintptr_t >(addr));
+    r.size      = size;
+    r.pool      = m_pool;
+    r.event     = static_cast< uint8_t >(ev);
+    r.reserved  = 0;
+
+    __atomic_store_n(&r.seq, seq, __ATOMIC_RELEASE);
+}
+
+} // namespace ecl
+
+#endif // LIB_ALLOC_TRACE_HPP_
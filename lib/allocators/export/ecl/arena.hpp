@@ -0,0 +1,195 @@
+//!
+//! \file
+//! \brief Monotonic (bump) allocator.
+//!
+#ifndef LIB_ALLOC_ARENA_HPP_
+#define LIB_ALLOC_ARENA_HPP_
+
+#include <ecl/pool.hpp>
+
+#include <array>
+#include <cstddef>
+
+namespace ecl
+{
+
+//!
+//! \brief Arena that hands out memory by bumping a pointer.
+//!
+//! Deallocation of a single chunk does nothing, memory is reclaimed in bulk,
+//! by rewinding arena to a previously taken mark, or with arena_scope.
+//! Use it for transient data, that dies all at once, e.g. while processing
+//! a single request:
+//! \code
+//! ecl::arena< 512 > arena;
+//!
+//! void handle_request()
+//! {
+//!     ecl::arena_scope scope{arena};
+//!     ecl::pool_allocator< char > alloc{&arena};
+//!     auto buf = alloc.allocate(64);
+//!     ...
+//! } // Everything allocated within the scope is released here
+//! \endcode
+//!
+//! \tparam sz Size of the arena in bytes.
+//!
+template< size_t sz >
+class arena : public pool_base
+{
+    static_assert(sz, "Arena size must be bigger than 0");
+
+public:
+    //! Position in the arena.
+    using mark_type = size_t;
+
+    //! \brief Constructs empty arena.
+    arena();
+
+    //! \copydoc pool_base::real_alloc()
+    uint8_t* real_alloc(size_t n, size_t align, size_t obj_sz) override;
+
+    //!
+    //! \brief Does nothing.
+    //! Memory is released when arena is rewound.
+    //!
+    void real_dealloc(uint8_t *p, size_t n, size_t obj_sz) override;
+
+    //! \brief Gets current position in the arena.
+    mark_type mark() const;
+
+    //!
+    //! \brief Releases everything allocated after the mark was taken.
+    //! \pre Objects placed in released memory are destroyed.
+    //! \param[in] m Mark, returned by mark(). Must not be ahead of current
+    //!              position.
+    //!
+    void rewind(mark_type m);
+
+    //! \brief Releases everything allocated.
+    void reset();
+
+    //! \brief Gets amount of bytes in use, including alignment padding.
+    size_t used() const;
+
+    //! \copydoc pool_base::largest_free()
+    size_t largest_free() const override;
+
+private:
+    alignas(alignof(std::max_align_t))
+    std::array< uint8_t, sz >   m_data; //!< Memory of the arena.
+    size_t                      m_top;  //!< Offset of a first free byte.
+};
+
+//!
+//! \brief Rewinds arena to its state at the scope entry, when scope is left.
+//!
+//! Scopes can be nested.
+//!
+class arena_scope
+{
+public:
+    //!
+    //! \brief Enters a scope.
+    //! \param[in] a Arena to rewind later.
+    //!
+    template< size_t sz >
+    explicit arena_scope(arena< sz > &a)
+        :m_arena{&a}
+        ,m_mark{a.mark()}
+        ,m_rewind{[](void *obj, size_t m) {
+            static_cast< arena< sz >* >(obj)->rewind(m);
+        }}
+    {
+    }
+
+    //! \brief Leaves a scope.
+    ~arena_scope()
+    {
+        m_rewind(m_arena, m_mark);
+    }
+
+    arena_scope(const arena_scope&)             = delete;
+    arena_scope& operator=(const arena_scope&)  = delete;
+
+private:
+    void    *m_arena;                   //!< Arena to rewind.
+    size_t  m_mark;                     //!< Position at scope entry.
+    void    (*m_rewind)(void*, size_t); //!< Rewinds arena of given size.
+};
+
+//------------------------------------------------------------------------------
+
+template< size_t sz >
+arena< sz >::arena()
+    :m_data{}
+    ,m_top{0}
+{
+}
+
+template< size_t sz >
+uint8_t* arena< sz >::real_alloc(size_t n, size_t align, size_t obj_sz)
+{
+    // Not allowed to allocate zero-length buffer
+    ecl_assert(n);
+    // Alignment is always a power of two
+    ecl_assert(!(align & (align - 1)));
+    ecl_assert(align <= alignof(std::max_align_t));
+
+    size_t start = (m_top + align - 1) & ~(align - 1);
+    size_t len   = n * obj_sz;
+
+    if (start > sz || len > sz - start) {
+        return nullptr;
+    }
+
+    on_alloc(start + len - m_top);
+    m_top = start + len;
+    return m_data.begin() + start;
+}
+
+template< size_t sz >
+void arena< sz >::real_dealloc(uint8_t *p, size_t n, size_t obj_sz)
+{
+    (void) n;
+    (void) obj_sz;
+
+    ecl_assert(p >= m_data.begin() && p < m_data.begin() + m_top);
+    (void) p;
+}
+
+template< size_t sz >
+typename arena< sz >::mark_type arena< sz >::mark() const
+{
+    return m_top;
+}
+
+template< size_t sz >
+void arena< sz >::rewind(mark_type m)
+{
+    ecl_assert(m <= m_top);
+    on_dealloc(m_top - m);
+    m_top = m;
+}
+
+template< size_t sz >
+void arena< sz >::reset()
+{
+    rewind(0);
+}
+
+template< size_t sz >
+size_t arena< sz >::used() const
+{
+    return m_top;
+}
+
+template< size_t sz >
+size_t arena< sz >::largest_free() const
+{
+    return sz - m_top;
+}
+
+} // namespace ecl
+
+#endif // LIB_ALLOC_ARENA_HPP_
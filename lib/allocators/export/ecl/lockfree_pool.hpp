@@ -0,0 +1,40 @@
+//!
+//! \file
+//! \brief Lock-free pool of single blocks.
+//!
+#ifndef LIB_ALLOC_LOCKFREE_POOL_HPP_
+#define LIB_ALLOC_LOCKFREE_POOL_HPP_
+
+#include <ecl/object_pool.hpp>
+
+namespace ecl
+{
+
+//!
+//! \brief Untyped block of lockfree_pool.
+//! \tparam blk_sz Size of the block.
+//!
+template< size_t blk_sz >
+struct alignas((blk_sz > 64) ? 64 : blk_sz) lockfree_block
+{
+    // Sanity checks
+    static_assert(blk_sz, "Block size must be bigger than 0");
+    static_assert(!(blk_sz & (blk_sz - 1)), "Block size must be power of two");
+
+    uint8_t data[blk_sz];
+};
+
+//!
+//! \brief Pool that gives away only one block at a time, without any locking.
+//!
+//! Untyped counterpart of object_pool. Allocation and deallocation
+//! can be done from any context, including ISR, and never block.
+//! Allocations that don't fit into a single block fail.
+//! \sa pool
+//!
+template< size_t blk_sz, size_t blk_cnt >
+using lockfree_pool = object_pool< lockfree_block< blk_sz >, blk_cnt >;
+
+} // namespace ecl
+
+#endif // LIB_ALLOC_LOCKFREE_POOL_HPP_
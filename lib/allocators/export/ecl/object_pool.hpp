@@ -0,0 +1,172 @@
+//!
+//! \file
+//! \brief Lock-free pool of fixed-size objects.
+//!
+#ifndef LIB_ALLOC_OBJECT_POOL_HPP_
+#define LIB_ALLOC_OBJECT_POOL_HPP_
+
+#include <ecl/pool.hpp>
+
+#include <atomic>
+#include <array>
+#include <limits>
+
+namespace ecl
+{
+
+//!
+//! \brief Pool of objects of the same type, with intrusive free list.
+//!
+//! Each allocation takes exactly one slot, sized and aligned for T.
+//! Free slots hold index of a next free slot, so there is no memory overhead
+//! except the list head. Allocation and deallocation are constant-time and
+//! lock-free: list head is updated with compare-and-swap (LDREX/STREX on
+//! Cortex-M) and tagged with a counter to avoid ABA problem. Thus pool can
+//! be used from any context, including ISR.
+//!
+//! Pool works with pool_allocator:
+//! \code
+//! ecl::object_pool< xfer_descriptor, 8 > pool;
+//! ecl::pool_allocator< xfer_descriptor > alloc{&pool};
+//! \endcode
+//!
+//! \tparam T   Type of objects.
+//! \tparam cnt Count of slots.
+//!
+template< class T, size_t cnt >
+class object_pool : public pool_base
+{
+    static_assert(cnt, "Slot count must be bigger than 0");
+    static_assert(cnt < std::numeric_limits< uint16_t >::max(),
+                  "Slot index must fit in a half of a list head");
+
+    //! Slot of the pool. Holds either an object or a link to a next free slot.
+    union slot
+    {
+        alignas(T) uint8_t      data[sizeof(T)];
+        std::atomic< uint16_t > next;
+    };
+
+public:
+    //! Size of a single slot.
+    static constexpr size_t block_size  = sizeof(slot);
+    //! Count of slots in the pool.
+    static constexpr size_t block_count = cnt;
+
+    //! \brief Constructs pool.
+    object_pool();
+
+    //! \copydoc pool_base::real_alloc()
+    //! Chunks that don't fit into a single slot are never allocated.
+    uint8_t* real_alloc(size_t n, size_t align, size_t obj_sz) override;
+
+    //! \copydoc pool_base::real_dealloc()
+    void real_dealloc(uint8_t *p, size_t n, size_t obj_sz) override;
+
+    //! \copydoc pool::owns()
+    bool owns(const uint8_t *p) const;
+
+    //! \copydoc pool_base::largest_free()
+    size_t largest_free() const override;
+
+private:
+    //! Marks end of the list.
+    static constexpr uint16_t nil = std::numeric_limits< uint16_t >::max();
+
+    //! Packs list head.
+    static constexpr uint32_t head(uint16_t idx, uint16_t tag)
+    {
+        return (static_cast< uint32_t >(tag) << 16) | idx;
+    }
+
+    std::array< slot, cnt >     m_slots;    //!< Object storage.
+    std::atomic< uint32_t >     m_head;     //!< Tag and first free slot.
+};
+
+//------------------------------------------------------------------------------
+
+template< class T, size_t cnt >
+constexpr size_t object_pool< T, cnt >::block_size;
+
+template< class T, size_t cnt >
+constexpr size_t object_pool< T, cnt >::block_count;
+
+template< class T, size_t cnt >
+constexpr uint16_t object_pool< T, cnt >::nil;
+
+template< class T, size_t cnt >
+object_pool< T, cnt >::object_pool()
+    :m_slots{}
+    ,m_head{head(0, 0)}
+{
+    for (size_t i = 0; i < cnt; ++i) {
+        m_slots[i].next = i + 1 < cnt ? i + 1 : nil;
+    }
+}
+
+template< class T, size_t cnt >
+uint8_t* object_pool< T, cnt >::real_alloc(size_t n, size_t align, size_t obj_sz)
+{
+    // Not allowed to allocate zero-length buffer
+    ecl_assert(n);
+
+    if (n * obj_sz > sizeof(slot) || align > alignof(slot)) {
+        return nullptr;
+    }
+
+    auto cur = m_head.load();
+    uint16_t idx;
+
+    do {
+        idx = cur & 0xffff;
+        if (idx == nil) {
+            return nullptr;
+        }
+
+        // Link may be stale if slot is taken concurrently,
+        // tag change rejects such head then.
+    } while (!m_head.compare_exchange_weak(cur, head(m_slots[idx].next, (cur >> 16) + 1)));
+
+    on_alloc(1);
+    return m_slots[idx].data;
+}
+
+template< class T, size_t cnt >
+void object_pool< T, cnt >::real_dealloc(uint8_t *p, size_t n, size_t obj_sz)
+{
+    ecl_assert(n);
+    ecl_assert(owns(p));
+    ecl_assert(n * obj_sz <= sizeof(slot));
+
+    (void) n;
+    (void) obj_sz;
+
+    uint16_t idx = reinterpret_cast< slot * >(p) - m_slots.begin();
+    auto cur = m_head.load();
+
+    do {
+        m_slots[idx].next = cur & 0xffff;
+    } while (!m_head.compare_exchange_weak(cur, head(idx, (cur >> 16) + 1)));
+
+    on_dealloc(1);
+}
+
+template< class T, size_t cnt >
+bool object_pool< T, cnt >::owns(const uint8_t *p) const
+{
+    auto begin = reinterpret_cast< const uint8_t * >(m_slots.begin());
+    auto end   = reinterpret_cast< const uint8_t * >(m_slots.end());
+
+    return p >= begin && p < end;
+}
+
+template< class T, size_t cnt >
+size_t object_pool< T, cnt >::largest_free() const
+{
+    // Each chunk is a single slot, so any free slot is the longest run
+    return (m_head.load() & 0xffff) != nil ? 1 : 0;
+}
+
+} // namespace ecl
+
+#endif // LIB_ALLOC_OBJECT_POOL_HPP_
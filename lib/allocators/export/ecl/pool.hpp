@@ -6,8 +6,11 @@
 #ifndef LIB_ALLOC_POOL_HPP_
 #define LIB_ALLOC_POOL_HPP_
 
+#include <ecl/alloc_trace.hpp>
 #include <ecl/assert.h>
 #include <ecl/types.h>
+#include <ecl/prof.hpp>
+#include <ecl/bitset.hpp>
 
 #if defined (POOL_ALLOC_TEST_PRINT_STATS) || defined (POOL_ALLOC_TEST_PRINT_EXTENDED_STATS)
 #include <ecl/iostream.hpp>
@@ -15,10 +18,26 @@
 
 #include <memory>
 #include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
 
 namespace ecl
 {
 
+//!
+//! \brief Usage counters of a pool.
+//! Amounts are expressed in pool units: blocks for ecl::pool, slots for
+//! ecl::object_pool, bytes for ecl::arena.
+//!
+struct pool_stats
+{
+    size_t used;            //!< Units in use now.
+    size_t peak;            //!< Maximum of units in use ever.
+    size_t failed;          //!< Count of failed allocations.
+    size_t largest_free;    //!< Longest run of free units. Calculated on demand.
+};
+
 //!
 //! \brief Base class for memory pool.
 //!
@@ -65,12 +84,40 @@ public:
     template< typename T >
     void deallocate(T *p, size_t n);
 
+    //!
+    //! \brief Gets usage counters.
+    //! Counters are always maintained, so the call is cheap, except
+    //! calculation of the largest free run, which depends on the pool.
+    //!
+    pool_stats get_stats() const;
+
+    //!
+    //! \brief Starts or stops recording of allocations into a log.
+    //! Untraced pool pays a single branch per call.
+    //! \pre Pool is not used concurrently.
+    //! \param[in] trace Trace bound to a log, or default one to stop.
+    //! \sa alloc_trace
+    //!
+    void set_trace(const alloc_trace &trace);
+
     //!
     //! Destroys a pool.
     //!
     virtual ~pool_base();
 
 protected:
+    //!
+    //! \brief Finds longest run of free units.
+    //! \return Run length. Pool that doesn't track it returns 0.
+    //!
+    virtual size_t largest_free() const;
+
+    //! Accounts allocation of given amount of units.
+    void on_alloc(size_t n);
+
+    //! Accounts deallocation of given amount of units.
+    void on_dealloc(size_t n);
+
     //!
     //! \brief Allocates chunk with respect to given alingment.
     //! \param[in] n        Object count.
@@ -95,6 +142,13 @@ protected:
     //! \sa deallocate()
     //!
     virtual void real_dealloc(uint8_t *p, size_t n, size_t obj_size) = 0;
+
+private:
+    // Atomic, since lock-free pools update counters concurrently
+    std::atomic< size_t > m_used{0};   //!< Units in use.
+    std::atomic< size_t > m_peak{0};   //!< High-water mark of units in use.
+    std::atomic< size_t > m_failed{0}; //!< Failed allocations.
+    alloc_trace           m_trace{};   //!< Allocation log, disabled by default.
 };
 
 //------------------------------------------------------------------------------
@@ -102,12 +156,24 @@ protected:
 template< typename T >
 T* pool_base::aligned_alloc(size_t n)
 {
+    ECL_TRACE_SCOPE("pool.alloc");
+
     T *p = reinterpret_cast< T* > (real_alloc(n, alignof(T), sizeof(T)));
 
+    if (!p) {
+        ECL_COUNTER("pool.failed");
+        ++m_failed;
+    }
+
+    if (m_trace) {
+        m_trace.record(p ? alloc_trace_event::alloc : alloc_trace_event::fail,
+                       p, n * sizeof(T), __builtin_return_address(0));
+    }
+
 #ifdef POOL_ALLOC_TEST_PRINT_EXTENDED_STATS
-    ecl::cout << "alloc " << (int)n << " x " << (int)sizeof(T) << " = "
-              << (int)(n * sizeof(T)) << " bytes from "
-              << static_cast< int >((uintptr_t)p) << ecl::endl;
+    ecl::cout << "alloc " << n << " x " << sizeof(T) << " = "
+              << n * sizeof(T) << " bytes from "
+              << static_cast< const void* >(p) << ecl::endl;
 #endif
     return p;
 }
@@ -115,16 +181,61 @@ T* pool_base::aligned_alloc(size_t n)
 template< typename T >
 void pool_base::deallocate(T *p, size_t n)
 {
+    ECL_TRACE_SCOPE("pool.dealloc");
+
 #ifdef POOL_ALLOC_TEST_PRINT_EXTENDED_STATS
-    ecl::cout << "dealloc " << (int)n << " x " << (int)sizeof(T) << " = "
-              << (int)(n * sizeof(T)) << " bytes from "
-              << static_cast< int >((uintptr_t)p) << ecl::endl;
+    ecl::cout << "dealloc " << n << " x " << sizeof(T) << " = "
+              << n * sizeof(T) << " bytes from "
+              << static_cast< const void* >(p) << ecl::endl;
 #endif
+    if (m_trace) {
+        m_trace.record(alloc_trace_event::dealloc, p, n * sizeof(T),
+                       __builtin_return_address(0));
+    }
+
     real_dealloc(reinterpret_cast< uint8_t *>(p), n, sizeof(T));
 }
 
+inline pool_stats pool_base::get_stats() const
+{
+    return pool_stats{ m_used.load(), m_peak.load(), m_failed.load(), largest_free() };
+}
+
+inline void pool_base::set_trace(const alloc_trace &trace)
+{
+    m_trace = trace;
+}
+
+inline size_t pool_base::largest_free() const
+{
+    return 0;
+}
+
+inline void pool_base::on_alloc(size_t n)
+{
+    auto used = m_used += n;
+    auto peak = m_peak.load();
+
+    while (used > peak && !m_peak.compare_exchange_weak(peak, used)) { }
+}
+
+inline void pool_base::on_dealloc(size_t n)
+{
+    m_used -= n;
+}
+
 //------------------------------------------------------------------------------
 
+//!
+//! \brief Lock policy that does no locking.
+//! Suitable for pools used from a single thread only.
+//!
+struct no_lock
+{
+    void lock() { }
+    void unlock() { }
+};
+
 //!
 //! \brief Holds given buffer as a pool.
 //!
@@ -132,15 +243,32 @@ void pool_base::deallocate(T *p, size_t n)
 //! Refer to a wiki for further info:
 //! [here](https://en.wikipedia.org/wiki/Fixed-size_blocks_allocation)
 //!
-template< size_t blk_sz, size_t blk_cnt >
+//! Pool is protected by a lock of given type. Any type with lock() and
+//! unlock() methods fits, e.g. ecl::mutex for pools shared between threads
+//! or IRQ_lock for pools used from ISR. By default no locking is done.
+//!
+//! Pool data is aligned to the block size, up to 64 bytes. Larger alignment
+//! can be requested, e.g. to fit DMA burst boundaries. Pool memory region
+//! is defined by placement of the pool object itself, see platform
+//! memory section attributes.
+//! \sa lockfree_pool
+//!
+template< size_t blk_sz, size_t blk_cnt, class Lock = no_lock,
+          size_t data_align = (blk_sz > 64) ? 64 : blk_sz >
 class pool : public pool_base
 {
     // Sanity checks
     static_assert(blk_sz, "Block size must be bigger than 0");
     static_assert(blk_cnt, "Block count must be bigger than 0");
     static_assert(!(blk_sz & (blk_sz - 1)), "Block size must be power of two");
+    static_assert(!(data_align & (data_align - 1)), "Alignment must be power of two");
 
 public:
+    //! Size of a single block.
+    static constexpr size_t block_size  = blk_sz;
+    //! Count of blocks in the pool.
+    static constexpr size_t block_count = blk_cnt;
+
     //! \brief Constructs pool.
     pool();
 
@@ -153,6 +281,16 @@ public:
     //! \copydoc pool_base::real_dealloc()
     void real_dealloc(uint8_t *p, size_t n, size_t obj_sz) override;
 
+    //! \copydoc pool_base::largest_free()
+    size_t largest_free() const override;
+
+    //!
+    //! \brief Checks if given memory belongs to the pool.
+    //! \param[in] p Any address.
+    //! \return true if address lies within the pool data.
+    //!
+    bool owns(const uint8_t *p) const;
+
 #ifdef POOL_ALLOC_TEST
     // Special routines used for test purposes only
     auto& get_data() { return m_data; }
@@ -162,17 +300,21 @@ public:
 #endif
 
 private:
-    //! Gets size of info array containing bits representing data chunk state.
-    static constexpr auto info_blks_sz();
     //! Gets size of data array.
     static constexpr auto data_blks_sz();
 
+    //! Allocates chunk without locking. \sa real_alloc()
+    uint8_t* alloc(size_t n, size_t align, size_t obj_sz);
+    //! Deallocates chunk without locking. \sa real_dealloc()
+    void dealloc(uint8_t *p, size_t n, size_t obj_sz);
+
     //!
-    //! \brief Marks block with given index as used\unused.
-    //! \param[in] idx  Block index. Must be valid index of a block within a pool.
-    //! \param[in] used True if block must be marked as used. False - if as unused.
+    //! \brief Marks run of blocks as used\unused.
+    //! \param[in] idx  Index of a first block. Must be valid index of a block within a pool.
+    //! \param[in] n    Count of blocks. Run must fit into the pool.
+    //! \param[in] used True if blocks must be marked as used. False - if as unused.
     //!
-    void mark(size_t idx, bool used);
+    void mark(size_t idx, size_t n, bool used);
 
     //!
     //! \brief Checks if block with given index is free or not.
@@ -181,6 +323,17 @@ private:
     //!
     bool is_free(size_t idx) const;
 
+    //!
+    //! \brief Finds first used\unused block in given range.
+    //! Info bits are scanned word by word, rather than bit by bit.
+    //! \param[in] from Index of a block to start from.
+    //! \param[in] to   Index past the last block of the range. Must not
+    //!                 exceed block count.
+    //! \param[in] used True if used block is searched. False - if unused.
+    //! \return Index of a block found or \p to if there is no such block.
+    //!
+    size_t find(size_t from, size_t to, bool used) const;
+
     //!
     //! \brief Obtains a block by given index.
     //! \param[in] idx  Block index. Must be valid index of a block within a pool.
@@ -190,88 +343,126 @@ private:
 
     // Data buffer must be aligned to size of block,
     // this will reduce complexity of calculations.
-    // 64 is now maximum alignment supported TODO: clarify
-    alignas((blk_sz > 64) ? 64 : blk_sz)
+    alignas(data_align)
     std::array< uint8_t, data_blks_sz() >   m_data; //!< Memory pool.
-    //! \todo use bitset?
-    std::array< uint8_t, info_blks_sz() >   m_info; //!< Memory info array.
+    bitset< blk_cnt >                       m_info; //!< Used blocks.
+    size_t                                  m_hint; //!< All blocks below are used.
+    mutable Lock                            m_lock; //!< Protects pool state.
 };
 
 //------------------------------------------------------------------------------
 
-template< size_t blk_sz, size_t blk_cnt >
-pool< blk_sz, blk_cnt >::pool()
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+constexpr size_t pool< blk_sz, blk_cnt, Lock, data_align >::block_size;
+
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+constexpr size_t pool< blk_sz, blk_cnt, Lock, data_align >::block_count;
+
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+pool< blk_sz, blk_cnt, Lock, data_align >::pool()
     :m_data{0}
-    ,m_info{0}
+    ,m_info{}
+    ,m_hint{0}
+    ,m_lock{}
 {
 }
 
-template< size_t blk_sz, size_t blk_cnt >
-pool< blk_sz, blk_cnt >::~pool()
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+pool< blk_sz, blk_cnt, Lock, data_align >::~pool()
 {
 }
 
-template< size_t blk_sz, size_t blk_cnt >
-uint8_t* pool< blk_sz, blk_cnt >::real_alloc(size_t n, size_t align, size_t obj_sz)
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+uint8_t* pool< blk_sz, blk_cnt, Lock, data_align >::real_alloc(size_t n, size_t align, size_t obj_sz)
 {
-    // Consider reviewing the block size if this assertion fails.
-    ecl_assert(align < blk_sz);
-    // Not allowed to allocate zero-length buffer
-    ecl_assert(n);
+    m_lock.lock();
+    auto p = alloc(n, align, obj_sz);
+    m_lock.unlock();
 
-    // TODO: use byte-based iteration, instead of bit-based
+    return p;
+}
 
-    bool found = false;
-    size_t i = 0;
-    size_t j;
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+void pool< blk_sz, blk_cnt, Lock, data_align >::real_dealloc(uint8_t *p, size_t n, size_t obj_sz)
+{
+    m_lock.lock();
+    dealloc(p, n, obj_sz);
+    m_lock.unlock();
+}
+
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+size_t pool< blk_sz, blk_cnt, Lock, data_align >::largest_free() const
+{
+    size_t longest = 0;
+
+    m_lock.lock();
+
+    for (size_t i = find(m_hint, blk_cnt, false); i < blk_cnt; ) {
+        size_t end = find(i, blk_cnt, true);
+        longest = end - i > longest ? end - i : longest;
+        i = find(end, blk_cnt, false);
+    }
+
+    m_lock.unlock();
+
+    return longest;
+}
+
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+uint8_t* pool< blk_sz, blk_cnt, Lock, data_align >::alloc(size_t n, size_t align, size_t obj_sz)
+{
+    // Consider reviewing the block size if this assertion fails.
+    ecl_assert_level(ECL_ASSERT_LEVEL_ALLOC, align < blk_sz);
+    // Blocks are aligned no stricter than the data
+    ecl_assert_level(ECL_ASSERT_LEVEL_ALLOC, align <= data_align);
+    // Not allowed to allocate zero-length buffer
+    ecl_assert_level(ECL_ASSERT_LEVEL_ALLOC, n);
+    (void) align;
 
     // Convert a count of objects to a block count with rounding away from zero
     // to a boundary of the block size.
     n = (n * obj_sz + blk_sz - 1) / blk_sz;
 
-    // Convert count to offset
-    n--;
+    if (n > blk_cnt) {
+        return nullptr;
+    }
 
-    // Iterate over whole slab
-    for (; i + n < blk_cnt; ++i) {
-        j = i;
+    // All blocks below the hint are used, no need to look there.
+    size_t i = find(m_hint, blk_cnt, false);
+    m_hint = i;
 
-        // Finds cache row with appropriate length
-        for (; j <= i + n; ++j) {
-            if (!is_free(j)) {
-                break;
-            }
-        }
+    while (i + n <= blk_cnt) {
+        // Check that the whole run, starting from free block, is free too
+        size_t used = find(i, i + n, true);
 
-        if (j == i + n + 1) {
-            found = true;
-            break;
-        }
-    }
+        if (used == i + n) {
+            mark(i, n, true);
+            on_alloc(n);
 
-    if (found) {
-        // Mark caches as used
-        for (j = i; j <= i + n; ++j) {
-            mark(j, true);
+            if (i == m_hint) {
+                m_hint = i + n;
+            }
+
+            return get_block(i);
         }
 
-        return get_block(i);
+        i = find(used, blk_cnt, false);
     }
 
     return nullptr;
 }
 
 
-template< size_t blk_sz, size_t blk_cnt >
-void pool< blk_sz, blk_cnt >::real_dealloc(uint8_t *p, size_t n, size_t obj_sz)
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+void pool< blk_sz, blk_cnt, Lock, data_align >::dealloc(uint8_t *p, size_t n, size_t obj_sz)
 {
-    ecl_assert(n);
-    ecl_assert(p); // For now
+    ecl_assert_level(ECL_ASSERT_LEVEL_ALLOC, n);
+    ecl_assert_level(ECL_ASSERT_LEVEL_ALLOC, p); // For now
 
     auto start = m_data.begin();
     auto end   = m_data.end();
 
-    ecl_assert(p >= start && p < end);
+    ecl_assert_level(ECL_ASSERT_LEVEL_ALLOC, p >= start && p < end);
 
     size_t idx = (p - start) / blk_sz;
     size_t cnt = (end - p)   / blk_sz;
@@ -280,72 +471,69 @@ void pool< blk_sz, blk_cnt >::real_dealloc(uint8_t *p, size_t n, size_t obj_sz)
     // to a boundary of the block size.
     n = (n * obj_sz + blk_sz - 1) / blk_sz;
 
-    ecl_assert(n <= cnt);
+    ecl_assert_level(ECL_ASSERT_LEVEL_ALLOC, n <= cnt);
+    (void) cnt;
+    // Every block of a chunk must be in use
+    ecl_assert_level_paranoid(ECL_ASSERT_LEVEL_ALLOC, find(idx, idx + n, false) == idx + n);
+
+    mark(idx, n, false);
+    on_dealloc(n);
 
-    while (n) {
-        size_t to_free = idx + --n;
-        ecl_assert(!is_free(to_free));
-        mark(to_free, false);
+    if (idx < m_hint) {
+        m_hint = idx;
     }
 }
 
 
 
-//------------------------------------------------------------------------------
-
-template< size_t blk_sz, size_t blk_cnt >
-constexpr auto pool< blk_sz, blk_cnt >::info_blks_sz()
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+bool pool< blk_sz, blk_cnt, Lock, data_align >::owns(const uint8_t *p) const
 {
-    // Count bytes required to hold info bits. One bit per each block.
-    // TODO: use bitset?
-    return blk_cnt / 8 + 1;
+    return p >= m_data.begin() && p < m_data.end();
 }
 
-template< size_t blk_sz, size_t blk_cnt >
-constexpr auto pool<blk_sz, blk_cnt>::data_blks_sz()
+//------------------------------------------------------------------------------
+
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+constexpr auto pool< blk_sz, blk_cnt, Lock, data_align >::data_blks_sz()
 {
     return blk_cnt * blk_sz;
 }
 
-template< size_t blk_sz, size_t blk_cnt >
-bool pool< blk_sz, blk_cnt >::is_free(size_t idx) const
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+bool pool< blk_sz, blk_cnt, Lock, data_align >::is_free(size_t idx) const
 {
-    // TODO: use bitset?
-    ecl_assert(idx < blk_cnt);
-
-    uint byte = idx >> 3;
-    uint bit  = idx & 7;
+    ecl_assert_level(ECL_ASSERT_LEVEL_ALLOC, idx < blk_cnt);
 
-    return !(m_info[byte] & (1 << bit));
+    return !m_info.test(idx);
 }
 
-
-template< size_t blk_sz, size_t blk_cnt >
-void pool< blk_sz, blk_cnt >::mark(size_t idx, bool used)
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+size_t pool< blk_sz, blk_cnt, Lock, data_align >::find(size_t from, size_t to, bool used) const
 {
-    // TODO: use bitset?
-    ecl_assert(idx < blk_cnt);
+    ecl_assert_level(ECL_ASSERT_LEVEL_ALLOC, to <= blk_cnt);
 
-    uint byte = idx >> 3;
-    uint bit  = idx & 7;
+    return m_info.find(from, to, used);
+}
 
-    if (used) {
-        m_info[byte] |= (1 << bit);
-    } else {
-        m_info[byte] &= ~(1 << bit);
-    }
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+void pool< blk_sz, blk_cnt, Lock, data_align >::mark(size_t idx, size_t n, bool used)
+{
+    ecl_assert_level(ECL_ASSERT_LEVEL_ALLOC, idx + n <= blk_cnt);
+
+    m_info.fill(idx, idx + n, used);
 }
 
-template< size_t blk_sz, size_t blk_cnt >
-uint8_t *pool< blk_sz, blk_cnt >::get_block(size_t idx)
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+uint8_t *pool< blk_sz, blk_cnt, Lock, data_align >::get_block(size_t idx)
 {
-    ecl_assert(idx < blk_cnt);
+    ecl_assert_level(ECL_ASSERT_LEVEL_ALLOC, idx < blk_cnt);
     return m_data.begin() + idx * blk_sz;
 }
 
 #ifdef POOL_ALLOC_TEST_PRINT_STATS
-template< size_t blk_sz, size_t blk_cnt >
-void pool< blk_sz, blk_cnt >::print_stats() const
+template< size_t blk_sz, size_t blk_cnt, class Lock, size_t data_align >
+void pool< blk_sz, blk_cnt, Lock, data_align >::print_stats() const
 {
     // Print memory stats for whole pool
     size_t i = 0;
@@ -367,10 +555,10 @@ void pool< blk_sz, blk_cnt >::print_stats() const
     ecl::cout << "\n\n";
 
     ecl::cout << "_________________________" << ecl::endl;
-    ecl::cout << "total blk:\t\t"        << (int) blk_cnt << ecl::endl;
-    ecl::cout << "blk sz:\t\t\t"         << (int) blk_sz << ecl::endl;
-    ecl::cout << "used:\t\t\t"           << (int) used << ecl::endl;
-    ecl::cout << "longest free streak:\t"<< (int) streak << ecl::endl;
+    ecl::cout << "total blk:\t\t"        << blk_cnt << ecl::endl;
+    ecl::cout << "blk sz:\t\t\t"         << blk_sz << ecl::endl;
+    ecl::cout << "used:\t\t\t"           << used << ecl::endl;
+    ecl::cout << "longest free streak:\t"<< streak << ecl::endl;
 }
 #endif
 
@@ -380,19 +568,47 @@ void pool< blk_sz, blk_cnt >::print_stats() const
 //!
 //! \brief Almost stateless pool allocator.
 //!
-//! Provides the interface for shared memory pool.
+//! Provides the interface for shared memory pool. Meets standard allocator
+//! requirements, so STL containers can keep their storage in a pool:
+//! \code
+//! ecl::pool< 16, 64 > pool;
+//! std::vector< int, ecl::pool_allocator< int > > v{ ecl::pool_allocator< int >{&pool} };
+//! \endcode
+//! Allocators are equal if they share the pool. Pool follows the container
+//! on copy, move and swap, thus memory is always returned to the pool it was
+//! taken from, and move assignment never copies elements.
+//! Unlike the standard allocator, nullptr is returned if the pool is
+//! exhausted, since exceptions are disabled on target. Containers don't
+//! check it, so pools for them must be sized for the peak usage, see
+//! pool_base::get_stats().
 //! \tparam Type for whom memory should be allocated.
 //!
 template< typename T >
 class pool_allocator
 {
 public:
+    using value_type        = T;
+    using size_type         = size_t;
+    using difference_type   = ptrdiff_t;
+
+    using propagate_on_container_copy_assignment    = std::true_type;
+    using propagate_on_container_move_assignment    = std::true_type;
+    using propagate_on_container_swap               = std::true_type;
+    using is_always_equal                           = std::false_type;
+
     //!
     //! \brief Constructs pool allocator with memory pool given.
     //! \param[in] Memory pool to use with this allocator.
     //!
     pool_allocator(pool_base *pool);
 
+    //!
+    //! \brief Constructs allocator for other type over the same pool.
+    //! \param[in] other Allocator to get the pool from.
+    //!
+    template< typename U >
+    pool_allocator(const pool_allocator< U > &other);
+
     //! Deallocates allocator.
     ~pool_allocator();
 
@@ -407,7 +623,11 @@ public:
     //!
     T* allocate(size_t n);
 
-    //! \todo: fill docs
+    //!
+    //! \brief Deallocates memory, previously allocated by this or equal allocator.
+    //! \param[in] p Pointer returned by allocate().
+    //! \param[in] n Objects count, the same as passed to allocate().
+    //!
     void deallocate(T *p, size_t n);
 
     //! \brief Create new instanse of the allocator, suitable for a new type
@@ -415,10 +635,21 @@ public:
     template< typename U >
     pool_allocator< U > rebind() const;
 
+    //! Gets the pool.
+    pool_base *get_pool() const;
+
 private:
     pool_base *m_pool; //!< Memory pool. \todo use reference instead of pointer.
 };
 
+//! Checks if memory allocated by one allocator can be freed by the other.
+template< typename T, typename U >
+bool operator ==(const pool_allocator< T > &lhs, const pool_allocator< U > &rhs);
+
+//! Checks if memory allocated by one allocator can't be freed by the other.
+template< typename T, typename U >
+bool operator !=(const pool_allocator< T > &lhs, const pool_allocator< U > &rhs);
+
 
 template< typename T >
 pool_allocator< T >::pool_allocator(pool_base *pool)
@@ -426,6 +657,13 @@ pool_allocator< T >::pool_allocator(pool_base *pool)
 {
 }
 
+template< typename T >
+template< typename U >
+pool_allocator< T >::pool_allocator(const pool_allocator< U > &other)
+    :m_pool{other.get_pool()}
+{
+}
+
 template< typename T >
 pool_allocator< T >::~pool_allocator()
 {
@@ -450,6 +688,23 @@ pool_allocator< U > pool_allocator< T >::rebind() const
     return pool_allocator< U >{ m_pool };
 }
 
+template< typename T >
+pool_base *pool_allocator< T >::get_pool() const
+{
+    return m_pool;
+}
+
+template< typename T, typename U >
+bool operator ==(const pool_allocator< T > &lhs, const pool_allocator< U > &rhs)
+{
+    return lhs.get_pool() == rhs.get_pool();
+}
+
+template< typename T, typename U >
+bool operator !=(const pool_allocator< T > &lhs, const pool_allocator< U > &rhs)
+{
+    return !(lhs == rhs);
+}
 
 }
 
@@ -0,0 +1,235 @@
+//!
+//! \file
+//! \brief Memory pool composed of few fixed-size pools (size classes).
+//!
+#ifndef LIB_ALLOC_SIZE_CLASS_POOL_HPP_
+#define LIB_ALLOC_SIZE_CLASS_POOL_HPP_
+
+#include <ecl/pool.hpp>
+
+#include <tuple>
+#include <type_traits>
+
+namespace ecl
+{
+
+//!
+//! \brief Segregated pool, routing allocations to the best fitting size class.
+//!
+//! Each class is an ecl::pool with its own block size. Chunk is allocated
+//! from the smallest class which block can hold it. If that class is
+//! depleted, larger classes are tried. Chunks bigger than the largest block
+//! are allocated as a run of blocks from the largest class.
+//!
+//! When type is known in advance, class can be selected at compile time:
+//! \code
+//! ecl::size_class_pool< ecl::pool< 16, 32 >, ecl::pool< 64, 16 > > pool;
+//! ecl::pool_allocator< foo > alloc{&pool.pool_for< foo >()};
+//! \endcode
+//!
+//! Usage counters of the composite count only failed allocations.
+//! Each class keeps its own counters, reachable via pool_for().
+//!
+//! \tparam Pools Size classes, sorted by block size in ascending order.
+//!
+template< class... Pools >
+class size_class_pool : public pool_base
+{
+    static_assert(sizeof...(Pools), "At least one size class is required");
+
+    //! Gets block size of the class with given index.
+    static constexpr size_t block_size(size_t idx);
+    //! Checks that classes are sorted by block size.
+    static constexpr bool sorted();
+    //! Finds best fitting class for given chunk size and alignment.
+    static constexpr size_t best_class(size_t sz, size_t align);
+
+    static_assert(sorted(), "Size classes must be sorted by block size");
+
+public:
+    //! Count of size classes.
+    static constexpr size_t classes = sizeof...(Pools);
+
+    //! \copydoc pool_base::real_alloc()
+    uint8_t* real_alloc(size_t n, size_t align, size_t obj_sz) override;
+
+    //! \copydoc pool_base::real_dealloc()
+    void real_dealloc(uint8_t *p, size_t n, size_t obj_sz) override;
+
+    //!
+    //! \brief Gets pool of the class that fits given type best.
+    //! Selection is done at compile time, no routing is involved later.
+    //! \tparam T Type of objects.
+    //! \tparam n Count of objects allocated at once.
+    //!
+    template< typename T, size_t n = 1 >
+    auto &pool_for();
+
+    //!
+    //! \brief Gets usage counters of a size class.
+    //! \param[in] idx Class index. Must be less than class count.
+    //!
+    pool_stats class_stats(size_t idx) const;
+
+private:
+    template< size_t idx >
+    using index = std::integral_constant< size_t, idx >;
+
+    // Allocates from the first class, starting from given one, that has space
+    template< size_t idx >
+    uint8_t *alloc_from(index< idx >, size_t first, size_t n, size_t align, size_t obj_sz);
+    uint8_t *alloc_from(index< classes >, size_t first, size_t n, size_t align, size_t obj_sz);
+
+    // Returns chunk to the class it belongs to
+    template< size_t idx >
+    void dealloc_to(index< idx >, uint8_t *p, size_t n, size_t obj_sz);
+    void dealloc_to(index< classes >, uint8_t *p, size_t n, size_t obj_sz);
+
+    // Gets counters of the class with given index
+    template< size_t idx >
+    pool_stats stats_of(index< idx >, size_t cls) const;
+    pool_stats stats_of(index< classes >, size_t cls) const;
+
+    std::tuple< Pools... > m_pools; //!< Size classes.
+};
+
+//------------------------------------------------------------------------------
+
+template< class... Pools >
+constexpr size_t size_class_pool< Pools... >::classes;
+
+template< class... Pools >
+constexpr size_t size_class_pool< Pools... >::block_size(size_t idx)
+{
+    constexpr size_t sizes[] = { Pools::block_size... };
+    return sizes[idx];
+}
+
+template< class... Pools >
+constexpr bool size_class_pool< Pools... >::sorted()
+{
+    for (size_t i = 1; i < sizeof...(Pools); ++i) {
+        if (block_size(i - 1) >= block_size(i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template< class... Pools >
+constexpr size_t size_class_pool< Pools... >::best_class(size_t sz, size_t align)
+{
+    // Pool requires alignment to be strictly less than block size
+    for (size_t i = 0; i < sizeof...(Pools); ++i) {
+        if (sz <= block_size(i) && align < block_size(i)) {
+            return i;
+        }
+    }
+
+    return sizeof...(Pools) - 1;
+}
+
+template< class... Pools >
+uint8_t* size_class_pool< Pools... >::real_alloc(size_t n, size_t align, size_t obj_sz)
+{
+    ecl_assert(n);
+
+    return alloc_from(index< 0 >{}, best_class(n * obj_sz, align), n, align, obj_sz);
+}
+
+template< class... Pools >
+void size_class_pool< Pools... >::real_dealloc(uint8_t *p, size_t n, size_t obj_sz)
+{
+    ecl_assert(p);
+
+    dealloc_to(index< 0 >{}, p, n, obj_sz);
+}
+
+template< class... Pools >
+template< typename T, size_t n >
+auto &size_class_pool< Pools... >::pool_for()
+{
+    static_assert(n, "Zero-length allocations are not allowed");
+
+    return std::get< best_class(sizeof(T) * n, alignof(T)) >(m_pools);
+}
+
+template< class... Pools >
+pool_stats size_class_pool< Pools... >::class_stats(size_t idx) const
+{
+    ecl_assert(idx < classes);
+
+    return stats_of(index< 0 >{}, idx);
+}
+
+//------------------------------------------------------------------------------
+
+template< class... Pools >
+template< size_t idx >
+uint8_t *size_class_pool< Pools... >::alloc_from(index< idx >, size_t first,
+                                                 size_t n, size_t align, size_t obj_sz)
+{
+    if (idx >= first && align < block_size(idx)) {
+        auto p = std::get< idx >(m_pools).real_alloc(n, align, obj_sz);
+        if (p) {
+            return p;
+        }
+    }
+
+    // Class is depleted, try larger one
+    return alloc_from(index< idx + 1 >{}, first, n, align, obj_sz);
+}
+
+template< class... Pools >
+uint8_t *size_class_pool< Pools... >::alloc_from(index< classes >, size_t first,
+                                                 size_t n, size_t align, size_t obj_sz)
+{
+    (void) first;
+    (void) n;
+    (void) align;
+    (void) obj_sz;
+    return nullptr;
+}
+
+template< class... Pools >
+template< size_t idx >
+void size_class_pool< Pools... >::dealloc_to(index< idx >, uint8_t *p, size_t n, size_t obj_sz)
+{
+    auto &pool = std::get< idx >(m_pools);
+
+    if (pool.owns(p)) {
+        pool.real_dealloc(p, n, obj_sz);
+    } else {
+        dealloc_to(index< idx + 1 >{}, p, n, obj_sz);
+    }
+}
+
+template< class... Pools >
+void size_class_pool< Pools... >::dealloc_to(index< classes >, uint8_t *p, size_t n, size_t obj_sz)
+{
+    (void) p;
+    (void) n;
+    (void) obj_sz;
+    // Chunk doesn't belong to any class
+    ecl_assert(false);
+}
+
+template< class... Pools >
+template< size_t idx >
+pool_stats size_class_pool< Pools... >::stats_of(index< idx >, size_t cls) const
+{
+    return cls == idx ? std::get< idx >(m_pools).get_stats()
+                      : stats_of(index< idx + 1 >{}, cls);
+}
+
+template< class... Pools >
+pool_stats size_class_pool< Pools... >::stats_of(index< classes >, size_t cls) const
+{
+    (void) cls;
+    return pool_stats{};
+}
+
+} // namespace ecl
+
+#endif // LIB_ALLOC_SIZE_CLASS_POOL_HPP_
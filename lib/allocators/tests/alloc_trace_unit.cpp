@@ -0,0 +1,111 @@
+#include <ecl/pool.hpp>
+
+#include <CppUTest/TestHarness.h>
+
+using test_pool = ecl::pool< 16, 8 >;
+
+static test_pool *pool;
+static test_pool *other_pool;
+static ecl::alloc_trace_log< 4 > *log;
+
+static uint32_t ticks;
+
+static uint32_t fake_clock()
+{
+    return ticks++;
+}
+
+TEST_GROUP(alloc_trace)
+{
+    void setup()
+    {
+        pool = new test_pool;
+        other_pool = new test_pool;
+        log = new ecl::alloc_trace_log< 4 >{};
+        ticks = 100;
+    }
+
+    void teardown()
+    {
+        delete pool;
+        delete other_pool;
+        delete log;
+    }
+
+    const ecl::alloc_trace_record &record(uint32_t seq)
+    {
+        return log->records[seq % 4];
+    }
+};
+
+TEST(alloc_trace, untraced_pool_records_nothing)
+{
+    pool->deallocate(pool->aligned_alloc< uint32_t >(2), 2);
+
+    CHECK_EQUAL(0, log->hdr.magic);
+    CHECK_EQUAL(0, log->hdr.head);
+}
+
+TEST(alloc_trace, allocations_are_recorded)
+{
+    pool->set_trace(ecl::alloc_trace{*log, 3, fake_clock, 1000});
+
+    CHECK_EQUAL(ecl::alloc_trace_magic, log->hdr.magic);
+    CHECK_EQUAL(4, log->hdr.capacity);
+    CHECK_EQUAL(1000, log->hdr.clock_hz);
+
+    auto p = pool->aligned_alloc< uint32_t >(5);
+    pool->deallocate(p, 5);
+
+    CHECK_EQUAL(2, log->hdr.head);
+
+    auto &a = record(0);
+    CHECK_EQUAL(0, a.seq);
+    CHECK_EQUAL(100, a.time);
+    CHECK_EQUAL(static_cast< uint32_t >(reinterpret_cast< uintptr_t >(p)), a.addr);
+    CHECK_EQUAL(5 * sizeof(uint32_t), a.size);
+    CHECK_EQUAL(3, a.pool);
+    CHECK_EQUAL(static_cast< uint8_t >(ecl::alloc_trace_event::alloc), a.event);
+    CHECK_TRUE(a.caller);
+
+    auto &d = record(1);
+    CHECK_EQUAL(1, d.seq);
+    CHECK_EQUAL(101, d.time);
+    CHECK_EQUAL(a.addr, d.addr);
+    CHECK_EQUAL(static_cast< uint8_t >(ecl::alloc_trace_event::dealloc), d.event);
+}
+
+TEST(alloc_trace, failures_are_recorded)
+{
+    pool->set_trace(ecl::alloc_trace{*log, 1});
+
+    POINTERS_EQUAL(nullptr, pool->aligned_alloc< uint8_t >(test_pool::block_size * 9));
+
+    auto &f = record(0);
+    CHECK_EQUAL(static_cast< uint8_t >(ecl::alloc_trace_event::fail), f.event);
+    CHECK_EQUAL(0, f.addr);
+    CHECK_EQUAL(0, f.time);
+    CHECK_EQUAL(0, log->hdr.clock_hz);
+}
+
+TEST(alloc_trace, pools_share_log_and_old_records_are_overwritten)
+{
+    pool->set_trace(ecl::alloc_trace{*log, 1});
+    other_pool->set_trace(ecl::alloc_trace{*log, 2});
+
+    for (int i = 0; i < 3; ++i) {
+        pool->deallocate(pool->aligned_alloc< uint8_t >(1), 1);
+    }
+    other_pool->aligned_alloc< uint8_t >(1);
+
+    CHECK_EQUAL(7, log->hdr.head);
+    CHECK_EQUAL(6, record(6).seq);
+    CHECK_EQUAL(2, record(6).pool);
+    CHECK_EQUAL(1, record(5).pool);
+
+    // Stopped trace leaves the log intact
+    pool->set_trace(ecl::alloc_trace{});
+    pool->aligned_alloc< uint8_t >(1);
+
+    CHECK_EQUAL(7, log->hdr.head);
+}
@@ -0,0 +1,92 @@
+#include <ecl/arena.hpp>
+
+#include <CppUTest/TestHarness.h>
+
+static constexpr auto arena_size = 64;
+
+using test_arena = ecl::arena< arena_size >;
+
+static test_arena *arena;
+
+TEST_GROUP(arena)
+{
+    void setup()
+    {
+        arena = new test_arena;
+    }
+
+    void teardown()
+    {
+        delete arena;
+    }
+};
+
+TEST(arena, bump_allocation)
+{
+    ecl::pool_allocator< char >     chars{arena};
+    ecl::pool_allocator< uint32_t > words = chars.rebind< uint32_t >();
+
+    auto c = chars.allocate(3);
+    auto w = words.allocate(2);
+
+    // Chunks are placed one after another, with respect to alignment
+    POINTERS_EQUAL(c + 4, w);
+    CHECK_EQUAL(12, arena->used());
+
+    // Deallocation doesn't release anything
+    words.deallocate(w, 2);
+    CHECK_EQUAL(12, arena->used());
+
+    // Exactly the rest of the arena
+    auto rest = chars.allocate(arena_size - 12);
+    CHECK_TRUE(rest != nullptr);
+    POINTERS_EQUAL(nullptr, chars.allocate(1));
+
+    arena->reset();
+    CHECK_EQUAL(0, arena->used());
+    POINTERS_EQUAL(c, chars.allocate(1));
+}
+
+TEST(arena, scoped_reset)
+{
+    ecl::pool_allocator< char > alloc{arena};
+
+    auto outer = alloc.allocate(8);
+
+    {
+        ecl::arena_scope scope{*arena};
+        alloc.allocate(16);
+
+        {
+            ecl::arena_scope inner{*arena};
+            alloc.allocate(16);
+            CHECK_EQUAL(40, arena->used());
+        }
+
+        CHECK_EQUAL(24, arena->used());
+    }
+
+    CHECK_EQUAL(8, arena->used());
+    POINTERS_EQUAL(outer + 8, alloc.allocate(1));
+}
+
+TEST(arena, usage_stats)
+{
+    ecl::pool_allocator< uint32_t > alloc{arena};
+
+    {
+        ecl::arena_scope scope{*arena};
+        alloc.allocate(4);
+        POINTERS_EQUAL(nullptr, alloc.allocate(arena_size));
+
+        auto stats = arena->get_stats();
+        CHECK_EQUAL(16, stats.used);
+        CHECK_EQUAL(1, stats.failed);
+        CHECK_EQUAL(arena_size - 16, stats.largest_free);
+    }
+
+    auto stats = arena->get_stats();
+    CHECK_EQUAL(0, stats.used);
+    CHECK_EQUAL(16, stats.peak);
+    CHECK_EQUAL(arena_size, stats.largest_free);
+}
@@ -0,0 +1,70 @@
+#include <ecl/lockfree_pool.hpp>
+
+#include <set>
+
+#include <CppUTest/TestHarness.h>
+
+static constexpr auto block_size    = 16; // Must be power of two
+static constexpr auto blocks        = 10;
+
+using test_pool = ecl::lockfree_pool< block_size, blocks >;
+
+static test_pool *pool;
+
+struct half_block
+{
+    char data[block_size / 2];
+};
+
+struct over_block
+{
+    char data[block_size + 1];
+};
+
+TEST_GROUP(lockfree_pool)
+{
+    void setup()
+    {
+        pool = new test_pool;
+    }
+
+    void teardown()
+    {
+        delete pool;
+    }
+};
+
+TEST(lockfree_pool, alloc_all_blocks)
+{
+    std::set< half_block * > taken;
+
+    for (size_t i = 0; i < blocks; ++i) {
+        auto p = pool->aligned_alloc< half_block >(1);
+        CHECK_TRUE(pool->owns(reinterpret_cast< uint8_t * >(p)));
+        CHECK_EQUAL(0, reinterpret_cast< uintptr_t >(p) % block_size);
+        taken.insert(p);
+    }
+
+    // All blocks are distinct
+    CHECK_EQUAL(blocks, taken.size());
+    POINTERS_EQUAL(nullptr, pool->aligned_alloc< half_block >(1));
+
+    for (auto p : taken) {
+        pool->deallocate(p, 1);
+    }
+
+    // Last freed block is reused first
+    auto last = *taken.rbegin();
+    POINTERS_EQUAL(last, pool->aligned_alloc< half_block >(1));
+    pool->deallocate(last, 1);
+}
+
+TEST(lockfree_pool, no_multi_block_chunks)
+{
+    POINTERS_EQUAL(nullptr, pool->aligned_alloc< over_block >(1));
+    POINTERS_EQUAL(nullptr, pool->aligned_alloc< half_block >(3));
+
+    auto p = pool->aligned_alloc< half_block >(2);
+    CHECK_TRUE(p != nullptr);
+    pool->deallocate(p, 2);
+}
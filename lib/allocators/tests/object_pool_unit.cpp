@@ -0,0 +1,75 @@
+#include <ecl/object_pool.hpp>
+
+#include <CppUTest/TestHarness.h>
+
+// Transaction descriptor, as bus would have it
+struct descriptor
+{
+    uint32_t    id;
+    const void  *buf;
+    uint16_t    len;
+};
+
+struct oversized_descriptor
+{
+    descriptor  base;
+    uint32_t    extra[4];
+};
+
+static constexpr auto slots = 4;
+
+using test_pool = ecl::object_pool< descriptor, slots >;
+
+static test_pool *pool;
+
+TEST_GROUP(object_pool)
+{
+    void setup()
+    {
+        pool = new test_pool;
+    }
+
+    void teardown()
+    {
+        delete pool;
+    }
+};
+
+TEST(object_pool, through_allocator)
+{
+    ecl::pool_allocator< descriptor > alloc{pool};
+    descriptor *d[slots];
+
+    for (auto &p : d) {
+        p = alloc.allocate(1);
+        CHECK_TRUE(pool->owns(reinterpret_cast< uint8_t * >(p)));
+        CHECK_EQUAL(0, reinterpret_cast< uintptr_t >(p) % alignof(descriptor));
+
+        // Object can be used freely, it doesn't overlap with others
+        *p = descriptor{ 0xdeadbeef, nullptr, 0xffff };
+    }
+
+    POINTERS_EQUAL(nullptr, alloc.allocate(1));
+
+    for (auto p : d) {
+        CHECK_EQUAL(0xdeadbeef, p->id);
+        alloc.deallocate(p, 1);
+    }
+
+    // Slots are reused in LIFO order
+    POINTERS_EQUAL(d[slots - 1], alloc.allocate(1));
+    POINTERS_EQUAL(d[slots - 2], alloc.allocate(1));
+}
+
+TEST(object_pool, chunk_doesnt_fit)
+{
+    ecl::pool_base *base = pool;
+
+    POINTERS_EQUAL(nullptr, base->aligned_alloc< oversized_descriptor >(1));
+    POINTERS_EQUAL(nullptr, base->aligned_alloc< descriptor >(2));
+
+    // Smaller object fits into a slot
+    auto p = base->aligned_alloc< uint32_t >(1);
+    CHECK_TRUE(p != nullptr);
+    base->deallocate(p, 1);
+}
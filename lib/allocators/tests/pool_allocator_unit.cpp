@@ -0,0 +1,127 @@
+#include <ecl/pool.hpp>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+
+using test_pool = ecl::pool< 16, 64 >;
+
+template< typename T >
+using alloc = ecl::pool_allocator< T >;
+
+using pool_vector = std::vector< int, alloc< int > >;
+
+static test_pool *pool;
+static test_pool *other_pool;
+
+TEST_GROUP(pool_allocator)
+{
+    void setup()
+    {
+        pool = new test_pool;
+        other_pool = new test_pool;
+    }
+
+    void teardown()
+    {
+        delete pool;
+        delete other_pool;
+    }
+};
+
+TEST(pool_allocator, allocators_are_equal_if_pool_is_shared)
+{
+    alloc< int > a{pool};
+    alloc< double > b{a};
+    alloc< int > c{other_pool};
+
+    CHECK_TRUE(a == b);
+    CHECK_FALSE(a != b);
+    CHECK_TRUE(a != c);
+    POINTERS_EQUAL(pool, b.get_pool());
+
+    using traits = std::allocator_traits< alloc< int > >;
+    CHECK_TRUE((std::is_same< traits::rebind_alloc< char >, alloc< char > >::value));
+    CHECK_TRUE(traits::propagate_on_container_move_assignment::value);
+    CHECK_FALSE(traits::is_always_equal::value);
+}
+
+TEST(pool_allocator, vector_storage_is_taken_from_pool)
+{
+    {
+        pool_vector v{alloc< int >{pool}};
+
+        for (int i = 0; i < 40; ++i) {
+            v.push_back(i);
+        }
+
+        CHECK_TRUE(pool->owns(reinterpret_cast< uint8_t* >(v.data())));
+        CHECK_TRUE(pool->get_stats().used >= 40 * sizeof(int) / test_pool::block_size);
+        CHECK_EQUAL(39, v.back());
+    }
+
+    CHECK_EQUAL(0, pool->get_stats().used);
+}
+
+TEST(pool_allocator, node_containers_rebind_to_pool)
+{
+    {
+        std::map< int, int, std::less< int >, alloc< std::pair< const int, int > > >
+            m{alloc< std::pair< const int, int > >{pool}};
+        std::list< char, alloc< char > > l{alloc< char >{pool}};
+
+        m[1] = 2;
+        m[3] = 4;
+        l.push_back('a');
+
+        // One node per element, each one fits into few blocks
+        CHECK_TRUE(pool->get_stats().used >= 3);
+        CHECK_EQUAL(4, m[3]);
+    }
+
+    CHECK_EQUAL(0, pool->get_stats().used);
+}
+
+TEST(pool_allocator, move_assignment_takes_pool_along)
+{
+    pool_vector from{{1, 2, 3}, alloc< int >{pool}};
+    pool_vector to{alloc< int >{other_pool}};
+    auto data = from.data();
+
+    to = std::move(from);
+
+    POINTERS_EQUAL(data, to.data());
+    POINTERS_EQUAL(pool, to.get_allocator().get_pool());
+
+    to.clear();
+    to.shrink_to_fit();
+
+    CHECK_EQUAL(0, pool->get_stats().used);
+    CHECK_EQUAL(0, other_pool->get_stats().used);
+}
+
+TEST(pool_allocator, swap_exchanges_pools)
+{
+    pool_vector a{{1}, alloc< int >{pool}};
+    pool_vector b{{2, 3}, alloc< int >{other_pool}};
+
+    a.swap(b);
+
+    CHECK_EQUAL(2, a.size());
+    POINTERS_EQUAL(other_pool, a.get_allocator().get_pool());
+    POINTERS_EQUAL(pool, b.get_allocator().get_pool());
+}
+
+TEST(pool_allocator, shared_object_is_placed_in_pool)
+{
+    auto p = std::allocate_shared< int >(alloc< int >{pool}, 5);
+
+    CHECK_EQUAL(5, *p);
+    CHECK_TRUE(pool->owns(reinterpret_cast< uint8_t* >(p.get())));
+
+    p.reset();
+    CHECK_EQUAL(0, pool->get_stats().used);
+}
@@ -46,8 +46,8 @@ struct less_than_block
 static void check_if_empty_pool_is_empty()
 {
     auto &info = real_pool->get_info();
-    for (size_t i = 0; i < info.size(); i++) {
-        auto byte = info[i];
+    for (size_t i = 0; i < info.word_count; i++) {
+        auto byte = info.word(i);
         if (byte) { // Something is still present in pool
             std::stringstream ss;
             ss << "Byte at position [" << i << "] indicates that something is "
@@ -86,9 +86,10 @@ static void test_alloc_dealloc_with_type(size_t n, size_t blk_cnt)
     size_t cnt = 0;
 
     // Count how many blocks are used.
-    std::for_each(info.begin(), info.end(), [&cnt](auto val) {
-        cnt += std::bitset< 8 >{val}.count();
-    });
+    for (size_t i = 0; i < info.word_count; i++) {
+        auto val = info.word(i);
+        cnt += std::bitset< sizeof(val) * 8 >{val}.count();
+    }
 
     if (blk_cnt != cnt) {
         std::cout << "\n\nRequested type size: " << sizeof(T) << std::endl;
@@ -220,3 +221,129 @@ TEST(pool_unit, randomly_allocate_and_deallocate)
     // Check that no data is present
     check_if_empty_pool_is_empty();
 }
+
+TEST(pool_unit, reuse_of_freed_blocks)
+{
+    exactly_block *p[blocks];
+
+    for (size_t i = 0; i < blocks; ++i) {
+        p[i] = test_pool->aligned_alloc< exactly_block >(1);
+        CHECK_TRUE(p[i] != nullptr);
+    }
+
+    // Free blocks from both sides of an info word boundary
+    test_pool->deallocate< exactly_block >(p[70], 1);
+    test_pool->deallocate< exactly_block >(p[30], 1);
+    test_pool->deallocate< exactly_block >(p[31], 1);
+    test_pool->deallocate< exactly_block >(p[32], 1);
+
+    // Lowest free block is picked first
+    POINTERS_EQUAL(p[30], test_pool->aligned_alloc< exactly_block >(1));
+
+    // Run that doesn't fit into the hole is not allocated
+    POINTERS_EQUAL(nullptr, test_pool->aligned_alloc< exactly_block >(3));
+
+    // Run that crosses a word boundary
+    auto run = test_pool->aligned_alloc< exactly_block >(2);
+    POINTERS_EQUAL(p[31], run);
+
+    test_pool->deallocate< exactly_block >(p[30], 1);
+    test_pool->deallocate< exactly_block >(run, 2);
+    run = test_pool->aligned_alloc< exactly_block >(3);
+    POINTERS_EQUAL(p[30], run);
+
+    POINTERS_EQUAL(p[70], test_pool->aligned_alloc< exactly_block >(1));
+    POINTERS_EQUAL(nullptr, test_pool->aligned_alloc< exactly_block >(1));
+
+    test_pool->deallocate< exactly_block >(run, 3);
+    for (size_t i = 0; i < blocks; ++i) {
+        if (i < 30 || i > 32) {
+            test_pool->deallocate< exactly_block >(p[i], 1);
+        }
+    }
+
+    check_if_empty_pool_is_empty();
+}
+
+// Lock policy that tracks its state
+struct counting_lock
+{
+    void lock()
+    {
+        CHECK_FALSE(locked);
+        locked = true;
+        ++count;
+    }
+
+    void unlock()
+    {
+        CHECK_TRUE(locked);
+        locked = false;
+    }
+
+    static bool     locked;
+    static size_t   count;
+};
+
+bool   counting_lock::locked;
+size_t counting_lock::count;
+
+TEST(pool_unit, lock_policy)
+{
+    ecl::pool< block_size, blocks, counting_lock > pool;
+    ecl::pool_base *base = &pool;
+
+    counting_lock::count = 0;
+
+    auto p = base->aligned_alloc< exactly_block >(2);
+    CHECK_TRUE(p != nullptr);
+    base->deallocate(p, 2);
+
+    // Failed allocation takes the lock too
+    POINTERS_EQUAL(nullptr, base->aligned_alloc< exactly_block >(blocks + 1));
+
+    CHECK_EQUAL(3, counting_lock::count);
+    CHECK_FALSE(counting_lock::locked);
+}
+
+TEST(pool_unit, usage_stats)
+{
+    auto stats = test_pool->get_stats();
+    CHECK_EQUAL(0, stats.used);
+    CHECK_EQUAL(0, stats.peak);
+    CHECK_EQUAL(0, stats.failed);
+    CHECK_EQUAL(blocks, stats.largest_free);
+
+    auto a = test_pool->aligned_alloc< exactly_block >(10);
+    // Three objects, four blocks
+    auto b = test_pool->aligned_alloc< more_than_block >(3);
+    auto c = test_pool->aligned_alloc< exactly_block >(20);
+
+    // Split free space into two runs: 10 blocks and the tail
+    test_pool->deallocate(a, 10);
+    POINTERS_EQUAL(nullptr, test_pool->aligned_alloc< exactly_block >(blocks));
+
+    stats = test_pool->get_stats();
+    CHECK_EQUAL(4 + 20, stats.used);
+    CHECK_EQUAL(10 + 4 + 20, stats.peak);
+    CHECK_EQUAL(1, stats.failed);
+    CHECK_EQUAL(blocks - 10 - 4 - 20, stats.largest_free);
+
+    test_pool->deallocate(b, 3);
+    test_pool->deallocate(c, 20);
+
+    stats = test_pool->get_stats();
+    CHECK_EQUAL(0, stats.used);
+    CHECK_EQUAL(10 + 4 + 20, stats.peak);
+    CHECK_EQUAL(blocks, stats.largest_free);
+}
+
+TEST(pool_unit, data_alignment)
+{
+    ecl::pool< block_size, 4, ecl::no_lock, 64 > pool;
+    ecl::pool_base *base = &pool;
+
+    auto p = base->aligned_alloc< exactly_block >(1);
+    CHECK_EQUAL(0, reinterpret_cast< uintptr_t >(p) % 64);
+    base->deallocate(p, 1);
+}
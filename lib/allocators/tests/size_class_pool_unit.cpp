@@ -0,0 +1,105 @@
+#include <ecl/size_class_pool.hpp>
+
+#include <new>
+#include <type_traits>
+
+#include <CppUTest/TestHarness.h>
+
+using small_pool    = ecl::pool< 16, 4 >;
+using medium_pool   = ecl::pool< 64, 4 >;
+using large_pool    = ecl::pool< 256, 2 >;
+using test_pool     = ecl::size_class_pool< small_pool, medium_pool, large_pool >;
+
+// Pool is over-aligned, so it can't be allocated by plain new
+static std::aligned_storage_t< sizeof(test_pool), alignof(test_pool) > storage;
+static test_pool *pool;
+
+struct small_type
+{
+    char data[12];
+};
+
+struct medium_type
+{
+    char data[40];
+};
+
+TEST_GROUP(size_class_pool)
+{
+    void setup()
+    {
+        pool = new (&storage) test_pool;
+    }
+
+    void teardown()
+    {
+        pool->~test_pool();
+    }
+};
+
+TEST(size_class_pool, routed_to_best_fit_class)
+{
+    auto &small     = pool->pool_for< small_type >();
+    auto &medium    = pool->pool_for< medium_type >();
+    auto &large     = pool->pool_for< medium_type, 4 >();
+
+    auto s  = pool->aligned_alloc< small_type >(1);
+    auto m  = pool->aligned_alloc< medium_type >(1);
+    auto l  = pool->aligned_alloc< medium_type >(4);
+
+    CHECK_TRUE(small.owns(reinterpret_cast< uint8_t * >(s)));
+    CHECK_TRUE(medium.owns(reinterpret_cast< uint8_t * >(m)));
+    CHECK_TRUE(large.owns(reinterpret_cast< uint8_t * >(l)));
+
+    CHECK_EQUAL(1, pool->class_stats(0).used);
+    CHECK_EQUAL(1, pool->class_stats(1).used);
+    CHECK_EQUAL(1, pool->class_stats(2).used);
+
+    pool->deallocate(s, 1);
+    pool->deallocate(m, 1);
+    pool->deallocate(l, 4);
+
+    CHECK_EQUAL(0, pool->class_stats(2).used);
+    CHECK_EQUAL(1, pool->class_stats(2).peak);
+}
+
+TEST(size_class_pool, spill_to_larger_class)
+{
+    small_type *s[small_pool::block_count];
+
+    for (auto &p : s) {
+        p = pool->aligned_alloc< small_type >(1);
+        CHECK_TRUE(p != nullptr);
+    }
+
+    // Small class is depleted, next allocation goes to the medium one
+    auto extra = pool->aligned_alloc< small_type >(1);
+    CHECK_TRUE(pool->pool_for< medium_type >().owns(reinterpret_cast< uint8_t * >(extra)));
+    pool->deallocate(extra, 1);
+
+    for (auto p : s) {
+        pool->deallocate(p, 1);
+    }
+
+    // After deallocation small class is used again
+    extra = pool->aligned_alloc< small_type >(1);
+    POINTERS_EQUAL(s[0], extra);
+    pool->deallocate(extra, 1);
+}
+
+TEST(size_class_pool, oversized_chunk)
+{
+    // Spans both blocks of the largest class
+    auto &large = pool->pool_for< char, 300 >();
+
+    auto p = pool->aligned_alloc< char >(300);
+    CHECK_TRUE(large.owns(reinterpret_cast< uint8_t * >(p)));
+
+    POINTERS_EQUAL(nullptr, pool->aligned_alloc< char >(300));
+
+    pool->deallocate(p, 300);
+
+    p = pool->aligned_alloc< char >(300);
+    CHECK_TRUE(p != nullptr);
+    pool->deallocate(p, 300);
+}
@@ -0,0 +1,265 @@
+// Decodes allocation logs of pools, see ecl/alloc_trace.hpp.
+//
+// Input is a binary dump of alloc_trace_log, or of any memory region that
+// contains such logs, e.g. whole RAM. Every log found is decoded. For each
+// pool, allocation sites are listed with their call counts, bytes and
+// failures, hottest first, followed by chunks that are still allocated
+// when the dump was taken, grouped by site. Sites are addresses of the code
+// that called the allocator, use addr2line to resolve them.
+//
+//   alloc_trace_decode [-v] dump.bin
+//
+// With -v every event is printed before the summary.
+//
+// Only surviving records are seen: chunks allocated before the oldest one
+// are not reported as live, and their deallocations are counted as
+// unmatched.
+
+#include <ecl/alloc_trace.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace
+{
+
+using namespace ecl;
+
+struct site_stats
+{
+    unsigned    allocs = 0;
+    unsigned    deallocs = 0;
+    unsigned    fails = 0;
+    uint64_t    bytes = 0;
+    double      lifetime = 0;   // Sum of lifetimes of freed chunks, us
+    unsigned    live = 0;
+    uint64_t    live_bytes = 0;
+};
+
+struct pool_stats
+{
+    unsigned    allocs = 0;
+    unsigned    deallocs = 0;
+    unsigned    fails = 0;
+    unsigned    unmatched = 0;
+    uint64_t    live_bytes = 0;
+    uint64_t    peak_bytes = 0;
+
+    std::map< uint32_t, site_stats > sites;
+};
+
+// Chunk allocated within the window
+struct chunk
+{
+    uint32_t    caller;
+    uint32_t    size;
+    double      time;
+};
+
+const char *event_name(uint8_t ev)
+{
+    static const char *names[] = { "alloc", "dealloc", "fail" };
+    return ev < sizeof(names) / sizeof(names[0]) ? names[ev] : "?";
+}
+
+// Finds next log in a dump, starting from given offset.
+// Returns offset of its records or 0 if there is none.
+size_t find_log(const std::vector< uint8_t > &dump, size_t &offt, alloc_trace_header &hdr)
+{
+    for (; offt + sizeof(hdr) <= dump.size(); offt += 4) {
+        memcpy(&hdr, dump.data() + offt, sizeof(hdr));
+
+        if (hdr.magic != alloc_trace_magic || hdr.version != alloc_trace_version) {
+            continue;
+        }
+
+        if (!hdr.capacity || (hdr.capacity & (hdr.capacity - 1))) {
+            continue;
+        }
+
+        size_t size = sizeof(hdr) + hdr.capacity * sizeof(alloc_trace_record);
+        if (offt + size <= dump.size()) {
+            size_t records = offt + sizeof(hdr);
+            offt += size;
+            return records;
+        }
+    }
+
+    return 0;
+}
+
+void decode(const uint8_t *data, const alloc_trace_header &hdr, bool verbose)
+{
+    // Only last capacity records survive
+    uint32_t first = hdr.head > hdr.capacity ? hdr.head - hdr.capacity : 0;
+    std::vector< alloc_trace_record > records;
+    unsigned dropped = 0;
+
+    for (uint32_t seq = first; seq != hdr.head; ++seq) {
+        alloc_trace_record r;
+        memcpy(&r, data + (seq & (hdr.capacity - 1)) * sizeof(r), sizeof(r));
+
+        // Record was being written when the dump was taken
+        if (r.seq != seq) {
+            ++dropped;
+            continue;
+        }
+
+        records.push_back(r);
+    }
+
+    printf("%u records, %u lost to overwrite, %u incomplete, clock %u Hz\n",
+           static_cast< unsigned >(records.size()), first, dropped, hdr.clock_hz);
+
+    if (records.empty()) {
+        return;
+    }
+
+    double us_per_tick = hdr.clock_hz ? 1e6 / hdr.clock_hz : 0;
+
+    std::map< uint8_t, pool_stats > pools;
+    std::map< std::pair< uint8_t, uint32_t >, chunk > live;
+
+    // Timestamps are unwrapped by accumulating differences. Difference can be
+    // negative, if a record was preempted between reservation and timestamp.
+    double now = 0;
+    uint32_t prev = records.front().time;
+
+    if (verbose) {
+        printf("%12s %4s  %-7s %10s %10s %10s\n",
+               "time, us", "pool", "event", "addr", "size", "caller");
+    }
+
+    for (auto &r : records) {
+        now += static_cast< int32_t >(r.time - prev) * us_per_tick;
+        prev = r.time;
+
+        auto &p = pools[r.pool];
+        auto &s = p.sites[r.caller];
+        auto ev = static_cast< alloc_trace_event >(r.event);
+
+        switch (ev) {
+        case alloc_trace_event::alloc:
+            p.allocs++;
+            s.allocs++;
+            s.bytes += r.size;
+            p.live_bytes += r.size;
+            p.peak_bytes = std::max(p.peak_bytes, p.live_bytes);
+            live[{r.pool, r.addr}] = chunk{r.caller, r.size, now};
+            break;
+        case alloc_trace_event::dealloc: {
+            p.deallocs++;
+            s.deallocs++;
+
+            auto it = live.find({r.pool, r.addr});
+            if (it == live.end()) {
+                p.unmatched++;
+                break;
+            }
+
+            p.live_bytes -= it->second.size;
+            p.sites[it->second.caller].lifetime += now - it->second.time;
+            live.erase(it);
+            break;
+        }
+        case alloc_trace_event::fail:
+            p.fails++;
+            s.fails++;
+            break;
+        }
+
+        if (verbose) {
+            printf("%12.3f %4u  %-7s 0x%08x %10u 0x%08x\n",
+                   now, r.pool, event_name(r.event), r.addr, r.size, r.caller);
+        }
+    }
+
+    for (auto &it : live) {
+        auto &s = pools[it.first.first].sites[it.second.caller];
+        s.live++;
+        s.live_bytes += it.second.size;
+    }
+
+    printf("\nSummary over %.3f us:\n", now);
+
+    for (auto &it : pools) {
+        auto &p = it.second;
+
+        printf("pool %u: %u allocs, %u deallocs, %u unmatched, %u failed,"
+               " %llu bytes live, peak %llu\n",
+               it.first, p.allocs, p.deallocs, p.unmatched, p.fails,
+               static_cast< unsigned long long >(p.live_bytes),
+               static_cast< unsigned long long >(p.peak_bytes));
+
+        // Sites that allocate most often come first
+        std::vector< std::pair< uint32_t, site_stats > > sites{p.sites.begin(), p.sites.end()};
+        std::sort(sites.begin(), sites.end(), [](const auto &l, const auto &r) {
+            return l.second.allocs + l.second.fails > r.second.allocs + r.second.fails;
+        });
+
+        for (auto &s : sites) {
+            auto &st = s.second;
+            if (!st.allocs && !st.fails) {
+                continue;
+            }
+
+            unsigned freed = st.allocs - st.live;
+
+            printf("  site 0x%08x: %u allocs, %llu bytes, %u failed",
+                   s.first, st.allocs, static_cast< unsigned long long >(st.bytes), st.fails);
+            if (us_per_tick && freed) {
+                printf(", lifetime avg %.3f us", st.lifetime / freed);
+            }
+
+            printf("\n");
+        }
+
+        for (auto &s : sites) {
+            if (s.second.live) {
+                printf("  live from 0x%08x: %u chunks, %llu bytes\n", s.first, s.second.live,
+                       static_cast< unsigned long long >(s.second.live_bytes));
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    bool verbose = argc > 2 && !strcmp(argv[1], "-v");
+
+    if (argc < 2 || (argc > 2 && !verbose)) {
+        fprintf(stderr, "Usage: %s [-v] dump.bin\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream in{argv[argc - 1], std::ios::binary};
+    if (!in) {
+        fprintf(stderr, "Can't open %s\n", argv[argc - 1]);
+        return 1;
+    }
+
+    std::vector< uint8_t > dump{std::istreambuf_iterator< char >{in},
+                                std::istreambuf_iterator< char >{}};
+
+    alloc_trace_header hdr;
+    unsigned logs = 0;
+
+    for (size_t offt = 0, records; (records = find_log(dump, offt, hdr)); ++logs) {
+        printf("%sLog at offset 0x%zx: ", logs ? "\n" : "", records - sizeof(hdr));
+        decode(dump.data() + records, hdr, verbose);
+    }
+
+    if (!logs) {
+        fprintf(stderr, "No allocation log found\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,388 @@
+#ifndef LIB_BENCH_BENCH_HPP_
+#define LIB_BENCH_BENCH_HPP_
+
+//!
+//! \file
+//! \brief Micro-benchmarks, run on host and on target.
+//! Each benchmark is a plain function, registered with ECL_BENCH().
+//! Function is called few times to warm up caches and branch predictors,
+//! then measured samples are taken. Minimum, median and maximum time of
+//! a single call are reported, as well as calls per second and, if
+//! benchmark processes data, throughput. Time is measured by the platform
+//! clock: nanoseconds on host, CPU cycles on target.
+//! \code
+//! ECL_BENCH(pool_alloc)
+//! {
+//!     auto p = pool.alloc();
+//!     ecl::bench::do_not_optimize(p);
+//!     pool.free(p);
+//! }
+//!
+//! ecl::bench::run_all(ecl::cout);
+//! \endcode
+//!
+
+#include <ecl/bench/clock.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ecl
+{
+
+namespace bench
+{
+
+//! Maximum amount of measured samples.
+constexpr size_t max_repeats = 64;
+
+//!
+//! \brief How benchmark is run.
+//!
+struct options
+{
+    unsigned    warmup;     //!< Samples taken before measurement.
+    unsigned    repeats;    //!< Measured samples, up to max_repeats.
+    uint32_t    iterations; //!< Calls per sample. Amortizes clock resolution.
+};
+
+//! Options used when none are given.
+constexpr options default_options = { 3, 15, 1 };
+
+//!
+//! \brief Time of a single call, in clock units.
+//!
+struct result
+{
+    clock::rep  min;        //!< Best case.
+    clock::rep  median;     //!< Typical case.
+    clock::rep  max;        //!< Worst case.
+};
+
+//!
+//! \brief Prevents compiler from optimizing out computation of the value.
+//!
+template< class T >
+inline void do_not_optimize(const T &value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+//!
+//! \brief Computes statistics of samples. Samples are reordered.
+//! \param[in,out] samples  Measured durations.
+//! \param[in]     n        Amount of samples, must be greater than zero.
+//!
+inline result summarize(clock::rep *samples, size_t n)
+{
+    std::sort(samples, samples + n);
+    return result{ samples[0], samples[n / 2], samples[n - 1] };
+}
+
+//!
+//! \brief Registered benchmark.
+//! Benchmarks are objects with static storage duration, linked into a list
+//! in order of construction. They are never unregistered, so benchmark must
+//! not be created on the stack.
+//!
+class benchmark
+{
+public:
+    //! Benchmark body.
+    using fn_type = void (*)();
+
+    //! Body that measures itself. Returns time spent in clock units.
+    using manual_fn_type = clock::rep (*)();
+
+    //!
+    //! \brief Registers benchmark.
+    //! \param[in] name Benchmark name, must have static storage duration.
+    //! \param[in] fn   Body, called once per iteration.
+    //! \param[in] opts  How benchmark is run.
+    //! \param[in] bytes Data processed by single call, 0 if none.
+    //!
+    benchmark(const char *name, fn_type fn, const options &opts = default_options,
+              uint32_t bytes = 0);
+
+    //!
+    //! \brief Registers benchmark that measures only a part of its body.
+    //! Useful when time of interest starts or ends somewhere in the middle,
+    //! i.e. latency between an event and its handler.
+    //! \param[in] name Benchmark name, must have static storage duration.
+    //! \param[in] fn   Body, called once per iteration.
+    //! \param[in] opts  How benchmark is run.
+    //! \param[in] bytes Data processed by single call, 0 if none.
+    //!
+    benchmark(const char *name, manual_fn_type fn, const options &opts = default_options,
+              uint32_t bytes = 0);
+
+    benchmark(const benchmark &) = delete;
+    benchmark &operator=(const benchmark &) = delete;
+
+    //! Gets benchmark name.
+    const char *name() const { return m_name; }
+
+    //! Gets options of the benchmark.
+    const options &opts() const { return m_opts; }
+
+    //! Gets data processed by single call, 0 if none.
+    uint32_t bytes() const { return m_bytes; }
+
+    //!
+    //! \brief Runs benchmark.
+    //! Clock overhead is measured before and subtracted from each sample.
+    //!
+    result run() const;
+
+    //! Gets first registered benchmark, if any.
+    static const benchmark *first() { return head(); }
+
+    //! Gets next registered benchmark, if any.
+    const benchmark *next() const { return m_next; }
+
+private:
+    static benchmark *&head();
+    static benchmark *&tail();
+
+    // Gets time the clock itself takes to read
+    static clock::rep overhead();
+
+    // Clamps options and links benchmark into the list
+    void enroll();
+
+    // Takes single sample, in clock units
+    clock::rep sample(clock::rep ovh) const;
+
+    const char      *m_name;    //!< Benchmark name.
+    fn_type         m_fn;       //!< Benchmark body.
+    manual_fn_type  m_manual;   //!< Self-measured body, if fn is not set.
+    options         m_opts;     //!< How benchmark is run.
+    uint32_t        m_bytes;    //!< Data processed by single call.
+    benchmark       *m_next;    //!< Next registered benchmark.
+};
+
+//!
+//! \brief Runs registered benchmarks and reports results.
+//! Line is printed per benchmark. Rates are computed from the median,
+//! throughput is printed only for benchmarks that process data:
+//! \code
+//! <name>: min <n> median <n> max <n> <unit>, <n> op/s, <n> KiB/s
+//! \endcode
+//! \param[in] out      Stream for the report, i.e. ecl::cout or a stream
+//!                     over ITM driver.
+//! \param[in] filter   If not null, only benchmarks with names
+//!                     containing this string are run.
+//! \return Amount of benchmarks run.
+//!
+template< class Stream >
+unsigned run_all(Stream &out, const char *filter = nullptr);
+
+//------------------------------------------------------------------------------
+
+inline benchmark::benchmark(const char *name, fn_type fn, const options &opts,
+                            uint32_t bytes)
+    :m_name{name}
+    ,m_fn{fn}
+    ,m_manual{nullptr}
+    ,m_opts(opts)
+    ,m_bytes{bytes}
+    ,m_next{nullptr}
+{
+    enroll();
+}
+
+inline benchmark::benchmark(const char *name, manual_fn_type fn, const options &opts,
+                            uint32_t bytes)
+    :m_name{name}
+    ,m_fn{nullptr}
+    ,m_manual{fn}
+    ,m_opts(opts)
+    ,m_bytes{bytes}
+    ,m_next{nullptr}
+{
+    enroll();
+}
+
+inline void benchmark::enroll()
+{
+    if (!m_opts.repeats) {
+        m_opts.repeats = 1;
+    } else if (m_opts.repeats > max_repeats) {
+        m_opts.repeats = max_repeats;
+    }
+
+    if (!m_opts.iterations) {
+        m_opts.iterations = 1;
+    }
+
+    if (tail()) {
+        tail()->m_next = this;
+    } else {
+        head() = this;
+    }
+
+    tail() = this;
+}
+
+inline benchmark *&benchmark::head()
+{
+    // Constant-initialized, thus available to constructors of
+    // benchmarks regardless of static init order
+    static benchmark *h = nullptr;
+    return h;
+}
+
+inline benchmark *&benchmark::tail()
+{
+    static benchmark *t = nullptr;
+    return t;
+}
+
+inline clock::rep benchmark::overhead()
+{
+    clock::rep best = static_cast< clock::rep >(-1);
+
+    for (int i = 0; i < 16; ++i) {
+        auto start = clock::now();
+        auto end = clock::now();
+        best = std::min< clock::rep >(best, end - start);
+    }
+
+    return best;
+}
+
+inline clock::rep benchmark::sample(clock::rep ovh) const
+{
+    clock::rep spent = 0;
+
+    if (m_manual) {
+        // Each call reports its own time, overhead is counted per call
+        for (uint32_t j = 0; j < m_opts.iterations; ++j) {
+            clock::rep t = m_manual();
+            spent += t > ovh ? t - ovh : 0;
+        }
+    } else {
+        auto start = clock::now();
+        for (uint32_t j = 0; j < m_opts.iterations; ++j) {
+            m_fn();
+        }
+        spent = clock::now() - start;
+        spent = spent > ovh ? spent - ovh : 0;
+    }
+
+    return spent / m_opts.iterations;
+}
+
+inline result benchmark::run() const
+{
+    clock::rep samples[max_repeats];
+
+    clock::init();
+    auto ovh = overhead();
+
+    for (unsigned i = 0; i < m_opts.warmup; ++i) {
+        sample(ovh);
+    }
+
+    for (unsigned i = 0; i < m_opts.repeats; ++i) {
+        samples[i] = sample(ovh);
+    }
+
+    return summarize(samples, m_opts.repeats);
+}
+
+template< class Stream >
+unsigned run_all(Stream &out, const char *filter)
+{
+    unsigned count = 0;
+
+    for (auto b = benchmark::first(); b; b = b->next()) {
+        if (filter && !strstr(b->name(), filter)) {
+            continue;
+        }
+
+        auto res = b->run();
+        ++count;
+
+        out << b->name() << ": min " << res.min
+            << " median " << res.median
+            << " max " << res.max
+            << " " << clock::unit();
+
+        // Rate of calls faster than the clock resolution is unknown
+        if (res.median) {
+            uint64_t per_second = clock::per_second();
+
+            out << ", " << static_cast< unsigned long >(per_second / res.median) << " op/s";
+
+            if (b->bytes()) {
+                out << ", " << static_cast< unsigned long >
+                        (per_second * b->bytes() / res.median / 1024) << " KiB/s";
+            }
+        }
+
+        out << "\n";
+    }
+
+    return count;
+}
+
+} // namespace bench
+
+} // namespace ecl
+
+//!
+//! \brief Defines and registers benchmark with default options.
+//! Must be followed by the function body.
+//!
+#define ECL_BENCH(name) ECL_BENCH_OPTS(name, ::ecl::bench::default_options)
+
+//!
+//! \brief Defines and registers benchmark with given options.
+//! Must be followed by the function body.
+//!
+#define ECL_BENCH_OPTS(name, opts) \
+    static void ecl_bench_fn_##name(); \
+    static ::ecl::bench::benchmark ecl_bench_##name{#name, ecl_bench_fn_##name, opts}; \
+    static void ecl_bench_fn_##name()
+
+//!
+//! \brief Defines and registers benchmark that processes given amount
+//! of bytes per call. Throughput is reported for it.
+//! Must be followed by the function body.
+//!
+#define ECL_BENCH_BYTES(name, opts, bytes) \
+    static void ecl_bench_fn_##name(); \
+    static ::ecl::bench::benchmark ecl_bench_##name{#name, ecl_bench_fn_##name, opts, bytes}; \
+    static void ecl_bench_fn_##name()
+
+//!
+//! \brief Defines and registers benchmark that measures itself.
+//! Must be followed by the function body, which returns time of interest
+//! taken with ecl::bench::clock::now().
+//! \code
+//! ECL_BENCH_MANUAL(irq_latency, ecl::bench::default_options)
+//! {
+//!     trigger();
+//!     return handled_at - triggered_at;
+//! }
+//! \endcode
+//!
+#define ECL_BENCH_MANUAL(name, opts) \
+    static ::ecl::bench::clock::rep ecl_bench_fn_##name(); \
+    static ::ecl::bench::benchmark ecl_bench_##name{#name, ecl_bench_fn_##name, opts}; \
+    static ::ecl::bench::clock::rep ecl_bench_fn_##name()
+
+//!
+//! \brief Defines and registers benchmark that measures itself and
+//! processes given amount of bytes per call. Throughput is reported for it.
+//! Must be followed by the function body, as for ECL_BENCH_MANUAL().
+//!
+#define ECL_BENCH_MANUAL_BYTES(name, opts, bytes) \
+    static ::ecl::bench::clock::rep ecl_bench_fn_##name(); \
+    static ::ecl::bench::benchmark ecl_bench_##name{#name, ecl_bench_fn_##name, opts, bytes}; \
+    static ::ecl::bench::clock::rep ecl_bench_fn_##name()
+
+#endif // LIB_BENCH_BENCH_HPP_
@@ -0,0 +1,42 @@
+#ifndef LIB_BENCH_HOST_CLOCK_HPP_
+#define LIB_BENCH_HOST_CLOCK_HPP_
+
+#include <chrono>
+#include <cstdint>
+
+namespace ecl
+{
+
+namespace bench
+{
+
+//!
+//! \brief Benchmark clock of the host, based on steady clock.
+//!
+struct clock
+{
+    //! Tick type. Differences of ticks are durations.
+    using rep = uint64_t;
+
+    //! Name of tick unit, used in reports.
+    static const char *unit() { return "ns"; }
+
+    //! Gets amount of ticks per second.
+    static uint64_t per_second() { return 1000000000; }
+
+    //! Prepares clock. Nothing to do on host.
+    static void init() { }
+
+    //! Gets current tick.
+    static rep now()
+    {
+        auto t = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast< std::chrono::nanoseconds >(t).count();
+    }
+};
+
+} // namespace bench
+
+} // namespace ecl
+
+#endif // LIB_BENCH_HOST_CLOCK_HPP_
@@ -0,0 +1,11 @@
+#include <ecl/bench.hpp>
+
+#include <iostream>
+
+// Runs benchmarks, which names contain first argument, if given
+int main(int argc, char *argv[])
+{
+    auto count = ecl::bench::run_all(std::cout, argc > 1 ? argv[1] : nullptr);
+    std::cout << count << " benchmarks run" << std::endl;
+    return 0;
+}
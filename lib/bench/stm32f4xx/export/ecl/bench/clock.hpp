@@ -0,0 +1,50 @@
+#ifndef LIB_BENCH_STM32F4XX_CLOCK_HPP_
+#define LIB_BENCH_STM32F4XX_CLOCK_HPP_
+
+#include <stm32f4xx.h>
+#include <core_cm4.h>
+
+#include <cstdint>
+
+namespace ecl
+{
+
+namespace bench
+{
+
+//!
+//! \brief Benchmark clock of STM32F4, based on DWT cycle counter.
+//! Counter is 32 bits wide, so single sample must be shorter
+//! than 2^32 cycles, about 25 seconds at 168 MHz.
+//!
+struct clock
+{
+    //! Tick type. Differences of ticks are durations.
+    using rep = uint32_t;
+
+    //! Name of tick unit, used in reports.
+    static const char *unit() { return "cycles"; }
+
+    //! Gets amount of ticks per second.
+    static uint64_t per_second() { return SystemCoreClock; }
+
+    //! Starts cycle counter.
+    static void init()
+    {
+        // Cycle counter is a part of debug unit, which must be enabled first
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    //! Gets current tick.
+    static rep now()
+    {
+        return DWT->CYCCNT;
+    }
+};
+
+} // namespace bench
+
+} // namespace ecl
+
+#endif // LIB_BENCH_STM32F4XX_CLOCK_HPP_
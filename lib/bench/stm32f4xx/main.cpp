@@ -0,0 +1,11 @@
+#include <ecl/bench.hpp>
+#include <ecl/iostream.hpp>
+
+// Runs all benchmarks and reports over the console
+int main()
+{
+    auto count = ecl::bench::run_all(ecl::cout);
+    ecl::cout << count << " benchmarks run" << ecl::endl;
+
+    for (;;);
+}
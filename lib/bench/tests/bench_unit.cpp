@@ -0,0 +1,158 @@
+#include <ecl/bench.hpp>
+
+#include <sstream>
+#include <string>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+int calls;
+
+} // namespace
+
+ECL_BENCH(counter)
+{
+    ++calls;
+}
+
+ECL_BENCH_OPTS(counter_iterated, (ecl::bench::options{ 2, 5, 10 }))
+{
+    ++calls;
+}
+
+ECL_BENCH(dummy)
+{
+    int x = 0;
+    ecl::bench::do_not_optimize(x);
+}
+
+// Reports fixed time, overhead is subtracted per call
+ECL_BENCH_MANUAL(manual, (ecl::bench::options{ 1, 3, 4 }))
+{
+    ++calls;
+    return 1000000;
+}
+
+// Throughput is reported
+ECL_BENCH_BYTES(bytes_copied, (ecl::bench::options{ 1, 3, 1 }), 4096)
+{
+    static char src[4096], dst[4096];
+    memcpy(dst, src, sizeof(dst));
+    ecl::bench::do_not_optimize(dst);
+}
+
+// Out of range options
+ECL_BENCH_OPTS(clamped, (ecl::bench::options{ 0, 1000, 0 }))
+{
+    ++calls;
+}
+
+TEST_GROUP(bench)
+{
+    void setup()
+    {
+        calls = 0;
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(bench, registration_order)
+{
+    auto b = ecl::bench::benchmark::first();
+    STRCMP_EQUAL("counter", b->name());
+    b = b->next();
+    STRCMP_EQUAL("counter_iterated", b->name());
+    b = b->next();
+    STRCMP_EQUAL("dummy", b->name());
+    b = b->next();
+    STRCMP_EQUAL("manual", b->name());
+    b = b->next();
+    STRCMP_EQUAL("bytes_copied", b->name());
+    b = b->next();
+    STRCMP_EQUAL("clamped", b->name());
+    POINTERS_EQUAL(nullptr, b->next());
+}
+
+TEST(bench, warmup_and_repeats)
+{
+    auto b = ecl::bench::benchmark::first()->next();
+    auto res = b->run();
+
+    // (warmup + repeats) samples, 10 calls each
+    CHECK_EQUAL(70, calls);
+    CHECK_TRUE(res.min <= res.median);
+    CHECK_TRUE(res.median <= res.max);
+}
+
+TEST(bench, summary)
+{
+    ecl::bench::clock::rep samples[] = { 9, 3, 7, 1, 5 };
+    auto res = ecl::bench::summarize(samples, 5);
+
+    CHECK_EQUAL(1, res.min);
+    CHECK_EQUAL(5, res.median);
+    CHECK_EQUAL(9, res.max);
+}
+
+TEST(bench, manual_timing)
+{
+    auto b = ecl::bench::benchmark::first()->next()->next()->next();
+    auto res = b->run();
+
+    // (warmup + repeats) samples, 4 calls each
+    CHECK_EQUAL(16, calls);
+    CHECK_TRUE(res.max <= 1000000);
+    CHECK_EQUAL(res.min, res.max);
+}
+
+TEST(bench, throughput_report)
+{
+    std::ostringstream out;
+
+    auto count = ecl::bench::run_all(out, "bytes_copied");
+    CHECK_EQUAL(1, count);
+
+    auto report = out.str();
+    CHECK_EQUAL(4096, ecl::bench::benchmark::first()->next()->next()->next()->next()->bytes());
+    CHECK_TRUE(report.find(" KiB/s\n") != std::string::npos);
+}
+
+TEST(bench, options_are_clamped)
+{
+    auto b = ecl::bench::benchmark::first();
+    while (b->next()) {
+        b = b->next();
+    }
+
+    CHECK_EQUAL(ecl::bench::max_repeats, b->opts().repeats);
+    CHECK_EQUAL(1, b->opts().iterations);
+
+    b->run();
+    CHECK_EQUAL(ecl::bench::max_repeats, calls);
+}
+
+TEST(bench, report_with_filter)
+{
+    std::ostringstream out;
+
+    auto count = ecl::bench::run_all(out, "counter");
+    CHECK_EQUAL(2, count);
+
+    auto report = out.str();
+    CHECK_TRUE(report.find("counter: min ") == 0);
+    CHECK_TRUE(report.find("counter_iterated: min ") != std::string::npos);
+    CHECK_TRUE(report.find("dummy") == std::string::npos);
+    CHECK_TRUE(report.find(" ns") != std::string::npos);
+    CHECK_TRUE(report.find("KiB/s") == std::string::npos);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
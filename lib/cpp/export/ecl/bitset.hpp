@@ -0,0 +1,202 @@
+//!
+//! \file
+//! \brief Fixed-size bit set with word-wise search.
+//! Unlike std::bitset, it can be used in constant expressions, searches
+//! a range for set or cleared bits a word at a time and updates whole
+//! runs of bits with a mask per word. That is what allocation bitmaps,
+//! i.e. of ecl::pool, are made of.
+//! \code
+//! ecl::bitset< 100 > used;
+//! used.fill(10, 20, true);
+//! auto free = used.find(10, used.size(), false); // 20
+//! \endcode
+//!
+#ifndef ECL_BITSET_HPP_
+#define ECL_BITSET_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Fixed-size set of bits, stored in 32-bit words.
+//! Indexes out of the set are not checked, callers validate them.
+//! Bits past N in the last word are never set.
+//! \tparam N Amount of bits.
+//!
+template< size_t N >
+class bitset
+{
+    static_assert(N > 0, "Bit set must hold at least one bit");
+
+public:
+    //! Type of a storage word.
+    using word_type = uint32_t;
+    //! Bits in a storage word.
+    static constexpr size_t word_bits  = 32;
+    //! Amount of storage words.
+    static constexpr size_t word_count = (N + word_bits - 1) / word_bits;
+
+    //! Constructs set with all bits cleared.
+    constexpr bitset() :m_words{} { }
+
+    //! Gets amount of bits.
+    static constexpr size_t size() { return N; }
+
+    //!
+    //! \brief Checks bit.
+    //! \pre Index is less than N.
+    //!
+    constexpr bool test(size_t idx) const
+    {
+        return m_words[idx / word_bits] & bit(idx);
+    }
+
+    //!
+    //! \brief Sets or clears single bit.
+    //! \pre Index is less than N.
+    //!
+    constexpr void set(size_t idx, bool value = true)
+    {
+        if (value) {
+            m_words[idx / word_bits] |= bit(idx);
+        } else {
+            m_words[idx / word_bits] &= ~bit(idx);
+        }
+    }
+
+    //!
+    //! \brief Clears single bit.
+    //! \pre Index is less than N.
+    //!
+    constexpr void reset(size_t idx)
+    {
+        set(idx, false);
+    }
+
+    //! Clears all bits.
+    constexpr void reset()
+    {
+        for (auto &w : m_words) {
+            w = 0;
+        }
+    }
+
+    //!
+    //! \brief Sets or clears run of bits, a word at a time.
+    //! \param[in] from  Index of a first bit.
+    //! \param[in] to    Index past the last bit. Must not exceed N.
+    //! \param[in] value Value to assign.
+    //!
+    constexpr void fill(size_t from, size_t to, bool value)
+    {
+        while (from < to) {
+            size_t shift = from % word_bits;
+            size_t len = word_bits - shift < to - from ? word_bits - shift : to - from;
+
+            // Avoid shift by the word width, it is undefined
+            word_type mask = len == word_bits ? ~word_type{0}
+                                              : ((word_type{1} << len) - 1) << shift;
+
+            if (value) {
+                m_words[from / word_bits] |= mask;
+            } else {
+                m_words[from / word_bits] &= ~mask;
+            }
+
+            from += len;
+        }
+    }
+
+    //!
+    //! \brief Finds first set or cleared bit in given range.
+    //! Words without matching bits are skipped at once.
+    //! \param[in] from  Index to start from.
+    //! \param[in] to    Index past the last bit of the range. Must not exceed N.
+    //! \param[in] value True if set bit is searched, false if cleared.
+    //! \return Index of a bit found or \p to if there is no such bit.
+    //!
+    constexpr size_t find(size_t from, size_t to, bool value) const
+    {
+        if (from >= to) {
+            return to;
+        }
+
+        size_t w = from / word_bits;
+        // Bits below the start position are masked out
+        word_type bits = load(w, value) & (~word_type{0} << (from % word_bits));
+
+        while (!bits) {
+            if (++w * word_bits >= to) {
+                return to;
+            }
+
+            bits = load(w, value);
+        }
+
+        size_t idx = w * word_bits + __builtin_ctz(bits);
+        return idx < to ? idx : to;
+    }
+
+    //! Counts set bits.
+    constexpr size_t count() const
+    {
+        size_t cnt = 0;
+
+        for (auto w : m_words) {
+            cnt += __builtin_popcount(w);
+        }
+
+        return cnt;
+    }
+
+    //! Checks if any bit is set.
+    constexpr bool any() const
+    {
+        for (auto w : m_words) {
+            if (w) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    //! Checks if no bit is set.
+    constexpr bool none() const { return !any(); }
+
+    //! Checks if all bits are set.
+    constexpr bool all() const { return find(0, N, false) == N; }
+
+    //!
+    //! \brief Gets storage word, lowest bits go first.
+    //! \pre Index is less than word_count.
+    //!
+    constexpr word_type word(size_t w) const { return m_words[w]; }
+
+private:
+    static constexpr word_type bit(size_t idx)
+    {
+        return word_type{1} << (idx % word_bits);
+    }
+
+    //! Gets word, inverted if cleared bits are searched.
+    constexpr word_type load(size_t w, bool value) const
+    {
+        return value ? m_words[w] : ~m_words[w];
+    }
+
+    word_type m_words[word_count]; //!< Bits, lowest index first.
+};
+
+template< size_t N >
+constexpr size_t bitset< N >::word_bits;
+
+template< size_t N >
+constexpr size_t bitset< N >::word_count;
+
+} // namespace ecl
+
+#endif // ECL_BITSET_HPP_
@@ -0,0 +1,71 @@
+//!
+//! \file
+//! \brief Instruction set extensions of the host CPU, detected at runtime.
+//! Host builds, i.e. simulation, trace replay and image tools, are compiled
+//! for the baseline ISA, so they run on any machine. Hot routines are built
+//! for wider vector units as well, and the best version is picked either
+//! once, when the program is loaded (ECL_CPU_CLONES), or on each call,
+//! by checking ecl::cpu features.
+//! On ARM targets nothing is dispatched, ISA is fixed by the build. On
+//! AArch64 hosts NEON is a part of the baseline and is always used by
+//! the compiler.
+//!
+#ifndef LIB_ECL_CPU_HPP_
+#define LIB_ECL_CPU_HPP_
+
+#if defined(__x86_64__) || defined(__i386__)
+//! Host CPU is x86, extensions may be checked at runtime.
+#define ECL_CPU_X86 1
+#else
+#define ECL_CPU_X86 0
+#endif
+
+//!
+//! \brief Builds function for AVX2 and for the baseline, the version is
+//! selected by the loader. Suits loops the compiler vectorizes by itself.
+//! Requires ifunc support, thus only ELF x86 hosts get both versions.
+//! \code
+//! ECL_CPU_CLONES void scale(const int16_t *in, float *out, size_t n);
+//! \endcode
+//!
+#if ECL_CPU_X86 && defined(__ELF__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define ECL_CPU_CLONES __attribute__((target_clones("avx2", "default")))
+#endif
+#endif
+
+#ifndef ECL_CPU_CLONES
+#define ECL_CPU_CLONES
+#endif
+
+namespace ecl
+{
+
+namespace cpu
+{
+
+//! Checks if SSSE3 is available, i.e. PSHUFB.
+inline bool has_ssse3()
+{
+#if ECL_CPU_X86
+    return __builtin_cpu_supports("ssse3");
+#else
+    return false;
+#endif
+}
+
+//! Checks if AVX2 is available.
+inline bool has_avx2()
+{
+#if ECL_CPU_X86
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+} // namespace cpu
+
+} // namespace ecl
+
+#endif // LIB_ECL_CPU_HPP_
@@ -1,8 +1,17 @@
 #ifndef LIB_ECL_ENDIAN_HPP_
 #define LIB_ECL_ENDIAN_HPP_
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
 
+#include "cpu.hpp"
+
+#if ECL_CPU_X86
+#include <immintrin.h>
+#endif
+
 namespace ecl {
 
 #if __BYTE_ORDER__ ==__ORDER_LITTLE_ENDIAN__
@@ -19,32 +28,32 @@ Integer LE(Integer in)
 
 // Set of routines, converting from\to Big Endian order
 
-uint16_t BE(uint16_t in)
+inline uint16_t BE(uint16_t in)
 {
     return __builtin_bswap16(in);
 }
 
-int16_t BE(int16_t in)
+inline int16_t BE(int16_t in)
 {
     return __builtin_bswap16(in);
 }
 
-uint32_t BE(uint32_t in)
+inline uint32_t BE(uint32_t in)
 {
     return __builtin_bswap32(in);
 }
 
-int32_t BE(int32_t in)
+inline int32_t BE(int32_t in)
 {
     return __builtin_bswap32(in);
 }
 
-uint64_t BE(uint64_t in)
+inline uint64_t BE(uint64_t in)
 {
     return __builtin_bswap64(in);
 }
 
-int64_t BE(int64_t in)
+inline int64_t BE(int64_t in)
 {
     return __builtin_bswap64(in);
 }
@@ -53,6 +62,157 @@ int64_t BE(int64_t in)
 #error "Not supported endianness! Implementation required"
 #endif
 
+// Loads and stores of integers placed at arbitrary addresses, i.e. fields
+// of packed headers and protocol frames. memcpy() of fixed size is turned
+// into a single load or store by the compiler, followed by REV or BSWAP
+// when byte order differs.
+
+template< typename Integer >
+Integer load_unaligned(const uint8_t *src)
+{
+    static_assert(std::is_integral< Integer >::value, "Output must be integer");
+
+    Integer val;
+    memcpy(&val, src, sizeof(val));
+    return val;
+}
+
+template< typename Integer >
+void store_unaligned(uint8_t *dst, Integer val)
+{
+    static_assert(std::is_integral< Integer >::value, "Input must be integer");
+
+    memcpy(dst, &val, sizeof(val));
+}
+
+inline uint16_t load_le16(const uint8_t *src) { return LE(load_unaligned< uint16_t >(src)); }
+inline uint32_t load_le32(const uint8_t *src) { return LE(load_unaligned< uint32_t >(src)); }
+inline uint64_t load_le64(const uint8_t *src) { return LE(load_unaligned< uint64_t >(src)); }
+
+inline uint16_t load_be16(const uint8_t *src) { return BE(load_unaligned< uint16_t >(src)); }
+inline uint32_t load_be32(const uint8_t *src) { return BE(load_unaligned< uint32_t >(src)); }
+inline uint64_t load_be64(const uint8_t *src) { return BE(load_unaligned< uint64_t >(src)); }
+
+inline void store_le16(uint8_t *dst, uint16_t val) { store_unaligned(dst, LE(val)); }
+inline void store_le32(uint8_t *dst, uint32_t val) { store_unaligned(dst, LE(val)); }
+inline void store_le64(uint8_t *dst, uint64_t val) { store_unaligned(dst, LE(val)); }
+
+inline void store_be16(uint8_t *dst, uint16_t val) { store_unaligned(dst, BE(val)); }
+inline void store_be32(uint8_t *dst, uint32_t val) { store_unaligned(dst, BE(val)); }
+inline void store_be64(uint8_t *dst, uint64_t val) { store_unaligned(dst, BE(val)); }
+
+// Bulk conversion of arrays, i.e. sample buffers or tables from a network.
+// Swaps byte order of count elements. Buffers may be unaligned and may be
+// the same (in-place conversion), but must not partially overlap.
+// On x86 hosts 32 or 16 bytes are processed at once with PSHUFB of AVX2
+// or SSSE3, whichever the CPU has, see ecl/cpu.hpp. On ARM each word is
+// reversed with single REV or REV16 instruction.
+
+namespace detail
+{
+
+// Byte order of a 16-byte block after the swap, per element size
+constexpr uint8_t swap_order16[16] = { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 };
+constexpr uint8_t swap_order32[16] = { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 };
+constexpr uint8_t swap_order64[16] = { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 };
+
+#if ECL_CPU_X86
+
+// Shuffle whole 16-byte blocks. Return amount of bytes processed.
+
+__attribute__((target("ssse3")))
+inline size_t shuffle_ssse3(uint8_t *d, const uint8_t *s, size_t bytes, const uint8_t *order)
+{
+    const __m128i mask = _mm_loadu_si128(reinterpret_cast< const __m128i* >(order));
+    size_t i = 0;
+
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast< const __m128i* >(s + i));
+        _mm_storeu_si128(reinterpret_cast< __m128i* >(d + i), _mm_shuffle_epi8(v, mask));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2")))
+inline size_t shuffle_avx2(uint8_t *d, const uint8_t *s, size_t bytes, const uint8_t *order)
+{
+    // Shuffle is done within each 16-byte lane, so the order is repeated
+    const __m256i mask = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast< const __m128i* >(order)));
+    size_t i = 0;
+
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast< const __m256i* >(s + i));
+        _mm256_storeu_si256(reinterpret_cast< __m256i* >(d + i), _mm256_shuffle_epi8(v, mask));
+    }
+
+    // Last 16-byte block, if any
+    return i + shuffle_ssse3(d + i, s + i, bytes - i, order);
+}
+
+inline size_t shuffle(uint8_t *d, const uint8_t *s, size_t bytes, const uint8_t *order)
+{
+    if (cpu::has_avx2()) {
+        return shuffle_avx2(d, s, bytes, order);
+    } else if (cpu::has_ssse3()) {
+        return shuffle_ssse3(d, s, bytes, order);
+    }
+
+    return 0;
+}
+
+#else
+
+inline size_t shuffle(uint8_t *, const uint8_t *, size_t, const uint8_t *)
+{
+    return 0;
+}
+
+#endif // ECL_CPU_X86
+
+} // namespace detail
+
+inline void swap_bytes16(void *dst, const void *src, size_t count)
+{
+    auto d = static_cast< uint8_t* >(dst);
+    auto s = static_cast< const uint8_t* >(src);
+    size_t i = detail::shuffle(d, s, count * 2, detail::swap_order16) / 2;
+
+    // Two elements per word
+    for (; i + 2 <= count; i += 2) {
+        uint32_t w = load_unaligned< uint32_t >(s + i * 2);
+        w = __builtin_bswap32(w);
+        store_unaligned(d + i * 2, (w >> 16) | (w << 16));
+    }
+
+    if (i < count) {
+        store_unaligned(d + i * 2, __builtin_bswap16(load_unaligned< uint16_t >(s + i * 2)));
+    }
+}
+
+inline void swap_bytes32(void *dst, const void *src, size_t count)
+{
+    auto d = static_cast< uint8_t* >(dst);
+    auto s = static_cast< const uint8_t* >(src);
+    size_t i = detail::shuffle(d, s, count * 4, detail::swap_order32) / 4;
+
+    for (; i < count; ++i) {
+        store_unaligned(d + i * 4, __builtin_bswap32(load_unaligned< uint32_t >(s + i * 4)));
+    }
+}
+
+inline void swap_bytes64(void *dst, const void *src, size_t count)
+{
+    auto d = static_cast< uint8_t* >(dst);
+    auto s = static_cast< const uint8_t* >(src);
+    size_t i = detail::shuffle(d, s, count * 8, detail::swap_order64) / 8;
+
+    for (; i < count; ++i) {
+        store_unaligned(d + i * 8, __builtin_bswap64(load_unaligned< uint64_t >(s + i * 8)));
+    }
+}
+
 }
 
 #endif
@@ -0,0 +1,140 @@
+//!
+//! \file
+//! \brief Sorted associative array with fixed capacity.
+//! Key-value pairs are kept sorted in a single contiguous array, so lookup
+//! is a binary search over adjacent memory and the map never allocates.
+//! Insertion and removal move following elements, which is cheap for
+//! small tables, e.g. of descriptors or cached entries.
+//! \code
+//! ecl::flat_map< int, const char*, 8 > names;
+//! names.insert(2, "two");
+//! auto it = names.find(2);
+//! \endcode
+//!
+#ifndef ECL_FLAT_MAP_HPP_
+#define ECL_FLAT_MAP_HPP_
+
+#include "static_vector.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <utility>
+
+namespace ecl
+{
+
+//!
+//! \brief Map with fixed capacity, placed in sorted array.
+//! Insertion into the full map fails and leaves it unchanged.
+//! \tparam K       Key type.
+//! \tparam V       Value type.
+//! \tparam N       Capacity.
+//! \tparam Compare Key ordering.
+//!
+template< class K, class V, size_t N, class Compare = std::less< K > >
+class flat_map
+{
+public:
+    using key_type          = K;
+    using mapped_type       = V;
+    using value_type        = std::pair< K, V >;
+    using iterator          = value_type*;
+    using const_iterator    = const value_type*;
+
+    //! Constructs empty map.
+    constexpr flat_map() :m_items{} { }
+
+    //! Gets capacity.
+    static constexpr size_t capacity() { return N; }
+
+    size_t size() const { return m_items.size(); }
+    bool empty() const { return m_items.empty(); }
+    bool full() const { return m_items.full(); }
+
+    //! Items are iterated in key order.
+    iterator begin() { return m_items.begin(); }
+    iterator end() { return m_items.end(); }
+    const_iterator begin() const { return m_items.begin(); }
+    const_iterator end() const { return m_items.end(); }
+
+    //! Finds item by key. \return end() if there is no such key.
+    iterator find(const K &key) { return find_in(begin(), end(), key); }
+    //! \copydoc find()
+    const_iterator find(const K &key) const { return find_in(begin(), end(), key); }
+
+    //! Checks if key is present.
+    bool contains(const K &key) const { return find(key) != end(); }
+
+    //!
+    //! \brief Inserts item, if key is not present yet.
+    //! \return Iterator to the item with given key and true if item was
+    //!         inserted. end() and false if key is absent and map is full.
+    //!
+    template< class... Args >
+    std::pair< iterator, bool > emplace(const K &key, Args&&... args)
+    {
+        auto it = lower_bound(begin(), end(), key);
+
+        if (it != end() && !less(key, it->first)) {
+            return {it, false};
+        }
+
+        auto pos = m_items.emplace(it, std::piecewise_construct,
+                                   std::forward_as_tuple(key),
+                                   std::forward_as_tuple(std::forward< Args >(args)...));
+        return {pos, pos != end()};
+    }
+
+    //! \copydoc emplace()
+    std::pair< iterator, bool > insert(const K &key, const V &value)
+    {
+        return emplace(key, value);
+    }
+
+    //!
+    //! \brief Removes item by key.
+    //! \return Amount of removed items, 0 or 1.
+    //!
+    size_t erase(const K &key)
+    {
+        auto it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+
+        m_items.erase(it);
+        return 1;
+    }
+
+    //! Removes item by iterator. \return Iterator following the removed item.
+    iterator erase(const_iterator pos) { return m_items.erase(pos); }
+
+    //! Removes all items.
+    void clear() { m_items.clear(); }
+
+private:
+    static bool less(const K &a, const K &b) { return Compare{}(a, b); }
+
+    template< class It >
+    static It lower_bound(It first, It last, const K &key)
+    {
+        return std::lower_bound(first, last, key, [](const value_type &item, const K &k) {
+            return less(item.first, k);
+        });
+    }
+
+    template< class It >
+    static It find_in(It first, It last, const K &key)
+    {
+        auto it = lower_bound(first, last, key);
+        return it != last && !less(key, it->first) ? it : last;
+    }
+
+    static_vector< value_type, N > m_items; //!< Items, sorted by key.
+};
+
+} // namespace ecl
+
+#endif // ECL_FLAT_MAP_HPP_
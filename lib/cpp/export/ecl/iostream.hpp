@@ -6,6 +6,22 @@
 
 #include <console_driver.hpp>
 
+// Console library may provide separate driver for each standard stream,
+// i.e. fast unbuffered channel for cerr and DMA-driven USART for cout.
+// Drivers are declared in console_driver.hpp. Streams that use the same
+// driver type share single device.
+#ifndef CONFIG_CONSOLE_CIN_DRIVER
+#define CONFIG_CONSOLE_CIN_DRIVER console_driver
+#endif
+
+#ifndef CONFIG_CONSOLE_COUT_DRIVER
+#define CONFIG_CONSOLE_COUT_DRIVER console_driver
+#endif
+
+#ifndef CONFIG_CONSOLE_CERR_DRIVER
+#define CONFIG_CONSOLE_CERR_DRIVER console_driver
+#endif
+
 #include <unistd.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -37,6 +53,9 @@ public:
 
     // Puts a single character
     iostream& put(char c);
+
+    // Writes buffered output to the device
+    iostream& flush();
     iostream& operator>>(int& value);
     iostream& operator>>(unsigned int& value);
     iostream& operator>>(char& character);
@@ -58,12 +77,22 @@ private:
 };
 
 
+// Drivers of standard streams
+using cin_driver  = CONFIG_CONSOLE_CIN_DRIVER;
+using cout_driver = CONFIG_CONSOLE_COUT_DRIVER;
+using cerr_driver = CONFIG_CONSOLE_CERR_DRIVER;
+
 // Standard streams, defined elsewhere
-// These streams rely on specific driver, which name should be
+// These streams rely on specific drivers, which names should be
 // the same accross all targets
-extern istream< console_driver > cin;
-extern ostream< console_driver > cout;
-extern ostream< console_driver > cerr;
+extern istream< cin_driver > cin;
+extern ostream< cout_driver > cout;
+// Errors are written right away, as in standard library
+extern ostream< cerr_driver, 0 > cerr;
+
+// Initializes devices of standard streams.
+// Device that is shared between streams is initialized only once.
+void init_console();
 
 
 //------------------------------------------------------------------------------
@@ -128,6 +157,13 @@ iostream<IO_device>& iostream< IO_device >::put(char c)
     return *this;
 }
 
+template< class IO_device >
+iostream<IO_device>& iostream< IO_device >::flush()
+{
+    m_out.flush();
+    return *this;
+}
+
 template< class IO_device >
 iostream<IO_device>& iostream< IO_device >::operator>>(int& value)
 {
@@ -3,9 +3,38 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <type_traits>
+
+// Default size of the input buffer. Zero makes streams unbuffered.
+// Buffer is filled by single device read, thus it should be enabled only
+// for devices that return as soon as some data is available, i.e.
+// buffered_bus_pipe over usart_bus in idle-line terminated RX mode.
+// Otherwise read will block until whole buffer is filled.
+#ifndef CONFIG_ISTREAM_BUFFER_SIZE
+#define CONFIG_ISTREAM_BUFFER_SIZE 0
+#endif
 
 namespace ecl {
+
+// Checks if device provides non-blocking try_read() method
 template< class IO_device >
+class has_try_read
+{
+    template< class D >
+    static auto check(D *d)
+        -> decltype(d->try_read(static_cast< uint8_t* >(nullptr), size_t{}), std::true_type{});
+
+    template< class D >
+    static std::false_type check(...);
+
+public:
+    static constexpr bool value = decltype(check< IO_device >(nullptr))::value;
+};
+
+// Input stream. Data is read from the device in portions and kept in the
+// internal buffer, so parsing doesn't cost a device read per character.
+// Stream is not thread-safe.
+template< class IO_device, size_t buf_size = CONFIG_ISTREAM_BUFFER_SIZE >
 class istream
 {
 public:
@@ -22,7 +51,7 @@ public:
     istream& operator>>(char& character);
     istream& operator>>(char *string);
     // For I\O manipulators
-    istream& operator>>(istream& (*func)(istream< IO_device >&));
+    istream& operator>>(istream& (*func)(istream&));
     // NOTE: this will be used later with different manipulators,
     // such that used for hex or octal output of integers
 
@@ -30,44 +59,79 @@ public:
     int get();
     istream& get(char& c);
 
+    // Reads a line, until delimiter or until count - 1 characters are stored.
+    // Delimiter is extracted, but not stored. Line is always null-terminated.
+    // Line discipline is applied: carriage returns are dropped, backspace
+    // and DEL erase previous character.
+    istream& getline(char *string, size_t count, char delim = '\n');
+
+    // Gets amount of characters extracted by the last getline() or readsome()
+    size_t gcount() const;
+
+    // Extracts only characters that are available right now, never blocks.
+    // If buffer is empty and device supports try_read(), device is polled.
+    // Returns amount of characters extracted.
+    size_t readsome(char *string, size_t count);
+
+    // Extracts single character, if available. Never blocks.
+    bool try_read(char &c);
+
 private:
+    // Extracts next character, blocking if required
+    bool read_char(char &c);
+    // Extracts character, skipping spaces
+    bool read_nonspace(char &c);
+    // Refills the buffer from the device, blocking if required
+    bool underflow();
+    // Refills the buffer from the device, without blocking
+    bool poll(std::true_type);
+    bool poll(std::false_type);
+
     // Simply, a device driver object
     IO_device *m_device;
+    // Received characters. Single byte is reserved for unbuffered stream,
+    // since zero-length arrays are not allowed.
+    char m_buf[buf_size ? buf_size : 1];
+    // Position of the next character in the buffer
+    size_t m_pos;
+    // Amount of characters in the buffer
+    size_t m_len;
+    // Characters extracted by the last unformatted input
+    size_t m_gcount;
 };
 
 
 //------------------------------------------------------------------------------
 
 
-template< class IO_device >
-istream< IO_device >::istream(IO_device *device)
+template< class IO_device, size_t buf_size >
+istream< IO_device, buf_size >::istream(IO_device *device)
     :m_device{device}
+    ,m_buf{}
+    ,m_pos{0}
+    ,m_len{0}
+    ,m_gcount{0}
 {
 }
 
-template< class IO_device >
-istream< IO_device >::~istream()
+template< class IO_device, size_t buf_size >
+istream< IO_device, buf_size >::~istream()
 {
 }
 
 
-template< class IO_device >
-istream<IO_device>& istream< IO_device >::operator>>(int& value)
+template< class IO_device, size_t buf_size >
+istream< IO_device, buf_size >& istream< IO_device, buf_size >::operator>>(int& value)
 {
     value = 0;
     char in_character;
-    char in_char_for_spaces;
     int symbol_code;
     bool sign = false; //TRUE is used to indicate negative number
     bool first = true; //TRUE indicates the first round of cycle
 
-    do{
-        if(m_device->read((uint8_t*) &in_char_for_spaces, 1) < 0) {
-            break;
-        }
-    } while(in_char_for_spaces == ' ');
-
-    in_character = in_char_for_spaces;
+    if (!read_nonspace(in_character)) {
+        return *this;
+    }
 
     do{
         symbol_code = in_character;
@@ -85,7 +149,7 @@ istream<IO_device>& istream< IO_device >::operator>>(int& value)
             break; //FIXME: add error handling
         }
 
-        if(m_device->read((uint8_t*) &in_character, 1) < 0) {
+        if(!read_char(in_character)) {
             break;
         }
     } while(in_character != '\n' && in_character != ' ');
@@ -97,21 +161,16 @@ istream<IO_device>& istream< IO_device >::operator>>(int& value)
     return *this;
 }
 
-template< class IO_device >
-istream<IO_device>& istream< IO_device >::operator>>(unsigned int& value)
+template< class IO_device, size_t buf_size >
+istream< IO_device, buf_size >& istream< IO_device, buf_size >::operator>>(unsigned int& value)
 {
     value = 0;
     char in_character;
-    char in_char_for_spaces;
     int symbol_code;
 
-    do{
-        if(m_device->read((uint8_t*) &in_char_for_spaces, 1) < 0) {
-            break;
-        }
-    } while(in_char_for_spaces == ' ');
-
-    in_character = in_char_for_spaces;
+    if (!read_nonspace(in_character)) {
+        return *this;
+    }
 
     do{
         symbol_code = in_character;
@@ -124,7 +183,7 @@ istream<IO_device>& istream< IO_device >::operator>>(unsigned int& value)
             break; //FIXME: add error handling
         }
 
-        if(m_device->read((uint8_t*) &in_character, 1) < 0) {
+        if(!read_char(in_character)) {
             break; //FIXME: add error handling
         }
 
@@ -133,38 +192,24 @@ istream<IO_device>& istream< IO_device >::operator>>(unsigned int& value)
     return *this;
 }
 
-template< class IO_device >
-istream<IO_device>& istream< IO_device >::operator>>(char& character)
+template< class IO_device, size_t buf_size >
+istream< IO_device, buf_size >& istream< IO_device, buf_size >::operator>>(char& character)
 {
-    char in_char_for_spaces;
-
-    do{
-        if(m_device->read((uint8_t*) &in_char_for_spaces, 1) < 0) {
-            break;
-        }
-    } while(in_char_for_spaces == ' ');
-
-    character = in_char_for_spaces;
-
+    read_nonspace(character);
     return *this;
 }
 
-template< class IO_device >
-istream<IO_device>& istream< IO_device >::operator>>(char *string)
+template< class IO_device, size_t buf_size >
+istream< IO_device, buf_size >& istream< IO_device, buf_size >::operator>>(char *string)
 {
     size_t i = 1;
-    char in_char_for_spaces;
-
-    do{
-        if(m_device->read((uint8_t*) &in_char_for_spaces, 1) < 0) {
-            break;
-        }
-    } while(in_char_for_spaces == ' ');
 
-    string[0] = in_char_for_spaces;
+    if (!read_nonspace(string[0])) {
+        return *this;
+    }
 
     do {
-        if(m_device->read((uint8_t *) &string[i], 1) < 0) {
+        if(!read_char(string[i])) {
             break; //FIXME: add error handling
         }
     }
@@ -173,32 +218,158 @@ istream<IO_device>& istream< IO_device >::operator>>(char *string)
 }
 
 
-template< class IO_device >
-istream<IO_device>& istream< IO_device >::operator>>(
-        istream& (*func)(istream< IO_device >&))
+template< class IO_device, size_t buf_size >
+istream< IO_device, buf_size >& istream< IO_device, buf_size >::operator>>(
+        istream& (*func)(istream&))
 {
     return func(*this);
 }
 
-template< class IO_device >
-int istream< IO_device >::get()
+template< class IO_device, size_t buf_size >
+int istream< IO_device, buf_size >::get()
 {
-    int c = 0;
-    if(m_device->read((uint8_t *) &c, 1) < 0) {
+    char c;
+    if (!read_char(c)) {
         return -1;
     }
 
-    return c;
+    return static_cast< unsigned char >(c);
 }
 
-template< class IO_device >
-istream<IO_device>& istream< IO_device >::get(char& character)
+template< class IO_device, size_t buf_size >
+istream< IO_device, buf_size >& istream< IO_device, buf_size >::get(char& character)
 {
-    m_device->read((uint8_t *) &character, 1);
+    read_char(character);
 
     return *this;
 }
 
+template< class IO_device, size_t buf_size >
+istream< IO_device, buf_size >& istream< IO_device, buf_size >::getline(
+        char *string, size_t count, char delim)
+{
+    size_t len = 0;
+    char c;
+
+    m_gcount = 0;
+
+    if (!count) {
+        return *this;
+    }
+
+    while (len + 1 < count && read_char(c)) {
+        m_gcount++;
+
+        if (c == delim) {
+            break;
+        }
+
+        if (c == '\r') {
+            continue;
+        }
+
+        if (c == '\b' || c == 0x7f) {
+            if (len) {
+                len--;
+            }
+            continue;
+        }
+
+        string[len++] = c;
+    }
+
+    string[len] = 0;
+    return *this;
+}
+
+template< class IO_device, size_t buf_size >
+size_t istream< IO_device, buf_size >::gcount() const
+{
+    return m_gcount;
+}
+
+template< class IO_device, size_t buf_size >
+size_t istream< IO_device, buf_size >::readsome(char *string, size_t count)
+{
+    size_t extracted = 0;
+
+    while (extracted < count && try_read(string[extracted])) {
+        extracted++;
+    }
+
+    m_gcount = extracted;
+    return extracted;
+}
+
+template< class IO_device, size_t buf_size >
+bool istream< IO_device, buf_size >::try_read(char &c)
+{
+    if (m_pos == m_len && !poll(std::integral_constant< bool, has_try_read< IO_device >::value >{})) {
+        return false;
+    }
+
+    c = m_buf[m_pos++];
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+template< class IO_device, size_t buf_size >
+bool istream< IO_device, buf_size >::read_char(char &c)
+{
+    if (m_pos == m_len && !underflow()) {
+        return false;
+    }
+
+    c = m_buf[m_pos++];
+    return true;
+}
+
+template< class IO_device, size_t buf_size >
+bool istream< IO_device, buf_size >::read_nonspace(char &c)
+{
+    do {
+        if (!read_char(c)) {
+            return false;
+        }
+    } while (c == ' ');
+
+    return true;
+}
+
+template< class IO_device, size_t buf_size >
+bool istream< IO_device, buf_size >::underflow()
+{
+    auto rc = m_device->read(reinterpret_cast< uint8_t* >(m_buf), sizeof(m_buf));
+    if (rc <= 0) {
+        return false;
+    }
+
+    m_pos = 0;
+    m_len = static_cast< size_t >(rc);
+    return true;
+}
+
+template< class IO_device, size_t buf_size >
+bool istream< IO_device, buf_size >::poll(std::true_type)
+{
+    auto rc = m_device->try_read(reinterpret_cast< uint8_t* >(m_buf), sizeof(m_buf));
+    if (rc <= 0) {
+        return false;
+    }
+
+    m_pos = 0;
+    m_len = static_cast< size_t >(rc);
+    return true;
+}
+
+template< class IO_device, size_t buf_size >
+bool istream< IO_device, buf_size >::poll(std::false_type)
+{
+    // Device can't be polled, only buffered characters are available
+    return false;
+}
+
 }
 
 #endif // ECL_istream_HPP
@@ -1,6 +1,6 @@
 //!
 //! \file
-//! \brief Memory managment helpers: shared pointer.
+//! \brief Memory managment helpers: shared and intrusive pointers.
 //! \todo Implement unique poitner
 //! \todo Detailed description
 //!
@@ -13,32 +13,93 @@
 #include <cstddef>
 #include <utility>
 
+#ifdef CONFIG_ATOMIC_REFCOUNT
+#include <atomic>
+#endif
+
 namespace ecl
 {
 
+namespace detail
+{
+
+//!
+//! \brief Reference counter.
+//! With CONFIG_ATOMIC_REFCOUNT counter is atomic, so references can be
+//! shared between threads. Otherwise it is a plain integer.
+//!
+class ref_counter
+{
+public:
+    constexpr ref_counter() :m_cnt{0} { }
+
+#ifdef CONFIG_ATOMIC_REFCOUNT
+    // New reference is always made from existing one, no ordering required.
+    // Release must see all writes to the object made through other references.
+    size_t inc()        { return m_cnt.fetch_add(1, std::memory_order_relaxed) + 1; }
+    size_t dec()        { return m_cnt.fetch_sub(1, std::memory_order_acq_rel) - 1; }
+    size_t get() const  { return m_cnt.load(std::memory_order_acquire); }
+
+    bool inc_if_nonzero()
+    {
+        auto cnt = m_cnt.load(std::memory_order_relaxed);
+
+        do {
+            if (!cnt) {
+                return false;
+            }
+        } while (!m_cnt.compare_exchange_weak(cnt, cnt + 1, std::memory_order_relaxed));
+
+        return true;
+    }
+
+private:
+    std::atomic< size_t > m_cnt;
+#else
+    size_t inc()        { return ++m_cnt; }
+    size_t dec()        { return --m_cnt; }
+    size_t get() const  { return m_cnt;   }
+
+    bool inc_if_nonzero()
+    {
+        return m_cnt ? ++m_cnt : false;
+    }
+
+private:
+    size_t m_cnt;
+#endif
+};
+
+} // namespace detail
+
 //!
 //! \brief Base helper class, used internally by shared_ptr
 //!
+//! All strong references own a single weak reference together, so the
+//! helper outlives destruction of the managed object.
+//!
 class aux
 {
 public:
     //! Constructs auxilary object
     aux()
-        :m_cnt{0}, m_weak{0} { }
+        :m_cnt{}, m_weak{} { }
 
     //! Incremets reference counter and returns new value.
-    size_t inc() { return ++m_cnt; }
+    size_t inc() { return m_cnt.inc(); }
     //! Decrements reference counter and returns new value.
-    size_t dec() { return --m_cnt; }
+    size_t dec() { return m_cnt.dec(); }
     //! Returns reference counter.
-    size_t ref() { return m_cnt;   }
+    size_t ref() { return m_cnt.get(); }
+    //! Increments reference counter, unless it is zero already.
+    bool inc_if_alive() { return m_cnt.inc_if_nonzero(); }
 
     //! Incremets weak reference counter and returns new value.
-    size_t weak_inc() { return ++m_weak; }
+    size_t weak_inc() { return m_weak.inc(); }
     //! Decrements weak reference counter and returns new value.
-    size_t weak_dec() { return --m_weak; }
+    size_t weak_dec() { return m_weak.dec(); }
     //! Returns wek reference counter.
-    size_t weak_ref() { return m_weak;   }
+    size_t weak_ref() { return m_weak.get(); }
 
     //!
     //! \brief  Destroys aux and deallocates memory if both shared and weak
@@ -49,8 +110,8 @@ public:
     virtual void destroy() = 0;
 
 protected:
-    size_t m_cnt;       //!< Reference counter.
-    size_t m_weak;      //!< Weak reference counter.
+    detail::ref_counter m_cnt;  //!< Reference counter.
+    detail::ref_counter m_weak; //!< Weak reference counter.
 };
 
 //------------------------------------------------------------------------------
@@ -171,10 +232,10 @@ private:
         virtual void destroy() override
         {
             // Make sure there is no other references
-            ecl_assert(!m_cnt);
+            ecl_assert(!m_cnt.get());
 
             // No more weak references so this object may be deleted
-            if (!m_weak) {
+            if (!m_weak.get()) {
                 auto allocator = m_alloc.template rebind< aux_alloc >();
                 allocator.deallocate(this, 1);
             }
@@ -358,20 +419,23 @@ template< typename T >
 void shared_ptr< T >::release()
 {
     if (m_aux) {
-        if (unique()) {
-            // Release the resource
-            m_obj->~T();
-            // Object of T can contain weak reference of the same resourse.
-            // Thus it is prohibited to decrease counter before
-            // object desctruction.
-            m_aux->dec();
-            m_aux->destroy();
-        } else {
-            m_aux->dec();
-        }
+        auto aux = m_aux;
+        auto obj = m_obj;
 
         m_aux = nullptr;
         m_obj = nullptr;
+
+        // Counter is checked and decremented at once, so concurrent
+        // release of the last two references can't miss the zero.
+        if (!aux->dec()) {
+            // Object of T can contain weak reference of the same resourse.
+            // Weak reference, owned by strong ones, keeps aux alive meanwhile.
+            obj->~T();
+
+            if (!aux->weak_dec()) {
+                aux->destroy();
+            }
+        }
     }
 }
 
@@ -395,6 +459,8 @@ shared_ptr< T > allocate_shared(const Alloc &alloc, Args... args)
     shared.m_aux = ptr;
     // Now it owns the resourse
     shared.m_aux->inc();
+    // Weak reference of all strong references
+    shared.m_aux->weak_inc();
     shared.m_obj = &ptr->m_object;
 
     return shared;
@@ -488,7 +554,10 @@ template< typename T >
 weak_ptr< T >::~weak_ptr()
 {
     if (!expired()) {
-        m_aux->weak_dec();
+        // Strong references may be released right before the decrement
+        if (!m_aux->weak_dec()) {
+            m_aux->destroy();
+        }
     }
     // Do nothing here, already expired...
 }
@@ -532,7 +601,10 @@ template< typename T >
 weak_ptr< T >& weak_ptr< T >::operator =(const shared_ptr< T > &other)
 {
     if (!expired()) {
-        m_aux->weak_dec();
+        if (!m_aux->weak_dec()) {
+            m_aux->destroy();
+        }
+
         m_aux = nullptr;
         m_obj = nullptr;
     }
@@ -556,11 +628,11 @@ void weak_ptr< T >::swap(weak_ptr< T > &other)
 template< typename T >
 shared_ptr< T > weak_ptr< T >::lock() const
 {
-    if (expired()) {
+    // Last strong reference may be released concurrently
+    if (expired() || !m_aux->inc_if_alive()) {
         return nullptr;
     } else {
         // Weak counter already incremented
-        m_aux->inc();
 
         shared_ptr< T > ptr;
         ptr.m_aux = m_aux;
@@ -602,6 +674,191 @@ void weak_ptr< T >::reset() const
     m_obj = nullptr;
 }
 
+//------------------------------------------------------------------------------
+
+//!
+//! \brief Base for objects with embedded reference counter.
+//! Derived class must provide non-virtual destroy() method, that is called
+//! when last reference is dropped. Usually it destroys the object
+//! and returns its memory to the allocator.
+//! \tparam Derived Class that inherits this base.
+//! \sa intrusive_ptr
+//!
+template< class Derived >
+class ref_counted
+{
+public:
+    //! Acquires a reference.
+    void add_ref() { m_refs.inc(); }
+
+    //! Drops a reference and destroys object if it was the last one.
+    void release()
+    {
+        ecl_assert(m_refs.get());
+
+        if (!m_refs.dec()) {
+            static_cast< Derived* >(this)->destroy();
+        }
+    }
+
+    //! Returns reference counter.
+    size_t ref_count() const { return m_refs.get(); }
+
+protected:
+    ref_counted() :m_refs{} { }
+    ~ref_counted() = default;
+
+    // Copy doesn't share references of the source
+    ref_counted(const ref_counted &) :m_refs{} { }
+    ref_counted& operator=(const ref_counted &) { return *this; }
+
+private:
+    detail::ref_counter m_refs; //!< Reference counter.
+};
+
+//!
+//! \brief Pointer to an object that counts references by itself.
+//! Unlike shared_ptr, there is no separate control block: no pointer chase
+//! and no virtual call on copy or destruction. Weak references are
+//! not supported.
+//! \tparam T Type with add_ref() and release() methods, e.g. derived
+//!           from ref_counted.
+//!
+template< typename T >
+class intrusive_ptr
+{
+    template< typename U >
+    friend class intrusive_ptr;
+
+public:
+    //! Constructs pointer with no managed object.
+    constexpr intrusive_ptr() :m_obj{nullptr} { }
+
+    //! Constructs pointer with no managed object.
+    constexpr intrusive_ptr(std::nullptr_t) :m_obj{nullptr} { }
+
+    //!
+    //! \brief Takes a reference to given object.
+    //! \param[in] obj Object to manage. Can be null.
+    //!
+    explicit intrusive_ptr(T *obj);
+
+    //! Shares ownership with other pointer.
+    intrusive_ptr(const intrusive_ptr &other);
+
+    //! Moves ownership from other pointer.
+    intrusive_ptr(intrusive_ptr &&other);
+
+    //!
+    //! \copydoc intrusive_ptr(const intrusive_ptr &other)
+    //! \tparam U Is a subclass of T
+    //!
+    template< typename U >
+    intrusive_ptr(const intrusive_ptr< U > &other);
+
+    //! Drops a reference, if any.
+    ~intrusive_ptr();
+
+    //! Shares ownership with other pointer, releasing current object.
+    intrusive_ptr& operator=(intrusive_ptr other);
+
+    //! Drops a reference, if any.
+    void reset();
+
+    //! Returns the object itself.
+    T* get() const { return m_obj; }
+
+    //! Common smart pointer overload.
+    T& operator *() const;
+    //! Common smart pointer overload.
+    T* operator ->() const;
+
+    //! Returns true if this pointer manages the object.
+    explicit operator bool() const { return !!m_obj; }
+
+private:
+    T *m_obj; //!< Managed object.
+};
+
+template< typename T >
+intrusive_ptr< T >::intrusive_ptr(T *obj)
+    :m_obj{obj}
+{
+    if (m_obj) {
+        m_obj->add_ref();
+    }
+}
+
+template< typename T >
+intrusive_ptr< T >::intrusive_ptr(const intrusive_ptr &other)
+    :intrusive_ptr{other.m_obj}
+{
+}
+
+template< typename T >
+intrusive_ptr< T >::intrusive_ptr(intrusive_ptr &&other)
+    :m_obj{other.m_obj}
+{
+    other.m_obj = nullptr;
+}
+
+template< typename T >
+template< typename U >
+intrusive_ptr< T >::intrusive_ptr(const intrusive_ptr< U > &other)
+    :intrusive_ptr{other.m_obj}
+{
+}
+
+template< typename T >
+intrusive_ptr< T >::~intrusive_ptr()
+{
+    reset();
+}
+
+template< typename T >
+intrusive_ptr< T >& intrusive_ptr< T >::operator=(intrusive_ptr other)
+{
+    std::swap(m_obj, other.m_obj);
+    return *this;
+}
+
+template< typename T >
+void intrusive_ptr< T >::reset()
+{
+    if (m_obj) {
+        // Pointer must be clean before object is gone
+        auto obj = m_obj;
+        m_obj = nullptr;
+        obj->release();
+    }
+}
+
+template< typename T >
+T& intrusive_ptr< T >::operator *() const
+{
+    ecl_assert(m_obj);
+    return *m_obj;
+}
+
+template< typename T >
+T* intrusive_ptr< T >::operator ->() const
+{
+    ecl_assert(m_obj);
+    return m_obj;
+}
+
+template< typename T, typename U >
+bool operator ==(const intrusive_ptr< T > &a, const intrusive_ptr< U > &b)
+{
+    return a.get() == b.get();
+}
+
+template< typename T, typename U >
+bool operator !=(const intrusive_ptr< T > &a, const intrusive_ptr< U > &b)
+{
+    return a.get() != b.get();
+}
+
 }
 
 #endif // ECL_MEMORY_HPP_
@@ -1,6 +1,16 @@
 #ifndef ECL_OSTREAM_HPP
 #define ECL_OSTREAM_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Default size of the stream buffer. Zero makes streams unbuffered.
+#ifndef CONFIG_OSTREAM_BUFFER_SIZE
+#define CONFIG_OSTREAM_BUFFER_SIZE 64
+#endif
+
 namespace ecl {
 
 template< typename stream >
@@ -8,14 +18,111 @@ stream& endl(stream &ios)
 {
     ios.put('\n');
     ios.put('\r');
+    ios.flush();
+
+    return ios;
+}
+
+template< typename stream >
+stream& flush(stream &ios)
+{
+    ios.flush();
+    return ios;
+}
 
-    // TODO: flush stream when appropriate functionality
-    // will be ready
+// Switches integer output to hexadecimal base
+template< typename stream >
+stream& hex(stream &ios)
+{
+    ios.base(16);
     return ios;
 }
 
+// Switches integer output to decimal base
+template< typename stream >
+stream& dec(stream &ios)
+{
+    ios.base(10);
+    return ios;
+}
+
+// Minimal width of the next number or string, see setw()
+struct setw_t
+{
+    size_t width;
+};
+
+// Character used to pad output up to the width, see setfill()
+struct setfill_t
+{
+    char fill;
+};
+
+// Sets width of the next field. Width is reset after each field.
+inline setw_t setw(size_t width)
+{
+    return setw_t{width};
+}
+
+// Sets padding character. Space is used by default.
+inline setfill_t setfill(char fill)
+{
+    return setfill_t{fill};
+}
+
+namespace ostream_detail
+{
+
+// Table of digit pairs from "00" to "99"
+inline const char *digit_pairs()
+{
+    static const char pairs[] =
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    return pairs;
+}
+
+// Writes two decimal digits of the value, that is less than 100,
+// right before given position. Returns position of the first digit.
+inline char *format_pair(char *end, uint32_t value)
+{
+    auto pairs = digit_pairs();
+
+    end -= 2;
+    end[0] = pairs[value * 2];
+    end[1] = pairs[value * 2 + 1];
+
+    return end;
+}
+
+// Writes decimal digits of the value right before given position.
+// Two digits are produced per division. Returns position of the first digit.
+inline char *format_dec(char *end, uint32_t value)
+{
+    while (value >= 100) {
+        auto rest = value / 100;
+        end = format_pair(end, value - rest * 100);
+        value = rest;
+    }
+
+    if (value >= 10) {
+        return format_pair(end, value);
+    }
+
+    *--end = '0' + value;
+    return end;
+}
+
+} // namespace ostream_detail
+
 
-template< class IO_device >
+// Output stream. Output is collected in the internal buffer and written
+// to the device in one go when buffer is full, on ecl::endl or ecl::flush.
+// Stream is not thread-safe: concurrent output may interleave.
+template< class IO_device, size_t buf_size = CONFIG_OSTREAM_BUFFER_SIZE >
 class ostream
 {
 public:
@@ -29,147 +136,287 @@ public:
 
     ostream& operator<<(int value);
     ostream& operator<<(unsigned int value);
+    ostream& operator<<(long value);
+    ostream& operator<<(unsigned long value);
+    ostream& operator<<(long long value);
+    ostream& operator<<(unsigned long long value);
     ostream& operator<<(char character);
     ostream& operator<<(const char *string);
+    // Pointer is printed in hex with 0x prefix. Width applies to digits only.
+    ostream& operator<<(const void *ptr);
 
-    // For I\O manipulators
-    ostream& operator<<(ostream& (*func)(ostream< IO_device >&));
-    // NOTE: this will be used later with different manipulators,
-    // such that used for hex or octal output of integers
+    // For I\O manipulators, such as ecl::endl or ecl::hex
+    ostream& operator<<(ostream& (*func)(ostream&));
+    ostream& operator<<(setw_t manip);
+    ostream& operator<<(setfill_t manip);
+
+    // Sets base for integer output. Only 10 and 16 are supported.
+    // Negative numbers are printed in two's complement in hex, like in STL.
+    ostream& base(unsigned base);
 
     // Puts a single character
     ostream& put(char c);
 
+    // Writes buffered characters to the device
+    ostream& flush();
+
 private:
     // Simply, a device driver object
     IO_device *m_device;
+    // Pending characters. Single byte is reserved for unbuffered stream,
+    // since zero-length arrays are not allowed.
+    char m_buf[buf_size ? buf_size : 1];
+    // Amount of pending characters
+    size_t m_pos;
+    // Integer base
+    uint8_t m_base;
+    // Padding character
+    char m_fill;
+    // Minimal width of the next field
+    size_t m_width;
+
+    // Prints value of any signed type
+    template< typename T >
+    ostream& put_signed(T value);
+    // Prints magnitude of number, respecting base and width
+    ostream& put_integer(unsigned long long value, bool negative);
+    // Puts padding required for a field of given length
+    void put_padding(size_t len);
 };
 
 
 //------------------------------------------------------------------------------
 
 
-template< class IO_device >
-ostream< IO_device >::ostream(IO_device *device)
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >::ostream(IO_device *device)
     :m_device{device}
+    ,m_buf{}
+    ,m_pos{0}
+    ,m_base{10}
+    ,m_fill{' '}
+    ,m_width{0}
 {
 }
 
-template< class IO_device >
-ostream< IO_device >::~ostream()
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >::~ostream()
 {
+    flush();
 }
 
-template< class IO_device >
-ostream<IO_device>& ostream< IO_device >::operator<< (int value)
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::operator<<(int value)
 {
-    int higher_multiplicand = 1;
-    int out_digit = 0;
-    int val2 = value;
-    char out_character;
+    return put_signed(value);
+}
 
-    while(val2 / 10 != 0) {
-        higher_multiplicand *= 10;
-        val2 /= 10;
-    }
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::operator<<(unsigned int value)
+{
+    return put_integer(value, false);
+}
 
-    if (value < 0) {
-        m_device->write((uint8_t *) "-", 1);
-        value *= -1;
-    }
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::operator<<(long value)
+{
+    return put_signed(value);
+}
 
-    for (int i = 1; i <= higher_multiplicand; i *= 10) {
-        out_digit = value * i / higher_multiplicand;
-        out_character = out_digit + 48;
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::operator<<(unsigned long value)
+{
+    return put_integer(value, false);
+}
 
-        if (m_device->write((uint8_t *) &out_character, 1) < 0) {
-            break; //FIXME: add error handling
-        }
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::operator<<(long long value)
+{
+    return put_signed(value);
+}
 
-        value = value - out_digit * higher_multiplicand / i;
-    }
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::operator<<(unsigned long long value)
+{
+    return put_integer(value, false);
+}
 
-    return *this;
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::operator<<(char character)
+{
+    return put(character);
 }
 
 
-template< class IO_device >
-ostream<IO_device>& ostream< IO_device >::operator<< (unsigned int value)
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::operator<<(const char *string)
 {
-    int higher_multiplicand = 1;
-    int out_digit = 0;
-    int val2 = value;
-    char out_character;
-
-    while(val2 / 10 != 0) {
-        higher_multiplicand *= 10;
-        val2 /= 10;
+    if (m_width) {
+        put_padding(strlen(string));
     }
 
-    for (int i = 1; i <= higher_multiplicand; i *= 10) {
-        out_digit = value * i / higher_multiplicand;
-        out_character = out_digit + 48;
-
-        if (m_device->write((uint8_t *) &out_character, 1) < 0) {
-            break; //FIXME: add error handling
+    size_t i = 0;
+    while(string[i] != 0) {
+        if (string[i] == '\n') {
+            put('\r');
         }
 
-        value = value - out_digit * higher_multiplicand / i;
+        put(string[i]);
+        i++;
     }
+    return *this;
+}
+
+
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::operator<<(const void *ptr)
+{
+    auto saved = m_base;
+
+    put('0');
+    put('x');
+    m_base = 16;
+    put_integer(reinterpret_cast< uintptr_t >(ptr), false);
+    m_base = saved;
 
     return *this;
 }
 
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::operator<<(
+        ostream& (*func)(ostream&))
+{
+    return func(*this);
+}
 
-template< class IO_device >
-ostream<IO_device>& ostream< IO_device >::operator<<(char character)
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::operator<<(setw_t manip)
 {
-    if(m_device->write((uint8_t *) &character,1) < 0) {
-        return *this; //FIXME: add error handling
-    }
+    m_width = manip.width;
+    return *this;
+}
 
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::operator<<(setfill_t manip)
+{
+    m_fill = manip.fill;
     return *this;
 }
 
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::base(unsigned base)
+{
+    m_base = base == 16 ? 16 : 10;
+    return *this;
+}
 
-template< class IO_device >
-ostream<IO_device>& ostream< IO_device >::operator<<(const char *string)
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::put(char c)
 {
-    // TODO: improve this function in a way it can write a string
-    // to a device with chunks that are splitted by '\n' symbol
-    // What about somehow move it to the platform layer?
+    if (!buf_size) {
+        m_device->write((uint8_t *)&c, 1);
+        return *this;
+    }
 
-    size_t i = 0;
-    while(string[i] != 0) {
-        if (string[i] == '\n') {
-            uint8_t carret_ret = '\r';
-            m_device->write(&carret_ret, 1);
-        }
+    // Position is copied, so the buffer is never overrun,
+    // even if stream is misused from several threads
+    size_t pos = m_pos;
+
+    if (pos >= buf_size) {
+        flush();
+        pos = 0;
+    }
+
+    m_buf[pos] = c;
+    m_pos = pos + 1;
+
+    return *this;
+}
 
-        if(m_device->write((const uint8_t *) &string[i], 1) < 0) {
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::flush()
+{
+    size_t pending = m_pos < buf_size ? m_pos : buf_size;
+    m_pos = 0;
+
+    // Device may accept only part of the data
+    size_t written = 0;
+    while (written < pending) {
+        auto rc = m_device->write((const uint8_t *) m_buf + written, pending - written);
+        if (rc <= 0) {
             break; //FIXME: add error handling
         }
 
-        i++;
+        written += static_cast< size_t >(rc);
     }
+
     return *this;
 }
 
-
-template< class IO_device >
-ostream<IO_device>& ostream< IO_device >::operator<<(
-        ostream& (*func)(ostream< IO_device >&))
+template< class IO_device, size_t buf_size >
+template< typename T >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::put_signed(T value)
 {
-    return func(*this);
+    using unsigned_type = typename std::make_unsigned< T >::type;
+    auto magnitude = static_cast< unsigned_type >(value);
+
+    if (m_base == 16 || value >= 0) {
+        return put_integer(magnitude, false);
+    }
+
+    // Negation is done on unsigned type, so minimal value doesn't overflow
+    return put_integer(unsigned_type{0} - magnitude, true);
 }
 
-template< class IO_device >
-ostream<IO_device>& ostream< IO_device >::put(char c)
+template< class IO_device, size_t buf_size >
+ostream< IO_device, buf_size >& ostream< IO_device, buf_size >::put_integer(unsigned long long value, bool negative)
 {
-    m_device->write((uint8_t *)&c, 1);
+    // 64-bit value takes 20 decimal digits at most, plus sign
+    char buf[24];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+
+    if (m_base == 16) {
+        do {
+            *--p = "0123456789abcdef"[value & 0xf];
+            value >>= 4;
+        } while (value);
+    } else {
+        // 64-bit division is slow on 32-bit cores, thus used only if required
+        while (value > UINT32_MAX) {
+            auto rest = value / 100;
+            p = ostream_detail::format_pair(p, static_cast< uint32_t >(value - rest * 100));
+            value = rest;
+        }
+
+        p = ostream_detail::format_dec(p, static_cast< uint32_t >(value));
+    }
+
+    if (negative) {
+        *--p = '-';
+    }
+
+    size_t len = end - p;
+    put_padding(len);
+
+    while (p != end) {
+        put(*p++);
+    }
+
     return *this;
 }
 
+template< class IO_device, size_t buf_size >
+void ostream< IO_device, buf_size >::put_padding(size_t len)
+{
+    auto width = m_width;
+    m_width = 0;
+
+    for (; width > len; --width) {
+        put(m_fill);
+    }
+}
+
 }
 
 #endif // ECL_OSTREAM_HPP
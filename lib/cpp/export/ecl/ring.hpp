@@ -0,0 +1,198 @@
+//!
+//! \file
+//! \brief FIFO queue with fixed capacity and in-place storage.
+//! Elements are held in a circular buffer inside the object itself, so the
+//! queue never allocates. Unlike ecl::byte_ring or ecl::spsc_queue it is not
+//! synchronized: callers serialize access, i.e. with ecl::mutex or IRQ_lock.
+//! \code
+//! ecl::ring< event, 16 > q;
+//! q.push_back(ev);
+//! while (!q.empty()) { handle(q.front()); q.pop_front(); }
+//! \endcode
+//!
+#ifndef ECL_RING_HPP_
+#define ECL_RING_HPP_
+
+#include <ecl/assert.h>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ecl
+{
+
+//!
+//! \brief Circular FIFO queue with fixed capacity.
+//! Insertion into the full queue fails and leaves it unchanged.
+//! Power of two capacity lets wrap-around be done by masking.
+//! \tparam T Element type.
+//! \tparam N Capacity.
+//!
+template< class T, size_t N >
+class ring
+{
+    static_assert(N > 0, "Ring must hold at least one element");
+
+public:
+    using value_type = T;
+    using size_type  = size_t;
+
+    //! Constructs empty queue. Storage is constant-initialized.
+    constexpr ring() :m_storage{}, m_head{0}, m_size{0} { }
+
+    ring(const ring &other);
+    ring &operator=(const ring &other);
+    ~ring();
+
+    //! Gets capacity.
+    static constexpr size_t capacity() { return N; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return !m_size; }
+    bool full() const { return m_size == N; }
+
+    //!
+    //! \brief Gets element, counting from the oldest one.
+    //! \pre Index is less than size.
+    //!
+    T &operator[](size_t idx)
+    {
+        ecl_assert(idx < m_size);
+        return slot(wrap(m_head + idx));
+    }
+
+    //! \copydoc operator[]()
+    const T &operator[](size_t idx) const
+    {
+        ecl_assert(idx < m_size);
+        return slot(wrap(m_head + idx));
+    }
+
+    //! Oldest element. \pre Queue is not empty.
+    T &front() { return (*this)[0]; }
+    //! Newest element. \pre Queue is not empty.
+    T &back() { return (*this)[m_size - 1]; }
+    const T &front() const { return (*this)[0]; }
+    const T &back() const { return (*this)[m_size - 1]; }
+
+    //!
+    //! \brief Constructs element at the end.
+    //! \return Pointer to the element, nullptr if queue is full.
+    //!
+    template< class... Args >
+    T *emplace_back(Args&&... args)
+    {
+        if (full()) {
+            return nullptr;
+        }
+
+        auto p = new (&slot(wrap(m_head + m_size))) T(std::forward< Args >(args)...);
+        m_size++;
+        return p;
+    }
+
+    //! Appends element. \return false if queue is full.
+    bool push_back(const T &val) { return emplace_back(val) != nullptr; }
+    //! \copydoc push_back()
+    bool push_back(T &&val) { return emplace_back(std::move(val)) != nullptr; }
+
+    //!
+    //! \brief Destroys oldest element.
+    //! \pre Queue is not empty.
+    //!
+    void pop_front()
+    {
+        ecl_assert(m_size);
+
+        slot(m_head).~T();
+        m_head = wrap(m_head + 1);
+        m_size--;
+    }
+
+    //!
+    //! \brief Moves oldest element out and destroys it.
+    //! \return false if queue is empty.
+    //!
+    bool pop_front(T &out)
+    {
+        if (empty()) {
+            return false;
+        }
+
+        out = std::move(front());
+        pop_front();
+        return true;
+    }
+
+    //! Destroys all elements.
+    void clear()
+    {
+        if (std::is_trivially_destructible< T >::value) {
+            m_size = 0;
+        }
+
+        while (m_size) {
+            pop_front();
+        }
+
+        m_head = 0;
+    }
+
+private:
+    //! Maps logical position, less than 2 * N, to a slot index.
+    static constexpr size_t wrap(size_t pos)
+    {
+        return (N & (N - 1)) ? (pos >= N ? pos - N : pos) : (pos & (N - 1));
+    }
+
+    T &slot(size_t idx)
+    {
+        return reinterpret_cast< T* >(m_storage)[idx];
+    }
+
+    const T &slot(size_t idx) const
+    {
+        return reinterpret_cast< const T* >(m_storage)[idx];
+    }
+
+    alignas(T) unsigned char    m_storage[N * sizeof(T)];   //!< Elements.
+    size_t                      m_head;                     //!< Slot of the oldest element.
+    size_t                      m_size;                     //!< Elements in the queue.
+};
+
+//------------------------------------------------------------------------------
+
+template< class T, size_t N >
+ring< T, N >::ring(const ring &other)
+    :ring{}
+{
+    for (size_t i = 0; i < other.size(); ++i) {
+        emplace_back(other[i]);
+    }
+}
+
+template< class T, size_t N >
+ring< T, N > &ring< T, N >::operator=(const ring &other)
+{
+    if (this != &other) {
+        clear();
+
+        for (size_t i = 0; i < other.size(); ++i) {
+            emplace_back(other[i]);
+        }
+    }
+
+    return *this;
+}
+
+template< class T, size_t N >
+ring< T, N >::~ring()
+{
+    clear();
+}
+
+} // namespace ecl
+
+#endif // ECL_RING_HPP_
@@ -0,0 +1,99 @@
+//!
+//! \file
+//! \brief Lazily constructed objects with static storage duration.
+//! Global objects with non-trivial constructors are initialized by startup
+//! code before the kernel starts, whether they are used or not, and in no
+//! particular order across translation units. static_instance reserves
+//! storage only: it is constant-initialized, thus has no entry in init array,
+//! and the object itself is constructed on first use.
+//! \code
+//! static ecl::static_instance< big_driver > driver;
+//!
+//! void handle()
+//! {
+//!     driver.get().send(...); // Constructed here, if wasn't yet
+//! }
+//! \endcode
+//!
+#ifndef ECL_STATIC_INSTANCE_HPP_
+#define ECL_STATIC_INSTANCE_HPP_
+
+#include <ecl/assert.h>
+
+#include <new>
+#include <utility>
+
+namespace ecl
+{
+
+//!
+//! \brief Storage for an object, constructed on demand.
+//! Object is never destroyed, as any other global in the embedded world.
+//! Construction is not synchronized: first access must not race with
+//! other threads or ISRs. If object is shared, construct it explicitly
+//! before it is published.
+//! \tparam T Object type.
+//!
+template< class T >
+class static_instance
+{
+public:
+    //! Reserves storage, nothing is constructed.
+    constexpr static_instance() :m_storage{}, m_constructed{false} { }
+
+    static_instance(const static_instance &) = delete;
+    static_instance &operator=(const static_instance &) = delete;
+
+    //!
+    //! \brief Constructs object with given arguments.
+    //! \pre Object is not constructed yet.
+    //! \return Constructed object.
+    //!
+    template< class... Args >
+    T &construct(Args&&... args)
+    {
+        ecl_assert(!m_constructed);
+
+        new (m_storage) T(std::forward< Args >(args)...);
+        m_constructed = true;
+        return object();
+    }
+
+    //!
+    //! \brief Gets object, default constructing it on first call.
+    //!
+    T &get()
+    {
+        if (!m_constructed) {
+            construct();
+        }
+
+        return object();
+    }
+
+    T &operator*()  { return get(); }
+    T *operator->() { return &get(); }
+
+    //!
+    //! \brief Checks if object is constructed already.
+    //!
+    bool constructed() const { return m_constructed; }
+
+    //!
+    //! \brief Gets address of the object without constructing it.
+    //! Address is valid for the whole program, so it can be handed out to
+    //! others during static initialization. Object must not be accessed
+    //! through it until constructed.
+    //!
+    T *address() { return reinterpret_cast< T* >(m_storage); }
+
+private:
+    T &object() { return *address(); }
+
+    alignas(T) unsigned char    m_storage[sizeof(T)];   //!< Object storage.
+    bool                        m_constructed;          //!< Construction flag.
+};
+
+} // namespace ecl
+
+#endif // ECL_STATIC_INSTANCE_HPP_
@@ -0,0 +1,244 @@
+//!
+//! \file
+//! \brief Vector with fixed capacity and in-place storage.
+//! Elements are held contiguously inside the object itself, so the vector
+//! never allocates and can be placed in any memory section, like a plain
+//! array. Unlike an array, only pushed elements are constructed.
+//! \code
+//! ecl::static_vector< int, 8 > v;
+//! v.push_back(1);
+//! v.emplace_back(2);
+//! for (auto x : v) { ... }
+//! \endcode
+//!
+#ifndef ECL_STATIC_VECTOR_HPP_
+#define ECL_STATIC_VECTOR_HPP_
+
+#include <ecl/assert.h>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ecl
+{
+
+//!
+//! \brief Vector with fixed capacity.
+//! Insertion into the full vector fails and leaves it unchanged.
+//! \tparam T Element type.
+//! \tparam N Capacity.
+//!
+template< class T, size_t N >
+class static_vector
+{
+    static_assert(N > 0, "Vector must hold at least one element");
+
+public:
+    using value_type        = T;
+    using size_type         = size_t;
+    using reference         = T&;
+    using const_reference   = const T&;
+    using iterator          = T*;
+    using const_iterator    = const T*;
+
+    //! Constructs empty vector. Storage is constant-initialized.
+    constexpr static_vector() :m_storage{}, m_size{0} { }
+
+    static_vector(const static_vector &other);
+    static_vector &operator=(const static_vector &other);
+    ~static_vector();
+
+    //! Gets capacity.
+    static constexpr size_t capacity() { return N; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return !m_size; }
+    bool full() const { return m_size == N; }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + m_size; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + m_size; }
+
+    T *data() { return reinterpret_cast< T* >(m_storage); }
+    const T *data() const { return reinterpret_cast< const T* >(m_storage); }
+
+    //!
+    //! \brief Gets element.
+    //! \pre Index is less than size.
+    //!
+    T &operator[](size_t idx)
+    {
+        ecl_assert(idx < m_size);
+        return data()[idx];
+    }
+
+    //! \copydoc operator[]()
+    const T &operator[](size_t idx) const
+    {
+        ecl_assert(idx < m_size);
+        return data()[idx];
+    }
+
+    T &front() { return (*this)[0]; }
+    T &back() { return (*this)[m_size - 1]; }
+    const T &front() const { return (*this)[0]; }
+    const T &back() const { return (*this)[m_size - 1]; }
+
+    //!
+    //! \brief Constructs element at the end.
+    //! \return Pointer to the element, nullptr if vector is full.
+    //!
+    template< class... Args >
+    T *emplace_back(Args&&... args);
+
+    //! Appends element. \return false if vector is full.
+    bool push_back(const T &val) { return emplace_back(val) != nullptr; }
+    //! \copydoc push_back()
+    bool push_back(T &&val) { return emplace_back(std::move(val)) != nullptr; }
+
+    //!
+    //! \brief Constructs element before given position.
+    //! Following elements are moved by one.
+    //! \return Iterator to the element, end() if vector is full.
+    //!
+    template< class... Args >
+    iterator emplace(const_iterator pos, Args&&... args);
+
+    //!
+    //! \brief Destroys last element.
+    //! \pre Vector is not empty.
+    //!
+    void pop_back();
+
+    //!
+    //! \brief Erases element, following elements are moved by one.
+    //! \return Iterator to the element that followed the erased one.
+    //!
+    iterator erase(const_iterator pos);
+
+    //! Destroys all elements.
+    void clear();
+
+private:
+    alignas(T) unsigned char    m_storage[N * sizeof(T)];   //!< Elements.
+    size_t                      m_size;                     //!< Elements constructed.
+};
+
+//------------------------------------------------------------------------------
+
+template< class T, size_t N >
+static_vector< T, N >::static_vector(const static_vector &other)
+    :static_vector{}
+{
+    for (auto &v : other) {
+        emplace_back(v);
+    }
+}
+
+template< class T, size_t N >
+static_vector< T, N > &static_vector< T, N >::operator=(const static_vector &other)
+{
+    if (this != &other) {
+        clear();
+
+        for (auto &v : other) {
+            emplace_back(v);
+        }
+    }
+
+    return *this;
+}
+
+template< class T, size_t N >
+static_vector< T, N >::~static_vector()
+{
+    clear();
+}
+
+template< class T, size_t N >
+template< class... Args >
+T *static_vector< T, N >::emplace_back(Args&&... args)
+{
+    if (full()) {
+        return nullptr;
+    }
+
+    auto p = new (data() + m_size) T(std::forward< Args >(args)...);
+    m_size++;
+    return p;
+}
+
+template< class T, size_t N >
+template< class... Args >
+typename static_vector< T, N >::iterator
+static_vector< T, N >::emplace(const_iterator pos, Args&&... args)
+{
+    ecl_assert(pos >= begin() && pos <= end());
+
+    size_t idx = pos - begin();
+
+    if (full()) {
+        return end();
+    }
+
+    if (idx == m_size) {
+        return emplace_back(std::forward< Args >(args)...);
+    }
+
+    // Element is constructed first, since arguments may refer to the vector
+    T tmp(std::forward< Args >(args)...);
+    auto p = data();
+
+    new (p + m_size) T(std::move(p[m_size - 1]));
+    for (size_t i = m_size - 1; i > idx; --i) {
+        p[i] = std::move(p[i - 1]);
+    }
+
+    p[idx] = std::move(tmp);
+    m_size++;
+    return p + idx;
+}
+
+template< class T, size_t N >
+void static_vector< T, N >::pop_back()
+{
+    ecl_assert(m_size);
+
+    data()[--m_size].~T();
+}
+
+template< class T, size_t N >
+typename static_vector< T, N >::iterator static_vector< T, N >::erase(const_iterator pos)
+{
+    ecl_assert(pos >= begin() && pos < end());
+
+    size_t idx = pos - begin();
+    auto p = data();
+
+    for (size_t i = idx; i + 1 < m_size; ++i) {
+        p[i] = std::move(p[i + 1]);
+    }
+
+    pop_back();
+    return p + idx;
+}
+
+template< class T, size_t N >
+void static_vector< T, N >::clear()
+{
+    // Trivially destructible elements are dropped at once
+    if (!std::is_trivially_destructible< T >::value) {
+        for (auto &v : *this) {
+            v.~T();
+        }
+    }
+
+    m_size = 0;
+}
+
+} // namespace ecl
+
+#endif // ECL_STATIC_VECTOR_HPP_
@@ -1,15 +1,33 @@
 #include <ecl/iostream.hpp>
+#include <ecl/static_instance.hpp>
 
-namespace ecl {
+#include <type_traits>
 
-// TODO: think about extending of console devices to cover
-// case when there are different drivers for cin, count and cerr streams.
-typename istream< console_driver >::device_type console_device;
+namespace ecl {
 
-// TODO: avoid this somehow.
+// Single device per driver type, so streams with the same driver share it.
+// Devices are constructed by init_console(), not by global constructors,
+// so streams can be bound to them regardless of static init order.
 // See https://isocpp.org/wiki/faq/ctors#static-init-order
+template< class Driver >
+static_instance< Driver > console_device;
+
+istream< cin_driver > cin{console_device< cin_driver >.address()};
+ostream< cout_driver > cout{console_device< cout_driver >.address()};
+ostream< cerr_driver, 0 > cerr{console_device< cerr_driver >.address()};
+
+void init_console()
+{
+    console_device< cin_driver >.get().init();
+
+    if (!std::is_same< cout_driver, cin_driver >::value) {
+        console_device< cout_driver >.get().init();
+    }
+
+    if (!std::is_same< cerr_driver, cin_driver >::value
+        && !std::is_same< cerr_driver, cout_driver >::value) {
+        console_device< cerr_driver >.get().init();
+    }
+}
 
-istream< console_driver > cin{&console_device};
-ostream< console_driver > cout{&console_device};
-ostream< console_driver > cerr{&console_device};
 }
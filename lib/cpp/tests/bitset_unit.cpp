@@ -0,0 +1,125 @@
+#include "bitset.hpp"
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Bits are set in constant expression
+constexpr ecl::bitset< 40 > make_pattern()
+{
+    ecl::bitset< 40 > b;
+    b.fill(3, 35, true);
+    b.reset(10);
+    return b;
+}
+
+constexpr auto pattern = make_pattern();
+
+static_assert(pattern.count() == 31, "Bits must be counted at compile time");
+static_assert(pattern.find(0, 40, true) == 3, "First set bit");
+static_assert(pattern.find(3, 40, false) == 10, "First cleared bit after the start");
+static_assert(pattern.find(11, 40, false) == 35, "Cleared bit in the next word");
+
+} // namespace
+
+TEST_GROUP(bitset)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(bitset, empty_on_construction)
+{
+    ecl::bitset< 70 > b;
+
+    CHECK_EQUAL(70U, b.size());
+    CHECK_EQUAL(3U, b.word_count);
+    CHECK_TRUE(b.none());
+    CHECK_FALSE(b.any());
+    CHECK_EQUAL(0U, b.count());
+}
+
+TEST(bitset, single_bits)
+{
+    ecl::bitset< 70 > b;
+
+    b.set(0);
+    b.set(31);
+    b.set(32);
+    b.set(69);
+
+    CHECK_TRUE(b.test(0));
+    CHECK_TRUE(b.test(31));
+    CHECK_TRUE(b.test(32));
+    CHECK_TRUE(b.test(69));
+    CHECK_FALSE(b.test(1));
+    CHECK_EQUAL(4U, b.count());
+
+    b.set(31, false);
+    b.reset(69);
+    CHECK_FALSE(b.test(31));
+    CHECK_FALSE(b.test(69));
+    CHECK_EQUAL(2U, b.count());
+
+    CHECK_EQUAL(0x1U, b.word(0));
+    CHECK_EQUAL(0x1U, b.word(1));
+}
+
+TEST(bitset, runs_cross_words)
+{
+    ecl::bitset< 100 > b;
+
+    b.fill(30, 70, true);
+    CHECK_EQUAL(40U, b.count());
+    CHECK_FALSE(b.test(29));
+    CHECK_TRUE(b.test(30));
+    CHECK_TRUE(b.test(69));
+    CHECK_FALSE(b.test(70));
+    // Whole word in the middle
+    CHECK_EQUAL(0xffffffffU, b.word(1));
+
+    b.fill(32, 64, false);
+    CHECK_EQUAL(8U, b.count());
+    CHECK_EQUAL(0U, b.word(1));
+}
+
+TEST(bitset, find_respects_range)
+{
+    ecl::bitset< 100 > b;
+
+    CHECK_EQUAL(100U, b.find(0, 100, true));
+    CHECK_EQUAL(0U, b.find(0, 100, false));
+    // Empty range
+    CHECK_EQUAL(5U, b.find(5, 5, false));
+
+    b.set(64);
+    CHECK_EQUAL(64U, b.find(0, 100, true));
+    CHECK_EQUAL(64U, b.find(64, 100, true));
+    CHECK_EQUAL(60U, b.find(0, 60, true));
+    CHECK_EQUAL(100U, b.find(65, 100, true));
+}
+
+TEST(bitset, all_ignores_tail_of_last_word)
+{
+    ecl::bitset< 33 > b;
+
+    b.fill(0, 33, true);
+    CHECK_TRUE(b.all());
+    CHECK_EQUAL(33U, b.count());
+    CHECK_EQUAL(33U, b.find(0, 33, false));
+
+    b.reset();
+    CHECK_TRUE(b.none());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,149 @@
+#include "endian.hpp"
+
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+TEST_GROUP(endian)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(endian, scalar)
+{
+    CHECK_EQUAL(0x3412, ecl::BE(static_cast< uint16_t >(0x1234)));
+    CHECK_EQUAL(0x78563412U, ecl::BE(static_cast< uint32_t >(0x12345678)));
+    CHECK(0x0807060504030201ULL == ecl::BE(static_cast< uint64_t >(0x0102030405060708ULL)));
+    CHECK_EQUAL(0x1234, ecl::LE(0x1234));
+}
+
+TEST(endian, unaligned_load)
+{
+    const uint8_t buf[] = { 0xff, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+
+    // Odd offset, so loads are unaligned
+    CHECK_EQUAL(0x0102, ecl::load_be16(buf + 1));
+    CHECK_EQUAL(0x0201, ecl::load_le16(buf + 1));
+    CHECK_EQUAL(0x01020304U, ecl::load_be32(buf + 1));
+    CHECK_EQUAL(0x04030201U, ecl::load_le32(buf + 1));
+    CHECK(0x0102030405060708ULL == ecl::load_be64(buf + 1));
+    CHECK(0x0807060504030201ULL == ecl::load_le64(buf + 1));
+}
+
+TEST(endian, unaligned_store)
+{
+    uint8_t buf[10] = {};
+
+    ecl::store_be32(buf + 1, 0x01020304);
+    CHECK_EQUAL(0, buf[0]);
+    CHECK_EQUAL(0x01, buf[1]);
+    CHECK_EQUAL(0x04, buf[4]);
+    CHECK_EQUAL(0, buf[5]);
+
+    ecl::store_le16(buf + 5, 0x0506);
+    CHECK_EQUAL(0x06, buf[5]);
+    CHECK_EQUAL(0x05, buf[6]);
+
+    ecl::store_be64(buf + 1, 0x1122334455667788ULL);
+    CHECK(0x1122334455667788ULL == ecl::load_be64(buf + 1));
+
+    ecl::store_be16(buf, 0xabcd);
+    ecl::store_le32(buf + 2, 0xdeadbeef);
+    ecl::store_le64(buf + 2, ecl::load_le64(buf + 2));
+    CHECK_EQUAL(0xabcd, ecl::load_be16(buf));
+    CHECK_EQUAL(0xdeadbeefU, ecl::load_le32(buf + 2));
+}
+
+TEST(endian, bulk_swap)
+{
+    // Sizes cover both vector and scalar tails
+    for (size_t count = 0; count < 40; ++count) {
+        std::vector< uint8_t > src(count * 8 + 1);
+        for (size_t i = 0; i < src.size(); ++i) {
+            src[i] = i * 7 + 1;
+        }
+
+        // Unaligned buffers
+        std::vector< uint8_t > dst(src.size() + 1);
+        const uint8_t *s = src.data() + 1;
+        uint8_t *d = dst.data() + 1;
+
+        ecl::swap_bytes16(d, s, count);
+        for (size_t i = 0; i < count; ++i) {
+            CHECK_EQUAL(ecl::BE(ecl::load_unaligned< uint16_t >(s + i * 2)),
+                        ecl::load_unaligned< uint16_t >(d + i * 2));
+        }
+
+        ecl::swap_bytes32(d, s, count);
+        for (size_t i = 0; i < count; ++i) {
+            CHECK_EQUAL(ecl::BE(ecl::load_unaligned< uint32_t >(s + i * 4)),
+                        ecl::load_unaligned< uint32_t >(d + i * 4));
+        }
+
+        ecl::swap_bytes64(d, s, count);
+        for (size_t i = 0; i < count; ++i) {
+            CHECK(ecl::BE(ecl::load_unaligned< uint64_t >(s + i * 8))
+                  == ecl::load_unaligned< uint64_t >(d + i * 8));
+        }
+
+        // Element after the last one is untouched
+        CHECK_EQUAL(0, dst[count * 8 + 1]);
+    }
+}
+
+TEST(endian, in_place_swap)
+{
+    uint32_t words[9];
+    for (uint32_t i = 0; i < 9; ++i) {
+        words[i] = 0x01020300 + i;
+    }
+
+    ecl::swap_bytes32(words, words, 9);
+    for (uint32_t i = 0; i < 9; ++i) {
+        CHECK_EQUAL(ecl::BE(0x01020300 + i), words[i]);
+    }
+}
+
+TEST(endian, every_extension)
+{
+#if ECL_CPU_X86
+    // Paths, not taken by dispatch on this CPU, are checked as well
+    uint8_t src[83];
+    uint8_t dst[83];
+    for (size_t i = 0; i < sizeof(src); ++i) {
+        src[i] = i;
+    }
+
+    if (ecl::cpu::has_ssse3()) {
+        memset(dst, 0, sizeof(dst));
+        CHECK_EQUAL(80, ecl::detail::shuffle_ssse3(dst, src, 83, ecl::detail::swap_order32));
+        for (uint32_t i = 0; i < 20; ++i) {
+            CHECK_EQUAL(__builtin_bswap32(ecl::load_unaligned< uint32_t >(src + i * 4)),
+                        ecl::load_unaligned< uint32_t >(dst + i * 4));
+        }
+        CHECK_EQUAL(0, dst[80]);
+    }
+
+    if (ecl::cpu::has_avx2()) {
+        memset(dst, 0, sizeof(dst));
+        CHECK_EQUAL(80, ecl::detail::shuffle_avx2(dst, src, 83, ecl::detail::swap_order16));
+        for (uint32_t i = 0; i < 40; ++i) {
+            CHECK_EQUAL(__builtin_bswap16(ecl::load_unaligned< uint16_t >(src + i * 2)),
+                        ecl::load_unaligned< uint16_t >(dst + i * 2));
+        }
+        CHECK_EQUAL(0, dst[80]);
+    }
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
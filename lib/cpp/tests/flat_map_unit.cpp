@@ -0,0 +1,122 @@
+#include "flat_map.hpp"
+
+#include <functional>
+#include <string.h>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+TEST_GROUP(flat_map)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(flat_map, items_are_sorted)
+{
+    ecl::flat_map< int, int, 8 > m;
+
+    CHECK_TRUE(m.insert(5, 50).second);
+    CHECK_TRUE(m.insert(1, 10).second);
+    CHECK_TRUE(m.emplace(3, 30).second);
+
+    int prev = 0;
+    for (auto &item : m) {
+        CHECK_TRUE(item.first > prev);
+        CHECK_EQUAL(item.first * 10, item.second);
+        prev = item.first;
+    }
+
+    CHECK_EQUAL(3U, m.size());
+}
+
+TEST(flat_map, lookup)
+{
+    ecl::flat_map< int, const char *, 4 > m;
+
+    m.insert(2, "two");
+    m.insert(4, "four");
+
+    const auto &cm = m;
+    auto it = cm.find(4);
+    CHECK_TRUE(it != cm.end());
+    STRCMP_EQUAL("four", it->second);
+
+    CHECK_TRUE(m.contains(2));
+    CHECK_FALSE(m.contains(3));
+    CHECK_TRUE(m.find(1) == m.end());
+    CHECK_TRUE(m.find(5) == m.end());
+}
+
+TEST(flat_map, duplicates_are_not_inserted)
+{
+    ecl::flat_map< int, int, 4 > m;
+
+    m.insert(1, 10);
+    auto rc = m.insert(1, 20);
+
+    CHECK_FALSE(rc.second);
+    CHECK_EQUAL(10, rc.first->second);
+    CHECK_EQUAL(1U, m.size());
+}
+
+TEST(flat_map, full_map_rejects_new_keys)
+{
+    ecl::flat_map< int, int, 2 > m;
+
+    m.insert(1, 10);
+    m.insert(3, 30);
+    CHECK_TRUE(m.full());
+
+    auto rc = m.insert(2, 20);
+    CHECK_FALSE(rc.second);
+    CHECK_TRUE(rc.first == m.end());
+    CHECK_FALSE(m.contains(2));
+
+    // Existing key is still found
+    rc = m.insert(3, 0);
+    CHECK_FALSE(rc.second);
+    CHECK_EQUAL(30, rc.first->second);
+}
+
+TEST(flat_map, erase)
+{
+    ecl::flat_map< int, int, 4 > m;
+
+    m.insert(1, 10);
+    m.insert(2, 20);
+    m.insert(3, 30);
+
+    CHECK_EQUAL(1U, m.erase(2));
+    CHECK_EQUAL(0U, m.erase(2));
+    CHECK_FALSE(m.contains(2));
+    CHECK_EQUAL(3, m.begin()[1].first);
+
+    auto it = m.erase(m.begin());
+    CHECK_EQUAL(3, it->first);
+
+    m.clear();
+    CHECK_TRUE(m.empty());
+}
+
+TEST(flat_map, custom_order)
+{
+    ecl::flat_map< int, int, 4, std::greater< int > > m;
+
+    m.insert(1, 0);
+    m.insert(3, 0);
+    m.insert(2, 0);
+
+    CHECK_EQUAL(3, m.begin()->first);
+    CHECK_TRUE(m.contains(1));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
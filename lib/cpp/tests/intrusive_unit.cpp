@@ -0,0 +1,87 @@
+#include "memory.hpp"
+
+#include <new>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+static int destroyed;
+
+struct node : ecl::ref_counted< node >
+{
+    void destroy()
+    {
+        destroyed++;
+        this->~node();
+    }
+
+    int value = 0;
+};
+
+// Storage is static, so destroyed objects can be inspected
+static std::aligned_storage_t< sizeof(node), alignof(node) > storage;
+
+TEST_GROUP(intrusive)
+{
+    node *obj;
+
+    void setup()
+    {
+        destroyed = 0;
+        obj = new (&storage) node;
+    }
+};
+
+TEST(intrusive, empty_pointer)
+{
+    ecl::intrusive_ptr< node > ptr;
+    CHECK_FALSE(ptr);
+    POINTERS_EQUAL(nullptr, ptr.get());
+
+    ptr.reset();
+    ecl::intrusive_ptr< node > copy{ptr};
+    CHECK_FALSE(copy);
+}
+
+TEST(intrusive, copy_and_move)
+{
+    {
+        ecl::intrusive_ptr< node > ptr{obj};
+        CHECK_EQUAL(1, obj->ref_count());
+
+        auto copy = ptr;
+        CHECK_EQUAL(2, obj->ref_count());
+        CHECK_TRUE(copy == ptr);
+
+        auto moved = std::move(copy);
+        CHECK_EQUAL(2, obj->ref_count());
+        CHECK_FALSE(copy);
+
+        moved->value = 42;
+        CHECK_EQUAL(42, (*ptr).value);
+
+        ptr = nullptr;
+        CHECK_EQUAL(1, obj->ref_count());
+        CHECK_EQUAL(0, destroyed);
+    }
+
+    // Last reference is gone
+    CHECK_EQUAL(1, destroyed);
+}
+
+TEST(intrusive, self_assignment)
+{
+    ecl::intrusive_ptr< node > ptr{obj};
+
+    ptr = ptr;
+    CHECK_EQUAL(1, obj->ref_count());
+    CHECK_EQUAL(0, destroyed);
+
+    ptr.reset();
+    CHECK_EQUAL(1, destroyed);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
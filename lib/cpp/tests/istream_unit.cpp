@@ -0,0 +1,180 @@
+#include "istream.hpp"
+
+#include <cstring>
+#include <string>
+#include <sys/types.h>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+// Device that returns prepared input and counts read calls
+struct fake_device
+{
+    ssize_t read(uint8_t *data, size_t count)
+    {
+        ++reads;
+
+        if (pos == in.size()) {
+            return -1;
+        }
+
+        // Device returns as soon as some data is available
+        if (max_chunk && count > max_chunk) {
+            count = max_chunk;
+        }
+
+        if (count > in.size() - pos) {
+            count = in.size() - pos;
+        }
+
+        memcpy(data, in.data() + pos, count);
+        pos += count;
+        return count;
+    }
+
+    std::string in;
+    size_t pos = 0;
+    int reads = 0;
+    size_t max_chunk = 0;
+};
+
+// Device that can be polled
+struct polled_device : fake_device
+{
+    ssize_t try_read(uint8_t *data, size_t count)
+    {
+        ++polls;
+
+        if (!ready) {
+            return -1;
+        }
+
+        return read(data, count);
+    }
+
+    bool ready = false;
+    int polls = 0;
+};
+
+TEST_GROUP(istream)
+{
+    fake_device dev;
+
+    void setup()
+    {
+        dev = fake_device{};
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(istream, formatted_input_is_buffered)
+{
+    ecl::istream< fake_device, 32 > is{&dev};
+    int a;
+    unsigned b;
+    char c;
+    char str[16] = {};
+
+    dev.in = "-12 34 x word\n";
+    is >> a >> b >> c >> str;
+
+    CHECK_EQUAL(-12, a);
+    CHECK_EQUAL(34, b);
+    CHECK_EQUAL('x', c);
+    CHECK_EQUAL(0, strncmp("word", str, 4));
+
+    // Whole input is fetched by single read
+    CHECK_EQUAL(1, dev.reads);
+}
+
+TEST(istream, unbuffered_reads_each_char)
+{
+    ecl::istream< fake_device, 0 > is{&dev};
+
+    dev.in = "ab";
+    CHECK_EQUAL('a', is.get());
+    CHECK_EQUAL('b', is.get());
+    CHECK_EQUAL(-1, is.get());
+    CHECK_EQUAL(3, dev.reads);
+}
+
+TEST(istream, getline_with_line_discipline)
+{
+    ecl::istream< fake_device, 8 > is{&dev};
+    char line[16];
+
+    dev.in = "helo\blo\r\nnext\n";
+    dev.max_chunk = 3;
+
+    is.getline(line, sizeof(line));
+    STRCMP_EQUAL("hello", line);
+    CHECK_EQUAL(9, is.gcount());
+
+    is.getline(line, sizeof(line));
+    STRCMP_EQUAL("next", line);
+
+    // No more input
+    is.getline(line, sizeof(line));
+    STRCMP_EQUAL("", line);
+    CHECK_EQUAL(0, is.gcount());
+}
+
+TEST(istream, getline_truncates_long_line)
+{
+    ecl::istream< fake_device, 8 > is{&dev};
+    char line[4];
+
+    dev.in = "abcdef\n";
+
+    is.getline(line, sizeof(line), '\n');
+    STRCMP_EQUAL("abc", line);
+
+    // Rest of the line is left in the stream
+    CHECK_EQUAL('d', is.get());
+}
+
+TEST(istream, readsome_returns_buffered_only)
+{
+    ecl::istream< fake_device, 4 > is{&dev};
+    char buf[8];
+
+    dev.in = "abcdef";
+
+    // Nothing buffered, device can't be polled
+    CHECK_EQUAL(0, is.readsome(buf, sizeof(buf)));
+    CHECK_EQUAL(0, dev.reads);
+
+    CHECK_EQUAL('a', is.get());
+    CHECK_EQUAL(3, is.readsome(buf, sizeof(buf)));
+    CHECK_EQUAL(0, strncmp("bcd", buf, 3));
+    CHECK_EQUAL(1, dev.reads);
+}
+
+TEST(istream, readsome_polls_device)
+{
+    polled_device pdev;
+    ecl::istream< polled_device, 4 > is{&pdev};
+    char buf[8];
+    char c;
+
+    pdev.in = "abcdef";
+
+    CHECK_FALSE(is.try_read(c));
+    CHECK_EQUAL(1, pdev.polls);
+
+    pdev.ready = true;
+    CHECK_EQUAL(6, is.readsome(buf, sizeof(buf)));
+    CHECK_EQUAL(0, strncmp("abcdef", buf, 6));
+    CHECK_EQUAL(6, is.gcount());
+
+    // Device is drained
+    CHECK_FALSE(is.try_read(c));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
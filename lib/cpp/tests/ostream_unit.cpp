@@ -0,0 +1,175 @@
+#include "ostream.hpp"
+
+#include <climits>
+#include <cstdio>
+#include <string>
+#include <sys/types.h>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+// Device that records output and counts write calls
+struct fake_device
+{
+    ssize_t write(const uint8_t *data, size_t count)
+    {
+        ++writes;
+
+        // Device may accept only part of the data
+        if (max_chunk && count > max_chunk) {
+            count = max_chunk;
+        }
+
+        out.append(reinterpret_cast< const char * >(data), count);
+        return count;
+    }
+
+    std::string out;
+    int writes = 0;
+    size_t max_chunk = 0;
+};
+
+TEST_GROUP(ostream)
+{
+    fake_device dev;
+
+    void setup()
+    {
+        dev = fake_device{};
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(ostream, output_is_buffered_until_endl)
+{
+    ecl::ostream< fake_device, 64 > os{&dev};
+
+    os << "value: " << 42 << ' ' << -7 << ' ' << 100u;
+    CHECK_EQUAL(0, dev.writes);
+
+    os << ecl::endl;
+    CHECK_EQUAL(1, dev.writes);
+    STRCMP_EQUAL("value: 42 -7 100\n\r", dev.out.c_str());
+}
+
+TEST(ostream, full_buffer_is_flushed)
+{
+    ecl::ostream< fake_device, 4 > os{&dev};
+
+    os << "abcdef";
+    CHECK_EQUAL(1, dev.writes);
+    STRCMP_EQUAL("abcd", dev.out.c_str());
+
+    os << ecl::flush;
+    CHECK_EQUAL(2, dev.writes);
+    STRCMP_EQUAL("abcdef", dev.out.c_str());
+
+    // Nothing to flush
+    os.flush();
+    CHECK_EQUAL(2, dev.writes);
+}
+
+TEST(ostream, newline_gets_carriage_return)
+{
+    ecl::ostream< fake_device, 16 > os{&dev};
+
+    os << "a\nb";
+    os.flush();
+    STRCMP_EQUAL("a\r\nb", dev.out.c_str());
+}
+
+TEST(ostream, partial_writes_are_retried)
+{
+    ecl::ostream< fake_device, 16 > os{&dev};
+    dev.max_chunk = 3;
+
+    os << "12345678" << ecl::flush;
+    CHECK_EQUAL(3, dev.writes);
+    STRCMP_EQUAL("12345678", dev.out.c_str());
+}
+
+TEST(ostream, unbuffered_writes_each_char)
+{
+    ecl::ostream< fake_device, 0 > os{&dev};
+
+    os << "abc";
+    CHECK_EQUAL(3, dev.writes);
+    STRCMP_EQUAL("abc", dev.out.c_str());
+}
+
+TEST(ostream, destruction_flushes)
+{
+    {
+        ecl::ostream< fake_device, 16 > os{&dev};
+        os << "bye";
+        CHECK_EQUAL(0, dev.writes);
+    }
+
+    STRCMP_EQUAL("bye", dev.out.c_str());
+}
+
+TEST(ostream, integer_limits)
+{
+    ecl::ostream< fake_device, 128 > os{&dev};
+
+    os << 0 << ' ' << 9 << ' ' << 10 << ' ' << 99 << ' ' << 100 << ' '
+       << INT_MIN << ' ' << INT_MAX << ' ' << UINT_MAX;
+    os.flush();
+    STRCMP_EQUAL("0 9 10 99 100 -2147483648 2147483647 4294967295", dev.out.c_str());
+}
+
+TEST(ostream, 64bit_integers)
+{
+    ecl::ostream< fake_device, 128 > os{&dev};
+
+    os << LLONG_MIN << ' ' << ULLONG_MAX << ' ' << 10000000000ull << ' '
+       << 4294967296ull;
+    os.flush();
+    STRCMP_EQUAL("-9223372036854775808 18446744073709551615 10000000000 4294967296",
+                 dev.out.c_str());
+}
+
+TEST(ostream, hex_and_dec)
+{
+    ecl::ostream< fake_device, 128 > os{&dev};
+
+    os << ecl::hex << 255 << ' ' << 0u << ' ' << 0xdeadbeefu << ' ' << -1
+       << ' ' << 0x123456789abcull << ecl::dec << ' ' << 255;
+    os.flush();
+    STRCMP_EQUAL("ff 0 deadbeef ffffffff 123456789abc 255", dev.out.c_str());
+}
+
+TEST(ostream, width_and_fill)
+{
+    ecl::ostream< fake_device, 128 > os{&dev};
+
+    os << ecl::setw(5) << 42 << '|' << ecl::setw(4) << -7 << '|'
+       << ecl::setfill('0') << ecl::hex << ecl::setw(8) << 0xbeefu << '|'
+       << ecl::setfill('.') << ecl::setw(6) << "abc" << '|'
+       << ecl::setw(2) << 12345u << '|'
+       // Width applies to the next field only
+       << 1;
+    os.flush();
+    STRCMP_EQUAL("   42|  -7|0000beef|...abc|3039|1", dev.out.c_str());
+}
+
+TEST(ostream, pointers)
+{
+    ecl::ostream< fake_device, 128 > os{&dev};
+    int local;
+
+    os << static_cast< const void* >(&local) << ' ' << 10;
+    os.flush();
+
+    char expected[64];
+    snprintf(expected, sizeof(expected), "%p 10", static_cast< void* >(&local));
+    STRCMP_EQUAL(expected, dev.out.c_str());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,125 @@
+// Atomic reference counting is checked by sharing pointers between threads
+#define CONFIG_ATOMIC_REFCOUNT
+
+#include "memory.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+static constexpr auto threads       = 4;
+static constexpr auto iterations    = 100000;
+
+static std::atomic_int destroyed;
+static std::atomic_int deallocated;
+
+struct node : ecl::ref_counted< node >
+{
+    void destroy()
+    {
+        destroyed++;
+        this->~node();
+    }
+};
+
+struct object
+{
+    ~object() { destroyed++; }
+};
+
+template< typename T >
+struct test_allocator
+{
+    T* allocate(size_t n)
+    {
+        return static_cast< T* >(aligned_alloc(alignof(T), n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t)
+    {
+        deallocated++;
+        free(p);
+    }
+
+    template< typename U >
+    test_allocator< U > rebind() const
+    {
+        return test_allocator< U >{};
+    }
+};
+
+// Copies and drops pointer in few threads at once
+template< class Ptr >
+static void share(const Ptr &ptr)
+{
+    std::vector< std::thread > workers;
+
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&ptr]() {
+            for (int j = 0; j < iterations; ++j) {
+                Ptr copy{ptr};
+            }
+        });
+    }
+
+    for (auto &t : workers) {
+        t.join();
+    }
+}
+
+TEST_GROUP(refcount_atomic)
+{
+    void setup()
+    {
+        destroyed   = 0;
+        deallocated = 0;
+    }
+};
+
+TEST(refcount_atomic, intrusive)
+{
+    static std::aligned_storage_t< sizeof(node), alignof(node) > storage;
+    auto obj = new (&storage) node;
+
+    {
+        ecl::intrusive_ptr< node > ptr{obj};
+        share(ptr);
+        CHECK_EQUAL(1, obj->ref_count());
+        CHECK_EQUAL(0, destroyed);
+    }
+
+    CHECK_EQUAL(1, destroyed);
+}
+
+TEST(refcount_atomic, shared_and_weak)
+{
+    {
+        auto ptr = ecl::allocate_shared< object >(test_allocator< object >{});
+        ecl::weak_ptr< object > weak{ptr};
+
+        share(ptr);
+
+        CHECK_TRUE(ptr.unique());
+        CHECK_TRUE(weak.lock() == ptr);
+        CHECK_EQUAL(0, destroyed);
+
+        ptr = nullptr;
+        CHECK_EQUAL(1, destroyed);
+        CHECK_EQUAL(0, deallocated);
+
+        // Expired weak reference releases memory
+        CHECK_TRUE(weak.expired());
+        CHECK_EQUAL(1, deallocated);
+    }
+
+    CHECK_EQUAL(1, deallocated);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
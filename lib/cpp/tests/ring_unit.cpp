@@ -0,0 +1,134 @@
+#include "ring.hpp"
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Counts live objects
+struct counted
+{
+    counted(int v) :value{v} { ++alive; }
+    counted(const counted &other) :value{other.value} { ++alive; }
+    counted &operator=(const counted &other) = default;
+    ~counted() { --alive; }
+
+    int value;
+
+    static int alive;
+};
+
+int counted::alive;
+
+// Pushes and pops values, so the queue is wrapped many times
+template< size_t N >
+void check_wrap()
+{
+    ecl::ring< int, N > r;
+    int next_in = 0;
+    int next_out = 0;
+
+    for (int round = 0; round < 10; ++round) {
+        while (r.push_back(next_in)) {
+            next_in++;
+        }
+
+        CHECK_TRUE(r.full());
+        CHECK_EQUAL(N, r.size());
+        CHECK_EQUAL(next_in - 1, r.back());
+
+        // Leave some elements, so head moves across the end
+        for (size_t i = 0; i < N / 2 + 1; ++i) {
+            int v;
+            CHECK_TRUE(r.pop_front(v));
+            CHECK_EQUAL(next_out++, v);
+        }
+    }
+
+    for (size_t i = 0; i < r.size(); ++i) {
+        CHECK_EQUAL(next_out + static_cast< int >(i), r[i]);
+    }
+}
+
+} // namespace
+
+TEST_GROUP(ring)
+{
+    void setup()
+    {
+        counted::alive = 0;
+    }
+
+    void teardown()
+    {
+        CHECK_EQUAL(0, counted::alive);
+    }
+};
+
+TEST(ring, fifo_order)
+{
+    ecl::ring< int, 4 > r;
+
+    CHECK_TRUE(r.empty());
+    CHECK_EQUAL(4U, r.capacity());
+
+    r.push_back(1);
+    r.push_back(2);
+    r.emplace_back(3);
+
+    CHECK_EQUAL(3U, r.size());
+    CHECK_EQUAL(1, r.front());
+    CHECK_EQUAL(3, r.back());
+
+    r.pop_front();
+    CHECK_EQUAL(2, r.front());
+
+    int v = 0;
+    CHECK_TRUE(r.pop_front(v));
+    CHECK_EQUAL(2, v);
+    CHECK_TRUE(r.pop_front(v));
+    CHECK_EQUAL(3, v);
+    CHECK_FALSE(r.pop_front(v));
+    CHECK_TRUE(r.empty());
+}
+
+TEST(ring, wraps_with_power_of_two_capacity)
+{
+    check_wrap< 8 >();
+}
+
+TEST(ring, wraps_with_arbitrary_capacity)
+{
+    check_wrap< 5 >();
+    check_wrap< 1 >();
+}
+
+TEST(ring, elements_are_destroyed)
+{
+    {
+        ecl::ring< counted, 3 > r;
+
+        r.emplace_back(1);
+        r.emplace_back(2);
+        r.pop_front();
+        r.emplace_back(3);
+        r.emplace_back(4);
+        CHECK_EQUAL(3, counted::alive);
+
+        auto copy = r;
+        CHECK_EQUAL(6, counted::alive);
+        CHECK_EQUAL(2, copy.front().value);
+        CHECK_EQUAL(4, copy.back().value);
+
+        copy.clear();
+        CHECK_EQUAL(3, counted::alive);
+    }
+
+    CHECK_EQUAL(0, counted::alive);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
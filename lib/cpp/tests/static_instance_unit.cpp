@@ -0,0 +1,90 @@
+#include "static_instance.hpp"
+
+#include <type_traits>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Counts constructions
+struct counted
+{
+    counted() :value{42} { ++ctors; }
+    counted(int v) :value{v} { ++ctors; }
+
+    int value;
+
+    static int ctors;
+};
+
+int counted::ctors;
+
+// Must be constant-initialized, thus not constructed by startup code
+ecl::static_instance< counted > global;
+
+} // namespace
+
+TEST_GROUP(static_instance)
+{
+    void setup()
+    {
+        counted::ctors = 0;
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(static_instance, lazy_construction)
+{
+    ecl::static_instance< counted > inst;
+
+    CHECK_FALSE(inst.constructed());
+    CHECK_EQUAL(0, counted::ctors);
+
+    CHECK_EQUAL(42, inst.get().value);
+    CHECK_TRUE(inst.constructed());
+    CHECK_EQUAL(1, counted::ctors);
+
+    // Constructed only once
+    inst->value = 7;
+    CHECK_EQUAL(7, (*inst).value);
+    CHECK_EQUAL(1, counted::ctors);
+}
+
+TEST(static_instance, explicit_construction)
+{
+    ecl::static_instance< counted > inst;
+
+    auto &obj = inst.construct(5);
+    CHECK_EQUAL(5, obj.value);
+    CHECK_EQUAL(&obj, &inst.get());
+    CHECK_EQUAL(1, counted::ctors);
+}
+
+TEST(static_instance, address_is_stable)
+{
+    ecl::static_instance< counted > inst;
+
+    auto addr = inst.address();
+    CHECK_EQUAL(addr, &inst.get());
+    CHECK_EQUAL(0, reinterpret_cast< uintptr_t >(addr) % alignof(counted));
+}
+
+TEST(static_instance, global_is_not_constructed_at_startup)
+{
+    static_assert(std::is_trivially_destructible< ecl::static_instance< counted > >::value,
+                  "Instance must not register destructor");
+
+    CHECK_FALSE(global.constructed());
+    CHECK_EQUAL(42, global->value);
+    CHECK_TRUE(global.constructed());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,133 @@
+#include "static_vector.hpp"
+
+#include <type_traits>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Counts live objects
+struct counted
+{
+    counted(int v) :value{v} { ++alive; }
+    counted(const counted &other) :value{other.value} { ++alive; }
+    counted &operator=(const counted &other) = default;
+    ~counted() { --alive; }
+
+    int value;
+
+    static int alive;
+};
+
+int counted::alive;
+
+// Must be constant-initialized, thus not constructed by startup code
+ecl::static_vector< int, 4 > global;
+
+} // namespace
+
+TEST_GROUP(static_vector)
+{
+    void setup()
+    {
+        counted::alive = 0;
+    }
+
+    void teardown()
+    {
+        CHECK_EQUAL(0, counted::alive);
+    }
+};
+
+TEST(static_vector, storage_is_in_place)
+{
+    static_assert(sizeof(ecl::static_vector< uint32_t, 8 >) >= 8 * sizeof(uint32_t),
+                  "Elements must be stored inside the vector");
+
+    CHECK_TRUE(global.empty());
+    CHECK_TRUE(global.push_back(1));
+    CHECK_EQUAL(1, global[0]);
+    global.clear();
+}
+
+TEST(static_vector, push_until_full)
+{
+    ecl::static_vector< int, 3 > v;
+
+    CHECK_EQUAL(3U, v.capacity());
+    CHECK_TRUE(v.push_back(1));
+    CHECK_TRUE(v.push_back(2));
+    CHECK_TRUE(v.emplace_back(3) != nullptr);
+    CHECK_TRUE(v.full());
+
+    // Vector is left unchanged
+    CHECK_FALSE(v.push_back(4));
+    CHECK_TRUE(v.emplace_back(4) == nullptr);
+    CHECK_EQUAL(3U, v.size());
+
+    int sum = 0;
+    for (auto x : v) {
+        sum += x;
+    }
+
+    CHECK_EQUAL(6, sum);
+    CHECK_EQUAL(1, v.front());
+    CHECK_EQUAL(3, v.back());
+}
+
+TEST(static_vector, insert_and_erase_in_the_middle)
+{
+    ecl::static_vector< int, 5 > v;
+
+    v.push_back(1);
+    v.push_back(3);
+    v.push_back(4);
+
+    auto it = v.emplace(v.begin() + 1, 2);
+    CHECK_EQUAL(2, *it);
+    CHECK_EQUAL(4U, v.size());
+
+    for (int i = 0; i < 4; ++i) {
+        CHECK_EQUAL(i + 1, v[i]);
+    }
+
+    it = v.erase(v.begin());
+    CHECK_EQUAL(2, *it);
+    CHECK_EQUAL(3U, v.size());
+    CHECK_EQUAL(4, v.back());
+
+    v.pop_back();
+    CHECK_EQUAL(3, v.back());
+}
+
+TEST(static_vector, elements_are_destroyed)
+{
+    {
+        ecl::static_vector< counted, 4 > v;
+
+        v.emplace_back(1);
+        v.emplace_back(2);
+        v.emplace(v.begin(), 0);
+        CHECK_EQUAL(3, counted::alive);
+
+        auto copy = v;
+        CHECK_EQUAL(6, counted::alive);
+        CHECK_EQUAL(0, copy[0].value);
+
+        v.erase(v.begin() + 1);
+        CHECK_EQUAL(5, counted::alive);
+        CHECK_EQUAL(2, v[1].value);
+
+        copy = v;
+        CHECK_EQUAL(4, counted::alive);
+    }
+
+    CHECK_EQUAL(0, counted::alive);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
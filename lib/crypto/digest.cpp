@@ -0,0 +1,419 @@
+#include "ecl/crypto/digest.hpp"
+
+#include <cstring>
+
+namespace ecl
+{
+
+namespace crypto
+{
+
+namespace
+{
+
+inline uint32_t rol(uint32_t x, unsigned n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+inline uint32_t ror(uint32_t x, unsigned n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+inline uint32_t load_be(const uint8_t *p)
+{
+    return (static_cast< uint32_t >(p[0]) << 24) | (static_cast< uint32_t >(p[1]) << 16)
+         | (static_cast< uint32_t >(p[2]) << 8)  | p[3];
+}
+
+inline uint32_t load_le(const uint8_t *p)
+{
+    return (static_cast< uint32_t >(p[3]) << 24) | (static_cast< uint32_t >(p[2]) << 16)
+         | (static_cast< uint32_t >(p[1]) << 8)  | p[0];
+}
+
+inline void store_be(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+inline void store_le(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+
+namespace detail
+{
+
+md_engine::md_engine(compress_fn compress)
+    :m_compress{compress}
+    ,m_buf{}
+    ,m_used{0}
+    ,m_total{0}
+{
+}
+
+void md_engine::restart()
+{
+    m_used = 0;
+    m_total = 0;
+}
+
+void md_engine::absorb(uint32_t *state, const uint8_t *data, size_t size)
+{
+    m_total += size;
+
+    if (m_used) {
+        size_t chunk = sizeof(m_buf) - m_used;
+        if (chunk > size) {
+            chunk = size;
+        }
+
+        memcpy(m_buf + m_used, data, chunk);
+        m_used += chunk;
+        data += chunk;
+        size -= chunk;
+
+        if (m_used < sizeof(m_buf)) {
+            return;
+        }
+
+        m_compress(state, m_buf);
+        m_used = 0;
+    }
+
+    // Whole blocks are processed right from the input
+    for (; size >= sizeof(m_buf); size -= sizeof(m_buf), data += sizeof(m_buf)) {
+        m_compress(state, data);
+    }
+
+    memcpy(m_buf, data, size);
+    m_used = size;
+}
+
+void md_engine::pad(uint32_t *state, bool big_endian)
+{
+    uint64_t bits = m_total * 8;
+
+    m_buf[m_used++] = 0x80;
+
+    // No room for the length, it goes into the next block
+    if (m_used > sizeof(m_buf) - 8) {
+        memset(m_buf + m_used, 0, sizeof(m_buf) - m_used);
+        m_compress(state, m_buf);
+        m_used = 0;
+    }
+
+    memset(m_buf + m_used, 0, sizeof(m_buf) - 8 - m_used);
+
+    uint8_t *len = m_buf + sizeof(m_buf) - 8;
+
+    if (big_endian) {
+        store_be(len, bits >> 32);
+        store_be(len + 4, bits);
+    } else {
+        store_le(len, bits);
+        store_le(len + 4, bits >> 32);
+    }
+
+    m_compress(state, m_buf);
+    m_used = 0;
+}
+
+} // namespace detail
+
+//------------------------------------------------------------------------------
+
+md5::md5()
+    :md_engine{compress}
+    ,m_state{}
+{
+    reset();
+}
+
+void md5::reset()
+{
+    restart();
+
+    m_state[0] = 0x67452301;
+    m_state[1] = 0xefcdab89;
+    m_state[2] = 0x98badcfe;
+    m_state[3] = 0x10325476;
+}
+
+void md5::update(const uint8_t *data, size_t size)
+{
+    absorb(m_state, data, size);
+}
+
+void md5::finish(uint8_t *digest)
+{
+    pad(m_state, false);
+
+    for (size_t i = 0; i < 4; ++i) {
+        store_le(digest + 4 * i, m_state[i]);
+    }
+}
+
+void md5::compress(uint32_t *state, const uint8_t *block)
+{
+    static const uint32_t k[64] = {
+        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+        0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+        0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+        0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+        0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+        0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+        0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+        0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+        0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+        0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+        0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+    };
+
+    static const uint8_t r[16] = {
+        7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21,
+    };
+
+    uint32_t w[16];
+
+    for (size_t i = 0; i < 16; ++i) {
+        w[i] = load_le(block + 4 * i);
+    }
+
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+
+    for (size_t i = 0; i < 64; ++i) {
+        uint32_t f;
+        size_t g;
+
+        switch (i / 16) {
+        case 0:
+            f = (b & c) | (~b & d);
+            g = i;
+            break;
+        case 1:
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) % 16;
+            break;
+        case 2:
+            f = b ^ c ^ d;
+            g = (3 * i + 5) % 16;
+            break;
+        default:
+            f = c ^ (b | ~d);
+            g = (7 * i) % 16;
+            break;
+        }
+
+        uint32_t t = d;
+        d = c;
+        c = b;
+        b = b + rol(a + f + k[i] + w[g], r[(i / 16) * 4 + i % 4]);
+        a = t;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+}
+
+//------------------------------------------------------------------------------
+
+sha1::sha1()
+    :md_engine{compress}
+    ,m_state{}
+{
+    reset();
+}
+
+void sha1::reset()
+{
+    restart();
+
+    m_state[0] = 0x67452301;
+    m_state[1] = 0xefcdab89;
+    m_state[2] = 0x98badcfe;
+    m_state[3] = 0x10325476;
+    m_state[4] = 0xc3d2e1f0;
+}
+
+void sha1::update(const uint8_t *data, size_t size)
+{
+    absorb(m_state, data, size);
+}
+
+void sha1::finish(uint8_t *digest)
+{
+    pad(m_state, true);
+
+    for (size_t i = 0; i < 5; ++i) {
+        store_be(digest + 4 * i, m_state[i]);
+    }
+}
+
+void sha1::compress(uint32_t *state, const uint8_t *block)
+{
+    // Message schedule is kept in a 16-word ring, saving stack
+    uint32_t w[16];
+
+    for (size_t i = 0; i < 16; ++i) {
+        w[i] = load_be(block + 4 * i);
+    }
+
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    uint32_t e = state[4];
+
+    for (size_t i = 0; i < 80; ++i) {
+        if (i >= 16) {
+            w[i & 15] = rol(w[(i - 3) & 15] ^ w[(i - 8) & 15]
+                          ^ w[(i - 14) & 15] ^ w[i & 15], 1);
+        }
+
+        uint32_t f;
+        uint32_t k;
+
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+
+        uint32_t t = rol(a, 5) + f + e + k + w[i & 15];
+        e = d;
+        d = c;
+        c = rol(b, 30);
+        b = a;
+        a = t;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+//------------------------------------------------------------------------------
+
+sha256::sha256()
+    :md_engine{compress}
+    ,m_state{}
+{
+    reset();
+}
+
+void sha256::reset()
+{
+    restart();
+
+    m_state[0] = 0x6a09e667;
+    m_state[1] = 0xbb67ae85;
+    m_state[2] = 0x3c6ef372;
+    m_state[3] = 0xa54ff53a;
+    m_state[4] = 0x510e527f;
+    m_state[5] = 0x9b05688c;
+    m_state[6] = 0x1f83d9ab;
+    m_state[7] = 0x5be0cd19;
+}
+
+void sha256::update(const uint8_t *data, size_t size)
+{
+    absorb(m_state, data, size);
+}
+
+void sha256::finish(uint8_t *digest)
+{
+    pad(m_state, true);
+
+    for (size_t i = 0; i < 8; ++i) {
+        store_be(digest + 4 * i, m_state[i]);
+    }
+}
+
+void sha256::compress(uint32_t *state, const uint8_t *block)
+{
+    static const uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+        0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+        0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+        0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+        0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+        0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+        0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+        0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+        0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    uint32_t w[16];
+
+    for (size_t i = 0; i < 16; ++i) {
+        w[i] = load_be(block + 4 * i);
+    }
+
+    uint32_t s[8];
+    memcpy(s, state, sizeof(s));
+
+    for (size_t i = 0; i < 64; ++i) {
+        if (i >= 16) {
+            uint32_t w15 = w[(i - 15) & 15];
+            uint32_t w2  = w[(i - 2) & 15];
+            uint32_t s0  = ror(w15, 7) ^ ror(w15, 18) ^ (w15 >> 3);
+            uint32_t s1  = ror(w2, 17) ^ ror(w2, 19) ^ (w2 >> 10);
+
+            w[i & 15] += s0 + w[(i - 7) & 15] + s1;
+        }
+
+        uint32_t e  = s[4];
+        uint32_t a  = s[0];
+        uint32_t t1 = s[7] + (ror(e, 6) ^ ror(e, 11) ^ ror(e, 25))
+                    + ((e & s[5]) ^ (~e & s[6])) + k[i] + w[i & 15];
+        uint32_t t2 = (ror(a, 2) ^ ror(a, 13) ^ ror(a, 22))
+                    + ((a & s[1]) ^ (a & s[2]) ^ (s[1] & s[2]));
+
+        s[7] = s[6];
+        s[6] = s[5];
+        s[5] = s[4];
+        s[4] = s[3] + t1;
+        s[3] = s[2];
+        s[2] = s[1];
+        s[1] = s[0];
+        s[0] = t1 + t2;
+    }
+
+    for (size_t i = 0; i < 8; ++i) {
+        state[i] += s[i];
+    }
+}
+
+} // namespace crypto
+
+} // namespace ecl
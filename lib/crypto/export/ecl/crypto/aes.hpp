@@ -0,0 +1,105 @@
+#ifndef LIB_CRYPTO_AES_HPP_
+#define LIB_CRYPTO_AES_HPP_
+
+//!
+//! \file
+//! \brief Portable AES block cipher, FIPS 197, with ECB, CBC and CTR modes.
+//! Serves as a fallback of platform hw_aes driver and shares its interface.
+//!
+
+#include <ecl/err.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+namespace crypto
+{
+
+//! Block cipher modes of operation, NIST SP 800-38A.
+enum class cipher_mode
+{
+    ecb,
+    cbc,
+    ctr,
+};
+
+//!
+//! \brief AES with 128, 192 or 256-bit keys.
+//! Byte-oriented implementation, small in flash: the only tables are
+//! forward and inverse S-boxes.
+//!
+class aes
+{
+public:
+    enum : size_t
+    {
+        block_size = 16, //!< Size of the cipher block, in bytes.
+    };
+
+    aes();
+    ~aes();
+
+    //!
+    //! \brief Expands the key.
+    //! \param[in] key  Key.
+    //! \param[in] size Key size in bytes: 16, 24 or 32.
+    //! \retval err::ok    Key is set.
+    //! \retval err::inval Key size is invalid.
+    //!
+    err set_key(const uint8_t *key, size_t size);
+
+    //!
+    //! \brief Encrypts data.
+    //! Chaining value is updated, so a long message can be processed
+    //! in several calls. In CTR mode the last call can have a size that
+    //! is not a multiple of the block, rest of the keystream block is lost.
+    //! \param[in]     mode Mode of operation.
+    //! \param[in]     in   Plaintext.
+    //! \param[out]    out  Ciphertext. Can be the same as plaintext.
+    //! \param[in]     size Size of data. Multiple of block_size, except for CTR.
+    //! \param[in,out] iv   Chaining value of block_size bytes, for CBC
+    //!                     and CTR. In CTR it is a big-endian counter block.
+    //! \retval err::ok    Data is encrypted.
+    //! \retval err::inval Size or arguments are invalid, or key is not set.
+    //!
+    err encrypt(cipher_mode mode, const uint8_t *in, uint8_t *out, size_t size,
+                uint8_t *iv = nullptr) const;
+
+    //!
+    //! \brief Decrypts data.
+    //! \copydetails encrypt()
+    //!
+    err decrypt(cipher_mode mode, const uint8_t *in, uint8_t *out, size_t size,
+                uint8_t *iv = nullptr) const;
+
+    //!
+    //! \brief Encrypts single block.
+    //! \pre Key is set.
+    //!
+    void encrypt_block(const uint8_t *in, uint8_t *out) const;
+
+    //!
+    //! \brief Decrypts single block.
+    //! \pre Key is set.
+    //!
+    void decrypt_block(const uint8_t *in, uint8_t *out) const;
+
+private:
+    //! Checks arguments of a bulk operation.
+    bool valid(cipher_mode mode, size_t size, const uint8_t *iv) const;
+
+    //! Processes data in CTR mode, which is the same in both directions.
+    void ctr(const uint8_t *in, uint8_t *out, size_t size, uint8_t *iv) const;
+
+    uint8_t     m_rk[240];  //!< Expanded key, 16 bytes per round.
+    unsigned    m_rounds;   //!< Amount of rounds, zero if key is not set.
+};
+
+} // namespace crypto
+
+} // namespace ecl
+
+#endif // LIB_CRYPTO_AES_HPP_
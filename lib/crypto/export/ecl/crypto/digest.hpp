@@ -0,0 +1,196 @@
+#ifndef LIB_CRYPTO_DIGEST_HPP_
+#define LIB_CRYPTO_DIGEST_HPP_
+
+//!
+//! \file
+//! \brief Portable message digests: MD5, SHA-1 and SHA-256.
+//! These are used directly on parts without hash processor and serve
+//! as a fallback of platform hw_hash drivers. All digests share the same
+//! interface, so the code can be written against any of them:
+//! \code
+//!     ecl::crypto::sha256 h;
+//!     h.update(data, size);
+//!     h.finish(out);
+//! \endcode
+//!
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+namespace crypto
+{
+
+//! Hash algorithms.
+enum class hash_algo
+{
+    md5,
+    sha1,
+    sha256,
+};
+
+namespace detail
+{
+
+//!
+//! \brief Merkle-Damgard block engine, shared by all digests.
+//! Buffers input until a whole 64-byte block is collected and applies
+//! compression function of the derived digest to it.
+//!
+class md_engine
+{
+protected:
+    //! Compression function, processes single 64-byte block.
+    using compress_fn = void (*)(uint32_t *state, const uint8_t *block);
+
+    explicit md_engine(compress_fn compress);
+
+    //! Discards buffered data and message length.
+    void restart();
+
+    //! Feeds data into the state.
+    void absorb(uint32_t *state, const uint8_t *data, size_t size);
+
+    //! Appends padding and message length in bits, flushing the last block.
+    void pad(uint32_t *state, bool big_endian);
+
+private:
+    compress_fn m_compress;     //!< Compression function of the digest.
+    uint8_t     m_buf[64];      //!< Partial block.
+    size_t      m_used;         //!< Bytes in partial block.
+    uint64_t    m_total;        //!< Message length, in bytes.
+};
+
+} // namespace detail
+
+//!
+//! \brief MD5 digest, RFC 1321.
+//! \warning MD5 is broken for collision resistance. Use it only to check
+//! integrity against accidental damage or to talk to legacy protocols.
+//!
+class md5 : private detail::md_engine
+{
+public:
+    enum : size_t
+    {
+        digest_size = 16, //!< Size of the digest, in bytes.
+        block_size  = 64, //!< Size of the processed block, in bytes.
+    };
+
+    md5();
+
+    //!
+    //! \brief Starts a new message.
+    //!
+    void reset();
+
+    //!
+    //! \brief Appends data to the message.
+    //! \param[in] data Data to hash.
+    //! \param[in] size Size of data.
+    //!
+    void update(const uint8_t *data, size_t size);
+
+    //!
+    //! \brief Completes the message and obtains the digest.
+    //! Object must be reset before hashing next message.
+    //! \param[out] digest Buffer of digest_size bytes.
+    //!
+    void finish(uint8_t *digest);
+
+private:
+    static void compress(uint32_t *state, const uint8_t *block);
+
+    uint32_t m_state[4]; //!< Chaining state.
+};
+
+//!
+//! \brief SHA-1 digest, FIPS 180-4.
+//! \warning SHA-1 is deprecated for signatures. \sa md5
+//!
+class sha1 : private detail::md_engine
+{
+public:
+    enum : size_t
+    {
+        digest_size = 20, //!< Size of the digest, in bytes.
+        block_size  = 64, //!< Size of the processed block, in bytes.
+    };
+
+    sha1();
+
+    //! \copydoc md5::reset()
+    void reset();
+
+    //! \copydoc md5::update()
+    void update(const uint8_t *data, size_t size);
+
+    //! \copydoc md5::finish()
+    void finish(uint8_t *digest);
+
+private:
+    static void compress(uint32_t *state, const uint8_t *block);
+
+    uint32_t m_state[5]; //!< Chaining state.
+};
+
+//!
+//! \brief SHA-256 digest, FIPS 180-4.
+//!
+class sha256 : private detail::md_engine
+{
+public:
+    enum : size_t
+    {
+        digest_size = 32, //!< Size of the digest, in bytes.
+        block_size  = 64, //!< Size of the processed block, in bytes.
+    };
+
+    sha256();
+
+    //! \copydoc md5::reset()
+    void reset();
+
+    //! \copydoc md5::update()
+    void update(const uint8_t *data, size_t size);
+
+    //! \copydoc md5::finish()
+    void finish(uint8_t *digest);
+
+private:
+    static void compress(uint32_t *state, const uint8_t *block);
+
+    uint32_t m_state[8]; //!< Chaining state.
+};
+
+//!
+//! \brief Maps an algorithm to its software implementation.
+//!
+template< hash_algo algo >
+struct soft_hash;
+
+template<>
+struct soft_hash< hash_algo::md5 >
+{
+    using type = md5;
+};
+
+template<>
+struct soft_hash< hash_algo::sha1 >
+{
+    using type = sha1;
+};
+
+template<>
+struct soft_hash< hash_algo::sha256 >
+{
+    using type = sha256;
+};
+
+} // namespace crypto
+
+} // namespace ecl
+
+#endif // LIB_CRYPTO_DIGEST_HPP_
@@ -0,0 +1,291 @@
+#ifndef LIB_CRYPTO_ENTROPY_HPP_
+#define LIB_CRYPTO_ENTROPY_HPP_
+
+//!
+//! \file
+//! \brief Entropy pool, filled by a noise source.
+//! Raw samples of the source pass health tests of NIST SP 800-90B,
+//! then are conditioned by SHA-256 and stored in a lock-free ring.
+//! Source driver (i.e. RNG interrupt handler) is the only producer,
+//! any amount of consumers can take words from the ring concurrently.
+//!
+
+#include <ecl/crypto/digest.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ecl
+{
+
+namespace crypto
+{
+
+//!
+//! \brief Continuous health tests of a noise source, SP 800-90B 4.4.
+//! Source is assumed to give at least 16 bits of min-entropy per 32-bit
+//! sample. Cutoffs are chosen for false positive rate of 2^-30.
+//!
+class health_test
+{
+public:
+    enum : size_t
+    {
+        rct_cutoff  = 3,    //!< Repetition count test: run of equal samples.
+        apt_window  = 512,  //!< Adaptive proportion test: window size.
+        apt_cutoff  = 71,   //!< Adaptive proportion test: occurrences of
+                            //!< the low byte of first sample in the window.
+    };
+
+    health_test()
+        :m_last{0}
+        ,m_repeats{0}
+        ,m_apt_byte{0}
+        ,m_apt_count{0}
+        ,m_apt_pos{0}
+    {
+    }
+
+    //!
+    //! \brief Restarts tests, i.e. after source is restarted.
+    //!
+    void reset()
+    {
+        m_repeats = 0;
+        m_apt_pos = 0;
+    }
+
+    //!
+    //! \brief Tests next sample.
+    //! \retval true  Sample passed tests.
+    //! \retval false Source is considered broken.
+    //!
+    bool feed(uint32_t sample)
+    {
+        bool ok = true;
+
+        if (m_repeats && sample == m_last) {
+            ok = ++m_repeats < rct_cutoff;
+        } else {
+            m_last = sample;
+            m_repeats = 1;
+        }
+
+        uint8_t byte = sample;
+
+        if (!m_apt_pos) {
+            m_apt_byte = byte;
+            m_apt_count = 1;
+        } else if (byte == m_apt_byte && ++m_apt_count >= apt_cutoff) {
+            ok = false;
+        }
+
+        if (++m_apt_pos == apt_window) {
+            m_apt_pos = 0;
+        }
+
+        return ok;
+    }
+
+private:
+    uint32_t    m_last;         //!< Previous sample.
+    size_t      m_repeats;      //!< Length of run of equal samples.
+    uint8_t     m_apt_byte;     //!< Low byte of the first sample in window.
+    size_t      m_apt_count;    //!< Occurrences of it in the window.
+    size_t      m_apt_pos;      //!< Position in the window.
+};
+
+//! Result of feeding a sample into the pool.
+enum class pool_status
+{
+    more,   //!< Pool wants more samples.
+    full,   //!< Pool is full, source can be paused.
+    failed, //!< Health test failed, source must be restarted.
+};
+
+//!
+//! \brief Pool of conditioned entropy.
+//! Each 64 bytes of raw samples are hashed into 32 bytes of output,
+//! thus conditioning requires two samples per output word.
+//! First apt_window samples after a reset are tested but not used,
+//! as startup tests require.
+//! Unlike ecl::spsc_queue, ring allows many consumers: a word is claimed
+//! by CAS on read index, which is cheap since producer never waits.
+//! \tparam words Capacity of the ring, in words. Power of two.
+//!
+template< size_t words = 64 >
+class entropy_pool
+{
+    static_assert(words >= 8 && !(words & (words - 1)),
+                  "Pool capacity must be a power of two, at least 8 words");
+
+public:
+    entropy_pool();
+
+    //!
+    //! \brief Restarts health tests and startup phase.
+    //! Words already in the ring are kept. Producer side.
+    //!
+    void restart();
+
+    //!
+    //! \brief Feeds raw sample of the source. Producer side, ISR-safe.
+    //! \param[in] sample Raw sample.
+    //! \return Status of the pool.
+    //!
+    pool_status feed(uint32_t sample);
+
+    //!
+    //! \brief Takes a word from the pool. Consumer side, ISR-safe.
+    //! \param[out] w Random word.
+    //! \retval true  Word is taken.
+    //! \retval false Pool is empty.
+    //!
+    bool pop(uint32_t &w);
+
+    //!
+    //! \brief Gets amount of words ready to be taken.
+    //!
+    size_t available() const;
+
+    //!
+    //! \brief Checks if pool has room for one more conditioned block.
+    //!
+    bool full() const;
+
+private:
+    //! Conditions collected block and puts result into the ring.
+    void condition();
+
+    enum : size_t
+    {
+        raw_words = sha256::block_size / 4,     //!< Samples per block.
+        out_words = sha256::digest_size / 4,    //!< Output words per block.
+    };
+
+    std::atomic< uint32_t > m_ring[words];      //!< Conditioned words.
+    std::atomic< size_t >   m_head;             //!< Write index, free running.
+    std::atomic< size_t >   m_tail;             //!< Read index, free running.
+    uint32_t                m_raw[raw_words];   //!< Block of raw samples.
+    size_t                  m_raw_cnt;          //!< Samples in block.
+    size_t                  m_startup;          //!< Samples left to discard.
+    health_test             m_health;           //!< Health tests.
+    sha256                  m_hash;             //!< Conditioning function.
+};
+
+//------------------------------------------------------------------------------
+
+template< size_t words >
+entropy_pool< words >::entropy_pool()
+    :m_ring{}
+    ,m_head{0}
+    ,m_tail{0}
+    ,m_raw{}
+    ,m_raw_cnt{0}
+    ,m_startup{health_test::apt_window}
+    ,m_health{}
+    ,m_hash{}
+{
+}
+
+template< size_t words >
+void entropy_pool< words >::restart()
+{
+    m_health.reset();
+    m_raw_cnt = 0;
+    m_startup = health_test::apt_window;
+}
+
+template< size_t words >
+pool_status entropy_pool< words >::feed(uint32_t sample)
+{
+    if (!m_health.feed(sample)) {
+        // Block can contain bad samples, so it is dropped
+        m_raw_cnt = 0;
+        return pool_status::failed;
+    }
+
+    if (m_startup) {
+        --m_startup;
+        return pool_status::more;
+    }
+
+    if (full()) {
+        return pool_status::full;
+    }
+
+    m_raw[m_raw_cnt++] = sample;
+
+    if (m_raw_cnt == raw_words) {
+        condition();
+        m_raw_cnt = 0;
+    }
+
+    return full() ? pool_status::full : pool_status::more;
+}
+
+template< size_t words >
+bool entropy_pool< words >::pop(uint32_t &w)
+{
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+
+    // Slot is read before it is claimed. Producer can overwrite it
+    // meanwhile only if other consumer took the word, then CAS fails
+    // and stale value is discarded.
+    do {
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        w = m_ring[tail & (words - 1)].load(std::memory_order_relaxed);
+    } while (!m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel));
+
+    return true;
+}
+
+template< size_t words >
+size_t entropy_pool< words >::available() const
+{
+    return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+}
+
+template< size_t words >
+bool entropy_pool< words >::full() const
+{
+    return available() > words - out_words;
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< size_t words >
+void entropy_pool< words >::condition()
+{
+    uint8_t out[sha256::digest_size];
+
+    m_hash.reset();
+    m_hash.update(reinterpret_cast< const uint8_t * >(m_raw), sizeof(m_raw));
+    m_hash.finish(out);
+
+    size_t head = m_head.load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < out_words; ++i) {
+        uint32_t w;
+        memcpy(&w, out + 4 * i, sizeof(w));
+        m_ring[(head + i) & (words - 1)].store(w, std::memory_order_relaxed);
+    }
+
+    m_head.store(head + out_words, std::memory_order_release);
+
+    // Raw samples are not kept around
+    memset(m_raw, 0, sizeof(m_raw));
+    memset(out, 0, sizeof(out));
+}
+
+} // namespace crypto
+
+} // namespace ecl
+
+#endif // LIB_CRYPTO_ENTROPY_HPP_
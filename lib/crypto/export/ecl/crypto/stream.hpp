@@ -0,0 +1,79 @@
+#ifndef LIB_CRYPTO_STREAM_HPP_
+#define LIB_CRYPTO_STREAM_HPP_
+
+//!
+//! \file
+//! \brief Feeding digests from files and other sources.
+//! Helpers are templates over both the digest and the source, so they work
+//! with software digests of ecl::crypto and with platform hw_hash alike,
+//! and don't pull filesystem into the library.
+//!
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+namespace ecl
+{
+
+namespace crypto
+{
+
+//!
+//! \brief Hashes the rest of a stream, read chunk by chunk.
+//! Source is anything with read(uint8_t *, size_t) returning amount of
+//! bytes read, zero at the end and negative value on error, e.g.
+//! fs::file_descriptor. Digest is not finished, so a trailer can still
+//! be appended.
+//! \param[in,out] h    Digest.
+//! \param[in,out] src  Source of data.
+//! \param[in]     buf  Scratch buffer. Should be DMA capable and word
+//!                     aligned, if digest is a hardware one.
+//! \param[in]     size Size of scratch buffer. Larger chunks mean less
+//!                     DMA setups per byte.
+//! \return Amount of bytes hashed, or negative value if source failed.
+//!
+template< class Digest, class Source >
+ssize_t digest_stream(Digest &h, Source &src, uint8_t *buf, size_t size)
+{
+    ssize_t total = 0;
+    ssize_t rc;
+
+    while ((rc = src.read(buf, size)) > 0) {
+        h.update(buf, rc);
+        total += rc;
+    }
+
+    return rc < 0 ? rc : total;
+}
+
+//!
+//! \brief Hashes a part of a mapped source without copying.
+//! Suits files on memory-mapped storage, i.e. internal flash, where
+//! fs::file_descriptor::map() gives pointer to the data itself.
+//! \param[in,out] h    Digest.
+//! \param[in,out] src  Source with map(off_t, size_t) returning pointer
+//!                     to the range or nullptr.
+//! \param[in]     offt Offset of the range.
+//! \param[in]     len  Length of the range.
+//! \retval 0  Range is hashed.
+//! \retval -1 Source can't map the range. Use digest_stream() instead.
+//!
+template< class Digest, class Source >
+int digest_mapped(Digest &h, Source &src, off_t offt, size_t len)
+{
+    const uint8_t *p = src.map(offt, len);
+
+    if (!p) {
+        return -1;
+    }
+
+    h.update(p, len);
+    return 0;
+}
+
+} // namespace crypto
+
+} // namespace ecl
+
+#endif // LIB_CRYPTO_STREAM_HPP_
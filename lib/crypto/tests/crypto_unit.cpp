@@ -0,0 +1,308 @@
+#include <ecl/crypto/digest.hpp>
+#include <ecl/crypto/aes.hpp>
+#include <ecl/crypto/stream.hpp>
+
+#include <cstring>
+#include <string>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+using namespace ecl::crypto;
+
+static std::string to_hex(const uint8_t *p, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string s;
+
+    for (size_t i = 0; i < size; ++i) {
+        s += digits[p[i] >> 4];
+        s += digits[p[i] & 0xf];
+    }
+
+    return s;
+}
+
+static void from_hex(const char *hex, uint8_t *out)
+{
+    auto nibble = [](char c) {
+        return c <= '9' ? c - '0' : c - 'a' + 10;
+    };
+
+    for (size_t i = 0; hex[2 * i]; ++i) {
+        out[i] = nibble(hex[2 * i]) << 4 | nibble(hex[2 * i + 1]);
+    }
+}
+
+template< class Digest >
+static std::string digest_of(const char *msg, size_t chunk = 0)
+{
+    Digest h;
+    uint8_t out[Digest::digest_size];
+
+    auto p = reinterpret_cast< const uint8_t * >(msg);
+    size_t size = strlen(msg);
+
+    if (!chunk) {
+        chunk = size;
+    }
+
+    for (size_t i = 0; i < size; i += chunk) {
+        h.update(p + i, size - i < chunk ? size - i : chunk);
+    }
+
+    h.finish(out);
+    return to_hex(out, sizeof(out));
+}
+
+TEST_GROUP(digest)
+{
+};
+
+TEST(digest, md5_matches_rfc_vectors)
+{
+    STRCMP_EQUAL("d41d8cd98f00b204e9800998ecf8427e", digest_of< md5 >("").c_str());
+    STRCMP_EQUAL("900150983cd24fb0d6963f7d28e17f72", digest_of< md5 >("abc").c_str());
+    STRCMP_EQUAL("57edf4a22be3c955ac49da2e2107b67a",
+                 digest_of< md5 >("1234567890123456789012345678901234567890"
+                                  "1234567890123456789012345678901234567890").c_str());
+}
+
+TEST(digest, sha1_matches_fips_vectors)
+{
+    STRCMP_EQUAL("a9993e364706816aba3e25717850c26c9cd0d89d",
+                 digest_of< sha1 >("abc").c_str());
+    STRCMP_EQUAL("84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+                 digest_of< sha1 >("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq").c_str());
+}
+
+TEST(digest, sha256_matches_fips_vectors)
+{
+    STRCMP_EQUAL("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+                 digest_of< sha256 >("").c_str());
+    STRCMP_EQUAL("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+                 digest_of< sha256 >("abc").c_str());
+    STRCMP_EQUAL("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+                 digest_of< sha256 >("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq").c_str());
+}
+
+TEST(digest, piecewise_update_gives_same_digest)
+{
+    const char *msg = "The quick brown fox jumps over the lazy dog, "
+                      "then runs across two blocks of the compression function";
+
+    for (size_t chunk : { 1, 3, 7, 63, 64, 65 }) {
+        STRCMP_EQUAL(digest_of< sha256 >(msg).c_str(), digest_of< sha256 >(msg, chunk).c_str());
+        STRCMP_EQUAL(digest_of< sha1 >(msg).c_str(), digest_of< sha1 >(msg, chunk).c_str());
+        STRCMP_EQUAL(digest_of< md5 >(msg).c_str(), digest_of< md5 >(msg, chunk).c_str());
+    }
+}
+
+TEST(digest, million_a)
+{
+    sha256 h;
+    uint8_t block[1000];
+    uint8_t out[sha256::digest_size];
+
+    memset(block, 'a', sizeof(block));
+
+    for (int i = 0; i < 1000; ++i) {
+        h.update(block, sizeof(block));
+    }
+
+    h.finish(out);
+    STRCMP_EQUAL("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+                 to_hex(out, sizeof(out)).c_str());
+
+    // Digest is reusable after reset
+    h.reset();
+    h.update(reinterpret_cast< const uint8_t * >("abc"), 3);
+    h.finish(out);
+    STRCMP_EQUAL("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+                 to_hex(out, sizeof(out)).c_str());
+}
+
+//------------------------------------------------------------------------------
+
+namespace
+{
+
+// Source that returns data in small pieces, like a file does
+struct chunked_source
+{
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    bool fail;
+
+    ssize_t read(uint8_t *buf, size_t len)
+    {
+        if (fail && pos) {
+            return -1;
+        }
+
+        size_t n = size - pos < len ? size - pos : len;
+        memcpy(buf, data + pos, n);
+        pos += n;
+        return n;
+    }
+
+    const uint8_t *map(off_t offt, size_t len)
+    {
+        return static_cast< size_t >(offt) + len <= size ? data + offt : nullptr;
+    }
+};
+
+} // namespace
+
+TEST_GROUP(stream)
+{
+};
+
+TEST(stream, stream_is_hashed_to_the_end)
+{
+    const char *msg = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    chunked_source src{reinterpret_cast< const uint8_t * >(msg), strlen(msg), 0, false};
+
+    sha1 h;
+    uint8_t buf[5];
+    uint8_t out[sha1::digest_size];
+
+    CHECK_EQUAL(static_cast< ssize_t >(strlen(msg)), digest_stream(h, src, buf, sizeof(buf)));
+    h.finish(out);
+    STRCMP_EQUAL("84983e441c3bd26ebaae4aa1f95129e5e54670f1", to_hex(out, sizeof(out)).c_str());
+
+    src.pos = 0;
+    src.fail = true;
+    CHECK_EQUAL(-1, digest_stream(h, src, buf, sizeof(buf)));
+}
+
+TEST(stream, mapped_range_is_hashed)
+{
+    const char *msg = "xxabcxx";
+    chunked_source src{reinterpret_cast< const uint8_t * >(msg), strlen(msg), 0, false};
+
+    md5 h;
+    uint8_t out[md5::digest_size];
+
+    CHECK_EQUAL(0, digest_mapped(h, src, 2, 3));
+    h.finish(out);
+    STRCMP_EQUAL("900150983cd24fb0d6963f7d28e17f72", to_hex(out, sizeof(out)).c_str());
+
+    CHECK_EQUAL(-1, digest_mapped(h, src, 5, 3));
+}
+
+//------------------------------------------------------------------------------
+
+TEST_GROUP(aes)
+{
+};
+
+TEST(aes, block_matches_fips_197)
+{
+    const char *pt_hex = "00112233445566778899aabbccddeeff";
+    const char *keys[] = {
+        "000102030405060708090a0b0c0d0e0f",
+        "000102030405060708090a0b0c0d0e0f1011121314151617",
+        "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+    };
+    const char *cts[] = {
+        "69c4e0d86a7b0430d8cdb78070b4c55a",
+        "dda97ca4864cdfe06eaf70a0ec0d7191",
+        "8ea2b7ca516745bfeafc49904b496089",
+    };
+
+    uint8_t pt[16];
+    from_hex(pt_hex, pt);
+
+    for (size_t i = 0; i < 3; ++i) {
+        uint8_t key[32];
+        uint8_t out[16];
+        uint8_t back[16];
+
+        from_hex(keys[i], key);
+
+        aes cipher;
+        CHECK_TRUE(cipher.set_key(key, strlen(keys[i]) / 2) == ecl::err::ok);
+
+        cipher.encrypt_block(pt, out);
+        STRCMP_EQUAL(cts[i], to_hex(out, 16).c_str());
+
+        cipher.decrypt_block(out, back);
+        MEMCMP_EQUAL(pt, back, 16);
+    }
+}
+
+// NIST SP 800-38A, F.2.1 and F.5.1
+static const char *sp800_key = "2b7e151628aed2a6abf7158809cf4f3c";
+static const char *sp800_pt  = "6bc1bee22e409f96e93d7e117393172a"
+                               "ae2d8a571e03ac9c9eb76fac45af8e51";
+
+TEST(aes, cbc_matches_sp800_38a)
+{
+    uint8_t key[16], pt[32], buf[32], iv[16];
+
+    from_hex(sp800_key, key);
+    from_hex(sp800_pt, pt);
+    from_hex("000102030405060708090a0b0c0d0e0f", iv);
+
+    aes cipher;
+    cipher.set_key(key, sizeof(key));
+
+    // Two calls of one block each, chaining value is carried over
+    CHECK_TRUE(cipher.encrypt(cipher_mode::cbc, pt, buf, 16, iv) == ecl::err::ok);
+    CHECK_TRUE(cipher.encrypt(cipher_mode::cbc, pt + 16, buf + 16, 16, iv) == ecl::err::ok);
+
+    STRCMP_EQUAL("7649abac8119b246cee98e9b12e9197d"
+                 "5086cb9b507219ee95db113a917678b2", to_hex(buf, 32).c_str());
+
+    from_hex("000102030405060708090a0b0c0d0e0f", iv);
+    CHECK_TRUE(cipher.decrypt(cipher_mode::cbc, buf, buf, 32, iv) == ecl::err::ok);
+    MEMCMP_EQUAL(pt, buf, 32);
+}
+
+TEST(aes, ctr_matches_sp800_38a)
+{
+    uint8_t key[16], pt[32], buf[32], iv[16];
+
+    from_hex(sp800_key, key);
+    from_hex(sp800_pt, pt);
+    from_hex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", iv);
+
+    aes cipher;
+    cipher.set_key(key, sizeof(key));
+
+    CHECK_TRUE(cipher.encrypt(cipher_mode::ctr, pt, buf, 32, iv) == ecl::err::ok);
+    STRCMP_EQUAL("874d6191b620e3261bef6864990db6ce"
+                 "9806f66b7970fdff8617187bb9fffdff", to_hex(buf, 32).c_str());
+
+    // Counter is advanced past both blocks, with carry into upper bytes
+    STRCMP_EQUAL("f0f1f2f3f4f5f6f7f8f9fafbfcfdff01", to_hex(iv, 16).c_str());
+
+    // Partial tail block is allowed
+    from_hex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", iv);
+    CHECK_TRUE(cipher.decrypt(cipher_mode::ctr, buf, buf, 21, iv) == ecl::err::ok);
+    MEMCMP_EQUAL(pt, buf, 21);
+}
+
+TEST(aes, invalid_arguments_are_rejected)
+{
+    uint8_t key[32] = {};
+    uint8_t buf[32] = {};
+    uint8_t iv[16] = {};
+
+    aes cipher;
+
+    CHECK_TRUE(cipher.encrypt(cipher_mode::ecb, buf, buf, 16) == ecl::err::inval);
+    CHECK_TRUE(cipher.set_key(key, 20) == ecl::err::inval);
+    CHECK_TRUE(cipher.set_key(key, 32) == ecl::err::ok);
+    CHECK_TRUE(cipher.encrypt(cipher_mode::ecb, buf, buf, 15) == ecl::err::inval);
+    CHECK_TRUE(cipher.encrypt(cipher_mode::cbc, buf, buf, 16) == ecl::err::inval);
+    CHECK_TRUE(cipher.decrypt(cipher_mode::cbc, buf, buf, 17, iv) == ecl::err::inval);
+    CHECK_TRUE(cipher.encrypt(cipher_mode::ecb, buf, buf, 32) == ecl::err::ok);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
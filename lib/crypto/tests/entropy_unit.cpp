@@ -0,0 +1,167 @@
+#include <ecl/crypto/entropy.hpp>
+
+#include <cstdint>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+using namespace ecl::crypto;
+
+TEST_GROUP(health)
+{
+};
+
+TEST(health, random_samples_pass)
+{
+    health_test t;
+    std::mt19937 gen{1};
+
+    for (int i = 0; i < 100000; ++i) {
+        CHECK_TRUE(t.feed(gen()));
+    }
+}
+
+TEST(health, stuck_source_fails_repetition_test)
+{
+    health_test t;
+
+    CHECK_TRUE(t.feed(0x12345678));
+    CHECK_TRUE(t.feed(0x12345678));
+    CHECK_FALSE(t.feed(0x12345678));
+
+    t.reset();
+    CHECK_TRUE(t.feed(0x12345678));
+}
+
+TEST(health, biased_source_fails_proportion_test)
+{
+    health_test t;
+    bool ok = true;
+
+    // Words differ, but low byte is the same in every other sample
+    for (uint32_t i = 0; i < health_test::apt_window && ok; ++i) {
+        ok = t.feed(i & 1 ? i << 8 : (i << 8) | 0x5a);
+    }
+
+    CHECK_FALSE(ok);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_GROUP(pool)
+{
+};
+
+// Feeds counter as a source, which passes health tests
+template< size_t words >
+static uint32_t fill(entropy_pool< words > &pool, uint32_t sample = 0)
+{
+    while (pool.feed(sample++) != pool_status::full) { }
+    return sample;
+}
+
+TEST(pool, startup_samples_are_discarded)
+{
+    entropy_pool< 8 > pool;
+    uint32_t w;
+
+    for (uint32_t i = 0; i < health_test::apt_window + 15; ++i) {
+        CHECK_TRUE(pool.feed(i) == pool_status::more);
+    }
+
+    CHECK_FALSE(pool.pop(w));
+
+    // Full block of 16 samples gives 8 words, which fill the ring
+    CHECK_TRUE(pool.feed(0) == pool_status::full);
+    CHECK_EQUAL(8, pool.available());
+}
+
+TEST(pool, output_is_conditioned)
+{
+    entropy_pool< 16 > pool;
+    fill(pool);
+
+    // Counter doesn't show through conditioning
+    std::set< uint32_t > seen;
+    uint32_t w;
+
+    while (pool.pop(w)) {
+        seen.insert(w);
+    }
+
+    CHECK_EQUAL(16, seen.size());
+    CHECK_EQUAL(0, pool.available());
+}
+
+TEST(pool, failure_drops_block_and_restarts)
+{
+    entropy_pool< 8 > pool;
+
+    for (uint32_t i = 0; i < health_test::apt_window + 4; ++i) {
+        pool.feed(i);
+    }
+
+    pool.feed(7);
+    pool.feed(7);
+    CHECK_TRUE(pool.feed(7) == pool_status::failed);
+
+    pool.restart();
+    for (uint32_t i = 0; i < health_test::apt_window + 15; ++i) {
+        CHECK_TRUE(pool.feed(i + 100) == pool_status::more);
+    }
+
+    CHECK_TRUE(pool.feed(1) == pool_status::full);
+}
+
+TEST(pool, concurrent_consumers_take_distinct_words)
+{
+    entropy_pool< 64 > pool;
+    std::vector< uint32_t > taken[4];
+    std::atomic_bool done{false};
+
+    std::vector< std::thread > consumers;
+
+    for (auto &v : taken) {
+        consumers.emplace_back([&pool, &v, &done] {
+            uint32_t w;
+            while (!done || pool.available()) {
+                if (pool.pop(w)) {
+                    v.push_back(w);
+                }
+            }
+        });
+    }
+
+    uint32_t sample = 0;
+    for (int i = 0; i < 200; ++i) {
+        while (pool.full()) { }
+        sample = fill(pool, sample);
+    }
+
+    done = true;
+
+    for (auto &t : consumers) {
+        t.join();
+    }
+
+    std::set< uint32_t > all;
+    size_t total = 0;
+
+    for (auto &v : taken) {
+        all.insert(v.begin(), v.end());
+        total += v.size();
+    }
+
+    // Each word is taken exactly once
+    CHECK_EQUAL(total, all.size());
+    CHECK_TRUE(total >= 200 * 8);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
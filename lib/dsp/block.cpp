@@ -0,0 +1,87 @@
+#include "ecl/dsp/block.hpp"
+
+#include <ecl/cpu.hpp>
+
+#include <cmath>
+
+namespace ecl
+{
+
+namespace dsp
+{
+
+// Integer loops below are vectorized by the compiler. On x86 hosts AVX2
+// versions are built as well, see ECL_CPU_CLONES. Float accumulation
+// must keep its order, so rms() of floats is not cloned.
+
+ECL_CPU_CLONES
+void from_adc(const uint16_t *in, q15 *out, size_t n, unsigned bits)
+{
+    unsigned shift = 16 - bits;
+    int32_t mid = 1 << (bits - 1);
+
+    for (size_t i = 0; i < n; ++i) {
+        int32_t v = (static_cast< int32_t >(in[i]) - mid) * (1 << shift);
+        out[i] = static_cast< q15 >(v);
+    }
+}
+
+ECL_CPU_CLONES
+void to_f32(const q15 *in, float *out, size_t n)
+{
+    constexpr float scale = 1.0f / 32768;
+
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = in[i] * scale;
+    }
+}
+
+void to_q15(const float *in, q15 *out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = simd::sat_q15(static_cast< int64_t >(std::lround(in[i] * 32768)));
+    }
+}
+
+ECL_CPU_CLONES
+q15 rms(const q15 *in, size_t n)
+{
+    if (!n) {
+        return 0;
+    }
+
+    int64_t acc = 0;
+    size_t i = 0;
+
+    for (; i + 1 < n; i += 2) {
+        uint32_t x = simd::load2(in + i);
+        acc = simd::mac2(x, x, acc);
+    }
+
+    if (i < n) {
+        acc += static_cast< int32_t >(in[i]) * in[i];
+    }
+
+    // Mean square is below 2^30, float sqrt is exact enough for Q15
+    float mean = static_cast< float >(acc / static_cast< int64_t >(n));
+    return simd::sat_q15(static_cast< int64_t >(std::sqrt(mean) + 0.5f));
+}
+
+float rms(const float *in, size_t n)
+{
+    if (!n) {
+        return 0;
+    }
+
+    float acc = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        acc += in[i] * in[i];
+    }
+
+    return std::sqrt(acc / n);
+}
+
+} // namespace dsp
+
+} // namespace ecl
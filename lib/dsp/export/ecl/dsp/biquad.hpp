@@ -0,0 +1,175 @@
+#ifndef LIB_DSP_BIQUAD_HPP_
+#define LIB_DSP_BIQUAD_HPP_
+
+//!
+//! \file
+//! \brief Cascade of second order IIR sections.
+//!
+
+#include <cmath>
+#include <cstddef>
+
+namespace ecl
+{
+
+namespace dsp
+{
+
+//!
+//! \brief Coefficients of a second order section, normalized by a0.
+//! y[n] = b0 * x[n] + b1 * x[n - 1] + b2 * x[n - 2]
+//!                  - a1 * y[n - 1] - a2 * y[n - 2]
+//!
+struct biquad_coeffs
+{
+    float b0;
+    float b1;
+    float b2;
+    float a1;
+    float a2;
+
+    //!
+    //! \brief Designs low-pass section.
+    //! \param[in] fc Cutoff frequency, Hz.
+    //! \param[in] fs Sampling frequency, Hz.
+    //! \param[in] q  Quality factor. Default gives Butterworth response.
+    //!
+    static biquad_coeffs lowpass(float fc, float fs, float q = 0.70710678f);
+
+    //!
+    //! \brief Designs high-pass section.
+    //! \param[in] fc Cutoff frequency, Hz.
+    //! \param[in] fs Sampling frequency, Hz.
+    //! \param[in] q  Quality factor. Default gives Butterworth response.
+    //!
+    static biquad_coeffs highpass(float fc, float fs, float q = 0.70710678f);
+};
+
+//!
+//! \brief Cascade of biquad filters over float samples.
+//! Sections are in transposed direct form II, which needs two state
+//! variables per section and is the least sensitive to rounding for float.
+//! On Cortex-M4F each section costs five FPU MACs per sample.
+//! \tparam stages Amount of sections.
+//!
+template< size_t stages >
+class biquad_f32
+{
+    static_assert(stages > 0, "Cascade must have at least one section");
+
+public:
+    //!
+    //! \brief Constructs the filter.
+    //! \param[in] coeffs Coefficients of each section, in cascade order. Copied.
+    //!
+    explicit biquad_f32(const biquad_coeffs *coeffs);
+
+    //!
+    //! \brief Clears filter state.
+    //!
+    void reset();
+
+    //!
+    //! \brief Filters a block of samples.
+    //! \param[in]  in  Input samples.
+    //! \param[out] out Output samples. Can be the same as input.
+    //! \param[in]  n   Amount of samples.
+    //!
+    void process(const float *in, float *out, size_t n);
+
+private:
+    biquad_coeffs   m_coeffs[stages];   //!< Coefficients of sections.
+    float           m_z[stages][2];     //!< State of sections.
+};
+
+//------------------------------------------------------------------------------
+
+inline biquad_coeffs biquad_coeffs::lowpass(float fc, float fs, float q)
+{
+    // Audio EQ cookbook, R. Bristow-Johnson
+    constexpr float pi = 3.14159265f;
+
+    float w = 2 * pi * fc / fs;
+    float alpha = std::sin(w) / (2 * q);
+    float cw = std::cos(w);
+    float a0 = 1 + alpha;
+
+    return biquad_coeffs{
+        (1 - cw) / 2 / a0,
+        (1 - cw) / a0,
+        (1 - cw) / 2 / a0,
+        -2 * cw / a0,
+        (1 - alpha) / a0,
+    };
+}
+
+inline biquad_coeffs biquad_coeffs::highpass(float fc, float fs, float q)
+{
+    constexpr float pi = 3.14159265f;
+
+    float w = 2 * pi * fc / fs;
+    float alpha = std::sin(w) / (2 * q);
+    float cw = std::cos(w);
+    float a0 = 1 + alpha;
+
+    return biquad_coeffs{
+        (1 + cw) / 2 / a0,
+        -(1 + cw) / a0,
+        (1 + cw) / 2 / a0,
+        -2 * cw / a0,
+        (1 - alpha) / a0,
+    };
+}
+
+template< size_t stages >
+biquad_f32< stages >::biquad_f32(const biquad_coeffs *coeffs)
+    :m_coeffs{}
+    ,m_z{}
+{
+    for (size_t s = 0; s < stages; ++s) {
+        m_coeffs[s] = coeffs[s];
+    }
+}
+
+template< size_t stages >
+void biquad_f32< stages >::reset()
+{
+    for (size_t s = 0; s < stages; ++s) {
+        m_z[s][0] = m_z[s][1] = 0;
+    }
+}
+
+template< size_t stages >
+void biquad_f32< stages >::process(const float *in, float *out, size_t n)
+{
+    // Section by section, so coefficients and state stay in registers
+    // for the whole block.
+    const float *src = in;
+
+    for (size_t s = 0; s < stages; ++s) {
+        const biquad_coeffs c = m_coeffs[s];
+        float z0 = m_z[s][0];
+        float z1 = m_z[s][1];
+
+        for (size_t i = 0; i < n; ++i) {
+            float x = src[i];
+            float y = c.b0 * x + z0;
+
+            z0 = c.b1 * x - c.a1 * y + z1;
+            z1 = c.b2 * x - c.a2 * y;
+
+            out[i] = y;
+        }
+
+        m_z[s][0] = z0;
+        m_z[s][1] = z1;
+
+        src = out;
+    }
+}
+
+} // namespace dsp
+
+} // namespace ecl
+
+#endif // LIB_DSP_BIQUAD_HPP_
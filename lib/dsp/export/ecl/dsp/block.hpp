@@ -0,0 +1,70 @@
+#ifndef LIB_DSP_BLOCK_HPP_
+#define LIB_DSP_BLOCK_HPP_
+
+//!
+//! \file
+//! \brief Block conversions and statistics.
+//! Conversions take raw buffers as filled by DMA, i.e. by adc_sampler
+//! or a bus streaming xfer, so samples can be processed in place of
+//! the completed half of a double buffer.
+//!
+
+#include <ecl/dsp/simd.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+namespace dsp
+{
+
+//!
+//! \brief Converts unsigned right-aligned ADC codes to Q15.
+//! Mid-scale code becomes zero.
+//! \param[in]  in      ADC codes.
+//! \param[out] out     Q15 samples. Can be the same as input.
+//! \param[in]  n       Amount of samples.
+//! \param[in]  bits    ADC resolution, 1 .. 16.
+//!
+void from_adc(const uint16_t *in, q15 *out, size_t n, unsigned bits = 12);
+
+//!
+//! \brief Converts Q15 samples to float.
+//! \param[in]  in  Q15 samples.
+//! \param[out] out Float samples, in [-1, 1).
+//! \param[in]  n   Amount of samples.
+//!
+void to_f32(const q15 *in, float *out, size_t n);
+
+//!
+//! \brief Converts float samples to Q15, with saturation.
+//! \param[in]  in  Float samples.
+//! \param[out] out Q15 samples.
+//! \param[in]  n   Amount of samples.
+//!
+void to_q15(const float *in, q15 *out, size_t n);
+
+//!
+//! \brief Computes RMS value of Q15 samples.
+//! Squares are accumulated in 64 bits, two samples per MAC.
+//! \param[in] in   Samples.
+//! \param[in] n    Amount of samples.
+//! \return RMS value, in Q15. Zero if there are no samples.
+//!
+q15 rms(const q15 *in, size_t n);
+
+//!
+//! \brief Computes RMS value of float samples.
+//! \param[in] in   Samples.
+//! \param[in] n    Amount of samples.
+//! \return RMS value. Zero if there are no samples.
+//!
+float rms(const float *in, size_t n);
+
+} // namespace dsp
+
+} // namespace ecl
+
+#endif // LIB_DSP_BLOCK_HPP_
@@ -0,0 +1,168 @@
+#ifndef LIB_DSP_FFT_HPP_
+#define LIB_DSP_FFT_HPP_
+
+//!
+//! \file
+//! \brief Complex radix-2 FFT over float samples.
+//!
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+namespace ecl
+{
+
+namespace dsp
+{
+
+//!
+//! \brief In-place complex FFT of fixed size.
+//! Data is interleaved: re[0], im[0], re[1], im[1], ... Transform is
+//! iterative, decimation in time, with twiddle factors computed once
+//! by the constructor.
+//! \tparam points Transform size, power of two.
+//!
+template< size_t points >
+class fft_f32
+{
+    static_assert(points >= 2 && !(points & (points - 1)),
+                  "FFT size must be a power of two");
+
+public:
+    //!
+    //! \brief Constructs the transform, computing twiddle factors.
+    //!
+    fft_f32();
+
+    //!
+    //! \brief Computes forward transform.
+    //! \param[in,out] data Interleaved complex samples, 2 * points floats.
+    //!
+    void forward(float *data) const;
+
+    //!
+    //! \brief Computes inverse transform, scaled by 1 / points.
+    //! \param[in,out] data Interleaved complex bins, 2 * points floats.
+    //!
+    void inverse(float *data) const;
+
+    //!
+    //! \brief Computes magnitudes of bins.
+    //! \param[in]  data Interleaved complex bins.
+    //! \param[out] mag  Magnitudes. Can be the same as data, then
+    //!                  first half of it is overwritten.
+    //! \param[in]  n    Amount of bins.
+    //!
+    static void magnitude(const float *data, float *mag, size_t n);
+
+private:
+    //! Reorders samples in bit-reversed order.
+    static void reorder(float *data);
+
+    //! Executes butterflies. Direction is given by sign of imaginary
+    //! part of twiddle factors.
+    void butterflies(float *data, float sign) const;
+
+    float m_cos[points / 2];    //!< Real parts of twiddle factors.
+    float m_sin[points / 2];    //!< Imaginary parts of twiddle factors, negated.
+};
+
+//------------------------------------------------------------------------------
+
+template< size_t points >
+fft_f32< points >::fft_f32()
+    :m_cos{}
+    ,m_sin{}
+{
+    constexpr double pi = 3.14159265358979323846;
+
+    for (size_t k = 0; k < points / 2; ++k) {
+        double w = 2 * pi * k / points;
+        m_cos[k] = static_cast< float >(std::cos(w));
+        m_sin[k] = static_cast< float >(std::sin(w));
+    }
+}
+
+template< size_t points >
+void fft_f32< points >::forward(float *data) const
+{
+    reorder(data);
+    butterflies(data, -1);
+}
+
+template< size_t points >
+void fft_f32< points >::inverse(float *data) const
+{
+    reorder(data);
+    butterflies(data, 1);
+
+    constexpr float scale = 1.0f / points;
+
+    for (size_t i = 0; i < 2 * points; ++i) {
+        data[i] *= scale;
+    }
+}
+
+template< size_t points >
+void fft_f32< points >::magnitude(const float *data, float *mag, size_t n)
+{
+    // Each output lies at or before its input, so in-place use is safe
+    for (size_t i = 0; i < n; ++i) {
+        float re = data[2 * i];
+        float im = data[2 * i + 1];
+        mag[i] = std::sqrt(re * re + im * im);
+    }
+}
+
+template< size_t points >
+void fft_f32< points >::reorder(float *data)
+{
+    for (size_t i = 1, j = 0; i < points; ++i) {
+        size_t bit = points >> 1;
+
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+
+        j ^= bit;
+
+        if (i < j) {
+            std::swap(data[2 * i], data[2 * j]);
+            std::swap(data[2 * i + 1], data[2 * j + 1]);
+        }
+    }
+}
+
+template< size_t points >
+void fft_f32< points >::butterflies(float *data, float sign) const
+{
+    for (size_t len = 2; len <= points; len <<= 1) {
+        size_t half = len / 2;
+        size_t step = points / len;
+
+        for (size_t start = 0; start < points; start += len) {
+            for (size_t k = 0; k < half; ++k) {
+                float wr = m_cos[k * step];
+                float wi = sign * m_sin[k * step];
+
+                float *a = data + 2 * (start + k);
+                float *b = data + 2 * (start + k + half);
+
+                float tr = b[0] * wr - b[1] * wi;
+                float ti = b[0] * wi + b[1] * wr;
+
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+} // namespace dsp
+
+} // namespace ecl
+
+#endif // LIB_DSP_FFT_HPP_
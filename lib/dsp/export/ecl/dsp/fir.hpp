@@ -0,0 +1,126 @@
+#ifndef LIB_DSP_FIR_HPP_
+#define LIB_DSP_FIR_HPP_
+
+//!
+//! \file
+//! \brief Fixed-point FIR filter.
+//!
+
+#include <ecl/dsp/simd.hpp>
+
+#include <cstddef>
+#include <cstring>
+
+namespace ecl
+{
+
+namespace dsp
+{
+
+//!
+//! \brief FIR filter over Q15 samples.
+//! Computes y[n] = sum(b[k] * x[n - k]), k = 0 .. taps - 1. Products are
+//! accumulated in 64 bits, two taps per MAC, and the result is saturated,
+//! so the filter doesn't overflow internally for any coefficients.
+//! Samples are processed in chunks of up to block samples; larger
+//! requests are split. State keeps block + taps samples.
+//! \tparam taps  Amount of coefficients.
+//! \tparam block Largest chunk processed at once.
+//!
+template< size_t taps, size_t block = 32 >
+class fir_q15
+{
+    static_assert(taps > 0, "Filter must have at least one tap");
+    static_assert(block > 0, "Block must not be empty");
+
+public:
+    //!
+    //! \brief Constructs the filter.
+    //! \param[in] coeffs Coefficients b[0] .. b[taps - 1], in Q15. Copied.
+    //!
+    explicit fir_q15(const q15 *coeffs);
+
+    //!
+    //! \brief Clears filter history.
+    //!
+    void reset();
+
+    //!
+    //! \brief Filters a block of samples.
+    //! \param[in]  in  Input samples.
+    //! \param[out] out Output samples. Can be the same as input.
+    //! \param[in]  n   Amount of samples.
+    //!
+    void process(const q15 *in, q15 *out, size_t n);
+
+private:
+    //! Taps, rounded up to be processed in pairs.
+    static constexpr size_t m_len = (taps + 1) & ~static_cast< size_t >(1);
+
+    //! Filters single chunk.
+    void process_chunk(const q15 *in, q15 *out, size_t n);
+
+    q15 m_coeffs[m_len];                //!< Coefficients in reversed order.
+    q15 m_state[m_len - 1 + block];     //!< History, followed by new samples.
+};
+
+//------------------------------------------------------------------------------
+
+template< size_t taps, size_t block >
+fir_q15< taps, block >::fir_q15(const q15 *coeffs)
+    :m_coeffs{}
+    ,m_state{}
+{
+    // Reversed coefficients match samples in memory order, so both can be
+    // loaded by pairs. Odd tap count is padded by leading zero.
+    for (size_t k = 0; k < taps; ++k) {
+        m_coeffs[m_len - 1 - k] = coeffs[k];
+    }
+}
+
+template< size_t taps, size_t block >
+void fir_q15< taps, block >::reset()
+{
+    std::memset(m_state, 0, sizeof(m_state));
+}
+
+template< size_t taps, size_t block >
+void fir_q15< taps, block >::process(const q15 *in, q15 *out, size_t n)
+{
+    while (n) {
+        size_t chunk = n < block ? n : block;
+
+        process_chunk(in, out, chunk);
+
+        in  += chunk;
+        out += chunk;
+        n   -= chunk;
+    }
+}
+
+template< size_t taps, size_t block >
+void fir_q15< taps, block >::process_chunk(const q15 *in, q15 *out, size_t n)
+{
+    constexpr size_t history = m_len - 1;
+
+    std::memcpy(m_state + history, in, n * sizeof(q15));
+
+    for (size_t i = 0; i < n; ++i) {
+        const q15 *x = m_state + i;
+        int64_t acc = 0;
+
+        for (size_t j = 0; j < m_len; j += 2) {
+            acc = simd::mac2(simd::load2(x + j), simd::load2(m_coeffs + j), acc);
+        }
+
+        out[i] = simd::sat_q15(acc >> 15);
+    }
+
+    std::memmove(m_state, m_state + n, history * sizeof(q15));
+}
+
+} // namespace dsp
+
+} // namespace ecl
+
+#endif // LIB_DSP_FIR_HPP_
@@ -0,0 +1,80 @@
+#ifndef LIB_DSP_SIMD_HPP_
+#define LIB_DSP_SIMD_HPP_
+
+//!
+//! \file
+//! \brief Packed 16-bit arithmetic, used by fixed-point kernels.
+//! On Cortex-M4 operations map to DSP extension instructions through
+//! CMSIS intrinsics of core_cm4_simd.h, so two samples are processed per
+//! instruction. Elsewhere portable equivalents are used, producing
+//! bit-exact results.
+//!
+
+#ifdef CONFIG_DSP_SIMD
+#include <stm32f4xx.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ecl
+{
+
+namespace dsp
+{
+
+//! Fixed-point sample in Q1.15 format, [-1, 1).
+using q15 = int16_t;
+
+namespace simd
+{
+
+//!
+//! \brief Loads two adjacent samples as a packed word.
+//! First sample is placed in lower halfword. Unaligned addresses are
+//! allowed, since Cortex-M4 handles unaligned word loads.
+//!
+inline uint32_t load2(const q15 *p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+//!
+//! \brief Multiplies halfwords pairwise and adds both products
+//! to 64-bit accumulator.
+//!
+inline int64_t mac2(uint32_t x, uint32_t y, int64_t acc)
+{
+#ifdef CONFIG_DSP_SIMD
+    return static_cast< int64_t >(__SMLALD(x, y, static_cast< uint64_t >(acc)));
+#else
+    int32_t lo = static_cast< int16_t >(x) * static_cast< int16_t >(y);
+    int32_t hi = static_cast< int16_t >(x >> 16) * static_cast< int16_t >(y >> 16);
+    return acc + lo + hi;
+#endif
+}
+
+//!
+//! \brief Saturates accumulator to Q15 range.
+//!
+inline q15 sat_q15(int64_t v)
+{
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    } else if (v < INT16_MIN) {
+        return INT16_MIN;
+    }
+
+    return static_cast< q15 >(v);
+}
+
+} // namespace simd
+
+} // namespace dsp
+
+} // namespace ecl
+
+#endif // LIB_DSP_SIMD_HPP_
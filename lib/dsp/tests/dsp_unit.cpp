@@ -0,0 +1,221 @@
+#include <ecl/dsp/fir.hpp>
+#include <ecl/dsp/biquad.hpp>
+#include <ecl/dsp/fft.hpp>
+#include <ecl/dsp/block.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+using ecl::dsp::q15;
+
+static const float pi = 3.14159265f;
+
+// Straightforward FIR, used as a reference
+template< size_t taps >
+static q15 fir_ref(const q15 (&b)[taps], const q15 *x, size_t i)
+{
+    int64_t acc = 0;
+
+    for (size_t k = 0; k < taps && k <= i; ++k) {
+        acc += static_cast< int32_t >(b[k]) * x[i - k];
+    }
+
+    return ecl::dsp::simd::sat_q15(acc >> 15);
+}
+
+TEST_GROUP(dsp)
+{
+};
+
+TEST(dsp, fir_impulse_response_is_coefficients)
+{
+    const q15 b[5] = { 1000, -2000, 3000, 4000, 32767 };
+    ecl::dsp::fir_q15< 5, 4 > fir{b};
+
+    q15 x[8] = { 32767 };
+    q15 y[8];
+
+    fir.process(x, y, 8);
+
+    for (size_t k = 0; k < 5; ++k) {
+        // Unit impulse is 1 - 2^-15, truncation takes one LSB off
+        CHECK_TRUE(std::abs(y[k] - b[k]) <= 1);
+    }
+
+    for (size_t k = 5; k < 8; ++k) {
+        CHECK_EQUAL(0, y[k]);
+    }
+}
+
+TEST(dsp, fir_matches_reference_across_blocks)
+{
+    const q15 b[7] = { 1200, -3400, 5600, 12000, 5600, -3400, 1200 };
+    ecl::dsp::fir_q15< 7, 5 > fir{b};
+
+    q15 x[50];
+    q15 y[50];
+
+    srand(1);
+    for (auto &v : x) {
+        v = static_cast< q15 >(rand() % 65536 - 32768);
+    }
+
+    // Split into odd chunks, so history crosses block boundaries
+    fir.process(x, y, 3);
+    fir.process(x + 3, y + 3, 13);
+    fir.process(x + 16, y + 16, 34);
+
+    for (size_t i = 0; i < 50; ++i) {
+        CHECK_EQUAL(fir_ref(b, x, i), y[i]);
+    }
+
+    // In-place processing gives the same result
+    q15 z[50];
+    std::memcpy(z, x, sizeof(z));
+
+    fir.reset();
+    fir.process(z, z, 50);
+    MEMCMP_EQUAL(y, z, sizeof(y));
+}
+
+TEST(dsp, fir_saturates)
+{
+    const q15 b[2] = { 32767, 32767 };
+    ecl::dsp::fir_q15< 2 > fir{b};
+
+    q15 x[4] = { 32767, 32767, -32768, -32768 };
+    q15 y[4];
+
+    fir.process(x, y, 4);
+    CHECK_EQUAL(32767, y[1]);
+    CHECK_EQUAL(-32768, y[3]);
+}
+
+TEST(dsp, biquad_lowpass_passes_dc_and_rejects_high_frequency)
+{
+    const ecl::dsp::biquad_coeffs c[2] = {
+        ecl::dsp::biquad_coeffs::lowpass(1000, 48000),
+        ecl::dsp::biquad_coeffs::lowpass(1000, 48000),
+    };
+
+    ecl::dsp::biquad_f32< 2 > lp{c};
+
+    float x[480];
+    float y[480];
+
+    for (auto &v : x) {
+        v = 0.5f;
+    }
+
+    lp.process(x, y, 480);
+    DOUBLES_EQUAL(0.5f, y[479], 1e-3);
+
+    // 12 kHz tone is attenuated by far more than 40 dB
+    for (size_t i = 0; i < 480; ++i) {
+        x[i] = std::sin(2 * pi * 12000 * i / 48000);
+    }
+
+    lp.reset();
+    lp.process(x, y, 480);
+    CHECK_TRUE(ecl::dsp::rms(y + 240, 240) < 0.01f);
+}
+
+TEST(dsp, fft_finds_tone)
+{
+    constexpr size_t n = 64;
+    ecl::dsp::fft_f32< n > fft;
+
+    float data[2 * n];
+
+    for (size_t i = 0; i < n; ++i) {
+        data[2 * i] = std::cos(2 * pi * 5 * i / n);
+        data[2 * i + 1] = 0;
+    }
+
+    fft.forward(data);
+
+    float mag[n];
+    fft.magnitude(data, mag, n);
+
+    // Real tone splits between positive and negative frequencies
+    DOUBLES_EQUAL(n / 2, mag[5], 1e-3);
+    DOUBLES_EQUAL(n / 2, mag[n - 5], 1e-3);
+
+    for (size_t k = 0; k < n; ++k) {
+        if (k != 5 && k != n - 5) {
+            CHECK_TRUE(mag[k] < 1e-3);
+        }
+    }
+}
+
+TEST(dsp, fft_roundtrip_restores_signal)
+{
+    constexpr size_t n = 32;
+    ecl::dsp::fft_f32< n > fft;
+
+    float orig[2 * n];
+    float data[2 * n];
+
+    for (size_t i = 0; i < 2 * n; ++i) {
+        orig[i] = data[i] = static_cast< float >(i % 7) - 3;
+    }
+
+    fft.forward(data);
+    fft.inverse(data);
+
+    for (size_t i = 0; i < 2 * n; ++i) {
+        DOUBLES_EQUAL(orig[i], data[i], 1e-4);
+    }
+}
+
+TEST(dsp, adc_codes_are_converted)
+{
+    const uint16_t codes[4] = { 0, 2048, 4095, 1024 };
+    q15 out[4];
+
+    ecl::dsp::from_adc(codes, out, 4);
+
+    CHECK_EQUAL(-32768, out[0]);
+    CHECK_EQUAL(0, out[1]);
+    CHECK_EQUAL(32752, out[2]);
+    CHECK_EQUAL(-16384, out[3]);
+
+    float f[4];
+    ecl::dsp::to_f32(out, f, 4);
+    DOUBLES_EQUAL(-1.0f, f[0], 1e-6);
+    DOUBLES_EQUAL(-0.5f, f[3], 1e-6);
+
+    q15 back[4];
+    ecl::dsp::to_q15(f, back, 4);
+    MEMCMP_EQUAL(out, back, sizeof(out));
+}
+
+TEST(dsp, rms_is_computed)
+{
+    // Square wave of amplitude A has RMS of A, odd length covers the tail
+    q15 sq[9];
+
+    for (size_t i = 0; i < 9; ++i) {
+        sq[i] = (i & 1) ? -16384 : 16384;
+    }
+
+    CHECK_EQUAL(16384, ecl::dsp::rms(sq, 9));
+    CHECK_EQUAL(0, ecl::dsp::rms(sq, 0));
+
+    float sine[1000];
+
+    for (size_t i = 0; i < 1000; ++i) {
+        sine[i] = std::sin(2 * pi * 10 * i / 1000);
+    }
+
+    DOUBLES_EQUAL(0.70710678f, ecl::dsp::rms(sine, 1000), 1e-4);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -1,16 +1,12 @@
 /* Avoid collisions with libc by using relative paths */
 #include "export/string.h"
+#include "word.h"
+
 #include <stdint.h>
 
-__attribute__((used))
+__attribute__((used)) EMC_NO_BUILTIN
 void * LIBC_FUNCTION(memcpy) (void *dst, const void *src, size_t cnt)
 {
-    uint8_t         *d = (uint8_t *)        dst;
-    const uint8_t   *s = (const uint8_t *)  src;
-
-    while (cnt--) {
-        *d++ = *s++;
-    }
-
+    emc_copy_fwd((uint8_t *) dst, (const uint8_t *) src, cnt);
     return dst;
 }
@@ -1,29 +1,21 @@
-#include "string.h"
+/* Avoid collisions with libc by using relative paths */
+#include "export/string.h"
+#include "word.h"
+
+#include <stdint.h>
 
 // Hack to avoid errors when using LTO
-__attribute__((used))
+__attribute__((used)) EMC_NO_BUILTIN
 void * LIBC_FUNCTION(memmove) (void *dst_void, const void *src_void, size_t length)
 {
-    // Grabbed from newlib implementation
-    char *dst = dst_void;
-    const char *src = src_void;
+    uint8_t *dst = dst_void;
+    const uint8_t *src = src_void;
 
-    if (src < dst && dst < src + length)
-    {
+    if (src < dst && dst < src + length) {
         /* Have to copy backwards */
-        src += length;
-        dst += length;
-        while (length--)
-        {
-            *--dst = *--src;
-        }
-    }
-    else
-    {
-        while (length--)
-        {
-            *dst++ = *src++;
-        }
+        emc_copy_bwd(dst, src, length);
+    } else {
+        emc_copy_fwd(dst, src, length);
     }
 
     return dst_void;
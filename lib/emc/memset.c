@@ -1,14 +1,37 @@
 /* Avoid collisions with libc by using relative paths */
 #include "export/string.h"
+#include "word.h"
 
 #include <stdint.h>
 
 // Hack to avoid errors when using LTO
-__attribute__((used))
+__attribute__((used)) EMC_NO_BUILTIN
 void * LIBC_FUNCTION(memset) (void *s, int c, size_t n)
 {
     uint8_t *dest = (uint8_t *) s;
 
+    if (EMC_USE_WORDS && n >= EMC_SMALL_SIZE) {
+        while (!emc_is_aligned(dest)) {
+            *dest++ = c;
+            n--;
+        }
+
+        emc_word pattern = EMC_REPEAT(c);
+        emc_word *dw = (emc_word *) dest;
+
+        /* Four words per iteration, so STM is used on ARM */
+        for (; n >= EMC_WORD_SIZE * 4; n -= EMC_WORD_SIZE * 4) {
+            dw[0] = pattern; dw[1] = pattern; dw[2] = pattern; dw[3] = pattern;
+            dw += 4;
+        }
+
+        for (; n >= EMC_WORD_SIZE; n -= EMC_WORD_SIZE) {
+            *dw++ = pattern;
+        }
+
+        dest = (uint8_t *) dw;
+    }
+
     while (n--) {
         *dest++ = c;
     }
@@ -1,13 +1,38 @@
-#include "string.h"
+/* Avoid collisions with libc by using relative paths */
+#include "export/string.h"
+#include "word.h"
 
+EMC_NO_ASAN
 const char*  LIBC_FUNCTION(strchr) (const char *str, int character)
 {
-    const char *p;
-    while (*(p = str++)) {
-        if (*p == character) {
-            return p;
+    const char c = character;
+    const char *p = str;
+
+#ifdef EMC_VEC_SIZE
+    p = emc_vec_find(str, c);
+#else
+#if EMC_USE_WORDS
+    while (!emc_is_aligned(p)) {
+        if (*p == c || !*p) {
+            return *p == c ? p : NULL;
         }
+        p++;
+    }
+
+    /* Skip words that contain neither the character, nor the terminator */
+    const emc_word pattern = EMC_REPEAT(c);
+    const emc_word *w = (const emc_word *) p;
+    while (!EMC_HAS_ZERO(*w) && !EMC_HAS_ZERO(*w ^ pattern)) {
+        w++;
+    }
+
+    p = (const char *) w;
+#endif
+
+    while (*p != c && *p) {
+        p++;
     }
+#endif
 
-    return NULL;
+    return *p == c ? p : NULL;
 }
@@ -1,20 +1,75 @@
-#include "string.h"
+/* Avoid collisions with libc by using relative paths */
+#include "export/string.h"
+#include "word.h"
 
 /* Rely upon actual function */
 extern int tolower(int c);
 
+/* Skips common prefix by words, if strings are mutually aligned.
+ * Equal words without terminator are equal in any case, thus the same
+ * prefix is valid for case-insensitive comparison. */
+static inline EMC_NO_ASAN
+void skip_equal_words(const unsigned char **str1, const unsigned char **str2)
+{
+	const unsigned char *a = *str1;
+	const unsigned char *b = *str2;
+
+	if (!EMC_USE_WORDS
+	    || ((uintptr_t) a & EMC_WORD_MASK) != ((uintptr_t) b & EMC_WORD_MASK)) {
+		return;
+	}
+
+	while (!emc_is_aligned(a)) {
+		if (*a != *b || !*a) {
+			goto out;
+		}
+		a++;
+		b++;
+	}
+
+	const emc_word *wa = (const emc_word *) a;
+	const emc_word *wb = (const emc_word *) b;
+
+	while (*wa == *wb && !EMC_HAS_ZERO(*wa)) {
+		wa++;
+		wb++;
+	}
+
+	a = (const unsigned char *) wa;
+	b = (const unsigned char *) wb;
+
+out:
+	*str1 = a;
+	*str2 = b;
+}
+
+/* Standard routine is provided by the toolchain libc, if requested */
+#ifndef CONFIG_EMC_STRING_TOOLCHAIN
 int LIBC_FUNCTION(strcmp)(const char *str1, const char *str2)
 {
-	int c;
-	while (!(c = *str1 - *str2++) && *str1++) { }
+	const unsigned char *a = (const unsigned char *) str1;
+	const unsigned char *b = (const unsigned char *) str2;
+
+	skip_equal_words(&a, &b);
 
-	return c;
+	while (*a == *b && *a) {
+		a++;
+		b++;
+	}
+
+	return *a - *b;
 }
+#endif
 
 int LIBC_FUNCTION(strcmpi)(const char *str1, const char *str2)
 {
+    const unsigned char *a = (const unsigned char *) str1;
+    const unsigned char *b = (const unsigned char *) str2;
     int c;
-    while (!(c = tolower(*str1) - tolower(*str2++)) && *str1++) { }
+
+    skip_equal_words(&a, &b);
+
+    while (!(c = tolower(*a) - tolower(*b++)) && *a++) { }
 
     return c;
 }
@@ -1,9 +1,37 @@
-#include "string.h"
+/* Avoid collisions with libc by using relative paths */
+#include "export/string.h"
+#include "word.h"
 
+EMC_NO_ASAN
 size_t  LIBC_FUNCTION(strlen) (const char *str)
 {
-	size_t len = 0;
-	while (*str++) { len++; }
+#ifdef EMC_VEC_SIZE
+	return emc_vec_find(str, 0) - str;
+#else
+	const char *p = str;
 
-	return len;
+#if EMC_USE_WORDS
+	while (!emc_is_aligned(p)) {
+		if (!*p) {
+			return p - str;
+		}
+		p++;
+	}
+
+	/* Aligned word never crosses a page, so reading past
+	 * the terminator is safe */
+	const emc_word *w = (const emc_word *) p;
+	while (!EMC_HAS_ZERO(*w)) {
+		w++;
+	}
+
+	p = (const char *) w;
+#endif
+
+	while (*p) {
+		p++;
+	}
+
+	return p - str;
+#endif
 }
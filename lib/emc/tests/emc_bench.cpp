@@ -0,0 +1,172 @@
+// Relative path when testing libc-like functions is unavoidable
+#include "../export/string.h"
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Throughput of emc routines against the system libc.
+// Only reports results, never fails on them.
+
+namespace
+{
+
+// Amount of bytes processed by each measurement
+constexpr size_t bench_bytes = 64 * 1024 * 1024;
+
+constexpr size_t sizes[] = { 8, 32, 128, 1024, 16384 };
+
+// Destination and source offsets from the aligned address
+struct alignment
+{
+    size_t dst;
+    size_t src;
+};
+
+constexpr alignment alignments[] = { {0, 0}, {1, 1}, {0, 3}, {3, 0} };
+
+// Called through volatile pointers, so compiler neither inlines
+// nor removes calls to the system routines
+using copy_fn  = void *(*)(void *, const void *, size_t);
+using set_fn   = void *(*)(void *, int, size_t);
+using len_fn   = size_t (*)(const char *);
+
+volatile copy_fn libc_memcpy  = memcpy;
+volatile copy_fn libc_memmove = memmove;
+volatile set_fn  libc_memset  = memset;
+volatile len_fn  libc_strlen  = strlen;
+
+volatile copy_fn our_memcpy   = LIBC_FUNCTION(memcpy);
+volatile copy_fn our_memmove  = LIBC_FUNCTION(memmove);
+volatile set_fn  our_memset   = LIBC_FUNCTION(memset);
+volatile len_fn  our_strlen   = LIBC_FUNCTION(strlen);
+
+volatile size_t sink;
+
+alignas(64) uint8_t dst_buf[16384 + 64];
+alignas(64) uint8_t src_buf[16384 + 64];
+
+// Returns throughput in MB/s
+template< class Fn >
+double measure(size_t size, Fn fn)
+{
+    size_t iterations = bench_bytes / size;
+
+    // Warm up caches and branch predictors
+    fn();
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double us = std::chrono::duration_cast< std::chrono::microseconds >(end - start).count();
+    return us ? (iterations * size) / us : 0;
+}
+
+void report(const char *name, size_t size, const alignment &a, double ecl, double libc)
+{
+    printf("%-8s %6zu  %zu/%zu  %9.1f %9.1f  %5.2fx\n",
+           name, size, a.dst, a.src, ecl, libc, libc ? ecl / libc : 0);
+}
+
+void header()
+{
+    printf("\n%-8s %6s  %s  %9s %9s  %6s\n",
+           "routine", "size", "d/s", "ecl MB/s", "libc MB/s", "ratio");
+}
+
+} // namespace
+
+TEST_GROUP(emc_bench)
+{
+    void setup()
+    {
+        memset(src_buf, 'a', sizeof(src_buf));
+        memset(dst_buf, 0, sizeof(dst_buf));
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(emc_bench, memcpy_memmove)
+{
+    header();
+
+    for (auto size : sizes) {
+        for (auto &a : alignments) {
+            auto d = dst_buf + a.dst;
+            auto s = src_buf + a.src;
+
+            report("memcpy", size, a,
+                   measure(size, [=]() { our_memcpy(d, s, size); }),
+                   measure(size, [=]() { libc_memcpy(d, s, size); }));
+        }
+    }
+
+    for (auto size : sizes) {
+        // Overlapping backward copy, the slowest memmove case
+        auto d = src_buf + 5;
+        auto s = src_buf;
+        alignment a{5, 0};
+
+        report("memmove", size, a,
+               measure(size, [=]() { our_memmove(d, s, size); }),
+               measure(size, [=]() { libc_memmove(d, s, size); }));
+    }
+}
+
+TEST(emc_bench, memset)
+{
+    header();
+
+    for (auto size : sizes) {
+        for (auto off : { 0, 1 }) {
+            auto d = dst_buf + off;
+            alignment a{static_cast< size_t >(off), 0};
+
+            report("memset", size, a,
+                   measure(size, [=]() { our_memset(d, 0x5a, size); }),
+                   measure(size, [=]() { libc_memset(d, 0x5a, size); }));
+        }
+    }
+}
+
+TEST(emc_bench, strlen)
+{
+    header();
+
+    for (auto size : sizes) {
+        for (auto off : { 0, 3 }) {
+            auto str = reinterpret_cast< char * >(src_buf) + off;
+            std::vector< char > saved(str, str + size);
+
+            std::fill(str, str + size - 1, 'a');
+            str[size - 1] = 0;
+
+            alignment a{0, static_cast< size_t >(off)};
+
+            report("strlen", size, a,
+                   measure(size, [=]() { sink = our_strlen(str); }),
+                   measure(size, [=]() { sink = libc_strlen(str); }));
+
+            // Both must agree
+            CHECK_EQUAL(libc_strlen(str), our_strlen(str));
+            std::copy(saved.begin(), saved.end(), str);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
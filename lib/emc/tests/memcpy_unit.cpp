@@ -1,6 +1,113 @@
+// Relative path when testing libc-like functions is unavoidable
+#include "../export/string.h"
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+#include <algorithm>
+#include <cstdint>
+
+// For convinience
+static auto &our_memcpy  = LIBC_FUNCTION(memcpy);
+static auto &our_memmove = LIBC_FUNCTION(memmove);
+
+static constexpr uint8_t   canary_byte  = 0xab;
+static constexpr size_t    max_size     = 100;
+static constexpr size_t    max_offset   = 2 * sizeof(uintptr_t);
+static constexpr size_t    arr_size     = max_size + max_offset * 2;
+
+static uint8_t src[arr_size];
+static uint8_t dst[arr_size];
+
+// Unique pattern, so misplaced byte is detected
+static uint8_t pattern(size_t i)
+{
+    return static_cast< uint8_t >(i * 7 + 1);
+}
+
+TEST_GROUP(memcpy_test)
+{
+    void setup()
+    {
+        for (size_t i = 0; i < arr_size; ++i) {
+            src[i] = pattern(i);
+        }
+
+        std::fill(dst, dst + arr_size, canary_byte);
+    }
+
+    void teardown()
+    {
+    }
+
+    // Checks that only given range is copied, bytes around are intact
+    void check_copied(size_t dst_off, size_t src_off, size_t size)
+    {
+        for (size_t i = 0; i < arr_size; ++i) {
+            if (i >= dst_off && i < dst_off + size) {
+                BYTES_EQUAL(pattern(src_off + i - dst_off), dst[i]);
+            } else {
+                BYTES_EQUAL(canary_byte, dst[i]);
+            }
+        }
+    }
+};
+
+TEST(memcpy_test, retval)
+{
+    POINTERS_EQUAL(dst, our_memcpy(dst, src, 1));
+    POINTERS_EQUAL(dst, our_memmove(dst, src, 1));
+}
+
+TEST(memcpy_test, all_sizes_and_alignments)
+{
+    for (size_t dst_off = 0; dst_off < max_offset; ++dst_off) {
+        for (size_t src_off = 0; src_off < max_offset; ++src_off) {
+            for (size_t size = 0; size <= max_size; ++size) {
+                setup();
+                our_memcpy(dst + dst_off, src + src_off, size);
+                check_copied(dst_off, src_off, size);
+            }
+        }
+    }
+}
+
+TEST(memcpy_test, memmove_no_overlap)
+{
+    for (size_t dst_off = 0; dst_off < max_offset; ++dst_off) {
+        for (size_t size = 0; size <= max_size; ++size) {
+            setup();
+            our_memmove(dst + dst_off, src + 1, size);
+            check_copied(dst_off, 1, size);
+        }
+    }
+}
+
+TEST(memcpy_test, memmove_overlap)
+{
+    for (size_t shift = 1; shift < max_offset * 2; ++shift) {
+        for (size_t size = 0; size <= max_size; ++size) {
+            // Forward: destination is after source
+            setup();
+            std::copy(src, src + arr_size, dst);
+            our_memmove(dst + shift, dst, size);
+
+            for (size_t i = 0; i < size; ++i) {
+                BYTES_EQUAL(pattern(i), dst[shift + i]);
+            }
+
+            // Backward: destination is before source
+            setup();
+            std::copy(src, src + arr_size, dst);
+            our_memmove(dst, dst + shift, size);
+
+            for (size_t i = 0; i < size; ++i) {
+                BYTES_EQUAL(pattern(shift + i), dst[i]);
+            }
+        }
+    }
+}
+
 int main(int argc, char *argv[])
 {
-    (void) argc;
-    (void) argv;
-    return 0;
+    return CommandLineTestRunner::RunAllTests(argc, argv);
 }
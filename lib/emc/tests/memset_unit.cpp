@@ -68,6 +68,21 @@ TEST(memset_test, all_bytes_set)
                   [](auto elem){ BYTES_EQUAL(test_byte, elem); });
 }
 
+TEST(memset_test, all_sizes_and_alignments)
+{
+    for (size_t off = 0; off < 2 * sizeof(uintptr_t); ++off) {
+        for (size_t size = 0; size + off <= data_size; ++size) {
+            setup();
+            our_memset(chunk.data + off, test_byte, size);
+
+            for (size_t i = 0; i < data_size; ++i) {
+                auto expected = (i >= off && i < off + size) ? test_byte : initial_byte;
+                BYTES_EQUAL(expected, chunk.data[i]);
+            }
+        }
+    }
+}
+
 int main(int argc, char *argv[])
 {
     return CommandLineTestRunner::RunAllTests(argc, argv);
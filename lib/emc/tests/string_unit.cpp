@@ -0,0 +1,142 @@
+// Relative path when testing libc-like functions is unavoidable
+#include "../export/string.h"
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+#include <algorithm>
+#include <cstdint>
+
+// For convinience
+static auto &our_strlen  = LIBC_FUNCTION(strlen);
+static auto &our_strchr  = LIBC_FUNCTION(strchr);
+static auto &our_strcmp  = LIBC_FUNCTION(strcmp);
+static auto &our_strcmpi = LIBC_FUNCTION(strcmpi);
+
+static constexpr size_t max_len     = 80;
+static constexpr size_t max_offset  = 32;
+
+// Aligned, so offsets cover all positions within words and vectors
+alignas(64) static char buf1[max_len + max_offset + 1];
+alignas(64) static char buf2[max_len + max_offset + 1];
+
+// Places string of given length at given offset
+static char *make_string(char *buf, size_t off, size_t len)
+{
+    std::fill(buf, buf + sizeof(buf1), 'x');
+
+    char *str = buf + off;
+    for (size_t i = 0; i < len; ++i) {
+        str[i] = 'a' + i % 10;
+    }
+    str[len] = 0;
+
+    return str;
+}
+
+static int sign(int v)
+{
+    return (v > 0) - (v < 0);
+}
+
+TEST_GROUP(string_test)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(string_test, strlen_all_lengths_and_alignments)
+{
+    for (size_t off = 0; off < max_offset; ++off) {
+        for (size_t len = 0; len <= max_len; ++len) {
+            auto str = make_string(buf1, off, len);
+            CHECK_EQUAL(len, our_strlen(str));
+        }
+    }
+}
+
+TEST(string_test, strchr_all_positions)
+{
+    for (size_t off = 0; off < max_offset; ++off) {
+        for (size_t len = 0; len <= max_len; ++len) {
+            auto str = make_string(buf1, off, len);
+
+            for (size_t pos = 0; pos < len; ++pos) {
+                str[pos] = '#';
+                POINTERS_EQUAL(str + pos, our_strchr(str, '#'));
+                str[pos] = 'a' + pos % 10;
+            }
+
+            // Trailing garbage is never matched
+            POINTERS_EQUAL(nullptr, our_strchr(str, 'x'));
+
+            // Terminator is a part of the string
+            POINTERS_EQUAL(str + len, our_strchr(str, 0));
+        }
+    }
+}
+
+TEST(string_test, strchr_high_characters)
+{
+    auto str = make_string(buf1, 3, 40);
+    str[17] = '\xe9';
+
+    POINTERS_EQUAL(str + 17, our_strchr(str, 0xe9));
+    POINTERS_EQUAL(str + 17, our_strchr(str, '\xe9'));
+}
+
+TEST(string_test, strcmp_all_alignments)
+{
+    for (size_t off1 = 0; off1 < 16; ++off1) {
+        for (size_t off2 = 0; off2 < 16; ++off2) {
+            for (size_t len = 0; len <= max_len; len += 3) {
+                auto s1 = make_string(buf1, off1, len);
+                auto s2 = make_string(buf2, off2, len);
+
+                CHECK_EQUAL(0, our_strcmp(s1, s2));
+
+                for (size_t pos = 0; pos < len; ++pos) {
+                    s2[pos]++;
+                    CHECK_EQUAL(-1, sign(our_strcmp(s1, s2)));
+                    CHECK_EQUAL(1, sign(our_strcmp(s2, s1)));
+                    s2[pos]--;
+                }
+
+                // Prefix is less than the whole string
+                if (len) {
+                    s2[len - 1] = 0;
+                    CHECK_EQUAL(1, sign(our_strcmp(s1, s2)));
+                    CHECK_EQUAL(-1, sign(our_strcmp(s2, s1)));
+                }
+            }
+        }
+    }
+}
+
+TEST(string_test, strcmp_unsigned_characters)
+{
+    CHECK_EQUAL(1, sign(our_strcmp("\xe9", "a")));
+    CHECK_EQUAL(-1, sign(our_strcmp("a", "\xe9")));
+}
+
+TEST(string_test, strcmpi)
+{
+    auto s1 = make_string(buf1, 0, 40);
+    auto s2 = make_string(buf2, 0, 40);
+
+    s2[0]  = 'A';
+    s2[21] = 'B';
+    CHECK_EQUAL(0, our_strcmpi(s1, s2));
+    CHECK_EQUAL(0, our_strcmpi("Boot.INI", "boot.ini"));
+    CHECK_EQUAL(-1, sign(our_strcmpi("abc", "ABD")));
+    CHECK_EQUAL(1, sign(our_strcmpi("abcd", "ABC")));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
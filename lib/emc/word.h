@@ -0,0 +1,215 @@
+#ifndef LIB_EMC_WORD_H_
+#define LIB_EMC_WORD_H_
+
+/* Helpers for word-at-a-time memory and string routines */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Aliases any memory, as char does */
+typedef uintptr_t __attribute__((may_alias)) emc_word;
+
+/* Same as above, but may be misaligned. Targets that lack unaligned
+ * access get byte loads from the compiler. */
+typedef uintptr_t __attribute__((may_alias, aligned(1))) emc_uword;
+
+#define EMC_WORD_SIZE       sizeof(emc_word)
+#define EMC_WORD_MASK       (EMC_WORD_SIZE - 1)
+
+/* Word-at-a-time paths are compiled out in portable build,
+ * leaving only byte loops */
+#ifdef CONFIG_EMC_STRING_PORTABLE
+#define EMC_USE_WORDS       0
+#else
+#define EMC_USE_WORDS       1
+#endif
+
+/* Below this size, byte loop is faster than alignment handling */
+#define EMC_SMALL_SIZE      (EMC_WORD_SIZE * 4)
+
+/* Value with given byte repeated in each byte of the word */
+#define EMC_REPEAT(b)       ((emc_word) -1 / 0xff * (uint8_t) (b))
+
+/* Non-zero if any byte of the word is zero. Lowest marked byte is exact,
+ * higher ones may be false positives. */
+#define EMC_HAS_ZERO(w)     (((w) - EMC_REPEAT(0x01)) & ~(w) & EMC_REPEAT(0x80))
+
+/* String routines load whole aligned words and vectors, thus may read past
+ * the terminator. Such reads never cross a page, so they never fault,
+ * but address sanitizer would report them. */
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define EMC_NO_ASAN         __attribute__((no_sanitize_address))
+#endif
+#endif
+
+#if !defined(EMC_NO_ASAN) && defined(__SANITIZE_ADDRESS__)
+#define EMC_NO_ASAN         __attribute__((no_sanitize_address))
+#endif
+
+#ifndef EMC_NO_ASAN
+#define EMC_NO_ASAN
+#endif
+
+/* Prevents compiler from turning loops back into memcpy()/memset() calls,
+ * which would recurse when the routines are built as libc replacement */
+#if defined(__GNUC__) && !defined(__clang__)
+#define EMC_NO_BUILTIN      __attribute__((optimize("no-tree-loop-distribute-patterns")))
+#elif defined(__clang__) && defined(__has_attribute)
+#if __has_attribute(no_builtin)
+#define EMC_NO_BUILTIN      __attribute__((no_builtin))
+#endif
+#endif
+
+#ifndef EMC_NO_BUILTIN
+#define EMC_NO_BUILTIN
+#endif
+
+static inline int emc_is_aligned(const void *p)
+{
+    return ((uintptr_t) p & EMC_WORD_MASK) == 0;
+}
+
+/* Copies forward. Destination is aligned first, so all stores are aligned.
+ * Four words are moved per iteration, so LDM/STM are used on ARM. */
+static inline EMC_NO_BUILTIN
+void emc_copy_fwd(uint8_t *d, const uint8_t *s, size_t cnt)
+{
+    if (EMC_USE_WORDS && cnt >= EMC_SMALL_SIZE) {
+        while (!emc_is_aligned(d)) {
+            *d++ = *s++;
+            cnt--;
+        }
+
+        emc_word *dw = (emc_word *) d;
+
+        if (emc_is_aligned(s)) {
+            const emc_word *sw = (const emc_word *) s;
+
+            for (; cnt >= EMC_WORD_SIZE * 4; cnt -= EMC_WORD_SIZE * 4) {
+                emc_word w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3];
+                dw[0] = w0; dw[1] = w1; dw[2] = w2; dw[3] = w3;
+                dw += 4;
+                sw += 4;
+            }
+
+            s = (const uint8_t *) sw;
+        }
+
+        for (; cnt >= EMC_WORD_SIZE; cnt -= EMC_WORD_SIZE) {
+            *dw++ = *(const emc_uword *) s;
+            s += EMC_WORD_SIZE;
+        }
+
+        d = (uint8_t *) dw;
+    }
+
+    while (cnt--) {
+        *d++ = *s++;
+    }
+}
+
+/* Copies backward, starting from the end of regions */
+static inline EMC_NO_BUILTIN
+void emc_copy_bwd(uint8_t *d, const uint8_t *s, size_t cnt)
+{
+    d += cnt;
+    s += cnt;
+
+    if (EMC_USE_WORDS && cnt >= EMC_SMALL_SIZE) {
+        while (!emc_is_aligned(d)) {
+            *--d = *--s;
+            cnt--;
+        }
+
+        emc_word *dw = (emc_word *) d;
+
+        if (emc_is_aligned(s)) {
+            const emc_word *sw = (const emc_word *) s;
+
+            for (; cnt >= EMC_WORD_SIZE * 4; cnt -= EMC_WORD_SIZE * 4) {
+                dw -= 4;
+                sw -= 4;
+                emc_word w0 = sw[0], w1 = sw[1], w2 = sw[2], w3 = sw[3];
+                dw[0] = w0; dw[1] = w1; dw[2] = w2; dw[3] = w3;
+            }
+
+            s = (const uint8_t *) sw;
+        }
+
+        for (; cnt >= EMC_WORD_SIZE; cnt -= EMC_WORD_SIZE) {
+            s -= EMC_WORD_SIZE;
+            *--dw = *(const emc_uword *) s;
+        }
+
+        d = (uint8_t *) dw;
+    }
+
+    while (cnt--) {
+        *--d = *--s;
+    }
+}
+
+/* Vector helpers, selected at compile time on hosts with SSE2 or AVX2.
+ * All loads are aligned to the vector size. */
+#if !EMC_USE_WORDS
+
+/* No vector helpers */
+
+#elif defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define EMC_VEC_SIZE        32
+
+/* Mask of bytes equal to zero or to given character */
+static inline EMC_NO_ASAN
+unsigned emc_vec_match(const void *p, char c)
+{
+    __m256i v = _mm256_load_si256((const __m256i *) p);
+    __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()),
+                                _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+    return (unsigned) _mm256_movemask_epi8(m);
+}
+
+#elif defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#define EMC_VEC_SIZE        16
+
+/* Mask of bytes equal to zero or to given character */
+static inline EMC_NO_ASAN
+unsigned emc_vec_match(const void *p, char c)
+{
+    __m128i v = _mm_load_si128((const __m128i *) p);
+    __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_setzero_si128()),
+                             _mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+    return (unsigned) _mm_movemask_epi8(m);
+}
+
+#endif
+
+#ifdef EMC_VEC_SIZE
+
+/* Finds first byte equal to zero or to given character */
+static inline EMC_NO_ASAN
+const char *emc_vec_find(const char *str, char c)
+{
+    uintptr_t off = (uintptr_t) str & (EMC_VEC_SIZE - 1);
+    const char *p = str - off;
+
+    /* Bytes before the string are masked out */
+    unsigned mask = emc_vec_match(p, c) >> off << off;
+
+    while (!mask) {
+        p += EMC_VEC_SIZE;
+        mask = emc_vec_match(p, c);
+    }
+
+    return p + __builtin_ctz(mask);
+}
+
+#endif
+
+#endif
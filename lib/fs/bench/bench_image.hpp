@@ -0,0 +1,126 @@
+#ifndef LIB_FS_BENCH_IMAGE_HPP_
+#define LIB_FS_BENCH_IMAGE_HPP_
+
+// Volume, on which filesystem benchmarks are run:
+//
+//   /DATA.BIN                      1 MiB of data, for reads
+//   /F.TXT ... /D1/D2/D3/D4/F.TXT  small files at depths 0 to 4, for opens
+//   /LIST/F00.TXT ... F63.TXT      64 small files, for dir listing
+//
+// Image is built by the native FAT engine on any device, given as
+// a volume::disk. Device content is destroyed.
+
+#include <fat/native/format.hpp>
+
+#include <cstring>
+
+namespace fs_bench
+{
+
+using fat::native::volume;
+
+constexpr uint32_t data_size    = 1024 * 1024;
+constexpr unsigned max_depth    = 4;
+constexpr unsigned list_size    = 64;
+
+namespace detail
+{
+
+// Creates a file with given content
+inline int create_file(volume &vol, uint32_t dir, const char *name,
+                       const uint8_t *data, size_t size)
+{
+    fat::native::entry e;
+    fat::native::cursor cur = {};
+
+    if (vol.dir_create(dir, name, 0, e) < 0) {
+        return -1;
+    }
+
+    if (vol.write(e, cur, 0, data, size) != static_cast< ssize_t >(size)) {
+        return -1;
+    }
+
+    return vol.entry_update(e);
+}
+
+} // namespace detail
+
+// Formats device and fills it with benchmark files.
+// -1 if error, 0 otherwise.
+inline int build(const volume::disk &d, uint32_t blocks)
+{
+    using namespace detail;
+
+    static uint8_t chunk[64 * volume::sector_size];
+    static volume vol;
+
+    // One sector per cluster
+    if (fat::native::format(d, blocks) < 0 || vol.mount(d, blocks) < 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < sizeof(chunk); ++i) {
+        chunk[i] = i * 7 + (i >> 9);
+    }
+
+    // Data file is written in chunks, so clusters are allocated the way
+    // typical writer would do
+    fat::native::entry data;
+    fat::native::cursor cur = {};
+
+    if (vol.dir_create(vol.root(), "DATA.BIN", 0, data) < 0) {
+        return -1;
+    }
+
+    for (uint32_t offt = 0; offt < data_size; offt += sizeof(chunk)) {
+        if (vol.write(data, cur, offt, chunk, sizeof(chunk)) != sizeof(chunk)) {
+            return -1;
+        }
+    }
+
+    if (vol.entry_update(data) < 0) {
+        return -1;
+    }
+
+    // Nested dirs, with a file on each level
+    uint32_t dir = vol.root();
+    for (unsigned depth = 0; depth <= max_depth; ++depth) {
+        if (create_file(vol, dir, "F.TXT", chunk, 16) < 0) {
+            return -1;
+        }
+
+        if (depth < max_depth) {
+            char name[] = "D0";
+            fat::native::entry sub;
+
+            name[1] += depth + 1;
+            if (vol.dir_create(dir, name, volume::attr_dir, sub) < 0) {
+                return -1;
+            }
+
+            dir = sub.cluster;
+        }
+    }
+
+    fat::native::entry list;
+    if (vol.dir_create(vol.root(), "LIST", volume::attr_dir, list) < 0) {
+        return -1;
+    }
+
+    for (unsigned i = 0; i < list_size; ++i) {
+        char name[] = "F00.TXT";
+
+        name[1] += i / 10;
+        name[2] += i % 10;
+        if (create_file(vol, list.cluster, name, chunk, 16) < 0) {
+            return -1;
+        }
+    }
+
+    return vol.sync();
+}
+
+} // namespace fs_bench
+
+#endif // LIB_FS_BENCH_IMAGE_HPP_
@@ -0,0 +1,217 @@
+// Filesystem benchmarks, run through vfs.
+//
+// Same image, see bench_image.hpp, is mounted twice: as petit under /p
+// and as native FAT under /n, so engines can be compared side by side.
+// Device is taken from bench_disk.hpp: RAM disk on host, SD card on target.
+//
+//  - *_seq_<n> reads whole 1 MiB file with buffer of n bytes, open included;
+//  - *_rand_4k reads 4 KiB at random aligned offset, op/s is IOPS;
+//  - *_open_d<n> opens and closes a file at depth n, path is resolved
+//    from scratch, *_open_cached_d4 is served from the dentry cache;
+//  - *_list_64 lists a dir of 64 files in batches of 16 entries.
+//
+// Random reads of petit require CONFIG_FS_FAT_PETIT_LSEEK.
+
+#include <bench_disk.hpp>
+
+#include <fs/fs.hpp>
+#include <fat/fs.hpp>
+#include <fat/native/fs.hpp>
+
+#include <ecl/bench.hpp>
+#include <ecl/static_instance.hpp>
+
+namespace
+{
+
+constexpr char petit_mnt[]  = "/p";
+constexpr char native_mnt[] = "/n";
+
+using bench_vfs = fs::vfs<
+    fs::fs_descriptor< petit_mnt, fat::petit< fs_bench::bench_disk > >,
+    fs::fs_descriptor< native_mnt, fat::native::filesystem< fs_bench::bench_disk > >
+>;
+
+constexpr ecl::bench::options seq_options     = { 1, 5, 1 };
+constexpr ecl::bench::options op_options      = { 3, 15, 20 };
+constexpr size_t              rand_size       = 4096;
+constexpr size_t              list_batch      = 16;
+
+uint8_t buf[32 * 1024];
+
+ecl::static_instance< bench_vfs > vfs_instance;
+
+// Image is built and filesystems are mounted on first use, rather than
+// during static initialization
+bench_vfs &vfs()
+{
+    if (!vfs_instance.constructed()) {
+        auto rc = fs_bench::prepare();
+        ecl_assert(rc == 0);
+        (void) rc;
+
+        vfs_instance.construct();
+        vfs_instance->mount_all();
+    }
+
+    return *vfs_instance;
+}
+
+void read_all(const char *path, size_t chunk)
+{
+    auto f = vfs().open_file(path);
+    ecl_assert(f);
+
+    while (f->read(buf, chunk) > 0) { }
+
+    f->close();
+}
+
+void read_random(fs::file_ptr &f, const char *path)
+{
+    static uint32_t seed = 1;
+
+    if (!f) {
+        f = vfs().open_file(path);
+        ecl_assert(f);
+    }
+
+    seed = seed * 1103515245 + 12345;
+    off_t offt = (seed >> 8) % (fs_bench::data_size / rand_size) * rand_size;
+
+    f->seek(offt);
+    auto ret = f->read(buf, rand_size);
+    ecl::bench::do_not_optimize(ret);
+}
+
+void open_close(const char *path, bool cached)
+{
+    if (!cached) {
+        vfs().invalidate();
+    }
+
+    auto f = vfs().open_file(path);
+    ecl_assert(f);
+
+    f->close();
+}
+
+void list(const char *path)
+{
+    static fs::dir_entry entries[list_batch];
+
+    auto d = vfs().open_dir(path);
+    ecl_assert(d);
+
+    size_t total = 0;
+    ssize_t n;
+
+    while ((n = d->readdir(entries, list_batch)) > 0) {
+        total += n;
+    }
+
+    ecl_assert(total == fs_bench::list_size);
+    ecl::bench::do_not_optimize(total);
+
+    d->close();
+}
+
+} // namespace
+
+// Petit -----------------------------------------------------------------------
+
+ECL_BENCH_BYTES(petit_seq_512, seq_options, fs_bench::data_size)
+{
+    read_all("/p/DATA.BIN", 512);
+}
+
+ECL_BENCH_BYTES(petit_seq_4k, seq_options, fs_bench::data_size)
+{
+    read_all("/p/DATA.BIN", 4096);
+}
+
+ECL_BENCH_BYTES(petit_seq_32k, seq_options, fs_bench::data_size)
+{
+    read_all("/p/DATA.BIN", 32 * 1024);
+}
+
+#if _USE_LSEEK
+ECL_BENCH_BYTES(petit_rand_4k, op_options, rand_size)
+{
+    static fs::file_ptr f;
+    read_random(f, "/p/DATA.BIN");
+}
+#endif
+
+ECL_BENCH_OPTS(petit_open_d0, op_options)
+{
+    open_close("/p/F.TXT", false);
+}
+
+ECL_BENCH_OPTS(petit_open_d2, op_options)
+{
+    open_close("/p/D1/D2/F.TXT", false);
+}
+
+ECL_BENCH_OPTS(petit_open_d4, op_options)
+{
+    open_close("/p/D1/D2/D3/D4/F.TXT", false);
+}
+
+ECL_BENCH_OPTS(petit_open_cached_d4, op_options)
+{
+    open_close("/p/D1/D2/D3/D4/F.TXT", true);
+}
+
+ECL_BENCH_OPTS(petit_list_64, op_options)
+{
+    list("/p/LIST/");
+}
+
+// Native FAT ------------------------------------------------------------------
+
+ECL_BENCH_BYTES(native_seq_512, seq_options, fs_bench::data_size)
+{
+    read_all("/n/DATA.BIN", 512);
+}
+
+ECL_BENCH_BYTES(native_seq_4k, seq_options, fs_bench::data_size)
+{
+    read_all("/n/DATA.BIN", 4096);
+}
+
+ECL_BENCH_BYTES(native_seq_32k, seq_options, fs_bench::data_size)
+{
+    read_all("/n/DATA.BIN", 32 * 1024);
+}
+
+ECL_BENCH_BYTES(native_rand_4k, op_options, rand_size)
+{
+    static fs::file_ptr f;
+    read_random(f, "/n/DATA.BIN");
+}
+
+ECL_BENCH_OPTS(native_open_d0, op_options)
+{
+    open_close("/n/F.TXT", false);
+}
+
+ECL_BENCH_OPTS(native_open_d2, op_options)
+{
+    open_close("/n/D1/D2/F.TXT", false);
+}
+
+ECL_BENCH_OPTS(native_open_d4, op_options)
+{
+    open_close("/n/D1/D2/D3/D4/F.TXT", false);
+}
+
+ECL_BENCH_OPTS(native_open_cached_d4, op_options)
+{
+    open_close("/n/D1/D2/D3/D4/F.TXT", true);
+}
+
+ECL_BENCH_OPTS(native_list_64, op_options)
+{
+    list("/n/LIST/");
+}
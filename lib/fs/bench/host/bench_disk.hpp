@@ -0,0 +1,72 @@
+#ifndef LIB_FS_BENCH_HOST_BENCH_DISK_HPP_
+#define LIB_FS_BENCH_HOST_BENCH_DISK_HPP_
+
+// Device under benchmark. On host it is a RAM disk, so the results
+// show the cost of filesystems alone. Image is built at startup.
+// Target projects provide own bench_disk.hpp, see lib/fs/CMakeLists.txt.
+
+#include "bench_image.hpp"
+
+#include <fs/ram_block.hpp>
+
+namespace fs_bench
+{
+
+// Smallest device that fits FAT32 with one sector per cluster
+constexpr size_t disk_blocks = 66664;
+
+using ram_disk = fs::ram_block< disk_blocks >;
+
+inline ram_disk &disk()
+{
+    static ram_disk d;
+    return d;
+}
+
+// Block device, given to filesystems. All instances share the RAM disk,
+// so the image is visible to every filesystem mounted over it.
+struct bench_disk
+{
+    int init() { return disk().init(); }
+    int open() { return disk().open(); }
+    int close() { return disk().close(); }
+
+    constexpr size_t get_block_length() { return volume::sector_size; }
+    size_t block_count() const { return disk().block_count(); }
+    constexpr size_t preferred_io_size() { return volume::sector_size; }
+
+    int read_blocks(size_t lba, uint8_t *buf, size_t n) { return disk().read_blocks(lba, buf, n); }
+    int write_blocks(size_t lba, const uint8_t *buf, size_t n) { return disk().write_blocks(lba, buf, n); }
+    int trim(size_t lba, size_t n) { return disk().trim(lba, n); }
+
+    const uint8_t *map_blocks(size_t lba, size_t n) const { return disk().map_blocks(lba, n); }
+};
+
+// Builds benchmark image. -1 if error, 0 otherwise.
+inline int prepare()
+{
+    static const volume::disk binding = {
+        &disk(),
+        [](void *obj, uint32_t lba, uint8_t *buf, size_t n) {
+            return static_cast< ram_disk* >(obj)->read_blocks(lba, buf, n);
+        },
+        [](void *obj, uint32_t lba, const uint8_t *buf, size_t n) {
+            return static_cast< ram_disk* >(obj)->write_blocks(lba, buf, n);
+        },
+        [](void *obj, uint32_t lba, size_t n) {
+            return static_cast< const ram_disk* >(obj)->map_blocks(lba, n);
+        },
+        nullptr,
+        nullptr,
+    };
+
+    disk().open();
+    auto rc = build(binding, disk_blocks);
+    disk().close();
+
+    return rc;
+}
+
+} // namespace fs_bench
+
+#endif // LIB_FS_BENCH_HOST_BENCH_DISK_HPP_
@@ -0,0 +1,103 @@
+#ifndef LIB_FS_BENCH_HOST_SD_BENCH_DISK_HPP_
+#define LIB_FS_BENCH_HOST_SD_BENCH_DISK_HPP_
+
+// Device under benchmark. It is SD card, emulated on host over SPI bus,
+// so the results show the cost of filesystems together with sd_spi and
+// generic bus, and profiles of the whole storage stack can be taken on host.
+// Card image is built at startup in the temp directory.
+//
+// Bus and card take no time by default. Set host_latency and
+// host_sd_timing in prepare() to model a real card, see platform/host.
+
+#include "bench_image.hpp"
+
+#include <dev/bus.hpp>
+#include <dev/sdspi.hpp>
+#include <platform/host_sd_card.hpp>
+
+#include <cstdlib>
+#include <string>
+
+namespace fs_bench
+{
+
+// SDHC capacity is a multiple of 1024 blocks. Smallest one
+// that fits FAT32 with one sector per cluster.
+constexpr size_t disk_blocks = 67584;
+
+constexpr auto sd_spi_dev = ecl::spi_device::bus_1;
+
+using sd_card = ecl::sd_spi< ecl::generic_bus< ecl::host_spi_bus< sd_spi_dev > >,
+                             ecl::host_spi_cs< sd_spi_dev >, 4 >;
+
+inline ecl::host_sd_card &card()
+{
+    static ecl::host_sd_card c;
+    return c;
+}
+
+inline sd_card &disk()
+{
+    static sd_card d;
+    return d;
+}
+
+// Block device, given to filesystems. All instances share the card,
+// so the image is visible to every filesystem mounted over it.
+struct bench_disk
+{
+    int init() { return disk().init(); }
+    int open() { return disk().open(); }
+    int close() { return disk().close(); }
+
+    constexpr size_t get_block_length() { return volume::sector_size; }
+    size_t block_count() const { return disk().block_count(); }
+    constexpr size_t preferred_io_size() { return volume::sector_size; }
+
+    int read_blocks(size_t lba, uint8_t *buf, size_t n) { return disk().read_blocks(lba, buf, n); }
+    int write_blocks(size_t lba, const uint8_t *buf, size_t n) { return disk().write_blocks(lba, buf, n); }
+    int trim(size_t lba, size_t n) { return disk().trim(lba, n); }
+};
+
+// Builds benchmark image. -1 if error, 0 otherwise.
+inline int prepare()
+{
+    static const volume::disk binding = {
+        &disk(),
+        [](void *obj, uint32_t lba, uint8_t *buf, size_t n) {
+            return static_cast< sd_card* >(obj)->read_blocks(lba, buf, n);
+        },
+        [](void *obj, uint32_t lba, const uint8_t *buf, size_t n) {
+            return static_cast< sd_card* >(obj)->write_blocks(lba, buf, n);
+        },
+        nullptr,
+        nullptr,
+        nullptr,
+    };
+
+    const char *tmp = getenv("TMPDIR");
+    std::string path = std::string{tmp ? tmp : "/tmp"} + "/fs_bench_sd.img";
+
+    if (ecl::is_error(card().open(path.c_str(), disk_blocks))) {
+        return -1;
+    }
+
+    ecl::host_spi_bus< sd_spi_dev >::attach(&card());
+
+    if (disk().init() < 0 || disk().open() < 0) {
+        return -1;
+    }
+
+    auto rc = build(binding, disk_blocks);
+
+    // Image must reach the card before filesystems read it
+    if (disk().close() < 0) {
+        return -1;
+    }
+
+    return rc;
+}
+
+} // namespace fs_bench
+
+#endif // LIB_FS_BENCH_HOST_SD_BENCH_DISK_HPP_
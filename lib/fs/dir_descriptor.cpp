@@ -1,6 +1,8 @@
 #include "fs/dir_descriptor.hpp"
 #include "fs/inode.hpp"
 
+#include <string.h>
+
 using namespace fs;
 
 dir_descriptor::dir_descriptor(const inode_weak &node)
@@ -15,3 +17,47 @@ dir_descriptor::~dir_descriptor()
 {
 }
 
+
+ssize_t dir_descriptor::readdir(dir_entry *out, size_t n)
+{
+    ecl_assert(out);
+
+    size_t cnt = 0;
+    inode_ptr next;
+
+    while (cnt < n && (next = this->next())) {
+        auto &e = out[cnt++];
+
+        e.type = next->get_type();
+        e.size = e.type == inode::type::file ? next->size() : 0;
+
+        if (next->get_name(e.name, sizeof(e.name)) < 0) {
+            return -1;
+        }
+    }
+
+    return cnt;
+}
+
+inode_ptr dir_descriptor::find(const name_view &name)
+{
+    ecl_assert(name.ptr);
+
+    char inode_name[max_name + 1];
+    inode_ptr next;
+
+    if (rewind() < 0) {
+        return inode_ptr{};
+    }
+
+    while ((next = this->next())) {
+        ssize_t ret = next->get_name(inode_name, sizeof(inode_name));
+
+        // Truncated names can't match
+        if (ret >= 0 && (size_t) ret < sizeof(inode_name) && same_name(name, inode_name)) {
+            return next;
+        }
+    }
+
+    return inode_ptr{};
+}
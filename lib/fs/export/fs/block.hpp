@@ -0,0 +1,164 @@
+#ifndef LIB_FS_BLOCK_HPP_
+#define LIB_FS_BLOCK_HPP_
+
+#include <sys/types.h>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace fs
+{
+
+// Block device interface, used by filesystems.
+// Block device is any class that provides following members:
+//
+//   int init();                 - lazy initialization, negative if error
+//   int open();                 - negative if error
+//   int close();                - negative if error
+//   size_t get_block_length();  - size of a block, in bytes
+//   size_t block_count();       - amount of blocks, 0 if device is not opened
+//   size_t preferred_io_size(); - preferred size of a request, in bytes
+//
+//   int read_blocks(size_t lba, uint8_t *buf, size_t n);
+//   int write_blocks(size_t lba, const uint8_t *buf, size_t n);
+//   int trim(size_t lba, size_t n);
+//
+// Block I/O functions operate on whole blocks and return negative value
+// if error or 0 otherwise. Requests past the last block are rejected.
+// Trimmed blocks have undefined content.
+//
+// Filesystems should issue whole-block requests, preferably grouped
+// into chunks of preferred_io_size().
+//
+// Memory-mapped devices (RAM disk, internal flash) additionally provide:
+//
+//   const uint8_t *map_blocks(size_t lba, size_t n); - nullptr if error
+//
+// It gives direct access to the device content, so filesystems can avoid
+// intermediate copies.
+//
+// Devices, that move data by DMA, may also split a read in two halves:
+//
+//   int read_start(size_t lba, uint8_t *buf, size_t n); - starts a read
+//   int read_finish();                                  - waits for it
+//
+// Caller can do other work while the read is in progress, but must not
+// issue other requests until read_finish() returns. Both return negative
+// value if error or 0 otherwise.
+//
+// Devices, that complete requests in background, may provide callback-based
+// I/O instead, i.e. SD card over SPI bus:
+//
+//   int read_blocks_async(size_t lba, uint8_t *buf, size_t n, const cb &done);
+//   int write_blocks_async(size_t lba, const uint8_t *buf, size_t n, const cb &done);
+//
+// Both return negative value if request is not started, 0 otherwise.
+// Callback receives status of the request, negative if error, and is likely
+// executed in ISR context. No other requests are allowed until it is invoked.
+
+// Run of consecutive blocks, i.e. part of a file
+struct extent
+{
+    size_t lba;     // First block
+    size_t blocks;  // Amount of blocks
+};
+
+namespace detail
+{
+
+template< class... >
+struct make_void
+{
+    using type = void;
+};
+
+template< class Block, class = void >
+struct block_device_check : std::false_type
+{
+};
+
+template< class Block >
+struct block_device_check< Block, typename make_void<
+        decltype(std::declval< Block& >().init()),
+        decltype(std::declval< Block& >().open()),
+        decltype(std::declval< Block& >().close()),
+        decltype(std::declval< Block& >().get_block_length()),
+        decltype(std::declval< Block& >().block_count()),
+        decltype(std::declval< Block& >().preferred_io_size()),
+        decltype(std::declval< Block& >().read_blocks(size_t{}, (uint8_t *) nullptr, size_t{})),
+        decltype(std::declval< Block& >().write_blocks(size_t{}, (const uint8_t *) nullptr, size_t{})),
+        decltype(std::declval< Block& >().trim(size_t{}, size_t{}))
+        >::type > : std::true_type
+{
+};
+
+template< class Block, class = void >
+struct mapped_device_check : std::false_type
+{
+};
+
+template< class Block >
+struct mapped_device_check< Block, typename make_void<
+        decltype(std::declval< const Block& >().map_blocks(size_t{}, size_t{}))
+        >::type > : std::true_type
+{
+};
+
+template< class Block, class = void >
+struct async_device_check : std::false_type
+{
+};
+
+template< class Block >
+struct async_device_check< Block, typename make_void<
+        decltype(std::declval< Block& >().read_start(size_t{}, (uint8_t *) nullptr, size_t{})),
+        decltype(std::declval< Block& >().read_finish())
+        >::type > : std::true_type
+{
+};
+
+template< class Block, class = void >
+struct callback_device_check : std::false_type
+{
+};
+
+template< class Block >
+struct callback_device_check< Block, typename make_void<
+        decltype(std::declval< Block& >().read_blocks_async(size_t{}, (uint8_t *) nullptr, size_t{},
+                                                            std::declval< void (*)(int) >())),
+        decltype(std::declval< Block& >().write_blocks_async(size_t{}, (const uint8_t *) nullptr, size_t{},
+                                                             std::declval< void (*)(int) >()))
+        >::type > : std::true_type
+{
+};
+
+} // namespace detail
+
+// Checks if given class conforms to the block device interface
+template< class Block >
+struct is_block_device : detail::block_device_check< Block >
+{
+};
+
+// Checks if given block device is memory-mapped
+template< class Block >
+struct is_mapped_device : detail::mapped_device_check< Block >
+{
+};
+
+// Checks if given block device can overlap reads with work of the caller
+template< class Block >
+struct is_async_device : detail::async_device_check< Block >
+{
+};
+
+// Checks if given block device completes requests in background
+template< class Block >
+struct is_callback_device : detail::callback_device_check< Block >
+{
+};
+
+}
+
+#endif // LIB_FS_BLOCK_HPP_
@@ -0,0 +1,144 @@
+#ifndef LIB_FS_DENTRY_CACHE_HPP_
+#define LIB_FS_DENTRY_CACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string.h>
+
+namespace fs
+{
+
+// Bounded cache of resolved paths. Each path is mapped to a node
+// (i.e. inode pointer), so repeated lookups of the same path do not scan
+// directories again. Least recently used entry is evicted when cache is full.
+// Paths are compared case-insensitively, in the same way as vfs matches names.
+// Paths longer than max_path are not cached.
+template< class Node, size_t entries = 8, size_t max_path = 48 >
+class dentry_cache
+{
+    static_assert(entries > 0, "Cache must hold at least one entry");
+
+public:
+    dentry_cache();
+
+    // Finds a node by path, empty node if path is not cached
+    Node find(const char *path);
+    // Stores a path and associated node
+    void insert(const char *path, const Node &node);
+    // Drops all entries. Must be called when directory layout is changed.
+    void invalidate();
+
+private:
+    // Case-insensitive FNV-1a hash. Gets a length of a string as well.
+    static uint32_t hash(const char *path, size_t &len);
+
+    static char to_lower(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+    }
+
+    static bool equal(const char *a, const char *b)
+    {
+        while (*a && to_lower(*a) == to_lower(*b)) {
+            a++;
+            b++;
+        }
+
+        return !*a && !*b;
+    }
+
+    struct dentry
+    {
+        uint32_t    hash;               // Hash of a path
+        uint32_t    used;               // Time of last access, 0 if entry is free
+        Node        node;               // Resolved node
+        char        path[max_path];     // Path itself, hash collisions are possible
+    };
+
+    dentry      m_entries[entries];
+    uint32_t    m_clock;
+};
+
+template< class Node, size_t entries, size_t max_path >
+dentry_cache< Node, entries, max_path >::dentry_cache()
+    :m_entries{}
+    ,m_clock{0}
+{
+}
+
+template< class Node, size_t entries, size_t max_path >
+Node dentry_cache< Node, entries, max_path >::find(const char *path)
+{
+    size_t len;
+    uint32_t h = hash(path, len);
+
+    if (len >= max_path) {
+        return Node{};
+    }
+
+    for (auto &e : m_entries) {
+        if (e.used && e.hash == h && equal(e.path, path)) {
+            e.used = ++m_clock;
+            return e.node;
+        }
+    }
+
+    return Node{};
+}
+
+template< class Node, size_t entries, size_t max_path >
+void dentry_cache< Node, entries, max_path >::insert(const char *path, const Node &node)
+{
+    size_t len;
+    uint32_t h = hash(path, len);
+
+    if (len >= max_path) {
+        return;
+    }
+
+    // Free entry is used first, otherwise least recently used one
+    auto victim = &m_entries[0];
+
+    for (auto &e : m_entries) {
+        if (e.used && e.hash == h && equal(e.path, path)) {
+            victim = &e;
+            break;
+        }
+
+        if (e.used < victim->used) {
+            victim = &e;
+        }
+    }
+
+    victim->hash = h;
+    victim->used = ++m_clock;
+    victim->node = node;
+    memcpy(victim->path, path, len + 1);
+}
+
+template< class Node, size_t entries, size_t max_path >
+void dentry_cache< Node, entries, max_path >::invalidate()
+{
+    for (auto &e : m_entries) {
+        // Releases a node as well
+        e.node = Node{};
+        e.used = 0;
+    }
+}
+
+template< class Node, size_t entries, size_t max_path >
+uint32_t dentry_cache< Node, entries, max_path >::hash(const char *path, size_t &len)
+{
+    uint32_t h = 2166136261u;
+
+    for (len = 0; path[len]; ++len) {
+        h ^= static_cast< uint8_t >(to_lower(path[len]));
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+}
+
+#endif // LIB_FS_DENTRY_CACHE_HPP_
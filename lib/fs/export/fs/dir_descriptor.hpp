@@ -3,7 +3,9 @@
 
 
 #include <ecl/memory.hpp>
+#include <sys/types.h>
 #include "types.hpp"
+#include "path.hpp"
 
 namespace fs
 {
@@ -18,6 +20,17 @@ public:
 	// Next entity in a dir
 	// nullptr returned if no more items
     virtual inode_ptr next() = 0;
+	// Reads up to n next entries into given array, without creating inodes
+	// when filesystem supports it. Lets listing of big dirs avoid
+	// allocation and virtual calls per entry.
+	// -1 if error, amount of entries read otherwise, 0 if no more items
+	virtual ssize_t readdir(dir_entry *out, size_t n);
+	// Finds an entity by name, case-insensitive. Position of a descriptor
+	// is not defined after the call. Filesystems are encouraged to override
+	// it and match raw dir entries, instead of creating inode for each.
+	// Name may be a segment of a path, it is not null-terminated then.
+	// nullptr returned if not found
+	virtual inode_ptr find(const name_view &name);
 	// Rewinds to the start of the dir
 	// -1 if error, 0 otherwise
 	virtual int rewind() = 0;
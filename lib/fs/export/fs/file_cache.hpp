@@ -0,0 +1,132 @@
+#ifndef LIB_FS_FILE_CACHE_HPP_
+#define LIB_FS_FILE_CACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fs
+{
+
+// Bounded table of recently opened files. Each node (i.e. inode pointer) is
+// mapped to a descriptor, opened for it. When the descriptor is no longer
+// referenced outside the table, it is reopened by the next open of the same
+// node, so neither allocation nor filesystem lookup is needed.
+// Table keeps descriptor alive, so one dropped without close() is not
+// destroyed, thus not closed by its destructor. Such descriptors must be
+// closed by close_unused() before new file is opened.
+// Descriptors in use are never evicted. If all entries are in use,
+// new descriptors are not cached. Least recently used one is evicted otherwise.
+template< class Node, class File, size_t entries = 4 >
+class file_cache
+{
+    static_assert(entries > 0, "Cache must hold at least one entry");
+
+public:
+    file_cache();
+
+    // Finds unused descriptor of a node and reopens it.
+    // Empty descriptor if there is none or it can't be reopened.
+    File revive(const Node &node);
+    // Stores a descriptor, opened for the node
+    void insert(const Node &node, const File &file);
+    // Closes descriptors, referenced only by the table. Data is flushed and
+    // filesystem resources are returned, but descriptors are still revivable.
+    void close_unused();
+    // Drops all entries. Must be called when nodes become stale.
+    void invalidate();
+
+private:
+    struct slot
+    {
+        uint32_t    used;   // Time of last access, 0 if slot is free
+        Node        node;   // Node, for which descriptor is opened
+        File        file;   // Descriptor itself
+    };
+
+    void release(slot &s)
+    {
+        s.used = 0;
+        s.node = Node{};
+        s.file = File{};
+    }
+
+    slot        m_slots[entries];
+    uint32_t    m_clock;
+};
+
+template< class Node, class File, size_t entries >
+file_cache< Node, File, entries >::file_cache()
+    :m_slots{}
+    ,m_clock{0}
+{
+}
+
+template< class Node, class File, size_t entries >
+File file_cache< Node, File, entries >::revive(const Node &node)
+{
+    for (auto &s : m_slots) {
+        // Only the table refers to unused descriptor
+        if (!s.used || s.node.get() != node.get() || !s.file.unique()) {
+            continue;
+        }
+
+        if (s.file->reopen() < 0) {
+            release(s);
+            return File{};
+        }
+
+        s.used = ++m_clock;
+        return s.file;
+    }
+
+    return File{};
+}
+
+template< class Node, class File, size_t entries >
+void file_cache< Node, File, entries >::insert(const Node &node, const File &file)
+{
+    slot *victim = nullptr;
+
+    // Free slot is used first, otherwise least recently used unused one
+    for (auto &s : m_slots) {
+        if (s.used && !s.file.unique()) {
+            continue;
+        }
+
+        if (!victim || s.used < victim->used) {
+            victim = &s;
+        }
+    }
+
+    if (!victim) {
+        return;
+    }
+
+    victim->used = ++m_clock;
+    victim->node = node;
+    victim->file = file;
+}
+
+template< class Node, class File, size_t entries >
+void file_cache< Node, File, entries >::close_unused()
+{
+    for (auto &s : m_slots) {
+        // Closing already closed descriptor is harmless
+        if (s.used && s.file.unique()) {
+            s.file->close();
+        }
+    }
+}
+
+template< class Node, class File, size_t entries >
+void file_cache< Node, File, entries >::invalidate()
+{
+    for (auto &s : m_slots) {
+        // Releases a descriptor as well
+        release(s);
+    }
+}
+
+}
+
+#endif // LIB_FS_FILE_CACHE_HPP_
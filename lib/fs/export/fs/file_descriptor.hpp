@@ -3,6 +3,8 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <ecl/iovec.hpp>
 #include <sys/io.hpp>
 #include <sys/types.h>
 
@@ -14,14 +16,45 @@ namespace fs
 class file_descriptor
 {
 public:
+    // Completion callback of async file I/O. Receives the same value,
+    // that read() or write() would return.
+    using io_callback = std::function< void(ssize_t result) >;
+
     file_descriptor(const inode_weak &node);
 	virtual ~file_descriptor();
 
     virtual ssize_t read(uint8_t *buf, size_t size) = 0;
     virtual ssize_t write(const uint8_t *buf, size_t size) = 0;
+    // Reads or writes few buffers back-to-back, as if buffers were a single
+    // one, i.e. a header and a body. Stops at the first short transfer.
+    // Returns total amount of bytes moved, -1 if nothing is moved due to
+    // an error. By default, each buffer is passed to read() or write(),
+    // so whole sectors of each buffer still go to the device in one
+    // multi-block request.
+    virtual ssize_t readv(const ecl::iovec *iov, size_t n);
+    virtual ssize_t writev(const ecl::iovec *iov, size_t n);
+    // Starts reading or writing in background. Callback is invoked when
+    // data is transferred and position is moved, likely from ISR context.
+    // Buffer must stay valid and no other I/O is allowed on the filesystem
+    // until that moment. Negative if not started, in such case callback
+    // is not invoked. By default, I/O is done in place by read() or write()
+    // and callback is invoked before return.
+    virtual int read_async(uint8_t *buf, size_t size, const io_callback &cb);
+    virtual int write_async(const uint8_t *buf, size_t size, const io_callback &cb);
     virtual int seek(off_t offt, seekdir way = seekdir::beg) = 0;
     virtual off_t tell() = 0;
     virtual int close() = 0;
+    // Opens the same file again, with position at the start. Descriptor,
+    // that is not closed yet, is closed first. Lets a closed descriptor be
+    // reused instead of allocating a new one, see fs/file_cache.hpp.
+    // -1 if filesystem doesn't support it or error, 0 otherwise.
+    virtual int reopen();
+    // Gives direct access to a part of a file, without moving a position.
+    // Pointer refers to device memory if file resides on memory-mapped
+    // device, or to a buffer, filled by the filesystem, otherwise.
+    // Pointer is valid until next map(), write() or close().
+    // nullptr if filesystem doesn't support mapping or range is invalid.
+    virtual const uint8_t *map(off_t offt, size_t len);
 
 protected:
 	// Associated inode
@@ -2,9 +2,17 @@
 #define LIB_FS_FS_HPP_
 
 #include "fs_descriptor.hpp"
-
+#include "dentry_cache.hpp"
+#include "file_cache.hpp"
+#include "mount_table.hpp"
+#include "inode.hpp"
+#include "path.hpp"
+
+#include <algorithm>
+#include <string.h>
 #include <tuple>
 #include <ecl/utils.hpp>
+#include <ecl/iostream.hpp>
 
 namespace fs
 {
@@ -12,108 +20,31 @@ namespace fs
 template< class ...Fs >
 class vfs
 {
+    static_assert(sizeof...(Fs) > 0, "At least one filesystem must be given");
+
 public:
     vfs();
     ~vfs();
 
     int mount_all();
 
+    // Descriptors of recently opened files are reused, once all references
+    // to them are dropped. Reused descriptor is reopened at the start of a file.
+    // Descriptor, dropped without close(), is closed by the next open_file()
+    // or invalidate(). Call close() to get data to the device right away.
     file_ptr open_file(const char *path);
     dir_ptr  open_dir(const char *path);
 
+    // Drops cached path lookups and descriptors. Must be called after
+    // entries are created, removed or renamed bypassing vfs.
+    void invalidate();
+
     /* TODO:
      copy(), create_dir(), rename(), remove(), move()
      */
 
 
 private:
-    // TODO: convert it to generic-purpose class
-    class path_iter
-    {
-    public:
-        path_iter(const char *path)
-            :path{path}
-            ,path_len{strlen(path)}
-            ,cur{0}
-            ,component{0}
-        {
-        }
-
-
-        // Get next path token
-        const char* next(inode::type &next_type)
-        {
-            size_t len;
-            inode::type expected;
-
-
-            // Find a start of the segment
-            while (path[cur] == '/') {
-                cur++;
-            }
-
-            if (cur == path_len)
-                return nullptr;
-
-            const char *p = strchr(path + cur, '/');
-
-            // TODO: compact this
-            if (p) {
-                len = p - (path + cur);
-                // Dir is found in path
-                if (len >= 16) {
-                    // Name is too long
-                    // TODO: fix it
-                    ecl_assert(0);
-                } else {
-                    std::copy(path + cur, p, component);
-                    component[len] = 0;
-                }
-
-                // Skip following '/'
-                cur += len;
-                expected = inode::type::dir;
-
-            } else {
-                // File is found in the path
-                len = path_len - cur;
-
-                if (len >= 16) {
-                    // Name is too long
-                    // TODO: fix it
-                    ecl_assert(0);
-                } else {
-                    std::copy(path + cur, path + cur + len, component);
-                    component[len] = 0;
-                }
-
-                cur += len;
-
-                expected = inode::type::file;
-            }
-
-            next_type = expected;
-            return component;
-        }
-
-        // Obvious
-        size_t get_cur_idx() const
-        {
-            return cur;
-        }
-
-        size_t get_len() const
-        {
-            return path_len;
-        }
-
-    private:
-        const char  *path;
-        size_t      path_len;
-        size_t      cur;
-        char        component[16]; // TODO: clarify size
-    };
-
     // Get root node by the path to its element.
     // It changes the path pointer so it will point to the root
     // of a filesystem.
@@ -122,15 +53,24 @@ private:
     // Resolves path to inode
     auto path_to_inode(const char *path);
     // Resolves the name of item in current dir to the inode
-    auto name_to_inode(inode_ptr cur_dir, const char *name);
+    auto name_to_inode(inode_ptr cur_dir, const name_view &name);
 
     std::tuple< Fs... > m_fses;
+    // Roots of mounted filesystems, in order of declaration
+    inode_ptr           m_roots[sizeof...(Fs)];
+    // Recently resolved paths
+    dentry_cache< inode_ptr > m_dentries;
+    // Recently opened files
+    file_cache< inode_ptr, file_ptr > m_files;
 };
 
 
 template< class ...Fs >
 vfs< Fs... >::vfs()
     :m_fses{}
+    ,m_roots{}
+    ,m_dentries{}
+    ,m_files{}
 {
 }
 
@@ -142,12 +82,19 @@ vfs< Fs... >::~vfs()
 template< class ...Fs >
 int vfs< Fs... >::mount_all()
 {
-    auto mounter = [](auto &fs) {
+    size_t i = 0;
+
+    auto mounter = [this, &i](auto &fs) {
          fs.mount();
+         m_roots[i++] = fs.get_root();
     };
 
     ecl::for_each(m_fses, mounter);
 
+    // Roots are changed
+    m_dentries.invalidate();
+    m_files.invalidate();
+
     return 0;
 }
 
@@ -163,7 +110,21 @@ file_ptr vfs< Fs... >::open_file(const char *path)
         return nullptr;
     }
 
-    return node->open();
+    // Descriptors dropped without close() still hold filesystem resources,
+    // i.e. a slot counted against max_files, and unflushed data
+    m_files.close_unused();
+
+    auto fd = m_files.revive(node);
+    if (fd) {
+        return fd;
+    }
+
+    fd = node->open();
+    if (fd) {
+        m_files.insert(node, fd);
+    }
+
+    return fd;
 }
 
 template< class ...Fs >
@@ -180,6 +141,13 @@ dir_ptr vfs< Fs... >::open_dir(const char *path)
     return node->open_dir();
 }
 
+template< class ...Fs >
+void vfs< Fs... >::invalidate()
+{
+    m_dentries.invalidate();
+    m_files.invalidate();
+}
+
 //------------------------------------------------------------------------------
 
 template< class ...Fs >
@@ -187,67 +155,41 @@ auto vfs< Fs... >::get_root_node(const char *&path)
 {
     ecl_assert(path);
 
-    inode_ptr root;
-    size_t last_match = 0;
-
-    // Picks most appropriate inode
-    auto fn = [&root, &last_match, path](auto &fs) {
-        constexpr const char *mnt_point = fs.mnt_point;
+    // Mount points are known at compile time, so are sorted once
+    static constexpr auto table = make_mount_table< Fs... >();
 
-        // Iterate over two paths, trying to find best match
-
-        auto dummy_type = inode::type::dir;
-        path_iter m{mnt_point};
-        path_iter p{path};
-
-        const char *mnt_seg;
-        const char *path_seg;
-
-        while ((mnt_seg = m.next(dummy_type)) && (path_seg = p.next(dummy_type))) {
-            // TODO: most of FSes are case sensitive.
-            // This must be optionally be supported by checking special flags
-            if (strcmpi(mnt_seg, path_seg)) {
-                // Token mismatch
-                break;
-            }
-        }
-
-        // Whole mount path was iterated, meaning that it
-        // can be a possible match
-        if (!mnt_seg) {
-            // An incoming path can contain multiple slashes
-            // thus current index must be taken from it rather than from
-            // a mount point.
-            auto match = p.get_cur_idx();
-
-            // Check if it is a better match.
-            if (match > last_match) {
-                root = fs.get_root();
-                last_match = match;
-            }
-        }
-    };
-
-    ecl::for_each(m_fses, fn);
-
-    // Properly advance a path
-    path += last_match;
+    auto idx = table.resolve(path);
+    if (idx == sizeof...(Fs)) {
+        return inode_ptr{};
+    }
 
-    return root;
+    return m_roots[idx];
 }
 
 template< class ...Fs >
 auto vfs< Fs... >::path_to_inode(const char *path)
 {
     ecl_assert(path);
+
+    auto cached = m_dentries.find(path);
+    if (cached) {
+        return cached;
+    }
+
+    const char *full_path = path;
     auto root = get_root_node(path);
-    ecl_assert(root);
+    if (!root) {
+        // Not mounted
+        return inode_ptr{nullptr};
+    }
 
-    path_iter iter{path};
-    const char *part;
-    inode::type type;
+    // Segments are matched in place, without copying
+    path_tokenizer iter{path};
+    name_view part{path, 0};
+    bool is_dir;
 
-    while ((part = iter.next(type))) {
+    while (iter.next(part, is_dir)) {
+        auto type = is_dir ? inode::type::dir : inode::type::file;
         auto next = name_to_inode(root, part);
 
         if (!next) {
@@ -269,45 +211,31 @@ auto vfs< Fs... >::path_to_inode(const char *path)
             break;
     }
 
+    if (iter.overflow()) {
+        return inode_ptr{nullptr};
+    }
+
+    m_dentries.insert(full_path, root);
     return root;
 }
 
 template< class ...Fs >
-auto vfs< Fs... >::name_to_inode(inode_ptr cur_dir, const char *name)
+auto vfs< Fs... >::name_to_inode(inode_ptr cur_dir, const name_view &name)
 {
     ecl_assert(cur_dir);
-    ecl_assert(name);
+    ecl_assert(name.ptr);
     ecl_assert(cur_dir->get_type() == inode::type::dir);
 
     auto dd = cur_dir->open_dir();
-    char inode_name[16]; // TODO: Clarify size
-
-    // Iterate over directory and try to find proper item
-    inode_ptr next;
-    while (next = dd->next()) {
-        ssize_t ret;
-        ret = next->get_name(inode_name, sizeof(inode_name));
-
-        if (ret < 0) {
-            // Error occur
-            return inode_ptr{nullptr};
-        }
-
-        if ((size_t) ret >= sizeof(inode_name)) {
-            // Name is too long
-            ecl_assert(0);
-        }
-
-        // TODO: most of FSes are case sensitive.
-        // This must be optionally be supported by checking special flags
-        if (!strcmpi(inode_name, name)) {
-            // Item found!
-            return next;
-        }
+    if (!dd) {
+        return inode_ptr{nullptr};
     }
 
+    // Filesystem matches the name on its own
+    auto next = dd->find(name);
+    dd->close();
 
-    return inode_ptr{nullptr};
+    return next;
 }
 
 }
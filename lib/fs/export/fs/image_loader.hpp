@@ -0,0 +1,256 @@
+#ifndef LIB_FS_IMAGE_LOADER_HPP_
+#define LIB_FS_IMAGE_LOADER_HPP_
+
+// Loading of firmware images from block devices into flash, i.e. by
+// a bootloader. Image is given as extents of device blocks, so it is read
+// by multi-block requests, and each chunk is hashed and programmed while
+// the next one is read by the device:
+//
+//   fs::extent ext[8];
+//   size_t size;
+//   auto n = fat.map_file("/FW.BIN", ext, 8, size);
+//
+//   ecl::hw_hash< ecl::crypto::hash_algo::sha256 > h;
+//   fs::image_loader< ecl::flash_sectors< 5, 3 > > loader;
+//   loader.load(fat.device(), ext, n, size, h);
+//   h.finish(digest);
+//
+// Flash is any class with flash sectors interface of ecl::kv_store.
+// Reads overlap with hashing and programming only on devices, that
+// support split reads, see fs/block.hpp. On other devices the same
+// steps are done one after another.
+
+#include "fs/block.hpp"
+
+#include <ecl/err.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sys/types.h>
+#include <type_traits>
+
+namespace fs
+{
+
+// Loads images into flash sectors, starting from the first one.
+// Loader holds two chunk buffers, so place it in static storage.
+// Chunk buffers must be reachable by DMA of both the device and the digest.
+template< class Flash, size_t chunk_blocks = 8 >
+class image_loader
+{
+    static_assert(chunk_blocks > 0, "Chunk must hold at least one block");
+    static_assert(Flash::sector_size % 4 == 0, "Flash is programmed by words");
+
+public:
+    static constexpr size_t block_len   = 512;
+    static constexpr size_t chunk_size  = chunk_blocks * block_len;
+    static constexpr size_t capacity    = Flash::sectors * Flash::sector_size;
+
+    // Reads image from extents of the device, passes it to the digest and
+    // programs it into flash. Sectors are erased as the image reaches them,
+    // the rest of flash is left intact. Programmed data is verified by
+    // reading it back. Digest is neither reset, nor finished, so the caller
+    // can hash a header before the image and compare the result after.
+    // Gives size of the image, or -1 if error. Flash content is undefined
+    // after an error.
+    template< class Block, class Digest >
+    ssize_t load(Block &dev, const extent *ext, size_t count, size_t size, Digest &h);
+
+private:
+    // Position of the next read
+    struct cursor
+    {
+        const extent    *ext;
+        size_t          left;   // Extents left
+        size_t          block;  // Block in the current extent
+    };
+
+    // Takes next chunk of the image. Gives amount of blocks, 0 at the end
+    static size_t next(cursor &c, size_t &lba);
+
+    template< class Block >
+    int read_start(Block &dev, size_t lba, uint8_t *buf, size_t n, std::true_type async);
+    template< class Block >
+    int read_start(Block &dev, size_t lba, uint8_t *buf, size_t n, std::false_type async);
+    template< class Block >
+    int read_finish(Block &dev, std::true_type async);
+    template< class Block >
+    int read_finish(Block &dev, std::false_type async);
+
+    // Programs a chunk at given image offset, erasing sectors it enters
+    static int program(size_t offt, uint8_t *data, size_t len);
+
+    alignas(4) uint8_t  m_buf[2][chunk_size];
+
+    // Postponed read of a device without split reads
+    size_t              m_lba = 0;
+    uint8_t             *m_dst = nullptr;
+    size_t              m_blocks = 0;
+};
+
+//------------------------------------------------------------------------------
+
+template< class Flash, size_t chunk_blocks >
+template< class Block, class Digest >
+ssize_t image_loader< Flash, chunk_blocks >::load(Block &dev, const extent *ext, size_t count,
+                                                  size_t size, Digest &h)
+{
+    using async = is_async_device< Block >;
+
+    if (!size || size > capacity || dev.get_block_length() != block_len) {
+        return -1;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += ext[i].blocks;
+    }
+
+    if (total < (size + block_len - 1) / block_len) {
+        return -1;
+    }
+
+    cursor c{ext, count, 0};
+    size_t lba;
+    size_t n = next(c, lba);
+    size_t offt = 0;
+    int cur = 0;
+    int rc = read_start(dev, lba, m_buf[cur], n, async{});
+
+    while (rc == 0) {
+        rc = read_finish(dev, async{});
+        if (rc < 0) {
+            break;
+        }
+
+        size_t len = n * block_len < size - offt ? n * block_len : size - offt;
+
+        // Next chunk is read while this one is processed
+        if (offt + len < size) {
+            n = next(c, lba);
+            rc = read_start(dev, lba, m_buf[cur ^ 1], n, async{});
+            if (rc < 0) {
+                break;
+            }
+        }
+
+        h.update(m_buf[cur], len);
+
+        if (program(offt, m_buf[cur], len) < 0) {
+            if (offt + len < size) {
+                read_finish(dev, async{});
+            }
+
+            return -1;
+        }
+
+        offt += len;
+        cur ^= 1;
+
+        if (offt == size) {
+            return size;
+        }
+    }
+
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< class Flash, size_t chunk_blocks >
+size_t image_loader< Flash, chunk_blocks >::next(cursor &c, size_t &lba)
+{
+    while (c.left && c.block == c.ext->blocks) {
+        c.ext++;
+        c.left--;
+        c.block = 0;
+    }
+
+    if (!c.left) {
+        return 0;
+    }
+
+    size_t n = c.ext->blocks - c.block < chunk_blocks ? c.ext->blocks - c.block : chunk_blocks;
+
+    lba = c.ext->lba + c.block;
+    c.block += n;
+
+    return n;
+}
+
+template< class Flash, size_t chunk_blocks >
+template< class Block >
+int image_loader< Flash, chunk_blocks >::read_start(Block &dev, size_t lba, uint8_t *buf,
+                                                    size_t n, std::true_type async)
+{
+    (void) async;
+    return dev.read_start(lba, buf, n);
+}
+
+template< class Flash, size_t chunk_blocks >
+template< class Block >
+int image_loader< Flash, chunk_blocks >::read_start(Block &dev, size_t lba, uint8_t *buf,
+                                                    size_t n, std::false_type async)
+{
+    (void) dev;
+    (void) async;
+
+    m_lba = lba;
+    m_dst = buf;
+    m_blocks = n;
+
+    return 0;
+}
+
+template< class Flash, size_t chunk_blocks >
+template< class Block >
+int image_loader< Flash, chunk_blocks >::read_finish(Block &dev, std::true_type async)
+{
+    (void) async;
+    return dev.read_finish();
+}
+
+template< class Flash, size_t chunk_blocks >
+template< class Block >
+int image_loader< Flash, chunk_blocks >::read_finish(Block &dev, std::false_type async)
+{
+    (void) async;
+    return dev.read_blocks(m_lba, m_dst, m_blocks);
+}
+
+template< class Flash, size_t chunk_blocks >
+int image_loader< Flash, chunk_blocks >::program(size_t offt, uint8_t *data, size_t len)
+{
+    // Tail of the image is padded to a word with erased flash value
+    size_t padded = (len + 3) & ~static_cast< size_t >(3);
+    memset(data + len, 0xff, padded - len);
+
+    while (padded) {
+        size_t sector = offt / Flash::sector_size;
+        size_t at = offt % Flash::sector_size;
+        size_t n = Flash::sector_size - at < padded ? Flash::sector_size - at : padded;
+
+        if (!at && ecl::is_error(Flash::erase(sector))) {
+            return -1;
+        }
+
+        auto words = reinterpret_cast< const uint32_t * >(data);
+
+        if (ecl::is_error(Flash::program(sector, at, words, n / 4))
+                || memcmp(Flash::map(sector) + at, data, n)) {
+            return -1;
+        }
+
+        offt += n;
+        data += n;
+        padded -= n;
+    }
+
+    return 0;
+}
+
+}
+
+#endif // LIB_FS_IMAGE_LOADER_HPP_
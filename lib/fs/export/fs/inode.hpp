@@ -32,13 +32,17 @@ public:
     // If truncation occur then it will return amount bytes that would have
     // been written if enough space had been avaliable.
     virtual ssize_t get_name(char *buf, size_t buf_sz) const = 0;
+    // Creates a file or a dir with given name inside this dir. Returns
+    // an inode of created entity or nullptr if inode is not a dir,
+    // entity exists or filesystem doesn't support creation.
+    virtual inode_ptr create(const char *name, type t);
     // Assigns weak reference, so it can pass to descriptors, when they are
     // created using open() and open_dir() methods.
     int set_weak(const fs::inode_ptr &ptr);
 
     /*
      TODO:
-     declare move(), copy(), create() and delete() operations
+     declare move(), copy() and delete() operations
 	 */
 protected:
     // Allows to pass this reference to a dir descriptor without increasing
@@ -49,6 +53,14 @@ protected:
 // TODO: move it somewhere
 using inode_ptr = ecl::shared_ptr< inode >;
 
+// Plain description of a dir entry, filled by dir_descriptor::readdir()
+struct dir_entry
+{
+    char        name[max_name + 1]; // Null-terminated name
+    size_t      size;               // Size of a file, 0 for dirs
+    inode::type type;               // Type of an entity
+};
+
 
 }
 
@@ -0,0 +1,700 @@
+#ifndef LIB_FS_LOG_STORE_HPP_
+#define LIB_FS_LOG_STORE_HPP_
+
+#include <ecl/crc.hpp>
+#include <ecl/result.hpp>
+
+#include <sys/types.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string.h>
+
+#include "block.hpp"
+
+namespace fs
+{
+
+// Append-only record log over a block device, see fs/block.hpp.
+//
+// Device is split into segments, used round-robin: when the last one is
+// full, the oldest one is erased and reused. First block of a segment holds
+// its header with a sequence number, the rest holds records:
+//
+//   length (2 bytes) | CRC-16 (2 bytes) | payload (length bytes)
+//
+// CRC covers segment sequence number, length and payload, so records left
+// from previous use of the segment are never taken as valid. Record with
+// zero length pads the rest of a block, as well as less than 4 bytes left
+// in a block do. Records may span adjacent blocks.
+//
+// Records are collected in RAM and written in batches of whole blocks.
+// Written blocks are never rewritten until their segment is reused:
+// sync() pads current block, so records appended after it start from the
+// next block. Thus only records appended after last sync() are lost
+// on power failure.
+//
+// Mount scans segment headers and records of the newest segment. Scan
+// stops at the first invalid record, after checking the next block, since
+// torn record of interrupted batch may precede records appended after
+// recovery.
+//
+// Device must not be shared with other users, since blocks are cached.
+template< class Block, size_t segment_blocks = 64, size_t batch = 8, size_t block_len = 512 >
+class log_store
+{
+    static_assert(is_block_device< Block >::value, "Block device is required");
+    static_assert(segment_blocks >= 2, "Segment must hold at least one data block");
+    static_assert(batch >= 1 && batch < segment_blocks, "Invalid batch size");
+    static_assert(block_len >= 32 && block_len <= 0x8000, "Invalid block length");
+
+public:
+    enum : size_t
+    {
+        record_header   = 4,
+        // Longest record, so each one fits into two adjacent blocks
+        max_record      = block_len - record_header,
+    };
+
+    // Position of a record within the log
+    struct cursor
+    {
+        uint32_t seq;       // Sequence number of a segment
+        uint32_t offset;    // Offset within data blocks of the segment
+    };
+
+    log_store(Block &dev);
+    ~log_store();
+
+    // Writes empty log, destroying device content. Store must not be mounted.
+    // Negative value if error, 0 otherwise.
+    int format();
+
+    // Opens the device and finds the end of the log.
+    // Negative value if error or device holds no log, 0 otherwise.
+    int mount();
+
+    // Syncs and closes the device. Negative value if error, 0 otherwise.
+    int unmount();
+
+    // Appends a record. Record is written when batch is full, or by sync().
+    // Negative value if error, 0 otherwise. After device failure, store is
+    // unmounted and has to be mounted again.
+    int append(const uint8_t *data, size_t size);
+
+    // Writes appended records to the device.
+    // Negative value if error, 0 otherwise.
+    int sync();
+
+    // Gets cursor, pointing to the oldest record
+    cursor begin() const;
+
+    // Reads a record, written to the device, and advances the cursor.
+    // If records at cursor position were overwritten, it is moved to the
+    // oldest record. Gives length of the record, 0 at the end of the log,
+    // err::msgsize if buffer is too small, keeping the cursor, or err::io.
+    ecl::result< size_t > read(cursor &c, uint8_t *buf, size_t size);
+
+    // Gets amount of segments, 0 if store is not mounted
+    size_t segment_count() const;
+
+private:
+    enum : size_t
+    {
+        data_blocks     = segment_blocks - 1,
+        data_size       = data_blocks * block_len,
+    };
+
+    static constexpr uint32_t magic = 0x53474f4c; // "LOGS"
+
+    // Gets first block of a segment
+    size_t segment_lba(size_t seg) const;
+    // Gets segment of given sequence number
+    size_t segment_of(uint32_t seq) const;
+    // Checks header of a segment. Negative value if it is invalid.
+    int read_header(size_t seg, uint32_t &seq);
+    // Writes header of a segment, erasing its data blocks
+    int start_segment(size_t seg, uint32_t seq);
+    // Syncs current segment and starts the next one
+    int roll();
+
+    // Copies bytes to the batch, writing it if full
+    int put(const uint8_t *data, size_t size);
+    // Writes n blocks of the batch
+    int write_batch(size_t n);
+
+    // Gets a block through the cache, nullptr if error
+    const uint8_t *load(size_t lba);
+    // Reads bytes of segment data blocks
+    int read_data(size_t seg, size_t offset, uint8_t *dst, size_t size);
+    // Checks a record at given offset, copying payload if buffer is given.
+    // Returns offset of the next record, or negative value if record
+    // is invalid, or -2 if buffer is too small.
+    ssize_t check(size_t seg, uint32_t seq, size_t offset, size_t &len,
+                  uint8_t *buf, size_t size);
+    // Finds a record, starting from given offset and not going past limit.
+    // Padding and single invalid block are skipped.
+    // Returns offset of the record, or negative value if none is found.
+    ssize_t find(size_t seg, uint32_t seq, size_t offset, size_t limit, size_t &len,
+                 size_t &next, uint8_t *buf, size_t size);
+
+    // Starts CRC of a record
+    static uint16_t crc_start(uint32_t seq, uint16_t len);
+    // Rounds offset up to block boundary
+    static size_t next_block(size_t offset);
+
+    static void put_le(uint8_t *p, uint32_t v, size_t n);
+    static uint32_t get_le(const uint8_t *p, size_t n);
+
+    Block       &m_dev;                     // Block device
+    bool        m_mounted;                  // Store is mounted
+    size_t      m_count;                    // Amount of segments
+    size_t      m_seg;                      // Segment being written
+    uint32_t    m_seq;                      // Its sequence number
+    uint32_t    m_oldest;                   // Sequence of the oldest segment
+    size_t      m_batch_block;              // First data block of the batch
+    size_t      m_batch_len;                // Bytes in the batch
+    uint8_t     m_batch[batch * block_len]; // Records to write
+    size_t      m_cache_lba;                // Cached block, or SIZE_MAX
+    uint8_t     m_cache[block_len];         // Block, used by reads
+};
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+constexpr uint32_t log_store< Block, segment_blocks, batch, block_len >::magic;
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+log_store< Block, segment_blocks, batch, block_len >::log_store(Block &dev)
+    :m_dev{dev}
+    ,m_mounted{false}
+    ,m_count{0}
+    ,m_seg{0}
+    ,m_seq{0}
+    ,m_oldest{0}
+    ,m_batch_block{0}
+    ,m_batch_len{0}
+    ,m_batch{}
+    ,m_cache_lba{SIZE_MAX}
+    ,m_cache{}
+{
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+log_store< Block, segment_blocks, batch, block_len >::~log_store()
+{
+    unmount();
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+int log_store< Block, segment_blocks, batch, block_len >::format()
+{
+    if (m_mounted || m_dev.init() < 0 || m_dev.open() < 0) {
+        return -1;
+    }
+
+    int rc = -1;
+    size_t count = m_dev.get_block_length() == block_len
+                 ? m_dev.block_count() / segment_blocks : 0;
+
+    if (count) {
+        // Stale headers would be taken as valid ones. Batch is not used
+        // until mount, so it serves as a zeroed block.
+        memset(m_batch, 0, block_len);
+        rc = 0;
+
+        for (size_t seg = 1; seg < count && !rc; ++seg) {
+            rc = m_dev.write_blocks(segment_lba(seg), m_batch, 1);
+        }
+
+        rc = rc < 0 ? rc : start_segment(0, 1);
+    }
+
+    m_cache_lba = SIZE_MAX;
+    m_dev.close();
+    return rc < 0 ? -1 : 0;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+int log_store< Block, segment_blocks, batch, block_len >::mount()
+{
+    if (m_mounted || m_dev.init() < 0 || m_dev.open() < 0) {
+        return -1;
+    }
+
+    m_count = m_dev.get_block_length() == block_len
+            ? m_dev.block_count() / segment_blocks : 0;
+    m_cache_lba = SIZE_MAX;
+
+    size_t head = 0;
+    uint32_t head_seq = 0;
+
+    for (size_t seg = 0; seg < m_count; ++seg) {
+        uint32_t seq;
+        if (read_header(seg, seq) == 0 && seq > head_seq) {
+            head = seg;
+            head_seq = seq;
+        }
+    }
+
+    if (!head_seq) {
+        m_count = 0;
+        m_dev.close();
+        return -1;
+    }
+
+    m_seg = head;
+    m_seq = head_seq;
+
+    // Segments older than the oldest valid one are missing or reused
+    m_oldest = m_seq;
+    while (m_oldest > 1 && m_seq - m_oldest + 1 < m_count) {
+        uint32_t seq;
+        if (read_header(segment_of(m_oldest - 1), seq) < 0 || seq != m_oldest - 1) {
+            break;
+        }
+
+        --m_oldest;
+    }
+
+    // End of the log is after the last valid record
+    size_t offset = 0;
+    size_t len;
+    size_t next;
+
+    while (find(m_seg, m_seq, offset, data_size, len, next, nullptr, 0) >= 0) {
+        offset = next;
+    }
+
+    // Torn record may be there, it is never overwritten
+    m_batch_block = next_block(offset) / block_len;
+    m_batch_len = 0;
+    m_mounted = true;
+
+    return 0;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+int log_store< Block, segment_blocks, batch, block_len >::unmount()
+{
+    if (!m_mounted) {
+        return -1;
+    }
+
+    int rc = sync();
+
+    m_mounted = false;
+    m_count = 0;
+    m_dev.close();
+
+    return rc;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+int log_store< Block, segment_blocks, batch, block_len >::append(const uint8_t *data, size_t size)
+{
+    if (!m_mounted || !data || !size || size > max_record) {
+        return -1;
+    }
+
+    size_t offset = m_batch_block * block_len + m_batch_len;
+
+    // Header doesn't fit into the block, it is a padding
+    if (next_block(offset) - offset < record_header) {
+        offset = next_block(offset);
+    }
+
+    if (offset + record_header + size > data_size && roll() < 0) {
+        return -1;
+    }
+
+    // Padding is added by put(), since batch may end there
+    uint8_t zero[record_header] = {};
+    offset = m_batch_block * block_len + m_batch_len;
+    if (next_block(offset) - offset < record_header
+            && put(zero, next_block(offset) - offset) < 0) {
+        return -1;
+    }
+
+    uint8_t header[record_header];
+    put_le(header, size, 2);
+    put_le(header + 2, ecl::crc16(data, size, crc_start(m_seq, size)), 2);
+
+    if (put(header, sizeof(header)) < 0 || put(data, size) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+int log_store< Block, segment_blocks, batch, block_len >::sync()
+{
+    if (!m_mounted) {
+        return -1;
+    }
+
+    if (!m_batch_len) {
+        return 0;
+    }
+
+    size_t tail = next_block(m_batch_len) - m_batch_len;
+
+    if (tail) {
+        memset(m_batch + m_batch_len, 0, tail);
+
+        if (tail >= record_header) {
+            put_le(m_batch + m_batch_len + 2, crc_start(m_seq, 0), 2);
+        }
+    }
+
+    return write_batch(next_block(m_batch_len) / block_len);
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+typename log_store< Block, segment_blocks, batch, block_len >::cursor
+log_store< Block, segment_blocks, batch, block_len >::begin() const
+{
+    return cursor{m_oldest, 0};
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+ecl::result< size_t > log_store< Block, segment_blocks, batch, block_len >::read(cursor &c,
+                                                                                  uint8_t *buf,
+                                                                                  size_t size)
+{
+    if (!m_mounted || !buf) {
+        return ecl::err::inval;
+    }
+
+    if (c.seq < m_oldest) {
+        c = begin();
+    }
+
+    while (c.seq <= m_seq) {
+        size_t seg = segment_of(c.seq);
+        uint32_t seq;
+
+        // Only blocks written so far are valid in the current segment
+        size_t limit = c.seq == m_seq ? m_batch_block * block_len : data_size;
+
+        if (read_header(seg, seq) < 0 || seq != c.seq) {
+            if (c.seq == m_oldest) {
+                return ecl::err::io;
+            }
+
+            // Segment is reused meanwhile
+            c = begin();
+            continue;
+        }
+
+        size_t len;
+        size_t next;
+        auto rc = find(seg, c.seq, c.offset, limit, len, next, buf, size);
+
+        if (rc == -2) {
+            return ecl::err::msgsize;
+        }
+
+        if (rc >= 0) {
+            c.offset = next;
+            return len;
+        }
+
+        if (c.seq == m_seq) {
+            break;
+        }
+
+        c.seq++;
+        c.offset = 0;
+    }
+
+    return 0;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+size_t log_store< Block, segment_blocks, batch, block_len >::segment_count() const
+{
+    return m_count;
+}
+
+//------------------------------------------------------------------------------
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+size_t log_store< Block, segment_blocks, batch, block_len >::segment_lba(size_t seg) const
+{
+    return seg * segment_blocks;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+size_t log_store< Block, segment_blocks, batch, block_len >::segment_of(uint32_t seq) const
+{
+    return (m_seg + m_count - (m_seq - seq) % m_count) % m_count;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+int log_store< Block, segment_blocks, batch, block_len >::read_header(size_t seg, uint32_t &seq)
+{
+    auto header = load(segment_lba(seg));
+
+    if (!header || get_le(header, 4) != magic
+            || get_le(header + 8, 2) != ecl::crc16(header, 8)) {
+        return -1;
+    }
+
+    seq = get_le(header + 4, 4);
+    return seq ? 0 : -1;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+int log_store< Block, segment_blocks, batch, block_len >::start_segment(size_t seg, uint32_t seq)
+{
+    // Trim is a hint, old records are rejected by CRC anyway
+    m_dev.trim(segment_lba(seg) + 1, data_blocks);
+
+    // Batch is empty here, so it holds the header block
+    memset(m_batch, 0, block_len);
+    put_le(m_batch, magic, 4);
+    put_le(m_batch + 4, seq, 4);
+    put_le(m_batch + 8, ecl::crc16(m_batch, 8), 2);
+
+    if (segment_lba(seg) == m_cache_lba) {
+        m_cache_lba = SIZE_MAX;
+    }
+
+    return m_dev.write_blocks(segment_lba(seg), m_batch, 1) < 0 ? -1 : 0;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+int log_store< Block, segment_blocks, batch, block_len >::roll()
+{
+    if (sync() < 0) {
+        return -1;
+    }
+
+    size_t seg = (m_seg + 1) % m_count;
+
+    // Blocks of the reused segment are no longer valid
+    m_cache_lba = SIZE_MAX;
+
+    if (start_segment(seg, m_seq + 1) < 0) {
+        m_mounted = false;
+        return -1;
+    }
+
+    m_seg = seg;
+    m_seq++;
+    m_batch_block = 0;
+    m_batch_len = 0;
+
+    // Records of the oldest segment are erased
+    if (m_seq - m_oldest + 1 > m_count) {
+        m_oldest++;
+    }
+
+    return 0;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+int log_store< Block, segment_blocks, batch, block_len >::put(const uint8_t *data, size_t size)
+{
+    while (size) {
+        size_t chunk = std::min(size, sizeof(m_batch) - m_batch_len);
+        memcpy(m_batch + m_batch_len, data, chunk);
+        m_batch_len += chunk;
+        data += chunk;
+        size -= chunk;
+
+        if (m_batch_len == sizeof(m_batch) && write_batch(batch) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+int log_store< Block, segment_blocks, batch, block_len >::write_batch(size_t n)
+{
+    size_t lba = segment_lba(m_seg) + 1 + m_batch_block;
+
+    if (m_cache_lba >= lba && m_cache_lba < lba + n) {
+        m_cache_lba = SIZE_MAX;
+    }
+
+    if (m_dev.write_blocks(lba, m_batch, n) < 0) {
+        // Position of the log end is unknown, it is found by mount
+        m_mounted = false;
+        return -1;
+    }
+
+    m_batch_block += n;
+    m_batch_len = 0;
+
+    return 0;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+const uint8_t *log_store< Block, segment_blocks, batch, block_len >::load(size_t lba)
+{
+    if (lba != m_cache_lba) {
+        if (m_dev.read_blocks(lba, m_cache, 1) < 0) {
+            m_cache_lba = SIZE_MAX;
+            return nullptr;
+        }
+
+        m_cache_lba = lba;
+    }
+
+    return m_cache;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+int log_store< Block, segment_blocks, batch, block_len >::read_data(size_t seg, size_t offset,
+                                                                     uint8_t *dst, size_t size)
+{
+    while (size) {
+        size_t pos = offset % block_len;
+        size_t chunk = std::min(size, block_len - pos);
+        auto block = load(segment_lba(seg) + 1 + offset / block_len);
+
+        if (!block) {
+            return -1;
+        }
+
+        memcpy(dst, block + pos, chunk);
+        dst += chunk;
+        size -= chunk;
+        offset += chunk;
+    }
+
+    return 0;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+ssize_t log_store< Block, segment_blocks, batch, block_len >::check(size_t seg, uint32_t seq,
+                                                                    size_t offset, size_t &len,
+                                                                    uint8_t *buf, size_t size)
+{
+    uint8_t header[record_header];
+
+    if (read_data(seg, offset, header, sizeof(header)) < 0) {
+        return -1;
+    }
+
+    len = get_le(header, 2);
+    uint16_t crc = crc_start(seq, len);
+
+    if (len > max_record || offset + record_header + len > data_size) {
+        return -1;
+    }
+
+    if (buf && len > size) {
+        return -2;
+    }
+
+    // Payload is checked in portions, if it isn't copied
+    uint8_t portion[32];
+    size_t pos = offset + record_header;
+
+    for (size_t done = 0; done < len; ) {
+        uint8_t *dst = buf ? buf + done : portion;
+        size_t chunk = buf ? len : std::min(len - done, sizeof(portion));
+
+        if (read_data(seg, pos, dst, chunk) < 0) {
+            return -1;
+        }
+
+        crc = ecl::crc16(dst, chunk, crc);
+        pos += chunk;
+        done += chunk;
+    }
+
+    if (get_le(header + 2, 2) != crc) {
+        return -1;
+    }
+
+    return len ? pos : next_block(offset + 1);
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+ssize_t log_store< Block, segment_blocks, batch, block_len >::find(size_t seg, uint32_t seq,
+                                                                   size_t offset, size_t limit,
+                                                                   size_t &len, size_t &next,
+                                                                   uint8_t *buf, size_t size)
+{
+    bool retried = false;
+
+    while (offset < limit) {
+        // Header doesn't fit into the block, it is a padding
+        if (next_block(offset) - offset < record_header && offset % block_len) {
+            offset = next_block(offset);
+            continue;
+        }
+
+        auto rc = check(seg, seq, offset, len, buf, size);
+
+        if (rc == -2) {
+            return rc;
+        }
+
+        if (rc >= 0 && len) {
+            next = rc;
+            return offset;
+        }
+
+        if (rc >= 0) {
+            // Padding
+            offset = rc;
+            retried = false;
+            continue;
+        }
+
+        if (retried) {
+            break;
+        }
+
+        retried = true;
+        offset = next_block(offset + 1);
+    }
+
+    // Failed offset is not returned, log ends at the first failure
+    next = offset;
+    return -1;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+uint16_t log_store< Block, segment_blocks, batch, block_len >::crc_start(uint32_t seq, uint16_t len)
+{
+    uint8_t prefix[6];
+    put_le(prefix, seq, 4);
+    put_le(prefix + 4, len, 2);
+    return ecl::crc16(prefix, sizeof(prefix));
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+size_t log_store< Block, segment_blocks, batch, block_len >::next_block(size_t offset)
+{
+    return (offset + block_len - 1) / block_len * block_len;
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+void log_store< Block, segment_blocks, batch, block_len >::put_le(uint8_t *p, uint32_t v, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        p[i] = v >> (8 * i);
+    }
+}
+
+template< class Block, size_t segment_blocks, size_t batch, size_t block_len >
+uint32_t log_store< Block, segment_blocks, batch, block_len >::get_le(const uint8_t *p, size_t n)
+{
+    uint32_t v = 0;
+    for (size_t i = 0; i < n; ++i) {
+        v |= static_cast< uint32_t >(p[i]) << (8 * i);
+    }
+
+    return v;
+}
+
+}
+
+#endif // LIB_FS_LOG_STORE_HPP_
@@ -0,0 +1,144 @@
+#ifndef LIB_FS_MMAP_BLOCK_HPP_
+#define LIB_FS_MMAP_BLOCK_HPP_
+
+#include <sys/types.h>
+#include <cstddef>
+#include <cstdint>
+#include <string.h>
+
+namespace fs
+{
+
+// Read-only block device over a memory-mapped region, e.g. internal flash.
+// Implements block device interface, see fs/block.hpp. Blocks can be mapped
+// with map_blocks(), so data is accessed in place, without copying.
+// Example, for an image placed in STM32F4 flash at 512 KiB offset:
+//
+//   using assets = fs::mmap_block< 0x08000000 + 512 * 1024, 256 >;
+//   fat::petit< assets > fat;
+//
+template< std::uintptr_t base, size_t blocks, size_t block_len = 512 >
+class mmap_block
+{
+    static_assert(blocks > 0, "At least one block is required");
+
+public:
+    mmap_block();
+
+    // Always succeeds
+    int init();
+    int open();
+    int close();
+
+    constexpr size_t get_block_length();
+    // Returns amount of blocks, 0 if device is not opened
+    size_t block_count() const;
+    // Any request size is equally fast
+    constexpr size_t preferred_io_size();
+
+    // -1 if error, 0 otherwise
+    int read_blocks(size_t lba, uint8_t *buf, size_t n);
+    // Region is read-only, always -1
+    int write_blocks(size_t lba, const uint8_t *buf, size_t n);
+    // Region is read-only, always -1
+    int trim(size_t lba, size_t n);
+
+    // Returns pointer to given blocks, without copying them.
+    // Nullptr if error.
+    const uint8_t *map_blocks(size_t lba, size_t n) const;
+
+private:
+    int m_opened; // Opened times counter
+};
+
+template< std::uintptr_t base, size_t blocks, size_t block_len >
+mmap_block< base, blocks, block_len >::mmap_block()
+    :m_opened{0}
+{
+}
+
+template< std::uintptr_t base, size_t blocks, size_t block_len >
+int mmap_block< base, blocks, block_len >::init()
+{
+    return 0;
+}
+
+template< std::uintptr_t base, size_t blocks, size_t block_len >
+int mmap_block< base, blocks, block_len >::open()
+{
+    m_opened++;
+    return 0;
+}
+
+template< std::uintptr_t base, size_t blocks, size_t block_len >
+int mmap_block< base, blocks, block_len >::close()
+{
+    if (!m_opened) {
+        return -1;
+    }
+
+    m_opened--;
+    return 0;
+}
+
+template< std::uintptr_t base, size_t blocks, size_t block_len >
+constexpr size_t mmap_block< base, blocks, block_len >::get_block_length()
+{
+    return block_len;
+}
+
+template< std::uintptr_t base, size_t blocks, size_t block_len >
+size_t mmap_block< base, blocks, block_len >::block_count() const
+{
+    return m_opened ? blocks : 0;
+}
+
+template< std::uintptr_t base, size_t blocks, size_t block_len >
+constexpr size_t mmap_block< base, blocks, block_len >::preferred_io_size()
+{
+    return block_len;
+}
+
+template< std::uintptr_t base, size_t blocks, size_t block_len >
+int mmap_block< base, blocks, block_len >::read_blocks(size_t lba, uint8_t *buf, size_t n)
+{
+    auto src = map_blocks(lba, n);
+    if (!src) {
+        return -1;
+    }
+
+    memcpy(buf, src, n * block_len);
+    return 0;
+}
+
+template< std::uintptr_t base, size_t blocks, size_t block_len >
+int mmap_block< base, blocks, block_len >::write_blocks(size_t lba, const uint8_t *buf, size_t n)
+{
+    (void) lba;
+    (void) buf;
+    (void) n;
+    return -1;
+}
+
+template< std::uintptr_t base, size_t blocks, size_t block_len >
+int mmap_block< base, blocks, block_len >::trim(size_t lba, size_t n)
+{
+    (void) lba;
+    (void) n;
+    return -1;
+}
+
+template< std::uintptr_t base, size_t blocks, size_t block_len >
+const uint8_t *mmap_block< base, blocks, block_len >::map_blocks(size_t lba, size_t n) const
+{
+    // Overflow-safe check
+    if (!m_opened || lba > blocks || n > blocks - lba) {
+        return nullptr;
+    }
+
+    return reinterpret_cast< const uint8_t * >(base) + lba * block_len;
+}
+
+}
+
+#endif // LIB_FS_MMAP_BLOCK_HPP_
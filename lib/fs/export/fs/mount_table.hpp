@@ -0,0 +1,130 @@
+#ifndef LIB_FS_MOUNT_TABLE_HPP_
+#define LIB_FS_MOUNT_TABLE_HPP_
+
+#include <cstddef>
+#include <utility>
+
+namespace fs
+{
+
+// Mount point of a filesystem, as seen by the lookup
+struct mount_entry
+{
+    const char  *path;      // Mount point
+    size_t      segments;   // Amount of path segments
+    size_t      index;      // Index of a filesystem
+};
+
+// Mount points, ordered from the most specific to the least specific one.
+// First match during the lookup is the longest one.
+template< size_t N >
+struct mount_table
+{
+    mount_entry entries[N];
+
+    // Finds a filesystem, that holds given path. Path is advanced past
+    // the mount point. Returns index of the filesystem, N if none matches.
+    size_t resolve(const char *&path) const;
+};
+
+namespace detail
+{
+
+// Counts non-empty segments, repeated slashes are ignored
+constexpr size_t count_segments(const char *path)
+{
+    size_t cnt = 0;
+
+    for (size_t i = 0; path[i]; ++i) {
+        if (path[i] != '/' && (!i || path[i - 1] == '/')) {
+            cnt++;
+        }
+    }
+
+    return cnt;
+}
+
+constexpr char to_lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+// Matches mount point against the beginning of a path, segment by segment.
+// Returns amount of matched characters of a path, -1 if mismatch.
+inline ptrdiff_t match_mount(const char *mnt, const char *path)
+{
+    const char *p = path;
+
+    for (;;) {
+        while (*mnt == '/') {
+            mnt++;
+        }
+
+        while (*p == '/') {
+            p++;
+        }
+
+        if (!*mnt) {
+            return p - path;
+        }
+
+        // TODO: most of FSes are case sensitive.
+        // This must be optionally be supported by checking special flags
+        while (*mnt && *mnt != '/' && to_lower(*mnt) == to_lower(*p)) {
+            mnt++;
+            p++;
+        }
+
+        // Segment must be matched entirely
+        if ((*mnt && *mnt != '/') || (*p && *p != '/')) {
+            return -1;
+        }
+    }
+}
+
+template< class... Fs, size_t... I >
+constexpr mount_table< sizeof...(Fs) > make_mount_table(std::index_sequence< I... >)
+{
+    mount_table< sizeof...(Fs) > table = {
+        { { Fs::mnt_point, count_segments(Fs::mnt_point), I }... }
+    };
+
+    // Stable insertion sort, deeper mount points go first
+    for (size_t i = 1; i < sizeof...(Fs); ++i) {
+        for (size_t j = i; j > 0 && table.entries[j - 1].segments < table.entries[j].segments; --j) {
+            mount_entry tmp         = table.entries[j];
+            table.entries[j]        = table.entries[j - 1];
+            table.entries[j - 1]    = tmp;
+        }
+    }
+
+    return table;
+}
+
+}
+
+// Builds mount table from filesystem descriptors at compile time
+template< class... Fs >
+constexpr mount_table< sizeof...(Fs) > make_mount_table()
+{
+    return detail::make_mount_table< Fs... >(std::index_sequence_for< Fs... >{});
+}
+
+template< size_t N >
+size_t mount_table< N >::resolve(const char *&path) const
+{
+    for (auto &e : entries) {
+        auto matched = detail::match_mount(e.path, path);
+
+        if (matched >= 0) {
+            path += matched;
+            return e.index;
+        }
+    }
+
+    return N;
+}
+
+}
+
+#endif // LIB_FS_MOUNT_TABLE_HPP_
@@ -0,0 +1,106 @@
+#ifndef LIB_FS_PATH_HPP_
+#define LIB_FS_PATH_HPP_
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <string.h>
+
+namespace fs
+{
+
+// Part of a string, i.e. a path segment. Refers to the path itself,
+// so it is not null-terminated and valid while the path is alive.
+struct name_view
+{
+    name_view(const char *str)
+        :ptr{str}
+        ,len{strlen(str)}
+    {
+    }
+
+    name_view(const char *str, size_t n)
+        :ptr{str}
+        ,len{n}
+    {
+    }
+
+    const char  *ptr;
+    size_t      len;
+};
+
+// Case-insensitive comparison of a name with null-terminated string.
+// Only ASCII letters are folded, as filesystems do for short names.
+inline bool same_name(const name_view &name, const char *str)
+{
+    auto upper = [](char c) { return c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c; };
+
+    for (size_t i = 0; i < name.len; ++i) {
+        // Null terminator of a shorter string mismatches here as well
+        if (upper(name.ptr[i]) != upper(str[i])) {
+            return false;
+        }
+    }
+
+    return !str[name.len];
+}
+
+// Splits a path into segments, in a single pass and without copying.
+// Repeated separators are skipped.
+class path_tokenizer
+{
+public:
+    path_tokenizer(const char *path)
+        :m_path{path}
+        ,m_cur{0}
+        ,m_too_long{false}
+    {
+    }
+
+    // Gets next segment. Segment followed by a separator is a dir.
+    // false if path is over or segment is too long.
+    bool next(name_view &seg, bool &is_dir)
+    {
+        // Find a start of the segment
+        while (m_path[m_cur] == '/') {
+            m_cur++;
+        }
+
+        size_t start = m_cur;
+
+        while (m_path[m_cur] && m_path[m_cur] != '/') {
+            m_cur++;
+        }
+
+        size_t len = m_cur - start;
+
+        if (!len) {
+            return false;
+        }
+
+        if (len > max_name) {
+            // Name is too long, no filesystem can hold it
+            m_too_long = true;
+            return false;
+        }
+
+        seg    = name_view{m_path + start, len};
+        is_dir = m_path[m_cur] == '/';
+        return true;
+    }
+
+    // Checks if iteration stopped on a name that is too long
+    bool overflow() const
+    {
+        return m_too_long;
+    }
+
+private:
+    const char  *m_path;
+    size_t      m_cur;
+    bool        m_too_long;
+};
+
+}
+
+#endif // LIB_FS_PATH_HPP_
@@ -0,0 +1,153 @@
+#ifndef LIB_FS_RAM_BLOCK_HPP_
+#define LIB_FS_RAM_BLOCK_HPP_
+
+#include <sys/types.h>
+#include <cstddef>
+#include <cstdint>
+#include <string.h>
+
+namespace fs
+{
+
+// RAM disk. Implements block device interface, see fs/block.hpp.
+// Storage is a part of the object itself. Content is lost when
+// the object is destroyed.
+template< size_t blocks, size_t block_len = 512 >
+class ram_block
+{
+    static_assert(blocks > 0, "At least one block is required");
+
+public:
+    ram_block();
+
+    // Always succeeds
+    int init();
+    int open();
+    int close();
+
+    constexpr size_t get_block_length();
+    // Returns amount of blocks, 0 if device is not opened
+    size_t block_count() const;
+    // Any request size is equally fast
+    constexpr size_t preferred_io_size();
+
+    // -1 if error, 0 otherwise
+    int read_blocks(size_t lba, uint8_t *buf, size_t n);
+    // -1 if error, 0 otherwise
+    int write_blocks(size_t lba, const uint8_t *buf, size_t n);
+    // Nothing to erase in RAM. -1 if error, 0 otherwise
+    int trim(size_t lba, size_t n);
+
+    // Returns pointer to given blocks, without copying them.
+    // Nullptr if error.
+    const uint8_t *map_blocks(size_t lba, size_t n) const;
+    uint8_t *map_blocks(size_t lba, size_t n);
+
+private:
+    bool valid_range(size_t lba, size_t n) const;
+
+    int     m_opened;                   // Opened times counter
+    uint8_t m_data[blocks * block_len]; // Disk content
+};
+
+template< size_t blocks, size_t block_len >
+ram_block< blocks, block_len >::ram_block()
+    :m_opened{0}
+    ,m_data{}
+{
+}
+
+template< size_t blocks, size_t block_len >
+int ram_block< blocks, block_len >::init()
+{
+    return 0;
+}
+
+template< size_t blocks, size_t block_len >
+int ram_block< blocks, block_len >::open()
+{
+    m_opened++;
+    return 0;
+}
+
+template< size_t blocks, size_t block_len >
+int ram_block< blocks, block_len >::close()
+{
+    if (!m_opened) {
+        return -1;
+    }
+
+    m_opened--;
+    return 0;
+}
+
+template< size_t blocks, size_t block_len >
+constexpr size_t ram_block< blocks, block_len >::get_block_length()
+{
+    return block_len;
+}
+
+template< size_t blocks, size_t block_len >
+size_t ram_block< blocks, block_len >::block_count() const
+{
+    return m_opened ? blocks : 0;
+}
+
+template< size_t blocks, size_t block_len >
+constexpr size_t ram_block< blocks, block_len >::preferred_io_size()
+{
+    return block_len;
+}
+
+template< size_t blocks, size_t block_len >
+int ram_block< blocks, block_len >::read_blocks(size_t lba, uint8_t *buf, size_t n)
+{
+    auto src = map_blocks(lba, n);
+    if (!src) {
+        return -1;
+    }
+
+    memcpy(buf, src, n * block_len);
+    return 0;
+}
+
+template< size_t blocks, size_t block_len >
+int ram_block< blocks, block_len >::write_blocks(size_t lba, const uint8_t *buf, size_t n)
+{
+    auto dst = map_blocks(lba, n);
+    if (!dst) {
+        return -1;
+    }
+
+    memcpy(dst, buf, n * block_len);
+    return 0;
+}
+
+template< size_t blocks, size_t block_len >
+int ram_block< blocks, block_len >::trim(size_t lba, size_t n)
+{
+    return valid_range(lba, n) ? 0 : -1;
+}
+
+template< size_t blocks, size_t block_len >
+const uint8_t *ram_block< blocks, block_len >::map_blocks(size_t lba, size_t n) const
+{
+    return valid_range(lba, n) ? m_data + lba * block_len : nullptr;
+}
+
+template< size_t blocks, size_t block_len >
+uint8_t *ram_block< blocks, block_len >::map_blocks(size_t lba, size_t n)
+{
+    return valid_range(lba, n) ? m_data + lba * block_len : nullptr;
+}
+
+template< size_t blocks, size_t block_len >
+bool ram_block< blocks, block_len >::valid_range(size_t lba, size_t n) const
+{
+    // Overflow-safe check
+    return m_opened && lba <= blocks && n <= blocks - lba;
+}
+
+}
+
+#endif // LIB_FS_RAM_BLOCK_HPP_
@@ -0,0 +1,355 @@
+#ifndef LIB_FS_STRIPED_BLOCK_HPP_
+#define LIB_FS_STRIPED_BLOCK_HPP_
+
+#include <fs/block.hpp>
+#include <ecl/thread/semaphore.hpp>
+
+#include <sys/types.h>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace fs
+{
+
+// Striped volume over two block devices. Implements block device interface,
+// see fs/block.hpp. Consecutive stripes of stripe_blocks blocks are placed
+// on both devices in turn: even stripes go to the first device, odd ones
+// to the second.
+//
+// If both devices complete requests in background (see is_callback_device),
+// halves of a request that fall on different devices are transferred
+// simultaneously, so throughput of two cards on separate buses is summed.
+// Otherwise, devices are accessed one after another.
+//
+// Devices must have the same block length. Volume size is limited by
+// the smaller device.
+template< class BlockA, class BlockB, size_t stripe_blocks = 8 >
+class striped_block
+{
+    static_assert(stripe_blocks > 0, "Stripe must contain at least one block");
+
+public:
+    striped_block(BlockA &first, BlockB &second);
+
+    // Initializes both devices, negative if error
+    int init();
+    // Opens both devices, negative if error. None is left opened on failure.
+    int open();
+    int close();
+
+    size_t get_block_length();
+    // Returns amount of blocks, 0 if device is not opened
+    size_t block_count() const;
+    // Whole stripe on both devices
+    size_t preferred_io_size();
+
+    // Negative if error, 0 otherwise
+    int read_blocks(size_t lba, uint8_t *buf, size_t n);
+    // Negative if error, 0 otherwise
+    int write_blocks(size_t lba, const uint8_t *buf, size_t n);
+    // Negative if error, 0 otherwise
+    int trim(size_t lba, size_t n);
+
+    // Underlying devices
+    BlockA &first();
+    BlockB &second();
+
+private:
+    // Part of a request, placed on a single device
+    struct chunk
+    {
+        int     dev;    // 0 for the first device, 1 for the second
+        size_t  lba;    // First block on the device
+        size_t  n;      // Amount of blocks
+        uint8_t *buf;   // Data of the chunk
+    };
+
+    static constexpr bool use_async =
+        is_callback_device< BlockA >::value && is_callback_device< BlockB >::value;
+
+    bool valid_range(size_t lba, size_t n) const;
+    // Maps given volume block to a chunk, limited by the stripe end
+    chunk map(size_t lba, uint8_t *buf, size_t n);
+
+    int xfer(size_t lba, uint8_t *buf, size_t n, bool write);
+    // Transfers up to two chunks, placed on different devices
+    int xfer_chunks(const chunk *c, size_t cnt, bool write, std::true_type async);
+    int xfer_chunks(const chunk *c, size_t cnt, bool write, std::false_type async);
+
+    template< class Block >
+    static int xfer_one(Block &dev, const chunk &c, bool write);
+    template< class Block >
+    int start_one(Block &dev, const chunk &c, bool write);
+
+    BlockA          &m_a;           // Device with even stripes
+    BlockB          &m_b;           // Device with odd stripes
+    bool            m_opened;       // Both devices are opened
+    ecl::semaphore  m_done;         // Signalled on every async chunk completion
+    int             m_status[2];    // Statuses of async chunks, per device
+};
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+striped_block< BlockA, BlockB, stripe_blocks >::striped_block(BlockA &first, BlockB &second)
+    :m_a{first}
+    ,m_b{second}
+    ,m_opened{false}
+    ,m_done{}
+    ,m_status{}
+{
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+int striped_block< BlockA, BlockB, stripe_blocks >::init()
+{
+    int rc = m_a.init();
+    if (rc < 0) {
+        return rc;
+    }
+
+    return m_b.init();
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+int striped_block< BlockA, BlockB, stripe_blocks >::open()
+{
+    if (m_opened) {
+        return -1;
+    }
+
+    int rc = m_a.open();
+    if (rc < 0) {
+        return rc;
+    }
+
+    rc = m_b.open();
+    if (rc < 0) {
+        m_a.close();
+        return rc;
+    }
+
+    if (m_a.get_block_length() != m_b.get_block_length()) {
+        m_b.close();
+        m_a.close();
+        return -1;
+    }
+
+    m_opened = true;
+    return 0;
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+int striped_block< BlockA, BlockB, stripe_blocks >::close()
+{
+    if (!m_opened) {
+        return -1;
+    }
+
+    m_opened = false;
+
+    int rc_a = m_a.close();
+    int rc_b = m_b.close();
+    return rc_a < 0 ? rc_a : rc_b;
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+size_t striped_block< BlockA, BlockB, stripe_blocks >::get_block_length()
+{
+    return m_a.get_block_length();
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+size_t striped_block< BlockA, BlockB, stripe_blocks >::block_count() const
+{
+    if (!m_opened) {
+        return 0;
+    }
+
+    // Only whole stripes, present on both devices, are used
+    size_t a = m_a.block_count();
+    size_t b = m_b.block_count();
+    size_t stripes = (a < b ? a : b) / stripe_blocks;
+
+    return stripes * 2 * stripe_blocks;
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+size_t striped_block< BlockA, BlockB, stripe_blocks >::preferred_io_size()
+{
+    return 2 * stripe_blocks * get_block_length();
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+int striped_block< BlockA, BlockB, stripe_blocks >::read_blocks(size_t lba, uint8_t *buf, size_t n)
+{
+    return xfer(lba, buf, n, false);
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+int striped_block< BlockA, BlockB, stripe_blocks >::write_blocks(size_t lba, const uint8_t *buf,
+                                                                 size_t n)
+{
+    // Buffer is not modified by writes
+    return xfer(lba, const_cast< uint8_t * >(buf), n, true);
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+int striped_block< BlockA, BlockB, stripe_blocks >::trim(size_t lba, size_t n)
+{
+    if (!valid_range(lba, n)) {
+        return -1;
+    }
+
+    while (n) {
+        auto c = map(lba, nullptr, n);
+        int rc = c.dev ? m_b.trim(c.lba, c.n) : m_a.trim(c.lba, c.n);
+        if (rc < 0) {
+            return rc;
+        }
+
+        lba += c.n;
+        n -= c.n;
+    }
+
+    return 0;
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+BlockA &striped_block< BlockA, BlockB, stripe_blocks >::first()
+{
+    return m_a;
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+BlockB &striped_block< BlockA, BlockB, stripe_blocks >::second()
+{
+    return m_b;
+}
+
+//------------------------------------------------------------------------------
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+bool striped_block< BlockA, BlockB, stripe_blocks >::valid_range(size_t lba, size_t n) const
+{
+    size_t count = block_count();
+    // Overflow-safe check
+    return lba <= count && n <= count - lba;
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+typename striped_block< BlockA, BlockB, stripe_blocks >::chunk
+striped_block< BlockA, BlockB, stripe_blocks >::map(size_t lba, uint8_t *buf, size_t n)
+{
+    size_t stripe = lba / stripe_blocks;
+    size_t within = lba % stripe_blocks;
+    size_t left = stripe_blocks - within;
+
+    return chunk{static_cast< int >(stripe % 2),
+                 (stripe / 2) * stripe_blocks + within,
+                 n < left ? n : left,
+                 buf};
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+int striped_block< BlockA, BlockB, stripe_blocks >::xfer(size_t lba, uint8_t *buf, size_t n,
+                                                         bool write)
+{
+    if (!valid_range(lba, n)) {
+        return -1;
+    }
+
+    size_t len = get_block_length();
+
+    while (n) {
+        // Consecutive chunks always belong to different devices
+        chunk c[2];
+        size_t cnt = 0;
+
+        while (n && cnt < 2) {
+            c[cnt] = map(lba, buf, n);
+            lba += c[cnt].n;
+            buf += c[cnt].n * len;
+            n -= c[cnt].n;
+            cnt++;
+        }
+
+        int rc = xfer_chunks(c, cnt, write, std::integral_constant< bool, use_async >{});
+        if (rc < 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+int striped_block< BlockA, BlockB, stripe_blocks >::xfer_chunks(const chunk *c, size_t cnt,
+                                                                bool write, std::true_type)
+{
+    int rc = 0;
+    size_t started = 0;
+
+    for (size_t i = 0; i < cnt; ++i) {
+        rc = c[i].dev ? start_one(m_b, c[i], write) : start_one(m_a, c[i], write);
+        if (rc < 0) {
+            break;
+        }
+
+        started++;
+    }
+
+    // Chunks that are already in progress must be finished in any case,
+    // otherwise their callbacks would outlive the request
+    for (size_t i = 0; i < started; ++i) {
+        m_done.wait();
+    }
+
+    for (size_t i = 0; i < started; ++i) {
+        if (m_status[c[i].dev] < 0) {
+            return m_status[c[i].dev];
+        }
+    }
+
+    return rc;
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+int striped_block< BlockA, BlockB, stripe_blocks >::xfer_chunks(const chunk *c, size_t cnt,
+                                                                bool write, std::false_type)
+{
+    for (size_t i = 0; i < cnt; ++i) {
+        int rc = c[i].dev ? xfer_one(m_b, c[i], write) : xfer_one(m_a, c[i], write);
+        if (rc < 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+template< class Block >
+int striped_block< BlockA, BlockB, stripe_blocks >::xfer_one(Block &dev, const chunk &c,
+                                                             bool write)
+{
+    return write ? dev.write_blocks(c.lba, c.buf, c.n) : dev.read_blocks(c.lba, c.buf, c.n);
+}
+
+template< class BlockA, class BlockB, size_t stripe_blocks >
+template< class Block >
+int striped_block< BlockA, BlockB, stripe_blocks >::start_one(Block &dev, const chunk &c,
+                                                              bool write)
+{
+    int dev_idx = c.dev;
+    auto done = [this, dev_idx](int status) {
+        m_status[dev_idx] = status;
+        m_done.signal();
+    };
+
+    return write ? dev.write_blocks_async(c.lba, c.buf, c.n, done)
+                 : dev.read_blocks_async(c.lba, c.buf, c.n, done);
+}
+
+}
+
+#endif // LIB_FS_STRIPED_BLOCK_HPP_
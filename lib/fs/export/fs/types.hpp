@@ -8,12 +8,16 @@ namespace fs
     class inode;
     class file_descriptor;
     class dir_descriptor;
+    struct dir_entry;
 
 
     using inode_ptr = ecl::shared_ptr< inode >;
     using inode_weak = ecl::weak_ptr< inode >;
     using file_ptr = ecl::shared_ptr< file_descriptor >;
     using dir_ptr = ecl::shared_ptr< dir_descriptor >;
+
+    // Maximum length of a name of a file or a dir, excluding null character
+    static constexpr size_t max_name = 255;
 }
 
 #endif
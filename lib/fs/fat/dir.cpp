@@ -5,15 +5,19 @@
 #include <ecl/iostream.hpp>
 #include <ecl/assert.h>
 
+#include <string.h>
+
 using namespace fat;
 
-dir::dir(const fs::inode_ptr &node, FATFS *fs, const allocator &alloc,
+dir::dir(const fs::inode_ptr &node, mount_state *fs, const allocator &alloc,
          const DIR &fat_dir, path_ptr path)
     :fs::dir_descriptor{node}
     ,m_fs{fs}
     ,m_alloc{alloc}
     ,m_fdir{fat_dir}
     ,m_path{path}
+    ,m_last_dir{}
+    ,m_last_file{}
     ,m_opened{true}
 {
     ecl_assert(node);
@@ -28,27 +32,87 @@ fs::inode_ptr dir::next()
 {
     if (m_opened) {
         FILINFO fno;
-        FRESULT res = pf_readdir(m_fs, &m_fdir, &fno);
+        FRESULT res = pf_readdir(&m_fs->fat, &m_fdir, &fno);
 
         if (res != FR_OK || fno.fname[0] == 0) {
             // End of dir
             return fs::inode_ptr{};
         }
 
+        // Inode, returned last time, is reused if nobody holds it anymore
         if (fno.fattrib & AM_DIR) {
-            auto ptr = ecl::allocate_shared< dir_inode, decltype(m_alloc) >
-                    (m_alloc, m_fs, m_alloc, m_path->get_path(), fno.fname);
-
-            ptr->set_weak(ptr);
+            if (m_last_dir && m_last_dir.unique()) {
+                static_cast< dir_inode* >(m_last_dir.get())->reuse(fno.fname);
+            } else {
+                m_last_dir = make_inode(fno);
+            }
 
-            return ptr;
+            return m_last_dir;
         } else {
-            auto ptr = ecl::allocate_shared< file_inode, decltype(m_alloc) >
-                    (m_alloc, m_fs, m_alloc, m_path->get_path(), fno.fname);
+            if (m_last_file && m_last_file.unique()) {
+                static_cast< file_inode* >(m_last_file.get())->reuse(fno.fname);
+            } else {
+                m_last_file = make_inode(fno);
+            }
+
+            return m_last_file;
+        }
+    }
 
-            ptr->set_weak(ptr);
+    return fs::inode_ptr{};
+}
+
+ssize_t dir::readdir(fs::dir_entry *out, size_t n)
+{
+    ecl_assert(out);
+
+    if (!m_opened) {
+        return -1;
+    }
 
-            return ptr;
+    size_t cnt = 0;
+
+    while (cnt < n) {
+        FILINFO fno;
+
+        if (pf_readdir(&m_fs->fat, &m_fdir, &fno) != FR_OK) {
+            return -1;
+        }
+
+        if (!fno.fname[0]) {
+            // End of dir
+            break;
+        }
+
+        auto &d = out[cnt++];
+        bool is_dir = fno.fattrib & AM_DIR;
+
+        strcpy(d.name, fno.fname);
+        d.type = is_dir ? fs::inode::type::dir : fs::inode::type::file;
+        d.size = is_dir ? 0 : fno.fsize;
+    }
+
+    return cnt;
+}
+
+fs::inode_ptr dir::find(const fs::name_view &name)
+{
+    ecl_assert(name.ptr);
+
+    if (m_opened) {
+        FILINFO fno;
+
+        if (pf_readdir(&m_fs->fat, &m_fdir, nullptr) != FR_OK) {
+            return fs::inode_ptr{};
+        }
+
+        // Only matching entry gets an inode
+        while (pf_readdir(&m_fs->fat, &m_fdir, &fno) == FR_OK && fno.fname[0]) {
+            if (!fs::same_name(name, fno.fname)) {
+                continue;
+            }
+
+            return make_inode(fno);
         }
     }
 
@@ -58,7 +122,7 @@ fs::inode_ptr dir::next()
 int dir::rewind()
 {
     if (m_opened) {
-        FRESULT res = pf_readdir(m_fs, &m_fdir, nullptr);
+        FRESULT res = pf_readdir(&m_fs->fat, &m_fdir, nullptr);
         if (res == FR_OK) {
             return 0;
         }
@@ -71,8 +135,29 @@ int dir::close()
 {
     if (m_opened) {
         m_opened = false;
+        m_last_dir = fs::inode_ptr{};
+        m_last_file = fs::inode_ptr{};
         return 0;
     }
 
     return -1;
 }
+
+fs::inode_ptr dir::make_inode(const FILINFO &fno)
+{
+    if (fno.fattrib & AM_DIR) {
+        auto ptr = ecl::allocate_shared< dir_inode, decltype(m_alloc) >
+                (m_alloc, m_fs, m_alloc, m_path, fno.fname);
+
+        ptr->set_weak(ptr);
+
+        return ptr;
+    } else {
+        auto ptr = ecl::allocate_shared< file_inode, decltype(m_alloc) >
+                (m_alloc, m_fs, m_alloc, m_path, fno.fname);
+
+        ptr->set_weak(ptr);
+
+        return ptr;
+    }
+}
@@ -4,17 +4,27 @@
 
 using namespace fat;
 
-dir_inode::dir_inode(FATFS *fs, const allocator &alloc, const char *path, const char *name)
+dir_inode::dir_inode(mount_state *fs, const allocator &alloc)
     :fs::inode()
     ,m_alloc(alloc)
+    ,m_dir_path()
     ,m_path()
     ,m_fs(fs)
+    ,m_name{}
 {
-    if (!path && !name) {
-        m_path = allocate_path("/", nullptr, m_alloc);
-    } else {
-        m_path = allocate_path(path, name, m_alloc);
-    }
+    m_path = allocate_path("/", nullptr, m_alloc);
+}
+
+dir_inode::dir_inode(mount_state *fs, const allocator &alloc, const path_ptr &dir_path,
+                     const char *name)
+    :fs::inode()
+    ,m_alloc(alloc)
+    ,m_dir_path(dir_path)
+    ,m_path()
+    ,m_fs(fs)
+    ,m_name{}
+{
+    reuse(name);
 }
 
 dir_inode::~dir_inode()
@@ -32,7 +42,11 @@ fs::dir_ptr dir_inode::open_dir()
     ecl_assert(!my_ptr.expired());
     DIR fat_dir;
 
-    FRESULT res = pf_opendir(m_fs, &fat_dir, m_path->get_path());
+    if (!m_path) {
+        m_path = allocate_path(m_dir_path->get_path(), m_name, m_alloc);
+    }
+
+    FRESULT res = pf_opendir(&m_fs->fat, &fat_dir, m_path->get_path());
     // TODO: graceful error handing
     // ecl_assert(res == FR_OK);
     if (res != FR_OK) {
@@ -61,34 +75,25 @@ ssize_t dir_inode::get_name(char *buf, size_t buf_sz) const
     ecl_assert(buf);
     ecl_assert(buf_sz);
 
-    const char *path = m_path->get_path();
-
-    size_t path_len = strlen(path);
-    const char *start = path;
-    const char *end;
-
-    //assert(path[path_len - 1] == '/');
-    end = path + path_len;
-
-    // Skip trailing '/'
-    for (uint i = path_len - 1; i > 0; --i) {
-        if (path[i - 1] == '/') {
-            start = path + i; // Skipping forward slash
-            break;
-        }
-    }
+    // Root is named as in a path
+    const char *name = m_dir_path ? m_name : "/";
+    size_t len = strlen(name);
 
     // Reserve place for null terminator
-    size_t to_copy = std::min(buf_sz - 1, (size_t) (end - start));
-
-    // Algorithm check
-    ecl_assert(to_copy < buf_sz);
-    ecl_assert(start < end);
-
+    size_t to_copy = std::min(buf_sz - 1, len);
+    std::copy(name, name + to_copy, buf);
     buf[to_copy] = 0;
 
-    std::copy(start, end, buf);
-
-    return path_len;
+    return len;
 }
 
+void dir_inode::reuse(const char *name)
+{
+    ecl_assert(m_dir_path);
+    ecl_assert(name);
+    ecl_assert(strlen(name) < sizeof(m_name));
+
+    strcpy(m_name, name);
+    // Path of a previous dir is not valid anymore
+    m_path = path_ptr{};
+}
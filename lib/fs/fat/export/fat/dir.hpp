@@ -14,13 +14,18 @@ namespace fat
 class dir : public fs::dir_descriptor
 {
 public:
-    dir(const fs::inode_ptr &node, FATFS *fs, const allocator &alloc,
+    dir(const fs::inode_ptr &node, mount_state *fs, const allocator &alloc,
         const DIR &fat_dir, fat::path_ptr path);
     virtual ~dir();
 
     // Next entity in a dir
     // nullptr returned if no more items
     virtual fs::inode_ptr next() override;
+    // Reads next entries straight from dir entries
+    virtual ssize_t readdir(fs::dir_entry *out, size_t n) override;
+    // Finds an entity by name, without creating inodes for other entries
+    // nullptr returned if not found
+    virtual fs::inode_ptr find(const fs::name_view &name) override;
     // Rewinds to the start of the dir
     // -1 if error, 0 otherwise
     virtual int rewind() override;
@@ -28,12 +33,17 @@ public:
     virtual int close() override;
 
 private:
-    // TBD
-    FATFS       *m_fs;
-    allocator   m_alloc;
-    DIR         m_fdir;
-    path_ptr    m_path;
-    bool        m_opened;
+    // Creates an inode for given entry
+    fs::inode_ptr make_inode(const FILINFO &fno);
+
+    mount_state     *m_fs;
+    allocator       m_alloc;
+    DIR             m_fdir;
+    path_ptr        m_path;
+    // Inodes, returned by next(). Reused when user doesn't hold them.
+    fs::inode_ptr   m_last_dir;
+    fs::inode_ptr   m_last_file;
+    bool            m_opened;
 };
 
 
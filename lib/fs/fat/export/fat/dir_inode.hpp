@@ -19,12 +19,13 @@ class dir_inode : public fs::inode
 public:
     using type = typename fs::inode::type;
 
-    // Constructs this inode for given filesystem. Allocator is used for internal
-    // allocations. The 'path' pointer should point to a path to a parent dir.
-    // The name is a name of a dir represented by this inode.
-    // If both name and path are null then this inode represents root node.
-    dir_inode(FATFS *fs, const allocator &alloc,
-              const char *path = nullptr, const char *name = nullptr);
+    // Constructs root inode for given filesystem. Allocator is used
+    // for internal allocations.
+    dir_inode(mount_state *fs, const allocator &alloc);
+    // Constructs inode of a dir with given name, residing in a dir
+    // with given path.
+    dir_inode(mount_state *fs, const allocator &alloc, const path_ptr &dir_path,
+              const char *name);
     virtual ~dir_inode();
 
     virtual type get_type() const override;
@@ -32,11 +33,16 @@ public:
     virtual ssize_t size() const override;
     virtual ssize_t get_name(char *buf, size_t buf_sz) const override;
 
+    // Makes this inode to represent other dir in the same parent dir.
+    // Lets dir iteration avoid an allocation per entry.
+    void reuse(const char *name);
+
 private:
-    // Holds a reference to a path string and manages its deallocation
-    allocator  m_alloc; // The allocator to create various objects
-    path_ptr   m_path;  // The path of this inodeho
-    FATFS      *m_fs;   // The filesystem object
+    allocator  m_alloc;     // The allocator to create various objects
+    path_ptr   m_dir_path;  // Path to a parent dir, null for root
+    path_ptr   m_path;      // Full path, allocated when dir is opened
+    mount_state *m_fs;      // The filesystem object
+    char       m_name[13];  // 8.3 name of a dir
 };
 
 }
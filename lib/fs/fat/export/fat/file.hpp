@@ -6,6 +6,7 @@
 #include <fs/inode.hpp>
 
 #include "src/pff.h"
+#include "fat/types.hpp"
 
 namespace fat
 {
@@ -13,18 +14,26 @@ namespace fat
 class file : public fs::file_descriptor
 {
 public:
-    file(const fs::inode_weak &node, FATFS *fs);
+    // Constructs closed file, counting it as opened in the filesystem
+    file(const fs::inode_weak &node, mount_state *fs);
     virtual ~file();
 
+    // Opens a file by path. -1 if error, 0 otherwise
+    int open(const char *path);
+
     virtual ssize_t read(uint8_t *buf, size_t size);
     virtual ssize_t write(const uint8_t *buf, size_t size);
     virtual int seek(off_t offt, seekdir way = seekdir::beg);
     virtual off_t tell();
     virtual int close();
+    // Counted in amount of opened files again, so it may fail as open() does
+    virtual int reopen();
 
 private:
-    FATFS *m_fs;
-    bool  m_opened; // TODO: remove it and use FATFS::flag instead
+    mount_state *m_state;   // Filesystem, to which file belongs
+    FATFS       m_fs;       // Own copy of the FAT object, holds file position
+    bool        m_counted;  // File is counted in amount of opened files
+    bool        m_opened;   // TODO: remove it and use FATFS::flag instead
 };
 
 }
@@ -17,19 +17,25 @@ class file_inode : public fs::inode
 public:
     using type = typename fs::inode::type;
 
-    file_inode(FATFS *fs, const allocator &alloc, const char *path, const char *name);
+    // Constructs inode of a file with given name, residing in a dir
+    // with given path
+    file_inode(mount_state *fs, const allocator &alloc, const path_ptr &dir_path,
+               const char *name);
     virtual ~file_inode();
     virtual type get_type() const override;
     virtual fs::file_ptr open() override;
     virtual ssize_t size() const override;
     virtual ssize_t get_name(char *buf, size_t buf_sz) const override;
 
+    // Makes this inode to represent other file in the same dir.
+    // Lets dir iteration avoid an allocation per entry.
+    void reuse(const char *name);
+
 private:
-    // TBD
-    FATFS       m_fs;
-    path_ptr    m_path;     // Full path to a file
+    mount_state *m_fs;      // The filesystem object
+    path_ptr    m_dir_path; // Path to a parent dir, shared with siblings
     allocator   m_alloc;    // Allocator for internal use
-
+    char        m_name[13]; // 8.3 name of a file
 };
 
 }
@@ -5,24 +5,61 @@
 #include "fat/types.hpp"
 #include "fat/file_inode.hpp"
 #include "fat/dir_inode.hpp"
+#include "fat/sector_cache.hpp"
 #include "src/pff.h"
 
 #include <ecl/pool.hpp>
 #include <fs/inode.hpp>
+#include <fs/block.hpp>
 #include <ecl/iostream.hpp>
+#include <ecl/assert.h>
+
+#include <string.h>
+#include <type_traits>
+
+// Sectors read ahead by petit on sequential access, 0 disables readahead
+#ifndef CONFIG_FS_FAT_PETIT_READAHEAD
+#define CONFIG_FS_FAT_PETIT_READAHEAD 2
+#endif
 
 namespace fat
 {
 
-template< class Block >
+// Read-only FAT filesystem, based on Petite FAT.
+// Pool holds all inodes and descriptors of the filesystem, so pool_size
+// limits amount of objects alive at once. Every opened file has its own
+// position and up to max_files files can be opened at once.
+// Types restrict FAT types this instance mounts, i.e. fat12 | fat16
+// for small media. Only types built into Petite FAT can be given,
+// so ones not used by any instance should be left out of the build,
+// see CONFIG_FS_FAT_PETIT_TYPES.
+template< class Block, size_t pool_size = 256, size_t max_files = 4,
+          uint8_t types = petit_types >
 class petit // TODO: rename it to 'petite_fat'
 {
+    static_assert(max_files > 0, "At least one file must be allowed to open");
+
+    static_assert(types && !(types & ~petit_types),
+                  "FAT type is not built into Petite FAT, see CONFIG_FS_FAT_PETIT_TYPES");
+
+    static_assert(fs::is_block_device< Block >::value,
+                  "Block must implement block device interface, see fs/block.hpp");
+
 public:
     petit();
     ~petit();
     // Mounts a system and returns the root inode
     fs::inode_ptr mount();
 
+    // Maps data of a file to device blocks, so a large file can be read
+    // by multi-block requests, bypassing the filesystem. Consecutive
+    // blocks are merged into one extent. Gives amount of extents,
+    // or -1 if error or file has more than max extents.
+    ssize_t map_file(const char *path, fs::extent *out, size_t max, size_t &size);
+
+    // Gets the block device, i.e. to read mapped extents
+    Block &device() { return m_block; }
+
 private:
     // Get an estimated single allocation size
     // that will be used to store inodes.
@@ -34,50 +71,84 @@ private:
     static DRESULT disk_readp(void* disk_obj, BYTE* buff,
                               DWORD sector, UINT offser, UINT count);
 
+    // Reads a part of a sector, either through sector cache
+    // or straight from memory-mapped device
+    template< class Dev >
+    DRESULT read_piece(Dev &dev, BYTE* buff, DWORD sector, UINT offt, UINT count,
+                       std::false_type mapped);
+    template< class Dev >
+    DRESULT read_piece(Dev &dev, BYTE* buff, DWORD sector, UINT offt, UINT count,
+                       std::true_type mapped);
+
 
-    // TODO: make it configurable, i.e. by moving it to the template arguments
     // Memory pool where fat objects will reside
-    ecl::pool< get_alloc_blk_size(), 256 > m_pool;
+    ecl::pool< get_alloc_blk_size(), pool_size > m_pool;
     // Will be rebound to a proper object type each time allocation will occur
     allocator   m_alloc;
-    // Petite FAT object
-    FATFS       m_fat;
+    // Petite FAT object, shared by all objects of the filesystem
+    mount_state m_fat;
     // Block device on which FAT will operate
     Block       m_block;
+
+    // Petite FAT reads sectors piece by piece. Whole sectors are read once
+    // and pieces are served from the cache. Memory-mapped devices
+    // are accessed directly, so minimal cache is enough for them.
+    static constexpr size_t sector_size = 512;
+
+    using cache_type = typename std::conditional<
+        fs::is_mapped_device< Block >::value,
+        sector_cache< Block, 1, 0, sector_size >,
+        sector_cache< Block, 2, CONFIG_FS_FAT_PETIT_READAHEAD, sector_size >
+        >::type;
+
+    cache_type  m_cache;
 };
 
-template< class Block >
-petit< Block >::petit()
+template< class Block, size_t pool_size, size_t max_files, uint8_t types >
+petit< Block, pool_size, max_files, types >::petit()
     :m_pool{}
     ,m_alloc{&m_pool}
     ,m_fat{}
     ,m_block{}
+    ,m_cache{m_block}
 {
 }
 
-template< class Block >
-petit< Block >::~petit()
+template< class Block, size_t pool_size, size_t max_files, uint8_t types >
+petit< Block, pool_size, max_files, types >::~petit()
 {
 
 }
 
-template< class Block >
-fs::inode_ptr petit< Block >::mount()
+template< class Block, size_t pool_size, size_t max_files, uint8_t types >
+fs::inode_ptr petit< Block, pool_size, max_files, types >::mount()
 {
     m_block.init();
     m_block.open();
 
+    // TODO: support other sector sizes
+    ecl_assert(m_block.get_block_length() == sector_size);
+    m_cache.invalidate();
+
     // Pass block device bindings
     // that will be used by internal fat routines
-    m_fat.disk = {
-        reinterpret_cast< void * >(&m_block),
+    m_fat.files     = 0;
+    m_fat.max_files = max_files;
+    m_fat.fat.disk  = {
+        reinterpret_cast< void * >(this),
         disk_initialize,
         disk_writep,
         disk_readp
     };
 
     // TODO: error check!
-    auto res = pf_mount(&m_fat);
+    auto res = pf_mount(&m_fat.fat);
+    if (res == FR_OK && !((1 << m_fat.fat.fs_type) & types)) {
+        // Volume is left without root, so it is never reached
+        ecl::cout << "Mount error: FAT type is not allowed" << ecl::endl;
+        return fs::inode_ptr{};
+    }
+
     if (res == FR_OK) {
         ecl::cout << "Mounted!" << ecl::endl;
     } else {
@@ -91,8 +162,46 @@ fs::inode_ptr petit< Block >::mount()
     return iptr;
 }
 
-template< class Block >
-constexpr size_t petit< Block >::get_alloc_blk_size()
+template< class Block, size_t pool_size, size_t max_files, uint8_t types >
+ssize_t petit< Block, pool_size, max_files, types >::map_file(const char *path, fs::extent *out,
+                                                        size_t max, size_t &size)
+{
+    ecl_assert(path);
+
+    // Own copy of the FAT object, as files have
+    FATFS f = m_fat.fat;
+    size_t count = 0;
+
+    if (pf_open(&f, path) != FR_OK) {
+        return -1;
+    }
+
+    size = f.fsize;
+
+    // Reads without a buffer only walk the cluster chain, giving
+    // sector of each position
+    while (f.fptr < f.fsize) {
+        UINT chunk = f.fsize - f.fptr < sector_size ? f.fsize - f.fptr : sector_size;
+        UINT br;
+
+        if (pf_read(&f, nullptr, chunk, &br) != FR_OK || br != chunk) {
+            return -1;
+        }
+
+        if (count && out[count - 1].lba + out[count - 1].blocks == f.dsect) {
+            out[count - 1].blocks++;
+        } else if (count < max) {
+            out[count++] = fs::extent{f.dsect, 1};
+        } else {
+            return -1;
+        }
+    }
+
+    return count;
+}
+
+template< class Block, size_t pool_size, size_t max_files, uint8_t types >
+constexpr size_t petit< Block, pool_size, max_files, types >::get_alloc_blk_size()
 {
     // Determine a size of allocations.
     // The maximum size will be used as block size for the pool
@@ -132,47 +241,71 @@ constexpr size_t petit< Block >::get_alloc_blk_size()
 #endif
 }
 
-template< class Block >
-DSTATUS petit< Block >::disk_initialize(void* disk_obj)
+template< class Block, size_t pool_size, size_t max_files, uint8_t types >
+DSTATUS petit< Block, pool_size, max_files, types >::disk_initialize(void* disk_obj)
 {
-    Block *device = reinterpret_cast< Block* >(disk_obj);
+    petit *fat = reinterpret_cast< petit* >(disk_obj);
     // Do nothing?
-    ecl_assert(device);
+    ecl_assert(fat);
     return RES_OK;
 }
 
 
-template< class Block >
-DRESULT petit< Block >::disk_writep(void* disk_obj, const BYTE* buff, DWORD sc)
+template< class Block, size_t pool_size, size_t max_files, uint8_t types >
+DRESULT petit< Block, pool_size, max_files, types >::disk_writep(void* disk_obj, const BYTE* buff, DWORD sc)
 {
     (void) buff;
     (void) sc;
-    Block *device = reinterpret_cast< Block* >(disk_obj);
-    ecl_assert(device);
+    petit *fat = reinterpret_cast< petit* >(disk_obj);
+    ecl_assert(fat);
 
     return RES_OK;
 }
 
 
-template< class Block >
-DRESULT petit< Block >::disk_readp(void* disk_obj, BYTE* buff,
+template< class Block, size_t pool_size, size_t max_files, uint8_t types >
+DRESULT petit< Block, pool_size, max_files, types >::disk_readp(void* disk_obj, BYTE* buff,
                                    DWORD sector, UINT offser, UINT count)
 {
-    Block *device = reinterpret_cast< Block* >(disk_obj);
-    ecl_assert(device);
+    petit *fat = reinterpret_cast< petit* >(disk_obj);
+    ecl_assert(fat);
 
+    if (offser + count > sector_size) {
+        return RES_PARERR;
+    }
 
     if (buff) {
-        // TODO: is sector size always will be 512 bytes
-        off_t offt = sector * 512 + offser;
-        device->seek(offt);
-        ssize_t read = device->read(buff, count);
-        if (read < 0 || (size_t)read != count) {
-            return RES_ERROR;
-        }
+        return fat->read_piece(fat->m_block, buff, sector, offser, count,
+                               fs::is_mapped_device< Block >{});
     }
 
+    return RES_OK;
+}
+
+template< class Block, size_t pool_size, size_t max_files, uint8_t types >
+template< class Dev >
+DRESULT petit< Block, pool_size, max_files, types >::read_piece(Dev &dev, BYTE* buff, DWORD sector, UINT offt, UINT count,
+                                   std::false_type mapped)
+{
+    (void) mapped;
+    (void) dev;
+
+    return m_cache.read(sector, offt, buff, count) < 0 ? RES_ERROR : RES_OK;
+}
+
+template< class Block, size_t pool_size, size_t max_files, uint8_t types >
+template< class Dev >
+DRESULT petit< Block, pool_size, max_files, types >::read_piece(Dev &dev, BYTE* buff, DWORD sector, UINT offt, UINT count,
+                                   std::true_type mapped)
+{
+    (void) mapped;
+
+    auto data = dev.map_blocks(sector, 1);
+    if (!data) {
+        return RES_ERROR;
+    }
 
+    memcpy(buff, data + offt, count);
     return RES_OK;
 }
 
@@ -0,0 +1,50 @@
+#ifndef FATFS_NATIVE_DIR_HPP_
+#define FATFS_NATIVE_DIR_HPP_
+
+#include <fs/dir_descriptor.hpp>
+#include <fs/inode.hpp>
+
+#include "fat/types.hpp"
+#include "fat/native/volume.hpp"
+
+namespace fat
+{
+
+namespace native
+{
+
+class dir : public fs::dir_descriptor
+{
+public:
+    dir(const fs::inode_ptr &node, volume *vol, const allocator &alloc, uint32_t start);
+    virtual ~dir();
+
+    // Next entity in a dir
+    // nullptr returned if no more items
+    virtual fs::inode_ptr next() override;
+    // Reads next entries straight from dir entries
+    virtual ssize_t readdir(fs::dir_entry *out, size_t n) override;
+    // Finds an entity by name, without creating inodes for other entries
+    // nullptr returned if not found
+    virtual fs::inode_ptr find(const fs::name_view &name) override;
+    // Rewinds to the start of the dir
+    // -1 if error, 0 otherwise
+    virtual int rewind() override;
+    // Closes a dir
+    virtual int close() override;
+
+private:
+    // Creates an inode for given entry
+    fs::inode_ptr make_inode(const entry &e);
+
+    volume      *m_vol;
+    allocator   m_alloc;
+    dir_pos     m_pos;
+    bool        m_opened;
+};
+
+}
+
+}
+
+#endif // FATFS_NATIVE_DIR_HPP_
@@ -0,0 +1,48 @@
+#ifndef FATFS_NATIVE_DIR_INODE_HPP_
+#define FATFS_NATIVE_DIR_INODE_HPP_
+
+#include <sys/types.h>
+#include <fs/inode.hpp>
+#include <fs/types.hpp>
+#include <cstdint>
+
+#include "fat/types.hpp"
+#include "fat/native/volume.hpp"
+
+namespace fat
+{
+
+namespace native
+{
+
+class dir_inode : public fs::inode
+{
+public:
+    using type = typename fs::inode::type;
+
+    // Constructs this inode for given volume. Allocator is used for internal
+    // allocations. If entry is null then this inode represents root node.
+    dir_inode(volume *vol, const allocator &alloc, const entry *e = nullptr);
+    virtual ~dir_inode();
+
+    virtual type get_type() const override;
+    virtual fs::dir_ptr open_dir() override;
+    virtual ssize_t size() const override;
+    virtual ssize_t get_name(char *buf, size_t buf_sz) const override;
+    virtual fs::inode_ptr create(const char *name, type t) override;
+
+    // First cluster of this dir
+    uint32_t start() const { return m_start; }
+
+private:
+    volume      *m_vol;     // The volume object
+    allocator   m_alloc;    // The allocator to create various objects
+    uint32_t    m_start;    // First cluster of this dir
+    char        m_name[13]; // Name of this dir, empty for root
+};
+
+}
+
+}
+
+#endif // FATFS_NATIVE_DIR_INODE_HPP_
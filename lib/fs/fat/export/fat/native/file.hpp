@@ -0,0 +1,68 @@
+#ifndef FATFS_NATIVE_FILE_HPP_
+#define FATFS_NATIVE_FILE_HPP_
+
+#include <fs/file_descriptor.hpp>
+#include <fs/inode.hpp>
+
+#include "fat/types.hpp"
+#include "fat/native/volume.hpp"
+
+namespace fat
+{
+
+namespace native
+{
+
+class file : public fs::file_descriptor
+{
+public:
+    file(const fs::inode_weak &node, volume *vol, const allocator &alloc);
+    virtual ~file();
+
+    virtual ssize_t read(uint8_t *buf, size_t size) override;
+    virtual ssize_t write(const uint8_t *buf, size_t size) override;
+    // Whole sectors in contiguous clusters are transferred by async device
+    // request, if device supports it. Other I/O is done in place.
+    // Writes that extend a file are always done in place.
+    virtual int read_async(uint8_t *buf, size_t size, const io_callback &cb) override;
+    virtual int write_async(const uint8_t *buf, size_t size, const io_callback &cb) override;
+    // Seeking past the end of a file is not allowed
+    virtual int seek(off_t offt, seekdir way = seekdir::beg) override;
+    virtual off_t tell() override;
+    // Updates dir entry and flushes all cached data to the device
+    virtual int close() override;
+    // Seek map is dropped, as the chain may be changed meanwhile
+    virtual int reopen() override;
+    // Points into device memory when possible, otherwise data is read
+    // to a buffer, allocated from the filesystem pool
+    virtual const uint8_t *map(off_t offt, size_t len) override;
+
+private:
+    entry& get_entry();
+    void release_bounce();
+    int start_async(uint8_t *buf, size_t size, const io_callback &cb, bool write);
+    static void async_done(void *ctx, int status);
+
+    volume      *m_vol;
+    allocator   m_alloc;    // Allocator for a bounce buffer
+    uint8_t     *m_bounce;  // Buffer, used if data can't be mapped
+    size_t      m_bounce_sz;
+    cluster_map m_map;      // Map for seeking, built on first seek
+    cursor      m_cur;      // Cluster of a current position
+    uint32_t    m_offt;     // Current position
+    bool        m_dirty;    // Entry must be updated on close
+    bool        m_opened;
+
+    // Async I/O in progress
+    bool        m_async_busy;
+    bool        m_async_write;
+    cursor      m_async_cur;    // Cursor after the request
+    size_t      m_async_len;    // Bytes in the request
+    io_callback m_async_cb;
+};
+
+}
+
+}
+
+#endif // FATFS_NATIVE_FILE_HPP_
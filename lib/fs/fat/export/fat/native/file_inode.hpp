@@ -0,0 +1,42 @@
+#ifndef FATFS_NATIVE_FILE_INODE_HPP_
+#define FATFS_NATIVE_FILE_INODE_HPP_
+
+#include <sys/types.h>
+#include <cstdint>
+#include <fs/inode.hpp>
+
+#include "fat/types.hpp"
+#include "fat/native/volume.hpp"
+
+namespace fat
+{
+
+namespace native
+{
+
+class file_inode : public fs::inode
+{
+public:
+    using type = typename fs::inode::type;
+
+    file_inode(volume *vol, const allocator &alloc, const entry &e);
+    virtual ~file_inode();
+    virtual type get_type() const override;
+    virtual fs::file_ptr open() override;
+    virtual ssize_t size() const override;
+    virtual ssize_t get_name(char *buf, size_t buf_sz) const override;
+
+    // Entry is shared between all descriptors of this file
+    entry& get_entry() { return m_entry; }
+
+private:
+    volume      *m_vol;     // The volume object
+    allocator   m_alloc;    // Allocator for internal use
+    entry       m_entry;    // Dir entry of a file
+};
+
+}
+
+}
+
+#endif // FATFS_NATIVE_FILE_INODE_HPP_
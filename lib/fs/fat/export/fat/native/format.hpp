@@ -0,0 +1,118 @@
+#ifndef FATFS_NATIVE_FORMAT_HPP_
+#define FATFS_NATIVE_FORMAT_HPP_
+
+#include "fat/native/volume.hpp"
+
+#include <cstring>
+
+namespace fat
+{
+
+namespace native
+{
+
+namespace detail
+{
+
+inline void st16(uint8_t *p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+inline void st32(uint8_t *p, uint32_t v)
+{
+    st16(p, v);
+    st16(p + 2, v >> 16);
+}
+
+} // namespace detail
+
+// Creates an empty, unpartitioned FAT32 volume over whole device, as mkfs
+// would do. FAT32 needs at least 65525 clusters, so device must hold more
+// than 65525 clusters of given amount of sectors, a power of two up to 128.
+// Device content is destroyed. -1 if error, 0 otherwise.
+inline int format(const volume::disk &d, uint32_t blocks, uint8_t cluster_sectors = 1)
+{
+    using namespace detail;
+
+    constexpr uint16_t reserved = 32;
+    uint8_t sector[volume::sector_size] = {};
+
+    if (!cluster_sectors || (cluster_sectors & (cluster_sectors - 1))
+            || blocks <= reserved + 2) {
+        return -1;
+    }
+
+    // Smallest FAT that covers all clusters left after FATs themselves
+    uint32_t fat_len = 1;
+    while (((blocks - reserved - 2 * fat_len) / cluster_sectors + 2) * 4
+            > fat_len * volume::sector_size) {
+        ++fat_len;
+    }
+
+    if (blocks < reserved + 2 * fat_len
+            || (blocks - reserved - 2 * fat_len) / cluster_sectors < 65525) {
+        return -1;
+    }
+
+    sector[0] = 0xeb;
+    sector[1] = 0x58;
+    sector[2] = 0x90;
+    memcpy(sector + 3, "ECLFAT  ", 8);
+    st16(sector + 11, volume::sector_size);
+    sector[13] = cluster_sectors;
+    st16(sector + 14, reserved);
+    sector[16] = 2;
+    sector[21] = 0xf8;
+    st32(sector + 32, blocks);
+    st32(sector + 36, fat_len);
+    st32(sector + 44, 2);
+    st16(sector + 48, 1);
+    sector[66] = 0x29;
+    memcpy(sector + 82, "FAT32   ", 8);
+    st16(sector + 510, 0xaa55);
+
+    if (d.write(d.obj, 0, sector, 1) < 0) {
+        return -1;
+    }
+
+    // FSInfo, free count is unknown
+    memset(sector, 0, sizeof(sector));
+    st32(sector, 0x41615252);
+    st32(sector + 484, 0x61417272);
+    st32(sector + 488, 0xffffffff);
+    st32(sector + 492, 3);
+    st32(sector + 508, 0xaa550000);
+
+    if (d.write(d.obj, 1, sector, 1) < 0) {
+        return -1;
+    }
+
+    // Rest of reserved area, both FATs and the root dir cluster are zeroed
+    memset(sector, 0, sizeof(sector));
+    for (uint32_t lba = 2; lba < reserved + 2 * fat_len + cluster_sectors; ++lba) {
+        if (d.write(d.obj, lba, sector, 1) < 0) {
+            return -1;
+        }
+    }
+
+    // Media, end-of-chain marker and the root dir cluster
+    st32(sector, 0x0ffffff8);
+    st32(sector + 4, 0x0fffffff);
+    st32(sector + 8, 0x0fffffff);
+
+    for (uint32_t fat = 0; fat < 2; ++fat) {
+        if (d.write(d.obj, reserved + fat * fat_len, sector, 1) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace native
+
+} // namespace fat
+
+#endif // FATFS_NATIVE_FORMAT_HPP_
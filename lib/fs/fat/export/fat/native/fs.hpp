@@ -0,0 +1,229 @@
+#ifndef FATFS_NATIVE_FILESYSTEM_HPP_
+#define FATFS_NATIVE_FILESYSTEM_HPP_
+
+#include "fat/types.hpp"
+#include "fat/native/volume.hpp"
+#include "fat/native/dir_inode.hpp"
+
+#include <ecl/pool.hpp>
+#include <fs/inode.hpp>
+#include <fs/block.hpp>
+#include <ecl/iostream.hpp>
+#include <ecl/assert.h>
+
+namespace fat
+{
+
+namespace native
+{
+
+// Read-write FAT16/FAT32 filesystem on top of a block device.
+// Unlike petit, files can be created, written and seeked, and any number
+// of files can be opened at once. Pool holds all inodes and descriptors
+// of the filesystem, so pool_size limits amount of objects alive at once.
+template< class Block, size_t pool_size = 256 >
+class filesystem
+{
+    static_assert(fs::is_block_device< Block >::value,
+                  "Block must implement block device interface, see fs/block.hpp");
+
+public:
+    filesystem();
+    ~filesystem();
+    // Mounts a system and returns the root inode, nullptr if error
+    fs::inode_ptr mount();
+    // Writes all cached data to the device
+    // -1 if error, 0 otherwise
+    int sync();
+
+private:
+    // Block device bindings
+    static int disk_read(void *disk_obj, uint32_t lba, uint8_t *buf, size_t n);
+    static int disk_write(void *disk_obj, uint32_t lba, const uint8_t *buf, size_t n);
+
+    // Mapping binding, provided only for memory-mapped devices
+    using map_fn = const uint8_t *(*)(void *disk_obj, uint32_t lba, size_t n);
+
+    template< class Dev >
+    static map_fn disk_map_binding(std::true_type mapped);
+    template< class Dev >
+    static map_fn disk_map_binding(std::false_type mapped);
+    template< class Dev >
+    static const uint8_t *disk_map(void *disk_obj, uint32_t lba, size_t n);
+
+    // Async bindings, provided only for devices that complete requests
+    // in background, see fs::is_callback_device
+    template< class Dev >
+    static void disk_async_binding(volume::disk &d, std::true_type async);
+    template< class Dev >
+    static void disk_async_binding(volume::disk &d, std::false_type async);
+    template< class Dev >
+    static int disk_read_async(void *disk_obj, uint32_t lba, uint8_t *buf, size_t n,
+                               volume::done_fn done, void *ctx);
+    template< class Dev >
+    static int disk_write_async(void *disk_obj, uint32_t lba, const uint8_t *buf, size_t n,
+                                volume::done_fn done, void *ctx);
+
+    // Memory pool where fat objects will reside
+    ecl::pool< alignof(std::max_align_t), pool_size > m_pool;
+    // Will be rebound to a proper object type each time allocation will occur
+    allocator   m_alloc;
+    // FAT engine
+    volume      m_vol;
+    // Block device on which FAT will operate
+    Block       m_block;
+};
+
+template< class Block, size_t pool_size >
+filesystem< Block, pool_size >::filesystem()
+    :m_pool{}
+    ,m_alloc{&m_pool}
+    ,m_vol{}
+    ,m_block{}
+{
+}
+
+template< class Block, size_t pool_size >
+filesystem< Block, pool_size >::~filesystem()
+{
+    m_vol.sync();
+}
+
+template< class Block, size_t pool_size >
+fs::inode_ptr filesystem< Block, pool_size >::mount()
+{
+    m_block.init();
+
+    if (m_block.open() < 0) {
+        return fs::inode_ptr{};
+    }
+
+    // TODO: support other sector sizes
+    ecl_assert(m_block.get_block_length() == volume::sector_size);
+
+    volume::disk d = {
+        this,
+        disk_read,
+        disk_write,
+        disk_map_binding< Block >(fs::is_mapped_device< Block >{}),
+        nullptr,
+        nullptr
+    };
+
+    disk_async_binding< Block >(d, fs::is_callback_device< Block >{});
+
+    if (m_vol.mount(d, m_block.block_count()) < 0) {
+        ecl::cout << "Mount error" << ecl::endl;
+        return fs::inode_ptr{};
+    }
+
+    auto iptr = ecl::allocate_shared< dir_inode >(m_alloc, &m_vol, m_alloc);
+    iptr->set_weak(iptr);
+
+    return iptr;
+}
+
+template< class Block, size_t pool_size >
+int filesystem< Block, pool_size >::sync()
+{
+    return m_vol.sync();
+}
+
+template< class Block, size_t pool_size >
+int filesystem< Block, pool_size >::disk_read(void *disk_obj, uint32_t lba, uint8_t *buf, size_t n)
+{
+    auto fs = reinterpret_cast< filesystem* >(disk_obj);
+    ecl_assert(fs);
+
+    return fs->m_block.read_blocks(lba, buf, n) < 0 ? -1 : 0;
+}
+
+template< class Block, size_t pool_size >
+int filesystem< Block, pool_size >::disk_write(void *disk_obj, uint32_t lba, const uint8_t *buf, size_t n)
+{
+    auto fs = reinterpret_cast< filesystem* >(disk_obj);
+    ecl_assert(fs);
+
+    return fs->m_block.write_blocks(lba, buf, n) < 0 ? -1 : 0;
+}
+
+template< class Block, size_t pool_size >
+template< class Dev >
+typename filesystem< Block, pool_size >::map_fn
+filesystem< Block, pool_size >::disk_map_binding(std::true_type mapped)
+{
+    (void) mapped;
+    return disk_map< Dev >;
+}
+
+template< class Block, size_t pool_size >
+template< class Dev >
+typename filesystem< Block, pool_size >::map_fn
+filesystem< Block, pool_size >::disk_map_binding(std::false_type mapped)
+{
+    (void) mapped;
+    return nullptr;
+}
+
+template< class Block, size_t pool_size >
+template< class Dev >
+const uint8_t *filesystem< Block, pool_size >::disk_map(void *disk_obj, uint32_t lba, size_t n)
+{
+    auto fs = reinterpret_cast< filesystem* >(disk_obj);
+    ecl_assert(fs);
+
+    const Dev &dev = fs->m_block;
+    return dev.map_blocks(lba, n);
+}
+
+template< class Block, size_t pool_size >
+template< class Dev >
+void filesystem< Block, pool_size >::disk_async_binding(volume::disk &d, std::true_type async)
+{
+    (void) async;
+    d.read_async  = disk_read_async< Dev >;
+    d.write_async = disk_write_async< Dev >;
+}
+
+template< class Block, size_t pool_size >
+template< class Dev >
+void filesystem< Block, pool_size >::disk_async_binding(volume::disk &d, std::false_type async)
+{
+    (void) d;
+    (void) async;
+}
+
+template< class Block, size_t pool_size >
+template< class Dev >
+int filesystem< Block, pool_size >::disk_read_async(void *disk_obj, uint32_t lba, uint8_t *buf,
+                                                    size_t n, volume::done_fn done, void *ctx)
+{
+    auto fs = reinterpret_cast< filesystem* >(disk_obj);
+    ecl_assert(fs);
+
+    Dev &dev = fs->m_block;
+    return dev.read_blocks_async(lba, buf, n, [done, ctx](int status) {
+        done(ctx, status < 0 ? -1 : 0);
+    }) < 0 ? -1 : 0;
+}
+
+template< class Block, size_t pool_size >
+template< class Dev >
+int filesystem< Block, pool_size >::disk_write_async(void *disk_obj, uint32_t lba,
+                                                     const uint8_t *buf, size_t n,
+                                                     volume::done_fn done, void *ctx)
+{
+    auto fs = reinterpret_cast< filesystem* >(disk_obj);
+    ecl_assert(fs);
+
+    Dev &dev = fs->m_block;
+    return dev.write_blocks_async(lba, buf, n, [done, ctx](int status) {
+        done(ctx, status < 0 ? -1 : 0);
+    }) < 0 ? -1 : 0;
+}
+
+}
+
+}
+
+#endif // FATFS_NATIVE_FILESYSTEM_HPP_
@@ -0,0 +1,274 @@
+#ifndef FATFS_NATIVE_VOLUME_HPP_
+#define FATFS_NATIVE_VOLUME_HPP_
+
+#include <sys/types.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace fat
+{
+
+namespace native
+{
+
+// Directory entry, as seen by the engine
+struct entry
+{
+    char        name[13];   // "NAME.EXT", null-terminated
+    uint8_t     attr;       // FAT attributes
+    uint32_t    cluster;    // First cluster, 0 if nothing is allocated
+    uint32_t    size;       // Size of a file, in bytes
+    uint32_t    sector;     // Sector, where entry resides
+    uint16_t    offset;     // Offset of the entry within the sector
+};
+
+// Position within a directory, used for iteration
+struct dir_pos
+{
+    uint32_t    start;      // First cluster of a dir, 0 for FAT16 root
+    uint32_t    cluster;    // Current cluster
+    uint32_t    cl_index;   // Index of current cluster in the chain
+    uint32_t    index;      // Index of next entry
+};
+
+// Map of a cluster chain, as a list of contiguous runs. Lets random access
+// find a cluster without reading FAT. Only the beginning of a chain is
+// mapped if it consists of more runs than the map can hold.
+struct cluster_map
+{
+    static constexpr size_t max_runs = 8;
+
+    struct run
+    {
+        uint32_t    start;  // First cluster of a run
+        uint32_t    length; // Amount of clusters in a run
+    };
+
+    uint32_t    first;      // First cluster of a mapped chain
+    uint32_t    count;      // Amount of runs, 0 if map is not built
+    run         runs[max_runs];
+};
+
+// Position within a file cluster chain. Lets sequential access avoid
+// walking the chain from the beginning every time.
+struct cursor
+{
+    uint32_t            cluster;    // Cluster, 0 if position is unknown
+    uint32_t            index;      // Index of the cluster in the chain
+    const cluster_map   *map;       // Map of the chain, optional
+};
+
+// Native FAT16/FAT32 engine.
+// Volume operates on whole sectors of a block device. It keeps:
+//  - write-back LRU cache of FAT sectors, so allocation and chain walking
+//    do not touch the device every time;
+//  - single sector window, used for directory entries and partial
+//    data sectors.
+// Data that covers whole sectors is transferred directly between user
+// buffer and the device, in runs spanning contiguous clusters.
+// Long names can be used for lookup, but only 8.3 names are created.
+class volume
+{
+public:
+    // Completion of async device request, receives its status
+    using done_fn = void (*)(void *ctx, int status);
+    // Source of current time: FAT date in upper half, FAT time in lower
+    // half, see ecl::to_fat(). Called on each entry update, so it must
+    // be cheap.
+    using time_fn = uint32_t (*)();
+
+    // Block device bindings, negative value if error, 0 otherwise.
+    // Mapping is optional, it is provided by memory-mapped devices only.
+    // Async I/O is optional, it is provided by devices that complete
+    // requests in background. Negative if request is not started.
+    struct disk
+    {
+        void            *obj;
+        int             (*read)(void *obj, uint32_t lba, uint8_t *buf, size_t n);
+        int             (*write)(void *obj, uint32_t lba, const uint8_t *buf, size_t n);
+        const uint8_t   *(*map)(void *obj, uint32_t lba, size_t n);
+        int             (*read_async)(void *obj, uint32_t lba, uint8_t *buf, size_t n,
+                                      done_fn done, void *ctx);
+        int             (*write_async)(void *obj, uint32_t lba, const uint8_t *buf, size_t n,
+                                       done_fn done, void *ctx);
+    };
+
+    // FAT entry attributes
+    static constexpr uint8_t attr_ro       = 0x01;
+    static constexpr uint8_t attr_hidden   = 0x02;
+    static constexpr uint8_t attr_system   = 0x04;
+    static constexpr uint8_t attr_label    = 0x08;
+    static constexpr uint8_t attr_dir      = 0x10;
+    static constexpr uint8_t attr_archive  = 0x20;
+    static constexpr uint8_t attr_lfn      = 0x0f;
+
+    static constexpr size_t  sector_size   = 512;
+    static constexpr size_t  max_long_name = 255;
+
+    volume();
+
+    // Sets source of timestamps for all volumes. Without it, entries get
+    // a fixed date. Null resets the source.
+    static void set_time_source(time_fn fn);
+
+    // Mounts a volume, located on a device with given amount of blocks.
+    // Either unpartitioned device or first MBR partition is used.
+    // -1 if error, 0 otherwise.
+    int mount(const disk &d, uint32_t blocks);
+    // Writes all cached data to the device. -1 if error, 0 otherwise.
+    int sync();
+
+    // Returns first cluster of the root dir, 0 for FAT16 root
+    uint32_t root() const;
+    // Returns size of a cluster, in bytes
+    uint32_t cluster_size() const;
+
+    // Directories -------------------------------------------------------------
+
+    // Starts iteration over dir, that begins from given cluster
+    void dir_open(dir_pos &pos, uint32_t start) const;
+    // Gets next entry of a dir, skipping dot entries and labels.
+    // Long name of an entry is placed to the buffer, if it is provided, and
+    // if name fits. Otherwise buffer holds empty string.
+    // -1 if error, 0 if there is no more entries, 1 otherwise.
+    int dir_next(dir_pos &pos, entry &e, char *long_name = nullptr, size_t long_len = 0);
+    // Finds entry by short or long name, case-insensitive.
+    // -1 if error, 0 if not found, 1 otherwise.
+    int dir_find(uint32_t start, const char *name, entry &e);
+    // Same, name is given by length and may be not null-terminated
+    int dir_find(uint32_t start, const char *name, size_t len, entry &e);
+    // Creates an empty file or a dir with given name.
+    // -1 if error, i.e. name is invalid or already exists, 0 otherwise.
+    int dir_create(uint32_t start, const char *name, uint8_t attr, entry &e);
+    // Writes size and first cluster from the entry back to the dir.
+    // -1 if error, 0 otherwise.
+    int entry_update(const entry &e);
+
+    // Files -------------------------------------------------------------------
+
+    // Reads file data from given offset, up to the end of a file.
+    // -1 if error, amount of bytes read otherwise.
+    ssize_t read(const entry &e, cursor &cur, uint32_t offt, uint8_t *buf, size_t size);
+    // Writes file data to given offset, allocating clusters as needed.
+    // Size in the entry is updated, but not written back to the dir.
+    // -1 if error, amount of bytes written otherwise.
+    ssize_t write(entry &e, cursor &cur, uint32_t offt, const uint8_t *buf, size_t size);
+    // Starts a device request for file data from given offset, done in
+    // background. Only whole sectors, that lie inside a file in contiguous
+    // clusters, are transferred. Writes never extend a file. Size is cut
+    // to the request length and cursor is moved before the request starts.
+    // -1 if device doesn't support async I/O, data can't be transferred
+    // this way or request is not started, 0 otherwise.
+    int start_xfer(const entry &e, cursor &cur, uint32_t offt, uint8_t *buf, size_t &size,
+                   bool write, done_fn done, void *ctx);
+
+    // Gets pointer to file data in device memory. Possible only if device
+    // is memory-mapped and data lies in contiguous clusters.
+    // nullptr if error or mapping is not possible.
+    const uint8_t *map(const entry &e, cursor &cur, uint32_t offt, size_t size);
+    // Builds a map of a chain, starting from given cluster.
+    // -1 if error, 0 otherwise.
+    int map_chain(uint32_t first, cluster_map &map);
+
+    volume(const volume&) = delete;
+    volume& operator=(const volume&) = delete;
+
+private:
+    enum class fat_type
+    {
+        none,
+        fat16,
+        fat32,
+    };
+
+    static constexpr uint32_t no_sector     = 0xffffffff;
+    static constexpr size_t   fat_cache_len = 4;
+
+    // Cached FAT sector
+    struct fat_sector
+    {
+        uint32_t    sector;     // FAT sector number, relative to FAT start
+        bool        dirty;      // Sector was modified
+        uint32_t    used;       // Time of last access, for LRU eviction
+        uint8_t     data[sector_size];
+    };
+
+    int probe(uint32_t lba);
+
+    // Sector window
+    int move_window(uint32_t sector, bool load = true);
+    int sync_window();
+
+    // FAT access
+    fat_sector *fat_load(uint32_t sector);
+    int fat_flush(fat_sector &s);
+    int fat_get(uint32_t cluster, uint32_t &val);
+    int fat_set(uint32_t cluster, uint32_t val);
+    bool is_eoc(uint32_t val) const;
+    uint32_t eoc() const;
+
+    // Cluster chains
+    int alloc_cluster(uint32_t prev, uint32_t &cluster);
+    int clear_cluster(uint32_t cluster);
+    // Moves cursor to cluster with given index in the chain. Chain is extended
+    // by allocating clusters if requested.
+    // -1 if error, 0 if chain ended before the cluster, 1 otherwise.
+    int seek_cluster(uint32_t first, cursor &cur, uint32_t index, bool extend);
+    // Counts sectors that can be transferred at once, starting from given
+    // sector of current cluster. Cursor is moved to the last cluster of a run.
+    int contiguous_run(cursor &cur, uint32_t sec_in, uint32_t wanted, bool extend,
+                       uint32_t &count);
+    uint32_t cluster_lba(uint32_t cluster) const;
+    bool valid_cluster(uint32_t cluster) const;
+
+    // Dir entries.
+    // Gets sector, holding entry at current dir position.
+    // -1 if error, 0 if end of dir is reached, 1 otherwise.
+    int dir_sector(dir_pos &pos, uint32_t &sector);
+    // Compares name of given length with null-terminated one
+    static bool same_name(const char *a, size_t len, const char *b);
+    static uint8_t lfn_checksum(const uint8_t *raw);
+    // Places part of a long name from the entry to the buffer.
+    // Returns order number of the entry, 0 if sequence is broken.
+    static uint8_t decode_lfn(const uint8_t *raw, uint8_t expected, uint8_t &sum,
+                              char *name, size_t len);
+    static void decode_name(const uint8_t *raw, char *name);
+    static bool encode_name(const char *name, uint8_t *raw);
+    static void decode_entry(const uint8_t *raw, entry &e);
+    static void stamp_entry(uint8_t *raw);
+    // Gets current FAT timestamp
+    static uint32_t now();
+
+    // Read-modify-write of FSInfo
+    int sync_info();
+
+    disk        m_disk;
+    fat_type    m_type;
+    uint32_t    m_blocks;       // Size of the device
+    uint32_t    m_spc;          // Sectors per cluster
+    uint32_t    m_fat_lba;      // First sector of first FAT
+    uint32_t    m_fat_len;      // Sectors per FAT
+    uint8_t     m_fats;         // Amount of FAT copies
+    uint32_t    m_root_lba;     // First sector of FAT16 root dir
+    uint32_t    m_root_len;     // Sectors in FAT16 root dir
+    uint32_t    m_root_cl;      // Root cluster of FAT32
+    uint32_t    m_data_lba;     // First sector of cluster 2
+    uint32_t    m_clusters;     // Amount of data clusters
+    uint32_t    m_info_lba;     // FSInfo sector, 0 if not present
+    uint32_t    m_free;         // Free clusters, 0xffffffff if unknown
+    uint32_t    m_next_free;    // Allocation hint
+    bool        m_info_dirty;   // FSInfo must be updated
+
+    uint8_t     m_win[sector_size];     // Sector window
+    uint32_t    m_win_sector;           // Sector held in the window
+    bool        m_win_dirty;            // Window was modified
+
+    fat_sector  m_fat_cache[fat_cache_len];
+    uint32_t    m_clock;                // FAT cache access counter
+};
+
+} // namespace native
+
+} // namespace fat
+
+#endif // FATFS_NATIVE_VOLUME_HPP_
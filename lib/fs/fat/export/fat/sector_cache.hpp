@@ -0,0 +1,196 @@
+#ifndef FATFS_SECTOR_CACHE_HPP_
+#define FATFS_SECTOR_CACHE_HPP_
+
+#include <fs/block.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string.h>
+
+namespace fat
+{
+
+// Read cache of whole sectors, placed between a filesystem reading sectors
+// piece by piece and a block device, see fs/block.hpp.
+//
+// Two kinds of sectors are held:
+//  - LRU set of single sectors, for random accesses like FAT entries
+//    and a boot record;
+//  - readahead window of consecutive sectors. When a miss follows the
+//    previous one, or hits the sector right after the window, access is
+//    considered sequential and the window is refilled by a single
+//    multi-block request. Directory walks and file reads go there.
+//
+// Set readahead to 0 to disable the window.
+template< class Block, size_t slots = 2, size_t readahead = 4, size_t sector_size = 512 >
+class sector_cache
+{
+    static_assert(slots > 0, "At least one sector slot is required");
+
+public:
+    struct stats
+    {
+        uint32_t hits;      // Pieces served from the cache
+        uint32_t misses;    // Pieces that required device access
+        uint32_t requests;  // Device requests issued
+    };
+
+    sector_cache(Block &dev);
+
+    // Drops all cached sectors, i.e. when the device is remounted
+    void invalidate();
+
+    // Copies part of a sector to the buffer. -1 if error, 0 otherwise.
+    int read(uint32_t sector, size_t offt, uint8_t *buf, size_t count);
+
+    const stats &get_stats() const { return m_stats; }
+
+private:
+    static constexpr uint32_t no_sector = 0xffffffff;
+
+    // Cached single sector
+    struct slot
+    {
+        uint32_t    sector;     // Sector number, no_sector if empty
+        uint32_t    used;       // Time of last access, for LRU eviction
+        uint8_t     data[sector_size];
+    };
+
+    // Gets data of the sector, loading it if needed. Nullptr if error.
+    const uint8_t *lookup(uint32_t sector);
+    const uint8_t *load_window(uint32_t sector);
+    const uint8_t *load_slot(uint32_t sector);
+
+    bool in_window(uint32_t sector) const
+    {
+        return m_win_len && sector >= m_win_first && sector - m_win_first < m_win_len;
+    }
+
+    Block       &m_dev;
+    slot        m_slots[slots];
+    uint32_t    m_clock;                // Slot access counter
+    uint32_t    m_last_miss;            // Sector of the last miss
+    uint32_t    m_win_first;            // First sector in the window
+    uint32_t    m_win_len;              // Sectors held in the window
+    uint8_t     m_win[readahead ? readahead * sector_size : 1];
+    stats       m_stats;
+};
+
+template< class Block, size_t slots, size_t readahead, size_t sector_size >
+sector_cache< Block, slots, readahead, sector_size >::sector_cache(Block &dev)
+    :m_dev{dev}
+    ,m_slots{}
+    ,m_clock{0}
+    ,m_last_miss{no_sector}
+    ,m_win_first{0}
+    ,m_win_len{0}
+    ,m_win{}
+    ,m_stats{}
+{
+    invalidate();
+}
+
+template< class Block, size_t slots, size_t readahead, size_t sector_size >
+void sector_cache< Block, slots, readahead, sector_size >::invalidate()
+{
+    for (auto &s : m_slots) {
+        s.sector = no_sector;
+        s.used   = 0;
+    }
+
+    m_last_miss = no_sector;
+    m_win_len   = 0;
+}
+
+template< class Block, size_t slots, size_t readahead, size_t sector_size >
+int sector_cache< Block, slots, readahead, sector_size >::read(uint32_t sector, size_t offt,
+                                                               uint8_t *buf, size_t count)
+{
+    if (offt > sector_size || count > sector_size - offt) {
+        return -1;
+    }
+
+    auto data = lookup(sector);
+    if (!data) {
+        return -1;
+    }
+
+    memcpy(buf, data + offt, count);
+    return 0;
+}
+
+template< class Block, size_t slots, size_t readahead, size_t sector_size >
+const uint8_t *sector_cache< Block, slots, readahead, sector_size >::lookup(uint32_t sector)
+{
+    if (in_window(sector)) {
+        m_stats.hits++;
+        return m_win + (sector - m_win_first) * sector_size;
+    }
+
+    for (auto &s : m_slots) {
+        if (s.sector == sector) {
+            s.used = ++m_clock;
+            m_stats.hits++;
+            return s.data;
+        }
+    }
+
+    m_stats.misses++;
+
+    bool sequential = (m_last_miss != no_sector && sector == m_last_miss + 1)
+            || (m_win_len && sector == m_win_first + m_win_len);
+
+    m_last_miss = sector;
+
+    if (readahead && sequential) {
+        return load_window(sector);
+    }
+
+    return load_slot(sector);
+}
+
+template< class Block, size_t slots, size_t readahead, size_t sector_size >
+const uint8_t *sector_cache< Block, slots, readahead, sector_size >::load_window(uint32_t sector)
+{
+    // Window must not run past the device end
+    size_t count = m_dev.block_count();
+    size_t len = count > sector && count - sector < readahead ? count - sector : readahead;
+
+    m_win_len = 0;
+    m_stats.requests++;
+
+    if (!len || m_dev.read_blocks(sector, m_win, len) < 0) {
+        return nullptr;
+    }
+
+    m_win_first = sector;
+    m_win_len   = len;
+    return m_win;
+}
+
+template< class Block, size_t slots, size_t readahead, size_t sector_size >
+const uint8_t *sector_cache< Block, slots, readahead, sector_size >::load_slot(uint32_t sector)
+{
+    auto victim = &m_slots[0];
+
+    for (auto &s : m_slots) {
+        if (s.used < victim->used) {
+            victim = &s;
+        }
+    }
+
+    victim->sector = no_sector;
+    m_stats.requests++;
+
+    if (m_dev.read_blocks(sector, victim->data, 1) < 0) {
+        return nullptr;
+    }
+
+    victim->sector = sector;
+    victim->used   = ++m_clock;
+    return victim->data;
+}
+
+} // namespace fat
+
+#endif // FATFS_SECTOR_CACHE_HPP_
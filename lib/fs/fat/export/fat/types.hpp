@@ -3,10 +3,31 @@
 
 #include <ecl/pool.hpp>
 
+#include "src/pff.h"
+
 namespace fat
 {
     // Defines common allocator type for all fat objects
     using allocator = ecl::pool_allocator< uint8_t >;
+
+    // FAT types, combined as flags, i.e. to select ones that petit
+    // is allowed to mount
+    static constexpr uint8_t fat12 = 1 << FS_FAT12;
+    static constexpr uint8_t fat16 = 1 << FS_FAT16;
+    static constexpr uint8_t fat32 = 1 << FS_FAT32;
+
+    // Types built into Petite FAT, see CONFIG_FS_FAT_PETIT_TYPES
+    static constexpr uint8_t petit_types = (_FS_FAT12 ? fat12 : 0)
+                                         | (_FS_FAT16 ? fat16 : 0)
+                                         | (_FS_FAT32 ? fat32 : 0);
+
+    // State of a mounted filesystem, shared by all its objects
+    struct mount_state
+    {
+        FATFS   fat;        // Petite FAT object
+        size_t  files;      // Amount of opened files
+        size_t  max_files;  // Limit of simultaneously opened files
+    };
 }
 
 #endif
@@ -1,28 +1,49 @@
 // TODO: rename it to 'file descriptor'
 #include "fat/file.hpp"
 
+#include <ecl/prof.hpp>
+
 using namespace fat;
 
-file::file(const fs::inode_weak &node, FATFS *fs)
+file::file(const fs::inode_weak &node, mount_state *fs)
     :fs::file_descriptor{node}
-    ,m_fs{fs}
-    ,m_opened{true} // When constructed it is already opened
+    ,m_state{fs}
+    ,m_fs(fs->fat)
+    ,m_counted{true}
+    ,m_opened{false}
 {
+    m_state->files++;
 }
 
 file::~file()
 {
+    close();
+}
+
+int file::open(const char *path)
+{
+    ecl_assert(path);
+    ecl_assert(!m_opened);
+
+    if (pf_open(&m_fs, path) != FR_OK) {
+        return -1;
+    }
+
+    m_opened = true;
+    return 0;
 }
 
 ssize_t file::read(uint8_t *buf, size_t size)
 {
+    ECL_TRACE_SCOPE("fat.petit.read");
+
     ecl_assert(buf);
     ecl_assert(size); // TODO: for now
 
     if (m_opened) {
-        size_t read;
+        UINT read;
 
-        FRESULT res = pf_read(m_fs, reinterpret_cast< void* >(buf), size, &read);
+        FRESULT res = pf_read(&m_fs, reinterpret_cast< void* >(buf), size, &read);
 
         if (res == FR_OK)
             return read;
@@ -33,14 +54,16 @@ ssize_t file::read(uint8_t *buf, size_t size)
 
 ssize_t file::write(const uint8_t *buf, size_t size)
 {
+    ECL_TRACE_SCOPE("fat.petit.write");
+
     ecl_assert(buf);
     ecl_assert(size); // TODO: for now
 
 #if _USE_WRITE
     if (m_opened) {
-        size_t written;
+        UINT written;
 
-        FRESULT res = pf_write(m_fs, reinterpret_cast< const void* >(buf), size, &written);
+        FRESULT res = pf_write(&m_fs, reinterpret_cast< const void* >(buf), size, &written);
 
         if (res != FR_OK)
             return -1;
@@ -65,16 +88,16 @@ int file::seek(off_t offt, seekdir way)
             top_offt = offt;
             break;
         case seekdir::cur:
-            top_offt = m_fs->fptr + offt;
+            top_offt = m_fs.fptr + offt;
             break;
         case seekdir::end:
-            top_offt = m_fs->fsize + offt;
+            top_offt = m_fs.fsize + offt;
             break;
         default:
             return -1;
         }
 
-        res = pf_lseek(m_fs, top_offt);
+        res = pf_lseek(&m_fs, top_offt);
         if (res == FR_OK)
             return 0;
 
@@ -91,14 +114,39 @@ off_t file::tell()
 {
 #if _USE_LSEEK
     if (m_opened) {
-        return m_fs->fptr;
+        return m_fs.fptr;
     }
 #endif
     return -1;
 }
 
+int file::reopen()
+{
+    if (m_opened) {
+        close();
+    }
+
+    // File, found by open(), is kept in the own copy of the FAT object.
+    // Zero position makes reading start from the first cluster.
+    if (!(m_fs.flag & FA_OPENED) || m_state->files >= m_state->max_files) {
+        return -1;
+    }
+
+    m_state->files++;
+    m_counted = true;
+    m_fs.fptr = 0;
+    m_opened  = true;
+    return 0;
+}
+
 int file::close()
 {
+    // Slot is returned even if file was not opened successfully
+    if (m_counted) {
+        m_counted = false;
+        m_state->files--;
+    }
+
     if (m_opened) {
         m_opened = false;
         return 0;
@@ -3,13 +3,14 @@
 
 using namespace fat;
 
-file_inode::file_inode(FATFS *fs, const allocator &alloc,
-                       const char *path, const char *name)
-    :m_fs{*fs}
-    ,m_path{}
+file_inode::file_inode(mount_state *fs, const allocator &alloc,
+                       const path_ptr &dir_path, const char *name)
+    :m_fs{fs}
+    ,m_dir_path{dir_path}
     ,m_alloc{alloc}
+    ,m_name{}
 {
-    m_path = allocate_path(path, name, m_alloc);
+    reuse(name);
 }
 
 file_inode::~file_inode()
@@ -24,14 +25,18 @@ file_inode::type file_inode::get_type() const
 
 fs::file_ptr file_inode::open()
 {
-    // Petite FAT does not support multiple opened files,
-    // so it is unnecesary to keep any state inside file descriptor.
-    // However, the filesystem object itself works as an obscured
-    // file descriptors
-    FRESULT res = pf_open(&m_fs, m_path->get_path());
-    if (res == FR_OK) {
-        auto ptr = ecl::allocate_shared< file, allocator >(m_alloc, my_ptr, &m_fs);
+    // Full path is needed only here, so it is not kept
+    // in the inode during dir iteration
+    auto path = allocate_path(m_dir_path->get_path(), m_name, m_alloc);
+
+    // Petite FAT keeps state of a single opened file inside the
+    // filesystem object, so each descriptor gets its own copy of it.
+    if (m_fs->files >= m_fs->max_files) {
+        return fs::file_ptr{};
+    }
 
+    auto ptr = ecl::allocate_shared< file, allocator >(m_alloc, my_ptr, m_fs);
+    if (ptr && ptr->open(path->get_path()) == 0) {
         return ptr;
     }
 
@@ -48,33 +53,20 @@ ssize_t file_inode::get_name(char *buf, size_t buf_sz) const
     ecl_assert(buf);
     ecl_assert(buf_sz);
 
-    const char *path = m_path->get_path();
-
-    size_t path_len = strlen(path);
-    uint i;
-    for (i = path_len; i > 0; --i) {
-        if (path[i - 1] == '/') {
-            i--; // Rest of the code assumes that 'i' is an index of array2
-            break;
-        }
-    }
+    size_t len = strlen(m_name);
 
-    // Skip forward slash
-    const char *start = path + i + 1;
     // Reserve place for null terminator
-    size_t to_copy = std::min(buf_sz - 1, path_len - i);
-    // One-beyond-end iterator
-    const char *end = start + to_copy + 1;
-
-    // Algorithm check
-    ecl_assert(to_copy < buf_sz);
-    ecl_assert(start < end);
-
+    size_t to_copy = std::min(buf_sz - 1, len);
+    std::copy(m_name, m_name + to_copy, buf);
     buf[to_copy] = 0;
 
-    // Copy [start;end) to buf
-    std::copy(start, end, buf);
-
-    return path + path_len - start;
+    return len;
 }
 
+void file_inode::reuse(const char *name)
+{
+    ecl_assert(name);
+    ecl_assert(strlen(name) < sizeof(m_name));
+
+    strcpy(m_name, name);
+}
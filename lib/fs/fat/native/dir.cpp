@@ -0,0 +1,129 @@
+#include "fat/native/dir.hpp"
+#include "fat/native/dir_inode.hpp"
+#include "fat/native/file_inode.hpp"
+
+#include <ecl/assert.h>
+
+#include <string.h>
+
+using namespace fat::native;
+
+dir::dir(const fs::inode_ptr &node, volume *vol, const allocator &alloc, uint32_t start)
+    :fs::dir_descriptor{node}
+    ,m_vol{vol}
+    ,m_alloc{alloc}
+    ,m_pos{}
+    ,m_opened{true}
+{
+    ecl_assert(node);
+    m_vol->dir_open(m_pos, start);
+}
+
+dir::~dir()
+{
+}
+
+fs::inode_ptr dir::next()
+{
+    if (m_opened) {
+        entry e;
+
+        if (m_vol->dir_next(m_pos, e) <= 0) {
+            // End of dir or error
+            return fs::inode_ptr{};
+        }
+
+        return make_inode(e);
+    }
+
+    return fs::inode_ptr{};
+}
+
+ssize_t dir::readdir(fs::dir_entry *out, size_t n)
+{
+    ecl_assert(out);
+
+    if (!m_opened) {
+        return -1;
+    }
+
+    size_t cnt = 0;
+
+    while (cnt < n) {
+        auto &d = out[cnt];
+        entry e;
+
+        int rc = m_vol->dir_next(m_pos, e, d.name, sizeof(d.name));
+        if (rc < 0) {
+            return -1;
+        } else if (!rc) {
+            break;
+        }
+
+        // Long name is preferred
+        if (!d.name[0]) {
+            strcpy(d.name, e.name);
+        }
+
+        bool is_dir = e.attr & volume::attr_dir;
+        d.type = is_dir ? fs::inode::type::dir : fs::inode::type::file;
+        d.size = is_dir ? 0 : e.size;
+        cnt++;
+    }
+
+    return cnt;
+}
+
+fs::inode_ptr dir::find(const fs::name_view &name)
+{
+    ecl_assert(name.ptr);
+
+    if (m_opened) {
+        entry e;
+
+        if (m_vol->dir_find(m_pos.start, name.ptr, name.len, e) > 0) {
+            return make_inode(e);
+        }
+    }
+
+    return fs::inode_ptr{};
+}
+
+int dir::rewind()
+{
+    if (m_opened) {
+        m_vol->dir_open(m_pos, m_pos.start);
+        return 0;
+    }
+
+    return -1;
+}
+
+int dir::close()
+{
+    if (m_opened) {
+        m_opened = false;
+        return 0;
+    }
+
+    return -1;
+}
+
+fs::inode_ptr dir::make_inode(const entry &e)
+{
+    if (e.attr & volume::attr_dir) {
+        auto ptr = ecl::allocate_shared< dir_inode, decltype(m_alloc) >
+                (m_alloc, m_vol, m_alloc, &e);
+
+        ptr->set_weak(ptr);
+
+        return ptr;
+    } else {
+        auto ptr = ecl::allocate_shared< file_inode, decltype(m_alloc) >
+                (m_alloc, m_vol, m_alloc, e);
+
+        ptr->set_weak(ptr);
+
+        return ptr;
+    }
+}
@@ -0,0 +1,103 @@
+#include "fat/native/dir_inode.hpp"
+#include "fat/native/file_inode.hpp"
+#include "fat/native/dir.hpp"
+
+#include <ecl/assert.h>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace fat::native;
+
+dir_inode::dir_inode(volume *vol, const allocator &alloc, const entry *e)
+    :fs::inode()
+    ,m_vol{vol}
+    ,m_alloc{alloc}
+    ,m_start{e ? e->cluster : vol->root()}
+    ,m_name{}
+{
+    if (e) {
+        strcpy(m_name, e->name);
+    }
+}
+
+dir_inode::~dir_inode()
+{
+}
+
+dir_inode::type dir_inode::get_type() const
+{
+    return dir_inode::type::dir;
+}
+
+fs::dir_ptr dir_inode::open_dir()
+{
+    ecl_assert(!my_ptr.expired());
+
+    auto inode = my_ptr.lock();
+    ecl_assert(inode);
+
+    auto ptr = ecl::allocate_shared< dir, decltype(m_alloc) >
+            (m_alloc, inode, m_vol, m_alloc, m_start);
+
+    return ptr;
+}
+
+ssize_t dir_inode::size() const
+{
+    dir_pos pos;
+    entry   e;
+    ssize_t cnt = 0;
+    int     rc;
+
+    m_vol->dir_open(pos, m_start);
+
+    while ((rc = m_vol->dir_next(pos, e)) > 0) {
+        cnt++;
+    }
+
+    return rc < 0 ? -1 : cnt;
+}
+
+ssize_t dir_inode::get_name(char *buf, size_t buf_sz) const
+{
+    ecl_assert(buf);
+    ecl_assert(buf_sz);
+
+    // Root is named as in a path
+    const char *name = m_name[0] ? m_name : "/";
+    size_t len = strlen(name);
+
+    // Reserve place for null terminator
+    size_t to_copy = std::min(buf_sz - 1, len);
+    std::copy(name, name + to_copy, buf);
+    buf[to_copy] = 0;
+
+    return len;
+}
+
+fs::inode_ptr dir_inode::create(const char *name, type t)
+{
+    ecl_assert(name);
+
+    entry e;
+    uint8_t attr = (t == type::dir) ? volume::attr_dir : volume::attr_archive;
+
+    if (m_vol->dir_create(m_start, name, attr, e) < 0 || m_vol->sync() < 0) {
+        return fs::inode_ptr{};
+    }
+
+    if (t == type::dir) {
+        auto ptr = ecl::allocate_shared< dir_inode, decltype(m_alloc) >
+                (m_alloc, m_vol, m_alloc, &e);
+
+        ptr->set_weak(ptr);
+        return ptr;
+    } else {
+        auto ptr = ecl::allocate_shared< file_inode, decltype(m_alloc) >
+                (m_alloc, m_vol, m_alloc, e);
+
+        ptr->set_weak(ptr);
+        return ptr;
+    }
+}
@@ -0,0 +1,282 @@
+#include "fat/native/file.hpp"
+#include "fat/native/file_inode.hpp"
+
+#include <ecl/assert.h>
+
+using namespace fat::native;
+
+file::file(const fs::inode_weak &node, volume *vol, const allocator &alloc)
+    :fs::file_descriptor{node}
+    ,m_vol{vol}
+    ,m_alloc{alloc}
+    ,m_bounce{nullptr}
+    ,m_bounce_sz{0}
+    ,m_map{}
+    ,m_cur{}
+    ,m_offt{0}
+    ,m_dirty{false}
+    ,m_opened{true} // When constructed it is already opened
+    ,m_async_busy{false}
+    ,m_async_write{false}
+    ,m_async_cur{}
+    ,m_async_len{0}
+    ,m_async_cb{}
+{
+}
+
+file::~file()
+{
+    // Data must reach the device even if descriptor is not closed explicitly
+    if (m_opened) {
+        close();
+    }
+}
+
+ssize_t file::read(uint8_t *buf, size_t size)
+{
+    ecl_assert(buf);
+
+    if (!m_opened) {
+        return -1;
+    }
+
+    auto rc = m_vol->read(get_entry(), m_cur, m_offt, buf, size);
+    if (rc > 0) {
+        m_offt += rc;
+    }
+
+    return rc;
+}
+
+ssize_t file::write(const uint8_t *buf, size_t size)
+{
+    ecl_assert(buf);
+
+    if (!m_opened) {
+        return -1;
+    }
+
+    // Mapped data may be changed
+    release_bounce();
+
+    auto rc = m_vol->write(get_entry(), m_cur, m_offt, buf, size);
+    if (rc > 0) {
+        m_offt += rc;
+        m_dirty = true;
+    }
+
+    return rc;
+}
+
+int file::read_async(uint8_t *buf, size_t size, const io_callback &cb)
+{
+    ecl_assert(buf);
+    return start_async(buf, size, cb, false);
+}
+
+int file::write_async(const uint8_t *buf, size_t size, const io_callback &cb)
+{
+    ecl_assert(buf);
+
+    // Buffer is never written by the device in write mode
+    return start_async(const_cast< uint8_t* >(buf), size, cb, true);
+}
+
+int file::seek(off_t offt, seekdir way)
+{
+    if (!m_opened) {
+        return -1;
+    }
+
+    off_t top_offt;
+    off_t size = get_entry().size;
+
+    switch (way) {
+    case seekdir::beg:
+        top_offt = offt;
+        break;
+    case seekdir::cur:
+        top_offt = m_offt + offt;
+        break;
+    case seekdir::end:
+        top_offt = size + offt;
+        break;
+    default:
+        return -1;
+    }
+
+    if (top_offt < 0 || top_offt > size) {
+        return -1;
+    }
+
+    // Random access goes through the map, so the chain is not walked
+    // from the start on every backward seek. Map is built once per
+    // descriptor, clusters appended later are reached from its end.
+    auto first = get_entry().cluster;
+    if (first && (!m_map.count || m_map.first != first)) {
+        if (m_vol->map_chain(first, m_map) == 0) {
+            m_cur.map = &m_map;
+        }
+    }
+
+    m_offt = top_offt;
+    return 0;
+}
+
+off_t file::tell()
+{
+    if (m_opened) {
+        return m_offt;
+    }
+
+    return -1;
+}
+
+int file::close()
+{
+    if (!m_opened) {
+        // Already closed
+        return -1;
+    }
+
+    m_opened = false;
+    release_bounce();
+
+    if (m_dirty && m_vol->entry_update(get_entry()) < 0) {
+        return -1;
+    }
+
+    return m_vol->sync();
+}
+
+int file::reopen()
+{
+    if (m_async_busy) {
+        return -1;
+    }
+
+    if (m_opened && close() < 0) {
+        return -1;
+    }
+
+    m_map    = cluster_map{};
+    m_cur    = cursor{};
+    m_offt   = 0;
+    m_dirty  = false;
+    m_opened = true;
+    return 0;
+}
+
+const uint8_t *file::map(off_t offt, size_t len)
+{
+    if (!m_opened || offt < 0 || !len) {
+        return nullptr;
+    }
+
+    auto &e = get_entry();
+    if (static_cast< uint32_t >(offt) >= e.size || len > e.size - static_cast< uint32_t >(offt)) {
+        return nullptr;
+    }
+
+    // Own cursor is kept, so mapping doesn't disturb sequential access
+    cursor cur = m_cur;
+
+    auto data = m_vol->map(e, cur, offt, len);
+    if (data) {
+        return data;
+    }
+
+    if (m_bounce_sz < len) {
+        release_bounce();
+
+        m_bounce = m_alloc.allocate(len);
+        if (!m_bounce) {
+            return nullptr;
+        }
+
+        m_bounce_sz = len;
+    }
+
+    if (m_vol->read(e, cur, offt, m_bounce, len) != static_cast< ssize_t >(len)) {
+        return nullptr;
+    }
+
+    return m_bounce;
+}
+
+int file::start_async(uint8_t *buf, size_t size, const io_callback &cb, bool write)
+{
+    if (!m_opened || m_async_busy) {
+        return -1;
+    }
+
+    auto &e = get_entry();
+
+    // Allocation of clusters and size update are left to write()
+    bool in_place = write && (m_offt > e.size || size > e.size - m_offt);
+
+    if (!in_place) {
+        if (write) {
+            // Mapped data may be changed
+            release_bounce();
+        }
+
+        // Request may complete before start_xfer() returns,
+        // so everything is prepared in advance
+        m_async_busy  = true;
+        m_async_write = write;
+        m_async_cur   = m_cur;
+        m_async_len   = size;
+        m_async_cb    = cb;
+
+        if (m_vol->start_xfer(e, m_async_cur, m_offt, buf, m_async_len, write,
+                              async_done, this) == 0) {
+            return 0;
+        }
+
+        m_async_cb    = nullptr;
+        m_async_busy  = false;
+    }
+
+    // Partial sectors, fragmented data or device without async I/O
+    return write ? fs::file_descriptor::write_async(buf, size, cb)
+                 : fs::file_descriptor::read_async(buf, size, cb);
+}
+
+void file::async_done(void *ctx, int status)
+{
+    auto f = static_cast< file* >(ctx);
+    ecl_assert(f);
+
+    ssize_t rc = -1;
+
+    if (status == 0) {
+        f->m_cur   = f->m_async_cur;
+        f->m_offt += f->m_async_len;
+        f->m_dirty = f->m_dirty || f->m_async_write;
+        rc = f->m_async_len;
+    }
+
+    // Busy flag is cleared before notification, so next I/O
+    // can be started from the callback
+    auto cb = std::move(f->m_async_cb);
+    f->m_async_busy = false;
+
+    if (cb) {
+        cb(rc);
+    }
+}
+
+void file::release_bounce()
+{
+    if (m_bounce) {
+        m_alloc.deallocate(m_bounce, m_bounce_sz);
+        m_bounce    = nullptr;
+        m_bounce_sz = 0;
+    }
+}
+
+entry& file::get_entry()
+{
+    return static_cast< file_inode* >(m_inode.get())->get_entry();
+}
@@ -0,0 +1,52 @@
+#include "fat/native/file_inode.hpp"
+#include "fat/native/file.hpp"
+
+#include <ecl/assert.h>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace fat::native;
+
+file_inode::file_inode(volume *vol, const allocator &alloc, const entry &e)
+    :m_vol{vol}
+    ,m_alloc{alloc}
+    ,m_entry(e)
+{
+}
+
+file_inode::~file_inode()
+{
+}
+
+file_inode::type file_inode::get_type() const
+{
+    return file_inode::type::file;
+}
+
+fs::file_ptr file_inode::open()
+{
+    auto ptr = ecl::allocate_shared< file, allocator >(m_alloc, my_ptr, m_vol, m_alloc);
+
+    return ptr;
+}
+
+ssize_t file_inode::size() const
+{
+    return m_entry.size;
+}
+
+ssize_t file_inode::get_name(char *buf, size_t buf_sz) const
+{
+    ecl_assert(buf);
+    ecl_assert(buf_sz);
+
+    size_t len = strlen(m_entry.name);
+
+    // Reserve place for null terminator
+    size_t to_copy = std::min(buf_sz - 1, len);
+    std::copy(m_entry.name, m_entry.name + to_copy, buf);
+    buf[to_copy] = 0;
+
+    return len;
+}
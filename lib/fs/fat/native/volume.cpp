@@ -0,0 +1,1319 @@
+#include "fat/native/volume.hpp"
+
+#include <ecl/prof.hpp>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace fat::native;
+
+// Little-endian field access
+static inline uint16_t ld16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t ld32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast< uint32_t >(p[3]) << 24);
+}
+
+static inline void st16(uint8_t *p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static inline void st32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static inline char to_upper(char c)
+{
+    return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+}
+
+static inline char to_lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+// Boot sector and FSInfo layout
+static constexpr size_t bs_bytes_per_sec    = 11;
+static constexpr size_t bs_sec_per_clus     = 13;
+static constexpr size_t bs_rsvd_sec_cnt     = 14;
+static constexpr size_t bs_num_fats         = 16;
+static constexpr size_t bs_root_ent_cnt     = 17;
+static constexpr size_t bs_tot_sec16        = 19;
+static constexpr size_t bs_fat_sz16         = 22;
+static constexpr size_t bs_tot_sec32        = 32;
+static constexpr size_t bs_fat_sz32         = 36;
+static constexpr size_t bs_root_clus        = 44;
+static constexpr size_t bs_fs_info          = 48;
+static constexpr size_t bs_signature        = 510;
+
+static constexpr size_t mbr_partition       = 446;
+
+static constexpr size_t fsi_lead_sig        = 0;
+static constexpr size_t fsi_struc_sig       = 484;
+static constexpr size_t fsi_free_count      = 488;
+static constexpr size_t fsi_nxt_free        = 492;
+
+// Directory entry layout
+static constexpr size_t dir_name            = 0;
+static constexpr size_t dir_attr            = 11;
+static constexpr size_t dir_nt_res          = 12;
+static constexpr size_t dir_crt_time        = 14;
+static constexpr size_t dir_crt_date        = 16;
+static constexpr size_t dir_lst_acc_date    = 18;
+static constexpr size_t dir_fst_clus_hi     = 20;
+static constexpr size_t dir_wrt_time        = 22;
+static constexpr size_t dir_wrt_date        = 24;
+static constexpr size_t dir_fst_clus_lo     = 26;
+static constexpr size_t dir_file_size       = 28;
+static constexpr size_t dir_entry_size      = 32;
+static constexpr size_t lfn_chksum          = 13;
+static constexpr size_t dir_per_sector      = volume::sector_size / dir_entry_size;
+
+// Case flags, used by NT to keep names lowercase
+static constexpr uint8_t nt_lower_base      = 0x08;
+static constexpr uint8_t nt_lower_ext       = 0x10;
+
+// Without time source, all entries get the same timestamp
+static constexpr uint16_t default_date      = ((2017 - 1980) << 9) | (1 << 5) | 1;
+static constexpr uint16_t default_time      = 0;
+
+static volume::time_fn time_source;
+
+constexpr uint8_t volume::attr_ro;
+constexpr uint8_t volume::attr_hidden;
+constexpr uint8_t volume::attr_system;
+constexpr uint8_t volume::attr_label;
+constexpr uint8_t volume::attr_dir;
+constexpr uint8_t volume::attr_archive;
+constexpr uint8_t volume::attr_lfn;
+constexpr size_t  volume::sector_size;
+constexpr size_t  volume::max_long_name;
+constexpr uint32_t volume::no_sector;
+constexpr size_t  cluster_map::max_runs;
+
+volume::volume()
+    :m_disk{}
+    ,m_type{fat_type::none}
+    ,m_blocks{0}
+    ,m_spc{0}
+    ,m_fat_lba{0}
+    ,m_fat_len{0}
+    ,m_fats{0}
+    ,m_root_lba{0}
+    ,m_root_len{0}
+    ,m_root_cl{0}
+    ,m_data_lba{0}
+    ,m_clusters{0}
+    ,m_info_lba{0}
+    ,m_free{0xffffffff}
+    ,m_next_free{2}
+    ,m_info_dirty{false}
+    ,m_win{}
+    ,m_win_sector{no_sector}
+    ,m_win_dirty{false}
+    ,m_fat_cache{}
+    ,m_clock{0}
+{
+}
+
+void volume::set_time_source(time_fn fn)
+{
+    time_source = fn;
+}
+
+int volume::mount(const disk &d, uint32_t blocks)
+{
+    m_disk       = d;
+    m_blocks     = blocks;
+    m_type       = fat_type::none;
+    m_win_sector = no_sector;
+    m_win_dirty  = false;
+    m_info_dirty = false;
+
+    for (auto &s : m_fat_cache) {
+        s.sector = no_sector;
+        s.dirty  = false;
+    }
+
+    int rc = probe(0);
+    if (rc < 0) {
+        return -1;
+    }
+
+    // Not a boot sector, it can be MBR
+    if (!rc) {
+        const uint8_t *part = m_win + mbr_partition;
+
+        // Partition type and start are checked
+        if (ld16(m_win + bs_signature) != 0xaa55 || !part[4] || !ld32(part + 8)) {
+            return -1;
+        }
+
+        if (probe(ld32(part + 8)) <= 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int volume::sync()
+{
+    int ret = 0;
+
+    if (sync_window() < 0) {
+        ret = -1;
+    }
+
+    for (auto &s : m_fat_cache) {
+        if (fat_flush(s) < 0) {
+            ret = -1;
+        }
+    }
+
+    if (sync_info() < 0) {
+        ret = -1;
+    }
+
+    return ret;
+}
+
+uint32_t volume::root() const
+{
+    return m_type == fat_type::fat32 ? m_root_cl : 0;
+}
+
+uint32_t volume::cluster_size() const
+{
+    return m_spc * sector_size;
+}
+
+//------------------------------------------------------------------------------
+
+void volume::dir_open(dir_pos &pos, uint32_t start) const
+{
+    pos.start    = start;
+    pos.cluster  = start;
+    pos.cl_index = 0;
+    pos.index    = 0;
+}
+
+int volume::dir_next(dir_pos &pos, entry &e, char *long_name, size_t long_len)
+{
+    // Long name entries precede short entry, in reverse order.
+    // Order number of the next expected one and checksum are tracked.
+    uint8_t lfn_ord = 0;
+    uint8_t lfn_sum = 0;
+
+    if (long_name && long_len) {
+        long_name[0] = 0;
+    }
+
+    for (;;) {
+        uint32_t sector;
+        int rc = dir_sector(pos, sector);
+        if (rc <= 0) {
+            return rc;
+        }
+
+        if (move_window(sector) < 0) {
+            return -1;
+        }
+
+        size_t offt = (pos.index % dir_per_sector) * dir_entry_size;
+        const uint8_t *raw = m_win + offt;
+
+        // End of dir, position is left as is
+        if (!raw[dir_name]) {
+            return 0;
+        }
+
+        pos.index++;
+
+        if (raw[dir_name] != 0xe5 && (raw[dir_attr] & attr_lfn) == attr_lfn) {
+            if (long_name) {
+                lfn_ord = decode_lfn(raw, lfn_ord, lfn_sum, long_name, long_len);
+            }
+
+            continue;
+        }
+
+        // Deleted entries, labels and dot entries are skipped
+        if (raw[dir_name] == 0xe5 || raw[dir_name] == '.' || (raw[dir_attr] & attr_label)) {
+            lfn_ord = 0;
+            continue;
+        }
+
+        // Long name is valid only if it is complete and belongs to this entry
+        if (long_name && long_len && (lfn_ord != 1 || lfn_sum != lfn_checksum(raw))) {
+            long_name[0] = 0;
+        }
+
+        decode_entry(raw, e);
+        e.sector = sector;
+        e.offset = offt;
+        return 1;
+    }
+}
+
+int volume::dir_find(uint32_t start, const char *name, entry &e)
+{
+    return dir_find(start, name, strlen(name), e);
+}
+
+int volume::dir_find(uint32_t start, const char *name, size_t len, entry &e)
+{
+    char long_name[max_long_name + 1];
+
+    dir_pos pos;
+    dir_open(pos, start);
+
+    int rc;
+    while ((rc = dir_next(pos, e, long_name, sizeof(long_name))) > 0) {
+        if (same_name(name, len, e.name) || (long_name[0] && same_name(name, len, long_name))) {
+            return 1;
+        }
+    }
+
+    return rc;
+}
+
+int volume::dir_create(uint32_t start, const char *name, uint8_t attr, entry &e)
+{
+    uint8_t raw[dir_entry_size] = {};
+
+    if (!encode_name(name, raw)) {
+        return -1;
+    }
+
+    // Names must be unique
+    if (dir_find(start, name, e) != 0) {
+        return -1;
+    }
+
+    // Find a free slot, extending the dir if needed
+    dir_pos pos;
+    dir_open(pos, start);
+
+    uint32_t sector;
+    size_t   offt;
+
+    for (;;) {
+        int rc = dir_sector(pos, sector);
+        if (rc < 0) {
+            return -1;
+        }
+
+        if (!rc) {
+            uint32_t cluster;
+
+            // FAT16 root can't grow
+            if (!pos.start || alloc_cluster(pos.cluster, cluster) < 0
+                    || clear_cluster(cluster) < 0) {
+                return -1;
+            }
+
+            continue;
+        }
+
+        if (move_window(sector) < 0) {
+            return -1;
+        }
+
+        offt = (pos.index % dir_per_sector) * dir_entry_size;
+        if (!m_win[offt] || m_win[offt] == 0xe5) {
+            break;
+        }
+
+        pos.index++;
+    }
+
+    uint32_t cluster = 0;
+
+    // Dir starts with dot entries, pointing to itself and to the parent
+    if (attr & attr_dir) {
+        if (alloc_cluster(0, cluster) < 0 || clear_cluster(cluster) < 0) {
+            return -1;
+        }
+
+        if (move_window(cluster_lba(cluster), false) < 0) {
+            return -1;
+        }
+
+        uint8_t *dot = m_win;
+        memset(dot, ' ', 11);
+        dot[dir_name] = '.';
+        dot[dir_attr] = attr_dir;
+        stamp_entry(dot);
+        st16(dot + dir_fst_clus_hi, cluster >> 16);
+        st16(dot + dir_fst_clus_lo, cluster);
+
+        uint8_t *dotdot = m_win + dir_entry_size;
+        memcpy(dotdot, dot, dir_entry_size);
+        dotdot[dir_name + 1] = '.';
+        // Root is always referred as 0
+        uint32_t parent = (start == root()) ? 0 : start;
+        st16(dotdot + dir_fst_clus_hi, parent >> 16);
+        st16(dotdot + dir_fst_clus_lo, parent);
+
+        m_win_dirty = true;
+
+        if (move_window(sector) < 0) {
+            return -1;
+        }
+    }
+
+    raw[dir_attr] = attr;
+    stamp_entry(raw);
+    st16(raw + dir_fst_clus_hi, cluster >> 16);
+    st16(raw + dir_fst_clus_lo, cluster);
+
+    memcpy(m_win + offt, raw, dir_entry_size);
+    m_win_dirty = true;
+
+    decode_entry(raw, e);
+    e.sector = sector;
+    e.offset = offt;
+
+    return 0;
+}
+
+int volume::entry_update(const entry &e)
+{
+    if (move_window(e.sector) < 0) {
+        return -1;
+    }
+
+    uint8_t *raw = m_win + e.offset;
+
+    raw[dir_attr] |= attr_archive;
+    st16(raw + dir_fst_clus_hi, e.cluster >> 16);
+    st16(raw + dir_fst_clus_lo, e.cluster);
+    st32(raw + dir_file_size, e.size);
+    uint32_t stamp = now();
+    st16(raw + dir_wrt_time, stamp);
+    st16(raw + dir_wrt_date, stamp >> 16);
+
+    m_win_dirty = true;
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+
+ssize_t volume::read(const entry &e, cursor &cur, uint32_t offt, uint8_t *buf, size_t size)
+{
+    ECL_TRACE_SCOPE("fat.read");
+
+    if (offt >= e.size) {
+        return 0;
+    }
+
+    size = std::min< size_t >(size, e.size - offt);
+
+    uint32_t csize = cluster_size();
+    size_t   done  = 0;
+
+    while (done < size) {
+        uint32_t pos    = offt + done;
+        uint32_t in_cl  = pos % csize;
+        uint32_t sec_in = in_cl / sector_size;
+        size_t   sec_offt = in_cl % sector_size;
+        size_t   left   = size - done;
+
+        // File size says that there is more data, chain must not end here
+        if (seek_cluster(e.cluster, cur, pos / csize, false) <= 0) {
+            return -1;
+        }
+
+        uint32_t lba = cluster_lba(cur.cluster) + sec_in;
+
+        if (sec_offt || left < sector_size) {
+            // Partial sector goes through the window
+            if (move_window(lba) < 0) {
+                return -1;
+            }
+
+            size_t n = std::min(sector_size - sec_offt, left);
+            memcpy(buf + done, m_win + sec_offt, n);
+            done += n;
+            continue;
+        }
+
+        uint32_t count;
+        if (contiguous_run(cur, sec_in, left / sector_size, false, count) < 0) {
+            return -1;
+        }
+
+        // Window may hold more recent data
+        if (m_win_dirty && m_win_sector >= lba && m_win_sector < lba + count) {
+            if (sync_window() < 0) {
+                return -1;
+            }
+        }
+
+        if (m_disk.read(m_disk.obj, lba, buf + done, count) < 0) {
+            return -1;
+        }
+
+        done += count * sector_size;
+    }
+
+    return done;
+}
+
+ssize_t volume::write(entry &e, cursor &cur, uint32_t offt, const uint8_t *buf, size_t size)
+{
+    ECL_TRACE_SCOPE("fat.write");
+
+    // Holes are not supported
+    if (offt > e.size) {
+        return -1;
+    }
+
+    // File can't exceed 4 GiB
+    size = std::min< size_t >(size, 0xffffffff - offt);
+
+    if (!size) {
+        return 0;
+    }
+
+    if (!e.cluster) {
+        if (alloc_cluster(0, e.cluster) < 0) {
+            return -1;
+        }
+
+        cur.cluster = e.cluster;
+        cur.index   = 0;
+    }
+
+    uint32_t csize = cluster_size();
+    size_t   done  = 0;
+
+    while (done < size) {
+        uint32_t pos    = offt + done;
+        uint32_t in_cl  = pos % csize;
+        uint32_t sec_in = in_cl / sector_size;
+        size_t   sec_offt = in_cl % sector_size;
+        size_t   left   = size - done;
+
+        if (seek_cluster(e.cluster, cur, pos / csize, true) <= 0) {
+            break;
+        }
+
+        uint32_t lba = cluster_lba(cur.cluster) + sec_in;
+
+        if (sec_offt || left < sector_size) {
+            // Sector past the end of a file holds no data, no need to read it
+            if (move_window(lba, (pos - sec_offt) < e.size) < 0) {
+                break;
+            }
+
+            size_t n = std::min(sector_size - sec_offt, left);
+            memcpy(m_win + sec_offt, buf + done, n);
+            m_win_dirty = true;
+            done += n;
+        } else {
+            uint32_t count;
+            if (contiguous_run(cur, sec_in, left / sector_size, true, count) < 0) {
+                break;
+            }
+
+            // Window content is overwritten anyway
+            if (m_win_sector >= lba && m_win_sector < lba + count) {
+                m_win_sector = no_sector;
+                m_win_dirty  = false;
+            }
+
+            if (m_disk.write(m_disk.obj, lba, buf + done, count) < 0) {
+                break;
+            }
+
+            done += count * sector_size;
+        }
+
+        e.size = std::max< uint32_t >(e.size, offt + done);
+    }
+
+    return done ? static_cast< ssize_t >(done) : -1;
+}
+
+int volume::start_xfer(const entry &e, cursor &cur, uint32_t offt, uint8_t *buf, size_t &size,
+                       bool write, done_fn done, void *ctx)
+{
+    ECL_TRACE_SCOPE("fat.start_xfer");
+
+    bool supported = write ? m_disk.write_async != nullptr : m_disk.read_async != nullptr;
+
+    if (!supported || offt >= e.size) {
+        return -1;
+    }
+
+    size = std::min< size_t >(size, e.size - offt);
+
+    uint32_t csize  = cluster_size();
+    uint32_t in_cl  = offt % csize;
+    uint32_t sec_in = in_cl / sector_size;
+
+    // Partial sectors go through the window, which is synchronous
+    if (in_cl % sector_size || size < sector_size) {
+        return -1;
+    }
+
+    if (seek_cluster(e.cluster, cur, offt / csize, false) <= 0) {
+        return -1;
+    }
+
+    uint32_t lba = cluster_lba(cur.cluster) + sec_in;
+    uint32_t count;
+
+    if (contiguous_run(cur, sec_in, size / sector_size, false, count) < 0) {
+        return -1;
+    }
+
+    if (m_win_sector >= lba && m_win_sector < lba + count) {
+        if (write) {
+            // Window content is overwritten anyway
+            m_win_sector = no_sector;
+            m_win_dirty  = false;
+        } else if (sync_window() < 0) {
+            // Window may hold more recent data
+            return -1;
+        }
+    }
+
+    size = count * sector_size;
+
+    return (write ? m_disk.write_async(m_disk.obj, lba, buf, count, done, ctx)
+                  : m_disk.read_async(m_disk.obj, lba, buf, count, done, ctx)) < 0 ? -1 : 0;
+}
+
+const uint8_t *volume::map(const entry &e, cursor &cur, uint32_t offt, size_t size)
+{
+    if (!m_disk.map || !size || offt >= e.size || size > e.size - offt) {
+        return nullptr;
+    }
+
+    uint32_t csize    = cluster_size();
+    uint32_t in_cl    = offt % csize;
+    uint32_t sec_in   = in_cl / sector_size;
+    size_t   sec_offt = in_cl % sector_size;
+
+    if (seek_cluster(e.cluster, cur, offt / csize, false) <= 0) {
+        return nullptr;
+    }
+
+    uint32_t lba    = cluster_lba(cur.cluster) + sec_in;
+    uint32_t wanted = (sec_offt + size + sector_size - 1) / sector_size;
+    uint32_t count;
+
+    // Whole range must be contiguous on the device
+    if (contiguous_run(cur, sec_in, wanted, false, count) < 0 || count < wanted) {
+        return nullptr;
+    }
+
+    // Device memory must hold data, cached in the window
+    if (m_win_dirty && m_win_sector >= lba && m_win_sector < lba + count) {
+        if (sync_window() < 0) {
+            return nullptr;
+        }
+    }
+
+    auto data = m_disk.map(m_disk.obj, lba, count);
+    return data ? data + sec_offt : nullptr;
+}
+
+int volume::map_chain(uint32_t first, cluster_map &map)
+{
+    map.first = first;
+    map.count = 0;
+
+    if (!first) {
+        return 0;
+    }
+
+    uint32_t cl = first;
+    auto run = &map.runs[0];
+
+    run->start  = cl;
+    run->length = 1;
+    map.count   = 1;
+
+    for (;;) {
+        uint32_t next;
+        if (fat_get(cl, next) < 0) {
+            map.count = 0;
+            return -1;
+        }
+
+        if (is_eoc(next)) {
+            return 0;
+        }
+
+        if (!valid_cluster(next)) {
+            map.count = 0;
+            return -1;
+        }
+
+        if (next == cl + 1) {
+            run->length++;
+        } else if (map.count < cluster_map::max_runs) {
+            run = &map.runs[map.count++];
+            run->start  = next;
+            run->length = 1;
+        } else {
+            // Rest of the chain is walked when accessed
+            return 0;
+        }
+
+        cl = next;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+int volume::probe(uint32_t lba)
+{
+    if (move_window(lba) < 0) {
+        return -1;
+    }
+
+    const uint8_t *bs = m_win;
+
+    if (ld16(bs + bs_signature) != 0xaa55 || ld16(bs + bs_bytes_per_sec) != sector_size) {
+        return 0;
+    }
+
+    uint32_t spc         = bs[bs_sec_per_clus];
+    uint32_t reserved    = ld16(bs + bs_rsvd_sec_cnt);
+    uint32_t fats        = bs[bs_num_fats];
+    uint32_t root_ents   = ld16(bs + bs_root_ent_cnt);
+    uint32_t total       = ld16(bs + bs_tot_sec16) ? ld16(bs + bs_tot_sec16)
+                                                   : ld32(bs + bs_tot_sec32);
+    uint32_t fat_len     = ld16(bs + bs_fat_sz16) ? ld16(bs + bs_fat_sz16)
+                                                  : ld32(bs + bs_fat_sz32);
+
+    if (!spc || (spc & (spc - 1)) || !reserved || !fats || !fat_len) {
+        return 0;
+    }
+
+    uint32_t root_len = (root_ents * dir_entry_size + sector_size - 1) / sector_size;
+    uint32_t meta     = reserved + fats * fat_len + root_len;
+
+    if (total <= meta || total > m_blocks - lba) {
+        return 0;
+    }
+
+    uint32_t clusters = (total - meta) / spc;
+
+    // Type is determined by amount of clusters only. FAT12 is not supported.
+    if (clusters < 4085) {
+        return 0;
+    } else if (clusters < 65525) {
+        if (!root_ents || fat_len * sector_size < (clusters + 2) * 2) {
+            return 0;
+        }
+
+        m_type = fat_type::fat16;
+    } else {
+        if (root_ents || fat_len * sector_size / 4 < clusters + 2) {
+            return 0;
+        }
+
+        m_type = fat_type::fat32;
+    }
+
+    m_spc       = spc;
+    m_fats      = fats;
+    m_fat_lba   = lba + reserved;
+    m_fat_len   = fat_len;
+    m_root_lba  = m_fat_lba + fats * fat_len;
+    m_root_len  = root_len;
+    m_data_lba  = lba + meta;
+    m_clusters  = clusters;
+    m_root_cl   = 0;
+    m_info_lba  = 0;
+    m_free      = 0xffffffff;
+    m_next_free = 2;
+
+    if (m_type == fat_type::fat16) {
+        return 1;
+    }
+
+    m_root_cl = ld32(bs + bs_root_clus);
+    if (!valid_cluster(m_root_cl)) {
+        m_type = fat_type::none;
+        return 0;
+    }
+
+    // Free clusters info is optional, it speeds up allocation
+    uint32_t info = ld16(bs + bs_fs_info);
+    if (!info || info >= reserved || move_window(lba + info) < 0) {
+        return 1;
+    }
+
+    if (ld32(m_win + fsi_lead_sig) == 0x41615252
+            && ld32(m_win + fsi_struc_sig) == 0x61417272
+            && ld32(m_win + bs_signature - 2) == 0xaa550000) {
+        m_info_lba = lba + info;
+
+        uint32_t free = ld32(m_win + fsi_free_count);
+        uint32_t next = ld32(m_win + fsi_nxt_free);
+
+        if (free <= clusters) {
+            m_free = free;
+        }
+
+        if (valid_cluster(next)) {
+            m_next_free = next;
+        }
+    }
+
+    return 1;
+}
+
+int volume::move_window(uint32_t sector, bool load)
+{
+    if (sector == m_win_sector) {
+        ECL_COUNTER("fat.window_hits");
+        return 0;
+    }
+
+    // Window is flushed and/or loaded, i.e. disk is accessed
+    ECL_TRACE_SCOPE("fat.move_window");
+
+    if (sync_window() < 0) {
+        return -1;
+    }
+
+    if (!load) {
+        memset(m_win, 0, sizeof(m_win));
+    } else if (m_disk.read(m_disk.obj, sector, m_win, 1) < 0) {
+        m_win_sector = no_sector;
+        return -1;
+    }
+
+    m_win_sector = sector;
+    return 0;
+}
+
+int volume::sync_window()
+{
+    if (!m_win_dirty) {
+        return 0;
+    }
+
+    if (m_disk.write(m_disk.obj, m_win_sector, m_win, 1) < 0) {
+        return -1;
+    }
+
+    m_win_dirty = false;
+    return 0;
+}
+
+volume::fat_sector *volume::fat_load(uint32_t sector)
+{
+    // Free entry is used first, then least recently used one
+    auto victim = &m_fat_cache[0];
+
+    for (auto &s : m_fat_cache) {
+        if (s.sector == sector) {
+            s.used = ++m_clock;
+            return &s;
+        }
+
+        if (victim->sector != no_sector
+                && (s.sector == no_sector || s.used < victim->used)) {
+            victim = &s;
+        }
+    }
+
+    if (fat_flush(*victim) < 0) {
+        return nullptr;
+    }
+
+    if (m_disk.read(m_disk.obj, m_fat_lba + sector, victim->data, 1) < 0) {
+        victim->sector = no_sector;
+        return nullptr;
+    }
+
+    victim->sector = sector;
+    victim->used   = ++m_clock;
+    return victim;
+}
+
+int volume::fat_flush(fat_sector &s)
+{
+    if (!s.dirty) {
+        return 0;
+    }
+
+    // All copies of FAT are kept in sync
+    for (uint32_t i = 0; i < m_fats; ++i) {
+        if (m_disk.write(m_disk.obj, m_fat_lba + i * m_fat_len + s.sector, s.data, 1) < 0) {
+            return -1;
+        }
+    }
+
+    s.dirty = false;
+    return 0;
+}
+
+int volume::fat_get(uint32_t cluster, uint32_t &val)
+{
+    if (!valid_cluster(cluster)) {
+        return -1;
+    }
+
+    uint32_t width = (m_type == fat_type::fat32) ? 4 : 2;
+    uint32_t offt  = cluster * width;
+
+    auto s = fat_load(offt / sector_size);
+    if (!s) {
+        return -1;
+    }
+
+    const uint8_t *p = s->data + offt % sector_size;
+    val = (width == 4) ? (ld32(p) & 0x0fffffff) : ld16(p);
+    return 0;
+}
+
+int volume::fat_set(uint32_t cluster, uint32_t val)
+{
+    if (!valid_cluster(cluster)) {
+        return -1;
+    }
+
+    uint32_t width = (m_type == fat_type::fat32) ? 4 : 2;
+    uint32_t offt  = cluster * width;
+
+    auto s = fat_load(offt / sector_size);
+    if (!s) {
+        return -1;
+    }
+
+    uint8_t *p = s->data + offt % sector_size;
+
+    if (width == 4) {
+        // Upper bits are reserved and must be preserved
+        st32(p, (ld32(p) & 0xf0000000) | (val & 0x0fffffff));
+    } else {
+        st16(p, val);
+    }
+
+    s->dirty = true;
+    return 0;
+}
+
+bool volume::is_eoc(uint32_t val) const
+{
+    return val >= ((m_type == fat_type::fat32) ? 0x0ffffff8 : 0xfff8);
+}
+
+uint32_t volume::eoc() const
+{
+    return (m_type == fat_type::fat32) ? 0x0fffffff : 0xffff;
+}
+
+int volume::alloc_cluster(uint32_t prev, uint32_t &cluster)
+{
+    if (!m_free) {
+        return -1;
+    }
+
+    uint32_t cl = valid_cluster(m_next_free) ? m_next_free : 2;
+
+    for (uint32_t i = 0; i < m_clusters; ++i) {
+        uint32_t val;
+        if (fat_get(cl, val) < 0) {
+            return -1;
+        }
+
+        if (!val) {
+            if (fat_set(cl, eoc()) < 0) {
+                return -1;
+            }
+
+            if (prev && fat_set(prev, cl) < 0) {
+                return -1;
+            }
+
+            if (m_free != 0xffffffff) {
+                m_free--;
+            }
+
+            m_next_free  = cl + 1;
+            m_info_dirty = true;
+            cluster      = cl;
+            return 0;
+        }
+
+        if (++cl == m_clusters + 2) {
+            cl = 2;
+        }
+    }
+
+    // Volume is full
+    m_free = 0;
+    return -1;
+}
+
+int volume::clear_cluster(uint32_t cluster)
+{
+    if (sync_window() < 0) {
+        return -1;
+    }
+
+    // Window is used as a source of zeroes
+    memset(m_win, 0, sizeof(m_win));
+    m_win_sector = no_sector;
+
+    uint32_t lba = cluster_lba(cluster);
+    for (uint32_t i = 0; i < m_spc; ++i) {
+        if (m_disk.write(m_disk.obj, lba + i, m_win, 1) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int volume::seek_cluster(uint32_t first, cursor &cur, uint32_t index, bool extend)
+{
+    ECL_TRACE_SCOPE("fat.seek_cluster");
+
+    if (!cur.cluster || cur.index > index) {
+        cur.cluster = first;
+        cur.index   = 0;
+    }
+
+    // Mapped part of the chain is reached without FAT access
+    auto map = cur.map;
+    if (map && map->count && map->first == first && cur.index < index) {
+        uint32_t base = 0;
+
+        for (uint32_t i = 0; i < map->count; ++i) {
+            auto &run = map->runs[i];
+
+            if (index < base + run.length) {
+                cur.cluster = run.start + index - base;
+                cur.index   = index;
+                return 1;
+            }
+
+            base += run.length;
+        }
+
+        // Walk continues from the end of the map
+        if (cur.index < base - 1) {
+            auto &last  = map->runs[map->count - 1];
+            cur.cluster = last.start + last.length - 1;
+            cur.index   = base - 1;
+        }
+    }
+
+    while (cur.index < index) {
+        uint32_t next;
+        if (fat_get(cur.cluster, next) < 0) {
+            return -1;
+        }
+
+        if (is_eoc(next)) {
+            if (!extend) {
+                return 0;
+            }
+
+            if (alloc_cluster(cur.cluster, next) < 0) {
+                return -1;
+            }
+        } else if (!valid_cluster(next)) {
+            // Chain is broken
+            return -1;
+        }
+
+        cur.cluster = next;
+        cur.index++;
+    }
+
+    return 1;
+}
+
+int volume::contiguous_run(cursor &cur, uint32_t sec_in, uint32_t wanted, bool extend,
+                           uint32_t &count)
+{
+    count = std::min(wanted, m_spc - sec_in);
+
+    while (count < wanted) {
+        uint32_t next;
+        if (fat_get(cur.cluster, next) < 0) {
+            return -1;
+        }
+
+        if (is_eoc(next)) {
+            // Out of space is reported when the rest is written
+            if (!extend || alloc_cluster(cur.cluster, next) < 0) {
+                break;
+            }
+        } else if (!valid_cluster(next)) {
+            return -1;
+        }
+
+        // Run ends on a gap, next cluster is reached through the chain later
+        if (next != cur.cluster + 1) {
+            break;
+        }
+
+        cur.cluster = next;
+        cur.index++;
+        count += std::min(wanted - count, m_spc);
+    }
+
+    return 0;
+}
+
+uint32_t volume::cluster_lba(uint32_t cluster) const
+{
+    return m_data_lba + (cluster - 2) * m_spc;
+}
+
+bool volume::valid_cluster(uint32_t cluster) const
+{
+    return cluster >= 2 && cluster < m_clusters + 2;
+}
+
+//------------------------------------------------------------------------------
+
+int volume::dir_sector(dir_pos &pos, uint32_t &sector)
+{
+    // FAT16 root has a fixed size
+    if (!pos.start) {
+        uint32_t sec = pos.index / dir_per_sector;
+        if (sec >= m_root_len) {
+            return 0;
+        }
+
+        sector = m_root_lba + sec;
+        return 1;
+    }
+
+    uint32_t per_cluster = m_spc * dir_per_sector;
+    cursor   cur{pos.cluster, pos.cl_index, nullptr};
+
+    int rc = seek_cluster(pos.start, cur, pos.index / per_cluster, false);
+
+    // Cursor points to the last cluster even if the end is reached
+    pos.cluster  = cur.cluster;
+    pos.cl_index = cur.index;
+
+    if (rc <= 0) {
+        return rc;
+    }
+
+    sector = cluster_lba(cur.cluster) + (pos.index % per_cluster) / dir_per_sector;
+    return 1;
+}
+
+bool volume::same_name(const char *a, size_t len, const char *b)
+{
+    for (size_t i = 0; i < len; ++i) {
+        // Null terminator of a shorter name mismatches here as well
+        if (to_upper(a[i]) != to_upper(b[i])) {
+            return false;
+        }
+    }
+
+    return !b[len];
+}
+
+uint8_t volume::lfn_checksum(const uint8_t *raw)
+{
+    uint8_t sum = 0;
+
+    for (size_t i = 0; i < 11; ++i) {
+        sum = ((sum & 1) << 7) + (sum >> 1) + raw[dir_name + i];
+    }
+
+    return sum;
+}
+
+uint8_t volume::decode_lfn(const uint8_t *raw, uint8_t expected, uint8_t &sum,
+                           char *name, size_t len)
+{
+    // Offsets of UCS-2 characters within an entry
+    static const uint8_t chars[] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+    constexpr size_t per_entry = sizeof(chars);
+    constexpr uint8_t last_flag = 0x40;
+
+    uint8_t ord = raw[dir_name] & ~last_flag;
+
+    if (raw[dir_name] & last_flag) {
+        // Physically first entry holds the end of a name
+        if (!ord || ord * per_entry >= len) {
+            return 0;
+        }
+
+        sum = raw[lfn_chksum];
+        // Name may occupy all characters of the entry
+        name[ord * per_entry] = 0;
+    } else if (!expected || ord != expected - 1 || raw[lfn_chksum] != sum) {
+        // Sequence is broken
+        return 0;
+    }
+
+    char *dst = name + (ord - 1) * per_entry;
+
+    for (size_t i = 0; i < per_entry; ++i) {
+        uint16_t c = ld16(raw + chars[i]);
+
+        if (!c) {
+            dst[i] = 0;
+            break;
+        }
+
+        // Only ASCII is supported, other characters are replaced
+        dst[i] = c < 0x80 ? c : '?';
+    }
+
+    return ord;
+}
+
+void volume::decode_name(const uint8_t *raw, char *name)
+{
+    size_t len = 0;
+    bool lower_base = raw[dir_nt_res] & nt_lower_base;
+    bool lower_ext  = raw[dir_nt_res] & nt_lower_ext;
+
+    for (size_t i = 0; i < 8 && raw[i] != ' '; ++i) {
+        char c = raw[i];
+
+        // 0x05 stands for 0xe5, that marks deleted entries
+        if (!i && c == 0x05) {
+            c = static_cast< char >(0xe5);
+        }
+
+        name[len++] = lower_base ? to_lower(c) : c;
+    }
+
+    if (raw[8] != ' ') {
+        name[len++] = '.';
+
+        for (size_t i = 8; i < 11 && raw[i] != ' '; ++i) {
+            name[len++] = lower_ext ? to_lower(raw[i]) : raw[i];
+        }
+    }
+
+    name[len] = 0;
+}
+
+bool volume::encode_name(const char *name, uint8_t *raw)
+{
+    static const char invalid[] = "\"*+,/:;<=>?[\\]|";
+
+    const char *dot = strrchr(name, '.');
+    size_t len      = strlen(name);
+    size_t base_len = dot ? static_cast< size_t >(dot - name) : len;
+    size_t ext_len  = dot ? len - base_len - 1 : 0;
+
+    if (!base_len || base_len > 8 || ext_len > 3 || (dot && !ext_len)) {
+        return false;
+    }
+
+    memset(raw + dir_name, ' ', 11);
+
+    // Case is kept for names that are entirely lowercase or uppercase
+    // in each part, in the same way as NT does
+    bool has_upper[2] = {};
+    bool has_lower[2] = {};
+
+    for (size_t i = 0; i < len; ++i) {
+        char c = name[i];
+        size_t part = (dot && name + i > dot) ? 1 : 0;
+
+        if (name + i == dot) {
+            continue;
+        }
+
+        if (static_cast< uint8_t >(c) <= ' ' || c == '.' || strchr(invalid, c)) {
+            return false;
+        }
+
+        has_upper[part] |= (c >= 'A' && c <= 'Z');
+        has_lower[part] |= (c >= 'a' && c <= 'z');
+
+        size_t pos = part ? 8 + (name + i - dot - 1) : i;
+        raw[pos] = to_upper(c);
+    }
+
+    if (raw[0] == 0xe5) {
+        raw[0] = 0x05;
+    }
+
+    raw[dir_nt_res] = 0;
+    if (has_lower[0] && !has_upper[0]) {
+        raw[dir_nt_res] |= nt_lower_base;
+    }
+
+    if (has_lower[1] && !has_upper[1]) {
+        raw[dir_nt_res] |= nt_lower_ext;
+    }
+
+    return true;
+}
+
+void volume::decode_entry(const uint8_t *raw, entry &e)
+{
+    decode_name(raw, e.name);
+    e.attr    = raw[dir_attr];
+    e.cluster = (static_cast< uint32_t >(ld16(raw + dir_fst_clus_hi)) << 16)
+            | ld16(raw + dir_fst_clus_lo);
+    e.size    = ld32(raw + dir_file_size);
+}
+
+void volume::stamp_entry(uint8_t *raw)
+{
+    uint32_t stamp = now();
+
+    st16(raw + dir_crt_time, stamp);
+    st16(raw + dir_crt_date, stamp >> 16);
+    st16(raw + dir_lst_acc_date, stamp >> 16);
+    st16(raw + dir_wrt_time, stamp);
+    st16(raw + dir_wrt_date, stamp >> 16);
+}
+
+uint32_t volume::now()
+{
+    auto fn = time_source;
+    return fn ? fn() : static_cast< uint32_t >(default_date) << 16 | default_time;
+}
+
+int volume::sync_info()
+{
+    if (!m_info_dirty || !m_info_lba) {
+        m_info_dirty = false;
+        return 0;
+    }
+
+    if (move_window(m_info_lba) < 0) {
+        return -1;
+    }
+
+    st32(m_win + fsi_free_count, m_free);
+    st32(m_win + fsi_nxt_free, m_next_free);
+    m_win_dirty = true;
+
+    if (sync_window() < 0) {
+        return -1;
+    }
+
+    m_info_dirty = false;
+    return 0;
+}
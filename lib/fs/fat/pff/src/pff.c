@@ -986,7 +986,6 @@ FRESULT pf_lseek (
 {
     CLUST clst;
     DWORD bcs, sect, ifptr;
-    FATFS *fs = FatFs;
 
 
     if (!fs) return FR_NOT_ENABLED;		/* Check file system */
@@ -1008,14 +1007,14 @@ FRESULT pf_lseek (
             fs->curr_clust = clst;
         }
         while (ofs > bcs) {				/* Cluster following loop */
-            clst = get_fat(clst);		/* Follow cluster chain */
+            clst = get_fat(fs, clst);	/* Follow cluster chain */
             if (clst <= 1 || clst >= fs->n_fatent) ABORT(FR_DISK_ERR);
             fs->curr_clust = clst;
             fs->fptr += bcs;
             ofs -= bcs;
         }
         fs->fptr += ofs;
-        sect = clust2sect(clst);		/* Current sector */
+        sect = clust2sect(fs, clst);	/* Current sector */
         if (!sect) ABORT(FR_DISK_ERR);
         fs->dsect = sect + (fs->fptr / 512 & (fs->csize - 1));
     }
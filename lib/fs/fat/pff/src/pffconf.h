@@ -11,12 +11,21 @@
 
 #define	_USE_READ	1	/* Enable pf_read() function */
 #define	_USE_DIR	1	/* Enable pf_opendir() and pf_readdir() function */
-#define	_USE_LSEEK	0	/* Enable pf_lseek() function */
+#ifndef _USE_LSEEK
+#define	_USE_LSEEK	0	/* Enable pf_lseek() function, see CONFIG_FS_FAT_PETIT_LSEEK */
+#endif
 #define	_USE_WRITE	0	/* Enable pf_write() function */
 
+/* FAT types are selected by CONFIG_FS_FAT_PETIT_TYPES */
+#ifndef _FS_FAT12
 #define _FS_FAT12	0	/* Enable FAT12 */
+#endif
+#ifndef _FS_FAT16
 #define _FS_FAT16	0	/* Enable FAT16 */
+#endif
+#ifndef _FS_FAT32
 #define _FS_FAT32	1	/* Enable FAT32 */
+#endif
 
 
 /*---------------------------------------------------------------------------/
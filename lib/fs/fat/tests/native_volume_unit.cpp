@@ -0,0 +1,714 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include "fat/native/volume.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+using fat::native::volume;
+using fat::native::entry;
+using fat::native::dir_pos;
+using fat::native::cursor;
+using fat::native::cluster_map;
+
+// Device big enough to hold FAT32 with one sector per cluster
+static constexpr uint32_t disk_blocks = 66664;
+
+static uint8_t disk_data[disk_blocks * volume::sector_size];
+static size_t  disk_reads;
+static size_t  disk_writes;
+
+static int disk_read(void *obj, uint32_t lba, uint8_t *buf, size_t n)
+{
+    (void) obj;
+    if (lba + n > disk_blocks) {
+        return -1;
+    }
+
+    disk_reads++;
+    memcpy(buf, disk_data + lba * volume::sector_size, n * volume::sector_size);
+    return 0;
+}
+
+static int disk_write(void *obj, uint32_t lba, const uint8_t *buf, size_t n)
+{
+    (void) obj;
+    if (lba + n > disk_blocks) {
+        return -1;
+    }
+
+    disk_writes++;
+    memcpy(disk_data + lba * volume::sector_size, buf, n * volume::sector_size);
+    return 0;
+}
+
+static const uint8_t *disk_map(void *obj, uint32_t lba, size_t n)
+{
+    (void) obj;
+    if (lba + n > disk_blocks) {
+        return nullptr;
+    }
+
+    return disk_data + lba * volume::sector_size;
+}
+
+// Async requests complete right away, before start function returns
+static size_t  async_reqs;
+static size_t  async_last_n;
+
+static int disk_read_async(void *obj, uint32_t lba, uint8_t *buf, size_t n,
+                           volume::done_fn done, void *ctx)
+{
+    async_reqs++;
+    async_last_n = n;
+    done(ctx, disk_read(obj, lba, buf, n));
+    return 0;
+}
+
+static int disk_write_async(void *obj, uint32_t lba, const uint8_t *buf, size_t n,
+                            volume::done_fn done, void *ctx)
+{
+    async_reqs++;
+    async_last_n = n;
+    done(ctx, disk_write(obj, lba, buf, n));
+    return 0;
+}
+
+static const volume::disk test_disk = { nullptr, disk_read, disk_write, nullptr, nullptr, nullptr };
+static const volume::disk mapped_disk = { nullptr, disk_read, disk_write, disk_map, nullptr, nullptr };
+static const volume::disk async_disk = { nullptr, disk_read, disk_write, nullptr,
+                                         disk_read_async, disk_write_async };
+
+static void st16(uint8_t *p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void st32(uint8_t *p, uint32_t v)
+{
+    st16(p, v);
+    st16(p + 2, v >> 16);
+}
+
+// Creates an empty volume in the way mkfs would do
+static void format(uint32_t total, uint8_t spc, uint16_t root_ents, uint16_t reserved,
+                   uint32_t fat_len, bool fat32)
+{
+    memset(disk_data, 0, sizeof(disk_data));
+
+    uint8_t *bs = disk_data;
+    bs[0] = 0xeb;
+    bs[1] = 0x3c;
+    bs[2] = 0x90;
+    st16(bs + 11, volume::sector_size);
+    bs[13] = spc;
+    st16(bs + 14, reserved);
+    bs[16] = 2;
+    st16(bs + 17, root_ents);
+    st32(bs + 32, total);
+    bs[21] = 0xf8;
+    st16(bs + 510, 0xaa55);
+
+    uint8_t *fat[2] = {
+        disk_data + reserved * volume::sector_size,
+        disk_data + (reserved + fat_len) * volume::sector_size,
+    };
+
+    if (fat32) {
+        st32(bs + 36, fat_len);
+        st32(bs + 44, 2);
+        st16(bs + 48, 1);
+
+        uint8_t *info = disk_data + volume::sector_size;
+        st32(info, 0x41615252);
+        st32(info + 484, 0x61417272);
+        st32(info + 488, 0xffffffff);
+        st32(info + 492, 3);
+        st32(info + 508, 0xaa550000);
+
+        for (auto f : fat) {
+            st32(f, 0x0ffffff8);
+            st32(f + 4, 0x0fffffff);
+            // Root dir cluster
+            st32(f + 8, 0x0fffffff);
+        }
+    } else {
+        st16(bs + 22, fat_len);
+
+        for (auto f : fat) {
+            st16(f, 0xfff8);
+            st16(f + 2, 0xffff);
+        }
+    }
+}
+
+static void format_fat16()
+{
+    // 8095 clusters, 512 entries in the root
+    format(8192, 1, 512, 1, 32, false);
+}
+
+static void format_fat32()
+{
+    // 65600 clusters
+    format(disk_blocks, 1, 0, 32, 516, true);
+}
+
+static void fill(uint8_t *buf, size_t size, uint8_t seed)
+{
+    for (size_t i = 0; i < size; ++i) {
+        buf[i] = seed + i * 7 + (i >> 9);
+    }
+}
+
+TEST_GROUP(native_volume)
+{
+    volume *vol;
+
+    void setup()
+    {
+        vol = new volume;
+        disk_reads  = 0;
+        disk_writes = 0;
+    }
+
+    void teardown()
+    {
+        delete vol;
+    }
+
+    void remount()
+    {
+        CHECK_EQUAL(0, vol->sync());
+        delete vol;
+        vol = new volume;
+        CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+    }
+};
+
+TEST(native_volume, no_filesystem)
+{
+    memset(disk_data, 0, volume::sector_size);
+    CHECK_EQUAL(-1, vol->mount(test_disk, disk_blocks));
+}
+
+TEST(native_volume, empty_root)
+{
+    format_fat16();
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    dir_pos pos;
+    entry   e;
+
+    vol->dir_open(pos, vol->root());
+    CHECK_EQUAL(0, vol->dir_next(pos, e));
+    CHECK_EQUAL(0, vol->dir_find(vol->root(), "none.txt", e));
+}
+
+TEST(native_volume, names)
+{
+    format_fat16();
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    entry e;
+    CHECK_EQUAL(-1, vol->dir_create(vol->root(), "toolongname.txt", 0, e));
+    CHECK_EQUAL(-1, vol->dir_create(vol->root(), "a.b.c", 0, e));
+    CHECK_EQUAL(-1, vol->dir_create(vol->root(), "a*b", 0, e));
+    CHECK_EQUAL(-1, vol->dir_create(vol->root(), "name.", 0, e));
+
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "lower.txt", 0, e));
+    STRCMP_EQUAL("lower.txt", e.name);
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "Mixed.TXT", 0, e));
+    STRCMP_EQUAL("MIXED.TXT", e.name);
+
+    // Names are case-insensitive
+    CHECK_EQUAL(-1, vol->dir_create(vol->root(), "LOWER.TXT", 0, e));
+    CHECK_EQUAL(1, vol->dir_find(vol->root(), "mixed.txt", e));
+    STRCMP_EQUAL("MIXED.TXT", e.name);
+}
+
+TEST(native_volume, write_read_fat16)
+{
+    format_fat16();
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    static uint8_t in[10000];
+    static uint8_t out[10000];
+    fill(in, sizeof(in), 1);
+
+    entry  e;
+    cursor cur = {};
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "data.bin", 0, e));
+
+    // Chunks of odd sizes cross sector and cluster boundaries
+    const ssize_t chunks[] = { 1, 511, 3000, 512, 1024, 4952 };
+    uint32_t offt = 0;
+
+    for (auto c : chunks) {
+        CHECK_EQUAL(c, vol->write(e, cur, offt, in + offt, c));
+        offt += c;
+    }
+
+    CHECK_EQUAL(sizeof(in), e.size);
+    CHECK_EQUAL(0, vol->entry_update(e));
+
+    remount();
+
+    CHECK_EQUAL(1, vol->dir_find(vol->root(), "DATA.BIN", e));
+    CHECK_EQUAL(sizeof(in), e.size);
+
+    cur = {};
+    CHECK_EQUAL(sizeof(out), vol->read(e, cur, 0, out, sizeof(out) + 100));
+    MEMCMP_EQUAL(in, out, sizeof(in));
+
+    // Reading backwards rewinds the cursor
+    memset(out, 0, sizeof(out));
+    CHECK_EQUAL(100, vol->read(e, cur, 5000, out, 100));
+    MEMCMP_EQUAL(in + 5000, out, 100);
+    CHECK_EQUAL(100, vol->read(e, cur, 10, out, 100));
+    MEMCMP_EQUAL(in + 10, out, 100);
+
+    // End of file
+    CHECK_EQUAL(0, vol->read(e, cur, sizeof(in), out, 1));
+}
+
+TEST(native_volume, overwrite)
+{
+    format_fat16();
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    uint8_t in[2048];
+    uint8_t out[2048];
+    fill(in, sizeof(in), 3);
+
+    entry  e;
+    cursor cur = {};
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "f", 0, e));
+    CHECK_EQUAL(sizeof(in), vol->write(e, cur, 0, in, sizeof(in)));
+
+    // Patch in the middle, file size is kept
+    memset(in + 700, 0x55, 10);
+    CHECK_EQUAL(10, vol->write(e, cur, 700, in + 700, 10));
+    CHECK_EQUAL(sizeof(in), e.size);
+
+    // Holes are not allowed
+    CHECK_EQUAL(-1, vol->write(e, cur, sizeof(in) + 1, in, 1));
+
+    CHECK_EQUAL(0, vol->entry_update(e));
+    remount();
+
+    CHECK_EQUAL(1, vol->dir_find(vol->root(), "F", e));
+    cur = {};
+    CHECK_EQUAL(sizeof(out), vol->read(e, cur, 0, out, sizeof(out)));
+    MEMCMP_EQUAL(in, out, sizeof(in));
+}
+
+static uint32_t test_time()
+{
+    return 0x5a2f6b4d;
+}
+
+TEST(native_volume, timestamps)
+{
+    format_fat16();
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    volume::set_time_source(test_time);
+
+    entry e;
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "stamped", 0, e));
+    CHECK_EQUAL(0, vol->sync());
+
+    volume::set_time_source(nullptr);
+
+    // Creation, access and write stamps are set from the source
+    const uint8_t *raw = disk_data + e.sector * volume::sector_size + e.offset;
+    const uint8_t stamp[] = { 0x4d, 0x6b, 0x2f, 0x5a };
+
+    MEMCMP_EQUAL(stamp, raw + 14, 4);
+    MEMCMP_EQUAL(stamp + 2, raw + 18, 2);
+    MEMCMP_EQUAL(stamp, raw + 22, 2);
+    MEMCMP_EQUAL(stamp + 2, raw + 24, 2);
+
+    // Update stamps write time only
+    CHECK_EQUAL(0, vol->entry_update(e));
+    CHECK_EQUAL(0, vol->sync());
+
+    MEMCMP_EQUAL(stamp, raw + 14, 4);
+    CHECK_EQUAL(0, raw[22]);
+    CHECK_EQUAL(0, raw[23]);
+}
+
+TEST(native_volume, subdirs)
+{
+    format_fat16();
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    entry d;
+    entry e;
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "sub", volume::attr_dir, d));
+    CHECK(d.cluster);
+
+    // More entries than fits into a single cluster, dir must grow
+    char name[24];
+    for (int i = 0; i < 40; ++i) {
+        snprintf(name, sizeof(name), "file%d.txt", i);
+        CHECK_EQUAL(0, vol->dir_create(d.cluster, name, 0, e));
+    }
+
+    remount();
+
+    CHECK_EQUAL(1, vol->dir_find(vol->root(), "sub", d));
+    CHECK(d.attr & volume::attr_dir);
+
+    // Dot entries are hidden
+    dir_pos pos;
+    int cnt = 0;
+    vol->dir_open(pos, d.cluster);
+    while (vol->dir_next(pos, e) > 0) {
+        snprintf(name, sizeof(name), "file%d.txt", cnt++);
+        STRCMP_EQUAL(name, e.name);
+    }
+
+    CHECK_EQUAL(40, cnt);
+}
+
+TEST(native_volume, fat32_multi_sector_io)
+{
+    format_fat32();
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    static uint8_t in[64 * 1024];
+    static uint8_t out[64 * 1024];
+    fill(in, sizeof(in), 9);
+
+    entry  e;
+    cursor cur = {};
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "big.bin", 0, e));
+
+    disk_writes = 0;
+    CHECK_EQUAL(sizeof(in), vol->write(e, cur, 0, in, sizeof(in)));
+
+    // Allocation is sequential, so data goes in a single transfer
+    CHECK_EQUAL(1, disk_writes);
+
+    CHECK_EQUAL(0, vol->entry_update(e));
+    remount();
+
+    CHECK_EQUAL(1, vol->dir_find(vol->root(), "big.bin", e));
+
+    disk_reads = 0;
+    cur = {};
+    CHECK_EQUAL(sizeof(out), vol->read(e, cur, 0, out, sizeof(out)));
+    MEMCMP_EQUAL(in, out, sizeof(in));
+
+    // Chain of 128 clusters is described by a single FAT sector, which is cached
+    CHECK(disk_reads <= 3);
+}
+
+TEST(native_volume, fat_copies_in_sync)
+{
+    format_fat16();
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    uint8_t buf[1536] = {};
+    entry   e;
+    cursor  cur = {};
+
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "a", 0, e));
+    CHECK_EQUAL(sizeof(buf), vol->write(e, cur, 0, buf, sizeof(buf)));
+    CHECK_EQUAL(0, vol->entry_update(e));
+    CHECK_EQUAL(0, vol->sync());
+
+    const uint8_t *fat0 = disk_data + 1 * volume::sector_size;
+    const uint8_t *fat1 = disk_data + 33 * volume::sector_size;
+
+    MEMCMP_EQUAL(fat0, fat1, 32 * volume::sector_size);
+
+    // Chain of three clusters: 2 -> 3 -> 4 -> EOC
+    CHECK_EQUAL(2, e.cluster);
+    CHECK_EQUAL(3, fat0[4]);
+    CHECK_EQUAL(4, fat0[6]);
+    CHECK_EQUAL(0xff, fat0[8]);
+    CHECK_EQUAL(0xff, fat0[9]);
+}
+
+// Places long name entries and a short entry into FAT16 root
+static void put_long_name(uint32_t index, const char *long_name, const char *short_name)
+{
+    static const uint8_t chars[] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+
+    uint8_t *root = disk_data + 65 * volume::sector_size;
+    size_t len = strlen(long_name);
+    size_t cnt = (len + 12) / 13;
+
+    uint8_t sum = 0;
+    for (size_t i = 0; i < 11; ++i) {
+        sum = ((sum & 1) << 7) + (sum >> 1) + short_name[i];
+    }
+
+    for (size_t n = cnt; n > 0; --n) {
+        uint8_t *raw = root + (index++) * 32;
+        memset(raw, 0xff, 32);
+        raw[0]  = n | (n == cnt ? 0x40 : 0);
+        raw[11] = volume::attr_lfn;
+        raw[12] = 0;
+        raw[13] = sum;
+        st16(raw + 26, 0);
+
+        for (size_t i = 0; i < 13; ++i) {
+            size_t c = (n - 1) * 13 + i;
+            if (c <= len) {
+                st16(raw + chars[i], c < len ? long_name[c] : 0);
+            }
+        }
+    }
+
+    uint8_t *raw = root + index * 32;
+    memset(raw, 0, 32);
+    memcpy(raw, short_name, 11);
+    raw[11] = volume::attr_archive;
+}
+
+TEST(native_volume, long_names)
+{
+    format_fat16();
+    put_long_name(0, "Configuration.json", "CONFIG~1JSO");
+    // Exactly two entries, no terminator
+    put_long_name(3, "Twenty-six characters.text", "TWENTY~1TEX");
+    // Checksum does not match, must be ignored
+    put_long_name(6, "orphan.txt", "ORPHAN~1TXT");
+    disk_data[65 * volume::sector_size + 6 * 32 + 13] ^= 1;
+
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    entry e;
+    CHECK_EQUAL(1, vol->dir_find(vol->root(), "configuration.JSON", e));
+    STRCMP_EQUAL("CONFIG~1.JSO", e.name);
+    CHECK_EQUAL(1, vol->dir_find(vol->root(), "config~1.jso", e));
+    CHECK_EQUAL(1, vol->dir_find(vol->root(), "Twenty-six characters.text", e));
+    STRCMP_EQUAL("TWENTY~1.TEX", e.name);
+    CHECK_EQUAL(0, vol->dir_find(vol->root(), "Twenty-six characters.tex", e));
+    CHECK_EQUAL(0, vol->dir_find(vol->root(), "orphan.txt", e));
+    CHECK_EQUAL(1, vol->dir_find(vol->root(), "orphan~1.txt", e));
+
+    // Buffer that is too small gets empty name
+    char small[8];
+    dir_pos pos;
+    vol->dir_open(pos, vol->root());
+    CHECK_EQUAL(1, vol->dir_next(pos, e, small, sizeof(small)));
+    STRCMP_EQUAL("", small);
+}
+
+TEST(native_volume, mapped_seek)
+{
+    format_fat16();
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    // Chain spans more FAT sectors than the cache holds
+    static uint8_t in[2048 * volume::sector_size];
+    fill(in, sizeof(in), 5);
+
+    entry  e;
+    cursor cur = {};
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "big.bin", 0, e));
+    CHECK_EQUAL(sizeof(in), vol->write(e, cur, 0, in, sizeof(in)));
+    CHECK_EQUAL(0, vol->entry_update(e));
+
+    remount();
+    CHECK_EQUAL(1, vol->dir_find(vol->root(), "big.bin", e));
+
+    cluster_map map;
+    CHECK_EQUAL(0, vol->map_chain(e.cluster, map));
+    CHECK_EQUAL(1, map.count);
+    CHECK_EQUAL(2048, map.runs[0].length);
+
+    cur = {};
+    cur.map = &map;
+
+    uint8_t out[16];
+    const uint32_t offts[] = { 2000 * 512 + 3, 10, 1500 * 512, 2047 * 512 + 100 };
+
+    for (auto offt : offts) {
+        disk_reads = 0;
+        CHECK_EQUAL(sizeof(out), vol->read(e, cur, offt, out, sizeof(out)));
+        MEMCMP_EQUAL(in + offt, out, sizeof(out));
+        // Data sector only
+        CHECK_EQUAL(1, disk_reads);
+    }
+}
+
+TEST(native_volume, mapped_seek_fragmented)
+{
+    format_fat16();
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    static uint8_t in[2][32 * volume::sector_size];
+    fill(in[0], sizeof(in[0]), 1);
+    fill(in[1], sizeof(in[1]), 2);
+
+    entry  e[2];
+    cursor cur[2] = {};
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "a", 0, e[0]));
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "b", 0, e[1]));
+
+    // Interleaved writes make every cluster a separate run
+    for (uint32_t offt = 0; offt < sizeof(in[0]); offt += volume::sector_size) {
+        for (int i = 0; i < 2; ++i) {
+            CHECK_EQUAL(volume::sector_size,
+                        vol->write(e[i], cur[i], offt, in[i] + offt, volume::sector_size));
+        }
+    }
+
+    cluster_map map;
+    CHECK_EQUAL(0, vol->map_chain(e[0].cluster, map));
+    CHECK_EQUAL(cluster_map::max_runs, map.count);
+
+    cursor c = {};
+    c.map = &map;
+
+    // Both mapped and unmapped parts are reachable
+    uint8_t out[volume::sector_size];
+    const uint32_t idx[] = { 20, 3, 31, 0, 7, 8 };
+
+    for (auto i : idx) {
+        CHECK_EQUAL(sizeof(out), vol->read(e[0], c, i * volume::sector_size, out, sizeof(out)));
+        MEMCMP_EQUAL(in[0] + i * volume::sector_size, out, sizeof(out));
+    }
+}
+
+TEST(native_volume, map)
+{
+    format_fat16();
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    static uint8_t in[2][4 * volume::sector_size];
+    fill(in[0], sizeof(in[0]), 1);
+    fill(in[1], sizeof(in[1]), 2);
+
+    entry  e[2];
+    cursor cur[2] = {};
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "a", 0, e[0]));
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "b", 0, e[1]));
+
+    // First two clusters of "a" are contiguous, then clusters interleave
+    CHECK_EQUAL(1024, vol->write(e[0], cur[0], 0, in[0], 1024));
+    for (uint32_t offt = 0; offt < sizeof(in[1]); offt += volume::sector_size) {
+        CHECK_EQUAL(volume::sector_size,
+                    vol->write(e[1], cur[1], offt, in[1] + offt, volume::sector_size));
+        if (offt + 1024 < sizeof(in[0])) {
+            CHECK_EQUAL(volume::sector_size,
+                        vol->write(e[0], cur[0], offt + 1024, in[0] + offt + 1024,
+                                   volume::sector_size));
+        }
+    }
+
+    // Not possible without device support
+    cursor c = {};
+    POINTERS_EQUAL(nullptr, vol->map(e[0], c, 0, 16));
+
+    CHECK_EQUAL(0, vol->entry_update(e[0]));
+    CHECK_EQUAL(0, vol->entry_update(e[1]));
+    CHECK_EQUAL(0, vol->sync());
+    delete vol;
+    vol = new volume;
+    CHECK_EQUAL(0, vol->mount(mapped_disk, disk_blocks));
+
+    c = {};
+    auto p = vol->map(e[0], c, 100, 900);
+    CHECK(p);
+    MEMCMP_EQUAL(in[0] + 100, p, 900);
+
+    // Crosses a gap between clusters
+    POINTERS_EQUAL(nullptr, vol->map(e[0], c, 1000, 100));
+    // Past end of file
+    POINTERS_EQUAL(nullptr, vol->map(e[0], c, 2000, 100));
+
+    p = vol->map(e[0], c, 1536, 512);
+    CHECK(p);
+    MEMCMP_EQUAL(in[0] + 1536, p, 512);
+}
+
+static void count_done(void *ctx, int status)
+{
+    auto statuses = static_cast< int* >(ctx);
+    statuses[status < 0 ? 1 : 0]++;
+}
+
+TEST(native_volume, async_xfer)
+{
+    format_fat16();
+    CHECK_EQUAL(0, vol->mount(test_disk, disk_blocks));
+
+    static uint8_t in[4 * volume::sector_size];
+    static uint8_t out[4 * volume::sector_size];
+    fill(in, sizeof(in), 3);
+
+    entry  e[2];
+    cursor cur[2] = {};
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "a", 0, e[0]));
+    CHECK_EQUAL(0, vol->dir_create(vol->root(), "b", 0, e[1]));
+
+    // Last sector of "a" is separated by a cluster of "b"
+    CHECK_EQUAL(1536, vol->write(e[0], cur[0], 0, in, 1536));
+    CHECK_EQUAL(512, vol->write(e[1], cur[1], 0, in, 512));
+    CHECK_EQUAL(512, vol->write(e[0], cur[0], 1536, in + 1536, 512));
+
+    int statuses[2] = {};
+    cursor c = {};
+    size_t size = sizeof(out);
+
+    // Not possible without device support
+    CHECK_EQUAL(-1, vol->start_xfer(e[0], c, 0, out, size, false, count_done, statuses));
+
+    CHECK_EQUAL(0, vol->entry_update(e[0]));
+    CHECK_EQUAL(0, vol->sync());
+    delete vol;
+    vol = new volume;
+    CHECK_EQUAL(0, vol->mount(async_disk, disk_blocks));
+    async_reqs = 0;
+
+    // Request is cut at the gap
+    c = {};
+    size = sizeof(out);
+    CHECK_EQUAL(0, vol->start_xfer(e[0], c, 0, out, size, false, count_done, statuses));
+    CHECK_EQUAL(1536, size);
+    CHECK_EQUAL(1, async_reqs);
+    CHECK_EQUAL(3, async_last_n);
+    CHECK_EQUAL(1, statuses[0]);
+    MEMCMP_EQUAL(in, out, 1536);
+
+    size = sizeof(out);
+    CHECK_EQUAL(0, vol->start_xfer(e[0], c, 1536, out, size, false, count_done, statuses));
+    CHECK_EQUAL(512, size);
+    MEMCMP_EQUAL(in + 1536, out, 512);
+
+    // Partial sectors and data past the end are not transferred this way
+    size = 512;
+    CHECK_EQUAL(-1, vol->start_xfer(e[0], c, 100, out, size, false, count_done, statuses));
+    size = 100;
+    CHECK_EQUAL(-1, vol->start_xfer(e[0], c, 0, out, size, false, count_done, statuses));
+    size = 512;
+    CHECK_EQUAL(-1, vol->start_xfer(e[0], c, 2048, out, size, false, count_done, statuses));
+    CHECK_EQUAL(2, async_reqs);
+
+    // Overwrite, window must not hide new data
+    c = {};
+    CHECK_EQUAL(16, vol->read(e[0], c, 512, out, 16));
+    fill(in + 512, 512, 9);
+    size = 512;
+    CHECK_EQUAL(0, vol->start_xfer(e[0], c, 512, in + 512, size, true, count_done, statuses));
+    CHECK_EQUAL(512, size);
+    CHECK_EQUAL(0, statuses[1]);
+
+    c = {};
+    CHECK_EQUAL(16, vol->read(e[0], c, 512, out, 16));
+    MEMCMP_EQUAL(in + 512, out, 16);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
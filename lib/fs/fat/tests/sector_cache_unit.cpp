@@ -0,0 +1,164 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include "fat/sector_cache.hpp"
+#include "fs/ram_block.hpp"
+
+#include <string.h>
+
+using disk_t = fs::ram_block< 16, 512 >;
+
+// Not mapped device, counting its requests
+class counting_disk
+{
+public:
+    int init() { return m_disk.init(); }
+    int open() { return m_disk.open(); }
+    int close() { return m_disk.close(); }
+    size_t get_block_length() { return m_disk.get_block_length(); }
+    size_t block_count() const { return m_disk.block_count(); }
+    size_t preferred_io_size() { return m_disk.preferred_io_size(); }
+
+    int read_blocks(size_t lba, uint8_t *buf, size_t n)
+    {
+        reads++;
+        last_n = n;
+        return fail ? -1 : m_disk.read_blocks(lba, buf, n);
+    }
+
+    int write_blocks(size_t lba, const uint8_t *buf, size_t n)
+    {
+        return m_disk.write_blocks(lba, buf, n);
+    }
+
+    int trim(size_t lba, size_t n) { return m_disk.trim(lba, n); }
+
+    size_t reads = 0;
+    size_t last_n = 0;
+    bool fail = false;
+
+private:
+    disk_t m_disk;
+};
+
+static_assert(fs::is_block_device< counting_disk >::value, "");
+static_assert(!fs::is_mapped_device< counting_disk >::value, "");
+
+using cache_t = fat::sector_cache< counting_disk, 2, 4 >;
+
+TEST_GROUP(sector_cache)
+{
+    counting_disk disk;
+    cache_t *cache;
+
+    void setup()
+    {
+        disk.init();
+        disk.open();
+
+        uint8_t sector[512];
+        for (uint8_t i = 0; i < 16; ++i) {
+            memset(sector, i, sizeof(sector));
+            disk.write_blocks(i, sector, 1);
+        }
+
+        cache = new cache_t{disk};
+    }
+
+    void teardown()
+    {
+        delete cache;
+    }
+};
+
+TEST(sector_cache, pieces_of_same_sector_are_read_once)
+{
+    uint8_t buf[32];
+
+    for (size_t offt = 0; offt < 512; offt += 32) {
+        CHECK_EQUAL(0, cache->read(5, offt, buf, 32));
+        CHECK_EQUAL(5, buf[0]);
+    }
+
+    CHECK_EQUAL(1, disk.reads);
+    CHECK_EQUAL(1, cache->get_stats().misses);
+    CHECK_EQUAL(15, cache->get_stats().hits);
+}
+
+TEST(sector_cache, random_sectors_are_kept_by_lru)
+{
+    uint8_t b;
+
+    CHECK_EQUAL(0, cache->read(3, 0, &b, 1));
+    CHECK_EQUAL(0, cache->read(9, 0, &b, 1));
+    CHECK_EQUAL(0, cache->read(3, 1, &b, 1));
+    CHECK_EQUAL(2, disk.reads);
+
+    // Evicts 9, as 3 was used later
+    CHECK_EQUAL(0, cache->read(12, 0, &b, 1));
+    CHECK_EQUAL(12, b);
+    CHECK_EQUAL(0, cache->read(3, 0, &b, 1));
+    CHECK_EQUAL(3, b);
+    CHECK_EQUAL(3, disk.reads);
+
+    CHECK_EQUAL(0, cache->read(9, 0, &b, 1));
+    CHECK_EQUAL(9, b);
+    CHECK_EQUAL(4, disk.reads);
+}
+
+TEST(sector_cache, sequential_access_reads_ahead)
+{
+    uint8_t buf[16];
+
+    // First miss is not known to be sequential
+    CHECK_EQUAL(0, cache->read(2, 0, buf, 16));
+    CHECK_EQUAL(1, disk.last_n);
+
+    CHECK_EQUAL(0, cache->read(3, 0, buf, 16));
+    CHECK_EQUAL(4, disk.last_n);
+    CHECK_EQUAL(2, disk.reads);
+
+    for (uint8_t s = 3; s < 7; ++s) {
+        CHECK_EQUAL(0, cache->read(s, 100, buf, 16));
+        CHECK_EQUAL(s, buf[0]);
+    }
+
+    CHECK_EQUAL(2, disk.reads);
+
+    // Sector after the window continues readahead
+    CHECK_EQUAL(0, cache->read(7, 0, buf, 16));
+    CHECK_EQUAL(7, buf[0]);
+    CHECK_EQUAL(3, disk.reads);
+    CHECK_EQUAL(4, disk.last_n);
+
+    // Window is cut at the device end
+    CHECK_EQUAL(0, cache->read(14, 0, buf, 16));
+    CHECK_EQUAL(0, cache->read(15, 0, buf, 16));
+    CHECK_EQUAL(1, disk.last_n);
+    CHECK_EQUAL(15, buf[0]);
+}
+
+TEST(sector_cache, errors_are_not_cached)
+{
+    uint8_t b;
+
+    CHECK_EQUAL(-1, cache->read(0, 510, &b, 3));
+
+    disk.fail = true;
+    CHECK_EQUAL(-1, cache->read(4, 0, &b, 1));
+    CHECK_EQUAL(-1, cache->read(5, 0, &b, 1));
+
+    disk.fail = false;
+    CHECK_EQUAL(0, cache->read(4, 0, &b, 1));
+    CHECK_EQUAL(4, b);
+    CHECK_EQUAL(3, disk.reads);
+
+    cache->invalidate();
+    CHECK_EQUAL(0, cache->read(4, 0, &b, 1));
+    CHECK_EQUAL(4, disk.reads);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
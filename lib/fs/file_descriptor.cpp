@@ -15,3 +15,67 @@ file_descriptor::~file_descriptor()
 {
 }
 
+
+const uint8_t *file_descriptor::map(off_t offt, size_t len)
+{
+    (void) offt;
+    (void) len;
+    return nullptr;
+}
+
+int file_descriptor::reopen()
+{
+    return -1;
+}
+
+ssize_t file_descriptor::readv(const ecl::iovec *iov, size_t n)
+{
+    ssize_t total = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        auto rc = read(static_cast< uint8_t* >(iov[i].iov_base), iov[i].iov_len);
+        if (rc < 0) {
+            return total ? total : -1;
+        }
+
+        total += rc;
+        if (static_cast< size_t >(rc) < iov[i].iov_len) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+ssize_t file_descriptor::writev(const ecl::iovec *iov, size_t n)
+{
+    ssize_t total = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        auto rc = write(static_cast< const uint8_t* >(iov[i].iov_base), iov[i].iov_len);
+        if (rc < 0) {
+            return total ? total : -1;
+        }
+
+        total += rc;
+        if (static_cast< size_t >(rc) < iov[i].iov_len) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+int file_descriptor::read_async(uint8_t *buf, size_t size, const io_callback &cb)
+{
+    auto rc = read(buf, size);
+    cb(rc);
+    return 0;
+}
+
+int file_descriptor::write_async(const uint8_t *buf, size_t size, const io_callback &cb)
+{
+    auto rc = write(buf, size);
+    cb(rc);
+    return 0;
+}
@@ -26,6 +26,14 @@ dir_ptr inode::open_dir()
     return dir_ptr{};
 }
 
+inode_ptr inode::create(const char *name, type t)
+{
+    (void) name;
+    (void) t;
+    // Read-only filesystems do not override it
+    return inode_ptr{};
+}
+
 int inode::set_weak(const fs::inode_ptr &ptr)
 {
     ecl_assert(my_ptr.expired());
@@ -0,0 +1,85 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include "fs/dentry_cache.hpp"
+
+#include <stdio.h>
+
+using cache_t = fs::dentry_cache< int, 4, 16 >;
+
+TEST_GROUP(dentry_cache)
+{
+    cache_t cache;
+
+    void setup()
+    {
+        cache.invalidate();
+    }
+};
+
+TEST(dentry_cache, empty)
+{
+    CHECK_EQUAL(0, cache.find("/"));
+    CHECK_EQUAL(0, cache.find("/a/b"));
+}
+
+TEST(dentry_cache, case_insensitive)
+{
+    cache.insert("/etc/config.txt", 1);
+    cache.insert("/etc", 2);
+
+    CHECK_EQUAL(1, cache.find("/etc/config.txt"));
+    CHECK_EQUAL(1, cache.find("/ETC/Config.TXT"));
+    CHECK_EQUAL(2, cache.find("/etc"));
+    CHECK_EQUAL(0, cache.find("/etc/"));
+}
+
+TEST(dentry_cache, replace)
+{
+    cache.insert("/a", 1);
+    cache.insert("/A", 2);
+    CHECK_EQUAL(2, cache.find("/a"));
+
+    // Other entries are kept
+    cache.insert("/b", 3);
+    cache.insert("/c", 4);
+    cache.insert("/d", 5);
+    CHECK_EQUAL(2, cache.find("/a"));
+}
+
+TEST(dentry_cache, lru_eviction)
+{
+    char path[8];
+
+    for (int i = 0; i < 4; ++i) {
+        snprintf(path, sizeof(path), "/%d", i);
+        cache.insert(path, i + 1);
+    }
+
+    // Makes first entry most recently used
+    CHECK_EQUAL(1, cache.find("/0"));
+
+    cache.insert("/4", 5);
+    CHECK_EQUAL(1, cache.find("/0"));
+    CHECK_EQUAL(0, cache.find("/1"));
+    CHECK_EQUAL(3, cache.find("/2"));
+    CHECK_EQUAL(5, cache.find("/4"));
+}
+
+TEST(dentry_cache, long_path)
+{
+    cache.insert("/very/long/path/to/file", 1);
+    CHECK_EQUAL(0, cache.find("/very/long/path/to/file"));
+}
+
+TEST(dentry_cache, invalidate)
+{
+    cache.insert("/a", 1);
+    cache.invalidate();
+    CHECK_EQUAL(0, cache.find("/a"));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,147 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include "fs/file_cache.hpp"
+
+#include <memory>
+
+struct node
+{
+};
+
+struct descriptor
+{
+    int reopen()
+    {
+        reopened++;
+        return fail ? -1 : 0;
+    }
+
+    int close()
+    {
+        closed++;
+        return 0;
+    }
+
+    int reopened = 0;
+    int closed = 0;
+    bool fail = false;
+};
+
+using node_ptr = std::shared_ptr< node >;
+using file_ptr = std::shared_ptr< descriptor >;
+using cache_t  = fs::file_cache< node_ptr, file_ptr, 2 >;
+
+TEST_GROUP(file_cache)
+{
+    cache_t cache;
+    node_ptr a = std::make_shared< node >();
+    node_ptr b = std::make_shared< node >();
+    node_ptr c = std::make_shared< node >();
+};
+
+TEST(file_cache, empty)
+{
+    CHECK(!cache.revive(a));
+}
+
+TEST(file_cache, unused_descriptor_is_reopened)
+{
+    auto fd = std::make_shared< descriptor >();
+    auto raw = fd.get();
+    cache.insert(a, fd);
+
+    // Still in use
+    CHECK(!cache.revive(a));
+    CHECK(!cache.revive(b));
+
+    fd.reset();
+    fd = cache.revive(a);
+    POINTERS_EQUAL(raw, fd.get());
+    CHECK_EQUAL(1, fd->reopened);
+
+    // Revived descriptor is in use again
+    CHECK(!cache.revive(a));
+}
+
+TEST(file_cache, descriptors_in_use_are_not_evicted)
+{
+    auto fa = std::make_shared< descriptor >();
+    auto fb = std::make_shared< descriptor >();
+    auto fc = std::make_shared< descriptor >();
+
+    cache.insert(a, fa);
+    cache.insert(b, fb);
+    // No room, all in use
+    cache.insert(c, fc);
+
+    fc.reset();
+    CHECK(!cache.revive(c));
+
+    // Least recently used unused one goes away
+    fb.reset();
+    fc = std::make_shared< descriptor >();
+    cache.insert(c, fc);
+    CHECK(!cache.revive(b));
+
+    fc.reset();
+    CHECK(cache.revive(c));
+}
+
+TEST(file_cache, failed_reopen_drops_entry)
+{
+    auto fd = std::make_shared< descriptor >();
+    fd->fail = true;
+    std::weak_ptr< descriptor > weak = fd;
+
+    cache.insert(a, fd);
+    fd.reset();
+
+    CHECK(!cache.revive(a));
+    CHECK(weak.expired());
+    CHECK(!cache.revive(a));
+}
+
+TEST(file_cache, unused_descriptors_are_closed)
+{
+    auto fa = std::make_shared< descriptor >();
+    auto fb = std::make_shared< descriptor >();
+    auto raw = fa.get();
+
+    cache.insert(a, fa);
+    cache.insert(b, fb);
+
+    // Dropped without close(), i.e. still holds filesystem resources
+    fa.reset();
+    cache.close_unused();
+
+    CHECK_EQUAL(1, raw->closed);
+    CHECK_EQUAL(0, fb->closed);
+
+    // Closed descriptor is still reused
+    fa = cache.revive(a);
+    POINTERS_EQUAL(raw, fa.get());
+    CHECK_EQUAL(1, fa->reopened);
+
+    cache.close_unused();
+    CHECK_EQUAL(1, fa->closed);
+}
+
+TEST(file_cache, invalidate_releases_descriptors)
+{
+    auto fd = std::make_shared< descriptor >();
+    std::weak_ptr< descriptor > weak = fd;
+
+    cache.insert(a, fd);
+    fd.reset();
+    CHECK(!weak.expired());
+
+    cache.invalidate();
+    CHECK(weak.expired());
+    CHECK(!cache.revive(a));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
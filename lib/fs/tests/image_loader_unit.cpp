@@ -0,0 +1,218 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include "fs/image_loader.hpp"
+#include "fs/ram_block.hpp"
+
+#include <ecl/ram_flash.hpp>
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using disk_t = fs::ram_block< 128 >;
+
+// Four sectors of 2 KiB
+using flash_t = ecl::ram_flash< 2048, 4 >;
+
+// Chunks of 2 blocks
+using loader_t = fs::image_loader< flash_t, 2 >;
+
+// Log of device and digest operations, to check their order
+std::string ops;
+
+// Disk with split reads
+struct async_disk : disk_t
+{
+    int read_start(size_t lba, uint8_t *buf, size_t n)
+    {
+        if (pending || lba == fail_lba) {
+            return -1;
+        }
+
+        ops += "s";
+        pending = true;
+        return read_blocks(lba, buf, n);
+    }
+
+    int read_finish()
+    {
+        if (!pending) {
+            return -1;
+        }
+
+        ops += "f";
+        pending = false;
+        return 0;
+    }
+
+    bool pending = false;
+    size_t fail_lba = SIZE_MAX;
+};
+
+// Digest, which keeps all data
+struct digest
+{
+    void update(const uint8_t *data, size_t size)
+    {
+        ops += "h";
+        bytes.insert(bytes.end(), data, data + size);
+    }
+
+    std::vector< uint8_t > bytes;
+};
+
+static_assert(fs::is_async_device< async_disk >::value, "");
+static_assert(!fs::is_async_device< disk_t >::value, "");
+
+std::vector< uint8_t > image(size_t size)
+{
+    std::vector< uint8_t > img(size);
+    for (size_t i = 0; i < size; ++i) {
+        img[i] = i * 13 + (i >> 8);
+    }
+
+    return img;
+}
+
+// Writes the image to given extents of the disk
+void place(disk_t &disk, const std::vector< uint8_t > &img,
+           const fs::extent *ext, size_t count)
+{
+    size_t offt = 0;
+
+    for (size_t i = 0; i < count && offt < img.size(); ++i) {
+        for (size_t b = 0; b < ext[i].blocks && offt < img.size(); ++b) {
+            uint8_t block[512];
+            size_t n = std::min< size_t >(512, img.size() - offt);
+
+            memset(block, 0xee, sizeof(block));
+            memcpy(block, img.data() + offt, n);
+            disk.write_blocks(ext[i].lba + b, block, 1);
+            offt += n;
+        }
+    }
+}
+
+bool flash_holds(const std::vector< uint8_t > &img)
+{
+    for (size_t i = 0; i < img.size(); ++i) {
+        if (flash_t::map(i / flash_t::sector_size)[i % flash_t::sector_size] != img[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+TEST_GROUP(image_loader)
+{
+    async_disk *disk;
+    loader_t *loader;
+
+    void setup()
+    {
+        flash_t::wipe();
+        ops.clear();
+
+        disk = new async_disk;
+        disk->init();
+        disk->open();
+        loader = new loader_t;
+    }
+
+    void teardown()
+    {
+        delete loader;
+        delete disk;
+    }
+};
+
+TEST(image_loader, fragmented_image)
+{
+    // 5 KiB image spread over three extents, last block is partial
+    const fs::extent ext[] = { {10, 3}, {40, 5}, {20, 4} };
+    auto img = image(5 * 1024 + 100);
+    digest h;
+
+    place(*disk, img, ext, 3);
+
+    CHECK_EQUAL(static_cast< ssize_t >(img.size()), loader->load(*disk, ext, 3, img.size(), h));
+    CHECK_TRUE(img == h.bytes);
+    CHECK_TRUE(flash_holds(img));
+
+    // Tail is padded, sectors past the image are not touched
+    CHECK_EQUAL(0xff, flash_t::map(2)[img.size() % 2048]);
+    CHECK_EQUAL(1, flash_t::erases(0));
+    CHECK_EQUAL(1, flash_t::erases(2));
+    CHECK_EQUAL(0, flash_t::erases(3));
+}
+
+TEST(image_loader, reads_overlap_processing)
+{
+    const fs::extent ext[] = { {0, 8} };
+    auto img = image(8 * 512);
+    digest h;
+
+    place(*disk, img, ext, 1);
+    CHECK_EQUAL(static_cast< ssize_t >(img.size()), loader->load(*disk, ext, 1, img.size(), h));
+
+    // Each chunk is hashed while the next one is read
+    STRCMP_EQUAL("sfshfshfshfh", ops.c_str());
+}
+
+TEST(image_loader, plain_device)
+{
+    disk_t plain;
+    const fs::extent ext[] = { {5, 2}, {100, 6} };
+    auto img = image(3000);
+    digest h;
+
+    plain.init();
+    plain.open();
+    place(plain, img, ext, 2);
+
+    CHECK_EQUAL(static_cast< ssize_t >(img.size()), loader->load(plain, ext, 2, img.size(), h));
+    CHECK_TRUE(img == h.bytes);
+    CHECK_TRUE(flash_holds(img));
+}
+
+TEST(image_loader, errors)
+{
+    const fs::extent ext[] = { {0, 4}, {50, 4} };
+    auto img = image(4 * 1024);
+    digest h;
+
+    place(*disk, img, ext, 2);
+
+    // Extents are shorter than the image, image doesn't fit flash
+    CHECK_EQUAL(-1, loader->load(*disk, ext, 1, img.size(), h));
+    CHECK_EQUAL(-1, loader->load(*disk, ext, 2, flash_t::sectors * 2048 + 1, h));
+    CHECK_EQUAL(-1, loader->load(*disk, ext, 2, 0, h));
+
+    // Read fails in the middle, no read is left pending
+    disk->fail_lba = 52;
+    CHECK_EQUAL(-1, loader->load(*disk, ext, 2, img.size(), h));
+    CHECK_FALSE(disk->pending);
+
+    // Flash fails
+    disk->fail_lba = SIZE_MAX;
+    flash_t::lose_power_after(100);
+    CHECK_EQUAL(-1, loader->load(*disk, ext, 2, img.size(), h));
+    CHECK_FALSE(disk->pending);
+
+    flash_t::lose_power_after(SIZE_MAX);
+    h.bytes.clear();
+    CHECK_EQUAL(static_cast< ssize_t >(img.size()), loader->load(*disk, ext, 2, img.size(), h));
+    CHECK_TRUE(flash_holds(img));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,268 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include "fs/log_store.hpp"
+#include "fs/ram_block.hpp"
+
+#include <string.h>
+#include <vector>
+
+namespace
+{
+
+constexpr size_t block_len = 64;
+
+// RAM disk, losing power after given amount of written blocks
+struct faulty_disk : fs::ram_block< 32, block_len >
+{
+    using disk = fs::ram_block< 32, block_len >;
+
+    int write_blocks(size_t lba, const uint8_t *buf, size_t n)
+    {
+        ++writes;
+
+        for (size_t i = 0; i < n; ++i, --budget) {
+            if (!budget) {
+                return -1;
+            }
+
+            disk::write_blocks(lba + i, buf + i * block_len, 1);
+        }
+
+        return 0;
+    }
+
+    size_t budget = SIZE_MAX;
+    int writes = 0;
+};
+
+// Segments of 8 blocks, batch of 2 blocks: 4 segments on the disk
+using store_t = fs::log_store< faulty_disk, 8, 2, block_len >;
+
+std::vector< uint8_t > record(int n)
+{
+    // Lengths vary, so records span blocks
+    std::vector< uint8_t > r(1 + n * 7 % 50);
+    for (size_t i = 0; i < r.size(); ++i) {
+        r[i] = n + i;
+    }
+
+    return r;
+}
+
+std::vector< std::vector< uint8_t > > read_all(store_t &store)
+{
+    std::vector< std::vector< uint8_t > > out;
+    auto c = store.begin();
+    uint8_t buf[store_t::max_record];
+    ecl::result< size_t > rc = 0;
+
+    while ((rc = store.read(c, buf, sizeof(buf))) && *rc) {
+        out.emplace_back(buf, buf + *rc);
+    }
+
+    CHECK_TRUE(rc.ok());
+    return out;
+}
+
+} // namespace
+
+TEST_GROUP(log_store)
+{
+    faulty_disk *disk;
+    store_t *store;
+
+    void setup()
+    {
+        disk = new faulty_disk;
+        store = new store_t{*disk};
+        CHECK_EQUAL(0, store->format());
+        CHECK_EQUAL(0, store->mount());
+    }
+
+    void teardown()
+    {
+        delete store;
+        delete disk;
+    }
+
+    void remount()
+    {
+        delete store;
+        disk->budget = SIZE_MAX;
+        store = new store_t{*disk};
+        CHECK_EQUAL(0, store->mount());
+    }
+};
+
+TEST(log_store, unformatted)
+{
+    faulty_disk blank;
+    store_t other{blank};
+
+    CHECK_EQUAL(-1, other.mount());
+    CHECK_EQUAL(0, other.segment_count());
+    CHECK_EQUAL(4, store->segment_count());
+}
+
+TEST(log_store, invalid_records)
+{
+    uint8_t buf[store_t::max_record + 1] = {};
+
+    CHECK_EQUAL(-1, store->append(buf, 0));
+    CHECK_EQUAL(-1, store->append(buf, sizeof(buf)));
+    CHECK_EQUAL(0, store->append(buf, store_t::max_record));
+}
+
+TEST(log_store, append_and_read)
+{
+    for (int i = 0; i < 10; ++i) {
+        auto r = record(i);
+        CHECK_EQUAL(0, store->append(r.data(), r.size()));
+    }
+
+    CHECK_EQUAL(0, store->sync());
+
+    auto out = read_all(*store);
+    CHECK_EQUAL(10, out.size());
+    for (int i = 0; i < 10; ++i) {
+        CHECK_TRUE(record(i) == out[i]);
+    }
+
+    // Records survive remount and new ones are appended after them
+    remount();
+
+    auto r = record(10);
+    CHECK_EQUAL(0, store->append(r.data(), r.size()));
+    CHECK_EQUAL(0, store->unmount());
+    CHECK_EQUAL(0, store->mount());
+
+    CHECK_EQUAL(11, read_all(*store).size());
+}
+
+TEST(log_store, batched_writes)
+{
+    // 13 records of 16 bytes fill batch of 128 bytes once
+    uint8_t buf[12] = {};
+
+    for (int i = 0; i < 13; ++i) {
+        store->append(buf, sizeof(buf));
+    }
+
+    // Format wrote 4 headers
+    CHECK_EQUAL(4 + 1, disk->writes);
+
+    // Cursor continues, once records are written
+    auto c = store->begin();
+    int count = 0;
+    while (store->read(c, buf, sizeof(buf)).value_or(0) > 0) {
+        ++count;
+    }
+
+    CHECK_EQUAL(8, count);
+    store->sync();
+
+    while (store->read(c, buf, sizeof(buf)).value_or(0) > 0) {
+        ++count;
+    }
+
+    CHECK_EQUAL(13, count);
+}
+
+TEST(log_store, small_buffer)
+{
+    uint8_t buf[20] = {};
+    CHECK_EQUAL(0, store->append(buf, sizeof(buf)));
+    store->sync();
+
+    auto c = store->begin();
+    CHECK_TRUE(store->read(c, buf, 10).error() == ecl::err::msgsize);
+    CHECK_EQUAL(20, *store->read(c, buf, sizeof(buf)));
+}
+
+TEST(log_store, segments_are_reused)
+{
+    // Far more records than the disk holds
+    for (int i = 0; i < 300; ++i) {
+        auto r = record(i);
+        CHECK_EQUAL(0, store->append(r.data(), r.size()));
+    }
+
+    store->sync();
+
+    auto out = read_all(*store);
+    CHECK_TRUE(out.size() > 20);
+    CHECK_TRUE(out.size() < 300);
+
+    // Newest records are kept, in order
+    for (size_t i = 0; i < out.size(); ++i) {
+        CHECK_TRUE(record(300 - out.size() + i) == out[i]);
+    }
+
+    remount();
+    CHECK_EQUAL(out.size(), read_all(*store).size());
+}
+
+TEST(log_store, power_failure)
+{
+    for (int seed = 0; seed < 40; ++seed) {
+        teardown();
+        setup();
+
+        int synced = 0;
+        int i = 0;
+
+        // Power is lost in the middle of a batch or of a segment start
+        disk->budget = 3 + seed;
+
+        while (true) {
+            auto r = record(i);
+            if (store->append(r.data(), r.size()) < 0) {
+                break;
+            }
+
+            ++i;
+
+            if (i % 5 == 0) {
+                if (store->sync() < 0) {
+                    break;
+                }
+
+                synced = i;
+            }
+        }
+
+        remount();
+
+        // Recovered records are intact and continuous, synced ones
+        // are kept unless their segment was reused
+        auto out = read_all(*store);
+        CHECK_FALSE(out.empty());
+
+        int first = out[0][0];
+        for (size_t k = 0; k < out.size(); ++k) {
+            CHECK_TRUE(record(first + k) == out[k]);
+        }
+
+        CHECK_TRUE(first + static_cast< int >(out.size()) >= synced);
+        CHECK_TRUE(first + static_cast< int >(out.size()) <= i);
+
+        // Appending after recovery keeps the log readable
+        for (int k = 0; k < 20; ++k) {
+            auto r = record(1000 + k);
+            CHECK_EQUAL(0, store->append(r.data(), r.size()));
+        }
+
+        store->sync();
+        remount();
+
+        auto after = read_all(*store);
+        CHECK_TRUE(after.size() >= 20);
+        CHECK_TRUE(record(1019) == after.back());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
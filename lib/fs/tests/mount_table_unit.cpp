@@ -0,0 +1,66 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include "fs/mount_table.hpp"
+
+template< const char *mount_point >
+struct fs_mock
+{
+    static constexpr const char *mnt_point = mount_point;
+};
+
+static constexpr char root[]    = "/";
+static constexpr char sd[]      = "/sd";
+static constexpr char sd_data[] = "//sd/data/";
+static constexpr char flash[]   = "/Flash";
+
+using table_t = fs::mount_table< 4 >;
+
+static constexpr table_t table = fs::make_mount_table< fs_mock< root >, fs_mock< sd_data >,
+                                                       fs_mock< sd >, fs_mock< flash > >();
+
+// Deeper mount points go first, order of equal ones is kept
+static_assert(table.entries[0].index == 1, "");
+static_assert(table.entries[1].index == 2, "");
+static_assert(table.entries[2].index == 3, "");
+static_assert(table.entries[3].index == 0, "");
+static_assert(table.entries[0].segments == 2, "");
+
+static size_t resolve(const table_t &t, const char *path, const char *rest)
+{
+    const char *p = path;
+    size_t idx = t.resolve(p);
+
+    STRCMP_EQUAL(rest, p);
+
+    return idx;
+}
+
+TEST_GROUP(mount_table)
+{
+};
+
+TEST(mount_table, longest_prefix)
+{
+    CHECK_EQUAL(1, resolve(table, "/sd/data/log.txt", "log.txt"));
+    CHECK_EQUAL(1, resolve(table, "/sd//data", ""));
+    CHECK_EQUAL(2, resolve(table, "/sd/database", "database"));
+    CHECK_EQUAL(2, resolve(table, "/SD/file", "file"));
+    CHECK_EQUAL(3, resolve(table, "/flash/", ""));
+    CHECK_EQUAL(0, resolve(table, "/sdcard/file", "sdcard/file"));
+    CHECK_EQUAL(0, resolve(table, "file", "file"));
+}
+
+TEST(mount_table, no_match)
+{
+    static constexpr auto t = fs::make_mount_table< fs_mock< sd >, fs_mock< flash > >();
+
+    const char *path = "/usb/file";
+    CHECK_EQUAL(2, t.resolve(path));
+    STRCMP_EQUAL("/usb/file", path);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
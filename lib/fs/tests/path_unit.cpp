@@ -0,0 +1,90 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include "fs/path.hpp"
+
+#include <string>
+
+using fs::name_view;
+using fs::path_tokenizer;
+using fs::same_name;
+
+TEST_GROUP(path)
+{
+};
+
+TEST(path, same_name)
+{
+    CHECK(same_name(name_view{"BOOT.INI"}, "boot.ini"));
+    CHECK(same_name(name_view{"boot.ini/next", 8}, "Boot.Ini"));
+    CHECK(!same_name(name_view{"boot.ini/next", 8}, "boot.ini/"));
+    CHECK(!same_name(name_view{"boot", 4}, "boot.ini"));
+    CHECK(!same_name(name_view{"boot.ini"}, "boot"));
+    CHECK(!same_name(name_view{"abc"}, "abd"));
+    // Only ASCII letters are folded
+    CHECK(!same_name(name_view{"["}, "{"));
+    CHECK(same_name(name_view{"x", 0}, ""));
+}
+
+TEST(path, segments_refer_to_path)
+{
+    const char *path = "//dir/sub//file.txt";
+    path_tokenizer iter{path};
+    name_view seg{path, 0};
+    bool is_dir;
+
+    CHECK(iter.next(seg, is_dir));
+    POINTERS_EQUAL(path + 2, seg.ptr);
+    CHECK_EQUAL(3, seg.len);
+    CHECK(is_dir);
+
+    CHECK(iter.next(seg, is_dir));
+    CHECK_EQUAL("sub", std::string(seg.ptr, seg.len));
+    CHECK(is_dir);
+
+    CHECK(iter.next(seg, is_dir));
+    CHECK_EQUAL("file.txt", std::string(seg.ptr, seg.len));
+    CHECK(!is_dir);
+
+    CHECK(!iter.next(seg, is_dir));
+    CHECK(!iter.overflow());
+}
+
+TEST(path, trailing_separator_gives_dir)
+{
+    path_tokenizer iter{"dir/"};
+    name_view seg{"", 0};
+    bool is_dir;
+
+    CHECK(iter.next(seg, is_dir));
+    CHECK_EQUAL("dir", std::string(seg.ptr, seg.len));
+    CHECK(is_dir);
+    CHECK(!iter.next(seg, is_dir));
+
+    path_tokenizer empty{"/"};
+    CHECK(!empty.next(seg, is_dir));
+    CHECK(!empty.overflow());
+}
+
+TEST(path, too_long_segment)
+{
+    std::string path = "dir/" + std::string(fs::max_name + 1, 'a') + "/file";
+    path_tokenizer iter{path.c_str()};
+    name_view seg{"", 0};
+    bool is_dir;
+
+    CHECK(iter.next(seg, is_dir));
+    CHECK(!iter.next(seg, is_dir));
+    CHECK(iter.overflow());
+
+    // Longest allowed name
+    path = std::string(fs::max_name, 'b');
+    path_tokenizer max{path.c_str()};
+    CHECK(max.next(seg, is_dir));
+    CHECK_EQUAL(fs::max_name, seg.len);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,88 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include "fs/block.hpp"
+#include "fs/ram_block.hpp"
+#include "fs/mmap_block.hpp"
+
+#include <string.h>
+
+using disk_t = fs::ram_block< 4, 16 >;
+
+static_assert(fs::is_block_device< disk_t >::value, "");
+static_assert(fs::is_mapped_device< disk_t >::value, "");
+static_assert(fs::is_block_device< fs::mmap_block< 0x08000000, 4 > >::value, "");
+static_assert(fs::is_mapped_device< fs::mmap_block< 0x08000000, 4 > >::value, "");
+
+TEST_GROUP(ram_block)
+{
+    disk_t *disk;
+
+    void setup()
+    {
+        disk = new disk_t;
+        disk->init();
+    }
+
+    void teardown()
+    {
+        delete disk;
+    }
+};
+
+TEST(ram_block, not_opened)
+{
+    uint8_t buf[16];
+
+    CHECK_EQUAL(0, disk->block_count());
+    CHECK_EQUAL(-1, disk->read_blocks(0, buf, 1));
+    CHECK_EQUAL(-1, disk->write_blocks(0, buf, 1));
+    CHECK_EQUAL(-1, disk->close());
+}
+
+TEST(ram_block, geometry)
+{
+    CHECK_EQUAL(0, disk->open());
+    CHECK_EQUAL(4, disk->block_count());
+    CHECK_EQUAL(16, disk->get_block_length());
+}
+
+TEST(ram_block, read_write)
+{
+    uint8_t in[32];
+    uint8_t out[32] = {};
+
+    for (size_t i = 0; i < sizeof(in); ++i) {
+        in[i] = i;
+    }
+
+    disk->open();
+
+    CHECK_EQUAL(0, disk->write_blocks(2, in, 2));
+    CHECK_EQUAL(0, disk->read_blocks(2, out, 2));
+    MEMCMP_EQUAL(in, out, sizeof(in));
+
+    // Mapped content is the same
+    MEMCMP_EQUAL(in, disk->map_blocks(2, 2), sizeof(in));
+    MEMCMP_EQUAL(in + 16, disk->map_blocks(3, 1), 16);
+}
+
+TEST(ram_block, out_of_range)
+{
+    uint8_t buf[32];
+
+    disk->open();
+
+    CHECK_EQUAL(-1, disk->read_blocks(3, buf, 2));
+    CHECK_EQUAL(-1, disk->write_blocks(4, buf, 1));
+    CHECK_EQUAL(-1, disk->trim(1, 4));
+    CHECK_EQUAL(-1, disk->read_blocks(static_cast< size_t >(-1), buf, 2));
+    POINTERS_EQUAL(nullptr, disk->map_blocks(2, 3));
+
+    CHECK_EQUAL(0, disk->trim(0, 4));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,237 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include "fs/block.hpp"
+#include "fs/ram_block.hpp"
+#include "fs/striped_block.hpp"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <string.h>
+
+using disk_t = fs::ram_block< 16, 16 >;
+using small_disk_t = fs::ram_block< 10, 16 >;
+
+// Requests in progress on all async disks
+static std::atomic_int in_flight{0};
+static std::atomic_int max_in_flight{0};
+
+// RAM disk, which completes requests in background thread
+class async_disk : public disk_t
+{
+public:
+    using cb = std::function< void(int) >;
+
+    ~async_disk()
+    {
+        join();
+    }
+
+    int read_blocks_async(size_t lba, uint8_t *buf, size_t n, const cb &done)
+    {
+        return start([=] { return read_blocks(lba, buf, n); }, done);
+    }
+
+    int write_blocks_async(size_t lba, const uint8_t *buf, size_t n, const cb &done)
+    {
+        return start([=] { return write_blocks(lba, buf, n); }, done);
+    }
+
+    int fail_start = 0;
+
+private:
+    int start(std::function< int() > op, const cb &done)
+    {
+        if (fail_start) {
+            return fail_start;
+        }
+
+        join();
+        int now = ++in_flight;
+        int max = max_in_flight;
+        while (now > max && !max_in_flight.compare_exchange_weak(max, now)) { }
+
+        m_worker = std::thread([op, done] {
+            // Let the other disk start its part
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            int rc = op();
+            --in_flight;
+            done(rc);
+        });
+
+        return 0;
+    }
+
+    void join()
+    {
+        if (m_worker.joinable()) {
+            m_worker.join();
+        }
+    }
+
+    std::thread m_worker;
+};
+
+static_assert(fs::is_block_device< fs::striped_block< disk_t, disk_t > >::value, "");
+static_assert(!fs::is_callback_device< disk_t >::value, "");
+static_assert(fs::is_callback_device< async_disk >::value, "");
+
+static void pattern(uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        buf[i] = static_cast< uint8_t >(i * 7 + i / 16);
+    }
+}
+
+TEST_GROUP(striped_block)
+{
+    disk_t a;
+    disk_t b;
+    fs::striped_block< disk_t, disk_t, 2 > vol{a, b};
+
+    void setup()
+    {
+        CHECK_EQUAL(0, vol.init());
+    }
+};
+
+TEST(striped_block, not_opened)
+{
+    uint8_t buf[16];
+
+    CHECK_EQUAL(0, vol.block_count());
+    CHECK_EQUAL(-1, vol.read_blocks(0, buf, 1));
+    CHECK_EQUAL(-1, vol.write_blocks(0, buf, 1));
+    CHECK_EQUAL(-1, vol.close());
+}
+
+TEST(striped_block, geometry)
+{
+    CHECK_EQUAL(0, vol.open());
+    CHECK_EQUAL(16, vol.get_block_length());
+    CHECK_EQUAL(32, vol.block_count());
+    CHECK_EQUAL(2 * 2 * 16, vol.preferred_io_size());
+    CHECK_EQUAL(0, vol.close());
+    CHECK_EQUAL(0, a.block_count());
+    CHECK_EQUAL(0, b.block_count());
+}
+
+TEST(striped_block, smaller_device_limits_volume)
+{
+    small_disk_t c;
+    fs::striped_block< disk_t, small_disk_t, 4 > odd{a, c};
+
+    CHECK_EQUAL(0, odd.open());
+    // 10 blocks hold only two whole stripes of 4 blocks
+    CHECK_EQUAL(16, odd.block_count());
+
+    uint8_t buf[16];
+    CHECK_EQUAL(0, odd.read_blocks(15, buf, 1));
+    CHECK_EQUAL(-1, odd.read_blocks(16, buf, 1));
+    CHECK_EQUAL(0, odd.close());
+}
+
+TEST(striped_block, stripes_interleave)
+{
+    CHECK_EQUAL(0, vol.open());
+
+    uint8_t data[32 * 16];
+    pattern(data, sizeof(data));
+    CHECK_EQUAL(0, vol.write_blocks(0, data, 32));
+
+    // Stripe k lands on device k % 2, at offset (k / 2) * stripe
+    for (size_t lba = 0; lba < 32; ++lba) {
+        size_t stripe = lba / 2;
+        auto &dev = stripe % 2 ? b : a;
+        auto blk = dev.map_blocks((stripe / 2) * 2 + lba % 2, 1);
+        CHECK(blk);
+        MEMCMP_EQUAL(data + lba * 16, blk, 16);
+    }
+
+    CHECK_EQUAL(0, vol.close());
+}
+
+TEST(striped_block, unaligned_requests)
+{
+    CHECK_EQUAL(0, vol.open());
+
+    uint8_t data[32 * 16];
+    uint8_t out[32 * 16];
+    pattern(data, sizeof(data));
+
+    CHECK_EQUAL(0, vol.write_blocks(0, data, 32));
+
+    // Starts in the middle of a stripe, ends in the middle of another
+    memset(out, 0, sizeof(out));
+    CHECK_EQUAL(0, vol.read_blocks(3, out, 10));
+    MEMCMP_EQUAL(data + 3 * 16, out, 10 * 16);
+
+    memset(out, 0xaa, 5 * 16);
+    CHECK_EQUAL(0, vol.write_blocks(7, out, 5));
+    CHECK_EQUAL(0, vol.read_blocks(0, data, 32));
+    for (size_t i = 7 * 16; i < 12 * 16; ++i) {
+        CHECK_EQUAL(0xaa, data[i]);
+    }
+
+    CHECK_EQUAL(0, vol.trim(1, 30));
+    CHECK_EQUAL(-1, vol.trim(31, 2));
+    CHECK_EQUAL(-1, vol.read_blocks(30, out, 3));
+    CHECK_EQUAL(0, vol.close());
+}
+
+TEST_GROUP(striped_block_async)
+{
+    async_disk a;
+    async_disk b;
+    fs::striped_block< async_disk, async_disk, 2 > vol{a, b};
+
+    void setup()
+    {
+        in_flight = 0;
+        max_in_flight = 0;
+        CHECK_EQUAL(0, vol.init());
+        CHECK_EQUAL(0, vol.open());
+    }
+
+    void teardown()
+    {
+        vol.close();
+    }
+};
+
+TEST(striped_block_async, devices_work_simultaneously)
+{
+    uint8_t data[32 * 16];
+    uint8_t out[32 * 16];
+    pattern(data, sizeof(data));
+
+    CHECK_EQUAL(0, vol.write_blocks(1, data, 30));
+    CHECK_EQUAL(2, max_in_flight);
+
+    memset(out, 0, sizeof(out));
+    CHECK_EQUAL(0, vol.read_blocks(1, out, 30));
+    MEMCMP_EQUAL(data, out, 30 * 16);
+
+    // Last chunk has no pair
+    CHECK_EQUAL(0, vol.read_blocks(2, out, 2));
+    MEMCMP_EQUAL(data + 16, out, 2 * 16);
+    CHECK_EQUAL(0, in_flight);
+}
+
+TEST(striped_block_async, start_failure_waits_for_started_part)
+{
+    uint8_t buf[4 * 16];
+
+    b.fail_start = -3;
+    CHECK_EQUAL(-3, vol.read_blocks(0, buf, 4));
+    CHECK_EQUAL(0, in_flight);
+
+    b.fail_start = 0;
+    CHECK_EQUAL(0, vol.read_blocks(0, buf, 4));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
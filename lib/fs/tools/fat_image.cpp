@@ -0,0 +1,494 @@
+// Builds FAT images and extracts files from them on host, through the same
+// filesystems that run on target. Image is accessed as a block device,
+// see platform/host_block.hpp, so neither root nor loop devices are needed:
+//
+//   fat_image format [-c sectors] image.img size_mib
+//   fat_image put image.img host_dir [image_dir]
+//   fat_image get [-j threads] [-p] image.img image_dir host_dir
+//
+// format creates or resizes the image and puts an empty FAT32 volume over
+// whole of it, with given amount of sectors per cluster.
+//
+// put copies host_dir recursively into image_dir, creating missing dirs.
+// FAT has a single allocation table, so the copy is done by one writer.
+// Native engine creates only 8.3 names, other names are reported.
+//
+// get copies image_dir recursively into host_dir. The tree is listed
+// through vfs, then files are read by worker threads, each with its own
+// vfs over its own descriptor of the image. Native engine is used by
+// default, -p reads through petit, the way readers on target do.
+
+#include <platform/host_block.hpp>
+
+#include <fs/fs.hpp>
+#include <fat/fs.hpp>
+#include <fat/native/format.hpp>
+#include <fat/native/fs.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ftw.h>
+#include <sys/stat.h>
+
+namespace
+{
+
+using fat::native::volume;
+
+constexpr char mnt[] = "/i";
+
+using native_vfs = fs::vfs< fs::fs_descriptor< mnt, fat::native::filesystem< ecl::host_block > > >;
+using petit_vfs  = fs::vfs< fs::fs_descriptor< mnt, fat::petit< ecl::host_block > > >;
+
+constexpr size_t chunk_size = 64 * 1024;
+
+// File to be copied out of the image
+struct job
+{
+    std::string src;    // Path in vfs
+    std::string dst;    // Path on host
+};
+
+struct totals
+{
+    std::atomic< size_t >   files{0};
+    std::atomic< uint64_t > bytes{0};
+};
+
+void report(const char *what, const totals &t, std::chrono::steady_clock::time_point start)
+{
+    auto spent = std::chrono::duration< double >(std::chrono::steady_clock::now() - start);
+    double mib = t.bytes / (1024.0 * 1024.0);
+
+    printf("%s %zu files, %.1f MiB in %.2f s, %.1f MiB/s\n", what, t.files.load(), mib,
+           spent.count(), spent.count() > 0 ? mib / spent.count() : 0.0);
+}
+
+// Gets path of image dir, as seen by vfs: mount point, then the dir with
+// trailing slash
+std::string vfs_dir(const char *dir)
+{
+    while (*dir == '/') {
+        ++dir;
+    }
+
+    std::string p = std::string{mnt} + '/' + dir;
+    if (p.back() != '/') {
+        p += '/';
+    }
+
+    return p;
+}
+
+// Extraction -------------------------------------------------------------------
+
+// Lists files of a dir recursively, creating host dirs on the way
+template< class Vfs >
+bool list(Vfs &v, const std::string &dir, const std::string &host, std::vector< job > &jobs)
+{
+    if (mkdir(host.c_str(), 0755) && errno != EEXIST) {
+        fprintf(stderr, "Can't create %s: %s\n", host.c_str(), strerror(errno));
+        return false;
+    }
+
+    auto d = v.open_dir(dir.c_str());
+    if (!d) {
+        fprintf(stderr, "No dir %s in the image\n", dir.c_str() + strlen(mnt));
+        return false;
+    }
+
+    std::vector< fs::dir_entry > batch(16);
+    std::vector< std::string > subdirs;
+    ssize_t n;
+
+    while ((n = d->readdir(batch.data(), batch.size())) > 0) {
+        for (ssize_t i = 0; i < n; ++i) {
+            auto &e = batch[i];
+
+            if (!strcmp(e.name, ".") || !strcmp(e.name, "..")) {
+                continue;
+            }
+
+            if (e.type == fs::inode::type::dir) {
+                subdirs.push_back(e.name);
+            } else {
+                jobs.push_back({dir + e.name, host + '/' + e.name});
+            }
+        }
+    }
+
+    d->close();
+
+    if (n < 0) {
+        fprintf(stderr, "Can't list %s\n", dir.c_str() + strlen(mnt));
+        return false;
+    }
+
+    // Descriptor is closed before going deeper, so depth is not limited
+    // by the amount of descriptors
+    for (auto &s : subdirs) {
+        if (!list(v, dir + s + '/', host + '/' + s, jobs)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template< class Vfs >
+bool copy_out(Vfs &v, const job &j, std::vector< uint8_t > &buf, totals &t)
+{
+    auto f = v.open_file(j.src.c_str());
+    if (!f) {
+        fprintf(stderr, "Can't open %s\n", j.src.c_str() + strlen(mnt));
+        return false;
+    }
+
+    FILE *out = fopen(j.dst.c_str(), "wb");
+    if (!out) {
+        fprintf(stderr, "Can't create %s: %s\n", j.dst.c_str(), strerror(errno));
+        f->close();
+        return false;
+    }
+
+    ssize_t n;
+    bool ok = true;
+
+    while (ok && (n = f->read(buf.data(), buf.size())) > 0) {
+        ok = fwrite(buf.data(), 1, n, out) == static_cast< size_t >(n);
+        t.bytes += n;
+    }
+
+    if (!ok || n < 0) {
+        fprintf(stderr, "Can't copy %s\n", j.src.c_str() + strlen(mnt));
+        ok = false;
+    }
+
+    f->close();
+    ok = !fclose(out) && ok;
+    t.files += ok;
+
+    return ok;
+}
+
+template< class Vfs >
+int get(const char *dir, const char *host, unsigned threads)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector< job > jobs;
+
+    {
+        std::unique_ptr< Vfs > v{new Vfs};
+        v->mount_all();
+
+        if (!list(*v, vfs_dir(dir), host, jobs)) {
+            return 1;
+        }
+    }
+
+    std::atomic< size_t > next{0};
+    std::atomic< bool > failed{false};
+    totals t;
+
+    auto worker = [&] {
+        // Filesystems are not shared, so no locking is needed
+        std::unique_ptr< Vfs > v{new Vfs};
+        std::vector< uint8_t > buf(chunk_size);
+
+        v->mount_all();
+
+        for (size_t i; !failed && (i = next++) < jobs.size(); ) {
+            if (!copy_out(*v, jobs[i], buf, t)) {
+                failed = true;
+            }
+        }
+    };
+
+    std::vector< std::thread > pool;
+    for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto &th : pool) {
+        th.join();
+    }
+
+    if (failed) {
+        return 1;
+    }
+
+    report("Extracted", t, start);
+    return 0;
+}
+
+// Population -------------------------------------------------------------------
+
+// Native volume over the image
+struct image
+{
+    ecl::host_block dev;
+    volume          vol;
+
+    static int read(void *obj, uint32_t lba, uint8_t *buf, size_t n)
+    {
+        return static_cast< ecl::host_block* >(obj)->read_blocks(lba, buf, n);
+    }
+
+    static int write(void *obj, uint32_t lba, const uint8_t *buf, size_t n)
+    {
+        return static_cast< ecl::host_block* >(obj)->write_blocks(lba, buf, n);
+    }
+
+    volume::disk binding() { return { &dev, read, write, nullptr, nullptr, nullptr }; }
+};
+
+// Finds a dir within given one, creates it if it doesn't exist.
+// -1 if error, 0 otherwise.
+int enter_dir(volume &vol, uint32_t &dir, const char *name)
+{
+    fat::native::entry e;
+
+    int rc = vol.dir_find(dir, name, e);
+    if (rc < 0 || (rc > 0 && !(e.attr & volume::attr_dir))) {
+        fprintf(stderr, "Can't enter %s\n", name);
+        return -1;
+    }
+
+    if (!rc && vol.dir_create(dir, name, volume::attr_dir, e) < 0) {
+        fprintf(stderr, "Can't create dir %s, is it an 8.3 name?\n", name);
+        return -1;
+    }
+
+    dir = e.cluster;
+    return 0;
+}
+
+int copy_in_file(volume &vol, uint32_t dir, const std::string &host, const char *name,
+                 std::vector< uint8_t > &buf, totals &t)
+{
+    fat::native::entry e;
+    fat::native::cursor cur = {};
+
+    FILE *in = fopen(host.c_str(), "rb");
+    if (!in) {
+        fprintf(stderr, "Can't open %s: %s\n", host.c_str(), strerror(errno));
+        return -1;
+    }
+
+    if (vol.dir_create(dir, name, 0, e) < 0) {
+        fprintf(stderr, "Can't create %s, is it an 8.3 name and a new file?\n", host.c_str());
+        fclose(in);
+        return -1;
+    }
+
+    uint32_t offt = 0;
+    size_t n;
+    int rc = 0;
+
+    while (!rc && (n = fread(buf.data(), 1, buf.size(), in)) > 0) {
+        if (vol.write(e, cur, offt, buf.data(), n) != static_cast< ssize_t >(n)) {
+            fprintf(stderr, "Can't write %s, is the image full?\n", host.c_str());
+            rc = -1;
+        }
+
+        offt += n;
+        t.bytes += n;
+    }
+
+    if (ferror(in)) {
+        fprintf(stderr, "Can't read %s\n", host.c_str());
+        rc = -1;
+    }
+
+    fclose(in);
+
+    // Entry is updated even on error, so allocated clusters are not lost
+    if (vol.entry_update(e) < 0) {
+        rc = -1;
+    }
+
+    t.files += !rc;
+    return rc;
+}
+
+// State of the host tree walk, nftw() takes no context
+struct walk
+{
+    volume                  *vol;
+    std::vector< uint32_t > dirs;   // Image dirs, by depth of the host tree
+    std::vector< uint8_t >  buf;
+    totals                  t;
+} w;
+
+// Tree is walked by nftw(), since petit declares its own DIR type
+int copy_in(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    const char *name = path + ftw->base;
+
+    if (!ftw->level) {
+        return 0;
+    }
+
+    // Dirs of the previous branch are left
+    w.dirs.resize(ftw->level);
+
+    if (flag == FTW_D) {
+        uint32_t sub = w.dirs.back();
+        if (enter_dir(*w.vol, sub, name) < 0) {
+            return -1;
+        }
+
+        w.dirs.push_back(sub);
+    } else if (flag == FTW_F && S_ISREG(st->st_mode)) {
+        return copy_in_file(*w.vol, w.dirs.back(), path, name, w.buf, w.t);
+    } else if (flag == FTW_DNR || flag == FTW_NS) {
+        fprintf(stderr, "Can't access %s\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+int put(const char *path, const char *host, const char *dir)
+{
+    auto start = std::chrono::steady_clock::now();
+    struct stat st;
+
+    if (stat(host, &st) || !S_ISDIR(st.st_mode)) {
+        fprintf(stderr, "No dir %s\n", host);
+        return 1;
+    }
+    std::unique_ptr< image > img{new image};
+    auto binding = img->binding();
+
+    ecl::host_block::set_image(path, true);
+
+    if (img->dev.open() < 0 || img->vol.mount(binding, img->dev.block_count()) < 0) {
+        fprintf(stderr, "Can't mount %s\n", path);
+        return 1;
+    }
+
+    uint32_t cur = img->vol.root();
+    std::string rest = dir;
+    size_t pos = 0;
+
+    // Target dir is created level by level
+    while (pos < rest.size()) {
+        auto end = rest.find('/', pos);
+        if (end == std::string::npos) {
+            end = rest.size();
+        }
+
+        if (end > pos && enter_dir(img->vol, cur, rest.substr(pos, end - pos).c_str()) < 0) {
+            return 1;
+        }
+
+        pos = end + 1;
+    }
+
+    w.vol = &img->vol;
+    w.dirs.assign(1, cur);
+    w.buf.resize(chunk_size);
+
+    int rc = nftw(host, copy_in, 16, FTW_PHYS);
+
+    if (img->vol.sync() < 0) {
+        fprintf(stderr, "Can't sync %s\n", path);
+        rc = -1;
+    }
+
+    img->dev.close();
+
+    if (rc) {
+        return 1;
+    }
+
+    report("Written", w.t, start);
+    return 0;
+}
+
+int format(const char *path, unsigned long size_mib, unsigned long cluster_sectors)
+{
+    FILE *f = fopen(path, "ab");
+    if (!f || fclose(f) || truncate(path, static_cast< off_t >(size_mib) << 20)) {
+        fprintf(stderr, "Can't create %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    std::unique_ptr< image > img{new image};
+    auto binding = img->binding();
+
+    ecl::host_block::set_image(path, true);
+
+    if (cluster_sectors > 128 || img->dev.open() < 0
+            || fat::native::format(binding, img->dev.block_count(), cluster_sectors) < 0) {
+        fprintf(stderr, "Can't format %s: FAT32 needs at least 65525 clusters\n", path);
+        return 1;
+    }
+
+    img->dev.close();
+    return 0;
+}
+
+int usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s format [-c sectors] image.img size_mib\n"
+            "       %s put image.img host_dir [image_dir]\n"
+            "       %s get [-j threads] [-p] image.img image_dir host_dir\n",
+            name, name, name);
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        return usage(argv[0]);
+    }
+
+    const char *cmd = argv[1];
+    unsigned long cluster_sectors = 1;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bool petit = false;
+    int arg = 2;
+
+    for (; arg + 1 < argc && argv[arg][0] == '-'; ++arg) {
+        if (!strcmp(argv[arg], "-c")) {
+            cluster_sectors = strtoul(argv[++arg], nullptr, 0);
+        } else if (!strcmp(argv[arg], "-j")) {
+            threads = std::max(1ul, strtoul(argv[++arg], nullptr, 0));
+        } else if (!strcmp(argv[arg], "-p")) {
+            petit = true;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    int left = argc - arg;
+    char **args = argv + arg;
+
+    if (!strcmp(cmd, "format") && left == 2) {
+        return format(args[0], strtoul(args[1], nullptr, 0), cluster_sectors);
+    } else if (!strcmp(cmd, "put") && (left == 2 || left == 3)) {
+        return put(args[0], args[1], left == 3 ? args[2] : "");
+    } else if (!strcmp(cmd, "get") && left == 3) {
+        ecl::host_block::set_image(args[0], false);
+        return petit ? get< petit_vfs >(args[1], args[2], threads)
+                     : get< native_vfs >(args[1], args[2], threads);
+    }
+
+    return usage(argv[0]);
+}
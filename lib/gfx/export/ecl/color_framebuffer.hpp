@@ -0,0 +1,334 @@
+#ifndef LIB_GFX_COLOR_FRAMEBUFFER_HPP_
+#define LIB_GFX_COLOR_FRAMEBUFFER_HPP_
+
+//!
+//! \file
+//! \brief Framebuffer for true color displays.
+//! Pixels are stored row by row, as in fb_layout::horizontal_rows.
+//! Area operations are delegated to a pixel engine, so they are offloaded
+//! from CPU where hardware allows it. Colors are given in ARGB8888
+//! and converted to the framebuffer format.
+//!
+
+#include <ecl/framebuffer.hpp>
+#include <ecl/pixel_engine.hpp>
+#include <ecl/err.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Color framebuffer.
+//! Anything outside the framebuffer is clipped. Framebuffer is not
+//! thread-safe. Dirty region is tracked in bytes, as by ecl::framebuffer.
+//! \tparam W       Width in pixels.
+//! \tparam H       Height in pixels.
+//! \tparam Fmt     Pixel format.
+//! \tparam Engine  Pixel engine, i.e. soft_pixel_engine or ecl::dma2d.
+//!
+template< int W, int H, pixel_format Fmt = pixel_format::rgb565,
+          class Engine = soft_pixel_engine >
+class color_framebuffer
+{
+public:
+    static constexpr int width      = W;                    //!< Width in pixels.
+    static constexpr int height     = H;                    //!< Height in pixels.
+    static constexpr pixel_format format = Fmt;             //!< Pixel format.
+    static constexpr int pixel_bytes = pixel_size(Fmt);     //!< Pixel size.
+    static constexpr int majors     = H;                    //!< Major index range.
+    static constexpr int minors     = W * pixel_bytes;      //!< Minor index range.
+    static constexpr size_t size    = majors * minors;      //!< Memory size.
+
+    //!
+    //! \brief Constructs framebuffer, cleared to black. Whole memory is dirty.
+    //!
+    color_framebuffer();
+
+    //!
+    //! \brief Sets a pixel.
+    //! \retval err::ok     Pixel is set.
+    //! \retval err::inval  Point is outside the framebuffer.
+    //!
+    err set_point(const point& coord, uint32_t argb);
+
+    //!
+    //! \brief Gets a pixel, converted to ARGB8888.
+    //! \retval err::ok     Pixel is read.
+    //! \retval err::inval  Point is outside the framebuffer.
+    //!
+    err get_point(const point& coord, uint32_t &argb) const;
+
+    //!
+    //! \brief Fills a rectangle, given its top left corner.
+    //! \retval err::ok     Rectangle is filled, possibly clipped.
+    //! \retval err::inval  Negative size is given.
+    //!
+    err fill_rect(const point& corner, int w, int h, uint32_t argb);
+
+    //!
+    //! \brief Draws a horizontal span, left to right.
+    //! \sa fill_rect()
+    //!
+    err draw_hline(const point& start, int len, uint32_t argb);
+
+    //!
+    //! \brief Draws a vertical span, top to bottom.
+    //! \sa fill_rect()
+    //!
+    err draw_vline(const point& start, int len, uint32_t argb);
+
+    //!
+    //! \brief Copies an image, given its top left corner.
+    //! Image is converted if its format differs.
+    //! \param[in] corner   Position of the image.
+    //! \param[in] src      Image, must not overlap the framebuffer.
+    //! \param[in] w        Width of the image.
+    //! \param[in] h        Height of the image.
+    //! \retval err::ok     Image is copied, possibly clipped.
+    //! \retval err::inval  Image is null or negative size is given.
+    //!
+    err blit(const point& corner, const pixmap &src, int w, int h);
+
+    //!
+    //! \brief Composes an image over the framebuffer, by alpha of the image.
+    //! Pixels of the framebuffer keep their alpha, if format has one.
+    //! \sa blit()
+    //!
+    err blend(const point& corner, const pixmap &src, int w, int h);
+
+    //!
+    //! \brief Fills whole framebuffer with a color.
+    //! \return Always err::ok.
+    //!
+    err clear(uint32_t argb = 0xff000000);
+
+    //!
+    //! \brief Gets framebuffer memory at given position.
+    //!
+    const uint8_t *data(int major = 0, int minor = 0) const
+    { return &m_data[major * minors + minor]; }
+
+    //!
+    //! \brief Gets a region modified since the last mark_clean() call.
+    //!
+    const fb_region &dirty() const { return m_dirty; }
+
+    //!
+    //! \brief Marks whole memory as modified.
+    //!
+    void mark_all_dirty() { m_dirty = fb_region{0, majors - 1, 0, minors - 1}; }
+
+    //!
+    //! \brief Marks whole memory as unmodified, i.e. after it was sent.
+    //!
+    void mark_clean() { m_dirty = fb_region{majors, 0, minors, 0}; }
+
+private:
+    //! Gets writable area, starting from given pixel.
+    surface area(int x, int y);
+
+    //! Clips a rectangle. \retval false Nothing is left.
+    static bool clip(int &x0, int &y0, int &x1, int &y1);
+
+    //! Extends dirty region, so it covers given pixels. Bounds are exclusive.
+    void mark_dirty(int x0, int y0, int x1, int y1);
+
+    alignas(4) uint8_t  m_data[size];   //!< Pixels.
+    fb_region           m_dirty;        //!< Modified region.
+};
+
+//------------------------------------------------------------------------------
+
+template< int W, int H, pixel_format Fmt, class Engine >
+color_framebuffer< W, H, Fmt, Engine >::color_framebuffer()
+    :m_data{}
+    ,m_dirty{}
+{
+    clear();
+}
+
+template< int W, int H, pixel_format Fmt, class Engine >
+err color_framebuffer< W, H, Fmt, Engine >::set_point(const point& coord, uint32_t argb)
+{
+    int x = coord.get_x();
+    int y = coord.get_y();
+
+    if (x < 0 || y < 0 || x >= W || y >= H) {
+        return err::inval;
+    }
+
+    // Single pixel isn't worth engine setup
+    soft_pixel_engine::fill(area(x, y), 1, 1, argb);
+    mark_dirty(x, y, x + 1, y + 1);
+
+    return err::ok;
+}
+
+template< int W, int H, pixel_format Fmt, class Engine >
+err color_framebuffer< W, H, Fmt, Engine >::get_point(const point& coord,
+                                                      uint32_t &argb) const
+{
+    int x = coord.get_x();
+    int y = coord.get_y();
+
+    if (x < 0 || y < 0 || x >= W || y >= H) {
+        return err::inval;
+    }
+
+    auto p = data(y, x * pixel_bytes);
+    uint32_t px = 0;
+
+    for (int i = pixel_bytes - 1; i >= 0; --i) {
+        px = px << 8 | p[i];
+    }
+
+    argb = to_argb(Fmt, px);
+    return err::ok;
+}
+
+template< int W, int H, pixel_format Fmt, class Engine >
+err color_framebuffer< W, H, Fmt, Engine >::fill_rect(const point& corner, int w, int h,
+                                                      uint32_t argb)
+{
+    if (w < 0 || h < 0) {
+        return err::inval;
+    }
+
+    int x0 = corner.get_x();
+    int y0 = corner.get_y();
+    int x1 = x0 + w;
+    int y1 = y0 + h;
+
+    if (clip(x0, y0, x1, y1)) {
+        Engine::fill(area(x0, y0), x1 - x0, y1 - y0, argb);
+        mark_dirty(x0, y0, x1, y1);
+    }
+
+    return err::ok;
+}
+
+template< int W, int H, pixel_format Fmt, class Engine >
+err color_framebuffer< W, H, Fmt, Engine >::draw_hline(const point& start, int len,
+                                                       uint32_t argb)
+{
+    return fill_rect(start, len, 1, argb);
+}
+
+template< int W, int H, pixel_format Fmt, class Engine >
+err color_framebuffer< W, H, Fmt, Engine >::draw_vline(const point& start, int len,
+                                                       uint32_t argb)
+{
+    return fill_rect(start, 1, len, argb);
+}
+
+template< int W, int H, pixel_format Fmt, class Engine >
+err color_framebuffer< W, H, Fmt, Engine >::blit(const point& corner, const pixmap &src,
+                                                 int w, int h)
+{
+    if (!src.data || w < 0 || h < 0) {
+        return err::inval;
+    }
+
+    int x0 = corner.get_x();
+    int y0 = corner.get_y();
+    int x1 = x0 + w;
+    int y1 = y0 + h;
+
+    // Source is advanced by the amount of clipped pixels
+    int skip_x = x0 < 0 ? -x0 : 0;
+    int skip_y = y0 < 0 ? -y0 : 0;
+
+    if (clip(x0, y0, x1, y1)) {
+        auto from = static_cast< const uint8_t * >(src.data)
+            + (skip_y * src.stride + skip_x) * pixel_size(src.format);
+
+        Engine::copy(pixmap{from, src.format, src.stride}, area(x0, y0),
+                     x1 - x0, y1 - y0);
+        mark_dirty(x0, y0, x1, y1);
+    }
+
+    return err::ok;
+}
+
+template< int W, int H, pixel_format Fmt, class Engine >
+err color_framebuffer< W, H, Fmt, Engine >::blend(const point& corner, const pixmap &src,
+                                                  int w, int h)
+{
+    if (!src.data || w < 0 || h < 0) {
+        return err::inval;
+    }
+
+    int x0 = corner.get_x();
+    int y0 = corner.get_y();
+    int x1 = x0 + w;
+    int y1 = y0 + h;
+
+    int skip_x = x0 < 0 ? -x0 : 0;
+    int skip_y = y0 < 0 ? -y0 : 0;
+
+    if (clip(x0, y0, x1, y1)) {
+        auto from = static_cast< const uint8_t * >(src.data)
+            + (skip_y * src.stride + skip_x) * pixel_size(src.format);
+        auto dst = area(x0, y0);
+
+        // Framebuffer itself is the background
+        Engine::blend(pixmap{from, src.format, src.stride},
+                      pixmap{dst.data, dst.format, dst.stride}, dst,
+                      x1 - x0, y1 - y0);
+        mark_dirty(x0, y0, x1, y1);
+    }
+
+    return err::ok;
+}
+
+template< int W, int H, pixel_format Fmt, class Engine >
+err color_framebuffer< W, H, Fmt, Engine >::clear(uint32_t argb)
+{
+    Engine::fill(area(0, 0), W, H, argb);
+    mark_all_dirty();
+
+    return err::ok;
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< int W, int H, pixel_format Fmt, class Engine >
+surface color_framebuffer< W, H, Fmt, Engine >::area(int x, int y)
+{
+    return surface{&m_data[y * minors + x * pixel_bytes], Fmt, W};
+}
+
+template< int W, int H, pixel_format Fmt, class Engine >
+bool color_framebuffer< W, H, Fmt, Engine >::clip(int &x0, int &y0, int &x1, int &y1)
+{
+    x0 = x0 < 0 ? 0 : x0;
+    y0 = y0 < 0 ? 0 : y0;
+    x1 = x1 > W ? W : x1;
+    y1 = y1 > H ? H : y1;
+
+    return x0 < x1 && y0 < y1;
+}
+
+template< int W, int H, pixel_format Fmt, class Engine >
+void color_framebuffer< W, H, Fmt, Engine >::mark_dirty(int x0, int y0, int x1, int y1)
+{
+    int minor0 = x0 * pixel_bytes;
+    int minor1 = x1 * pixel_bytes - 1;
+
+    if (y0 < m_dirty.major0)
+        m_dirty.major0 = y0;
+    if (y1 - 1 > m_dirty.major1)
+        m_dirty.major1 = y1 - 1;
+    if (minor0 < m_dirty.minor0)
+        m_dirty.minor0 = minor0;
+    if (minor1 > m_dirty.minor1)
+        m_dirty.minor1 = minor1;
+}
+
+} // namespace ecl
+
+#endif // LIB_GFX_COLOR_FRAMEBUFFER_HPP_
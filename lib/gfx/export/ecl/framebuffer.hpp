@@ -0,0 +1,643 @@
+#ifndef LIB_GFX_FRAMEBUFFER_HPP_
+#define LIB_GFX_FRAMEBUFFER_HPP_
+
+//!
+//! \file
+//! \brief Generic framebuffer for monochrome and low color displays.
+//! Framebuffer owns pixel storage, drawing primitives and dirty region
+//! tracking. Display drivers only have to send dirty region to a device.
+//! Memory layout is selected at compile time, so it matches display RAM
+//! and whole framebuffer regions can be transferred as is.
+//!
+
+#include <ecl/err.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace ecl
+{
+
+//!
+//! \brief Point on a display.
+//!
+class point
+{
+public:
+    point() :point{0, 0} { }
+    point(int x, int y) :m_coords(x, y) { }
+
+    int get_x() const { return m_coords.first; }
+    int get_y() const { return m_coords.second; }
+
+    void set_x(int x) { m_coords.first = x; }
+    void set_y(int y) { m_coords.second = y; }
+
+private:
+    std::pair< int, int > m_coords;
+};
+
+//!
+//! \brief Monospace bitmap font.
+//! Each glyph is 1-bpp page bitmap of width x height pixels, as accepted by
+//! framebuffer::blit(). Glyphs are stored one after another, starting from
+//! the first character.
+//!
+struct font
+{
+    uint8_t         width;      //!< Glyph width, including spacing.
+    uint8_t         height;     //!< Glyph height.
+    char            first;      //!< First character in the font.
+    char            last;       //!< Last character in the font, inclusive.
+    const uint8_t   *glyphs;    //!< Glyph bitmaps.
+};
+
+//!
+//! \brief Memory layouts of a framebuffer.
+//! Framebuffer memory is a two-dimensional array of bytes, indexed by major
+//! and minor index. Bytes with adjacent minor indexes are adjacent in memory.
+//!
+namespace fb_layout
+{
+
+//! Each byte holds 8 vertical pixels, LSB on top. Bytes are stored column
+//! by column: major index is X, minor index is a page. Used by controllers
+//! in vertical addressing mode, i.e. PCD8544.
+struct column_pages { };
+
+//! Each byte holds 8 vertical pixels, LSB on top. Bytes are stored page
+//! by page: major index is a page, minor index is X. Used by controllers
+//! in horizontal addressing mode, i.e. SSD1306 or ST7565.
+struct row_pages { };
+
+//! Each byte holds 8 / Bpp horizontal pixels, MSB on the left. Bytes are
+//! stored row by row: major index is Y, minor index is a byte within a row.
+//! Used by memory LCDs and most of color controllers.
+struct horizontal_rows { };
+
+} // namespace fb_layout
+
+//!
+//! \brief Region of framebuffer memory, in bytes.
+//! Bounds are inclusive. Region is empty if major0 > major1.
+//!
+struct fb_region
+{
+    int major0;     //!< First major index.
+    int major1;     //!< Last major index.
+    int minor0;     //!< First minor index.
+    int minor1;     //!< Last minor index.
+
+    //! Checks if region is empty.
+    bool empty() const { return major0 > major1; }
+};
+
+//! \cond INTERNAL
+namespace fb_detail
+{
+
+template< class Layout, int W, int H, int Bpp >
+struct geometry;
+
+template< int W, int H, int Bpp >
+struct geometry< fb_layout::column_pages, W, H, Bpp >
+{
+    static_assert(Bpp == 1, "Paged layouts are monochrome");
+
+    using paged = std::true_type;
+    static constexpr int majors = W;
+    static constexpr int minors = (H + 7) / 8;
+
+    static constexpr int major(int x, int)    { return x; }
+    static constexpr int minor(int, int page) { return page; }
+};
+
+template< int W, int H, int Bpp >
+struct geometry< fb_layout::row_pages, W, H, Bpp >
+{
+    static_assert(Bpp == 1, "Paged layouts are monochrome");
+
+    using paged = std::true_type;
+    static constexpr int majors = (H + 7) / 8;
+    static constexpr int minors = W;
+
+    static constexpr int major(int, int page) { return page; }
+    static constexpr int minor(int x, int)    { return x; }
+};
+
+template< int W, int H, int Bpp >
+struct geometry< fb_layout::horizontal_rows, W, H, Bpp >
+{
+    static_assert(Bpp == 1 || Bpp == 2 || Bpp == 4 || Bpp == 8,
+                  "Pixels must not cross byte boundaries");
+
+    using paged = std::false_type;
+    static constexpr int majors = H;
+    static constexpr int minors = (W * Bpp + 7) / 8;
+
+    static constexpr int major(int, int y)      { return y; }
+    static constexpr int minor(int x_byte, int) { return x_byte; }
+};
+
+} // namespace fb_detail
+//! \endcond
+
+//!
+//! \brief Framebuffer.
+//! Drawing operations process whole bytes where possible. Anything
+//! outside the framebuffer is clipped. Framebuffer is not thread-safe.
+//! \tparam W       Width in pixels.
+//! \tparam H       Height in pixels.
+//! \tparam Bpp     Bits per pixel. Paged layouts support only 1 bpp.
+//! \tparam Layout  Memory layout, one of fb_layout types.
+//!
+template< int W, int H, int Bpp = 1, class Layout = fb_layout::column_pages >
+class framebuffer
+{
+    using geom = fb_detail::geometry< Layout, W, H, Bpp >;
+
+public:
+    static constexpr int width      = W;        //!< Width in pixels.
+    static constexpr int height     = H;        //!< Height in pixels.
+    static constexpr int bpp        = Bpp;      //!< Bits per pixel.
+    static constexpr int majors     = geom::majors; //!< Major index range.
+    static constexpr int minors     = geom::minors; //!< Minor index range.
+    static constexpr size_t size    = majors * minors; //!< Memory size.
+    static constexpr uint8_t max_color = (1 << Bpp) - 1; //!< White, or whatever.
+
+    //!
+    //! \brief Constructs cleared framebuffer. Whole memory is dirty.
+    //!
+    framebuffer();
+
+    //!
+    //! \brief Sets a pixel.
+    //! \retval err::ok     Pixel is set.
+    //! \retval err::inval  Point is outside the framebuffer.
+    //!
+    err set_point(const point& coord, uint8_t color = max_color);
+
+    //!
+    //! \brief Clears a pixel.
+    //! \retval err::ok     Pixel is cleared.
+    //! \retval err::inval  Point is outside the framebuffer.
+    //!
+    err clear_point(const point& coord);
+
+    //!
+    //! \brief Gets a pixel.
+    //! \return Color of the pixel or -1 if point is outside the framebuffer.
+    //!
+    int get_point(const point& coord) const;
+
+    //!
+    //! \brief Fills a rectangle, given its top left corner.
+    //! \retval err::ok     Rectangle is filled, possibly clipped.
+    //! \retval err::inval  Negative size is given.
+    //!
+    err fill_rect(const point& corner, int w, int h, uint8_t color = max_color);
+
+    //!
+    //! \brief Draws a horizontal span, left to right.
+    //! \sa fill_rect()
+    //!
+    err draw_hline(const point& start, int len, uint8_t color = max_color);
+
+    //!
+    //! \brief Draws a vertical span, top to bottom.
+    //! \sa fill_rect()
+    //!
+    err draw_vline(const point& start, int len, uint8_t color = max_color);
+
+    //!
+    //! \brief Copies 1-bpp bitmap, given its top left corner.
+    //! Bitmap is a sequence of 8-pixel high pages, top to bottom. Each page
+    //! is w bytes long, byte holds a column of 8 pixels, LSB on the top.
+    //! Set pixels of the bitmap are drawn with given color, cleared pixels
+    //! are cleared.
+    //! \retval err::ok     Bitmap is copied, possibly clipped.
+    //! \retval err::inval  Bitmap is null or negative size is given.
+    //!
+    err blit(const point& corner, const uint8_t *bitmap, int w, int h,
+             uint8_t color = max_color);
+
+    //!
+    //! \brief Draws a character, given its top left corner.
+    //! \retval err::ok     Character is drawn.
+    //! \retval err::inval  Font has no such character.
+    //!
+    err draw_glyph(const point& corner, const font& f, char c,
+                   uint8_t color = max_color);
+
+    //!
+    //! \brief Draws a string. Characters missing in the font are skipped.
+    //! \retval err::ok     String is drawn.
+    //! \retval err::inval  String is null.
+    //!
+    err draw_text(const point& corner, const font& f, const char *str,
+                  uint8_t color = max_color);
+
+    //!
+    //! \brief Clears whole framebuffer.
+    //! \return Always err::ok.
+    //!
+    err clear();
+
+    //!
+    //! \brief Gets framebuffer memory at given position.
+    //! Bytes are stored in layout-specific order, as described in fb_layout.
+    //!
+    const uint8_t *data(int major = 0, int minor = 0) const
+    { return &m_data[major * minors + minor]; }
+
+    //!
+    //! \brief Gets a region modified since the last mark_clean() call.
+    //!
+    const fb_region &dirty() const { return m_dirty; }
+
+    //!
+    //! \brief Marks whole memory as modified.
+    //!
+    void mark_all_dirty() { m_dirty = fb_region{0, majors - 1, 0, minors - 1}; }
+
+    //!
+    //! \brief Marks whole memory as unmodified, i.e. after it was sent.
+    //!
+    void mark_clean() { m_dirty = fb_region{majors, 0, minors, 0}; }
+
+private:
+    using paged = typename geom::paged;
+
+    //! Color, replicated over whole byte.
+    static uint8_t color_byte(uint8_t color);
+
+    //! Finds a byte and bit offset of a pixel. Point must be valid.
+    static void locate(int x, int y, int &major, int &minor, int &shift);
+
+    //! Writes bits, selected by the mask, to given byte.
+    void write_byte(int major, int minor, uint8_t bits, uint8_t mask);
+
+    //! Writes a pixel, point must be valid.
+    void write_pixel(int x, int y, uint8_t color);
+
+    //! Extends dirty region, so it covers given byte.
+    void mark_dirty(int major, int minor);
+
+    //! Writes a column of 8 pixels in paged layouts, starting from given
+    //! point. Only pixels set in the mask are written.
+    void write_column(int x, int y, uint8_t bits, uint8_t mask);
+
+    //! Fills clipped rectangle.
+    void fill(int x0, int y0, int x1, int y1, uint8_t color, std::true_type);
+    void fill(int x0, int y0, int x1, int y1, uint8_t color, std::false_type);
+
+    //! Copies a page of the bitmap, within clipped columns.
+    void blit_page(int x, int y, const uint8_t *src, int from, int to,
+                   uint8_t mask, uint8_t color, std::true_type);
+    void blit_page(int x, int y, const uint8_t *src, int from, int to,
+                   uint8_t mask, uint8_t color, std::false_type);
+
+    uint8_t     m_data[size];   //!< Pixels.
+    fb_region   m_dirty;        //!< Modified region.
+};
+
+//------------------------------------------------------------------------------
+
+template< int W, int H, int Bpp, class Layout >
+framebuffer< W, H, Bpp, Layout >::framebuffer()
+    :m_data{}
+    ,m_dirty{}
+{
+    mark_all_dirty();
+}
+
+template< int W, int H, int Bpp, class Layout >
+err framebuffer< W, H, Bpp, Layout >::set_point(const point& coord, uint8_t color)
+{
+    int x = coord.get_x();
+    int y = coord.get_y();
+
+    if (x < 0 || y < 0 || x >= W || y >= H) {
+        return err::inval;
+    }
+
+    write_pixel(x, y, color);
+    return err::ok;
+}
+
+template< int W, int H, int Bpp, class Layout >
+err framebuffer< W, H, Bpp, Layout >::clear_point(const point& coord)
+{
+    return set_point(coord, 0);
+}
+
+template< int W, int H, int Bpp, class Layout >
+int framebuffer< W, H, Bpp, Layout >::get_point(const point& coord) const
+{
+    int x = coord.get_x();
+    int y = coord.get_y();
+
+    if (x < 0 || y < 0 || x >= W || y >= H) {
+        return -1;
+    }
+
+    int major, minor, shift;
+    locate(x, y, major, minor, shift);
+
+    return (*data(major, minor) >> shift) & max_color;
+}
+
+template< int W, int H, int Bpp, class Layout >
+err framebuffer< W, H, Bpp, Layout >::fill_rect(const point& corner, int w, int h,
+                                                uint8_t color)
+{
+    if (w < 0 || h < 0) {
+        return err::inval;
+    }
+
+    int x = corner.get_x();
+    int y = corner.get_y();
+
+    // Clip, so nothing outside is walked through
+    int x0 = x < 0 ? 0 : x;
+    int y0 = y < 0 ? 0 : y;
+    int x1 = x + w > W ? W : x + w;
+    int y1 = y + h > H ? H : y + h;
+
+    if (x0 < x1 && y0 < y1) {
+        fill(x0, y0, x1, y1, color, paged{});
+    }
+
+    return err::ok;
+}
+
+template< int W, int H, int Bpp, class Layout >
+err framebuffer< W, H, Bpp, Layout >::draw_hline(const point& start, int len,
+                                                 uint8_t color)
+{
+    return fill_rect(start, len, 1, color);
+}
+
+template< int W, int H, int Bpp, class Layout >
+err framebuffer< W, H, Bpp, Layout >::draw_vline(const point& start, int len,
+                                                 uint8_t color)
+{
+    return fill_rect(start, 1, len, color);
+}
+
+template< int W, int H, int Bpp, class Layout >
+err framebuffer< W, H, Bpp, Layout >::blit(const point& corner, const uint8_t *bitmap,
+                                           int w, int h, uint8_t color)
+{
+    if (!bitmap || w < 0 || h < 0) {
+        return err::inval;
+    }
+
+    int x = corner.get_x();
+    int y = corner.get_y();
+
+    // Visible columns of the bitmap
+    int from = x < 0 ? -x : 0;
+    int to = x + w > W ? W - x : w;
+
+    for (int page = 0; page * 8 < h && from < to; ++page) {
+        int page_y = y + page * 8;
+        int left = h - page * 8;
+        uint8_t mask = left >= 8 ? 0xff : (1 << left) - 1;
+
+        if (page_y >= H) {
+            break;
+        }
+
+        if (page_y + 8 > 0) {
+            blit_page(x, page_y, bitmap + page * w, from, to, mask, color, paged{});
+        }
+    }
+
+    return err::ok;
+}
+
+template< int W, int H, int Bpp, class Layout >
+err framebuffer< W, H, Bpp, Layout >::draw_glyph(const point& corner, const font& f,
+                                                 char c, uint8_t color)
+{
+    if (c < f.first || c > f.last) {
+        return err::inval;
+    }
+
+    size_t glyph_size = f.width * ((f.height + 7) / 8);
+    auto glyph = f.glyphs + (c - f.first) * glyph_size;
+
+    return blit(corner, glyph, f.width, f.height, color);
+}
+
+template< int W, int H, int Bpp, class Layout >
+err framebuffer< W, H, Bpp, Layout >::draw_text(const point& corner, const font& f,
+                                                const char *str, uint8_t color)
+{
+    if (!str) {
+        return err::inval;
+    }
+
+    point pos = corner;
+
+    for (; *str && pos.get_x() < W; ++str) {
+        draw_glyph(pos, f, *str, color);
+        pos.set_x(pos.get_x() + f.width);
+    }
+
+    return err::ok;
+}
+
+template< int W, int H, int Bpp, class Layout >
+err framebuffer< W, H, Bpp, Layout >::clear()
+{
+    memset(m_data, 0, sizeof(m_data));
+    mark_all_dirty();
+
+    return err::ok;
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< int W, int H, int Bpp, class Layout >
+uint8_t framebuffer< W, H, Bpp, Layout >::color_byte(uint8_t color)
+{
+    // 0xff, 0x55, 0x11 or 0x01 times the color
+    return (color & max_color) * (0xff / max_color);
+}
+
+template< int W, int H, int Bpp, class Layout >
+void framebuffer< W, H, Bpp, Layout >::locate(int x, int y, int &major, int &minor,
+                                              int &shift)
+{
+    if (paged::value) {
+        major = geom::major(x, y >> 3);
+        minor = geom::minor(x, y >> 3);
+        shift = y & 0x7;
+    } else {
+        constexpr int per_byte = 8 / Bpp;
+
+        major = geom::major(x / per_byte, y);
+        minor = geom::minor(x / per_byte, y);
+        // Leftmost pixel occupies most significant bits
+        shift = 8 - Bpp * (x % per_byte + 1);
+    }
+}
+
+template< int W, int H, int Bpp, class Layout >
+void framebuffer< W, H, Bpp, Layout >::write_byte(int major, int minor,
+                                                  uint8_t bits, uint8_t mask)
+{
+    uint8_t &byte = m_data[major * minors + minor];
+    uint8_t val = (byte & ~mask) | (bits & mask);
+
+    if (val != byte) {
+        byte = val;
+        mark_dirty(major, minor);
+    }
+}
+
+template< int W, int H, int Bpp, class Layout >
+void framebuffer< W, H, Bpp, Layout >::write_pixel(int x, int y, uint8_t color)
+{
+    int major, minor, shift;
+    locate(x, y, major, minor, shift);
+
+    write_byte(major, minor, color << shift, max_color << shift);
+}
+
+template< int W, int H, int Bpp, class Layout >
+void framebuffer< W, H, Bpp, Layout >::mark_dirty(int major, int minor)
+{
+    if (major < m_dirty.major0)
+        m_dirty.major0 = major;
+    if (major > m_dirty.major1)
+        m_dirty.major1 = major;
+    if (minor < m_dirty.minor0)
+        m_dirty.minor0 = minor;
+    if (minor > m_dirty.minor1)
+        m_dirty.minor1 = minor;
+}
+
+template< int W, int H, int Bpp, class Layout >
+void framebuffer< W, H, Bpp, Layout >::write_column(int x, int y, uint8_t bits,
+                                                    uint8_t mask)
+{
+    // Column is split between two pages, unless it is aligned.
+    // Shift is done in 16 bits, so the lower part gets into the high byte.
+    int shift = y & 0x7;
+    int page = (y - shift) / 8;
+
+    uint16_t wide_bits = bits << shift;
+    uint16_t wide_mask = mask << shift;
+
+    constexpr int pages = (H + 7) / 8;
+
+    if (page >= 0 && page < pages && (wide_mask & 0xff)) {
+        write_byte(geom::major(x, page), geom::minor(x, page), wide_bits, wide_mask);
+    }
+
+    page++;
+    wide_bits >>= 8;
+    wide_mask >>= 8;
+
+    if (page >= 0 && page < pages && wide_mask) {
+        write_byte(geom::major(x, page), geom::minor(x, page), wide_bits, wide_mask);
+    }
+}
+
+template< int W, int H, int Bpp, class Layout >
+void framebuffer< W, H, Bpp, Layout >::fill(int x0, int y0, int x1, int y1,
+                                            uint8_t color, std::true_type)
+{
+    uint8_t bits = color ? 0xff : 0;
+
+    // Rectangle is split into 8-pixel high strips, each strip touches
+    // one or two bytes per column
+    for (int y = y0; y < y1; y += 8) {
+        int left = y1 - y;
+        uint8_t mask = left >= 8 ? 0xff : (1 << left) - 1;
+
+        for (int x = x0; x < x1; ++x) {
+            write_column(x, y, bits, mask);
+        }
+    }
+}
+
+template< int W, int H, int Bpp, class Layout >
+void framebuffer< W, H, Bpp, Layout >::fill(int x0, int y0, int x1, int y1,
+                                            uint8_t color, std::false_type)
+{
+    constexpr int per_byte = 8 / Bpp;
+
+    uint8_t pattern = color_byte(color);
+
+    // Unaligned pixels at the edges of each row are written one by one,
+    // whole bytes between them are filled at once
+    int head_end = (x0 + per_byte - 1) / per_byte * per_byte;
+    int tail_start = x1 / per_byte * per_byte;
+
+    if (head_end > x1) {
+        head_end = x1;
+    }
+
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < head_end; ++x) {
+            write_pixel(x, y, color);
+        }
+
+        if (head_end < tail_start) {
+            int first = head_end / per_byte;
+            int last = tail_start / per_byte - 1;
+            auto row = &m_data[geom::major(0, y) * minors];
+
+            memset(row + first, pattern, last - first + 1);
+            mark_dirty(geom::major(first, y), geom::minor(first, y));
+            mark_dirty(geom::major(last, y), geom::minor(last, y));
+        }
+
+        for (int x = tail_start < head_end ? head_end : tail_start; x < x1; ++x) {
+            write_pixel(x, y, color);
+        }
+    }
+}
+
+template< int W, int H, int Bpp, class Layout >
+void framebuffer< W, H, Bpp, Layout >::blit_page(int x, int y, const uint8_t *src,
+                                                 int from, int to, uint8_t mask,
+                                                 uint8_t color, std::true_type)
+{
+    bool on = color;
+
+    for (int i = from; i < to; ++i) {
+        write_column(x + i, y, on ? src[i] : 0, mask);
+    }
+}
+
+template< int W, int H, int Bpp, class Layout >
+void framebuffer< W, H, Bpp, Layout >::blit_page(int x, int y, const uint8_t *src,
+                                                 int from, int to, uint8_t mask,
+                                                 uint8_t color, std::false_type)
+{
+    // Bitmap bytes are vertical, so each pixel is placed separately
+    for (int bit = 0; bit < 8; ++bit) {
+        int row = y + bit;
+
+        if (!(mask & (1 << bit)) || row < 0 || row >= H) {
+            continue;
+        }
+
+        for (int i = from; i < to; ++i) {
+            write_pixel(x + i, row, (src[i] >> bit) & 1 ? color : 0);
+        }
+    }
+}
+
+} // namespace ecl
+
+#endif // LIB_GFX_FRAMEBUFFER_HPP_
@@ -0,0 +1,292 @@
+#ifndef LIB_GFX_PIXEL_ENGINE_HPP_
+#define LIB_GFX_PIXEL_ENGINE_HPP_
+
+//!
+//! \file
+//! \brief Pixel formats of color framebuffers and software pixel engine.
+//! Pixel engine fills and copies rectangular areas of pixels, converting
+//! formats on the way. Hardware engines, i.e. platform/dma2d.hpp, follow
+//! the same interface, so framebuffers are not aware of what does the work.
+//!
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ecl
+{
+
+//!
+//! \brief Pixel formats. Pixels are stored little-endian, i.e. blue
+//! component of RGB888 comes first. Values match color mode codes of DMA2D.
+//!
+enum class pixel_format
+{
+    argb8888    = 0,
+    rgb888      = 1,
+    rgb565      = 2,
+    argb1555    = 3,
+    argb4444    = 4,
+};
+
+//!
+//! \brief Gets size of a pixel in bytes.
+//!
+constexpr int pixel_size(pixel_format fmt)
+{
+    return fmt == pixel_format::argb8888 ? 4 :
+           fmt == pixel_format::rgb888 ? 3 : 2;
+}
+
+//!
+//! \brief Converts ARGB8888 color to a pixel of given format.
+//! Components are truncated, alpha is dropped if format has no alpha.
+//!
+inline uint32_t to_pixel(pixel_format fmt, uint32_t argb)
+{
+    uint32_t a = argb >> 24;
+    uint32_t r = (argb >> 16) & 0xff;
+    uint32_t g = (argb >> 8) & 0xff;
+    uint32_t b = argb & 0xff;
+
+    switch (fmt) {
+    case pixel_format::argb8888:
+        return argb;
+    case pixel_format::rgb888:
+        return argb & 0xffffff;
+    case pixel_format::rgb565:
+        return (r >> 3) << 11 | (g >> 2) << 5 | b >> 3;
+    case pixel_format::argb1555:
+        return (a >> 7) << 15 | (r >> 3) << 10 | (g >> 3) << 5 | b >> 3;
+    case pixel_format::argb4444:
+        return (a >> 4) << 12 | (r >> 4) << 8 | (g >> 4) << 4 | b >> 4;
+    }
+
+    return 0;
+}
+
+//!
+//! \brief Converts a pixel of given format to ARGB8888 color.
+//! Components are expanded by replicating their high bits, as DMA2D does.
+//! Alpha is opaque if format has no alpha.
+//!
+inline uint32_t to_argb(pixel_format fmt, uint32_t px)
+{
+    uint32_t a = 0xff, r, g, b;
+
+    switch (fmt) {
+    case pixel_format::argb8888:
+        return px;
+    case pixel_format::rgb888:
+        return 0xff000000 | px;
+    case pixel_format::rgb565:
+        r = (px >> 11) & 0x1f;
+        g = (px >> 5) & 0x3f;
+        b = px & 0x1f;
+        r = r << 3 | r >> 2;
+        g = g << 2 | g >> 4;
+        b = b << 3 | b >> 2;
+        break;
+    case pixel_format::argb1555:
+        a = px & 0x8000 ? 0xff : 0;
+        r = (px >> 10) & 0x1f;
+        g = (px >> 5) & 0x1f;
+        b = px & 0x1f;
+        r = r << 3 | r >> 2;
+        g = g << 3 | g >> 2;
+        b = b << 3 | b >> 2;
+        break;
+    case pixel_format::argb4444:
+        a = ((px >> 12) & 0xf) * 0x11;
+        r = ((px >> 8) & 0xf) * 0x11;
+        g = ((px >> 4) & 0xf) * 0x11;
+        b = (px & 0xf) * 0x11;
+        break;
+    default:
+        return 0;
+    }
+
+    return a << 24 | r << 16 | g << 8 | b;
+}
+
+//!
+//! \brief Composes ARGB8888 color over another one, weighted by alpha,
+//! with the same formula as DMA2D blending uses.
+//! \param[in] fg Color on top.
+//! \param[in] bg Color below.
+//!
+inline uint32_t blend_argb(uint32_t fg, uint32_t bg)
+{
+    uint32_t af = fg >> 24;
+    // Part of the background that shows through the foreground
+    uint32_t ab = (bg >> 24) - (bg >> 24) * af / 255;
+    uint32_t a = af + ab;
+
+    if (!a) {
+        return 0;
+    }
+
+    uint32_t argb = a << 24;
+
+    for (int shift = 0; shift < 24; shift += 8) {
+        uint32_t cf = (fg >> shift) & 0xff;
+        uint32_t cb = (bg >> shift) & 0xff;
+        argb |= (cf * af + cb * ab) / a << shift;
+    }
+
+    return argb;
+}
+
+//!
+//! \brief Writable area of pixels.
+//!
+struct surface
+{
+    void            *data;      //!< First pixel of the area.
+    pixel_format    format;     //!< Format of pixels.
+    int             stride;     //!< Distance between lines, in pixels.
+};
+
+//!
+//! \brief Read-only area of pixels.
+//!
+struct pixmap
+{
+    const void      *data;      //!< First pixel of the area.
+    pixel_format    format;     //!< Format of pixels.
+    int             stride;     //!< Distance between lines, in pixels.
+};
+
+//!
+//! \brief Pixel engine, implemented by CPU.
+//! Areas must not overlap. Sizes are not validated, callers clip them.
+//!
+class soft_pixel_engine
+{
+public:
+    //!
+    //! \brief Fills an area with ARGB8888 color.
+    //! \param[in] dst  Destination.
+    //! \param[in] w    Width in pixels.
+    //! \param[in] h    Height in pixels.
+    //! \param[in] argb Color.
+    //!
+    static void fill(const surface &dst, int w, int h, uint32_t argb);
+
+    //!
+    //! \brief Copies an area, converting its format if formats differ.
+    //! \param[in] src  Source.
+    //! \param[in] dst  Destination.
+    //! \param[in] w    Width in pixels.
+    //! \param[in] h    Height in pixels.
+    //!
+    static void copy(const pixmap &src, const surface &dst, int w, int h);
+
+    //!
+    //! \brief Composes an area over another one, by alpha of the former.
+    //! \param[in] fg   Foreground.
+    //! \param[in] bg   Background. May be the same area as destination.
+    //! \param[in] dst  Destination.
+    //! \param[in] w    Width in pixels.
+    //! \param[in] h    Height in pixels.
+    //! \sa blend_argb()
+    //!
+    static void blend(const pixmap &fg, const pixmap &bg, const surface &dst, int w, int h);
+
+private:
+    //! Reads a pixel.
+    static uint32_t load(const uint8_t *p, int size);
+
+    //! Writes a pixel.
+    static void store(uint8_t *p, int size, uint32_t px);
+};
+
+//------------------------------------------------------------------------------
+
+inline void soft_pixel_engine::fill(const surface &dst, int w, int h, uint32_t argb)
+{
+    int size = pixel_size(dst.format);
+    uint32_t px = to_pixel(dst.format, argb);
+    auto line = static_cast< uint8_t * >(dst.data);
+
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    // First line is built pixel by pixel, the rest are copies of it
+    for (int x = 0; x < w; ++x) {
+        store(line + x * size, size, px);
+    }
+
+    for (int y = 1; y < h; ++y) {
+        memcpy(line + y * dst.stride * size, line, w * size);
+    }
+}
+
+inline void soft_pixel_engine::copy(const pixmap &src, const surface &dst, int w, int h)
+{
+    int src_size = pixel_size(src.format);
+    int dst_size = pixel_size(dst.format);
+
+    for (int y = 0; y < h; ++y) {
+        auto from = static_cast< const uint8_t * >(src.data) + y * src.stride * src_size;
+        auto to = static_cast< uint8_t * >(dst.data) + y * dst.stride * dst_size;
+
+        if (src.format == dst.format) {
+            memcpy(to, from, w * dst_size);
+            continue;
+        }
+
+        for (int x = 0; x < w; ++x) {
+            uint32_t argb = to_argb(src.format, load(from + x * src_size, src_size));
+            store(to + x * dst_size, dst_size, to_pixel(dst.format, argb));
+        }
+    }
+}
+
+inline void soft_pixel_engine::blend(const pixmap &fg, const pixmap &bg, const surface &dst,
+                                     int w, int h)
+{
+    int fg_size = pixel_size(fg.format);
+    int bg_size = pixel_size(bg.format);
+    int dst_size = pixel_size(dst.format);
+
+    for (int y = 0; y < h; ++y) {
+        auto top = static_cast< const uint8_t * >(fg.data) + y * fg.stride * fg_size;
+        auto below = static_cast< const uint8_t * >(bg.data) + y * bg.stride * bg_size;
+        auto to = static_cast< uint8_t * >(dst.data) + y * dst.stride * dst_size;
+
+        // Each pixel is read before it is written, so background can be
+        // the destination itself
+        for (int x = 0; x < w; ++x) {
+            uint32_t f = to_argb(fg.format, load(top + x * fg_size, fg_size));
+            uint32_t b = to_argb(bg.format, load(below + x * bg_size, bg_size));
+            store(to + x * dst_size, dst_size, to_pixel(dst.format, blend_argb(f, b)));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+inline uint32_t soft_pixel_engine::load(const uint8_t *p, int size)
+{
+    uint32_t px = 0;
+
+    for (int i = size - 1; i >= 0; --i) {
+        px = px << 8 | p[i];
+    }
+
+    return px;
+}
+
+inline void soft_pixel_engine::store(uint8_t *p, int size, uint32_t px)
+{
+    for (int i = 0; i < size; ++i, px >>= 8) {
+        p[i] = px;
+    }
+}
+
+} // namespace ecl
+
+#endif // LIB_GFX_PIXEL_ENGINE_HPP_
@@ -0,0 +1,327 @@
+#include <ecl/color_framebuffer.hpp>
+
+#include <cstdlib>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Counts operations, passed to the engine
+struct counting_engine
+{
+    static void fill(const ecl::surface &dst, int w, int h, uint32_t argb)
+    {
+        ++fills;
+        ecl::soft_pixel_engine::fill(dst, w, h, argb);
+    }
+
+    static void copy(const ecl::pixmap &src, const ecl::surface &dst, int w, int h)
+    {
+        ++copies;
+        ecl::soft_pixel_engine::copy(src, dst, w, h);
+    }
+
+    static void blend(const ecl::pixmap &fg, const ecl::pixmap &bg, const ecl::surface &dst,
+                      int w, int h)
+    {
+        ++blends;
+        ecl::soft_pixel_engine::blend(fg, bg, dst, w, h);
+    }
+
+    static int fills;
+    static int copies;
+    static int blends;
+};
+
+int counting_engine::fills;
+int counting_engine::copies;
+int counting_engine::blends;
+
+// Reference framebuffer with ARGB8888 pixels, converted to the format
+template< class Fb >
+struct reference
+{
+    void set(int x, int y, uint32_t argb)
+    {
+        if (x >= 0 && y >= 0 && x < Fb::width && y < Fb::height) {
+            pixels[y * Fb::width + x] = ecl::to_argb(Fb::format, ecl::to_pixel(Fb::format, argb));
+        }
+    }
+
+    void fill(int x, int y, int w, int h, uint32_t argb)
+    {
+        for (int i = x; i < x + w; ++i) {
+            for (int j = y; j < y + h; ++j) {
+                set(i, j, argb);
+            }
+        }
+    }
+
+    void check(const Fb &fb) const
+    {
+        for (int x = 0; x < Fb::width; ++x) {
+            for (int y = 0; y < Fb::height; ++y) {
+                uint32_t argb = 0;
+                CHECK_EQUAL(ecl::err::ok, fb.get_point({x, y}, argb));
+                CHECK_EQUAL(pixels[y * Fb::width + x], argb);
+            }
+        }
+    }
+
+    std::vector< uint32_t > pixels = std::vector< uint32_t >(Fb::width * Fb::height,
+                                                             0xff000000);
+};
+
+// Draws random rectangles and images, partially outside the framebuffer
+template< class Fb >
+void random_drawing()
+{
+    Fb fb;
+    reference< Fb > ref;
+    uint32_t image[16 * 16];
+
+    for (auto &px : image) {
+        px = static_cast< uint32_t >(rand()) << 16 ^ rand();
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        int x = rand() % (Fb::width + 20) - 10;
+        int y = rand() % (Fb::height + 20) - 10;
+        int w = rand() % 20;
+        int h = rand() % 20;
+        uint32_t argb = static_cast< uint32_t >(rand()) << 16 ^ rand();
+
+        if (i % 2) {
+            fb.fill_rect({x, y}, w, h, argb);
+            ref.fill(x, y, w, h, argb);
+        } else {
+            w = w > 16 ? 16 : w;
+            h = h > 16 ? 16 : h;
+
+            fb.blit({x, y}, ecl::pixmap{image, ecl::pixel_format::argb8888, 16}, w, h);
+
+            for (int j = 0; j < w; ++j) {
+                for (int k = 0; k < h; ++k) {
+                    ref.set(x + j, y + k, image[k * 16 + j]);
+                }
+            }
+        }
+    }
+
+    ref.check(fb);
+}
+
+} // namespace
+
+TEST_GROUP(color_framebuffer)
+{
+    void setup()
+    {
+        counting_engine::fills = 0;
+        counting_engine::copies = 0;
+        counting_engine::blends = 0;
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(color_framebuffer, geometry)
+{
+    using fb565 = ecl::color_framebuffer< 30, 10, ecl::pixel_format::rgb565 >;
+    using fb888 = ecl::color_framebuffer< 30, 10, ecl::pixel_format::rgb888 >;
+
+    CHECK_EQUAL(10, fb565::majors);
+    CHECK_EQUAL(60, fb565::minors);
+    CHECK_EQUAL(600, fb565::size);
+    CHECK_EQUAL(90, fb888::minors);
+}
+
+TEST(color_framebuffer, pixel_conversion)
+{
+    using ecl::pixel_format;
+
+    CHECK_EQUAL(0xf81f, ecl::to_pixel(pixel_format::rgb565, 0xffff00ff));
+    CHECK_EQUAL(0xffff00ff, ecl::to_argb(pixel_format::rgb565, 0xf81f));
+    CHECK_EQUAL(0x8000, ecl::to_pixel(pixel_format::argb1555, 0x80000000));
+    CHECK_EQUAL(0x7f0f, ecl::to_pixel(pixel_format::argb4444, 0x7ff000ff));
+    CHECK_EQUAL(0x77ff00ff, ecl::to_argb(pixel_format::argb4444, 0x7f0f));
+    CHECK_EQUAL(0xff123456, ecl::to_argb(pixel_format::rgb888, 0x123456));
+
+    // Full range components survive the round trip in every format
+    for (int f = 0; f <= 4; ++f) {
+        auto fmt = static_cast< pixel_format >(f);
+        CHECK_EQUAL(0xffffffff, ecl::to_argb(fmt, ecl::to_pixel(fmt, 0xffffffff)));
+    }
+}
+
+TEST(color_framebuffer, rgb888_byte_order)
+{
+    ecl::color_framebuffer< 4, 2, ecl::pixel_format::rgb888 > fb;
+
+    fb.set_point({1, 0}, 0xff123456);
+
+    CHECK_EQUAL(0x56, *fb.data(0, 3));
+    CHECK_EQUAL(0x34, *fb.data(0, 4));
+    CHECK_EQUAL(0x12, *fb.data(0, 5));
+}
+
+TEST(color_framebuffer, rgb565_drawing)
+{
+    random_drawing< ecl::color_framebuffer< 40, 30, ecl::pixel_format::rgb565 > >();
+}
+
+TEST(color_framebuffer, argb8888_drawing)
+{
+    random_drawing< ecl::color_framebuffer< 40, 30, ecl::pixel_format::argb8888 > >();
+}
+
+TEST(color_framebuffer, rgb888_drawing)
+{
+    random_drawing< ecl::color_framebuffer< 40, 30, ecl::pixel_format::rgb888 > >();
+}
+
+TEST(color_framebuffer, argb4444_drawing)
+{
+    random_drawing< ecl::color_framebuffer< 40, 30, ecl::pixel_format::argb4444 > >();
+}
+
+TEST(color_framebuffer, blit_clipping)
+{
+    using fb_type = ecl::color_framebuffer< 8, 8, ecl::pixel_format::rgb565 >;
+    fb_type fb;
+    uint16_t image[4 * 4];
+
+    for (int i = 0; i < 16; ++i) {
+        image[i] = i + 1;
+    }
+
+    fb.blit({-1, -2}, ecl::pixmap{image, ecl::pixel_format::rgb565, 4}, 4, 4);
+
+    uint32_t argb = 0;
+
+    // Top left pixel of the framebuffer comes from row 2, column 1
+    fb.get_point({0, 0}, argb);
+    CHECK_EQUAL(ecl::to_argb(ecl::pixel_format::rgb565, 10), argb);
+    fb.get_point({2, 1}, argb);
+    CHECK_EQUAL(ecl::to_argb(ecl::pixel_format::rgb565, 16), argb);
+    fb.get_point({3, 0}, argb);
+    CHECK_EQUAL(0xff000000, argb);
+
+    CHECK_EQUAL(ecl::err::inval, fb.blit({0, 0}, ecl::pixmap{nullptr,
+        ecl::pixel_format::rgb565, 4}, 4, 4));
+    CHECK_EQUAL(ecl::err::inval, fb.get_point({8, 0}, argb));
+}
+
+TEST(color_framebuffer, argb_blending)
+{
+    // Opaque and transparent foreground
+    CHECK_EQUAL(0xff102030, ecl::blend_argb(0xff102030, 0xffa0b0c0));
+    CHECK_EQUAL(0xffa0b0c0, ecl::blend_argb(0x00102030, 0xffa0b0c0));
+    CHECK_EQUAL(0x00000000, ecl::blend_argb(0x00102030, 0x00a0b0c0));
+
+    // Half of each color over opaque background
+    CHECK_EQUAL(0xff808080, ecl::blend_argb(0x80ffffff, 0xff000000));
+
+    // Over transparent background, foreground keeps its color and alpha
+    CHECK_EQUAL(0x80ff0000, ecl::blend_argb(0x80ff0000, 0x0000ff00));
+}
+
+TEST(color_framebuffer, blend_clipping)
+{
+    using fb_type = ecl::color_framebuffer< 8, 8, ecl::pixel_format::argb8888 >;
+    fb_type fb;
+    uint32_t image[2 * 2] = { 0x80ffffff, 0x00ffffff, 0xffff0000, 0x80ffffff };
+
+    fb.fill_rect({0, 0}, 8, 8, 0xff000000);
+    fb.blend({7, -1}, ecl::pixmap{image, ecl::pixel_format::argb8888, 2}, 2, 2);
+
+    uint32_t argb = 0;
+
+    // Only bottom left pixel of the image lands on the framebuffer
+    fb.get_point({7, 0}, argb);
+    CHECK_EQUAL(0xffff0000, argb);
+    fb.get_point({6, 0}, argb);
+    CHECK_EQUAL(0xff000000, argb);
+
+    fb.blend({0, 0}, ecl::pixmap{image, ecl::pixel_format::argb8888, 2}, 2, 2);
+
+    fb.get_point({0, 0}, argb);
+    CHECK_EQUAL(0xff808080, argb);
+    fb.get_point({1, 0}, argb);
+    CHECK_EQUAL(0xff000000, argb);
+
+    CHECK_EQUAL(ecl::err::inval, fb.blend({0, 0}, ecl::pixmap{nullptr,
+        ecl::pixel_format::argb8888, 2}, 2, 2));
+}
+
+TEST(color_framebuffer, blend_converts_formats)
+{
+    ecl::color_framebuffer< 4, 4, ecl::pixel_format::rgb565 > fb;
+    uint16_t image[1] = { 0x8f00 };  // ARGB4444, half transparent red
+
+    fb.fill_rect({0, 0}, 4, 4, 0xff0000ff);
+    fb.blend({1, 1}, ecl::pixmap{image, ecl::pixel_format::argb4444, 1}, 1, 1);
+
+    uint32_t argb = 0;
+    uint32_t expected = ecl::to_argb(ecl::pixel_format::rgb565, ecl::to_pixel(
+        ecl::pixel_format::rgb565, ecl::blend_argb(
+            ecl::to_argb(ecl::pixel_format::argb4444, image[0]), 0xff0000ff)));
+
+    fb.get_point({1, 1}, argb);
+    CHECK_EQUAL(expected, argb);
+    fb.get_point({0, 0}, argb);
+    CHECK_EQUAL(0xff0000ff, argb);
+}
+
+TEST(color_framebuffer, engine_is_used)
+{
+    ecl::color_framebuffer< 16, 16, ecl::pixel_format::rgb565, counting_engine > fb;
+    uint16_t image[4] = {};
+
+    CHECK_EQUAL(1, counting_engine::fills);
+
+    fb.fill_rect({2, 2}, 4, 4, 0xffffffff);
+    fb.draw_hline({0, 0}, 16, 0xffffffff);
+    fb.clear();
+    fb.blit({0, 0}, ecl::pixmap{image, ecl::pixel_format::rgb565, 2}, 2, 2);
+    fb.blend({0, 0}, ecl::pixmap{image, ecl::pixel_format::argb4444, 2}, 2, 2);
+
+    CHECK_EQUAL(4, counting_engine::fills);
+    CHECK_EQUAL(1, counting_engine::copies);
+    CHECK_EQUAL(1, counting_engine::blends);
+
+    // Fully clipped operations don't reach the engine
+    fb.fill_rect({20, 0}, 4, 4, 0xffffffff);
+    fb.blit({0, -4}, ecl::pixmap{image, ecl::pixel_format::rgb565, 2}, 2, 2);
+    fb.blend({16, 0}, ecl::pixmap{image, ecl::pixel_format::argb4444, 2}, 2, 2);
+
+    CHECK_EQUAL(4, counting_engine::fills);
+    CHECK_EQUAL(1, counting_engine::copies);
+    CHECK_EQUAL(1, counting_engine::blends);
+}
+
+TEST(color_framebuffer, dirty_region)
+{
+    ecl::color_framebuffer< 16, 16, ecl::pixel_format::rgb565 > fb;
+
+    fb.mark_clean();
+    CHECK_TRUE(fb.dirty().empty());
+
+    fb.fill_rect({2, 3}, 4, 5, 0xffffffff);
+    fb.set_point({10, 1}, 0xffffffff);
+
+    CHECK_EQUAL(1, fb.dirty().major0);
+    CHECK_EQUAL(7, fb.dirty().major1);
+    CHECK_EQUAL(4, fb.dirty().minor0);
+    CHECK_EQUAL(21, fb.dirty().minor1);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
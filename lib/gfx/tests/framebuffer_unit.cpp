@@ -0,0 +1,219 @@
+#include <ecl/framebuffer.hpp>
+
+#include <cstdlib>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Naive framebuffer with single byte per pixel, used as a reference
+template< class Fb >
+struct reference
+{
+    void set(int x, int y, uint8_t color)
+    {
+        if (x >= 0 && y >= 0 && x < Fb::width && y < Fb::height) {
+            pixels[y * Fb::width + x] = color;
+        }
+    }
+
+    void fill(int x, int y, int w, int h, uint8_t color)
+    {
+        for (int i = x; i < x + w; ++i) {
+            for (int j = y; j < y + h; ++j) {
+                set(i, j, color);
+            }
+        }
+    }
+
+    void blit(int x, int y, const uint8_t *bmp, int w, int h, uint8_t color)
+    {
+        for (int i = 0; i < w; ++i) {
+            for (int j = 0; j < h; ++j) {
+                set(x + i, y + j, (bmp[(j / 8) * w + i] >> (j % 8)) & 1 ? color : 0);
+            }
+        }
+    }
+
+    void check(const Fb &fb) const
+    {
+        for (int x = 0; x < Fb::width; ++x) {
+            for (int y = 0; y < Fb::height; ++y) {
+                CHECK_EQUAL(pixels[y * Fb::width + x], fb.get_point({x, y}));
+            }
+        }
+    }
+
+    std::vector< int > pixels = std::vector< int >(Fb::width * Fb::height);
+};
+
+// Draws random shapes, partially outside the framebuffer
+template< class Fb >
+void random_drawing()
+{
+    Fb fb;
+    reference< Fb > ref;
+    uint8_t bmp[64];
+    constexpr int max_color = Fb::max_color;
+
+    srand(42);
+
+    for (int i = 0; i < 2000; ++i) {
+        int x = rand() % (Fb::width + 16) - 8;
+        int y = rand() % (Fb::height + 16) - 8;
+        int w = rand() % 20;
+        int h = rand() % 20;
+        uint8_t color = rand() % (max_color + 1);
+
+        switch (rand() % 4) {
+        case 0:
+            fb.fill_rect({x, y}, w, h, color);
+            ref.fill(x, y, w, h, color);
+            break;
+        case 1:
+            fb.draw_hline({x, y}, w, color);
+            ref.fill(x, y, w, 1, color);
+            break;
+        case 2:
+            fb.draw_vline({x, y}, h, color);
+            ref.fill(x, y, 1, h, color);
+            break;
+        case 3:
+            w %= 8;
+            for (auto &b : bmp) {
+                b = rand();
+            }
+            fb.blit({x, y}, bmp, w, h, color);
+            ref.blit(x, y, bmp, w, h, color);
+            break;
+        }
+    }
+
+    ref.check(fb);
+}
+
+} // namespace
+
+TEST_GROUP(framebuffer)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(framebuffer, geometry)
+{
+    using column_fb = ecl::framebuffer< 84, 48, 1, ecl::fb_layout::column_pages >;
+    using row_fb = ecl::framebuffer< 128, 60, 1, ecl::fb_layout::row_pages >;
+    using color_fb = ecl::framebuffer< 30, 10, 2, ecl::fb_layout::horizontal_rows >;
+
+    CHECK_EQUAL(84, column_fb::majors);
+    CHECK_EQUAL(6, column_fb::minors);
+    CHECK_EQUAL(8, row_fb::majors);
+    CHECK_EQUAL(128, row_fb::minors);
+    CHECK_EQUAL(10, color_fb::majors);
+    CHECK_EQUAL(8, color_fb::minors);
+    CHECK_EQUAL(3, color_fb::max_color);
+}
+
+TEST(framebuffer, pixel_placement)
+{
+    ecl::framebuffer< 16, 16, 1, ecl::fb_layout::column_pages > col;
+    ecl::framebuffer< 16, 16, 1, ecl::fb_layout::row_pages > row;
+    ecl::framebuffer< 16, 16, 2, ecl::fb_layout::horizontal_rows > hor;
+
+    CHECK_EQUAL(ecl::err::ok, col.set_point({3, 10}));
+    CHECK_EQUAL(ecl::err::ok, row.set_point({3, 10}));
+    CHECK_EQUAL(ecl::err::ok, hor.set_point({5, 1}, 2));
+
+    // Column 3, page 1, bit 2
+    CHECK_EQUAL(0x04, *col.data(3, 1));
+    // Page 1, column 3, bit 2
+    CHECK_EQUAL(0x04, *row.data(1, 3));
+    // Row 1, byte 1, second pixel from the left
+    CHECK_EQUAL(0x20, *hor.data(1, 1));
+
+    CHECK_EQUAL(ecl::err::inval, col.set_point({16, 0}));
+    CHECK_EQUAL(ecl::err::inval, hor.clear_point({0, -1}));
+    CHECK_EQUAL(-1, row.get_point({-1, 0}));
+}
+
+TEST(framebuffer, column_pages_drawing)
+{
+    random_drawing< ecl::framebuffer< 84, 48, 1, ecl::fb_layout::column_pages > >();
+}
+
+TEST(framebuffer, row_pages_drawing)
+{
+    random_drawing< ecl::framebuffer< 61, 30, 1, ecl::fb_layout::row_pages > >();
+}
+
+TEST(framebuffer, horizontal_rows_drawing)
+{
+    random_drawing< ecl::framebuffer< 61, 30, 1, ecl::fb_layout::horizontal_rows > >();
+    random_drawing< ecl::framebuffer< 37, 20, 2, ecl::fb_layout::horizontal_rows > >();
+    random_drawing< ecl::framebuffer< 37, 20, 4, ecl::fb_layout::horizontal_rows > >();
+    random_drawing< ecl::framebuffer< 37, 20, 8, ecl::fb_layout::horizontal_rows > >();
+}
+
+TEST(framebuffer, dirty_region)
+{
+    ecl::framebuffer< 84, 48, 1, ecl::fb_layout::column_pages > fb;
+
+    // Initially whole memory is dirty
+    CHECK_EQUAL(0, fb.dirty().major0);
+    CHECK_EQUAL(83, fb.dirty().major1);
+    CHECK_EQUAL(0, fb.dirty().minor0);
+    CHECK_EQUAL(5, fb.dirty().minor1);
+
+    fb.mark_clean();
+    CHECK_TRUE(fb.dirty().empty());
+
+    // Clearing cleared pixels changes nothing
+    fb.fill_rect({0, 0}, 10, 10, 0);
+    CHECK_TRUE(fb.dirty().empty());
+
+    fb.set_point({20, 9});
+    fb.draw_hline({10, 30}, 3);
+
+    CHECK_EQUAL(10, fb.dirty().major0);
+    CHECK_EQUAL(20, fb.dirty().major1);
+    CHECK_EQUAL(1, fb.dirty().minor0);
+    CHECK_EQUAL(3, fb.dirty().minor1);
+
+    fb.clear();
+    CHECK_EQUAL(83, fb.dirty().major1);
+}
+
+TEST(framebuffer, text)
+{
+    // Two 3x7 glyphs
+    static const uint8_t glyphs[] = { 0x7f, 0x41, 0x7f, 0x01, 0x7f, 0x00 };
+    ecl::font f{3, 7, '0', '1', glyphs};
+    ecl::framebuffer< 16, 16, 1, ecl::fb_layout::column_pages > fb;
+
+    CHECK_EQUAL(ecl::err::ok, fb.draw_text({1, 2}, f, "1x0"));
+    CHECK_EQUAL(ecl::err::inval, fb.draw_glyph({0, 0}, f, 'x'));
+
+    // Glyph is shifted down by two pixels
+    CHECK_EQUAL(0x04, *fb.data(1, 0));
+    CHECK_EQUAL(0xfc, *fb.data(2, 0));
+    CHECK_EQUAL(0x01, *fb.data(2, 1));
+
+    // Missing character leaves a gap
+    CHECK_EQUAL(0, *fb.data(4, 0));
+    CHECK_EQUAL(0xfc, *fb.data(7, 0));
+    CHECK_EQUAL(0x04, *fb.data(8, 0));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,528 @@
+#ifndef LIB_KV_KV_STORE_HPP_
+#define LIB_KV_KV_STORE_HPP_
+
+//!
+//! \file
+//! \brief Key-value store over flash sectors.
+//! Updates are appended to the active sector as log entries, so a value
+//! is changed without erasing anything. RAM index, built by init(), points
+//! to the last entry of each key, values are read in place:
+//! \code
+//!     ecl::kv_store< ecl::flash_sectors< 1, 2 > > config;
+//!     config.init();
+//!     config.set("baud", &baud, sizeof(baud));
+//!     config.get("baud", &baud, sizeof(baud));
+//! \endcode
+//! When active sector is full, live entries are moved to the next sector,
+//! and sectors are used in turn, so erases are spread over all of them.
+//!
+//! Flash sectors interface:
+//! \code
+//!     enum : size_t { sector_size = ..., sectors = ... };
+//!     static const uint8_t *map(size_t sector);
+//!     static err erase(size_t sector);
+//!     static err program(size_t sector, size_t offset, const uint32_t *words, size_t n);
+//! \endcode
+//! \sa ecl::ram_flash
+//!
+
+#include <ecl/err.hpp>
+#include <ecl/crc.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ecl
+{
+
+//!
+//! \brief Key-value store, resistant to power loss at any moment.
+//! Entry is committed by its last programmed word, so interrupted update
+//! leaves previous value in effect. Store is not thread-safe, callers
+//! must serialize access.
+//! \tparam Flash    Flash sectors, at least two.
+//! \tparam max_keys Capacity of RAM index.
+//!
+template< class Flash, size_t max_keys = 32 >
+class kv_store
+{
+    static_assert(Flash::sectors >= 2, "Sectors are rotated, two at least are required");
+    static_assert(Flash::sector_size % 4 == 0 && Flash::sector_size >= 64,
+                  "Invalid sector size");
+
+public:
+    enum : size_t
+    {
+        max_key     = 32,   //!< Longest key, in characters.
+    };
+
+    //!
+    //! \brief Finds active sector and builds the index.
+    //! Flash without valid sectors is formatted.
+    //! \retval err::ok  Store is ready.
+    //! \retval err::io  Flash failed.
+    //!
+    err init();
+
+    //!
+    //! \brief Finds a value and gives direct access to it.
+    //! Pointer is valid until next update of the store.
+    //! \param[in]  key Key to find.
+    //! \param[out] len Length of the value.
+    //! \return Pointer to the value, or nullptr if key is not found.
+    //!
+    const uint8_t *find(const char *key, size_t &len) const;
+
+    //!
+    //! \brief Copies a value.
+    //! \param[in]  key  Key to find.
+    //! \param[out] buf  Buffer for the value.
+    //! \param[in]  size Size of the buffer.
+    //! \param[out] len  Optional. Length of the value.
+    //! \retval err::ok      Value is copied.
+    //! \retval err::noent   Key is not found.
+    //! \retval err::msgsize Buffer is too small, nothing is copied.
+    //!
+    err get(const char *key, void *buf, size_t size, size_t *len = nullptr) const;
+
+    //!
+    //! \brief Stores a value. Unchanged value isn't written again.
+    //! \retval err::ok          Value is stored.
+    //! \retval err::inval       Key or value is invalid.
+    //! \retval err::nametoolong Key is longer than max_key.
+    //! \retval err::nomem       Index is full.
+    //! \retval err::nospc       Live values don't leave space for the value.
+    //! \retval err::io          Flash failed, store must be inited again.
+    //!
+    err set(const char *key, const void *data, size_t size);
+
+    //!
+    //! \brief Removes a value.
+    //! \retval err::ok     Value is removed.
+    //! \retval err::noent  Key is not found.
+    //! \retval err::nospc  There is no space even for removal record.
+    //! \retval err::io     Flash failed, store must be inited again.
+    //!
+    err remove(const char *key);
+
+    //!
+    //! \brief Gets amount of stored keys.
+    //!
+    size_t count() const { return m_count; }
+
+    //!
+    //! \brief Gets amount of bytes left in the active sector.
+    //!
+    size_t space() const { return Flash::sector_size - m_end; }
+
+private:
+    //! Sector header: magic and generation words.
+    enum : uint32_t
+    {
+        magic       = 0x3153564b, // "KVS1"
+        header_size = 8,
+        entry_head  = 8,
+        flag_remove = 1,
+    };
+
+    //! Index record.
+    struct slot
+    {
+        uint32_t hash;      //!< Hash of a key.
+        uint32_t offset;    //!< Last entry of the key in the active sector.
+    };
+
+    //! Entry fields, decoded from its first word.
+    struct entry
+    {
+        size_t  value_len;
+        size_t  key_len;
+        uint8_t flags;
+    };
+
+    static uint32_t hash(const char *key, size_t len);
+    static size_t entry_size(size_t key_len, size_t value_len);
+    static uint32_t word(const uint8_t *p);
+    static entry decode(uint32_t w0);
+
+    //! Checks a sector header. Generation of invalid sector is 0.
+    static uint32_t generation(size_t sector);
+
+    //! Scans active sector and builds the index.
+    void scan();
+    //! Finds index slot of a key, nullptr if key is not found.
+    const slot *lookup(const char *key, size_t len) const;
+    //! Updates the index with an entry.
+    bool apply(uint32_t offset, const uint8_t *key, size_t key_len, bool removed);
+
+    //! Writes an entry to the active sector.
+    err append(const char *key, size_t key_len, const void *data, size_t size,
+               uint8_t flags);
+    //! Moves live entries to the next sector.
+    err compact();
+
+    size_t      m_active = 0;       //!< Active sector.
+    uint32_t    m_gen = 0;          //!< Its generation.
+    size_t      m_end = 0;          //!< End of the log in the active sector.
+    slot        m_index[max_keys];  //!< Index of live keys.
+    size_t      m_count = 0;        //!< Amount of live keys.
+};
+
+//------------------------------------------------------------------------------
+
+template< class Flash, size_t max_keys >
+err kv_store< Flash, max_keys >::init()
+{
+    m_gen = 0;
+
+    for (size_t s = 0; s < Flash::sectors; ++s) {
+        auto gen = generation(s);
+        if (gen > m_gen) {
+            m_gen = gen;
+            m_active = s;
+        }
+    }
+
+    if (!m_gen) {
+        const uint32_t header[] = { magic, 1 };
+
+        m_active = 0;
+
+        // Generation goes first, magic commits the header
+        if (is_error(Flash::erase(m_active))
+                || is_error(Flash::program(m_active, 4, header + 1, 1))
+                || is_error(Flash::program(m_active, 0, header, 1))) {
+            return err::io;
+        }
+
+        m_gen = 1;
+    }
+
+    scan();
+    return err::ok;
+}
+
+template< class Flash, size_t max_keys >
+const uint8_t *kv_store< Flash, max_keys >::find(const char *key, size_t &len) const
+{
+    auto s = lookup(key, strlen(key));
+    if (!s) {
+        return nullptr;
+    }
+
+    auto p = Flash::map(m_active) + s->offset;
+    auto e = decode(word(p));
+
+    len = e.value_len;
+    return p + entry_head + e.key_len;
+}
+
+template< class Flash, size_t max_keys >
+err kv_store< Flash, max_keys >::get(const char *key, void *buf, size_t size, size_t *len) const
+{
+    size_t value_len;
+    auto value = find(key, value_len);
+
+    if (!value) {
+        return err::noent;
+    }
+
+    if (len) {
+        *len = value_len;
+    }
+
+    if (value_len > size) {
+        return err::msgsize;
+    }
+
+    std::copy(value, value + value_len, static_cast< uint8_t * >(buf));
+    return err::ok;
+}
+
+template< class Flash, size_t max_keys >
+err kv_store< Flash, max_keys >::set(const char *key, const void *data, size_t size)
+{
+    if (!key || !*key || (size && !data) || size > 0xffff) {
+        return err::inval;
+    }
+
+    size_t key_len = strlen(key);
+    if (key_len > max_key) {
+        return err::nametoolong;
+    }
+
+    if (header_size + entry_size(key_len, size) > Flash::sector_size) {
+        return err::inval;
+    }
+
+    size_t old_len;
+    auto old = find(key, old_len);
+
+    if (old && old_len == size && std::equal(old, old + size,
+                                             static_cast< const uint8_t * >(data))) {
+        return err::ok;
+    }
+
+    if (!old && m_count == max_keys) {
+        return err::nomem;
+    }
+
+    return append(key, key_len, data, size, 0);
+}
+
+template< class Flash, size_t max_keys >
+err kv_store< Flash, max_keys >::remove(const char *key)
+{
+    if (!key || !lookup(key, strlen(key))) {
+        return err::noent;
+    }
+
+    return append(key, strlen(key), nullptr, 0, flag_remove);
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< class Flash, size_t max_keys >
+uint32_t kv_store< Flash, max_keys >::hash(const char *key, size_t len)
+{
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ static_cast< uint8_t >(key[i])) * 16777619u;
+    }
+
+    return h;
+}
+
+template< class Flash, size_t max_keys >
+size_t kv_store< Flash, max_keys >::entry_size(size_t key_len, size_t value_len)
+{
+    return entry_head + ((key_len + value_len + 3) & ~3u);
+}
+
+template< class Flash, size_t max_keys >
+uint32_t kv_store< Flash, max_keys >::word(const uint8_t *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | static_cast< uint32_t >(p[3]) << 24;
+}
+
+template< class Flash, size_t max_keys >
+typename kv_store< Flash, max_keys >::entry kv_store< Flash, max_keys >::decode(uint32_t w0)
+{
+    return entry{w0 & 0xffff, (w0 >> 16) & 0xff, static_cast< uint8_t >(w0 >> 24)};
+}
+
+template< class Flash, size_t max_keys >
+uint32_t kv_store< Flash, max_keys >::generation(size_t sector)
+{
+    auto p = Flash::map(sector);
+    uint32_t gen = word(p + 4);
+
+    return word(p) == magic && gen != 0xffffffff ? gen : 0;
+}
+
+template< class Flash, size_t max_keys >
+void kv_store< Flash, max_keys >::scan()
+{
+    auto base = Flash::map(m_active);
+    size_t offset = header_size;
+
+    m_count = 0;
+
+    while (offset + entry_head <= Flash::sector_size) {
+        uint32_t w0 = word(base + offset);
+        if (w0 == 0xffffffff) {
+            break;
+        }
+
+        auto e = decode(w0);
+        size_t size = entry_size(e.key_len, e.value_len);
+
+        if (!e.key_len || e.key_len > max_key || offset + size > Flash::sector_size) {
+            // Entry header itself is torn, rest of the sector is unusable
+            offset = Flash::sector_size;
+            break;
+        }
+
+        // Entry is committed by CRC word. Torn entries are skipped.
+        auto key = base + offset + entry_head;
+        uint8_t head[4] = { base[offset], base[offset + 1], base[offset + 2], base[offset + 3] };
+        uint16_t crc = crc16(head, 4);
+        crc = crc16(key, e.key_len + e.value_len, crc);
+
+        if (word(base + offset + 4) == crc) {
+            apply(offset, key, e.key_len, e.flags & flag_remove);
+        }
+
+        offset += size;
+    }
+
+    m_end = offset;
+}
+
+template< class Flash, size_t max_keys >
+const typename kv_store< Flash, max_keys >::slot *
+kv_store< Flash, max_keys >::lookup(const char *key, size_t len) const
+{
+    uint32_t h = hash(key, len);
+    auto base = Flash::map(m_active);
+
+    for (size_t i = 0; i < m_count; ++i) {
+        if (m_index[i].hash != h) {
+            continue;
+        }
+
+        auto p = base + m_index[i].offset;
+        if (decode(word(p)).key_len == len && !memcmp(p + entry_head, key, len)) {
+            return &m_index[i];
+        }
+    }
+
+    return nullptr;
+}
+
+template< class Flash, size_t max_keys >
+bool kv_store< Flash, max_keys >::apply(uint32_t offset, const uint8_t *key, size_t key_len,
+                                        bool removed)
+{
+    auto s = const_cast< slot * >(lookup(reinterpret_cast< const char * >(key), key_len));
+
+    if (removed) {
+        if (s) {
+            *s = m_index[--m_count];
+        }
+    } else if (s) {
+        s->offset = offset;
+    } else if (m_count < max_keys) {
+        m_index[m_count++] = slot{hash(reinterpret_cast< const char * >(key), key_len), offset};
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+template< class Flash, size_t max_keys >
+err kv_store< Flash, max_keys >::append(const char *key, size_t key_len, const void *data,
+                                        size_t size, uint8_t flags)
+{
+    size_t total = entry_size(key_len, size);
+
+    if (m_end + total > Flash::sector_size) {
+        auto rc = compact();
+        if (is_error(rc)) {
+            return rc;
+        }
+
+        if (m_end + total > Flash::sector_size) {
+            return err::nospc;
+        }
+    }
+
+    uint32_t w0 = size | key_len << 16 | static_cast< uint32_t >(flags) << 24;
+    uint8_t head[4] = { static_cast< uint8_t >(w0), static_cast< uint8_t >(w0 >> 8),
+                        static_cast< uint8_t >(w0 >> 16), static_cast< uint8_t >(w0 >> 24) };
+    uint16_t crc = crc16(head, 4);
+    crc = crc16(reinterpret_cast< const uint8_t * >(key), key_len, crc);
+    crc = crc16(static_cast< const uint8_t * >(data), size, crc);
+
+    // Key and value are programmed in portions, padding is left erased
+    uint32_t words[8];
+    size_t offset = m_end + entry_head;
+    size_t pos = 0;
+    size_t len = key_len + size;
+
+    if (is_error(Flash::program(m_active, m_end, &w0, 1))) {
+        return err::io;
+    }
+
+    while (pos < len) {
+        size_t n = 0;
+
+        for (; n < 8 && pos < len; ++n) {
+            uint8_t bytes[4] = { 0xff, 0xff, 0xff, 0xff };
+
+            for (size_t i = 0; i < 4 && pos < len; ++i, ++pos) {
+                bytes[i] = pos < key_len ? key[pos]
+                                         : static_cast< const uint8_t * >(data)[pos - key_len];
+            }
+
+            words[n] = word(bytes);
+        }
+
+        if (is_error(Flash::program(m_active, offset, words, n))) {
+            return err::io;
+        }
+
+        offset += n * 4;
+    }
+
+    // Entry is committed
+    uint32_t w1 = crc;
+    if (is_error(Flash::program(m_active, m_end + 4, &w1, 1))) {
+        return err::io;
+    }
+
+    apply(m_end, reinterpret_cast< const uint8_t * >(key), key_len, flags & flag_remove);
+    m_end += total;
+
+    return err::ok;
+}
+
+template< class Flash, size_t max_keys >
+err kv_store< Flash, max_keys >::compact()
+{
+    size_t target = (m_active + 1) % Flash::sectors;
+    auto src = Flash::map(m_active);
+    size_t offset = header_size;
+
+    if (is_error(Flash::erase(target))) {
+        return err::io;
+    }
+
+    for (size_t i = 0; i < m_count; ++i) {
+        auto p = src + m_index[i].offset;
+        auto e = decode(word(p));
+        size_t size = entry_size(e.key_len, e.value_len);
+        uint32_t words[8];
+
+        // Entries are copied as is, including their commit words
+        for (size_t done = 0; done < size; ) {
+            size_t n = std::min< size_t >(8, (size - done) / 4);
+
+            for (size_t k = 0; k < n; ++k) {
+                words[k] = word(p + done + k * 4);
+            }
+
+            if (is_error(Flash::program(target, offset + done, words, n))) {
+                return err::io;
+            }
+
+            done += n * 4;
+        }
+
+        m_index[i].offset = offset;
+        offset += size;
+    }
+
+    // Old sector stays active until new header is committed
+    const uint32_t header[] = { magic, m_gen + 1 };
+
+    if (is_error(Flash::program(target, 4, header + 1, 1))
+            || is_error(Flash::program(target, 0, header, 1))) {
+        return err::io;
+    }
+
+    m_active = target;
+    m_gen++;
+    m_end = offset;
+
+    return err::ok;
+}
+
+} // namespace ecl
+
+#endif // LIB_KV_KV_STORE_HPP_
@@ -0,0 +1,151 @@
+#ifndef LIB_KV_RAM_FLASH_HPP_
+#define LIB_KV_RAM_FLASH_HPP_
+
+//!
+//! \file
+//! \brief Flash sectors, emulated in RAM.
+//!
+
+#include <ecl/err.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ecl
+{
+
+//!
+//! \brief RAM emulation of NOR flash sectors, i.e. for host builds.
+//! Implements flash sectors interface, see ecl::kv_store. As on NOR flash,
+//! erase sets all bits, programming only clears them. Power loss can be
+//! emulated by limiting amount of words programmed from now on.
+//! \tparam size  Size of each sector, in bytes.
+//! \tparam count Amount of sectors.
+//!
+template< size_t size, size_t count >
+class ram_flash
+{
+    static_assert(size % 4 == 0 && count > 0, "Invalid geometry");
+
+public:
+    enum : size_t
+    {
+        sector_size = size,     //!< Size of each sector.
+        sectors     = count,    //!< Amount of sectors.
+    };
+
+    //!
+    //! \brief Gets content of a sector.
+    //!
+    static const uint8_t *map(size_t sector) { return m_data[sector]; }
+
+    //!
+    //! \brief Erases a sector.
+    //! \retval err::ok    Sector is erased.
+    //! \retval err::inval Sector doesn't exist.
+    //! \retval err::io    Power is lost.
+    //!
+    static err erase(size_t sector);
+
+    //!
+    //! \brief Programs words of a sector, clearing bits.
+    //! \retval err::ok    Words are programmed.
+    //! \retval err::inval Words are unaligned or outside of the sector.
+    //! \retval err::io    Power is lost, part of words is programmed.
+    //!
+    static err program(size_t sector, size_t offset, const uint32_t *words, size_t n);
+
+    //!
+    //! \brief Emulates power loss after given amount of operations.
+    //! Programming of a word and erase of a sector are operations.
+    //!
+    static void lose_power_after(size_t ops) { m_budget = ops; }
+
+    //!
+    //! \brief Erases all sectors and restores power.
+    //!
+    static void wipe();
+
+    //!
+    //! \brief Gets amount of erases of a sector so far.
+    //!
+    static size_t erases(size_t sector) { return m_erases[sector]; }
+
+private:
+    static uint8_t  m_data[count][size];    //!< Content of sectors.
+    static size_t   m_erases[count];        //!< Erase counters.
+    static size_t   m_budget;               //!< Operations until power loss.
+};
+
+//------------------------------------------------------------------------------
+
+template< size_t size, size_t count >
+uint8_t ram_flash< size, count >::m_data[count][size];
+
+template< size_t size, size_t count >
+size_t ram_flash< size, count >::m_erases[count];
+
+template< size_t size, size_t count >
+size_t ram_flash< size, count >::m_budget = SIZE_MAX;
+
+template< size_t size, size_t count >
+err ram_flash< size, count >::erase(size_t sector)
+{
+    if (sector >= count) {
+        return err::inval;
+    }
+
+    if (!m_budget) {
+        // Interrupted erase leaves sector content undefined
+        memset(m_data[sector], 0xa5, size / 2);
+        return err::io;
+    }
+
+    if (m_budget != SIZE_MAX) {
+        m_budget--;
+    }
+
+    memset(m_data[sector], 0xff, size);
+    m_erases[sector]++;
+
+    return err::ok;
+}
+
+template< size_t size, size_t count >
+err ram_flash< size, count >::program(size_t sector, size_t offset,
+                                      const uint32_t *words, size_t n)
+{
+    if (sector >= count || offset % 4 || offset + n * 4 > size) {
+        return err::inval;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!m_budget) {
+            return err::io;
+        }
+
+        if (m_budget != SIZE_MAX) {
+            m_budget--;
+        }
+
+        uint32_t word;
+        memcpy(&word, m_data[sector] + offset + i * 4, 4);
+        word &= words[i];
+        memcpy(m_data[sector] + offset + i * 4, &word, 4);
+    }
+
+    return err::ok;
+}
+
+template< size_t size, size_t count >
+void ram_flash< size, count >::wipe()
+{
+    memset(m_data, 0xff, sizeof(m_data));
+    memset(m_erases, 0, sizeof(m_erases));
+    m_budget = SIZE_MAX;
+}
+
+} // namespace ecl
+
+#endif // LIB_KV_RAM_FLASH_HPP_
@@ -0,0 +1,229 @@
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include "ecl/kv_store.hpp"
+#include "ecl/ram_flash.hpp"
+
+#include <string.h>
+#include <string>
+
+namespace
+{
+
+// Three sectors of 256 bytes
+using flash_t = ecl::ram_flash< 256, 3 >;
+using store_t = ecl::kv_store< flash_t, 8 >;
+
+std::string value(int n)
+{
+    return "value-" + std::to_string(n);
+}
+
+std::string get(store_t &store, const char *key)
+{
+    char buf[128];
+    size_t len;
+
+    if (store.get(key, buf, sizeof(buf), &len) != ecl::err::ok) {
+        return "";
+    }
+
+    return {buf, len};
+}
+
+ecl::err set(store_t &store, const char *key, const std::string &v)
+{
+    return store.set(key, v.data(), v.size());
+}
+
+} // namespace
+
+TEST_GROUP(kv_store)
+{
+    store_t *store;
+
+    void setup()
+    {
+        flash_t::wipe();
+        store = new store_t;
+        CHECK_EQUAL(ecl::err::ok, store->init());
+    }
+
+    void teardown()
+    {
+        delete store;
+    }
+
+    void remount()
+    {
+        delete store;
+        flash_t::lose_power_after(SIZE_MAX);
+        store = new store_t;
+        CHECK_EQUAL(ecl::err::ok, store->init());
+    }
+};
+
+TEST(kv_store, set_get_remove)
+{
+    CHECK_EQUAL(0, store->count());
+    CHECK_EQUAL(ecl::err::noent, store->get("baud", nullptr, 0));
+
+    CHECK_EQUAL(ecl::err::ok, set(*store, "baud", "115200"));
+    CHECK_EQUAL(ecl::err::ok, set(*store, "name", "node"));
+    CHECK_EQUAL(2, store->count());
+
+    STRCMP_EQUAL("115200", get(*store, "baud").c_str());
+    STRCMP_EQUAL("node", get(*store, "name").c_str());
+
+    // Value is read in place
+    size_t len;
+    auto p = store->find("baud", len);
+    CHECK_EQUAL(6, len);
+    CHECK_TRUE(p >= flash_t::map(0) && p < flash_t::map(0) + flash_t::sector_size);
+
+    // Too small buffer
+    char buf[4];
+    CHECK_EQUAL(ecl::err::msgsize, store->get("baud", buf, sizeof(buf), &len));
+    CHECK_EQUAL(6, len);
+
+    CHECK_EQUAL(ecl::err::ok, set(*store, "baud", "9600"));
+    STRCMP_EQUAL("9600", get(*store, "baud").c_str());
+
+    CHECK_EQUAL(ecl::err::ok, store->remove("baud"));
+    CHECK_EQUAL(ecl::err::noent, store->remove("baud"));
+    CHECK_EQUAL(ecl::err::noent, store->get("baud", buf, sizeof(buf)));
+    CHECK_EQUAL(1, store->count());
+
+    // Empty values are allowed
+    CHECK_EQUAL(ecl::err::ok, store->set("flag", nullptr, 0));
+    CHECK_EQUAL(ecl::err::ok, store->get("flag", buf, sizeof(buf), &len));
+    CHECK_EQUAL(0, len);
+}
+
+TEST(kv_store, invalid_arguments)
+{
+    std::string long_key(store_t::max_key + 1, 'k');
+    std::string huge(flash_t::sector_size, 'v');
+
+    CHECK_EQUAL(ecl::err::inval, set(*store, "", "v"));
+    CHECK_EQUAL(ecl::err::nametoolong, set(*store, long_key.c_str(), "v"));
+    CHECK_EQUAL(ecl::err::inval, set(*store, "k", huge));
+
+    // Index is full
+    for (int i = 0; i < 8; ++i) {
+        CHECK_EQUAL(ecl::err::ok, set(*store, std::to_string(i).c_str(), "v"));
+    }
+
+    CHECK_EQUAL(ecl::err::nomem, set(*store, "new", "v"));
+    CHECK_EQUAL(ecl::err::ok, set(*store, "0", "updated"));
+}
+
+TEST(kv_store, unchanged_value_is_not_written)
+{
+    set(*store, "key", "same");
+    auto space = store->space();
+
+    CHECK_EQUAL(ecl::err::ok, set(*store, "key", "same"));
+    CHECK_EQUAL(space, store->space());
+}
+
+TEST(kv_store, remount)
+{
+    set(*store, "a", "1");
+    set(*store, "b", "2");
+    set(*store, "a", "3");
+    set(*store, "c", "4");
+    store->remove("b");
+
+    remount();
+
+    CHECK_EQUAL(2, store->count());
+    STRCMP_EQUAL("3", get(*store, "a").c_str());
+    STRCMP_EQUAL("", get(*store, "b").c_str());
+    STRCMP_EQUAL("4", get(*store, "c").c_str());
+}
+
+TEST(kv_store, sectors_are_rotated)
+{
+    set(*store, "const", "kept");
+
+    for (int i = 0; i < 300; ++i) {
+        CHECK_EQUAL(ecl::err::ok, set(*store, "counter", value(i)));
+    }
+
+    STRCMP_EQUAL("kept", get(*store, "const").c_str());
+    STRCMP_EQUAL(value(299).c_str(), get(*store, "counter").c_str());
+
+    // Erases are spread evenly
+    for (size_t s = 1; s < flash_t::sectors; ++s) {
+        CHECK_TRUE(flash_t::erases(s) > 5);
+        CHECK_TRUE(flash_t::erases(s) + 1 >= flash_t::erases(0));
+        CHECK_TRUE(flash_t::erases(s) <= flash_t::erases(0) + 1);
+    }
+
+    remount();
+    STRCMP_EQUAL("kept", get(*store, "const").c_str());
+    STRCMP_EQUAL(value(299).c_str(), get(*store, "counter").c_str());
+}
+
+TEST(kv_store, no_space)
+{
+    std::string big(100, 'x');
+
+    CHECK_EQUAL(ecl::err::ok, set(*store, "a", big));
+    CHECK_EQUAL(ecl::err::ok, set(*store, "b", big));
+    CHECK_EQUAL(ecl::err::nospc, set(*store, "c", big));
+
+    // Store is still usable
+    CHECK_EQUAL(ecl::err::ok, store->remove("a"));
+    CHECK_EQUAL(ecl::err::ok, set(*store, "c", big));
+    STRCMP_EQUAL(big.c_str(), get(*store, "b").c_str());
+}
+
+TEST(kv_store, power_loss)
+{
+    for (size_t budget = 0; budget < 400; budget += 3) {
+        teardown();
+        setup();
+
+        set(*store, "const", "kept");
+
+        int committed = -1;
+        flash_t::lose_power_after(budget);
+
+        for (int i = 0; i < 100; ++i) {
+            if (is_error(set(*store, "counter", value(i)))) {
+                break;
+            }
+
+            committed = i;
+        }
+
+        remount();
+
+        // Last committed value or the one being written is in effect
+        STRCMP_EQUAL("kept", get(*store, "const").c_str());
+
+        auto v = get(*store, "counter");
+        if (committed < 0) {
+            CHECK_TRUE(v.empty() || v == value(0));
+        } else {
+            CHECK_TRUE(v == value(committed) || v == value(committed + 1));
+        }
+
+        // Store is usable after recovery
+        CHECK_EQUAL(ecl::err::ok, set(*store, "counter", "after"));
+        for (int i = 0; i < 50; ++i) {
+            CHECK_EQUAL(ecl::err::ok, set(*store, "other", value(i)));
+        }
+
+        remount();
+        STRCMP_EQUAL("after", get(*store, "counter").c_str());
+        STRCMP_EQUAL("kept", get(*store, "const").c_str());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
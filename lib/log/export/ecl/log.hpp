@@ -0,0 +1,341 @@
+#ifndef LIB_LOG_LOG_HPP_
+#define LIB_LOG_LOG_HPP_
+
+//!
+//! \file
+//! \brief Deferred logging.
+//! Caller only stores format string pointer and raw arguments into the
+//! lock-free queue. Formatting and slow console output are done later by
+//! a low-priority thread. Thus logging takes microseconds and can be used
+//! from hot paths and ISRs.
+//!
+
+#include <ecl/err.hpp>
+#include <ecl/thread/mpmc_queue.hpp>
+#include <ecl/thread/semaphore.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace ecl
+{
+
+//!
+//! \brief Argument of deferred log record.
+//!
+struct log_arg
+{
+    //! Kind of stored value.
+    enum class kind : uint8_t
+    {
+        sint,   //!< Signed integer.
+        uint,   //!< Unsigned integer.
+        chr,    //!< Character.
+        str,    //!< String with static storage duration.
+        ptr,    //!< Pointer, printed as hex.
+    };
+
+    kind    type;       //!< Value kind.
+    union
+    {
+        int32_t     s;
+        uint32_t    u;
+        char        c;
+        const char  *str;
+        const void  *ptr;
+    };
+};
+
+//! \cond INTERNAL
+namespace log_detail
+{
+
+template< class T >
+typename std::enable_if< std::is_integral< T >::value && std::is_signed< T >::value
+                         && !std::is_same< T, char >::value, log_arg >::type
+make_arg(T val)
+{
+    log_arg a; a.type = log_arg::kind::sint; a.s = val; return a;
+}
+
+template< class T >
+typename std::enable_if< std::is_integral< T >::value && std::is_unsigned< T >::value
+                         && !std::is_same< T, bool >::value, log_arg >::type
+make_arg(T val)
+{
+    log_arg a; a.type = log_arg::kind::uint; a.u = val; return a;
+}
+
+inline log_arg make_arg(bool val)
+{
+    log_arg a; a.type = log_arg::kind::uint; a.u = val; return a;
+}
+
+inline log_arg make_arg(char val)
+{
+    log_arg a; a.type = log_arg::kind::chr; a.c = val; return a;
+}
+
+inline log_arg make_arg(const char *val)
+{
+    log_arg a; a.type = log_arg::kind::str; a.str = val; return a;
+}
+
+inline log_arg make_arg(const void *val)
+{
+    log_arg a; a.type = log_arg::kind::ptr; a.ptr = val; return a;
+}
+
+template< class Stream >
+void put_hex(Stream &os, uintptr_t val)
+{
+    char digits[sizeof(val) * 2];
+    size_t n = 0;
+
+    do {
+        digits[n++] = "0123456789abcdef"[val & 0xf];
+        val >>= 4;
+    } while (val);
+
+    while (n) {
+        os << digits[--n];
+    }
+}
+
+} // namespace log_detail
+//! \endcond
+
+//!
+//! \brief Deferred logger.
+//! Supported conversions are %d, %i, %u, %x, %c, %s, %p and %%.
+//! Width and precision are not supported.
+//! \warning Strings are stored by pointer, so they must outlive the record.
+//!          String literals are fine, stack buffers are not.
+//! \tparam records  Maximum amount of pending records. Must be a power of two.
+//! \tparam max_args Maximum amount of arguments in a record.
+//! \par Example
+//! \code
+//! static ecl::deferred_log<> log;
+//!
+//! // Anywhere, including ISR
+//! log.write("rx overrun on %s, %u bytes lost\n", "usart2", lost);
+//!
+//! // In low-priority thread
+//! log.run(ecl::cout);
+//! \endcode
+//! Records are prefixed with time of write(), as "[seconds.micros] ", if
+//! clock is set. I.e. ecl::rtc::now_us() gives wall-clock time cheaply.
+//!
+template< size_t records = 32, size_t max_args = 4 >
+class deferred_log
+{
+public:
+    //! Source of record timestamps, in microseconds. Called by write(),
+    //! so it must be cheap and callable from ISR.
+    using clock_fn = uint64_t (*)();
+
+    deferred_log()
+        :m_queue{}
+        ,m_sem{}
+        ,m_dropped{0}
+        ,m_clock{nullptr}
+    {
+    }
+
+    //!
+    //! \brief Sets source of record timestamps.
+    //! Must be called before records are written.
+    //! \param[in] fn Clock, null to write records without timestamps.
+    //!
+    void set_clock(clock_fn fn) { m_clock = fn; }
+
+    //!
+    //! \brief Stores a record. Never blocks, can be called from ISR.
+    //! \param[in] fmt  Format string with static storage duration.
+    //! \param[in] args Values for conversions in the format string.
+    //! \retval err::nobufs Queue is full, record is dropped.
+    //! \retval err::ok     Record is queued.
+    //!
+    template< class... Args >
+    err write(const char *fmt, Args... args)
+    {
+        static_assert(sizeof...(args) <= max_args, "Too many log arguments");
+
+        record r;
+        r.stamp = m_clock ? m_clock() : no_stamp;
+        r.fmt = fmt;
+        r.nargs = sizeof...(args);
+        fill(r.args, args...);
+
+        if (!m_queue.push(r)) {
+            m_dropped++;
+            return err::nobufs;
+        }
+
+        m_sem.signal();
+        return err::ok;
+    }
+
+    //!
+    //! \brief Formats and outputs all pending records without blocking.
+    //! Cannot be called from ISR.
+    //! \param[in] os Output stream, i.e. ecl::cout.
+    //!
+    template< class Stream >
+    void drain(Stream &os)
+    {
+        record r;
+        bool any = false;
+
+        while (m_queue.pop(r)) {
+            format(os, r);
+            any = true;
+        }
+
+        auto lost = m_dropped.exchange(0);
+        if (lost) {
+            os << "<" << static_cast< unsigned >(lost) << " log records dropped>\n";
+        }
+
+        if (any || lost) {
+            os.flush();
+        }
+    }
+
+    //!
+    //! \brief Waits for records and outputs them. Runs forever.
+    //! Suitable as a body of low-priority logging thread.
+    //! \param[in] os Output stream, i.e. ecl::cout.
+    //!
+    template< class Stream >
+    void run(Stream &os)
+    {
+        for (;;) {
+            m_sem.wait();
+            drain(os);
+        }
+    }
+
+    //!
+    //! \brief Gets amount of records dropped since last drain().
+    //!
+    uint32_t dropped() const { return m_dropped.load(); }
+
+    deferred_log(const deferred_log&)             = delete;
+    deferred_log& operator=(const deferred_log&)  = delete;
+
+private:
+    //! Marks record written without clock.
+    static constexpr uint64_t no_stamp = UINT64_MAX;
+
+    struct record
+    {
+        uint64_t        stamp;
+        const char      *fmt;
+        log_arg         args[max_args ? max_args : 1];
+        uint8_t         nargs;
+    };
+
+    static void fill(log_arg *) { }
+
+    template< class T, class... Rest >
+    static void fill(log_arg *out, T val, Rest... rest)
+    {
+        *out = log_detail::make_arg(val);
+        fill(out + 1, rest...);
+    }
+
+    template< class Stream >
+    static void format(Stream &os, const record &r)
+    {
+        size_t next = 0;
+
+        if (r.stamp != no_stamp) {
+            put_stamp(os, r.stamp);
+        }
+
+        for (auto p = r.fmt; *p; ++p) {
+            if (*p != '%') {
+                os << *p;
+                continue;
+            }
+
+            auto conv = *++p;
+            if (!conv) {
+                break;
+            }
+
+            if (conv == '%') {
+                os << '%';
+                continue;
+            }
+
+            if (next >= r.nargs) {
+                // Missing argument is made visible, not skipped silently
+                os << "<?>";
+                continue;
+            }
+
+            put_arg(os, conv, r.args[next++]);
+        }
+    }
+
+    template< class Stream >
+    static void put_stamp(Stream &os, uint64_t us)
+    {
+        auto frac = static_cast< unsigned >(us % 1000000);
+
+        os << '[' << static_cast< unsigned >(us / 1000000) << '.';
+
+        for (unsigned div = 100000; div; div /= 10) {
+            os << static_cast< char >('0' + frac / div % 10);
+        }
+
+        os << "] ";
+    }
+
+    template< class Stream >
+    static void put_arg(Stream &os, char conv, const log_arg &a)
+    {
+        switch (a.type) {
+        case log_arg::kind::sint:
+            if (conv == 'x') {
+                log_detail::put_hex(os, static_cast< uint32_t >(a.s));
+            } else {
+                os << static_cast< int >(a.s);
+            }
+            break;
+        case log_arg::kind::uint:
+            if (conv == 'x') {
+                log_detail::put_hex(os, a.u);
+            } else {
+                os << static_cast< unsigned >(a.u);
+            }
+            break;
+        case log_arg::kind::chr:
+            os << a.c;
+            break;
+        case log_arg::kind::str:
+            os << (a.str ? a.str : "(null)");
+            break;
+        case log_arg::kind::ptr:
+            os << "0x";
+            log_detail::put_hex(os, reinterpret_cast< uintptr_t >(a.ptr));
+            break;
+        }
+    }
+
+    mpmc_queue< record, records >   m_queue;    //!< Pending records.
+    semaphore                       m_sem;      //!< Counts records.
+    std::atomic< uint32_t >         m_dropped;  //!< Records lost due to full queue.
+    clock_fn                        m_clock;    //!< Source of timestamps.
+};
+
+template< size_t records, size_t max_args >
+constexpr uint64_t deferred_log< records, max_args >::no_stamp;
+
+} // namespace ecl
+
+#endif // LIB_LOG_LOG_HPP_
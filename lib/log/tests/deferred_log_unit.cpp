@@ -0,0 +1,149 @@
+#include <ecl/log.hpp>
+
+#include <string>
+#include <thread>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Collects formatted output
+struct string_stream
+{
+    string_stream &operator<<(int val)          { out += std::to_string(val); return *this; }
+    string_stream &operator<<(unsigned val)     { out += std::to_string(val); return *this; }
+    string_stream &operator<<(char c)           { out += c; return *this; }
+    string_stream &operator<<(const char *str)  { out += str; return *this; }
+    void flush()                                { flushes++; }
+
+    std::string out;
+    int flushes = 0;
+};
+
+} // namespace
+
+TEST_GROUP(deferred_log)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(deferred_log, nothing_pending)
+{
+    ecl::deferred_log< 4 > log;
+    string_stream os;
+
+    log.drain(os);
+
+    STRCMP_EQUAL("", os.out.c_str());
+    CHECK_EQUAL(0, os.flushes);
+}
+
+TEST(deferred_log, conversions)
+{
+    ecl::deferred_log< 4, 6 > log;
+    string_stream os;
+    int local;
+
+    CHECK_EQUAL(ecl::err::ok, log.write("plain\n"));
+    CHECK_EQUAL(ecl::err::ok, log.write("%d %u %x %c %s 100%%\n",
+                                        -42, 42u, 0xbeefu, 'z', "str"));
+    CHECK_EQUAL(ecl::err::ok, log.write("%p\n", static_cast< const void* >(&local)));
+
+    // Nothing is formatted until drained
+    STRCMP_EQUAL("", os.out.c_str());
+
+    log.drain(os);
+
+    char ptr[32];
+    snprintf(ptr, sizeof(ptr), "%p", static_cast< void* >(&local));
+
+    auto expected = std::string{"plain\n-42 42 beef z str 100%\n"} + ptr + "\n";
+    STRCMP_EQUAL(expected.c_str(), os.out.c_str());
+    CHECK_EQUAL(1, os.flushes);
+}
+
+static uint64_t fake_clock()
+{
+    return 1700000000ULL * 1000000 + 42;
+}
+
+TEST(deferred_log, timestamps)
+{
+    ecl::deferred_log< 4 > log;
+    string_stream os;
+
+    log.set_clock(fake_clock);
+    log.write("stamped %u\n", 1u);
+    log.set_clock(nullptr);
+    log.write("plain\n");
+    log.drain(os);
+
+    STRCMP_EQUAL("[1700000000.000042] stamped 1\nplain\n", os.out.c_str());
+}
+
+TEST(deferred_log, missing_argument_is_visible)
+{
+    ecl::deferred_log< 4 > log;
+    string_stream os;
+
+    log.write("%d and %d\n", 1);
+    log.drain(os);
+
+    STRCMP_EQUAL("1 and <?>\n", os.out.c_str());
+}
+
+TEST(deferred_log, overflow_is_counted)
+{
+    ecl::deferred_log< 2 > log;
+    string_stream os;
+
+    CHECK_EQUAL(ecl::err::ok, log.write("a"));
+    CHECK_EQUAL(ecl::err::ok, log.write("b"));
+    CHECK_EQUAL(ecl::err::nobufs, log.write("c"));
+    CHECK_EQUAL(ecl::err::nobufs, log.write("d"));
+    CHECK_EQUAL(2, log.dropped());
+
+    log.drain(os);
+
+    STRCMP_EQUAL("ab<2 log records dropped>\n", os.out.c_str());
+    CHECK_EQUAL(0, log.dropped());
+}
+
+TEST(deferred_log, background_thread)
+{
+    ecl::deferred_log< 64 > log;
+    string_stream os;
+    constexpr int records = 32;
+
+    std::thread worker([&]() {
+        int seen = 0;
+        // Bounded version of run(), so test can finish
+        while (seen < records) {
+            auto before = os.out.size();
+            log.drain(os);
+            seen += os.out.size() - before;
+            std::this_thread::yield();
+        }
+    });
+
+    for (int i = 0; i < records; ++i) {
+        log.write("%c", 'x');
+    }
+
+    worker.join();
+
+    STRCMP_EQUAL(std::string(records, 'x').c_str(), os.out.c_str());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
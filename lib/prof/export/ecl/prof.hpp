@@ -0,0 +1,386 @@
+#ifndef LIB_PROF_PROF_HPP_
+#define LIB_PROF_PROF_HPP_
+
+//!
+//! \file
+//! \brief Hot path instrumentation.
+//! Code marks interesting scopes and events:
+//! \code
+//! int read_block(size_t n)
+//! {
+//!     ECL_TRACE_SCOPE("sd.read");
+//!     ECL_COUNTER("sd.read.blocks");
+//!     ...
+//! }
+//! \endcode
+//! Unless profiling is configured, macros expand to nothing, arguments are
+//! not evaluated and nothing is linked. Profiling is configured with
+//! CONFIG_PROF, which selects where scope entries and exits go:
+//!  - "ring" - timestamped into RAM rings, one per context. Rings are
+//!    turned into folded stacks on target by ecl::prof::fold().
+//!  - "itm" - written as single words to the ITM stimulus port,
+//!    timestamped by ITM itself. SWO capture is turned into folded stacks
+//!    on host by prof_fold tool.
+//! Folded stacks are the input of flame graph tools:
+//! \code
+//! $ flamegraph.pl stacks.txt > stacks.svg
+//! \endcode
+//! Counters are kept in RAM with both backends and printed by
+//! ecl::prof::report(). Each scope counts its entries as well.
+//!
+//! Times are in ticks of benchmark clock on ring backend, and in ticks of
+//! ITM timestamp counter on itm backend. On STM32F4 both are CPU cycles.
+//!
+
+#if defined(CONFIG_PROF_RING) || defined(CONFIG_PROF_ITM)
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef CONFIG_PROF_SITES
+//! Maximum amount of scopes and counters. Others are not profiled.
+#define CONFIG_PROF_SITES 64
+#endif
+
+#ifndef CONFIG_PROF_RINGS
+//! Amount of rings, i.e. contexts told apart. Power of two.
+#define CONFIG_PROF_RINGS 4
+#endif
+
+#ifndef CONFIG_PROF_RING_SIZE
+//! Events in each ring. Power of two. Older events are overwritten.
+#define CONFIG_PROF_RING_SIZE 256
+#endif
+
+#ifndef CONFIG_PROF_DEPTH
+//! Deepest nesting of scopes shown in folded stacks.
+#define CONFIG_PROF_DEPTH 16
+#endif
+
+#ifndef CONFIG_PROF_ITM_PORT
+//! ITM stimulus port used by itm backend. Port 0 is left for console.
+#define CONFIG_PROF_ITM_PORT 1
+#endif
+
+#include <ecl/prof/folder.hpp>
+
+namespace ecl
+{
+
+namespace prof
+{
+
+//!
+//! \brief Instrumented scope or counter. Created by the macros.
+//! Registered on the first use, when it gets its id.
+//!
+struct site
+{
+    constexpr site(const char *n) : name{n}, id{0}, count{0} { }
+
+    const char                  *name;  //!< Name, with static storage duration.
+    std::atomic< uint32_t >     id;     //!< Id, zero until registered.
+    std::atomic< uint32_t >     count;  //!< Entries of a scope, or counter value.
+};
+
+//!
+//! \brief Kinds of profiling events.
+//! Each event is a word: kind in bits 31:30, context in bits 29:24,
+//! payload in bits 23:0.
+//!
+enum class event : uint8_t
+{
+    enter,  //!< Scope is entered. Payload is site id.
+    leave,  //!< Scope is left. Payload is site id.
+    name,   //!< Site is registered. Payload is site id, name follows.
+    chars,  //!< Up to three characters of the name. Zero terminates name.
+};
+
+//! Makes event word.
+constexpr uint32_t make_word(event ev, uint8_t ctx, uint32_t payload)
+{
+    return (static_cast< uint32_t >(ev) << 30) | ((ctx & 0x3fUL) << 24)
+            | (payload & 0xffffff);
+}
+
+//!
+//! \brief Prepares the backend: starts clock or configures ITM port.
+//! Call once at startup. Sites are profiled from the first use anyway,
+//! but ITM output is discarded until the port is enabled.
+//!
+void init();
+
+//!
+//! \brief Drops all events and zeroes all counters.
+//! Sites stay registered.
+//!
+void reset();
+
+//!
+//! \brief Gets context of the caller. Each context has its own ring and
+//! its own stacks. Host builds tell threads apart by default. Target
+//! builds put everything into context 0, override this with weak linkage
+//! overriding function if several threads or ISRs are profiled.
+//!
+uint8_t context();
+
+//!
+//! \brief Gets registered site.
+//! \param[in] id Site id, 1 to sites().
+//! \return Site or nullptr if there is none.
+//!
+const site *find(uint32_t id);
+
+//!
+//! \brief Gets amount of registered sites.
+//!
+uint32_t sites();
+
+//!
+//! \brief Prints every counter, as "name value" lines.
+//!
+template< class Stream >
+void report(Stream &os);
+
+#ifdef CONFIG_PROF_RING
+//!
+//! \brief Single event of a ring.
+//!
+struct ring_event
+{
+    uint32_t    time;   //!< Timestamp.
+    uint32_t    word;   //!< Event word, see event.
+};
+
+//!
+//! \brief Ring of events of a single context.
+//!
+struct ring
+{
+    std::atomic< uint32_t >     head;                           //!< Events written ever.
+    ring_event                  events[CONFIG_PROF_RING_SIZE];  //!< Most recent events.
+};
+
+//!
+//! \brief Gets ring of the given context.
+//!
+const ring &ring_of(uint8_t ctx);
+
+//!
+//! \brief Prints surviving events of all rings as folded stacks:
+//! "ctx0;outer;inner ticks" lines, where ticks is time spent in the
+//! innermost scope itself. Same stacks are printed on separate lines,
+//! flame graph tools sum them.
+//! Scopes entered before the oldest surviving event are not shown.
+//! \pre Profiled code is idle, otherwise some stacks can be broken.
+//!
+template< class Stream >
+void fold(Stream &os);
+#endif // CONFIG_PROF_RING
+
+//! \cond INTERNAL
+namespace detail
+{
+
+//! Id of a site being registered.
+constexpr uint32_t claimed = 0xffffffff;
+
+//! Registers the site. Returns its id or zero if it can't be registered.
+uint32_t attach(site &s);
+
+//! Sends event to the backend.
+void emit(event ev, uint32_t id);
+
+//! Informs the backend about new site.
+void announce(const site &s, uint32_t id);
+
+//! Gets id of the site, registering it if required.
+inline uint32_t id_of(site &s)
+{
+    auto id = s.id.load(std::memory_order_acquire);
+    return (id && id != claimed) ? id : attach(s);
+}
+
+template< class Stream >
+void print(Stream &os, uint32_t val)
+{
+    char digits[10];
+    size_t n = 0;
+
+    do {
+        digits[n++] = '0' + val % 10;
+        val /= 10;
+    } while (val);
+
+    while (n) {
+        os << digits[--n];
+    }
+}
+
+} // namespace detail
+//! \endcond
+
+//!
+//! \brief Emits entry and exit events of the enclosing scope.
+//!
+class scope
+{
+public:
+    explicit scope(site &s)
+        :m_id{detail::id_of(s)}
+    {
+        s.count.fetch_add(1, std::memory_order_relaxed);
+
+        if (m_id) {
+            detail::emit(event::enter, m_id);
+        }
+    }
+
+    ~scope()
+    {
+        if (m_id) {
+            detail::emit(event::leave, m_id);
+        }
+    }
+
+    scope(const scope &) = delete;
+    scope &operator=(const scope &) = delete;
+
+private:
+    uint32_t m_id;
+};
+
+//!
+//! \brief Adds value to the counter.
+//!
+inline void count(site &s, uint32_t n)
+{
+    s.count.fetch_add(n, std::memory_order_relaxed);
+
+    // Counter must be registered to be reported
+    if (!s.id.load(std::memory_order_relaxed)) {
+        detail::attach(s);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template< class Stream >
+void report(Stream &os)
+{
+    for (uint32_t id = 1; id <= sites(); ++id) {
+        auto s = find(id);
+        if (!s) {
+            continue;
+        }
+
+        os << s->name << ' ';
+        detail::print(os, s->count.load(std::memory_order_relaxed));
+        os << '\n';
+    }
+}
+
+#ifdef CONFIG_PROF_RING
+template< class Stream >
+void fold(Stream &os)
+{
+    for (uint8_t ctx = 0; ctx < CONFIG_PROF_RINGS; ++ctx) {
+        auto &r = ring_of(ctx);
+        uint32_t head = r.head.load(std::memory_order_acquire);
+        uint32_t first = head > CONFIG_PROF_RING_SIZE ? head - CONFIG_PROF_RING_SIZE : 0;
+
+        folder< CONFIG_PROF_DEPTH > f;
+
+        auto out = [&os, ctx](const uint32_t *ids, size_t n, uint32_t self) {
+            os << "ctx";
+            detail::print(os, ctx);
+
+            for (size_t i = 0; i < n; ++i) {
+                auto s = find(ids[i]);
+                os << ';' << (s ? s->name : "?");
+            }
+
+            os << ' ';
+            detail::print(os, self);
+            os << '\n';
+        };
+
+        for (uint32_t seq = first; seq != head; ++seq) {
+            auto &e = r.events[seq & (CONFIG_PROF_RING_SIZE - 1)];
+            auto ev = static_cast< event >(e.word >> 30);
+            uint32_t id = e.word & 0xffffff;
+
+            if (ev == event::enter) {
+                f.enter(id, e.time);
+            } else if (ev == event::leave) {
+                f.leave(id, e.time, out);
+            }
+        }
+    }
+}
+#endif // CONFIG_PROF_RING
+
+} // namespace prof
+
+} // namespace ecl
+
+//! \cond INTERNAL
+#define ECL_PROF_CONCAT_(a, b) a##b
+#define ECL_PROF_CONCAT(a, b) ECL_PROF_CONCAT_(a, b)
+#define ECL_PROF_SITE ECL_PROF_CONCAT(ecl_prof_site_, __LINE__)
+//! \endcond
+
+//!
+//! \brief Profiles the rest of the enclosing scope.
+//! \param[in] name Scope name, string literal. Scopes with same name are merged.
+//!
+#define ECL_TRACE_SCOPE(name) \
+    static ecl::prof::site ECL_PROF_SITE{name}; \
+    ecl::prof::scope ECL_PROF_CONCAT(ecl_prof_scope_, __LINE__){ECL_PROF_SITE}
+
+//!
+//! \brief Increments the counter.
+//! \param[in] name Counter name, string literal.
+//!
+#define ECL_COUNTER(name) ECL_COUNTER_ADD(name, 1)
+
+//!
+//! \brief Adds value to the counter.
+//! \param[in] name Counter name, string literal.
+//! \param[in] n    Value to add. Not evaluated if profiling is disabled.
+//!
+#define ECL_COUNTER_ADD(name, n) \
+    do { \
+        static ecl::prof::site ECL_PROF_SITE{name}; \
+        ecl::prof::count(ECL_PROF_SITE, (n)); \
+    } while (0)
+
+#else // Profiling is disabled
+
+namespace ecl
+{
+
+namespace prof
+{
+
+inline void init() { }
+inline void reset() { }
+
+template< class Stream >
+void report(Stream &) { }
+
+template< class Stream >
+void fold(Stream &) { }
+
+} // namespace prof
+
+} // namespace ecl
+
+#define ECL_TRACE_SCOPE(name) ((void) 0)
+#define ECL_COUNTER(name) ((void) 0)
+#define ECL_COUNTER_ADD(name, n) ((void) sizeof(n))
+
+#endif
+
+#endif // LIB_PROF_PROF_HPP_
@@ -0,0 +1,113 @@
+#ifndef LIB_PROF_FOLDER_HPP_
+#define LIB_PROF_FOLDER_HPP_
+
+//!
+//! \file
+//! \brief Turns scope entries and exits of a single context into folded
+//! stacks. Shared by on-target folding and by host tools.
+//!
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+namespace prof
+{
+
+//!
+//! \brief Tracks stack of scopes and measures their own time.
+//! Timestamps are 32-bit, so any scope must be shorter than clock period.
+//! \tparam depth Deepest stack kept. Deeper scopes are not shown, their
+//!               time is accounted to the deepest kept scope.
+//!
+template< size_t depth >
+class folder
+{
+public:
+    folder() = default;
+
+    //!
+    //! \brief Accounts scope entry.
+    //! \param[in] id   Site id.
+    //! \param[in] time Timestamp of the entry.
+    //!
+    void enter(uint32_t id, uint32_t time);
+
+    //!
+    //! \brief Accounts scope exit. Exit of scope which entry was not seen,
+    //! i.e. happened before the trace start, is ignored.
+    //! \param[in] id   Site id.
+    //! \param[in] time Timestamp of the exit.
+    //! \param[in] out  Called with stack of site ids, outermost first,
+    //!                 stack size and time spent in the left scope itself.
+    //!
+    template< class Fn >
+    void leave(uint32_t id, uint32_t time, Fn &&out);
+
+    //! Gets current depth of the stack, including scopes not kept.
+    size_t level() const { return m_level; }
+
+private:
+    struct frame
+    {
+        uint32_t start;     //!< Entry time.
+        uint32_t children;  //!< Time spent in nested scopes.
+    };
+
+    uint32_t    m_ids[depth] = {};      //!< Kept stack.
+    frame       m_frames[depth] = {};   //!< Timing of kept stack.
+    size_t      m_level = 0;            //!< Stack depth.
+};
+
+//------------------------------------------------------------------------------
+
+template< size_t depth >
+void folder< depth >::enter(uint32_t id, uint32_t time)
+{
+    if (m_level < depth) {
+        m_ids[m_level] = id;
+        m_frames[m_level] = frame{ time, 0 };
+    }
+
+    ++m_level;
+}
+
+template< size_t depth >
+template< class Fn >
+void folder< depth >::leave(uint32_t id, uint32_t time, Fn &&out)
+{
+    if (!m_level) {
+        return;
+    }
+
+    --m_level;
+
+    if (m_level >= depth) {
+        return;
+    }
+
+    if (m_ids[m_level] != id) {
+        // Events are lost, i.e. overwritten in the middle of the stack.
+        // Nothing is known for sure, start over.
+        m_level = 0;
+        return;
+    }
+
+    auto &f = m_frames[m_level];
+    uint32_t total = time - f.start;
+
+    out(static_cast< const uint32_t * >(m_ids), m_level + 1,
+        total > f.children ? total - f.children : 0);
+
+    if (m_level) {
+        m_frames[m_level - 1].children += total;
+    }
+}
+
+} // namespace prof
+
+} // namespace ecl
+
+#endif // LIB_PROF_FOLDER_HPP_
@@ -0,0 +1,80 @@
+// ITM backend: every event is a single word written to the stimulus port,
+// so events of different contexts interleave only by whole words.
+// Timestamps are appended by ITM as local timestamp packets.
+
+#include <ecl/prof.hpp>
+#include <platform/itm.hpp>
+
+namespace ecl
+{
+
+namespace prof
+{
+
+namespace
+{
+
+using port = itm_console< CONFIG_PROF_ITM_PORT >;
+
+void put(uint32_t word)
+{
+    port{}.write(reinterpret_cast< const uint8_t * >(&word), sizeof(word));
+}
+
+} // namespace
+
+void init()
+{
+    port{}.init();
+
+    // Timestamps are clocked by the CPU clock, no prescaling
+    ITM->TCR = (ITM->TCR & ~ITM_TCR_TSPrescale_Msk) | ITM_TCR_TSENA_Msk;
+}
+
+void reset()
+{
+    for (uint32_t id = 1; id <= sites(); ++id) {
+        auto s = const_cast< site * >(find(id));
+        if (s) {
+            s->count.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+namespace detail
+{
+
+void emit(event ev, uint32_t id)
+{
+    put(make_word(ev, context(), id));
+}
+
+void announce(const site &s, uint32_t id)
+{
+    auto ctx = context();
+
+    // Names are sent once, decoder keeps them. Chunks are sent until
+    // the one holding terminating zero.
+    put(make_word(event::name, ctx, id));
+
+    const char *p = s.name;
+    bool end = false;
+
+    while (!end) {
+        uint32_t chunk = 0;
+
+        for (int i = 0; i < 3; ++i) {
+            uint32_t c = end ? 0 : static_cast< uint8_t >(*p++);
+            end = end || !c;
+            chunk |= c << (8 * i);
+        }
+
+        put(make_word(event::chars, ctx, chunk));
+    }
+}
+
+} // namespace detail
+
+} // namespace prof
+
+} // namespace ecl
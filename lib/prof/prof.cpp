@@ -0,0 +1,91 @@
+// Site registry, common for all backends.
+// Built only when profiling is configured, see CMakeLists.txt.
+
+#include <ecl/prof.hpp>
+
+namespace ecl
+{
+
+namespace prof
+{
+
+namespace
+{
+
+site *registry[CONFIG_PROF_SITES];
+std::atomic< uint32_t > registered{0};
+
+} // namespace
+
+namespace detail
+{
+
+uint32_t attach(site &s)
+{
+    uint32_t id = 0;
+
+    // Someone else is registering the site right now. It can be preempted
+    // by this very caller, so event is dropped rather than waited for.
+    if (!s.id.compare_exchange_strong(id, claimed, std::memory_order_acquire)) {
+        return id == claimed ? 0 : id;
+    }
+
+    id = registered.load(std::memory_order_relaxed);
+
+    do {
+        if (id >= CONFIG_PROF_SITES) {
+            // Out of space, site stays claimed and is never profiled
+            return 0;
+        }
+    } while (!registered.compare_exchange_weak(id, id + 1, std::memory_order_relaxed));
+
+    registry[id] = &s;
+    s.id.store(id + 1, std::memory_order_release);
+
+    announce(s, id + 1);
+
+    return id + 1;
+}
+
+} // namespace detail
+
+const site *find(uint32_t id)
+{
+    if (!id || id > sites()) {
+        return nullptr;
+    }
+
+    auto s = registry[id - 1];
+
+    // Slot is reserved before the site is stored
+    return (s && s->id.load(std::memory_order_acquire) == id) ? s : nullptr;
+}
+
+uint32_t sites()
+{
+    return registered.load(std::memory_order_acquire);
+}
+
+#if __STDC_HOSTED__
+// Threads are told apart on host, in order of their first event
+
+__attribute__((weak)) uint8_t context()
+{
+    static std::atomic< uint8_t > next{0};
+    thread_local uint8_t ctx = next.fetch_add(1, std::memory_order_relaxed);
+
+    return ctx;
+}
+#else
+// Target has no thread-local storage. Platform or application knows its
+// contexts better, e.g. ISR number or task tag, and overrides this.
+
+__attribute__((weak)) uint8_t context()
+{
+    return 0;
+}
+#endif
+
+} // namespace prof
+
+} // namespace ecl
@@ -0,0 +1,76 @@
+// Ring backend: events are timestamped into RAM, a ring per context.
+// Each ring has single writer, its context, so no atomic RMW is needed.
+
+#include <ecl/prof.hpp>
+#include <ecl/bench/clock.hpp>
+
+namespace ecl
+{
+
+namespace prof
+{
+
+static_assert(CONFIG_PROF_RINGS && !(CONFIG_PROF_RINGS & (CONFIG_PROF_RINGS - 1)),
+              "Amount of rings must be power of two");
+static_assert(CONFIG_PROF_RING_SIZE && !(CONFIG_PROF_RING_SIZE & (CONFIG_PROF_RING_SIZE - 1)),
+              "Ring size must be power of two");
+
+namespace
+{
+
+ring rings[CONFIG_PROF_RINGS];
+
+} // namespace
+
+void init()
+{
+    bench::clock::init();
+}
+
+void reset()
+{
+    for (auto &r : rings) {
+        r.head.store(0, std::memory_order_relaxed);
+    }
+
+    for (uint32_t id = 1; id <= sites(); ++id) {
+        auto s = const_cast< site * >(find(id));
+        if (s) {
+            s->count.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+const ring &ring_of(uint8_t ctx)
+{
+    return rings[ctx & (CONFIG_PROF_RINGS - 1)];
+}
+
+namespace detail
+{
+
+void emit(event ev, uint32_t id)
+{
+    auto ctx = context();
+    auto &r = rings[ctx & (CONFIG_PROF_RINGS - 1)];
+    auto head = r.head.load(std::memory_order_relaxed);
+    auto &e = r.events[head & (CONFIG_PROF_RING_SIZE - 1)];
+
+    e.time = static_cast< uint32_t >(bench::clock::now());
+    e.word = make_word(ev, ctx, id);
+
+    r.head.store(head + 1, std::memory_order_release);
+}
+
+void announce(const site &s, uint32_t id)
+{
+    // Names are looked up in the registry while folding
+    (void) s;
+    (void) id;
+}
+
+} // namespace detail
+
+} // namespace prof
+
+} // namespace ecl
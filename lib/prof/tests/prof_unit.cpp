@@ -0,0 +1,189 @@
+#include <ecl/prof.hpp>
+
+#include <string>
+#include <thread>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+// Collects output of fold() and report()
+struct text
+{
+    std::string str = {};
+
+    text &operator<<(char c) { str += c; return *this; }
+    text &operator<<(const char *s) { str += s; return *this; }
+
+    bool has(const std::string &line) const
+    {
+        return str.find(line) != std::string::npos;
+    }
+};
+
+static void inner()
+{
+    ECL_TRACE_SCOPE("inner");
+}
+
+static void outer()
+{
+    ECL_TRACE_SCOPE("outer");
+    inner();
+    inner();
+}
+
+static std::string ctx_name()
+{
+    return "ctx" + std::to_string(ecl::prof::context());
+}
+
+TEST_GROUP(prof)
+{
+    void setup()
+    {
+        ecl::prof::init();
+        ecl::prof::reset();
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(prof, scopes_are_folded)
+{
+    outer();
+
+    text t;
+    ecl::prof::fold(t);
+
+    auto ctx = ctx_name();
+
+    // One line per exit
+    CHECK_TRUE(t.has(ctx + ";outer;inner "));
+    CHECK_TRUE(t.has(ctx + ";outer "));
+    CHECK_FALSE(t.has(ctx + ";inner "));
+
+    size_t lines = 0;
+    for (auto c : t.str) {
+        lines += c == '\n';
+    }
+
+    CHECK_EQUAL(3, lines);
+}
+
+TEST(prof, entries_and_counters_are_reported)
+{
+    outer();
+
+    for (int i = 0; i < 3; ++i) {
+        ECL_COUNTER("hits");
+        ECL_COUNTER_ADD("bytes", 512);
+    }
+
+    text t;
+    ecl::prof::report(t);
+
+    CHECK_TRUE(t.has("outer 1\n"));
+    CHECK_TRUE(t.has("inner 2\n"));
+    CHECK_TRUE(t.has("hits 3\n"));
+    CHECK_TRUE(t.has("bytes 1536\n"));
+}
+
+TEST(prof, events_are_recorded_in_order)
+{
+    auto &r = ecl::prof::ring_of(ecl::prof::context());
+
+    outer();
+
+    CHECK_EQUAL(6, r.head.load());
+
+    uint32_t prev = r.events[0].time;
+    for (uint32_t i = 1; i < 6; ++i) {
+        CHECK_TRUE(r.events[i].time - prev < 0x80000000);
+        prev = r.events[i].time;
+    }
+
+    auto kind = [&r](uint32_t i) {
+        return static_cast< ecl::prof::event >(r.events[i].word >> 30);
+    };
+
+    CHECK_TRUE(kind(0) == ecl::prof::event::enter);
+    CHECK_TRUE(kind(1) == ecl::prof::event::enter);
+    CHECK_TRUE(kind(2) == ecl::prof::event::leave);
+    CHECK_TRUE(kind(5) == ecl::prof::event::leave);
+
+    // Both events of outer scope point to the same site
+    CHECK_EQUAL(r.events[0].word & 0xffffff, r.events[5].word & 0xffffff);
+    STRCMP_EQUAL("outer", ecl::prof::find(r.events[0].word & 0xffffff)->name);
+}
+
+TEST(prof, overwritten_scopes_are_skipped)
+{
+    {
+        ECL_TRACE_SCOPE("long");
+
+        // Entry of the long scope is overwritten
+        for (int i = 0; i < CONFIG_PROF_RING_SIZE; ++i) {
+            inner();
+        }
+    }
+
+    text t;
+    ecl::prof::fold(t);
+
+    CHECK_FALSE(t.has(";long"));
+    CHECK_TRUE(t.has(ctx_name() + ";inner "));
+}
+
+TEST(prof, threads_have_own_stacks)
+{
+    std::string ctx;
+
+    std::thread th{[&ctx] {
+        ctx = ctx_name();
+        outer();
+    }};
+    th.join();
+
+    inner();
+
+    CHECK_TRUE(ctx != ctx_name());
+
+    text t;
+    ecl::prof::fold(t);
+
+    CHECK_TRUE(t.has(ctx + ";outer;inner "));
+    CHECK_TRUE(t.has(ctx_name() + ";inner "));
+}
+
+TEST(prof, folder_accounts_own_time)
+{
+    ecl::prof::folder< 2 > f;
+    std::string out;
+
+    auto collect = [&out](const uint32_t *ids, size_t n, uint32_t self) {
+        for (size_t i = 0; i < n; ++i) {
+            out += std::to_string(ids[i]) + (i + 1 < n ? ";" : "");
+        }
+        out += " " + std::to_string(self) + "\n";
+    };
+
+    f.enter(1, 0);
+    f.enter(2, 10);
+    f.enter(3, 12);     // Too deep, accounted to 2
+    f.leave(3, 15, collect);
+    f.leave(2, 30, collect);
+    f.leave(1, 100, collect);
+
+    // Exit without entry is ignored
+    f.leave(4, 110, collect);
+
+    STRCMP_EQUAL("1;2 20\n1 80\n", out.c_str());
+    CHECK_EQUAL(0, f.level());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
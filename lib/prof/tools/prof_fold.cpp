@@ -0,0 +1,245 @@
+// Turns SWO capture of itm profiling backend into folded stacks,
+// see ecl/prof.hpp.
+//
+// Input is raw ITM stream, as written by OpenOCD or orbuculum, with
+// formatter bypassed. Words of the profiling port are decoded, other ports
+// and hardware packets are skipped. Events are timed by ITM local
+// timestamps, so timestamps must be enabled, as ecl::prof::init() does.
+// Output is a line per distinct stack, with total time spent in its
+// innermost scope itself, in timestamp ticks:
+//
+//   prof_fold [-p port] swo.bin > stacks.txt
+//   flamegraph.pl stacks.txt > stacks.svg
+//
+// Counters are not in the stream, use ecl::prof::report() on target.
+
+// Only layout of events is needed, backend itself is not linked
+#define CONFIG_PROF_ITM
+#include <ecl/prof.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using namespace ecl::prof;
+
+// Deeper stacks are rare on target, this merely bounds the memory
+constexpr size_t max_depth = 64;
+
+constexpr unsigned contexts = 64;
+
+struct decoder
+{
+    uint32_t                        port;
+    uint64_t                        now = 0;
+    std::map< uint32_t, std::string > names;
+    std::map< std::string, uint64_t > stacks;
+
+    // Words of the port waiting for the next timestamp
+    std::vector< uint32_t >         pending = {};
+
+    // Names being received, per context
+    std::string                     partial[contexts] = {};
+    uint32_t                        partial_id[contexts] = {};
+
+    folder< max_depth >             folders[contexts] = {};
+    unsigned                        lost = 0;
+
+    explicit decoder(uint32_t p) : port{p}, names{}, stacks{} { }
+
+    std::string name_of(uint32_t id) const
+    {
+        auto it = names.find(id);
+        return it != names.end() ? it->second : "site" + std::to_string(id);
+    }
+
+    void word(uint32_t w)
+    {
+        auto ev = static_cast< event >(w >> 30);
+        uint32_t ctx = (w >> 24) & 0x3f;
+        uint32_t payload = w & 0xffffff;
+
+        switch (ev) {
+        case event::enter:
+            folders[ctx].enter(payload, now);
+            break;
+
+        case event::leave:
+            // Stacks are kept as ids, names may arrive later
+            folders[ctx].leave(payload, now,
+                               [this, ctx](const uint32_t *ids, size_t n, uint32_t self) {
+                std::string key = "ctx" + std::to_string(ctx);
+                for (size_t i = 0; i < n; ++i) {
+                    key += ';';
+                    key += std::to_string(ids[i]);
+                }
+                stacks[key] += self;
+            });
+            break;
+
+        case event::name:
+            partial_id[ctx] = payload;
+            partial[ctx].clear();
+            break;
+
+        case event::chars:
+            for (int i = 0; i < 3; ++i) {
+                char c = (payload >> (8 * i)) & 0xff;
+                if (!c) {
+                    names[partial_id[ctx]] = partial[ctx];
+                    break;
+                }
+                partial[ctx] += c;
+            }
+            break;
+        }
+    }
+
+    // Timestamp is emitted after the packets it stamps
+    void timestamp(uint64_t delta)
+    {
+        now += delta;
+
+        for (auto w : pending) {
+            word(w);
+        }
+
+        pending.clear();
+    }
+
+    void decode(const std::vector< uint8_t > &in)
+    {
+        size_t i = 0;
+
+        while (i < in.size()) {
+            uint8_t h = in[i++];
+
+            if (h == 0x00 || h == 0x80) {
+                // Synchronization packet: zeros followed by 0x80
+                continue;
+            }
+
+            if (h == 0x70) {
+                // ITM FIFO overflowed, packets are lost
+                ++lost;
+                continue;
+            }
+
+            if (h & 0x03) {
+                // Source packet: instrumentation or hardware
+                size_t size = (h & 0x03) == 3 ? 4 : (h & 0x03);
+                bool hw = h & 0x04;
+                uint32_t p = h >> 3;
+
+                if (i + size > in.size()) {
+                    break;
+                }
+
+                uint32_t val = 0;
+                for (size_t b = 0; b < size; ++b) {
+                    val |= static_cast< uint32_t >(in[i + b]) << (8 * b);
+                }
+                i += size;
+
+                if (!hw && p == port && size == 4) {
+                    pending.push_back(val);
+                }
+                continue;
+            }
+
+            if ((h & 0x0f) == 0) {
+                // Local timestamp. Value is either in header itself,
+                // or in continuation bytes that follow.
+                if (!(h & 0x80)) {
+                    timestamp((h >> 4) & 0x07);
+                    continue;
+                }
+
+                uint64_t delta = 0;
+                unsigned shift = 0;
+
+                while (i < in.size()) {
+                    uint8_t b = in[i++];
+                    delta |= static_cast< uint64_t >(b & 0x7f) << shift;
+                    shift += 7;
+                    if (!(b & 0x80)) {
+                        break;
+                    }
+                }
+
+                timestamp(delta);
+                continue;
+            }
+
+            // Global timestamps and extension packets, skipped
+            if (h & 0x80) {
+                while (i < in.size() && (in[i++] & 0x80)) { }
+            }
+        }
+
+        // Words after the last timestamp
+        timestamp(0);
+    }
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    uint32_t port = CONFIG_PROF_ITM_PORT;
+    int arg = 1;
+
+    if (argc > 2 && !strcmp(argv[1], "-p")) {
+        port = strtoul(argv[2], nullptr, 0);
+        arg = 3;
+    }
+
+    if (arg + 1 != argc || port > 31) {
+        fprintf(stderr, "Usage: %s [-p port] swo.bin\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream in{argv[arg], std::ios::binary};
+    if (!in) {
+        fprintf(stderr, "Can't open %s\n", argv[arg]);
+        return 1;
+    }
+
+    std::vector< uint8_t > data{std::istreambuf_iterator< char >{in},
+                                std::istreambuf_iterator< char >{}};
+
+    decoder d{port};
+    d.decode(data);
+
+    if (d.lost) {
+        fprintf(stderr, "ITM overflowed %u times, some stacks are broken\n", d.lost);
+    }
+
+    for (auto &it : d.stacks) {
+        // Replace ids with names, context prefix is kept
+        auto &key = it.first;
+        auto pos = key.find(';');
+        std::string line = key.substr(0, pos);
+
+        while (pos != std::string::npos) {
+            auto next = key.find(';', pos + 1);
+            auto id = key.substr(pos + 1, next == std::string::npos ? next : next - pos - 1);
+
+            line += ';';
+            line += d.name_of(strtoul(id.c_str(), nullptr, 10));
+            pos = next;
+        }
+
+        printf("%s %llu\n", line.c_str(), static_cast< unsigned long long >(it.second));
+    }
+
+    return 0;
+}
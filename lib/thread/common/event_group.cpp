@@ -0,0 +1,88 @@
+#include <ecl/thread/common/event_group.hpp>
+#include <ecl/thread/common/semaphore.hpp>
+#include "wait_change.hpp"
+
+void ecl::common::event_group::set(bits_type bits)
+{
+    m_bits.fetch_or(static_cast< int >(bits));
+
+    // Waiter registers itself before it checks the mask,
+    // so either it sees new bits or it is woken here
+    if (m_waiters.load()) {
+        notify_change(m_bits);
+    }
+}
+
+void ecl::common::event_group::clear(bits_type bits)
+{
+    m_bits.fetch_and(~static_cast< int >(bits));
+}
+
+ecl::common::event_group::bits_type ecl::common::event_group::get() const
+{
+    return static_cast< bits_type >(m_bits.load());
+}
+
+ecl::common::event_group::bits_type
+ecl::common::event_group::wait(bits_type bits, bool all)
+{
+    bits_type got = 0;
+    int seen = 0;
+
+    while (!take(bits, all, got, seen)) {
+        sleep(seen, -1);
+    }
+
+    return got;
+}
+
+ecl::err ecl::common::event_group::wait_for(bits_type bits, uint32_t msecs,
+                                            bits_type &got, bool all)
+{
+    auto deadline = get_ticks() + msecs;
+    int seen = 0;
+
+    while (!take(bits, all, got, seen)) {
+        // Difference is signed to survive tick wrap
+        auto left = static_cast< int32_t >(deadline - get_ticks());
+        if (left <= 0) {
+            return err::timedout;
+        }
+
+        sleep(seen, left);
+    }
+
+    return err::ok;
+}
+
+bool ecl::common::event_group::take(bits_type bits, bool all, bits_type &got, int &seen)
+{
+    int cur = m_bits.load();
+
+    for (;;) {
+        auto match = static_cast< bits_type >(cur) & bits;
+
+        if (all ? match != bits : !match) {
+            seen = cur;
+            return false;
+        }
+
+        if (m_bits.compare_exchange_weak(cur, cur & ~static_cast< int >(match))) {
+            got = match;
+            return true;
+        }
+    }
+}
+
+void ecl::common::event_group::sleep(int seen, int32_t msecs)
+{
+    m_waiters++;
+
+    // Bits set after the mask was checked change its value,
+    // the waiter won't sleep then
+    if (m_bits.load() == seen) {
+        wait_change(m_bits, seen, msecs);
+    }
+
+    m_waiters--;
+}
@@ -0,0 +1,62 @@
+#ifndef LIB_THREAD_COMMON_EVENT_GROUP_
+#define LIB_THREAD_COMMON_EVENT_GROUP_
+
+#include <ecl/err.hpp>
+
+#include <atomic>
+#include <cstdint>
+
+namespace ecl
+{
+
+namespace common
+{
+
+// Set of event bits, that a single thread can wait on at once.
+// Bits are kept in an atomic mask. Waiter sleeps with WFE on ARM or
+// blocks on a futex on host, same as semaphore does.
+class event_group
+{
+public:
+    using bits_type = uint32_t;
+
+    constexpr event_group()
+        :m_bits{0}, m_waiters{0} { }
+
+    // Sets given bits and wakes up waiters. Can be called from ISR.
+    void set(bits_type bits);
+
+    // Clears given bits.
+    void clear(bits_type bits);
+
+    // Gets current bits.
+    bits_type get() const;
+
+    // Waits until any (or all, if requested) of given bits are set.
+    // Clears awaited bits, that are set, and returns them.
+    bits_type wait(bits_type bits, bool all = false);
+
+    // Same as wait(), but waits given amount of milliseconds.
+    // Returns err::timedout if bits were not set in time.
+    ecl::err wait_for(bits_type bits, uint32_t msecs, bits_type &got, bool all = false);
+
+    event_group(const event_group&)             = delete;
+    event_group& operator=(const event_group&)  = delete;
+
+private:
+    // Clears awaited bits if wait condition is met.
+    // Otherwise saves observed mask in seen.
+    bool take(bits_type bits, bool all, bits_type &got, int &seen);
+
+    // Sleeps until mask differs from seen one, or given time is elapsed
+    void sleep(int seen, int32_t msecs);
+
+    std::atomic_int m_bits;     // Event mask
+    std::atomic_int m_waiters;  // Threads sleeping on the mask
+};
+
+}
+
+}
+
+#endif // LIB_THREAD_COMMON_EVENT_GROUP_
@@ -0,0 +1,303 @@
+#ifndef LIB_THREAD_COMMON_FUTURE_
+#define LIB_THREAD_COMMON_FUTURE_
+
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ecl
+{
+
+namespace common
+{
+
+template< class T, class Event >
+class future;
+
+template< class T, class Event >
+class promise;
+
+// State shared between promise and future. Holds a value or an error.
+// State doesn't allocate. By default it lives inside a promise, but it
+// can be placed anywhere by the user, i.e. in static memory or in
+// an object pool, and then passed to the promise.
+// Event must provide signal(), wait(), wait_for() and try_wait(),
+// i.e. ecl::completion or ecl::semaphore.
+template< class T, class Event >
+class future_state
+{
+public:
+    // Continuation. Value is null if error is reported.
+    using callback = std::function< void(ecl::err status, T *value) >;
+
+    future_state()
+        :m_storage{}
+        ,m_flags{0}
+        ,m_status{ecl::err::ok}
+        ,m_event{}
+        ,m_callback{}
+    {
+    }
+
+    ~future_state()
+    {
+        destroy_value();
+    }
+
+    // Prepares state for next use.
+    // Neither promise nor future must use the state at this moment.
+    void reset()
+    {
+        destroy_value();
+        m_callback = callback{};
+        m_event.try_wait();
+        m_flags = 0;
+    }
+
+    future_state(const future_state&)             = delete;
+    future_state& operator=(const future_state&)  = delete;
+
+private:
+    friend class future< T, Event >;
+    friend class promise< T, Event >;
+
+    // Flags
+    static constexpr uint8_t claimed    = 0x1; // Result is being set
+    static constexpr uint8_t ready      = 0x2; // Result is set
+    static constexpr uint8_t chained    = 0x4; // Continuation is set
+    static constexpr uint8_t has_value  = 0x8; // Value is constructed
+
+    T *value() { return reinterpret_cast< T * >(&m_storage); }
+
+    void destroy_value()
+    {
+        if (m_flags.load() & has_value) {
+            value()->~T();
+            m_flags &= ~has_value;
+        }
+    }
+
+    // Claims right to set the result. Only first claim succeeds.
+    bool claim()
+    {
+        return !(m_flags.fetch_or(claimed) & claimed);
+    }
+
+    // Publishes the result and wakes up the waiter
+    void publish()
+    {
+        auto prev = m_flags.fetch_or(ready);
+
+        // Continuation is executed by whoever comes last:
+        // either by the producer or by the one who sets the callback
+        if (prev & chained) {
+            run_callback();
+        }
+
+        m_event.signal();
+    }
+
+    void run_callback()
+    {
+        auto val = is_error(m_status) ? nullptr : value();
+        m_callback(m_status, val);
+    }
+
+    using storage = typename std::aligned_storage< sizeof(T), alignof(T) >::type;
+
+    storage                 m_storage;  // Value, if any
+    std::atomic< uint8_t >  m_flags;    // State flags
+    ecl::err                m_status;   // Error, if any
+    Event                   m_event;    // Signalled when result is ready
+    callback                m_callback; // Continuation, if any
+};
+
+// Consumer side of the shared state.
+// Future is a lightweight handle and can be copied, but only one thread
+// may wait on it at a time.
+template< class T, class Event >
+class future
+{
+public:
+    using state_type = future_state< T, Event >;
+
+    constexpr future()
+        :m_state{nullptr}
+    {
+    }
+
+    // Checks if future refers to a state
+    bool valid() const { return m_state != nullptr; }
+
+    // Checks if result is ready. Can be called from ISR.
+    bool is_ready() const
+    {
+        ecl_assert(m_state);
+        return m_state->m_flags.load() & state_type::ready;
+    }
+
+    // Waits until result is ready.
+    // Cannot be called from ISR.
+    void wait()
+    {
+        ecl_assert(m_state);
+
+        while (!is_ready()) {
+            m_state->m_event.wait();
+        }
+    }
+
+    // Waits until result is ready, but no longer than given amount
+    // of milliseconds. Returns err::timedout if result is not ready yet.
+    // Cannot be called from ISR.
+    ecl::err wait_for(uint32_t msecs)
+    {
+        ecl_assert(m_state);
+
+        if (!is_ready()) {
+            m_state->m_event.wait_for(msecs);
+        }
+
+        return is_ready() ? ecl::err::ok : ecl::err::timedout;
+    }
+
+    // Waits for result and moves value out of the state.
+    // Returns error reported by the promise, if any. In that case
+    // value is not touched.
+    ecl::err get(T &out)
+    {
+        wait();
+
+        if (!is_error(m_state->m_status)) {
+            out = std::move(*m_state->value());
+        }
+
+        return m_state->m_status;
+    }
+
+    // Sets continuation, executed when result is ready. If result is
+    // already available, continuation is executed right away.
+    // Otherwise it is executed in the context of the producer, most likely
+    // in ISR. Only one continuation can be set.
+    void then(const typename state_type::callback &fn)
+    {
+        ecl_assert(m_state);
+
+        m_state->m_callback = fn;
+        auto prev = m_state->m_flags.fetch_or(state_type::chained);
+
+        ecl_assert(!(prev & state_type::chained));
+
+        if (prev & state_type::ready) {
+            m_state->run_callback();
+        }
+    }
+
+private:
+    friend class promise< T, Event >;
+
+    explicit future(state_type *state)
+        :m_state{state}
+    {
+    }
+
+    state_type *m_state;
+};
+
+// Producer side of the shared state.
+// Result can be set from any context, including ISR, but only once.
+// Promise must outlive all its futures.
+template< class T, class Event >
+class promise
+{
+public:
+    using state_type = future_state< T, Event >;
+
+    // Creates promise with embedded state
+    promise()
+        :m_own{}
+        ,m_state{&m_own}
+    {
+    }
+
+    // Creates promise with state provided by the user.
+    // State must outlive the promise.
+    explicit promise(state_type &state)
+        :m_state{&state}
+    {
+    }
+
+    ~promise()
+    {
+        if (m_state == &m_own) {
+            m_own.~state_type();
+        }
+    }
+
+    // Gets future associated with the promise
+    future< T, Event > get_future()
+    {
+        return future< T, Event >{m_state};
+    }
+
+    // Stores value and makes it ready.
+    // Returns err::busy if result is already set.
+    template< class U >
+    ecl::err set_value(U &&val)
+    {
+        if (!m_state->claim()) {
+            return ecl::err::busy;
+        }
+
+        new (&m_state->m_storage) T(std::forward< U >(val));
+        m_state->m_flags |= state_type::has_value;
+        m_state->m_status = ecl::err::ok;
+        m_state->publish();
+        return ecl::err::ok;
+    }
+
+    // Stores error and makes it ready.
+    // Returns err::busy if result is already set.
+    ecl::err set_error(ecl::err status)
+    {
+        ecl_assert(is_error(status));
+
+        if (!m_state->claim()) {
+            return ecl::err::busy;
+        }
+
+        m_state->m_status = status;
+        m_state->publish();
+        return ecl::err::ok;
+    }
+
+    // Prepares promise for next result. All futures obtained before
+    // must not be used anymore.
+    void reset()
+    {
+        m_state->reset();
+    }
+
+    promise(const promise&)             = delete;
+    promise& operator=(const promise&)  = delete;
+
+private:
+    union
+    {
+        state_type m_own;   // Embedded state, if not provided by the user
+    };
+
+    state_type *m_state;    // State in use
+};
+
+}
+
+}
+
+#endif // LIB_THREAD_COMMON_FUTURE_
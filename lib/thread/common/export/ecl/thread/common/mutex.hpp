@@ -1,6 +1,8 @@
 #ifndef LIB_THREAD_COMMON_MUTEX_
 #define LIB_THREAD_COMMON_MUTEX_
 
+#include <cstdint>
+
 namespace ecl
 {
 
@@ -10,11 +12,12 @@ namespace common
 class mutex
 {
 public:
-    constexpr mutex();
+    constexpr mutex() { }
 
     void lock();
     void unlock();
     bool try_lock();
+    bool try_lock_for(uint32_t msecs);
 
     mutex(const mutex&)             = delete;
     mutex& operator=(const mutex&)  = delete;
@@ -4,6 +4,7 @@
 #include <ecl/err.hpp>
 
 #include <atomic>
+#include <cstdint>
 
 namespace ecl
 {
@@ -11,22 +12,47 @@ namespace ecl
 namespace common
 {
 
-// Empty semaphore, acting like spinlock of some kind
+// Milliseconds since some moment in the past. Wraps around.
+using tick_type = uint32_t;
+
+// Gets current tick. Host uses monotonic clock. Bare metal platform
+// must provide its own implementation, i.e. based on SysTick. Default one
+// never advances, so timed waits on bare metal turn into endless ones.
+tick_type get_ticks();
+
+// Counting semaphore for platforms without OS.
+// Waiter doesn't spin: it sleeps with WFE on ARM or blocks
+// on a futex on host.
 class semaphore
 {
 public:
     constexpr semaphore()
-        :m_counter{0} { }
+        :m_counter{0}, m_waiters{0} { }
 
     void signal();
     void wait();
     ecl::err try_wait();
 
+    // Waits given amount of milliseconds.
+    // Returns err::timedout if semaphore was not signalled in time.
+    ecl::err wait_for(uint32_t msecs);
+
+    // Waits until given tick, see get_ticks().
+    // Returns err::timedout if semaphore was not signalled in time.
+    ecl::err wait_until(tick_type tick);
+
     semaphore(const semaphore&)             = delete;
     semaphore& operator=(const semaphore&)  = delete;
 
 private:
-    std::atomic_int m_counter;
+    // Decrements counter if it is positive
+    bool take();
+
+    // Sleeps until counter is changed, or given time is elapsed
+    void sleep(int32_t msecs);
+
+    std::atomic_int m_counter; // Signals not consumed yet
+    std::atomic_int m_waiters; // Threads sleeping on the counter
 };
 
 }
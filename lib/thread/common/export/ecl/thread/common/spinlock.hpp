@@ -2,6 +2,7 @@
 #define LIB_THREAD_COMMON_SPINLOCK_
 
 #include <atomic>
+#include <cstdint>
 
 namespace ecl
 {
@@ -10,16 +11,49 @@ namespace ecl
 namespace common
 {
 
+// Test-and-test-and-set lock with exponential backoff.
+// While lock is taken, waiters spin on a plain load instead of
+// read-modify-write, so the cache line is not bounced between cores.
+// On ARM waiters sleep with WFE until lock owner signals with SEV.
 class spinlock
 {
 public:
-    constexpr spinlock();
+    constexpr spinlock()
+        :m_locked{false}
+    {
+    }
 
     void lock();
+    bool try_lock();
     void unlock();
 
+    spinlock(const spinlock&)             = delete;
+    spinlock& operator=(const spinlock&)  = delete;
+
+private:
+    std::atomic_bool m_locked;
+};
+
+// Ticket lock. Grants lock in order of arrival, thus no waiter starves.
+// Costs one more word than a spinlock and a bit slower when uncontended.
+class ticket_spinlock
+{
+public:
+    constexpr ticket_spinlock()
+        :m_next{0}
+        ,m_serving{0}
+    {
+    }
+
+    void lock();
+    void unlock();
+
+    ticket_spinlock(const ticket_spinlock&)             = delete;
+    ticket_spinlock& operator=(const ticket_spinlock&)  = delete;
+
 private:
-    std::atomic_flag m_flag;
+    std::atomic< uint32_t > m_next;    // Ticket of the next arrived waiter
+    std::atomic< uint32_t > m_serving; // Ticket of the lock owner
 };
 
 }
@@ -1,9 +1,5 @@
 #include <ecl/thread/common/mutex.hpp>
 
-constexpr ecl::common::mutex::mutex()
-{
-}
-
 void ecl::common::mutex::lock()
 {
 }
@@ -16,3 +12,9 @@ bool ecl::common::mutex::try_lock()
 {
     return true;
 }
+
+bool ecl::common::mutex::try_lock_for(uint32_t msecs)
+{
+    (void) msecs;
+    return true;
+}
@@ -1,30 +1,96 @@
 // Empty semaphore
 
 #include <ecl/thread/common/semaphore.hpp>
+#include "wait_change.hpp"
+
+#if defined(__unix__)
+#include <chrono>
+#endif
+
+#if defined(__unix__)
+
+ecl::common::tick_type ecl::common::get_ticks()
+{
+    using namespace std::chrono;
+    auto now = steady_clock::now().time_since_epoch();
+    return static_cast< tick_type >(duration_cast< milliseconds >(now).count());
+}
+
+#else
+
+__attribute__((weak))
+ecl::common::tick_type ecl::common::get_ticks()
+{
+    return 0;
+}
+
+#endif
 
 void ecl::common::semaphore::signal()
 {
     m_counter++;
+
+    // Waiter registers itself before it checks the counter,
+    // so either it sees the signal or it is woken here
+    if (m_waiters.load()) {
+        notify_change(m_counter);
+    }
 }
 
 void ecl::common::semaphore::wait()
 {
-    int cnt;
-
-    if ((cnt = m_counter.fetch_sub(1)) <= 0) {
-        while (m_counter.load() < cnt) { }
+    while (!take()) {
+        sleep(-1);
     }
 }
 
 ecl::err ecl::common::semaphore::try_wait()
 {
-    int cnt;
-    err rc = err::ok;
+    return take() ? err::ok : err::again;
+}
+
+ecl::err ecl::common::semaphore::wait_for(uint32_t msecs)
+{
+    return wait_until(get_ticks() + msecs);
+}
+
+ecl::err ecl::common::semaphore::wait_until(tick_type tick)
+{
+    while (!take()) {
+        // Difference is signed to survive tick wrap
+        auto left = static_cast< int32_t >(tick - get_ticks());
+        if (left <= 0) {
+            return err::timedout;
+        }
+
+        sleep(left);
+    }
+
+    return err::ok;
+}
+
+bool ecl::common::semaphore::take()
+{
+    int cnt = m_counter.load();
+
+    while (cnt > 0) {
+        if (m_counter.compare_exchange_weak(cnt, cnt - 1)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ecl::common::semaphore::sleep(int32_t msecs)
+{
+    m_waiters++;
 
-    if ((cnt = m_counter.fetch_sub(1)) <= 0) {
-        m_counter++;
-        rc = err::again;
+    // Counter can't get below zero, it is enough to wait
+    // for a change of zero value
+    if (m_counter.load() == 0) {
+        wait_change(m_counter, 0, msecs);
     }
 
-    return rc;
+    m_waiters--;
 }
@@ -1,19 +1,103 @@
 #include <ecl/thread/common/spinlock.hpp>
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
-constexpr ecl::common::spinlock::spinlock()
-    :m_flag{ATOMIC_FLAG_INIT}
+#if defined(__unix__)
+#include <sched.h>
+#endif
+
+namespace
+{
+
+// Upper limit of pause instructions between two lock checks
+constexpr uint32_t max_backoff = 1024;
+
+// Waits a bit before next check of the lock
+void relax(uint32_t times)
+{
+#if defined(__arm__)
+    // Sleeps until SEV from unlock() or any exception
+    (void) times;
+    __asm__ volatile ("wfe");
+#elif defined(__i386__) || defined(__x86_64__)
+    for (uint32_t i = 0; i < times; ++i) {
+        _mm_pause();
+    }
+
+#if defined(__unix__)
+    // Lock owner is likely preempted, let it run
+    if (times >= max_backoff) {
+        sched_yield();
+    }
+#endif
+#else
+    (void) times;
+#endif
+}
+
+// Wakes up waiters that sleep in relax()
+void notify()
 {
+#if defined(__arm__)
+    // Lock state must be visible before waiters are woken up
+    __asm__ volatile ("dsb\n\tsev" ::: "memory");
+#endif
+}
+
 }
 
+//------------------------------------------------------------------------------
+
 void ecl::common::spinlock::lock()
 {
-    while (m_flag.test_and_set(std::memory_order_acquire))
-        ;
+    uint32_t backoff = 1;
+
+    while (m_locked.exchange(true, std::memory_order_acquire)) {
+        while (m_locked.load(std::memory_order_relaxed)) {
+            relax(backoff);
+
+            if (backoff < max_backoff) {
+                backoff <<= 1;
+            }
+        }
+    }
+}
+
+bool ecl::common::spinlock::try_lock()
+{
+    return !m_locked.load(std::memory_order_relaxed)
+        && !m_locked.exchange(true, std::memory_order_acquire);
 }
 
 void ecl::common::spinlock::unlock()
 {
-    m_flag.clear(std::memory_order_release);
+    m_locked.store(false, std::memory_order_release);
+    notify();
+}
+
+//------------------------------------------------------------------------------
+
+void ecl::common::ticket_spinlock::lock()
+{
+    auto ticket = m_next.fetch_add(1, std::memory_order_relaxed);
+    uint32_t backoff = 1;
+
+    // Order is defined by tickets, so backoff doesn't affect fairness
+    while (m_serving.load(std::memory_order_acquire) != ticket) {
+        relax(backoff);
+
+        if (backoff < max_backoff) {
+            backoff <<= 1;
+        }
+    }
 }
 
+void ecl::common::ticket_spinlock::unlock()
+{
+    // Only owner modifies serving ticket
+    auto serving = m_serving.load(std::memory_order_relaxed);
+    m_serving.store(serving + 1, std::memory_order_release);
+    notify();
+}
@@ -0,0 +1,53 @@
+#include "wait_change.hpp"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <ctime>
+#elif defined(__unix__)
+#include <sched.h>
+#endif
+
+void ecl::common::wait_change(std::atomic_int &value, int seen, int32_t msecs)
+{
+#if defined(__arm__)
+    // Signal is sent from ISR, its exception return sets event,
+    // thus there is no risk to miss it and sleep forever.
+    // Tick interrupt wakes a waiter as well, so timeout is checked
+    // periodically.
+    (void) value;
+    (void) seen;
+    (void) msecs;
+    __asm__ volatile ("wfe");
+#elif defined(__linux__)
+    timespec ts{msecs / 1000, (msecs % 1000) * 1000000L};
+
+    // Atomic is layout-compatible with int
+    syscall(SYS_futex, reinterpret_cast< int * >(&value),
+            FUTEX_WAIT_PRIVATE, seen, msecs < 0 ? nullptr : &ts, nullptr, 0);
+#elif defined(__unix__)
+    (void) value;
+    (void) seen;
+    (void) msecs;
+    sched_yield();
+#else
+    (void) value;
+    (void) seen;
+    (void) msecs;
+#endif
+}
+
+void ecl::common::notify_change(std::atomic_int &value)
+{
+#if defined(__arm__)
+    (void) value;
+    __asm__ volatile ("dsb\n\tsev" ::: "memory");
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast< int * >(&value),
+            FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void) value;
+#endif
+}
@@ -0,0 +1,24 @@
+#ifndef LIB_THREAD_COMMON_WAIT_CHANGE_
+#define LIB_THREAD_COMMON_WAIT_CHANGE_
+
+#include <atomic>
+#include <cstdint>
+
+namespace ecl
+{
+
+namespace common
+{
+
+// Blocks until value, probably, differs from given one or timeout
+// (negative means no timeout) is expired. Spurious wakeups are allowed.
+void wait_change(std::atomic_int &value, int seen, int32_t msecs);
+
+// Wakes up all waiters, blocked in wait_change()
+void notify_change(std::atomic_int &value);
+
+}
+
+}
+
+#endif // LIB_THREAD_COMMON_WAIT_CHANGE_
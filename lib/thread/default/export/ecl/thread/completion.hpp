@@ -0,0 +1,12 @@
+#ifndef LIB_THREAD_DEFAULT_COMPLETION_
+#define LIB_THREAD_DEFAULT_COMPLETION_
+
+#include <ecl/thread/common/semaphore.hpp>
+
+namespace ecl
+{
+    // No cheaper primitive without OS, semaphore is used as is
+    using completion = common::semaphore;
+}
+
+#endif //LIB_THREAD_DEFAULT_COMPLETION_
@@ -0,0 +1,11 @@
+#ifndef LIB_THREAD_DEFAULT_EVENT_GROUP_
+#define LIB_THREAD_DEFAULT_EVENT_GROUP_
+
+#include <ecl/thread/common/event_group.hpp>
+
+namespace ecl
+{
+    using event_group = common::event_group;
+}
+
+#endif //LIB_THREAD_DEFAULT_EVENT_GROUP_
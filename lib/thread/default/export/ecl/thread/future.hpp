@@ -0,0 +1,22 @@
+#ifndef LIB_THREAD_DEFAULT_FUTURE_
+#define LIB_THREAD_DEFAULT_FUTURE_
+
+#include <ecl/thread/common/future.hpp>
+#include <ecl/thread/completion.hpp>
+
+namespace ecl
+{
+
+// Only one thread waits for a future, completion fits best
+template< class T >
+using future_state = common::future_state< T, completion >;
+
+template< class T >
+using future = common::future< T, completion >;
+
+template< class T >
+using promise = common::promise< T, completion >;
+
+}
+
+#endif // LIB_THREAD_DEFAULT_FUTURE_
@@ -6,6 +6,13 @@
 namespace ecl
 {
     using semaphore = common::semaphore;
+
+    namespace os
+    {
+        // Time base for semaphore::wait_until()
+        using common::tick_type;
+        using common::get_ticks;
+    }
 }
 
 #endif //LIB_THREAD_DEFAULT_SEMAPHORE_
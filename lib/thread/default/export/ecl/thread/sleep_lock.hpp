@@ -0,0 +1,14 @@
+#ifndef LIB_THREAD_DEFAULT_SLEEP_LOCK_
+#define LIB_THREAD_DEFAULT_SLEEP_LOCK_
+
+namespace ecl
+{
+    // There is no idle task to put MCU to sleep without OS
+    struct sleep_lock
+    {
+        static void acquire() { }
+        static void release() { }
+    };
+}
+
+#endif //LIB_THREAD_DEFAULT_SLEEP_LOCK_
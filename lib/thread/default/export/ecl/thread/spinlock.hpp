@@ -1,11 +1,12 @@
 #ifndef LIB_THREAD_DEFAULT_SPINLOCK_
 #define LIB_THREAD_DEFAULT_SPINLOCK_
 
-#include <ecl/common/thread/spinlock.hpp>
+#include <ecl/thread/common/spinlock.hpp>
 
 namespace ecl
 {
-    using spinlock = common::spinlock;
+    using spinlock          = common::spinlock;
+    using ticket_spinlock   = common::ticket_spinlock;
 }
 
 #endif // LIB_THREAD_DEFAULT_SPINLOCK_
@@ -0,0 +1,127 @@
+#ifndef LIB_THREAD_BLOCK_EXCHANGE_
+#define LIB_THREAD_BLOCK_EXCHANGE_
+
+//!
+//! \file
+//! \brief Handoff of data blocks between a thread and a streaming driver.
+//!
+
+#include <ecl/thread/semaphore.hpp>
+#include <ecl/thread/spsc_queue.hpp>
+
+#include <atomic>
+#include <cstddef>
+
+namespace ecl
+{
+
+//!
+//! \brief Passes blocks to a streaming driver and back, without copying.
+//! Driver owns two blocks at a time, the one it transfers and the next one.
+//! Once a block is transferred, driver hands it back and takes the next one
+//! given by the thread, all from its IRQ, see exchange(). Blocks come from
+//! the thread, i.e. from ecl::pool, and neither the driver nor the exchange
+//! touches the pool, so the pool needs no IRQ locking.
+//! For playback, thread gives blocks filled with samples and takes played
+//! ones, to fill them again, i.e. by reading a file right into them. For
+//! recording, thread gives empty blocks and takes filled ones. Slow thread
+//! operations, like SD access, don't disturb the stream as long as enough
+//! blocks are queued.
+//! \tparam T       Type of block elements.
+//! \tparam depth   Most blocks in flight, including two owned by the driver.
+//!                 Must be a power of two.
+//!
+template< class T, size_t depth >
+class block_exchange
+{
+public:
+    block_exchange()
+        :m_given{}
+        ,m_done{}
+        ,m_ready{}
+        ,m_misses{0}
+    {
+    }
+
+    //!
+    //! \brief Gives a block to the driver. Called by the thread only.
+    //! \retval true  Block is queued.
+    //! \retval false Too many blocks are queued.
+    //!
+    bool give(T *block)
+    {
+        return m_given.push(block);
+    }
+
+    //!
+    //! \brief Takes a block the driver is done with, waiting for it.
+    //! Called by the thread only.
+    //!
+    T *take()
+    {
+        T *block;
+
+        while (!m_done.pop(block)) {
+            m_ready.wait();
+        }
+
+        return block;
+    }
+
+    //!
+    //! \brief Takes a block the driver is done with, if there is one.
+    //! Called by the thread only.
+    //! \return Block or nullptr if driver holds all blocks given.
+    //!
+    T *try_take()
+    {
+        T *block;
+        return m_done.pop(block) ? block : nullptr;
+    }
+
+    //!
+    //! \brief Exchanges a block the driver is done with for the next one.
+    //! Called by the driver only, i.e. from its IRQ. If thread gave no
+    //! block in time, the done one is transferred again and the miss is
+    //! counted: for playback the block is played twice, for recording it
+    //! is overwritten.
+    //! \param[in] done Block just transferred.
+    //! \return Block to transfer next.
+    //!
+    T *exchange(T *done)
+    {
+        T *next;
+
+        if (!m_given.pop(next)) {
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            return done;
+        }
+
+        // Can't overflow, since at most depth blocks are in flight
+        m_done.push(done);
+        m_ready.signal();
+
+        return next;
+    }
+
+    //!
+    //! \brief Gets amount of times thread was late to give a block.
+    //!
+    size_t misses() const
+    {
+        return m_misses.load(std::memory_order_relaxed);
+    }
+
+    block_exchange(const block_exchange&)             = delete;
+    block_exchange& operator=(const block_exchange&)  = delete;
+
+private:
+    spsc_queue< T*, depth > m_given;    //!< Blocks to be transferred.
+    spsc_queue< T*, depth > m_done;     //!< Blocks transferred.
+    semaphore               m_ready;    //!< Signalled when a block is done.
+    std::atomic< size_t >   m_misses;   //!< Exchanges with no block given.
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_BLOCK_EXCHANGE_
@@ -0,0 +1,328 @@
+#ifndef LIB_THREAD_EPOCH_
+#define LIB_THREAD_EPOCH_
+
+//!
+//! \file
+//! \brief Epoch-based reclamation of memory for lock-free structures.
+//! Node, removed from a lock-free structure, can still be read by threads,
+//! that took a pointer to it before. Such node is retired instead of being
+//! freed, and is freed once every thread left the critical section, where
+//! it could see the node. Freed node can't be reused while someone still
+//! reads it, so there is no use-after-free and no ABA on its address:
+//! \code
+//!     struct node : ecl::epoch_node { int value; std::atomic< node* > next; };
+//!     ecl::object_pool< node, 64 > nodes;
+//!     ecl::epoch_domain< 4 > ebr;
+//!
+//!     int id = ebr.enter();
+//!     {
+//!         ecl::epoch_domain< 4 >::guard g{ebr, id};
+//!         node *n = pop(head);    // Lock-free removal
+//!         use(n->value);
+//!         ebr.retire(id, n, nodes);
+//!     }
+//!     ebr.leave(id);
+//! \endcode
+//! Reclamation is amortized: retired nodes are freed in batches, by the
+//! thread that retired them.
+//!
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Base of nodes, that can be retired.
+//! Holds the link of the retired list, so retiring never allocates.
+//!
+struct epoch_node
+{
+    //! Frees the node.
+    using free_fn = void (*)(epoch_node *node, void *ctx);
+
+    epoch_node  *retired_next = nullptr;    //!< Next retired node.
+    free_fn     retired_free  = nullptr;    //!< Routine, that frees the node.
+    void        *retired_ctx  = nullptr;    //!< Argument of the routine.
+};
+
+//!
+//! \brief Domain of epoch-based reclamation.
+//! Threads register in the domain once and access shared nodes only within
+//! critical sections, marked by guard. Critical sections must be short:
+//! a thread, that stays in one, holds back reclamation of all threads.
+//! Can't be used from ISRs, since ISR can't wait for preempted threads.
+//! \tparam participants Maximum amount of registered threads.
+//! \tparam batch        Amount of retired nodes, after which a thread tries
+//!                      to advance the epoch and free its nodes.
+//!
+template< size_t participants, size_t batch = 32 >
+class epoch_domain
+{
+    static_assert(participants > 0, "At least one participant is required");
+    static_assert(batch > 0, "Batch must not be empty");
+
+public:
+    //!
+    //! \brief Critical section, where shared nodes can be accessed.
+    //! Sections can't be nested.
+    //!
+    class guard
+    {
+    public:
+        guard(epoch_domain &domain, int id)
+            :m_domain{domain}
+            ,m_id{id}
+        {
+            m_domain.pin(m_id);
+        }
+
+        ~guard()
+        {
+            m_domain.unpin(m_id);
+        }
+
+        guard(const guard&)             = delete;
+        guard& operator=(const guard&)  = delete;
+
+    private:
+        epoch_domain    &m_domain;
+        int             m_id;
+    };
+
+    epoch_domain()
+        :m_epoch{0}
+        ,m_records{}
+    {
+    }
+
+    //!
+    //! \brief Frees all retired nodes.
+    //! \pre No thread accesses nodes anymore.
+    //!
+    ~epoch_domain()
+    {
+        for (auto &r : m_records) {
+            for (auto &b : r.buckets) {
+                free_list(b.head);
+                b.head = nullptr;
+            }
+        }
+    }
+
+    //!
+    //! \brief Registers calling thread.
+    //! Nodes, retired by a thread that left the slot, are inherited.
+    //! \return Slot of the thread, or -1 if all slots are taken.
+    //!
+    int enter()
+    {
+        for (size_t i = 0; i < participants; ++i) {
+            bool expected = false;
+
+            if (m_records[i].used.compare_exchange_strong(expected, true,
+                                                          std::memory_order_acquire)) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    //!
+    //! \brief Unregisters a thread. Its nodes are freed by the next owner
+    //!        of the slot, or by the domain destructor.
+    //! \pre Thread is outside of a critical section.
+    //!
+    void leave(int id)
+    {
+        reclaim(id);
+        m_records[id].used.store(false, std::memory_order_release);
+    }
+
+    //!
+    //! \brief Retires a node, that is no longer reachable from the structure.
+    //! \param[in] id   Slot of the calling thread.
+    //! \param[in] node Node to free.
+    //! \param[in] fn   Frees the node, once no thread can access it.
+    //! \param[in] ctx  Argument of the free routine.
+    //!
+    void retire(int id, epoch_node *node, epoch_node::free_fn fn, void *ctx);
+
+    //!
+    //! \brief Retires a node, that is returned to a pool once no thread
+    //!        can access it. Node is destroyed before.
+    //! \tparam Node Type of the node, derived from epoch_node.
+    //! \tparam Pool Pool with deallocate(), i.e. ecl::object_pool.
+    //!
+    template< class Node, class Pool >
+    void retire(int id, Node *node, Pool &pool)
+    {
+        retire(id, node, [](epoch_node *n, void *ctx) {
+            auto p = static_cast< Node* >(n);
+            p->~Node();
+            static_cast< Pool* >(ctx)->deallocate(p, 1);
+        }, &pool);
+    }
+
+    //!
+    //! \brief Frees nodes of the thread, that are safe to free.
+    //! Tries to advance the epoch first.
+    //! \return Amount of nodes, that are still retired by the thread.
+    //!
+    size_t reclaim(int id);
+
+    //!
+    //! \brief Gets current epoch.
+    //!
+    uint32_t epoch() const { return m_epoch.load(std::memory_order_relaxed); }
+
+    epoch_domain(const epoch_domain&)             = delete;
+    epoch_domain& operator=(const epoch_domain&)  = delete;
+
+private:
+    //! Nodes retired in the same epoch.
+    struct bucket
+    {
+        epoch_node  *head;
+        uint32_t    epoch;
+    };
+
+    //! Node is safe to free two epochs later, so three buckets are enough.
+    static constexpr size_t bucket_count = 3;
+
+    //! State of a slot.
+    struct alignas(64) record
+    {
+        std::atomic_bool        used;       //!< Slot is registered.
+        std::atomic< uint32_t > state;      //!< Pinned epoch shifted left, with one
+                                            //!< in LSB, or zero if thread is outside.
+        bucket                  buckets[bucket_count]; //!< Retired nodes.
+        size_t                  retired;    //!< Amount of retired nodes.
+        size_t                  since;      //!< Retired since the last reclaim.
+    };
+
+    void pin(int id)
+    {
+        auto &r = m_records[id];
+        uint32_t e = m_epoch.load(std::memory_order_relaxed);
+
+        // Full barrier: state must be visible before shared pointers are read
+        r.state.exchange(e << 1 | 1, std::memory_order_seq_cst);
+    }
+
+    void unpin(int id)
+    {
+        m_records[id].state.store(0, std::memory_order_release);
+    }
+
+    //! Advances the epoch, if all threads inside have seen the current one.
+    bool try_advance();
+
+    static void free_bucket(record &r, bucket &b)
+    {
+        auto n = b.head;
+        b.head = nullptr;
+
+        for (auto p = n; p; p = p->retired_next) {
+            r.retired--;
+        }
+
+        free_list(n);
+    }
+
+    static void free_list(epoch_node *n)
+    {
+        while (n) {
+            auto next = n->retired_next;
+            n->retired_free(n, n->retired_ctx);
+            n = next;
+        }
+    }
+
+    std::atomic< uint32_t > m_epoch;                //!< Global epoch.
+    record                  m_records[participants]; //!< Registered threads.
+};
+
+//------------------------------------------------------------------------------
+
+template< size_t participants, size_t batch >
+void epoch_domain< participants, batch >::retire(int id, epoch_node *node,
+                                                 epoch_node::free_fn fn, void *ctx)
+{
+    auto &r = m_records[id];
+    uint32_t e = m_epoch.load(std::memory_order_seq_cst);
+    bucket *b = nullptr;
+
+    // Buckets may hold nodes of current and previous epoch, the third one
+    // is either empty or holds nodes, that are safe to free
+    for (auto &cur : r.buckets) {
+        if (cur.head && cur.epoch == e) {
+            b = &cur;
+            break;
+        }
+
+        if (!cur.head || e - cur.epoch >= 2) {
+            b = &cur;
+        }
+    }
+
+    if (b->head && b->epoch != e) {
+        free_bucket(r, *b);
+    }
+
+    node->retired_free = fn;
+    node->retired_ctx = ctx;
+    node->retired_next = b->head;
+    b->head = node;
+    b->epoch = e;
+    r.retired++;
+
+    if (++r.since >= batch) {
+        reclaim(id);
+    }
+}
+
+template< size_t participants, size_t batch >
+size_t epoch_domain< participants, batch >::reclaim(int id)
+{
+    auto &r = m_records[id];
+
+    r.since = 0;
+    try_advance();
+
+    uint32_t e = m_epoch.load(std::memory_order_seq_cst);
+
+    for (auto &b : r.buckets) {
+        if (b.head && e - b.epoch >= 2) {
+            free_bucket(r, b);
+        }
+    }
+
+    return r.retired;
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< size_t participants, size_t batch >
+bool epoch_domain< participants, batch >::try_advance()
+{
+    uint32_t e = m_epoch.load(std::memory_order_seq_cst);
+
+    for (auto &r : m_records) {
+        uint32_t s = r.state.load(std::memory_order_seq_cst);
+
+        if ((s & 1) && (s >> 1) != (e & (UINT32_MAX >> 1))) {
+            return false;
+        }
+    }
+
+    return m_epoch.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+}
+
+} // namespace ecl
+
+#endif // LIB_THREAD_EPOCH_
@@ -0,0 +1,129 @@
+#ifndef LIB_THREAD_HEARTBEAT_
+#define LIB_THREAD_HEARTBEAT_
+
+//!
+//! \file
+//! \brief Lock-free table of thread heartbeats.
+//!
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Table of heartbeats, tracking liveness of threads.
+//! Each registered thread beats at least once per its period. Supervisor
+//! checks the table and finds threads, that missed their period, i.e.
+//! stuck waiting for an event that never comes. Times are given by the
+//! caller in any units, wrapping counters are fine as long as periods
+//! are shorter than half of their range. Registration, beats and checks
+//! are lock-free, so they can be done from threads and ISRs.
+//! \tparam slots Maximum amount of registered threads.
+//!
+template< size_t slots >
+class heartbeat_table
+{
+    static_assert(slots > 0, "At least one slot is required");
+
+public:
+    heartbeat_table()
+        :m_slots{}
+    {
+    }
+
+    //!
+    //! \brief Registers a thread.
+    //! \param[in] tag    Identifies the thread in reports, i.e. its number.
+    //! \param[in] period Longest allowed interval between beats, non-zero.
+    //! \param[in] now    Current time, counted as the first beat.
+    //! \return Slot of the thread, or -1 if table is full or period is invalid.
+    //!
+    int add(uint32_t tag, uint32_t period, uint32_t now)
+    {
+        if (!period || period == claimed) {
+            return -1;
+        }
+
+        for (size_t i = 0; i < slots; ++i) {
+            uint32_t expected = 0;
+            auto &s = m_slots[i];
+
+            if (s.period.compare_exchange_strong(expected, claimed, std::memory_order_acquire)) {
+                s.tag = tag;
+                s.last.store(now, std::memory_order_relaxed);
+                // Slot becomes visible to the supervisor
+                s.period.store(period, std::memory_order_release);
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    //!
+    //! \brief Unregisters a thread, i.e. before it exits or sleeps for long.
+    //! \param[in] id Slot of the thread.
+    //!
+    void remove(int id)
+    {
+        m_slots[id].period.store(0, std::memory_order_release);
+    }
+
+    //!
+    //! \brief Marks a thread alive.
+    //! \param[in] id  Slot of the thread.
+    //! \param[in] now Current time.
+    //!
+    void beat(int id, uint32_t now)
+    {
+        m_slots[id].last.store(now, std::memory_order_release);
+    }
+
+    //!
+    //! \brief Finds a thread, that missed its period.
+    //! \param[in] now Current time.
+    //! \return Slot of the thread, or -1 if all threads are alive.
+    //!
+    int stalled(uint32_t now) const
+    {
+        for (size_t i = 0; i < slots; ++i) {
+            auto &s = m_slots[i];
+            uint32_t period = s.period.load(std::memory_order_acquire);
+
+            if (period && period != claimed
+                    && now - s.last.load(std::memory_order_acquire) > period) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    //!
+    //! \brief Gets tag of a registered thread.
+    //!
+    uint32_t tag(int id) const { return m_slots[id].tag; }
+
+    heartbeat_table(const heartbeat_table&)             = delete;
+    heartbeat_table& operator=(const heartbeat_table&)  = delete;
+
+private:
+    //! Period of a slot, that is being registered.
+    static constexpr uint32_t claimed = UINT32_MAX;
+
+    struct slot
+    {
+        std::atomic< uint32_t > period;     //!< Allowed interval, 0 if slot is free.
+        std::atomic< uint32_t > last;       //!< Time of the last beat.
+        uint32_t                tag;        //!< Thread identifier.
+    };
+
+    slot m_slots[slots];    //!< Registered threads.
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_HEARTBEAT_
@@ -0,0 +1,123 @@
+#ifndef LIB_THREAD_MPMC_QUEUE_
+#define LIB_THREAD_MPMC_QUEUE_
+
+//!
+//! \file
+//! \brief Bounded lock-free multi-producer multi-consumer queue.
+//!
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace ecl
+{
+
+//!
+//! \brief Bounded lock-free MPMC queue.
+//! Each cell carries a sequence number, telling whether it is ready to be
+//! written or read in the current lap. Producers and consumers only contend
+//! on their own index, cells are handed over without locks.
+//! Both push() and pop() can be called from ISR.
+//! \tparam T    Item type. Must be trivially copyable.
+//! \tparam size Capacity. Must be a power of two.
+//!
+template< class T, size_t size >
+class mpmc_queue
+{
+    static_assert(size >= 2 && !(size & (size - 1)), "Size must be a power of two");
+    static_assert(std::is_trivially_copyable< T >::value, "Item must be trivially copyable");
+
+public:
+    mpmc_queue()
+        :m_cells{}
+        ,m_head{0}
+        ,m_tail{0}
+    {
+        for (size_t i = 0; i < size; ++i) {
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    //!
+    //! \brief Pushes item to the queue.
+    //! \retval true  Item is pushed.
+    //! \retval false Queue is full.
+    //!
+    bool push(const T &item)
+    {
+        auto pos = m_tail.load(std::memory_order_relaxed);
+
+        for (;;) {
+            auto &cell = m_cells[pos & mask];
+            auto seq = cell.seq.load(std::memory_order_acquire);
+            auto diff = static_cast< std::ptrdiff_t >(seq - pos);
+
+            if (diff == 0) {
+                // Cell is free in this lap, try to occupy it
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.item = item;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // Cell is still occupied by previous lap
+                return false;
+            } else {
+                // Other producer took the cell, catch up
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //!
+    //! \brief Pops item from the queue.
+    //! \param[out] item Popped item.
+    //! \retval true  Item is popped.
+    //! \retval false Queue is empty.
+    //!
+    bool pop(T &item)
+    {
+        auto pos = m_head.load(std::memory_order_relaxed);
+
+        for (;;) {
+            auto &cell = m_cells[pos & mask];
+            auto seq = cell.seq.load(std::memory_order_acquire);
+            auto diff = static_cast< std::ptrdiff_t >(seq - (pos + 1));
+
+            if (diff == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    item = cell.item;
+                    // Cell is free for the next lap
+                    cell.seq.store(pos + size, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // Cell is not yet written
+                return false;
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    mpmc_queue(const mpmc_queue&)             = delete;
+    mpmc_queue& operator=(const mpmc_queue&)  = delete;
+
+private:
+    static constexpr size_t mask = size - 1;
+
+    struct cell
+    {
+        std::atomic< size_t >   seq;    //!< Lap, where cell is ready.
+        T                       item;   //!< Stored item.
+    };
+
+    cell                    m_cells[size];  //!< Storage.
+    std::atomic< size_t >   m_head;         //!< Next position to read.
+    std::atomic< size_t >   m_tail;         //!< Next position to write.
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_MPMC_QUEUE_
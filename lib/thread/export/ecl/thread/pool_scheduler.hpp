@@ -0,0 +1,106 @@
+#ifndef LIB_THREAD_POOL_SCHEDULER_
+#define LIB_THREAD_POOL_SCHEDULER_
+
+//!
+//! \file
+//! \brief Job schedulers used by the thread pool.
+//! Scheduler decides where submitted job is kept and what job is picked
+//! by a worker next. Every scheduler provides the same interface:
+//! \code
+//! err  submit(const pool_job &job);           // Any context, never blocks
+//! bool take(size_t worker, pool_job &job);    // Blocks, false if stopped
+//! void stop();                                // Wakes all workers to exit
+//! void restart();                             // Clears stop request
+//! \endcode
+//!
+
+#include <ecl/err.hpp>
+#include <ecl/thread/semaphore.hpp>
+#include <ecl/thread/mpmc_queue.hpp>
+
+#include <atomic>
+#include <cstddef>
+
+namespace ecl
+{
+
+//!
+//! \brief Job, executed by the thread pool.
+//!
+struct pool_job
+{
+    void    (*fn)(void *arg);   //!< Job routine.
+    void    *arg;               //!< Job argument.
+};
+
+//!
+//! \brief Scheduler with single shared FIFO queue.
+//! Cheap and fair. Suits small amount of workers, like on MCU targets.
+//! \tparam workers    Amount of workers.
+//! \tparam queue_size Maximum amount of pending jobs. Must be a power of two.
+//!
+template< size_t workers, size_t queue_size >
+class fifo_scheduler
+{
+public:
+    fifo_scheduler()
+        :m_jobs{}
+        ,m_sem{}
+        ,m_stop{false}
+    {
+    }
+
+    err submit(const pool_job &job)
+    {
+        if (!m_jobs.push(job)) {
+            return err::nobufs;
+        }
+
+        m_sem.signal();
+        return err::ok;
+    }
+
+    bool take(size_t worker, pool_job &job)
+    {
+        (void) worker;
+
+        for (;;) {
+            // Woken worker takes jobs until queue is drained, so a signal
+            // lost due to semaphore limits can't leave a job behind.
+            if (m_jobs.pop(job)) {
+                return true;
+            }
+
+            if (m_stop) {
+                // Pass wakeup to the next worker
+                m_sem.signal();
+                return false;
+            }
+
+            m_sem.wait();
+        }
+    }
+
+    void stop()
+    {
+        m_stop = true;
+        m_sem.signal();
+    }
+
+    void restart()
+    {
+        m_stop = false;
+    }
+
+    fifo_scheduler(const fifo_scheduler&)             = delete;
+    fifo_scheduler& operator=(const fifo_scheduler&)  = delete;
+
+private:
+    mpmc_queue< pool_job, queue_size >  m_jobs;     //!< Pending jobs.
+    semaphore                           m_sem;      //!< Counts submissions.
+    std::atomic_bool                    m_stop;     //!< Workers must exit.
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_POOL_SCHEDULER_
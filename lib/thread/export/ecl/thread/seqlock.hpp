@@ -0,0 +1,139 @@
+#ifndef LIB_THREAD_SEQLOCK_
+#define LIB_THREAD_SEQLOCK_
+
+//!
+//! \file
+//! \brief Sequence lock.
+//! Publishes small data from a single writer, i.e. an ISR updating counters
+//! and timestamps, to any amount of readers. Writer never waits, readers
+//! retry if the data was changed while they were reading:
+//! \code
+//!     struct capture { uint32_t stamp; uint32_t count; };
+//!     ecl::seqlock< capture > last;
+//!
+//!     // ISR
+//!     last.store({now(), ++count});
+//!
+//!     // Thread
+//!     capture c = last.load();
+//! \endcode
+//!
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ecl
+{
+
+//!
+//! \brief Value, protected by sequence lock.
+//! Only one writer at a time is allowed: writes from different contexts
+//! must be serialized by the caller. Reader spins while a write is in
+//! progress, so writer must not be preempted by readers, i.e. it is
+//! an ISR or a thread of higher priority.
+//! \tparam T Trivially copyable type of the value. Readers copy it
+//!           word by word, so keep it small.
+//!
+template< class T >
+class seqlock
+{
+    static_assert(std::is_trivially_copyable< T >::value, "Value must be trivially copyable");
+
+public:
+    seqlock()
+        :m_seq{0}
+        ,m_words{}
+    {
+    }
+
+    //!
+    //! \brief Constructs lock with initial value.
+    //!
+    explicit seqlock(const T &value)
+        :seqlock()
+    {
+        store(value);
+    }
+
+    //!
+    //! \brief Publishes new value. Never blocks.
+    //!
+    void store(const T &value)
+    {
+        uint32_t words[word_count] = {};
+        memcpy(words, &value, sizeof(T));
+
+        auto seq = m_seq.load(std::memory_order_relaxed);
+
+        // Odd sequence tells readers the value is being written.
+        // Reader, that sees any new word, sees the odd sequence as well.
+        m_seq.store(seq + 1, std::memory_order_relaxed);
+
+        for (size_t i = 0; i < word_count; ++i) {
+            m_words[i].store(words[i], std::memory_order_release);
+        }
+
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    //!
+    //! \brief Gets consistent copy of the value.
+    //! Retries if writer intervened.
+    //!
+    T load() const
+    {
+        T value;
+        while (!try_load(value)) { }
+        return value;
+    }
+
+    //!
+    //! \brief Makes single attempt to get the value.
+    //! \param[out] value Copy of the value, if consistent.
+    //! \retval true Value is copied.
+    //! \retval false Writer intervened, value is not altered.
+    //!
+    bool try_load(T &value) const
+    {
+        uint32_t words[word_count];
+        auto seq = m_seq.load(std::memory_order_acquire);
+
+        if (seq & 1) {
+            return false;
+        }
+
+        for (size_t i = 0; i < word_count; ++i) {
+            words[i] = m_words[i].load(std::memory_order_acquire);
+        }
+
+        if (m_seq.load(std::memory_order_relaxed) != seq) {
+            return false;
+        }
+
+        memcpy(&value, words, sizeof(T));
+        return true;
+    }
+
+    //!
+    //! \brief Gets amount of completed writes.
+    //! Lets readers skip processing if nothing has changed.
+    //!
+    uint32_t version() const { return m_seq.load(std::memory_order_acquire) / 2; }
+
+    seqlock(const seqlock&)             = delete;
+    seqlock& operator=(const seqlock&)  = delete;
+
+private:
+    //! Value is kept in atomic words, so concurrent copying is well defined.
+    static constexpr size_t word_count = (sizeof(T) + 3) / 4;
+
+    std::atomic< uint32_t > m_seq;                  //!< Sequence, odd while writing.
+    std::atomic< uint32_t > m_words[word_count];    //!< Words of the value.
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_SEQLOCK_
@@ -0,0 +1,184 @@
+#ifndef LIB_THREAD_SHARED_MUTEX_
+#define LIB_THREAD_SHARED_MUTEX_
+
+//!
+//! \file
+//! \brief Reader-writer lock.
+//! Protects read-mostly state, i.e. tables and configuration, so readers
+//! run in parallel with each other:
+//! \code
+//!     ecl::shared_mutex lock;
+//!
+//!     // Reader
+//!     {
+//!         ecl::shared_lock< ecl::shared_mutex > guard{lock};
+//!         lookup(table);
+//!     }
+//!
+//!     // Writer
+//!     lock.lock();
+//!     update(table);
+//!     lock.unlock();
+//! \endcode
+//! Built on top of OS mutex and semaphore, so it is available with any
+//! kernel, including none.
+//!
+
+#include <ecl/thread/mutex.hpp>
+#include <ecl/thread/semaphore.hpp>
+
+#include <atomic>
+
+namespace ecl
+{
+
+//!
+//! \brief Mutex with shared and exclusive ownership.
+//! Writers are preferred: once a writer waits, new readers wait for it,
+//! so a stream of readers can't starve writers. Waiting writer gets
+//! priority inheritance from the OS mutex against other writers only,
+//! not against readers. Lock is not recursive in either mode. Can't be
+//! used from ISRs.
+//!
+class shared_mutex
+{
+public:
+    shared_mutex()
+        :m_writer{}
+        ,m_idle{}
+        ,m_readers{0}
+        ,m_waiting{false}
+    {
+    }
+
+    //!
+    //! \brief Takes exclusive ownership.
+    //! Waits until readers, that took the lock earlier, leave.
+    //!
+    void lock()
+    {
+        m_writer.lock();
+        wait_readers();
+    }
+
+    //!
+    //! \brief Tries to take exclusive ownership without waiting.
+    //! \retval true Lock is taken.
+    //!
+    bool try_lock()
+    {
+        if (!m_writer.try_lock()) {
+            return false;
+        }
+
+        if (m_readers.load()) {
+            m_writer.unlock();
+            return false;
+        }
+
+        return true;
+    }
+
+    //!
+    //! \brief Releases exclusive ownership.
+    //!
+    void unlock()
+    {
+        m_writer.unlock();
+    }
+
+    //!
+    //! \brief Takes shared ownership.
+    //! Waits while the lock is taken or requested by a writer.
+    //!
+    void lock_shared()
+    {
+        m_writer.lock();
+        m_readers.fetch_add(1);
+        m_writer.unlock();
+    }
+
+    //!
+    //! \brief Tries to take shared ownership without waiting.
+    //! \retval true Lock is taken.
+    //!
+    bool try_lock_shared()
+    {
+        if (!m_writer.try_lock()) {
+            return false;
+        }
+
+        m_readers.fetch_add(1);
+        m_writer.unlock();
+        return true;
+    }
+
+    //!
+    //! \brief Releases shared ownership.
+    //!
+    void unlock_shared()
+    {
+        // Last reader wakes the writer up, if there is one
+        if (m_readers.fetch_sub(1) == 1 && m_waiting.load()) {
+            m_idle.signal();
+        }
+    }
+
+    shared_mutex(const shared_mutex&)             = delete;
+    shared_mutex& operator=(const shared_mutex&)  = delete;
+
+private:
+    //! Waits for readers, with writer mutex taken.
+    void wait_readers()
+    {
+        m_waiting.store(true);
+
+        // Signal may be left from a previous writer, so count is checked again
+        while (m_readers.load()) {
+            m_idle.wait();
+        }
+
+        m_waiting.store(false);
+    }
+
+    mutex                   m_writer;   //!< Held by writer, briefly by readers.
+    semaphore               m_idle;     //!< Signalled when last reader leaves.
+    std::atomic< int >      m_readers;  //!< Amount of readers, holding the lock.
+    std::atomic_bool        m_waiting;  //!< Writer waits for readers.
+};
+
+//!
+//! \brief Guard of shared ownership.
+//! \tparam Mutex Type with lock_shared() and unlock_shared(), i.e. shared_mutex.
+//!
+template< class Mutex >
+class shared_lock
+{
+public:
+    //!
+    //! \brief Takes shared ownership of the mutex.
+    //!
+    explicit shared_lock(Mutex &m)
+        :m_mutex{m}
+    {
+        m_mutex.lock_shared();
+    }
+
+    //!
+    //! \brief Releases shared ownership.
+    //!
+    ~shared_lock()
+    {
+        m_mutex.unlock_shared();
+    }
+
+    shared_lock(const shared_lock&)             = delete;
+    shared_lock& operator=(const shared_lock&)  = delete;
+
+private:
+    Mutex &m_mutex;     //!< Mutex, held in shared mode.
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_SHARED_MUTEX_
@@ -0,0 +1,101 @@
+#ifndef LIB_THREAD_SPSC_QUEUE_
+#define LIB_THREAD_SPSC_QUEUE_
+
+//!
+//! \file
+//! \brief Bounded lock-free single-producer single-consumer queue.
+//!
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace ecl
+{
+
+//!
+//! \brief Bounded lock-free SPSC queue.
+//! Suits the most common handoff: ISR produces data, single thread consumes
+//! it (or vice versa). Each index is written by one side only, so no
+//! read-modify-write operations are required, just acquire/release stores.
+//! Cheaper than mpmc_queue, but exactly one producer and one consumer
+//! are allowed at a time.
+//! \tparam T    Item type. Must be trivially copyable.
+//! \tparam size Capacity. Must be a power of two.
+//!
+template< class T, size_t size >
+class spsc_queue
+{
+    static_assert(size >= 2 && !(size & (size - 1)), "Size must be a power of two");
+    static_assert(std::is_trivially_copyable< T >::value, "Item must be trivially copyable");
+
+public:
+    spsc_queue()
+        :m_items{}
+        ,m_head{0}
+        ,m_tail{0}
+    {
+    }
+
+    //!
+    //! \brief Pushes item to the queue. Called by producer only.
+    //! \retval true  Item is pushed.
+    //! \retval false Queue is full.
+    //!
+    bool push(const T &item)
+    {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_head.load(std::memory_order_acquire) == size) {
+            return false;
+        }
+
+        m_items[tail & mask] = item;
+        // Publish item to the consumer
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //!
+    //! \brief Pops item from the queue. Called by consumer only.
+    //! \param[out] item Popped item.
+    //! \retval true  Item is popped.
+    //! \retval false Queue is empty.
+    //!
+    bool pop(T &item)
+    {
+        auto head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        item = m_items[head & mask];
+        // Hand the cell back to the producer
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //!
+    //! \brief Checks if queue is empty.
+    //! Result is exact only if called by producer or consumer.
+    //!
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    spsc_queue(const spsc_queue&)             = delete;
+    spsc_queue& operator=(const spsc_queue&)  = delete;
+
+private:
+    static constexpr size_t mask = size - 1;
+
+    T                       m_items[size];  //!< Storage.
+    std::atomic< size_t >   m_head;         //!< Next position to read.
+    std::atomic< size_t >   m_tail;         //!< Next position to write.
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_SPSC_QUEUE_
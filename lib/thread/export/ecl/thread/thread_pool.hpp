@@ -0,0 +1,199 @@
+#ifndef LIB_THREAD_THREAD_POOL_
+#define LIB_THREAD_THREAD_POOL_
+
+//!
+//! \file
+//! \brief Fixed-size pool of worker threads.
+//! Lets drivers and application run short jobs, like CRC computation or
+//! log formatting, without creating a thread per job.
+//!
+
+#include <ecl/err.hpp>
+#include <ecl/thread/thread.hpp>
+#include <ecl/thread/pool_scheduler.hpp>
+#include <ecl/assert.h>
+
+#ifdef CONFIG_THREAD_POOL_WORK_STEALING
+#include <ecl/thread/work_stealing.hpp>
+#endif
+
+#include <cstddef>
+
+namespace ecl
+{
+
+//!
+//! \brief Default scheduler of the thread pool.
+//! Work stealing is used where it is enabled (i.e. on host),
+//! single FIFO queue otherwise.
+//!
+template< size_t workers, size_t queue_size >
+#ifdef CONFIG_THREAD_POOL_WORK_STEALING
+using default_pool_scheduler = work_stealing_scheduler< workers, queue_size >;
+#else
+using default_pool_scheduler = fifo_scheduler< workers, queue_size >;
+#endif
+
+//!
+//! \brief Pool of worker threads, executing submitted jobs.
+//! Jobs are kept in lock-free queues, so submission never blocks and can
+//! be done from ISR. Any idle worker picks next job. Jobs may complete in
+//! any order. On host each worker is a separate thread, so jobs are spread
+//! across cores.
+//! \tparam threads    Amount of worker threads.
+//! \tparam stack_size Stack size of each worker.
+//! \tparam queue_size Maximum amount of pending jobs. Must be a power of two.
+//! \tparam scheduler  Job scheduler, see pool_scheduler.hpp.
+//! \par Example
+//! \code
+//! static ecl::thread_pool< 2, 1024 > pool;
+//!
+//! pool.start();
+//! pool.submit([](void *ctx) {
+//!     // Runs in one of workers
+//! }, &ctx);
+//! \endcode
+//!
+template< size_t threads, size_t stack_size, size_t queue_size = 16,
+          class scheduler = default_pool_scheduler< threads, queue_size > >
+class thread_pool
+{
+    static_assert(threads > 0, "Pool must have at least one worker");
+
+public:
+    //! Job routine.
+    using job_fn = void (*)(void *arg);
+
+    thread_pool()
+        :m_sched{}
+        ,m_ctx{}
+        ,m_workers{}
+        ,m_started{false}
+    {
+        for (size_t i = 0; i < threads; ++i) {
+            m_ctx[i] = worker_ctx{this, i};
+        }
+    }
+
+    ~thread_pool()
+    {
+        stop();
+    }
+
+    //!
+    //! \brief Creates and starts worker threads.
+    //! If any worker fails to start, workers started so far are stopped.
+    //! \retval err::busy Pool is already started.
+    //! \retval err::ok   Workers are started.
+    //! \return Error of the worker start otherwise.
+    //!
+    err start();
+
+    //!
+    //! \brief Submits a job.
+    //! Can be called from ISR or from a job.
+    //! \param[in] fn  Job routine. Must not be null.
+    //! \param[in] arg Job argument.
+    //! \retval err::nobufs Too many pending jobs.
+    //! \retval err::ok     Job is queued.
+    //!
+    err submit(job_fn fn, void *arg);
+
+    //!
+    //! \brief Executes pending jobs and stops workers.
+    //! Cannot be called from ISR or from a worker.
+    //!
+    void stop();
+
+    thread_pool(const thread_pool&)             = delete;
+    thread_pool& operator=(const thread_pool&)  = delete;
+
+private:
+    //! Worker thread argument.
+    struct worker_ctx
+    {
+        thread_pool *pool;  //!< Owner.
+        size_t      idx;    //!< Worker index.
+    };
+
+    //! Worker thread routine.
+    static err worker(void *arg);
+
+    scheduler       m_sched;            //!< Jobs.
+    worker_ctx      m_ctx[threads];     //!< Worker arguments.
+    native_thread   m_workers[threads]; //!< Worker threads.
+    bool            m_started;          //!< Workers are running.
+};
+
+//------------------------------------------------------------------------------
+
+template< size_t threads, size_t stack_size, size_t queue_size, class scheduler >
+err thread_pool< threads, stack_size, queue_size, scheduler >::start()
+{
+    if (m_started) {
+        return err::busy;
+    }
+
+    m_sched.restart();
+
+    for (size_t i = 0; i < threads; ++i) {
+        auto &w = m_workers[i];
+        w.set_stack_size(stack_size);
+        w.set_routine(worker, &m_ctx[i]);
+
+        auto rc = w.start();
+        if (is_error(rc)) {
+            // Workers, started so far, would outlive the pool otherwise
+            m_sched.stop();
+
+            for (size_t j = 0; j < i; ++j) {
+                m_workers[j].join();
+            }
+
+            return rc;
+        }
+    }
+
+    m_started = true;
+    return err::ok;
+}
+
+template< size_t threads, size_t stack_size, size_t queue_size, class scheduler >
+err thread_pool< threads, stack_size, queue_size, scheduler >::submit(job_fn fn, void *arg)
+{
+    ecl_assert(fn);
+    return m_sched.submit(pool_job{fn, arg});
+}
+
+template< size_t threads, size_t stack_size, size_t queue_size, class scheduler >
+void thread_pool< threads, stack_size, queue_size, scheduler >::stop()
+{
+    if (!m_started) {
+        return;
+    }
+
+    m_sched.stop();
+
+    for (auto &w : m_workers) {
+        w.join();
+    }
+
+    m_started = false;
+}
+
+template< size_t threads, size_t stack_size, size_t queue_size, class scheduler >
+err thread_pool< threads, stack_size, queue_size, scheduler >::worker(void *arg)
+{
+    auto ctx = static_cast< worker_ctx * >(arg);
+    pool_job j;
+
+    while (ctx->pool->m_sched.take(ctx->idx, j)) {
+        j.fn(j.arg);
+    }
+
+    return err::ok;
+}
+
+} // namespace ecl
+
+#endif // LIB_THREAD_THREAD_POOL_
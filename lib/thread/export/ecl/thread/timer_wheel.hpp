@@ -0,0 +1,296 @@
+#ifndef LIB_THREAD_TIMER_WHEEL_
+#define LIB_THREAD_TIMER_WHEEL_
+
+//!
+//! \file
+//! \brief Software timers, kept in hierarchical timer wheel.
+//! Lets drivers arm timeouts without keeping a thread parked in sleep.
+//! Wheel is driven by periodic tick, i.e. from SysTick or hardware timer ISR.
+//! Expired timers are executed by the deferred work queue.
+//!
+
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+#include <ecl/thread/mutex.hpp>
+#include <ecl/thread/work_queue.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace ecl
+{
+
+class timer_wheel;
+
+//!
+//! \brief Software timer.
+//! Timer is owned by the user and must outlive the wheel where it is armed.
+//!
+class soft_timer
+{
+public:
+    //!
+    //! \brief Constructs timer.
+    //! \param[in] fn Routine to execute on expiry. Runs in the work queue
+    //!               worker, thus blocking calls are allowed.
+    //!
+    explicit soft_timer(const std::function< void() > &fn)
+        :m_fn{fn}
+        ,m_next{nullptr}
+        ,m_pprev{nullptr}
+        ,m_fired{nullptr}
+        ,m_expires{0}
+        ,m_period{0}
+        ,m_armed{false}
+    {
+    }
+
+    //!
+    //! \brief Checks if timer is waiting for expiry.
+    //!
+    bool armed() const { return m_armed.load(); }
+
+    soft_timer(const soft_timer&)             = delete;
+    soft_timer& operator=(const soft_timer&)  = delete;
+
+private:
+    friend class timer_wheel;
+
+    std::function< void() > m_fn;       //!< Expiry routine.
+    soft_timer              *m_next;    //!< Next timer in the slot.
+    soft_timer              **m_pprev;  //!< Link, pointing to this timer.
+    soft_timer              *m_fired;   //!< Next expired timer.
+    uint32_t                m_expires;  //!< Tick of expiry.
+    uint32_t                m_period;   //!< Rearm period, zero if one-shot.
+    std::atomic_bool        m_armed;    //!< Timer is in the wheel.
+};
+
+//!
+//! \brief Hierarchical timer wheel.
+//! Each level has 64 slots, each slot of the next level spans whole previous
+//! level. Timers are placed to the slot of expiry, so arming and cancelling
+//! take constant time. Timers of upper levels are moved down (cascaded) once
+//! the lower level wraps.
+//! \par Example
+//! \code
+//! ecl::work_queue  queue;
+//! ecl::timer_wheel wheel{queue};
+//! ecl::soft_timer  timeout{[]() {
+//!     // Runs in work queue worker
+//! }};
+//!
+//! // From SysTick handler or FreeRTOS tick hook
+//! wheel.tick();
+//!
+//! // Elsewhere
+//! wheel.schedule(timeout, 100);
+//! \endcode
+//!
+class timer_wheel
+{
+    static constexpr size_t slot_bits   = 6;
+    static constexpr size_t slots       = 1 << slot_bits;
+    static constexpr size_t levels      = 4;
+    static constexpr uint32_t slot_mask = slots - 1;
+
+public:
+    //! Maximum delay, in ticks, that can be scheduled.
+    static constexpr uint32_t max_ticks = (1u << (slot_bits * levels)) - 1;
+
+    //!
+    //! \brief Constructs the wheel.
+    //! \param[in] queue Work queue, executing expired timers.
+    //!
+    explicit timer_wheel(work_queue &queue)
+        :m_queue(queue)
+        ,m_advance{[this]() { advance(); }}
+        ,m_lock{}
+        ,m_slots{}
+        ,m_now{0}
+        ,m_ticks{0}
+    {
+    }
+
+    //!
+    //! \brief Counts one tick and lets the work queue process it.
+    //! Can be called from ISR. Never blocks.
+    //!
+    void tick()
+    {
+        m_ticks++;
+        // Several ticks can be served by single post
+        m_queue.post(m_advance);
+    }
+
+    //!
+    //! \brief Arms the timer. Rearms it, if it is already armed.
+    //! Cannot be called from ISR.
+    //! \param[in] timer  Timer to arm.
+    //! \param[in] ticks  Delay in ticks, no more than max_ticks.
+    //!                   Zero delay expires on the next tick.
+    //! \param[in] period Rearm period in ticks. Zero means one-shot timer.
+    //!
+    void schedule(soft_timer &timer, uint32_t ticks, uint32_t period = 0)
+    {
+        ecl_assert(ticks <= max_ticks && period <= max_ticks);
+
+        m_lock.lock();
+
+        if (timer.m_armed) {
+            unlink(timer);
+        }
+
+        // Deadline is counted from the latest tick,
+        // even if the wheel didn't catch up yet
+        timer.m_expires = m_ticks.load() + (ticks ? ticks : 1);
+        timer.m_period  = period;
+        timer.m_armed   = true;
+        link(timer);
+
+        m_lock.unlock();
+    }
+
+    //!
+    //! \brief Disarms the timer.
+    //! Cannot be called from ISR.
+    //! \retval err::ok    Timer is disarmed.
+    //! \retval err::again Timer is not armed. It may be executing right now.
+    //!
+    err cancel(soft_timer &timer)
+    {
+        err rc = err::again;
+
+        m_lock.lock();
+
+        if (timer.m_armed) {
+            unlink(timer);
+            timer.m_armed = false;
+            rc = err::ok;
+        }
+
+        m_lock.unlock();
+        return rc;
+    }
+
+    //!
+    //! \brief Processes counted ticks and executes expired timers.
+    //! Called by the work queue. Cannot be called from ISR.
+    //!
+    void advance()
+    {
+        auto target = m_ticks.load();
+
+        while (m_now != target) {
+            m_lock.lock();
+            auto expired = step();
+            m_lock.unlock();
+
+            // Routines run without lock, so they can rearm timers
+            while (expired) {
+                auto next = expired->m_fired;
+                expired->m_fired = nullptr;
+                expired->m_fn();
+                expired = next;
+            }
+        }
+    }
+
+    timer_wheel(const timer_wheel&)             = delete;
+    timer_wheel& operator=(const timer_wheel&)  = delete;
+
+private:
+    //! Places timer to the slot of its expiry.
+    void link(soft_timer &timer)
+    {
+        auto delta = timer.m_expires - m_now;
+        size_t level = 0;
+
+        while (level < levels - 1 && delta >= (1u << (slot_bits * (level + 1)))) {
+            ++level;
+        }
+
+        auto &head = m_slots[level][(timer.m_expires >> (slot_bits * level)) & slot_mask];
+
+        timer.m_next  = head;
+        timer.m_pprev = &head;
+        if (head) {
+            head->m_pprev = &timer.m_next;
+        }
+        head = &timer;
+    }
+
+    //! Removes timer from its slot.
+    void unlink(soft_timer &timer)
+    {
+        *timer.m_pprev = timer.m_next;
+        if (timer.m_next) {
+            timer.m_next->m_pprev = timer.m_pprev;
+        }
+
+        timer.m_next  = nullptr;
+        timer.m_pprev = nullptr;
+    }
+
+    //! Advances wheel by one tick. Returns list of expired timers.
+    soft_timer *step()
+    {
+        ++m_now;
+
+        // Move timers down, each time lower level wraps
+        for (size_t level = 1; level < levels; ++level) {
+            if ((m_now >> (slot_bits * (level - 1))) & slot_mask) {
+                break;
+            }
+
+            auto &head = m_slots[level][(m_now >> (slot_bits * level)) & slot_mask];
+            auto timer = head;
+            head = nullptr;
+
+            while (timer) {
+                auto next = timer->m_next;
+                link(*timer);
+                timer = next;
+            }
+        }
+
+        auto &head = m_slots[0][m_now & slot_mask];
+        auto timer = head;
+        head = nullptr;
+
+        soft_timer *expired = nullptr;
+
+        while (timer) {
+            auto next = timer->m_next;
+
+            if (timer->m_period) {
+                timer->m_expires += timer->m_period;
+                link(*timer);
+            } else {
+                timer->m_next  = nullptr;
+                timer->m_pprev = nullptr;
+                timer->m_armed = false;
+            }
+
+            // Periodic timer is in the wheel already, thus separate
+            // link is used for the list of expired timers
+            timer->m_fired = expired;
+            expired = timer;
+            timer = next;
+        }
+
+        return expired;
+    }
+
+    work_queue              &m_queue;                   //!< Executes timers.
+    work_item               m_advance;                  //!< Processes ticks.
+    mutex                   m_lock;                     //!< Protects slots.
+    soft_timer              *m_slots[levels][slots];    //!< Armed timers.
+    uint32_t                m_now;                      //!< Processed ticks.
+    std::atomic< uint32_t > m_ticks;                    //!< Counted ticks.
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_TIMER_WHEEL_
@@ -0,0 +1,177 @@
+#ifndef LIB_THREAD_WORK_QUEUE_
+#define LIB_THREAD_WORK_QUEUE_
+
+//!
+//! \file
+//! \brief Deferred work queue.
+//! Lets drivers split interrupt handling into two parts: short top half that
+//! runs in ISR and posts a work item, and bottom half that is executed later
+//! by a worker thread, where it can block and use mutexes.
+//!
+
+#include <ecl/err.hpp>
+#include <ecl/thread/semaphore.hpp>
+
+#include <atomic>
+#include <functional>
+
+namespace ecl
+{
+
+class work_queue;
+
+//!
+//! \brief Unit of deferred work.
+//! Item is owned by the user and must outlive the queue where it is posted.
+//! Item cannot be posted twice: while it is pending, subsequent posts are
+//! coalesced into one execution.
+//!
+class work_item
+{
+public:
+    //!
+    //! \brief Constructs work item.
+    //! \param[in] fn Routine to execute in the worker context.
+    //!
+    explicit work_item(const std::function< void() > &fn)
+        :m_fn{fn}
+        ,m_next{nullptr}
+        ,m_pending{false}
+    {
+    }
+
+    //!
+    //! \brief Checks if item is waiting for execution.
+    //!
+    bool pending() const { return m_pending.load(); }
+
+    work_item(const work_item&)             = delete;
+    work_item& operator=(const work_item&)  = delete;
+
+private:
+    friend class work_queue;
+
+    std::function< void() > m_fn;       //!< Work routine.
+    work_item               *m_next;    //!< Next item in the queue.
+    std::atomic_bool        m_pending;  //!< Item is queued.
+};
+
+//!
+//! \brief Queue of deferred work items.
+//! Items can be posted from any context, including ISR. Posting is lock-free.
+//! Items are executed in posting order by a single worker.
+//! \par Example
+//! \code
+//! ecl::work_queue  queue;
+//! ecl::work_item   done{[]() {
+//!     // Runs in worker thread. Blocking calls are allowed.
+//! }};
+//!
+//! bus::xfer([](ecl::bus_channel ch, ecl::bus_event type, size_t total) {
+//!     if (ch == ecl::bus_channel::meta && type == ecl::bus_event::tc) {
+//!         queue.post(done);
+//!     }
+//! });
+//!
+//! thread.set_routine(ecl::work_queue::worker, &queue);
+//! thread.set_affinity(1 << 1);    // SMP: completions run on the second core
+//! \endcode
+//!
+class work_queue
+{
+public:
+    work_queue()
+        :m_head{nullptr}
+        ,m_sem{}
+    {
+    }
+
+    //!
+    //! \brief Posts item to the queue and wakes up the worker.
+    //! Can be called from ISR.
+    //! \param[in] item Item to execute.
+    //! \retval err::ok    Item is posted.
+    //! \retval err::again Item is already pending and will be executed once.
+    //!
+    err post(work_item &item)
+    {
+        if (item.m_pending.exchange(true)) {
+            return err::again;
+        }
+
+        auto head = m_head.load();
+        do {
+            item.m_next = head;
+        } while (!m_head.compare_exchange_weak(head, &item));
+
+        m_sem.signal();
+        return err::ok;
+    }
+
+    //!
+    //! \brief Waits for posted items and executes all of them.
+    //! Cannot be called from ISR.
+    //!
+    void run_once()
+    {
+        m_sem.wait();
+        drain();
+    }
+
+    //!
+    //! \brief Executes all posted items, if any, without blocking.
+    //! Cannot be called from ISR.
+    //!
+    void drain()
+    {
+        // Items are pushed in LIFO order, reverse them
+        // to preserve posting order.
+        work_item *item = nullptr;
+        auto head = m_head.exchange(nullptr);
+
+        while (head) {
+            auto next = head->m_next;
+            head->m_next = item;
+            item = head;
+            head = next;
+        }
+
+        while (item) {
+            auto next = item->m_next;
+            item->m_next = nullptr;
+
+            // Item can be posted again right from its routine
+            item->m_pending = false;
+            item->m_fn();
+
+            item = next;
+        }
+    }
+
+    //!
+    //! \brief Worker routine, suitable for ecl::native_thread::set_routine().
+    //! Runs forever.
+    //! \param[in] arg Pointer to the work queue.
+    //!
+    static err worker(void *arg)
+    {
+        auto queue = static_cast< work_queue * >(arg);
+
+        for (;;) {
+            queue->run_once();
+        }
+
+        return err::ok;
+    }
+
+    work_queue(const work_queue&)             = delete;
+    work_queue& operator=(const work_queue&)  = delete;
+
+private:
+    std::atomic< work_item * >  m_head; //!< Posted items, most recent first.
+    semaphore                   m_sem;  //!< Counts posts.
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_WORK_QUEUE_
@@ -0,0 +1,255 @@
+#ifndef LIB_THREAD_WORK_STEALING_
+#define LIB_THREAD_WORK_STEALING_
+
+//!
+//! \file
+//! \brief Work-stealing scheduler for the thread pool.
+//! Each worker keeps jobs, that it submits itself, in its own deque.
+//! Idle workers steal from others, so load spreads over all cores
+//! without a single contended queue. Intended for host builds.
+//!
+
+#include <ecl/err.hpp>
+#include <ecl/thread/semaphore.hpp>
+#include <ecl/thread/mpmc_queue.hpp>
+#include <ecl/thread/pool_scheduler.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Bounded Chase-Lev work-stealing deque.
+//! Owner pushes and pops at the bottom in LIFO order, keeping recently
+//! spawned (cache-hot) jobs local. Thieves steal from the top, taking
+//! the oldest jobs.
+//! \tparam size Capacity. Must be a power of two.
+//!
+template< size_t size >
+class ws_deque
+{
+    static_assert(size >= 2 && !(size & (size - 1)), "Size must be a power of two");
+
+public:
+    ws_deque()
+        :m_top{0}
+        ,m_bottom{0}
+        ,m_fn{}
+        ,m_arg{}
+    {
+    }
+
+    //!
+    //! \brief Pushes job to the bottom. Called by owner only.
+    //! \retval false Deque is full.
+    //!
+    bool push(const pool_job &job)
+    {
+        auto b = m_bottom.load(std::memory_order_relaxed);
+        auto t = m_top.load(std::memory_order_acquire);
+
+        if (b - t >= static_cast< int64_t >(size)) {
+            return false;
+        }
+
+        m_fn[b & mask].store(job.fn, std::memory_order_relaxed);
+        m_arg[b & mask].store(job.arg, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    //!
+    //! \brief Pops job from the bottom. Called by owner only.
+    //! \retval false Deque is empty.
+    //!
+    bool pop(pool_job &job)
+    {
+        auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = m_top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Empty
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        read(b, job);
+
+        if (t == b) {
+            // Last job, race with thieves for it
+            bool won = m_top.compare_exchange_strong(t, t + 1,
+                                                     std::memory_order_seq_cst,
+                                                     std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+
+        return true;
+    }
+
+    //!
+    //! \brief Steals job from the top. Can be called by anyone.
+    //! \retval false Deque is empty or steal lost a race.
+    //!
+    bool steal(pool_job &job)
+    {
+        auto t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto b = m_bottom.load(std::memory_order_acquire);
+
+        if (t >= b) {
+            return false;
+        }
+
+        // Cell can't be reused until top moves, so the values
+        // are valid if CAS succeeds.
+        read(t, job);
+
+        return m_top.compare_exchange_strong(t, t + 1,
+                                             std::memory_order_seq_cst,
+                                             std::memory_order_relaxed);
+    }
+
+    ws_deque(const ws_deque&)             = delete;
+    ws_deque& operator=(const ws_deque&)  = delete;
+
+private:
+    static constexpr int64_t mask = size - 1;
+
+    using job_fn = void (*)(void *);
+
+    void read(int64_t idx, pool_job &job)
+    {
+        job.fn  = m_fn[idx & mask].load(std::memory_order_relaxed);
+        job.arg = m_arg[idx & mask].load(std::memory_order_relaxed);
+    }
+
+    std::atomic< int64_t >  m_top;          //!< Next job to steal.
+    std::atomic< int64_t >  m_bottom;       //!< Next free cell of the owner.
+    std::atomic< job_fn >   m_fn[size];     //!< Job routines.
+    std::atomic< void * >   m_arg[size];    //!< Job arguments.
+};
+
+//!
+//! \brief Work-stealing scheduler.
+//! Jobs submitted by a worker go to its own deque. Jobs submitted from
+//! outside go to the shared injection queue. Worker looks for a job in its
+//! deque first, then in the injection queue, then steals from others.
+//! \tparam workers    Amount of workers.
+//! \tparam queue_size Capacity of each deque and of the injection queue.
+//!                    Must be a power of two.
+//!
+template< size_t workers, size_t queue_size >
+class work_stealing_scheduler
+{
+public:
+    work_stealing_scheduler()
+        :m_deques{}
+        ,m_inject{}
+        ,m_sem{}
+        ,m_stop{false}
+    {
+    }
+
+    err submit(const pool_job &job)
+    {
+        auto self = current();
+
+        // Worker keeps its jobs locally, if there is a room
+        if (!(self < workers && m_deques[self].push(job)) && !m_inject.push(job)) {
+            return err::nobufs;
+        }
+
+        // Wake up someone to take or steal the job
+        m_sem.signal();
+        return err::ok;
+    }
+
+    bool take(size_t worker, pool_job &job)
+    {
+        tls() = worker_info{this, worker};
+
+        for (;;) {
+            if (find(worker, job)) {
+                return true;
+            }
+
+            if (m_stop) {
+                // Pass wakeup to the next worker
+                m_sem.signal();
+                return false;
+            }
+
+            // Each job is accompanied by a signal, so a worker can't sleep
+            // while there is a job nobody is going to take.
+            m_sem.wait();
+        }
+    }
+
+    void stop()
+    {
+        m_stop = true;
+        m_sem.signal();
+    }
+
+    void restart()
+    {
+        m_stop = false;
+    }
+
+    work_stealing_scheduler(const work_stealing_scheduler&)             = delete;
+    work_stealing_scheduler& operator=(const work_stealing_scheduler&)  = delete;
+
+private:
+    //! Worker, running in the current thread.
+    struct worker_info
+    {
+        const void  *owner; //!< Scheduler of the worker.
+        size_t      idx;    //!< Worker index.
+    };
+
+    static worker_info &tls()
+    {
+        static thread_local worker_info info{nullptr, 0};
+        return info;
+    }
+
+    //! Gets index of the worker running in the current thread.
+    //! Index is out of range for non-worker threads.
+    size_t current() const
+    {
+        auto &info = tls();
+        return info.owner == this ? info.idx : workers;
+    }
+
+    bool find(size_t worker, pool_job &job)
+    {
+        if (m_deques[worker].pop(job) || m_inject.pop(job)) {
+            return true;
+        }
+
+        // Start from the neighbour, so thieves don't pile on one victim
+        for (size_t i = 1; i < workers; ++i) {
+            if (m_deques[(worker + i) % workers].steal(job)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    ws_deque< queue_size >              m_deques[workers];  //!< Per-worker jobs.
+    mpmc_queue< pool_job, queue_size >  m_inject;           //!< External jobs.
+    semaphore                           m_sem;              //!< Counts submissions.
+    std::atomic_bool                    m_stop;             //!< Workers must exit.
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_WORK_STEALING_
@@ -0,0 +1,55 @@
+#include <ecl/thread/completion.hpp>
+#include <os/signal.hpp>
+
+#include <FreeRTOS.h>
+
+void ecl::completion::signal()
+{
+    m_done = true;
+
+    // Waiter registers itself before it checks the event,
+    // so either it sees the event or it is notified here.
+    auto waiter = m_waiter.load();
+    if (waiter) {
+        os::signal::send(waiter);
+    }
+}
+
+void ecl::completion::wait()
+{
+    m_waiter = os::this_thread::get_handle();
+
+    while (!m_done.exchange(false)) {
+        os::signal::wait();
+    }
+
+    m_waiter = nullptr;
+}
+
+ecl::err ecl::completion::try_wait()
+{
+    return m_done.exchange(false) ? ecl::err::ok : ecl::err::again;
+}
+
+ecl::err ecl::completion::wait_for(uint32_t msecs)
+{
+    auto rc = ecl::err::ok;
+    auto deadline = os::get_ticks() + os::ms_to_ticks(msecs);
+
+    m_waiter = os::this_thread::get_handle();
+
+    while (!m_done.exchange(false)) {
+        // Difference is signed to survive tick wrap
+        auto left = static_cast< int32_t >(deadline - os::get_ticks());
+        if (left <= 0) {
+            rc = ecl::err::timedout;
+            break;
+        }
+
+        // Notification can be stale, event flag is checked again anyway
+        os::signal::wait_for(left * portTICK_PERIOD_MS);
+    }
+
+    m_waiter = nullptr;
+    return rc;
+}
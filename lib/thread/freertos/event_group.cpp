@@ -0,0 +1,91 @@
+#include <ecl/thread/event_group.hpp>
+#include <os/utils.hpp>
+#include <ecl/assert.h>
+
+#include <platform/utils.hpp>
+
+namespace
+{
+
+// Bits, reserved by FreeRTOS for its own use
+#if configUSE_16_BIT_TICKS == 1
+constexpr ecl::event_group::bits_type reserved_bits = 0xff00;
+#else
+constexpr ecl::event_group::bits_type reserved_bits = 0xff000000;
+#endif
+
+}
+
+ecl::event_group::event_group()
+    :m_group{nullptr}
+{
+    m_group = xEventGroupCreate();
+    ecl_assert(m_group);
+}
+
+ecl::event_group::~event_group()
+{
+    vEventGroupDelete(m_group);
+}
+
+void ecl::event_group::set(bits_type bits)
+{
+    ecl_assert(!(bits & reserved_bits));
+
+    if (!ecl::in_isr()) {
+        xEventGroupSetBits(m_group, bits);
+        return;
+    }
+
+#if configUSE_TIMERS && INCLUDE_xTimerPendFunctionCall
+    BaseType_t woken = pdFALSE;
+
+    // Can fail if timer queue is full, event will be lost then
+    xEventGroupSetBitsFromISR(m_group, bits, &woken);
+    portYIELD_FROM_ISR(woken);
+#else
+    ecl_assert_msg(false, "Setting event bits from ISR requires FreeRTOS timers");
+#endif
+}
+
+void ecl::event_group::clear(bits_type bits)
+{
+    ecl_assert(!ecl::in_isr());
+    xEventGroupClearBits(m_group, bits);
+}
+
+ecl::event_group::bits_type ecl::event_group::get() const
+{
+    if (ecl::in_isr()) {
+        return xEventGroupGetBitsFromISR(m_group);
+    }
+
+    return xEventGroupGetBits(m_group);
+}
+
+ecl::event_group::bits_type ecl::event_group::wait(bits_type bits, bool all)
+{
+    bits_type got = 0;
+    bool rc = take(bits, all, portMAX_DELAY, got);
+    ecl_assert(rc);
+    (void) rc;
+    return got;
+}
+
+ecl::err ecl::event_group::wait_for(bits_type bits, uint32_t msecs,
+                                    bits_type &got, bool all)
+{
+    return take(bits, all, os::ms_to_ticks(msecs), got) ? err::ok : err::timedout;
+}
+
+bool ecl::event_group::take(bits_type bits, bool all, TickType_t ticks, bits_type &got)
+{
+    ecl_assert(!ecl::in_isr());
+    ecl_assert(bits && !(bits & reserved_bits));
+
+    // Bits are returned as they were before clearing on exit
+    auto cur = xEventGroupWaitBits(m_group, bits, pdTRUE, all ? pdTRUE : pdFALSE, ticks);
+    got = cur & bits;
+
+    return all ? got == bits : got != 0;
+}
@@ -0,0 +1,71 @@
+#ifndef LIB_THREAD_FREERTOS_COMPLETION_HPP_
+#define LIB_THREAD_FREERTOS_COMPLETION_HPP_
+
+#include <os/utils.hpp>
+
+#include <ecl/err.hpp>
+
+#include <atomic>
+
+namespace ecl
+{
+
+//!
+//! \brief Completion event with single waiter.
+//! Behaves like a binary semaphore, but wakes up its waiter with FreeRTOS
+//! direct-to-task notification instead of going through a queue.
+//! It is faster and doesn't allocate kernel objects.
+//! \warning Only one thread at a time can wait for completion.
+//! \note    Notification can be left pending in the waiter thread if event
+//!          arrives just before wait starts. Thus os::signal::wait() in the
+//!          same thread can be woken up spuriously.
+//!
+class completion
+{
+public:
+    constexpr completion()
+        :m_waiter{nullptr}
+        ,m_done{false}
+    {
+    }
+
+    //!
+    //! \brief Signals completion.
+    //! Can be called from ISR. Multiple signals without waiting
+    //! are delivered as one event.
+    //!
+    void signal();
+
+    //!
+    //! \brief Waits for completion.
+    //! Cannot be called from ISR.
+    //!
+    void wait();
+
+    //!
+    //! \brief Consumes completion event, if any, without blocking.
+    //! \retval err::again  No completion signalled.
+    //! \retval err::ok     Event consumed.
+    //!
+    ecl::err try_wait();
+
+    //!
+    //! \brief Waits for completion during given time.
+    //! Cannot be called from ISR.
+    //! \param[in] msecs Timeout in milliseconds.
+    //! \retval err::timedout Completion was not signalled in time.
+    //! \retval err::ok       Event consumed.
+    //!
+    ecl::err wait_for(uint32_t msecs);
+
+    completion(const completion&)             = delete;
+    completion& operator=(const completion&)  = delete;
+
+private:
+    std::atomic< os::thread_handle >    m_waiter;   //!< Thread to notify.
+    std::atomic_bool                    m_done;     //!< Pending event.
+};
+
+}
+
+#endif // LIB_THREAD_FREERTOS_COMPLETION_HPP_
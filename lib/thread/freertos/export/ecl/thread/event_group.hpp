@@ -0,0 +1,81 @@
+#ifndef LIB_THREAD_FREERTOS_EVENT_GROUP_HPP_
+#define LIB_THREAD_FREERTOS_EVENT_GROUP_HPP_
+
+#include <FreeRTOS.h>
+#include <event_groups.h>
+
+#include <ecl/err.hpp>
+
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief FreeRTOS-based event group.
+//! Lets single thread wait for many events at once, i.e. for completions
+//! of several buses, instead of keeping a thread per event.
+//! \note Only lower 24 bits are available, if configUSE_16_BIT_TICKS is 0.
+//!       Otherwise, only lower 8 bits are available.
+//!
+class event_group
+{
+public:
+    using bits_type = uint32_t;
+
+    event_group();
+    ~event_group();
+
+    //!
+    //! \brief Sets given bits and wakes up waiters.
+    //! Can be called from ISR. From ISR bits are set by the timer task,
+    //! thus configUSE_TIMERS and INCLUDE_xTimerPendFunctionCall must be enabled.
+    //!
+    void set(bits_type bits);
+
+    //!
+    //! \brief Clears given bits.
+    //! Cannot be called from ISR.
+    //!
+    void clear(bits_type bits);
+
+    //!
+    //! \brief Gets current bits.
+    //! Can be called from ISR.
+    //!
+    bits_type get() const;
+
+    //!
+    //! \brief Waits until any (or all) of given bits are set.
+    //! Cannot be called from ISR.
+    //! \param[in] bits Bits to wait for.
+    //! \param[in] all  Wait for all bits, rather than for any of them.
+    //! \return Awaited bits, that are set. These bits are cleared.
+    //!
+    bits_type wait(bits_type bits, bool all = false);
+
+    //!
+    //! \brief Waits until any (or all) of given bits are set, during given time.
+    //! Cannot be called from ISR.
+    //! \param[in]  bits  Bits to wait for.
+    //! \param[in]  msecs Timeout in milliseconds.
+    //! \param[out] got   Awaited bits, that are set. These bits are cleared.
+    //! \param[in]  all   Wait for all bits, rather than for any of them.
+    //! \retval err::timedout Bits were not set in time.
+    //! \retval err::ok       Wait condition is met.
+    //!
+    ecl::err wait_for(bits_type bits, uint32_t msecs, bits_type &got, bool all = false);
+
+    event_group(const event_group&)             = delete;
+    event_group& operator=(const event_group&)  = delete;
+
+private:
+    //! Waits for bits no longer than given amount of ticks.
+    bool take(bits_type bits, bool all, TickType_t ticks, bits_type &got);
+
+    EventGroupHandle_t m_group;
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_FREERTOS_EVENT_GROUP_HPP_
@@ -4,9 +4,24 @@
 #include <FreeRTOS.h>
 #include <semphr.h>
 
+#include <atomic>
+#include <cstdint>
+
 namespace ecl
 {
 
+// Lock usage counters, collected if CONFIG_MUTEX_STATS is set
+struct mutex_stats
+{
+    uint32_t locks;     // Successful acquisitions
+    uint32_t contended; // Acquisitions that had to wait for the owner
+    uint32_t timeouts;  // Failed try_lock() and try_lock_for() calls
+};
+
+// Mutex with priority inheritance: a low-priority owner is raised to
+// the priority of the highest waiter until it unlocks the mutex.
+// Thus waiting time of high-priority task is bounded by the critical
+// section length of the owner, not by the work of medium-priority tasks.
 class mutex
 {
 public:
@@ -17,10 +32,55 @@ public:
     void unlock();
     bool try_lock();
 
+    // Tries to lock a mutex during given time, in milliseconds
+    bool try_lock_for(uint32_t msecs);
+
+    // Gets lock counters. Zeroes if CONFIG_MUTEX_STATS is not set
+    mutex_stats get_stats() const;
+
     mutex(const mutex&)             = delete;
     mutex& operator=(const mutex&)  = delete;
 private:
+    bool take(TickType_t ticks);
+
+    SemaphoreHandle_t m_mutex;
+#ifdef CONFIG_MUTEX_STATS
+    uint32_t                    m_locks;
+    uint32_t                    m_contended;
+    std::atomic< uint32_t >     m_timeouts;
+#endif
+};
+
+// Mutex that can be locked by its owner repeatedly.
+// It must be unlocked as many times as it was locked.
+// Priority inheritance is provided as for ordinary mutex.
+class recursive_mutex
+{
+public:
+    recursive_mutex();
+    ~recursive_mutex();
+
+    void lock();
+    void unlock();
+    bool try_lock();
+
+    // Tries to lock a mutex during given time, in milliseconds
+    bool try_lock_for(uint32_t msecs);
+
+    // Gets lock counters. Zeroes if CONFIG_MUTEX_STATS is not set
+    mutex_stats get_stats() const;
+
+    recursive_mutex(const recursive_mutex&)             = delete;
+    recursive_mutex& operator=(const recursive_mutex&)  = delete;
+private:
+    bool take(TickType_t ticks);
+
     SemaphoreHandle_t m_mutex;
+#ifdef CONFIG_MUTEX_STATS
+    uint32_t                    m_locks;
+    uint32_t                    m_contended;
+    std::atomic< uint32_t >     m_timeouts;
+#endif
 };
 
 }
@@ -5,6 +5,7 @@
 #include <semphr.h>
 
 #include <ecl/err.hpp>
+#include <os/utils.hpp>
 
 namespace ecl
 {
@@ -38,6 +39,24 @@ public:
     //!
     ecl::err try_wait();
 
+    //!
+    //! \brief Waits a semaphore during given time.
+    //! Cannot be called from ISR.
+    //! \param[in] msecs Timeout in milliseconds.
+    //! \retval err::timedout Semaphore was not signalled in time.
+    //! \retval err::ok       Semaphore counter decremented.
+    //!
+    ecl::err wait_for(uint32_t msecs);
+
+    //!
+    //! \brief Waits a semaphore until given kernel tick.
+    //! Cannot be called from ISR.
+    //! \param[in] tick Deadline, see os::get_ticks().
+    //! \retval err::timedout Semaphore was not signalled in time.
+    //! \retval err::ok       Semaphore counter decremented.
+    //!
+    ecl::err wait_until(os::tick_type tick);
+
     semaphore(const semaphore&)             = delete;
     semaphore& operator=(const semaphore&)  = delete;
 
@@ -78,6 +97,24 @@ public:
     //!
     ecl::err try_wait();
 
+    //!
+    //! \brief Waits a semaphore during given time.
+    //! Cannot be called from ISR.
+    //! \param[in] msecs Timeout in milliseconds.
+    //! \retval err::timedout Semaphore was not signalled in time.
+    //! \retval err::ok       Semaphore counter decremented.
+    //!
+    ecl::err wait_for(uint32_t msecs);
+
+    //!
+    //! \brief Waits a semaphore until given kernel tick.
+    //! Cannot be called from ISR.
+    //! \param[in] tick Deadline, see os::get_ticks().
+    //! \retval err::timedout Semaphore was not signalled in time.
+    //! \retval err::ok       Semaphore counter decremented.
+    //!
+    ecl::err wait_until(os::tick_type tick);
+
     binary_semaphore(const semaphore&)             = delete;
     binary_semaphore& operator=(const semaphore&)  = delete;
 
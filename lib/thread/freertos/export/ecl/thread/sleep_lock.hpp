@@ -0,0 +1,32 @@
+#ifndef LIB_THREAD_FREERTOS_SLEEP_LOCK_HPP_
+#define LIB_THREAD_FREERTOS_SLEEP_LOCK_HPP_
+
+extern "C" void kernel_sleep_inhibit();
+extern "C" void kernel_sleep_allow();
+
+namespace ecl
+{
+
+//!
+//! \brief Keeps MCU from sleeping in tickless idle.
+//! Held while DMA or bus transaction is pending, so its completion isn't
+//! delayed by wake-up from sleep. Locks are counted, each acquire() must be
+//! paired with release().
+//!
+class sleep_lock
+{
+public:
+    //!
+    //! \brief Inhibits sleep. Can be called from ISR.
+    //!
+    static void acquire() { kernel_sleep_inhibit(); }
+
+    //!
+    //! \brief Allows sleep, if there is no more locks. Can be called from ISR.
+    //!
+    static void release() { kernel_sleep_allow(); }
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_FREERTOS_SLEEP_LOCK_HPP_
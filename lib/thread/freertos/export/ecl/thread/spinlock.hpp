@@ -0,0 +1,102 @@
+#ifndef LIB_THREAD_FREERTOS_SPINLOCK_HPP_
+#define LIB_THREAD_FREERTOS_SPINLOCK_HPP_
+
+//!
+//! \file
+//! \brief Spinlock, safe against ISRs and other cores.
+//! Protects short sections, shared between threads and ISRs, possibly
+//! running on different cores:
+//! \code
+//!     ecl::spinlock lock;
+//!
+//!     lock.lock();
+//!     stats.count++;
+//!     lock.unlock();
+//! \endcode
+//!
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <atomic>
+
+//! Kernel runs tasks on more than one core.
+#if defined(configNUMBER_OF_CORES) && configNUMBER_OF_CORES > 1
+#define ECL_SPINLOCK_SMP 1
+#else
+#define ECL_SPINLOCK_SMP 0
+#endif
+
+//! Core has exclusive access instructions, so the lock can spin on its own flag.
+//! Otherwise, i.e. on Cortex-M0+, the lock of the port is taken. It is backed
+//! by a hardware spinlock, where the part has one.
+#if ECL_SPINLOCK_SMP && ATOMIC_BOOL_LOCK_FREE == 2
+#define ECL_SPINLOCK_ATOMIC 1
+#else
+#define ECL_SPINLOCK_ATOMIC 0
+#endif
+
+namespace ecl
+{
+
+//!
+//! \brief Lock, that masks interrupts on the calling core and spins
+//!        until other cores release it.
+//! On single-core kernels it only masks interrupts. Sections must be short
+//! and must not block, since other cores spin meanwhile. Can be used from ISRs.
+//! Lock is not recursive.
+//!
+class spinlock
+{
+public:
+    spinlock() = default;
+
+    //!
+    //! \brief Takes the lock.
+    //!
+    void lock()
+    {
+#if ECL_SPINLOCK_ATOMIC
+        UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+
+        while (m_flag.test_and_set(std::memory_order_acquire)) { }
+#elif ECL_SPINLOCK_SMP
+        UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+#else
+        UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+#endif
+
+        // Written by the owner only
+        m_mask = mask;
+    }
+
+    //!
+    //! \brief Releases the lock and restores interrupts of the calling core.
+    //!
+    void unlock()
+    {
+        UBaseType_t mask = m_mask;
+
+#if ECL_SPINLOCK_ATOMIC
+        m_flag.clear(std::memory_order_release);
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+#elif ECL_SPINLOCK_SMP
+        taskEXIT_CRITICAL_FROM_ISR(mask);
+#else
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+#endif
+    }
+
+    spinlock(const spinlock&)             = delete;
+    spinlock& operator=(const spinlock&)  = delete;
+
+private:
+#if ECL_SPINLOCK_ATOMIC
+    std::atomic_flag    m_flag = ATOMIC_FLAG_INIT;  //!< Set while taken.
+#endif
+    UBaseType_t         m_mask = 0;                 //!< Interrupt state of the owner.
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_FREERTOS_SPINLOCK_HPP_
@@ -0,0 +1,185 @@
+#ifndef LIB_THREAD_FREERTOS_STATIC_THREAD_HPP_
+#define LIB_THREAD_FREERTOS_STATIC_THREAD_HPP_
+
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+#include <ecl/thread/thread.hpp>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+static_assert(configSUPPORT_STATIC_ALLOCATION,
+              "Static allocation must be enabled in FreeRTOS config");
+
+namespace ecl
+{
+
+//!
+//! \brief Thread with stack and control block allocated at compile time.
+//! Unlike native_thread it doesn't touch the heap, so it can't fail on start
+//! due to lack of memory and starts faster. Place it in static storage:
+//! \code
+//! static ecl::static_thread< 1024 > worker;
+//!
+//! worker.set_routine(worker_fn, nullptr);
+//! worker.start();
+//! \endcode
+//! \tparam stack_size Stack size in bytes.
+//!
+template< size_t stack_size >
+class static_thread
+{
+    static_assert(stack_size >= configMINIMAL_STACK_SIZE * sizeof(StackType_t),
+                  "Stack is smaller than FreeRTOS minimum");
+
+public:
+    using routine = native_thread::routine;
+
+    static_thread()
+        :m_tcb{}
+        ,m_task{nullptr}
+        ,m_name{0}
+        ,m_fn{nullptr}
+        ,m_arg{nullptr}
+        ,m_prio{tskIDLE_PRIORITY}
+    {
+    }
+
+    //!
+    //! \brief Sets thread name.
+    //! \retval err::nobufs Name is too long.
+    //! \retval err::busy   Thread is already started.
+    //!
+    ecl::err set_name(const char *name)
+    {
+        size_t len = strlen(name);
+        if (len >= sizeof(m_name)) {
+            return err::nobufs;
+        }
+
+        if (m_task) {
+            return err::busy;
+        }
+
+        // Copy null-terminator as well
+        std::copy(name, name + len + 1, m_name);
+        return err::ok;
+    }
+
+    //!
+    //! \brief Sets thread priority.
+    //! \retval err::busy Thread is already started.
+    //!
+    ecl::err set_priority(UBaseType_t prio)
+    {
+        if (m_task) {
+            return err::busy;
+        }
+
+        m_prio = prio;
+        return err::ok;
+    }
+
+    //!
+    //! \brief Sets routine and its context.
+    //! \retval err::busy Thread is already started.
+    //!
+    ecl::err set_routine(routine fn, void *arg)
+    {
+        ecl_assert(fn);
+
+        if (m_task) {
+            return err::busy;
+        }
+
+        m_fn  = fn;
+        m_arg = arg;
+        return err::ok;
+    }
+
+    //!
+    //! \brief Starts thread. Never allocates.
+    //! \retval err::busy Thread is already started.
+    //!
+    ecl::err start()
+    {
+        ecl_assert_msg(m_fn, "Attempting to start thread without thread routine");
+
+        if (m_task) {
+            return err::busy;
+        }
+
+        // Routine and its argument are kept in the object itself,
+        // so no handshake with the new thread is required.
+        m_task = xTaskCreateStatic(runner,
+                                   m_name,
+                                   stack_words,
+                                   this,
+                                   m_prio,
+                                   m_stack,
+                                   &m_tcb);
+
+        return m_task ? err::ok : err::generic;
+    }
+
+    //!
+    //! \brief Gets amount of stack bytes, never used by the thread so far.
+    //! Helps to right-size the stack after running typical workload.
+    //! If stacks are guarded by MPU, see stack_guard.h in kernel, the scan
+    //! reaches the guard, so the thread can't query its own stack.
+    //! \pre Thread is started.
+    //!
+    size_t stack_unused() const
+    {
+        static_assert(INCLUDE_uxTaskGetStackHighWaterMark,
+                      "Stack watermark must be enabled in FreeRTOS config");
+
+        ecl_assert(m_task);
+        return uxTaskGetStackHighWaterMark(m_task) * sizeof(StackType_t) - guard_bytes;
+    }
+
+    //!
+    //! \brief Gets stack size in bytes, available to the thread.
+    //!
+    static constexpr size_t stack_bytes() { return stack_words * sizeof(StackType_t) - guard_bytes; }
+
+    static_thread(const static_thread&)             = delete;
+    static_thread& operator=(const static_thread&)  = delete;
+
+private:
+#ifdef KERNEL_STACK_GUARD_SIZE
+    // Stack is aligned, so MPU guard takes exactly its first bytes
+    static constexpr size_t guard_bytes = KERNEL_STACK_GUARD_SIZE;
+#else
+    static constexpr size_t guard_bytes = 0;
+#endif
+
+    static constexpr size_t stack_align = std::max(guard_bytes, alignof(StackType_t));
+    static constexpr size_t stack_words = (stack_size + guard_bytes) / sizeof(StackType_t);
+
+    static void runner(void *arg)
+    {
+        auto self = static_cast< static_thread * >(arg);
+        self->m_fn(self->m_arg);
+
+        // Task must not return from its routine
+        vTaskDelete(nullptr);
+    }
+
+    StaticTask_t    m_tcb;                              //!< Task control block.
+    alignas(stack_align)
+    StackType_t     m_stack[stack_words];               //!< Task stack.
+    TaskHandle_t    m_task;                             //!< Task handle, if started.
+    char            m_name[configMAX_TASK_NAME_LEN];    //!< Task name.
+    routine         m_fn;                               //!< Thread routine.
+    void            *m_arg;                             //!< Routine argument.
+    UBaseType_t     m_prio;                             //!< Task priority.
+};
+
+} // namespace ecl
+
+#endif // LIB_THREAD_FREERTOS_STATIC_THREAD_HPP_
@@ -0,0 +1,115 @@
+#ifndef LIB_THREAD_FREERTOS_STATS_HPP_
+#define LIB_THREAD_FREERTOS_STATS_HPP_
+
+//!
+//! \file
+//! \brief Per-thread CPU usage and context switch statistics.
+//! Requires CONFIG_FREERTOS_RUN_TIME_STATS, or equivalent FreeRTOS config.
+//!
+
+#include <ecl/err.hpp>
+#include <os/utils.hpp>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <cstddef>
+#include <cstdint>
+
+static_assert(configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY,
+              "Run time statistics must be enabled in FreeRTOS config");
+
+static_assert(configUSE_APPLICATION_TASK_TAG,
+              "Task tags are required to count context switches");
+
+namespace ecl
+{
+
+namespace os
+{
+
+//!
+//! \brief Statistics of a single thread.
+//!
+struct thread_stats
+{
+    thread_handle   handle;         //!< Thread handle.
+    const char      *name;          //!< Thread name.
+    uint32_t        runtime;        //!< Time spent running, in counter units.
+    uint32_t        switches;       //!< Times thread was switched in.
+    size_t          stack_unused;   //!< Stack bytes, never used so far.
+};
+
+//!
+//! \brief Gets amount of times given thread was switched in.
+//! Can be called from ISR.
+//!
+inline uint32_t context_switches(thread_handle handle)
+{
+    auto tag = xTaskGetApplicationTaskTag(static_cast< TaskHandle_t >(handle));
+    return static_cast< uint32_t >(reinterpret_cast< uintptr_t >(tag));
+}
+
+//!
+//! \brief Gets statistics of all threads.
+//! Cannot be called from ISR.
+//! \param[out] stats Statistics, one entry per thread.
+//! \param[out] total Total run time, in counter units.
+//! \return Amount of entries filled. Zero if there are more threads than
+//!         entries.
+//!
+template< size_t max_threads >
+size_t get_thread_stats(thread_stats (&stats)[max_threads], uint32_t &total)
+{
+    TaskStatus_t tasks[max_threads];
+
+    auto cnt = uxTaskGetSystemState(tasks, max_threads, &total);
+
+    for (size_t i = 0; i < cnt; ++i) {
+        auto &t = tasks[i];
+
+        stats[i].handle       = t.xHandle;
+        stats[i].name         = t.pcTaskName;
+        stats[i].runtime      = t.ulRunTimeCounter;
+        stats[i].switches     = context_switches(t.xHandle);
+        stats[i].stack_unused = t.usStackHighWaterMark * sizeof(StackType_t);
+    }
+
+    return cnt;
+}
+
+//!
+//! \brief Prints statistics of all threads as a table.
+//! Cannot be called from ISR.
+//! \tparam max_threads Maximum amount of threads to print.
+//! \param[in] os Output stream, i.e. ecl::cout.
+//!
+template< size_t max_threads = 16, class Stream >
+void dump_thread_stats(Stream &os)
+{
+    thread_stats stats[max_threads];
+    uint32_t total = 0;
+
+    auto cnt = get_thread_stats(stats, total);
+
+    // Percentage is computed without overflowing 32-bit counters
+    total /= 100;
+
+    os << "thread\tcpu%\tswitches\tstack free\n";
+
+    for (size_t i = 0; i < cnt; ++i) {
+        auto &s = stats[i];
+        auto load = total ? s.runtime / total : 0;
+
+        os << s.name << '\t'
+           << static_cast< unsigned >(load) << '\t'
+           << static_cast< unsigned >(s.switches) << '\t'
+           << static_cast< unsigned >(s.stack_unused) << "\n";
+    }
+}
+
+} // namespace os
+
+} // namespace ecl
+
+#endif // LIB_THREAD_FREERTOS_STATS_HPP_
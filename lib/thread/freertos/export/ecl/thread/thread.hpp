@@ -40,6 +40,16 @@ public:
     // Retval < 0 if some error occur
     ssize_t get_name(char *buf, size_t size);
 
+    // Sets priority, from tskIDLE_PRIORITY to configMAX_PRIORITIES - 1.
+    // Higher values preempt lower. Can be changed after start as well.
+    // Returns err::inval if priority is out of range
+    ecl::err set_priority(UBaseType_t prio);
+
+    // Sets cores, where thread can run, as a bit mask.
+    // On single-core builds mask must include core 0.
+    // Returns err::inval if no existing core is given
+    ecl::err set_affinity(uint32_t mask);
+
     // Sets routine and its context
     // Asserts if fn == null
     // Return error if thread already started
@@ -65,6 +75,11 @@ public:
     // - thread was already joined
     ecl::err detach();
 
+    // Gets amount of times thread was switched in.
+    // Zero, if context switches are not counted,
+    // see CONFIG_FREERTOS_RUN_TIME_STATS.
+    uint32_t context_switches() const;
+
 private:
     struct runner_arg
     {
@@ -85,6 +100,8 @@ private:
     TaskHandle_t    m_task;
     size_t          m_stack;
     char            m_name[configMAX_TASK_NAME_LEN];
+    UBaseType_t     m_prio;
+    uint32_t        m_affinity;
     state           m_state;
     routine         m_fn;
     void            *m_arg;
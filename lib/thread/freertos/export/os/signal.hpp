@@ -46,6 +46,14 @@ void wait();
 //!
 ecl::err try_wait();
 
+//!
+//! \brief Waits for signal for current thread during given time.
+//! Can't be called from ISR context.
+//! \param[in] msecs Timeout in milliseconds.
+//! \retval err::timedout No signal received in time.
+//! \retval err::ok       Signal consumed.
+//!
+ecl::err wait_for(uint32_t msecs);
 
 } // namespace signal
 
@@ -2,7 +2,7 @@
 #define LIB_THREAD_FREERTOS_OS_UTILS_
 
 #include <cstdint>
-#include <cstdint>
+#include <cstddef>
 
 namespace ecl
 {
@@ -15,6 +15,22 @@ namespace os
 //! this will stay here.
 using thread_handle = void *;
 
+//! Kernel tick counter type. Wraps around.
+using tick_type = uint32_t;
+
+//!
+//! \brief Gets current value of kernel tick counter.
+//! Can be called from ISR.
+//! \note  Tick duration is defined by FreeRTOS configuration,
+//!        see ms_to_ticks().
+//!
+tick_type get_ticks();
+
+//!
+//! \brief Converts milliseconds to kernel ticks.
+//!
+tick_type ms_to_ticks(uint32_t msecs);
+
 namespace this_thread
 {
 
@@ -37,6 +53,22 @@ void sleep_for(uint32_t msesc);
 //!
 thread_handle get_handle();
 
+//!
+//! \brief Gets core, where current thread or ISR runs.
+//! Thread may migrate right after the call, unless it is pinned,
+//! see native_thread::set_affinity().
+//! \return Core number, always 0 on single-core kernels.
+//!
+unsigned core();
+
+//!
+//! \brief Gets amount of stack bytes, never used by current thread so far.
+//! Helps to right-size thread stacks after running typical workload.
+//! \note  Requires INCLUDE_uxTaskGetStackHighWaterMark in FreeRTOS config,
+//!        otherwise zero is returned.
+//!
+size_t stack_unused();
+
 } // namespace this_thread
 
 } // namespace os
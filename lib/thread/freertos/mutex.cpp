@@ -1,8 +1,45 @@
 #include <ecl/thread/mutex.hpp>
 #include <ecl/assert.h>
 
+static_assert(configUSE_MUTEXES, "Mutexes must be enabled in FreeRTOS config");
+
+namespace
+{
+
+// Takes a semaphore using given function, counting contention if required
+template< class Take >
+bool counted_take(Take take, TickType_t ticks,
+                  uint32_t &locks, uint32_t &contended,
+                  std::atomic< uint32_t > &timeouts)
+{
+    // Fast path, no need to wait
+    if (take(0) == pdTRUE) {
+        ++locks;
+        return true;
+    }
+
+    if (ticks == 0 || take(ticks) != pdTRUE) {
+        ++timeouts;
+        return false;
+    }
+
+    // Counters are modified only by the owner, no extra lock is needed
+    ++locks;
+    ++contended;
+    return true;
+}
+
+}
+
+//------------------------------------------------------------------------------
+
 ecl::mutex::mutex()
     :m_mutex{xSemaphoreCreateMutex()}
+#ifdef CONFIG_MUTEX_STATS
+    ,m_locks{0}
+    ,m_contended{0}
+    ,m_timeouts{0}
+#endif
 {
     ecl_assert(m_mutex);
 }
@@ -14,8 +51,9 @@ ecl::mutex::~mutex()
 
 void ecl::mutex::lock()
 {
-    auto rc = xSemaphoreTake(m_mutex, portMAX_DELAY);
-    ecl_assert(rc == pdTRUE);
+    auto rc = take(portMAX_DELAY);
+    ecl_assert(rc);
+    (void) rc;
 }
 
 void ecl::mutex::unlock()
@@ -27,6 +65,92 @@ void ecl::mutex::unlock()
 
 bool ecl::mutex::try_lock()
 {
-    auto rc = xSemaphoreTake(m_mutex, 0);
-    return rc == pdTRUE;
+    return take(0);
+}
+
+bool ecl::mutex::try_lock_for(uint32_t msecs)
+{
+    return take(msecs / portTICK_PERIOD_MS);
+}
+
+ecl::mutex_stats ecl::mutex::get_stats() const
+{
+#ifdef CONFIG_MUTEX_STATS
+    return mutex_stats{m_locks, m_contended, m_timeouts.load()};
+#else
+    return mutex_stats{};
+#endif
+}
+
+bool ecl::mutex::take(TickType_t ticks)
+{
+#ifdef CONFIG_MUTEX_STATS
+    auto fn = [this](TickType_t t) { return xSemaphoreTake(m_mutex, t); };
+    return counted_take(fn, ticks, m_locks, m_contended, m_timeouts);
+#else
+    return xSemaphoreTake(m_mutex, ticks) == pdTRUE;
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+static_assert(configUSE_RECURSIVE_MUTEXES,
+              "Recursive mutexes must be enabled in FreeRTOS config");
+
+ecl::recursive_mutex::recursive_mutex()
+    :m_mutex{xSemaphoreCreateRecursiveMutex()}
+#ifdef CONFIG_MUTEX_STATS
+    ,m_locks{0}
+    ,m_contended{0}
+    ,m_timeouts{0}
+#endif
+{
+    ecl_assert(m_mutex);
+}
+
+ecl::recursive_mutex::~recursive_mutex()
+{
+    vSemaphoreDelete(m_mutex);
+}
+
+void ecl::recursive_mutex::lock()
+{
+    auto rc = take(portMAX_DELAY);
+    ecl_assert(rc);
+    (void) rc;
+}
+
+void ecl::recursive_mutex::unlock()
+{
+    auto rc = xSemaphoreGiveRecursive(m_mutex);
+    ecl_assert(rc == pdTRUE);
+}
+
+bool ecl::recursive_mutex::try_lock()
+{
+    return take(0);
+}
+
+bool ecl::recursive_mutex::try_lock_for(uint32_t msecs)
+{
+    return take(msecs / portTICK_PERIOD_MS);
+}
+
+ecl::mutex_stats ecl::recursive_mutex::get_stats() const
+{
+#ifdef CONFIG_MUTEX_STATS
+    return mutex_stats{m_locks, m_contended, m_timeouts.load()};
+#else
+    return mutex_stats{};
+#endif
+}
+
+bool ecl::recursive_mutex::take(TickType_t ticks)
+{
+#ifdef CONFIG_MUTEX_STATS
+    auto fn = [this](TickType_t t) { return xSemaphoreTakeRecursive(m_mutex, t); };
+    return counted_take(fn, ticks, m_locks, m_contended, m_timeouts);
+#else
+    return xSemaphoreTakeRecursive(m_mutex, ticks) == pdTRUE;
+#endif
 }
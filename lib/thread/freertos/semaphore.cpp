@@ -4,6 +4,26 @@
 
 #include <platform/utils.hpp>
 
+namespace
+{
+
+// Takes semaphore, waiting no longer than given amount of ticks
+ecl::err take(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    auto rc = xSemaphoreTake(sem, ticks);
+    return rc == pdTRUE ? ecl::err::ok : ecl::err::timedout;
+}
+
+// Gets amount of ticks left till the deadline
+TickType_t ticks_left(ecl::os::tick_type tick)
+{
+    // Difference is signed to survive tick wrap
+    auto left = static_cast< int32_t >(tick - ecl::os::get_ticks());
+    return left > 0 ? left : 0;
+}
+
+}
+
 ecl::semaphore::semaphore()
     :m_semaphore{nullptr}
 {
@@ -30,7 +50,9 @@ void ecl::semaphore::signal()
         }
     } else {
         // Can't block an ISR, event will be lost
-        xSemaphoreGiveFromISR(m_semaphore, nullptr);
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(m_semaphore, &woken);
+        portYIELD_FROM_ISR(woken);
     }
 }
 
@@ -46,6 +68,16 @@ ecl::err ecl::semaphore::try_wait()
     return rc == pdTRUE ? ecl::err::ok : ecl::err::again;
 }
 
+ecl::err ecl::semaphore::wait_for(uint32_t msecs)
+{
+    return take(m_semaphore, os::ms_to_ticks(msecs));
+}
+
+ecl::err ecl::semaphore::wait_until(os::tick_type tick)
+{
+    return take(m_semaphore, ticks_left(tick));
+}
+
 //------------------------------------------------------------------------------
 
 ecl::binary_semaphore::binary_semaphore()
@@ -69,8 +101,11 @@ void ecl::binary_semaphore::signal()
     if (!ecl::in_isr()) {
         xSemaphoreGive(m_semaphore);
     } else {
-        // Don't care about priority inversion thus skipping second argument
-        xSemaphoreGiveFromISR(m_semaphore, nullptr);
+        // Waiter of higher priority on this core runs right after the ISR.
+        // Kernel interrupts other cores by itself, if waiter runs there.
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(m_semaphore, &woken);
+        portYIELD_FROM_ISR(woken);
     }
 }
 
@@ -85,3 +120,13 @@ ecl::err ecl::binary_semaphore::try_wait()
     auto rc = xSemaphoreTake(m_semaphore, 0);
     return rc == pdTRUE ? ecl::err::ok : ecl::err::again;
 }
+
+ecl::err ecl::binary_semaphore::wait_for(uint32_t msecs)
+{
+    return take(m_semaphore, os::ms_to_ticks(msecs));
+}
+
+ecl::err ecl::binary_semaphore::wait_until(os::tick_type tick)
+{
+    return take(m_semaphore, ticks_left(tick));
+}
@@ -18,8 +18,10 @@ namespace signal
 ecl::err send(const thread_handle &handle)
 {
     if (ecl::in_isr()) {
-        // pxHigherPriorityTaskWoken argument is not interesting right now.
-        vTaskNotifyGiveFromISR(handle, nullptr);
+        // Kernel interrupts other cores by itself, if receiver runs there
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(handle, &woken);
+        portYIELD_FROM_ISR(woken);
     } else {
         xTaskNotifyGive(handle);
     }
@@ -61,6 +63,16 @@ ecl::err try_wait()
     return rc == pdPASS ? ecl::err::ok : ecl::err::again;
 }
 
+ecl::err wait_for(uint32_t msecs)
+{
+    ecl_assert(!ecl::in_isr());
+    constexpr BaseType_t clear_count = pdFALSE;
+    // Non-zero value means that notification was taken
+    auto rc = ulTaskNotifyTake(clear_count, ms_to_ticks(msecs));
+
+    return rc ? ecl::err::ok : ecl::err::timedout;
+}
+
 } // namespace signal
 
 } // namespace os
@@ -4,10 +4,38 @@
 
 #include <algorithm>
 
+// Core affinity is available on SMP kernels only
+#if defined(configNUMBER_OF_CORES) && defined(configUSE_CORE_AFFINITY)
+#define ECL_FREERTOS_SMP (configNUMBER_OF_CORES > 1 && configUSE_CORE_AFFINITY)
+#else
+#define ECL_FREERTOS_SMP 0
+#endif
+
+namespace
+{
+
+// Mask of all existing cores
+#if defined(configNUMBER_OF_CORES)
+constexpr uint32_t all_cores = (1u << configNUMBER_OF_CORES) - 1;
+#else
+constexpr uint32_t all_cores = 1;
+#endif
+
+// Stack is extended by bytes the MPU guard takes, see stack_guard.h in kernel
+#ifdef KERNEL_STACK_GUARD_OVERHEAD
+constexpr size_t stack_guard = KERNEL_STACK_GUARD_OVERHEAD;
+#else
+constexpr size_t stack_guard = 0;
+#endif
+
+}
+
 ecl::native_thread::native_thread()
     :m_task{nullptr}
     ,m_stack{512} // TODO: rationale, why this number?
     ,m_name{0}
+    ,m_prio{tskIDLE_PRIORITY}
+    ,m_affinity{all_cores}
     ,m_state{state::initial}
     ,m_fn{nullptr}
     ,m_arg{nullptr}
@@ -18,6 +46,8 @@ ecl::native_thread::native_thread(native_thread &&other)
     :m_task{other.m_task}
     ,m_stack{other.m_stack}
     ,m_name{0}
+    ,m_prio{other.m_prio}
+    ,m_affinity{other.m_affinity}
     ,m_state{other.m_state}
     ,m_fn{other.m_fn}
     ,m_arg{other.m_arg}
@@ -70,6 +100,38 @@ ssize_t ecl::native_thread::get_name(char *buf, size_t size)
     return len;
 }
 
+ecl::err ecl::native_thread::set_priority(UBaseType_t prio)
+{
+    if (prio >= configMAX_PRIORITIES) {
+        return ecl::err::inval;
+    }
+
+    m_prio = prio;
+
+    if (m_task) {
+        vTaskPrioritySet(m_task, prio);
+    }
+
+    return ecl::err::ok;
+}
+
+ecl::err ecl::native_thread::set_affinity(uint32_t mask)
+{
+    if (!(mask & all_cores)) {
+        return ecl::err::inval;
+    }
+
+    m_affinity = mask & all_cores;
+
+#if ECL_FREERTOS_SMP
+    if (m_task) {
+        vTaskCoreAffinitySet(m_task, m_affinity);
+    }
+#endif
+
+    return ecl::err::ok;
+}
+
 ecl::err ecl::native_thread::set_routine(routine fn, void *arg)
 {
     ecl_assert(fn);
@@ -95,12 +157,23 @@ ecl::err ecl::native_thread::start()
     // TODO: comment about it
     runner_arg arg = { false, m_fn, m_arg };
 
+#if ECL_FREERTOS_SMP
+    // Task must not run on other cores even once
+    xTaskCreateAffinitySet(thread_runner,
+                           m_name,
+                           (m_stack + stack_guard) / sizeof(StackType_t),
+                           reinterpret_cast< void* >(&arg),
+                           m_prio,
+                           m_affinity,
+                           &m_task);
+#else
     xTaskCreate(thread_runner,
                 m_name,
-                m_stack / sizeof(StackType_t),
+                (m_stack + stack_guard) / sizeof(StackType_t),
                 reinterpret_cast< void* >(&arg),
-                tskIDLE_PRIORITY,
+                m_prio,
                 &m_task);
+#endif
 
     if (!m_task) {
         return ecl::err::generic;
@@ -131,6 +204,21 @@ ecl::err ecl::native_thread::join()
     return join(dummy);
 }
 
+uint32_t ecl::native_thread::context_switches() const
+{
+#if configUSE_APPLICATION_TASK_TAG
+    if (!m_task) {
+        return 0;
+    }
+
+    // Counter is kept in the task tag, see run_time_stats.h in kernel
+    auto tag = xTaskGetApplicationTaskTag(m_task);
+    return static_cast< uint32_t >(reinterpret_cast< uintptr_t >(tag));
+#else
+    return 0;
+#endif
+}
+
 //------------------------------------------------------------------------------
 
 void ecl::native_thread::thread_runner(void *arg)
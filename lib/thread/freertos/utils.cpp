@@ -4,12 +4,33 @@
 #include <task.h>
 #include <platform/utils.hpp>
 
+// SMP kernel keeps current TCB per core
+#if defined(configNUMBER_OF_CORES) && configNUMBER_OF_CORES > 1
+#define ECL_FREERTOS_SMP 1
+#else
+#define ECL_FREERTOS_SMP 0
+#endif
+
+#if !ECL_FREERTOS_SMP
+
 // Thread Control Block, here is just used as an opaque type
 typedef struct TCB TCB_t;
 
 // Obtain current TCB from FreeRTOS
 extern "C" TCB_t * volatile pxCurrentTCB;
 
+#endif
+
+
+ecl::os::tick_type ecl::os::get_ticks()
+{
+    return ecl::in_isr() ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+}
+
+ecl::os::tick_type ecl::os::ms_to_ticks(uint32_t msecs)
+{
+    return msecs / portTICK_PERIOD_MS;
+}
 
 void ecl::os::this_thread::yield()
 {
@@ -18,7 +39,7 @@ void ecl::os::this_thread::yield()
 
 void ecl::os::this_thread::sleep_for(uint32_t msecs)
 {
-    vTaskDelay(msecs / portTICK_PERIOD_MS);
+    vTaskDelay(ms_to_ticks(msecs));
 }
 
 ecl::os::thread_handle ecl::os::this_thread::get_handle()
@@ -26,9 +47,32 @@ ecl::os::thread_handle ecl::os::this_thread::get_handle()
     TaskHandle_t handle = NULL;
 
     if (!ecl::in_isr()) {
-        ecl::disable_interrupts();
+#if ECL_FREERTOS_SMP
+        // Task may migrate between reading core ID and its TCB
+        handle = xTaskGetCurrentTaskHandle();
+#else
+        // Single word read, no need to enter critical section
         handle = reinterpret_cast< TaskHandle_t >(pxCurrentTCB);
+#endif
     }
 
     return handle;
 }
+
+unsigned ecl::os::this_thread::core()
+{
+#if ECL_FREERTOS_SMP
+    return portGET_CORE_ID();
+#else
+    return 0;
+#endif
+}
+
+size_t ecl::os::this_thread::stack_unused()
+{
+#if INCLUDE_uxTaskGetStackHighWaterMark
+    return uxTaskGetStackHighWaterMark(nullptr) * sizeof(StackType_t);
+#else
+    return 0;
+#endif
+}
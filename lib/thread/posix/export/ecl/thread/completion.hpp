@@ -0,0 +1,72 @@
+#ifndef LIB_THREAD_HOST_COMPLETION_HPP_
+#define LIB_THREAD_HOST_COMPLETION_HPP_
+
+#include <ecl/err.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace ecl
+{
+
+// Completion event with single waiter.
+// Multiple signals without waiting are delivered as one event.
+class completion
+{
+public:
+    completion()
+        :m_mutex{}
+        ,m_cond{}
+        ,m_done{false}
+    {
+    }
+
+    void signal()
+    {
+        // Notify under the lock: waiter may destroy completion right after wakeup
+        std::unique_lock< std::mutex > lock(m_mutex);
+        m_done = true;
+        m_cond.notify_one();
+    }
+
+    void wait()
+    {
+        std::unique_lock< std::mutex > lock(m_mutex);
+        m_cond.wait(lock, [&]{ return m_done; });
+        m_done = false;
+    }
+
+    ecl::err try_wait()
+    {
+        std::unique_lock< std::mutex > lock(m_mutex);
+        auto done = m_done;
+        m_done = false;
+        return done ? err::ok : err::again;
+    }
+
+    ecl::err wait_for(uint32_t msecs)
+    {
+        std::unique_lock< std::mutex > lock(m_mutex);
+        if (!m_cond.wait_for(lock, std::chrono::milliseconds(msecs),
+                             [&]{ return m_done; })) {
+            return err::timedout;
+        }
+
+        m_done = false;
+        return err::ok;
+    }
+
+    completion(const completion&)             = delete;
+    completion& operator=(const completion&)  = delete;
+
+private:
+    std::mutex                  m_mutex;
+    std::condition_variable     m_cond;
+    bool                        m_done;
+};
+
+}
+
+#endif
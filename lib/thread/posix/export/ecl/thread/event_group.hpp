@@ -0,0 +1,14 @@
+#ifndef LIB_THREAD_HOST_EVENT_GROUP_HPP_
+#define LIB_THREAD_HOST_EVENT_GROUP_HPP_
+
+#include <ecl/thread/common/event_group.hpp>
+
+namespace ecl
+{
+
+// Atomic mask with futex-based wait is already the cheapest option on host
+using event_group = common::event_group;
+
+}
+
+#endif // LIB_THREAD_HOST_EVENT_GROUP_HPP_
@@ -1,6 +1,22 @@
 #ifndef LIB_THREAD_HOST_FUTURE_HPP_
 #define LIB_THREAD_HOST_FUTURE_HPP_
 
-// TODO
+#include <ecl/thread/common/future.hpp>
+#include <ecl/thread/completion.hpp>
+
+namespace ecl
+{
+
+// Only one thread waits for a future, completion fits best
+template< class T >
+using future_state = common::future_state< T, completion >;
+
+template< class T >
+using future = common::future< T, completion >;
+
+template< class T >
+using promise = common::promise< T, completion >;
+
+}
 
 #endif // LIB_THREAD_HOST_FUTURE_HPP_
@@ -2,6 +2,7 @@
 #define LIB_THREAD_HOST_MUTEX_
 
 #include <mutex>
+#include <cstdint>
 
 namespace ecl
 {
@@ -9,16 +10,17 @@ namespace ecl
 class mutex
 {
 public:
-    constexpr mutex();
+    mutex();
 
     void lock();
     void unlock();
     bool try_lock();
+    bool try_lock_for(uint32_t msecs);
 
     mutex(const mutex&)             = delete;
     mutex& operator=(const mutex&)  = delete;
 private:
-    std::mutex m_mutex;
+    std::timed_mutex m_mutex;
 };
 
 }
@@ -1,12 +1,26 @@
 #ifndef LIB_THREAD_HOST_SEMAPHORE_HPP_
 #define LIB_THREAD_HOST_SEMAPHORE_HPP_
 
+#include <ecl/err.hpp>
+
 #include <condition_variable>
-#include <atomic>
+#include <cstdint>
 
 namespace ecl
 {
 
+namespace os
+{
+
+// Milliseconds of monotonic clock. Wraps around.
+using tick_type = uint32_t;
+
+// Gets current tick. Used as a time base for semaphore::wait_until()
+tick_type get_ticks();
+
+}
+
+// Counting semaphore
 class semaphore
 {
 public:
@@ -14,6 +28,15 @@ public:
 
     void signal();
     void wait();
+    ecl::err try_wait();
+
+    // Waits given amount of milliseconds.
+    // Returns err::timedout if semaphore was not signalled in time.
+    ecl::err wait_for(uint32_t msecs);
+
+    // Waits until given tick, see os::get_ticks().
+    // Returns err::timedout if semaphore was not signalled in time.
+    ecl::err wait_until(os::tick_type tick);
 
     semaphore(const semaphore&)             = delete;
     semaphore& operator=(const semaphore&)  = delete;
@@ -21,7 +44,7 @@ public:
 private:
     std::mutex                  m_mutex;
     std::condition_variable     m_cond;
-    std::atomic_bool            m_flag;
+    int                         m_count;
 };
 
 }
@@ -0,0 +1,16 @@
+#ifndef LIB_THREAD_HOST_SLEEP_LOCK_HPP_
+#define LIB_THREAD_HOST_SLEEP_LOCK_HPP_
+
+namespace ecl
+{
+
+// Host manages power by itself
+struct sleep_lock
+{
+    static void acquire() { }
+    static void release() { }
+};
+
+}
+
+#endif // LIB_THREAD_HOST_SLEEP_LOCK_HPP_
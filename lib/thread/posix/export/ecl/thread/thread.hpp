@@ -16,6 +16,14 @@ class native_thread
 public:
     using routine = ecl::err (*)(void *);
 
+    // Scheduling policy
+    enum class sched_policy
+    {
+        normal,         // SCHED_OTHER, time-sharing
+        fifo,           // SCHED_FIFO, real-time, runs until it blocks
+        round_robin,    // SCHED_RR, real-time, time-sliced within priority
+    };
+
     native_thread();
 
     native_thread(native_thread &&other);
@@ -38,6 +46,21 @@ public:
     // Retval < 0 if some error occur
     ssize_t get_name(char *buf, size_t size);
 
+    // Sets scheduling policy. Priority is reset to the minimum of the policy.
+    // Can be changed after start as well.
+    // Returns err::perm if process is not allowed to use real-time policies
+    ecl::err set_policy(sched_policy policy);
+
+    // Sets priority within the policy, see sched_get_priority_min/max().
+    // Normal policy accepts only 0.
+    // Returns err::inval if priority is out of range
+    // Returns err::perm if process is not allowed to raise it
+    ecl::err set_priority(int prio);
+
+    // Sets CPUs, where thread can run, as a bit mask
+    // Returns err::inval if no existing CPU is given
+    ecl::err set_affinity(uint32_t mask);
+
     // Sets routine and its context
     // Asserts if fn == null
     // Return error if thread already started
@@ -69,10 +92,15 @@ private:
         ecl::semaphore  start_flag;
         routine         start_routine;
         void            *routine_arg;
+        const char      *name;
     };
 
     static void* thread_runner(void *ctx);
 
+    // Applies scheduling and affinity to attributes of thread being created
+    // Returns errno-style code of pthread_attr_* routines
+    int apply_attr(pthread_attr_t &attr);
+
     enum class state
     {
         initial,
@@ -83,6 +111,9 @@ private:
     pthread_t       m_thread;
     size_t          m_stack;
     std::string     m_name;
+    sched_policy    m_policy;
+    int             m_prio;
+    uint32_t        m_affinity;
     state           m_state;
     routine         m_fn;
     void            *m_arg;
@@ -1,6 +1,8 @@
 #include <ecl/thread/mutex.hpp>
 
-constexpr ecl::mutex::mutex()
+#include <chrono>
+
+ecl::mutex::mutex()
     :m_mutex{}
 {
 }
@@ -19,3 +21,8 @@ bool ecl::mutex::try_lock()
 {
     return m_mutex.try_lock();
 }
+
+bool ecl::mutex::try_lock_for(uint32_t msecs)
+{
+    return m_mutex.try_lock_for(std::chrono::milliseconds(msecs));
+}
@@ -1,24 +1,64 @@
 #include <ecl/thread/semaphore.hpp>
 
+#include <chrono>
+
+ecl::os::tick_type ecl::os::get_ticks()
+{
+    using namespace std::chrono;
+    auto now = steady_clock::now().time_since_epoch();
+    return static_cast< tick_type >(duration_cast< milliseconds >(now).count());
+}
+
+//------------------------------------------------------------------------------
+
 ecl::semaphore::semaphore()
     :m_mutex{}
     ,m_cond{}
-    ,m_flag{false}
+    ,m_count{0}
 {
 }
 
 void ecl::semaphore::signal()
 {
+    // Notify under the lock: waiter may destroy semaphore right after wakeup
     std::unique_lock< std::mutex > lock(m_mutex);
-    m_flag = true;
-    lock.unlock();
+    ++m_count;
     m_cond.notify_one();
 }
 
 void ecl::semaphore::wait()
 {
     std::unique_lock< std::mutex > lock(m_mutex);
-    m_cond.wait(lock, [&]{ return m_flag.load(); }); // To avoid spurious wakeup
-    m_flag = false;
+    m_cond.wait(lock, [&]{ return m_count > 0; }); // To avoid spurious wakeup
+    --m_count;
 }
 
+ecl::err ecl::semaphore::try_wait()
+{
+    std::unique_lock< std::mutex > lock(m_mutex);
+    if (!m_count) {
+        return err::again;
+    }
+
+    --m_count;
+    return err::ok;
+}
+
+ecl::err ecl::semaphore::wait_for(uint32_t msecs)
+{
+    std::unique_lock< std::mutex > lock(m_mutex);
+    if (!m_cond.wait_for(lock, std::chrono::milliseconds(msecs),
+                         [&]{ return m_count > 0; })) {
+        return err::timedout;
+    }
+
+    --m_count;
+    return err::ok;
+}
+
+ecl::err ecl::semaphore::wait_until(os::tick_type tick)
+{
+    // Difference is signed to survive tick wrap
+    auto left = static_cast< int32_t >(tick - os::get_ticks());
+    return wait_for(left > 0 ? left : 0);
+}
@@ -3,10 +3,60 @@
 #include <bits/local_lim.h>
 #include <algorithm>
 
+#include <errno.h>
+#include <sched.h>
+
+namespace
+{
+
+int to_native(ecl::native_thread::sched_policy policy)
+{
+    switch (policy) {
+    case ecl::native_thread::sched_policy::fifo:
+        return SCHED_FIFO;
+    case ecl::native_thread::sched_policy::round_robin:
+        return SCHED_RR;
+    default:
+        return SCHED_OTHER;
+    }
+}
+
+// Real-time policies require privileges (CAP_SYS_NICE or RLIMIT_RTPRIO)
+ecl::err to_err(int rc)
+{
+    switch (rc) {
+    case 0:
+        return ecl::err::ok;
+    case EPERM:
+        return ecl::err::perm;
+    case EINVAL:
+        return ecl::err::inval;
+    default:
+        return ecl::err::generic;
+    }
+}
+
+// Mask bits above CPU_SETSIZE are ignored
+void to_cpuset(uint32_t mask, cpu_set_t &set)
+{
+    CPU_ZERO(&set);
+
+    for (unsigned i = 0; i < 32 && i < CPU_SETSIZE; ++i) {
+        if (mask & (1u << i)) {
+            CPU_SET(i, &set);
+        }
+    }
+}
+
+}
+
 ecl::native_thread::native_thread()
     :m_thread{}
     ,m_stack{PTHREAD_STACK_MIN}
     ,m_name{""}
+    ,m_policy{sched_policy::normal}
+    ,m_prio{0}
+    ,m_affinity{0} // Not restricted
     ,m_state{state::initial}
     ,m_fn{nullptr}
     ,m_arg{nullptr}
@@ -22,6 +72,9 @@ ecl::native_thread::native_thread(native_thread &&other)
     this->m_stack = other.m_stack;
     this->m_arg = other.m_arg;
     this->m_name = std::move(other.m_name);
+    this->m_policy = other.m_policy;
+    this->m_prio = other.m_prio;
+    this->m_affinity = other.m_affinity;
 
     other.m_state = state::detached;
 }
@@ -68,6 +121,76 @@ ssize_t ecl::native_thread::get_name(char *buf, size_t size)
     return m_name.length();
 }
 
+ecl::err ecl::native_thread::set_policy(sched_policy policy)
+{
+    int prio = sched_get_priority_min(to_native(policy));
+
+    if (m_state == state::started) {
+        sched_param param = {};
+        param.sched_priority = prio;
+
+        int rc = pthread_setschedparam(m_thread, to_native(policy), &param);
+        if (rc != 0) {
+            return to_err(rc);
+        }
+
+    } else if (m_state != state::initial) {
+        return err::srch;
+    }
+
+    m_policy = policy;
+    m_prio = prio;
+    return err::ok;
+}
+
+ecl::err ecl::native_thread::set_priority(int prio)
+{
+    int policy = to_native(m_policy);
+
+    if (prio < sched_get_priority_min(policy) || prio > sched_get_priority_max(policy)) {
+        return err::inval;
+    }
+
+    if (m_state == state::started) {
+        sched_param param = {};
+        param.sched_priority = prio;
+
+        int rc = pthread_setschedparam(m_thread, policy, &param);
+        if (rc != 0) {
+            return to_err(rc);
+        }
+
+    } else if (m_state != state::initial) {
+        return err::srch;
+    }
+
+    m_prio = prio;
+    return err::ok;
+}
+
+ecl::err ecl::native_thread::set_affinity(uint32_t mask)
+{
+    if (!mask) {
+        return err::inval;
+    }
+
+    if (m_state == state::started) {
+        cpu_set_t set;
+        to_cpuset(mask, set);
+
+        int rc = pthread_setaffinity_np(m_thread, sizeof(set), &set);
+        if (rc != 0) {
+            return to_err(rc);
+        }
+
+    } else if (m_state != state::initial) {
+        return err::srch;
+    }
+
+    m_affinity = mask;
+    return err::ok;
+}
+
 ecl::err ecl::native_thread::set_routine(routine fn, void *arg)
 {
     ecl_assert(fn);
@@ -98,26 +221,30 @@ ecl::err ecl::native_thread::start()
         return err::generic;
     }
 
+    rc = apply_attr(attr);
+    if (rc != 0) {
+        pthread_attr_destroy(&attr);
+        return to_err(rc);
+    }
+
     // TODO: comment about why stack size is not used
 
     // TODO: comment about it
-    runner_arg arg = { {}, m_fn, m_arg };
+    runner_arg arg = { {}, m_fn, m_arg, m_name.c_str() };
 
     rc = pthread_create(&m_thread, &attr, thread_runner, reinterpret_cast< void* >(&arg));
     if (rc != 0) {
         pthread_attr_destroy(&attr);
-        return err::generic;
+        return rc == EPERM ? err::perm : err::generic;
     }
 
     arg.start_flag.wait();
 
     m_state = state::started;
 
-    rc = pthread_setname_np(m_thread, m_name.c_str());
-
     pthread_attr_destroy(&attr);
 
-    return rc != 0 ? err::generic : err::ok;
+    return err::ok;
 }
 
 ecl::err ecl::native_thread::join(ecl::err &retcode)
@@ -172,6 +299,12 @@ void* ecl::native_thread::thread_runner(void *arg)
     auto *fn = rarg->start_routine;
     auto *fn_arg = rarg->routine_arg;
 
+    // Named by itself, since thread of higher priority may finish
+    // before creator gets control back
+    if (rarg->name[0]) {
+        pthread_setname_np(pthread_self(), rarg->name);
+    }
+
     // TODO: comment
     rarg->start_flag.signal();
 
@@ -179,3 +312,39 @@ void* ecl::native_thread::thread_runner(void *arg)
     return reinterpret_cast< void * >(result);
 }
 
+int ecl::native_thread::apply_attr(pthread_attr_t &attr)
+{
+    int rc;
+
+    // Default attributes inherit scheduling of the creator, so the policy
+    // must be explicit, otherwise it is silently ignored
+    if (m_policy != sched_policy::normal) {
+        sched_param param = {};
+        param.sched_priority = m_prio;
+
+        rc = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        if (rc == 0) {
+            rc = pthread_attr_setschedpolicy(&attr, to_native(m_policy));
+        }
+
+        if (rc == 0) {
+            rc = pthread_attr_setschedparam(&attr, &param);
+        }
+
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    if (m_affinity) {
+        cpu_set_t set;
+        to_cpuset(m_affinity, set);
+
+        rc = pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
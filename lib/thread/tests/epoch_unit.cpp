@@ -0,0 +1,182 @@
+#include <ecl/thread/epoch.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+constexpr int poison = -1;
+
+struct node : ecl::epoch_node
+{
+    std::atomic< int >      value{0};
+    std::atomic< node* >    next{nullptr};
+};
+
+// Pool, that reuses freed nodes at once, to provoke use-after-free and ABA
+struct node_pool
+{
+    node *allocate()
+    {
+        std::lock_guard< std::mutex > lock{m};
+        void *mem;
+
+        if (free.empty()) {
+            mem = ::operator new(sizeof(node));
+            all.push_back(mem);
+        } else {
+            mem = free.back();
+            free.pop_back();
+        }
+
+        return new (mem) node{};
+    }
+
+    void deallocate(node *n, size_t count)
+    {
+        CHECK_EQUAL(1, count);
+
+        // Node is destroyed, but readers would still see the poison
+        reinterpret_cast< std::atomic< int >* >(&n->value)->store(poison);
+
+        std::lock_guard< std::mutex > lock{m};
+        free.push_back(n);
+        freed++;
+    }
+
+    ~node_pool()
+    {
+        for (auto p : all) {
+            ::operator delete(p);
+        }
+    }
+
+    std::mutex          m;
+    std::vector< void* > free;
+    std::vector< void* > all;
+    int                 freed = 0;
+};
+
+using domain_t = ecl::epoch_domain< 8, 4 >;
+
+} // namespace
+
+TEST_GROUP(epoch)
+{
+};
+
+TEST(epoch, slots)
+{
+    ecl::epoch_domain< 2 > d;
+
+    int a = d.enter();
+    int b = d.enter();
+
+    CHECK_TRUE(a >= 0 && b >= 0 && a != b);
+    CHECK_EQUAL(-1, d.enter());
+
+    d.leave(a);
+    CHECK_EQUAL(a, d.enter());
+}
+
+TEST(epoch, pinned_reader_holds_nodes)
+{
+    node_pool pool;
+    domain_t d;
+    int writer = d.enter();
+    int reader = d.enter();
+
+    {
+        domain_t::guard g{d, reader};
+
+        for (int i = 0; i < 20; ++i) {
+            d.retire(writer, pool.allocate(), pool);
+        }
+
+        d.reclaim(writer);
+        d.reclaim(writer);
+
+        // Reader could see any of the nodes
+        CHECK_EQUAL(0, pool.freed);
+    }
+
+    // Epoch advances twice, once reader is gone
+    for (int i = 0; i < 3; ++i) {
+        d.reclaim(writer);
+    }
+
+    CHECK_EQUAL(20, pool.freed);
+    CHECK_EQUAL(0, d.reclaim(writer));
+}
+
+TEST(epoch, treiber_stack)
+{
+    constexpr int threads_count = 4;
+    constexpr int iterations = 20000;
+
+    node_pool pool;
+    domain_t d;
+    std::atomic< node* > head{nullptr};
+    std::atomic< long > pushed{0};
+    std::atomic< long > popped{0};
+    std::atomic< int > poisoned{0};
+    std::vector< std::thread > threads;
+
+    for (int t = 0; t < threads_count; ++t) {
+        threads.emplace_back([&, t] {
+            int id = d.enter();
+
+            for (int i = 1; i <= iterations; ++i) {
+                auto n = pool.allocate();
+                n->value = t * iterations + i;
+                pushed += n->value;
+
+                auto top = head.load();
+                do {
+                    n->next = top;
+                } while (!head.compare_exchange_weak(top, n));
+
+                domain_t::guard g{d, id};
+                auto p = head.load();
+
+                // Top node may be popped and freed concurrently
+                while (p && !head.compare_exchange_weak(p, p->next.load())) { }
+
+                if (p) {
+                    int v = p->value;
+                    if (v == poison) {
+                        poisoned++;
+                    }
+
+                    popped += v;
+                    d.retire(id, p, pool);
+                }
+            }
+
+            d.leave(id);
+        });
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    for (auto p = head.load(); p; p = p->next) {
+        popped += p->value;
+    }
+
+    CHECK_EQUAL(0, poisoned.load());
+    CHECK_EQUAL(pushed.load(), popped.load());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
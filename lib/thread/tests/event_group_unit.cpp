@@ -0,0 +1,130 @@
+#include <ecl/thread/event_group.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+constexpr ecl::event_group::bits_type usart_done = 1 << 0;
+constexpr ecl::event_group::bits_type spi_done   = 1 << 1;
+constexpr ecl::event_group::bits_type i2c_done   = 1 << 2;
+
+}
+
+TEST_GROUP(event_group)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(event_group, set_clear_get)
+{
+    ecl::event_group group;
+
+    CHECK_EQUAL(0, group.get());
+
+    group.set(usart_done | spi_done);
+    CHECK_EQUAL(usart_done | spi_done, group.get());
+
+    group.clear(usart_done);
+    CHECK_EQUAL(spi_done, group.get());
+}
+
+TEST(event_group, wait_any_clears_awaited_bits)
+{
+    ecl::event_group group;
+
+    group.set(spi_done | i2c_done);
+
+    // Only awaited bits are returned and cleared
+    auto got = group.wait(usart_done | spi_done);
+    CHECK_EQUAL(spi_done, got);
+    CHECK_EQUAL(i2c_done, group.get());
+}
+
+TEST(event_group, wait_all)
+{
+    ecl::event_group group;
+    ecl::event_group::bits_type got = 0;
+
+    group.set(usart_done);
+
+    auto rc = group.wait_for(usart_done | spi_done, 10, got, true);
+    CHECK_EQUAL(ecl::err::timedout, rc);
+
+    // Partially satisfied wait leaves bits untouched
+    CHECK_EQUAL(usart_done, group.get());
+
+    group.set(spi_done);
+
+    rc = group.wait_for(usart_done | spi_done, 10, got, true);
+    CHECK_EQUAL(ecl::err::ok, rc);
+    CHECK_EQUAL(usart_done | spi_done, got);
+    CHECK_EQUAL(0, group.get());
+}
+
+TEST(event_group, wait_for_timeout)
+{
+    ecl::event_group group;
+    ecl::event_group::bits_type got = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    auto rc = group.wait_for(usart_done, 50, got);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    CHECK_EQUAL(ecl::err::timedout, rc);
+    CHECK_TRUE(elapsed >= std::chrono::milliseconds(45));
+}
+
+TEST(event_group, single_thread_serves_many_events)
+{
+    constexpr int rounds = 1000;
+
+    ecl::event_group group;
+    int usart_events = 0;
+    int spi_events = 0;
+
+    std::thread usart([&group]() {
+        for (int i = 0; i < rounds; ++i) {
+            while (group.get() & usart_done) {
+                std::this_thread::yield();
+            }
+            group.set(usart_done);
+        }
+    });
+
+    std::thread spi([&group]() {
+        for (int i = 0; i < rounds; ++i) {
+            while (group.get() & spi_done) {
+                std::this_thread::yield();
+            }
+            group.set(spi_done);
+        }
+    });
+
+    while (usart_events < rounds || spi_events < rounds) {
+        auto got = group.wait(usart_done | spi_done);
+        usart_events += !!(got & usart_done);
+        spi_events += !!(got & spi_done);
+    }
+
+    usart.join();
+    spi.join();
+
+    CHECK_EQUAL(rounds, usart_events);
+    CHECK_EQUAL(rounds, spi_events);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
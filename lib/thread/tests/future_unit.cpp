@@ -0,0 +1,157 @@
+#include <ecl/thread/common/future.hpp>
+#include <ecl/thread/common/semaphore.hpp>
+
+#include <thread>
+#include <chrono>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+// Error code helper
+static SimpleString StringFrom(ecl::err err)
+{
+    return SimpleString{ecl::err_to_str(err)};
+}
+
+using promise_t     = ecl::common::promise< int, ecl::common::semaphore >;
+using future_t      = ecl::common::future< int, ecl::common::semaphore >;
+using state_t       = ecl::common::future_state< int, ecl::common::semaphore >;
+
+TEST_GROUP(future)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(future, value_is_delivered)
+{
+    promise_t p;
+    auto f = p.get_future();
+
+    CHECK(f.valid());
+    CHECK(!f.is_ready());
+
+    auto rc = p.set_value(42);
+    CHECK_EQUAL(ecl::err::ok, rc);
+    CHECK(f.is_ready());
+
+    int val = 0;
+    rc = f.get(val);
+    CHECK_EQUAL(ecl::err::ok, rc);
+    CHECK_EQUAL(42, val);
+}
+
+TEST(future, error_is_delivered)
+{
+    promise_t p;
+    auto f = p.get_future();
+
+    auto rc = p.set_error(ecl::err::io);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    int val = 7;
+    rc = f.get(val);
+    CHECK_EQUAL(ecl::err::io, rc);
+    CHECK_EQUAL(7, val);
+}
+
+TEST(future, result_set_only_once)
+{
+    promise_t p;
+    auto f = p.get_future();
+
+    CHECK_EQUAL(ecl::err::ok, p.set_value(1));
+    CHECK_EQUAL(ecl::err::busy, p.set_value(2));
+    CHECK_EQUAL(ecl::err::busy, p.set_error(ecl::err::io));
+
+    int val = 0;
+    CHECK_EQUAL(ecl::err::ok, f.get(val));
+    CHECK_EQUAL(1, val);
+}
+
+TEST(future, wait_for_timeout)
+{
+    promise_t p;
+    auto f = p.get_future();
+
+    auto rc = f.wait_for(10);
+    CHECK_EQUAL(ecl::err::timedout, rc);
+
+    p.set_value(1);
+
+    rc = f.wait_for(10);
+    CHECK_EQUAL(ecl::err::ok, rc);
+}
+
+TEST(future, value_from_other_thread)
+{
+    promise_t p;
+    auto f = p.get_future();
+
+    std::thread producer{[&p]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        p.set_value(5);
+    }};
+
+    int val = 0;
+    auto rc = f.get(val);
+    CHECK_EQUAL(ecl::err::ok, rc);
+    CHECK_EQUAL(5, val);
+
+    producer.join();
+}
+
+TEST(future, continuation)
+{
+    promise_t p;
+    auto f = p.get_future();
+
+    int got = 0;
+    ecl::err status = ecl::err::generic;
+
+    // Set before the result: executed by producer
+    f.then([&](ecl::err st, int *v) { status = st; got = *v; });
+    CHECK_EQUAL(0, got);
+
+    p.set_value(3);
+    CHECK_EQUAL(ecl::err::ok, status);
+    CHECK_EQUAL(3, got);
+
+    // Set after the result: executed right away
+    p.reset();
+    f = p.get_future();
+    p.set_error(ecl::err::io);
+
+    int *ptr = &got;
+    f.then([&](ecl::err st, int *v) { status = st; ptr = v; });
+    CHECK_EQUAL(ecl::err::io, status);
+    POINTERS_EQUAL(nullptr, ptr);
+}
+
+TEST(future, external_state)
+{
+    state_t state;
+
+    for (int i = 0; i < 3; ++i) {
+        promise_t p{state};
+        auto f = p.get_future();
+
+        p.set_value(i);
+
+        int val = -1;
+        CHECK_EQUAL(ecl::err::ok, f.get(val));
+        CHECK_EQUAL(i, val);
+
+        state.reset();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,113 @@
+#include <ecl/thread/heartbeat.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+TEST_GROUP(heartbeat)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(heartbeat, stalled_thread_is_found)
+{
+    ecl::heartbeat_table< 4 > table;
+
+    CHECK_EQUAL(-1, table.stalled(1000));
+
+    int a = table.add(10, 100, 0);
+    int b = table.add(20, 300, 0);
+
+    CHECK_TRUE(a >= 0 && b >= 0 && a != b);
+    CHECK_EQUAL(20, table.tag(b));
+
+    // Both are within periods
+    CHECK_EQUAL(-1, table.stalled(100));
+
+    // First misses its period, unless it beats
+    CHECK_EQUAL(a, table.stalled(101));
+    table.beat(a, 90);
+    CHECK_EQUAL(-1, table.stalled(190));
+
+    table.beat(a, 300);
+    CHECK_EQUAL(b, table.stalled(301));
+
+    // Removed thread is not checked
+    table.remove(b);
+    CHECK_EQUAL(-1, table.stalled(301));
+}
+
+TEST(heartbeat, time_wraps)
+{
+    ecl::heartbeat_table< 2 > table;
+    const uint32_t start = UINT32_MAX - 50;
+
+    int id = table.add(1, 100, start);
+
+    CHECK_EQUAL(-1, table.stalled(start + 100));
+    CHECK_EQUAL(id, table.stalled(start + 101));
+}
+
+TEST(heartbeat, table_is_full)
+{
+    ecl::heartbeat_table< 2 > table;
+
+    CHECK_EQUAL(-1, table.add(1, 0, 0));
+    CHECK_EQUAL(-1, table.add(1, UINT32_MAX, 0));
+
+    int a = table.add(1, 10, 0);
+    CHECK_TRUE(table.add(2, 10, 0) >= 0);
+    CHECK_EQUAL(-1, table.add(3, 10, 0));
+
+    // Slot is reused
+    table.remove(a);
+    CHECK_EQUAL(a, table.add(4, 10, 0));
+    CHECK_EQUAL(4, table.tag(a));
+}
+
+TEST(heartbeat, concurrent_registration)
+{
+    constexpr int threads = 8;
+    ecl::heartbeat_table< threads > table;
+    std::atomic< int > ids[threads];
+    std::vector< std::thread > workers;
+
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&table, &ids, i] {
+            ids[i] = table.add(i, 1000, 0);
+            for (uint32_t t = 0; t < 10000; ++t) {
+                table.beat(ids[i], t);
+            }
+        });
+    }
+
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    // Each thread got own slot
+    bool taken[threads] = {};
+    for (int i = 0; i < threads; ++i) {
+        CHECK_TRUE(ids[i] >= 0 && ids[i] < threads);
+        CHECK_FALSE(taken[ids[i]]);
+        taken[ids[i]] = true;
+        CHECK_EQUAL(static_cast< uint32_t >(i), table.tag(ids[i]));
+    }
+
+    CHECK_EQUAL(-1, table.stalled(10000));
+    CHECK_TRUE(table.stalled(11000) >= 0);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,104 @@
+#include <ecl/thread/mpmc_queue.hpp>
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+TEST_GROUP(mpmc_queue)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(mpmc_queue, fifo_order)
+{
+    ecl::mpmc_queue< int, 4 > queue;
+    int val;
+
+    CHECK_FALSE(queue.pop(val));
+
+    for (int i = 0; i < 4; ++i) {
+        CHECK_TRUE(queue.push(i));
+    }
+
+    // Queue is full
+    CHECK_FALSE(queue.push(4));
+
+    for (int i = 0; i < 4; ++i) {
+        CHECK_TRUE(queue.pop(val));
+        CHECK_EQUAL(i, val);
+    }
+
+    CHECK_FALSE(queue.pop(val));
+}
+
+TEST(mpmc_queue, wrap_around)
+{
+    ecl::mpmc_queue< int, 2 > queue;
+    int val;
+
+    // Several laps over the same cells
+    for (int i = 0; i < 10; ++i) {
+        CHECK_TRUE(queue.push(i));
+        CHECK_TRUE(queue.pop(val));
+        CHECK_EQUAL(i, val);
+    }
+}
+
+TEST(mpmc_queue, concurrent_producers_consumers)
+{
+    constexpr int per_producer = 10000;
+    constexpr int producers = 2;
+    constexpr int consumers = 2;
+
+    ecl::mpmc_queue< int, 64 > queue;
+    std::atomic< long > sum{0};
+    std::atomic< int > popped{0};
+    std::vector< std::thread > workers;
+
+    for (int p = 0; p < producers; ++p) {
+        workers.emplace_back([&queue]() {
+            for (int i = 1; i <= per_producer; ++i) {
+                while (!queue.push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (int c = 0; c < consumers; ++c) {
+        workers.emplace_back([&]() {
+            int val;
+            while (popped.load() < producers * per_producer) {
+                if (queue.pop(val)) {
+                    sum += val;
+                    ++popped;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    // Every item is delivered exactly once
+    long expected = static_cast< long >(producers) * per_producer * (per_producer + 1) / 2;
+    CHECK_EQUAL(expected, sum.load());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
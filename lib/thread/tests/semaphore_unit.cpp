@@ -137,6 +137,59 @@ TEST(semaphore, one_semaphore_few_threads)
     test_for_each(threads, [](auto &thread) { thread.join(); });
 }
 
+TEST(semaphore, wait_for)
+{
+    ecl::semaphore sem;
+
+    auto start = ecl::os::get_ticks();
+    auto rc = sem.wait_for(20);
+    CHECK_EQUAL(ecl::err::timedout, rc);
+    CHECK(ecl::os::get_ticks() - start >= 20);
+
+    sem.signal();
+
+    rc = sem.wait_for(20);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    // Signal must be consumed
+    rc = sem.try_wait();
+    CHECK_EQUAL(ecl::err::again, rc);
+}
+
+TEST(semaphore, wait_until)
+{
+    ecl::semaphore sem;
+
+    auto deadline = ecl::os::get_ticks() + 20;
+    auto rc = sem.wait_until(deadline);
+    CHECK_EQUAL(ecl::err::timedout, rc);
+    CHECK(static_cast< int32_t >(ecl::os::get_ticks() - deadline) >= 0);
+
+    // Deadline in the past doesn't block
+    rc = sem.wait_until(deadline);
+    CHECK_EQUAL(ecl::err::timedout, rc);
+
+    sem.signal();
+
+    rc = sem.wait_until(deadline);
+    CHECK_EQUAL(ecl::err::ok, rc);
+}
+
+TEST(semaphore, wait_for_signal_from_thread)
+{
+    ecl::semaphore sem;
+
+    std::thread signaller{[&sem]() {
+        test_delay(10);
+        sem.signal();
+    }};
+
+    auto rc = sem.wait_for(5000);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    signaller.join();
+}
+
 TEST(semaphore, multiple_threads)
 {
     // Preparation
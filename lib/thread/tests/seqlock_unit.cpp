@@ -0,0 +1,86 @@
+#include <ecl/thread/seqlock.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Odd size, to check the tail word
+struct sample
+{
+    uint32_t stamp;
+    uint32_t count;
+    uint32_t sum;
+    uint8_t  flag;
+};
+
+} // namespace
+
+TEST_GROUP(seqlock)
+{
+};
+
+TEST(seqlock, store_and_load)
+{
+    ecl::seqlock< sample > lock{sample{1, 2, 3, 4}};
+
+    auto s = lock.load();
+    CHECK_EQUAL(1, s.stamp);
+    CHECK_EQUAL(3, s.sum);
+    CHECK_EQUAL(4, s.flag);
+    CHECK_EQUAL(1, lock.version());
+
+    lock.store(sample{5, 6, 7, 8});
+    CHECK_TRUE(lock.try_load(s));
+    CHECK_EQUAL(5, s.stamp);
+    CHECK_EQUAL(8, s.flag);
+    CHECK_EQUAL(2, lock.version());
+}
+
+TEST(seqlock, readers_never_see_torn_values)
+{
+    constexpr uint32_t writes = 200000;
+    ecl::seqlock< sample > lock{sample{0, 0, 0, 0}};
+    std::atomic_bool done{false};
+    std::atomic< int > torn{0};
+    std::vector< std::thread > readers;
+
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back([&] {
+            uint32_t last = 0;
+
+            while (!done.load()) {
+                auto s = lock.load();
+
+                // Fields are written together and only grow
+                if (s.sum != s.stamp + s.count || s.stamp < last) {
+                    torn++;
+                }
+
+                last = s.stamp;
+            }
+        });
+    }
+
+    for (uint32_t i = 1; i <= writes; ++i) {
+        lock.store(sample{i, i * 3, i * 4, static_cast< uint8_t >(i)});
+    }
+
+    done = true;
+    for (auto &t : readers) {
+        t.join();
+    }
+
+    CHECK_EQUAL(0, torn.load());
+    CHECK_EQUAL(writes + 1, lock.version());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
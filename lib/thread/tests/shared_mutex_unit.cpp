@@ -0,0 +1,107 @@
+#include <ecl/thread/shared_mutex.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+TEST_GROUP(shared_mutex)
+{
+};
+
+TEST(shared_mutex, try_lock)
+{
+    ecl::shared_mutex m;
+
+    CHECK_TRUE(m.try_lock_shared());
+    CHECK_TRUE(m.try_lock_shared());
+    CHECK_FALSE(m.try_lock());
+
+    m.unlock_shared();
+    m.unlock_shared();
+    CHECK_TRUE(m.try_lock());
+    CHECK_FALSE(m.try_lock_shared());
+    CHECK_FALSE(m.try_lock());
+
+    m.unlock();
+    CHECK_TRUE(m.try_lock_shared());
+    m.unlock_shared();
+}
+
+TEST(shared_mutex, readers_share_the_lock)
+{
+    ecl::shared_mutex m;
+    std::atomic< int > inside{0};
+    std::atomic< int > met{0};
+    std::vector< std::thread > readers;
+
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            ecl::shared_lock< ecl::shared_mutex > guard{m};
+            ++inside;
+
+            // All readers meet inside
+            for (int k = 0; k < 2000 && inside.load() < 4; ++k) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            if (inside.load() == 4) {
+                met++;
+            }
+        });
+    }
+
+    for (auto &t : readers) {
+        t.join();
+    }
+
+    CHECK_EQUAL(4, met.load());
+}
+
+TEST(shared_mutex, writers_exclude_everyone)
+{
+    constexpr int iterations = 5000;
+    ecl::shared_mutex m;
+    // Plain pair, race would break the invariant
+    volatile int a = 0;
+    volatile int b = 0;
+    std::atomic< int > broken{0};
+    std::vector< std::thread > threads;
+
+    for (int i = 0; i < 2; ++i) {
+        threads.emplace_back([&] {
+            for (int k = 0; k < iterations; ++k) {
+                m.lock();
+                a = a + 1;
+                b = b + 1;
+                m.unlock();
+            }
+        });
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            for (int k = 0; k < iterations; ++k) {
+                ecl::shared_lock< ecl::shared_mutex > guard{m};
+                if (a != b) {
+                    broken++;
+                }
+            }
+        });
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    CHECK_EQUAL(0, broken.load());
+    CHECK_EQUAL(2 * iterations, a);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,67 @@
+#include <ecl/thread/common/spinlock.hpp>
+
+#include <array>
+#include <thread>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+constexpr auto threads_count    = 8;
+constexpr auto iterations       = 20000;
+
+// Increments counter under the lock from few threads at once
+template< class Lock >
+static void test_exclusion()
+{
+    Lock lock;
+    // Plain variable is used, race would certainly lose increments
+    volatile int counter = 0;
+    std::array< std::thread, threads_count > threads;
+
+    for (auto &t : threads) {
+        t = std::thread{[&lock, &counter]() {
+            for (int i = 0; i < iterations; ++i) {
+                lock.lock();
+                counter = counter + 1;
+                lock.unlock();
+            }
+        }};
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    CHECK_EQUAL(threads_count * iterations, counter);
+}
+
+TEST_GROUP(spinlock)
+{
+};
+
+TEST(spinlock, mutual_exclusion)
+{
+    test_exclusion< ecl::common::spinlock >();
+}
+
+TEST(spinlock, try_lock)
+{
+    ecl::common::spinlock lock;
+
+    CHECK_TRUE(lock.try_lock());
+    CHECK_FALSE(lock.try_lock());
+
+    lock.unlock();
+    CHECK_TRUE(lock.try_lock());
+    lock.unlock();
+}
+
+TEST(spinlock, ticket_mutual_exclusion)
+{
+    test_exclusion< ecl::common::ticket_spinlock >();
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
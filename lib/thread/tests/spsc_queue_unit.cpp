@@ -0,0 +1,189 @@
+#include <ecl/thread/spsc_queue.hpp>
+#include <ecl/thread/mpmc_queue.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+TEST_GROUP(spsc_queue)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(spsc_queue, fifo_order)
+{
+    ecl::spsc_queue< int, 4 > queue;
+    int val;
+
+    CHECK_TRUE(queue.empty());
+    CHECK_FALSE(queue.pop(val));
+
+    for (int i = 0; i < 4; ++i) {
+        CHECK_TRUE(queue.push(i));
+    }
+
+    // Queue is full
+    CHECK_FALSE(queue.push(4));
+    CHECK_FALSE(queue.empty());
+
+    for (int i = 0; i < 4; ++i) {
+        CHECK_TRUE(queue.pop(val));
+        CHECK_EQUAL(i, val);
+    }
+
+    CHECK_FALSE(queue.pop(val));
+    CHECK_TRUE(queue.empty());
+}
+
+TEST(spsc_queue, wrap_around)
+{
+    ecl::spsc_queue< int, 2 > queue;
+    int val;
+
+    for (int i = 0; i < 10; ++i) {
+        CHECK_TRUE(queue.push(i));
+        CHECK_TRUE(queue.pop(val));
+        CHECK_EQUAL(i, val);
+    }
+}
+
+TEST(spsc_queue, concurrent_producer_consumer)
+{
+    constexpr int items = 100000;
+
+    ecl::spsc_queue< int, 64 > queue;
+    bool in_order = true;
+
+    std::thread consumer([&]() {
+        int val;
+        for (int i = 0; i < items; ) {
+            if (queue.pop(val)) {
+                in_order = in_order && (val == i);
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (int i = 0; i < items; ) {
+        if (queue.push(i)) {
+            ++i;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    consumer.join();
+    CHECK_TRUE(in_order);
+}
+
+//------------------------------------------------------------------------------
+// Handoff benchmarks. Only report timings, never fail on them.
+
+namespace
+{
+
+constexpr int bench_items = 200000;
+
+template< class Fn >
+long long measure_us(Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast< std::chrono::microseconds >(end - start).count();
+}
+
+template< class Queue >
+void lockfree_handoff(Queue &queue)
+{
+    std::thread consumer([&queue]() {
+        int val;
+        for (int i = 0; i < bench_items; ) {
+            if (queue.pop(val)) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (int i = 0; i < bench_items; ) {
+        if (queue.push(i)) {
+            ++i;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    consumer.join();
+}
+
+void mutex_handoff()
+{
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque< int > queue;
+
+    std::thread consumer([&]() {
+        for (int i = 0; i < bench_items; ++i) {
+            std::unique_lock< std::mutex > lk{mtx};
+            cv.wait(lk, [&queue]() { return !queue.empty(); });
+            queue.pop_front();
+        }
+    });
+
+    for (int i = 0; i < bench_items; ++i) {
+        std::lock_guard< std::mutex > lk{mtx};
+        queue.push_back(i);
+        cv.notify_one();
+    }
+
+    consumer.join();
+}
+
+} // namespace
+
+TEST_GROUP(handoff_bench)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(handoff_bench, spsc_mpmc_mutex)
+{
+    ecl::spsc_queue< int, 256 > spsc;
+    ecl::mpmc_queue< int, 256 > mpmc;
+
+    auto spsc_us  = measure_us([&spsc]() { lockfree_handoff(spsc); });
+    auto mpmc_us  = measure_us([&mpmc]() { lockfree_handoff(mpmc); });
+    auto mutex_us = measure_us(mutex_handoff);
+
+    printf("\n%d items handed over: spsc %lld us, mpmc %lld us, mutex %lld us\n",
+           bench_items, spsc_us, mpmc_us, mutex_us);
+
+    CHECK_TRUE(spsc.empty());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
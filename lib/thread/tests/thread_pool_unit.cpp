@@ -0,0 +1,148 @@
+#include <ecl/thread/thread_pool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+// Error code helper
+static SimpleString StringFrom(ecl::err err)
+{
+    return SimpleString{ecl::err_to_str(err)};
+}
+
+TEST_GROUP(thread_pool)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+static void count_job(void *arg)
+{
+    ++*static_cast< std::atomic_int * >(arg);
+}
+
+TEST(thread_pool, jobs_are_executed)
+{
+    ecl::thread_pool< 3, 16384, 64 > pool;
+    std::atomic_int cnt{0};
+
+    CHECK_EQUAL(ecl::err::ok, pool.start());
+    CHECK_EQUAL(ecl::err::busy, pool.start());
+
+    for (int i = 0; i < 50; ++i) {
+        CHECK_EQUAL(ecl::err::ok, pool.submit(count_job, &cnt));
+    }
+
+    // All pending jobs are done before workers exit
+    pool.stop();
+    CHECK_EQUAL(50, cnt.load());
+}
+
+TEST(thread_pool, queue_overflow)
+{
+    ecl::thread_pool< 1, 16384, 2 > pool;
+    std::atomic_bool release{false};
+    std::atomic_int cnt{0};
+
+    // Pool is not started, jobs are only queued
+    auto block_job = [](void *arg) {
+        while (!static_cast< std::atomic_bool * >(arg)->load()) {
+            std::this_thread::yield();
+        }
+    };
+
+    CHECK_EQUAL(ecl::err::ok, pool.submit(block_job, &release));
+    CHECK_EQUAL(ecl::err::ok, pool.submit(count_job, &cnt));
+    CHECK_EQUAL(ecl::err::nobufs, pool.submit(count_job, &cnt));
+
+    release = true;
+    pool.start();
+    pool.stop();
+
+    CHECK_EQUAL(1, cnt.load());
+}
+
+TEST(thread_pool, jobs_run_in_parallel)
+{
+    ecl::thread_pool< 2, 16384 > pool;
+    std::atomic_int arrived{0};
+
+    // Each job waits for the other one, thus they must
+    // run on different workers
+    auto rendezvous = [](void *arg) {
+        auto cnt = static_cast< std::atomic_int * >(arg);
+        ++*cnt;
+        while (cnt->load() < 2) {
+            std::this_thread::yield();
+        }
+    };
+
+    pool.start();
+    pool.submit(rendezvous, &arrived);
+    pool.submit(rendezvous, &arrived);
+    pool.stop();
+
+    CHECK_EQUAL(2, arrived.load());
+}
+
+using nested_pool = ecl::thread_pool< 2, 16384, 64 >;
+
+struct spawn_ctx
+{
+    std::atomic_int *cnt;
+    nested_pool     *pool;
+};
+
+// Submits children right from the worker
+static void parent_job(void *arg)
+{
+    auto ctx = static_cast< spawn_ctx * >(arg);
+
+    for (int i = 0; i < 20; ++i) {
+        CHECK_EQUAL(ecl::err::ok, ctx->pool->submit(count_job, ctx->cnt));
+    }
+}
+
+TEST(thread_pool, nested_submission)
+{
+    nested_pool pool;
+    std::atomic_int cnt{0};
+    spawn_ctx ctx{&cnt, &pool};
+
+    pool.start();
+    for (int i = 0; i < 3; ++i) {
+        CHECK_EQUAL(ecl::err::ok, pool.submit(parent_job, &ctx));
+    }
+
+    // Children are executed as well, even if stop is requested meanwhile
+    pool.stop();
+
+    CHECK_EQUAL(60, cnt.load());
+}
+
+TEST(thread_pool, fifo_scheduler)
+{
+    ecl::thread_pool< 2, 16384, 16, ecl::fifo_scheduler< 2, 16 > > pool;
+    std::atomic_int cnt{0};
+
+    pool.start();
+    for (int i = 0; i < 10; ++i) {
+        CHECK_EQUAL(ecl::err::ok, pool.submit(count_job, &cnt));
+    }
+    pool.stop();
+
+    CHECK_EQUAL(10, cnt.load());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -102,6 +102,69 @@ TEST(not_started_native_thread, detach)
     CHECK_EQUAL(ecl::err::srch, rc);
 }
 
+TEST(not_started_native_thread, set_priority)
+{
+    ecl::native_thread tr;
+
+    // Normal policy has the only priority
+    auto rc = tr.set_priority(1);
+    CHECK_EQUAL(ecl::err::inval, rc);
+
+    rc = tr.set_priority(0);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    rc = tr.set_policy(ecl::native_thread::sched_policy::fifo);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    rc = tr.set_priority(1);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    rc = tr.set_priority(0);
+    CHECK_EQUAL(ecl::err::inval, rc);
+}
+
+TEST(not_started_native_thread, set_affinity)
+{
+    ecl::native_thread tr;
+
+    auto rc = tr.set_affinity(0);
+    CHECK_EQUAL(ecl::err::inval, rc);
+
+    rc = tr.set_affinity(1);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    rc = tr.set_routine(dummy_routine, nullptr);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    rc = tr.start();
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    rc = tr.join();
+    CHECK_EQUAL(ecl::err::ok, rc);
+}
+
+TEST(not_started_native_thread, start_fifo)
+{
+    ecl::native_thread tr;
+
+    auto rc = tr.set_policy(ecl::native_thread::sched_policy::fifo);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    rc = tr.set_routine(dummy_routine, nullptr);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    // Unprivileged process is not allowed to use real-time policies
+    rc = tr.start();
+    if (rc == ecl::err::perm) {
+        return;
+    }
+
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    rc = tr.join();
+    CHECK_EQUAL(ecl::err::ok, rc);
+}
+
 //------------------------------------------------------------------------------
 
 struct test_arg
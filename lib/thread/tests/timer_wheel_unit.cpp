@@ -0,0 +1,199 @@
+#include <ecl/thread/timer_wheel.hpp>
+
+#include <thread>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+// Error code helper
+static SimpleString StringFrom(ecl::err err)
+{
+    return SimpleString{ecl::err_to_str(err)};
+}
+
+TEST_GROUP(timer_wheel)
+{
+    // Advances the wheel by given amount of ticks and
+    // lets the work queue process them.
+    void run_ticks(ecl::timer_wheel &wheel, ecl::work_queue &queue, uint32_t ticks)
+    {
+        for (uint32_t i = 0; i < ticks; ++i) {
+            wheel.tick();
+            queue.drain();
+        }
+    }
+
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(timer_wheel, one_shot_expires_in_time)
+{
+    ecl::work_queue queue;
+    ecl::timer_wheel wheel{queue};
+    int fired = 0;
+
+    ecl::soft_timer timer{[&fired]() { ++fired; }};
+
+    wheel.schedule(timer, 10);
+    CHECK_TRUE(timer.armed());
+
+    run_ticks(wheel, queue, 9);
+    CHECK_EQUAL(0, fired);
+
+    run_ticks(wheel, queue, 1);
+    CHECK_EQUAL(1, fired);
+    CHECK_FALSE(timer.armed());
+
+    run_ticks(wheel, queue, 100);
+    CHECK_EQUAL(1, fired);
+}
+
+TEST(timer_wheel, long_delays_cascade)
+{
+    ecl::work_queue queue;
+    ecl::timer_wheel wheel{queue};
+    std::vector< uint32_t > fired_at;
+    uint32_t now = 0;
+
+    // Delays that land on every level, and on level boundaries
+    const uint32_t delays[] = { 1, 63, 64, 65, 4095, 4096, 4097, 300000 };
+    std::vector< ecl::soft_timer * > timers;
+
+    for (auto d : delays) {
+        timers.push_back(new ecl::soft_timer{[&fired_at, &now]() { fired_at.push_back(now); }});
+        wheel.schedule(*timers.back(), d);
+    }
+
+    for (now = 1; now <= 300000; ++now) {
+        wheel.tick();
+        queue.drain();
+    }
+
+    CHECK_EQUAL(sizeof(delays) / sizeof(delays[0]), fired_at.size());
+    for (size_t i = 0; i < fired_at.size(); ++i) {
+        CHECK_EQUAL(delays[i], fired_at[i]);
+    }
+
+    for (auto t : timers) {
+        delete t;
+    }
+}
+
+TEST(timer_wheel, periodic_and_cancel)
+{
+    ecl::work_queue queue;
+    ecl::timer_wheel wheel{queue};
+    int fired = 0;
+
+    ecl::soft_timer timer{[&fired]() { ++fired; }};
+
+    wheel.schedule(timer, 5, 5);
+    run_ticks(wheel, queue, 50);
+    CHECK_EQUAL(10, fired);
+    CHECK_TRUE(timer.armed());
+
+    CHECK_EQUAL(ecl::err::ok, wheel.cancel(timer));
+    CHECK_FALSE(timer.armed());
+    CHECK_EQUAL(ecl::err::again, wheel.cancel(timer));
+
+    run_ticks(wheel, queue, 50);
+    CHECK_EQUAL(10, fired);
+}
+
+TEST(timer_wheel, rearm_from_routine)
+{
+    ecl::work_queue queue;
+    ecl::timer_wheel wheel{queue};
+    int fired = 0;
+
+    ecl::soft_timer *self = nullptr;
+    ecl::soft_timer timer{[&]() {
+        if (++fired < 3) {
+            wheel.schedule(*self, 100);
+        }
+    }};
+    self = &timer;
+
+    wheel.schedule(timer, 100);
+    run_ticks(wheel, queue, 1000);
+    CHECK_EQUAL(3, fired);
+}
+
+TEST(timer_wheel, reschedule_moves_deadline)
+{
+    ecl::work_queue queue;
+    ecl::timer_wheel wheel{queue};
+    int fired = 0;
+
+    ecl::soft_timer timer{[&fired]() { ++fired; }};
+
+    wheel.schedule(timer, 10);
+    run_ticks(wheel, queue, 5);
+
+    // Timeout is restarted, like on bus activity
+    wheel.schedule(timer, 10);
+    run_ticks(wheel, queue, 9);
+    CHECK_EQUAL(0, fired);
+
+    run_ticks(wheel, queue, 1);
+    CHECK_EQUAL(1, fired);
+}
+
+TEST(timer_wheel, ticks_batched_by_worker)
+{
+    ecl::work_queue queue;
+    ecl::timer_wheel wheel{queue};
+    int fired = 0;
+
+    ecl::soft_timer first{[&fired]() { ++fired; }};
+    ecl::soft_timer second{[&fired]() { ++fired; }};
+
+    wheel.schedule(first, 3);
+    wheel.schedule(second, 7);
+
+    // Worker was busy, while ticks were counted
+    for (int i = 0; i < 10; ++i) {
+        wheel.tick();
+    }
+
+    CHECK_EQUAL(0, fired);
+    queue.drain();
+    CHECK_EQUAL(2, fired);
+}
+
+TEST(timer_wheel, ticks_from_other_thread)
+{
+    ecl::work_queue queue;
+    ecl::timer_wheel wheel{queue};
+    std::atomic_int fired{0};
+
+    ecl::soft_timer timer{[&fired]() { ++fired; }};
+
+    wheel.schedule(timer, 1, 1);
+
+    // Tick source plays role of the timer ISR
+    std::thread ticker([&wheel]() {
+        for (int i = 0; i < 1000; ++i) {
+            wheel.tick();
+        }
+    });
+
+    ticker.join();
+
+    queue.run_once();
+    queue.drain();
+
+    CHECK_EQUAL(1000, fired.load());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,137 @@
+#include <ecl/thread/work_queue.hpp>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+// Error code helper
+static SimpleString StringFrom(ecl::err err)
+{
+    return SimpleString{ecl::err_to_str(err)};
+}
+
+TEST_GROUP(work_queue)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(work_queue, posting_order)
+{
+    ecl::work_queue queue;
+    std::vector< int > order;
+
+    ecl::work_item first{[&order]() { order.push_back(1); }};
+    ecl::work_item second{[&order]() { order.push_back(2); }};
+    ecl::work_item third{[&order]() { order.push_back(3); }};
+
+    queue.post(second);
+    queue.post(first);
+    queue.post(third);
+
+    CHECK_TRUE(first.pending());
+
+    queue.run_once();
+
+    CHECK_FALSE(first.pending());
+    CHECK_EQUAL(3, order.size());
+    CHECK_EQUAL(2, order[0]);
+    CHECK_EQUAL(1, order[1]);
+    CHECK_EQUAL(3, order[2]);
+}
+
+TEST(work_queue, pending_item_is_coalesced)
+{
+    ecl::work_queue queue;
+    int counter = 0;
+
+    ecl::work_item item{[&counter]() { counter++; }};
+
+    auto rc = queue.post(item);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    rc = queue.post(item);
+    CHECK_EQUAL(ecl::err::again, rc);
+
+    queue.run_once();
+    CHECK_EQUAL(1, counter);
+
+    // Executed item can be posted again
+    rc = queue.post(item);
+    CHECK_EQUAL(ecl::err::ok, rc);
+
+    queue.drain();
+    CHECK_EQUAL(2, counter);
+}
+
+TEST(work_queue, repost_from_routine)
+{
+    ecl::work_queue queue;
+    int counter = 0;
+
+    ecl::work_item *self = nullptr;
+    ecl::work_item item{[&]() {
+        if (++counter < 3) {
+            queue.post(*self);
+        }
+    }};
+
+    self = &item;
+
+    queue.post(item);
+
+    while (counter < 3) {
+        queue.run_once();
+    }
+
+    CHECK_EQUAL(3, counter);
+    CHECK_FALSE(item.pending());
+}
+
+TEST(work_queue, concurrent_posters)
+{
+    constexpr auto threads_count = 10;
+
+    ecl::work_queue queue;
+    std::atomic_int counter{0};
+
+    std::vector< ecl::work_item * > items;
+    for (int i = 0; i < threads_count; ++i) {
+        items.push_back(new ecl::work_item{[&counter]() { counter++; }});
+    }
+
+    std::array< std::thread, threads_count > threads;
+
+    for (int i = 0; i < threads_count; ++i) {
+        threads[i] = std::thread([&queue, &items, i]() {
+            queue.post(*items[i]);
+        });
+    }
+
+    while (counter < threads_count) {
+        queue.run_once();
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    CHECK_EQUAL(threads_count, counter.load());
+
+    for (auto item : items) {
+        delete item;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
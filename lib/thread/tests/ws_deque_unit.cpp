@@ -0,0 +1,123 @@
+#include <ecl/thread/work_stealing.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+TEST_GROUP(ws_deque)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+static void dummy_job(void *)
+{
+}
+
+static ecl::pool_job make_job(std::intptr_t id)
+{
+    return ecl::pool_job{dummy_job, reinterpret_cast< void * >(id)};
+}
+
+static std::intptr_t job_id(const ecl::pool_job &job)
+{
+    return reinterpret_cast< std::intptr_t >(job.arg);
+}
+
+TEST(ws_deque, owner_lifo_thief_fifo)
+{
+    ecl::ws_deque< 4 > deque;
+    ecl::pool_job job;
+
+    CHECK_FALSE(deque.pop(job));
+    CHECK_FALSE(deque.steal(job));
+
+    for (int i = 1; i <= 4; ++i) {
+        CHECK_TRUE(deque.push(make_job(i)));
+    }
+
+    // Deque is full
+    CHECK_FALSE(deque.push(make_job(5)));
+
+    // Owner takes most recent job
+    CHECK_TRUE(deque.pop(job));
+    CHECK_EQUAL(4, job_id(job));
+
+    // Thief takes the oldest one
+    CHECK_TRUE(deque.steal(job));
+    CHECK_EQUAL(1, job_id(job));
+
+    CHECK_TRUE(deque.pop(job));
+    CHECK_EQUAL(3, job_id(job));
+    CHECK_TRUE(deque.pop(job));
+    CHECK_EQUAL(2, job_id(job));
+
+    CHECK_FALSE(deque.pop(job));
+    CHECK_FALSE(deque.steal(job));
+}
+
+TEST(ws_deque, concurrent_steal)
+{
+    constexpr int jobs = 20000;
+    constexpr int thieves = 2;
+
+    ecl::ws_deque< 128 > deque;
+    std::atomic< long > sum{0};
+    std::atomic< int > taken{0};
+    std::vector< std::thread > workers;
+
+    for (int i = 0; i < thieves; ++i) {
+        workers.emplace_back([&]() {
+            ecl::pool_job job;
+            while (taken.load() < jobs) {
+                if (deque.steal(job)) {
+                    sum += job_id(job);
+                    ++taken;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Owner pushes all jobs and pops some of them back
+    ecl::pool_job job;
+    for (int i = 1; i <= jobs; ++i) {
+        while (!deque.push(make_job(i))) {
+            std::this_thread::yield();
+        }
+
+        if (i % 3 == 0 && deque.pop(job)) {
+            sum += job_id(job);
+            ++taken;
+        }
+    }
+
+    while (taken.load() < jobs) {
+        if (deque.pop(job)) {
+            sum += job_id(job);
+            ++taken;
+        }
+    }
+
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    // Every job is taken exactly once
+    CHECK_EQUAL(jobs, taken.load());
+    CHECK_EQUAL(static_cast< long >(jobs) * (jobs + 1) / 2, sum.load());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,172 @@
+#ifndef LIB_TYPES_RESULT_HPP_
+#define LIB_TYPES_RESULT_HPP_
+
+//!
+//! \file
+//! \brief Value or error, returned by value.
+//! Replaces sentinel values, i.e. negative sizes, and out-parameters:
+//! \code
+//!     ecl::result< size_t > read_frame(uint8_t *buf, size_t size)
+//!     {
+//!         if (size < frame_size) {
+//!             return ecl::err::msgsize;
+//!         }
+//!         ...
+//!         return frame_size;
+//!     }
+//!
+//!     auto rc = read_frame(buf, sizeof(buf));
+//!     if (!rc) {
+//!         return rc.error();
+//!     }
+//!     process(buf, *rc);
+//! \endcode
+//! Result is trivially copyable and fits in registers for small values,
+//! so it costs the same as returning a plain integer with a status.
+//!
+
+#include <ecl/err.hpp>
+
+#include <sys/types.h>
+#include <type_traits>
+
+#if defined(__has_cpp_attribute)
+#if __has_cpp_attribute(nodiscard)
+//! Warns if a result is ignored.
+#define ECL_NODISCARD [[nodiscard]]
+#endif
+#endif
+
+#ifndef ECL_NODISCARD
+#define ECL_NODISCARD
+#endif
+
+namespace ecl
+{
+
+//!
+//! \brief Value of an operation or error, why there is no value.
+//! \tparam T Type of the value. Must be trivially copyable.
+//!
+template< class T >
+class ECL_NODISCARD result
+{
+    static_assert(std::is_trivially_copyable< T >::value, "Value must be trivially copyable");
+
+public:
+    //!
+    //! \brief Constructs a successful result.
+    //!
+    constexpr result(const T &value)
+        :m_value{value}
+        ,m_err{err::ok}
+    {
+    }
+
+    //!
+    //! \brief Constructs a failed result.
+    //! \pre Error is not err::ok.
+    //!
+    constexpr result(err error)
+        :m_none{}
+        ,m_err{error}
+    {
+    }
+
+    //!
+    //! \brief Checks if result holds a value.
+    //!
+    constexpr bool ok() const { return m_err == err::ok; }
+
+    //!
+    //! \brief Checks if result holds a value.
+    //!
+    constexpr explicit operator bool() const { return ok(); }
+
+    //!
+    //! \brief Gets the error, err::ok if result holds a value.
+    //!
+    constexpr err error() const { return m_err; }
+
+    //!
+    //! \brief Gets the value.
+    //! \pre Result holds a value.
+    //!
+    constexpr const T &value() const { return m_value; }
+
+    //!
+    //! \brief Gets the value, or given one if result holds an error.
+    //!
+    constexpr T value_or(const T &other) const { return ok() ? m_value : other; }
+
+    //! \copydoc value()
+    constexpr const T &operator*() const { return m_value; }
+
+    //! \copydoc value()
+    constexpr const T *operator->() const { return &m_value; }
+
+private:
+    //! Placeholder, so value type needs no default constructor.
+    struct none
+    {
+    };
+
+    union
+    {
+        T       m_value;    //!< Value, valid if there is no error.
+        none    m_none;     //!< Placeholder for failed results.
+    };
+
+    err m_err;              //!< Status of the operation.
+};
+
+//!
+//! \brief Result of an operation, which gives no value.
+//!
+template<>
+class ECL_NODISCARD result< void >
+{
+public:
+    //!
+    //! \brief Constructs a result from status.
+    //!
+    constexpr result(err error = err::ok)
+        :m_err{error}
+    {
+    }
+
+    //! \copydoc result::ok()
+    constexpr bool ok() const { return m_err == err::ok; }
+
+    //! \copydoc result::ok()
+    constexpr explicit operator bool() const { return ok(); }
+
+    //! \copydoc result::error()
+    constexpr err error() const { return m_err; }
+
+private:
+    err m_err;              //!< Status of the operation.
+};
+
+//!
+//! \brief Converts size, returned in legacy way, to a result.
+//! \param[in] rc    Size, or negative value if error.
+//! \param[in] error Error to report, since legacy value doesn't tell it.
+//!
+constexpr result< size_t > to_result(ssize_t rc, err error = err::io)
+{
+    return rc < 0 ? result< size_t >{error} : result< size_t >{static_cast< size_t >(rc)};
+}
+
+//!
+//! \brief Converts a result to size, for legacy interfaces.
+//! \return Size, or -1 if result holds an error.
+//!
+constexpr ssize_t to_ssize(const result< size_t > &r)
+{
+    return r ? static_cast< ssize_t >(*r) : -1;
+}
+
+} // namespace ecl
+
+#endif // LIB_TYPES_RESULT_HPP_
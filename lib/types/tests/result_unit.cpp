@@ -0,0 +1,99 @@
+#include <ecl/result.hpp>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+struct point
+{
+    // No default constructor
+    point(int x_, int y_) : x{x_}, y{y_} { }
+
+    int x;
+    int y;
+};
+
+ecl::result< size_t > parse(const char *s)
+{
+    if (!s) {
+        return ecl::err::inval;
+    }
+
+    return static_cast< size_t >(s[0] - '0');
+}
+
+static_assert(std::is_trivially_copyable< ecl::result< size_t > >::value, "");
+static_assert(std::is_trivially_copyable< ecl::result< point > >::value, "");
+static_assert(sizeof(ecl::result< uint32_t >) == 2 * sizeof(uint32_t), "");
+
+constexpr ecl::result< int > constant{5};
+static_assert(constant.ok() && *constant == 5, "");
+
+} // namespace
+
+TEST_GROUP(result)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(result, value_and_error)
+{
+    auto ok = parse("7");
+    auto bad = parse(nullptr);
+
+    CHECK_TRUE(ok.ok());
+    CHECK_TRUE(static_cast< bool >(ok));
+    CHECK_EQUAL(7, *ok);
+    CHECK_EQUAL(7, ok.value_or(1));
+    CHECK_TRUE(ecl::err::ok == ok.error());
+
+    CHECK_FALSE(bad.ok());
+    CHECK_TRUE(ecl::err::inval == bad.error());
+    CHECK_EQUAL(1, bad.value_or(1));
+}
+
+TEST(result, value_without_default_constructor)
+{
+    ecl::result< point > p{point{1, 2}};
+    ecl::result< point > none{ecl::err::noent};
+
+    CHECK_EQUAL(2, p->y);
+    CHECK_FALSE(none);
+
+    // Results are copied as plain data
+    none = p;
+    CHECK_EQUAL(1, none->x);
+}
+
+TEST(result, void_result)
+{
+    ecl::result< void > ok;
+    ecl::result< void > bad{ecl::err::io};
+
+    CHECK_TRUE(ok);
+    CHECK_FALSE(bad);
+    CHECK_TRUE(ecl::err::io == bad.error());
+}
+
+TEST(result, legacy_conversions)
+{
+    CHECK_EQUAL(10, *ecl::to_result(10));
+    CHECK_TRUE(ecl::err::io == ecl::to_result(-1).error());
+    CHECK_TRUE(ecl::err::busy == ecl::to_result(-1, ecl::err::busy).error());
+
+    CHECK_EQUAL(3, ecl::to_ssize(3));
+    CHECK_EQUAL(-1, ecl::to_ssize(ecl::err::nospc));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -1,8 +1,10 @@
-#include "assert.h"
+#include <ecl/assert.h>
 
 #include <ecl/iostream.hpp>
 
 extern "C"
+{
+
 void ecl_assert_failed(const char *assertion,
                        const char *message,
                        const char *file,
@@ -21,3 +23,5 @@ void ecl_assert_failed(const char *assertion,
 
     for(;;);
 }
+
+}
@@ -0,0 +1,26 @@
+#include <ecl/assert.h>
+
+// Compact asserts, kept apart from the full one to not pull in iostream
+
+extern "C"
+{
+
+volatile ecl_assert_record ecl_assert_last;
+
+__attribute__((weak))
+void ecl_assert_hook(const volatile ecl_assert_record *rec)
+{
+    (void) rec;
+}
+
+void ecl_assert_fault(uint32_t file_id, unsigned int line)
+{
+    ecl_assert_last.file_id = file_id;
+    ecl_assert_last.line = line;
+
+    ecl_assert_hook(&ecl_assert_last);
+
+    for(;;);
+}
+
+}
@@ -1,50 +1,177 @@
 #ifndef LIB_UTILS_ASSERT_HPP_
 #define LIB_UTILS_ASSERT_HPP_
 
+// Asserts with configurable levels.
+//
+// Each assert is checked only if its level is enabled:
+//
+//   ECL_ASSERT_OFF      - nothing is checked, asserts cost nothing
+//   ECL_ASSERT_CHEAP    - ecl_assert() and ecl_assert_msg(), O(1) checks
+//   ECL_ASSERT_PARANOID - also ecl_assert_paranoid(), i.e. scans of buffers
+//
+// ECL_ASSERT_LEVEL is off if NDEBUG is defined and cheap otherwise.
+// Subsystems on hot paths check their own level, which defaults to the
+// global one, so they can be tuned separately:
+//
+//   ecl_assert_level(ECL_ASSERT_LEVEL_BUS, m_state & bus_locked);
+//
+// Since these are header-only in many cases, levels must be defined for
+// all translation units, i.e. with CONFIG_ASSERT_LEVEL and
+// CONFIG_ASSERT_LEVEL_<SUBSYSTEM> build options.
+//
+// If ECL_ASSERT_COMPACT is defined, failed asserts don't keep strings
+// with conditions and file names in the image. Only file id, which is a hash
+// of the file name, and line are stored in ecl_assert_last, so they can be
+// read by a debugger or saved by ecl_assert_hook() before the system halts.
+
 #if __STDC_HOSTED__
-#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+
+#include <stdint.h>
+
+#define ECL_ASSERT_OFF          0
+#define ECL_ASSERT_CHEAP        1
+#define ECL_ASSERT_PARANOID     2
+
+#ifndef ECL_ASSERT_LEVEL
+#ifdef NDEBUG
+#define ECL_ASSERT_LEVEL        ECL_ASSERT_OFF
+#else
+#define ECL_ASSERT_LEVEL        ECL_ASSERT_CHEAP
+#endif
+#endif
+
+// Levels of subsystems
+#ifndef ECL_ASSERT_LEVEL_BUS
+#define ECL_ASSERT_LEVEL_BUS    ECL_ASSERT_LEVEL
+#endif
+
+#ifndef ECL_ASSERT_LEVEL_ALLOC
+#define ECL_ASSERT_LEVEL_ALLOC  ECL_ASSERT_LEVEL
 #endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#if __STDC_HOSTED__
-// Assert itself
-#define ecl_assert(cond) \
-    assert(cond)
+// Record of the last failed assert, in compact mode
+struct ecl_assert_record
+{
+    uint32_t file_id;   // Hash of the file name, see ecl_file_id()
+    uint32_t line;      // Line of the assert
+};
 
-// Prints some useful message before asserting
-#define ecl_assert_msg(cond, message) \
-    do { if (!(cond)) { puts(message); assert(cond); } } while (0)
-#else
-// These two is same as above but just works without libc implementation
+extern volatile struct ecl_assert_record ecl_assert_last;
 
-#define ecl_assert(COND) \
-do { \
-    if (!(COND)) { \
-        ecl_assert_failed((#COND), NULL, __FILE__, __func__, __LINE__);\
-    } \
-} while(0)
+// Called in compact mode after the record is filled, i.e. to save it in
+// backup memory and reset the system instead of halting. Weak, does nothing
+// by default.
+void ecl_assert_hook(const volatile struct ecl_assert_record *rec);
 
-#define ecl_assert_msg(COND, MESSAGE) \
-    do { \
-        if (!(COND)) { \
-            ecl_assert_failed((#COND), (MESSAGE), __FILE__, __func__, __LINE__);\
-        } \
-    } while(0)
+// Compact assert routine, records the failure and halts
+__attribute__((noreturn))
+void ecl_assert_fault(uint32_t file_id, unsigned int line);
 
 // Real assert routine
+__attribute__((noreturn))
 void ecl_assert_failed(const char *assertion,
                        const char *message,
                        const char *file,
                        const char *func,
                        unsigned int line);
 
+#ifdef __cplusplus
+}
 #endif
 
+#ifndef ECL_FILE_ID
 #ifdef __cplusplus
+
+// FNV-1a of the file name without directories, so ids don't depend
+// on the build location
+constexpr uint32_t ecl_file_id(const char *path)
+{
+    const char *base = path;
+    for (const char *p = path; *p; ++p) {
+        if (*p == '/' || *p == '\\') {
+            base = p + 1;
+        }
+    }
+
+    uint32_t h = 2166136261u;
+    for (; *base; ++base) {
+        h = (h ^ static_cast< uint8_t >(*base)) * 16777619u;
+    }
+
+    return h;
 }
+
+// Template argument makes sure the hash is computed at compile time
+template< uint32_t id >
+struct ecl_file_id_holder
+{
+    static constexpr uint32_t value = id;
+};
+
+#define ECL_FILE_ID (ecl_file_id_holder< ecl_file_id(__FILE__) >::value)
+#else
+#define ECL_FILE_ID 0
+#endif
+#endif
+
+#if defined(ECL_ASSERT_COMPACT)
+#define ecl_assert_fail_(COND, MESSAGE) \
+    ecl_assert_fault(ECL_FILE_ID, __LINE__)
+#elif __STDC_HOSTED__
+// Same message as of the libc assert, which is disabled by NDEBUG
+#define ecl_assert_fail_(COND, MESSAGE) \
+    do { \
+        const char *ecl_msg_ = (MESSAGE); \
+        if (ecl_msg_) { \
+            fprintf(stderr, "%s\n", ecl_msg_); \
+        } \
+        fprintf(stderr, "%s:%u: %s: Assertion `%s' failed.\n", \
+                __FILE__, __LINE__, __func__, (COND)); \
+        abort(); \
+    } while (0)
+#else
+#define ecl_assert_fail_(COND, MESSAGE) \
+    ecl_assert_failed((COND), (MESSAGE), __FILE__, __func__, __LINE__)
 #endif
 
+// Checks condition if given level is at least cheap. Disabled condition
+// is compiled, but never evaluated.
+#define ecl_assert_level(LEVEL, COND) \
+    do { \
+        if ((LEVEL) >= ECL_ASSERT_CHEAP && !(COND)) { \
+            ecl_assert_fail_(#COND, 0); \
+        } \
+    } while (0)
+
+// Checks condition if given level is paranoid
+#define ecl_assert_level_paranoid(LEVEL, COND) \
+    do { \
+        if ((LEVEL) >= ECL_ASSERT_PARANOID && !(COND)) { \
+            ecl_assert_fail_(#COND, 0); \
+        } \
+    } while (0)
+
+// Assert itself
+#define ecl_assert(COND) \
+    ecl_assert_level(ECL_ASSERT_LEVEL, COND)
+
+// Prints some useful message before asserting
+#define ecl_assert_msg(COND, MESSAGE) \
+    do { \
+        if (ECL_ASSERT_LEVEL >= ECL_ASSERT_CHEAP && !(COND)) { \
+            ecl_assert_fail_(#COND, (MESSAGE)); \
+        } \
+    } while (0)
+
+// Expensive check, i.e. of the whole data structure
+#define ecl_assert_paranoid(COND) \
+    ecl_assert_level_paranoid(ECL_ASSERT_LEVEL, COND)
+
 #endif // LIB_UTILS_ASSERT_HPP_
@@ -0,0 +1,82 @@
+#ifndef LIB_UTILS_CALENDAR_HPP_
+#define LIB_UTILS_CALENDAR_HPP_
+
+//!
+//! \file
+//! \brief Conversions between calendar time, Unix time and FAT timestamps.
+//! All times are UTC, proleptic Gregorian calendar is used.
+//!
+
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Calendar date and time.
+//!
+struct date_time
+{
+    uint16_t    year;   //!< Year, i.e. 2024.
+    uint8_t     month;  //!< Month, 1 .. 12.
+    uint8_t     day;    //!< Day of month, 1 .. 31.
+    uint8_t     hour;   //!< Hour, 0 .. 23.
+    uint8_t     min;    //!< Minute, 0 .. 59.
+    uint8_t     sec;    //!< Second, 0 .. 59.
+};
+
+//!
+//! \brief Converts calendar time to seconds since 1970-01-01 00:00:00.
+//! \pre Time is not before 1970.
+//!
+constexpr uint32_t to_unix(const date_time &dt)
+{
+    // Year starts in March, so leap day is the last one
+    int y = dt.year - (dt.month <= 2);
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (dt.month + (dt.month > 2 ? -3 : 9)) + 2) / 5 + dt.day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    uint32_t days = era * 146097 + doe - 719468;
+
+    return days * 86400 + dt.hour * 3600 + dt.min * 60 + dt.sec;
+}
+
+//!
+//! \brief Converts seconds since 1970-01-01 00:00:00 to calendar time.
+//!
+constexpr date_time from_unix(uint32_t secs)
+{
+    uint32_t days = secs / 86400 + 719468;
+    uint32_t rem = secs % 86400;
+    uint32_t era = days / 146097;
+    uint32_t doe = days - era * 146097;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+
+    return date_time{
+        static_cast< uint16_t >(yoe + era * 400 + (month <= 2)),
+        static_cast< uint8_t >(month),
+        static_cast< uint8_t >(doy - (153 * mp + 2) / 5 + 1),
+        static_cast< uint8_t >(rem / 3600),
+        static_cast< uint8_t >(rem / 60 % 60),
+        static_cast< uint8_t >(rem % 60),
+    };
+}
+
+//!
+//! \brief Packs calendar time into FAT timestamp: date in upper half,
+//! time in lower half. FAT time has two-second resolution.
+//! \pre Year is in 1980 .. 2107.
+//!
+constexpr uint32_t to_fat(const date_time &dt)
+{
+    return static_cast< uint32_t >((dt.year - 1980) << 9 | dt.month << 5 | dt.day) << 16
+           | dt.hour << 11 | dt.min << 5 | dt.sec / 2;
+}
+
+} // namespace ecl
+
+#endif // LIB_UTILS_CALENDAR_HPP_
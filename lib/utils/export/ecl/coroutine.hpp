@@ -0,0 +1,145 @@
+#ifndef LIB_UTILS_COROUTINE_HPP_
+#define LIB_UTILS_COROUTINE_HPP_
+
+//!
+//! \file
+//! \brief Stackless coroutines for driver state machines.
+//! Long sequences, like SD card or display initialization, can be written
+//! as a plain function that returns err::again instead of blocking. Function
+//! is called again later and resumes where it left off. No stack is kept per
+//! coroutine, only the resume point, thus many devices can be driven from
+//! single thread.
+//! \par Example
+//! \code
+//! ecl::coroutine m_co;
+//!
+//! ecl::err init()
+//! {
+//!     ECL_CO_BEGIN(m_co);
+//!
+//!     send_reset();
+//!     ECL_CO_AWAIT(m_co, card_ready());
+//!     ECL_CO_AWAIT_CALL(m_co, read_config());  // Nested coroutine
+//!
+//!     ECL_CO_END(m_co);
+//! }
+//! \endcode
+//! \warning Local variables are not preserved across suspension points,
+//!          keep the state in object members. Only one suspension point per
+//!          line is allowed. Suspension points can't be placed inside
+//!          a switch statement.
+//! \note    Implemented with switch-based resumption (Duff's device),
+//!          since only C++14 is available.
+//!
+
+#include <ecl/err.hpp>
+
+namespace ecl
+{
+
+//!
+//! \brief Resume point of a stackless coroutine.
+//! See ECL_CO_BEGIN() and friends.
+//!
+class coroutine
+{
+public:
+    constexpr coroutine() :m_point{0} { }
+
+    //! Checks if coroutine ran to completion.
+    bool done() const { return m_point == finished; }
+
+    //! Rewinds coroutine, so the next call starts from the beginning.
+    void reset() { m_point = 0; }
+
+    //! Gets resume point. For use by ECL_CO_*() macros only.
+    int &point() { return m_point; }
+
+    //! Resume point of a completed coroutine.
+    static constexpr int finished = -1;
+
+private:
+    int m_point; //!< Line to resume from, or special value.
+};
+
+//!
+//! \brief Runs coroutines round-robin on the current thread until all
+//! of them complete.
+//! \param[in] tasks Callables, returning err::again while in progress.
+//! \return First error returned by any task, or err::ok.
+//!
+template< class... Tasks >
+err co_run(Tasks&&... tasks)
+{
+    for (;;) {
+        bool pending = false;
+        err rc = err::ok;
+
+        // Expand over pack in order, stop at first error
+        auto step = [&](auto &&task) {
+            if (is_error(rc)) {
+                return;
+            }
+
+            auto task_rc = task();
+            if (task_rc == err::again) {
+                pending = true;
+            } else if (is_error(task_rc)) {
+                rc = task_rc;
+            }
+        };
+
+        int expand[] = { 0, (step(tasks), 0)... };
+        (void) expand;
+
+        if (is_error(rc)) {
+            return rc;
+        }
+
+        if (!pending) {
+            return err::ok;
+        }
+    }
+}
+
+} // namespace ecl
+
+//! Marks resume point on the current line.
+//! Label is hidden in dead branch, so code never falls through into it.
+#define ECL_CO_POINT_(co) \
+    (co).point() = __LINE__; if (false) { case __LINE__:; }
+
+//! Starts coroutine body. Must be the first statement of the function.
+#define ECL_CO_BEGIN(co) \
+    switch ((co).point()) { case 0:;
+
+//! Suspends coroutine. Next call resumes right after this point.
+#define ECL_CO_YIELD(co) \
+    do { (co).point() = __LINE__; return ::ecl::err::again; case __LINE__:; } while (0)
+
+//! Suspends coroutine until given condition is true.
+#define ECL_CO_AWAIT(co, cond) \
+    do { ECL_CO_POINT_(co) if (!(cond)) { return ::ecl::err::again; } } while (0)
+
+//! Suspends coroutine until nested coroutine call completes.
+//! Error of nested coroutine finishes this one with the same error.
+#define ECL_CO_AWAIT_CALL(co, call) \
+    do { \
+        ECL_CO_POINT_(co) \
+        auto ecl_co_rc_ = (call); \
+        if (ecl_co_rc_ == ::ecl::err::again) { return ecl_co_rc_; } \
+        if (::ecl::is_error(ecl_co_rc_)) { \
+            (co).point() = ::ecl::coroutine::finished; \
+            return ecl_co_rc_; \
+        } \
+    } while (0)
+
+//! Finishes coroutine with given status.
+#define ECL_CO_RETURN(co, rc) \
+    do { (co).point() = ::ecl::coroutine::finished; return (rc); } while (0)
+
+//! Ends coroutine body. Must be the last statement of the function.
+#define ECL_CO_END(co) \
+    if (false) { default:; } } (co).point() = ::ecl::coroutine::finished; return ::ecl::err::ok
+
+#endif // LIB_UTILS_COROUTINE_HPP_
@@ -0,0 +1,53 @@
+#ifndef LIB_UTILS_CRC_HPP_
+#define LIB_UTILS_CRC_HPP_
+
+//!
+//! \file
+//! \brief CRC routines, used by storage and communication drivers.
+//!
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Computes CRC-16/XMODEM (polynomial 0x1021, no reflection).
+//! This is the data CRC used by SD cards. Table-driven, processes
+//! a byte per lookup.
+//! \param[in] data Data to process.
+//! \param[in] size Size of data.
+//! \param[in] crc  Initial value, or CRC of previous data in case of
+//!                 a piecewise computation.
+//! \return CRC of the data.
+//!
+uint16_t crc16(const uint8_t *data, size_t size, uint16_t crc = 0);
+
+//!
+//! \brief Computes CRC-7 (polynomial 0x09).
+//! This is the command CRC used by SD cards.
+//! \param[in] data Data to process.
+//! \param[in] size Size of data.
+//! \param[in] crc  Initial value, or CRC of previous data.
+//! \return CRC of the data, in lower 7 bits.
+//!
+uint8_t crc7(const uint8_t *data, size_t size, uint8_t crc = 0);
+
+//!
+//! \brief Computes CRC-32 of 32-bit words, the same way STM32 CRC unit does.
+//! Polynomial is 0x04c11db7, no reflection and no final xor. Each word is
+//! processed starting from its most significant bit, so for a byte stream
+//! result equals CRC-32/MPEG-2 of the bytes only if the words are packed
+//! big-endian. Slicing-by-8: two words per iteration, using eight tables.
+//! \param[in] data Words to process.
+//! \param[in] n    Amount of words.
+//! \param[in] crc  Initial value, or CRC of previous words.
+//! \return CRC of the words.
+//! \sa hw_crc32
+//!
+uint32_t crc32(const uint32_t *data, size_t n, uint32_t crc = 0xffffffff);
+
+} // namespace ecl
+
+#endif // LIB_UTILS_CRC_HPP_
@@ -0,0 +1,266 @@
+//!
+//! \file
+//! \brief Function wrapper with fixed in-place storage.
+//! Unlike std::function, callable is always placed inside the wrapper itself,
+//! so construction, copy and assignment never touch the heap. Callable
+//! that doesn't fit is rejected at compile time. Trivially copyable callables,
+//! like function pointers and lambdas capturing pointers, are copied as plain
+//! bytes, without indirect calls. Thus wrapper can be safely assigned in ISR.
+//! \code
+//! ecl::inplace_function< void(int) > fn = [this](int v) { m_value = v; };
+//! fn(42);
+//! \endcode
+//!
+#ifndef ECL_INPLACE_FUNCTION_HPP_
+#define ECL_INPLACE_FUNCTION_HPP_
+
+#include <ecl/assert.h>
+
+#include <cstddef>
+#include <new>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+namespace ecl
+{
+
+//! Default storage size, enough for a member function pointer and an object.
+static constexpr size_t inplace_function_capacity = 4 * sizeof(void *);
+
+template< class Sig, size_t Capacity = inplace_function_capacity >
+class inplace_function;
+
+//!
+//! \brief Function wrapper with fixed in-place storage.
+//! \tparam R        Return type.
+//! \tparam Args     Argument types.
+//! \tparam Capacity Storage size, in bytes.
+//!
+template< class R, class... Args, size_t Capacity >
+class inplace_function< R(Args...), Capacity >
+{
+    static_assert(Capacity >= sizeof(void *), "Storage must hold at least a pointer");
+
+    //! Checks if callable can be invoked with Args and its result converts to R.
+    template< class Fn, class = void >
+    struct is_callable : std::false_type { };
+
+    template< class Fn >
+    struct is_callable< Fn, typename std::enable_if<
+            std::is_void< R >::value
+            || std::is_convertible< decltype(std::declval< Fn& >()(std::declval< Args >()...)),
+                                    R >::value,
+            decltype(void(std::declval< Fn& >()(std::declval< Args >()...))) >::type >
+        : std::true_type { };
+
+public:
+    //! Constructs empty wrapper.
+    constexpr inplace_function() noexcept
+        :m_storage{}, m_invoke{nullptr}, m_ops{nullptr} { }
+
+    //! Constructs empty wrapper.
+    constexpr inplace_function(std::nullptr_t) noexcept
+        :inplace_function{} { }
+
+    //!
+    //! \brief Wraps given callable.
+    //! Null function pointer gives empty wrapper, as in std::function.
+    //!
+    template< class F, class Fn = typename std::decay< F >::type,
+              class = typename std::enable_if<
+                  !std::is_same< Fn, inplace_function >::value
+                  && is_callable< Fn >::value >::type >
+    inplace_function(F &&f)
+        :inplace_function{}
+    {
+        static_assert(sizeof(Fn) <= Capacity,
+                      "Callable doesn't fit into inplace_function, increase Capacity");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t),
+                      "Callable alignment is not supported");
+
+        if (is_null(f)) {
+            return;
+        }
+
+        new (m_storage) Fn(std::forward< F >(f));
+        m_invoke = invoke< Fn >;
+        m_ops    = trivial< Fn >() ? nullptr : &ops_for< Fn >::table;
+    }
+
+    inplace_function(const inplace_function &other)
+        :inplace_function{}
+    {
+        copy_from(other);
+    }
+
+    inplace_function(inplace_function &&other) noexcept
+        :inplace_function{}
+    {
+        move_from(other);
+    }
+
+    ~inplace_function()
+    {
+        reset();
+    }
+
+    inplace_function &operator=(const inplace_function &other)
+    {
+        if (this != &other) {
+            reset();
+            copy_from(other);
+        }
+
+        return *this;
+    }
+
+    inplace_function &operator=(inplace_function &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            move_from(other);
+        }
+
+        return *this;
+    }
+
+    inplace_function &operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    //!
+    //! \brief Invokes wrapped callable.
+    //! \pre Wrapper is not empty.
+    //!
+    R operator()(Args... args) const
+    {
+        ecl_assert(m_invoke);
+        return m_invoke(m_storage, std::forward< Args >(args)...);
+    }
+
+    //! Checks if callable is wrapped.
+    explicit operator bool() const noexcept { return m_invoke != nullptr; }
+
+    friend bool operator==(const inplace_function &f, std::nullptr_t) noexcept { return !f; }
+    friend bool operator==(std::nullptr_t, const inplace_function &f) noexcept { return !f; }
+    friend bool operator!=(const inplace_function &f, std::nullptr_t) noexcept { return !!f; }
+    friend bool operator!=(std::nullptr_t, const inplace_function &f) noexcept { return !!f; }
+
+private:
+    using invoke_fn = R (*)(const unsigned char *storage, Args&&... args);
+
+    //! Operations on callables, that are not trivially copyable.
+    struct ops
+    {
+        void (*copy)(unsigned char *dst, const unsigned char *src);
+        void (*move)(unsigned char *dst, unsigned char *src);
+        void (*destroy)(unsigned char *storage);
+    };
+
+    template< class Fn >
+    struct ops_for
+    {
+        static void copy(unsigned char *dst, const unsigned char *src)
+        {
+            new (dst) Fn(*reinterpret_cast< const Fn* >(src));
+        }
+
+        static void move(unsigned char *dst, unsigned char *src)
+        {
+            new (dst) Fn(std::move(*reinterpret_cast< Fn* >(src)));
+            reinterpret_cast< Fn* >(src)->~Fn();
+        }
+
+        static void destroy(unsigned char *storage)
+        {
+            reinterpret_cast< Fn* >(storage)->~Fn();
+        }
+
+        static constexpr ops table = { copy, move, destroy };
+    };
+
+    template< class Fn >
+    static constexpr bool trivial()
+    {
+        return std::is_trivially_copy_constructible< Fn >::value
+                && std::is_trivially_destructible< Fn >::value;
+    }
+
+    template< class Fn >
+    static R invoke(const unsigned char *storage, Args&&... args)
+    {
+        // Callable is invoked as non-const, as std::function does
+        auto &fn = *reinterpret_cast< Fn* >(const_cast< unsigned char* >(storage));
+        return fn(std::forward< Args >(args)...);
+    }
+
+    template< class Fn >
+    static bool is_null(const Fn &fn, typename std::enable_if<
+                        std::is_pointer< Fn >::value
+                        || std::is_member_pointer< Fn >::value >::type * = nullptr)
+    {
+        return fn == nullptr;
+    }
+
+    template< class Fn >
+    static bool is_null(const Fn &, typename std::enable_if<
+                        !std::is_pointer< Fn >::value
+                        && !std::is_member_pointer< Fn >::value >::type * = nullptr)
+    {
+        return false;
+    }
+
+    void copy_from(const inplace_function &other)
+    {
+        if (other.m_ops) {
+            other.m_ops->copy(m_storage, other.m_storage);
+        } else {
+            // Trivially copyable or empty
+            memcpy(m_storage, other.m_storage, Capacity);
+        }
+
+        m_invoke = other.m_invoke;
+        m_ops    = other.m_ops;
+    }
+
+    void move_from(inplace_function &other)
+    {
+        if (other.m_ops) {
+            other.m_ops->move(m_storage, other.m_storage);
+        } else {
+            memcpy(m_storage, other.m_storage, Capacity);
+        }
+
+        m_invoke = other.m_invoke;
+        m_ops    = other.m_ops;
+
+        other.m_invoke = nullptr;
+        other.m_ops    = nullptr;
+    }
+
+    void reset()
+    {
+        if (m_ops) {
+            m_ops->destroy(m_storage);
+        }
+
+        m_invoke = nullptr;
+        m_ops    = nullptr;
+    }
+
+    alignas(std::max_align_t) unsigned char m_storage[Capacity];  //!< Callable storage.
+    invoke_fn                               m_invoke;   //!< Invokes the callable, null if empty.
+    const ops                               *m_ops;     //!< Null if callable is trivial.
+};
+
+template< class R, class... Args, size_t Capacity >
+template< class Fn >
+constexpr typename inplace_function< R(Args...), Capacity >::ops
+inplace_function< R(Args...), Capacity >::ops_for< Fn >::table;
+
+} // namespace ecl
+
+#endif // ECL_INPLACE_FUNCTION_HPP_
@@ -0,0 +1,36 @@
+#ifndef LIB_UTILS_IOVEC_HPP_
+#define LIB_UTILS_IOVEC_HPP_
+
+//!
+//! \file
+//! \brief Buffer of vectored I/O.
+//! Message, assembled from few buffers, i.e. a header and a body, is
+//! written or read at once, without being copied into a single buffer:
+//! \code
+//! ecl::iovec iov[] = {
+//!     { &hdr, sizeof(hdr) },
+//!     { payload, payload_len },
+//! };
+//!
+//! pipe.writev(iov, 2);
+//! \endcode
+//! Layout is the same as of POSIX struct iovec.
+//!
+
+#include <cstddef>
+
+namespace ecl
+{
+
+//!
+//! \brief Single buffer of vectored I/O.
+//!
+struct iovec
+{
+    void    *iov_base;  //!< Start of the buffer.
+    size_t  iov_len;    //!< Size of the buffer.
+};
+
+} // namespace ecl
+
+#endif // LIB_UTILS_IOVEC_HPP_
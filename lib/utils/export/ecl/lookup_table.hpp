@@ -0,0 +1,125 @@
+//!
+//! \file
+//! \brief Compile-time key-value tables.
+//! Replaces chains of ifs and switches that map a device, given as a template
+//! argument, to its registers, IRQ numbers and clock bits. Table is evaluated
+//! by the compiler only, so no lookup code gets to init and IRQ paths, and
+//! a key missing from the table is reported by static_assert rather than
+//! by a sentinel value returned at runtime.
+//! \code
+//! template< usart_device dev >
+//! constexpr auto pick_irqn()
+//! {
+//!     constexpr auto irqns = ecl::make_lookup_table< usart_device, IRQn_Type >({
+//!         { usart_device::dev_1, USART1_IRQn },
+//!         { usart_device::dev_2, USART2_IRQn },
+//!     });
+//!
+//!     static_assert(irqns.contains(dev), "USART is not supported");
+//!     return irqns[dev];
+//! }
+//! \endcode
+//!
+#ifndef ECL_LOOKUP_TABLE_HPP_
+#define ECL_LOOKUP_TABLE_HPP_
+
+#include <cstddef>
+
+namespace ecl
+{
+
+//!
+//! \brief Single entry of a lookup table.
+//!
+template< class K, class V >
+struct lookup_entry
+{
+    K key;      //!< Key, compared by equality.
+    V value;    //!< Value, mapped to the key.
+};
+
+//!
+//! \brief Table of unique keys and corresponding values.
+//! Intended to be constexpr, i.e. a local constant of a constexpr picker.
+//! Keys and values must be literal and default-constructible types,
+//! e.g. enums, integers and function pointers.
+//! \tparam K Key type.
+//! \tparam V Value type.
+//! \tparam N Amount of entries.
+//!
+template< class K, class V, size_t N >
+class lookup_table
+{
+public:
+    //! Constructs table from array of entries.
+    constexpr lookup_table(const lookup_entry< K, V > (&entries)[N])
+        :m_entries{}
+    {
+        for (size_t i = 0; i < N; ++i) {
+            m_entries[i] = entries[i];
+        }
+    }
+
+    //! Gets amount of entries.
+    static constexpr size_t size() { return N; }
+
+    //! Gets position of a key in the table, N if key is absent.
+    constexpr size_t index_of(K key) const
+    {
+        for (size_t i = 0; i < N; ++i) {
+            if (m_entries[i].key == key) {
+                return i;
+            }
+        }
+
+        return N;
+    }
+
+    //! Checks if key is present.
+    constexpr bool contains(K key) const { return index_of(key) < N; }
+
+    //!
+    //! \brief Gets value of given key.
+    //! Look up of an absent key is not a constant expression, thus
+    //! it fails to compile when evaluated by the compiler.
+    //! \pre Key is present.
+    //!
+    constexpr V operator[](K key) const { return m_entries[index_of(key)].value; }
+
+    //! Gets value of given key or fallback if key is absent.
+    constexpr V value_or(K key, V fallback) const
+    {
+        return contains(key) ? m_entries[index_of(key)].value : fallback;
+    }
+
+    //! Checks that no key is listed twice.
+    constexpr bool unique() const
+    {
+        for (size_t i = 0; i < N; ++i) {
+            if (index_of(m_entries[i].key) != i) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    lookup_entry< K, V > m_entries[N];  //!< Entries, in order of declaration.
+};
+
+//!
+//! \brief Makes lookup table, deducing its size from given entries.
+//! \code
+//! constexpr auto t = ecl::make_lookup_table< int, char >({ { 1, 'a' }, { 2, 'b' } });
+//! \endcode
+//!
+template< class K, class V, size_t N >
+constexpr lookup_table< K, V, N > make_lookup_table(const lookup_entry< K, V > (&entries)[N])
+{
+    return lookup_table< K, V, N >{entries};
+}
+
+} // namespace ecl
+
+#endif // ECL_LOOKUP_TABLE_HPP_
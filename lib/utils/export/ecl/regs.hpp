@@ -0,0 +1,195 @@
+//!
+//! \file
+//! \brief Type-safe access to memory-mapped registers.
+//! Register is described by a peripheral block type and a pointer to its
+//! member, bit fields by a position and a width within the register.
+//! Masks are computed by the compiler and every access is inlined into
+//! a single load, store or read-modify-write of the register, without
+//! out-of-line calls and runtime argument checks of vendor libraries.
+//! Descriptors of different registers can't be mixed: a field of SPI CR2
+//! can't be applied to DMA stream, nor combined with a field of SPI CR1.
+//! \code
+//! using cr2       = ECL_REG(SPI_TypeDef, CR2);
+//! using rxdmaen   = ecl::regs::field< cr2, 0 >;
+//! using txdmaen   = ecl::regs::field< cr2, 1 >;
+//!
+//! ecl::regs::set< rxdmaen, txdmaen >(SPI1);
+//! \endcode
+//!
+#ifndef ECL_REGS_HPP_
+#define ECL_REGS_HPP_
+
+#include <cstdint>
+#include <type_traits>
+
+//! Describes register \p member of peripheral block \p periph.
+#define ECL_REG(periph, member) \
+    ecl::regs::reg< periph, decltype(periph::member), &periph::member >
+
+//! Register accessors must be inlined even if optimization is disabled.
+#define ECL_REGS_INLINE __attribute__((always_inline)) inline
+
+namespace ecl
+{
+
+namespace regs
+{
+
+//!
+//! \brief Register, a member of peripheral register block.
+//! \tparam P Type of the block, i.e. SPI_TypeDef.
+//! \tparam T Type of the member, usually volatile integer.
+//! \tparam R Pointer to the member.
+//!
+template< class P, class T, T P::*R >
+struct reg
+{
+    using periph_type   = P;
+    using value_type    = typename std::remove_cv< T >::type;
+
+    static_assert(std::is_integral< value_type >::value, "Register must be integral");
+
+    //! Gets register of given block.
+    static ECL_REGS_INLINE volatile value_type &ref(P *p) { return p->*R; }
+};
+
+//!
+//! \brief Arbitrary set of bits of a register.
+//! Useful when a mask is composed elsewhere, i.e. by a vendor header.
+//! \tparam Reg  Register.
+//! \tparam Mask Bits of the register.
+//!
+template< class Reg, typename Reg::value_type Mask >
+struct bits
+{
+    using reg_type      = Reg;
+    using value_type    = typename Reg::value_type;
+
+    static constexpr value_type mask = Mask;
+};
+
+template< class Reg, typename Reg::value_type Mask >
+constexpr typename Reg::value_type bits< Reg, Mask >::mask;
+
+//!
+//! \brief Contiguous bit field of a register.
+//! \tparam Reg   Register.
+//! \tparam Pos   Position of the lowest bit.
+//! \tparam Width Amount of bits.
+//!
+template< class Reg, unsigned Pos, unsigned Width = 1 >
+struct field : bits< Reg, static_cast< typename Reg::value_type >(
+                              ((uint64_t{1} << Width) - 1) << Pos) >
+{
+    static_assert(Width > 0, "Field must contain bits");
+    static_assert(Pos + Width <= sizeof(typename Reg::value_type) * 8,
+                  "Field does not fit the register");
+
+    static constexpr unsigned pos = Pos;
+};
+
+template< class Reg, unsigned Pos, unsigned Width >
+constexpr unsigned field< Reg, Pos, Width >::pos;
+
+namespace detail
+{
+
+//! Combines masks of descriptors, that must belong to the same register.
+template< class F, class... Fs >
+struct combine
+{
+    using reg_type      = typename F::reg_type;
+    using periph_type   = typename reg_type::periph_type;
+    using value_type    = typename reg_type::value_type;
+
+    static constexpr value_type mask = F::mask;
+};
+
+template< class F, class G, class... Fs >
+struct combine< F, G, Fs... >
+{
+    static_assert(std::is_same< typename F::reg_type, typename G::reg_type >::value,
+                  "Fields of different registers can't be accessed at once");
+
+    using reg_type      = typename F::reg_type;
+    using periph_type   = typename reg_type::periph_type;
+    using value_type    = typename reg_type::value_type;
+
+    static constexpr value_type mask = F::mask | combine< G, Fs... >::mask;
+};
+
+} // namespace detail
+
+//! Peripheral block, that registers of given fields belong to.
+template< class F, class... Fs >
+using periph_t = typename detail::combine< F, Fs... >::periph_type;
+
+//!
+//! \brief Sets all bits of given fields, in a single read-modify-write.
+//!
+template< class F, class... Fs >
+ECL_REGS_INLINE void set(periph_t< F, Fs... > *p)
+{
+    using c = detail::combine< F, Fs... >;
+    auto &r = c::reg_type::ref(p);
+    r = static_cast< typename c::value_type >(r | c::mask);
+}
+
+//!
+//! \brief Clears all bits of given fields, in a single read-modify-write.
+//!
+template< class F, class... Fs >
+ECL_REGS_INLINE void clear(periph_t< F, Fs... > *p)
+{
+    using c = detail::combine< F, Fs... >;
+    auto &r = c::reg_type::ref(p);
+    r = static_cast< typename c::value_type >(r & ~c::mask);
+}
+
+//!
+//! \brief Checks if any bit of given fields is set, in a single read.
+//!
+template< class F, class... Fs >
+ECL_REGS_INLINE bool test(periph_t< F, Fs... > *p)
+{
+    using c = detail::combine< F, Fs... >;
+    return c::reg_type::ref(p) & c::mask;
+}
+
+//!
+//! \brief Writes bits of given fields, zeroes to the rest of register.
+//! Intended for registers where writing zero has no effect, i.e. for
+//! "write 1 to clear" flag registers or bit set-reset registers.
+//!
+template< class F, class... Fs >
+ECL_REGS_INLINE void store(periph_t< F, Fs... > *p)
+{
+    using c = detail::combine< F, Fs... >;
+    c::reg_type::ref(p) = c::mask;
+}
+
+//!
+//! \brief Reads value of a field, shifted to the lowest bits.
+//!
+template< class F >
+ECL_REGS_INLINE typename F::value_type read(periph_t< F > *p)
+{
+    return static_cast< typename F::value_type >((F::reg_type::ref(p) & F::mask) >> F::pos);
+}
+
+//!
+//! \brief Writes value of a field, leaving other bits of the register intact.
+//! Bits of the value, that don't fit the field, are dropped.
+//!
+template< class F >
+ECL_REGS_INLINE void write(periph_t< F > *p, typename F::value_type v)
+{
+    auto &r = F::reg_type::ref(p);
+    r = static_cast< typename F::value_type >((r & ~F::mask) | ((v << F::pos) & F::mask));
+}
+
+} // namespace regs
+
+} // namespace ecl
+
+#endif // ECL_REGS_HPP_
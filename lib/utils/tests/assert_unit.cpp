@@ -0,0 +1,97 @@
+// Asserts are recorded, not printed
+#define ECL_ASSERT_COMPACT
+#define ECL_ASSERT_LEVEL ECL_ASSERT_PARANOID
+
+#include <ecl/assert.h>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+struct assert_failed
+{
+};
+
+int hook_calls;
+
+template< class F >
+bool fails(F f)
+{
+    try {
+        f();
+    } catch (const assert_failed &) {
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace
+
+// Leaves the halting assert routine
+extern "C" void ecl_assert_hook(const volatile ecl_assert_record *rec)
+{
+    (void) rec;
+    ++hook_calls;
+    throw assert_failed{};
+}
+
+static_assert(ecl_file_id("/src/lib/utils/tests/assert_unit.cpp")
+              == ecl_file_id("assert_unit.cpp"), "Directories must not affect file id");
+static_assert(ecl_file_id("a.cpp") != ecl_file_id("b.cpp"), "");
+
+TEST_GROUP(assert)
+{
+    void setup()
+    {
+        hook_calls = 0;
+        ecl_assert_last.file_id = 0;
+        ecl_assert_last.line = 0;
+    }
+};
+
+TEST(assert, passed)
+{
+    ecl_assert(1 + 1 == 2);
+    ecl_assert_msg(true, "never shown");
+    ecl_assert_paranoid(true);
+
+    CHECK_EQUAL(0, hook_calls);
+}
+
+TEST(assert, failure_is_recorded)
+{
+    unsigned int line = 0;
+
+    CHECK_TRUE(fails([&] { line = __LINE__; ecl_assert(1 + 1 == 3); }));
+
+    CHECK_EQUAL(1, hook_calls);
+    CHECK_EQUAL(line, ecl_assert_last.line);
+    CHECK_EQUAL(ecl_file_id(__FILE__), ecl_assert_last.file_id);
+
+    CHECK_TRUE(fails([] { ecl_assert_msg(false, "message"); }));
+    CHECK_TRUE(fails([] { ecl_assert_paranoid(false); }));
+    CHECK_EQUAL(3, hook_calls);
+}
+
+TEST(assert, disabled_levels)
+{
+    int evaluated = 0;
+
+    // Subsystem levels override the global one
+    ecl_assert_level(ECL_ASSERT_OFF, ++evaluated == 0);
+    ecl_assert_level_paranoid(ECL_ASSERT_CHEAP, ++evaluated == 0);
+    CHECK_EQUAL(0, evaluated);
+    CHECK_EQUAL(0, hook_calls);
+
+    CHECK_TRUE(fails([&] { ecl_assert_level(ECL_ASSERT_CHEAP, ++evaluated == 0); }));
+    CHECK_TRUE(fails([&] { ecl_assert_level_paranoid(ECL_ASSERT_PARANOID, ++evaluated == 0); }));
+    CHECK_EQUAL(2, evaluated);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,72 @@
+#include <ecl/calendar.hpp>
+
+#include <cstdint>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+void check_same(const ecl::date_time &expected, const ecl::date_time &actual)
+{
+    CHECK_EQUAL(expected.year, actual.year);
+    CHECK_EQUAL(expected.month, actual.month);
+    CHECK_EQUAL(expected.day, actual.day);
+    CHECK_EQUAL(expected.hour, actual.hour);
+    CHECK_EQUAL(expected.min, actual.min);
+    CHECK_EQUAL(expected.sec, actual.sec);
+}
+
+// Conversions are usable at compile time, i.e. for build timestamps
+static_assert(ecl::to_unix({1970, 1, 1, 0, 0, 0}) == 0, "Epoch must be zero");
+
+} // namespace
+
+TEST_GROUP(calendar)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(calendar, known_dates)
+{
+    CHECK_EQUAL(0U, ecl::to_unix({1970, 1, 1, 0, 0, 0}));
+    CHECK_EQUAL(951782400U, ecl::to_unix({2000, 2, 29, 0, 0, 0}));
+    CHECK_EQUAL(1709251199U, ecl::to_unix({2024, 2, 29, 23, 59, 59}));
+    CHECK_EQUAL(4102444800U, ecl::to_unix({2100, 1, 1, 0, 0, 0}));
+
+    check_same({2000, 3, 1, 0, 0, 0}, ecl::from_unix(951868800));
+    check_same({2038, 1, 19, 3, 14, 8}, ecl::from_unix(2147483648U));
+    check_same({2106, 2, 7, 6, 28, 15}, ecl::from_unix(0xffffffff));
+}
+
+TEST(calendar, round_trip)
+{
+    // Every day until 2106, at different times of day
+    for (uint32_t secs = 0; secs < 0xffffffff - 86400; secs += 86400 + 3607) {
+        CHECK_EQUAL(secs, ecl::to_unix(ecl::from_unix(secs)));
+    }
+}
+
+TEST(calendar, fat_timestamp)
+{
+    // 1980-01-01 00:00:00 is the FAT epoch
+    CHECK_EQUAL(0x00210000U, ecl::to_fat({1980, 1, 1, 0, 0, 0}));
+
+    // Seconds are stored halved
+    uint32_t stamp = ecl::to_fat({2024, 7, 15, 13, 45, 31});
+
+    CHECK_EQUAL((2024 - 1980) << 9 | 7 << 5 | 15, stamp >> 16);
+    CHECK_EQUAL(13 << 11 | 45 << 5 | 15, stamp & 0xffff);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
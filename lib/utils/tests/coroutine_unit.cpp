@@ -0,0 +1,171 @@
+#include <ecl/coroutine.hpp>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Device with multi-step initialization, like SD card
+struct fake_device
+{
+    ecl::err init()
+    {
+        ECL_CO_BEGIN(co);
+
+        ++steps;
+        ECL_CO_YIELD(co);
+
+        ++steps;
+        ECL_CO_AWAIT(co, ready);
+
+        ++steps;
+        ECL_CO_AWAIT_CALL(co, configure());
+
+        if (fail) {
+            ECL_CO_RETURN(co, ecl::err::io);
+        }
+
+        ++steps;
+        ECL_CO_END(co);
+    }
+
+    ecl::err configure()
+    {
+        ECL_CO_BEGIN(config_co);
+
+        ECL_CO_AWAIT(config_co, config_polls++ == 2);
+
+        if (config_fail) {
+            ECL_CO_RETURN(config_co, ecl::err::inval);
+        }
+
+        ECL_CO_END(config_co);
+    }
+
+    ecl::coroutine co;
+    ecl::coroutine config_co;
+    int steps = 0;
+    int config_polls = 0;
+    bool ready = false;
+    bool fail = false;
+    bool config_fail = false;
+};
+
+}
+
+TEST_GROUP(coroutine)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(coroutine, resumes_after_suspension_points)
+{
+    fake_device dev;
+
+    CHECK_EQUAL(ecl::err::again, dev.init());
+    CHECK_EQUAL(1, dev.steps);
+
+    // Condition isn't met, coroutine stays suspended
+    CHECK_EQUAL(ecl::err::again, dev.init());
+    CHECK_EQUAL(ecl::err::again, dev.init());
+    CHECK_EQUAL(2, dev.steps);
+    CHECK_FALSE(dev.co.done());
+
+    dev.ready = true;
+
+    // Nested coroutine takes a few polls
+    CHECK_EQUAL(ecl::err::again, dev.init());
+    CHECK_EQUAL(ecl::err::again, dev.init());
+    CHECK_EQUAL(ecl::err::ok, dev.init());
+    CHECK_EQUAL(4, dev.steps);
+    CHECK_TRUE(dev.co.done());
+    CHECK_TRUE(dev.config_co.done());
+
+    // Completed coroutine doesn't run again
+    CHECK_EQUAL(ecl::err::ok, dev.init());
+    CHECK_EQUAL(4, dev.steps);
+}
+
+TEST(coroutine, reset_restarts)
+{
+    fake_device dev;
+    dev.ready = true;
+
+    while (dev.init() == ecl::err::again) { }
+    CHECK_EQUAL(4, dev.steps);
+
+    dev.co.reset();
+    dev.config_co.reset();
+    dev.config_polls = 0;
+
+    while (dev.init() == ecl::err::again) { }
+    CHECK_EQUAL(8, dev.steps);
+}
+
+TEST(coroutine, errors_finish_coroutine)
+{
+    fake_device dev;
+    dev.ready = true;
+    dev.fail = true;
+
+    while (dev.init() == ecl::err::again) { }
+    CHECK_TRUE(dev.co.done());
+    CHECK_EQUAL(3, dev.steps);
+
+    // Nested error is propagated
+    fake_device other;
+    other.ready = true;
+    other.config_fail = true;
+
+    ecl::err rc;
+    while ((rc = other.init()) == ecl::err::again) { }
+    CHECK_EQUAL(ecl::err::inval, rc);
+    CHECK_TRUE(other.co.done());
+}
+
+TEST(coroutine, run_many_devices)
+{
+    fake_device first;
+    fake_device second;
+    int polls = 0;
+
+    // Devices become ready at different moments, neither blocks the other
+    auto rc = ecl::co_run(
+        [&]() { first.ready = ++polls > 2; return first.init(); },
+        [&]() { second.ready = polls > 5; return second.init(); }
+    );
+
+    CHECK_EQUAL(ecl::err::ok, rc);
+    CHECK_EQUAL(4, first.steps);
+    CHECK_EQUAL(4, second.steps);
+    CHECK_TRUE(first.co.done());
+    CHECK_TRUE(second.co.done());
+}
+
+TEST(coroutine, run_stops_on_error)
+{
+    fake_device good;
+    fake_device bad;
+    good.ready = true;
+    bad.ready = true;
+    bad.fail = true;
+
+    auto rc = ecl::co_run(
+        [&]() { return good.init(); },
+        [&]() { return bad.init(); }
+    );
+
+    CHECK_EQUAL(ecl::err::io, rc);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
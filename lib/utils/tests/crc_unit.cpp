@@ -0,0 +1,100 @@
+#include <ecl/crc.hpp>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+#include <cstring>
+
+TEST_GROUP(crc)
+{
+};
+
+TEST(crc, crc16_check_value)
+{
+    const uint8_t data[] = "123456789";
+
+    CHECK_EQUAL(0x31c3, ecl::crc16(data, 9));
+}
+
+TEST(crc, crc16_sd_block)
+{
+    // CRC of the erased block, as reported by SD cards
+    uint8_t block[512];
+    memset(block, 0xff, sizeof(block));
+
+    CHECK_EQUAL(0x7fa1, ecl::crc16(block, sizeof(block)));
+}
+
+TEST(crc, crc16_piecewise)
+{
+    const uint8_t data[] = "123456789";
+
+    auto crc = ecl::crc16(data, 4);
+    crc = ecl::crc16(data + 4, 5, crc);
+
+    CHECK_EQUAL(0x31c3, crc);
+}
+
+TEST(crc, crc16_empty)
+{
+    CHECK_EQUAL(0, ecl::crc16(nullptr, 0));
+    CHECK_EQUAL(0x1234, ecl::crc16(nullptr, 0, 0x1234));
+}
+
+TEST(crc, crc7_sd_commands)
+{
+    // Well-known CRCs of CMD0 and CMD8 with 0x1aa argument
+    const uint8_t cmd0[] = { 0x40, 0x00, 0x00, 0x00, 0x00 };
+    const uint8_t cmd8[] = { 0x48, 0x00, 0x00, 0x01, 0xaa };
+
+    CHECK_EQUAL(0x95 >> 1, ecl::crc7(cmd0, sizeof(cmd0)));
+    CHECK_EQUAL(0x87 >> 1, ecl::crc7(cmd8, sizeof(cmd8)));
+}
+
+// Bitwise reference, as described in STM32 reference manual
+static uint32_t crc32_ref(const uint32_t *data, size_t n, uint32_t crc = 0xffffffff)
+{
+    for (size_t i = 0; i < n; ++i) {
+        crc ^= data[i];
+
+        for (int bit = 0; bit < 32; ++bit) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+TEST(crc, crc32_matches_crc_unit)
+{
+    // Value given by CRC unit after reset for a single word
+    const uint32_t word = 0x12345678;
+    CHECK_EQUAL(0xdf8a8a2b, ecl::crc32(&word, 1));
+
+    // Big-endian packed "12345678" is CRC-32/MPEG-2 of these bytes
+    const uint32_t digits[] = { 0x31323334, 0x35363738 };
+    CHECK_EQUAL(crc32_ref(digits, 2), ecl::crc32(digits, 2));
+}
+
+TEST(crc, crc32_matches_reference_piecewise)
+{
+    uint32_t data[37];
+
+    for (size_t i = 0; i < 37; ++i) {
+        data[i] = i * 0x9e3779b9;
+    }
+
+    // Odd and even lengths, and the slicing tail
+    for (size_t n = 0; n <= 37; ++n) {
+        CHECK_EQUAL(crc32_ref(data, n), ecl::crc32(data, n));
+    }
+
+    auto crc = ecl::crc32(data, 5);
+    crc = ecl::crc32(data + 5, 32, crc);
+    CHECK_EQUAL(crc32_ref(data, 37), crc);
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,181 @@
+#include <ecl/inplace_function.hpp>
+
+#include <memory>
+#include <type_traits>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Tracks constructions and destructions of non-trivial callable
+struct tracked
+{
+    tracked(int v) :value{v} { ++alive; }
+    tracked(const tracked &other) :value{other.value} { ++alive; ++copies; }
+    tracked(tracked &&other) :value{other.value} { ++alive; ++moves; }
+    ~tracked() { --alive; }
+
+    int operator()(int x) const { return value + x; }
+
+    int value;
+
+    static int alive;
+    static int copies;
+    static int moves;
+};
+
+int tracked::alive;
+int tracked::copies;
+int tracked::moves;
+
+int twice(int x)
+{
+    return x * 2;
+}
+
+using int_fn = ecl::inplace_function< int(int) >;
+
+} // namespace
+
+TEST_GROUP(inplace_function)
+{
+    void setup()
+    {
+        tracked::alive  = 0;
+        tracked::copies = 0;
+        tracked::moves  = 0;
+    }
+
+    void teardown()
+    {
+        CHECK_EQUAL(0, tracked::alive);
+    }
+};
+
+TEST(inplace_function, empty)
+{
+    int_fn fn;
+    int_fn null_fn = nullptr;
+    int (*null_ptr)(int) = nullptr;
+    int_fn from_null_ptr = null_ptr;
+
+    CHECK_FALSE(fn);
+    CHECK_TRUE(fn == nullptr);
+    CHECK_TRUE(null_fn == nullptr);
+    CHECK_TRUE(from_null_ptr == nullptr);
+}
+
+TEST(inplace_function, function_pointer)
+{
+    int_fn fn = twice;
+
+    CHECK_TRUE(fn);
+    CHECK_TRUE(fn != nullptr);
+    CHECK_EQUAL(8, fn(4));
+}
+
+TEST(inplace_function, capturing_lambda)
+{
+    int acc = 0;
+    void *self = this;
+    ecl::inplace_function< void(int) > fn = [&acc, self](int v) { acc += v; (void)self; };
+
+    fn(3);
+    fn(4);
+    CHECK_EQUAL(7, acc);
+}
+
+TEST(inplace_function, trivial_copy_and_move)
+{
+    int base = 10;
+    int_fn fn = [&base](int x) { return base + x; };
+
+    int_fn copy = fn;
+    CHECK_EQUAL(11, copy(1));
+    CHECK_EQUAL(12, fn(2));
+
+    int_fn moved = std::move(copy);
+    CHECK_FALSE(copy);
+    CHECK_EQUAL(13, moved(3));
+
+    fn = nullptr;
+    CHECK_FALSE(fn);
+    CHECK_EQUAL(14, moved(4));
+}
+
+TEST(inplace_function, non_trivial_callable)
+{
+    {
+        int_fn fn = tracked{5};
+        CHECK_EQUAL(1, tracked::alive);
+        CHECK_EQUAL(6, fn(1));
+
+        int_fn copy = fn;
+        CHECK_EQUAL(2, tracked::alive);
+        CHECK_EQUAL(1, tracked::copies);
+        CHECK_EQUAL(7, copy(2));
+
+        int_fn moved = std::move(fn);
+        // Source is destroyed after move
+        CHECK_EQUAL(2, tracked::alive);
+        CHECK_FALSE(fn);
+        CHECK_EQUAL(8, moved(3));
+
+        copy = twice;
+        CHECK_EQUAL(1, tracked::alive);
+        CHECK_EQUAL(4, copy(2));
+
+        copy = moved;
+        CHECK_EQUAL(2, tracked::alive);
+        CHECK_EQUAL(9, copy(4));
+    }
+
+    CHECK_EQUAL(0, tracked::alive);
+}
+
+TEST(inplace_function, mutable_callable)
+{
+    int_fn counter = [n = 0](int x) mutable { return n += x; };
+
+    CHECK_EQUAL(1, counter(1));
+    CHECK_EQUAL(3, counter(2));
+
+    // Copy has its own state
+    int_fn copy = counter;
+    CHECK_EQUAL(13, copy(10));
+    CHECK_EQUAL(4, counter(1));
+}
+
+TEST(inplace_function, move_only_arguments)
+{
+    ecl::inplace_function< int(std::unique_ptr< int >) > fn =
+            [](std::unique_ptr< int > p) { return *p; };
+
+    CHECK_EQUAL(5, fn(std::unique_ptr< int >{new int{5}}));
+}
+
+TEST(inplace_function, only_callables_are_accepted)
+{
+    static_assert(std::is_constructible< int_fn, int(*)(int) >::value, "Function must fit");
+    static_assert(!std::is_constructible< int_fn, bool >::value, "Bool is not callable");
+    static_assert(!std::is_constructible< int_fn, void(*)(int) >::value,
+                  "Result must convert to int");
+    static_assert(std::is_constructible< ecl::inplace_function< void(int) >, int(*)(int) >::value,
+                  "Result is discarded for void wrapper");
+}
+
+TEST(inplace_function, custom_capacity)
+{
+    char big[24] = { 1, 2, 3 };
+    ecl::inplace_function< int(), sizeof(big) > fn = [big] { return big[0] + big[2]; };
+
+    static_assert(sizeof(fn) >= sizeof(big), "Storage must be in place");
+    CHECK_EQUAL(4, fn());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
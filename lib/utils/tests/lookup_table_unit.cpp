@@ -0,0 +1,84 @@
+#include <ecl/lookup_table.hpp>
+
+#include <cstdint>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+enum class dev
+{
+    first,
+    second,
+    third,
+    unknown,
+};
+
+int first_fn() { return 1; }
+int second_fn() { return 2; }
+
+// Picker, as drivers use it
+template< dev d >
+constexpr uint32_t pick_base()
+{
+    constexpr auto bases = ecl::make_lookup_table< dev, uint32_t >({
+        { dev::first,   0x40010000 },
+        { dev::second,  0x40020000 },
+        { dev::third,   0x40030000 },
+    });
+
+    static_assert(bases.unique(), "Device is listed twice");
+    static_assert(bases.contains(d), "Device is not supported");
+    return bases[d];
+}
+
+constexpr auto fns = ecl::make_lookup_table< dev, int (*)() >({
+    { dev::first,   first_fn },
+    { dev::second,  second_fn },
+});
+
+static_assert(pick_base< dev::second >() == 0x40020000, "Lookup must be done at compile time");
+static_assert(fns.size() == 2, "Size must be deduced from entries");
+static_assert(!fns.contains(dev::third), "Absent key must not be found");
+static_assert(fns.value_or(dev::third, nullptr) == nullptr, "Fallback must be used");
+
+constexpr auto dup = ecl::make_lookup_table< int, int >({ { 1, 1 }, { 2, 2 }, { 1, 3 } });
+static_assert(!dup.unique(), "Duplicate must be detected");
+
+} // namespace
+
+TEST_GROUP(lookup_table)
+{
+    void setup()
+    {
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(lookup_table, lookup_at_runtime)
+{
+    // Keys not known at compile time are looked up as well
+    volatile int key = 1;
+    auto d = static_cast< dev >(key);
+
+    CHECK_TRUE(fns.contains(d));
+    CHECK_EQUAL(1U, fns.index_of(d));
+    CHECK_EQUAL(2, fns[d]());
+    CHECK_EQUAL(2U, fns.index_of(dev::unknown));
+}
+
+TEST(lookup_table, picker)
+{
+    CHECK_EQUAL(0x40010000U, pick_base< dev::first >());
+    CHECK_EQUAL(0x40030000U, pick_base< dev::third >());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
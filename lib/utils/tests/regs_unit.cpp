@@ -0,0 +1,99 @@
+#include <ecl/regs.hpp>
+
+#include <cstdint>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+namespace
+{
+
+// Register block, laid out as vendor headers do
+struct periph_regs
+{
+    volatile uint16_t   CR;
+    uint16_t            RESERVED0;
+    volatile uint32_t   SR;
+};
+
+using cr        = ECL_REG(periph_regs, CR);
+using sr        = ECL_REG(periph_regs, SR);
+
+using cr_en     = ecl::regs::field< cr, 0 >;
+using cr_ie     = ecl::regs::field< cr, 1 >;
+using cr_div    = ecl::regs::field< cr, 4, 3 >;
+using cr_top    = ecl::regs::field< cr, 15 >;
+using sr_flags  = ecl::regs::bits< sr, 0x80000011 >;
+
+static_assert(cr_div::mask == 0x70, "Mask must be computed by the compiler");
+static_assert(cr_top::mask == 0x8000, "Highest bit must fit the register");
+static_assert(std::is_same< cr_en::value_type, uint16_t >::value,
+              "Field must be as wide as its register");
+
+} // namespace
+
+TEST_GROUP(regs)
+{
+    periph_regs p;
+
+    void setup()
+    {
+        p.CR = 0;
+        p.RESERVED0 = 0;
+        p.SR = 0;
+    }
+
+    void teardown()
+    {
+    }
+};
+
+TEST(regs, set_and_clear)
+{
+    p.CR = 0x0100;
+
+    ecl::regs::set< cr_en, cr_ie >(&p);
+    CHECK_EQUAL(0x0103, p.CR);
+    CHECK_TRUE(ecl::regs::test< cr_ie >(&p));
+
+    ecl::regs::clear< cr_en >(&p);
+    CHECK_EQUAL(0x0102, p.CR);
+    CHECK_FALSE(ecl::regs::test< cr_en >(&p));
+    CHECK_TRUE((ecl::regs::test< cr_en, cr_ie >(&p)));
+
+    // Other registers are not touched
+    CHECK_EQUAL(0U, p.SR);
+    CHECK_EQUAL(0U, p.RESERVED0);
+}
+
+TEST(regs, read_and_write)
+{
+    p.CR = 0xff8f;
+
+    ecl::regs::write< cr_div >(&p, 5);
+    CHECK_EQUAL(0xffdf, p.CR);
+    CHECK_EQUAL(5, ecl::regs::read< cr_div >(&p));
+
+    // Excess bits of the value are dropped
+    ecl::regs::write< cr_div >(&p, 0xa);
+    CHECK_EQUAL(0xffaf, p.CR);
+    CHECK_EQUAL(2, ecl::regs::read< cr_div >(&p));
+
+    ecl::regs::write< cr_top >(&p, 0);
+    CHECK_EQUAL(0x7faf, p.CR);
+}
+
+TEST(regs, store)
+{
+    p.SR = 0xffff;
+
+    // Register is overwritten, as for "write 1 to clear" flags
+    ecl::regs::store< sr_flags >(&p);
+    CHECK_EQUAL(0x80000011U, p.SR);
+    CHECK_TRUE(ecl::regs::test< sr_flags >(&p));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
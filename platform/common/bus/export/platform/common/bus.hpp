@@ -8,8 +8,10 @@
 #define PLATFORM_COMMON_BUS_
 
 #include <ecl/err.hpp>
+#include <ecl/inplace_function.hpp>
 
-#include <functional>
+#include <cstdint>
+#include <cstddef>
 
 
 namespace ecl
@@ -42,9 +44,28 @@ enum class bus_event
 //! \param[in] type  Type of the event.
 //! \param[in] total Bytes transferred trough given channel
 //!                  during current xfer.
+//! Handler is stored in place, so setting it never allocates and
+//! invoking it from ISR costs a single indirect call.
 //! \sa generic_bus::xfer()
 //!
-using bus_handler = std::function< void(bus_channel ch, bus_event type, size_t total) >;
+using bus_handler = inplace_function< void(bus_channel ch, bus_event type, size_t total) >;
+
+//!
+//! \brief Single segment of a scatter-gather xfer chain.
+//! Segments are executed one after another, as they were placed in the chain.
+//! Rules for buffers are the same as for generic_bus::set_buffers():
+//! \li If both tx and rx are set, full-duplex xfer of given size is executed.
+//! \li If only one of them is set, then only given direction is used.
+//! \li If neither tx nor rx is set, then fill_byte is sent size times.
+//! \sa generic_bus::set_buffers(const bus_segment *segs, size_t n)
+//!
+struct bus_segment
+{
+    const uint8_t   *tx;        //!< Data to transmit. Optional.
+    uint8_t         *rx;        //!< Buffer to receive a data. Optional.
+    size_t          size;       //!< Size of buffers.
+    uint8_t         fill_byte;  //!< Byte to send if no buffers are given.
+};
 
 //!
 //! \brief The dummy bus class.
@@ -113,6 +134,65 @@ public:
     //!
     ecl::err do_xfer()
     { return ecl::err::nosys; }
+
+    //!
+    //! \brief Sets double buffers for streaming xfer.
+    //! Optional. Required only if generic_bus::stream() is used.
+    //! \param[in]      tx0     First buffer to transmit. Optional.
+    //! \param[in]      tx1     Second buffer to transmit. Optional.
+    //! \param[in,out]  rx0     First buffer to write data to. Optional.
+    //! \param[in,out]  rx1     Second buffer to write data to. Optional.
+    //! \param[in]      size    Size of each buffer.
+    //!
+    void set_double_buffers(const uint8_t *tx0, const uint8_t *tx1,
+                            uint8_t *rx0, uint8_t *rx1, size_t size)
+    { (void) tx0; (void) tx1; (void) rx0; (void) rx1; (void) size; }
+
+    //!
+    //! \brief Starts streaming xfer, using double buffers previously set.
+    //! Optional. Completion of each buffer is reported with ht (first buffer)
+    //! and tc (second buffer) events.
+    //! \return Status of operation.
+    //!
+    ecl::err do_stream()
+    { return ecl::err::nosys; }
+
+    //!
+    //! \brief Stops streaming xfer.
+    //! Optional. Meta-channel TC event is reported when streaming is stopped.
+    //! \return Status of operation.
+    //!
+    ecl::err stop_stream()
+    { return ecl::err::nosys; }
+
+    //!
+    //! \brief Sets bus clock.
+    //! Optional. Required only if generic_bus::lock(uint32_t clk) is used.
+    //! \param[in] clk Desired clock, in Hz.
+    //! \return Status of operation.
+    //!
+    ecl::err set_clock(uint32_t clk)
+    { (void) clk; return ecl::err::nosys; }
+
+    //!
+    //! \brief Sets clock polarity and phase.
+    //! Optional. Required only if bus_device is used.
+    //! \param[in] cpol Clock polarity, in platform-specific format.
+    //! \param[in] cpha Clock phase, in platform-specific format.
+    //! \return Status of operation.
+    //!
+    ecl::err set_mode(uint16_t cpol, uint16_t cpha)
+    { (void) cpol; (void) cpha; return ecl::err::nosys; }
+
+    //!
+    //! \brief Recovers bus after error.
+    //! Optional. Called by the generic bus before next xfer, that follows
+    //! an error event. Peripheral and its DMA streams must be brought back
+    //! to idle state, keeping the configuration and buffers.
+    //! \return Status of operation.
+    //!
+    ecl::err recover()
+    { return ecl::err::nosys; }
 };
 
 } // namespace ecl
@@ -0,0 +1,67 @@
+#ifndef COMMON_CAN_HPP_
+#define COMMON_CAN_HPP_
+
+//!
+//! \file
+//! \brief Types shared by CAN drivers.
+//!
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief CAN frame.
+//! Trivially copyable, so frames are passed through lock-free queues.
+//!
+struct can_frame
+{
+    uint32_t    id;         //!< Identifier, 11 or 29 bits.
+    bool        ext;        //!< Identifier is extended, 29-bit one.
+    bool        rtr;        //!< Remote transmission request, no data.
+    uint8_t     dlc;        //!< Data length, 0 to 8.
+    uint8_t     data[8];    //!< Data.
+};
+
+//!
+//! \brief Acceptance filter.
+//! Frame is accepted if bits of its identifier, selected by the mask, are
+//! equal to the ones of the filter identifier, and identifier type matches.
+//! Zero mask accepts every frame, of both types.
+//!
+struct can_filter
+{
+    uint32_t    id;         //!< Identifier to match.
+    uint32_t    mask;       //!< Bits of identifier to compare.
+    bool        ext;        //!< Frames with extended identifiers are matched.
+    uint8_t     fifo;       //!< Receive FIFO of accepted frames, 0 or 1.
+};
+
+//!
+//! \brief Operating modes of a CAN controller.
+//!
+enum class can_mode
+{
+    normal,     //!< Takes part in bus traffic.
+    loopback,   //!< Frames sent are received back, TX pin stays recessive.
+    silent,     //!< Only listens, never acknowledges or sends.
+};
+
+//!
+//! \brief Counters of a CAN controller.
+//!
+struct can_stats
+{
+    size_t  rx;             //!< Frames received.
+    size_t  tx;             //!< Frames transmitted.
+    size_t  rx_dropped;     //!< Frames lost, because RX queue was full.
+    size_t  rx_overruns;    //!< Frames lost by hardware FIFO overrun.
+    size_t  tx_failed;      //!< Frames aborted, i.e. by bus-off.
+    size_t  bus_off;        //!< Bus-off events so far.
+};
+
+} // namespace ecl
+
+#endif // COMMON_CAN_HPP_
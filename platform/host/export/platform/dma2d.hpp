@@ -0,0 +1,29 @@
+#ifndef PLATFORM_HOST_DMA2D_HPP_
+#define PLATFORM_HOST_DMA2D_HPP_
+
+//!
+//! \file
+//! \brief Pixel engine on host, with the same interface as target DMA2D.
+//!
+
+#include <ecl/pixel_engine.hpp>
+
+namespace ecl
+{
+
+//!
+//! \brief Host pixel engine, implemented by CPU.
+//!
+class dma2d : public soft_pixel_engine
+{
+public:
+    //! Does nothing.
+    static void init() { }
+
+    //! Does nothing.
+    static void deinit() { }
+};
+
+} // namespace ecl
+
+#endif // PLATFORM_HOST_DMA2D_HPP_
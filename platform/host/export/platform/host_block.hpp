@@ -0,0 +1,160 @@
+#ifndef PLATFORM_HOST_BLOCK_HPP_
+#define PLATFORM_HOST_BLOCK_HPP_
+
+//!
+//! \file
+//! \brief Block device over an image file, i.e. of an SD card.
+//! Implements block device interface, see fs/block.hpp, so images are
+//! mounted by the same filesystems as on target, bypassing bus and card
+//! emulation. Filesystems construct devices themselves, thus the image is
+//! selected for all devices at once, with set_image(). Each device opens
+//! the file on its own, so filesystems over the same image can be used
+//! from different threads, as long as none of them writes.
+//!
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ecl
+{
+
+//!
+//! \brief Image-backed block device of 512-byte blocks.
+//!
+class host_block
+{
+public:
+    //! Size of a block.
+    static constexpr size_t block_size = 512;
+
+    host_block() = default;
+    ~host_block() { release(); }
+
+    host_block(const host_block &) = delete;
+    host_block &operator=(const host_block &) = delete;
+
+    //!
+    //! \brief Selects image, opened by devices afterwards.
+    //! \param[in] path     Path to the image. Size must be a multiple
+    //!                     of the block size.
+    //! \param[in] writable If false, writes are rejected.
+    //!
+    static void set_image(const char *path, bool writable)
+    {
+        image_path() = path;
+        image_writable() = writable;
+    }
+
+    //! Always succeeds.
+    int init() { return 0; }
+
+    //! Opens the image. -1 if error, 0 otherwise.
+    int open()
+    {
+        if (m_opened++) {
+            return 0;
+        }
+
+        int fd = ::open(image_path().c_str(), image_writable() ? O_RDWR : O_RDONLY);
+        struct stat st;
+
+        if (fd < 0 || fstat(fd, &st) || st.st_size % block_size) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+
+            m_opened = 0;
+            return -1;
+        }
+
+        m_fd = fd;
+        m_blocks = st.st_size / block_size;
+        return 0;
+    }
+
+    //! Closes the image, once all opens are paired. -1 if not opened.
+    int close()
+    {
+        if (!m_opened) {
+            return -1;
+        }
+
+        if (!--m_opened) {
+            release();
+        }
+
+        return 0;
+    }
+
+    constexpr size_t get_block_length() { return block_size; }
+    //! Gets amount of blocks, 0 if device is not opened.
+    size_t block_count() const { return m_blocks; }
+    //! Larger requests amortize the system call.
+    constexpr size_t preferred_io_size() { return 64 * 1024; }
+
+    //! -1 if error, 0 otherwise.
+    int read_blocks(size_t lba, uint8_t *buf, size_t n)
+    {
+        return xfer(lba, n) && pread(m_fd, buf, n * block_size, offset(lba)) == length(n)
+                ? 0 : -1;
+    }
+
+    //! -1 if error or image is read-only, 0 otherwise.
+    int write_blocks(size_t lba, const uint8_t *buf, size_t n)
+    {
+        return image_writable() && xfer(lba, n)
+                && pwrite(m_fd, buf, n * block_size, offset(lba)) == length(n)
+                ? 0 : -1;
+    }
+
+    //! Content of trimmed blocks is kept. -1 if range is invalid, 0 otherwise.
+    int trim(size_t lba, size_t n)
+    {
+        return xfer(lba, n) ? 0 : -1;
+    }
+
+private:
+    static std::string &image_path()
+    {
+        static std::string p;
+        return p;
+    }
+
+    static bool &image_writable()
+    {
+        static bool w = false;
+        return w;
+    }
+
+    // Checks that the range lies within the image
+    bool xfer(size_t lba, size_t n) const
+    {
+        return m_fd >= 0 && lba <= m_blocks && n <= m_blocks - lba;
+    }
+
+    static off_t offset(size_t lba) { return static_cast< off_t >(lba) * block_size; }
+    static ssize_t length(size_t n) { return static_cast< ssize_t >(n * block_size); }
+
+    void release()
+    {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+
+        m_blocks = 0;
+    }
+
+    int     m_fd        = -1;   //!< Image file.
+    int     m_opened    = 0;    //!< Opened times counter.
+    size_t  m_blocks    = 0;    //!< Amount of blocks in the image.
+};
+
+} // namespace ecl
+
+#endif // PLATFORM_HOST_BLOCK_HPP_
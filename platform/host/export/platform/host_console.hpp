@@ -1,30 +1,120 @@
 #ifndef HOST_CONSOLE_HPP_
 #define HOST_CONSOLE_HPP_
 
-#include <iostream>
+// Console of host builds, over standard input and output of the process.
+// Data is passed to the OS in bulk, one system call per write or read,
+// so heavily logging simulations are not slowed down by the console.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
 
 class host_console
 {
 public:
+    // Descriptors can be given to run console over pipes, i.e. in tests
+    explicit host_console(int in_fd = STDIN_FILENO, int out_fd = STDOUT_FILENO)
+        :m_in{in_fd}, m_out{out_fd}
+    { }
+
+    ~host_console() { set_raw(false); }
+
+    host_console(const host_console &) = delete;
+    host_console &operator=(const host_console &) = delete;
+
     int init() { return 0; }
     int open() { return 0; }
-    int close() { return 0; }
+    int close() { return set_raw(false); }
 
     // -1 if error, [0, count] otherwise
     ssize_t write(const uint8_t *data, size_t count)
     {
-        size_t to_write = count;
-        while (to_write--) { std::putchar(*data++); }
-        return count;
+        // Output of printf() and friends, buffered so far, goes first
+        if (m_out == STDOUT_FILENO) {
+            std::fflush(stdout);
+        }
+
+        size_t done = 0;
+        while (done < count) {
+            ssize_t rc = ::write(m_out, data + done, count - done);
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return done ? done : -1;
+            }
+            done += rc;
+        }
+        return done;
     }
 
-    // -1 if error, [0, count] otherwise
+    // -1 if error or end of input, [1, count] otherwise
+    // Returns as soon as some data is available: terminal in canonical mode
+    // gives whole lines, in raw mode - every key pressed.
     ssize_t read(uint8_t *data, size_t count)
     {
-        size_t to_write = count;
-        while(to_write--) { *data++ = std::getchar(); }
-        return count;
+        ssize_t rc;
+        do {
+            rc = ::read(m_in, data, count);
+        } while (rc < 0 && errno == EINTR);
+
+        return rc > 0 ? rc : -1;
     }
+
+    // -1 if error or end of input, [0, count] otherwise
+    // Never blocks, zero means that no data is available right now.
+    ssize_t try_read(uint8_t *data, size_t count)
+    {
+        pollfd pfd{m_in, POLLIN, 0};
+
+        int rc = ::poll(&pfd, 1, 0);
+        if (rc < 0) {
+            return errno == EINTR ? 0 : -1;
+        }
+
+        return rc ? read(data, count) : 0;
+    }
+
+    // Switches terminal to raw mode and back: input is not line-buffered
+    // and not echoed, so keys are read as soon as they are pressed.
+    // Original mode is restored by close() and on destruction.
+    // -1 if input is not a terminal, 0 otherwise
+    int set_raw(bool raw)
+    {
+        if (raw == m_raw) {
+            return 0;
+        }
+
+        if (raw) {
+            if (tcgetattr(m_in, &m_saved) < 0) {
+                return -1;
+            }
+
+            termios t = m_saved;
+            t.c_lflag &= ~(ICANON | ECHO);
+            t.c_cc[VMIN] = 1;
+            t.c_cc[VTIME] = 0;
+
+            if (tcsetattr(m_in, TCSANOW, &t) < 0) {
+                return -1;
+            }
+        } else if (tcsetattr(m_in, TCSANOW, &m_saved) < 0) {
+            return -1;
+        }
+
+        m_raw = raw;
+        return 0;
+    }
+
+private:
+    int     m_in;           // Input descriptor
+    int     m_out;          // Output descriptor
+    bool    m_raw = false;  // Terminal is in raw mode
+    termios m_saved{};      // Mode of terminal before raw mode
 };
 
 #endif // HOST_CONSOLE_HPP_
@@ -0,0 +1,81 @@
+#ifndef PLATFORM_HOST_LATENCY_HPP_
+#define PLATFORM_HOST_LATENCY_HPP_
+
+//!
+//! \file
+//! \brief Latency model of emulated host buses.
+//! Xfer over emulated bus takes setup time plus time required to clock
+//! every byte out. This time is either only accounted, so profiles show
+//! the cost of the software alone, or spent for real, so timings of the
+//! whole stack resemble the target.
+//!
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace ecl
+{
+
+//!
+//! \brief How modeled time is spent.
+//!
+enum class host_delay
+{
+    none,   //!< Time is accounted only, xfer is instant.
+    sleep,  //!< Calling thread sleeps. Keeps CPU profiles clean.
+    spin,   //!< Calling thread busy-waits. Precise, like polling driver.
+};
+
+//!
+//! \brief Latency model of a bus.
+//!
+struct host_latency
+{
+    uint32_t    setup_ns        = 0;    //!< Fixed cost of each xfer, i.e. DMA and IRQ.
+    uint32_t    clock           = 0;    //!< Bus clock in Hz. Zero means no per-byte cost.
+    uint8_t     bits_per_byte   = 8;    //!< Bit times per byte, i.e. 10 for 8N1 USART.
+    host_delay  delay           = host_delay::none; //!< Way to spend time.
+
+    //!
+    //! \brief Gets modeled duration of xfer.
+    //! \param[in] bytes Bytes clocked over the bus.
+    //! \return Duration in nanoseconds.
+    //!
+    uint64_t cost(size_t bytes) const
+    {
+        uint64_t wire = clock ? bytes * bits_per_byte * 1000000000ULL / clock : 0;
+        return setup_ns + wire;
+    }
+
+    //!
+    //! \brief Spends given time as configured.
+    //! \param[in] ns Time in nanoseconds.
+    //!
+    void spend(uint64_t ns) const
+    {
+        using namespace std::chrono;
+
+        if (!ns) {
+            return;
+        }
+
+        switch (delay) {
+        case host_delay::none:
+            break;
+        case host_delay::sleep:
+            std::this_thread::sleep_for(nanoseconds{ns});
+            break;
+        case host_delay::spin: {
+            auto until = steady_clock::now() + nanoseconds{ns};
+            while (steady_clock::now() < until) { }
+            break;
+        }
+        }
+    }
+};
+
+} // namespace ecl
+
+#endif // PLATFORM_HOST_LATENCY_HPP_
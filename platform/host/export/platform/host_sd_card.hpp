@@ -0,0 +1,558 @@
+#ifndef PLATFORM_HOST_SD_CARD_HPP_
+#define PLATFORM_HOST_SD_CARD_HPP_
+
+//!
+//! \file
+//! \brief Emulated SD card in SPI mode, backed by an image file.
+//! Card is SDHC, so it is block addressed and block length is fixed
+//! to 512 bytes. Access, program and erase times are reported on the bus
+//! the same way real card does: as 0xff bytes before data token and
+//! as 0x00 busy bytes after a write or erase.
+//!
+
+#include <ecl/err.hpp>
+#include <ecl/crc.hpp>
+#include <platform/host_spi_bus.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ecl
+{
+
+//!
+//! \brief Timings of emulated card.
+//! Defaults are zero, so the card answers as fast as the bus allows.
+//!
+struct host_sd_timing
+{
+    uint32_t access_ns  = 0;    //!< Time from read command till data token.
+    uint32_t program_ns = 0;    //!< Time to program a block.
+    uint32_t erase_ns   = 0;    //!< Time to erase a range of blocks.
+};
+
+//!
+//! \brief Statistics of emulated card.
+//!
+struct host_sd_stats
+{
+    uint32_t commands       = 0;    //!< Commands received.
+    uint32_t blocks_read    = 0;    //!< Blocks sent to the host.
+    uint32_t blocks_written = 0;    //!< Blocks programmed.
+    uint32_t erases         = 0;    //!< Erase commands executed.
+    uint32_t crc_errors     = 0;    //!< Commands and blocks rejected due to CRC.
+};
+
+//!
+//! \brief Emulated SDHC card.
+//! Attach it to host_spi_bus and drive sd_spi over generic_bus of that bus.
+//!
+class host_sd_card : public host_spi_slave
+{
+public:
+    host_sd_card() = default;
+    ~host_sd_card() override { close(); }
+
+    host_sd_card(const host_sd_card &) = delete;
+    host_sd_card &operator=(const host_sd_card &) = delete;
+
+    //!
+    //! \brief Opens card image.
+    //! Capacity of SDHC card is a multiple of 512 KiB, so is the image size.
+    //! \param[in] path     Path to the image.
+    //! \param[in] blocks   If not zero, image is created or resized
+    //!                     to hold given amount of blocks.
+    //! \retval err::ok     Image is opened.
+    //! \retval err::inval  Image size is not a multiple of 512 KiB.
+    //! \retval err::io     Image can't be opened or resized.
+    //!
+    ecl::err open(const char *path, size_t blocks = 0)
+    {
+        close();
+
+        int fd = ::open(path, O_RDWR | (blocks ? O_CREAT : 0), 0644);
+        if (fd < 0) {
+            return ecl::err::io;
+        }
+
+        struct stat st;
+
+        if ((blocks && ftruncate(fd, static_cast< off_t >(blocks) * block_size))
+                || fstat(fd, &st)) {
+            ::close(fd);
+            return ecl::err::io;
+        }
+
+        size_t total = st.st_size / block_size;
+
+        if (!total || total % blocks_per_unit || st.st_size % block_size) {
+            ::close(fd);
+            return ecl::err::inval;
+        }
+
+        m_fd = fd;
+        m_blocks = total;
+        power_up();
+
+        return ecl::err::ok;
+    }
+
+    //!
+    //! \brief Closes the image. Card is removed from the bus afterwards.
+    //!
+    void close()
+    {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+
+        m_blocks = 0;
+    }
+
+    //! Gets amount of blocks on the card.
+    size_t block_count() const { return m_blocks; }
+
+    //! Gets timings of the card. Can be changed at any time.
+    host_sd_timing &timing() { return m_timing; }
+
+    //! Gets statistics of the card.
+    const host_sd_stats &stats() const { return m_stats; }
+
+    //! Resets statistics of the card.
+    void reset_stats() { m_stats = host_sd_stats{}; }
+
+    void select(bool selected) override
+    {
+        m_selected = selected;
+    }
+
+    uint64_t exchange(const uint8_t *tx, uint8_t fill, uint8_t *rx, size_t size) override
+    {
+        m_stall = 0;
+
+        for (size_t i = 0; i < size; ++i) {
+            uint8_t out = xchg(tx ? tx[i] : fill);
+            if (rx) {
+                rx[i] = out;
+            }
+        }
+
+        return m_stall;
+    }
+
+    void clock(uint32_t clk) override
+    {
+        m_clock = clk;
+    }
+
+private:
+    static constexpr size_t     block_size      = 512;
+    static constexpr size_t     blocks_per_unit = 1024;
+
+    // sd_spi polls for data token within 64 bytes, thus longer access
+    // time is reported as a stall of the bus rather than in bytes.
+    static constexpr size_t     max_access_bytes    = 8;
+    static constexpr size_t     max_busy_bytes      = 256;
+
+    // R1 flags
+    enum : uint8_t
+    {
+        r1_idle         = 0x01,
+        r1_illegal      = 0x04,
+        r1_crc          = 0x08,
+        r1_param        = 0x40,
+    };
+
+    // Data tokens and responses
+    enum : uint8_t
+    {
+        token_single    = 0xfe,
+        token_multi     = 0xfc,
+        token_stop      = 0xfd,
+        token_range     = 0x08,
+        resp_accepted   = 0xe5,
+        resp_crc        = 0xeb,
+        resp_write      = 0xed,
+    };
+
+    enum class state
+    {
+        idle,
+        read_multi,
+        write_single,
+        write_multi,
+    };
+
+    //! Returns the card to its power-up state.
+    void power_up()
+    {
+        m_out.clear();
+        m_busy = 0;
+        m_cmd_pos = -1;
+        m_data_pos = -1;
+        m_app = false;
+        m_initing = true;
+        m_init_polled = false;
+        m_crc = false;
+        m_state = state::idle;
+    }
+
+    //! Converts time to bytes on the wire, the rest goes to bus stall.
+    size_t to_bytes(uint32_t ns, size_t limit)
+    {
+        if (!m_clock) {
+            m_stall += ns;
+            return 0;
+        }
+
+        uint64_t bytes = static_cast< uint64_t >(ns) * m_clock / 8000000000ULL;
+
+        if (bytes > limit) {
+            m_stall += ns - limit * 8000000000ULL / m_clock;
+            bytes = limit;
+        }
+
+        return bytes;
+    }
+
+    //! Queues data packet with given payload.
+    void queue_data(const uint8_t *data, size_t size)
+    {
+        uint16_t crc = crc16(data, size);
+
+        m_out.push_back(token_single);
+        m_out.insert(m_out.end(), data, data + size);
+        m_out.push_back(crc >> 8);
+        m_out.push_back(crc & 0xff);
+    }
+
+    //! Queues a block read from the image, preceded by access time.
+    void queue_block(size_t blk)
+    {
+        m_out.insert(m_out.end(), to_bytes(m_timing.access_ns, max_access_bytes), 0xff);
+
+        uint8_t buf[block_size];
+
+        if (blk >= m_blocks || pread(m_fd, buf, block_size,
+                                     static_cast< off_t >(blk) * block_size) != ssize_t{block_size}) {
+            m_out.push_back(token_range);
+            m_state = state::idle;
+            return;
+        }
+
+        queue_data(buf, block_size);
+        ++m_stats.blocks_read;
+    }
+
+    //! Exchanges single byte.
+    uint8_t xchg(uint8_t in)
+    {
+        if (!m_selected || m_fd < 0) {
+            return 0xff;
+        }
+
+        uint8_t out = 0xff;
+
+        if (!m_out.empty()) {
+            out = m_out.front();
+            m_out.pop_front();
+        } else if (m_busy) {
+            --m_busy;
+            out = 0x00;
+        } else if (m_state == state::read_multi) {
+            queue_block(m_blk++);
+            out = m_out.front();
+            m_out.pop_front();
+        }
+
+        process(in);
+        return out;
+    }
+
+    //! Processes byte received from the host.
+    void process(uint8_t in)
+    {
+        bool writing = m_state == state::write_single || m_state == state::write_multi;
+
+        if (writing && m_cmd_pos < 0) {
+            receive_data(in);
+            return;
+        }
+
+        if (m_cmd_pos < 0) {
+            // Command starts with 01 bits, anything else is idle clocking
+            if ((in & 0xc0) == 0x40) {
+                m_cmd[0] = in;
+                m_cmd_pos = 1;
+            }
+            return;
+        }
+
+        m_cmd[m_cmd_pos++] = in;
+
+        if (m_cmd_pos == sizeof(m_cmd)) {
+            m_cmd_pos = -1;
+            execute();
+        }
+    }
+
+    //! Processes byte of data packet, sent by the host.
+    void receive_data(uint8_t in)
+    {
+        if (m_data_pos < 0) {
+            if (in == token_stop && m_state == state::write_multi) {
+                m_out.push_back(0xff);
+                m_busy = to_bytes(m_timing.program_ns, max_busy_bytes);
+                m_state = state::idle;
+            } else if (in == token_single || in == token_multi) {
+                m_data_pos = 0;
+            }
+            return;
+        }
+
+        m_data[m_data_pos++] = in;
+
+        if (m_data_pos < static_cast< int >(sizeof(m_data))) {
+            return;
+        }
+
+        m_data_pos = -1;
+
+        if (m_crc && crc16(m_data, block_size) != ((m_data[block_size] << 8) | m_data[block_size + 1])) {
+            ++m_stats.crc_errors;
+            m_out.push_back(resp_crc);
+            m_state = state::idle;
+            return;
+        }
+
+        if (m_blk >= m_blocks || pwrite(m_fd, m_data, block_size,
+                                        static_cast< off_t >(m_blk) * block_size) != ssize_t{block_size}) {
+            m_out.push_back(resp_write);
+            m_state = state::idle;
+            return;
+        }
+
+        ++m_blk;
+        ++m_stats.blocks_written;
+
+        m_out.push_back(resp_accepted);
+        m_busy = to_bytes(m_timing.program_ns, max_busy_bytes);
+
+        if (m_state == state::write_single) {
+            m_state = state::idle;
+        }
+    }
+
+    //! Executes received command.
+    void execute()
+    {
+        uint8_t idx = m_cmd[0] & 0x3f;
+        uint32_t arg = (m_cmd[1] << 24) | (m_cmd[2] << 16) | (m_cmd[3] << 8) | m_cmd[4];
+        bool app = m_app;
+
+        m_app = false;
+        ++m_stats.commands;
+
+        // Stop transmission is accepted amid data, stuff byte precedes R1
+        if (idx == 12 && m_state == state::read_multi) {
+            m_out.clear();
+            m_out.push_back(0x3f);
+            m_out.push_back(0x00);
+            m_busy = 1;
+            m_state = state::idle;
+            return;
+        }
+
+        // Response follows after a byte
+        m_out.push_back(0xff);
+
+        // Go idle and interface condition commands are always protected
+        if ((m_crc || idx == 0 || idx == 8) && (crc7(m_cmd, 5) << 1 | 1) != m_cmd[5]) {
+            ++m_stats.crc_errors;
+            m_out.push_back(r1_crc);
+            return;
+        }
+
+        if (idx == 0) {
+            // Pending response is dropped as well
+            power_up();
+            m_out.push_back(0xff);
+            m_out.push_back(r1_idle);
+            return;
+        }
+
+        uint8_t r1 = m_initing ? r1_idle : 0;
+
+        switch (idx) {
+        case 8:
+            // Voltage is accepted, check pattern is echoed
+            m_out.insert(m_out.end(), { r1, 0x00, 0x00,
+                                        static_cast< uint8_t >(arg >> 8 & 0xf),
+                                        static_cast< uint8_t >(arg & 0xff) });
+            break;
+        case 9:
+            m_out.push_back(r1);
+            send_csd();
+            break;
+        case 10:
+            m_out.push_back(r1);
+            send_cid();
+            break;
+        case 13:
+            m_out.insert(m_out.end(), { r1, 0x00 });
+            break;
+        case 16:
+            m_out.push_back(arg == block_size ? r1 : (r1 | r1_param));
+            break;
+        case 17:
+        case 18:
+            if (m_initing || arg >= m_blocks) {
+                m_out.push_back(r1 | r1_param);
+                break;
+            }
+            m_out.push_back(r1);
+            if (idx == 17) {
+                queue_block(arg);
+            } else {
+                m_blk = arg;
+                m_state = state::read_multi;
+            }
+            break;
+        case 23:
+            // Pre-erase hint, nothing to do
+            m_out.push_back(r1);
+            break;
+        case 24:
+        case 25:
+            if (m_initing || arg >= m_blocks) {
+                m_out.push_back(r1 | r1_param);
+                break;
+            }
+            m_out.push_back(r1);
+            m_blk = arg;
+            m_data_pos = -1;
+            m_state = idx == 24 ? state::write_single : state::write_multi;
+            break;
+        case 32:
+            m_erase_start = arg;
+            m_out.push_back(r1);
+            break;
+        case 33:
+            m_erase_end = arg;
+            m_out.push_back(r1);
+            break;
+        case 38:
+            m_out.push_back(r1);
+            erase();
+            break;
+        case 41:
+            if (!app) {
+                m_out.push_back(r1 | r1_illegal);
+                break;
+            }
+            // Init takes a while, the first ACMD41 leaves card idle
+            m_initing = m_initing && !m_init_polled;
+            m_init_polled = true;
+            m_out.push_back(m_initing ? r1_idle : 0);
+            break;
+        case 55:
+            m_out.push_back(r1);
+            m_app = true;
+            break;
+        case 58:
+            // Powered up, high capacity, 2.7-3.6V
+            m_out.insert(m_out.end(), { r1, static_cast< uint8_t >(m_initing ? 0x40 : 0xc0),
+                                        0xff, 0x80, 0x00 });
+            break;
+        case 59:
+            m_crc = arg & 1;
+            m_out.push_back(r1);
+            break;
+        default:
+            m_out.push_back(r1 | r1_illegal);
+            break;
+        }
+    }
+
+    //! Erases previously selected range of blocks.
+    void erase()
+    {
+        if (m_erase_start > m_erase_end || m_erase_end >= m_blocks) {
+            return;
+        }
+
+        uint8_t erased[block_size];
+        memset(erased, 0xff, sizeof(erased));
+
+        for (size_t blk = m_erase_start; blk <= m_erase_end; ++blk) {
+            if (pwrite(m_fd, erased, block_size, static_cast< off_t >(blk) * block_size) != ssize_t{block_size}) {
+                break;
+            }
+        }
+
+        ++m_stats.erases;
+        m_busy = to_bytes(m_timing.erase_ns, max_busy_bytes);
+    }
+
+    //! Sends CSD version 2.0 register.
+    void send_csd()
+    {
+        uint32_t c_size = m_blocks / blocks_per_unit - 1;
+        uint8_t csd[16] = {
+            0x40, 0x0e, 0x00, 0x32, 0x5b, 0x59, 0x00,
+            static_cast< uint8_t >((c_size >> 16) & 0x3f),
+            static_cast< uint8_t >(c_size >> 8),
+            static_cast< uint8_t >(c_size),
+            0x7f, 0x80, 0x0a, 0x40, 0x00, 0x00,
+        };
+
+        csd[15] = crc7(csd, 15) << 1 | 1;
+        queue_data(csd, sizeof(csd));
+    }
+
+    //! Sends CID register.
+    void send_cid()
+    {
+        uint8_t cid[16] = {
+            0x00, 'E', 'C', 'H', 'O', 'S', 'T', 'S', 0x10,
+            0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x00,
+        };
+
+        cid[15] = crc7(cid, 15) << 1 | 1;
+        queue_data(cid, sizeof(cid));
+    }
+
+    int                     m_fd                = -1;       //!< Image file.
+    size_t                  m_blocks            = 0;        //!< Capacity in blocks.
+    bool                    m_selected          = false;    //!< CS line is low.
+    uint32_t                m_clock             = 0;        //!< Bus clock in Hz.
+    uint64_t                m_stall             = 0;        //!< Bus stall of current exchange.
+    host_sd_timing          m_timing            = {};       //!< Timings.
+    host_sd_stats           m_stats             = {};       //!< Statistics.
+
+    std::deque< uint8_t >   m_out               = {};       //!< Bytes to send.
+    size_t                  m_busy              = 0;        //!< Busy bytes to send.
+    uint8_t                 m_cmd[6]            = {};       //!< Command being received.
+    int                     m_cmd_pos           = -1;       //!< Command position, -1 if none.
+    uint8_t                 m_data[block_size + 2] = {};    //!< Block being received, with CRC.
+    int                     m_data_pos          = -1;       //!< Block position, -1 if waiting for token.
+    bool                    m_app               = false;    //!< Next command is application specific.
+    bool                    m_initing           = true;     //!< Initialization is not complete.
+    bool                    m_init_polled       = false;    //!< ACMD41 was received once.
+    bool                    m_crc               = false;    //!< CRC checks are on.
+    state                   m_state             = state::idle; //!< Data transfer state.
+    size_t                  m_blk               = 0;        //!< Block of current data transfer.
+    size_t                  m_erase_start       = 0;        //!< First block to erase.
+    size_t                  m_erase_end         = 0;        //!< Last block to erase.
+};
+
+} // namespace ecl
+
+#endif // PLATFORM_HOST_SD_CARD_HPP_
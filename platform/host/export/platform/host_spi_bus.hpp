@@ -0,0 +1,275 @@
+#ifndef PLATFORM_HOST_SPI_BUS_HPP_
+#define PLATFORM_HOST_SPI_BUS_HPP_
+
+//!
+//! \file
+//! \brief Emulated SPI bus for host builds.
+//! Bus follows platform bus interface of stm32f4xx spi_bus, so drivers
+//! written against generic_bus run on host unchanged. Bytes are exchanged
+//! with emulated slave device, i.e. host_sd_card. Time, that real bus
+//! would spend on the wire, is modeled by host_latency.
+//!
+
+#include <ecl/err.hpp>
+#include <common/spi.hpp>
+#include <platform/common/bus.hpp>
+#include <platform/host_latency.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Device on the emulated SPI bus.
+//!
+class host_spi_slave
+{
+public:
+    virtual ~host_spi_slave() = default;
+
+    //!
+    //! \brief Notifies the device about chip select change.
+    //! \param[in] selected True if CS line is driven low.
+    //!
+    virtual void select(bool selected) = 0;
+
+    //!
+    //! \brief Exchanges bytes with the device.
+    //! \param[in]  tx      Bytes clocked out by master. Can be null.
+    //! \param[in]  fill    Byte clocked out by master if tx is null.
+    //! \param[out] rx      Bytes clocked in by master. Can be null.
+    //! \param[in]  size    Amount of bytes.
+    //! \return Time in nanoseconds the device held the bus beyond
+    //!         the wire time, i.e. when it can't report own latency in bytes.
+    //!
+    virtual uint64_t exchange(const uint8_t *tx, uint8_t fill, uint8_t *rx, size_t size) = 0;
+
+    //!
+    //! \brief Notifies the device about clock change.
+    //! \param[in] clk Clock in Hz.
+    //!
+    virtual void clock(uint32_t clk) { (void) clk; }
+};
+
+//!
+//! \brief Emulated platform SPI bus.
+//! Events are delivered right from do_xfer(), as if DMA and IRQ took
+//! no time. Xfer started from a handler is deferred until the handler
+//! returns, as with real DMA, thus long polling chains don't nest.
+//! If no device is attached, MISO is pulled up and reads as 0xff.
+//! \tparam dev Device, only distinguishes buses from each other.
+//!
+template< spi_device dev >
+class host_spi_bus
+{
+public:
+    using channel    = ecl::bus_channel;
+    using event      = ecl::bus_event;
+    using handler_fn = ecl::bus_handler;
+
+    host_spi_bus()
+        :m_tx{nullptr}
+        ,m_rx{nullptr}
+        ,m_tx_size{0}
+        ,m_rx_size{0}
+        ,m_fill{0xff}
+        ,m_handler{}
+        ,m_delivering{false}
+        ,m_pending{false}
+    { }
+
+    host_spi_bus(const host_spi_bus &) = delete;
+    host_spi_bus &operator=(const host_spi_bus &) = delete;
+
+    ecl::err init() { return ecl::err::ok; }
+
+    void reset_buffers()
+    {
+        m_tx = nullptr;
+        m_rx = nullptr;
+        m_tx_size = m_rx_size = 0;
+    }
+
+    void set_tx(const uint8_t *tx, size_t size)
+    {
+        m_tx = tx;
+        m_tx_size = tx ? size : 0;
+        m_fill = 0xff;
+    }
+
+    void set_rx(uint8_t *rx, size_t size)
+    {
+        m_rx = rx;
+        m_rx_size = rx ? size : 0;
+    }
+
+    void set_tx(size_t size, uint8_t fill_byte = 0xff)
+    {
+        m_tx = nullptr;
+        m_tx_size = size;
+        m_fill = fill_byte;
+    }
+
+    void set_handler(const handler_fn &handler) { m_handler = handler; }
+    void reset_handler() { m_handler = handler_fn{}; }
+
+    ecl::err do_xfer()
+    {
+        if (m_delivering) {
+            m_pending = true;
+            return ecl::err::ok;
+        }
+
+        do {
+            m_pending = false;
+            run();
+            deliver();
+        } while (m_pending);
+
+        return ecl::err::ok;
+    }
+
+    // Streaming never ends on its own, thus cannot be delivered synchronously
+    void set_double_buffers(const uint8_t *, const uint8_t *, uint8_t *, uint8_t *, size_t) { }
+    ecl::err do_stream() { return ecl::err::notsup; }
+    ecl::err stop_stream() { return ecl::err::perm; }
+
+    ecl::err set_clock(uint32_t clk)
+    {
+        m_latency.clock = clk;
+
+        if (m_slave) {
+            m_slave->clock(clk);
+        }
+
+        return ecl::err::ok;
+    }
+
+    ecl::err set_mode(uint16_t, uint16_t) { return ecl::err::ok; }
+
+    //!
+    //! \brief Attaches a device to the bus.
+    //! \param[in] slave Device. Null detaches current one.
+    //!
+    static void attach(host_spi_slave *slave)
+    {
+        m_slave = slave;
+
+        if (m_slave && m_latency.clock) {
+            m_slave->clock(m_latency.clock);
+        }
+    }
+
+    //!
+    //! \brief Drives chip select of attached device.
+    //! \param[in] selected True if CS line is driven low.
+    //!
+    static void select(bool selected)
+    {
+        if (m_slave) {
+            m_slave->select(selected);
+        }
+    }
+
+    //!
+    //! \brief Gets latency model of the bus.
+    //! Clock is updated by set_clock(), the rest is up to user.
+    //!
+    static host_latency &latency() { return m_latency; }
+
+    //!
+    //! \brief Gets time, modeled so far, in nanoseconds.
+    //!
+    static uint64_t elapsed_ns() { return m_elapsed; }
+
+    //!
+    //! \brief Resets modeled time.
+    //!
+    static void reset_elapsed() { m_elapsed = 0; }
+
+private:
+    //! Clocks bytes through the device, spending modeled time.
+    void run()
+    {
+        size_t size = m_tx_size > m_rx_size ? m_tx_size : m_rx_size;
+        uint64_t ns = m_latency.cost(size);
+
+        if (m_slave) {
+            ns += m_slave->exchange(m_tx, m_fill, m_rx, size);
+        } else if (m_rx) {
+            for (size_t i = 0; i < m_rx_size; ++i) {
+                m_rx[i] = 0xff;
+            }
+        }
+
+        m_elapsed += ns;
+        m_latency.spend(ns);
+    }
+
+    //! Notifies generic bus, in the same order as DMA-driven buses do.
+    void deliver()
+    {
+        m_delivering = true;
+
+        if (m_tx_size) {
+            m_handler(channel::tx, event::tc, m_tx_size);
+        }
+
+        if (m_rx_size) {
+            m_handler(channel::rx, event::tc, m_rx_size);
+        }
+
+        m_handler(channel::meta, event::tc, 0);
+
+        m_delivering = false;
+    }
+
+    const uint8_t   *m_tx;          //!< Data to transmit.
+    uint8_t         *m_rx;          //!< Buffer to receive a data.
+    size_t          m_tx_size;      //!< Size of transmitted data.
+    size_t          m_rx_size;      //!< Size of received data.
+    uint8_t         m_fill;         //!< Fill byte, if no data is transmitted.
+    handler_fn      m_handler;      //!< Handler of generic bus.
+    bool            m_delivering;   //!< Handler is being executed.
+    bool            m_pending;      //!< Xfer was started from the handler.
+
+    static host_spi_slave   *m_slave;   //!< Attached device.
+    static host_latency     m_latency;  //!< Latency model.
+    static uint64_t         m_elapsed;  //!< Modeled time, in nanoseconds.
+};
+
+template< spi_device dev >
+host_spi_slave *host_spi_bus< dev >::m_slave{nullptr};
+
+template< spi_device dev >
+host_latency host_spi_bus< dev >::m_latency{};
+
+template< spi_device dev >
+uint64_t host_spi_bus< dev >::m_elapsed{0};
+
+//!
+//! \brief Chip select line of emulated SPI bus.
+//! Follows GPIO interface, as expected by SPI device drivers.
+//! Line is active low, so reset() selects the device.
+//! \tparam dev Bus the line belongs to.
+//!
+template< spi_device dev >
+struct host_spi_cs
+{
+    static void set()       { m_low = false; host_spi_bus< dev >::select(false); }
+    static void reset()     { m_low = true; host_spi_bus< dev >::select(true); }
+    static void toggle()    { m_low ? set() : reset(); }
+    static bool get()       { return !m_low; }
+
+private:
+    static bool m_low;      //!< Line is driven low.
+};
+
+template< spi_device dev >
+bool host_spi_cs< dev >::m_low{false};
+
+} // namespace ecl
+
+#endif // PLATFORM_HOST_SPI_BUS_HPP_
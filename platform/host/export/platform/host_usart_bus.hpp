@@ -0,0 +1,296 @@
+#ifndef PLATFORM_HOST_USART_BUS_HPP_
+#define PLATFORM_HOST_USART_BUS_HPP_
+
+//!
+//! \file
+//! \brief Emulated USART bus for host builds.
+//! Bus follows platform bus interface of stm32f4xx usart_bus. Transmitted
+//! bytes are written to a file descriptor and received bytes are read
+//! from another one, so the bus can be wired to a pipe, a socket, a pty
+//! or a real serial port.
+//!
+
+#include <ecl/err.hpp>
+#include <common/usart.hpp>
+#include <platform/common/bus.hpp>
+#include <platform/host_latency.hpp>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ecl
+{
+
+//!
+//! \brief Emulated platform USART bus.
+//! Xfer blocks until whole TX buffer is written and RX buffer is filled,
+//! then events are delivered right from do_xfer(). Xfer started from
+//! a handler is deferred until the handler returns, as with real DMA.
+//! If no descriptors are attached, TX is discarded and RX fails.
+//! Latency model is set up for 8N1 frames, so only clock must be
+//! configured to model the wire.
+//! \tparam dev Device, only distinguishes buses from each other.
+//!
+template< usart_device dev >
+class host_usart_bus
+{
+public:
+    using channel    = ecl::bus_channel;
+    using event      = ecl::bus_event;
+    using handler_fn = ecl::bus_handler;
+
+    host_usart_bus()
+        :m_tx{nullptr}
+        ,m_rx{nullptr}
+        ,m_tx_size{0}
+        ,m_rx_size{0}
+        ,m_fill{0xff}
+        ,m_handler{}
+        ,m_rx_idle{false}
+        ,m_delivering{false}
+        ,m_pending{false}
+        ,m_sent{0}
+        ,m_received{0}
+        ,m_tx_err{false}
+        ,m_rx_err{false}
+    { }
+
+    host_usart_bus(const host_usart_bus &) = delete;
+    host_usart_bus &operator=(const host_usart_bus &) = delete;
+
+    ecl::err init() { return ecl::err::ok; }
+
+    void reset_buffers()
+    {
+        m_tx = nullptr;
+        m_rx = nullptr;
+        m_tx_size = m_rx_size = 0;
+    }
+
+    void set_tx(const uint8_t *tx, size_t size)
+    {
+        m_tx = tx;
+        m_tx_size = tx ? size : 0;
+    }
+
+    void set_rx(uint8_t *rx, size_t size)
+    {
+        m_rx = rx;
+        m_rx_size = rx ? size : 0;
+    }
+
+    void set_tx(size_t size, uint8_t fill_byte = 0xff)
+    {
+        m_tx = nullptr;
+        m_tx_size = size;
+        m_fill = fill_byte;
+    }
+
+    void set_handler(const handler_fn &handler) { m_handler = handler; }
+    void reset_handler() { m_handler = handler_fn{}; }
+
+    //!
+    //! \brief Enables or disables idle-line terminated RX.
+    //! In this mode RX ends as soon as any data is available, the same
+    //! way as it ends on idle line after a frame.
+    //! \param[in] enable Desired mode state.
+    //!
+    void set_rx_idle(bool enable) { m_rx_idle = enable; }
+
+    ecl::err do_xfer()
+    {
+        if (m_delivering) {
+            m_pending = true;
+            return ecl::err::ok;
+        }
+
+        do {
+            m_pending = false;
+            run();
+            deliver();
+        } while (m_pending);
+
+        return ecl::err::ok;
+    }
+
+    //!
+    //! \brief Attaches descriptors to the bus.
+    //! Descriptors are owned by the caller. Negative value detaches.
+    //! \param[in] rx_fd Descriptor to read received bytes from.
+    //! \param[in] tx_fd Descriptor to write transmitted bytes to.
+    //!
+    static void attach(int rx_fd, int tx_fd)
+    {
+        m_rx_fd = rx_fd;
+        m_tx_fd = tx_fd;
+    }
+
+    //!
+    //! \brief Opens a file, i.e. a pty or a serial port, and attaches it
+    //! in both directions.
+    //! \param[in] path Path to the file.
+    //! \return Status of operation.
+    //!
+    static ecl::err open(const char *path)
+    {
+        int fd = ::open(path, O_RDWR | O_NOCTTY);
+        if (fd < 0) {
+            return ecl::err::io;
+        }
+
+        close();
+        m_owned = fd;
+        attach(fd, fd);
+
+        return ecl::err::ok;
+    }
+
+    //!
+    //! \brief Closes file opened by open() and detaches descriptors.
+    //!
+    static void close()
+    {
+        if (m_owned >= 0) {
+            ::close(m_owned);
+            m_owned = -1;
+        }
+
+        attach(-1, -1);
+    }
+
+    //!
+    //! \brief Gets latency model of the bus.
+    //!
+    static host_latency &latency() { return m_latency; }
+
+    //!
+    //! \brief Gets time, modeled so far, in nanoseconds.
+    //!
+    static uint64_t elapsed_ns() { return m_elapsed; }
+
+    //!
+    //! \brief Resets modeled time.
+    //!
+    static void reset_elapsed() { m_elapsed = 0; }
+
+private:
+    //! Moves bytes through descriptors, spending modeled time.
+    void run()
+    {
+        m_sent = m_received = 0;
+        m_tx_err = m_rx_err = false;
+
+        while (m_sent < m_tx_size) {
+            uint8_t chunk[64];
+            const uint8_t *src = m_tx ? m_tx + m_sent : chunk;
+            size_t len = m_tx_size - m_sent;
+
+            if (!m_tx) {
+                len = len < sizeof(chunk) ? len : sizeof(chunk);
+                for (size_t i = 0; i < len; ++i) {
+                    chunk[i] = m_fill;
+                }
+            }
+
+            // Nothing is wired to TX, bytes are lost as on idle line
+            if (m_tx_fd < 0) {
+                m_sent += len;
+                continue;
+            }
+
+            ssize_t rc = ::write(m_tx_fd, src, len);
+            if (rc < 0 && errno == EINTR) {
+                continue;
+            } else if (rc <= 0) {
+                m_tx_err = true;
+                break;
+            }
+
+            m_sent += rc;
+        }
+
+        while (m_received < m_rx_size) {
+            ssize_t rc = m_rx_fd < 0 ? -1 : ::read(m_rx_fd, m_rx + m_received,
+                                                   m_rx_size - m_received);
+            if (rc < 0 && errno == EINTR) {
+                continue;
+            } else if (rc <= 0) {
+                m_rx_err = true;
+                break;
+            }
+
+            m_received += rc;
+
+            if (m_rx_idle) {
+                break;
+            }
+        }
+
+        size_t size = m_sent > m_received ? m_sent : m_received;
+        uint64_t ns = m_latency.cost(size);
+
+        m_elapsed += ns;
+        m_latency.spend(ns);
+    }
+
+    //! Notifies generic bus, in the same order as stm32f4xx bus does.
+    void deliver()
+    {
+        m_delivering = true;
+
+        if (m_tx_size) {
+            m_handler(channel::tx, m_tx_err ? event::err : event::tc, m_sent);
+        }
+
+        if (m_rx_size) {
+            m_handler(channel::rx, m_rx_err ? event::err : event::tc, m_received);
+        }
+
+        m_handler(channel::meta, event::tc, 0);
+
+        m_delivering = false;
+    }
+
+    const uint8_t   *m_tx;          //!< Data to transmit.
+    uint8_t         *m_rx;          //!< Buffer to receive a data.
+    size_t          m_tx_size;      //!< Size of transmitted data.
+    size_t          m_rx_size;      //!< Size of received data.
+    uint8_t         m_fill;         //!< Fill byte, if no data is transmitted.
+    handler_fn      m_handler;      //!< Handler of generic bus.
+    bool            m_rx_idle;      //!< RX ends as soon as data is available.
+    bool            m_delivering;   //!< Handler is being executed.
+    bool            m_pending;      //!< Xfer was started from the handler.
+    size_t          m_sent;         //!< Bytes sent by last xfer.
+    size_t          m_received;     //!< Bytes received by last xfer.
+    bool            m_tx_err;       //!< Last xfer failed to send.
+    bool            m_rx_err;       //!< Last xfer failed to receive.
+
+    static int              m_rx_fd;    //!< Descriptor of RX line.
+    static int              m_tx_fd;    //!< Descriptor of TX line.
+    static int              m_owned;    //!< Descriptor opened by open().
+    static host_latency     m_latency;  //!< Latency model.
+    static uint64_t         m_elapsed;  //!< Modeled time, in nanoseconds.
+};
+
+template< usart_device dev >
+int host_usart_bus< dev >::m_rx_fd{-1};
+
+template< usart_device dev >
+int host_usart_bus< dev >::m_tx_fd{-1};
+
+template< usart_device dev >
+int host_usart_bus< dev >::m_owned{-1};
+
+template< usart_device dev >
+host_latency host_usart_bus< dev >::m_latency{0, 0, 10, host_delay::none};
+
+template< usart_device dev >
+uint64_t host_usart_bus< dev >::m_elapsed{0};
+
+} // namespace ecl
+
+#endif // PLATFORM_HOST_USART_BUS_HPP_
@@ -0,0 +1,61 @@
+#ifndef PLATFORM_HOST_HW_CRC32_HPP_
+#define PLATFORM_HOST_HW_CRC32_HPP_
+
+//!
+//! \file
+//! \brief CRC-32 of words on host, with the same interface as target CRC unit.
+//!
+
+#include <ecl/crc.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Streaming CRC-32, computed by ecl::crc32().
+//! Gives the same values as CRC unit of STM32 does.
+//!
+class hw_crc32
+{
+public:
+    hw_crc32()
+        :m_crc{0xffffffff}
+    {
+    }
+
+    //!
+    //! \brief Starts a new checksum.
+    //!
+    void reset()
+    {
+        m_crc = 0xffffffff;
+    }
+
+    //!
+    //! \brief Appends words to the checksum.
+    //! \param[in] data Words.
+    //! \param[in] n    Amount of words.
+    //!
+    void update(const uint32_t *data, size_t n)
+    {
+        m_crc = crc32(data, n, m_crc);
+    }
+
+    //!
+    //! \brief Gets current value of the checksum.
+    //!
+    uint32_t value() const
+    {
+        return m_crc;
+    }
+
+private:
+    uint32_t m_crc; //!< Current value.
+};
+
+} // namespace ecl
+
+#endif // PLATFORM_HOST_HW_CRC32_HPP_
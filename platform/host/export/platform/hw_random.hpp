@@ -0,0 +1,126 @@
+#ifndef PLATFORM_HOST_HW_RANDOM_HPP_
+#define PLATFORM_HOST_HW_RANDOM_HPP_
+
+//!
+//! \file
+//! \brief Random numbers on host, with the same interface as target RNG.
+//! std::random_device acts as a noise source. Its output passes through
+//! the same health tests and conditioning as RNG output does on target,
+//! so consumers of ecl::hw_random behave the same in host tests.
+//!
+
+#include <ecl/crypto/entropy.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <random>
+
+namespace ecl
+{
+
+//!
+//! \brief Host random device.
+//! Pool is refilled synchronously by a consumer that finds it empty.
+//! \tparam pool_words Capacity of entropy pool, in words.
+//!
+template< size_t pool_words = 64 >
+class hw_random
+{
+public:
+    using result_type = uint32_t;
+
+    //! Does nothing, source is always ready.
+    static void init() { }
+
+    //! Does nothing.
+    static void deinit() { }
+
+    //!
+    //! \brief Gets random word.
+    //!
+    result_type operator()()
+    {
+        result_type w;
+
+        while (!m_pool.pop(w)) {
+            refill();
+        }
+
+        return w;
+    }
+
+    //!
+    //! \brief Gets random words.
+    //! \return Amount of words obtained, always as requested.
+    //!
+    static size_t read(result_type *out, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            while (!m_pool.pop(out[i])) {
+                refill();
+            }
+        }
+
+        return n;
+    }
+
+    //!
+    //! \brief Gets amount of health test failures so far.
+    //!
+    static size_t failures()
+    {
+        return m_failures;
+    }
+
+    static constexpr result_type min()
+    {
+        return std::numeric_limits< result_type >::min();
+    }
+
+    static constexpr result_type max()
+    {
+        return std::numeric_limits< result_type >::max();
+    }
+
+private:
+    //! Feeds the pool until it is full. Pool has single producer,
+    //! so producers are serialized.
+    static void refill()
+    {
+        static std::random_device source;
+        static std::mutex lock;
+
+        std::lock_guard< std::mutex > guard{lock};
+
+        for (;;) {
+            auto sample = static_cast< uint32_t >(source());
+
+            switch (m_pool.feed(sample)) {
+            case crypto::pool_status::full:
+                return;
+            case crypto::pool_status::failed:
+                ++m_failures;
+                m_pool.restart();
+                break;
+            case crypto::pool_status::more:
+                break;
+            }
+        }
+    }
+
+    static crypto::entropy_pool< pool_words >   m_pool;     //!< Conditioned words.
+    static std::atomic< size_t >                m_failures; //!< Failures so far.
+};
+
+template< size_t pool_words >
+crypto::entropy_pool< pool_words > hw_random< pool_words >::m_pool{};
+
+template< size_t pool_words >
+std::atomic< size_t > hw_random< pool_words >::m_failures{0};
+
+} // namespace ecl
+
+#endif // PLATFORM_HOST_HW_RANDOM_HPP_
@@ -0,0 +1,98 @@
+#ifndef PLATFORM_HOST_RTC_HPP_
+#define PLATFORM_HOST_RTC_HPP_
+
+//!
+//! \file
+//! \brief Wall-clock time on host, with the same interface as target RTC.
+//! Time is taken from std::chrono::system_clock, shifted by set().
+//!
+
+#include <ecl/calendar.hpp>
+#include <ecl/err.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Clock of RTC.
+//!
+enum class rtc_source
+{
+    lse,
+    lsi,
+};
+
+//!
+//! \brief Host real-time clock.
+//! \tparam source  Unused, for compatibility with target RTC.
+//! \tparam tb      Unused, for compatibility with target RTC.
+//!
+template< rtc_source source = rtc_source::lse, class tb = void >
+class rtc_unit
+{
+public:
+    //! Starts the clock, in sync with the host.
+    static ecl::err init()
+    {
+        m_shift = 0;
+        return ecl::err::ok;
+    }
+
+    //! Sets calendar time. Year must be in 2000 .. 2099, as on target.
+    static ecl::err set(const date_time &dt)
+    {
+        if (dt.year < 2000 || dt.year > 2099) {
+            return ecl::err::inval;
+        }
+
+        m_shift = static_cast< int64_t >(to_unix(dt)) * 1000000 - host_us();
+        return ecl::err::ok;
+    }
+
+    //! Nothing to capture on host.
+    static ecl::err resync()
+    {
+        return ecl::err::ok;
+    }
+
+    //! Gets current Unix time in microseconds.
+    static uint64_t now_us()
+    {
+        return host_us() + m_shift;
+    }
+
+    //! Gets current calendar time.
+    static date_time now()
+    {
+        return from_unix(now_us() / 1000000);
+    }
+
+    //! Gets current FAT timestamp.
+    static uint32_t fat_now()
+    {
+        return to_fat(now());
+    }
+
+private:
+    static int64_t host_us()
+    {
+        using namespace std::chrono;
+        return duration_cast< microseconds >(system_clock::now().time_since_epoch()).count();
+    }
+
+    static std::atomic< int64_t > m_shift; //!< Difference from host time, us.
+};
+
+template< rtc_source source, class tb >
+std::atomic< int64_t > rtc_unit< source, tb >::m_shift{0};
+
+//! Host real-time clock.
+using rtc = rtc_unit<>;
+
+} // namespace ecl
+
+#endif // PLATFORM_HOST_RTC_HPP_
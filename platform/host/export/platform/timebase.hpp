@@ -0,0 +1,160 @@
+#ifndef PLATFORM_HOST_TIMEBASE_HPP_
+#define PLATFORM_HOST_TIMEBASE_HPP_
+
+//!
+//! \file
+//! \brief Microsecond timebase on host, with the same interface as target one.
+//! Time is taken from std::chrono::steady_clock. There are no capture
+//! inputs, so events are injected by trigger() instead.
+//!
+
+#include <ecl/err.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace ecl
+{
+
+//!
+//! \brief Edge of input signal, which is captured.
+//!
+enum class capture_edge
+{
+    rising,
+    falling,
+    both,
+};
+
+//!
+//! \brief Host microsecond timebase.
+//! \tparam timer Unused, for compatibility with target timebase.
+//!
+template< std::uintptr_t timer = 0 >
+class timebase_unit
+{
+public:
+    //! Handler of captured event, called with event timestamp.
+    using capture_handler = std::function< void(uint32_t timestamp) >;
+
+    //! Amount of capture channels.
+    static constexpr int channels = 4;
+
+    //! Starts counting from zero.
+    static void init()
+    {
+        m_epoch = clock::now();
+    }
+
+    //! Removes capture handlers.
+    static void deinit()
+    {
+        std::lock_guard< std::mutex > guard{m_lock};
+
+        for (auto &h : m_handlers) {
+            h = nullptr;
+        }
+    }
+
+    //! Gets current time in microseconds since init(), wrapping at 2^32.
+    static uint32_t now_us()
+    {
+        auto us = std::chrono::duration_cast< std::chrono::microseconds >(
+            clock::now() - m_epoch.load());
+
+        return static_cast< uint32_t >(us.count());
+    }
+
+    //! Waits, spinning, for at least given time.
+    static void delay_us(uint32_t us)
+    {
+        uint32_t start = now_us();
+
+        while (now_us() - start <= us) { }
+    }
+
+    //! Stores a handler of channel events.
+    static err capture(int channel, capture_edge edge, capture_handler handler,
+                       uint8_t filter = 0)
+    {
+        (void)edge;
+
+        if (channel < 1 || channel > channels || filter > 0xf) {
+            return err::inval;
+        }
+
+        std::lock_guard< std::mutex > guard{m_lock};
+        m_handlers[channel - 1] = handler;
+
+        return err::ok;
+    }
+
+    //! Removes a handler of channel events.
+    static void stop_capture(int channel)
+    {
+        if (channel < 1 || channel > channels) {
+            return;
+        }
+
+        std::lock_guard< std::mutex > guard{m_lock};
+        m_handlers[channel - 1] = nullptr;
+    }
+
+    //! Always zero, events are never lost on host.
+    static size_t overcaptures()
+    {
+        return 0;
+    }
+
+    //!
+    //! \brief Emulates captured edge at a channel input, now.
+    //! \retval err::ok     Event is delivered.
+    //! \retval err::inval  Invalid channel.
+    //! \retval err::again  Capture is not started at the channel.
+    //!
+    static err trigger(int channel)
+    {
+        if (channel < 1 || channel > channels) {
+            return err::inval;
+        }
+
+        uint32_t timestamp = now_us();
+        std::lock_guard< std::mutex > guard{m_lock};
+
+        if (!m_handlers[channel - 1]) {
+            return err::again;
+        }
+
+        m_handlers[channel - 1](timestamp);
+        return err::ok;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    static std::atomic< clock::time_point > m_epoch;           //!< Time of init().
+    static std::mutex                       m_lock;            //!< Protects handlers.
+    static capture_handler                  m_handlers[channels]; //!< Event handlers.
+};
+
+//! Host microsecond timebase.
+using timebase = timebase_unit<>;
+
+template< std::uintptr_t timer >
+std::atomic< typename timebase_unit< timer >::clock::time_point >
+timebase_unit< timer >::m_epoch{timebase_unit< timer >::clock::now()};
+
+template< std::uintptr_t timer >
+std::mutex timebase_unit< timer >::m_lock;
+
+template< std::uintptr_t timer >
+typename timebase_unit< timer >::capture_handler
+timebase_unit< timer >::m_handlers[timebase_unit< timer >::channels];
+
+} // namespace ecl
+
+#endif // PLATFORM_HOST_TIMEBASE_HPP_
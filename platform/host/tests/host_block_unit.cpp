@@ -0,0 +1,125 @@
+#include <platform/host_block.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+using ecl::host_block;
+
+TEST_GROUP(host_block)
+{
+    char path[32] = "/tmp/host_block_XXXXXX";
+
+    void setup()
+    {
+        int fd = mkstemp(path);
+        CHECK_TRUE(fd >= 0);
+
+        std::vector< uint8_t > image(8 * host_block::block_size);
+        for (size_t i = 0; i < image.size(); ++i) {
+            image[i] = i / host_block::block_size;
+        }
+
+        CHECK_EQUAL(image.size(), static_cast< size_t >(write(fd, image.data(), image.size())));
+        ::close(fd);
+    }
+
+    void teardown()
+    {
+        unlink(path);
+    }
+};
+
+TEST(host_block, blocks_are_read_from_the_image)
+{
+    host_block::set_image(path, false);
+    host_block dev;
+    uint8_t buf[2 * host_block::block_size];
+
+    CHECK_EQUAL(0, dev.open());
+    CHECK_EQUAL(8, dev.block_count());
+
+    CHECK_EQUAL(0, dev.read_blocks(3, buf, 2));
+    CHECK_EQUAL(3, buf[0]);
+    CHECK_EQUAL(4, buf[sizeof(buf) - 1]);
+
+    CHECK_EQUAL(0, dev.close());
+    CHECK_EQUAL(0, dev.block_count());
+}
+
+TEST(host_block, out_of_range_requests_are_rejected)
+{
+    host_block::set_image(path, true);
+    host_block dev;
+    uint8_t buf[2 * host_block::block_size] = {};
+
+    CHECK_EQUAL(-1, dev.read_blocks(0, buf, 1));
+
+    CHECK_EQUAL(0, dev.open());
+    CHECK_EQUAL(-1, dev.read_blocks(7, buf, 2));
+    CHECK_EQUAL(-1, dev.write_blocks(9, buf, 1));
+    CHECK_EQUAL(-1, dev.trim(8, 1));
+    CHECK_EQUAL(0, dev.trim(7, 1));
+    CHECK_EQUAL(0, dev.close());
+}
+
+TEST(host_block, writes_reach_the_image_only_if_writable)
+{
+    uint8_t buf[host_block::block_size] = {};
+    uint8_t back[host_block::block_size];
+
+    host_block::set_image(path, false);
+    {
+        host_block dev;
+        CHECK_EQUAL(0, dev.open());
+        CHECK_EQUAL(-1, dev.write_blocks(1, buf, 1));
+    }
+
+    host_block::set_image(path, true);
+    {
+        host_block dev;
+        CHECK_EQUAL(0, dev.open());
+        CHECK_EQUAL(0, dev.write_blocks(1, buf, 1));
+    }
+
+    host_block dev;
+    CHECK_EQUAL(0, dev.open());
+    CHECK_EQUAL(0, dev.read_blocks(1, back, 1));
+    MEMCMP_EQUAL(buf, back, sizeof(buf));
+}
+
+TEST(host_block, opens_are_counted)
+{
+    host_block::set_image(path, false);
+    host_block dev;
+    uint8_t buf[host_block::block_size];
+
+    CHECK_EQUAL(-1, dev.close());
+    CHECK_EQUAL(0, dev.open());
+    CHECK_EQUAL(0, dev.open());
+    CHECK_EQUAL(0, dev.close());
+    CHECK_EQUAL(0, dev.read_blocks(0, buf, 1));
+    CHECK_EQUAL(0, dev.close());
+    CHECK_EQUAL(-1, dev.read_blocks(0, buf, 1));
+}
+
+TEST(host_block, images_of_partial_blocks_are_not_opened)
+{
+    FILE *f = fopen(path, "ab");
+    fputc(0, f);
+    fclose(f);
+
+    host_block::set_image(path, false);
+    host_block dev;
+
+    CHECK_EQUAL(-1, dev.open());
+    CHECK_EQUAL(-1, dev.close());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,306 @@
+#include <platform/host_spi_bus.hpp>
+#include <platform/host_sd_card.hpp>
+#include <platform/host_usart_bus.hpp>
+
+#include <dev/bus.hpp>
+#include <dev/sdspi.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+using spi_pbus  = ecl::host_spi_bus< ecl::spi_device::bus_1 >;
+using spi       = ecl::generic_bus< spi_pbus >;
+using spi_cs    = ecl::host_spi_cs< ecl::spi_device::bus_1 >;
+using sd        = ecl::sd_spi< spi, spi_cs >;
+
+using usart_pbus    = ecl::host_usart_bus< ecl::usart_device::dev_1 >;
+using usart         = ecl::generic_bus< usart_pbus >;
+
+// Smallest SDHC card
+static constexpr size_t card_blocks = 1024;
+
+//------------------------------------------------------------------------------
+
+TEST_GROUP(host_sd)
+{
+    char            path[32];
+    ecl::host_sd_card *card;
+
+    void setup()
+    {
+        strcpy(path, "/tmp/host_sd_XXXXXX");
+        int fd = mkstemp(path);
+        CHECK_TRUE(fd >= 0);
+        close(fd);
+
+        card = new ecl::host_sd_card;
+        CHECK_TRUE(card->open(path, card_blocks) == ecl::err::ok);
+
+        spi_pbus::attach(card);
+        spi_pbus::latency() = ecl::host_latency{};
+        spi_pbus::reset_elapsed();
+    }
+
+    void teardown()
+    {
+        spi_pbus::attach(nullptr);
+        delete card;
+        unlink(path);
+    }
+};
+
+TEST(host_sd, card_is_initialized)
+{
+    sd dev;
+
+    CHECK_EQUAL(0, dev.init());
+    CHECK_EQUAL(0, dev.open());
+    CHECK_EQUAL(card_blocks, dev.block_count());
+    CHECK_EQUAL(0, dev.close());
+}
+
+TEST(host_sd, blocks_are_stored_in_image)
+{
+    sd dev;
+    uint8_t out[512 * 3];
+    uint8_t in[sizeof(out)];
+
+    for (size_t i = 0; i < sizeof(out); ++i) {
+        out[i] = i * 7 + i / 512;
+    }
+
+    dev.init();
+    CHECK_EQUAL(0, dev.open());
+    CHECK_EQUAL(0, dev.write_blocks(5, out, 3));
+    CHECK_EQUAL(0, dev.read_blocks(5, in, 3));
+    MEMCMP_EQUAL(out, in, sizeof(out));
+    CHECK_EQUAL(0, dev.close());
+
+    CHECK_EQUAL(3, card->stats().blocks_written);
+
+    // Written data is in the image itself
+    int fd = open(path, O_RDONLY);
+    CHECK_EQUAL(sizeof(in), pread(fd, in, sizeof(in), 5 * 512));
+    close(fd);
+
+    MEMCMP_EQUAL(out, in, sizeof(out));
+}
+
+TEST(host_sd, async_xfers_are_completed)
+{
+    sd dev;
+    uint8_t out[512 * 4];
+    uint8_t in[sizeof(out)];
+    int status = 1;
+
+    for (size_t i = 0; i < sizeof(out); ++i) {
+        out[i] = i * 3 + 1;
+    }
+
+    // Card is polled byte by byte, continuations must not nest
+    card->timing().program_ns = 200000;
+
+    dev.init();
+    CHECK_EQUAL(0, dev.open());
+
+    CHECK_EQUAL(0, dev.write_blocks_async(40, out, 4, [&status](int s) { status = s; }));
+    CHECK_EQUAL(0, status);
+
+    status = 1;
+    CHECK_EQUAL(0, dev.read_blocks_async(40, in, 4, [&status](int s) { status = s; }));
+    CHECK_EQUAL(0, status);
+    MEMCMP_EQUAL(out, in, sizeof(out));
+
+    CHECK_EQUAL(0, dev.close());
+}
+
+TEST(host_sd, reads_beyond_card_fail)
+{
+    sd dev;
+    uint8_t buf[512];
+
+    dev.init();
+    CHECK_EQUAL(0, dev.open());
+    CHECK_TRUE(dev.read_blocks(card_blocks, buf, 1) < 0);
+    CHECK_EQUAL(0, dev.close());
+}
+
+TEST(host_sd, offsets_beyond_4gib_are_addressed)
+{
+    // Image is sparse, only touched blocks take space
+    constexpr size_t big_blocks = 9 * 1024 * 1024;
+    constexpr int64_t offt = (int64_t{1} << 32) + 512 * 3 + 7;
+
+    ecl::host_sd_card big;
+    CHECK_TRUE(big.open(path, big_blocks) == ecl::err::ok);
+    spi_pbus::attach(&big);
+
+    sd dev;
+    uint8_t out[600];
+    uint8_t in[512 * 2];
+
+    for (size_t i = 0; i < sizeof(out); ++i) {
+        out[i] = i * 5 + 3;
+    }
+
+    dev.init();
+    CHECK_EQUAL(0, dev.open());
+    CHECK_EQUAL(big_blocks, dev.block_count());
+
+    CHECK_EQUAL(0, dev.seek(offt));
+    CHECK_EQUAL((ssize_t) sizeof(out), dev.write(out, sizeof(out)));
+    CHECK_TRUE(dev.tell() == offt + (int64_t) sizeof(out));
+    CHECK_EQUAL(0, dev.flush());
+
+    // Data lands in the block right after 4 GiB boundary
+    CHECK_EQUAL(0, dev.read_blocks(8 * 1024 * 1024 + 3, in, 2));
+    MEMCMP_EQUAL(out, in + 7, sizeof(out));
+
+    // Position can't go past the end of the card
+    CHECK_EQUAL(-1, dev.seek((int64_t) big_blocks * 512 + 1));
+    CHECK_EQUAL(0, dev.close());
+
+    spi_pbus::attach(card);
+}
+
+TEST(host_sd, latency_is_modeled)
+{
+    sd dev;
+    uint8_t buf[512];
+
+    dev.init();
+    CHECK_EQUAL(0, dev.open());
+
+    spi_pbus::latency().setup_ns = 1000;
+    card->timing().access_ns = 1000000;
+    spi_pbus::reset_elapsed();
+
+    CHECK_EQUAL(0, dev.read_blocks(0, buf, 1));
+
+    // Access time exceeds what card can report in bytes, rest is a stall.
+    // Block alone takes 512 bytes on the wire.
+    uint64_t wire = 512ULL * 8 * 1000000000ULL / spi_pbus::latency().clock;
+    CHECK_TRUE(spi_pbus::elapsed_ns() >= 1000000 + wire + 1000);
+
+    CHECK_EQUAL(0, dev.close());
+}
+
+TEST(host_sd, image_size_is_validated)
+{
+    ecl::host_sd_card other;
+
+    CHECK_TRUE(other.open(path, card_blocks + 1) == ecl::err::inval);
+    CHECK_TRUE(other.open("/nonexistent/image") == ecl::err::io);
+}
+
+//------------------------------------------------------------------------------
+
+TEST_GROUP(host_usart)
+{
+    int fds[2];
+
+    void setup()
+    {
+        CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        usart_pbus::attach(fds[0], fds[0]);
+        usart::init();
+    }
+
+    void teardown()
+    {
+        usart_pbus::attach(-1, -1);
+        close(fds[0]);
+        if (fds[1] >= 0) {
+            close(fds[1]);
+        }
+    }
+};
+
+TEST(host_usart, data_is_sent_and_received)
+{
+    const uint8_t ping[] = "ping";
+    uint8_t buf[sizeof(ping)] = {};
+    size_t sent = 0;
+    size_t received = 0;
+
+    usart::lock();
+    usart::set_buffers(ping, nullptr, sizeof(ping));
+    CHECK_TRUE(usart::xfer(&sent, &received) == ecl::err::ok);
+    CHECK_EQUAL(sizeof(ping), sent);
+
+    CHECK_EQUAL(sizeof(buf), read(fds[1], buf, sizeof(buf)));
+    MEMCMP_EQUAL(ping, buf, sizeof(ping));
+
+    const uint8_t pong[] = "pong";
+    CHECK_EQUAL(sizeof(pong), write(fds[1], pong, sizeof(pong)));
+
+    usart::set_buffers(nullptr, buf, sizeof(buf));
+    CHECK_TRUE(usart::xfer(&sent, &received) == ecl::err::ok);
+    CHECK_EQUAL(sizeof(pong), received);
+    MEMCMP_EQUAL(pong, buf, sizeof(pong));
+
+    usart::unlock();
+}
+
+TEST(host_usart, idle_line_ends_rx)
+{
+    uint8_t buf[16];
+    size_t received = 0;
+
+    CHECK_EQUAL(2, write(fds[1], "ok", 2));
+
+    usart::lock();
+    usart::platform_bus().set_rx_idle(true);
+    usart::set_buffers(nullptr, buf, sizeof(buf));
+    CHECK_TRUE(usart::xfer(nullptr, &received) == ecl::err::ok);
+    usart::platform_bus().set_rx_idle(false);
+    usart::unlock();
+
+    CHECK_EQUAL(2, received);
+    MEMCMP_EQUAL("ok", buf, 2);
+}
+
+TEST(host_usart, closed_line_is_an_error)
+{
+    uint8_t buf[4];
+
+    close(fds[1]);
+    fds[1] = -1;
+
+    usart::lock();
+    usart::set_buffers(nullptr, buf, sizeof(buf));
+    CHECK_TRUE(usart::xfer() != ecl::err::ok);
+    usart::unlock();
+}
+
+TEST(host_usart, wire_time_is_modeled)
+{
+    const uint8_t data[100] = {};
+    uint8_t buf[sizeof(data)];
+
+    usart_pbus::latency().clock = 115200;
+    usart_pbus::reset_elapsed();
+
+    usart::lock();
+    usart::set_buffers(data, nullptr, sizeof(data));
+    usart::xfer();
+    usart::unlock();
+
+    CHECK_EQUAL(sizeof(buf), read(fds[1], buf, sizeof(buf)));
+
+    // 8N1 frame is 10 bits long
+    CHECK_EQUAL(100ULL * 10 * 1000000000ULL / 115200, usart_pbus::elapsed_ns());
+
+    usart_pbus::latency().clock = 0;
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
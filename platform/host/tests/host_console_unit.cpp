@@ -0,0 +1,96 @@
+#include <platform/host_console.hpp>
+
+#include <cstring>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+TEST_GROUP(host_console)
+{
+    int in[2];
+    int out[2];
+
+    void setup()
+    {
+        CHECK_EQUAL(0, pipe(in));
+        CHECK_EQUAL(0, pipe(out));
+    }
+
+    void teardown()
+    {
+        for (int fd : {in[0], in[1], out[0], out[1]}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+};
+
+TEST(host_console, data_is_written_in_bulk)
+{
+    host_console console{in[0], out[1]};
+    std::vector< uint8_t > data(4000);
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = i;
+    }
+
+    CHECK_EQUAL(static_cast< ssize_t >(data.size()), console.write(data.data(), data.size()));
+
+    std::vector< uint8_t > got(data.size());
+    size_t done = 0;
+
+    while (done < got.size()) {
+        auto rc = ::read(out[0], got.data() + done, got.size() - done);
+        CHECK_TRUE(rc > 0);
+        done += rc;
+    }
+
+    CHECK_TRUE(data == got);
+}
+
+TEST(host_console, read_returns_available_data)
+{
+    host_console console{in[0], out[1]};
+    uint8_t buf[64];
+
+    CHECK_EQUAL(12, ::write(in[1], "first\nsecond", 12));
+
+    // Doesn't wait for the whole buffer to be filled
+    CHECK_EQUAL(12, console.read(buf, sizeof(buf)));
+    MEMCMP_EQUAL("first\nsecond", buf, 12);
+
+    ::close(in[1]);
+    in[1] = -1;
+
+    CHECK_EQUAL(-1, console.read(buf, sizeof(buf)));
+}
+
+TEST(host_console, try_read_never_blocks)
+{
+    host_console console{in[0], out[1]};
+    uint8_t buf[8];
+
+    CHECK_EQUAL(0, console.try_read(buf, sizeof(buf)));
+
+    CHECK_EQUAL(3, ::write(in[1], "abc", 3));
+
+    CHECK_EQUAL(3, console.try_read(buf, sizeof(buf)));
+    MEMCMP_EQUAL("abc", buf, 3);
+    CHECK_EQUAL(0, console.try_read(buf, sizeof(buf)));
+}
+
+TEST(host_console, raw_mode_requires_terminal)
+{
+    host_console console{in[0], out[1]};
+
+    CHECK_EQUAL(-1, console.set_raw(true));
+    CHECK_EQUAL(0, console.set_raw(false));
+    CHECK_EQUAL(0, console.close());
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,66 @@
+#include <platform/hw_random.hpp>
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+using rng = ecl::hw_random< 16 >;
+
+TEST_GROUP(host_random)
+{
+};
+
+TEST(host_random, words_are_distinct)
+{
+    rng gen;
+    std::set< uint32_t > seen;
+
+    rng::init();
+
+    for (int i = 0; i < 1000; ++i) {
+        seen.insert(gen());
+    }
+
+    // Collision of 1000 random words has a chance of about 1e-4
+    CHECK_TRUE(seen.size() >= 999);
+
+    uint32_t buf[40];
+    CHECK_EQUAL(40, rng::read(buf, 40));
+    CHECK_EQUAL(0, rng::failures());
+
+    rng::deinit();
+}
+
+TEST(host_random, works_with_standard_distributions)
+{
+    rng gen;
+    std::uniform_int_distribution< int > dice{1, 6};
+
+    int hist[7] = {};
+
+    for (int i = 0; i < 6000; ++i) {
+        ++hist[dice(gen)];
+    }
+
+    CHECK_EQUAL(0, hist[0]);
+
+    for (int k = 1; k <= 6; ++k) {
+        CHECK_TRUE(hist[k] > 800 && hist[k] < 1200);
+    }
+
+    int v[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    std::shuffle(v, v + 10, gen);
+    std::sort(v, v + 10);
+
+    for (int k = 0; k < 10; ++k) {
+        CHECK_EQUAL(k, v[k]);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,72 @@
+#include <platform/timebase.hpp>
+
+#include <chrono>
+#include <vector>
+
+#include <CppUTest/TestHarness.h>
+#include <CppUTest/CommandLineTestRunner.h>
+
+using ecl::timebase;
+
+TEST_GROUP(host_timebase)
+{
+    void setup()
+    {
+        timebase::init();
+    }
+
+    void teardown()
+    {
+        timebase::deinit();
+    }
+};
+
+TEST(host_timebase, delay_waits_at_least_given_time)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint32_t start_us = timebase::now_us();
+
+    timebase::delay_us(1500);
+
+    auto took = std::chrono::steady_clock::now() - start;
+
+    CHECK_TRUE(took >= std::chrono::microseconds(1500));
+    CHECK_TRUE(timebase::now_us() - start_us > 1500);
+}
+
+TEST(host_timebase, captured_events_are_timestamped)
+{
+    std::vector< uint32_t > stamps;
+
+    CHECK_EQUAL(ecl::err::again, timebase::trigger(1));
+    CHECK_EQUAL(ecl::err::ok, timebase::capture(1, ecl::capture_edge::rising,
+                                                [&](uint32_t ts) { stamps.push_back(ts); }));
+
+    uint32_t before = timebase::now_us();
+    CHECK_EQUAL(ecl::err::ok, timebase::trigger(1));
+    timebase::delay_us(100);
+    CHECK_EQUAL(ecl::err::ok, timebase::trigger(1));
+
+    CHECK_EQUAL(2, stamps.size());
+    CHECK_TRUE(stamps[0] - before < 100);
+    CHECK_TRUE(stamps[1] - stamps[0] > 100);
+
+    timebase::stop_capture(1);
+    CHECK_EQUAL(ecl::err::again, timebase::trigger(1));
+    CHECK_EQUAL(2, stamps.size());
+}
+
+TEST(host_timebase, invalid_channels_are_rejected)
+{
+    auto h = [](uint32_t) { };
+
+    CHECK_EQUAL(ecl::err::inval, timebase::capture(0, ecl::capture_edge::both, h));
+    CHECK_EQUAL(ecl::err::inval, timebase::capture(5, ecl::capture_edge::both, h));
+    CHECK_EQUAL(ecl::err::inval, timebase::capture(1, ecl::capture_edge::both, h, 16));
+    CHECK_EQUAL(ecl::err::inval, timebase::trigger(5));
+}
+
+int main(int argc, char *argv[])
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,193 @@
+/*
+ * Clock tree configuration, shared by SystemInit() and platform code.
+ * Every parameter can be overridden from the project, see
+ * CMSIS/CMakeLists.txt. Resulting frequencies are plain constant
+ * expressions, thus are used by bus drivers at compile time.
+ */
+#ifndef STM32F4XX_RCC_CONFIG_H_
+#define STM32F4XX_RCC_CONFIG_H_
+
+#if defined (STM32F411xE)
+/*!< Uncomment the following line if you need to clock the STM32F411xE by HSE Bypass
+     through STLINK MCO pin of STM32F103 microcontroller. The frequency cannot be changed
+     and is fixed at 8 MHz.
+     Hardware configuration needed for Nucleo Board:
+      SB54, SB55 OFF
+      R35 removed
+      SB16, SB50 ON */
+/* #define USE_HSE_BYPASS */
+
+#if defined (USE_HSE_BYPASS)
+#define HSE_BYPASS_INPUT_FREQUENCY   8000000
+#endif /* USE_HSE_BYPASS */
+#endif /* STM32F411xE */
+
+#define HSI_CLOCK_SOURCE 1
+#define HSE_CLOCK_SOURCE 2
+#define PLL_CLOCK_SOURCE 3
+
+#ifndef RCC_SYSCLK_SRC
+#define RCC_SYSCLK_SRC PLL_CLOCK_SOURCE
+#endif
+
+#if (RCC_SYSCLK_SRC != HSI_CLOCK_SOURCE) && \
+		(RCC_SYSCLK_SRC != HSE_CLOCK_SOURCE) && \
+		(RCC_SYSCLK_SRC != PLL_CLOCK_SOURCE)
+#error Invalid sysclk source
+#endif
+
+#if (RCC_SYSCLK_SRC == PLL_CLOCK_SOURCE)
+#ifndef RCC_PLL_SRC
+#if defined (STM32F411xE) && !defined (USE_HSE_BYPASS)
+#define RCC_PLL_SRC HSI_CLOCK_SOURCE
+#else
+#define RCC_PLL_SRC HSE_CLOCK_SOURCE
+#endif
+#endif
+
+#if (RCC_PLL_SRC != HSI_CLOCK_SOURCE) && (RCC_PLL_SRC != HSE_CLOCK_SOURCE)
+#error Invalid pll source
+#endif
+
+#endif /* RCC_SYSCLK_SRC == PLL_CLOCK_SOURCE */
+
+/************************* PLL Parameters *************************************/
+/* PLL_VCO = (HSE_VALUE or HSI_VALUE / PLL_M) * PLL_N */
+#ifndef RCC_PLL_M
+#if defined (STM32F40_41xxx) || defined (STM32F427_437xx) || defined (STM32F429_439xx) || defined (STM32F401xx)
+#define RCC_PLL_M      8
+#else /* STM32F411xE */
+#if defined (USE_HSE_BYPASS)
+#define RCC_PLL_M      8
+#else /* STM32F411xE */
+#define RCC_PLL_M      16
+#endif /* USE_HSE_BYPASS */
+#endif /* STM32F40_41xxx || STM32F427_437xx || STM32F429_439xx || STM32F401xx */
+#endif /* RCC_PLL_M */
+
+/* USB OTG FS, SDIO and RNG Clock =  PLL_VCO / PLLQ */
+#ifndef RCC_PLL_Q
+#define RCC_PLL_Q      7
+#endif /* RCC_PLL_Q */
+
+#ifndef RCC_PLL_N
+#if defined (STM32F40_41xxx) || defined (STM32F401xx)
+#define RCC_PLL_N      336
+#endif /* STM32F40_41xxx || STM32F401xx */
+
+#if defined (STM32F427_437xx) || defined (STM32F429_439xx)
+#define RCC_PLL_N      360
+#endif /* STM32F427_437x || STM32F429_439xx */
+
+#if defined (STM32F411xE)
+#define RCC_PLL_N      400
+#endif /* STM32F411xx */
+#endif /* RCC_PLL_N */
+
+#ifndef RCC_PLL_P
+#if defined (STM32F40_41xxx) || defined (STM32F427_437xx) || defined (STM32F429_439xx)
+#define RCC_PLL_P      2
+#endif /* STM32F40_41xxx || STM32F427_437x || STM32F429_439xx */
+
+#if defined (STM32F401xx) || defined (STM32F411xE)
+#define RCC_PLL_P      4
+#endif /* STM32F401xx || STM32F411xE */
+#endif /* RCC_PLL_P */
+
+/************************* Bus limits *****************************************/
+/* Maximum frequencies of AHB, APB1 and APB2, see datasheet of the device */
+#if defined (STM32F40_41xxx)
+#define RCC_HCLK_MAX        168000000
+#define RCC_PCLK1_MAX       42000000
+#define RCC_PCLK2_MAX       84000000
+#elif defined (STM32F427_437xx) || defined (STM32F429_439xx)
+#define RCC_HCLK_MAX        180000000
+#define RCC_PCLK1_MAX       45000000
+#define RCC_PCLK2_MAX       90000000
+#elif defined (STM32F401xx)
+#define RCC_HCLK_MAX        84000000
+#define RCC_PCLK1_MAX       42000000
+#define RCC_PCLK2_MAX       84000000
+#else /* STM32F411xE */
+#define RCC_HCLK_MAX        100000000
+#define RCC_PCLK1_MAX       50000000
+#define RCC_PCLK2_MAX       100000000
+#endif
+
+/************************* Resulting frequencies ******************************/
+#define RCC_HSI_FREQ        16000000
+
+#if defined (USE_HSE_BYPASS)
+#define RCC_HSE_FREQ        HSE_BYPASS_INPUT_FREQUENCY
+#else
+#define RCC_HSE_FREQ        HSE_VALUE
+#endif
+
+#if (RCC_SYSCLK_SRC == HSI_CLOCK_SOURCE)
+#define RCC_SYSCLK_FREQ     RCC_HSI_FREQ
+#elif (RCC_SYSCLK_SRC == HSE_CLOCK_SOURCE)
+#define RCC_SYSCLK_FREQ     RCC_HSE_FREQ
+#else
+#if (RCC_PLL_SRC == HSI_CLOCK_SOURCE)
+#define RCC_PLL_IN_FREQ     RCC_HSI_FREQ
+#else
+#define RCC_PLL_IN_FREQ     RCC_HSE_FREQ
+#endif
+#define RCC_PLL_VCO_FREQ    (RCC_PLL_IN_FREQ / RCC_PLL_M * RCC_PLL_N)
+#define RCC_SYSCLK_FREQ     (RCC_PLL_VCO_FREQ / RCC_PLL_P)
+#endif
+
+/* AHB runs at sysclk, unless prescaler is given */
+#ifndef RCC_HCLK_DIV
+#define RCC_HCLK_DIV        1
+#endif
+
+#define RCC_HCLK_FREQ       (RCC_SYSCLK_FREQ / RCC_HCLK_DIV)
+
+/* Picks the smallest APB prescaler that keeps the bus within its limit */
+#define RCC_PCLK_DIV(max) \
+	(RCC_HCLK_FREQ <= (max) ? 1 : \
+	 RCC_HCLK_FREQ <= (max) * 2 ? 2 : \
+	 RCC_HCLK_FREQ <= (max) * 4 ? 4 : \
+	 RCC_HCLK_FREQ <= (max) * 8 ? 8 : 16)
+
+#ifndef RCC_PCLK1_DIV
+#define RCC_PCLK1_DIV       RCC_PCLK_DIV(RCC_PCLK1_MAX)
+#endif
+
+#ifndef RCC_PCLK2_DIV
+#define RCC_PCLK2_DIV       RCC_PCLK_DIV(RCC_PCLK2_MAX)
+#endif
+
+#define RCC_PCLK1_FREQ      (RCC_HCLK_FREQ / RCC_PCLK1_DIV)
+#define RCC_PCLK2_FREQ      (RCC_HCLK_FREQ / RCC_PCLK2_DIV)
+
+/************************* Flash interface ************************************/
+/* Wait states for 2.7 - 3.6 V supply: one per each 30 MHz of HCLK.
+ * See RM0090, section 3.5.1 'Relation between CPU clock frequency
+ * and Flash memory read time'.
+ */
+#ifndef RCC_FLASH_LATENCY
+#define RCC_FLASH_LATENCY   ((RCC_HCLK_FREQ - 1) / 30000000)
+#endif
+
+/* ART accelerator: prefetch buffer, instruction and data caches */
+#ifndef RCC_FLASH_PREFETCH
+#define RCC_FLASH_PREFETCH  1
+#endif
+
+#ifndef RCC_FLASH_ICACHE
+#define RCC_FLASH_ICACHE    1
+#endif
+
+#ifndef RCC_FLASH_DCACHE
+#define RCC_FLASH_DCACHE    1
+#endif
+
+#define RCC_FLASH_ACR \
+	((RCC_FLASH_LATENCY) \
+	 | (RCC_FLASH_PREFETCH ? FLASH_ACR_PRFTEN : 0) \
+	 | (RCC_FLASH_ICACHE ? FLASH_ACR_ICEN : 0) \
+	 | (RCC_FLASH_DCACHE ? FLASH_ACR_DCEN : 0))
+
+#endif /* STM32F4XX_RCC_CONFIG_H_ */
@@ -260,6 +260,7 @@
   */
 
 #include "stm32f4xx.h"
+#include "rcc_config.h"
 
 /**
   * @}
@@ -288,46 +289,6 @@
 /* #define DATA_IN_ExtSDRAM */
 #endif /* STM32F427_437x || STM32F429_439xx */
 
-#if defined (STM32F411xE)
-/*!< Uncomment the following line if you need to clock the STM32F411xE by HSE Bypass
-     through STLINK MCO pin of STM32F103 microcontroller. The frequency cannot be changed
-     and is fixed at 8 MHz.
-     Hardware configuration needed for Nucleo Board:
-      SB54, SB55 OFF
-      R35 removed
-      SB16, SB50 ON */
-/* #define USE_HSE_BYPASS */
-
-#if defined (USE_HSE_BYPASS)
-#define HSE_BYPASS_INPUT_FREQUENCY   8000000
-#endif /* USE_HSE_BYPASS */
-#endif /* STM32F411xE */
-
-#define HSI_CLOCK_SOURCE 1
-#define HSE_CLOCK_SOURCE 2
-#define PLL_CLOCK_SOURCE 3
-
-#ifndef RCC_SYSCLK_SRC
-#define RCC_SYSCLK_SRC PLL_CLOCK_SOURCE
-#endif
-
-#if (RCC_SYSCLK_SRC != HSI_CLOCK_SOURCE) && \
-		(RCC_SYSCLK_SRC != HSE_CLOCK_SOURCE) && \
-		(RCC_SYSCLK_SRC != PLL_CLOCK_SOURCE)
-#error Invalid sysclk source
-#endif
-
-#if (RCC_SYSCLK_SRC == PLL_CLOCK_SOURCE)
-#ifndef RCC_PLL_SRC
-#define RCC_PLL_SRC HSE_CLOCK_SOURCE
-#endif
-
-#if (RCC_PLL_SRC != HSI_CLOCK_SOURCE) && (RCC_PLL_SRC != HSE_CLOCK_SOURCE)
-#error Invalid pll source
-#endif
-
-#endif /* RCC_SYSCLK_SRC == PLL_CLOCK_SOURCE */
-
 /*!< Uncomment the following line if you need to relocate your vector Table in
      Internal SRAM. */
 /* #define VECT_TAB_SRAM */
@@ -336,69 +297,11 @@
 /******************************************************************************/
 
 /************************* PLL Parameters *************************************/
-#ifndef RCC_PLL_M
-#if defined (STM32F40_41xxx) || defined (STM32F427_437xx) || defined (STM32F429_439xx) || defined (STM32F401xx)
-/* PLL_VCO = (HSE_VALUE or HSI_VALUE / PLL_M) * PLL_N */
-#define PLL_M      8
-#else /* STM32F411xE */
-#if defined (USE_HSE_BYPASS)
-#define PLL_M      8
-#else /* STM32F411xE */
-#define PLL_M      16
-#endif /* USE_HSE_BYPASS */
-#endif /* STM32F40_41xxx || STM32F427_437xx || STM32F429_439xx || STM32F401xx */
-#else
-#define PLL_M RCC_PLL_M
-#endif /* RCC_PLL_M */
-
-#ifndef RCC_PLL_Q
-/* USB OTG FS, SDIO and RNG Clock =  PLL_VCO / PLLQ */
-#define PLL_Q      7
-#else
-#define PLL_Q RCC_PLL_Q
-#endif /* RCC_PLL_Q */
-
-#ifndef RCC_PLL_N
-#if defined (STM32F40_41xxx)
-#define PLL_N      64
-#endif /* STM32F40_41xxx */
-
-#if defined (STM32F427_437xx) || defined (STM32F429_439xx)
-#define PLL_N      360
-#endif /* STM32F427_437x || STM32F429_439xx */
-
-#if defined (STM32F401xx)
-#define PLL_N      336
-#endif /* STM32F401xx */
-
-#if defined (STM32F411xE)
-#define PLL_N      400
-#endif /* STM32F411xx */
-
-#else
-#define PLL_N RCC_PLL_N
-#endif /* RCC_PLL_N */
-
-#ifndef RCC_PLL_P
-#if defined (STM32F40_41xxx)
-#define PLL_P      8
-#endif /* STM32F40_41xxx */
-
-#if defined (STM32F427_437xx) || defined (STM32F429_439xx)
-#define PLL_P      2
-#endif /* STM32F427_437x || STM32F429_439xx */
-
-#if defined (STM32F401xx)
-#define PLL_P      4
-#endif /* STM32F401xx */
-
-#if defined (STM32F411xE)
-#define PLL_P      4
-#endif /* STM32F411xE */
-
-#else
-#define PLL_P RCC_PLL_P
-#endif /* RCC_PLL_P */
+/* Defaults and overrides are resolved in rcc_config.h */
+#define PLL_M      RCC_PLL_M
+#define PLL_N      RCC_PLL_N
+#define PLL_P      RCC_PLL_P
+#define PLL_Q      RCC_PLL_Q
 
 /******************************************************************************/
 
@@ -418,21 +321,7 @@
   * @{
   */
 
-#if defined (STM32F40_41xxx)
-  uint32_t SystemCoreClock = 168000000;
-#endif /* STM32F40_41xxx */
-
-#if defined (STM32F427_437xx) || defined (STM32F429_439xx)
-  uint32_t SystemCoreClock = 180000000;
-#endif /* STM32F427_437x || STM32F429_439xx */
-
-#if defined (STM32F401xx)
-  uint32_t SystemCoreClock = 84000000;
-#endif /* STM32F401xx */
-
-#if defined (STM32F411xE)
-  uint32_t SystemCoreClock = 100000000;
-#endif /* STM32F401xx */
+  uint32_t SystemCoreClock = RCC_HCLK_FREQ;
 
 __I uint8_t AHBPrescTable[16] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 6, 7, 8, 9};
 
@@ -684,41 +573,22 @@ static void SetSysClock(void)
 	(void) StartUpCounter;
 	(void) SourceStatus;
 
-#ifdef RCC_HCLK_DIV
-#if !((RCC_HCLK_DIV - 1) & RCC_HCLK_DIV)
-	uint32_t hclk_prescaler = get_HCLK_prescaler(RCC_HCLK_DIV);
-	RCC->CFGR |= hclk_prescaler;
-#else
-#error Invalid RCC_HCLK_DIV is provided (should be power of 2)
-#endif /* !((RCC_HCLK_DIV - 1) & RCC_HCLK_DIV) */
-#else
-	/* HCLK = SYSCLK / 1*/
-	RCC->CFGR |= RCC_CFGR_HPRE_DIV1;
-#endif /* RCC_HCLK_DIV */
+	/* Prescalers are validated at compile time, see platform/clock.hpp */
+	RCC->CFGR |= get_HCLK_prescaler(RCC_HCLK_DIV);
+	RCC->CFGR |= get_PCLK1_prescaler(RCC_PCLK1_DIV);
+	RCC->CFGR |= get_PCLK2_prescaler(RCC_PCLK2_DIV);
 
-#ifdef RCC_PCLK1_DIV
-#if !((RCC_PCLK1_DIV - 1) & RCC_PCLK1_DIV)
-	uint32_t pclk1_prescaler = get_PCLK1_prescaler(RCC_PCLK1_DIV);
-	RCC->CFGR |= pclk1_prescaler;
-#else
-#error Invalid RCC_PCLK1_DIV is provided (should be power of 2)
-#endif /* !((RCC_PCLK1_DIV - 1) & RCC_PCLK1_DIV) */
-#else
-	/* PCLK1 = HCLK / 2 */
-	RCC->CFGR |= RCC_CFGR_PPRE1_DIV2;
-#endif /* RCC_PCLK1_DIV */
-
-#ifdef RCC_PCLK2_DIV
-#if !((RCC_PCLK2_DIV - 1) & RCC_PCLK2_DIV)
-	uint32_t pclk2_prescaler = get_PCLK2_prescaler(RCC_PCLK2_DIV);
-	RCC->CFGR |= pclk2_prescaler;
-#else
-#error Invalid RCC_PCLK2_DIV is provided (should be power of 2)
-#endif /* !((RCC_PCLK2_DIV - 1) & RCC_PCLK2_DIV) */
-#else
-	/* PCLK2 = HCLK / 1 */
-	RCC->CFGR |= RCC_CFGR_PPRE2_DIV1;
-#endif /* RCC_PCLK2_DIV */
+	/* Select regulator voltage output Scale 1 mode.
+	 * Scale can be changed only while PLL is off.
+	 */
+	RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+	PWR->CR |= PWR_CR_VOS;
+
+	/* Wait states must be set before clock goes up.
+	 * Extra wait states are harmless at reset clock.
+	 */
+	FLASH->ACR = RCC_FLASH_ACR;
+	while ((FLASH->ACR & FLASH_ACR_LATENCY) != RCC_FLASH_LATENCY);
 
 #if (RCC_SYSCLK_SRC == HSI_CLOCK_SOURCE || RCC_PLL_SRC == HSI_CLOCK_SOURCE)
 	/* Enable HSI */
@@ -771,38 +641,22 @@ static void SetSysClock(void)
 	/* Wait till the main PLL is ready */
 	while(!(RCC->CR & RCC_CR_PLLRDY));
 
-	/* Select the main PLL as system clock source */
-	RCC->CFGR &= (uint32_t)((uint32_t)~(RCC_CFGR_SW));
-	RCC->CFGR |= RCC_CFGR_SW_PLL;
-
-	/* Wait till the main PLL is used as system clock source */
-	while ((RCC->CFGR & (uint32_t)RCC_CFGR_SWS ) != RCC_CFGR_SWS_PLL);
-
-#endif
-	/* Select regulator voltage output Scale 1 mode */
-	RCC->APB1ENR |= RCC_APB1ENR_PWREN;
-	PWR->CR |= PWR_CR_VOS;
-
 #if defined (STM32F427_437xx) || defined (STM32F429_439xx)
 	/* Enable the Over-drive to extend the clock frequency to 180 Mhz */
 	PWR->CR |= PWR_CR_ODEN;
 	while((PWR->CSR & PWR_CSR_ODRDY) == 0);
 	PWR->CR |= PWR_CR_ODSWEN;
 	while((PWR->CSR & PWR_CSR_ODSWRDY) == 0);
-	/* Configure Flash prefetch, Instruction cache, Data cache and wait state */
-	FLASH->ACR = FLASH_ACR_PRFTEN | FLASH_ACR_ICEN |FLASH_ACR_DCEN |FLASH_ACR_LATENCY_5WS;
 #endif /* STM32F427_437x || STM32F429_439xx  */
 
-#if defined (STM32F40_41xxx)
-	/* Configure Flash prefetch, Instruction cache, Data cache and wait state */
-	FLASH->ACR = FLASH_ACR_PRFTEN | FLASH_ACR_ICEN |FLASH_ACR_DCEN |FLASH_ACR_LATENCY_5WS;
-#endif /* STM32F40_41xxx  */
+	/* Select the main PLL as system clock source */
+	RCC->CFGR &= (uint32_t)((uint32_t)~(RCC_CFGR_SW));
+	RCC->CFGR |= RCC_CFGR_SW_PLL;
 
-#if defined (STM32F401xx)
-	/* Configure Flash prefetch, Instruction cache, Data cache and wait state */
-	FLASH->ACR = FLASH_ACR_PRFTEN | FLASH_ACR_ICEN |FLASH_ACR_DCEN |FLASH_ACR_LATENCY_2WS;
-#endif /* STM32F401xx */
+	/* Wait till the main PLL is used as system clock source */
+	while ((RCC->CFGR & (uint32_t)RCC_CFGR_SWS ) != RCC_CFGR_SWS_PLL);
 
+#endif
 #elif defined (STM32F411xE)
 #if defined (USE_HSE_BYPASS)
 /******************************************************************************/
@@ -833,11 +687,9 @@ static void SetSysClock(void)
 		/* HCLK = SYSCLK / 1*/
 		RCC->CFGR |= RCC_CFGR_HPRE_DIV1;
 
-		/* PCLK2 = HCLK / 2*/
-		RCC->CFGR |= RCC_CFGR_PPRE2_DIV2;
-
-		/* PCLK1 = HCLK / 4*/
-		RCC->CFGR |= RCC_CFGR_PPRE1_DIV4;
+		/* APB prescalers, see rcc_config.h */
+		RCC->CFGR |= get_PCLK2_prescaler(RCC_PCLK2_DIV);
+		RCC->CFGR |= get_PCLK1_prescaler(RCC_PCLK1_DIV);
 
 		/* Configure the main PLL */
 		RCC->PLLCFGR = PLL_M | (PLL_N << 6) | (((PLL_P >> 1) -1) << 16) |
@@ -850,7 +702,7 @@ static void SetSysClock(void)
 		while((RCC->CR & RCC_CR_PLLRDY) == 0) {}
 
 		/* Configure Flash prefetch, Instruction cache, Data cache and wait state */
-		FLASH->ACR = FLASH_ACR_PRFTEN | FLASH_ACR_ICEN |FLASH_ACR_DCEN |FLASH_ACR_LATENCY_2WS;
+		FLASH->ACR = RCC_FLASH_ACR;
 
 		/* Select the main PLL as system clock source */
 		RCC->CFGR &= (uint32_t)((uint32_t)~(RCC_CFGR_SW));
@@ -869,11 +721,9 @@ static void SetSysClock(void)
 	/* HCLK = SYSCLK / 1*/
 	RCC->CFGR |= RCC_CFGR_HPRE_DIV1;
 
-	/* PCLK2 = HCLK / 1*/
-	RCC->CFGR |= RCC_CFGR_PPRE2_DIV1;
-
-	/* PCLK1 = HCLK / 2*/
-	RCC->CFGR |= RCC_CFGR_PPRE1_DIV2;
+	/* APB prescalers, see rcc_config.h */
+	RCC->CFGR |= get_PCLK2_prescaler(RCC_PCLK2_DIV);
+	RCC->CFGR |= get_PCLK1_prescaler(RCC_PCLK1_DIV);
 
 	/* Configure the main PLL */
 	RCC->PLLCFGR = PLL_M | (PLL_N << 6) | (((PLL_P >> 1) -1) << 16) | (PLL_Q << 24);
@@ -885,7 +735,7 @@ static void SetSysClock(void)
 	while((RCC->CR & RCC_CR_PLLRDY) == 0);
 
 	/* Configure Flash prefetch, Instruction cache, Data cache and wait state */
-	FLASH->ACR = FLASH_ACR_PRFTEN | FLASH_ACR_ICEN |FLASH_ACR_DCEN |FLASH_ACR_LATENCY_2WS;
+	FLASH->ACR = RCC_FLASH_ACR;
 
 	/* Select the main PLL as system clock source */
 	RCC->CFGR &= (uint32_t)((uint32_t)~(RCC_CFGR_SW));
@@ -0,0 +1,247 @@
+// Bandwidth and latency of STM32F4 memories, to decide where DMA buffers,
+// pools and stacks go. SRAM1, SRAM2 and CCM hold a 4 KiB data block and
+// a 1 KiB chain each, flash holds constant ones. For every memory:
+//
+//  - <mem>_read and <mem>_write are word loads and stores over the block,
+//    KiB/s is the bandwidth;
+//  - <mem>_copy is memcpy() of the block into SRAM1;
+//  - <mem>_chase is 256 dependent loads, each one 148 bytes past the
+//    previous, so cycles divided by 256 is the latency of a single load;
+//  - *_dma variants run while DMA2 copies between two SRAM1 buffers,
+//    showing how much the bus matrix slows the CPU down. If the stream
+//    is leased by other driver, the copy is done by CPU beforehand and
+//    the variant equals the plain one;
+//  - flash_*_noart variants run with ART caches and prefetch disabled,
+//    code is fetched from flash without them as well.
+
+#include <platform/clock.hpp>
+#include <platform/dma_memcpy.hpp>
+#include <platform/memory.hpp>
+
+#include <ecl/bench.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+
+using ecl::bench::clock;
+
+constexpr size_t block_words    = 1024;
+constexpr size_t chain_words    = 256;
+constexpr size_t chain_stride   = 37;
+constexpr size_t dma_bytes      = 16384;
+
+constexpr ecl::bench::options mem_options = { 3, 15, 10 };
+
+//! Chain of indexes, each element points to the next one to load.
+struct chain
+{
+    constexpr chain() :next{}
+    {
+        for (size_t i = 0; i < chain_words; ++i) {
+            next[i] = (i + chain_stride) % chain_words;
+        }
+    }
+
+    uint32_t next[chain_words];
+};
+
+// Flash contents must not be known to the optimizer, otherwise loops
+// over constant data are folded. See hide().
+constexpr chain flash_chain{};
+const uint32_t flash_block[block_words] = { 1, 2, 3, 4 };
+
+PLATFORM_DMA_RAM uint32_t sram1_block[block_words];
+PLATFORM_DMA_RAM uint32_t sram1_chain[chain_words];
+PLATFORM_SRAM2_RAM uint32_t sram2_block[block_words];
+PLATFORM_SRAM2_RAM uint32_t sram2_chain[chain_words];
+PLATFORM_CCM_RAM uint32_t ccm_block[block_words];
+PLATFORM_CCM_RAM uint32_t ccm_chain[chain_words];
+
+// Destination of copies
+PLATFORM_DMA_RAM uint32_t sink[block_words];
+
+// Background DMA traffic, long enough to outlast a sample
+PLATFORM_DMA_RAM uint8_t dma_src[dma_bytes];
+PLATFORM_DMA_RAM uint8_t dma_dst[dma_bytes];
+
+using dma_copy = ecl::dma::memcpy_service< DMA2_Stream0_BASE >;
+
+volatile bool dma_done;
+
+// RAM chains are laid out as the one in flash
+struct prefill
+{
+    prefill()
+    {
+        std::memcpy(sram1_chain, flash_chain.next, sizeof(sram1_chain));
+        std::memcpy(sram2_chain, flash_chain.next, sizeof(sram2_chain));
+        std::memcpy(ccm_chain, flash_chain.next, sizeof(ccm_chain));
+    }
+} prefilled;
+
+//! Hides value of a pointer from the optimizer.
+template< class T >
+T *hide(T *p)
+{
+    asm volatile("" : "+r"(p));
+    return p;
+}
+
+void read_block(const uint32_t *block)
+{
+    auto p = hide(block);
+    uint32_t sum = 0;
+
+    for (size_t i = 0; i < block_words; ++i) {
+        sum += p[i];
+    }
+
+    ecl::bench::do_not_optimize(sum);
+}
+
+void write_block(uint32_t *block)
+{
+    auto p = hide(block);
+
+    for (size_t i = 0; i < block_words; ++i) {
+        p[i] = i;
+    }
+
+    ecl::bench::do_not_optimize(p);
+}
+
+void copy_block(const uint32_t *block)
+{
+    std::memcpy(hide(sink), hide(block), sizeof(sink));
+    ecl::bench::do_not_optimize(sink);
+}
+
+void chase(const uint32_t *next)
+{
+    auto p = hide(next);
+    uint32_t i = 0;
+
+    for (size_t n = 0; n < chain_words; ++n) {
+        i = p[i];
+    }
+
+    ecl::bench::do_not_optimize(i);
+}
+
+//! Measures function while DMA copies within SRAM1.
+template< class Fn >
+clock::rep under_dma(Fn fn)
+{
+    dma_done = false;
+    dma_copy::copy(dma_dst, dma_src, dma_bytes, [](ecl::err) { dma_done = true; });
+
+    auto start = clock::now();
+    fn();
+    auto spent = clock::now() - start;
+
+    while (!dma_done) { }
+
+    return spent;
+}
+
+//! Measures function with ART disabled.
+template< class Fn >
+clock::rep without_art(Fn fn)
+{
+    ecl::clock::set_flash_caches(false);
+    ecl::clock::set_flash_prefetch(false);
+
+    auto start = clock::now();
+    fn();
+    auto spent = clock::now() - start;
+
+    ecl::clock::set_flash_prefetch(true);
+    ecl::clock::set_flash_caches(true);
+
+    return spent;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+
+ECL_BENCH_BYTES(sram1_read, mem_options, sizeof(sram1_block)) { read_block(sram1_block); }
+ECL_BENCH_BYTES(sram1_write, mem_options, sizeof(sram1_block)) { write_block(sram1_block); }
+ECL_BENCH_BYTES(sram1_copy, mem_options, sizeof(sram1_block)) { copy_block(sram1_block); }
+ECL_BENCH_OPTS(sram1_chase, mem_options) { chase(sram1_chain); }
+
+ECL_BENCH_BYTES(sram2_read, mem_options, sizeof(sram2_block)) { read_block(sram2_block); }
+ECL_BENCH_BYTES(sram2_write, mem_options, sizeof(sram2_block)) { write_block(sram2_block); }
+ECL_BENCH_BYTES(sram2_copy, mem_options, sizeof(sram2_block)) { copy_block(sram2_block); }
+ECL_BENCH_OPTS(sram2_chase, mem_options) { chase(sram2_chain); }
+
+ECL_BENCH_BYTES(ccm_read, mem_options, sizeof(ccm_block)) { read_block(ccm_block); }
+ECL_BENCH_BYTES(ccm_write, mem_options, sizeof(ccm_block)) { write_block(ccm_block); }
+ECL_BENCH_BYTES(ccm_copy, mem_options, sizeof(ccm_block)) { copy_block(ccm_block); }
+ECL_BENCH_OPTS(ccm_chase, mem_options) { chase(ccm_chain); }
+
+ECL_BENCH_BYTES(flash_read, mem_options, sizeof(flash_block)) { read_block(flash_block); }
+ECL_BENCH_BYTES(flash_copy, mem_options, sizeof(flash_block)) { copy_block(flash_block); }
+ECL_BENCH_OPTS(flash_chase, mem_options) { chase(flash_chain.next); }
+
+//------------------------------------------------------------------------------
+
+ECL_BENCH_MANUAL_BYTES(sram1_read_dma, mem_options, sizeof(sram1_block))
+{
+    return under_dma([] { read_block(sram1_block); });
+}
+
+ECL_BENCH_MANUAL_BYTES(sram1_write_dma, mem_options, sizeof(sram1_block))
+{
+    return under_dma([] { write_block(sram1_block); });
+}
+
+ECL_BENCH_MANUAL(sram1_chase_dma, mem_options)
+{
+    return under_dma([] { chase(sram1_chain); });
+}
+
+ECL_BENCH_MANUAL_BYTES(sram2_read_dma, mem_options, sizeof(sram2_block))
+{
+    return under_dma([] { read_block(sram2_block); });
+}
+
+ECL_BENCH_MANUAL_BYTES(sram2_write_dma, mem_options, sizeof(sram2_block))
+{
+    return under_dma([] { write_block(sram2_block); });
+}
+
+ECL_BENCH_MANUAL(sram2_chase_dma, mem_options)
+{
+    return under_dma([] { chase(sram2_chain); });
+}
+
+ECL_BENCH_MANUAL_BYTES(ccm_read_dma, mem_options, sizeof(ccm_block))
+{
+    return under_dma([] { read_block(ccm_block); });
+}
+
+ECL_BENCH_MANUAL_BYTES(flash_read_dma, mem_options, sizeof(flash_block))
+{
+    return under_dma([] { read_block(flash_block); });
+}
+
+//------------------------------------------------------------------------------
+
+ECL_BENCH_MANUAL_BYTES(flash_read_noart, mem_options, sizeof(flash_block))
+{
+    return without_art([] { read_block(flash_block); });
+}
+
+ECL_BENCH_MANUAL_BYTES(flash_copy_noart, mem_options, sizeof(flash_block))
+{
+    return without_art([] { copy_block(flash_block); });
+}
+
+ECL_BENCH_MANUAL(flash_chase_noart, mem_options)
+{
+    return without_art([] { chase(flash_chain.next); });
+}
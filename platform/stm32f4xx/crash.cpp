@@ -0,0 +1,162 @@
+#include <platform/crash.hpp>
+
+#include <stm32f4xx.h>
+#include <core_cm4.h>
+
+#include <cstring>
+
+// Fault handlers, see start.s, and crash record, kept in RAM over resets.
+
+extern "C"
+{
+
+// Memory regions, defined by linker script
+extern uint32_t ___ram_origin;
+extern uint32_t ___ram_limit;
+extern uint32_t ___ccm_origin;
+extern uint32_t ___ccm_limit;
+
+}
+
+namespace
+{
+
+// Record of a crash, counter is valid as well
+constexpr uint32_t crash_magic = 0x43525348; // "CRSH"
+// Counter is valid, but there is no record
+constexpr uint32_t clear_magic = 0x434c5252; // "CLRR"
+
+__attribute__((section(".noinit")))
+ecl::crash_record record;
+
+uint32_t checksum(const ecl::crash_record &rec)
+{
+    auto words = reinterpret_cast< const uint32_t * >(&rec);
+    uint32_t sum = 0;
+
+    for (size_t i = 0; i < offsetof(ecl::crash_record, check) / 4; ++i) {
+        sum = (sum << 1 | sum >> 31) + words[i];
+    }
+
+    return ~sum;
+}
+
+bool counter_valid()
+{
+    return (record.magic == crash_magic || record.magic == clear_magic)
+            && record.check == checksum(record);
+}
+
+// Faults while reading the broken stack would lock the core up
+bool in_ram(const uint32_t *p, size_t words)
+{
+    auto addr = reinterpret_cast< uintptr_t >(p);
+    auto within = [addr, words](const uint32_t *start, const uint32_t *end) {
+        auto from = reinterpret_cast< uintptr_t >(start);
+        auto to = reinterpret_cast< uintptr_t >(end);
+
+        return addr >= from && addr <= to && (to - addr) / 4 >= words;
+    };
+
+    return within(&___ram_origin, &___ram_limit) || within(&___ccm_origin, &___ccm_limit);
+}
+
+} // namespace
+
+extern "C"
+{
+
+__attribute__((weak))
+void ecl_fault_thread(char *name, size_t size)
+{
+    (void) name;
+    (void) size;
+}
+
+// Called by fault handlers on own stack.
+// Frame is stacked by the processor, callee-saved registers are stacked
+// by the handler in order r4 to r11.
+__attribute__((used, noreturn))
+void ecl_fault_capture(const uint32_t *frame, uint32_t exc_return, const uint32_t *callee)
+{
+    uint32_t crashes = counter_valid() ? record.crashes + 1 : 1;
+
+    memset(&record, 0, sizeof(record));
+
+    record.crashes = crashes;
+    record.exception = __get_IPSR() & 0x1ff;
+    record.exc_return = exc_return;
+    record.cfsr = SCB->CFSR;
+    record.hfsr = SCB->HFSR;
+    record.mmfar = SCB->MMFAR;
+    record.bfar = SCB->BFAR;
+
+    memcpy(record.callee, callee, sizeof(record.callee));
+
+    constexpr size_t frame_words = sizeof(record.regs) / 4;
+
+    // Frame is not valid if stacking itself failed
+    if (in_ram(frame, frame_words)) {
+        memcpy(&record.regs, frame, sizeof(record.regs));
+
+        // Floating point context and alignment padding follow basic frame
+        const uint32_t *sp = frame + frame_words;
+        if (!(exc_return & 0x10)) {
+            sp += 18;
+        }
+
+        if (record.regs.xpsr & (1 << 9)) {
+            sp += 1;
+        }
+
+        record.sp = reinterpret_cast< uintptr_t >(sp);
+
+        for (size_t i = 0; i < ecl::crash_record::stack_words && in_ram(sp + i, 1); ++i) {
+            record.stack[i] = sp[i];
+        }
+    } else {
+        record.sp = reinterpret_cast< uintptr_t >(frame);
+    }
+
+    ecl_fault_thread(record.thread, sizeof(record.thread));
+
+    record.magic = crash_magic;
+    record.check = checksum(record);
+
+    __DSB();
+
+    if (CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk) {
+        __BKPT(0);
+    }
+
+    NVIC_SystemReset();
+
+    for (;;);
+}
+
+}
+
+namespace ecl
+{
+
+const crash_record *crash::last()
+{
+    return record.magic == crash_magic && record.check == checksum(record) ? &record : nullptr;
+}
+
+void crash::clear()
+{
+    uint32_t crashes = count();
+
+    memset(&record, 0, sizeof(record));
+    record.crashes = crashes;
+    record.magic = clear_magic;
+    record.check = checksum(record);
+}
+
+uint32_t crash::count()
+{
+    return counter_valid() ? record.crashes : 0;
+}
+
+} // namespace ecl
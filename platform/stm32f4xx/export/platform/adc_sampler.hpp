@@ -0,0 +1,662 @@
+//!
+//! \file
+//! \brief STM32F4xx timer-triggered ADC sampling engine
+//!
+
+#ifndef PLATFORM_ADC_SAMPLER_HPP_
+#define PLATFORM_ADC_SAMPLER_HPP_
+
+#include <platform/common/bus.hpp>
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+
+#include <stm32f4xx_adc.h>
+#include <stm32f4xx_tim.h>
+#include <stm32f4xx_rcc.h>
+
+#include <platform/irq_manager.hpp>
+#include <platform/clock.hpp>
+#include <platform/dma_device.hpp>
+#include <platform/dma_manager.hpp>
+
+#include <cstdint>
+#include <cstddef>
+
+namespace ecl
+{
+
+//!
+//! \brief Configuration of ADC sampler.
+//! See reference manual for DMA request mapping, i.e. ADC1 is served by
+//! DMA2 stream 0 or 4, channel 0, ADC2 by DMA2 stream 2 or 3, channel 1,
+//! ADC3 by DMA2 stream 0 or 1, channel 2.
+//! \tparam adc             ADC base address: ADC1_BASE, ADC2_BASE or ADC3_BASE.
+//! \tparam timer           Base address of the timer, which update event
+//!                         triggers a scan: TIM2_BASE, TIM3_BASE or TIM8_BASE.
+//! \tparam dma_stream      DMA stream used to move samples.
+//! \tparam dma_channel     DMA channel of the stream.
+//! \tparam sample_time     Sampling time of each channel, in ADC clocks.
+//!                         Conversion takes 12 more clocks.
+//!
+template< std::uintptr_t    adc,
+          std::uintptr_t    timer,
+          std::uintptr_t    dma_stream,
+          uint32_t          dma_channel,
+          uint8_t           sample_time = ADC_SampleTime_15Cycles >
+struct adc_config
+{
+    static constexpr std::uintptr_t     m_adc              = adc;
+    static constexpr std::uintptr_t     m_timer            = timer;
+    static constexpr std::uintptr_t     m_dma_stream       = dma_stream;
+    static constexpr uint32_t           m_dma_channel      = dma_channel;
+    static constexpr uint8_t            m_sample_time      = sample_time;
+
+    //! Streams claimed by the sampler. \sa dma::exclusive_streams
+    using dma_streams = dma::stream_list< dma_stream >;
+
+    static_assert(adc == ADC1_BASE || adc == ADC2_BASE || adc == ADC3_BASE,
+                  "Unknown ADC");
+    static_assert(timer == TIM2_BASE || timer == TIM3_BASE || timer == TIM8_BASE,
+                  "Only TIM2, TIM3 and TIM8 can trigger ADC by update event");
+};
+
+//!
+//! \brief Continuous ADC acquisition.
+//! Timer triggers a scan of the channel sequence at configured rate. Each
+//! scan converts all channels of the sequence, one after another, and DMA
+//! moves conversion results into double buffers. Samples of a scan are
+//! placed in sequence order, so a buffer holds interleaved channels.
+//! CPU is not involved per sample, only once per buffer.
+//! Handler follows streaming semantics of platform buses:
+//! \li RX event::ht is reported when first buffer is filled.
+//! \li RX event::tc is reported when second buffer is filled.
+//! \li RX event::err is reported if ADC overruns, i.e. DMA is not able to
+//!     keep up with the rate. Sampling is stopped then.
+//! \li Meta-channel TC event is reported when sampling is stopped.
+//! Total amount of samples acquired so far is reported with each event.
+//! Filled buffer must be consumed before the other one is filled.
+//! ADC IRQ is shared between all ADCs, so only one sampler can exist.
+//! \tparam adc_config Sampler configuration. \sa adc_config
+//!
+template< class adc_config >
+class adc_sampler
+{
+public:
+    // Convinient type aliases.
+    using channel       = ecl::bus_channel;
+    using event         = ecl::bus_event;
+    using handler_fn    = ecl::bus_handler;
+
+    //! Maximum length of a scan sequence.
+    static constexpr size_t max_channels = 16;
+
+    //!
+    //! \brief Constructs a sampler.
+    //!
+    adc_sampler();
+
+    //!
+    //! \brief Destructs a sampler.
+    ~adc_sampler();
+
+    //!
+    //! \brief Lazy initialization.
+    //! \return Status of opeartion.
+    //!
+    ecl::err init();
+
+    //!
+    //! \brief Sets scan sequence.
+    //! \pre Sampling is stopped.
+    //! \param[in] channels ADC channels, i.e. ADC_Channel_0, in scan order.
+    //!                     Channel may appear in the sequence more than once.
+    //! \param[in] n        Length of the sequence.
+    //! \retval err::ok     Sequence is set.
+    //! \retval err::inval  Sequence is empty, too long or has invalid channel.
+    //! \retval err::busy   Sampling is in progress.
+    //!
+    ecl::err set_channels(const uint8_t *channels, size_t n);
+
+    //!
+    //! \brief Sets double buffers for samples.
+    //! If second buffer is null, first one is used instead.
+    //! \pre Sampling is stopped.
+    //! \param[in,out]  buf0    First buffer.
+    //! \param[in,out]  buf1    Second buffer. Optional.
+    //! \param[in]      size    Size of each buffer, in samples. Must be a
+    //!                         multiple of the sequence length.
+    //! \retval err::ok     Buffers are set.
+    //! \retval err::inval  Buffer is null or size is invalid.
+    //! \retval err::busy   Sampling is in progress.
+    //!
+    ecl::err set_buffers(uint16_t *buf0, uint16_t *buf1, size_t size);
+
+    //!
+    //! \brief Sets event handler.
+    //! Handler will be used by the sampler, until reset_handler() will be called.
+    //! \param[in] handler Handler itself.
+    //!
+    void set_handler(const handler_fn &handler);
+
+    //!
+    //! \brief Resets previously set handler.
+    //!
+    void reset_handler();
+
+    //!
+    //! \brief Starts sampling.
+    //! Timer is set to the closest achievable rate.
+    //! \param[in] rate Scans per second.
+    //! \retval err::ok     Sampling is started.
+    //! \retval err::perm   Sampler is not initialized.
+    //! \retval err::nobufs Sequence or buffers are not set.
+    //! \retval err::inval  Rate is zero or too high for the timer.
+    //! \retval err::busy   Sampling is already started or DMA stream is
+    //!                     leased by someone else.
+    //!
+    ecl::err start(uint32_t rate);
+
+    //!
+    //! \brief Stops sampling.
+    //! Handler will be invoked with meta-channel TC event.
+    //! \retval err::ok     Sampling is stopped.
+    //! \retval err::perm   Sampling is not started.
+    //!
+    ecl::err stop();
+
+    //!
+    //! \brief Gets actual scan rate, set by the last start().
+    //!
+    uint32_t rate() const;
+
+private:
+    //! Converts to proper ADC type.
+    static constexpr auto pick_adc();
+    //! Converts to proper timer type.
+    static constexpr auto pick_timer();
+    //! Picks RCC of ADC at compile time. All ADCs are on APB2.
+    static constexpr uint32_t pick_adc_rcc();
+    //! Picks trigger source of the ADC.
+    static constexpr uint32_t pick_trigger();
+    //! Gets clock of the timer. Timers run at twice the APB clock,
+    //! unless APB prescaler is 1.
+    static constexpr uint32_t pick_timer_clk();
+
+    //! Configures ADC for the sequence.
+    void configure_adc();
+
+    //! Configures timer for given rate.
+    ecl::err configure_timer(uint32_t rate);
+
+    //! Prepares and starts DMA stream.
+    void start_dma();
+
+    //! Stops timer, ADC and DMA.
+    void halt();
+
+    //! Handles DMA IRQ events.
+    void dma_irq_handler();
+
+    //! Handles ADC IRQ events.
+    void irq_handler();
+
+    //! DMA IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void dma_irq_entry();
+
+    //! ADC IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void irq_entry();
+
+    //! Sampler is inited if this flag is set.
+    static constexpr uint8_t inited         = 0x1;
+    //! Sampling is in progress if this flag is set.
+    static constexpr uint8_t sampling       = 0x2;
+
+    handler_fn      m_event_handler;            //! Handler passed via set_handler().
+    uint8_t         m_seq[max_channels];        //! Scan sequence.
+    size_t          m_seq_len;                  //! Length of the sequence.
+    uint16_t        *m_buf0;                    //! First buffer.
+    uint16_t        *m_buf1;                    //! Second buffer.
+    size_t          m_size;                     //! Size of each buffer, in samples.
+    size_t          m_sampled;                  //! Samples acquired since start().
+    uint32_t        m_rate;                     //! Actual scan rate.
+    uint8_t         m_status;                   //! Represents sampler status.
+
+    //! Sampler object, served by IRQ entries. Only one object can exist.
+    static adc_sampler *m_instance;
+};
+
+template< class adc_config >
+adc_sampler< adc_config > *adc_sampler< adc_config >::m_instance{nullptr};
+
+template< class adc_config >
+adc_sampler< adc_config >::adc_sampler()
+    :m_event_handler{}
+    ,m_seq{}
+    ,m_seq_len{0}
+    ,m_buf0{nullptr}
+    ,m_buf1{nullptr}
+    ,m_size{0}
+    ,m_sampled{0}
+    ,m_rate{0}
+    ,m_status{0}
+{
+
+}
+
+template< class adc_config >
+adc_sampler< adc_config >::~adc_sampler()
+{
+
+}
+
+template< class adc_config >
+ecl::err adc_sampler< adc_config >::init()
+{
+    if (m_status & inited) {
+        return ecl::err::ok;
+    }
+
+    constexpr auto timer = pick_timer();
+
+    RCC_APB2PeriphClockCmd(pick_adc_rcc(), ENABLE);
+
+    if (timer == TIM8) {
+        RCC_APB2PeriphClockCmd(RCC_APB2Periph_TIM8, ENABLE);
+    } else if (timer == TIM2) {
+        RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM2, ENABLE);
+    } else {
+        RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM3, ENABLE);
+    }
+
+    dma::init_rcc< adc_config::m_dma_stream >();
+
+    // ADC clock must not exceed 36 MHz
+    ADC_CommonInitTypeDef common;
+
+    common.ADC_Mode             = ADC_Mode_Independent;
+    common.ADC_Prescaler        = clock::pclk2 / 2 <= 36000000
+                                  ? ADC_Prescaler_Div2 : ADC_Prescaler_Div4;
+    common.ADC_DMAAccessMode    = ADC_DMAAccessMode_Disabled;
+    common.ADC_TwoSamplingDelay = ADC_TwoSamplingDelay_5Cycles;
+
+    ADC_CommonInit(&common);
+
+    ecl_assert(!m_instance || m_instance == this);
+    m_instance = this;
+
+    IRQ_manager::mask(ADC_IRQn);
+    IRQ_manager::clear(ADC_IRQn);
+    IRQ_manager::subscribe(ADC_IRQn, irq_entry);
+    IRQ_manager::unmask(ADC_IRQn);
+
+    m_status |= inited;
+    return ecl::err::ok;
+}
+
+template< class adc_config >
+ecl::err adc_sampler< adc_config >::set_channels(const uint8_t *channels, size_t n)
+{
+    if (m_status & sampling) {
+        return ecl::err::busy;
+    }
+
+    if (!channels || !n || n > max_channels) {
+        return ecl::err::inval;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!IS_ADC_CHANNEL(channels[i])) {
+            return ecl::err::inval;
+        }
+
+        m_seq[i] = channels[i];
+    }
+
+    m_seq_len = n;
+    return ecl::err::ok;
+}
+
+template< class adc_config >
+ecl::err adc_sampler< adc_config >::set_buffers(uint16_t *buf0, uint16_t *buf1, size_t size)
+{
+    if (m_status & sampling) {
+        return ecl::err::busy;
+    }
+
+    // DMA counter is 16-bit wide
+    if (!buf0 || !size || size > 0xffff) {
+        return ecl::err::inval;
+    }
+
+    m_buf0 = buf0;
+    m_buf1 = buf1 ? buf1 : buf0;
+    m_size = size;
+
+    return ecl::err::ok;
+}
+
+template< class adc_config >
+void adc_sampler< adc_config >::set_handler(const handler_fn &handler)
+{
+    // It is possible (and recommended) to set handler before init.
+    m_event_handler = handler;
+}
+
+template< class adc_config >
+void adc_sampler< adc_config >::reset_handler()
+{
+    m_event_handler = handler_fn{};
+}
+
+template< class adc_config >
+ecl::err adc_sampler< adc_config >::start(uint32_t rate)
+{
+    if (!(m_status & inited)) {
+        return ecl::err::perm;
+    }
+
+    if (m_status & sampling) {
+        return ecl::err::busy;
+    }
+
+    if (!m_seq_len || !m_size || m_size % m_seq_len) {
+        return ecl::err::nobufs;
+    }
+
+    auto rc = configure_timer(rate);
+    if (is_error(rc)) {
+        return rc;
+    }
+
+    rc = dma::stream_lease< adc_config::m_dma_stream >::acquire(this, dma_irq_entry);
+    if (is_error(rc)) {
+        return rc;
+    }
+
+    constexpr auto adc   = pick_adc();
+    constexpr auto timer = pick_timer();
+
+    m_sampled = 0;
+    m_status |= sampling;
+
+    configure_adc();
+    start_dma();
+
+    ADC_ClearFlag(adc, ADC_FLAG_OVR);
+    ADC_ITConfig(adc, ADC_IT_OVR, ENABLE);
+
+    // Requests are raised after each conversion, not only up to the first
+    // DMA transfer complete
+    ADC_DMARequestAfterLastTransferCmd(adc, ENABLE);
+    ADC_DMACmd(adc, ENABLE);
+    ADC_Cmd(adc, ENABLE);
+
+    // First trigger comes after full timer period
+    TIM_SetCounter(timer, 0);
+    TIM_Cmd(timer, ENABLE);
+
+    return ecl::err::ok;
+}
+
+template< class adc_config >
+ecl::err adc_sampler< adc_config >::stop()
+{
+    if (!(m_status & sampling)) {
+        return ecl::err::perm;
+    }
+
+    constexpr auto irqn = dma::get_irqn< adc_config::m_dma_stream >();
+
+    // Prevent stream events from being delivered while stream is stopped
+    IRQ_manager::mask(irqn);
+    IRQ_manager::mask(ADC_IRQn);
+
+    halt();
+
+    IRQ_manager::clear(ADC_IRQn);
+    IRQ_manager::unmask(ADC_IRQn);
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+
+    m_event_handler(channel::meta, event::tc, 0);
+
+    return ecl::err::ok;
+}
+
+template< class adc_config >
+uint32_t adc_sampler< adc_config >::rate() const
+{
+    return m_rate;
+}
+
+// -----------------------------------------------------------------------------
+// Private members
+
+template< class adc_config >
+constexpr auto adc_sampler< adc_config >::pick_adc()
+{
+    return reinterpret_cast< ADC_TypeDef * >(adc_config::m_adc);
+}
+
+template< class adc_config >
+constexpr auto adc_sampler< adc_config >::pick_timer()
+{
+    return reinterpret_cast< TIM_TypeDef * >(adc_config::m_timer);
+}
+
+template< class adc_config >
+constexpr uint32_t adc_sampler< adc_config >::pick_adc_rcc()
+{
+    switch (adc_config::m_adc) {
+    case ADC1_BASE:
+        return RCC_APB2Periph_ADC1;
+    case ADC2_BASE:
+        return RCC_APB2Periph_ADC2;
+    case ADC3_BASE:
+        return RCC_APB2Periph_ADC3;
+    default:
+        return static_cast< uint32_t >(-1);
+    }
+}
+
+template< class adc_config >
+constexpr uint32_t adc_sampler< adc_config >::pick_trigger()
+{
+    switch (adc_config::m_timer) {
+    case TIM2_BASE:
+        return ADC_ExternalTrigConv_T2_TRGO;
+    case TIM3_BASE:
+        return ADC_ExternalTrigConv_T3_TRGO;
+    case TIM8_BASE:
+        return ADC_ExternalTrigConv_T8_TRGO;
+    default:
+        return static_cast< uint32_t >(-1);
+    }
+}
+
+template< class adc_config >
+constexpr uint32_t adc_sampler< adc_config >::pick_timer_clk()
+{
+    if (adc_config::m_timer == TIM8_BASE) {
+        return RCC_PCLK2_DIV == 1 ? clock::pclk2 : clock::pclk2 * 2;
+    }
+
+    return RCC_PCLK1_DIV == 1 ? clock::pclk1 : clock::pclk1 * 2;
+}
+
+template< class adc_config >
+void adc_sampler< adc_config >::configure_adc()
+{
+    constexpr auto adc = pick_adc();
+
+    ADC_InitTypeDef init_struct;
+
+    // Single scan per trigger
+    init_struct.ADC_Resolution              = ADC_Resolution_12b;
+    init_struct.ADC_ScanConvMode            = m_seq_len > 1 ? ENABLE : DISABLE;
+    init_struct.ADC_ContinuousConvMode      = DISABLE;
+    init_struct.ADC_ExternalTrigConvEdge    = ADC_ExternalTrigConvEdge_Rising;
+    init_struct.ADC_ExternalTrigConv        = pick_trigger();
+    init_struct.ADC_DataAlign               = ADC_DataAlign_Right;
+    init_struct.ADC_NbrOfConversion         = m_seq_len;
+
+    ADC_Cmd(adc, DISABLE);
+    ADC_Init(adc, &init_struct);
+
+    for (size_t i = 0; i < m_seq_len; ++i) {
+        ADC_RegularChannelConfig(adc, m_seq[i], i + 1, adc_config::m_sample_time);
+    }
+}
+
+template< class adc_config >
+ecl::err adc_sampler< adc_config >::configure_timer(uint32_t rate)
+{
+    constexpr auto timer     = pick_timer();
+    constexpr auto timer_clk = pick_timer_clk();
+
+    if (!rate || rate > timer_clk / 2) {
+        return ecl::err::inval;
+    }
+
+    // Counter is treated as 16-bit, even if the timer is wider
+    uint32_t ticks = timer_clk / rate;
+    uint32_t presc = (ticks - 1) / 0x10000;
+    uint32_t period = ticks / (presc + 1);
+
+    TIM_TimeBaseInitTypeDef init_struct;
+    TIM_TimeBaseStructInit(&init_struct);
+
+    init_struct.TIM_Prescaler       = presc;
+    init_struct.TIM_CounterMode     = TIM_CounterMode_Up;
+    init_struct.TIM_Period          = period - 1;
+    init_struct.TIM_ClockDivision   = TIM_CKD_DIV1;
+
+    TIM_Cmd(timer, DISABLE);
+    TIM_TimeBaseInit(timer, &init_struct);
+    TIM_SelectOutputTrigger(timer, TIM_TRGOSource_Update);
+
+    m_rate = timer_clk / ((presc + 1) * period);
+
+    return ecl::err::ok;
+}
+
+template< class adc_config >
+void adc_sampler< adc_config >::start_dma()
+{
+    constexpr auto adc      = pick_adc();
+    constexpr auto stream   = dma::get_stream< adc_config::m_dma_stream >();
+
+    DMA_InitTypeDef dma_init;
+    DMA_StructInit(&dma_init);
+
+    dma_init.DMA_Channel             = adc_config::m_dma_channel;
+    dma_init.DMA_DIR                 = DMA_DIR_PeripheralToMemory;
+    dma_init.DMA_PeripheralBaseAddr  = reinterpret_cast< uint32_t >(&adc->DR);
+    dma_init.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+    dma_init.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+    dma_init.DMA_PeripheralDataSize  = DMA_PeripheralDataSize_HalfWord;
+    dma_init.DMA_MemoryDataSize      = DMA_MemoryDataSize_HalfWord;
+    dma_init.DMA_Mode                = DMA_Mode_Circular;
+    dma_init.DMA_Priority            = DMA_Priority_High;
+    dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(m_buf0);
+    dma_init.DMA_BufferSize          = m_size;
+
+    DMA_Cmd(stream, DISABLE);
+    DMA_DeInit(stream);
+    DMA_Init(stream, &dma_init);
+    dma::enable_double_buffer< adc_config::m_dma_stream >(m_buf1);
+    DMA_ITConfig(stream, DMA_IT_TC | DMA_IT_TE, ENABLE);
+    DMA_Cmd(stream, ENABLE);
+}
+
+template< class adc_config >
+void adc_sampler< adc_config >::halt()
+{
+    constexpr auto adc      = pick_adc();
+    constexpr auto timer    = pick_timer();
+    constexpr auto stream   = dma::get_stream< adc_config::m_dma_stream >();
+
+    TIM_Cmd(timer, DISABLE);
+
+    ADC_ITConfig(adc, ADC_IT_OVR, DISABLE);
+    ADC_DMACmd(adc, DISABLE);
+    ADC_Cmd(adc, DISABLE);
+
+    DMA_Cmd(stream, DISABLE);
+    DMA_DeInit(stream);
+
+    dma::stream_lease< adc_config::m_dma_stream >::release();
+
+    m_status &= ~(sampling);
+}
+
+template< class adc_config >
+void adc_sampler< adc_config >::dma_irq_entry()
+{
+    m_instance->dma_irq_handler();
+}
+
+template< class adc_config >
+void adc_sampler< adc_config >::irq_entry()
+{
+    m_instance->irq_handler();
+}
+
+template< class adc_config >
+void adc_sampler< adc_config >::dma_irq_handler()
+{
+    constexpr auto stream   = dma::get_stream< adc_config::m_dma_stream >();
+    constexpr auto tc_if    = dma::get_tc_if< adc_config::m_dma_stream >();
+    constexpr auto err_if   = dma::get_err_if< adc_config::m_dma_stream >();
+    constexpr auto irqn     = dma::get_irqn< adc_config::m_dma_stream >();
+
+    if (DMA_GetITStatus(stream, err_if)) {
+        DMA_ClearITPendingBit(stream, err_if);
+
+        halt();
+        m_event_handler(channel::rx, event::err, m_sampled);
+        m_event_handler(channel::meta, event::tc, 0);
+    } else if (DMA_GetITStatus(stream, tc_if)) {
+        DMA_ClearITPendingBit(stream, tc_if);
+
+        // At this point DMA already switched to the other memory target,
+        // thus completed buffer is the one that is not used now.
+        auto type = dma::get_memory_target< adc_config::m_dma_stream >()
+                ? event::ht : event::tc;
+
+        m_sampled += m_size;
+        m_event_handler(channel::rx, type, m_sampled);
+    }
+
+    // Stream is left running, so IRQ must be enabled back
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+}
+
+template< class adc_config >
+void adc_sampler< adc_config >::irq_handler()
+{
+    constexpr auto adc      = pick_adc();
+    constexpr auto stream   = dma::get_stream< adc_config::m_dma_stream >();
+
+    if (ADC_GetITStatus(adc, ADC_IT_OVR) == SET) {
+        ADC_ClearITPendingBit(adc, ADC_IT_OVR);
+
+        // DMA stops serving ADC after overrun, samples in the current
+        // buffer are still valid
+        size_t received = m_sampled + m_size - DMA_GetCurrDataCounter(stream);
+
+        if (m_status & sampling) {
+            halt();
+            m_event_handler(channel::rx, event::err, received);
+            m_event_handler(channel::meta, event::tc, 0);
+        }
+    }
+
+    IRQ_manager::clear(ADC_IRQn);
+    IRQ_manager::unmask(ADC_IRQn);
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_ADC_SAMPLER_HPP_
@@ -0,0 +1,730 @@
+#ifndef PLATFORM_BOARD_HPP_
+#define PLATFORM_BOARD_HPP_
+
+//!
+//! \file
+//! \brief Compile-time board description.
+//! Board lists its pins and peripherals, and the layout emits driver types:
+//! DMA streams and channels are picked from the request mapping of
+//! the device, so that no stream is used twice, and SPI clocks are
+//! checked against prescalers of the APB bus. Any mistake in the
+//! description fails compilation.
+//! \code
+//! using layout = ecl::board::layout<
+//!     ecl::board::pins<
+//!         pin_cfg< pin::port::port_a, pin::number::pin_5, pin::function::pin_SPI1 >,
+//!         pin_cfg< pin::port::port_a, pin::number::pin_6, pin::function::pin_SPI1 >,
+//!         pin_cfg< pin::port::port_a, pin::number::pin_7, pin::function::pin_SPI1 >,
+//!         pin_cfg< pin::port::port_a, pin::number::pin_2, pin::function::UART2 >,
+//!         pin_cfg< pin::port::port_a, pin::number::pin_3, pin::function::UART2 >
+//!     >,
+//!     ecl::board::spi< ecl::spi_device::bus_1, 20000000 >,
+//!     ecl::board::usart< ecl::usart_device::dev_2 >,
+//!     ecl::board::fixed< DMA2_Stream3_BASE >      // SDIO, see sd_sdio.hpp
+//! >;
+//!
+//! using flash_spi = layout::bus< 0 >;             // spi_bus< spi_config< ... > >
+//! using console   = layout::bus< 1 >;             // usart_bus< dev_2, usart_dma_config< ... > >
+//!
+//! layout::init();                                 // configures all pins
+//! \endcode
+//! Streams are assigned in order of peripherals. First free stream from
+//! the mapping is taken, and the search backtracks if some request can't
+//! be served at all.
+//!
+
+#include <platform/spi_bus.hpp>
+#include <platform/usart_bus.hpp>
+#include <platform/pin_table.hpp>
+#include <platform/clock.hpp>
+
+#include <stm32f4xx.h>
+#include <stm32f4xx_dma.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+
+namespace ecl
+{
+
+namespace board
+{
+
+//! DMA requests of peripherals, that drivers are able to use.
+enum class dma_req : uint8_t
+{
+    none,
+    spi1_tx, spi1_rx, spi2_tx, spi2_rx, spi3_tx, spi3_rx,
+    spi4_tx, spi4_rx, spi5_tx, spi5_rx, spi6_tx, spi6_rx,
+    usart1_tx, usart1_rx, usart2_tx, usart2_rx, usart3_tx, usart3_rx,
+    uart4_tx, uart4_rx, uart5_tx, uart5_rx, usart6_tx, usart6_rx,
+};
+
+//! Directions, served by DMA.
+enum class dma_use
+{
+    none,
+    tx,
+    rx,
+    tx_rx,
+};
+
+//! SPI modes, as combinations of clock polarity and phase.
+enum class spi_mode
+{
+    mode_0,     //!< CPOL 0, CPHA 0
+    mode_1,     //!< CPOL 0, CPHA 1
+    mode_2,     //!< CPOL 1, CPHA 0
+    mode_3,     //!< CPOL 1, CPHA 1
+};
+
+//! Signals of peripherals, routed to pins.
+enum class pin_role : uint8_t
+{
+    sck,
+    miso,
+    mosi,
+    tx,
+    rx,
+};
+
+//! \cond
+namespace detail
+{
+
+//! Stream, that can serve a request: 0 to 7 of DMA1, 8 to 15 of DMA2.
+struct dma_route
+{
+    dma_req     req;
+    uint8_t     stream;
+    uint8_t     channel;
+};
+
+//! Pin, that can serve a signal of a peripheral.
+struct af_pin
+{
+    pin::function   fn;
+    pin::port       port;
+    uint8_t         num;
+    pin_role        role;
+};
+
+// Request mapping, RM0090 tables 42 and 43. Preferred streams go first.
+constexpr size_t route_count = 36;
+
+constexpr dma_route route(size_t i)
+{
+    const dma_route routes[route_count] = {
+        { dma_req::spi1_tx,     8 + 3,  3 },
+        { dma_req::spi1_tx,     8 + 5,  3 },
+        { dma_req::spi1_rx,     8 + 0,  3 },
+        { dma_req::spi1_rx,     8 + 2,  3 },
+        { dma_req::spi2_tx,     4,      0 },
+        { dma_req::spi2_rx,     3,      0 },
+        { dma_req::spi3_tx,     5,      0 },
+        { dma_req::spi3_tx,     7,      0 },
+        { dma_req::spi3_rx,     0,      0 },
+        { dma_req::spi3_rx,     2,      0 },
+        { dma_req::spi4_tx,     8 + 1,  4 },
+        { dma_req::spi4_tx,     8 + 4,  5 },
+        { dma_req::spi4_rx,     8 + 0,  4 },
+        { dma_req::spi4_rx,     8 + 3,  5 },
+        { dma_req::spi5_tx,     8 + 4,  2 },
+        { dma_req::spi5_tx,     8 + 6,  7 },
+        { dma_req::spi5_rx,     8 + 3,  2 },
+        { dma_req::spi5_rx,     8 + 5,  7 },
+        { dma_req::spi6_tx,     8 + 5,  1 },
+        { dma_req::spi6_rx,     8 + 6,  1 },
+        { dma_req::usart1_tx,   8 + 7,  4 },
+        { dma_req::usart1_rx,   8 + 2,  4 },
+        { dma_req::usart1_rx,   8 + 5,  4 },
+        { dma_req::usart2_tx,   6,      4 },
+        { dma_req::usart2_rx,   5,      4 },
+        { dma_req::usart3_tx,   3,      4 },
+        { dma_req::usart3_tx,   4,      7 },
+        { dma_req::usart3_rx,   1,      4 },
+        { dma_req::uart4_tx,    4,      4 },
+        { dma_req::uart4_rx,    2,      4 },
+        { dma_req::uart5_tx,    7,      4 },
+        { dma_req::uart5_rx,    0,      4 },
+        { dma_req::usart6_tx,   8 + 6,  5 },
+        { dma_req::usart6_tx,   8 + 7,  5 },
+        { dma_req::usart6_rx,   8 + 1,  5 },
+        { dma_req::usart6_rx,   8 + 2,  5 },
+    };
+
+    return routes[i];
+}
+
+// Alternate functions of pins, STM32F405/407 datasheet, table 9.
+// Only functions known to pin_cfg are listed.
+constexpr size_t af_pin_count = 35;
+
+constexpr af_pin alternate(size_t i)
+{
+    using f = pin::function;
+    using p = pin::port;
+    using r = pin_role;
+
+    const af_pin pins[af_pin_count] = {
+        { f::pin_SPI1,  p::port_a,  5,  r::sck  },
+        { f::pin_SPI1,  p::port_b,  3,  r::sck  },
+        { f::pin_SPI1,  p::port_a,  6,  r::miso },
+        { f::pin_SPI1,  p::port_b,  4,  r::miso },
+        { f::pin_SPI1,  p::port_a,  7,  r::mosi },
+        { f::pin_SPI1,  p::port_b,  5,  r::mosi },
+        { f::pin_SPI2,  p::port_b,  10, r::sck  },
+        { f::pin_SPI2,  p::port_b,  13, r::sck  },
+        { f::pin_SPI2,  p::port_i,  1,  r::sck  },
+        { f::pin_SPI2,  p::port_b,  14, r::miso },
+        { f::pin_SPI2,  p::port_c,  2,  r::miso },
+        { f::pin_SPI2,  p::port_i,  2,  r::miso },
+        { f::pin_SPI2,  p::port_b,  15, r::mosi },
+        { f::pin_SPI2,  p::port_c,  3,  r::mosi },
+        { f::pin_SPI2,  p::port_i,  3,  r::mosi },
+        { f::pin_SPI3,  p::port_b,  3,  r::sck  },
+        { f::pin_SPI3,  p::port_c,  10, r::sck  },
+        { f::pin_SPI3,  p::port_b,  4,  r::miso },
+        { f::pin_SPI3,  p::port_c,  11, r::miso },
+        { f::pin_SPI3,  p::port_b,  5,  r::mosi },
+        { f::pin_SPI3,  p::port_c,  12, r::mosi },
+        { f::UART1,     p::port_a,  9,  r::tx   },
+        { f::UART1,     p::port_b,  6,  r::tx   },
+        { f::UART1,     p::port_a,  10, r::rx   },
+        { f::UART1,     p::port_b,  7,  r::rx   },
+        { f::UART2,     p::port_a,  2,  r::tx   },
+        { f::UART2,     p::port_d,  5,  r::tx   },
+        { f::UART2,     p::port_a,  3,  r::rx   },
+        { f::UART2,     p::port_d,  6,  r::rx   },
+        { f::UART3,     p::port_b,  10, r::tx   },
+        { f::UART3,     p::port_c,  10, r::tx   },
+        { f::UART3,     p::port_d,  8,  r::tx   },
+        { f::UART3,     p::port_b,  11, r::rx   },
+        { f::UART3,     p::port_c,  11, r::rx   },
+        { f::UART3,     p::port_d,  9,  r::rx   },
+    };
+
+    return pins[i];
+}
+
+//! Gets address of the stream, as drivers expect it.
+constexpr std::uintptr_t stream_addr(uint8_t stream)
+{
+    const std::uintptr_t addr[16] = {
+        DMA1_Stream0_BASE, DMA1_Stream1_BASE, DMA1_Stream2_BASE, DMA1_Stream3_BASE,
+        DMA1_Stream4_BASE, DMA1_Stream5_BASE, DMA1_Stream6_BASE, DMA1_Stream7_BASE,
+        DMA2_Stream0_BASE, DMA2_Stream1_BASE, DMA2_Stream2_BASE, DMA2_Stream3_BASE,
+        DMA2_Stream4_BASE, DMA2_Stream5_BASE, DMA2_Stream6_BASE, DMA2_Stream7_BASE,
+    };
+
+    return addr[stream];
+}
+
+//! Gets stream index by its address, or 16 if address is unknown.
+constexpr uint8_t stream_index(std::uintptr_t addr)
+{
+    for (uint8_t i = 0; i < 16; ++i) {
+        if (stream_addr(i) == addr) {
+            return i;
+        }
+    }
+
+    return 16;
+}
+
+//! Gets channel selection bits of the stream.
+constexpr uint32_t channel_bits(uint8_t channel)
+{
+    const uint32_t bits[8] = {
+        DMA_Channel_0, DMA_Channel_1, DMA_Channel_2, DMA_Channel_3,
+        DMA_Channel_4, DMA_Channel_5, DMA_Channel_6, DMA_Channel_7,
+    };
+
+    return bits[channel];
+}
+
+//! Marks request slot, that has no route assigned.
+constexpr size_t no_route = route_count;
+
+//! Routes, picked for each request slot.
+template< size_t n >
+struct dma_plan
+{
+    size_t  route[n];
+    bool    ok;
+};
+
+//!
+//! \brief Assigns stream to every request, so that no stream is used twice.
+//! Depth-first search over the mapping. Amount of candidate streams per
+//! request is two at most, so the search is cheap for boards of any size.
+//! \param[in] reqs     Requests. Slots without request are skipped.
+//! \param[in] reserved Mask of streams, that are not available.
+//!
+template< size_t n >
+constexpr dma_plan< n > plan_streams(const dma_req (&reqs)[n], uint16_t reserved)
+{
+    dma_plan< n > plan{};
+    size_t next[n] = {};
+    uint16_t used = reserved;
+
+    for (size_t i = 0; i < n; ++i) {
+        plan.route[i] = no_route;
+    }
+
+    size_t i = 0;
+    while (i < n) {
+        if (reqs[i] == dma_req::none) {
+            ++i;
+            continue;
+        }
+
+        // Stream of the previous attempt is released, if we came back here
+        if (plan.route[i] != no_route) {
+            used &= ~(1u << route(plan.route[i]).stream);
+        }
+
+        size_t r = next[i];
+        while (r < route_count && (route(r).req != reqs[i]
+                                   || (used & (1u << route(r).stream)))) {
+            ++r;
+        }
+
+        if (r < route_count) {
+            plan.route[i] = r;
+            next[i] = r + 1;
+            used |= 1u << route(r).stream;
+            ++i;
+            continue;
+        }
+
+        // Nothing left for this request, so previous one must be changed
+        plan.route[i] = no_route;
+        next[i] = 0;
+
+        do {
+            if (i == 0) {
+                plan.ok = false;
+                return plan;
+            }
+            --i;
+        } while (reqs[i] == dma_req::none);
+    }
+
+    plan.ok = true;
+    return plan;
+}
+
+//! Checks if pin can serve given alternate function.
+constexpr bool af_valid(pin::function fn, pin::port port, uint8_t num)
+{
+    bool known = false;
+
+    for (size_t i = 0; i < af_pin_count; ++i) {
+        auto p = alternate(i);
+        if (p.fn == fn) {
+            known = true;
+            if (p.port == port && p.num == num) {
+                return true;
+            }
+        }
+    }
+
+    // Functions, that are not in the table, are not checked
+    return !known;
+}
+
+//! Checks if pin can serve given signal of alternate function.
+constexpr bool has_role(pin::function fn, pin::port port, uint8_t num, pin_role role)
+{
+    for (size_t i = 0; i < af_pin_count; ++i) {
+        auto p = alternate(i);
+        if (p.fn == fn && p.port == port && p.num == num && p.role == role) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//! Pin function of SPI device, or gpio_in if pins of the device are not known.
+constexpr pin::function spi_function(spi_device dev)
+{
+    return dev == spi_device::bus_1 ? pin::function::pin_SPI1
+         : dev == spi_device::bus_2 ? pin::function::pin_SPI2
+         : dev == spi_device::bus_3 ? pin::function::pin_SPI3
+         : pin::function::gpio_in;
+}
+
+//! Pin function of USART device, or gpio_in if pins of the device are not known.
+constexpr pin::function usart_function(usart_device dev)
+{
+    return dev == usart_device::dev_1 ? pin::function::UART1
+         : dev == usart_device::dev_2 ? pin::function::UART2
+         : dev == usart_device::dev_3 ? pin::function::UART3
+         : pin::function::gpio_in;
+}
+
+//! Gets SPI DMA request of given direction.
+constexpr dma_req spi_req(spi_device dev, bool rx)
+{
+    return static_cast< dma_req >(static_cast< uint8_t >(dma_req::spi1_tx)
+                                  + static_cast< uint8_t >(dev) * 2 + rx);
+}
+
+//! Gets USART DMA request of given direction.
+constexpr dma_req usart_req(usart_device dev, bool rx)
+{
+    return static_cast< int >(dev) > static_cast< int >(usart_device::dev_6)
+            ? dma_req::none
+            : static_cast< dma_req >(static_cast< uint8_t >(dma_req::usart1_tx)
+                                     + static_cast< uint8_t >(dev) * 2 + rx);
+}
+
+//! Gets clock of APB, the SPI is connected to.
+constexpr uint32_t spi_pclk(spi_device dev)
+{
+    return (dev == spi_device::bus_2 || dev == spi_device::bus_3)
+            ? ecl::clock::pclk1 : ecl::clock::pclk2;
+}
+
+//! Gets smallest SPI divider, that gives clock not greater than requested.
+//! Zero is returned, if even the largest divider is not enough.
+constexpr uint32_t spi_divider(uint32_t pclk, uint32_t clk)
+{
+    for (uint32_t div = 2; div <= 256; div *= 2) {
+        if (pclk / div <= clk) {
+            return div;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace detail
+//! \endcond
+
+//------------------------------------------------------------------------------
+
+//!
+//! \brief Pins of the board.
+//! \tparam Pins Pins, see pin_cfg in platform/pin_table.hpp.
+//!
+template< class... Pins >
+struct pins
+{
+    //! Pin table, that configures all pins at once.
+    using table = pin_table< Pins... >;
+
+    //!
+    //! \brief Checks if peripheral signal is routed to some pin.
+    //! Always true for peripherals, whose pins are not known.
+    //!
+    static constexpr bool routed(pin::function fn, pin_role role)
+    {
+        const pin::port ports[] = { Pins::port_id... };
+        const pin::number nums[] = { Pins::number_id... };
+        const pin::function fns[] = { Pins::function_id... };
+
+        if (fn == pin::function::gpio_in) {
+            return true;
+        }
+
+        for (size_t i = 0; i < sizeof...(Pins); ++i) {
+            if (fns[i] == fn && detail::has_role(fn, ports[i],
+                                                 static_cast< uint8_t >(nums[i]), role)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    //! Checks that every pin can serve its alternate function.
+    static constexpr bool valid()
+    {
+        const pin::port ports[] = { Pins::port_id... };
+        const pin::number nums[] = { Pins::number_id... };
+        const pin::function fns[] = { Pins::function_id... };
+
+        for (size_t i = 0; i < sizeof...(Pins); ++i) {
+            if (!detail::af_valid(fns[i], ports[i], static_cast< uint8_t >(nums[i]))) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+//!
+//! \brief SPI bus of the board, in master mode with software NSS.
+//! DMA is always used by SPI bus: TX and, unless bus is TX-only, RX.
+//! \tparam dev         SPI device.
+//! \tparam max_clk     Maximum clock, supported by slaves, Hz. Fastest clock,
+//!                     not greater than this one, is used.
+//! \tparam mode        SPI mode.
+//! \tparam tx_only     Bus only transmits, using single bidirectional line.
+//! \tparam data_size   SPI_DataSize_8b or SPI_DataSize_16b.
+//! \tparam first_bit   SPI_FirstBit_MSB or SPI_FirstBit_LSB.
+//!
+template< spi_device    dev,
+          uint32_t      max_clk,
+          spi_mode      mode        = spi_mode::mode_0,
+          bool          tx_only     = false,
+          uint16_t      data_size   = SPI_DataSize_8b,
+          uint16_t      first_bit   = SPI_FirstBit_MSB >
+struct spi
+{
+    //! Divider of the APB clock.
+    static constexpr uint32_t m_div = detail::spi_divider(detail::spi_pclk(dev), max_clk);
+
+    static_assert(m_div, "Requested SPI clock is lower than the largest prescaler gives");
+
+    //! Actual bus clock, Hz.
+    static constexpr uint32_t m_clk = detail::spi_pclk(dev) / (m_div ? m_div : 1);
+
+    static constexpr dma_req request(bool rx)
+    {
+        return (rx && tx_only) ? dma_req::none : detail::spi_req(dev, rx);
+    }
+
+    static constexpr bool reserves(uint8_t)
+    {
+        return false;
+    }
+
+    template< class layout_pins >
+    static constexpr bool routed()
+    {
+        constexpr auto fn = detail::spi_function(dev);
+
+        return layout_pins::routed(fn, pin_role::sck)
+                && layout_pins::routed(fn, pin_role::mosi)
+                && (tx_only || layout_pins::routed(fn, pin_role::miso));
+    }
+
+    template< std::uintptr_t tx_stream, uint32_t tx_channel,
+              std::uintptr_t rx_stream, uint32_t rx_channel >
+    using config = spi_config< dev, tx_stream, tx_channel, rx_stream, rx_channel,
+                               tx_only ? SPI_Direction_1Line_Tx
+                                       : SPI_Direction_2Lines_FullDuplex,
+                               SPI_Mode_Master,
+                               (mode == spi_mode::mode_2 || mode == spi_mode::mode_3)
+                                       ? SPI_CPOL_High : SPI_CPOL_Low,
+                               (mode == spi_mode::mode_1 || mode == spi_mode::mode_3)
+                                       ? SPI_CPHA_2Edge : SPI_CPHA_1Edge,
+                               SPI_NSS_Soft,
+                               first_bit,
+                               m_clk,
+                               data_size >;
+
+    template< class cfg >
+    using bus = spi_bus< cfg >;
+};
+
+//!
+//! \brief USART bus of the board.
+//! \tparam dev USART device.
+//! \tparam dma Directions served by DMA. The rest is served from IRQ.
+//!
+template< usart_device dev, dma_use dma = dma_use::tx_rx >
+struct usart
+{
+    static constexpr dma_req request(bool rx)
+    {
+        return (rx ? (dma == dma_use::rx || dma == dma_use::tx_rx)
+                   : (dma == dma_use::tx || dma == dma_use::tx_rx))
+                ? detail::usart_req(dev, rx) : dma_req::none;
+    }
+
+    static_assert(dma == dma_use::none || static_cast< int >(dev) <= static_cast< int >(usart_device::dev_6),
+                  "USART device has no DMA requests");
+
+    static constexpr bool reserves(uint8_t)
+    {
+        return false;
+    }
+
+    template< class layout_pins >
+    static constexpr bool routed()
+    {
+        constexpr auto fn = detail::usart_function(dev);
+
+        return layout_pins::routed(fn, pin_role::tx) && layout_pins::routed(fn, pin_role::rx);
+    }
+
+    template< std::uintptr_t tx_stream, uint32_t tx_channel,
+              std::uintptr_t rx_stream, uint32_t rx_channel >
+    using config = usart_dma_config< tx_stream, tx_channel, rx_stream, rx_channel >;
+
+    template< class cfg >
+    using bus = usart_bus< dev, cfg >;
+};
+
+//!
+//! \brief Streams, used by drivers with fixed DMA mapping.
+//! I.e. SDIO, CRYP or HASH. Streams are never picked for other peripherals.
+//! \tparam streams Addresses of streams, i.e. DMA2_Stream3_BASE.
+//!
+template< std::uintptr_t... streams >
+struct fixed
+{
+    static_assert(dma::distinct(dma::stream_list< streams... >{}),
+                  "Stream is listed more than once");
+
+    static constexpr dma_req request(bool)
+    {
+        return dma_req::none;
+    }
+
+    static constexpr bool reserves(uint8_t stream)
+    {
+        const std::uintptr_t s[] = { streams..., 0 };
+
+        for (size_t i = 0; i < sizeof...(streams); ++i) {
+            if (detail::stream_index(s[i]) == stream) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    template< class layout_pins >
+    static constexpr bool routed()
+    {
+        return true;
+    }
+
+    template< std::uintptr_t, uint32_t, std::uintptr_t, uint32_t >
+    using config = dma::stream_list< streams... >;
+
+    template< class cfg >
+    using bus = void;
+};
+
+//------------------------------------------------------------------------------
+
+//!
+//! \brief Board layout.
+//! \tparam board_pins  Pins of the board. \sa pins
+//! \tparam periphs     Peripherals: spi, usart and fixed.
+//!
+//! \cond
+namespace detail
+{
+
+// Slot 2 * i is TX request of i-th peripheral, 2 * i + 1 is RX one.
+// Last slot is never used, it lets board be empty.
+template< class... periphs >
+constexpr dma_plan< sizeof...(periphs) * 2 + 1 > layout_plan()
+{
+    constexpr size_t count = sizeof...(periphs);
+
+    const dma_req tx[] = { periphs::request(false)..., dma_req::none };
+    const dma_req rx[] = { periphs::request(true)..., dma_req::none };
+    dma_req reqs[count * 2 + 1] = {};
+
+    for (size_t i = 0; i < count; ++i) {
+        reqs[i * 2] = tx[i];
+        reqs[i * 2 + 1] = rx[i];
+    }
+
+    uint16_t reserved = 0;
+    for (uint8_t s = 0; s < 16; ++s) {
+        const bool r[] = { periphs::reserves(s)..., false };
+        for (size_t i = 0; i < count; ++i) {
+            if (r[i]) {
+                reserved |= 1u << s;
+            }
+        }
+    }
+
+    return plan_streams(reqs, reserved);
+}
+
+// Checks that signals of all peripherals are routed to pins
+template< class board_pins, class... periphs >
+constexpr bool layout_routed()
+{
+    const bool r[] = { periphs::template routed< board_pins >()..., true };
+
+    for (size_t i = 0; i < sizeof...(periphs); ++i) {
+        if (!r[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Gets stream, assigned to the slot, or zero if slot has no request
+template< size_t slot, class... periphs >
+constexpr std::uintptr_t layout_stream()
+{
+    return layout_plan< periphs... >().route[slot] == no_route
+            ? 0 : stream_addr(route(layout_plan< periphs... >().route[slot]).stream);
+}
+
+// Gets channel, assigned to the slot, or zero if slot has no request
+template< size_t slot, class... periphs >
+constexpr uint32_t layout_channel()
+{
+    return layout_plan< periphs... >().route[slot] == no_route
+            ? 0 : channel_bits(route(layout_plan< periphs... >().route[slot]).channel);
+}
+
+} // namespace detail
+//! \endcond
+
+//!
+//! \brief Board layout.
+//! \tparam board_pins  Pins of the board. \sa pins
+//! \tparam periphs     Peripherals: spi, usart and fixed.
+//!
+template< class board_pins, class... periphs >
+class layout
+{
+    static_assert(board_pins::table::valid(), "Pin is listed more than once");
+    static_assert(board_pins::valid(), "Pin can't serve its alternate function");
+    static_assert(detail::layout_routed< board_pins, periphs... >(),
+                  "Signal of a peripheral is not routed to any pin");
+    static_assert(detail::layout_plan< periphs... >().ok,
+                  "DMA requests can't be served without sharing a stream");
+
+    template< size_t i >
+    using periph = typename std::tuple_element< i, std::tuple< periphs... > >::type;
+
+public:
+    //! Pin table of the board.
+    using pins = typename board_pins::table;
+
+    //!
+    //! \brief Configuration of i-th peripheral.
+    //! spi_config for SPI, usart_dma_config for USART.
+    //!
+    template< size_t i >
+    using config = typename periph< i >::template config<
+            detail::layout_stream< i * 2, periphs... >(),
+            detail::layout_channel< i * 2, periphs... >(),
+            detail::layout_stream< i * 2 + 1, periphs... >(),
+            detail::layout_channel< i * 2 + 1, periphs... >() >;
+
+    //! Driver of i-th peripheral: spi_bus or usart_bus.
+    template< size_t i >
+    using bus = typename periph< i >::template bus< config< i > >;
+
+    //! Configures pins of the board.
+    static void init()
+    {
+        pins::init();
+    }
+};
+
+} // namespace board
+
+} // namespace ecl
+
+#endif // PLATFORM_BOARD_HPP_
@@ -0,0 +1,604 @@
+//!
+//! \file
+//! \brief STM32F4xx bxCAN driver
+//!
+
+#ifndef PLATFORM_CAN_BUS_HPP_
+#define PLATFORM_CAN_BUS_HPP_
+
+#include <common/can.hpp>
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+#include <ecl/thread/completion.hpp>
+#include <ecl/thread/spsc_queue.hpp>
+#include <ecl/thread/mpmc_queue.hpp>
+
+#include <stm32f4xx_can.h>
+#include <stm32f4xx_rcc.h>
+
+#include <platform/irq_manager.hpp>
+#include <platform/clock.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace ecl
+{
+
+//! \cond INTERNAL
+namespace can_detail
+{
+
+//! Bit timing, in time quanta.
+struct timing
+{
+    uint32_t presc;     //!< Clock prescaler, zero if bitrate can't be reached.
+    uint32_t bs1;       //!< Segment before the sample point, w/o sync segment.
+    uint32_t bs2;       //!< Segment after the sample point.
+};
+
+//! Finds timing with the most quanta per bit and the sample point
+//! close to 87.5%, as CANopen and ARINC 825 recommend.
+constexpr timing pick_timing(uint32_t clk, uint32_t bitrate)
+{
+    for (uint32_t tq = 25; tq >= 8; --tq) {
+        uint32_t bs1 = (tq * 7 + 4) / 8 - 1;
+        uint32_t bs2 = tq - 1 - bs1;
+
+        if (clk % (bitrate * tq) || bs1 > 16 || bs2 > 8) {
+            continue;
+        }
+
+        uint32_t presc = clk / (bitrate * tq);
+
+        if (presc <= 1024) {
+            return timing{presc, bs1, bs2};
+        }
+    }
+
+    return timing{0, 0, 0};
+}
+
+} // namespace can_detail
+//! \endcond
+
+//!
+//! \brief Configuration of CAN bus.
+//! CAN1 owns filter banks 0 to 13, CAN2 owns banks 14 to 27. Banks are
+//! numbered from zero for each controller.
+//! \tparam can         CAN base address: CAN1_BASE or CAN2_BASE.
+//! \tparam bitrate     Bitrate, in bit/s. Up to 1 Mbit/s.
+//! \tparam rx_frames   Capacity of RX queue. Power of two.
+//! \tparam tx_frames   Capacity of TX queue. Power of two.
+//!
+template< std::uintptr_t    can,
+          uint32_t          bitrate,
+          size_t            rx_frames = 64,
+          size_t            tx_frames = 16 >
+struct can_config
+{
+    static constexpr std::uintptr_t     m_can           = can;
+    static constexpr uint32_t           m_bitrate       = bitrate;
+    static constexpr size_t             m_rx_frames     = rx_frames;
+    static constexpr size_t             m_tx_frames     = tx_frames;
+    static constexpr can_detail::timing m_timing        =
+        can_detail::pick_timing(clock::pclk1, bitrate);
+
+    static_assert(can == CAN1_BASE || can == CAN2_BASE, "Unknown CAN");
+    static_assert(bitrate && bitrate <= 1000000, "CAN bitrate is out of range");
+    static_assert(m_timing.presc, "CAN bitrate can't be derived from APB1 clock");
+};
+
+//!
+//! \brief STM32F4 bxCAN controller.
+//! Acceptance filters are evaluated by hardware, so frames nobody listens
+//! to never reach CPU. Accepted frames are moved from both hardware FIFOs
+//! into RX queue by ISR. Receiving thread is woken up only when the queue
+//! becomes non-empty, then it drains frames in batches by recv().
+//! Frames to send are queued, and TX ISR keeps all 3 mailboxes busy until
+//! the queue is empty. Mailboxes are served in order of queueing, so frames
+//! leave in the same order as they were sent.
+//! Only one thread can receive. Any amount of threads and ISRs can send.
+//! Frames are trimmed to 8 data bytes.
+//! Automatic bus-off recovery is enabled.
+//! \tparam can_config Bus configuration. \sa can_config
+//!
+template< class can_config >
+class can_bus
+{
+public:
+    //!
+    //! \brief Initializes controller and enters the bus.
+    //! No frames are received until a filter is set.
+    //! \param[in] mode Operating mode.
+    //! \retval err::ok     Controller is ready.
+    //! \retval err::io     Controller failed to enter initialization mode,
+    //!                     i.e. CAN RX pin is not recessive.
+    //!
+    static err init(can_mode mode = can_mode::normal);
+
+    //!
+    //! \brief Leaves the bus and disables controller.
+    //!
+    static void deinit();
+
+    //!
+    //! \brief Sets acceptance filter bank.
+    //! \param[in] bank     Filter bank, 0 to 13.
+    //! \param[in] filter   Filter.
+    //! \retval err::ok     Filter is set.
+    //! \retval err::inval  Invalid bank or FIFO.
+    //!
+    static err set_filter(size_t bank, const can_filter &filter);
+
+    //!
+    //! \brief Disables acceptance filter bank.
+    //! \param[in] bank Filter bank, 0 to 13.
+    //!
+    static void clear_filter(size_t bank);
+
+    //!
+    //! \brief Queues a frame to send.
+    //! \retval true  Frame is queued.
+    //! \retval false TX queue is full.
+    //!
+    static bool send(const can_frame &frame);
+
+    //!
+    //! \brief Queues frames to send.
+    //! \return Amount of frames queued, less than requested if queue is full.
+    //!
+    static size_t send(const can_frame *frames, size_t n);
+
+    //!
+    //! \brief Takes received frames without waiting.
+    //! \param[out] frames  Buffer for frames.
+    //! \param[in]  n       Capacity of the buffer.
+    //! \return Amount of frames taken.
+    //!
+    static size_t recv(can_frame *frames, size_t n);
+
+    //!
+    //! \brief Waits until a frame is received.
+    //! Returns immediately if frames are already queued.
+    //!
+    static void wait_rx();
+
+    //!
+    //! \brief Gets counters of the controller.
+    //!
+    static can_stats stats();
+
+private:
+    //! Gets the controller.
+    static CAN_TypeDef *get_can();
+
+    //! IRQs of the controller.
+    static constexpr IRQn_Type get_tx_irqn();
+    static constexpr IRQn_Type get_rx0_irqn();
+    static constexpr IRQn_Type get_rx1_irqn();
+    static constexpr IRQn_Type get_sce_irqn();
+
+    //! Gets first filter bank of the controller.
+    static constexpr size_t first_bank();
+
+    //! Moves queued frames to empty mailboxes.
+    static void fill_mailboxes();
+
+    //! Moves frames from hardware FIFO to RX queue.
+    static void drain_fifo(uint8_t fifo);
+
+    static void tx_irq_handler();
+    static void rx0_irq_handler();
+    static void rx1_irq_handler();
+    static void sce_irq_handler();
+
+    //! Filter banks per controller.
+    static constexpr size_t banks = 14;
+
+    //! Mailboxes, which transmission is completed.
+    static constexpr uint32_t rqcp_all = CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2;
+
+    using rx_queue = spsc_queue< can_frame, can_config::m_rx_frames >;
+    using tx_queue = mpmc_queue< can_frame, can_config::m_tx_frames >;
+
+    static rx_queue                 m_rx;           //!< Received frames.
+    static tx_queue                 m_tx;           //!< Frames to send.
+    static ecl::completion          m_rx_ready;     //!< RX queue became non-empty.
+    static std::atomic< size_t >    m_cnt_rx;       //!< \sa can_stats
+    static std::atomic< size_t >    m_cnt_tx;
+    static std::atomic< size_t >    m_cnt_rx_dropped;
+    static std::atomic< size_t >    m_cnt_rx_overruns;
+    static std::atomic< size_t >    m_cnt_tx_failed;
+    static std::atomic< size_t >    m_cnt_bus_off;
+};
+
+template< class can_config >
+typename can_bus< can_config >::rx_queue can_bus< can_config >::m_rx{};
+
+template< class can_config >
+typename can_bus< can_config >::tx_queue can_bus< can_config >::m_tx{};
+
+template< class can_config >
+ecl::completion can_bus< can_config >::m_rx_ready{};
+
+template< class can_config >
+std::atomic< size_t > can_bus< can_config >::m_cnt_rx{0};
+
+template< class can_config >
+std::atomic< size_t > can_bus< can_config >::m_cnt_tx{0};
+
+template< class can_config >
+std::atomic< size_t > can_bus< can_config >::m_cnt_rx_dropped{0};
+
+template< class can_config >
+std::atomic< size_t > can_bus< can_config >::m_cnt_rx_overruns{0};
+
+template< class can_config >
+std::atomic< size_t > can_bus< can_config >::m_cnt_tx_failed{0};
+
+template< class can_config >
+std::atomic< size_t > can_bus< can_config >::m_cnt_bus_off{0};
+
+//------------------------------------------------------------------------------
+
+template< class can_config >
+err can_bus< can_config >::init(can_mode mode)
+{
+    auto can = get_can();
+
+    // CAN2 is a slave: filters and part of its logic belong to CAN1
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_CAN1, ENABLE);
+    if (can_config::m_can == CAN2_BASE) {
+        RCC_APB1PeriphClockCmd(RCC_APB1Periph_CAN2, ENABLE);
+    }
+
+    CAN_DeInit(can);
+
+    CAN_InitTypeDef init_struct;
+    CAN_StructInit(&init_struct);
+
+    init_struct.CAN_TTCM        = DISABLE;
+    init_struct.CAN_ABOM        = ENABLE;
+    init_struct.CAN_AWUM        = DISABLE;
+    init_struct.CAN_NART        = DISABLE;
+    init_struct.CAN_RFLM        = DISABLE;
+    // Mailboxes are sent in chronological order, not by identifier
+    init_struct.CAN_TXFP        = ENABLE;
+    init_struct.CAN_Mode        = mode == can_mode::loopback ? CAN_Mode_LoopBack :
+                                  mode == can_mode::silent   ? CAN_Mode_Silent :
+                                                               CAN_Mode_Normal;
+    init_struct.CAN_SJW         = CAN_SJW_1tq;
+    init_struct.CAN_BS1         = can_config::m_timing.bs1 - 1;
+    init_struct.CAN_BS2         = can_config::m_timing.bs2 - 1;
+    init_struct.CAN_Prescaler   = can_config::m_timing.presc;
+
+    if (CAN_Init(can, &init_struct) != CAN_InitStatus_Success) {
+        return err::io;
+    }
+
+    CAN_SlaveStartBank(banks);
+
+    for (auto irqn : { get_tx_irqn(), get_rx0_irqn(), get_rx1_irqn(), get_sce_irqn() }) {
+        IRQ_manager::mask(irqn);
+        IRQ_manager::clear(irqn);
+    }
+
+    IRQ_manager::subscribe(get_tx_irqn(), tx_irq_handler);
+    IRQ_manager::subscribe(get_rx0_irqn(), rx0_irq_handler);
+    IRQ_manager::subscribe(get_rx1_irqn(), rx1_irq_handler);
+    IRQ_manager::subscribe(get_sce_irqn(), sce_irq_handler);
+
+    can->IER = CAN_IER_TMEIE
+        | CAN_IER_FMPIE0 | CAN_IER_FOVIE0
+        | CAN_IER_FMPIE1 | CAN_IER_FOVIE1
+        | CAN_IER_BOFIE | CAN_IER_ERRIE;
+
+    for (auto irqn : { get_tx_irqn(), get_rx0_irqn(), get_rx1_irqn(), get_sce_irqn() }) {
+        IRQ_manager::unmask(irqn);
+    }
+
+    return err::ok;
+}
+
+template< class can_config >
+void can_bus< can_config >::deinit()
+{
+    auto can = get_can();
+
+    for (auto irqn : { get_tx_irqn(), get_rx0_irqn(), get_rx1_irqn(), get_sce_irqn() }) {
+        IRQ_manager::mask(irqn);
+        IRQ_manager::unsubscribe(irqn);
+    }
+
+    can->IER = 0;
+    CAN_DeInit(can);
+
+    if (can_config::m_can == CAN2_BASE) {
+        RCC_APB1PeriphClockCmd(RCC_APB1Periph_CAN2, DISABLE);
+    }
+
+    // CAN1 clock is left on, other controller may depend on it
+}
+
+template< class can_config >
+err can_bus< can_config >::set_filter(size_t bank, const can_filter &filter)
+{
+    if (bank >= banks || filter.fifo > 1) {
+        return err::inval;
+    }
+
+    // 32-bit register layout: STID[10:0] EXID[17:0] IDE RTR 0
+    uint32_t id = filter.ext ? (filter.id << 3) | CAN_Id_Extended : filter.id << 21;
+    uint32_t mask = filter.ext ? filter.mask << 3 : filter.mask << 21;
+
+    // Type is compared unless everything is accepted
+    if (filter.mask) {
+        mask |= CAN_Id_Extended;
+    }
+
+    CAN_FilterInitTypeDef init_struct;
+
+    init_struct.CAN_FilterNumber            = first_bank() + bank;
+    init_struct.CAN_FilterMode              = CAN_FilterMode_IdMask;
+    init_struct.CAN_FilterScale             = CAN_FilterScale_32bit;
+    init_struct.CAN_FilterIdHigh            = id >> 16;
+    init_struct.CAN_FilterIdLow             = id & 0xffff;
+    init_struct.CAN_FilterMaskIdHigh        = mask >> 16;
+    init_struct.CAN_FilterMaskIdLow         = mask & 0xffff;
+    init_struct.CAN_FilterFIFOAssignment    = filter.fifo ? CAN_Filter_FIFO1 : CAN_Filter_FIFO0;
+    init_struct.CAN_FilterActivation        = ENABLE;
+
+    CAN_FilterInit(&init_struct);
+
+    return err::ok;
+}
+
+template< class can_config >
+void can_bus< can_config >::clear_filter(size_t bank)
+{
+    if (bank >= banks) {
+        return;
+    }
+
+    uint32_t bit = 1 << (first_bank() + bank);
+
+    CAN1->FMR |= CAN_FMR_FINIT;
+    CAN1->FA1R &= ~bit;
+    CAN1->FMR &= ~CAN_FMR_FINIT;
+}
+
+template< class can_config >
+bool can_bus< can_config >::send(const can_frame &frame)
+{
+    return send(&frame, 1) == 1;
+}
+
+template< class can_config >
+size_t can_bus< can_config >::send(const can_frame *frames, size_t n)
+{
+    size_t i = 0;
+
+    for (; i < n && m_tx.push(frames[i]); ++i) { }
+
+    fill_mailboxes();
+
+    return i;
+}
+
+template< class can_config >
+size_t can_bus< can_config >::recv(can_frame *frames, size_t n)
+{
+    size_t i = 0;
+
+    for (; i < n && m_rx.pop(frames[i]); ++i) { }
+
+    return i;
+}
+
+template< class can_config >
+void can_bus< can_config >::wait_rx()
+{
+    // Signal left from already drained frames is consumed here
+    while (m_rx.empty()) {
+        m_rx_ready.wait();
+    }
+}
+
+template< class can_config >
+can_stats can_bus< can_config >::stats()
+{
+    return can_stats{
+        m_cnt_rx,
+        m_cnt_tx,
+        m_cnt_rx_dropped,
+        m_cnt_rx_overruns,
+        m_cnt_tx_failed,
+        m_cnt_bus_off,
+    };
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< class can_config >
+CAN_TypeDef *can_bus< can_config >::get_can()
+{
+    return reinterpret_cast< CAN_TypeDef * >(can_config::m_can);
+}
+
+template< class can_config >
+constexpr IRQn_Type can_bus< can_config >::get_tx_irqn()
+{
+    return can_config::m_can == CAN1_BASE ? CAN1_TX_IRQn : CAN2_TX_IRQn;
+}
+
+template< class can_config >
+constexpr IRQn_Type can_bus< can_config >::get_rx0_irqn()
+{
+    return can_config::m_can == CAN1_BASE ? CAN1_RX0_IRQn : CAN2_RX0_IRQn;
+}
+
+template< class can_config >
+constexpr IRQn_Type can_bus< can_config >::get_rx1_irqn()
+{
+    return can_config::m_can == CAN1_BASE ? CAN1_RX1_IRQn : CAN2_RX1_IRQn;
+}
+
+template< class can_config >
+constexpr IRQn_Type can_bus< can_config >::get_sce_irqn()
+{
+    return can_config::m_can == CAN1_BASE ? CAN1_SCE_IRQn : CAN2_SCE_IRQn;
+}
+
+template< class can_config >
+constexpr size_t can_bus< can_config >::first_bank()
+{
+    return can_config::m_can == CAN1_BASE ? 0 : banks;
+}
+
+template< class can_config >
+void can_bus< can_config >::fill_mailboxes()
+{
+    auto can = get_can();
+    can_frame frame;
+    IRQ_lock lock;
+
+    // Senders and TX ISR fill mailboxes, so they are kept out of each other.
+    // Section is short: at most 3 mailboxes are written.
+    lock.lock();
+
+    // CODE field points to an empty mailbox while any is empty
+    while ((can->TSR & CAN_TSR_TME) && m_tx.pop(frame)) {
+        auto &mb = can->sTxMailBox[(can->TSR & CAN_TSR_CODE) >> 24];
+
+        uint32_t data[2] = {
+            frame.data[0] | frame.data[1] << 8 | frame.data[2] << 16
+                | static_cast< uint32_t >(frame.data[3]) << 24,
+            frame.data[4] | frame.data[5] << 8 | frame.data[6] << 16
+                | static_cast< uint32_t >(frame.data[7]) << 24,
+        };
+
+        mb.TDLR = data[0];
+        mb.TDHR = data[1];
+        mb.TDTR = frame.dlc > 8 ? 8 : frame.dlc;
+        mb.TIR  = (frame.ext ? (frame.id << 3) | CAN_Id_Extended : frame.id << 21)
+            | (frame.rtr ? CAN_RTR_Remote : 0)
+            | CAN_TI0R_TXRQ;
+    }
+
+    lock.unlock();
+}
+
+template< class can_config >
+void can_bus< can_config >::drain_fifo(uint8_t fifo)
+{
+    auto can = get_can();
+    auto &rfr = fifo ? can->RF1R : can->RF0R;
+    auto &mb = can->sFIFOMailBox[fifo];
+
+    bool was_empty = m_rx.empty();
+
+    // Up to 3 frames are pending
+    while (rfr & CAN_RF0R_FMP0) {
+        uint32_t rir = mb.RIR;
+        uint32_t lo = mb.RDLR;
+        uint32_t hi = mb.RDHR;
+
+        can_frame frame;
+
+        frame.ext = rir & CAN_Id_Extended;
+        frame.rtr = rir & CAN_RTR_Remote;
+        frame.id  = frame.ext ? rir >> 3 : rir >> 21;
+        frame.dlc = mb.RDTR & 0xf;
+
+        for (int i = 0; i < 4; ++i) {
+            frame.data[i] = lo >> (8 * i);
+            frame.data[i + 4] = hi >> (8 * i);
+        }
+
+        rfr = CAN_RF0R_RFOM0;
+
+        if (m_rx.push(frame)) {
+            ++m_cnt_rx;
+        } else {
+            ++m_cnt_rx_dropped;
+        }
+    }
+
+    if (rfr & CAN_RF0R_FOVR0) {
+        rfr = CAN_RF0R_FOVR0;
+        ++m_cnt_rx_overruns;
+    }
+
+    // Receiver is woken up once per batch, not per frame
+    if (was_empty && !m_rx.empty()) {
+        m_rx_ready.signal();
+    }
+}
+
+template< class can_config >
+void can_bus< can_config >::tx_irq_handler()
+{
+    auto can = get_can();
+    uint32_t tsr = can->TSR;
+
+    for (uint32_t ok : { CAN_TSR_TXOK0, CAN_TSR_TXOK1, CAN_TSR_TXOK2 }) {
+        // Request completed bit precedes TX OK bit of the same mailbox
+        if (!(tsr & (ok >> 1))) {
+            continue;
+        }
+
+        if (tsr & ok) {
+            ++m_cnt_tx;
+        } else {
+            ++m_cnt_tx_failed;
+        }
+    }
+
+    can->TSR = tsr & rqcp_all;
+
+    fill_mailboxes();
+
+    IRQ_manager::clear(get_tx_irqn());
+    IRQ_manager::unmask(get_tx_irqn());
+}
+
+template< class can_config >
+void can_bus< can_config >::rx0_irq_handler()
+{
+    drain_fifo(0);
+
+    IRQ_manager::clear(get_rx0_irqn());
+    IRQ_manager::unmask(get_rx0_irqn());
+}
+
+template< class can_config >
+void can_bus< can_config >::rx1_irq_handler()
+{
+    drain_fifo(1);
+
+    IRQ_manager::clear(get_rx1_irqn());
+    IRQ_manager::unmask(get_rx1_irqn());
+}
+
+template< class can_config >
+void can_bus< can_config >::sce_irq_handler()
+{
+    auto can = get_can();
+
+    // Interrupt is raised when bus-off is entered, recovery is done by hardware
+    if (can->ESR & CAN_ESR_BOFF) {
+        ++m_cnt_bus_off;
+    }
+
+    can->MSR = CAN_MSR_ERRI;
+
+    IRQ_manager::clear(get_sce_irqn());
+    IRQ_manager::unmask(get_sce_irqn());
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_CAN_BUS_HPP_
@@ -0,0 +1,105 @@
+#ifndef PLATFORM_CLOCK_HPP_
+#define PLATFORM_CLOCK_HPP_
+
+//!
+//! \file
+//! \brief Clock tree of STM32F4, as configured at build time.
+//! Clocks are set up by SystemInit() from the configuration in
+//! rcc_config.h, which defaults to maximum frequency of the device.
+//! Bus drivers use frequencies below to compute prescalers at compile
+//! time, instead of querying RCC registers at runtime.
+//!
+
+#include <stm32f4xx.h>
+#include <rcc_config.h>
+
+#include <cstdint>
+
+namespace ecl
+{
+
+namespace clock
+{
+
+//! System clock, Hz.
+constexpr uint32_t sysclk       = RCC_SYSCLK_FREQ;
+//! AHB clock, Hz. CPU, DMA and GPIO run at this clock.
+constexpr uint32_t hclk         = RCC_HCLK_FREQ;
+//! APB1 clock, Hz.
+constexpr uint32_t pclk1        = RCC_PCLK1_FREQ;
+//! APB2 clock, Hz.
+constexpr uint32_t pclk2        = RCC_PCLK2_FREQ;
+//! Flash wait states.
+constexpr uint32_t flash_latency = RCC_FLASH_LATENCY;
+
+//! \cond
+namespace detail
+{
+
+constexpr bool is_pow2(uint32_t v) { return v && !(v & (v - 1)); }
+
+} // namespace detail
+//! \endcond
+
+static_assert(detail::is_pow2(RCC_HCLK_DIV) && RCC_HCLK_DIV <= 512 && RCC_HCLK_DIV != 32,
+              "AHB prescaler must be 1, 2, 4, .. 512, except 32");
+static_assert(detail::is_pow2(RCC_PCLK1_DIV) && RCC_PCLK1_DIV <= 16,
+              "APB1 prescaler must be 1, 2, 4, 8 or 16");
+static_assert(detail::is_pow2(RCC_PCLK2_DIV) && RCC_PCLK2_DIV <= 16,
+              "APB2 prescaler must be 1, 2, 4, 8 or 16");
+
+static_assert(hclk <= RCC_HCLK_MAX, "AHB clock is out of device limits");
+static_assert(pclk1 <= RCC_PCLK1_MAX, "APB1 clock is out of device limits");
+static_assert(pclk2 <= RCC_PCLK2_MAX, "APB2 clock is out of device limits");
+static_assert(flash_latency <= 7, "Flash latency is out of range");
+
+#if (RCC_SYSCLK_SRC == PLL_CLOCK_SOURCE)
+static_assert(RCC_PLL_M >= 2 && RCC_PLL_M <= 63, "PLL M must be in 2 .. 63");
+static_assert(RCC_PLL_N >= 50 && RCC_PLL_N <= 432, "PLL N must be in 50 .. 432");
+static_assert(RCC_PLL_P == 2 || RCC_PLL_P == 4 || RCC_PLL_P == 6 || RCC_PLL_P == 8,
+              "PLL P must be 2, 4, 6 or 8");
+static_assert(RCC_PLL_Q >= 2 && RCC_PLL_Q <= 15, "PLL Q must be in 2 .. 15");
+static_assert(RCC_PLL_IN_FREQ / RCC_PLL_M >= 1000000 && RCC_PLL_IN_FREQ / RCC_PLL_M <= 2000000,
+              "PLL input must be in 1 .. 2 MHz");
+static_assert(RCC_PLL_VCO_FREQ >= 100000000 && RCC_PLL_VCO_FREQ <= 432000000,
+              "PLL VCO must be in 100 .. 432 MHz");
+#endif
+
+//!
+//! \brief Enables or disables flash prefetch buffer.
+//!
+inline void set_flash_prefetch(bool enable)
+{
+    if (enable) {
+        FLASH->ACR |= FLASH_ACR_PRFTEN;
+    } else {
+        FLASH->ACR &= ~FLASH_ACR_PRFTEN;
+    }
+}
+
+//!
+//! \brief Enables or disables ART instruction and data caches.
+//! Caches are flushed when disabled, so stale lines are not hit after
+//! flash is erased or programmed. Disable caches before such operations
+//! and enable them back after.
+//!
+inline void set_flash_caches(bool enable)
+{
+    constexpr uint32_t caches = FLASH_ACR_ICEN | FLASH_ACR_DCEN;
+    constexpr uint32_t resets = FLASH_ACR_ICRST | FLASH_ACR_DCRST;
+
+    if (enable) {
+        FLASH->ACR |= caches;
+    } else {
+        // Caches can be reset only while disabled
+        FLASH->ACR &= ~caches;
+        FLASH->ACR |= resets;
+        FLASH->ACR &= ~resets;
+    }
+}
+
+} // namespace clock
+
+} // namespace ecl
+
+#endif // PLATFORM_CLOCK_HPP_
@@ -0,0 +1,160 @@
+#ifndef PLATFORM_CRASH_HPP_
+#define PLATFORM_CRASH_HPP_
+
+//!
+//! \file
+//! \brief Records of crashes, kept over resets.
+//! HardFault, MemManage, BusFault and UsageFault handlers save registers,
+//! fault status, top of the stack and the current thread into RAM, that is
+//! not initialized on startup, and reset the part. The record is reported
+//! on the next boot:
+//! \code
+//!     if (ecl::crash::last()) {
+//!         ecl::crash::report(ecl::cout);
+//!         ecl::crash::clear();
+//!     }
+//! \endcode
+//! If debugger is attached, handler stops at a breakpoint instead of reset.
+//! Record is lost on power loss.
+//!
+
+#include <ecl/ostream.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C"
+{
+
+//!
+//! \brief Gets the name of the current thread, called from fault handlers.
+//! Weak, gives nothing by default. Kernel provides it if it tracks threads.
+//! \param[out] name Buffer for the name, not terminated if name is too long.
+//! \param[in]  size Size of the buffer.
+//!
+void ecl_fault_thread(char *name, size_t size);
+
+}
+
+namespace ecl
+{
+
+//!
+//! \brief Crash record.
+//!
+struct crash_record
+{
+    //! Registers, stacked by the processor on exception entry.
+    struct frame
+    {
+        uint32_t r0;
+        uint32_t r1;
+        uint32_t r2;
+        uint32_t r3;
+        uint32_t r12;
+        uint32_t lr;
+        uint32_t pc;    //!< Faulting instruction, or the one after it.
+        uint32_t xpsr;
+    };
+
+    //! Amount of stack words, saved after the frame.
+    static constexpr size_t stack_words = 16;
+
+    uint32_t    magic;          //!< Record is valid if it holds a magic value.
+    uint32_t    crashes;        //!< Amount of crashes since power-up.
+    uint32_t    exception;      //!< Exception number, 3 to 6.
+    frame       regs;           //!< Stacked registers.
+    uint32_t    callee[8];      //!< Callee-saved registers, r4 to r11.
+    uint32_t    sp;             //!< Stack pointer before the exception.
+    uint32_t    exc_return;     //!< EXC_RETURN, tells which stack was used.
+    uint32_t    cfsr;           //!< Configurable fault status.
+    uint32_t    hfsr;           //!< HardFault status.
+    uint32_t    mmfar;          //!< MemManage fault address, valid if CFSR tells so.
+    uint32_t    bfar;           //!< BusFault address, valid if CFSR tells so.
+    uint32_t    stack[stack_words]; //!< Stack after the frame, zeroes outside of RAM.
+    char        thread[16];     //!< Name of the current thread, if known.
+    uint32_t    check;          //!< Sum of the words above.
+};
+
+//!
+//! \brief Access to the crash record of the previous run.
+//!
+class crash
+{
+public:
+    //!
+    //! \brief Gets the record of the last crash.
+    //! \return Record, or nullptr if there was no crash since the last
+    //!         clear() or power-up.
+    //!
+    static const crash_record *last();
+
+    //!
+    //! \brief Discards the record. Crash counter is kept.
+    //!
+    static void clear();
+
+    //!
+    //! \brief Gets amount of crashes since power-up.
+    //!
+    static uint32_t count();
+
+    //!
+    //! \brief Prints the last crash record, if any.
+    //! \param[in] os Output stream.
+    //!
+    template< class Stream >
+    static void report(Stream &os);
+};
+
+//------------------------------------------------------------------------------
+
+template< class Stream >
+void crash::report(Stream &os)
+{
+    auto rec = last();
+
+    if (!rec) {
+        return;
+    }
+
+    static const char * const names[] = { "HardFault", "MemManage", "BusFault", "UsageFault" };
+    const char *name = rec->exception >= 3 && rec->exception <= 6
+            ? names[rec->exception - 3] : "Fault";
+
+    os << "Crash #" << rec->crashes << ": " << name;
+    if (rec->thread[0]) {
+        char thread[sizeof(rec->thread) + 1] = {};
+        for (size_t i = 0; i < sizeof(rec->thread); ++i) {
+            thread[i] = rec->thread[i];
+        }
+
+        os << " in " << thread;
+    }
+
+    os << ecl::endl << ecl::hex;
+    os << "pc " << rec->regs.pc << " lr " << rec->regs.lr << " sp " << rec->sp
+       << " xpsr " << rec->regs.xpsr << ecl::endl;
+    os << "r0 " << rec->regs.r0 << " r1 " << rec->regs.r1 << " r2 " << rec->regs.r2
+       << " r3 " << rec->regs.r3 << " r12 " << rec->regs.r12 << ecl::endl;
+
+    os << "r4-r11";
+    for (auto r : rec->callee) {
+        os << ' ' << r;
+    }
+
+    os << ecl::endl;
+    os << "cfsr " << rec->cfsr << " hfsr " << rec->hfsr
+       << " mmfar " << rec->mmfar << " bfar " << rec->bfar << ecl::endl;
+
+    os << "stack";
+    for (auto w : rec->stack) {
+        os << ' ' << w;
+    }
+
+    os << ecl::dec << ecl::endl;
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_CRASH_HPP_
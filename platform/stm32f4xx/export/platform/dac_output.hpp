@@ -0,0 +1,598 @@
+//!
+//! \file
+//! \brief STM32F4xx timer-triggered DAC waveform output engine
+//!
+
+#ifndef PLATFORM_DAC_OUTPUT_HPP_
+#define PLATFORM_DAC_OUTPUT_HPP_
+
+#include <platform/common/bus.hpp>
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+#include <ecl/lookup_table.hpp>
+
+#include <stm32f4xx_dac.h>
+#include <stm32f4xx_tim.h>
+#include <stm32f4xx_rcc.h>
+
+#include <platform/irq_manager.hpp>
+#include <platform/clock.hpp>
+#include <platform/dma_device.hpp>
+#include <platform/dma_manager.hpp>
+
+#include <cstdint>
+#include <cstddef>
+
+namespace ecl
+{
+
+//!
+//! \brief Configuration of DAC output.
+//! See reference manual for DMA request mapping: DAC channel 1 is served by
+//! DMA1 stream 5, channel 7, DAC channel 2 by DMA1 stream 6, channel 7.
+//! Output pin, PA4 for channel 1 and PA5 for channel 2, must be configured
+//! as analog.
+//! \tparam dac_channel     DAC channel: DAC_Channel_1 or DAC_Channel_2.
+//! \tparam timer           Base address of the timer, which update event
+//!                         triggers a conversion: TIM2_BASE, TIM4_BASE,
+//!                         TIM5_BASE, TIM6_BASE, TIM7_BASE or TIM8_BASE.
+//! \tparam dma_stream      DMA stream used to move samples.
+//! \tparam dma_channel     DMA channel of the stream.
+//! \tparam output_buffer   Output buffer of the DAC: DAC_OutputBuffer_Enable
+//!                         lowers output impedance, but output can't reach
+//!                         the rails. DAC_OutputBuffer_Disable otherwise.
+//!
+template< uint32_t          dac_channel,
+          std::uintptr_t    timer,
+          std::uintptr_t    dma_stream,
+          uint32_t          dma_channel,
+          uint32_t          output_buffer = DAC_OutputBuffer_Enable >
+struct dac_config
+{
+    static constexpr uint32_t           m_dac_channel      = dac_channel;
+    static constexpr std::uintptr_t     m_timer            = timer;
+    static constexpr std::uintptr_t     m_dma_stream       = dma_stream;
+    static constexpr uint32_t           m_dma_channel      = dma_channel;
+    static constexpr uint32_t           m_output_buffer    = output_buffer;
+
+    //! Streams claimed by the output. \sa dma::exclusive_streams
+    using dma_streams = dma::stream_list< dma_stream >;
+
+    static_assert(dac_channel == DAC_Channel_1 || dac_channel == DAC_Channel_2,
+                  "Unknown DAC channel");
+};
+
+//!
+//! \brief Continuous DAC waveform output.
+//! Timer triggers a conversion at configured rate. Each trigger moves
+//! next sample from double buffers to the DAC, by DMA, so CPU is not
+//! involved per sample, only once per buffer. Samples are 12-bit, right
+//! aligned.
+//! Handler follows streaming semantics of platform buses:
+//! \li TX event::ht is reported when first buffer is sent to the DAC,
+//!     so it can be refilled while the second one is played.
+//! \li TX event::tc is reported when second buffer is sent to the DAC.
+//! \li TX event::err is reported if DAC underruns, i.e. DMA is not able to
+//!     keep up with the rate. Output is stopped then.
+//! \li Meta-channel TC event is reported when output is stopped.
+//! Total amount of samples sent so far is reported with each event.
+//! Buffer just sent must be refilled before the other one is sent,
+//! otherwise it is played again. For periodic waveforms, buffers may be
+//! filled once and left as is.
+//! Underrun IRQ is shared by both DAC channels, so only one output can exist.
+//! \tparam dac_config Output configuration. \sa dac_config
+//!
+template< class dac_config >
+class dac_output
+{
+public:
+    // Convinient type aliases.
+    using channel       = ecl::bus_channel;
+    using event         = ecl::bus_event;
+    using handler_fn    = ecl::bus_handler;
+
+    //! Largest sample value.
+    static constexpr uint16_t max_sample = 0xfff;
+
+    //!
+    //! \brief Constructs an output.
+    //!
+    dac_output();
+
+    //!
+    //! \brief Destructs an output.
+    ~dac_output();
+
+    //!
+    //! \brief Lazy initialization.
+    //! \return Status of opeartion.
+    //!
+    ecl::err init();
+
+    //!
+    //! \brief Sets double buffers of samples.
+    //! If second buffer is null, first one is used instead.
+    //! \pre Output is stopped.
+    //! \param[in]  buf0    First buffer.
+    //! \param[in]  buf1    Second buffer. Optional.
+    //! \param[in]  size    Size of each buffer, in samples.
+    //! \retval err::ok     Buffers are set.
+    //! \retval err::inval  Buffer is null or size is invalid.
+    //! \retval err::busy   Output is in progress.
+    //!
+    ecl::err set_buffers(const uint16_t *buf0, const uint16_t *buf1, size_t size);
+
+    //!
+    //! \brief Sets event handler.
+    //! Handler will be used by the output, until reset_handler() will be called.
+    //! \param[in] handler Handler itself.
+    //!
+    void set_handler(const handler_fn &handler);
+
+    //!
+    //! \brief Resets previously set handler.
+    //!
+    void reset_handler();
+
+    //!
+    //! \brief Starts output.
+    //! Timer is set to the closest achievable rate. First sample appears
+    //! at the output after full timer period.
+    //! \param[in] rate Samples per second.
+    //! \retval err::ok     Output is started.
+    //! \retval err::perm   Output is not initialized.
+    //! \retval err::nobufs Buffers are not set.
+    //! \retval err::inval  Rate is zero or too high for the timer.
+    //! \retval err::busy   Output is already started or DMA stream is
+    //!                     leased by someone else.
+    //!
+    ecl::err start(uint32_t rate);
+
+    //!
+    //! \brief Stops output.
+    //! DAC is disabled, so the pin is left floating.
+    //! Handler will be invoked with meta-channel TC event.
+    //! \retval err::ok     Output is stopped.
+    //! \retval err::perm   Output is not started.
+    //!
+    ecl::err stop();
+
+    //!
+    //! \brief Gets actual sample rate, set by the last start().
+    //!
+    uint32_t rate() const;
+
+private:
+    //! Timer properties.
+    struct timer_info
+    {
+        uint32_t    trigger;    //!< DAC trigger source.
+        uint32_t    rcc;        //!< Clock enable bit of the timer.
+        bool        apb2;       //!< Timer lies on APB2 bus.
+    };
+
+    //! Picks timer properties at compile time.
+    static constexpr timer_info pick_timer_info();
+    //! Converts to proper timer type.
+    static constexpr auto pick_timer();
+    //! Gets clock of the timer. Timers run at twice the APB clock,
+    //! unless APB prescaler is 1.
+    static constexpr uint32_t pick_timer_clk();
+    //! Gets address of the data holding register of the channel.
+    static constexpr uint32_t pick_dhr();
+
+    //! Configures DAC channel.
+    void configure_dac();
+
+    //! Configures timer for given rate.
+    ecl::err configure_timer(uint32_t rate);
+
+    //! Prepares and starts DMA stream.
+    void start_dma();
+
+    //! Stops timer, DAC and DMA.
+    void halt();
+
+    //! Handles DMA IRQ events.
+    void dma_irq_handler();
+
+    //! Handles DAC IRQ events.
+    void irq_handler();
+
+    //! DMA IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void dma_irq_entry();
+
+    //! DAC IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void irq_entry();
+
+    //! Output is inited if this flag is set.
+    static constexpr uint8_t inited         = 0x1;
+    //! Output is in progress if this flag is set.
+    static constexpr uint8_t playing        = 0x2;
+
+    handler_fn      m_event_handler;            //! Handler passed via set_handler().
+    const uint16_t  *m_buf0;                    //! First buffer.
+    const uint16_t  *m_buf1;                    //! Second buffer.
+    size_t          m_size;                     //! Size of each buffer, in samples.
+    size_t          m_sent;                     //! Samples sent since start().
+    uint32_t        m_rate;                     //! Actual sample rate.
+    uint8_t         m_status;                   //! Represents output status.
+
+    //! Output object, served by IRQ entries. Only one object can exist.
+    static dac_output *m_instance;
+};
+
+template< class dac_config >
+dac_output< dac_config > *dac_output< dac_config >::m_instance{nullptr};
+
+template< class dac_config >
+dac_output< dac_config >::dac_output()
+    :m_event_handler{}
+    ,m_buf0{nullptr}
+    ,m_buf1{nullptr}
+    ,m_size{0}
+    ,m_sent{0}
+    ,m_rate{0}
+    ,m_status{0}
+{
+
+}
+
+template< class dac_config >
+dac_output< dac_config >::~dac_output()
+{
+
+}
+
+template< class dac_config >
+ecl::err dac_output< dac_config >::init()
+{
+    if (m_status & inited) {
+        return ecl::err::ok;
+    }
+
+    constexpr auto info = pick_timer_info();
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_DAC, ENABLE);
+
+    if (info.apb2) {
+        RCC_APB2PeriphClockCmd(info.rcc, ENABLE);
+    } else {
+        RCC_APB1PeriphClockCmd(info.rcc, ENABLE);
+    }
+
+    dma::init_rcc< dac_config::m_dma_stream >();
+
+    ecl_assert(!m_instance || m_instance == this);
+    m_instance = this;
+
+    IRQ_manager::mask(TIM6_DAC_IRQn);
+    IRQ_manager::clear(TIM6_DAC_IRQn);
+    IRQ_manager::subscribe(TIM6_DAC_IRQn, irq_entry);
+    IRQ_manager::unmask(TIM6_DAC_IRQn);
+
+    m_status |= inited;
+    return ecl::err::ok;
+}
+
+template< class dac_config >
+ecl::err dac_output< dac_config >::set_buffers(const uint16_t *buf0, const uint16_t *buf1,
+                                                 size_t size)
+{
+    if (m_status & playing) {
+        return ecl::err::busy;
+    }
+
+    // DMA counter is 16-bit wide
+    if (!buf0 || !size || size > 0xffff) {
+        return ecl::err::inval;
+    }
+
+    m_buf0 = buf0;
+    m_buf1 = buf1 ? buf1 : buf0;
+    m_size = size;
+
+    return ecl::err::ok;
+}
+
+template< class dac_config >
+void dac_output< dac_config >::set_handler(const handler_fn &handler)
+{
+    // It is possible (and recommended) to set handler before init.
+    m_event_handler = handler;
+}
+
+template< class dac_config >
+void dac_output< dac_config >::reset_handler()
+{
+    m_event_handler = handler_fn{};
+}
+
+template< class dac_config >
+ecl::err dac_output< dac_config >::start(uint32_t rate)
+{
+    if (!(m_status & inited)) {
+        return ecl::err::perm;
+    }
+
+    if (m_status & playing) {
+        return ecl::err::busy;
+    }
+
+    if (!m_size) {
+        return ecl::err::nobufs;
+    }
+
+    auto rc = configure_timer(rate);
+    if (is_error(rc)) {
+        return rc;
+    }
+
+    rc = dma::stream_lease< dac_config::m_dma_stream >::acquire(this, dma_irq_entry);
+    if (is_error(rc)) {
+        return rc;
+    }
+
+    constexpr auto ch    = dac_config::m_dac_channel;
+    constexpr auto timer = pick_timer();
+
+    m_sent = 0;
+    m_status |= playing;
+
+    configure_dac();
+    start_dma();
+
+    DAC_ClearFlag(ch, DAC_FLAG_DMAUDR);
+    DAC_ITConfig(ch, DAC_IT_DMAUDR, ENABLE);
+
+    DAC_DMACmd(ch, ENABLE);
+    DAC_Cmd(ch, ENABLE);
+
+    TIM_SetCounter(timer, 0);
+    TIM_Cmd(timer, ENABLE);
+
+    return ecl::err::ok;
+}
+
+template< class dac_config >
+ecl::err dac_output< dac_config >::stop()
+{
+    if (!(m_status & playing)) {
+        return ecl::err::perm;
+    }
+
+    constexpr auto irqn = dma::get_irqn< dac_config::m_dma_stream >();
+
+    // Prevent stream events from being delivered while stream is stopped
+    IRQ_manager::mask(irqn);
+    IRQ_manager::mask(TIM6_DAC_IRQn);
+
+    halt();
+
+    IRQ_manager::clear(TIM6_DAC_IRQn);
+    IRQ_manager::unmask(TIM6_DAC_IRQn);
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+
+    m_event_handler(channel::meta, event::tc, 0);
+
+    return ecl::err::ok;
+}
+
+template< class dac_config >
+uint32_t dac_output< dac_config >::rate() const
+{
+    return m_rate;
+}
+
+// -----------------------------------------------------------------------------
+// Private members
+
+template< class dac_config >
+constexpr typename dac_output< dac_config >::timer_info dac_output< dac_config >::pick_timer_info()
+{
+    // APB1 - TIM2 TIM4 TIM5 TIM6 TIM7
+    // APB2 - TIM8
+    constexpr auto timers = make_lookup_table< std::uintptr_t, timer_info >({
+        { TIM2_BASE, { DAC_Trigger_T2_TRGO, RCC_APB1Periph_TIM2, false } },
+        { TIM4_BASE, { DAC_Trigger_T4_TRGO, RCC_APB1Periph_TIM4, false } },
+        { TIM5_BASE, { DAC_Trigger_T5_TRGO, RCC_APB1Periph_TIM5, false } },
+        { TIM6_BASE, { DAC_Trigger_T6_TRGO, RCC_APB1Periph_TIM6, false } },
+        { TIM7_BASE, { DAC_Trigger_T7_TRGO, RCC_APB1Periph_TIM7, false } },
+        { TIM8_BASE, { DAC_Trigger_T8_TRGO, RCC_APB2Periph_TIM8, true  } },
+    });
+
+    static_assert(timers.contains(dac_config::m_timer),
+                  "Only TIM2, TIM4-TIM8 can trigger DAC by update event");
+
+    return timers[dac_config::m_timer];
+}
+
+template< class dac_config >
+constexpr auto dac_output< dac_config >::pick_timer()
+{
+    return reinterpret_cast< TIM_TypeDef * >(dac_config::m_timer);
+}
+
+template< class dac_config >
+constexpr uint32_t dac_output< dac_config >::pick_timer_clk()
+{
+    if (pick_timer_info().apb2) {
+        return RCC_PCLK2_DIV == 1 ? clock::pclk2 : clock::pclk2 * 2;
+    }
+
+    return RCC_PCLK1_DIV == 1 ? clock::pclk1 : clock::pclk1 * 2;
+}
+
+template< class dac_config >
+constexpr uint32_t dac_output< dac_config >::pick_dhr()
+{
+    return dac_config::m_dac_channel == DAC_Channel_1
+            ? DAC_BASE + offsetof(DAC_TypeDef, DHR12R1)
+            : DAC_BASE + offsetof(DAC_TypeDef, DHR12R2);
+}
+
+template< class dac_config >
+void dac_output< dac_config >::configure_dac()
+{
+    DAC_InitTypeDef init_struct;
+    DAC_StructInit(&init_struct);
+
+    init_struct.DAC_Trigger         = pick_timer_info().trigger;
+    init_struct.DAC_WaveGeneration  = DAC_WaveGeneration_None;
+    init_struct.DAC_OutputBuffer    = dac_config::m_output_buffer;
+
+    DAC_Cmd(dac_config::m_dac_channel, DISABLE);
+    DAC_Init(dac_config::m_dac_channel, &init_struct);
+}
+
+template< class dac_config >
+ecl::err dac_output< dac_config >::configure_timer(uint32_t rate)
+{
+    constexpr auto timer     = pick_timer();
+    constexpr auto timer_clk = pick_timer_clk();
+
+    if (!rate || rate > timer_clk / 2) {
+        return ecl::err::inval;
+    }
+
+    // Counter is treated as 16-bit, even if the timer is wider
+    uint32_t ticks = timer_clk / rate;
+    uint32_t presc = (ticks - 1) / 0x10000;
+    uint32_t period = ticks / (presc + 1);
+
+    TIM_TimeBaseInitTypeDef init_struct;
+    TIM_TimeBaseStructInit(&init_struct);
+
+    init_struct.TIM_Prescaler       = presc;
+    init_struct.TIM_CounterMode     = TIM_CounterMode_Up;
+    init_struct.TIM_Period          = period - 1;
+    init_struct.TIM_ClockDivision   = TIM_CKD_DIV1;
+
+    TIM_Cmd(timer, DISABLE);
+    TIM_TimeBaseInit(timer, &init_struct);
+    TIM_SelectOutputTrigger(timer, TIM_TRGOSource_Update);
+
+    m_rate = timer_clk / ((presc + 1) * period);
+
+    return ecl::err::ok;
+}
+
+template< class dac_config >
+void dac_output< dac_config >::start_dma()
+{
+    constexpr auto stream   = dma::get_stream< dac_config::m_dma_stream >();
+
+    DMA_InitTypeDef dma_init;
+    DMA_StructInit(&dma_init);
+
+    dma_init.DMA_Channel             = dac_config::m_dma_channel;
+    dma_init.DMA_DIR                 = DMA_DIR_MemoryToPeripheral;
+    dma_init.DMA_PeripheralBaseAddr  = pick_dhr();
+    dma_init.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+    dma_init.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+    dma_init.DMA_PeripheralDataSize  = DMA_PeripheralDataSize_HalfWord;
+    dma_init.DMA_MemoryDataSize      = DMA_MemoryDataSize_HalfWord;
+    dma_init.DMA_Mode                = DMA_Mode_Circular;
+    dma_init.DMA_Priority            = DMA_Priority_High;
+    dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(m_buf0);
+    dma_init.DMA_BufferSize          = m_size;
+
+    dma::disable< dac_config::m_dma_stream >();
+    DMA_DeInit(stream);
+    DMA_Init(stream, &dma_init);
+    dma::enable_double_buffer< dac_config::m_dma_stream >(m_buf1);
+    dma::enable_irq< dac_config::m_dma_stream, DMA_IT_TC | DMA_IT_TE >();
+    dma::enable< dac_config::m_dma_stream >();
+}
+
+template< class dac_config >
+void dac_output< dac_config >::halt()
+{
+    constexpr auto ch       = dac_config::m_dac_channel;
+    constexpr auto timer    = pick_timer();
+    constexpr auto stream   = dma::get_stream< dac_config::m_dma_stream >();
+
+    TIM_Cmd(timer, DISABLE);
+
+    DAC_ITConfig(ch, DAC_IT_DMAUDR, DISABLE);
+    DAC_DMACmd(ch, DISABLE);
+    DAC_Cmd(ch, DISABLE);
+
+    dma::disable< dac_config::m_dma_stream >();
+    DMA_DeInit(stream);
+
+    dma::stream_lease< dac_config::m_dma_stream >::release();
+
+    m_status &= ~(playing);
+}
+
+template< class dac_config >
+void dac_output< dac_config >::dma_irq_entry()
+{
+    m_instance->dma_irq_handler();
+}
+
+template< class dac_config >
+void dac_output< dac_config >::irq_entry()
+{
+    m_instance->irq_handler();
+}
+
+template< class dac_config >
+void dac_output< dac_config >::dma_irq_handler()
+{
+    constexpr auto stream   = dac_config::m_dma_stream;
+    constexpr auto tc_if    = dma::get_tc_if< stream >();
+    constexpr auto err_if   = dma::get_err_if< stream >();
+    constexpr auto irqn     = dma::get_irqn< stream >();
+
+    if (dma::get_it_status< stream, err_if >()) {
+        dma::clear_flags< stream, err_if >();
+
+        halt();
+        m_event_handler(channel::tx, event::err, m_sent);
+        m_event_handler(channel::meta, event::tc, 0);
+    } else if (dma::get_it_status< stream, tc_if >()) {
+        dma::clear_flags< stream, tc_if >();
+
+        // At this point DMA already switched to the other memory target,
+        // thus sent buffer is the one that is not used now.
+        auto type = dma::get_memory_target< stream >() ? event::ht : event::tc;
+
+        m_sent += m_size;
+        m_event_handler(channel::tx, type, m_sent);
+    }
+
+    // Stream is left running, so IRQ must be enabled back
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+}
+
+template< class dac_config >
+void dac_output< dac_config >::irq_handler()
+{
+    constexpr auto ch = dac_config::m_dac_channel;
+
+    if (DAC_GetITStatus(ch, DAC_IT_DMAUDR) == SET) {
+        DAC_ClearITPendingBit(ch, DAC_IT_DMAUDR);
+
+        // DAC stops requesting DMA after underrun, samples up to the
+        // current position were sent
+        size_t sent = m_sent + m_size
+                - dma::get_counter< dac_config::m_dma_stream >();
+
+        if (m_status & playing) {
+            halt();
+            m_event_handler(channel::tx, event::err, sent);
+            m_event_handler(channel::meta, event::tc, 0);
+        }
+    }
+
+    IRQ_manager::clear(TIM6_DAC_IRQn);
+    IRQ_manager::unmask(TIM6_DAC_IRQn);
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_DAC_OUTPUT_HPP_
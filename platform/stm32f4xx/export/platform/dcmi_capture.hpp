@@ -0,0 +1,692 @@
+//!
+//! \file
+//! \brief STM32F4xx DCMI camera capture engine
+//!
+
+#ifndef PLATFORM_DCMI_CAPTURE_HPP_
+#define PLATFORM_DCMI_CAPTURE_HPP_
+
+#include <platform/common/bus.hpp>
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+#include <ecl/inplace_function.hpp>
+
+#include <stm32f4xx_dcmi.h>
+#include <stm32f4xx_rcc.h>
+
+#include <platform/irq_manager.hpp>
+#include <platform/memory.hpp>
+#include <platform/dma_device.hpp>
+#include <platform/dma_manager.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace ecl
+{
+
+//!
+//! \brief Configuration of DCMI capture.
+//! DCMI is served by DMA2 channel 1, on stream 1 or stream 7. Pins (PIXCLK,
+//! HSYNC, VSYNC and data lines) must be configured as alternate function.
+//! Sensor itself is configured by its own driver, i.e. over I2C, so that
+//! its output matches signals below.
+//! \tparam dma_stream      DMA stream used to move pixels.
+//! \tparam dma_channel     DMA channel of the stream.
+//! \tparam frames          Most frame buffers in the pool, 1 .. 32.
+//! \tparam pck_polarity    Edge of pixel clock data is sampled on:
+//!                         DCMI_PCKPolarity_Rising or DCMI_PCKPolarity_Falling.
+//! \tparam vs_polarity     Level of VSYNC during blanking: DCMI_VSPolarity_Low
+//!                         or DCMI_VSPolarity_High.
+//! \tparam hs_polarity     Level of HSYNC during blanking: DCMI_HSPolarity_Low
+//!                         or DCMI_HSPolarity_High.
+//! \tparam data_mode       Width of data bus, i.e. DCMI_ExtendedDataMode_8b.
+//!
+template< std::uintptr_t    dma_stream,
+          uint32_t          dma_channel,
+          size_t            frames          = 4,
+          uint16_t          pck_polarity    = DCMI_PCKPolarity_Rising,
+          uint16_t          vs_polarity     = DCMI_VSPolarity_Low,
+          uint16_t          hs_polarity     = DCMI_HSPolarity_Low,
+          uint16_t          data_mode       = DCMI_ExtendedDataMode_8b >
+struct dcmi_config
+{
+    static constexpr std::uintptr_t     m_dma_stream    = dma_stream;
+    static constexpr uint32_t           m_dma_channel   = dma_channel;
+    static constexpr size_t             m_frames        = frames;
+    static constexpr uint16_t           m_pck_polarity  = pck_polarity;
+    static constexpr uint16_t           m_vs_polarity   = vs_polarity;
+    static constexpr uint16_t           m_hs_polarity   = hs_polarity;
+    static constexpr uint16_t           m_data_mode     = data_mode;
+
+    //! Streams claimed by the capture. \sa dma::exclusive_streams
+    using dma_streams = dma::stream_list< dma_stream >;
+
+    static_assert(frames >= 1 && frames <= 32, "Pool must hold 1 .. 32 frames");
+    static_assert((dma_stream == DMA2_Stream1_BASE || dma_stream == DMA2_Stream7_BASE)
+                  && dma_channel == DMA_Channel_1,
+                  "DCMI is served by DMA2 stream 1 or 7, channel 1");
+};
+
+//!
+//! \brief Camera capture into a pool of frame buffers.
+//! Frames are moved by DMA from the DCMI, so CPU is involved only once
+//! per frame. Buffers are given with set_frames() and handed out, one
+//! captured frame at a time, to the frame handler. Frame belongs to the
+//! caller then, until release(), so it can be processed while next
+//! frames are captured:
+//! \code
+//! PLATFORM_DMA_RAM static uint8_t frames[3][160 * 120 * 2]; // QQVGA, RGB565
+//! uint8_t *list[] = { frames[0], frames[1], frames[2] };
+//!
+//! cam.set_frames(list, 3, sizeof(frames[0]));
+//! cam.set_frame_handler([](uint8_t *frame, size_t size) { queue.push(frame); });
+//! cam.start();
+//! ...
+//! queue.pop(frame);   // In a thread
+//! process(frame);
+//! cam.release(frame);
+//! \endcode
+//! Continuous capture keeps two frames in DMA double-buffer mode. Once a
+//! frame is captured, free one replaces it, while the other is being
+//! captured. If no frame is free, captured one is not handed out and is
+//! overwritten by a frame after next, see dropped(). Thus continuous
+//! capture requires two frames, and at least three to process frames
+//! without drops. Snapshot takes one frame and stops.
+//! Larger frames may reside in external RAM, attached by FSMC.
+//! Frame is complete when its buffer is full, thus frame size must match
+//! output of the sensor exactly, e.g. width x height x 2 for RGB565.
+//! Handler follows streaming semantics of platform buses:
+//! \li RX event::err is reported if DCMI overruns, detects sync error or
+//!     DMA fails. Capture is stopped then.
+//! \li Meta-channel TC event is reported when capture is stopped,
+//!     including the end of snapshot.
+//! Total amount of frames captured so far is reported with each event.
+//! \tparam dcmi_config Capture configuration. \sa dcmi_config
+//!
+template< class dcmi_config >
+class dcmi_capture
+{
+public:
+    // Convinient type aliases.
+    using channel       = ecl::bus_channel;
+    using event         = ecl::bus_event;
+    using handler_fn    = ecl::bus_handler;
+    //! Gets captured frame, now owned by the caller. Invoked from IRQ.
+    using frame_fn      = ecl::inplace_function< void(uint8_t *frame, size_t size) >;
+
+    //!
+    //! \brief Constructs a capture.
+    //!
+    dcmi_capture();
+
+    //!
+    //! \brief Destructs a capture.
+    ~dcmi_capture();
+
+    //!
+    //! \brief Lazy initialization.
+    //! \return Status of opeartion.
+    //!
+    ecl::err init();
+
+    //!
+    //! \brief Sets frame buffers of the pool. All of them become free.
+    //! \pre Capture is stopped and no frame is held by the caller.
+    //! \param[in]  frames  Frame buffers, word-aligned and DMA-capable.
+    //! \param[in]  count   Amount of frames.
+    //! \param[in]  size    Size of each frame, in bytes.
+    //! \retval err::ok     Frames are set.
+    //! \retval err::inval  Frame is misplaced or amount or size is invalid.
+    //! \retval err::busy   Capture is in progress.
+    //!
+    ecl::err set_frames(uint8_t *const *frames, size_t count, size_t size);
+
+    //!
+    //! \brief Returns frame, handed out by the frame handler, to the pool.
+    //! Can be called from any context.
+    //! \param[in] frame Frame to release.
+    //! \retval err::ok     Frame is free.
+    //! \retval err::inval  Frame is not from the pool or it is free already.
+    //!
+    ecl::err release(uint8_t *frame);
+
+    //!
+    //! \brief Sets frame handler.
+    //! \pre Capture is stopped.
+    //! \param[in] fn Frame handler.
+    //!
+    void set_frame_handler(const frame_fn &fn);
+
+    //!
+    //! \brief Sets event handler.
+    //! Handler will be used by the capture, until reset_handler() will be called.
+    //! \param[in] handler Handler itself.
+    //!
+    void set_handler(const handler_fn &handler);
+
+    //!
+    //! \brief Resets previously set handler.
+    //!
+    void reset_handler();
+
+    //!
+    //! \brief Starts continuous capture, from the next frame of the sensor.
+    //! \retval err::ok     Capture is started.
+    //! \retval err::perm   Capture is not initialized.
+    //! \retval err::nobufs Less than two frames are free.
+    //! \retval err::busy   Capture is already started or DMA stream is
+    //!                     leased by someone else.
+    //!
+    ecl::err start();
+
+    //!
+    //! \brief Captures single frame, from the next frame of the sensor.
+    //! \retval err::ok     Capture is started.
+    //! \retval err::perm   Capture is not initialized.
+    //! \retval err::nobufs No frame is free.
+    //! \retval err::busy   Capture is already started or DMA stream is
+    //!                     leased by someone else.
+    //!
+    ecl::err snapshot();
+
+    //!
+    //! \brief Stops capture. Frames held by DMA become free.
+    //! Handler will be invoked with meta-channel TC event.
+    //! \retval err::ok     Capture is stopped.
+    //! \retval err::perm   Capture is not started.
+    //!
+    ecl::err stop();
+
+    //!
+    //! \brief Gets amount of frames handed out since start.
+    //!
+    size_t captured() const;
+
+    //!
+    //! \brief Gets amount of frames overwritten since start, because no
+    //! frame was free.
+    //!
+    size_t dropped() const;
+
+private:
+    //! Takes free frame out of the pool.
+    //! \return Frame or nullptr if none is free.
+    uint8_t *acquire();
+
+    //! Returns frame to the pool. No checks are made.
+    void put_back(uint8_t *frame);
+
+    //! Gets index of the frame in the pool or -1 if it is not there.
+    int index_of(const uint8_t *frame) const;
+
+    //! Starts capture in given DCMI mode.
+    ecl::err begin(uint16_t mode);
+
+    //! Configures DCMI.
+    void configure_dcmi(uint16_t mode);
+
+    //! Prepares and starts DMA stream.
+    void start_dma(bool circular);
+
+    //! Stops DCMI and DMA, frames held by DMA are put back.
+    void halt();
+
+    //! Stops capture due to error and reports it.
+    void fail();
+
+    //! Handles DMA IRQ events.
+    void dma_irq_handler();
+
+    //! Handles DCMI IRQ events.
+    void irq_handler();
+
+    //! DMA IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void dma_irq_entry();
+
+    //! DCMI IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void irq_entry();
+
+    //! Capture is inited if this flag is set.
+    static constexpr uint8_t inited         = 0x1;
+    //! Capture is in progress if this flag is set.
+    static constexpr uint8_t capturing      = 0x2;
+    //! Single frame is captured if this flag is set.
+    static constexpr uint8_t single         = 0x4;
+
+    handler_fn              m_event_handler;    //! Handler passed via set_handler().
+    frame_fn                m_frame_handler;    //! Handler passed via set_frame_handler().
+    uint8_t                 *m_frames[dcmi_config::m_frames]; //! Pool of frames.
+    std::atomic< uint32_t > m_free;             //! Mask of free frames in the pool.
+    uint8_t                 *m_slots[2];        //! Frames held by DMA, by memory target.
+    size_t                  m_count;            //! Amount of frames in the pool.
+    size_t                  m_size;             //! Size of each frame, in bytes.
+    size_t                  m_captured;         //! Frames handed out since start.
+    size_t                  m_dropped;          //! Frames overwritten since start.
+    uint8_t                 m_status;           //! Represents capture status.
+
+    //! Capture object, served by IRQ entries. Only one object can exist.
+    static dcmi_capture *m_instance;
+};
+
+template< class dcmi_config >
+dcmi_capture< dcmi_config > *dcmi_capture< dcmi_config >::m_instance{nullptr};
+
+template< class dcmi_config >
+dcmi_capture< dcmi_config >::dcmi_capture()
+    :m_event_handler{}
+    ,m_frame_handler{}
+    ,m_frames{}
+    ,m_free{0}
+    ,m_slots{nullptr, nullptr}
+    ,m_count{0}
+    ,m_size{0}
+    ,m_captured{0}
+    ,m_dropped{0}
+    ,m_status{0}
+{
+
+}
+
+template< class dcmi_config >
+dcmi_capture< dcmi_config >::~dcmi_capture()
+{
+
+}
+
+template< class dcmi_config >
+ecl::err dcmi_capture< dcmi_config >::init()
+{
+    if (m_status & inited) {
+        return ecl::err::ok;
+    }
+
+    RCC_AHB2PeriphClockCmd(RCC_AHB2Periph_DCMI, ENABLE);
+    dma::init_rcc< dcmi_config::m_dma_stream >();
+
+    ecl_assert(!m_instance || m_instance == this);
+    m_instance = this;
+
+    IRQ_manager::mask(DCMI_IRQn);
+    IRQ_manager::clear(DCMI_IRQn);
+    IRQ_manager::subscribe(DCMI_IRQn, irq_entry);
+    IRQ_manager::unmask(DCMI_IRQn);
+
+    m_status |= inited;
+    return ecl::err::ok;
+}
+
+template< class dcmi_config >
+ecl::err dcmi_capture< dcmi_config >::set_frames(uint8_t *const *frames, size_t count,
+                                                   size_t size)
+{
+    if (m_status & capturing) {
+        return ecl::err::busy;
+    }
+
+    // DMA moves words, its counter is 16-bit wide
+    if (!frames || !count || count > dcmi_config::m_frames
+            || !size || size % 4 || size / 4 > 0xffff) {
+        return ecl::err::inval;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!frames[i] || reinterpret_cast< std::uintptr_t >(frames[i]) % 4
+                || !dma_capable(frames[i])) {
+            return ecl::err::inval;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        m_frames[i] = frames[i];
+    }
+
+    m_count = count;
+    m_size = size;
+    m_free = count == 32 ? ~0u : (1u << count) - 1;
+
+    return ecl::err::ok;
+}
+
+template< class dcmi_config >
+ecl::err dcmi_capture< dcmi_config >::release(uint8_t *frame)
+{
+    int idx = index_of(frame);
+    if (idx < 0) {
+        return ecl::err::inval;
+    }
+
+    uint32_t bit = 1u << idx;
+    if (m_free.fetch_or(bit) & bit) {
+        return ecl::err::inval;
+    }
+
+    return ecl::err::ok;
+}
+
+template< class dcmi_config >
+void dcmi_capture< dcmi_config >::set_frame_handler(const frame_fn &fn)
+{
+    ecl_assert(!(m_status & capturing));
+    m_frame_handler = fn;
+}
+
+template< class dcmi_config >
+void dcmi_capture< dcmi_config >::set_handler(const handler_fn &handler)
+{
+    // It is possible (and recommended) to set handler before init.
+    m_event_handler = handler;
+}
+
+template< class dcmi_config >
+void dcmi_capture< dcmi_config >::reset_handler()
+{
+    m_event_handler = handler_fn{};
+}
+
+template< class dcmi_config >
+ecl::err dcmi_capture< dcmi_config >::start()
+{
+    return begin(DCMI_CaptureMode_Continuous);
+}
+
+template< class dcmi_config >
+ecl::err dcmi_capture< dcmi_config >::snapshot()
+{
+    return begin(DCMI_CaptureMode_SnapShot);
+}
+
+template< class dcmi_config >
+ecl::err dcmi_capture< dcmi_config >::stop()
+{
+    if (!(m_status & capturing)) {
+        return ecl::err::perm;
+    }
+
+    constexpr auto irqn = dma::get_irqn< dcmi_config::m_dma_stream >();
+
+    // Prevent stream events from being delivered while stream is stopped
+    IRQ_manager::mask(irqn);
+    IRQ_manager::mask(DCMI_IRQn);
+
+    halt();
+
+    IRQ_manager::clear(DCMI_IRQn);
+    IRQ_manager::unmask(DCMI_IRQn);
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+
+    m_event_handler(channel::meta, event::tc, m_captured);
+
+    return ecl::err::ok;
+}
+
+template< class dcmi_config >
+size_t dcmi_capture< dcmi_config >::captured() const
+{
+    return m_captured;
+}
+
+template< class dcmi_config >
+size_t dcmi_capture< dcmi_config >::dropped() const
+{
+    return m_dropped;
+}
+
+// -----------------------------------------------------------------------------
+// Private members
+
+template< class dcmi_config >
+uint8_t *dcmi_capture< dcmi_config >::acquire()
+{
+    uint32_t free = m_free.load();
+
+    // Frames are released concurrently, from threads or other IRQs
+    do {
+        if (!free) {
+            return nullptr;
+        }
+    } while (!m_free.compare_exchange_weak(free, free & (free - 1)));
+
+    return m_frames[__builtin_ctz(free)];
+}
+
+template< class dcmi_config >
+void dcmi_capture< dcmi_config >::put_back(uint8_t *frame)
+{
+    m_free.fetch_or(1u << index_of(frame));
+}
+
+template< class dcmi_config >
+int dcmi_capture< dcmi_config >::index_of(const uint8_t *frame) const
+{
+    for (size_t i = 0; i < m_count; ++i) {
+        if (m_frames[i] == frame) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+template< class dcmi_config >
+ecl::err dcmi_capture< dcmi_config >::begin(uint16_t mode)
+{
+    if (!(m_status & inited)) {
+        return ecl::err::perm;
+    }
+
+    if (m_status & capturing) {
+        return ecl::err::busy;
+    }
+
+    bool circular = mode == DCMI_CaptureMode_Continuous;
+
+    m_slots[0] = acquire();
+    m_slots[1] = circular ? acquire() : nullptr;
+
+    if (!m_slots[0] || (circular && !m_slots[1])) {
+        for (auto frame : m_slots) {
+            if (frame) {
+                put_back(frame);
+            }
+        }
+
+        return ecl::err::nobufs;
+    }
+
+    auto rc = dma::stream_lease< dcmi_config::m_dma_stream >::acquire(this, dma_irq_entry);
+    if (is_error(rc)) {
+        put_back(m_slots[0]);
+        if (m_slots[1]) {
+            put_back(m_slots[1]);
+        }
+
+        return rc;
+    }
+
+    m_captured = 0;
+    m_dropped = 0;
+    m_status |= capturing;
+
+    if (!circular) {
+        m_status |= single;
+    }
+
+    configure_dcmi(mode);
+    start_dma(circular);
+
+    DCMI_ClearITPendingBit(DCMI_IT_OVF | DCMI_IT_ERR);
+    DCMI_ITConfig(DCMI_IT_OVF | DCMI_IT_ERR, ENABLE);
+
+    DCMI_Cmd(ENABLE);
+    DCMI_CaptureCmd(ENABLE);
+
+    return ecl::err::ok;
+}
+
+template< class dcmi_config >
+void dcmi_capture< dcmi_config >::configure_dcmi(uint16_t mode)
+{
+    DCMI_InitTypeDef init_struct;
+    DCMI_StructInit(&init_struct);
+
+    init_struct.DCMI_CaptureMode        = mode;
+    init_struct.DCMI_SynchroMode        = DCMI_SynchroMode_Hardware;
+    init_struct.DCMI_PCKPolarity        = dcmi_config::m_pck_polarity;
+    init_struct.DCMI_VSPolarity         = dcmi_config::m_vs_polarity;
+    init_struct.DCMI_HSPolarity         = dcmi_config::m_hs_polarity;
+    init_struct.DCMI_CaptureRate        = DCMI_CaptureRate_All_Frame;
+    init_struct.DCMI_ExtendedDataMode   = dcmi_config::m_data_mode;
+
+    DCMI_Cmd(DISABLE);
+    DCMI_DeInit();
+    DCMI_Init(&init_struct);
+}
+
+template< class dcmi_config >
+void dcmi_capture< dcmi_config >::start_dma(bool circular)
+{
+    constexpr auto stream   = dma::get_stream< dcmi_config::m_dma_stream >();
+
+    DMA_InitTypeDef dma_init;
+    DMA_StructInit(&dma_init);
+
+    dma_init.DMA_Channel             = dcmi_config::m_dma_channel;
+    dma_init.DMA_DIR                 = DMA_DIR_PeripheralToMemory;
+    dma_init.DMA_PeripheralBaseAddr  = reinterpret_cast< uint32_t >(&DCMI->DR);
+    dma_init.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+    dma_init.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+    dma_init.DMA_PeripheralDataSize  = DMA_PeripheralDataSize_Word;
+    dma_init.DMA_MemoryDataSize      = DMA_MemoryDataSize_Word;
+    dma_init.DMA_Mode                = circular ? DMA_Mode_Circular : DMA_Mode_Normal;
+    dma_init.DMA_Priority            = DMA_Priority_High;
+    // FIFO absorbs bus contention, DCMI FIFO holds only 8 words
+    dma_init.DMA_FIFOMode            = DMA_FIFOMode_Enable;
+    dma_init.DMA_FIFOThreshold       = DMA_FIFOThreshold_Full;
+    dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(m_slots[0]);
+    dma_init.DMA_BufferSize          = m_size / 4;
+
+    dma::disable< dcmi_config::m_dma_stream >();
+    DMA_DeInit(stream);
+    DMA_Init(stream, &dma_init);
+
+    if (circular) {
+        dma::enable_double_buffer< dcmi_config::m_dma_stream >(m_slots[1]);
+    }
+
+    dma::enable_irq< dcmi_config::m_dma_stream, DMA_IT_TC | DMA_IT_TE >();
+    dma::enable< dcmi_config::m_dma_stream >();
+}
+
+template< class dcmi_config >
+void dcmi_capture< dcmi_config >::halt()
+{
+    constexpr auto stream   = dma::get_stream< dcmi_config::m_dma_stream >();
+
+    DCMI_ITConfig(DCMI_IT_OVF | DCMI_IT_ERR, DISABLE);
+    DCMI_CaptureCmd(DISABLE);
+    DCMI_Cmd(DISABLE);
+
+    dma::disable< dcmi_config::m_dma_stream >();
+    DMA_DeInit(stream);
+
+    dma::stream_lease< dcmi_config::m_dma_stream >::release();
+
+    for (auto &frame : m_slots) {
+        if (frame) {
+            put_back(frame);
+            frame = nullptr;
+        }
+    }
+
+    m_status &= ~(capturing | single);
+}
+
+template< class dcmi_config >
+void dcmi_capture< dcmi_config >::fail()
+{
+    if (m_status & capturing) {
+        halt();
+        m_event_handler(channel::rx, event::err, m_captured);
+        m_event_handler(channel::meta, event::tc, m_captured);
+    }
+}
+
+template< class dcmi_config >
+void dcmi_capture< dcmi_config >::dma_irq_entry()
+{
+    m_instance->dma_irq_handler();
+}
+
+template< class dcmi_config >
+void dcmi_capture< dcmi_config >::irq_entry()
+{
+    m_instance->irq_handler();
+}
+
+template< class dcmi_config >
+void dcmi_capture< dcmi_config >::dma_irq_handler()
+{
+    constexpr auto stream   = dcmi_config::m_dma_stream;
+    constexpr auto tc_if    = dma::get_tc_if< stream >();
+    constexpr auto err_if   = dma::get_err_if< stream >();
+    constexpr auto irqn     = dma::get_irqn< stream >();
+
+    if (dma::get_it_status< stream, err_if >()) {
+        dma::clear_flags< stream, err_if >();
+        fail();
+    } else if (dma::get_it_status< stream, tc_if >()) {
+        dma::clear_flags< stream, tc_if >();
+
+        if (m_status & single) {
+            // Frame is handed out, so it is not put back by halt()
+            uint8_t *frame = m_slots[0];
+            m_slots[0] = nullptr;
+
+            halt();
+
+            m_captured++;
+            m_frame_handler(frame, m_size);
+            m_event_handler(channel::meta, event::tc, m_captured);
+        } else {
+            // At this point DMA already switched to the other memory target,
+            // thus captured frame is the one that is not used now. It can
+            // be replaced until the current one is captured.
+            uint8_t slot = dma::get_memory_target< stream >() ^ 1;
+            uint8_t *frame = m_slots[slot];
+            uint8_t *next = acquire();
+
+            if (next) {
+                dma::set_memory_target< stream >(next, slot);
+                m_slots[slot] = next;
+
+                m_captured++;
+                m_frame_handler(frame, m_size);
+            } else {
+                m_dropped++;
+            }
+        }
+    }
+
+    // Stream may be left running, so IRQ must be enabled back
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+}
+
+template< class dcmi_config >
+void dcmi_capture< dcmi_config >::irq_handler()
+{
+    if (DCMI_GetITStatus(DCMI_IT_OVF) == SET || DCMI_GetITStatus(DCMI_IT_ERR) == SET) {
+        DCMI_ClearITPendingBit(DCMI_IT_OVF | DCMI_IT_ERR);
+        fail();
+    }
+
+    IRQ_manager::clear(DCMI_IRQn);
+    IRQ_manager::unmask(DCMI_IRQn);
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_DCMI_CAPTURE_HPP_
@@ -0,0 +1,282 @@
+#ifndef PLATFORM_DMA2D_HPP_
+#define PLATFORM_DMA2D_HPP_
+
+//!
+//! \file
+//! \brief Pixel engine, implemented by DMA2D (Chrom-ART).
+//! DMA2D is present on STM32F427/437 and STM32F429/439 only. On other parts,
+//! and until dma2d is initialized, ecl::dma2d is served by software, so
+//! framebuffers can use it regardless of the part:
+//! \code
+//!     ecl::dma2d::init();
+//!     ecl::color_framebuffer< 240, 320, ecl::pixel_format::rgb565, ecl::dma2d > fb;
+//! \endcode
+//!
+
+#include <ecl/pixel_engine.hpp>
+
+#if defined(STM32F427_437xx) || defined(STM32F429_439xx)
+
+#include <platform/irq_manager.hpp>
+#include <platform/memory.hpp>
+#include <platform/utils.hpp>
+
+#include <ecl/thread/completion.hpp>
+#include <ecl/assert.h>
+
+#include <stm32f4xx_dma2d.h>
+#include <stm32f4xx_rcc.h>
+
+#include <atomic>
+#include <cstdint>
+
+#endif
+
+namespace ecl
+{
+
+#if defined(STM32F427_437xx) || defined(STM32F429_439xx)
+
+//!
+//! \brief DMA2D pixel engine.
+//! Caller waits for the transfer, but CPU is free to run other threads
+//! meanwhile. Areas are served by software if they are small, reside in
+//! CCM RAM, exceed DMA2D limits, if engine is used from ISR or if DMA2D
+//! is busy with other thread's transfer.
+//! \tparam min_pixels Areas below this are served by software,
+//!                    since DMA2D setup costs more.
+//! \sa soft_pixel_engine
+//!
+template< int min_pixels = 64 >
+class dma2d_unit
+{
+public:
+    //!
+    //! \brief Enables DMA2D. Engine is served by software until then.
+    //!
+    static void init();
+
+    //!
+    //! \brief Disables DMA2D. Must not be called while engine is in use.
+    //!
+    static void deinit();
+
+    //! \copydoc soft_pixel_engine::fill()
+    static void fill(const surface &dst, int w, int h, uint32_t argb);
+
+    //! \copydoc soft_pixel_engine::copy()
+    static void copy(const pixmap &src, const surface &dst, int w, int h);
+
+    //! \copydoc soft_pixel_engine::blend()
+    static void blend(const pixmap &fg, const pixmap &bg, const surface &dst, int w, int h);
+
+private:
+    //! Checks if DMA2D can transfer an area and claims it, if so.
+    static bool acquire(const void *data, int stride, int w, int h);
+
+    //! Starts configured transfer, waits for it and releases DMA2D.
+    static void run();
+
+    static void irq_handler();
+
+    //! Limits of DMA2D.
+    enum : int
+    {
+        max_pixels  = 0x3fff,   //!< Pixels per line.
+        max_lines   = 0xffff,   //!< Lines per transfer.
+        max_offset  = 0x3fff,   //!< Pixels between lines.
+    };
+
+    static std::atomic_bool m_ready;    //!< DMA2D is initialized.
+    static std::atomic_bool m_busy;     //!< DMA2D is in use.
+    static bool             m_failed;   //!< Last transfer failed.
+    static ecl::completion  m_done;     //!< Signalled when transfer ends.
+};
+
+//! Pixel engine, implemented by DMA2D.
+using dma2d = dma2d_unit<>;
+
+//------------------------------------------------------------------------------
+
+template< int min_pixels >
+std::atomic_bool dma2d_unit< min_pixels >::m_ready{false};
+
+template< int min_pixels >
+std::atomic_bool dma2d_unit< min_pixels >::m_busy{false};
+
+template< int min_pixels >
+bool dma2d_unit< min_pixels >::m_failed{false};
+
+template< int min_pixels >
+ecl::completion dma2d_unit< min_pixels >::m_done{};
+
+template< int min_pixels >
+void dma2d_unit< min_pixels >::init()
+{
+    RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_DMA2D, ENABLE);
+    DMA2D_DeInit();
+
+    IRQ_manager::mask(DMA2D_IRQn);
+    IRQ_manager::clear(DMA2D_IRQn);
+    IRQ_manager::subscribe(DMA2D_IRQn, irq_handler);
+    IRQ_manager::unmask(DMA2D_IRQn);
+
+    m_ready = true;
+}
+
+template< int min_pixels >
+void dma2d_unit< min_pixels >::deinit()
+{
+    m_ready = false;
+
+    IRQ_manager::mask(DMA2D_IRQn);
+    IRQ_manager::unsubscribe(DMA2D_IRQn);
+
+    RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_DMA2D, DISABLE);
+}
+
+template< int min_pixels >
+void dma2d_unit< min_pixels >::fill(const surface &dst, int w, int h, uint32_t argb)
+{
+    if (!acquire(dst.data, dst.stride, w, h)) {
+        soft_pixel_engine::fill(dst, w, h, argb);
+        return;
+    }
+
+    // Register to memory mode takes the color in output format
+    DMA2D->CR       = DMA2D_R2M;
+    DMA2D->OPFCCR   = static_cast< uint32_t >(dst.format);
+    DMA2D->OCOLR    = to_pixel(dst.format, argb);
+    DMA2D->OMAR     = reinterpret_cast< uint32_t >(dst.data);
+    DMA2D->OOR      = dst.stride - w;
+    DMA2D->NLR      = static_cast< uint32_t >(w) << 16 | h;
+
+    run();
+}
+
+template< int min_pixels >
+void dma2d_unit< min_pixels >::copy(const pixmap &src, const surface &dst, int w, int h)
+{
+    if (!dma_capable(src.data) || src.stride - w > max_offset
+            || !acquire(dst.data, dst.stride, w, h)) {
+        soft_pixel_engine::copy(src, dst, w, h);
+        return;
+    }
+
+    DMA2D->CR       = src.format == dst.format ? DMA2D_M2M : DMA2D_M2M_PFC;
+    DMA2D->FGMAR    = reinterpret_cast< uint32_t >(src.data);
+    DMA2D->FGOR     = src.stride - w;
+    DMA2D->FGPFCCR  = static_cast< uint32_t >(src.format);
+    DMA2D->OPFCCR   = static_cast< uint32_t >(dst.format);
+    DMA2D->OMAR     = reinterpret_cast< uint32_t >(dst.data);
+    DMA2D->OOR      = dst.stride - w;
+    DMA2D->NLR      = static_cast< uint32_t >(w) << 16 | h;
+
+    run();
+}
+
+template< int min_pixels >
+void dma2d_unit< min_pixels >::blend(const pixmap &fg, const pixmap &bg, const surface &dst,
+                                     int w, int h)
+{
+    if (!dma_capable(fg.data) || !dma_capable(bg.data)
+            || fg.stride - w > max_offset || bg.stride - w > max_offset
+            || !acquire(dst.data, dst.stride, w, h)) {
+        soft_pixel_engine::blend(fg, bg, dst, w, h);
+        return;
+    }
+
+    // Alpha of both layers is taken from pixels, as is
+    DMA2D->CR       = DMA2D_M2M_BLEND;
+    DMA2D->FGMAR    = reinterpret_cast< uint32_t >(fg.data);
+    DMA2D->FGOR     = fg.stride - w;
+    DMA2D->FGPFCCR  = static_cast< uint32_t >(fg.format);
+    DMA2D->BGMAR    = reinterpret_cast< uint32_t >(bg.data);
+    DMA2D->BGOR     = bg.stride - w;
+    DMA2D->BGPFCCR  = static_cast< uint32_t >(bg.format);
+    DMA2D->OPFCCR   = static_cast< uint32_t >(dst.format);
+    DMA2D->OMAR     = reinterpret_cast< uint32_t >(dst.data);
+    DMA2D->OOR      = dst.stride - w;
+    DMA2D->NLR      = static_cast< uint32_t >(w) << 16 | h;
+
+    run();
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< int min_pixels >
+bool dma2d_unit< min_pixels >::acquire(const void *data, int stride, int w, int h)
+{
+    if (w <= 0 || h <= 0 || w * h < min_pixels) {
+        return false;
+    }
+
+    if (w > max_pixels || h > max_lines || stride - w > max_offset) {
+        return false;
+    }
+
+    if (!m_ready || !dma_capable(data) || in_isr()) {
+        return false;
+    }
+
+    return !m_busy.exchange(true);
+}
+
+template< int min_pixels >
+void dma2d_unit< min_pixels >::run()
+{
+    // Mode is written to CR by the caller. SPL flag and interrupt
+    // helpers accept single bits only, so registers are used directly.
+    DMA2D->IFCR = DMA2D_IFSR_CTCIF | DMA2D_IFSR_CTEIF | DMA2D_IFSR_CCEIF;
+    DMA2D->CR |= DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE | DMA2D_CR_START;
+
+    m_done.wait();
+
+    DMA2D->CR &= ~(DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE);
+
+    // Areas are checked above, only a bus fault can lead here
+    ecl_assert(!m_failed);
+
+    m_busy = false;
+}
+
+template< int min_pixels >
+void dma2d_unit< min_pixels >::irq_handler()
+{
+    uint32_t status = DMA2D->ISR;
+
+    if (status & (DMA2D_ISR_TEIF | DMA2D_ISR_CEIF)) {
+        DMA2D->IFCR = DMA2D_IFSR_CTEIF | DMA2D_IFSR_CCEIF;
+        m_failed = true;
+        m_done.signal();
+    } else if (status & DMA2D_ISR_TCIF) {
+        DMA2D->IFCR = DMA2D_IFSR_CTCIF;
+        m_failed = false;
+        m_done.signal();
+    }
+
+    IRQ_manager::clear(DMA2D_IRQn);
+    IRQ_manager::unmask(DMA2D_IRQn);
+}
+
+#else
+
+//!
+//! \brief Part has no DMA2D, pixel engine is implemented by CPU.
+//!
+class dma2d : public soft_pixel_engine
+{
+public:
+    //! Does nothing.
+    static void init() { }
+
+    //! Does nothing.
+    static void deinit() { }
+};
+
+#endif
+
+} // namespace ecl
+
+#endif // PLATFORM_DMA2D_HPP_
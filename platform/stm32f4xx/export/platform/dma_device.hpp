@@ -3,7 +3,12 @@
 
 #include <stm32f4xx_dma.h>
 #include <stm32f4xx_rcc.h>
+#include <platform/irq_manager.hpp>
+#include <ecl/lookup_table.hpp>
+#include <ecl/regs.hpp>
 #include <functional>
+#include <type_traits>
+#include <cstdint>
 
 //------------------------------------------------------------------------------
 
@@ -22,280 +27,285 @@ constexpr auto get_stream()
     return reinterpret_cast< DMA_Stream_TypeDef* >(dma_stream);
 }
 
+//!
+//! \brief Gets DMA controller, that given stream belongs to.
+//!
+template< std::uintptr_t dma_stream >
+constexpr auto get_controller()
+{
+    return reinterpret_cast< DMA_TypeDef* >(dma_stream < DMA2_BASE ? DMA1_BASE : DMA2_BASE);
+}
+
+//! Registers of DMA stream and of DMA controller, used on hot paths.
+using stream_cr     = ECL_REG(DMA_Stream_TypeDef, CR);
+using stream_ndtr   = ECL_REG(DMA_Stream_TypeDef, NDTR);
+using stream_fcr    = ECL_REG(DMA_Stream_TypeDef, FCR);
+using dma_lisr      = ECL_REG(DMA_TypeDef, LISR);
+using dma_hisr      = ECL_REG(DMA_TypeDef, HISR);
+using dma_lifcr     = ECL_REG(DMA_TypeDef, LIFCR);
+using dma_hifcr     = ECL_REG(DMA_TypeDef, HIFCR);
+
+using stream_en     = ecl::regs::bits< stream_cr, DMA_SxCR_EN >;
+using stream_feie   = ecl::regs::bits< stream_fcr, DMA_SxFCR_FEIE >;
+
+namespace detail
+{
+
+// Layout of SPL flag and interrupt descriptors, see stm32f4xx_dma.c
+
+// Flag is placed in HISR rather than in LISR
+static constexpr uint32_t high_isr      = 0x20000000;
+// Bits of the descriptor, that map to ISR and IFCR registers
+static constexpr uint32_t isr_bits      = 0x0F7D0F7D;
+// Interrupts, that are enabled by CR bits. FIFO error is enabled by FCR.
+static constexpr uint32_t transfer_its  = 0x0F3C0F3C;
+// Interrupt enable bits of CR
+static constexpr uint32_t cr_its        = 0x0000001E;
+
+} // namespace detail
+
+//!
+//! \brief Properties of a DMA stream, common for all its flags.
+//!
+struct stream_info
+{
+    int         number; //!< Stream number within DMA controller, -1 if unknown.
+    IRQn_Type   irqn;   //!< IRQ of the stream.
+    uint32_t    rcc;    //!< Clock of DMA controller.
+};
+
+//!
+//! \brief Gets properties of given DMA stream.
+//! Stream is looked up by the compiler. Zero stream means that DMA is not
+//! used by a driver at all: pickers are instantiated, but never called.
+//! Any other unknown stream fails to compile.
+//!
+template< std::uintptr_t dma_stream >
+constexpr stream_info get_stream_info()
+{
+    constexpr auto dma1 = RCC_AHB1Periph_DMA1;
+    constexpr auto dma2 = RCC_AHB1Periph_DMA2;
+
+    constexpr auto streams = make_lookup_table< std::uintptr_t, stream_info >({
+        { DMA1_Stream0_BASE, { 0, DMA1_Stream0_IRQn, dma1 } },
+        { DMA1_Stream1_BASE, { 1, DMA1_Stream1_IRQn, dma1 } },
+        { DMA1_Stream2_BASE, { 2, DMA1_Stream2_IRQn, dma1 } },
+        { DMA1_Stream3_BASE, { 3, DMA1_Stream3_IRQn, dma1 } },
+        { DMA1_Stream4_BASE, { 4, DMA1_Stream4_IRQn, dma1 } },
+        { DMA1_Stream5_BASE, { 5, DMA1_Stream5_IRQn, dma1 } },
+        { DMA1_Stream6_BASE, { 6, DMA1_Stream6_IRQn, dma1 } },
+        { DMA1_Stream7_BASE, { 7, DMA1_Stream7_IRQn, dma1 } },
+        { DMA2_Stream0_BASE, { 0, DMA2_Stream0_IRQn, dma2 } },
+        { DMA2_Stream1_BASE, { 1, DMA2_Stream1_IRQn, dma2 } },
+        { DMA2_Stream2_BASE, { 2, DMA2_Stream2_IRQn, dma2 } },
+        { DMA2_Stream3_BASE, { 3, DMA2_Stream3_IRQn, dma2 } },
+        { DMA2_Stream4_BASE, { 4, DMA2_Stream4_IRQn, dma2 } },
+        { DMA2_Stream5_BASE, { 5, DMA2_Stream5_IRQn, dma2 } },
+        { DMA2_Stream6_BASE, { 6, DMA2_Stream6_IRQn, dma2 } },
+        { DMA2_Stream7_BASE, { 7, DMA2_Stream7_IRQn, dma2 } },
+    });
+
+    static_assert(dma_stream == 0 || streams.contains(dma_stream), "Unknown DMA stream");
+
+    return streams.value_or(dma_stream, { -1, static_cast< IRQn_Type >(-1), 0 });
+}
+
+//!
+//! \brief Picks flag of given DMA stream from flags, indexed by stream number.
+//! \param[in] flags Flags of streams 0 to 7.
+//! \param[in] none  Value returned if DMA is not used.
+//!
+template< std::uintptr_t dma_stream >
+constexpr uint32_t pick_flag(const uint32_t (&flags)[8], uint32_t none)
+{
+    constexpr auto stream_no = get_stream_info< dma_stream >().number;
+
+    return stream_no < 0 ? none : flags[stream_no];
+}
+
 //!
 //! \brief Gets stream number of given DMA stream.
+//! \return Stream number or -1, if DMA is not used.
 //!
 template< std::uintptr_t dma_stream >
-constexpr auto get_stream_number()
+constexpr int get_stream_number()
 {
-    constexpr auto stream = get_stream< dma_stream >();
-
-    if (stream == DMA1_Stream0 || stream == DMA2_Stream0) {
-        return 0;
-    } else if (stream == DMA1_Stream1 || stream == DMA2_Stream1) {
-        return 1;
-    } else if (stream == DMA1_Stream2 || stream == DMA2_Stream2) {
-        return 2;
-    } else if (stream == DMA1_Stream3 || stream == DMA2_Stream3) {
-        return 3;
-    } else if (stream == DMA1_Stream4 || stream == DMA2_Stream4) {
-        return 4;
-    } else if (stream == DMA1_Stream5 || stream == DMA2_Stream5) {
-        return 5;
-    } else if (stream == DMA1_Stream6 || stream == DMA2_Stream6) {
-        return 6;
-    } else if (stream == DMA1_Stream7 || stream == DMA2_Stream7) {
-        return 7;
-    }
+    return get_stream_info< dma_stream >().number;
 }
 
 //!
 //! \brief Gets error flag descriptor of DMA stream.
 //!
 template< std::uintptr_t dma_stream >
-constexpr auto get_err_flag()
+constexpr uint32_t get_err_flag()
 {
-    constexpr auto stream_no = get_stream< dma_stream >();
-
-    switch (stream_no) {
-    case 0:
-        return DMA_FLAG_TEIF0;
-    case 1:
-        return DMA_FLAG_TEIF1;
-    case 2:
-        return DMA_FLAG_TEIF2;
-    case 3:
-        return DMA_FLAG_TEIF3;
-    case 4:
-        return DMA_FLAG_TEIF4;
-    case 5:
-        return DMA_FLAG_TEIF5;
-    case 6:
-        return DMA_FLAG_TEIF6;
-    case 7:
-        return DMA_FLAG_TEIF7;
-    default:
-        return static_cast< decltype (DMA_FLAG_TEIF7) >(-1);
-    }
+    return pick_flag< dma_stream >({
+        DMA_FLAG_TEIF0, DMA_FLAG_TEIF1, DMA_FLAG_TEIF2, DMA_FLAG_TEIF3,
+        DMA_FLAG_TEIF4, DMA_FLAG_TEIF5, DMA_FLAG_TEIF6, DMA_FLAG_TEIF7,
+    }, static_cast< uint32_t >(-1));
 }
 
 //!
 //! \brief Gets half-transfer flag descriptor of DMA stream.
 //!
 template< std::uintptr_t dma_stream >
-constexpr auto get_ht_flag()
+constexpr uint32_t get_ht_flag()
 {
-    constexpr auto stream_no = get_stream< dma_stream >();
-
-    switch (stream_no) {
-    case 0:
-        return DMA_FLAG_HTIF0;
-    case 1:
-        return DMA_FLAG_HTIF1;
-    case 2:
-        return DMA_FLAG_HTIF2;
-    case 3:
-        return DMA_FLAG_HTIF3;
-    case 4:
-        return DMA_FLAG_HTIF4;
-    case 5:
-        return DMA_FLAG_HTIF5;
-    case 6:
-        return DMA_FLAG_HTIF6;
-    case 7:
-        return DMA_FLAG_HTIF7;
-    default:
-        return 0xfful; // TODO
-    }
-
+    return pick_flag< dma_stream >({
+        DMA_FLAG_HTIF0, DMA_FLAG_HTIF1, DMA_FLAG_HTIF2, DMA_FLAG_HTIF3,
+        DMA_FLAG_HTIF4, DMA_FLAG_HTIF5, DMA_FLAG_HTIF6, DMA_FLAG_HTIF7,
+    }, 0xff);
 }
 
 //!
 //! \brief Gets transfer complete flag descriptor using of DMA stream.
 //!
 template< std::uintptr_t dma_stream >
-constexpr auto get_tc_flag()
+constexpr uint32_t get_tc_flag()
 {
-    constexpr auto stream_no = get_stream_number< dma_stream >();
-
-    switch (stream_no) {
-    case 0:
-        return DMA_FLAG_TCIF0;
-    case 1:
-        return DMA_FLAG_TCIF1;
-    case 2:
-        return DMA_FLAG_TCIF2;
-    case 3:
-        return DMA_FLAG_TCIF3;
-    case 4:
-        return DMA_FLAG_TCIF4;
-    case 5:
-        return DMA_FLAG_TCIF5;
-    case 6:
-        return DMA_FLAG_TCIF6;
-    case 7:
-        return DMA_FLAG_TCIF7;
-    default:
-        return 0xfful; // TODO
-    }
+    return pick_flag< dma_stream >({
+        DMA_FLAG_TCIF0, DMA_FLAG_TCIF1, DMA_FLAG_TCIF2, DMA_FLAG_TCIF3,
+        DMA_FLAG_TCIF4, DMA_FLAG_TCIF5, DMA_FLAG_TCIF6, DMA_FLAG_TCIF7,
+    }, 0xff);
 }
 
 //!
 //! \brief Gets IRQ number of given DMA stream.
 //!
 template< std::uintptr_t dma_stream >
-constexpr auto get_irqn()
+constexpr IRQn_Type get_irqn()
 {
-    constexpr auto stream = get_stream< dma_stream >();
-
-    if (stream == DMA1_Stream0)      // DMA1
-        return DMA1_Stream0_IRQn;
-    else if (stream == DMA1_Stream1)
-        return DMA1_Stream1_IRQn;
-    else if (stream == DMA1_Stream2)
-        return DMA1_Stream2_IRQn;
-    else if (stream == DMA1_Stream3)
-        return DMA1_Stream3_IRQn;
-    else if (stream == DMA1_Stream4)
-        return DMA1_Stream4_IRQn;
-    else if (stream == DMA1_Stream5)
-        return DMA1_Stream5_IRQn;
-    else if (stream == DMA1_Stream6)
-        return DMA1_Stream6_IRQn;
-    else if (stream == DMA1_Stream7)
-        return DMA1_Stream7_IRQn;
-    else if (stream == DMA2_Stream0)  // DMA2
-        return DMA2_Stream0_IRQn;
-    else if (stream == DMA2_Stream1)
-        return DMA2_Stream1_IRQn;
-    else if (stream == DMA2_Stream2)
-        return DMA2_Stream2_IRQn;
-    else if (stream == DMA2_Stream3)
-        return DMA2_Stream3_IRQn;
-    else if (stream == DMA2_Stream4)
-        return DMA2_Stream4_IRQn;
-    else if (stream == DMA2_Stream5)
-        return DMA2_Stream5_IRQn;
-    else if (stream == DMA2_Stream6)
-        return DMA2_Stream6_IRQn;
-    else if (stream == DMA2_Stream7)
-        return DMA2_Stream7_IRQn;
-    else
-        return static_cast< decltype (DMA1_Stream0_IRQn) >(-1);
+    return get_stream_info< dma_stream >().irqn;
 }
 
 //!
 //! \brief Gets reset and clock control descriptor associated with a given stream.
 //!
 template< std::uintptr_t dma_stream >
-constexpr auto get_rcc()
+constexpr uint32_t get_rcc()
 {
-    constexpr auto stream = get_stream< dma_stream >();
-
-    if (stream == DMA1_Stream0
-            || stream == DMA1_Stream1
-            || stream == DMA1_Stream2
-            || stream == DMA1_Stream3
-            || stream == DMA1_Stream4
-            || stream == DMA1_Stream5
-            || stream == DMA1_Stream6
-            || stream == DMA1_Stream7) {
-        return RCC_AHB1Periph_DMA1;
-    } else {
-        return RCC_AHB1Periph_DMA2;
-    }
-
+    return get_stream_info< dma_stream >().rcc;
 }
 
 //!
 //! \brief Gets half-transfer interrupt flag descriptor of given dma stream.
 //!
 template< std::uintptr_t dma_stream >
-constexpr auto get_ht_if()
+constexpr uint32_t get_ht_if()
 {
-    constexpr auto stream_no = get_stream_number< dma_stream >();
-
-    switch (stream_no) {
-    case 0:
-        return DMA_IT_HTIF0;
-    case 1:
-        return DMA_IT_HTIF1;
-    case 2:
-        return DMA_IT_HTIF2;
-    case 3:
-        return DMA_IT_HTIF3;
-    case 4:
-        return DMA_IT_HTIF4;
-    case 5:
-        return DMA_IT_HTIF5;
-    case 6:
-        return DMA_IT_HTIF6;
-    case 7:
-        return DMA_IT_HTIF7;
-    default:
-        return 0xfful; // TODO: ugly
-    }
-
+    return pick_flag< dma_stream >({
+        DMA_IT_HTIF0, DMA_IT_HTIF1, DMA_IT_HTIF2, DMA_IT_HTIF3,
+        DMA_IT_HTIF4, DMA_IT_HTIF5, DMA_IT_HTIF6, DMA_IT_HTIF7,
+    }, 0xff);
 }
 
 //!
 //! \brief Gets transfer complete interrupt flag descriptor of given dma stream.
 //!
 template< std::uintptr_t dma_stream >
-constexpr auto get_tc_if()
+constexpr uint32_t get_tc_if()
 {
-    constexpr auto stream_no = get_stream_number< dma_stream >();
-
-    switch (stream_no) {
-    case 0:
-        return DMA_IT_TCIF0;
-    case 1:
-        return DMA_IT_TCIF1;
-    case 2:
-        return DMA_IT_TCIF2;
-    case 3:
-        return DMA_IT_TCIF3;
-    case 4:
-        return DMA_IT_TCIF4;
-    case 5:
-        return DMA_IT_TCIF5;
-    case 6:
-        return DMA_IT_TCIF6;
-    case 7:
-        return DMA_IT_TCIF7;
-    default:
-        return 0xfful; // TODO
-    }
+    return pick_flag< dma_stream >({
+        DMA_IT_TCIF0, DMA_IT_TCIF1, DMA_IT_TCIF2, DMA_IT_TCIF3,
+        DMA_IT_TCIF4, DMA_IT_TCIF5, DMA_IT_TCIF6, DMA_IT_TCIF7,
+    }, 0xff);
 }
 
 //!
 //! \brief Gets transfer error interrupt flag descriptor of given dma stream.
 //!
 template< std::uintptr_t dma_stream >
-constexpr auto get_err_if()
+constexpr uint32_t get_err_if()
 {
-    constexpr auto stream_no = get_stream_number< dma_stream >();
-
-    switch (stream_no) {
-    case 0:
-        return DMA_IT_TEIF0 | DMA_IT_DMEIF0 | DMA_IT_FEIF0;
-    case 1:
-        return DMA_IT_TEIF1 | DMA_IT_DMEIF1 | DMA_IT_FEIF1;
-    case 2:
-        return DMA_IT_TEIF2 | DMA_IT_DMEIF2 | DMA_IT_FEIF2;
-    case 3:
-        return DMA_IT_TEIF3 | DMA_IT_DMEIF3 | DMA_IT_FEIF3;
-    case 4:
-        return DMA_IT_TEIF4 | DMA_IT_DMEIF4 | DMA_IT_FEIF4;
-    case 5:
-        return DMA_IT_TEIF5 | DMA_IT_DMEIF5 | DMA_IT_FEIF5;
-    case 6:
-        return DMA_IT_TEIF6 | DMA_IT_DMEIF6 | DMA_IT_FEIF6;
-    case 7:
-        return DMA_IT_TEIF7 | DMA_IT_DMEIF7 | DMA_IT_FEIF7;
-    default:
-        return static_cast< decltype (DMA_IT_TEIF7) >(-1);
-    }
+    return pick_flag< dma_stream >({
+        DMA_IT_TEIF0 | DMA_IT_DMEIF0 | DMA_IT_FEIF0,
+        DMA_IT_TEIF1 | DMA_IT_DMEIF1 | DMA_IT_FEIF1,
+        DMA_IT_TEIF2 | DMA_IT_DMEIF2 | DMA_IT_FEIF2,
+        DMA_IT_TEIF3 | DMA_IT_DMEIF3 | DMA_IT_FEIF3,
+        DMA_IT_TEIF4 | DMA_IT_DMEIF4 | DMA_IT_FEIF4,
+        DMA_IT_TEIF5 | DMA_IT_DMEIF5 | DMA_IT_FEIF5,
+        DMA_IT_TEIF6 | DMA_IT_DMEIF6 | DMA_IT_FEIF6,
+        DMA_IT_TEIF7 | DMA_IT_DMEIF7 | DMA_IT_FEIF7,
+    }, static_cast< uint32_t >(-1));
+}
+
+//!
+//! \brief Gets transfer error interrupt flag descriptor of given dma stream.
+//! Unlike get_err_if(), direct mode and FIFO errors are not included.
+//!
+template< std::uintptr_t dma_stream >
+constexpr uint32_t get_te_if()
+{
+    return pick_flag< dma_stream >({
+        DMA_IT_TEIF0, DMA_IT_TEIF1, DMA_IT_TEIF2, DMA_IT_TEIF3,
+        DMA_IT_TEIF4, DMA_IT_TEIF5, DMA_IT_TEIF6, DMA_IT_TEIF7,
+    }, static_cast< uint32_t >(-1));
+}
+
+//!
+//! \brief Enables DMA stream, i.e. starts a transfer.
+//!
+template< std::uintptr_t dma_stream >
+ECL_REGS_INLINE void enable()
+{
+    ecl::regs::set< stream_en >(get_stream< dma_stream >());
+}
+
+//!
+//! \brief Disables DMA stream.
+//! Stream is actually stopped after current beat, see reference manual.
+//!
+template< std::uintptr_t dma_stream >
+ECL_REGS_INLINE void disable()
+{
+    ecl::regs::clear< stream_en >(get_stream< dma_stream >());
+}
+
+//!
+//! \brief Gets amount of data items, that DMA stream is yet to transfer.
+//!
+template< std::uintptr_t dma_stream >
+ECL_REGS_INLINE uint32_t get_counter()
+{
+    return get_stream< dma_stream >()->NDTR;
+}
+
+//!
+//! \brief Checks if any of given interrupts of DMA stream is pending.
+//! Same as DMA_GetITStatus(), but registers and masks are resolved by the
+//! compiler: interrupt is pending if its flag is raised and it is enabled.
+//! \tparam it Interrupt descriptor, i.e. one returned by get_tc_if().
+//!
+template< std::uintptr_t dma_stream, uint32_t it >
+ECL_REGS_INLINE bool get_it_status()
+{
+    using isr       = typename std::conditional< (it & detail::high_isr) != 0,
+                                                 dma_hisr, dma_lisr >::type;
+    using flags     = ecl::regs::bits< isr, it & detail::isr_bits >;
+    using enables   = ecl::regs::bits< stream_cr, (it >> 11) & detail::cr_its >;
+
+    constexpr auto stream   = get_stream< dma_stream >();
+    constexpr auto dma      = get_controller< dma_stream >();
+
+    bool enabled = (it & detail::transfer_its) ? ecl::regs::test< enables >(stream)
+                                               : ecl::regs::test< stream_feie >(stream);
+
+    return enabled && ecl::regs::test< flags >(dma);
+}
+
+//!
+//! \brief Clears given flags or pending interrupts of DMA stream.
+//! Same as DMA_ClearFlag() and DMA_ClearITPendingBit(), single store to IFCR.
+//! \tparam flags Flag or interrupt descriptors, i.e. returned by get_tc_flag().
+//!
+template< std::uintptr_t dma_stream, uint32_t flags >
+ECL_REGS_INLINE void clear_flags()
+{
+    using ifcr      = typename std::conditional< (flags & detail::high_isr) != 0,
+                                                 dma_hifcr, dma_lifcr >::type;
+    using mask      = ecl::regs::bits< ifcr, flags & detail::isr_bits >;
+
+    ecl::regs::store< mask >(get_controller< dma_stream >());
 }
 
 //!
@@ -313,31 +323,96 @@ void init_rcc()
 //! \brief Enables IRQ for given DMA stream and interrupt sources.
 //!
 template< std::uintptr_t dma_stream, uint32_t flags >
-void enable_irq()
+ECL_REGS_INLINE void enable_irq()
 {
+    using enables = ecl::regs::bits< stream_cr, flags & detail::cr_its >;
+
     constexpr auto stream   = get_stream< dma_stream >();
 
-    // Enable interrupt sources
-    DMA_ITConfig(stream, flags, ENABLE);
+    // Enable interrupt sources, same as DMA_ITConfig() does
+    if (flags & DMA_IT_FE) {
+        ecl::regs::set< stream_feie >(stream);
+    }
+
+    if (flags & detail::cr_its) {
+        ecl::regs::set< enables >(stream);
+    }
 }
 
 //!
 //! \brief Disables IRQ for given DMA stream and interrupt sources.
 //!
 template< std::uintptr_t dma_stream, uint32_t flags >
-void disable_irq()
+ECL_REGS_INLINE void disable_irq()
+{
+    using enables = ecl::regs::bits< stream_cr, flags & detail::cr_its >;
+
+    constexpr auto stream   = get_stream< dma_stream >();
+
+    // Disable interrupt sources, same as DMA_ITConfig() does
+    if (flags & DMA_IT_FE) {
+        ecl::regs::clear< stream_feie >(stream);
+    }
+
+    if (flags & detail::cr_its) {
+        ecl::regs::clear< enables >(stream);
+    }
+}
+
+//!
+//! \brief Enables double-buffer mode for given DMA stream.
+//! Memory 0 address is taken from the stream init structure, memory 1 address
+//! is given here. Stream starts from memory 0 and switches between targets
+//! each time transfer of a buffer is complete. Circular mode must be selected
+//! when initializing the stream.
+//! \pre  Stream is initialized but not yet enabled.
+//! \param[in] mem1 Second memory buffer.
+//!
+template< std::uintptr_t dma_stream >
+void enable_double_buffer(const void *mem1)
+{
+    constexpr auto stream   = get_stream< dma_stream >();
+
+    DMA_DoubleBufferModeConfig(stream, reinterpret_cast< uint32_t >(mem1),
+                               DMA_Memory_0);
+    DMA_DoubleBufferModeCmd(stream, ENABLE);
+}
+
+//!
+//! \brief Gets memory target that DMA stream is currently working with.
+//! \retval 0 Memory 0 is in use, memory 1 may be accessed.
+//! \retval 1 Memory 1 is in use, memory 0 may be accessed.
+//!
+template< std::uintptr_t dma_stream >
+uint8_t get_memory_target()
+{
+    constexpr auto stream   = get_stream< dma_stream >();
+
+    return DMA_GetCurrentMemoryTarget(stream) ? 1 : 0;
+}
+
+//!
+//! \brief Replaces address of memory target in double-buffer mode.
+//! \pre Given target is not currently used by the stream.
+//! \param[in] mem     New memory buffer.
+//! \param[in] target  Target to update, 0 or 1.
+//!
+template< std::uintptr_t dma_stream >
+void set_memory_target(const void *mem, uint8_t target)
 {
     constexpr auto stream   = get_stream< dma_stream >();
 
-    // Enable interrupt sources
-    DMA_ITConfig(stream, flags, DISABLE);
+    DMA_MemoryTargetConfig(stream, reinterpret_cast< uint32_t >(mem),
+                           target ? DMA_Memory_1 : DMA_Memory_0);
 }
 
 //!
 //! \brief Subscribes to DMA IRQ associated with given DMA stream.
+//! \param[in] handler IRQ handler. Must be a plain function if static IRQ
+//!                    dispatch is used.
 //!
 template< std::uintptr_t dma_stream >
-void subscribe_irq(const std::function< void () > &handler)
+void subscribe_irq(const IRQ_manager::handler_type &handler)
 {
     constexpr auto dma_irqn = get_irqn< dma_stream >();
 
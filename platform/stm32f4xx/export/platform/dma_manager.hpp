@@ -0,0 +1,186 @@
+#ifndef PLATFORM_DMA_MANAGER
+#define PLATFORM_DMA_MANAGER
+
+//!
+//! \file
+//! \brief DMA stream manager.
+//! Streams can be claimed by drivers statically, at compile time,
+//! or leased at runtime, when stream is idle.
+//!
+
+#include <platform/irq_manager.hpp>
+#include <platform/dma_device.hpp>
+#include <platform/power.hpp>
+
+#include <ecl/err.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace ecl
+{
+
+namespace dma
+{
+
+//!
+//! \brief List of DMA streams, used by a driver.
+//! Zero stream means that driver doesn't use DMA in given direction.
+//!
+template< std::uintptr_t... streams >
+struct stream_list
+{
+};
+
+//!
+//! \brief Joins few stream lists into one.
+//!
+template< class... lists >
+struct join_streams;
+
+template<>
+struct join_streams<>
+{
+    using type = stream_list<>;
+};
+
+template< std::uintptr_t... a >
+struct join_streams< stream_list< a... > >
+{
+    using type = stream_list< a... >;
+};
+
+template< std::uintptr_t... a, std::uintptr_t... b, class... rest >
+struct join_streams< stream_list< a... >, stream_list< b... >, rest... >
+{
+    using type = typename join_streams< stream_list< a..., b... >, rest... >::type;
+};
+
+//!
+//! \brief Checks that no stream appears in the list twice.
+//! Zero streams are ignored.
+//!
+template< std::uintptr_t... streams >
+constexpr bool distinct(stream_list< streams... >)
+{
+    constexpr std::uintptr_t s[] = { streams..., 0 };
+
+    for (size_t i = 0; i < sizeof...(streams); ++i) {
+        for (size_t j = i + 1; s[i] && j < sizeof...(streams); ++j) {
+            if (s[i] == s[j]) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//!
+//! \brief Compile-time check of exclusive stream usage.
+//! Each claimant (i.e. driver configuration like spi_config) must provide
+//! \c dma_streams type, listing streams it claims. Compilation fails if
+//! any stream is claimed twice. Intended to be used in board definitions,
+//! listing all drivers that use DMA:
+//! \code
+//! static_assert(ecl::dma::exclusive_streams< spi1_cfg, spi2_cfg >::value, "");
+//! \endcode
+//! Streams that are not claimed by anyone can be leased at runtime.
+//! \sa stream_lease
+//!
+template< class... claimants >
+struct exclusive_streams
+{
+    using all = typename join_streams< typename claimants::dma_streams... >::type;
+
+    static_assert(distinct(all{}), "DMA stream is claimed by more than one driver");
+
+    static constexpr bool value = true;
+};
+
+//------------------------------------------------------------------------------
+
+//!
+//! \brief Runtime lease of a DMA stream.
+//! Stream is owned by a single user at a time. Owner subscribes
+//! its own IRQ handler when lease is taken. Handler is not replaced if
+//! the same owner takes lease repeatedly, so leasing is cheap for a
+//! driver that doesn't share the stream in practice.
+//! Leased stream keeps MCU out of stop mode, see platform/power.hpp.
+//! \tparam dma_stream DMA stream.
+//!
+template< std::uintptr_t dma_stream >
+class stream_lease
+{
+public:
+    //!
+    //! \brief Tries to take a lease.
+    //! Can be called from ISR.
+    //! \param[in] owner   Unique owner identifier, e.g. driver address.
+    //! \param[in] handler IRQ handler of the owner.
+    //! \retval err::ok   Lease is taken.
+    //! \retval err::busy Stream is leased by someone else.
+    //!
+    static err acquire(const void *owner, const IRQ_manager::handler_type &handler);
+
+    //!
+    //! \brief Returns a lease.
+    //! Can be called from ISR.
+    //! \pre Lease is taken.
+    //!
+    static void release();
+
+    //!
+    //! \brief Checks if stream is leased at this moment.
+    //!
+    static bool leased();
+
+private:
+    static std::atomic_bool m_busy;     //!< Stream is leased.
+    static const void       *m_owner;   //!< Most recent lease owner.
+};
+
+template< std::uintptr_t dma_stream >
+std::atomic_bool stream_lease< dma_stream >::m_busy{false};
+
+template< std::uintptr_t dma_stream >
+const void *stream_lease< dma_stream >::m_owner{nullptr};
+
+template< std::uintptr_t dma_stream >
+err stream_lease< dma_stream >::acquire(const void *owner,
+                                        const IRQ_manager::handler_type &handler)
+{
+    if (m_busy.exchange(true)) {
+        return err::busy;
+    }
+
+    if (m_owner != owner) {
+        m_owner = owner;
+        subscribe_irq< dma_stream >(handler);
+    }
+
+    power::inhibit_stop();
+    return err::ok;
+}
+
+template< std::uintptr_t dma_stream >
+void stream_lease< dma_stream >::release()
+{
+    if (m_busy.exchange(false)) {
+        power::allow_stop();
+    }
+}
+
+template< std::uintptr_t dma_stream >
+bool stream_lease< dma_stream >::leased()
+{
+    return m_busy.load();
+}
+
+} // namespace dma
+
+} // namespace ecl
+
+#endif // PLATFORM_DMA_MANAGER
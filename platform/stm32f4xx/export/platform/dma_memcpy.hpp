@@ -0,0 +1,239 @@
+#ifndef PLATFORM_DMA_MEMCPY
+#define PLATFORM_DMA_MEMCPY
+
+//!
+//! \file
+//! \brief DMA-accelerated memory-to-memory copy service.
+//!
+
+#include <platform/irq_manager.hpp>
+#include <platform/dma_device.hpp>
+#include <platform/dma_manager.hpp>
+#include <platform/memory.hpp>
+
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+#ifndef CONFIG_DMA_MEMCPY_THRESHOLD
+//! Copies smaller than this are done by CPU.
+#define CONFIG_DMA_MEMCPY_THRESHOLD 64
+#endif
+
+namespace ecl
+{
+
+namespace dma
+{
+
+//! Completion callback of async copy. Likely executed in ISR context.
+using memcpy_callback = std::function< void(err status) >;
+
+//!
+//! \brief Memory-to-memory copy, executed by DMA.
+//! Only DMA2 streams are capable of memory-to-memory transfers.
+//! Stream is leased for the copy duration, so it can be shared with other
+//! drivers, as long as it is not claimed by them statically.
+//! \tparam dma_stream  DMA2 stream used for copying.
+//! \tparam dma_channel DMA channel. Any, request line is not used.
+//! \sa stream_lease
+//!
+template< std::uintptr_t dma_stream, uint32_t dma_channel = DMA_Channel_0 >
+class memcpy_service
+{
+    static_assert(dma_stream >= DMA2_Stream0_BASE && dma_stream <= DMA2_Stream7_BASE,
+                  "Only DMA2 supports memory-to-memory transfers");
+
+public:
+    //!
+    //! \brief Starts async copy.
+    //! If copy is too small or stream is busy, copy is done by CPU and
+    //! callback is invoked before return.
+    //! \pre Memory regions do not overlap and are accessible by DMA
+    //!      (i.e. CCM RAM can't be used).
+    //! \param[in] dst      Destination. Must not be null.
+    //! \param[in] src      Source. Must not be null.
+    //! \param[in] n        Size of memory regions.
+    //! \param[in] callback Completion callback.
+    //! \retval err::ok Copy is started (or done).
+    //!
+    static err copy(void *dst, const void *src, size_t n, const memcpy_callback &callback);
+
+private:
+    //! Starts next portion of a copy.
+    static void start_chunk();
+
+    //! Handles DMA events.
+    static void irq_handler();
+
+    //! Finishes copy and reports status.
+    static void complete(err status);
+
+    static uint8_t          *m_dst;     //!< Destination of next portion.
+    static const uint8_t    *m_src;     //!< Source of next portion.
+    static size_t           m_left;     //!< Bytes left to copy.
+    static size_t           m_chunk;    //!< Size of a portion in flight.
+    static memcpy_callback  m_callback; //!< User callback.
+};
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+uint8_t *memcpy_service< dma_stream, dma_channel >::m_dst{};
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+const uint8_t *memcpy_service< dma_stream, dma_channel >::m_src{};
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+size_t memcpy_service< dma_stream, dma_channel >::m_left{};
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+size_t memcpy_service< dma_stream, dma_channel >::m_chunk{};
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+memcpy_callback memcpy_service< dma_stream, dma_channel >::m_callback{};
+
+//------------------------------------------------------------------------------
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+err memcpy_service< dma_stream, dma_channel >::copy(void *dst, const void *src, size_t n,
+                                                    const memcpy_callback &callback)
+{
+    ecl_assert(dst && src);
+    // CCM is not on DMA bus
+    ecl_assert(dma_capable(dst) && dma_capable(src));
+
+    // It is faster to copy by hand, rather than to setup
+    // DMA and wait for an interrupt.
+    if (n < CONFIG_DMA_MEMCPY_THRESHOLD) {
+        std::memcpy(dst, src, n);
+        callback(err::ok);
+        return err::ok;
+    }
+
+    // Stream is used by other driver right now
+    if (is_error(stream_lease< dma_stream >::acquire(&m_callback, irq_handler))) {
+        std::memcpy(dst, src, n);
+        callback(err::ok);
+        return err::ok;
+    }
+
+    init_rcc< dma_stream >();
+
+    m_dst       = static_cast< uint8_t * >(dst);
+    m_src       = static_cast< const uint8_t * >(src);
+    m_left      = n;
+    m_callback  = callback;
+
+    start_chunk();
+
+    return err::ok;
+}
+
+//------------------------------------------------------------------------------
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+void memcpy_service< dma_stream, dma_channel >::start_chunk()
+{
+    // Amount of data items is limited by 16-bit counter
+    constexpr size_t max_items = 0xffff;
+    constexpr auto stream = get_stream< dma_stream >();
+
+    DMA_InitTypeDef dma_init;
+    DMA_StructInit(&dma_init);
+
+    auto aligned = !((reinterpret_cast< std::uintptr_t >(m_dst)
+                      | reinterpret_cast< std::uintptr_t >(m_src)) & 3);
+
+    if (aligned && m_left >= 4) {
+        // Word-sized beats move four times more data per bus access
+        m_chunk = std::min(m_left & ~static_cast< size_t >(3), max_items * 4);
+        dma_init.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+        dma_init.DMA_MemoryDataSize     = DMA_MemoryDataSize_Word;
+        dma_init.DMA_BufferSize         = m_chunk / 4;
+    } else {
+        m_chunk = std::min(m_left, max_items);
+        dma_init.DMA_BufferSize         = m_chunk;
+    }
+
+    // In memory-to-memory mode, peripheral port is the source
+    dma_init.DMA_Channel             = dma_channel;
+    dma_init.DMA_DIR                 = DMA_DIR_MemoryToMemory;
+    dma_init.DMA_PeripheralBaseAddr  = reinterpret_cast< uint32_t >(m_src);
+    dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(m_dst);
+    dma_init.DMA_PeripheralInc       = DMA_PeripheralInc_Enable;
+    dma_init.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+    // Direct mode is not allowed for memory-to-memory transfers
+    dma_init.DMA_FIFOMode            = DMA_FIFOMode_Enable;
+    dma_init.DMA_FIFOThreshold       = DMA_FIFOThreshold_Full;
+
+    DMA_DeInit(stream);
+    DMA_Init(stream, &dma_init);
+    enable_irq< dma_stream, DMA_IT_TC | DMA_IT_TE >();
+    DMA_Cmd(stream, ENABLE);
+}
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+void memcpy_service< dma_stream, dma_channel >::irq_handler()
+{
+    constexpr auto stream   = get_stream< dma_stream >();
+    constexpr auto tc_if    = get_tc_if< dma_stream >();
+    constexpr auto err_if   = get_err_if< dma_stream >();
+    constexpr auto irqn     = get_irqn< dma_stream >();
+
+    if (DMA_GetITStatus(stream, err_if)) {
+        DMA_ClearITPendingBit(stream, err_if);
+        complete(err::io);
+    } else if (DMA_GetITStatus(stream, tc_if)) {
+        DMA_ClearITPendingBit(stream, tc_if);
+
+        m_dst  += m_chunk;
+        m_src  += m_chunk;
+        m_left -= m_chunk;
+
+        if (m_left) {
+            start_chunk();
+        } else {
+            complete(err::ok);
+        }
+    }
+
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+}
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+void memcpy_service< dma_stream, dma_channel >::complete(err status)
+{
+    constexpr auto stream = get_stream< dma_stream >();
+
+    DMA_Cmd(stream, DISABLE);
+    disable_irq< dma_stream, DMA_IT_TC | DMA_IT_TE >();
+
+    // Callback may start next copy right away
+    auto callback = std::move(m_callback);
+    stream_lease< dma_stream >::release();
+
+    callback(status);
+}
+
+} // namespace dma
+
+//!
+//! \brief Copies memory using DMA.
+//! \sa dma::memcpy_service::copy()
+//! \tparam dma_stream DMA2 stream used for copying.
+//!
+template< std::uintptr_t dma_stream = DMA2_Stream1_BASE >
+err dma_memcpy_async(void *dst, const void *src, size_t n,
+                     const dma::memcpy_callback &callback)
+{
+    return dma::memcpy_service< dma_stream >::copy(dst, src, n, callback);
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_DMA_MEMCPY
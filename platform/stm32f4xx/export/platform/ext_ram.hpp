@@ -0,0 +1,235 @@
+#ifndef PLATFORM_EXT_RAM_HPP_
+#define PLATFORM_EXT_RAM_HPP_
+
+//!
+//! \file
+//! \brief External SRAM and PSRAM, attached by FSMC.
+//! Memory becomes a linker region, so objects are placed there with
+//! PLATFORM_EXT_RAM, see platform/memory.hpp. Region is set up by
+//! the build:
+//! \code
+//! set(CONFIG_EXT_RAM_BANK 1)          # FSMC NOR/SRAM bank, 1 .. 4
+//! set(CONFIG_EXT_RAM_SIZE 0x100000)   # 1 MiB
+//! \endcode
+//! FSMC must be set up before constructors of objects in the region run,
+//! thus it is done by the board:
+//! \code
+//! using sram = ecl::ext_ram< ecl::ext_ram_config< FSMC_Bank1_NORSRAM1 > >;
+//!
+//! extern "C" void board_init()
+//! {
+//!     // ... pins of address and data buses, NE1, NOE, NWE, NBL0 and NBL1
+//!     // in alternate function GPIO_AF_FSMC ...
+//!     sram::init();
+//! }
+//! \endcode
+//! External RAM is a lot slower than on-chip SRAM, especially for random
+//! accesses, so it suits large and cold data: caches, framebuffers,
+//! staging buffers. DMA2 reaches it as well.
+//!
+
+#if !defined(STM32F40_41xxx)
+#error "Only FSMC of STM32F40x/F41x is supported, FMC and SDRAM need own setup"
+#endif
+
+#include <platform/clock.hpp>
+
+#include <ecl/err.hpp>
+
+#include <stm32f4xx_fsmc.h>
+#include <stm32f4xx_rcc.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//! \cond
+namespace detail
+{
+
+//! Converts nanoseconds to HCLK cycles, rounding up.
+constexpr uint32_t hclk_cycles(uint32_t ns)
+{
+    return (static_cast< uint64_t >(ns) * clock::hclk + 999999999) / 1000000000;
+}
+
+} // namespace detail
+//! \endcond
+
+//!
+//! \brief Configuration of external RAM.
+//! Timings are from the datasheet of the memory and are rounded up to
+//! HCLK cycles. Defaults suit 10 ns asynchronous SRAM, like IS61WV51216.
+//! \tparam bank                FSMC bank: FSMC_Bank1_NORSRAM1 .. FSMC_Bank1_NORSRAM4.
+//!                             Must match CONFIG_EXT_RAM_BANK.
+//! \tparam memory_type         FSMC_MemoryType_SRAM or FSMC_MemoryType_PSRAM.
+//! \tparam data_width          FSMC_MemoryDataWidth_16b or FSMC_MemoryDataWidth_8b.
+//! \tparam address_setup_ns    Address setup time, ns.
+//! \tparam data_setup_ns       Data setup time, i.e. write pulse width, ns.
+//! \tparam bus_turnaround_ns   Pause between consecutive accesses, ns.
+//!
+template< uint32_t bank,
+          uint32_t memory_type          = FSMC_MemoryType_SRAM,
+          uint32_t data_width           = FSMC_MemoryDataWidth_16b,
+          uint32_t address_setup_ns     = 0,
+          uint32_t data_setup_ns        = 10,
+          uint32_t bus_turnaround_ns    = 0 >
+struct ext_ram_config
+{
+    static constexpr uint32_t m_bank         = bank;
+    static constexpr uint32_t m_memory_type  = memory_type;
+    static constexpr uint32_t m_data_width   = data_width;
+
+    //! Address setup time, in HCLK cycles.
+    static constexpr uint32_t m_address_setup   = detail::hclk_cycles(address_setup_ns);
+    //! Data setup time, in HCLK cycles. At least one cycle.
+    static constexpr uint32_t m_data_setup      = data_setup_ns
+                                                  ? detail::hclk_cycles(data_setup_ns) : 1;
+    //! Bus turnaround, in HCLK cycles.
+    static constexpr uint32_t m_bus_turnaround  = detail::hclk_cycles(bus_turnaround_ns);
+
+    //! Start of the bank in the address space. Banks are 64 MiB apart.
+    static constexpr std::uintptr_t m_base      = 0x60000000 + (bank / 2) * 0x04000000;
+
+    static_assert(bank == FSMC_Bank1_NORSRAM1 || bank == FSMC_Bank1_NORSRAM2
+                  || bank == FSMC_Bank1_NORSRAM3 || bank == FSMC_Bank1_NORSRAM4,
+                  "Only NOR/SRAM banks can hold RAM");
+    static_assert(memory_type == FSMC_MemoryType_SRAM || memory_type == FSMC_MemoryType_PSRAM,
+                  "Memory must be SRAM or PSRAM");
+    static_assert(m_address_setup <= 0xf, "Address setup time is too long");
+    static_assert(m_data_setup <= 0xff, "Data setup time is too long");
+    static_assert(m_bus_turnaround <= 0xf, "Bus turnaround is too long");
+};
+
+//!
+//! \brief External RAM.
+//! \tparam ext_ram_config Memory configuration. \sa ext_ram_config
+//!
+template< class ext_ram_config >
+class ext_ram
+{
+public:
+    //!
+    //! \brief Sets up FSMC bank, memory is accessible after.
+    //! Pins must be configured before.
+    //!
+    static void init();
+
+    //!
+    //! \brief Gets start of the memory.
+    //!
+    static constexpr std::uintptr_t base();
+
+    //!
+    //! \brief Checks that memory responds, by writing and reading back
+    //! data lines and address lines. Content of the memory is destroyed,
+    //! so probe is done by the board before any object is placed there.
+    //! \param[in] size Size of the memory, in bytes, power of two.
+    //! \retval err::ok     Memory works.
+    //! \retval err::inval  Size is not a power of two.
+    //! \retval err::io     Data or address line is stuck or shorted.
+    //!
+    static ecl::err probe(size_t size);
+};
+
+//------------------------------------------------------------------------------
+
+template< class ext_ram_config >
+void ext_ram< ext_ram_config >::init()
+{
+    RCC_AHB3PeriphClockCmd(RCC_AHB3Periph_FSMC, ENABLE);
+
+    FSMC_NORSRAMTimingInitTypeDef timing{};
+
+    timing.FSMC_AddressSetupTime        = ext_ram_config::m_address_setup;
+    timing.FSMC_AddressHoldTime         = 1;
+    timing.FSMC_DataSetupTime           = ext_ram_config::m_data_setup;
+    timing.FSMC_BusTurnAroundDuration   = ext_ram_config::m_bus_turnaround;
+    timing.FSMC_CLKDivision             = 1;
+    timing.FSMC_DataLatency             = 0;
+    timing.FSMC_AccessMode              = FSMC_AccessMode_A;
+
+    // NORSRAMStructInit() is not used, it writes through timing pointers
+    FSMC_NORSRAMInitTypeDef init_struct;
+
+    init_struct.FSMC_Bank                   = ext_ram_config::m_bank;
+    init_struct.FSMC_DataAddressMux         = FSMC_DataAddressMux_Disable;
+    init_struct.FSMC_MemoryType             = ext_ram_config::m_memory_type;
+    init_struct.FSMC_MemoryDataWidth        = ext_ram_config::m_data_width;
+    init_struct.FSMC_BurstAccessMode        = FSMC_BurstAccessMode_Disable;
+    init_struct.FSMC_AsynchronousWait       = FSMC_AsynchronousWait_Disable;
+    init_struct.FSMC_WaitSignalPolarity     = FSMC_WaitSignalPolarity_Low;
+    init_struct.FSMC_WrapMode               = FSMC_WrapMode_Disable;
+    init_struct.FSMC_WaitSignalActive       = FSMC_WaitSignalActive_BeforeWaitState;
+    init_struct.FSMC_WriteOperation         = FSMC_WriteOperation_Enable;
+    init_struct.FSMC_WaitSignal             = FSMC_WaitSignal_Disable;
+    init_struct.FSMC_ExtendedMode           = FSMC_ExtendedMode_Disable;
+    init_struct.FSMC_WriteBurst             = FSMC_WriteBurst_Disable;
+    init_struct.FSMC_ReadWriteTimingStruct  = &timing;
+    init_struct.FSMC_WriteTimingStruct      = &timing;
+
+    FSMC_NORSRAMInit(&init_struct);
+    FSMC_NORSRAMCmd(ext_ram_config::m_bank, ENABLE);
+}
+
+template< class ext_ram_config >
+constexpr std::uintptr_t ext_ram< ext_ram_config >::base()
+{
+    return ext_ram_config::m_base;
+}
+
+template< class ext_ram_config >
+ecl::err ext_ram< ext_ram_config >::probe(size_t size)
+{
+    auto mem = reinterpret_cast< volatile uint32_t * >(base());
+    size_t words = size / sizeof(uint32_t);
+
+    if (!words || (words & (words - 1))) {
+        return ecl::err::inval;
+    }
+
+    // Walking one over data lines
+    for (uint32_t pattern = 1; pattern; pattern <<= 1) {
+        mem[0] = pattern;
+        if (mem[0] != pattern) {
+            return ecl::err::io;
+        }
+    }
+
+    // Each address line selects own word, see if there are aliases
+    mem[0] = 0xaaaaaaaa;
+    for (size_t offt = 1; offt < words; offt <<= 1) {
+        mem[offt] = 0xaaaaaaaa;
+    }
+
+    mem[0] = 0x55555555;
+    for (size_t offt = 1; offt < words; offt <<= 1) {
+        if (mem[offt] != 0xaaaaaaaa) {
+            return ecl::err::io;
+        }
+    }
+
+    for (size_t offt = 1; offt < words; offt <<= 1) {
+        mem[offt] = 0x55555555;
+
+        if (mem[0] != 0x55555555) {
+            return ecl::err::io;
+        }
+
+        for (size_t other = 1; other < words; other <<= 1) {
+            if (other != offt && mem[other] != 0xaaaaaaaa) {
+                return ecl::err::io;
+            }
+        }
+
+        mem[offt] = 0xaaaaaaaa;
+    }
+
+    return ecl::err::ok;
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_EXT_RAM_HPP_
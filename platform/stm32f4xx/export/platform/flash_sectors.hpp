@@ -0,0 +1,147 @@
+#ifndef PLATFORM_FLASH_SECTORS_HPP_
+#define PLATFORM_FLASH_SECTORS_HPP_
+
+//!
+//! \file
+//! \brief Internal flash sectors, i.e. to keep configuration in.
+//! Sectors must be excluded from the firmware image by linker script.
+//! \sa ecl::kv_store
+//!
+
+#include <ecl/err.hpp>
+
+#include <stm32f4xx_flash.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+namespace flash_detail
+{
+
+//! Size of a sector in KiB, bank 2 repeats layout of bank 1.
+constexpr size_t kib(size_t n)
+{
+    return n % 12 < 4 ? 16 : n % 12 == 4 ? 64 : 128;
+}
+
+//! Offset of a sector from start of flash, in KiB.
+constexpr size_t start(size_t n)
+{
+    return n ? start(n - 1) + kib(n - 1) : 0;
+}
+
+constexpr bool same_size(size_t n, size_t left)
+{
+    return left < 2 || (kib(n) == kib(n + 1) && same_size(n + 1, left - 1));
+}
+
+} // namespace flash_detail
+
+//!
+//! \brief Range of equal internal flash sectors.
+//! Implements flash sectors interface of ecl::kv_store. Erase and program
+//! stall the CPU, including code executed from flash, so store updates
+//! shouldn't be done in time-critical paths.
+//! \tparam first Number of the first sector, i.e. 1 for sectors 1 to 3.
+//! \tparam count Amount of sectors.
+//!
+template< size_t first, size_t count >
+class flash_sectors
+{
+    static_assert(count > 0 && first + count <= 24, "Sectors don't exist");
+    static_assert(flash_detail::same_size(first, count), "Sectors must be of the same size");
+
+public:
+    enum : size_t
+    {
+        sector_size = flash_detail::kib(first) * 1024,  //!< Size of each sector.
+        sectors     = count,                            //!< Amount of sectors.
+    };
+
+    //!
+    //! \brief Gets content of a sector.
+    //!
+    static const uint8_t *map(size_t sector)
+    {
+        return reinterpret_cast< const uint8_t * >(address(sector, 0));
+    }
+
+    //!
+    //! \brief Erases a sector.
+    //! Supply voltage is assumed to be in 2.7 - 3.6 V range.
+    //! \retval err::ok    Sector is erased.
+    //! \retval err::inval Sector doesn't exist.
+    //! \retval err::io    Flash reported an error.
+    //!
+    static err erase(size_t sector);
+
+    //!
+    //! \brief Programs words of a sector.
+    //! \retval err::ok    Words are programmed.
+    //! \retval err::inval Words are unaligned or outside of the sector.
+    //! \retval err::io    Flash reported an error.
+    //!
+    static err program(size_t sector, size_t offset, const uint32_t *words, size_t n);
+
+private:
+    static uint32_t address(size_t sector, size_t at)
+    {
+        return FLASH_BASE + flash_detail::start(first) * 1024 + sector * sector_size + at;
+    }
+
+    //! Sector number, as SPL encodes it.
+    static uint32_t spl_sector(size_t sector)
+    {
+        size_t n = first + sector;
+        return (n < 12 ? n : n - 12 + 16) * FLASH_Sector_1;
+    }
+
+    static void unlock()
+    {
+        FLASH_Unlock();
+        FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR
+                        | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+    }
+};
+
+//------------------------------------------------------------------------------
+
+template< size_t first, size_t count >
+err flash_sectors< first, count >::erase(size_t sector)
+{
+    if (sector >= count) {
+        return err::inval;
+    }
+
+    unlock();
+    auto status = FLASH_EraseSector(spl_sector(sector), VoltageRange_3);
+    FLASH_Lock();
+
+    return status == FLASH_COMPLETE ? err::ok : err::io;
+}
+
+template< size_t first, size_t count >
+err flash_sectors< first, count >::program(size_t sector, size_t offset,
+                                           const uint32_t *words, size_t n)
+{
+    if (sector >= count || offset % 4 || offset + n * 4 > sector_size) {
+        return err::inval;
+    }
+
+    auto status = FLASH_COMPLETE;
+
+    unlock();
+    for (size_t i = 0; i < n && status == FLASH_COMPLETE; ++i) {
+        status = FLASH_ProgramWord(address(sector, offset + i * 4), words[i]);
+    }
+    FLASH_Lock();
+
+    return status == FLASH_COMPLETE ? err::ok : err::io;
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_FLASH_SECTORS_HPP_
@@ -4,12 +4,110 @@
 #include <common/pin.hpp>
 #include "pin_descriptor.hpp"
 
+#include <ecl/regs.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Pins are driven through registers directly. BSRR is used for output,
+// so pin changes are atomic and other pins of the port are never
+// read-modified-written.
+
+namespace gpio_detail
+{
+
+// Amount of GPIO ports
+static constexpr int port_count = static_cast< int >(pin::port::port_k) + 1;
+
+// Halves of BSRR and input data, as seen by single pin operations
+using bsrrl = ECL_REG(GPIO_TypeDef, BSRRL);
+using bsrrh = ECL_REG(GPIO_TypeDef, BSRRH);
+using idr   = ECL_REG(GPIO_TypeDef, IDR);
+
+// Gets registers of the port
+static inline GPIO_TypeDef *regs(pin::port port)
+{
+    return reinterpret_cast< GPIO_TypeDef* >(pick_port_base(port));
+}
+
+// Writes BSRR: lower half sets pins, upper half resets them
+static inline void write_bsrr(GPIO_TypeDef *regs, uint32_t val)
+{
+    *reinterpret_cast< volatile uint32_t* >(&regs->BSRRL) = val;
+}
+
+// Gets BSRR value that inverts pins in the mask
+static inline uint32_t toggle_bsrr(GPIO_TypeDef *regs, uint16_t mask)
+{
+    uint32_t odr = regs->ODR;
+    return (~odr & mask) | ((odr & mask) << 16);
+}
+
+// Gets mask of the group pins, that belong to given port
+template< class... Pins >
+constexpr uint16_t port_mask(pin::port port)
+{
+    const pin::port ports[] = { Pins::port_id... };
+    const uint16_t masks[] = { Pins::pin_mask... };
+    uint16_t mask = 0;
+
+    for (size_t i = 0; i < sizeof...(Pins); ++i) {
+        if (ports[i] == port) {
+            mask |= masks[i];
+        }
+    }
+
+    return mask;
+}
+
+// Converts group value to the pin values of given port.
+// Bit N of the group value corresponds to N-th pin of the group.
+template< class... Pins >
+inline uint16_t scatter(pin::port port, uint32_t value)
+{
+    const pin::port ports[] = { Pins::port_id... };
+    const uint16_t masks[] = { Pins::pin_mask... };
+    uint16_t bits = 0;
+
+    for (size_t i = 0; i < sizeof...(Pins); ++i) {
+        if (ports[i] == port && (value & (1UL << i))) {
+            bits |= masks[i];
+        }
+    }
+
+    return bits;
+}
+
+// Converts pin values of given port to the group value
+template< class... Pins >
+inline uint32_t gather(pin::port port, uint32_t idr)
+{
+    const pin::port ports[] = { Pins::port_id... };
+    const uint16_t masks[] = { Pins::pin_mask... };
+    uint32_t value = 0;
+
+    for (size_t i = 0; i < sizeof...(Pins); ++i) {
+        if (ports[i] == port && (idr & masks[i])) {
+            value |= 1UL << i;
+        }
+    }
+
+    return value;
+}
+
+} // namespace gpio_detail
+
 // TODO: support for output port as well
 // Incapsulate pin usage
 template< pin::port port, pin::number pin >
 class GPIO
 {
 public:
+    // Port and pin, used by gpio_group
+    static constexpr ::pin::port    port_id     = port;
+    static constexpr uint16_t       pin_mask    = 1 << static_cast< int >(pin);
+
     // Set pin to 1
     static void set();
 
@@ -21,43 +119,142 @@ public:
 
     // Get input data
     static uint8_t get();
+
+private:
+    // Bits of the pin in GPIO registers
+    using set_bit   = ecl::regs::bits< gpio_detail::bsrrl, pin_mask >;
+    using reset_bit = ecl::regs::bits< gpio_detail::bsrrh, pin_mask >;
+    using input_bit = ecl::regs::bits< gpio_detail::idr, pin_mask >;
+};
+
+// Group of pins, driven at once. Pins of the same port are changed by
+// single register write, i.e. to toggle CS and D/C lines together or
+// to drive a parallel bit-banged bus.
+// Pins of different ports are allowed, one write per port is done then.
+template< class... Pins >
+class gpio_group
+{
+    static_assert(sizeof...(Pins) > 0, "Group must contain pins");
+    static_assert(sizeof...(Pins) <= 32, "Group value is 32 bits wide");
+
+public:
+    // Set all pins to 1
+    static void set();
+
+    // Set all pins to 0
+    static void reset();
+
+    // Toggle all pins
+    static void toggle();
+
+    // Sets pins according to the value. Bit N of the value is written
+    // to N-th pin of the group.
+    static void write(uint32_t value);
+
+    // Gets input data of all pins. Bit N of the returned value holds
+    // input of N-th pin of the group.
+    static uint32_t get();
+
+private:
+    // Invokes an operation for each port, that has pins in the group
+    template< class Op, int port >
+    static void for_each_port(const Op &op, std::integral_constant< int, port >);
+
+    template< class Op >
+    static void for_each_port(const Op &, std::integral_constant< int, gpio_detail::port_count >) {}
+
+    template< class Op >
+    static void for_each_port(const Op &op)
+    { for_each_port(op, std::integral_constant< int, 0 >{}); }
 };
 
+//------------------------------------------------------------------------------
+
 template< pin::port port, pin::number pin >
 void GPIO< port, pin >::set()
 {
-    constexpr auto m_port = pick_port(port);
-    constexpr auto m_pin  = pick_pin(pin);
-
-    GPIO_WriteBit(m_port, m_pin, Bit_SET);
+    ecl::regs::store< set_bit >(gpio_detail::regs(port));
 }
 
 template< pin::port port, pin::number pin >
 void GPIO< port, pin >::reset()
 {
-    constexpr auto m_port = pick_port(port);
-    constexpr auto m_pin  = pick_pin(pin);
-
-    GPIO_WriteBit(m_port, m_pin, Bit_RESET);
+    ecl::regs::store< reset_bit >(gpio_detail::regs(port));
 }
 
 template< pin::port port, pin::number pin >
 void GPIO< port, pin >::toggle()
 {
-    constexpr auto m_port = pick_port(port);
-    constexpr auto m_pin  = pick_pin(pin);
-
-    GPIO_ToggleBits(m_port, m_pin);
+    auto regs = gpio_detail::regs(port);
+    gpio_detail::write_bsrr(regs, gpio_detail::toggle_bsrr(regs, pin_mask));
 }
 
 template< pin::port port, pin::number pin >
 uint8_t GPIO< port, pin >::get()
 {
-    constexpr auto m_port = pick_port(port);
-    constexpr auto m_pin  = pick_pin(pin);
+    return ecl::regs::test< input_bit >(gpio_detail::regs(port)) ? 1 : 0;
+}
 
-    return static_cast< uint8_t >(GPIO_ReadInputDataBit(m_port, m_pin));
+//------------------------------------------------------------------------------
+
+template< class... Pins >
+void gpio_group< Pins... >::set()
+{
+    for_each_port([](GPIO_TypeDef *regs, pin::port, uint16_t mask) {
+        gpio_detail::write_bsrr(regs, mask);
+    });
 }
 
+template< class... Pins >
+void gpio_group< Pins... >::reset()
+{
+    for_each_port([](GPIO_TypeDef *regs, pin::port, uint16_t mask) {
+        gpio_detail::write_bsrr(regs, static_cast< uint32_t >(mask) << 16);
+    });
+}
+
+template< class... Pins >
+void gpio_group< Pins... >::toggle()
+{
+    for_each_port([](GPIO_TypeDef *regs, pin::port, uint16_t mask) {
+        gpio_detail::write_bsrr(regs, gpio_detail::toggle_bsrr(regs, mask));
+    });
+}
+
+template< class... Pins >
+void gpio_group< Pins... >::write(uint32_t value)
+{
+    for_each_port([value](GPIO_TypeDef *regs, pin::port port, uint16_t mask) {
+        uint16_t bits = gpio_detail::scatter< Pins... >(port, value);
+        gpio_detail::write_bsrr(regs, bits | (static_cast< uint32_t >(mask & ~bits) << 16));
+    });
+}
+
+template< class... Pins >
+uint32_t gpio_group< Pins... >::get()
+{
+    uint32_t value = 0;
+
+    for_each_port([&value](GPIO_TypeDef *regs, pin::port port, uint16_t) {
+        value |= gpio_detail::gather< Pins... >(port, regs->IDR);
+    });
+
+    return value;
+}
+
+template< class... Pins >
+template< class Op, int port >
+void gpio_group< Pins... >::for_each_port(const Op &op, std::integral_constant< int, port >)
+{
+    constexpr auto id = static_cast< pin::port >(port);
+    constexpr uint16_t mask = gpio_detail::port_mask< Pins... >(id);
+
+    // Mask is known at compile time, ports without pins cost nothing
+    if (mask) {
+        op(gpio_detail::regs(id), id, mask);
+    }
+
+    for_each_port(op, std::integral_constant< int, port + 1 >{});
+}
 
 #endif
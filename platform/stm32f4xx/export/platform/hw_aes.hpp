@@ -0,0 +1,500 @@
+#ifndef PLATFORM_HW_AES_HPP_
+#define PLATFORM_HW_AES_HPP_
+
+//!
+//! \file
+//! \brief AES cipher, executed by CRYP processor.
+//! CRYP processor is present on STM32F415/417 and STM32F437/439, which
+//! is told by CONFIG_HW_CRYPTO build option, \sa hw_hash.hpp. On other
+//! parts ecl::hw_aes resolves to software ecl::crypto::aes.
+//!
+
+#include <platform/dma_manager.hpp>
+
+#include <ecl/crypto/aes.hpp>
+
+#ifdef CONFIG_HW_CRYPTO
+
+#include <platform/irq_manager.hpp>
+#include <platform/dma_device.hpp>
+#include <platform/memory.hpp>
+
+#include <ecl/thread/completion.hpp>
+#include <ecl/thread/sleep_lock.hpp>
+#include <ecl/assert.h>
+
+#include <stm32f4xx_cryp.h>
+#include <stm32f4xx_dma.h>
+#include <stm32f4xx_rcc.h>
+
+#include <cstring>
+
+#endif // CONFIG_HW_CRYPTO
+
+namespace ecl
+{
+
+//!
+//! \brief AES, computed by software.
+//! Used in place of cryp_unit when CRYP processor is not available.
+//!
+class soft_aes_unit : public crypto::aes
+{
+public:
+    //! No streams are used. \sa dma::exclusive_streams
+    using dma_streams = dma::stream_list<>;
+};
+
+#ifdef CONFIG_HW_CRYPTO
+
+//!
+//! \brief AES, computed by CRYP processor.
+//! Interface is the same as one of ecl::crypto::aes. Data is moved through
+//! the processor by a pair of DMA streams if buffers are DMA capable and
+//! word aligned, otherwise by CPU, block by block.
+//! Only one object can use the processor at a time.
+//! \note In CTR mode processor increments only lower 32 bits of the counter
+//!       block, while software implementation carries into the whole block.
+//!       Results differ only if lower word wraps within a message.
+//! \tparam in_stream  DMA2 stream 6, wired to CRYP input.
+//! \tparam out_stream DMA2 stream 5, wired to CRYP output.
+//!
+template< std::uintptr_t in_stream = DMA2_Stream6_BASE,
+          std::uintptr_t out_stream = DMA2_Stream5_BASE >
+class cryp_unit
+{
+    static_assert(in_stream == DMA2_Stream6_BASE, "CRYP input is served by DMA2 stream 6 only");
+    static_assert(out_stream == DMA2_Stream5_BASE, "CRYP output is served by DMA2 stream 5 only");
+
+public:
+    //! Streams claimed by the driver. \sa dma::exclusive_streams
+    using dma_streams = dma::stream_list< in_stream, out_stream >;
+
+    enum : size_t
+    {
+        block_size = 16, //!< Size of the cipher block, in bytes.
+    };
+
+    cryp_unit();
+    ~cryp_unit();
+
+    //! \copydoc crypto::aes::set_key()
+    err set_key(const uint8_t *key, size_t size);
+
+    //! \copydoc crypto::aes::encrypt()
+    err encrypt(crypto::cipher_mode mode, const uint8_t *in, uint8_t *out, size_t size,
+                uint8_t *iv = nullptr);
+
+    //! \copydoc crypto::aes::decrypt()
+    err decrypt(crypto::cipher_mode mode, const uint8_t *in, uint8_t *out, size_t size,
+                uint8_t *iv = nullptr);
+
+    //! \copydoc crypto::aes::encrypt_block()
+    void encrypt_block(const uint8_t *in, uint8_t *out);
+
+    //! \copydoc crypto::aes::decrypt_block()
+    void decrypt_block(const uint8_t *in, uint8_t *out);
+
+private:
+    //! Runs whole operation on the processor.
+    err run(bool enc, crypto::cipher_mode mode, const uint8_t *in, uint8_t *out,
+            size_t size, uint8_t *iv);
+
+    //! Loads the key and the mode into the processor.
+    void configure(bool enc, crypto::cipher_mode mode, const uint8_t *iv);
+
+    //! Processes single block by CPU.
+    void process_cpu(const uint8_t *in, uint8_t *out);
+
+    //! Processes blocks by DMA.
+    //! \retval false DMA can't be used for these buffers.
+    bool process_dma(const uint8_t *in, uint8_t *out, size_t size);
+
+    static void in_irq_entry();
+    static void out_irq_entry();
+
+    //! Data below this is processed by CPU, since DMA setup costs more.
+    static constexpr size_t dma_threshold = 64;
+
+    static cryp_unit     *m_instance;    //!< Object that waits for DMA.
+
+    ecl::completion     m_done;         //!< Signalled when output DMA ends.
+    uint32_t            m_key[8];       //!< Key words, big-endian.
+    size_t              m_key_size;     //!< Key size in bytes, zero if not set.
+    volatile bool       m_dma_err;      //!< DMA failed.
+};
+
+#endif // CONFIG_HW_CRYPTO
+
+//!
+//! \brief AES, computed by CRYP processor where available.
+//! Resolves to cryp_unit on parts with the processor and to
+//! software implementation otherwise.
+//!
+#ifdef CONFIG_HW_CRYPTO
+using hw_aes = cryp_unit<>;
+#else
+using hw_aes = soft_aes_unit;
+#endif
+
+//------------------------------------------------------------------------------
+
+#ifdef CONFIG_HW_CRYPTO
+
+namespace cryp_detail
+{
+
+inline uint32_t load_be(const uint8_t *p)
+{
+    return (static_cast< uint32_t >(p[0]) << 24) | (static_cast< uint32_t >(p[1]) << 16)
+         | (static_cast< uint32_t >(p[2]) << 8)  | p[3];
+}
+
+inline void store_be(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+} // namespace cryp_detail
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+cryp_unit< in_stream, out_stream > *cryp_unit< in_stream, out_stream >::m_instance{nullptr};
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+cryp_unit< in_stream, out_stream >::cryp_unit()
+    :m_done{}
+    ,m_key{}
+    ,m_key_size{0}
+    ,m_dma_err{false}
+{
+}
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+cryp_unit< in_stream, out_stream >::~cryp_unit()
+{
+    volatile uint32_t *p = m_key;
+
+    for (size_t i = 0; i < 8; ++i) {
+        p[i] = 0;
+    }
+}
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+err cryp_unit< in_stream, out_stream >::set_key(const uint8_t *key, size_t size)
+{
+    if (!key || (size != 16 && size != 24 && size != 32)) {
+        return err::inval;
+    }
+
+    // Key is right-aligned in key registers, shorter keys leave
+    // leading words unused
+    size_t first = 8 - size / 4;
+
+    for (size_t i = 0; i < 8; ++i) {
+        m_key[i] = i < first ? 0 : cryp_detail::load_be(key + 4 * (i - first));
+    }
+
+    m_key_size = size;
+    return err::ok;
+}
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+err cryp_unit< in_stream, out_stream >::encrypt(crypto::cipher_mode mode, const uint8_t *in,
+                                                uint8_t *out, size_t size, uint8_t *iv)
+{
+    return run(true, mode, in, out, size, iv);
+}
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+err cryp_unit< in_stream, out_stream >::decrypt(crypto::cipher_mode mode, const uint8_t *in,
+                                                uint8_t *out, size_t size, uint8_t *iv)
+{
+    return run(false, mode, in, out, size, iv);
+}
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+void cryp_unit< in_stream, out_stream >::encrypt_block(const uint8_t *in, uint8_t *out)
+{
+    ecl_assert(m_key_size);
+    run(true, crypto::cipher_mode::ecb, in, out, block_size, nullptr);
+}
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+void cryp_unit< in_stream, out_stream >::decrypt_block(const uint8_t *in, uint8_t *out)
+{
+    ecl_assert(m_key_size);
+    run(false, crypto::cipher_mode::ecb, in, out, block_size, nullptr);
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+err cryp_unit< in_stream, out_stream >::run(bool enc, crypto::cipher_mode mode,
+                                            const uint8_t *in, uint8_t *out,
+                                            size_t size, uint8_t *iv)
+{
+    bool ctr = mode == crypto::cipher_mode::ctr;
+
+    if (!m_key_size || (mode != crypto::cipher_mode::ecb && !iv)) {
+        return err::inval;
+    }
+
+    if (!ctr && (size % block_size)) {
+        return err::inval;
+    }
+
+    configure(enc, mode, iv);
+
+    size_t whole = size & ~(block_size - 1);
+    size_t done  = 0;
+
+    if (whole >= dma_threshold && process_dma(in, out, whole)) {
+        done = whole;
+    }
+
+    for (; done < whole; done += block_size) {
+        process_cpu(in + done, out + done);
+    }
+
+    // Tail of CTR is xored with a keystream block, computed from zeros
+    if (done < size) {
+        uint8_t block[block_size] = {};
+
+        memcpy(block, in + done, size - done);
+        process_cpu(block, block);
+        memcpy(out + done, block, size - done);
+    }
+
+    CRYP_Cmd(DISABLE);
+
+    // Processor keeps chaining value updated
+    if (iv) {
+        cryp_detail::store_be(iv,      CRYP->IV0LR);
+        cryp_detail::store_be(iv + 4,  CRYP->IV0RR);
+        cryp_detail::store_be(iv + 8,  CRYP->IV1LR);
+        cryp_detail::store_be(iv + 12, CRYP->IV1RR);
+    }
+
+    return err::ok;
+}
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+void cryp_unit< in_stream, out_stream >::configure(bool enc, crypto::cipher_mode mode,
+                                                   const uint8_t *iv)
+{
+    RCC_AHB2PeriphClockCmd(RCC_AHB2Periph_CRYP, ENABLE);
+
+    CRYP_KeyInitTypeDef key;
+
+    key.CRYP_Key0Left   = m_key[0];
+    key.CRYP_Key0Right  = m_key[1];
+    key.CRYP_Key1Left   = m_key[2];
+    key.CRYP_Key1Right  = m_key[3];
+    key.CRYP_Key2Left   = m_key[4];
+    key.CRYP_Key2Right  = m_key[5];
+    key.CRYP_Key3Left   = m_key[6];
+    key.CRYP_Key3Right  = m_key[7];
+
+    CRYP_InitTypeDef init;
+
+    init.CRYP_DataType  = CRYP_DataType_8b;
+    init.CRYP_KeySize   = m_key_size == 16 ? CRYP_KeySize_128b
+                        : m_key_size == 24 ? CRYP_KeySize_192b
+                                           : CRYP_KeySize_256b;
+
+    CRYP_Cmd(DISABLE);
+    CRYP_KeyInit(&key);
+
+    // Decryption in ECB and CBC modes needs the last round key,
+    // prepared by the processor from the key
+    if (!enc && mode != crypto::cipher_mode::ctr) {
+        init.CRYP_AlgoDir   = CRYP_AlgoDir_Decrypt;
+        init.CRYP_AlgoMode  = CRYP_AlgoMode_AES_Key;
+
+        CRYP_Init(&init);
+        CRYP_Cmd(ENABLE);
+
+        while (CRYP_GetFlagStatus(CRYP_FLAG_BUSY) != RESET) { }
+
+        CRYP_Cmd(DISABLE);
+    }
+
+    // CTR decryption is the same as encryption
+    init.CRYP_AlgoDir   = (enc || mode == crypto::cipher_mode::ctr)
+                        ? CRYP_AlgoDir_Encrypt : CRYP_AlgoDir_Decrypt;
+    init.CRYP_AlgoMode  = mode == crypto::cipher_mode::ecb ? CRYP_AlgoMode_AES_ECB
+                        : mode == crypto::cipher_mode::cbc ? CRYP_AlgoMode_AES_CBC
+                                                           : CRYP_AlgoMode_AES_CTR;
+
+    CRYP_Init(&init);
+
+    if (iv) {
+        CRYP_IVInitTypeDef iv_init;
+
+        iv_init.CRYP_IV0Left    = cryp_detail::load_be(iv);
+        iv_init.CRYP_IV0Right   = cryp_detail::load_be(iv + 4);
+        iv_init.CRYP_IV1Left    = cryp_detail::load_be(iv + 8);
+        iv_init.CRYP_IV1Right   = cryp_detail::load_be(iv + 12);
+
+        CRYP_IVInit(&iv_init);
+    }
+
+    CRYP_FIFOFlush();
+    CRYP_Cmd(ENABLE);
+}
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+void cryp_unit< in_stream, out_stream >::process_cpu(const uint8_t *in, uint8_t *out)
+{
+    uint32_t w[4];
+
+    memcpy(w, in, sizeof(w));
+
+    for (auto v : w) {
+        CRYP_DataIn(v);
+    }
+
+    for (auto &v : w) {
+        while (CRYP_GetFlagStatus(CRYP_FLAG_OFNE) == RESET) { }
+        v = CRYP_DataOut();
+    }
+
+    memcpy(out, w, sizeof(w));
+}
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+bool cryp_unit< in_stream, out_stream >::process_dma(const uint8_t *in, uint8_t *out,
+                                                     size_t size)
+{
+    constexpr auto istream = dma::get_stream< in_stream >();
+    constexpr auto ostream = dma::get_stream< out_stream >();
+
+    using in_lease  = dma::stream_lease< in_stream >;
+    using out_lease = dma::stream_lease< out_stream >;
+
+    auto aligned = [](const void *p) {
+        return !(reinterpret_cast< std::uintptr_t >(p) & 3);
+    };
+
+    if (!dma_capable(in) || !dma_capable(out) || !aligned(in) || !aligned(out)) {
+        return false;
+    }
+
+    if (is_error(in_lease::acquire(this, in_irq_entry))) {
+        return false;
+    }
+
+    if (is_error(out_lease::acquire(this, out_irq_entry))) {
+        in_lease::release();
+        return false;
+    }
+
+    sleep_lock::acquire();
+
+    m_instance = this;
+    m_dma_err  = false;
+
+    DMA_InitTypeDef dma_init;
+    DMA_StructInit(&dma_init);
+
+    // Bursts of four words match CRYP FIFO size, a block per burst
+    dma_init.DMA_Channel             = DMA_Channel_2;
+    dma_init.DMA_BufferSize          = size / 4;
+    dma_init.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+    dma_init.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+    dma_init.DMA_PeripheralDataSize  = DMA_PeripheralDataSize_Word;
+    dma_init.DMA_MemoryDataSize      = DMA_MemoryDataSize_Word;
+    dma_init.DMA_Mode                = DMA_Mode_Normal;
+    dma_init.DMA_Priority            = DMA_Priority_High;
+    dma_init.DMA_FIFOMode            = DMA_FIFOMode_Enable;
+    dma_init.DMA_FIFOThreshold       = DMA_FIFOThreshold_Full;
+    dma_init.DMA_MemoryBurst         = DMA_MemoryBurst_INC4;
+    dma_init.DMA_PeripheralBurst     = DMA_PeripheralBurst_INC4;
+
+    dma_init.DMA_PeripheralBaseAddr  = reinterpret_cast< uint32_t >(&CRYP->DR);
+    dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(in);
+    dma_init.DMA_DIR                 = DMA_DIR_MemoryToPeripheral;
+
+    DMA_DeInit(istream);
+    DMA_Init(istream, &dma_init);
+    DMA_ITConfig(istream, DMA_IT_TE, ENABLE);
+
+    dma_init.DMA_PeripheralBaseAddr  = reinterpret_cast< uint32_t >(&CRYP->DOUT);
+    dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(out);
+    dma_init.DMA_DIR                 = DMA_DIR_PeripheralToMemory;
+
+    DMA_DeInit(ostream);
+    DMA_Init(ostream, &dma_init);
+    DMA_ITConfig(ostream, DMA_IT_TC | DMA_IT_TE, ENABLE);
+
+    // Output is armed first, so no output word is missed
+    DMA_Cmd(ostream, ENABLE);
+    DMA_Cmd(istream, ENABLE);
+    CRYP_DMACmd(CRYP_DMAReq_DataIN | CRYP_DMAReq_DataOUT, ENABLE);
+
+    m_done.wait();
+
+    CRYP_DMACmd(CRYP_DMAReq_DataIN | CRYP_DMAReq_DataOUT, DISABLE);
+    DMA_ITConfig(istream, DMA_IT_TE, DISABLE);
+    DMA_ITConfig(ostream, DMA_IT_TC | DMA_IT_TE, DISABLE);
+    DMA_Cmd(istream, DISABLE);
+    DMA_Cmd(ostream, DISABLE);
+
+    sleep_lock::release();
+    out_lease::release();
+    in_lease::release();
+
+    // Buffers are checked above, only a bus fault can lead here
+    ecl_assert(!m_dma_err);
+
+    return true;
+}
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+void cryp_unit< in_stream, out_stream >::in_irq_entry()
+{
+    constexpr auto stream   = dma::get_stream< in_stream >();
+    constexpr auto err_if   = dma::get_err_if< in_stream >();
+    constexpr auto irqn     = dma::get_irqn< in_stream >();
+
+    if (DMA_GetITStatus(stream, err_if)) {
+        DMA_ClearITPendingBit(stream, err_if);
+        m_instance->m_dma_err = true;
+        m_instance->m_done.signal();
+    }
+
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+}
+
+template< std::uintptr_t in_stream, std::uintptr_t out_stream >
+void cryp_unit< in_stream, out_stream >::out_irq_entry()
+{
+    constexpr auto stream   = dma::get_stream< out_stream >();
+    constexpr auto tc_if    = dma::get_tc_if< out_stream >();
+    constexpr auto err_if   = dma::get_err_if< out_stream >();
+    constexpr auto irqn     = dma::get_irqn< out_stream >();
+
+    // Output ends after input, so its completion ends the operation
+    if (DMA_GetITStatus(stream, err_if)) {
+        DMA_ClearITPendingBit(stream, err_if);
+        m_instance->m_dma_err = true;
+        m_instance->m_done.signal();
+    } else if (DMA_GetITStatus(stream, tc_if)) {
+        DMA_ClearITPendingBit(stream, tc_if);
+        m_instance->m_done.signal();
+    }
+
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+}
+
+#endif // CONFIG_HW_CRYPTO
+
+} // namespace ecl
+
+#endif // PLATFORM_HW_AES_HPP_
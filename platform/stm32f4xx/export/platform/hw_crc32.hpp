@@ -0,0 +1,247 @@
+#ifndef PLATFORM_HW_CRC32_HPP_
+#define PLATFORM_HW_CRC32_HPP_
+
+//!
+//! \file
+//! \brief CRC-32 of words, computed by CRC unit.
+//! Result is the same as one of portable ecl::crc32(), so checksums
+//! computed on target can be verified on host and vice versa.
+//!
+
+#include <platform/irq_manager.hpp>
+#include <platform/dma_device.hpp>
+#include <platform/dma_manager.hpp>
+#include <platform/memory.hpp>
+#include <platform/utils.hpp>
+
+#include <ecl/thread/completion.hpp>
+#include <ecl/crc.hpp>
+#include <ecl/assert.h>
+
+#include <stm32f4xx_crc.h>
+#include <stm32f4xx_dma.h>
+#include <stm32f4xx_rcc.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Streaming CRC-32, computed by CRC unit.
+//! Large word-aligned blocks are fed to the unit by memory-to-memory DMA,
+//! small ones are written by CPU. Unit has no initial value register,
+//! so it continues a checksum only if it still holds the checksum's
+//! current value. Otherwise, i.e. when other object used the unit
+//! in between or the unit is busy, checksum is continued by ecl::crc32().
+//! Thus any amount of objects can be used concurrently, from threads or ISRs.
+//! \tparam dma_stream  DMA2 stream, leased for the transfer only.
+//! \tparam dma_channel DMA channel. Any, request line is not used.
+//!
+template< std::uintptr_t dma_stream = DMA2_Stream0_BASE, uint32_t dma_channel = DMA_Channel_0 >
+class crc_unit
+{
+    static_assert(dma_stream >= DMA2_Stream0_BASE && dma_stream <= DMA2_Stream7_BASE,
+                  "Only DMA2 supports memory-to-memory transfers");
+
+public:
+    //! Stream is leased at runtime, not claimed. \sa dma::exclusive_streams
+    using dma_streams = dma::stream_list<>;
+
+    crc_unit();
+
+    //!
+    //! \brief Starts a new checksum.
+    //!
+    void reset();
+
+    //!
+    //! \brief Appends words to the checksum.
+    //! \param[in] data Words.
+    //! \param[in] n    Amount of words.
+    //!
+    void update(const uint32_t *data, size_t n);
+
+    //!
+    //! \brief Gets current value of the checksum.
+    //!
+    uint32_t value() const;
+
+private:
+    //! Feeds words to the unit by DMA.
+    //! \retval false DMA can't be used for these words.
+    bool feed_dma(const uint32_t *data, size_t n);
+
+    static void dma_irq_entry();
+
+    //! Blocks below this are written by CPU, since DMA setup costs more.
+    static constexpr size_t dma_threshold = 16;
+
+    //! Maximum words per DMA transfer.
+    static constexpr size_t dma_max = 0xffff;
+
+    static std::atomic_bool m_busy;         //!< Unit is in use.
+    static crc_unit         *m_instance;    //!< Object that waits for DMA.
+
+    ecl::completion         m_done;         //!< Signalled when DMA ends.
+    uint32_t                m_crc;          //!< Current value.
+};
+
+//! CRC-32 of words, computed by CRC unit.
+using hw_crc32 = crc_unit<>;
+
+//------------------------------------------------------------------------------
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+std::atomic_bool crc_unit< dma_stream, dma_channel >::m_busy{false};
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+crc_unit< dma_stream, dma_channel > *crc_unit< dma_stream, dma_channel >::m_instance{nullptr};
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+crc_unit< dma_stream, dma_channel >::crc_unit()
+    :m_done{}
+    ,m_crc{0xffffffff}
+{
+}
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+void crc_unit< dma_stream, dma_channel >::reset()
+{
+    m_crc = 0xffffffff;
+}
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+void crc_unit< dma_stream, dma_channel >::update(const uint32_t *data, size_t n)
+{
+    if (!n) {
+        return;
+    }
+
+    if (m_busy.exchange(true)) {
+        m_crc = crc32(data, n, m_crc);
+        return;
+    }
+
+    RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_CRC, ENABLE);
+
+    // Unit can start a checksum or continue the one it holds
+    if (CRC->DR != m_crc) {
+        if (m_crc != 0xffffffff) {
+            m_busy = false;
+            m_crc = crc32(data, n, m_crc);
+            return;
+        }
+
+        CRC_ResetDR();
+    }
+
+    if (n < dma_threshold || !feed_dma(data, n)) {
+        CRC_CalcBlockCRC(const_cast< uint32_t * >(data), n);
+    }
+
+    m_crc = CRC->DR;
+    m_busy = false;
+}
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+uint32_t crc_unit< dma_stream, dma_channel >::value() const
+{
+    return m_crc;
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+bool crc_unit< dma_stream, dma_channel >::feed_dma(const uint32_t *data, size_t n)
+{
+    constexpr auto stream = dma::get_stream< dma_stream >();
+
+    using lease = dma::stream_lease< dma_stream >;
+
+    if (!dma_capable(data) || in_isr()) {
+        return false;
+    }
+
+    if (is_error(lease::acquire(this, dma_irq_entry))) {
+        return false;
+    }
+
+    m_instance = this;
+
+    DMA_InitTypeDef dma_init;
+    DMA_StructInit(&dma_init);
+
+    // In memory-to-memory mode peripheral port is the source,
+    // so words are read from the buffer and written to the data register.
+    dma_init.DMA_Channel             = dma_channel;
+    dma_init.DMA_DIR                 = DMA_DIR_MemoryToMemory;
+    dma_init.DMA_PeripheralInc       = DMA_PeripheralInc_Enable;
+    dma_init.DMA_MemoryInc           = DMA_MemoryInc_Disable;
+    dma_init.DMA_PeripheralDataSize  = DMA_PeripheralDataSize_Word;
+    dma_init.DMA_MemoryDataSize      = DMA_MemoryDataSize_Word;
+    dma_init.DMA_Mode                = DMA_Mode_Normal;
+    dma_init.DMA_Priority            = DMA_Priority_Low;
+    dma_init.DMA_FIFOMode            = DMA_FIFOMode_Enable;
+    dma_init.DMA_FIFOThreshold       = DMA_FIFOThreshold_Full;
+    dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(&CRC->DR);
+
+    bool ok = true;
+
+    while (n && ok) {
+        size_t chunk = n < dma_max ? n : dma_max;
+
+        dma_init.DMA_PeripheralBaseAddr = reinterpret_cast< uint32_t >(data);
+        dma_init.DMA_BufferSize         = chunk;
+
+        DMA_DeInit(stream);
+        DMA_Init(stream, &dma_init);
+        DMA_ITConfig(stream, DMA_IT_TC | DMA_IT_TE, ENABLE);
+        DMA_Cmd(stream, ENABLE);
+
+        m_done.wait();
+
+        ok = !DMA_GetFlagStatus(stream, dma::get_err_flag< dma_stream >());
+
+        DMA_ITConfig(stream, DMA_IT_TC | DMA_IT_TE, DISABLE);
+        DMA_Cmd(stream, DISABLE);
+
+        data += chunk;
+        n -= chunk;
+    }
+
+    lease::release();
+
+    // Buffer is checked above, only a bus fault can lead here
+    ecl_assert(ok);
+
+    return true;
+}
+
+template< std::uintptr_t dma_stream, uint32_t dma_channel >
+void crc_unit< dma_stream, dma_channel >::dma_irq_entry()
+{
+    constexpr auto stream   = dma::get_stream< dma_stream >();
+    constexpr auto tc_if    = dma::get_tc_if< dma_stream >();
+    constexpr auto err_if   = dma::get_err_if< dma_stream >();
+    constexpr auto irqn     = dma::get_irqn< dma_stream >();
+
+    // Error flag is kept for the waiter, only interrupt is masked
+    if (DMA_GetITStatus(stream, err_if)) {
+        DMA_ITConfig(stream, DMA_IT_TE, DISABLE);
+        m_instance->m_done.signal();
+    } else if (DMA_GetITStatus(stream, tc_if)) {
+        DMA_ClearITPendingBit(stream, tc_if);
+        m_instance->m_done.signal();
+    }
+
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_HW_CRC32_HPP_
@@ -0,0 +1,433 @@
+#ifndef PLATFORM_HW_HASH_HPP_
+#define PLATFORM_HW_HASH_HPP_
+
+//!
+//! \file
+//! \brief Message digests, computed by HASH processor.
+//! HASH processor is present on STM32F415/417 (MD5, SHA-1) and on
+//! STM32F437/439 (also SHA-224/256). Device headers don't tell these parts
+//! from ones without the processor, so its presence is given by the build:
+//! \li CONFIG_HW_CRYPTO   - part has HASH and CRYP processors.
+//! \li CONFIG_HW_HASH_SHA2 - HASH processor supports SHA-256 and
+//!                           multiple DMA transfers per message.
+//! Algorithms not supported by the part are served by ecl::crypto, so
+//! ecl::hw_hash< algo > can be used regardless of the part.
+//!
+
+#include <platform/dma_manager.hpp>
+
+#include <ecl/crypto/digest.hpp>
+
+#include <type_traits>
+
+#ifdef CONFIG_HW_CRYPTO
+
+#include <platform/irq_manager.hpp>
+#include <platform/dma_device.hpp>
+#include <platform/memory.hpp>
+
+#include <ecl/thread/completion.hpp>
+#include <ecl/thread/sleep_lock.hpp>
+#include <ecl/assert.h>
+
+#include <stm32f4xx_hash.h>
+#include <stm32f4xx_dma.h>
+#include <stm32f4xx_rcc.h>
+
+#include <algorithm>
+#include <cstring>
+
+#endif // CONFIG_HW_CRYPTO
+
+namespace ecl
+{
+
+//!
+//! \brief Checks if HASH processor of the part supports an algorithm.
+//!
+constexpr bool hash_unit_supports(crypto::hash_algo algo)
+{
+#if defined(CONFIG_HW_CRYPTO) && defined(CONFIG_HW_HASH_SHA2)
+    return (void)algo, true;
+#elif defined(CONFIG_HW_CRYPTO)
+    return algo != crypto::hash_algo::sha256;
+#else
+    return (void)algo, false;
+#endif
+}
+
+//!
+//! \brief Digest, computed by software.
+//! Used in place of hash_unit when HASH processor is not available.
+//!
+template< crypto::hash_algo algo >
+class soft_hash_unit : public crypto::soft_hash< algo >::type
+{
+public:
+    //! No streams are used. \sa dma::exclusive_streams
+    using dma_streams = dma::stream_list<>;
+};
+
+#ifdef CONFIG_HW_CRYPTO
+
+//!
+//! \brief Digest, computed by HASH processor.
+//! Interface is the same as one of ecl::crypto digests. Input is written
+//! to the processor by DMA, if it is large enough and DMA capable,
+//! otherwise by CPU. Digest computation itself never loads CPU.
+//! HASH processor holds state of a single message, so messages
+//! of different objects must not be interleaved.
+//! \tparam algo       Hash algorithm.
+//! \tparam dma_stream DMA2 stream 7, the only one wired to HASH input.
+//!
+template< crypto::hash_algo algo, std::uintptr_t dma_stream = DMA2_Stream7_BASE >
+class hash_unit
+{
+    static_assert(dma_stream == DMA2_Stream7_BASE, "HASH is served by DMA2 stream 7 only");
+    static_assert(hash_unit_supports(algo), "Algorithm is not supported by the HASH processor");
+
+public:
+    //! Stream claimed by the driver. \sa dma::exclusive_streams
+    using dma_streams = dma::stream_list< dma_stream >;
+
+    enum : size_t
+    {
+        digest_size = crypto::soft_hash< algo >::type::digest_size,
+        block_size  = 64,
+    };
+
+    hash_unit();
+    ~hash_unit();
+
+    //!
+    //! \brief Starts a new message.
+    //!
+    void reset();
+
+    //!
+    //! \brief Appends data to the message.
+    //! \param[in] data Data to hash.
+    //! \param[in] size Size of data.
+    //!
+    void update(const uint8_t *data, size_t size);
+
+    //!
+    //! \brief Completes the message and obtains the digest.
+    //! \param[out] digest Buffer of digest_size bytes.
+    //!
+    void finish(uint8_t *digest);
+
+private:
+    //! Takes the processor and starts a message on it.
+    void start();
+
+    //! Writes words to the processor by CPU.
+    void feed_cpu(const uint8_t *data, size_t words);
+
+    //! Writes words to the processor by DMA.
+    //! \retval false DMA can't be used for this data.
+    bool feed_dma(const uint8_t *data, size_t words);
+
+    static void dma_irq_entry();
+
+    //! Words below this are written by CPU, since DMA setup costs more.
+    //! Multiple DMA transfers per message require a whole amount of blocks.
+    static constexpr size_t dma_min_words = 16;
+
+    static hash_unit        *m_instance;    //!< Object that waits for DMA.
+
+    ecl::completion         m_done;         //!< Signalled when DMA ends.
+    uint8_t                 m_tail[4];      //!< Partial word of the message.
+    size_t                  m_tail_len;     //!< Bytes in partial word.
+    bool                    m_started;      //!< Message is started on the processor.
+    volatile bool           m_dma_err;      //!< DMA failed.
+};
+
+//!
+//! \brief Owner of HASH processor, shared by all hash_unit instantiations.
+//!
+template< class dummy = void >
+struct hash_owner
+{
+    static const void *current; //!< Object, having the message in progress.
+};
+
+template< class dummy >
+const void *hash_owner< dummy >::current{nullptr};
+
+#endif // CONFIG_HW_CRYPTO
+
+//!
+//! \brief Digest, computed by HASH processor where possible.
+//! Resolves to hash_unit if the part supports the algorithm and to
+//! software implementation otherwise.
+//! \code
+//!     ecl::hw_hash< ecl::crypto::hash_algo::sha256 > h;
+//!     ecl::crypto::digest_stream(h, *file, buf, sizeof(buf));
+//!     h.finish(out);
+//! \endcode
+//!
+#ifdef CONFIG_HW_CRYPTO
+template< crypto::hash_algo algo, std::uintptr_t dma_stream = DMA2_Stream7_BASE >
+using hw_hash = typename std::conditional< hash_unit_supports(algo),
+                                           hash_unit< algo, dma_stream >,
+                                           soft_hash_unit< algo > >::type;
+#else
+template< crypto::hash_algo algo, std::uintptr_t dma_stream = DMA2_Stream7_BASE >
+using hw_hash = soft_hash_unit< algo >;
+#endif
+
+//------------------------------------------------------------------------------
+
+#ifdef CONFIG_HW_CRYPTO
+
+template< crypto::hash_algo algo, std::uintptr_t dma_stream >
+hash_unit< algo, dma_stream > *hash_unit< algo, dma_stream >::m_instance{nullptr};
+
+template< crypto::hash_algo algo, std::uintptr_t dma_stream >
+hash_unit< algo, dma_stream >::hash_unit()
+    :m_done{}
+    ,m_tail{}
+    ,m_tail_len{0}
+    ,m_started{false}
+    ,m_dma_err{false}
+{
+}
+
+template< crypto::hash_algo algo, std::uintptr_t dma_stream >
+hash_unit< algo, dma_stream >::~hash_unit()
+{
+    // Abandoned message releases the processor
+    if (hash_owner<>::current == this) {
+        hash_owner<>::current = nullptr;
+    }
+}
+
+template< crypto::hash_algo algo, std::uintptr_t dma_stream >
+void hash_unit< algo, dma_stream >::reset()
+{
+    if (hash_owner<>::current == this) {
+        hash_owner<>::current = nullptr;
+    }
+
+    m_tail_len = 0;
+    m_started  = false;
+}
+
+template< crypto::hash_algo algo, std::uintptr_t dma_stream >
+void hash_unit< algo, dma_stream >::update(const uint8_t *data, size_t size)
+{
+    if (!size) {
+        return;
+    }
+
+    if (!m_started) {
+        start();
+    }
+
+    if (m_tail_len) {
+        size_t chunk = std::min(sizeof(m_tail) - m_tail_len, size);
+
+        memcpy(m_tail + m_tail_len, data, chunk);
+        m_tail_len += chunk;
+        data += chunk;
+        size -= chunk;
+
+        if (m_tail_len < sizeof(m_tail)) {
+            return;
+        }
+
+        feed_cpu(m_tail, 1);
+        m_tail_len = 0;
+    }
+
+    size_t words = size / 4;
+
+#ifdef CONFIG_HW_HASH_SHA2
+    size_t dma_words = words & ~(dma_min_words - 1);
+
+    if (dma_words && feed_dma(data, dma_words)) {
+        data  += dma_words * 4;
+        size  -= dma_words * 4;
+        words -= dma_words;
+    }
+#endif
+
+    feed_cpu(data, words);
+
+    m_tail_len = size - words * 4;
+    memcpy(m_tail, data + words * 4, m_tail_len);
+}
+
+template< crypto::hash_algo algo, std::uintptr_t dma_stream >
+void hash_unit< algo, dma_stream >::finish(uint8_t *digest)
+{
+    if (!m_started) {
+        start();
+    }
+
+    if (m_tail_len) {
+        memset(m_tail + m_tail_len, 0, sizeof(m_tail) - m_tail_len);
+        feed_cpu(m_tail, 1);
+    }
+
+    // Processor pads the message itself, it needs only valid bits
+    // of the last word
+    HASH_SetLastWordValidBitsNbr(8 * m_tail_len);
+    HASH_StartDigest();
+
+    while (HASH_GetFlagStatus(HASH_FLAG_BUSY) != RESET) { }
+
+    HASH_MsgDigest result;
+    HASH_GetDigest(&result);
+
+    // Digest registers hold words of the digest as big-endian numbers
+    for (size_t i = 0; i < digest_size / 4; ++i) {
+        uint32_t w = result.Data[i];
+
+        digest[4 * i]     = w >> 24;
+        digest[4 * i + 1] = w >> 16;
+        digest[4 * i + 2] = w >> 8;
+        digest[4 * i + 3] = w;
+    }
+
+    hash_owner<>::current = nullptr;
+
+    m_tail_len = 0;
+    m_started  = false;
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< crypto::hash_algo algo, std::uintptr_t dma_stream >
+void hash_unit< algo, dma_stream >::start()
+{
+    ecl_assert_msg(!hash_owner<>::current, "HASH processor is busy with other message");
+
+    hash_owner<>::current = this;
+
+    constexpr uint32_t selection =
+            algo == crypto::hash_algo::md5  ? HASH_AlgoSelection_MD5  :
+            algo == crypto::hash_algo::sha1 ? HASH_AlgoSelection_SHA1 :
+                                              HASH_AlgoSelection_SHA256;
+
+    RCC_AHB2PeriphClockCmd(RCC_AHB2Periph_HASH, ENABLE);
+
+    HASH_InitTypeDef init;
+    HASH_StructInit(&init);
+
+    // Bytes are swapped by the processor, so message is fed as is
+    init.HASH_AlgoSelection = selection;
+    init.HASH_AlgoMode      = HASH_AlgoMode_HASH;
+    init.HASH_DataType      = HASH_DataType_8b;
+
+    HASH_Init(&init);
+
+#ifdef CONFIG_HW_HASH_SHA2
+    // End of a DMA transfer must not be taken as the end of the message
+    HASH->CR |= HASH_CR_MDMAT;
+#endif
+
+    m_started = true;
+}
+
+template< crypto::hash_algo algo, std::uintptr_t dma_stream >
+void hash_unit< algo, dma_stream >::feed_cpu(const uint8_t *data, size_t words)
+{
+    // Writes are stalled by the bus while input FIFO is full
+    for (size_t i = 0; i < words; ++i) {
+        uint32_t w;
+        memcpy(&w, data + 4 * i, sizeof(w));
+        HASH_DataIn(w);
+    }
+}
+
+template< crypto::hash_algo algo, std::uintptr_t dma_stream >
+bool hash_unit< algo, dma_stream >::feed_dma(const uint8_t *data, size_t words)
+{
+    constexpr auto stream = dma::get_stream< dma_stream >();
+
+    using lease = dma::stream_lease< dma_stream >;
+
+    if (!dma_capable(data) || (reinterpret_cast< std::uintptr_t >(data) & 3)) {
+        return false;
+    }
+
+    if (is_error(lease::acquire(this, dma_irq_entry))) {
+        return false;
+    }
+
+    sleep_lock::acquire();
+
+    m_instance = this;
+    m_dma_err  = false;
+
+    DMA_InitTypeDef dma_init;
+    DMA_StructInit(&dma_init);
+
+    dma_init.DMA_Channel             = DMA_Channel_2;
+    dma_init.DMA_PeripheralBaseAddr  = reinterpret_cast< uint32_t >(&HASH->DIN);
+    dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(data);
+    dma_init.DMA_DIR                 = DMA_DIR_MemoryToPeripheral;
+    dma_init.DMA_BufferSize          = words;
+    dma_init.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+    dma_init.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+    dma_init.DMA_PeripheralDataSize  = DMA_PeripheralDataSize_Word;
+    dma_init.DMA_MemoryDataSize      = DMA_MemoryDataSize_Word;
+    dma_init.DMA_Mode                = DMA_Mode_Normal;
+    dma_init.DMA_Priority            = DMA_Priority_High;
+    dma_init.DMA_FIFOMode            = DMA_FIFOMode_Enable;
+    dma_init.DMA_FIFOThreshold       = DMA_FIFOThreshold_Full;
+    dma_init.DMA_MemoryBurst         = DMA_MemoryBurst_INC4;
+    dma_init.DMA_PeripheralBurst     = DMA_PeripheralBurst_Single;
+
+    DMA_DeInit(stream);
+    DMA_Init(stream, &dma_init);
+    DMA_ITConfig(stream, DMA_IT_TC | DMA_IT_TE, ENABLE);
+
+    HASH_DMACmd(ENABLE);
+    DMA_Cmd(stream, ENABLE);
+
+    m_done.wait();
+
+    DMA_ITConfig(stream, DMA_IT_TC | DMA_IT_TE, DISABLE);
+    DMA_Cmd(stream, DISABLE);
+    HASH_DMACmd(DISABLE);
+
+    sleep_lock::release();
+    lease::release();
+
+    // Buffer is checked above, so only a bus fault of a broken
+    // buffer can lead here. Message can't be recovered.
+    ecl_assert(!m_dma_err);
+
+    return true;
+}
+
+template< crypto::hash_algo algo, std::uintptr_t dma_stream >
+void hash_unit< algo, dma_stream >::dma_irq_entry()
+{
+    constexpr auto stream   = dma::get_stream< dma_stream >();
+    constexpr auto tc_if    = dma::get_tc_if< dma_stream >();
+    constexpr auto err_if   = dma::get_err_if< dma_stream >();
+    constexpr auto irqn     = dma::get_irqn< dma_stream >();
+
+    if (DMA_GetITStatus(stream, err_if)) {
+        DMA_ClearITPendingBit(stream, err_if);
+        m_instance->m_dma_err = true;
+        m_instance->m_done.signal();
+    } else if (DMA_GetITStatus(stream, tc_if)) {
+        DMA_ClearITPendingBit(stream, tc_if);
+        m_instance->m_done.signal();
+    }
+
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+}
+
+#endif // CONFIG_HW_CRYPTO
+
+} // namespace ecl
+
+#endif // PLATFORM_HW_HASH_HPP_
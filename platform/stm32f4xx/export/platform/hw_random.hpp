@@ -0,0 +1,257 @@
+#ifndef PLATFORM_HW_RANDOM_HPP_
+#define PLATFORM_HW_RANDOM_HPP_
+
+//!
+//! \file
+//! \brief True random numbers from RNG peripheral.
+//! RNG interrupt fills an entropy pool in background, thus words are
+//! taken without waiting for the peripheral while the pool has them.
+//! Pool is refilled when it becomes half-empty, RNG is stopped when
+//! pool is full, to save power.
+//!
+//! Requirements:
+//! \li RNG kernel clock is 48 MHz, i.e. PLL Q output is configured so.
+//! \li HASH_RNG IRQ is not used by anyone else. hw_hash doesn't use it.
+//!
+
+#include <platform/irq_manager.hpp>
+
+#include <ecl/crypto/entropy.hpp>
+#include <ecl/assert.h>
+
+#include <stm32f4xx_rng.h>
+#include <stm32f4xx_rcc.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace ecl
+{
+
+//!
+//! \brief RNG device.
+//! Satisfies UniformRandomBitGenerator, so it can be used with
+//! standard distributions:
+//! \code
+//!     ecl::hw_random<> rng;
+//!     std::uniform_int_distribution< int > dice{1, 6};
+//!     int n = dice(rng);
+//! \endcode
+//! All objects share the same peripheral and the same pool.
+//! \tparam pool_words Capacity of entropy pool, in words.
+//! \sa crypto::entropy_pool
+//!
+template< size_t pool_words = 64 >
+class hw_random
+{
+public:
+    using result_type = uint32_t;
+
+    //!
+    //! \brief Inits RNG and starts filling the pool.
+    //!
+    static void init();
+
+    //!
+    //! \brief Stops RNG. Words left in the pool still can be taken.
+    //!
+    static void deinit();
+
+    //!
+    //! \brief Gets random word.
+    //! Waits for the pool only if it is drained.
+    //! Can be called concurrently from threads and ISRs.
+    //!
+    result_type operator()();
+
+    //!
+    //! \brief Gets random words without waiting.
+    //! \param[out] out Words.
+    //! \param[in]  n   Amount of words requested.
+    //! \return Amount of words obtained, less than requested if pool
+    //!         is drained at the moment.
+    //!
+    static size_t read(result_type *out, size_t n);
+
+    //!
+    //! \brief Gets amount of health test and seed failures so far.
+    //! Each failure restarts the RNG.
+    //!
+    static size_t failures();
+
+    static constexpr result_type min()
+    {
+        return std::numeric_limits< result_type >::min();
+    }
+
+    static constexpr result_type max()
+    {
+        return std::numeric_limits< result_type >::max();
+    }
+
+private:
+    //! Starts RNG if pool is low.
+    static void kick();
+
+    //! Enables RNG and its interrupt.
+    static void start();
+
+    //! Disables RNG and its interrupt.
+    static void stop();
+
+    static void irq_handler();
+
+    //! Failures in a row, after which RNG is considered broken.
+    static constexpr size_t max_failures = 8;
+
+    static crypto::entropy_pool< pool_words >   m_pool;         //!< Conditioned words.
+    static std::atomic_bool                     m_running;      //!< RNG is running.
+    static std::atomic< size_t >                m_failures;     //!< Failures so far.
+    static size_t                               m_in_a_row;     //!< Failures in a row.
+};
+
+template< size_t pool_words >
+crypto::entropy_pool< pool_words > hw_random< pool_words >::m_pool{};
+
+template< size_t pool_words >
+std::atomic_bool hw_random< pool_words >::m_running{false};
+
+template< size_t pool_words >
+std::atomic< size_t > hw_random< pool_words >::m_failures{0};
+
+template< size_t pool_words >
+size_t hw_random< pool_words >::m_in_a_row{0};
+
+//------------------------------------------------------------------------------
+
+template< size_t pool_words >
+void hw_random< pool_words >::init()
+{
+    RCC_AHB2PeriphClockCmd(RCC_AHB2Periph_RNG, ENABLE);
+
+    IRQ_manager::mask(HASH_RNG_IRQn);
+    IRQ_manager::clear(HASH_RNG_IRQn);
+    IRQ_manager::subscribe(HASH_RNG_IRQn, irq_handler);
+    IRQ_manager::unmask(HASH_RNG_IRQn);
+
+    m_running = true;
+    start();
+}
+
+template< size_t pool_words >
+void hw_random< pool_words >::deinit()
+{
+    IRQ_manager::mask(HASH_RNG_IRQn);
+
+    stop();
+    m_running = false;
+
+    IRQ_manager::unsubscribe(HASH_RNG_IRQn);
+    RCC_AHB2PeriphClockCmd(RCC_AHB2Periph_RNG, DISABLE);
+}
+
+template< size_t pool_words >
+typename hw_random< pool_words >::result_type hw_random< pool_words >::operator()()
+{
+    result_type w;
+
+    while (!m_pool.pop(w)) {
+        ecl_assert_msg(m_in_a_row < max_failures, "RNG is broken");
+        kick();
+    }
+
+    kick();
+    return w;
+}
+
+template< size_t pool_words >
+size_t hw_random< pool_words >::read(result_type *out, size_t n)
+{
+    size_t i = 0;
+
+    for (; i < n && m_pool.pop(out[i]); ++i) { }
+
+    kick();
+    return i;
+}
+
+template< size_t pool_words >
+size_t hw_random< pool_words >::failures()
+{
+    return m_failures;
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< size_t pool_words >
+void hw_random< pool_words >::kick()
+{
+    if (m_pool.available() <= pool_words / 2 && !m_running.exchange(true)) {
+        start();
+    }
+}
+
+template< size_t pool_words >
+void hw_random< pool_words >::start()
+{
+    RNG_ClearFlag(RNG_FLAG_CECS | RNG_FLAG_SECS);
+    RNG_Cmd(ENABLE);
+    RNG_ITConfig(ENABLE);
+}
+
+template< size_t pool_words >
+void hw_random< pool_words >::stop()
+{
+    RNG_ITConfig(DISABLE);
+    RNG_Cmd(DISABLE);
+}
+
+template< size_t pool_words >
+void hw_random< pool_words >::irq_handler()
+{
+    bool restart = false;
+
+    if (RNG_GetITStatus(RNG_IT_SEI) != RESET) {
+        // Seed error is recovered by restarting the generator
+        RNG_ClearITPendingBit(RNG_IT_SEI);
+        restart = true;
+    } else if (RNG_GetITStatus(RNG_IT_CEI) != RESET) {
+        // Generator resumes by itself once clock is back
+        RNG_ClearITPendingBit(RNG_IT_CEI);
+    } else if (RNG_GetFlagStatus(RNG_FLAG_DRDY) != RESET) {
+        switch (m_pool.feed(RNG_GetRandomNumber())) {
+        case crypto::pool_status::failed:
+            restart = true;
+            break;
+        case crypto::pool_status::full:
+            m_in_a_row = 0;
+            stop();
+            m_running = false;
+            break;
+        case crypto::pool_status::more:
+            break;
+        }
+    }
+
+    if (restart) {
+        ++m_failures;
+        stop();
+        m_pool.restart();
+
+        if (++m_in_a_row < max_failures) {
+            start();
+        } else {
+            m_running = false;
+        }
+    }
+
+    IRQ_manager::clear(HASH_RNG_IRQn);
+    IRQ_manager::unmask(HASH_RNG_IRQn);
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_HW_RANDOM_HPP_
@@ -0,0 +1,857 @@
+//!
+//! \file
+//! \brief STM32F4xx I2C master driver
+//!
+
+#ifndef PLATFORM_I2C_BUS_HPP_
+#define PLATFORM_I2C_BUS_HPP_
+
+#include <platform/common/bus.hpp>
+#include <common/i2c.hpp>
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+
+#include <stm32f4xx_i2c.h>
+#include <stm32f4xx_rcc.h>
+
+#include <platform/irq_manager.hpp>
+#include <platform/dma_device.hpp>
+#include <platform/dma_manager.hpp>
+
+#include <cstdint>
+#include <cstddef>
+
+namespace ecl
+{
+
+//!
+//! \brief Configuration of I2C bus.
+//! Both streams are required. See reference manual for DMA request mapping,
+//! i.e. I2C1 TX is served by DMA1 stream 6 or 7, channel 1, while I2C1 RX
+//! is served by DMA1 stream 0 or 5, channel 1.
+//! \tparam dev             I2C device.
+//! \tparam dma_tx_stream   DMA stream used for TX.
+//! \tparam dma_tx_channel  DMA channel of the TX stream.
+//! \tparam dma_rx_stream   DMA stream used for RX.
+//! \tparam dma_rx_channel  DMA channel of the RX stream.
+//! \tparam clk             Bus clock, in Hz. Up to 100 kHz for standard mode,
+//!                         up to 400 kHz for fast mode.
+//! \tparam duty            Fast mode duty cycle: I2C_DutyCycle_2 or
+//!                         I2C_DutyCycle_16_9.
+//!
+template< i2c_device        dev,
+          std::uintptr_t    dma_tx_stream,
+          uint32_t          dma_tx_channel,
+          std::uintptr_t    dma_rx_stream,
+          uint32_t          dma_rx_channel,
+          uint32_t          clk = 100000,
+          uint16_t          duty = I2C_DutyCycle_2 >
+struct i2c_config
+{
+    static constexpr i2c_device         m_dev              = dev;
+    static constexpr uint32_t           m_clk              = clk;
+    static constexpr uint16_t           m_duty             = duty;
+    static constexpr uint32_t           m_dma_tx_channel   = dma_tx_channel;
+    static constexpr std::uintptr_t     m_dma_tx_stream    = dma_tx_stream;
+    static constexpr uint32_t           m_dma_rx_channel   = dma_rx_channel;
+    static constexpr std::uintptr_t     m_dma_rx_stream    = dma_rx_stream;
+
+    //! Streams claimed by the bus. \sa dma::exclusive_streams
+    using dma_streams = dma::stream_list< dma_tx_stream, dma_rx_stream >;
+
+    static_assert(dma_tx_stream != dma_rx_stream,
+                  "TX and RX must use different DMA streams");
+    static_assert(clk && clk <= 400000, "I2C clock is out of range");
+};
+
+//!
+//! \brief STM32F4 I2C master bus.
+//! Every xfer is a single I2C transaction with the slave, selected by
+//! set_address(). If only TX is set, bytes are written to the slave. If only
+//! RX is set, bytes are read from the slave. If both are set, TX is written
+//! first, then RX is read after repeated start, without releasing the bus in
+//! between. This is a common way to read device registers: register address
+//! is sent as TX, register contents are received as RX.
+//! If neither is set, only the address is sent. Xfer succeeds if the slave
+//! acknowledges it, so the bus can be probed for devices this way.
+//! Data is moved by DMA, CPU is involved only on transaction phases.
+//! \tparam i2c_config Bus configuration. \sa i2c_config
+//!
+template< class i2c_config >
+class i2c_bus
+{
+public:
+    // Convinient type aliases.
+    using channel       = ecl::bus_channel;
+    using event         = ecl::bus_event;
+    using handler_fn    = ecl::bus_handler;
+
+    //!
+    //! \brief Constructs a bus.
+    //!
+    i2c_bus();
+
+    //!
+    //! \brief Destructs a bus.
+    ~i2c_bus();
+
+    //!
+    //! \brief Lazy initialization.
+    //! \return Status of opeartion.
+    //!
+    ecl::err init();
+
+    //!
+    //! \brief Sets rx buffer with given size.
+    //! \param[in,out]  rx      Buffer to write data to. Optional.
+    //! \param[in]      size    Size
+    //!
+    void set_rx(uint8_t *rx, size_t size);
+
+    //!
+    //! \brief Sets rx buffer made-up from sequence of similar bytes.
+    //! \param[in] size         Size of sequence
+    //! \param[in] fill_byte    Byte to fill a sequence. Optional.
+    //!
+    void set_tx(size_t size, uint8_t fill_byte = 0xff);
+
+    //!
+    //! \brief Sets tx buffer with given size.
+    //! \param[in] tx   Buffer to transmit. Optional.
+    //! \param[in] size Buffer size.
+    //!
+    void set_tx(const uint8_t *tx, size_t size);
+
+    //!
+    //! \brief Sets event handler.
+    //! Handler will be used by the bus, until reset_handler() will be called.
+    //! \param[in] handler Handler itself.
+    //!
+    void set_handler(const handler_fn &handler);
+
+    //!
+    //! \brief Reset xfer buffers.
+    //! Buffers that were set by \sa set_tx() and \sa set_rx()
+    //! will be no longer used after this call.
+    //!
+    void reset_buffers();
+
+    //!
+    //! \brief Resets previously set handler.
+    //!
+    void reset_handler();
+
+    //!
+    //! \brief Executes xfer, using buffers previously set.
+    //! When it will be done, handler will be invoked. TC events are reported
+    //! for each requested direction, then for meta channel. If the slave
+    //! doesn't acknowledge a byte or the bus fails, err event is reported for
+    //! the direction being transferred, with amount of bytes moved so far.
+    //! DMA streams are leased for the duration of the xfer.
+    //! \retval err::busy DMA stream is leased by someone else.
+    //! \return Status of operation.
+    //!
+    ecl::err do_xfer();
+
+    //!
+    //! \brief Selects a slave for following xfers.
+    //! generic_bus passes the same size for TX and RX buffers. For combined
+    //! transaction, write phase can be shortened by given length, so only
+    //! first bytes of the TX buffer are sent before repeated start.
+    //! \pre No xfer is in progress.
+    //! \param[in] address      7-bit slave address, not shifted.
+    //! \param[in] write_len    Length of write phase of combined transaction.
+    //!                         Zero means whole TX buffer.
+    //!
+    void set_address(uint8_t address, size_t write_len = 0);
+
+    //!
+    //! \brief Sets bus clock.
+    //! \pre No xfer is in progress.
+    //! \param[in] clk Desired clock, in Hz.
+    //! \retval err::ok     Clock is set.
+    //! \retval err::inval  Clock is zero or greater than 400 kHz.
+    //! \retval err::perm   Bus is not initialized.
+    //!
+    ecl::err set_clock(uint32_t clk);
+
+    //!
+    //! \brief Sets clock polarity and phase.
+    //! Not applicable to I2C, present for compatibility with generic_bus.
+    //! \return err::ok always.
+    //!
+    ecl::err set_mode(uint16_t cpol, uint16_t cpha);
+
+    // Streaming is not applicable to I2C transactions
+    void set_double_buffers(const uint8_t *, const uint8_t *, uint8_t *, uint8_t *, size_t) { }
+    ecl::err do_stream() { return ecl::err::notsup; }
+    ecl::err stop_stream() { return ecl::err::perm; }
+
+private:
+    //! Converts to proper I2C type.
+    static constexpr auto pick_i2c();
+    //! Picks proper RCC at compile time. All I2C devices are on APB1.
+    static constexpr auto pick_rcc();
+    //! Picks event IRQ number at compile time.
+    static constexpr auto pick_ev_irqn();
+    //! Picks error IRQ number at compile time.
+    static constexpr auto pick_er_irqn();
+
+    //! Configures the peripheral.
+    void configure(uint32_t clk);
+
+    //! Takes leases of DMA streams used by the bus.
+    ecl::err lease_dma();
+
+    //! Returns leases of DMA streams.
+    void release_dma();
+
+    //! Prepares and starts DMA stream for the current phase.
+    template< std::uintptr_t dma_stream >
+    void start_dma(uint32_t dma_channel, uint32_t dir, uint8_t *buf, size_t size, bool inc);
+
+    //! Handles I2C events.
+    void ev_irq_handler();
+
+    //! Handles I2C errors.
+    void er_irq_handler();
+
+    //! Handles DMA IRQ events.
+    void dma_irq_handler();
+
+    //! Event IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void ev_irq_entry();
+
+    //! Error IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void er_irq_entry();
+
+    //! DMA IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void dma_irq_entry();
+
+    //! Handles start condition: sends address and prepares the phase.
+    void on_start();
+
+    //! Handles address acknowledge: starts data transfer of the phase.
+    void on_addr();
+
+    //! Handles end of write phase.
+    void on_write_done();
+
+    //! Stops xfer and notifies user.
+    void finish(bool error);
+
+    //! Bus is inited if this flag is set.
+    static constexpr uint8_t inited         = 0x1;
+    //! Bus is in fill mode if this flag is set.
+    static constexpr uint8_t mode_fill      = 0x2;
+    //! Read phase is in progress if this flag is set.
+    static constexpr uint8_t phase_rx       = 0x4;
+    //! Write phase is finished if this flag is set.
+    static constexpr uint8_t tx_complete    = 0x8;
+    //! Xfer is in progress if this flag is set.
+    static constexpr uint8_t xfer_on        = 0x10;
+    //! TX DMA stream is started if this flag is set.
+    static constexpr uint8_t tx_started     = 0x20;
+
+    handler_fn      m_event_handler; //! Handler passed via set_handler().
+    const uint8_t   *m_tx;           //! Transmit buffer.
+    size_t          m_tx_size;       //! TX buffer size.
+    uint8_t         *m_rx;           //! Recieve buffer.
+    size_t          m_rx_size;       //! RX buffer size.
+    size_t          m_write_len;     //! Length of write phase of combined xfer.
+    size_t          m_tx_len;        //! Length of write phase of current xfer.
+    uint8_t         m_fill;          //! Byte to transmit in fill mode.
+    uint8_t         m_address;       //! Slave address, shifted.
+    uint8_t         m_status;        //! Represents bus status.
+
+    //! Bus object, served by IRQ entries. Only one object of a given bus can exist.
+    static i2c_bus  *m_instance;
+};
+
+template< class i2c_config >
+i2c_bus< i2c_config > *i2c_bus< i2c_config >::m_instance{nullptr};
+
+template< class i2c_config >
+i2c_bus< i2c_config >::i2c_bus()
+    :m_event_handler{}
+    ,m_tx{nullptr}
+    ,m_tx_size{0}
+    ,m_rx{nullptr}
+    ,m_rx_size{0}
+    ,m_write_len{0}
+    ,m_tx_len{0}
+    ,m_fill{0xff}
+    ,m_address{0}
+    ,m_status{0}
+{
+
+}
+
+template< class i2c_config >
+i2c_bus< i2c_config >::~i2c_bus()
+{
+
+}
+
+template< class i2c_config >
+ecl::err i2c_bus< i2c_config >::init()
+{
+    if (m_status & inited) {
+        return ecl::err::ok;
+    }
+
+    constexpr auto rcc_periph = pick_rcc();
+    constexpr auto ev_irqn    = pick_ev_irqn();
+    constexpr auto er_irqn    = pick_er_irqn();
+
+    RCC_APB1PeriphClockCmd(rcc_periph, ENABLE);
+
+    // Bus may be left locked by the slave after MCU reset,
+    // peripheral itself is reset here.
+    RCC_APB1PeriphResetCmd(rcc_periph, ENABLE);
+    RCC_APB1PeriphResetCmd(rcc_periph, DISABLE);
+
+    configure(i2c_config::m_clk);
+
+    dma::init_rcc< i2c_config::m_dma_tx_stream >();
+    dma::init_rcc< i2c_config::m_dma_rx_stream >();
+
+    ecl_assert(!m_instance || m_instance == this);
+    m_instance = this;
+
+    IRQ_manager::mask(ev_irqn);
+    IRQ_manager::clear(ev_irqn);
+    IRQ_manager::subscribe(ev_irqn, ev_irq_entry);
+    IRQ_manager::unmask(ev_irqn);
+
+    IRQ_manager::mask(er_irqn);
+    IRQ_manager::clear(er_irqn);
+    IRQ_manager::subscribe(er_irqn, er_irq_entry);
+    IRQ_manager::unmask(er_irqn);
+
+    m_status |= inited;
+    return ecl::err::ok;
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::set_rx(uint8_t *rx, size_t size)
+{
+    if (!(m_status & inited)) {
+        return;
+    }
+
+    m_rx = rx;
+    m_rx_size = rx ? size : 0;
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::set_tx(size_t size, uint8_t fill_byte)
+{
+    if (!(m_status & inited)) {
+        return;
+    }
+
+    m_status |= mode_fill;
+    m_tx = nullptr;
+    m_tx_size = size;
+    m_fill = fill_byte;
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::set_tx(const uint8_t *tx, size_t size)
+{
+    if (!(m_status & inited)) {
+        return;
+    }
+
+    m_status &= ~mode_fill;
+    m_tx = tx;
+    m_tx_size = tx ? size : 0;
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::set_handler(const handler_fn &handler)
+{
+    // It is possible (and recommended) to set handler before bus init.
+    m_event_handler = handler;
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::reset_buffers()
+{
+    if (!(m_status & inited)) {
+        return;
+    }
+
+    m_status &= ~mode_fill;
+    m_tx = nullptr;
+    m_rx = nullptr;
+    m_tx_size = m_rx_size = 0;
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::reset_handler()
+{
+    m_event_handler = handler_fn{};
+}
+
+template< class i2c_config >
+ecl::err i2c_bus< i2c_config >::do_xfer()
+{
+    if (!(m_status & inited)) {
+        return ecl::err::generic;
+    }
+
+    constexpr auto i2c = pick_i2c();
+
+    auto rc = lease_dma();
+    if (is_error(rc)) {
+        return rc;
+    }
+
+    m_tx_len = m_tx_size;
+
+    if (m_rx_size && m_write_len && m_write_len < m_tx_size) {
+        m_tx_len = m_write_len;
+    }
+
+    // Having no TX and no RX means address-only write
+    if (m_tx_len || !m_rx_size) {
+            m_status &= ~(phase_rx | tx_complete | tx_started);
+    } else {
+        m_status = (m_status & ~(tx_complete | tx_started)) | phase_rx;
+    }
+
+    m_status |= xfer_on;
+
+    // Stop condition of previous xfer may still be generated
+    while (i2c->CR1 & I2C_CR1_STOP) { }
+
+    I2C_ITConfig(i2c, I2C_IT_EVT | I2C_IT_ERR, ENABLE);
+    I2C_GenerateSTART(i2c, ENABLE);
+
+    return ecl::err::ok;
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::set_address(uint8_t address, size_t write_len)
+{
+    m_address = static_cast< uint8_t >(address << 1);
+    m_write_len = write_len;
+}
+
+template< class i2c_config >
+ecl::err i2c_bus< i2c_config >::set_clock(uint32_t clk)
+{
+    if (!clk || clk > 400000) {
+        return ecl::err::inval;
+    }
+
+    if (!(m_status & inited)) {
+        return ecl::err::perm;
+    }
+
+    configure(clk);
+    return ecl::err::ok;
+}
+
+template< class i2c_config >
+ecl::err i2c_bus< i2c_config >::set_mode(uint16_t cpol, uint16_t cpha)
+{
+    (void) cpol;
+    (void) cpha;
+    return ecl::err::ok;
+}
+
+// -----------------------------------------------------------------------------
+// Private members
+
+template< class i2c_config >
+constexpr auto i2c_bus< i2c_config >::pick_i2c()
+{
+    switch (i2c_config::m_dev) {
+    case i2c_device::bus_1:
+        return I2C1;
+    case i2c_device::bus_2:
+        return I2C2;
+    case i2c_device::bus_3:
+        return I2C3;
+    default:
+        return static_cast< decltype(I2C1) >(nullptr);
+    }
+}
+
+template< class i2c_config >
+constexpr auto i2c_bus< i2c_config >::pick_rcc()
+{
+    switch (i2c_config::m_dev) {
+    case i2c_device::bus_1:
+        return RCC_APB1Periph_I2C1;
+    case i2c_device::bus_2:
+        return RCC_APB1Periph_I2C2;
+    case i2c_device::bus_3:
+        return RCC_APB1Periph_I2C3;
+    default:
+        return static_cast< decltype(RCC_APB1Periph_I2C1) >(-1);
+    }
+}
+
+template< class i2c_config >
+constexpr auto i2c_bus< i2c_config >::pick_ev_irqn()
+{
+    switch (i2c_config::m_dev) {
+    case i2c_device::bus_1:
+        return I2C1_EV_IRQn;
+    case i2c_device::bus_2:
+        return I2C2_EV_IRQn;
+    case i2c_device::bus_3:
+        return I2C3_EV_IRQn;
+    default:
+        return static_cast< IRQn_Type >(-1);
+    }
+}
+
+template< class i2c_config >
+constexpr auto i2c_bus< i2c_config >::pick_er_irqn()
+{
+    switch (i2c_config::m_dev) {
+    case i2c_device::bus_1:
+        return I2C1_ER_IRQn;
+    case i2c_device::bus_2:
+        return I2C2_ER_IRQn;
+    case i2c_device::bus_3:
+        return I2C3_ER_IRQn;
+    default:
+        return static_cast< IRQn_Type >(-1);
+    }
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::configure(uint32_t clk)
+{
+    constexpr auto i2c = pick_i2c();
+
+    I2C_InitTypeDef init_struct;
+
+    // Own address is irrelevant, since the bus is a master only
+    init_struct.I2C_ClockSpeed          = clk;
+    init_struct.I2C_Mode                = I2C_Mode_I2C;
+    init_struct.I2C_DutyCycle           = i2c_config::m_duty;
+    init_struct.I2C_OwnAddress1         = 0;
+    init_struct.I2C_Ack                 = I2C_Ack_Enable;
+    init_struct.I2C_AcknowledgedAddress = I2C_AcknowledgedAddress_7bit;
+
+    I2C_Cmd(i2c, DISABLE);
+    I2C_Init(i2c, &init_struct);
+    I2C_Cmd(i2c, ENABLE);
+}
+
+template< class i2c_config >
+ecl::err i2c_bus< i2c_config >::lease_dma()
+{
+    using tx_lease = dma::stream_lease< i2c_config::m_dma_tx_stream >;
+    using rx_lease = dma::stream_lease< i2c_config::m_dma_rx_stream >;
+
+    auto rc = tx_lease::acquire(this, dma_irq_entry);
+    if (is_error(rc)) {
+        return rc;
+    }
+
+    rc = rx_lease::acquire(this, dma_irq_entry);
+    if (is_error(rc)) {
+        tx_lease::release();
+        return rc;
+    }
+
+    return ecl::err::ok;
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::release_dma()
+{
+    dma::stream_lease< i2c_config::m_dma_tx_stream >::release();
+    dma::stream_lease< i2c_config::m_dma_rx_stream >::release();
+}
+
+template< class i2c_config >
+template< std::uintptr_t dma_stream >
+void i2c_bus< i2c_config >::start_dma(uint32_t dma_channel, uint32_t dir,
+                                      uint8_t *buf, size_t size, bool inc)
+{
+    constexpr auto i2c      = pick_i2c();
+    constexpr auto stream   = dma::get_stream< dma_stream >();
+
+    DMA_InitTypeDef dma_init;
+    DMA_StructInit(&dma_init);
+
+    dma_init.DMA_Channel             = dma_channel;
+    dma_init.DMA_DIR                 = dir;
+    dma_init.DMA_PeripheralBaseAddr  = reinterpret_cast< uint32_t >(&i2c->DR);
+    dma_init.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+    dma_init.DMA_MemoryInc           = inc ? DMA_MemoryInc_Enable : DMA_MemoryInc_Disable;
+    dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(buf);
+    dma_init.DMA_BufferSize          = size;
+
+    DMA_DeInit(stream);
+    DMA_Init(stream, &dma_init);
+    DMA_ITConfig(stream, DMA_IT_TC | DMA_IT_TE, ENABLE);
+    DMA_Cmd(stream, ENABLE);
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::ev_irq_entry()
+{
+    m_instance->ev_irq_handler();
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::er_irq_entry()
+{
+    m_instance->er_irq_handler();
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::dma_irq_entry()
+{
+    m_instance->dma_irq_handler();
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::ev_irq_handler()
+{
+    constexpr auto i2c  = pick_i2c();
+    constexpr auto irqn = pick_ev_irqn();
+
+    // Each event is cleared by its own sequence, see reference manual
+    uint16_t sr1 = i2c->SR1;
+
+    if (sr1 & I2C_SR1_SB) {
+        on_start();
+    } else if (sr1 & I2C_SR1_ADDR) {
+        on_addr();
+    } else if ((sr1 & I2C_SR1_BTF) && !(m_status & phase_rx)) {
+        on_write_done();
+    } else if ((sr1 & I2C_SR1_RXNE) && (m_status & phase_rx)) {
+        // Single byte is read without DMA
+        *m_rx = static_cast< uint8_t >(i2c->DR);
+        finish(false);
+    }
+
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::er_irq_handler()
+{
+    constexpr auto i2c  = pick_i2c();
+    constexpr auto irqn = pick_er_irqn();
+    constexpr auto errors = I2C_IT_AF | I2C_IT_BERR | I2C_IT_ARLO
+                            | I2C_IT_OVR | I2C_IT_TIMEOUT;
+
+    uint16_t sr1 = i2c->SR1;
+
+    I2C_ClearITPendingBit(i2c, errors);
+
+    if (m_status & xfer_on) {
+        // Lost arbitration releases the bus by itself
+        if (!(sr1 & I2C_SR1_ARLO)) {
+            I2C_GenerateSTOP(i2c, ENABLE);
+        }
+
+        finish(true);
+    }
+
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::dma_irq_handler()
+{
+    constexpr auto i2c          = pick_i2c();
+    constexpr auto tx_stream    = dma::get_stream< i2c_config::m_dma_tx_stream >();
+    constexpr auto rx_stream    = dma::get_stream< i2c_config::m_dma_rx_stream >();
+    constexpr auto tx_tc_if     = dma::get_tc_if< i2c_config::m_dma_tx_stream >();
+    constexpr auto rx_tc_if     = dma::get_tc_if< i2c_config::m_dma_rx_stream >();
+    constexpr auto tx_err_if    = dma::get_err_if< i2c_config::m_dma_tx_stream >();
+    constexpr auto rx_err_if    = dma::get_err_if< i2c_config::m_dma_rx_stream >();
+    constexpr auto tx_irqn      = dma::get_irqn< i2c_config::m_dma_tx_stream >();
+    constexpr auto rx_irqn      = dma::get_irqn< i2c_config::m_dma_rx_stream >();
+
+    if (DMA_GetITStatus(tx_stream, tx_err_if) || DMA_GetITStatus(rx_stream, rx_err_if)) {
+        DMA_ClearITPendingBit(tx_stream, tx_err_if);
+        DMA_ClearITPendingBit(rx_stream, rx_err_if);
+
+        I2C_GenerateSTOP(i2c, ENABLE);
+        finish(true);
+    } else if (DMA_GetITStatus(tx_stream, tx_tc_if)) {
+        DMA_ClearITPendingBit(tx_stream, tx_tc_if);
+
+        // Last byte is still being shifted out. End of write phase is
+        // signalled by BTF event.
+        DMA_Cmd(tx_stream, DISABLE);
+        I2C_DMACmd(i2c, DISABLE);
+        I2C_ITConfig(i2c, I2C_IT_EVT, ENABLE);
+    } else if (DMA_GetITStatus(rx_stream, rx_tc_if)) {
+        DMA_ClearITPendingBit(rx_stream, rx_tc_if);
+
+        // Last byte is already NACKed due to DMA last transfer mode
+        I2C_GenerateSTOP(i2c, ENABLE);
+        finish(false);
+    }
+
+    // Stream IRQ is masked by IRQ manager before calling this handler
+    IRQ_manager::clear(tx_irqn);
+    IRQ_manager::unmask(tx_irqn);
+    IRQ_manager::clear(rx_irqn);
+    IRQ_manager::unmask(rx_irqn);
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::on_start()
+{
+    constexpr auto i2c = pick_i2c();
+
+    // Reading SR1 and writing DR clears SB
+    if (m_status & phase_rx) {
+        if (m_rx_size == 1) {
+            I2C_AcknowledgeConfig(i2c, DISABLE);
+        } else {
+            // DMA request is raised for every byte after ADDR is cleared.
+            // Last byte is NACKed by hardware at the end of DMA transfer.
+            I2C_AcknowledgeConfig(i2c, ENABLE);
+            I2C_DMALastTransferCmd(i2c, ENABLE);
+
+            start_dma< i2c_config::m_dma_rx_stream >(i2c_config::m_dma_rx_channel,
+                                                     DMA_DIR_PeripheralToMemory,
+                                                     m_rx, m_rx_size, true);
+            I2C_DMACmd(i2c, ENABLE);
+        }
+
+        I2C_Send7bitAddress(i2c, m_address, I2C_Direction_Receiver);
+    } else {
+        I2C_Send7bitAddress(i2c, m_address, I2C_Direction_Transmitter);
+    }
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::on_addr()
+{
+    constexpr auto i2c = pick_i2c();
+
+    if (m_status & phase_rx) {
+        // Reading SR2 after SR1 clears ADDR
+        (void) i2c->SR2;
+
+        if (m_rx_size == 1) {
+            I2C_GenerateSTOP(i2c, ENABLE);
+            I2C_ITConfig(i2c, I2C_IT_BUF, ENABLE);
+        } else {
+            // DMA is in charge until the last byte
+            I2C_ITConfig(i2c, I2C_IT_EVT, DISABLE);
+        }
+
+        return;
+    }
+
+    if (!m_tx_len) {
+        // Address-only write
+        (void) i2c->SR2;
+        I2C_GenerateSTOP(i2c, ENABLE);
+        finish(false);
+        return;
+    }
+
+    bool fill = (m_status & mode_fill) != 0;
+    auto buf  = fill ? &m_fill : const_cast< uint8_t * >(m_tx);
+
+    start_dma< i2c_config::m_dma_tx_stream >(i2c_config::m_dma_tx_channel,
+                                             DMA_DIR_MemoryToPeripheral,
+                                             buf, m_tx_len, !fill);
+    I2C_DMACmd(i2c, ENABLE);
+    m_status |= tx_started;
+
+    // BTF is not expected until DMA is done
+    I2C_ITConfig(i2c, I2C_IT_EVT, DISABLE);
+    (void) i2c->SR2;
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::on_write_done()
+{
+    constexpr auto i2c = pick_i2c();
+
+    m_status |= tx_complete;
+
+    // Both start and stop conditions clear BTF
+    if (m_rx_size) {
+        m_status |= phase_rx;
+        I2C_GenerateSTART(i2c, ENABLE);
+    } else {
+        I2C_GenerateSTOP(i2c, ENABLE);
+        finish(false);
+    }
+}
+
+template< class i2c_config >
+void i2c_bus< i2c_config >::finish(bool error)
+{
+    constexpr auto i2c          = pick_i2c();
+    constexpr auto tx_stream    = dma::get_stream< i2c_config::m_dma_tx_stream >();
+    constexpr auto rx_stream    = dma::get_stream< i2c_config::m_dma_rx_stream >();
+
+    I2C_ITConfig(i2c, I2C_IT_EVT | I2C_IT_BUF | I2C_IT_ERR, DISABLE);
+    I2C_DMACmd(i2c, DISABLE);
+    I2C_DMALastTransferCmd(i2c, DISABLE);
+    I2C_AcknowledgeConfig(i2c, ENABLE);
+
+    // Interrupts are disabled first, since disabling unfinished stream
+    // raises TC flag.
+    DMA_ITConfig(tx_stream, DMA_IT_TC | DMA_IT_TE, DISABLE);
+    DMA_ITConfig(rx_stream, DMA_IT_TC | DMA_IT_TE, DISABLE);
+    DMA_Cmd(tx_stream, DISABLE);
+    DMA_Cmd(rx_stream, DISABLE);
+
+    bool rx = (m_status & phase_rx) != 0;
+    size_t sent = 0;
+    size_t received = 0;
+
+    // Counters are stale, unless stream is started during this xfer
+    if (m_status & tx_complete) {
+        sent = m_tx_len;
+    } else if (m_status & tx_started) {
+        sent = m_tx_len - DMA_GetCurrDataCounter(tx_stream);
+    }
+
+    if (rx && !error) {
+        received = m_rx_size;
+    } else if (rx && m_rx_size > 1) {
+        received = m_rx_size - DMA_GetCurrDataCounter(rx_stream);
+    }
+
+    m_status &= ~(xfer_on | phase_rx | tx_complete | tx_started);
+
+    // Handler may start next xfer right away
+    release_dma();
+
+    if (m_tx_len) {
+        m_event_handler(channel::tx, error && !rx ? event::err : event::tc, sent);
+    }
+
+    // Read phase is not started if write phase fails
+    if (m_rx_size && (rx || !error)) {
+        m_event_handler(channel::rx, error ? event::err : event::tc, received);
+    }
+
+    if (error && !m_tx_len && !m_rx_size) {
+        // Address-only write is not acknowledged
+        m_event_handler(channel::meta, event::err, 0);
+    }
+
+    m_event_handler(channel::meta, event::tc, 0);
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_I2C_BUS_HPP_
@@ -0,0 +1,691 @@
+//!
+//! \file
+//! \brief STM32F4xx I2S audio stream with zero-copy block exchange
+//!
+
+#ifndef PLATFORM_I2S_STREAM_HPP_
+#define PLATFORM_I2S_STREAM_HPP_
+
+#include <platform/common/bus.hpp>
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+#include <ecl/inplace_function.hpp>
+#include <ecl/lookup_table.hpp>
+
+#include <stm32f4xx_spi.h>
+#include <stm32f4xx_rcc.h>
+
+#include <platform/irq_manager.hpp>
+#include <platform/clock.hpp>
+#include <platform/dma_device.hpp>
+#include <platform/dma_manager.hpp>
+
+#include <cstdint>
+#include <cstddef>
+
+#if !defined(STM32F40_41xxx) && !defined(STM32F401xx)
+#error "PLLI2S setup is written for STM32F40x/F41x and STM32F401"
+#endif
+
+namespace ecl
+{
+
+//!
+//! \brief Configuration of I2S stream.
+//! See reference manual for DMA request mapping, all on DMA1 channel 0:
+//! SPI2 TX - stream 4, SPI2 RX - stream 3, SPI3 TX - stream 5 or 7,
+//! SPI3 RX - stream 0 or 2. Pins (CK, WS, SD and MCK) must be configured
+//! as alternate function.
+//! I2S clock comes from PLLI2S, which takes the same input and M divider
+//! as the main PLL. Streams that share PLLI2S must use same N and R.
+//! \tparam spi             Base address of SPI in I2S mode: SPI2_BASE or SPI3_BASE.
+//! \tparam mode            I2S_Mode_MasterTx for playback or
+//!                         I2S_Mode_MasterRx for recording.
+//! \tparam dma_stream      DMA stream used to move samples.
+//! \tparam dma_channel     DMA channel of the stream.
+//! \tparam standard        I2S standard, i.e. I2S_Standard_Phillips.
+//! \tparam data_format     I2S_DataFormat_16b or I2S_DataFormat_16bextended.
+//!                         Samples are 16-bit in both cases.
+//! \tparam mclk            I2S_MCLKOutput_Enable to provide 256 x Fs master
+//!                         clock to a codec, I2S_MCLKOutput_Disable otherwise.
+//! \tparam plli2s_n        PLLI2S multiplier. Defaults give 48 kHz within 0.02%,
+//!                         with 1 MHz PLL input.
+//! \tparam plli2s_r        PLLI2S divider.
+//!
+template< std::uintptr_t    spi,
+          uint16_t          mode,
+          std::uintptr_t    dma_stream,
+          uint32_t          dma_channel,
+          uint16_t          standard    = I2S_Standard_Phillips,
+          uint16_t          data_format = I2S_DataFormat_16b,
+          uint16_t          mclk        = I2S_MCLKOutput_Enable,
+          uint32_t          plli2s_n    = 258,
+          uint32_t          plli2s_r    = 3 >
+struct i2s_config
+{
+    static constexpr std::uintptr_t     m_spi           = spi;
+    static constexpr uint16_t           m_mode          = mode;
+    static constexpr std::uintptr_t     m_dma_stream    = dma_stream;
+    static constexpr uint32_t           m_dma_channel   = dma_channel;
+    static constexpr uint16_t           m_standard      = standard;
+    static constexpr uint16_t           m_data_format   = data_format;
+    static constexpr uint16_t           m_mclk          = mclk;
+    static constexpr uint32_t           m_plli2s_n      = plli2s_n;
+    static constexpr uint32_t           m_plli2s_r      = plli2s_r;
+
+    //! I2S clock, Hz.
+    static constexpr uint32_t           m_i2s_clk = RCC_PLL_IN_FREQ / RCC_PLL_M
+                                                    * plli2s_n / plli2s_r;
+
+    //! Streams claimed by the stream. \sa dma::exclusive_streams
+    using dma_streams = dma::stream_list< dma_stream >;
+
+    static_assert(mode == I2S_Mode_MasterTx || mode == I2S_Mode_MasterRx,
+                  "Only master modes are supported");
+    static_assert(data_format == I2S_DataFormat_16b
+                  || data_format == I2S_DataFormat_16bextended,
+                  "Only 16-bit samples are supported");
+    static_assert(plli2s_n >= 192 && plli2s_n <= 432, "PLLI2S N must be in 192 .. 432");
+    static_assert(plli2s_r >= 2 && plli2s_r <= 7, "PLLI2S R must be in 2 .. 7");
+    static_assert(m_i2s_clk <= 192000000, "I2S clock must not exceed 192 MHz");
+};
+
+//!
+//! \brief Continuous I2S audio stream, playback or recording.
+//! Samples are moved by DMA in double-buffer mode between the I2S and two
+//! blocks owned by the stream, so CPU is involved only once per block.
+//! Stereo samples are interleaved: left, right, left, ...
+//! Blocks are not copied. Once a block is transferred, stream passes it to
+//! the exchange function, which returns the block to transfer next, in its
+//! place. ecl::block_exchange provides such a function, which hands blocks
+//! to a thread and back:
+//! \code
+//! ecl::pool< 2048, 6 > blocks_pool;
+//! ecl::block_exchange< int16_t, 8 > xchg;
+//!
+//! i2s.set_exchange([](int16_t *done) { return xchg.exchange(done); });
+//! i2s.set_blocks(read_block(file), read_block(file), block_size);
+//! for (int i = 0; i < 4; ++i) {
+//!     xchg.give(read_block(file));
+//! }
+//!
+//! i2s.start(48000);
+//!
+//! for (;;) {
+//!     auto block = xchg.take();   // Played already
+//!     file->read(block, ...);     // File lands right into the block
+//!     xchg.give(block);
+//! }
+//! \endcode
+//! Block is transferred while the other one is exchanged, so whole block
+//! time is given to replace it. Without exchange function, or if it
+//! returns nullptr, same block is transferred again: played once more or
+//! overwritten. Such blocks are counted, see dropped().
+//! Handler follows streaming semantics of platform buses, on TX channel
+//! for playback or RX channel for recording:
+//! \li event::ht is reported when first block slot is transferred.
+//! \li event::tc is reported when second block slot is transferred.
+//! \li event::err is reported on DMA error, or on I2S overrun while
+//!     recording. Stream is stopped then.
+//! \li Meta-channel TC event is reported when stream is stopped.
+//! Total amount of samples transferred so far is reported with each event.
+//! Handler is invoked after the exchange.
+//! \tparam i2s_config Stream configuration. \sa i2s_config
+//!
+template< class i2s_config >
+class i2s_stream
+{
+public:
+    // Convinient type aliases.
+    using channel       = ecl::bus_channel;
+    using event         = ecl::bus_event;
+    using handler_fn    = ecl::bus_handler;
+    //! Gets transferred block, returns one to transfer next or nullptr
+    //! to transfer the same block again. Invoked from IRQ.
+    using exchange_fn   = ecl::inplace_function< int16_t *(int16_t *done) >;
+
+    //!
+    //! \brief Constructs a stream.
+    //!
+    i2s_stream();
+
+    //!
+    //! \brief Destructs a stream.
+    ~i2s_stream();
+
+    //!
+    //! \brief Lazy initialization.
+    //! Starts PLLI2S, unless it is already running.
+    //! \return Status of opeartion.
+    //!
+    ecl::err init();
+
+    //!
+    //! \brief Sets blocks to start the stream with.
+    //! Blocks are held by the stream until exchanged, see get_block().
+    //! \pre Stream is stopped.
+    //! \param[in]  block0  First block.
+    //! \param[in]  block1  Second block.
+    //! \param[in]  size    Size of each block, in samples. Blocks that
+    //!                     come from the exchange must be of the same size.
+    //! \retval err::ok     Blocks are set.
+    //! \retval err::inval  Block is null or size is invalid.
+    //! \retval err::busy   Stream is in progress.
+    //!
+    ecl::err set_blocks(int16_t *block0, int16_t *block1, size_t size);
+
+    //!
+    //! \brief Gets block held by the stream in given slot.
+    //! After stop(), held blocks are to be released by the caller.
+    //! \param[in] slot Slot of the block: 0 or 1.
+    //!
+    int16_t *get_block(uint8_t slot) const;
+
+    //!
+    //! \brief Sets exchange function.
+    //! \pre Stream is stopped.
+    //! \param[in] fn Exchange function.
+    //!
+    void set_exchange(const exchange_fn &fn);
+
+    //!
+    //! \brief Sets event handler.
+    //! Handler will be used by the stream, until reset_handler() will be called.
+    //! \param[in] handler Handler itself.
+    //!
+    void set_handler(const handler_fn &handler);
+
+    //!
+    //! \brief Resets previously set handler.
+    //!
+    void reset_handler();
+
+    //!
+    //! \brief Starts stream.
+    //! I2S prescaler is set to the closest achievable rate.
+    //! \param[in] rate Audio frequency, Hz.
+    //! \retval err::ok     Stream is started.
+    //! \retval err::perm   Stream is not initialized.
+    //! \retval err::nobufs Blocks are not set.
+    //! \retval err::inval  Rate is not achievable with I2S clock.
+    //! \retval err::busy   Stream is already started or DMA stream is
+    //!                     leased by someone else.
+    //!
+    ecl::err start(uint32_t rate);
+
+    //!
+    //! \brief Stops stream.
+    //! Handler will be invoked with meta-channel TC event.
+    //! \retval err::ok     Stream is stopped.
+    //! \retval err::perm   Stream is not started.
+    //!
+    ecl::err stop();
+
+    //!
+    //! \brief Gets actual audio frequency, set by the last start().
+    //!
+    uint32_t rate() const;
+
+    //!
+    //! \brief Gets amount of blocks transferred again since start(),
+    //! because exchange had no next block.
+    //!
+    size_t dropped() const;
+
+private:
+    //! SPI properties.
+    struct spi_info
+    {
+        uint32_t    rcc;        //!< Clock enable bit, on APB1.
+        IRQn_Type   irqn;       //!< SPI IRQ.
+    };
+
+    //! Picks SPI properties at compile time.
+    static constexpr spi_info pick_spi_info();
+    //! Converts to proper SPI type.
+    static constexpr auto pick_spi();
+    //! Gets channel of bus events.
+    static constexpr channel pick_channel();
+    //! Gets length of channel frame, in 16-bit packets.
+    static constexpr uint32_t pick_packet_length();
+
+    //! Computes prescaler closest to the rate, the way I2S_Init() does.
+    //! \return Prescaler, as 2 x I2SDIV + ODD, or 0 if rate is not achievable.
+    static uint32_t compute_prescaler(uint32_t rate);
+
+    //! Configures I2S for given rate.
+    void configure_i2s(uint32_t rate);
+
+    //! Prepares and starts DMA stream.
+    void start_dma();
+
+    //! Stops I2S and DMA.
+    void halt();
+
+    //! Handles DMA IRQ events.
+    void dma_irq_handler();
+
+    //! Handles SPI IRQ events.
+    void irq_handler();
+
+    //! DMA IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void dma_irq_entry();
+
+    //! SPI IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void irq_entry();
+
+    //! Stream is inited if this flag is set.
+    static constexpr uint8_t inited         = 0x1;
+    //! Stream is in progress if this flag is set.
+    static constexpr uint8_t streaming      = 0x2;
+
+    handler_fn      m_event_handler;            //! Handler passed via set_handler().
+    exchange_fn     m_exchange;                 //! Exchange passed via set_exchange().
+    int16_t         *m_blocks[2];               //! Blocks held, by slot.
+    size_t          m_size;                     //! Size of each block, in samples.
+    size_t          m_streamed;                 //! Samples transferred since start().
+    size_t          m_dropped;                  //! Blocks transferred again.
+    uint32_t        m_rate;                     //! Actual audio frequency.
+    uint8_t         m_status;                   //! Represents stream status.
+
+    //! Stream object, served by IRQ entries. Only one object per SPI can exist.
+    static i2s_stream *m_instance;
+};
+
+template< class i2s_config >
+i2s_stream< i2s_config > *i2s_stream< i2s_config >::m_instance{nullptr};
+
+template< class i2s_config >
+i2s_stream< i2s_config >::i2s_stream()
+    :m_event_handler{}
+    ,m_exchange{}
+    ,m_blocks{nullptr, nullptr}
+    ,m_size{0}
+    ,m_streamed{0}
+    ,m_dropped{0}
+    ,m_rate{0}
+    ,m_status{0}
+{
+
+}
+
+template< class i2s_config >
+i2s_stream< i2s_config >::~i2s_stream()
+{
+
+}
+
+template< class i2s_config >
+ecl::err i2s_stream< i2s_config >::init()
+{
+    if (m_status & inited) {
+        return ecl::err::ok;
+    }
+
+    constexpr auto info = pick_spi_info();
+
+    RCC_APB1PeriphClockCmd(info.rcc, ENABLE);
+
+    // PLLI2S can't be reconfigured while running, other stream may use it
+    if (!(RCC->CR & RCC_CR_PLLI2SON)) {
+        RCC_I2SCLKConfig(RCC_I2S2CLKSource_PLLI2S);
+        RCC_PLLI2SConfig(i2s_config::m_plli2s_n, i2s_config::m_plli2s_r);
+        RCC_PLLI2SCmd(ENABLE);
+
+        while (RCC_GetFlagStatus(RCC_FLAG_PLLI2SRDY) == RESET) { }
+    }
+
+    dma::init_rcc< i2s_config::m_dma_stream >();
+
+    ecl_assert(!m_instance || m_instance == this);
+    m_instance = this;
+
+    IRQ_manager::mask(info.irqn);
+    IRQ_manager::clear(info.irqn);
+    IRQ_manager::subscribe(info.irqn, irq_entry);
+    IRQ_manager::unmask(info.irqn);
+
+    m_status |= inited;
+    return ecl::err::ok;
+}
+
+template< class i2s_config >
+ecl::err i2s_stream< i2s_config >::set_blocks(int16_t *block0, int16_t *block1, size_t size)
+{
+    if (m_status & streaming) {
+        return ecl::err::busy;
+    }
+
+    // DMA counter is 16-bit wide
+    if (!block0 || !block1 || !size || size > 0xffff) {
+        return ecl::err::inval;
+    }
+
+    m_blocks[0] = block0;
+    m_blocks[1] = block1;
+    m_size = size;
+
+    return ecl::err::ok;
+}
+
+template< class i2s_config >
+int16_t *i2s_stream< i2s_config >::get_block(uint8_t slot) const
+{
+    ecl_assert(slot < 2);
+    return m_blocks[slot];
+}
+
+template< class i2s_config >
+void i2s_stream< i2s_config >::set_exchange(const exchange_fn &fn)
+{
+    ecl_assert(!(m_status & streaming));
+    m_exchange = fn;
+}
+
+template< class i2s_config >
+void i2s_stream< i2s_config >::set_handler(const handler_fn &handler)
+{
+    // It is possible (and recommended) to set handler before init.
+    m_event_handler = handler;
+}
+
+template< class i2s_config >
+void i2s_stream< i2s_config >::reset_handler()
+{
+    m_event_handler = handler_fn{};
+}
+
+template< class i2s_config >
+ecl::err i2s_stream< i2s_config >::start(uint32_t rate)
+{
+    if (!(m_status & inited)) {
+        return ecl::err::perm;
+    }
+
+    if (m_status & streaming) {
+        return ecl::err::busy;
+    }
+
+    if (!m_size) {
+        return ecl::err::nobufs;
+    }
+
+    if (!compute_prescaler(rate)) {
+        return ecl::err::inval;
+    }
+
+    auto rc = dma::stream_lease< i2s_config::m_dma_stream >::acquire(this, dma_irq_entry);
+    if (is_error(rc)) {
+        return rc;
+    }
+
+    constexpr auto spi = pick_spi();
+
+    m_streamed = 0;
+    m_dropped = 0;
+    m_status |= streaming;
+
+    configure_i2s(rate);
+    start_dma();
+
+    if (i2s_config::m_mode == I2S_Mode_MasterRx) {
+        SPI_I2S_DMACmd(spi, SPI_I2S_DMAReq_Rx, ENABLE);
+        SPI_I2S_ITConfig(spi, SPI_I2S_IT_ERR, ENABLE);
+    } else {
+        SPI_I2S_DMACmd(spi, SPI_I2S_DMAReq_Tx, ENABLE);
+    }
+
+    I2S_Cmd(spi, ENABLE);
+
+    return ecl::err::ok;
+}
+
+template< class i2s_config >
+ecl::err i2s_stream< i2s_config >::stop()
+{
+    if (!(m_status & streaming)) {
+        return ecl::err::perm;
+    }
+
+    constexpr auto irqn     = dma::get_irqn< i2s_config::m_dma_stream >();
+    constexpr auto spi_irqn = pick_spi_info().irqn;
+
+    // Prevent stream events from being delivered while stream is stopped
+    IRQ_manager::mask(irqn);
+    IRQ_manager::mask(spi_irqn);
+
+    halt();
+
+    IRQ_manager::clear(spi_irqn);
+    IRQ_manager::unmask(spi_irqn);
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+
+    m_event_handler(channel::meta, event::tc, 0);
+
+    return ecl::err::ok;
+}
+
+template< class i2s_config >
+uint32_t i2s_stream< i2s_config >::rate() const
+{
+    return m_rate;
+}
+
+template< class i2s_config >
+size_t i2s_stream< i2s_config >::dropped() const
+{
+    return m_dropped;
+}
+
+// -----------------------------------------------------------------------------
+// Private members
+
+template< class i2s_config >
+constexpr typename i2s_stream< i2s_config >::spi_info i2s_stream< i2s_config >::pick_spi_info()
+{
+    // SPI1 has no I2S mode
+    constexpr auto spis = make_lookup_table< std::uintptr_t, spi_info >({
+        { SPI2_BASE, { RCC_APB1Periph_SPI2, SPI2_IRQn } },
+        { SPI3_BASE, { RCC_APB1Periph_SPI3, SPI3_IRQn } },
+    });
+
+    static_assert(spis.contains(i2s_config::m_spi), "Only SPI2 and SPI3 support I2S");
+
+    return spis[i2s_config::m_spi];
+}
+
+template< class i2s_config >
+constexpr auto i2s_stream< i2s_config >::pick_spi()
+{
+    return reinterpret_cast< SPI_TypeDef * >(i2s_config::m_spi);
+}
+
+template< class i2s_config >
+constexpr typename i2s_stream< i2s_config >::channel i2s_stream< i2s_config >::pick_channel()
+{
+    return i2s_config::m_mode == I2S_Mode_MasterRx ? channel::rx : channel::tx;
+}
+
+template< class i2s_config >
+constexpr uint32_t i2s_stream< i2s_config >::pick_packet_length()
+{
+    // Extended format places 16-bit sample into 32-bit channel frame
+    return i2s_config::m_data_format == I2S_DataFormat_16b ? 1 : 2;
+}
+
+template< class i2s_config >
+uint32_t i2s_stream< i2s_config >::compute_prescaler(uint32_t rate)
+{
+    constexpr auto clk = i2s_config::m_i2s_clk;
+
+    // Master clock is fixed at 256 x Fs, bit clock is 32 or 64 x Fs
+    constexpr uint32_t per_sample = i2s_config::m_mclk == I2S_MCLKOutput_Enable
+            ? 256 : 32 * pick_packet_length();
+
+    if (!rate) {
+        return 0;
+    }
+
+    // Rounded to the closest, with one decimal, as in I2S_Init()
+    uint32_t presc = ((clk / per_sample) * 10 / rate + 5) / 10;
+
+    // I2SDIV must be in 2 .. 255
+    if (presc < 4 || presc > 511) {
+        return 0;
+    }
+
+    return presc;
+}
+
+template< class i2s_config >
+void i2s_stream< i2s_config >::configure_i2s(uint32_t rate)
+{
+    constexpr auto spi = pick_spi();
+    constexpr auto clk = i2s_config::m_i2s_clk;
+    constexpr uint32_t per_sample = i2s_config::m_mclk == I2S_MCLKOutput_Enable
+            ? 256 : 32 * pick_packet_length();
+
+    I2S_InitTypeDef init_struct;
+    I2S_StructInit(&init_struct);
+
+    init_struct.I2S_Mode        = i2s_config::m_mode;
+    init_struct.I2S_Standard    = i2s_config::m_standard;
+    init_struct.I2S_DataFormat  = i2s_config::m_data_format;
+    init_struct.I2S_MCLKOutput  = i2s_config::m_mclk;
+    init_struct.I2S_AudioFreq   = rate;
+    init_struct.I2S_CPOL        = I2S_CPOL_Low;
+
+    I2S_Cmd(spi, DISABLE);
+    SPI_I2S_DeInit(spi);
+    I2S_Init(spi, &init_struct);
+
+    m_rate = clk / (per_sample * compute_prescaler(rate));
+}
+
+template< class i2s_config >
+void i2s_stream< i2s_config >::start_dma()
+{
+    constexpr auto stream   = dma::get_stream< i2s_config::m_dma_stream >();
+    constexpr auto spi      = pick_spi();
+    constexpr auto dir      = i2s_config::m_mode == I2S_Mode_MasterRx
+            ? DMA_DIR_PeripheralToMemory : DMA_DIR_MemoryToPeripheral;
+
+    DMA_InitTypeDef dma_init;
+    DMA_StructInit(&dma_init);
+
+    dma_init.DMA_Channel             = i2s_config::m_dma_channel;
+    dma_init.DMA_DIR                 = dir;
+    dma_init.DMA_PeripheralBaseAddr  = reinterpret_cast< uint32_t >(&spi->DR);
+    dma_init.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+    dma_init.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+    dma_init.DMA_PeripheralDataSize  = DMA_PeripheralDataSize_HalfWord;
+    dma_init.DMA_MemoryDataSize      = DMA_MemoryDataSize_HalfWord;
+    dma_init.DMA_Mode                = DMA_Mode_Circular;
+    dma_init.DMA_Priority            = DMA_Priority_High;
+    dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(m_blocks[0]);
+    dma_init.DMA_BufferSize          = m_size;
+
+    dma::disable< i2s_config::m_dma_stream >();
+    DMA_DeInit(stream);
+    DMA_Init(stream, &dma_init);
+    dma::enable_double_buffer< i2s_config::m_dma_stream >(m_blocks[1]);
+    dma::enable_irq< i2s_config::m_dma_stream, DMA_IT_TC | DMA_IT_TE >();
+    dma::enable< i2s_config::m_dma_stream >();
+}
+
+template< class i2s_config >
+void i2s_stream< i2s_config >::halt()
+{
+    constexpr auto spi      = pick_spi();
+    constexpr auto stream   = dma::get_stream< i2s_config::m_dma_stream >();
+
+    SPI_I2S_ITConfig(spi, SPI_I2S_IT_ERR, DISABLE);
+    SPI_I2S_DMACmd(spi, SPI_I2S_DMAReq_Tx | SPI_I2S_DMAReq_Rx, DISABLE);
+    I2S_Cmd(spi, DISABLE);
+
+    dma::disable< i2s_config::m_dma_stream >();
+    DMA_DeInit(stream);
+
+    dma::stream_lease< i2s_config::m_dma_stream >::release();
+
+    m_status &= ~(streaming);
+}
+
+template< class i2s_config >
+void i2s_stream< i2s_config >::dma_irq_entry()
+{
+    m_instance->dma_irq_handler();
+}
+
+template< class i2s_config >
+void i2s_stream< i2s_config >::irq_entry()
+{
+    m_instance->irq_handler();
+}
+
+template< class i2s_config >
+void i2s_stream< i2s_config >::dma_irq_handler()
+{
+    constexpr auto stream   = i2s_config::m_dma_stream;
+    constexpr auto tc_if    = dma::get_tc_if< stream >();
+    constexpr auto err_if   = dma::get_err_if< stream >();
+    constexpr auto irqn     = dma::get_irqn< stream >();
+    constexpr auto ch       = pick_channel();
+
+    if (dma::get_it_status< stream, err_if >()) {
+        dma::clear_flags< stream, err_if >();
+
+        halt();
+        m_event_handler(ch, event::err, m_streamed);
+        m_event_handler(channel::meta, event::tc, 0);
+    } else if (dma::get_it_status< stream, tc_if >()) {
+        dma::clear_flags< stream, tc_if >();
+
+        // At this point DMA already switched to the other memory target,
+        // thus transferred block is the one that is not used now. It can
+        // be replaced until the current one is transferred.
+        uint8_t slot = dma::get_memory_target< stream >() ^ 1;
+        int16_t *next = m_exchange ? m_exchange(m_blocks[slot]) : nullptr;
+
+        if (next && next != m_blocks[slot]) {
+            dma::set_memory_target< stream >(next, slot);
+            m_blocks[slot] = next;
+        } else {
+            m_dropped++;
+        }
+
+        m_streamed += m_size;
+        m_event_handler(ch, slot ? event::tc : event::ht, m_streamed);
+    }
+
+    // Stream is left running, so IRQ must be enabled back
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+}
+
+template< class i2s_config >
+void i2s_stream< i2s_config >::irq_handler()
+{
+    constexpr auto spi      = pick_spi();
+    constexpr auto irqn     = pick_spi_info().irqn;
+
+    if (SPI_I2S_GetITStatus(spi, SPI_I2S_IT_OVR) == SET) {
+        // Overrun is cleared by reading data, then status
+        (void)spi->DR;
+        (void)spi->SR;
+
+        if (m_status & streaming) {
+            halt();
+            m_event_handler(channel::rx, event::err, m_streamed);
+            m_event_handler(channel::meta, event::tc, 0);
+        }
+    }
+
+    IRQ_manager::clear(irqn);
+    IRQ_manager::unmask(irqn);
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_I2S_STREAM_HPP_
@@ -4,10 +4,32 @@
 #include <stm32f4xx.h>
 #include <core_cm4.h>
 
-#include <functional>
+#include <ecl/inplace_function.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
 
 using IRQn_t = IRQn_Type;
 
+// Static dispatch mode. Enabled by CONFIG_IRQ_STATIC_DISPATCH.
+// Vector table is relocated to RAM and handlers are placed directly
+// into it, so there is no dispatch code executed between exception entry
+// and a handler. Handlers are plain functions, thus
+// no subscription with bound state is possible in this mode.
+// Dynamic mode (default) allows any callable to be subscribed,
+// at a cost of a common ISR that looks up and invokes a handler.
+// Handlers are stored in place, see ecl::inplace_function, so subscription
+// never allocates and is safe to do from ISR.
+//
+// IRQ statistics. Enabled by CONFIG_IRQ_STATS, dynamic mode only.
+// Common ISR counts IRQs and measures handler execution time in
+// CPU cycles, using DWT cycle counter.
+
+#if defined(CONFIG_IRQ_STATS) && defined(CONFIG_IRQ_STATIC_DISPATCH)
+#error "IRQ statistics are collected by common ISR, not used in static dispatch mode"
+#endif
+
 // Manages irqs
 // TODO: singleton obviously
 class IRQ_manager
@@ -17,27 +39,112 @@ public:
     IRQ_manager() = delete;
     ~IRQ_manager() = delete;
 
+#ifdef CONFIG_IRQ_STATIC_DISPATCH
+    using handler_type = void (*)();
+#else
+    using handler_type = ecl::inplace_function< void() >;
+#endif
+
+#ifdef CONFIG_IRQ_STATS
+    // Statistics of a single IRQ
+    struct stats
+    {
+        uint32_t    count;      // Amount of handled IRQs
+        uint64_t    cycles;     // Total cycles spent in a handler
+        uint32_t    max_cycles; // Worst-case handler execution time
+    };
+#endif
+
     static void init()
     {
+#ifdef CONFIG_IRQ_STATIC_DISPATCH
+        // Core exceptions are preserved as is, including RTOS handlers
+        auto flash = reinterpret_cast< const uint32_t * >(SCB->VTOR);
+        for (size_t i = 0; i < core_vectors; ++i) {
+            m_vectors[i] = flash[i];
+        }
+
+        for (size_t i = core_vectors; i < vectors_count; ++i) {
+            m_vectors[i] = reinterpret_cast< uint32_t >(default_handler);
+        }
+
+        SCB->VTOR = reinterpret_cast< uint32_t >(m_vectors);
+        __DSB();
+#else
         for (auto &h : m_handlers) {
             h = default_handler;
         }
+#endif
+
+        for (auto &p : m_priorities) {
+            p = max_priority;
+        }
+
+#ifdef CONFIG_IRQ_STATS
+        // Cycle counter is a part of debug unit, which must be enabled first.
+        // Counter is not reset: it may be already in use by boot profile,
+        // see sys/init.hpp, and only differences are used here.
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
 
         __enable_irq();
     }
 
-    static int subscribe(IRQn_t IRQn, const std::function< void() > &handler)
+    // Subscribes to IRQ with priority, previously set by set_priority().
+    // If priority was never set, IRQ gets lowest allowed priority,
+    // i.e. CONFIG_MAX_ISR_PRIORITY.
+    static int subscribe(IRQn_t IRQn, const handler_type &handler)
     {
         // TODO: error check
 
         __disable_irq();
+        NVIC_SetPriority(IRQn, m_priorities[IRQn]);
+        set_handler(IRQn, handler);
+        __enable_irq();
+        return 0;
+    }
+
+    // Subscribes to IRQ with given preemption priority and sub-priority.
+    // Returns -1 if priority is invalid, see set_priority().
+    static int subscribe(IRQn_t IRQn, const handler_type &handler,
+                         uint8_t preempt, uint8_t sub = 0)
+    {
+        if (set_priority(IRQn, preempt, sub) < 0) {
+            return -1;
+        }
+
+        return subscribe(IRQn, handler);
+    }
+
+    // Sets preemption priority and sub-priority of IRQ. Lower values are
+    // more urgent. Priority is preserved across re-subscriptions, so it can
+    // be assigned by board code to IRQs that are subscribed by drivers lazily.
+    // Returns -1 if priority doesn't fit into current priority grouping or
+    // exceeds CONFIG_MAX_ISR_PRIORITY.
+    static int set_priority(IRQn_t IRQn, uint8_t preempt, uint8_t sub = 0)
+    {
+        auto group      = NVIC_GetPriorityGrouping();
+        auto pre_bits   = std::min(7 - group, static_cast< uint32_t >(__NVIC_PRIO_BITS));
+        auto sub_bits   = __NVIC_PRIO_BITS - pre_bits;
+
+        if (preempt >= (1u << pre_bits) || sub >= (1u << sub_bits)) {
+            return -1;
+        }
+
+        auto prio = NVIC_EncodePriority(group, preempt, sub);
 
         // Magic here.
         // Logical priority of *any* user interrupt that use
         // FreeRTOS API must not be greather than
         // configMAX_SYSCALL_INTERRUPT_PRIORITY
-        NVIC_SetPriority(IRQn, CONFIG_MAX_ISR_PRIORITY);
-        m_handlers[IRQn] = handler;
+        if (prio < max_priority) {
+            return -1;
+        }
+
+        __disable_irq();
+        m_priorities[IRQn] = prio;
+        NVIC_SetPriority(IRQn, prio);
         __enable_irq();
         return 0;
     }
@@ -45,7 +152,7 @@ public:
     static int unsubscribe(IRQn_t IRQn)
     {
         __disable_irq();
-        m_handlers[IRQn] = default_handler;
+        set_handler(IRQn, default_handler);
         __enable_irq();
         return 0;
     }
@@ -71,10 +178,48 @@ public:
         return 0;
     }
 
+#ifdef CONFIG_IRQ_STATS
+    // Returns consistent snapshot of IRQ statistics.
+    // Cycles include handler dispatching overhead.
+    static stats get_stats(IRQn_t IRQn)
+    {
+        __disable_irq();
+        auto s = m_stats[IRQn];
+        __enable_irq();
+        return s;
+    }
+
+    // Resets statistics of all IRQs
+    static void reset_stats()
+    {
+        __disable_irq();
+        for (auto &s : m_stats) {
+            s = stats{};
+        }
+        __enable_irq();
+    }
+#endif
+
 private:
+    static void set_handler(IRQn_t IRQn, const handler_type &handler)
+    {
+#ifdef CONFIG_IRQ_STATIC_DISPATCH
+        m_vectors[core_vectors + IRQn] = reinterpret_cast< uint32_t >(handler);
+        // Make sure that new vector is visible before IRQ is unmasked
+        __DSB();
+#else
+        m_handlers[IRQn] = handler;
+#endif
+    }
+
     // Prevent optimizing out an ISR routine
+    // In static mode it is referenced only by the flash vector table, which is
+    // not used after init()
     __attribute__ ((used)) static void ISR()
     {
+#ifdef CONFIG_IRQ_STATIC_DISPATCH
+        default_handler();
+#else
         volatile int IRQn;
 
         asm volatile (
@@ -89,7 +234,23 @@ private:
 
         // TODO: Is it needed?
         mask(static_cast< IRQn_t >(IRQn));
+
+#ifdef CONFIG_IRQ_STATS
+        uint32_t start = DWT->CYCCNT;
         m_handlers[IRQn]();
+        // Unsigned arithmetic handles counter wrap
+        uint32_t spent = DWT->CYCCNT - start;
+
+        auto &s = m_stats[IRQn];
+        s.count++;
+        s.cycles += spent;
+        if (spent > s.max_cycles) {
+            s.max_cycles = spent;
+        }
+#else
+        m_handlers[IRQn]();
+#endif
+#endif
     }
 
     static void default_handler()
@@ -98,11 +259,57 @@ private:
         for(;;);
     }
 
-    // Registered IRQ handlers
     // TODO: magic numbers
-    static std::function< void() > m_handlers[82];
+    static constexpr size_t irq_count       = 82;
+
+    // Highest allowed priority, in NVIC priority format
+    static constexpr uint8_t max_priority   =
+            CONFIG_MAX_ISR_PRIORITY & ((1 << __NVIC_PRIO_BITS) - 1);
+
+    // Priorities assigned to IRQs
+    static uint8_t m_priorities[irq_count];
+
+#ifdef CONFIG_IRQ_STATS
+    // Collected statistics
+    static stats m_stats[irq_count];
+#endif
+
+#ifdef CONFIG_IRQ_STATIC_DISPATCH
+    // Amount of core exceptions, including stack pointer entry
+    static constexpr size_t core_vectors    = 16;
+    static constexpr size_t vectors_count   = core_vectors + irq_count;
+
+    // Vector table in RAM. VTOR requires table to be aligned on
+    // power of two, greater than table size.
+    alignas(512) static uint32_t m_vectors[vectors_count];
+#else
+    // Registered IRQ handlers
+    static handler_type m_handlers[irq_count];
+#endif
 };
 
+// Critical section, that masks all configurable IRQs.
+// Fits as a lock policy for ecl::pool and alike, when pool is used from ISR.
+// Sections of different locks can be nested, since previous IRQ state
+// is restored on unlock. Same lock must not be taken recursively.
+class IRQ_lock
+{
+public:
+    void lock()
+    {
+        auto primask = __get_PRIMASK();
+        __disable_irq();
+        m_primask = primask;
+    }
 
+    void unlock()
+    {
+        __set_PRIMASK(m_primask);
+    }
+
+private:
+    // IRQ state before the section is entered
+    uint32_t m_primask = 0;
+};
 
 #endif
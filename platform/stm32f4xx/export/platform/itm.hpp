@@ -0,0 +1,256 @@
+#ifndef PLATFORM_ITM_HPP
+#define PLATFORM_ITM_HPP
+
+//!
+//! \file
+//! \brief ITM/SWO trace output and DWT profiling helpers.
+//! Data is written to ITM stimulus ports and leaves the chip through
+//! single SWO pin (PB3), clocked much faster than usual USART console.
+//! Writing a word to the port takes few cycles, unless ITM FIFO is full.
+//!
+
+#include <stm32f4xx.h>
+#include <core_cm4.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sys/types.h>
+
+#ifndef CONFIG_ITM_SWO_BAUD
+//! Default SWO baud rate. Zero leaves TPIU setup to the debugger.
+#define CONFIG_ITM_SWO_BAUD 2000000
+#endif
+
+namespace ecl
+{
+
+//!
+//! \brief ITM stimulus port console driver.
+//! Can be used as console_driver, i.e. for cerr or for telemetry output.
+//! Output only: read() always fails.
+//! If debugger is not attached or port is not enabled, output is discarded,
+//! so driver never blocks in production builds.
+//! \tparam port     Stimulus port, 0 to 31.
+//! \tparam swo_baud SWO baud rate. Zero means TPIU is configured by the
+//!                  debugger, i.e. by OpenOCD "tpiu config" command.
+//!
+template< uint8_t port = 0, uint32_t swo_baud = CONFIG_ITM_SWO_BAUD >
+class itm_console
+{
+    static_assert(port < 32, "ITM has 32 stimulus ports");
+
+public:
+    //!
+    //! \brief Configures SWO and enables the stimulus port.
+    //! \return Zero, as other console drivers do.
+    //!
+    int init();
+
+    int open()  { return 0; }
+    int close() { return 0; }
+
+    //!
+    //! \brief Writes data to the stimulus port.
+    //! Data is written in 32-bit words, remainder is written by bytes.
+    //! Writes from different contexts can interleave by words.
+    //! \return Amount of bytes written (or discarded).
+    //!
+    ssize_t write(const uint8_t *data, size_t count);
+
+    //!
+    //! \brief Does nothing, since ITM is output only.
+    //! \return Always -1.
+    //!
+    ssize_t read(uint8_t *data, size_t count)
+    { (void) data; (void) count; return -1; }
+
+    //!
+    //! \brief Checks if someone listens to the port.
+    //! \retval true  ITM and the port are enabled, output is transmitted.
+    //! \retval false Output is discarded.
+    //!
+    static bool enabled();
+
+private:
+    //! Waits for a room in ITM FIFO.
+    static void wait_ready();
+};
+
+//!
+//! \brief DWT-based profiling, emitted over SWO as hardware packets.
+//! Decoded by host tools, such as orbuculum or OpenOCD.
+//! \pre ITM is configured, i.e. by itm_console::init().
+//!
+class dwt_trace
+{
+public:
+    //! Event counters, see enable_counters().
+    enum counter : uint32_t
+    {
+        cpi     = DWT_CTRL_CPIEVTENA_Msk,   //!< Extra cycles of multi-cycle instructions.
+        exc     = DWT_CTRL_EXCEVTENA_Msk,   //!< Cycles spent in exception overhead.
+        sleep   = DWT_CTRL_SLEEPEVTENA_Msk, //!< Cycles spent in sleep.
+        lsu     = DWT_CTRL_LSUEVTENA_Msk,   //!< Extra cycles of load/store.
+        fold    = DWT_CTRL_FOLDEVTENA_Msk,  //!< Folded instructions.
+    };
+
+    //! Snapshot of 8-bit event counters.
+    struct counters
+    {
+        uint8_t cpi;
+        uint8_t exc;
+        uint8_t sleep;
+        uint8_t lsu;
+        uint8_t fold;
+    };
+
+    //!
+    //! \brief Enables periodic PC sampling.
+    //! \param[in] period Sampling period in CPU cycles. Rounded down to
+    //!                   supported value: multiple of 64 up to 1024, or
+    //!                   multiple of 1024 up to 16384.
+    //!
+    static void enable_pc_sampling(uint32_t period)
+    {
+        enable_dwt();
+
+        uint32_t tap = period > 16 * 64 ? 1024 : 64;
+        uint32_t reload = period / tap;
+
+        reload = reload ? (reload > 16 ? 16 : reload) : 1;
+
+        uint32_t ctrl = DWT->CTRL;
+        ctrl &= ~(DWT_CTRL_CYCTAP_Msk | DWT_CTRL_POSTPRESET_Msk);
+        ctrl |= (tap == 1024 ? DWT_CTRL_CYCTAP_Msk : 0)
+                | ((reload - 1) << DWT_CTRL_POSTPRESET_Pos)
+                | DWT_CTRL_PCSAMPLENA_Msk
+                | DWT_CTRL_CYCCNTENA_Msk;
+        DWT->CTRL = ctrl;
+    }
+
+    //!
+    //! \brief Disables PC sampling.
+    //!
+    static void disable_pc_sampling()
+    {
+        DWT->CTRL &= ~DWT_CTRL_PCSAMPLENA_Msk;
+    }
+
+    //!
+    //! \brief Enables event counters. Overflow of each counter
+    //! is also reported over SWO.
+    //! \param[in] mask Set of counters, combined from counter values.
+    //!
+    static void enable_counters(uint32_t mask)
+    {
+        enable_dwt();
+        DWT->CTRL |= mask;
+    }
+
+    //!
+    //! \brief Disables event counters.
+    //! \param[in] mask Set of counters, combined from counter values.
+    //!
+    static void disable_counters(uint32_t mask)
+    {
+        DWT->CTRL &= ~mask;
+    }
+
+    //!
+    //! \brief Gets event counters.
+    //! Counters are 8-bit and wrap, so take differences between snapshots.
+    //!
+    static counters read_counters()
+    {
+        return counters{
+            static_cast< uint8_t >(DWT->CPICNT),
+            static_cast< uint8_t >(DWT->EXCCNT),
+            static_cast< uint8_t >(DWT->SLEEPCNT),
+            static_cast< uint8_t >(DWT->LSUCNT),
+            static_cast< uint8_t >(DWT->FOLDCNT),
+        };
+    }
+
+private:
+    //! Lets DWT packets to be forwarded by ITM.
+    static void enable_dwt()
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        ITM->TCR |= ITM_TCR_DWTENA_Msk;
+    }
+};
+
+//------------------------------------------------------------------------------
+
+template< uint8_t port, uint32_t swo_baud >
+int itm_console< port, swo_baud >::init()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+    // TRACESWO pin is routed to PB3 in its reset state
+    DBGMCU->CR |= DBGMCU_CR_TRACE_IOEN;
+
+    if (swo_baud) {
+        // Asynchronous NRZ mode, formatter is bypassed
+        TPI->SPPR = 2;
+        TPI->ACPR = SystemCoreClock / swo_baud - 1;
+        TPI->FFCR &= ~TPI_FFCR_EnFCont_Msk;
+    }
+
+    // Unlock ITM registers
+    ITM->LAR = 0xC5ACCE55;
+
+    ITM->TCR |= ITM_TCR_ITMENA_Msk | ITM_TCR_SYNCENA_Msk | ITM_TCR_SWOENA_Msk
+                | (1UL << ITM_TCR_TraceBusID_Pos);
+
+    // Port is accessible from unprivileged code as well
+    ITM->TPR = 0;
+    ITM->TER |= 1UL << port;
+
+    return 0;
+}
+
+template< uint8_t port, uint32_t swo_baud >
+ssize_t itm_console< port, swo_baud >::write(const uint8_t *data, size_t count)
+{
+    if (!enabled()) {
+        return count;
+    }
+
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        uint32_t word;
+        memcpy(&word, data + i, sizeof(word));
+
+        wait_ready();
+        ITM->PORT[port].u32 = word;
+    }
+
+    for (; i < count; ++i) {
+        wait_ready();
+        ITM->PORT[port].u8 = data[i];
+    }
+
+    return count;
+}
+
+template< uint8_t port, uint32_t swo_baud >
+bool itm_console< port, swo_baud >::enabled()
+{
+    return (CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk)
+            && (ITM->TCR & ITM_TCR_ITMENA_Msk)
+            && (ITM->TER & (1UL << port));
+}
+
+template< uint8_t port, uint32_t swo_baud >
+void itm_console< port, swo_baud >::wait_ready()
+{
+    // Reading the port returns FIFO ready flag
+    while (!ITM->PORT[port].u32) { }
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_ITM_HPP
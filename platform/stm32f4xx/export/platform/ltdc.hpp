@@ -0,0 +1,541 @@
+//!
+//! \file
+//! \brief STM32F4xx LTDC display controller with two double-buffered layers
+//!
+
+#ifndef PLATFORM_LTDC_HPP_
+#define PLATFORM_LTDC_HPP_
+
+#if !defined(STM32F429_439xx)
+#error "LTDC is present on STM32F429/439 only"
+#endif
+
+#include <ecl/err.hpp>
+#include <ecl/assert.h>
+#include <ecl/inplace_function.hpp>
+#include <ecl/pixel_engine.hpp>
+#include <ecl/thread/completion.hpp>
+
+#include <stm32f4xx_ltdc.h>
+#include <stm32f4xx_rcc.h>
+
+#include <platform/clock.hpp>
+#include <platform/irq_manager.hpp>
+#include <platform/memory.hpp>
+#include <platform/power.hpp>
+#include <platform/utils.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace ecl
+{
+
+//!
+//! \brief Configuration of LTDC and panel timings.
+//! Timings are from the datasheet of the panel: horizontal ones are in
+//! pixel clocks, vertical ones are in lines. Pixel clock is produced by
+//! PLLSAI, from the same input as the main PLL. Pins (HSYNC, VSYNC, DE,
+//! CLK and color lines) must be configured as alternate function.
+//! Defaults suit 240x320 panel of STM32F429I-DISCO, with ILI9341 in RGB mode.
+//! \tparam width           Active width, pixels.
+//! \tparam height          Active height, lines.
+//! \tparam hsync           Horizontal sync width.
+//! \tparam hbp             Horizontal back porch.
+//! \tparam hfp             Horizontal front porch.
+//! \tparam vsync           Vertical sync height.
+//! \tparam vbp             Vertical back porch.
+//! \tparam vfp             Vertical front porch.
+//! \tparam pllsai_n        PLLSAI multiplier, 192 .. 432.
+//! \tparam pllsai_r        PLLSAI LCD output divider, 2 .. 7.
+//! \tparam pllsai_div      Further divider of LCD clock: 2, 4, 8 or 16.
+//! \tparam hs_polarity     LTDC_HSPolarity_AL or LTDC_HSPolarity_AH.
+//! \tparam vs_polarity     LTDC_VSPolarity_AL or LTDC_VSPolarity_AH.
+//! \tparam de_polarity     LTDC_DEPolarity_AL or LTDC_DEPolarity_AH.
+//! \tparam pc_polarity     LTDC_PCPolarity_IPC or LTDC_PCPolarity_IIPC.
+//!
+template< uint16_t  width       = 240,
+          uint16_t  height      = 320,
+          uint16_t  hsync       = 10,
+          uint16_t  hbp         = 20,
+          uint16_t  hfp         = 10,
+          uint16_t  vsync       = 2,
+          uint16_t  vbp         = 2,
+          uint16_t  vfp         = 4,
+          uint32_t  pllsai_n    = 192,
+          uint32_t  pllsai_r    = 4,
+          uint32_t  pllsai_div  = 8,
+          uint32_t  hs_polarity = LTDC_HSPolarity_AL,
+          uint32_t  vs_polarity = LTDC_VSPolarity_AL,
+          uint32_t  de_polarity = LTDC_DEPolarity_AL,
+          uint32_t  pc_polarity = LTDC_PCPolarity_IPC >
+struct ltdc_config
+{
+    static constexpr uint16_t   m_width         = width;
+    static constexpr uint16_t   m_height        = height;
+    static constexpr uint32_t   m_pllsai_n      = pllsai_n;
+    static constexpr uint32_t   m_pllsai_r      = pllsai_r;
+    static constexpr uint32_t   m_hs_polarity   = hs_polarity;
+    static constexpr uint32_t   m_vs_polarity   = vs_polarity;
+    static constexpr uint32_t   m_de_polarity   = de_polarity;
+    static constexpr uint32_t   m_pc_polarity   = pc_polarity;
+
+    //! Timings, accumulated as LTDC expects them: less one clock or line.
+    static constexpr uint16_t   m_hsync         = hsync - 1;
+    static constexpr uint16_t   m_vsync         = vsync - 1;
+    static constexpr uint16_t   m_hbp           = hsync + hbp - 1;
+    static constexpr uint16_t   m_vbp           = vsync + vbp - 1;
+    static constexpr uint16_t   m_active_w      = hsync + hbp + width - 1;
+    static constexpr uint16_t   m_active_h      = vsync + vbp + height - 1;
+    static constexpr uint16_t   m_total_w       = hsync + hbp + width + hfp - 1;
+    static constexpr uint16_t   m_total_h       = vsync + vbp + height + vfp - 1;
+
+    //! Divider of LCD clock, as RCC_LTDCCLKDivConfig() takes it.
+    static constexpr uint32_t   m_pllsai_div    = pllsai_div == 2 ? RCC_PLLSAIDivR_Div2
+                                                : pllsai_div == 4 ? RCC_PLLSAIDivR_Div4
+                                                : pllsai_div == 8 ? RCC_PLLSAIDivR_Div8
+                                                : RCC_PLLSAIDivR_Div16;
+
+    //! Pixel clock, Hz.
+    static constexpr uint32_t   m_pixel_clk     = RCC_PLL_IN_FREQ / RCC_PLL_M
+                                                  * pllsai_n / pllsai_r / pllsai_div;
+
+    //! Refresh rate, Hz.
+    static constexpr uint32_t   m_refresh       = m_pixel_clk
+                                                  / ((m_total_w + 1) * (m_total_h + 1));
+
+    static_assert(width && height && hsync && vsync && vfp, "Panel timings must not be zero");
+    static_assert(m_total_w <= 0xfff && m_total_h <= 0x7ff, "Panel timings are too long");
+    static_assert(pllsai_n >= 192 && pllsai_n <= 432, "PLLSAI N must be in 192 .. 432");
+    static_assert(pllsai_r >= 2 && pllsai_r <= 7, "PLLSAI R must be in 2 .. 7");
+    static_assert(pllsai_div == 2 || pllsai_div == 4 || pllsai_div == 8 || pllsai_div == 16,
+                  "LCD clock divider must be 2, 4, 8 or 16");
+};
+
+//!
+//! \brief LTDC display controller.
+//! Controller scans two layers out of memory and blends them on the fly,
+//! so CPU doesn't touch pixels once they are drawn. Each layer is double
+//! buffered: frame is drawn into the back buffer, i.e. by ecl::color_framebuffer
+//! with ecl::dma2d engine, then presented. Swap takes place in vertical
+//! blanking, from the line interrupt, so picture never tears:
+//! \code
+//! using lcd = ecl::ltdc< ecl::ltdc_config<> >;
+//! using fb_type = ecl::color_framebuffer< 240, 320, ecl::pixel_format::rgb565, ecl::dma2d >;
+//!
+//! // 150 KiB each, i.e. in SDRAM placed by the board linker script
+//! static fb_type frames[2];
+//!
+//! lcd::init();
+//! lcd::set_layer(0, fb_type::format, frames[0].data(), 0, 0, 240, 320);
+//! lcd::enable_layer(0, true);
+//!
+//! for (int back = 1;; back ^= 1) {
+//!     draw(frames[back]);
+//!     lcd::present(0, frames[back].data());
+//!     lcd::wait_vsync();  // Front buffer is free to draw into, from now on
+//! }
+//! \endcode
+//! Layer 0 is at the bottom. Alpha of layer 1 pixels, multiplied by its
+//! constant alpha, weights it over layer 0. Thus static background and
+//! busy foreground are redrawn independently, both layers in different
+//! formats if needed. Composition of more sprites into one layer is done
+//! by DMA2D, see ecl::color_framebuffer::blend().
+//! Frames must be word-aligned and DMA-capable. Scanning out of external
+//! RAM consumes large part of its bandwidth, see underruns().
+//! \tparam ltdc_config Display configuration. \sa ltdc_config
+//!
+template< class ltdc_config >
+class ltdc
+{
+public:
+    //! Invoked from IRQ, at the start of each vertical blanking.
+    using vsync_fn = ecl::inplace_function< void() >;
+
+    //! Amount of layers.
+    static constexpr int layers = 2;
+
+    //!
+    //! \brief Starts pixel clock and timings generator.
+    //! Screen shows background color until layers are enabled.
+    //! \param[in] background Background color, RGB888.
+    //!
+    static void init(uint32_t background = 0);
+
+    //!
+    //! \brief Stops display controller.
+    //!
+    static void deinit();
+
+    //!
+    //! \brief Sets layer window, its format and frame.
+    //! Change takes effect in next vertical blanking.
+    //! \param[in] layer    Layer index, 0 or 1.
+    //! \param[in] format   Pixel format of the frame.
+    //! \param[in] frame    Frame, of w x h pixels.
+    //! \param[in] x        Left of the window on the screen.
+    //! \param[in] y        Top of the window on the screen.
+    //! \param[in] w        Width of the window.
+    //! \param[in] h        Height of the window.
+    //! \retval err::ok     Layer is set.
+    //! \retval err::inval  Frame is misplaced or window is off the screen.
+    //!
+    static ecl::err set_layer(int layer, pixel_format format, const void *frame,
+                              int x, int y, int w, int h);
+
+    //!
+    //! \brief Sets constant alpha of the layer, 255 is opaque.
+    //! Change takes effect in next vertical blanking.
+    //!
+    static void set_alpha(int layer, uint8_t alpha);
+
+    //!
+    //! \brief Shows or hides the layer.
+    //! Change takes effect in next vertical blanking.
+    //!
+    static void enable_layer(int layer, bool enable);
+
+    //!
+    //! \brief Sets the frame, which layer shows from next vertical blanking.
+    //! Doesn't block. If previous frame isn't shown yet, it is replaced.
+    //! Frame, shown before, is scanned out until wait_vsync() returns.
+    //! \param[in] layer Layer index, 0 or 1.
+    //! \param[in] frame Frame of the same size and format as previous one.
+    //! \retval err::ok     Frame is pending.
+    //! \retval err::inval  Frame is misplaced.
+    //!
+    static ecl::err present(int layer, const void *frame);
+
+    //!
+    //! \brief Waits for next vertical blanking, after which pending frames
+    //! are shown. Cannot be called from ISR.
+    //!
+    static void wait_vsync();
+
+    //!
+    //! \brief Sets vertical blanking handler, i.e. to count frames.
+    //!
+    static void set_vsync_handler(const vsync_fn &fn);
+
+    //!
+    //! \brief Resets vertical blanking handler.
+    //!
+    static void reset_vsync_handler();
+
+    //!
+    //! \brief Gets amount of frames scanned out since init.
+    //!
+    static size_t frames();
+
+    //!
+    //! \brief Gets amount of FIFO underruns and bus errors since init.
+    //! Frame is partially lost on underrun: memory is too slow or too busy.
+    //!
+    static size_t underruns();
+
+private:
+    //! Gets layer registers.
+    static LTDC_Layer_TypeDef *regs(int layer);
+
+    //! Requests reload of shadow registers in next vertical blanking.
+    static void reload();
+
+    //! Line IRQ entry point, invoked at the end of active area.
+    static void irq_handler();
+
+    //! Error IRQ entry point.
+    static void err_irq_handler();
+
+    static std::atomic< const void * >  m_pending[layers];  //!< Frames to show.
+    static vsync_fn                     m_vsync_handler;    //!< Vertical blanking handler.
+    static ecl::completion              m_vsync;            //!< Signalled in blanking.
+    static std::atomic< size_t >        m_frames;           //!< Frames since init.
+    static std::atomic< size_t >        m_underruns;        //!< Errors since init.
+};
+
+//------------------------------------------------------------------------------
+
+template< class ltdc_config >
+std::atomic< const void * > ltdc< ltdc_config >::m_pending[layers]{};
+
+template< class ltdc_config >
+typename ltdc< ltdc_config >::vsync_fn ltdc< ltdc_config >::m_vsync_handler{};
+
+template< class ltdc_config >
+ecl::completion ltdc< ltdc_config >::m_vsync{};
+
+template< class ltdc_config >
+std::atomic< size_t > ltdc< ltdc_config >::m_frames{0};
+
+template< class ltdc_config >
+std::atomic< size_t > ltdc< ltdc_config >::m_underruns{0};
+
+template< class ltdc_config >
+void ltdc< ltdc_config >::init(uint32_t background)
+{
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_LTDC, ENABLE);
+
+    // Panel is refreshed continuously, PLLSAI is off in stop mode
+    if (!(LTDC->GCR & LTDC_GCR_LTDCEN)) {
+        power::inhibit_stop();
+    }
+
+    // PLLSAI can't be reconfigured while running, SAI may use it.
+    // SAI divider Q is kept as is.
+    if (!(RCC->CR & RCC_CR_PLLSAION)) {
+        uint32_t q = (RCC->PLLSAICFGR >> 24) & 0xf;
+
+        RCC_PLLSAIConfig(ltdc_config::m_pllsai_n, q, ltdc_config::m_pllsai_r);
+        RCC_LTDCCLKDivConfig(ltdc_config::m_pllsai_div);
+        RCC_PLLSAICmd(ENABLE);
+
+        while (RCC_GetFlagStatus(RCC_FLAG_PLLSAIRDY) == RESET) { }
+    }
+
+    LTDC_InitTypeDef init_struct;
+
+    init_struct.LTDC_HSPolarity             = ltdc_config::m_hs_polarity;
+    init_struct.LTDC_VSPolarity             = ltdc_config::m_vs_polarity;
+    init_struct.LTDC_DEPolarity             = ltdc_config::m_de_polarity;
+    init_struct.LTDC_PCPolarity             = ltdc_config::m_pc_polarity;
+    init_struct.LTDC_HorizontalSync         = ltdc_config::m_hsync;
+    init_struct.LTDC_VerticalSync           = ltdc_config::m_vsync;
+    init_struct.LTDC_AccumulatedHBP         = ltdc_config::m_hbp;
+    init_struct.LTDC_AccumulatedVBP         = ltdc_config::m_vbp;
+    init_struct.LTDC_AccumulatedActiveW     = ltdc_config::m_active_w;
+    init_struct.LTDC_AccumulatedActiveH     = ltdc_config::m_active_h;
+    init_struct.LTDC_TotalWidth             = ltdc_config::m_total_w;
+    init_struct.LTDC_TotalHeigh             = ltdc_config::m_total_h;
+    init_struct.LTDC_BackgroundRedValue     = (background >> 16) & 0xff;
+    init_struct.LTDC_BackgroundGreenValue   = (background >> 8) & 0xff;
+    init_struct.LTDC_BackgroundBlueValue    = background & 0xff;
+
+    LTDC_Init(&init_struct);
+
+    for (auto &frame : m_pending) {
+        frame = nullptr;
+    }
+
+    m_frames = 0;
+    m_underruns = 0;
+
+    IRQ_manager::mask(LTDC_IRQn);
+    IRQ_manager::clear(LTDC_IRQn);
+    IRQ_manager::subscribe(LTDC_IRQn, irq_handler);
+    IRQ_manager::unmask(LTDC_IRQn);
+
+    IRQ_manager::mask(LTDC_ER_IRQn);
+    IRQ_manager::clear(LTDC_ER_IRQn);
+    IRQ_manager::subscribe(LTDC_ER_IRQn, err_irq_handler);
+    IRQ_manager::unmask(LTDC_ER_IRQn);
+
+    // Line interrupt fires once the last active line is scanned out,
+    // front porch and sync give the rest of the blanking to swap frames
+    LTDC_LIPConfig(ltdc_config::m_active_h + 1);
+    LTDC_ClearITPendingBit(LTDC_IT_LI | LTDC_IT_FU | LTDC_IT_TERR);
+    LTDC_ITConfig(LTDC_IT_LI | LTDC_IT_FU | LTDC_IT_TERR, ENABLE);
+
+    LTDC_Cmd(ENABLE);
+}
+
+template< class ltdc_config >
+void ltdc< ltdc_config >::deinit()
+{
+    if (LTDC->GCR & LTDC_GCR_LTDCEN) {
+        power::allow_stop();
+    }
+
+    LTDC_ITConfig(LTDC_IT_LI | LTDC_IT_FU | LTDC_IT_TERR, DISABLE);
+    LTDC_Cmd(DISABLE);
+
+    IRQ_manager::mask(LTDC_IRQn);
+    IRQ_manager::unsubscribe(LTDC_IRQn);
+    IRQ_manager::mask(LTDC_ER_IRQn);
+    IRQ_manager::unsubscribe(LTDC_ER_IRQn);
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_LTDC, DISABLE);
+}
+
+template< class ltdc_config >
+ecl::err ltdc< ltdc_config >::set_layer(int layer, pixel_format format, const void *frame,
+                                        int x, int y, int w, int h)
+{
+    ecl_assert(layer >= 0 && layer < layers);
+
+    if (!frame || reinterpret_cast< std::uintptr_t >(frame) % 4 || !dma_capable(frame)) {
+        return ecl::err::inval;
+    }
+
+    if (x < 0 || y < 0 || w <= 0 || h <= 0
+            || x + w > ltdc_config::m_width || y + h > ltdc_config::m_height) {
+        return ecl::err::inval;
+    }
+
+    uint32_t line = w * pixel_size(format);
+
+    LTDC_Layer_InitTypeDef init_struct;
+
+    // Window is given in the timing coordinates, bounds are inclusive
+    init_struct.LTDC_HorizontalStart        = ltdc_config::m_hbp + x + 1;
+    init_struct.LTDC_HorizontalStop         = ltdc_config::m_hbp + x + w;
+    init_struct.LTDC_VerticalStart          = ltdc_config::m_vbp + y + 1;
+    init_struct.LTDC_VerticalStop           = ltdc_config::m_vbp + y + h;
+    init_struct.LTDC_PixelFormat            = static_cast< uint32_t >(format);
+    init_struct.LTDC_ConstantAlpha          = 255;
+    init_struct.LTDC_DefaultColorBlue       = 0;
+    init_struct.LTDC_DefaultColorGreen      = 0;
+    init_struct.LTDC_DefaultColorRed        = 0;
+    init_struct.LTDC_DefaultColorAlpha      = 0;
+    init_struct.LTDC_BlendingFactor_1       = LTDC_BlendingFactor1_PAxCA;
+    init_struct.LTDC_BlendingFactor_2       = LTDC_BlendingFactor2_PAxCA;
+    init_struct.LTDC_CFBStartAdress         = reinterpret_cast< uint32_t >(frame);
+    init_struct.LTDC_CFBLineLength          = line + 3;
+    init_struct.LTDC_CFBPitch               = line;
+    init_struct.LTDC_CFBLineNumber          = h;
+
+    // Shadow registers are written, frame isn't shown until reload
+    m_pending[layer] = nullptr;
+    LTDC_LayerInit(regs(layer), &init_struct);
+    reload();
+
+    return ecl::err::ok;
+}
+
+template< class ltdc_config >
+void ltdc< ltdc_config >::set_alpha(int layer, uint8_t alpha)
+{
+    ecl_assert(layer >= 0 && layer < layers);
+
+    LTDC_LayerAlpha(regs(layer), alpha);
+    reload();
+}
+
+template< class ltdc_config >
+void ltdc< ltdc_config >::enable_layer(int layer, bool enable)
+{
+    ecl_assert(layer >= 0 && layer < layers);
+
+    LTDC_LayerCmd(regs(layer), enable ? ENABLE : DISABLE);
+    reload();
+}
+
+template< class ltdc_config >
+ecl::err ltdc< ltdc_config >::present(int layer, const void *frame)
+{
+    ecl_assert(layer >= 0 && layer < layers);
+
+    if (!frame || reinterpret_cast< std::uintptr_t >(frame) % 4 || !dma_capable(frame)) {
+        return ecl::err::inval;
+    }
+
+    m_pending[layer] = frame;
+    return ecl::err::ok;
+}
+
+template< class ltdc_config >
+void ltdc< ltdc_config >::wait_vsync()
+{
+    ecl_assert(!in_isr());
+
+    // Event left from the blanking before is stale
+    m_vsync.try_wait();
+    m_vsync.wait();
+}
+
+template< class ltdc_config >
+void ltdc< ltdc_config >::set_vsync_handler(const vsync_fn &fn)
+{
+    IRQ_manager::mask(LTDC_IRQn);
+    m_vsync_handler = fn;
+    IRQ_manager::unmask(LTDC_IRQn);
+}
+
+template< class ltdc_config >
+void ltdc< ltdc_config >::reset_vsync_handler()
+{
+    set_vsync_handler(vsync_fn{});
+}
+
+template< class ltdc_config >
+size_t ltdc< ltdc_config >::frames()
+{
+    return m_frames;
+}
+
+template< class ltdc_config >
+size_t ltdc< ltdc_config >::underruns()
+{
+    return m_underruns;
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< class ltdc_config >
+LTDC_Layer_TypeDef *ltdc< ltdc_config >::regs(int layer)
+{
+    return layer ? LTDC_Layer2 : LTDC_Layer1;
+}
+
+template< class ltdc_config >
+void ltdc< ltdc_config >::reload()
+{
+    LTDC_ReloadConfig(LTDC_VBReload);
+}
+
+template< class ltdc_config >
+void ltdc< ltdc_config >::irq_handler()
+{
+    if (LTDC_GetITStatus(LTDC_IT_LI) == SET) {
+        LTDC_ClearITPendingBit(LTDC_IT_LI);
+
+        bool swapped = false;
+
+        for (int layer = 0; layer < layers; ++layer) {
+            auto frame = m_pending[layer].exchange(nullptr);
+
+            if (frame) {
+                LTDC_LayerAddress(regs(layer), reinterpret_cast< uint32_t >(frame));
+                swapped = true;
+            }
+        }
+
+        // Blanking has started, immediate reload doesn't tear the picture
+        if (swapped) {
+            LTDC_ReloadConfig(LTDC_IMReload);
+        }
+
+        ++m_frames;
+
+        if (m_vsync_handler) {
+            m_vsync_handler();
+        }
+
+        m_vsync.signal();
+    }
+
+    IRQ_manager::clear(LTDC_IRQn);
+    IRQ_manager::unmask(LTDC_IRQn);
+}
+
+template< class ltdc_config >
+void ltdc< ltdc_config >::err_irq_handler()
+{
+    if (LTDC_GetITStatus(LTDC_IT_FU) == SET) {
+        LTDC_ClearITPendingBit(LTDC_IT_FU);
+        ++m_underruns;
+    }
+
+    if (LTDC_GetITStatus(LTDC_IT_TERR) == SET) {
+        LTDC_ClearITPendingBit(LTDC_IT_TERR);
+        ++m_underruns;
+    }
+
+    IRQ_manager::clear(LTDC_ER_IRQn);
+    IRQ_manager::unmask(LTDC_ER_IRQn);
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_LTDC_HPP_
@@ -0,0 +1,106 @@
+#ifndef PLATFORM_MEMORY_HPP_
+#define PLATFORM_MEMORY_HPP_
+
+//!
+//! \file
+//! \brief Memory regions of STM32F4 and object placement.
+//! SRAM1/SRAM2 are reachable by both CPU and DMA. CCM RAM is 64 KiB of
+//! zero wait state memory, coupled to CPU data bus only, DMA can't
+//! access it.
+//!
+
+#include <cstdint>
+
+//!
+//! \brief Places object with static storage duration into CCM RAM.
+//! Use it for hot CPU-only data, like pools of control structures:
+//! \code
+//! PLATFORM_CCM_RAM static ecl::pool< 32, 64 > descriptors;
+//! \endcode
+//! Startup code zeroes CCM, but doesn't load it from flash. Thus constant
+//! non-zero initializers are lost, only constructors are run.
+//!
+#define PLATFORM_CCM_RAM __attribute__((section(".ccm")))
+
+//!
+//! \brief Places object with static storage duration into DMA-capable SRAM.
+//! This is where objects go by default, the attribute only documents intent
+//! and protects buffer from being moved to CCM by other means.
+//!
+#define PLATFORM_DMA_RAM __attribute__((section(".bss.dma")))
+
+//!
+//! \brief Places object with static storage duration into SRAM2.
+//! SRAM2 is accessed by the CPU and DMA in parallel with SRAM1, thus
+//! suits buffers of DMA streams running alongside CPU-intensive work in
+//! SRAM1. Memory is neither loaded nor zeroed, only constructors are run.
+//! Main stack shares SRAM2, growing down from its end.
+//!
+#define PLATFORM_SRAM2_RAM __attribute__((section(".sram2")))
+
+//!
+//! \brief Places object with static storage duration into external RAM.
+//! Suits large and cold objects, like caches, framebuffers and pools or
+//! arenas of staging buffers:
+//! \code
+//! PLATFORM_EXT_RAM static ecl::arena< 256 * 1024 > log_staging;
+//! \endcode
+//! Memory is neither loaded nor zeroed, only constructors are run. Region
+//! must be configured and FSMC set up in board_init(), see ecl::ext_ram.
+//!
+#define PLATFORM_EXT_RAM __attribute__((section(".ext_ram")))
+
+//!
+//! \brief Places initialized data into CCM RAM.
+//! Unlike PLATFORM_CCM_RAM, constant initializers are kept: startup code
+//! copies the data from flash, as for regular .data. Use it for hot
+//! lookup tables and state that is touched by ISRs and never by DMA.
+//! \code
+//! ECL_FAST_DATA static uint16_t sine[256] = { ... };
+//! \endcode
+//!
+#define ECL_FAST_DATA __attribute__((section(".ccmram")))
+
+//!
+//! \brief Places function into SRAM, copied from flash by startup code.
+//! Code in SRAM doesn't depend on flash wait states, thus suits short
+//! hot routines which are not served well by ART cache, i.e. these
+//! running while flash is being erased or written. Note that SRAM is
+//! shared with DMA, so measure before moving code there.
+//! Function is called with long call, since SRAM is out of reach of BL
+//! instruction from flash. Thus attribute must be present in
+//! the declaration, seen by callers.
+//! Clang has no long_call attribute on ARM, LLD inserts range
+//! extension thunks instead.
+//! \code
+//! ECL_FAST_CODE void spin_handler();
+//! \endcode
+//!
+#if defined(__clang__)
+#define ECL_FAST_CODE __attribute__((section(".ramfunc"), noinline))
+#else
+#define ECL_FAST_CODE __attribute__((section(".ramfunc"), long_call, noinline))
+#endif
+
+namespace ecl
+{
+
+//! Start of CCM RAM.
+constexpr std::uintptr_t ccm_ram_start  = 0x10000000;
+//! Size of CCM RAM.
+constexpr std::uintptr_t ccm_ram_size   = 0x10000;
+
+//!
+//! \brief Checks if memory at given address can be accessed by DMA.
+//! \param[in] p Any address.
+//! \return false if address lies in CCM RAM.
+//!
+inline bool dma_capable(const void *p)
+{
+    auto addr = reinterpret_cast< std::uintptr_t >(p);
+    return addr - ccm_ram_start >= ccm_ram_size;
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_MEMORY_HPP_
@@ -75,6 +75,38 @@ static constexpr GPIO_TypeDef *pick_port(pin::port port)
     }
 }
 
+// Gets base address of port registers. Unlike pick_port(), result
+// can be used in constant expressions.
+static constexpr uintptr_t pick_port_base(pin::port port)
+{
+    switch (port) {
+    case pin::port::port_a:
+        return GPIOA_BASE;
+    case pin::port::port_b:
+        return GPIOB_BASE;
+    case pin::port::port_c:
+        return GPIOC_BASE;
+    case pin::port::port_d:
+        return GPIOD_BASE;
+    case pin::port::port_e:
+        return GPIOE_BASE;
+    case pin::port::port_f:
+        return GPIOF_BASE;
+    case pin::port::port_g:
+        return GPIOG_BASE;
+    case pin::port::port_h:
+        return GPIOH_BASE;
+    case pin::port::port_i:
+        return GPIOI_BASE;
+    case pin::port::port_j:
+        return GPIOJ_BASE;
+    case pin::port::port_k:
+        return GPIOK_BASE;
+    default:
+        return 0;
+    }
+}
+
 // TODO: implement, comments
 static constexpr uint32_t pick_pin(pin::number pin)
 {
@@ -0,0 +1,382 @@
+#ifndef PLATFORM_PIN_EVENTS_HPP_
+#define PLATFORM_PIN_EVENTS_HPP_
+
+//!
+//! \file
+//! \brief Edges of input pins, caught by EXTI interrupts.
+//! Each edge is timestamped by the microsecond timebase in the ISR and
+//! queued, so a thread sleeps until the pin changes instead of polling it:
+//! \code
+//! using button = GPIO< pin::port::port_a, pin::number::pin_0 >;
+//! using button_events = ecl::pin_events< button >;
+//!
+//! ecl::timebase::init();
+//! button_events::init(ecl::capture_edge::both, 5000);   // 5 ms debounce
+//!
+//! for (;;) {
+//!     ecl::pin_event ev;
+//!     button_events::get(ev);
+//!     ecl::cout << (ev.level ? "released at " : "pressed at ") << ev.timestamp;
+//! }
+//! \endcode
+//! Pin must be configured as input, i.e. by the pin table. Each EXTI line
+//! serves pins with the same number, thus only one port can be watched per
+//! pin number. Latency of the ISR is included in timestamps, use input
+//! capture of the timebase for exact ones.
+//!
+
+#include <platform/gpio_device.hpp>
+#include <platform/irq_manager.hpp>
+#include <platform/timebase.hpp>
+
+#include <ecl/err.hpp>
+#include <ecl/thread/semaphore.hpp>
+#include <ecl/thread/spsc_queue.hpp>
+
+#include <stm32f4xx_exti.h>
+#include <stm32f4xx_syscfg.h>
+#include <stm32f4xx_rcc.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Edge of input pin.
+//!
+struct pin_event
+{
+    uint32_t    timestamp;  //!< Time of the edge, see timebase::now_us().
+    bool        level;      //!< Pin level, right after the edge.
+};
+
+//! \cond
+namespace exti_detail
+{
+
+//! Handler of single EXTI line.
+using line_fn = void (*)();
+
+//! Amount of EXTI lines, connected to GPIO.
+constexpr int lines = 16;
+
+//! Gets first line of the IRQ, that serves given line.
+constexpr int first_line(int line)
+{
+    return line < 5 ? line : line < 10 ? 5 : 10;
+}
+
+//! Gets last line of the IRQ, that serves given line.
+constexpr int last_line(int line)
+{
+    return line < 5 ? line : line < 10 ? 9 : 15;
+}
+
+//! Gets IRQ, that serves given line.
+constexpr IRQn_Type get_irqn(int line)
+{
+    return line < 5 ? static_cast< IRQn_Type >(EXTI0_IRQn + line)
+         : line < 10 ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
+
+//!
+//! \brief Dispatches EXTI IRQs, shared by lines 5 .. 9 and 10 .. 15, to
+//! handlers of lines.
+//! \tparam dummy Makes handler table a header-only static member.
+//!
+template< int dummy = 0 >
+struct dispatch
+{
+    //! Attaches handler to the line. \retval err::busy Line is taken.
+    template< int line >
+    static ecl::err attach(line_fn fn);
+
+    //! Detaches handler of the line.
+    template< int line >
+    static void detach();
+
+    //! IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    template< int first, int last >
+    static void irq_entry();
+
+    static line_fn m_lines[lines];  //!< Handlers of lines.
+};
+
+template< int dummy >
+line_fn dispatch< dummy >::m_lines[lines]{};
+
+template< int dummy >
+template< int line >
+ecl::err dispatch< dummy >::attach(line_fn fn)
+{
+    constexpr auto irqn = get_irqn(line);
+
+    IRQ_manager::mask(irqn);
+
+    if (m_lines[line] && m_lines[line] != fn) {
+        IRQ_manager::unmask(irqn);
+        return ecl::err::busy;
+    }
+
+    m_lines[line] = fn;
+
+    IRQ_manager::subscribe(irqn, irq_entry< first_line(line), last_line(line) >);
+    IRQ_manager::unmask(irqn);
+
+    return ecl::err::ok;
+}
+
+template< int dummy >
+template< int line >
+void dispatch< dummy >::detach()
+{
+    constexpr auto irqn = get_irqn(line);
+
+    IRQ_manager::mask(irqn);
+    m_lines[line] = nullptr;
+
+    for (int i = first_line(line); i <= last_line(line); ++i) {
+        if (m_lines[i]) {
+            IRQ_manager::unmask(irqn);
+            return;
+        }
+    }
+
+    IRQ_manager::unsubscribe(irqn);
+}
+
+template< int dummy >
+template< int first, int last >
+void dispatch< dummy >::irq_entry()
+{
+    constexpr uint32_t range = ((1UL << (last + 1)) - 1) & ~((1UL << first) - 1);
+    uint32_t pending = EXTI->PR & EXTI->IMR & range;
+
+    for (int line = first; line <= last; ++line) {
+        if (pending & (1UL << line)) {
+            EXTI->PR = 1UL << line;
+
+            if (m_lines[line]) {
+                m_lines[line]();
+            }
+        }
+    }
+
+    IRQ_manager::clear(get_irqn(first));
+    IRQ_manager::unmask(get_irqn(first));
+}
+
+} // namespace exti_detail
+//! \endcond
+
+//!
+//! \brief Interrupt-driven edges of an input pin.
+//! All members are static: EXTI line is bound to the pin number.
+//! Events are queued by the ISR and taken by a single thread.
+//! If debounce is set, edges closer than debounce time to last queued one
+//! are dropped. When both edges are caught, edges which don't change
+//! the level from the last queued event are dropped as well. Thus
+//! bouncing contact gives one event per press, as soon as it is pressed.
+//! \tparam Pin     GPIO of the pin, i.e. GPIO< pin::port::port_a, pin::number::pin_0 >.
+//! \tparam depth   Most events queued, power of two.
+//! \tparam tb      Timebase, must be initialized before events are caught.
+//!
+template< class Pin, size_t depth = 16, class tb = ecl::timebase >
+class pin_events
+{
+    static_assert(Pin::pin_mask && !(Pin::pin_mask & (Pin::pin_mask - 1)),
+                  "Single pin must be given");
+
+public:
+    //!
+    //! \brief Starts catching edges. Queue is emptied.
+    //! \param[in] edge         Edges to catch.
+    //! \param[in] debounce_us  Edges closer than this to the last queued
+    //!                         edge are dropped, in microseconds.
+    //! \retval err::ok     Edges are caught.
+    //! \retval err::busy   EXTI line is used by a pin of other port.
+    //!
+    static ecl::err init(capture_edge edge, uint32_t debounce_us = 0);
+
+    //!
+    //! \brief Stops catching edges.
+    //!
+    static void deinit();
+
+    //!
+    //! \brief Takes next event, waiting for it.
+    //! Cannot be called from ISR.
+    //!
+    static void get(pin_event &ev);
+
+    //!
+    //! \brief Takes next event, if any.
+    //! \retval err::ok     Event is taken.
+    //! \retval err::again  No event is queued.
+    //!
+    static ecl::err try_get(pin_event &ev);
+
+    //!
+    //! \brief Gets amount of edges lost since init(), because queue was full.
+    //!
+    static size_t dropped();
+
+    //!
+    //! \brief Gets amount of edges dropped by debounce since init().
+    //!
+    static size_t bounces();
+
+private:
+    //! EXTI line of the pin.
+    static constexpr int line = __builtin_ctz(Pin::pin_mask);
+
+    //! Handles edge of the line.
+    static void line_handler();
+
+    static ecl::spsc_queue< pin_event, depth >  m_queue;        //!< Queued events.
+    static ecl::semaphore                       m_ready;        //!< Counts queued events.
+    static uint32_t                             m_debounce;     //!< Debounce time, us.
+    static bool                                 m_both;         //!< Both edges are caught.
+    static pin_event                            m_last;         //!< Last queued event.
+    static std::atomic< size_t >                m_dropped;      //!< Edges lost.
+    static std::atomic< size_t >                m_bounces;      //!< Edges debounced.
+};
+
+//------------------------------------------------------------------------------
+
+template< class Pin, size_t depth, class tb >
+ecl::spsc_queue< pin_event, depth > pin_events< Pin, depth, tb >::m_queue{};
+
+template< class Pin, size_t depth, class tb >
+ecl::semaphore pin_events< Pin, depth, tb >::m_ready{};
+
+template< class Pin, size_t depth, class tb >
+uint32_t pin_events< Pin, depth, tb >::m_debounce{0};
+
+template< class Pin, size_t depth, class tb >
+bool pin_events< Pin, depth, tb >::m_both{false};
+
+template< class Pin, size_t depth, class tb >
+pin_event pin_events< Pin, depth, tb >::m_last{};
+
+template< class Pin, size_t depth, class tb >
+std::atomic< size_t > pin_events< Pin, depth, tb >::m_dropped{0};
+
+template< class Pin, size_t depth, class tb >
+std::atomic< size_t > pin_events< Pin, depth, tb >::m_bounces{0};
+
+template< class Pin, size_t depth, class tb >
+ecl::err pin_events< Pin, depth, tb >::init(capture_edge edge, uint32_t debounce_us)
+{
+    deinit();
+
+    pin_event ev;
+    while (try_get(ev) == ecl::err::ok) { }
+
+    m_debounce = debounce_us;
+    m_both = edge == capture_edge::both;
+    m_dropped = 0;
+    m_bounces = 0;
+
+    // Past timestamp lets the first edge through
+    m_last = pin_event{tb::now_us() - debounce_us, Pin::get() != 0};
+
+    auto rc = exti_detail::dispatch<>::attach< line >(line_handler);
+
+    if (rc != ecl::err::ok) {
+        return rc;
+    }
+
+    RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE);
+    SYSCFG_EXTILineConfig(static_cast< uint8_t >(Pin::port_id), line);
+
+    EXTI_InitTypeDef init_struct;
+
+    init_struct.EXTI_Line       = 1UL << line;
+    init_struct.EXTI_Mode       = EXTI_Mode_Interrupt;
+    init_struct.EXTI_Trigger    = edge == capture_edge::rising ? EXTI_Trigger_Rising
+                                : edge == capture_edge::falling ? EXTI_Trigger_Falling
+                                : EXTI_Trigger_Rising_Falling;
+    init_struct.EXTI_LineCmd    = ENABLE;
+
+    EXTI_ClearITPendingBit(1UL << line);
+    EXTI_Init(&init_struct);
+
+    return ecl::err::ok;
+}
+
+template< class Pin, size_t depth, class tb >
+void pin_events< Pin, depth, tb >::deinit()
+{
+    // Line of other port is left intact
+    if (exti_detail::dispatch<>::m_lines[line] != line_handler) {
+        return;
+    }
+
+    EXTI->IMR &= ~(1UL << line);
+    EXTI_ClearITPendingBit(1UL << line);
+
+    exti_detail::dispatch<>::detach< line >();
+}
+
+template< class Pin, size_t depth, class tb >
+void pin_events< Pin, depth, tb >::get(pin_event &ev)
+{
+    m_ready.wait();
+    m_queue.pop(ev);
+}
+
+template< class Pin, size_t depth, class tb >
+ecl::err pin_events< Pin, depth, tb >::try_get(pin_event &ev)
+{
+    if (m_ready.try_wait() != ecl::err::ok) {
+        return ecl::err::again;
+    }
+
+    m_queue.pop(ev);
+    return ecl::err::ok;
+}
+
+template< class Pin, size_t depth, class tb >
+size_t pin_events< Pin, depth, tb >::dropped()
+{
+    return m_dropped;
+}
+
+template< class Pin, size_t depth, class tb >
+size_t pin_events< Pin, depth, tb >::bounces()
+{
+    return m_bounces;
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< class Pin, size_t depth, class tb >
+void pin_events< Pin, depth, tb >::line_handler()
+{
+    pin_event ev{tb::now_us(), Pin::get() != 0};
+
+    if (m_debounce) {
+        if (ev.timestamp - m_last.timestamp < m_debounce
+                || (m_both && ev.level == m_last.level)) {
+            ++m_bounces;
+            return;
+        }
+    }
+
+    if (!m_queue.push(ev)) {
+        ++m_dropped;
+        return;
+    }
+
+    m_last = ev;
+    m_ready.signal();
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_PIN_EVENTS_HPP_
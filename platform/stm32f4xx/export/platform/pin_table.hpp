@@ -0,0 +1,233 @@
+#ifndef PLATFORM_PIN_TABLE_HPP
+#define PLATFORM_PIN_TABLE_HPP
+
+#include <common/pin.hpp>
+#include "pin_descriptor.hpp"
+#include "gpio_device.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Board pin table. Register values of every port are computed at
+// compile time from the whole table, so at startup each configuration
+// register is written once per port, instead of running SPL init for
+// each pin.
+//
+// Usage:
+//
+// using board_pins = pin_table<
+//     pin_cfg< pin::port::port_a, pin::number::pin_5, pin::function::pin_SPI1 >,
+//     pin_cfg< pin::port::port_d, pin::number::pin_12, pin::function::gpio_out >
+// >;
+//
+// board_pins::init();
+
+// Configuration of single pin, prepared for register computation
+struct pin_config
+{
+    pin::port   port;
+    uint8_t     num;    // Pin number, 0 to 15
+    uint8_t     mode;   // MODER value
+    uint8_t     type;   // OTYPER value
+    uint8_t     speed;  // OSPEEDR value
+    uint8_t     pupd;   // PUPDR value
+    uint8_t     af;     // AFR value, meaningful only in AF mode
+};
+
+// Register values of a port, and masks of bits that belong to the table.
+// Bits outside masks are preserved, so pins missing in the table,
+// i.e. SWD pins, keep their configuration.
+struct port_config
+{
+    uint32_t moder;
+    uint32_t otyper;
+    uint32_t ospeedr;
+    uint32_t pupdr;
+    uint32_t afr[2];
+
+    uint32_t wide_mask;     // Mask for 2-bit fields: MODER, OSPEEDR, PUPDR
+    uint32_t otyper_mask;
+    uint32_t afr_mask[2];
+};
+
+// Pin, as it is listed in the table
+template< pin::port        port,
+          pin::number      pin_num,
+          pin::function    purpose,
+          pin::type        type = pin::type::push_pull,
+          pin::pp_mode     mode = pin::pp_mode::no_pull >
+struct pin_cfg
+{
+    // Pin as it is written in the table, for checks of board descriptions
+    static constexpr pin::port      port_id     = port;
+    static constexpr pin::number    number_id   = pin_num;
+    static constexpr pin::function  function_id = purpose;
+
+    static constexpr pin_config config()
+    {
+        return pin_config {
+            port,
+            static_cast< uint8_t >(pin_num),
+            static_cast< uint8_t >(pick_mode(purpose)),
+            static_cast< uint8_t >(pick_type(type)),
+            static_cast< uint8_t >(pick_speed()),
+            static_cast< uint8_t >(pick_pp(mode)),
+            pick_mode(purpose) == GPIO_Mode_AF ? pick_AF(purpose) : uint8_t{0},
+        };
+    }
+};
+
+namespace pin_detail
+{
+
+// Computes registers of given port
+static constexpr port_config compute_port(const pin_config *pins, size_t n, pin::port port)
+{
+    port_config cfg{};
+
+    for (size_t i = 0; i < n; ++i) {
+        const auto &p = pins[i];
+
+        if (p.port != port) {
+            continue;
+        }
+
+        uint32_t wide_shift = p.num * 2;
+        uint32_t afr_idx = p.num / 8;
+        uint32_t afr_shift = (p.num % 8) * 4;
+
+        cfg.moder       |= static_cast< uint32_t >(p.mode) << wide_shift;
+        cfg.ospeedr     |= static_cast< uint32_t >(p.speed) << wide_shift;
+        cfg.pupdr       |= static_cast< uint32_t >(p.pupd) << wide_shift;
+        cfg.wide_mask   |= 0x3UL << wide_shift;
+
+        cfg.otyper      |= static_cast< uint32_t >(p.type) << p.num;
+        cfg.otyper_mask |= 1UL << p.num;
+
+        cfg.afr[afr_idx]      |= static_cast< uint32_t >(p.af & 0xf) << afr_shift;
+        cfg.afr_mask[afr_idx] |= 0xfUL << afr_shift;
+    }
+
+    return cfg;
+}
+
+// Gets AHB1 clock enable bits for all used ports
+static constexpr uint32_t compute_clocks(const pin_config *pins, size_t n)
+{
+    uint32_t clocks = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        // GPIOxEN bits follow port order
+        clocks |= RCC_AHB1ENR_GPIOAEN << static_cast< int >(pins[i].port);
+    }
+
+    return clocks;
+}
+
+// Checks that no pin is listed twice
+static constexpr bool has_duplicates(const pin_config *pins, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i + 1; j < n; ++j) {
+            if (pins[i].port == pins[j].port && pins[i].num == pins[j].num) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Writes bits under the mask, preserving the rest of the register
+static inline void write_masked(volatile uint32_t &reg, uint32_t val, uint32_t mask)
+{
+    reg = (reg & ~mask) | val;
+}
+
+} // namespace pin_detail
+
+// Table of board pins
+template< class... Pins >
+class pin_table
+{
+    static_assert(sizeof...(Pins) > 0, "Table must contain pins");
+
+public:
+    // Enables port clocks and configures all pins
+    static void init();
+
+    // Computed register values of given port
+    static constexpr port_config port(pin::port id)
+    {
+        const pin_config pins[] = { Pins::config()... };
+        return pin_detail::compute_port(pins, sizeof...(Pins), id);
+    }
+
+    // Clock enable bits of used ports
+    static constexpr uint32_t clocks()
+    {
+        const pin_config pins[] = { Pins::config()... };
+        return pin_detail::compute_clocks(pins, sizeof...(Pins));
+    }
+
+    // Checks the table
+    static constexpr bool valid()
+    {
+        const pin_config pins[] = { Pins::config()... };
+        return !pin_detail::has_duplicates(pins, sizeof...(Pins));
+    }
+
+private:
+    template< int id >
+    static void init_port(std::integral_constant< int, id >);
+
+    static void init_port(std::integral_constant< int, gpio_detail::port_count >) {}
+};
+
+//------------------------------------------------------------------------------
+
+template< class... Pins >
+void pin_table< Pins... >::init()
+{
+    static_assert(valid(), "Pin is listed more than once");
+
+    RCC->AHB1ENR |= clocks();
+
+    // Let clock reach ports before they are accessed
+    (void) RCC->AHB1ENR;
+
+    init_port(std::integral_constant< int, 0 >{});
+}
+
+template< class... Pins >
+template< int id >
+void pin_table< Pins... >::init_port(std::integral_constant< int, id >)
+{
+    constexpr auto cfg = port(static_cast< pin::port >(id));
+
+    // Ports without pins in the table cost nothing
+    if (cfg.wide_mask) {
+        auto regs = gpio_detail::regs(static_cast< pin::port >(id));
+
+        // Mode is written last, so pin doesn't glitch through
+        // intermediate configurations
+        pin_detail::write_masked(regs->OTYPER, cfg.otyper, cfg.otyper_mask);
+        pin_detail::write_masked(regs->OSPEEDR, cfg.ospeedr, cfg.wide_mask);
+        pin_detail::write_masked(regs->PUPDR, cfg.pupdr, cfg.wide_mask);
+
+        if (cfg.afr_mask[0]) {
+            pin_detail::write_masked(regs->AFR[0], cfg.afr[0], cfg.afr_mask[0]);
+        }
+
+        if (cfg.afr_mask[1]) {
+            pin_detail::write_masked(regs->AFR[1], cfg.afr[1], cfg.afr_mask[1]);
+        }
+
+        pin_detail::write_masked(regs->MODER, cfg.moder, cfg.wide_mask);
+    }
+
+    init_port(std::integral_constant< int, id + 1 >{});
+}
+
+#endif // PLATFORM_PIN_TABLE_HPP
@@ -0,0 +1,164 @@
+#ifndef PLATFORM_POWER_HPP_
+#define PLATFORM_POWER_HPP_
+
+//!
+//! \file
+//! \brief Low-power modes, entered by tickless idle of the kernel.
+//! Idle MCU waits for interrupts in sleep mode by default: clocks keep
+//! running, so do DMA transfers and timers. Stop mode halts all clocks
+//! but LSE/LSI, saving much more, and is entered instead when:
+//!  - it is enabled by power::enable_stop(),
+//!  - no sleep lock is held, i.e. no bus transaction is pending,
+//!  - no stop lock is held, i.e. no DMA stream is leased and no capture
+//!    channel of the timebase is armed,
+//!  - kernel is going to be idle long enough to pay off the wake-up.
+//! \code
+//! ecl::timebase::init();
+//! ecl::rtc::init();
+//! ecl::power::enable_stop<ecl::rtc>();
+//!
+//! // UART receiver must not be stopped while waiting for a command
+//! ecl::power::inhibit_stop();
+//! \endcode
+//! MCU is woken by the RTC wakeup timer right before the next kernel
+//! timeout, or earlier by any EXTI line, i.e. by pin_events. Clocks are
+//! restored from the configuration in rcc_config.h before the kernel
+//! continues. Timebase doesn't count in stop mode, so intervals which
+//! span it are shorter by the stop time. RTC time is resynced after each
+//! stop, thus wall-clock time is kept.
+//! Requires CONFIG_FREERTOS_TICKLESS_IDLE, otherwise MCU never sleeps.
+//!
+
+#include <ecl/err.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+//! Kernel hook of tickless idle, see kernel/freertos/kernel_main.c.
+extern "C" uint32_t kernel_deep_sleep(uint32_t idle_us);
+
+namespace ecl
+{
+
+//!
+//! \brief Mode, in which MCU spends idle time.
+//!
+enum class power_mode
+{
+    sleep,  //!< CPU clock is stopped, peripherals keep running.
+    stop,   //!< All clocks are stopped, but LSE/LSI.
+};
+
+//!
+//! \brief Power-mode manager.
+//! All members are static: power modes are shared by the whole firmware.
+//!
+class power
+{
+public:
+    //! Least idle time, worth entering stop mode, in microseconds.
+    //! Wake-up takes up to HSE startup time plus RTC resync.
+    static constexpr uint32_t default_stop_min_us = 10000;
+
+    //!
+    //! \brief Lets idle MCU enter stop mode.
+    //! RTC must be running. Its wakeup timer is taken by the manager.
+    //! \tparam rtc_t   RTC to resync after each stop, i.e. ecl::rtc.
+    //! \param[in] min_idle_us  Stop mode is entered if kernel is going to be
+    //!                         idle for at least this time, in microseconds.
+    //!
+    template< class rtc_t >
+    static void enable_stop(uint32_t min_idle_us = default_stop_min_us)
+    {
+        enable_stop(rtc_t::resync, min_idle_us);
+    }
+
+    //!
+    //! \brief Lets idle MCU enter stop mode, without RTC time to resync.
+    //! \sa enable_stop()
+    //!
+    static void enable_stop(ecl::err (*resync)(), uint32_t min_idle_us);
+
+    //!
+    //! \brief Keeps idle MCU in sleep mode only.
+    //!
+    static void disable_stop();
+
+    //!
+    //! \brief Inhibits stop mode, while clocks must keep running.
+    //! Locks are counted, each call must be paired with allow_stop().
+    //! Can be called from ISR.
+    //!
+    static void inhibit_stop();
+
+    //!
+    //! \brief Allows stop mode, if there is no more locks.
+    //! Can be called from ISR.
+    //!
+    static void allow_stop();
+
+    //!
+    //! \brief Gets the deepest mode, which is safe for given idle time.
+    //! Sleep locks are checked by the kernel, before the mode is selected.
+    //! \param[in] idle_us  Time, till kernel has something to do, in microseconds.
+    //!
+    static power_mode select(uint32_t idle_us);
+
+    //!
+    //! \brief Enters stop mode and restores clocks after wake-up.
+    //! Called by the kernel from tickless idle, with interrupts disabled.
+    //! \param[in] max_us  Most time to stay in stop mode, in microseconds.
+    //! \return Time spent in stop mode, in microseconds.
+    //!
+    static uint32_t enter_stop(uint32_t max_us);
+
+    //!
+    //! \brief Gets amount of times idle MCU went to sleep mode.
+    //!
+    static size_t sleeps();
+
+    //!
+    //! \brief Gets amount of times idle MCU went to stop mode.
+    //!
+    static size_t stops();
+
+private:
+    friend uint32_t ::kernel_deep_sleep(uint32_t idle_us);
+
+    //! Sets up RTC wakeup timer and its EXTI line.
+    static void init_wakeup();
+
+    //! Gets time of day by RTC, in RTC sub-second units.
+    static uint32_t rtc_ticks();
+
+    //! Restores oscillators and system clock after stop mode.
+    static void restore_clocks(bool overdrive);
+
+    //! Handles RTC wakeup IRQ, if it isn't cleared before interrupts are enabled.
+    static void wakeup_irq();
+
+    static std::atomic< uint32_t >  m_stop_locks;   //!< Stop locks held.
+    static std::atomic< size_t >    m_sleeps;       //!< Sleep mode entries.
+    static std::atomic< size_t >    m_stops;        //!< Stop mode entries.
+    static ecl::err                 (*m_resync)();  //!< Resyncs RTC time.
+    static uint32_t                 m_stop_min_us;  //!< Least idle time for stop.
+    static bool                     m_stop_enabled; //!< Stop mode is enabled.
+};
+
+//!
+//! \brief Holds stop lock in a scope.
+//!
+class stop_guard
+{
+public:
+    stop_guard() { power::inhibit_stop(); }
+    ~stop_guard() { power::allow_stop(); }
+
+    stop_guard(const stop_guard &) = delete;
+    stop_guard &operator=(const stop_guard &) = delete;
+};
+
+} // namespace ecl
+
+#endif // PLATFORM_POWER_HPP_
@@ -0,0 +1,300 @@
+#ifndef PLATFORM_RTC_HPP_
+#define PLATFORM_RTC_HPP_
+
+//!
+//! \file
+//! \brief Wall-clock time, kept by RTC and read through the timebase.
+//! RTC registers are read through shadow registers, which take a couple
+//! of RTC clock cycles to synchronize. Thus RTC is read only by resync():
+//! it captures calendar time together with the timebase, and now_us()
+//! extends the capture by elapsed timebase microseconds. Reading time
+//! costs as much as timebase::now_us() then, and can be done from ISRs:
+//! \code
+//! ecl::timebase::init();
+//! ecl::rtc::init();
+//!
+//! log.set_clock(ecl::rtc::now_us);
+//! fat::native::volume::set_time_source(ecl::rtc::fat_now);
+//!
+//! // In a low-priority thread, more often than timebase wraps
+//! for (;;) {
+//!     os::this_thread::sleep_for(10 * 60 * 1000);
+//!     ecl::rtc::resync();
+//! }
+//! \endcode
+//! Resync also corrects the drift between clocks of timebase and RTC.
+//! RTC keeps running across resets, as long as backup domain is powered.
+//!
+
+#include <platform/timebase.hpp>
+
+#include <ecl/calendar.hpp>
+#include <ecl/err.hpp>
+
+#include <stm32f4xx_pwr.h>
+#include <stm32f4xx_rcc.h>
+#include <stm32f4xx_rtc.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Clock of RTC.
+//!
+enum class rtc_source
+{
+    lse,    //!< 32.768 kHz crystal, accurate.
+    lsi,    //!< Internal RC, about 32 kHz, drifts by percents.
+};
+
+//!
+//! \brief Real-time clock.
+//! All members are static: RTC is shared by the whole firmware.
+//! \tparam source  Clock of RTC.
+//! \tparam tb      Timebase, must be initialized before RTC.
+//!
+template< rtc_source source = rtc_source::lse, class tb = ecl::timebase >
+class rtc_unit
+{
+public:
+    //!
+    //! \brief Starts RTC, unless it is running already, and captures time.
+    //! Calendar of just started RTC is set to 2000-01-01 00:00:00.
+    //! \retval err::ok         RTC is running.
+    //! \retval err::timedout   Oscillator doesn't start.
+    //! \retval err::io         RTC can't be initialized.
+    //!
+    static ecl::err init();
+
+    //!
+    //! \brief Sets calendar time and captures it.
+    //! \param[in] dt Time of year 2000 .. 2099.
+    //! \retval err::ok     Time is set.
+    //! \retval err::inval  Year is out of range.
+    //! \retval err::io     RTC doesn't respond.
+    //!
+    static ecl::err set(const date_time &dt);
+
+    //!
+    //! \brief Captures time of RTC and timebase together.
+    //! Must be called at least once per timebase wrap, i.e. each hour.
+    //! Cannot be called from ISR, waits for RTC shadow registers.
+    //! \retval err::ok     Time is captured.
+    //! \retval err::io     RTC doesn't respond.
+    //!
+    static ecl::err resync();
+
+    //!
+    //! \brief Gets current Unix time in microseconds.
+    //! Can be called from threads and ISRs.
+    //!
+    static uint64_t now_us();
+
+    //!
+    //! \brief Gets current calendar time.
+    //!
+    static date_time now();
+
+    //!
+    //! \brief Gets current FAT timestamp. \sa ecl::to_fat()
+    //!
+    static uint32_t fat_now();
+
+private:
+    //! Captured time.
+    struct epoch
+    {
+        uint64_t    unix_us;    //!< Unix time, microseconds.
+        uint32_t    tb_us;      //!< Timebase at the same moment.
+    };
+
+    //! Prescalers, giving 1 Hz calendar clock. Larger synchronous one
+    //! gives finer sub-seconds, about a millisecond, so time slept in
+    //! stop mode is measured to a kernel tick. Asynchronous one is kept
+    //! large enough to save power.
+    static constexpr uint32_t async_prediv  = 31;
+    static constexpr uint32_t sync_prediv   = source == rtc_source::lse ? 1023 : 999;
+
+    //! Starts selected oscillator. \retval false It doesn't start.
+    static bool start_oscillator();
+
+    //! Converts BCD field of a register to binary.
+    static uint32_t bcd(uint32_t reg, int shift, uint32_t mask);
+
+    //! Captures, one slot is read while other one is updated.
+    static epoch                    m_epochs[2];
+    //! Slot of actual capture.
+    static std::atomic< uint8_t >   m_slot;
+};
+
+//! Real-time clock, driven by LSE.
+using rtc = rtc_unit<>;
+
+//------------------------------------------------------------------------------
+
+template< rtc_source source, class tb >
+typename rtc_unit< source, tb >::epoch rtc_unit< source, tb >::m_epochs[2]{};
+
+template< rtc_source source, class tb >
+std::atomic< uint8_t > rtc_unit< source, tb >::m_slot{0};
+
+template< rtc_source source, class tb >
+ecl::err rtc_unit< source, tb >::init()
+{
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR, ENABLE);
+    PWR_BackupAccessCmd(ENABLE);
+
+    // LSI is not in the backup domain, it is off after each reset
+    bool running = (RCC->BDCR & RCC_BDCR_RTCEN) && source == rtc_source::lse;
+
+    if (!running) {
+        if (!start_oscillator()) {
+            return ecl::err::timedout;
+        }
+
+        RCC_RTCCLKConfig(source == rtc_source::lse ? RCC_RTCCLKSource_LSE
+                                                   : RCC_RTCCLKSource_LSI);
+        RCC_RTCCLKCmd(ENABLE);
+    }
+
+    // Calendar of running RTC is kept, prescalers may differ though
+    if (RTC->PRER != (async_prediv << 16 | sync_prediv)) {
+        RTC_InitTypeDef init_struct;
+
+        RTC_StructInit(&init_struct);
+        init_struct.RTC_HourFormat      = RTC_HourFormat_24;
+        init_struct.RTC_AsynchPrediv    = async_prediv;
+        init_struct.RTC_SynchPrediv     = sync_prediv;
+
+        if (RTC_Init(&init_struct) != SUCCESS) {
+            return ecl::err::io;
+        }
+    }
+
+    return resync();
+}
+
+template< rtc_source source, class tb >
+ecl::err rtc_unit< source, tb >::set(const date_time &dt)
+{
+    if (dt.year < 2000 || dt.year > 2099) {
+        return ecl::err::inval;
+    }
+
+    RTC_TimeTypeDef time;
+
+    time.RTC_Hours      = dt.hour;
+    time.RTC_Minutes    = dt.min;
+    time.RTC_Seconds    = dt.sec;
+    time.RTC_H12        = RTC_H12_AM;
+
+    // Week starts from Monday in RTC, 1970-01-01 is Thursday
+    RTC_DateTypeDef date;
+
+    date.RTC_WeekDay    = (to_unix(dt) / 86400 + 3) % 7 + 1;
+    date.RTC_Month      = dt.month;
+    date.RTC_Date       = dt.day;
+    date.RTC_Year       = dt.year - 2000;
+
+    if (RTC_SetDate(RTC_Format_BIN, &date) != SUCCESS
+            || RTC_SetTime(RTC_Format_BIN, &time) != SUCCESS) {
+        return ecl::err::io;
+    }
+
+    return resync();
+}
+
+template< rtc_source source, class tb >
+ecl::err rtc_unit< source, tb >::resync()
+{
+    if (RTC_WaitForSynchro() != SUCCESS) {
+        return ecl::err::io;
+    }
+
+    // Reading SSR freezes TR and DR until DR is read, so all three
+    // belong to the same moment. SPL getters unfreeze them in between.
+    uint32_t ssr = RTC->SSR;
+    uint32_t now = tb::now_us();
+    uint32_t tr = RTC->TR;
+    uint32_t dr = RTC->DR;
+
+    date_time dt{
+        static_cast< uint16_t >(2000 + bcd(dr, 16, 0xff)),
+        static_cast< uint8_t >(bcd(dr, 8, 0x1f)),
+        static_cast< uint8_t >(bcd(dr, 0, 0x3f)),
+        static_cast< uint8_t >(bcd(tr, 16, 0x3f)),
+        static_cast< uint8_t >(bcd(tr, 8, 0x7f)),
+        static_cast< uint8_t >(bcd(tr, 0, 0x7f)),
+    };
+
+    // Sub-second counter runs down from the synchronous prescaler
+    uint64_t frac = (sync_prediv - (ssr & 0xffff)) * 1000000ULL / (sync_prediv + 1);
+
+    uint8_t next = m_slot ^ 1;
+    m_epochs[next] = epoch{to_unix(dt) * 1000000ULL + frac, now};
+    m_slot = next;
+
+    return ecl::err::ok;
+}
+
+template< rtc_source source, class tb >
+uint64_t rtc_unit< source, tb >::now_us()
+{
+    const epoch &e = m_epochs[m_slot];
+    return e.unix_us + (tb::now_us() - e.tb_us);
+}
+
+template< rtc_source source, class tb >
+date_time rtc_unit< source, tb >::now()
+{
+    return from_unix(now_us() / 1000000);
+}
+
+template< rtc_source source, class tb >
+uint32_t rtc_unit< source, tb >::fat_now()
+{
+    return to_fat(now());
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< rtc_source source, class tb >
+bool rtc_unit< source, tb >::start_oscillator()
+{
+    // Crystal may take up to two seconds to start
+    constexpr uint32_t timeout_us = 2000000;
+    uint8_t flag;
+
+    if (source == rtc_source::lse) {
+        RCC_LSEConfig(RCC_LSE_ON);
+        flag = RCC_FLAG_LSERDY;
+    } else {
+        RCC_LSICmd(ENABLE);
+        flag = RCC_FLAG_LSIRDY;
+    }
+
+    auto start = tb::now_us();
+
+    while (RCC_GetFlagStatus(flag) == RESET) {
+        if (tb::now_us() - start > timeout_us) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template< rtc_source source, class tb >
+uint32_t rtc_unit< source, tb >::bcd(uint32_t reg, int shift, uint32_t mask)
+{
+    uint32_t v = (reg >> shift) & mask;
+    return (v >> 4) * 10 + (v & 0xf);
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_RTC_HPP_
@@ -4,7 +4,13 @@
 #include <common/spi.hpp>
 #include <platform/common/bus.hpp>
 #include <platform/irq_manager.hpp>
+#include <platform/clock.hpp>
 #include <platform/dma_device.hpp>
+#include <platform/dma_manager.hpp>
+
+#include <ecl/assert.h>
+#include <ecl/lookup_table.hpp>
+#include <ecl/regs.hpp>
 
 #include <sys/types.h>
 
@@ -25,13 +31,15 @@ template< spi_device        dev,
           uint16_t          cpha,
           uint16_t          nss,
           uint16_t          first_bit,
-          uint32_t          clk >
+          uint32_t          clk,
+          uint16_t          data_size = SPI_DataSize_8b,
+          size_t            poll_max  = 4 >
 struct spi_config
 {
     static constexpr SPI_InitTypeDef m_init_obj = {
         direction,
         mode,
-        SPI_DataSize_8b,
+        data_size,
         cpol,
         cpha,
         nss,
@@ -46,6 +54,22 @@ struct spi_config
     static constexpr std::uintptr_t     m_dma_tx_stream    = dma_tx_stream;
     static constexpr uint32_t           m_dma_rx_channel   = dma_rx_channel;
     static constexpr std::uintptr_t     m_dma_rx_stream    = dma_rx_stream;
+
+    //! 16-bit frames are used. Buffer sizes must be even in this case.
+    static constexpr bool               m_wide             = (data_size == SPI_DataSize_16b);
+    //! Bidirectional single-line TX mode. RX DMA stream is not used at all,
+    //! so it can be occupied by other peripheral.
+    static constexpr bool               m_tx_only          = (direction == SPI_Direction_1Line_Tx);
+    //! Largest xfer, in bytes, that is done by CPU polling instead of DMA.
+    //! DMA setup and completion IRQ cost more than few frames on the wire.
+    //! Zero disables polling.
+    static constexpr size_t             m_poll_max         = poll_max;
+
+    //! Streams claimed by the bus. \sa dma::exclusive_streams
+    using dma_streams = dma::stream_list< dma_tx_stream, m_tx_only ? 0 : dma_rx_stream >;
+
+    static_assert(m_tx_only || dma_tx_stream != dma_rx_stream,
+                  "TX and RX must use different DMA streams");
 };
 
 template< class spi_config >
@@ -115,25 +139,129 @@ public:
     //!
     //! \brief Executes xfer, using buffers previously set.
     //! When it will be done, handler will be invoked.
+    //! DMA streams are leased for the duration of the xfer.
+    //! Xfers up to spi_config::m_poll_max bytes are done by polling,
+    //! without DMA. In that case handler is invoked before return,
+    //! in context of the caller.
+    //! \retval err::busy DMA stream is leased by someone else.
     //! \return Status of operation.
     //!
     ecl::err do_xfer();
 
+    //!
+    //! \brief Sets double buffers for streaming xfer.
+    //! In streaming mode bus continuously transfers data, switching between
+    //! first and second buffer in each direction, until stop_stream() call.
+    //! Null buffers are threated the same way as in set_tx() and set_rx().
+    //! If second buffer of a direction is null, first one is used instead.
+    //! \param[in]      tx0     First buffer to transmit. Optional.
+    //! \param[in]      tx1     Second buffer to transmit. Optional.
+    //! \param[in,out]  rx0     First buffer to write data to. Optional.
+    //! \param[in,out]  rx1     Second buffer to write data to. Optional.
+    //! \param[in]      size    Size of each buffer.
+    //!
+    void set_double_buffers(const uint8_t *tx0, const uint8_t *tx1,
+                            uint8_t *rx0, uint8_t *rx1, size_t size);
+
+    //!
+    //! \brief Starts streaming xfer, using double buffers previously set.
+    //! Each time a buffer is complete, handler is invoked with event::ht
+    //! for the first buffer and with event::tc for the second one.
+    //! Total amount of bytes streamed so far is reported as well.
+    //! Completed buffer may be refilled (or consumed) while other one is
+    //! in flight. Events are delivered for RX channel or, if RX is not
+    //! requested, for TX channel.
+    //! \return Status of operation.
+    //!
+    ecl::err do_stream();
+
+    //!
+    //! \brief Stops streaming xfer.
+    //! Handler will be invoked with meta-channel TC event, as if regular
+    //! xfer is complete.
+    //! \retval err::ok     Streaming stopped.
+    //! \retval err::perm   Streaming is not started.
+    //!
+    ecl::err stop_stream();
+
+    //!
+    //! \brief Sets bus clock.
+    //! Closest clock that is not greater than requested is picked,
+    //! if possible. Bus is reconfigured only if prescaler is changed.
+    //! \pre No xfer is in progress.
+    //! \param[in] clk Desired clock, in Hz.
+    //! \retval err::ok     Clock is set.
+    //! \retval err::inval  Clock is zero.
+    //! \retval err::perm   Bus is not initialized.
+    //! \retval err::busy   Streaming xfer is in progress.
+    //!
+    ecl::err set_clock(uint32_t clk);
+
+    //!
+    //! \brief Sets clock polarity and phase.
+    //! \pre No xfer is in progress.
+    //! \param[in] cpol Clock polarity: SPI_CPOL_Low or SPI_CPOL_High.
+    //! \param[in] cpha Clock phase: SPI_CPHA_1Edge or SPI_CPHA_2Edge.
+    //! \retval err::ok     Mode is set.
+    //! \retval err::inval  Invalid polarity or phase.
+    //! \retval err::perm   Bus is not initialized.
+    //! \retval err::busy   Streaming xfer is in progress.
+    //!
+    ecl::err set_mode(uint16_t cpol, uint16_t cpha);
+
+    //!
+    //! \brief Recovers bus after error.
+    //! DMA streams are stopped, SPI error flags are cleared and master mode
+    //! is restored, if mode fault dropped it. Configuration and buffers
+    //! are kept.
+    //! \pre No xfer is in progress.
+    //! \retval err::ok     Bus is recovered.
+    //! \retval err::perm   Bus is not initialized.
+    //!
+    ecl::err recover();
+
 private:
+    // Registers and clock of SPI
+    struct periph_info
+    {
+        std::uintptr_t  base;   // Address of SPI registers
+        uint32_t        rcc;    // Clock bit of SPI
+        bool            apb2;   // SPI is on APB2, APB1 otherwise
+    };
+
+    // DMA requests of SPI, toggled on each xfer
+    using cr2       = ECL_REG(SPI_TypeDef, CR2);
+    using rxdmaen   = ecl::regs::bits< cr2, SPI_CR2_RXDMAEN >;
+    using txdmaen   = ecl::regs::bits< cr2, SPI_CR2_TXDMAEN >;
+
+    // Looks up SPI device at compile time
+    static constexpr periph_info pick_periph();
+
     static constexpr auto pick_spi();
     static constexpr auto pick_rcc();
     static constexpr auto pick_rcc_fn();
-    //    static constexpr auto pick_IT();
 
-    // Depends on the evironment
-    static auto pick_pclk();
+    // Gets clock of APB, the SPI is connected to
+    static constexpr uint32_t pick_pclk();
+
+    // Calculates closest prescaler for the given clock
+    static uint16_t pick_prescaler(uint32_t clk);
 
     // DMA init helper
     void init_dma();
 
+    // Takes leases of DMA streams used by the bus
+    ecl::err lease_dma();
+
+    // Returns leases of DMA streams
+    void release_dma();
+
     // Checks if buffer sizes are valid
     bool valid_sizes();
 
+    // Converts size in bytes to amount of SPI frames (DMA data items)
+    static constexpr size_t frames(size_t size);
+
     // Prepares TX transaction, if needed
     void prepare_tx();
 
@@ -143,12 +271,31 @@ private:
     // Starts transaction, if needed
     void start_xfer();
 
+    // Checks if xfer is small enough to be done by polling
+    bool poll_suitable() const;
+
+    // Executes xfer by polling, without DMA and IRQ
+    void poll_xfer();
+
+    // Aborts xfer after DMA error and reports unfinished channels as failed
+    void xfer_failed();
+
     // IRQ init helper. TODO: decide if this needed or not
     // void init_irq();
 
     // Handles both DMA and SPI IRQ events. (for now it handles DMA only)
     void irq_handler();
 
+    // IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void irq_entry();
+
+    // Handles DMA IRQ events in streaming mode
+    void stream_irq_handler();
+
+    // Reports buffer completion of given stream in streaming mode
+    template< std::uintptr_t dma_stream >
+    void stream_event(channel ch, size_t size);
+
     //! Bus is inited if this flag is set.
     static constexpr uint8_t inited         = 0x1;
     //! Bus is in fill mode if this flag is set.
@@ -159,28 +306,46 @@ private:
     static constexpr uint8_t tx_hidden      = 0x8;
     //! RX is finished if this flag is set.
     static constexpr uint8_t rx_complete    = 0x10;
+    //! Double buffers are used for streaming if this flag is set.
+    static constexpr uint8_t mode_stream    = 0x20;
+    //! Streaming xfer is in progress if this flag is set.
+    static constexpr uint8_t stream_on      = 0x40;
 
     handler_fn      m_event_handler; //! Handler passed via set_handler().
     union
     {
         const uint8_t   *buf;        //! Transmit buffer.
-        uint8_t          byte;       //! Byte to transmit.
+        uint16_t         word;       //! Byte to transmit, repeated for 16-bit frames.
     } m_tx;
 
     size_t          m_tx_size;       //! TX buffer size.
     uint8_t         *m_rx;           //! Recieve buffer.
     size_t          m_rx_size;       //! RX buffer size.
     uint8_t         m_status;        //! Represents bus status.
+    const uint8_t   *m_tx1;          //! Second transmit buffer, streaming mode.
+    uint8_t         *m_rx1;          //! Second receive buffer, streaming mode.
+    size_t          m_streamed;      //! Bytes streamed since do_stream().
+    uint16_t        m_presc;         //! Prescaler currently in use.
+
+    //! Bus object, served by IRQ entry. Only one object of a given bus can exist.
+    static spi_bus  *m_instance;
 };
 
+template< class spi_config >
+spi_bus< spi_config > *spi_bus< spi_config >::m_instance{nullptr};
+
 template< class spi_config >
 spi_bus< spi_config >::spi_bus()
-    :m_event_handler{false}
+    :m_event_handler{}
     ,m_tx{nullptr}
     ,m_tx_size{0}
     ,m_rx{nullptr}
     ,m_rx_size{0}
     ,m_status{0}
+    ,m_tx1{nullptr}
+    ,m_rx1{nullptr}
+    ,m_streamed{0}
+    ,m_presc{0}
 {
 
 }
@@ -206,33 +371,12 @@ ecl::err spi_bus< spi_config >::init()
     constexpr auto init_const_obj = spi_config::m_init_obj;
     auto init_obj = init_const_obj;
 
-    // Current clock on corresponding bus
-    auto apb_clk = pick_pclk();
-
-    // To calculate closest supported clock:
-    uint16_t quotient = apb_clk / spi_config::m_clk;
-
-    // Prescaler has a range from 2 to 256
-    if (quotient < 2) {
-        quotient = 2;
-    } else if (quotient > 256) {
-        quotient = 256;
-    }
-
-    // Divider values maps to prescaler according to
-    // binary logarithm in following way:
-    // Quo   Log2   Prescaler
-    // 2     1      0   (0b00)
-    // 4     2      1   (0b01)
-    // 8     3      2   (0b10)
-    // 16    4      3   (0b11)
-    // So conversion formula will look like:
-    // prescaler = log2(divider) - 1;
-    // Using clz() is more efficient way to do
-    // it and covers case when quotient is not
-    // power of two value.
-    uint16_t presc = ((32 - 1 - __builtin_clz(quotient)) - 1) << 3;
+    auto presc = pick_prescaler(spi_config::m_clk);
     init_obj.SPI_BaudRatePrescaler = presc;
+    m_presc = presc;
+
+    ecl_assert(!m_instance || m_instance == this);
+    m_instance = this;
 
     rcc_fn(rcc_periph, ENABLE);
     SPI_Init(spi, &init_obj);
@@ -274,7 +418,7 @@ void spi_bus< spi_config >::set_tx(size_t size, uint8_t fill_byte)
 
     m_status    |= mode_fill;
     m_status    &= ~(tx_hidden);
-    m_tx.byte   = fill_byte;
+    m_tx.word   = fill_byte | (fill_byte << 8);
     m_tx_size   = size;
 }
 
@@ -311,7 +455,9 @@ void spi_bus< spi_config >::set_handler(const handler_fn &handler)
 template< class spi_config >
 void spi_bus< spi_config >::reset_buffers()
 {
-    m_status    &= ~(mode_fill);
+    m_status    &= ~(mode_fill | mode_stream);
+    m_tx1       = nullptr;
+    m_rx1       = nullptr;
     m_tx.buf    = nullptr;
     m_tx_size   = 0;
     m_rx        = nullptr;
@@ -335,6 +481,16 @@ ecl::err spi_bus< spi_config >::do_xfer()
         return err::nobufs;
     }
 
+    // Double buffers are set, do_stream() must be used instead
+    if (m_status & mode_stream) {
+        return err::inval;
+    }
+
+    if (poll_suitable()) {
+        poll_xfer();
+        return ecl::err::ok;
+    }
+
     // TODO: check if buffers are the same as in previous transacuib
     // If so, do not reinitialize DMA but rather just update a data counter.
 
@@ -345,6 +501,62 @@ ecl::err spi_bus< spi_config >::do_xfer()
     //    while (SPI_I2S_GetFlagStatus(spi, SPI_FLAG_BSY) == SET)
     //    {}
 
+    auto rc = lease_dma();
+    if (is_error(rc)) {
+        return rc;
+    }
+
+    prepare_tx();
+    prepare_rx();
+    start_xfer();
+
+    return ecl::err::ok;
+}
+
+template< class spi_config >
+void spi_bus< spi_config >::set_double_buffers(const uint8_t *tx0, const uint8_t *tx1,
+                                               uint8_t *rx0, uint8_t *rx1, size_t size)
+{
+    if (!(m_status & inited)) {
+        return;
+    }
+
+    reset_buffers();
+    set_tx(tx0, size);
+    set_rx(rx0, size);
+
+    m_tx1       = tx1 ? tx1 : tx0;
+    m_rx1       = rx1 ? rx1 : rx0;
+    m_status    |= mode_stream;
+}
+
+template< class spi_config >
+ecl::err spi_bus< spi_config >::do_stream()
+{
+    if (!(m_status & inited)) {
+        return err::perm;
+    }
+
+    if (!(m_status & mode_stream)) {
+        return err::inval;
+    }
+
+    if (m_status & stream_on) {
+        return err::busy;
+    }
+
+    if (!valid_sizes()) {
+        return err::nobufs;
+    }
+
+    auto rc = lease_dma();
+    if (is_error(rc)) {
+        return rc;
+    }
+
+    m_streamed  = 0;
+    m_status    |= stream_on;
+
     prepare_tx();
     prepare_rx();
     start_xfer();
@@ -352,11 +564,168 @@ ecl::err spi_bus< spi_config >::do_xfer()
     return ecl::err::ok;
 }
 
+template< class spi_config >
+ecl::err spi_bus< spi_config >::stop_stream()
+{
+    if (!(m_status & stream_on)) {
+        return err::perm;
+    }
+
+    constexpr auto tx_dma   = dma::get_stream< spi_config::m_dma_tx_stream >();
+    constexpr auto rx_dma   = dma::get_stream< spi_config::m_dma_rx_stream >();
+    constexpr auto rx_irqn  = dma::get_irqn< spi_config::m_dma_rx_stream >();
+    constexpr auto tx_irqn  = dma::get_irqn< spi_config::m_dma_tx_stream >();
+    constexpr auto spi      = pick_spi();
+
+    // Prevent stream events from being delivered while streams are stopped
+    IRQ_manager::mask(tx_irqn);
+
+    if (!spi_config::m_tx_only) {
+        IRQ_manager::mask(rx_irqn);
+    }
+
+    dma::disable< spi_config::m_dma_tx_stream >();
+    DMA_DeInit(tx_dma);
+
+    if (!spi_config::m_tx_only) {
+        dma::disable< spi_config::m_dma_rx_stream >();
+        DMA_DeInit(rx_dma);
+    }
+
+    ecl::regs::clear< rxdmaen, txdmaen >(spi);
+
+    if (!spi_config::m_tx_only) {
+        IRQ_manager::clear(rx_irqn);
+        IRQ_manager::unmask(rx_irqn);
+    }
+
+    IRQ_manager::clear(tx_irqn);
+    IRQ_manager::unmask(tx_irqn);
+
+    release_dma();
+
+    m_status &= ~(stream_on);
+
+    // Streaming is over, same as regular xfer does.
+    m_event_handler(channel::meta, event::tc, m_streamed);
+
+    return ecl::err::ok;
+}
+
+template< class spi_config >
+ecl::err spi_bus< spi_config >::set_clock(uint32_t clk)
+{
+    if (!clk) {
+        return err::inval;
+    }
+
+    if (!(m_status & inited)) {
+        return err::perm;
+    }
+
+    if (m_status & stream_on) {
+        return err::busy;
+    }
+
+    auto presc = pick_prescaler(clk);
+
+    // Reconfiguration is not free, avoid it if possible
+    if (presc == m_presc) {
+        return err::ok;
+    }
+
+    constexpr auto spi = pick_spi();
+
+    // Baud rate must not be changed while SPI is enabled
+    SPI_Cmd(spi, DISABLE);
+    spi->CR1 = (spi->CR1 & ~SPI_CR1_BR) | presc;
+    SPI_Cmd(spi, ENABLE);
+
+    m_presc = presc;
+
+    return err::ok;
+}
+
+template< class spi_config >
+ecl::err spi_bus< spi_config >::set_mode(uint16_t cpol, uint16_t cpha)
+{
+    if (!IS_SPI_CPOL(cpol) || !IS_SPI_CPHA(cpha)) {
+        return err::inval;
+    }
+
+    if (!(m_status & inited)) {
+        return err::perm;
+    }
+
+    if (m_status & stream_on) {
+        return err::busy;
+    }
+
+    constexpr auto spi = pick_spi();
+
+    // Mode must not be changed while SPI is enabled
+    SPI_Cmd(spi, DISABLE);
+    spi->CR1 = (spi->CR1 & ~(SPI_CR1_CPOL | SPI_CR1_CPHA)) | cpol | cpha;
+    SPI_Cmd(spi, ENABLE);
+
+    return err::ok;
+}
+
+template< class spi_config >
+ecl::err spi_bus< spi_config >::recover()
+{
+    if (!(m_status & inited)) {
+        return err::perm;
+    }
+
+    constexpr auto tx_dma   = dma::get_stream< spi_config::m_dma_tx_stream >();
+    constexpr auto rx_dma   = dma::get_stream< spi_config::m_dma_rx_stream >();
+    constexpr auto spi      = pick_spi();
+    constexpr auto mode     = spi_config::m_init_obj.SPI_Mode;
+
+    // Failed xfer may leave streams in any state
+    dma::disable< spi_config::m_dma_tx_stream >();
+    DMA_DeInit(tx_dma);
+
+    if (!spi_config::m_tx_only) {
+        dma::disable< spi_config::m_dma_rx_stream >();
+        DMA_DeInit(rx_dma);
+    }
+
+    ecl::regs::clear< rxdmaen, txdmaen >(spi);
+
+    // Overrun is cleared by reading DR and then SR. Mode fault is cleared by
+    // reading SR and then writing CR1, but it drops master mode as well.
+    SPI_Cmd(spi, DISABLE);
+    (void) spi->DR;
+    (void) spi->SR;
+    spi->CR1 |= mode;
+    SPI_Cmd(spi, ENABLE);
+
+    return err::ok;
+}
+
 //------------------------------------------------------------------------------
 
+template< class spi_config >
+constexpr size_t spi_bus< spi_config >::frames(size_t size)
+{
+    return spi_config::m_wide ? (size >> 1) : size;
+}
+
 template< class spi_config >
 bool spi_bus< spi_config >::valid_sizes()
 {
+    // Nothing can be received through single TX line
+    if (spi_config::m_tx_only && m_rx_size) {
+        return false;
+    }
+
+    // Frame can't be split
+    if (spi_config::m_wide && ((m_tx_size | m_rx_size) & 1)) {
+        return false;
+    }
+
     // Bus is in full-duplex mode. Different sizes are not permitted.
     if (m_tx_size && m_rx_size) {
         if (m_tx_size != m_rx_size) {
@@ -383,7 +752,7 @@ void spi_bus< spi_config >::prepare_tx()
 
         m_status    |= mode_fill;
         m_tx_size   = m_rx_size;
-        m_tx.byte   = 0xff;
+        m_tx.word   = 0xffff;
     }
 
     m_status &= ~(tx_complete);
@@ -399,18 +768,44 @@ void spi_bus< spi_config >::prepare_tx()
     dma_init.DMA_PeripheralBaseAddr  = reinterpret_cast< uint32_t >(&spi->DR);
     dma_init.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
 
+    if (spi_config::m_wide) {
+        // Wider beats move the same data with half as many DMA requests
+        dma_init.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+        dma_init.DMA_MemoryDataSize     = DMA_MemoryDataSize_HalfWord;
+    }
+
     if (m_status & mode_fill) {
         dma_init.DMA_MemoryInc       = DMA_MemoryInc_Disable;
-        dma_init.DMA_Memory0BaseAddr = reinterpret_cast< uint32_t >(&m_tx.byte);
+        dma_init.DMA_Memory0BaseAddr = reinterpret_cast< uint32_t >(&m_tx.word);
     } else {
         dma_init.DMA_MemoryInc       = DMA_MemoryInc_Enable;
         dma_init.DMA_Memory0BaseAddr = reinterpret_cast< uint32_t >(m_tx.buf);
     }
 
-    dma_init.DMA_BufferSize          = m_tx_size;
+    dma_init.DMA_BufferSize          = frames(m_tx_size);
+
+    if (m_status & mode_stream) {
+        // Double buffer mode requires circular mode to be set
+        dma_init.DMA_Mode            = DMA_Mode_Circular;
+    }
+
+    // In streaming mode events are bound to the RX channel, if present
+    if (!(m_status & mode_stream) || !m_rx_size) {
+        dma::enable_irq< spi_config::m_dma_tx_stream, DMA_IT_TC >();
+    }
+
+    // Errors are reported in any mode
+    dma::enable_irq< spi_config::m_dma_tx_stream, DMA_IT_TE >();
 
-    DMA_ITConfig(tx_dma, DMA_IT_TC, ENABLE);
     DMA_Init(tx_dma, &dma_init);
+
+    if (m_status & mode_stream) {
+        if (m_status & mode_fill) {
+            dma::enable_double_buffer< spi_config::m_dma_tx_stream >(&m_tx.word);
+        } else {
+            dma::enable_double_buffer< spi_config::m_dma_tx_stream >(m_tx1);
+        }
+    }
 }
 
 template< class spi_config >
@@ -435,75 +830,238 @@ void spi_bus< spi_config >::prepare_rx()
     dma_init.DMA_PeripheralBaseAddr  = reinterpret_cast< uint32_t >(&spi->DR);
     dma_init.DMA_MemoryInc           = DMA_MemoryInc_Enable;
     dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(m_rx);
-    dma_init.DMA_BufferSize          = m_rx_size;
+    dma_init.DMA_BufferSize          = frames(m_rx_size);
+
+    if (spi_config::m_wide) {
+        dma_init.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+        dma_init.DMA_MemoryDataSize     = DMA_MemoryDataSize_HalfWord;
+    }
+
+    if (m_status & mode_stream) {
+        // Double buffer mode requires circular mode to be set
+        dma_init.DMA_Mode            = DMA_Mode_Circular;
+    }
 
-    DMA_ITConfig(rx_dma, DMA_IT_TC, ENABLE);
+    dma::enable_irq< spi_config::m_dma_rx_stream, DMA_IT_TC | DMA_IT_TE >();
     DMA_Init(rx_dma, &dma_init);
+
+    if (m_status & mode_stream) {
+        dma::enable_double_buffer< spi_config::m_dma_rx_stream >(m_rx1);
+    }
 }
 
 template< class spi_config >
 void spi_bus< spi_config >::start_xfer()
 {
-    constexpr auto rx_dma = dma::get_stream< spi_config::m_dma_rx_stream >();
-    constexpr auto tx_dma = dma::get_stream< spi_config::m_dma_tx_stream >();
     constexpr auto spi    = pick_spi();
 
     // After all directions configured, streams may be enabled
     if (m_tx_size) {
-        DMA_Cmd(tx_dma, ENABLE);
+        dma::enable< spi_config::m_dma_tx_stream >();
     }
 
     if (m_rx_size) {
-        DMA_Cmd(rx_dma, ENABLE);
+        dma::enable< spi_config::m_dma_rx_stream >();
     }
 
     // Enable interrupt request from SPI periphery
-    SPI_I2S_DMACmd(spi, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx , ENABLE);
+    if (m_rx_size) {
+        ecl::regs::set< rxdmaen, txdmaen >(spi);
+    } else {
+        ecl::regs::set< txdmaen >(spi);
+    }
+}
+
+template< class spi_config >
+bool spi_bus< spi_config >::poll_suitable() const
+{
+    return m_tx_size <= spi_config::m_poll_max && m_rx_size <= spi_config::m_poll_max;
+}
+
+template< class spi_config >
+void spi_bus< spi_config >::poll_xfer()
+{
+    constexpr auto spi = pick_spi();
+
+    // Sizes are equal in full-duplex, see valid_sizes()
+    size_t size = m_tx_size ? m_tx_size : m_rx_size;
+    bool fill = m_status & (mode_fill | tx_hidden);
+    uint16_t fill_word = (m_status & tx_hidden) ? 0xffff : m_tx.word;
+
+    if (!spi_config::m_tx_only) {
+        // Previous TX-only xfer leaves stale frame and overrun behind.
+        // Reading DR and then SR clears both.
+        (void) spi->DR;
+        (void) spi->SR;
+    }
+
+    for (size_t i = 0; i < frames(size); ++i) {
+        uint16_t frame;
+
+        if (fill) {
+            frame = fill_word;
+        } else if (spi_config::m_wide) {
+            frame = m_tx.buf[i * 2] | (m_tx.buf[i * 2 + 1] << 8);
+        } else {
+            frame = m_tx.buf[i];
+        }
+
+        while (!(spi->SR & SPI_I2S_FLAG_TXE)) { }
+        spi->DR = frame;
+
+        if (spi_config::m_tx_only) {
+            continue;
+        }
+
+        // Frame is received at the same time it is sent, DR is read even
+        // if nothing is requested, so overrun is never raised
+        while (!(spi->SR & SPI_I2S_FLAG_RXNE)) { }
+        frame = spi->DR;
+
+        if (m_rx_size) {
+            if (spi_config::m_wide) {
+                m_rx[i * 2] = frame & 0xff;
+                m_rx[i * 2 + 1] = frame >> 8;
+            } else {
+                m_rx[i] = frame;
+            }
+        }
+    }
+
+    // Last frame must be shifted out before xfer is deemed complete,
+    // otherwise chip-select can be released too early
+    while (!(spi->SR & SPI_I2S_FLAG_TXE)) { }
+    while (spi->SR & SPI_I2S_FLAG_BSY) { }
+
+    // Events are the same as in DMA mode, see irq_handler()
+    m_status |= tx_complete | rx_complete;
+
+    if (m_tx_size && !(m_status & tx_hidden)) {
+        m_event_handler(channel::tx, event::tc, m_tx_size);
+    }
+
+    if (m_rx_size) {
+        m_event_handler(channel::rx, event::tc, m_rx_size);
+    }
+
+    // Handler is allowed to start next xfer, see irq_handler()
+    m_event_handler(channel::meta, event::tc, size);
+}
+
+template< class spi_config >
+void spi_bus< spi_config >::xfer_failed()
+{
+    constexpr auto tx_dma   = dma::get_stream< spi_config::m_dma_tx_stream >();
+    constexpr auto rx_dma   = dma::get_stream< spi_config::m_dma_rx_stream >();
+    constexpr auto rx_irqn  = dma::get_irqn< spi_config::m_dma_rx_stream >();
+    constexpr auto tx_irqn  = dma::get_irqn< spi_config::m_dma_tx_stream >();
+    constexpr auto spi      = pick_spi();
+    constexpr size_t frame  = spi_config::m_wide ? 2 : 1;
+
+    // Counters must be read before streams are reset
+    size_t sent     = m_tx_size - dma::get_counter< spi_config::m_dma_tx_stream >() * frame;
+    size_t received = m_rx_size
+            ? m_rx_size - dma::get_counter< spi_config::m_dma_rx_stream >() * frame
+            : 0;
+
+    dma::disable< spi_config::m_dma_tx_stream >();
+    DMA_DeInit(tx_dma);
+
+    if (!spi_config::m_tx_only) {
+        dma::disable< spi_config::m_dma_rx_stream >();
+        DMA_DeInit(rx_dma);
+    }
+
+    ecl::regs::clear< rxdmaen, txdmaen >(spi);
+
+    if (!spi_config::m_tx_only) {
+        IRQ_manager::clear(rx_irqn);
+        IRQ_manager::unmask(rx_irqn);
+    }
+
+    IRQ_manager::clear(tx_irqn);
+    IRQ_manager::unmask(tx_irqn);
+
+    release_dma();
+
+    // Unfinished channels are aborted along with the failed one
+    if (!(m_status & tx_complete) && !(m_status & tx_hidden)) {
+        m_event_handler(channel::tx, event::err, sent);
+    }
+
+    if (!(m_status & rx_complete)) {
+        m_event_handler(channel::rx, event::err, received);
+    }
+
+    m_status |= tx_complete | rx_complete;
+
+    // SPI itself is recovered by the user, see recover()
+    m_event_handler(channel::meta, event::tc, m_tx_size);
+}
+
+template< class spi_config >
+void spi_bus< spi_config >::irq_entry()
+{
+    m_instance->irq_handler();
 }
 
 template< class spi_config >
 void spi_bus< spi_config >::irq_handler()
 {
+    if (m_status & mode_stream) {
+        stream_irq_handler();
+        return;
+    }
+
     constexpr auto tx_dma   = dma::get_stream< spi_config::m_dma_tx_stream >();
     constexpr auto rx_dma   = dma::get_stream< spi_config::m_dma_rx_stream >();
 
     constexpr auto tx_tc_if = dma::get_tc_if< spi_config::m_dma_tx_stream >();
     constexpr auto rx_tc_if = dma::get_tc_if< spi_config::m_dma_rx_stream >();
+    constexpr auto tx_te_if = dma::get_te_if< spi_config::m_dma_tx_stream >();
+    constexpr auto rx_te_if = dma::get_te_if< spi_config::m_dma_rx_stream >();
 
     constexpr auto spi      = pick_spi();
 
+    // Stream is disabled by hardware on error, xfer will never complete
+    if (dma::get_it_status< spi_config::m_dma_tx_stream, tx_te_if >()
+            || (!spi_config::m_tx_only
+                && dma::get_it_status< spi_config::m_dma_rx_stream, rx_te_if >())) {
+        dma::clear_flags< spi_config::m_dma_tx_stream, tx_te_if >();
+
+        if (!spi_config::m_tx_only) {
+            dma::clear_flags< spi_config::m_dma_rx_stream, rx_te_if >();
+        }
+
+        xfer_failed();
+        return;
+    }
 
     if (!(m_status & tx_complete)) {
-        auto tx_tc = DMA_GetITStatus(tx_dma, tx_tc_if);
+        auto tx_tc = dma::get_it_status< spi_config::m_dma_tx_stream, tx_tc_if >();
 
         if (tx_tc) {
             // Complete TX transaction
-            constexpr auto tx_tc_flag = dma::get_tc_flag< spi_config::m_dma_tx_stream >();
-
             if (!(m_status & tx_hidden)) {
                 m_event_handler(channel::tx, event::tc, m_tx_size);
             }
 
-            DMA_ClearFlag(tx_dma, tx_tc_flag);
-            DMA_ClearITPendingBit(tx_dma, tx_tc_if);
-            DMA_ITConfig(tx_dma, DMA_IT_TC, DISABLE);
+            dma::clear_flags< spi_config::m_dma_tx_stream, tx_tc_if >();
+            dma::disable_irq< spi_config::m_dma_tx_stream, DMA_IT_TC >();
 
             m_status |= tx_complete;
         }
     }
 
-    auto rx_tc = DMA_GetITStatus(rx_dma, rx_tc_if);
-
     if (!(m_status & rx_complete)) {
+        auto rx_tc = dma::get_it_status< spi_config::m_dma_rx_stream, rx_tc_if >();
+
         if (rx_tc) {
             // Complete TX transaction
-            constexpr auto rx_tc_flag = dma::get_tc_flag< spi_config::m_dma_rx_stream >();
-
             m_event_handler(channel::rx, event::tc, m_rx_size);
 
-            DMA_ClearFlag(rx_dma, rx_tc_flag);
-            DMA_ClearITPendingBit(rx_dma, rx_tc_if);
-            DMA_ITConfig(rx_dma, DMA_IT_TC, DISABLE);
+            dma::clear_flags< spi_config::m_dma_rx_stream, rx_tc_if >();
+            dma::disable_irq< spi_config::m_dma_rx_stream, DMA_IT_TC >();
 
             m_status |= rx_complete;
         }
@@ -513,123 +1071,228 @@ void spi_bus< spi_config >::irq_handler()
         constexpr auto rx_irqn = dma::get_irqn< spi_config::m_dma_rx_stream >();
         constexpr auto tx_irqn = dma::get_irqn< spi_config::m_dma_tx_stream >();
 
-        DMA_Cmd(tx_dma, DISABLE);
+        dma::disable< spi_config::m_dma_tx_stream >();
         DMA_DeInit(tx_dma);
 
-        DMA_Cmd(rx_dma, DISABLE);
-        DMA_DeInit(rx_dma);
+        if (!m_rx_size) {
+            // DMA TX completion means only that last frame is placed
+            // to the SPI. It must be shifted out before xfer is deemed
+            // complete, otherwise chip-select can be released too early.
+            while (!(spi->SR & SPI_I2S_FLAG_TXE)) { }
+            while (spi->SR & SPI_I2S_FLAG_BSY) { }
+        }
+
+        if (!spi_config::m_tx_only) {
+            dma::disable< spi_config::m_dma_rx_stream >();
+            DMA_DeInit(rx_dma);
+        }
 
-        SPI_I2S_DMACmd(spi, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+        ecl::regs::clear< rxdmaen, txdmaen >(spi);
 
         // Clear/enable NVIC interrupts
-        IRQ_manager::clear(rx_irqn);
-        IRQ_manager::unmask(rx_irqn);
+        if (!spi_config::m_tx_only) {
+            IRQ_manager::clear(rx_irqn);
+            IRQ_manager::unmask(rx_irqn);
+        }
+
         IRQ_manager::clear(tx_irqn);
         IRQ_manager::unmask(tx_irqn);
 
-        // All transfers comepleted
+        // Streams are free, until next xfer
+        release_dma();
+
+        // All transfers comepleted.
+        // Handler is allowed to start next xfer right from here (for example,
+        // when generic bus executes a segment chain), thus bus state must not
+        // be touched after this call.
         m_event_handler(channel::meta, event::tc, m_tx_size);
     }
 }
 
 template< class spi_config >
-constexpr auto spi_bus< spi_config >::pick_spi()
+void spi_bus< spi_config >::stream_irq_handler()
 {
-    switch (spi_config::m_dev) {
-    case spi_device::bus_1:
-        return SPI1;
-    case spi_device::bus_2:
-        return SPI2;
-    case spi_device::bus_3:
-        return SPI3;
-    case spi_device::bus_4:
-        return SPI4;
-    case spi_device::bus_5:
-        return SPI5;
-    case spi_device::bus_6:
-        return SPI6;
-    default:
-        // TODO: clarfy
-        return static_cast< decltype(SPI1) >(nullptr);
+    constexpr auto tx_tc_if = dma::get_tc_if< spi_config::m_dma_tx_stream >();
+    constexpr auto rx_tc_if = dma::get_tc_if< spi_config::m_dma_rx_stream >();
+
+    constexpr auto tx_te_if = dma::get_te_if< spi_config::m_dma_tx_stream >();
+    constexpr auto rx_te_if = dma::get_te_if< spi_config::m_dma_rx_stream >();
+
+    constexpr auto rx_irqn  = dma::get_irqn< spi_config::m_dma_rx_stream >();
+    constexpr auto tx_irqn  = dma::get_irqn< spi_config::m_dma_tx_stream >();
+
+    if (dma::get_it_status< spi_config::m_dma_tx_stream, tx_te_if >()
+            || (!spi_config::m_tx_only
+                && dma::get_it_status< spi_config::m_dma_rx_stream, rx_te_if >())) {
+        dma::clear_flags< spi_config::m_dma_tx_stream, tx_te_if >();
+
+        if (!spi_config::m_tx_only) {
+            dma::clear_flags< spi_config::m_dma_rx_stream, rx_te_if >();
+        }
+
+        // Stream can't proceed. It is stopped as if user did it,
+        // IRQs are enabled back there as well.
+        m_event_handler(m_rx_size ? channel::rx : channel::tx, event::err, m_streamed);
+        stop_stream();
+        return;
+    }
+
+    // Only one channel generates events, see prepare_tx()
+    if (m_rx_size) {
+        if (dma::get_it_status< spi_config::m_dma_rx_stream, rx_tc_if >()) {
+            dma::clear_flags< spi_config::m_dma_rx_stream, rx_tc_if >();
+            stream_event< spi_config::m_dma_rx_stream >(channel::rx, m_rx_size);
+        }
+    } else {
+        if (dma::get_it_status< spi_config::m_dma_tx_stream, tx_tc_if >()) {
+            dma::clear_flags< spi_config::m_dma_tx_stream, tx_tc_if >();
+            stream_event< spi_config::m_dma_tx_stream >(channel::tx, m_tx_size);
+        }
+    }
+
+    // Streams are left running, so IRQs must be enabled back
+    if (!spi_config::m_tx_only) {
+        IRQ_manager::clear(rx_irqn);
+        IRQ_manager::unmask(rx_irqn);
     }
+
+    IRQ_manager::clear(tx_irqn);
+    IRQ_manager::unmask(tx_irqn);
 }
 
 template< class spi_config >
-constexpr auto spi_bus< spi_config >::pick_rcc()
+template< std::uintptr_t dma_stream >
+void spi_bus< spi_config >::stream_event(channel ch, size_t size)
 {
-    // TODO: comments
-    switch (spi_config::m_dev) {
-    case spi_device::bus_1:
-        return RCC_APB2Periph_SPI1;
-    case spi_device::bus_2:
-        return RCC_APB1Periph_SPI2;
-    case spi_device::bus_3:
-        return RCC_APB1Periph_SPI3;
-    case spi_device::bus_4:
-        return RCC_APB2Periph_SPI4;
-    case spi_device::bus_5:
-        return RCC_APB2Periph_SPI5;
-    case spi_device::bus_6:
-        return RCC_APB2Periph_SPI6;
-    default:
-        // TODO: clarify
-        return static_cast< decltype(RCC_APB2Periph_SPI6) >(-1);
-    }
+    // At this point DMA already switched to the other memory target,
+    // thus completed buffer is the one that is not used now.
+    auto type = dma::get_memory_target< dma_stream >() ? event::ht : event::tc;
+
+    m_streamed += size;
+    m_event_handler(ch, type, m_streamed);
 }
 
 template< class spi_config >
-constexpr auto spi_bus< spi_config >::pick_rcc_fn()
+constexpr typename spi_bus< spi_config >::periph_info spi_bus< spi_config >::pick_periph()
 {
     // APB1 - SPI3 SPI2
     // APB2 - SPI5 SPI6 SPI1 SPI4
-    switch (spi_config::m_dev) {
-    case spi_device::bus_1:
-    case spi_device::bus_5:
-    case spi_device::bus_4:
-    case spi_device::bus_6:
-        return RCC_APB2PeriphClockCmd;
-    case spi_device::bus_2:
-    case spi_device::bus_3:
-        return RCC_APB1PeriphClockCmd;
-    default:
-        // TODO: clarify
-        return static_cast< decltype(&RCC_APB2PeriphClockCmd) >(nullptr);
-    }
+    constexpr auto spis = make_lookup_table< spi_device, periph_info >({
+        { spi_device::bus_1, { SPI1_BASE, RCC_APB2Periph_SPI1, true  } },
+        { spi_device::bus_2, { SPI2_BASE, RCC_APB1Periph_SPI2, false } },
+        { spi_device::bus_3, { SPI3_BASE, RCC_APB1Periph_SPI3, false } },
+        { spi_device::bus_4, { SPI4_BASE, RCC_APB2Periph_SPI4, true  } },
+        { spi_device::bus_5, { SPI5_BASE, RCC_APB2Periph_SPI5, true  } },
+        { spi_device::bus_6, { SPI6_BASE, RCC_APB2Periph_SPI6, true  } },
+    });
+
+    static_assert(spis.contains(spi_config::m_dev), "SPI device is not supported");
+
+    return spis[spi_config::m_dev];
+}
+
+template< class spi_config >
+constexpr auto spi_bus< spi_config >::pick_spi()
+{
+    return reinterpret_cast< SPI_TypeDef* >(pick_periph().base);
+}
+
+template< class spi_config >
+constexpr auto spi_bus< spi_config >::pick_rcc()
+{
+    return pick_periph().rcc;
+}
+
+template< class spi_config >
+constexpr auto spi_bus< spi_config >::pick_rcc_fn()
+{
+    return pick_periph().apb2 ? RCC_APB2PeriphClockCmd : RCC_APB1PeriphClockCmd;
+}
+
+template< class spi_config >
+constexpr uint32_t spi_bus< spi_config >::pick_pclk()
+{
+    // Bus clocks are fixed at build time, see platform/clock.hpp
+    return pick_periph().apb2 ? ecl::clock::pclk2 : ecl::clock::pclk1;
 }
 
 template< class spi_config >
-auto spi_bus< spi_config >::pick_pclk()
+uint16_t spi_bus< spi_config >::pick_prescaler(uint32_t clk)
 {
-    RCC_ClocksTypeDef clkcfg;
-    RCC_GetClocksFreq(&clkcfg);
+    // Current clock on corresponding bus
+    auto apb_clk = pick_pclk();
+
+    // To calculate closest supported clock, that not exceeds requested one,
+    // quotient is rounded up.
+    auto quotient = (apb_clk + clk - 1) / clk;
 
-    switch (spi_config::m_dev) {
-    case spi_device::bus_1:
-    case spi_device::bus_5:
-    case spi_device::bus_4:
-    case spi_device::bus_6:
-        return clkcfg.PCLK2_Frequency;
-    case spi_device::bus_2:
-    case spi_device::bus_3:
-        return clkcfg.PCLK1_Frequency;
-    default:
-        // TODO: clarify
-        return static_cast< decltype(clkcfg.PCLK1_Frequency) >(-1);
+    // Prescaler has a range from 2 to 256
+    if (quotient < 2) {
+        quotient = 2;
+    } else if (quotient > 256) {
+        quotient = 256;
     }
+
+    // Divider values maps to prescaler according to
+    // binary logarithm in following way:
+    // Quo   Log2   Prescaler
+    // 2     1      0   (0b00)
+    // 4     2      1   (0b01)
+    // 8     3      2   (0b10)
+    // 16    4      3   (0b11)
+    // So conversion formula will look like:
+    // prescaler = log2(divider) - 1;
+    // Using clz() is more efficient way to do it. When quotient is not
+    // power of two value, binary logarithm is rounded up, thus
+    // resulting clock is never greater than requested.
+    uint16_t presc = ((32 - __builtin_clz(quotient - 1)) - 1) << 3;
+
+    return presc;
 }
 
 template< class spi_config >
 void spi_bus< spi_config >::init_dma()
 {
-    dma::init_rcc< spi_config::m_dma_rx_stream >();
     dma::init_rcc< spi_config::m_dma_tx_stream >();
 
-    auto handler = [this]() {
-        this->irq_handler();
-    };
+    // RX stream is left untouched if SPI can't receive anything
+    if (!spi_config::m_tx_only) {
+        dma::init_rcc< spi_config::m_dma_rx_stream >();
+    }
 
-    dma::subscribe_irq< spi_config::m_dma_rx_stream >(handler);
-    dma::subscribe_irq< spi_config::m_dma_tx_stream >(handler);
+    // IRQs are subscribed when streams are leased, see lease_dma()
+}
+
+template< class spi_config >
+ecl::err spi_bus< spi_config >::lease_dma()
+{
+    using tx_lease = dma::stream_lease< spi_config::m_dma_tx_stream >;
+    using rx_lease = dma::stream_lease< spi_config::m_dma_rx_stream >;
+
+    auto rc = tx_lease::acquire(this, irq_entry);
+    if (is_error(rc)) {
+        return rc;
+    }
+
+    if (!spi_config::m_tx_only) {
+        rc = rx_lease::acquire(this, irq_entry);
+        if (is_error(rc)) {
+            tx_lease::release();
+            return rc;
+        }
+    }
+
+    return ecl::err::ok;
+}
+
+template< class spi_config >
+void spi_bus< spi_config >::release_dma()
+{
+    dma::stream_lease< spi_config::m_dma_tx_stream >::release();
+
+    if (!spi_config::m_tx_only) {
+        dma::stream_lease< spi_config::m_dma_rx_stream >::release();
+    }
 }
 
 
@@ -0,0 +1,322 @@
+#ifndef PLATFORM_TIMEBASE_HPP_
+#define PLATFORM_TIMEBASE_HPP_
+
+//!
+//! \file
+//! \brief Microsecond timebase, driven by a 32-bit timer.
+//! TIM2 or TIM5 counts microseconds, free-running over whole 32-bit range,
+//! so timestamps wrap each 71 minutes. Differences of timestamps are exact
+//! as long as measured intervals are shorter, i.e.:
+//! \code
+//!     auto start = ecl::timebase::now_us();
+//!     do_something();
+//!     auto took = ecl::timebase::now_us() - start;
+//! \endcode
+//! Channels of the timer timestamp external events by input capture,
+//! without software latency. Capture pins must be configured to the
+//! timer's alternate function, i.e. by the pin table.
+//!
+
+#include <platform/irq_manager.hpp>
+#include <platform/clock.hpp>
+#include <platform/power.hpp>
+
+#include <ecl/err.hpp>
+
+#include <stm32f4xx_tim.h>
+#include <stm32f4xx_rcc.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace ecl
+{
+
+//!
+//! \brief Edge of input signal, which is captured.
+//!
+enum class capture_edge
+{
+    rising,
+    falling,
+    both,
+};
+
+//!
+//! \brief Microsecond timebase.
+//! All members are static: timer is shared by the whole firmware.
+//! \tparam timer Base address of the timer: TIM2_BASE or TIM5_BASE.
+//!
+template< std::uintptr_t timer = TIM5_BASE >
+class timebase_unit
+{
+    static_assert(timer == TIM2_BASE || timer == TIM5_BASE,
+                  "Only TIM2 and TIM5 have 32-bit counters");
+
+    static constexpr uint32_t timer_clk =
+        RCC_PCLK1_DIV == 1 ? clock::pclk1 : clock::pclk1 * 2;
+
+    static_assert(timer_clk % 1000000 == 0,
+                  "Timer clock must be a multiple of 1 MHz");
+
+public:
+    //! Handler of captured event, called from ISR with event timestamp.
+    using capture_handler = std::function< void(uint32_t timestamp) >;
+
+    //! Amount of capture channels.
+    static constexpr int channels = 4;
+
+    //!
+    //! \brief Starts the counter from zero.
+    //!
+    static void init();
+
+    //!
+    //! \brief Stops the counter and all captures.
+    //!
+    static void deinit();
+
+    //!
+    //! \brief Gets current time in microseconds since init().
+    //! Can be called from threads and ISRs.
+    //!
+    static uint32_t now_us();
+
+    //!
+    //! \brief Waits, spinning, for at least given time.
+    //! Intended for short protocol delays, use os::this_thread::sleep_for()
+    //! for longer ones, so other threads can run.
+    //! \param[in] us Microseconds to wait, below 2^31.
+    //!
+    static void delay_us(uint32_t us);
+
+    //!
+    //! \brief Starts timestamping edges of a channel input.
+    //! \param[in] channel  Channel number, 1 to 4.
+    //! \param[in] edge     Edge that is captured.
+    //! \param[in] handler  Handler of captured events.
+    //! \param[in] filter   Input filter, 0 to 15, see TIMx_CCMR.
+    //! \retval err::ok     Capture is started.
+    //! \retval err::inval  Invalid channel or filter.
+    //!
+    static err capture(int channel, capture_edge edge, capture_handler handler,
+                       uint8_t filter = 0);
+
+    //!
+    //! \brief Stops timestamping edges of a channel input.
+    //! \param[in] channel Channel number, 1 to 4.
+    //!
+    static void stop_capture(int channel);
+
+    //!
+    //! \brief Gets amount of events lost so far, because next edge was
+    //! captured before the previous one was handled.
+    //!
+    static size_t overcaptures();
+
+private:
+    //! Gets the timer.
+    static TIM_TypeDef *get_timer();
+
+    //! Gets IRQ of the timer.
+    static constexpr IRQn_Type get_irqn();
+
+    static void irq_handler();
+
+    static capture_handler          m_handlers[channels];   //!< Event handlers.
+    static std::atomic< size_t >    m_overcaptures;         //!< Lost events.
+};
+
+//! Microsecond timebase on TIM5.
+using timebase = timebase_unit<>;
+
+//------------------------------------------------------------------------------
+
+template< std::uintptr_t timer >
+typename timebase_unit< timer >::capture_handler
+timebase_unit< timer >::m_handlers[timebase_unit< timer >::channels];
+
+template< std::uintptr_t timer >
+std::atomic< size_t > timebase_unit< timer >::m_overcaptures{0};
+
+template< std::uintptr_t timer >
+void timebase_unit< timer >::init()
+{
+    auto tim = get_timer();
+
+    RCC_APB1PeriphClockCmd(timer == TIM2_BASE ? RCC_APB1Periph_TIM2 : RCC_APB1Periph_TIM5,
+                           ENABLE);
+
+    TIM_TimeBaseInitTypeDef init_struct;
+    TIM_TimeBaseStructInit(&init_struct);
+
+    init_struct.TIM_Prescaler       = timer_clk / 1000000 - 1;
+    init_struct.TIM_CounterMode     = TIM_CounterMode_Up;
+    init_struct.TIM_Period          = 0xffffffff;
+    init_struct.TIM_ClockDivision   = TIM_CKD_DIV1;
+
+    TIM_Cmd(tim, DISABLE);
+    // Update event is generated here, so prescaler is loaded at once
+    TIM_TimeBaseInit(tim, &init_struct);
+    TIM_SetCounter(tim, 0);
+
+    IRQ_manager::mask(get_irqn());
+    IRQ_manager::clear(get_irqn());
+    IRQ_manager::subscribe(get_irqn(), irq_handler);
+    IRQ_manager::unmask(get_irqn());
+
+    TIM_Cmd(tim, ENABLE);
+}
+
+template< std::uintptr_t timer >
+void timebase_unit< timer >::deinit()
+{
+    auto tim = get_timer();
+
+    IRQ_manager::mask(get_irqn());
+
+    TIM_Cmd(tim, DISABLE);
+    TIM_ITConfig(tim, TIM_IT_CC1 | TIM_IT_CC2 | TIM_IT_CC3 | TIM_IT_CC4, DISABLE);
+
+    IRQ_manager::unsubscribe(get_irqn());
+
+    for (auto &h : m_handlers) {
+        h = nullptr;
+    }
+
+    RCC_APB1PeriphClockCmd(timer == TIM2_BASE ? RCC_APB1Periph_TIM2 : RCC_APB1Periph_TIM5,
+                           DISABLE);
+}
+
+template< std::uintptr_t timer >
+uint32_t timebase_unit< timer >::now_us()
+{
+    return get_timer()->CNT;
+}
+
+template< std::uintptr_t timer >
+void timebase_unit< timer >::delay_us(uint32_t us)
+{
+    uint32_t start = now_us();
+
+    // Start is somewhere within a tick, so one more tick is waited
+    while (now_us() - start <= us) { }
+}
+
+template< std::uintptr_t timer >
+err timebase_unit< timer >::capture(int channel, capture_edge edge,
+                                    capture_handler handler, uint8_t filter)
+{
+    if (channel < 1 || channel > channels || filter > 0xf) {
+        return err::inval;
+    }
+
+    auto tim = get_timer();
+    uint16_t it = TIM_IT_CC1 << (channel - 1);
+
+    TIM_ITConfig(tim, it, DISABLE);
+
+    // Armed channel keeps the timer clocked, see platform/power.hpp
+    if (!m_handlers[channel - 1]) {
+        power::inhibit_stop();
+    }
+
+    m_handlers[channel - 1] = handler;
+
+    TIM_ICInitTypeDef ic_init;
+    TIM_ICStructInit(&ic_init);
+
+    ic_init.TIM_Channel     = TIM_Channel_1 + 4 * (channel - 1);
+    ic_init.TIM_ICPolarity  = edge == capture_edge::rising  ? TIM_ICPolarity_Rising :
+                              edge == capture_edge::falling ? TIM_ICPolarity_Falling :
+                                                              TIM_ICPolarity_BothEdge;
+    ic_init.TIM_ICSelection = TIM_ICSelection_DirectTI;
+    ic_init.TIM_ICPrescaler = TIM_ICPSC_DIV1;
+    ic_init.TIM_ICFilter    = filter;
+
+    TIM_ICInit(tim, &ic_init);
+
+    // Stale capture is not reported
+    TIM_ClearFlag(tim, it | (TIM_FLAG_CC1OF << (channel - 1)));
+    TIM_ITConfig(tim, it, ENABLE);
+
+    return err::ok;
+}
+
+template< std::uintptr_t timer >
+void timebase_unit< timer >::stop_capture(int channel)
+{
+    if (channel < 1 || channel > channels) {
+        return;
+    }
+
+    auto tim = get_timer();
+
+    TIM_ITConfig(tim, TIM_IT_CC1 << (channel - 1), DISABLE);
+    TIM_CCxCmd(tim, TIM_Channel_1 + 4 * (channel - 1), TIM_CCx_Disable);
+
+    if (m_handlers[channel - 1]) {
+        power::allow_stop();
+    }
+
+    m_handlers[channel - 1] = nullptr;
+}
+
+template< std::uintptr_t timer >
+size_t timebase_unit< timer >::overcaptures()
+{
+    return m_overcaptures;
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< std::uintptr_t timer >
+TIM_TypeDef *timebase_unit< timer >::get_timer()
+{
+    return reinterpret_cast< TIM_TypeDef * >(timer);
+}
+
+template< std::uintptr_t timer >
+constexpr IRQn_Type timebase_unit< timer >::get_irqn()
+{
+    return timer == TIM2_BASE ? TIM2_IRQn : TIM5_IRQn;
+}
+
+template< std::uintptr_t timer >
+void timebase_unit< timer >::irq_handler()
+{
+    auto tim = get_timer();
+    volatile uint32_t *ccr = &tim->CCR1;
+
+    for (int i = 0; i < channels; ++i) {
+        uint16_t it = TIM_IT_CC1 << i;
+        uint16_t of = TIM_FLAG_CC1OF << i;
+
+        if (TIM_GetITStatus(tim, it) == RESET) {
+            continue;
+        }
+
+        // Reading captured value clears the capture flag.
+        // Capture registers of channels are adjacent.
+        uint32_t timestamp = ccr[i];
+
+        if (TIM_GetFlagStatus(tim, of) != RESET) {
+            TIM_ClearFlag(tim, of);
+            ++m_overcaptures;
+        }
+
+        if (m_handlers[i]) {
+            m_handlers[i](timestamp);
+        }
+    }
+
+    IRQ_manager::clear(get_irqn());
+    IRQ_manager::unmask(get_irqn());
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_TIMEBASE_HPP_
@@ -9,11 +9,16 @@
 #include <platform/common/bus.hpp>
 #include <common/usart.hpp>
 #include <ecl/err.hpp>
+#include <ecl/assert.h>
+#include <ecl/lookup_table.hpp>
+#include <ecl/regs.hpp>
 
 #include <stm32f4xx_usart.h>
 #include <stm32f4xx_rcc.h>
 
 #include <platform/irq_manager.hpp>
+#include <platform/dma_device.hpp>
+#include <platform/dma_manager.hpp>
 
 #include <cstdint>
 #include <unistd.h>
@@ -23,10 +28,39 @@
 namespace ecl
 {
 
+//!
+//! \brief DMA configuration of USART bus.
+//! Zero stream means that DMA is not used in given direction, so data is
+//! moved byte-by-byte from USART IRQ.
+//! \tparam dma_tx_stream  DMA stream used for TX. Optional.
+//! \tparam dma_tx_channel DMA channel of the TX stream.
+//! \tparam dma_rx_stream  DMA stream used for RX. Optional.
+//! \tparam dma_rx_channel DMA channel of the RX stream.
+//!
+template< std::uintptr_t    dma_tx_stream,
+          uint32_t          dma_tx_channel,
+          std::uintptr_t    dma_rx_stream,
+          uint32_t          dma_rx_channel >
+struct usart_dma_config
+{
+    static constexpr uint32_t           m_dma_tx_channel   = dma_tx_channel;
+    static constexpr std::uintptr_t     m_dma_tx_stream    = dma_tx_stream;
+    static constexpr uint32_t           m_dma_rx_channel   = dma_rx_channel;
+    static constexpr std::uintptr_t     m_dma_rx_stream    = dma_rx_stream;
+
+    //! Streams claimed by the bus. \sa dma::exclusive_streams
+    using dma_streams = dma::stream_list< dma_tx_stream, dma_rx_stream >;
+};
+
+//! DMA is not used by the USART bus.
+using usart_no_dma = usart_dma_config< 0, 0, 0, 0 >;
+
 //!
 //! \brief STM32F4 USART bus
+//! \tparam dev        USART device.
+//! \tparam dma_config DMA configuration. \sa usart_dma_config
 //!
-template< usart_device dev >
+template< usart_device dev, class dma_config = usart_no_dma >
 class usart_bus
 {
 public:
@@ -93,11 +127,37 @@ public:
     //!
     //! \brief Executes xfer, using buffers previously set.
     //! When it will be done, handler will be invoked.
+    //! If DMA is configured for a direction, then whole buffer is moved
+    //! via DMA and both ht and tc events are reported for that direction.
+    //! Otherwise, data is moved byte-by-byte and only single byte is
+    //! received per xfer.
     //! \return Status of operation.
     //!
     ecl::err do_xfer();
 
+    //!
+    //! \brief Enables or disables idle-line terminated RX.
+    //! In this mode RX buffer size is treated as maximum size of a frame.
+    //! RX ends either when buffer is full or when the line becomes idle
+    //! after at least one byte is received. Actual amount of bytes received
+    //! is reported via handler's total argument within RX TC event.
+    //! The mode persists accross xfers, until explicitly disabled.
+    //! \param[in] enable Desired mode state.
+    //!
+    void set_rx_idle(bool enable);
+
 private:
+    //! Registers, clock and IRQ of USART.
+    struct periph_info
+    {
+        std::uintptr_t  base;   //!< Address of USART registers.
+        uint32_t        rcc;    //!< Clock bit of USART.
+        bool            apb2;   //!< USART is on APB2, APB1 otherwise.
+        IRQn_Type       irqn;   //!< IRQ of USART.
+    };
+
+    //! Looks up USART device at compile time.
+    static constexpr periph_info pick_periph();
     //! Picks proper RCC at compile time.
     static constexpr auto pick_rcc();
     //! Picks proper RCC operation function at compile time.
@@ -107,6 +167,31 @@ private:
     //! Converts to proper USART type.
     static constexpr auto pick_usart();
 
+    // Registers and bits, touched on each xfer and in IRQ handlers
+
+    using sr        = ECL_REG(USART_TypeDef, SR);
+    using cr1       = ECL_REG(USART_TypeDef, CR1);
+    using cr3       = ECL_REG(USART_TypeDef, CR3);
+
+    using sr_txe    = ecl::regs::bits< sr, USART_SR_TXE >;
+    using sr_rxne   = ecl::regs::bits< sr, USART_SR_RXNE >;
+    using sr_idle   = ecl::regs::bits< sr, USART_SR_IDLE >;
+    using txeie     = ecl::regs::bits< cr1, USART_CR1_TXEIE >;
+    using rxneie    = ecl::regs::bits< cr1, USART_CR1_RXNEIE >;
+    using idleie    = ecl::regs::bits< cr1, USART_CR1_IDLEIE >;
+    using dmat      = ecl::regs::bits< cr3, USART_CR3_DMAT >;
+    using dmar      = ecl::regs::bits< cr3, USART_CR3_DMAR >;
+
+    //! Checks if interrupt is enabled and its flag is raised,
+    //! same as USART_GetITStatus() does.
+    template< class ie, class flag >
+    static bool it_pending();
+
+    //! TX is driven by DMA.
+    static constexpr bool tx_dma = dma_config::m_dma_tx_stream != 0;
+    //! RX is driven by DMA.
+    static constexpr bool rx_dma = dma_config::m_dma_rx_stream != 0;
+
     // Device status flags
 
     //! Bit set if device initialized.
@@ -115,12 +200,15 @@ private:
     static constexpr uint8_t m_tx_done    = 0x2;
     //! Bit set if rx is done.
     static constexpr uint8_t m_rx_done    = 0x4;
+    //! Bit set if rx is terminated by idle line.
+    static constexpr uint8_t m_rx_idle    = 0x8;
 
     // Device status methods
 
     inline bool inited() const     { return (m_status & m_inited)  != 0; }
     inline bool tx_done() const    { return (m_status & m_tx_done) != 0; }
     inline bool rx_done() const    { return (m_status & m_rx_done) != 0; }
+    inline bool rx_idle() const    { return (m_status & m_rx_idle) != 0; }
 
     inline void set_inited()       { m_status |= m_inited; }
     inline void set_tx_done()      { m_status |= m_tx_done; }
@@ -134,6 +222,30 @@ private:
     //! Handles IRQ events from a bus.
     void irq_handler();
 
+    //! Handles IRQ events from DMA streams.
+    void dma_irq_handler();
+
+    //! Bus IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void irq_entry();
+
+    //! DMA IRQ entry point. Plain function, suitable for static IRQ dispatch.
+    static void dma_irq_entry();
+
+    //! Handles RX events in idle-line terminated mode.
+    void rx_idle_handler();
+
+    //! Stops RX DMA stream.
+    void stop_rx_dma();
+
+    //! Prepares and starts TX DMA stream.
+    void start_tx_dma();
+
+    //! Prepares and starts RX DMA stream.
+    void start_rx_dma();
+
+    //! Notifies about end of xfer, if it is the case.
+    void check_complete();
+
     handler_fn      m_event_handler; //! Handler passed via set_handler().
     const uint8_t   *m_tx;           //! Transmit buffer.
     size_t          m_tx_size;       //! TX buffer size.
@@ -142,10 +254,16 @@ private:
     size_t          m_rx_size;       //! RX buffer size.
     size_t          m_rx_left;       //! Left to receive in RX buffer.
     uint8_t         m_status;        //! Tracks device status.
+
+    //! Bus object, served by IRQ entries. Only one object of a given bus can exist.
+    static usart_bus *m_instance;
 };
 
-template< usart_device dev >
-usart_bus< dev >::usart_bus()
+template< usart_device dev, class dma_config >
+usart_bus< dev, dma_config > *usart_bus< dev, dma_config >::m_instance{nullptr};
+
+template< usart_device dev, class dma_config >
+usart_bus< dev, dma_config >::usart_bus()
     :m_event_handler{}
     ,m_tx{nullptr}
     ,m_tx_size{0}
@@ -158,14 +276,14 @@ usart_bus< dev >::usart_bus()
 
 }
 
-template< usart_device dev >
-usart_bus< dev >::~usart_bus()
+template< usart_device dev, class dma_config >
+usart_bus< dev, dma_config >::~usart_bus()
 {
 
 }
 
-template< usart_device dev >
-ecl::err usart_bus< dev >::init()
+template< usart_device dev, class dma_config >
+ecl::err usart_bus< dev, dma_config >::init()
 {
     USART_InitTypeDef init_struct;
 
@@ -195,13 +313,27 @@ ecl::err usart_bus< dev >::init()
     // Init UART
     USART_Init(usart, &init_struct);
 
+    ecl_assert(!m_instance || m_instance == this);
+    m_instance = this;
+
     // TODO: enable irq before each transaction and disable after
     // rather than keep it enabled all time
-    auto lambda = [this]() {
-        this->irq_handler();
-    };
+    IRQ_manager::subscribe(irqn, irq_entry);
 
-    IRQ_manager::subscribe(irqn, lambda);
+    // Streams are leased permanently, since RX can be armed at any moment.
+    if (tx_dma) {
+        dma::init_rcc< dma_config::m_dma_tx_stream >();
+        if (is_error(dma::stream_lease< dma_config::m_dma_tx_stream >::acquire(this, dma_irq_entry))) {
+            return ecl::err::busy;
+        }
+    }
+
+    if (rx_dma) {
+        dma::init_rcc< dma_config::m_dma_rx_stream >();
+        if (is_error(dma::stream_lease< dma_config::m_dma_rx_stream >::acquire(this, dma_irq_entry))) {
+            return ecl::err::busy;
+        }
+    }
 
     // Enable UART
     USART_Cmd(usart, ENABLE);
@@ -210,8 +342,8 @@ ecl::err usart_bus< dev >::init()
     return ecl::err::ok;
 }
 
-template< usart_device dev >
-void usart_bus< dev >::set_rx(uint8_t *rx, size_t size)
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::set_rx(uint8_t *rx, size_t size)
 {
     // TODO: assert if not initialized
     if (!inited()) {
@@ -222,8 +354,8 @@ void usart_bus< dev >::set_rx(uint8_t *rx, size_t size)
     m_rx_size = size;
 }
 
-template< usart_device dev >
-void usart_bus< dev >::set_tx(size_t size, uint8_t fill_byte)
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::set_tx(size_t size, uint8_t fill_byte)
 {
     if (!inited()) {
         return;
@@ -234,8 +366,8 @@ void usart_bus< dev >::set_tx(size_t size, uint8_t fill_byte)
     (void) fill_byte;
 }
 
-template< usart_device dev >
-void usart_bus< dev >::set_tx(const uint8_t *tx, size_t size)
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::set_tx(const uint8_t *tx, size_t size)
 {
     if (!inited()) {
         return;
@@ -247,15 +379,15 @@ void usart_bus< dev >::set_tx(const uint8_t *tx, size_t size)
 }
 
 
-template< usart_device dev >
-void usart_bus< dev >::set_handler(const handler_fn &handler)
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::set_handler(const handler_fn &handler)
 {
     // It is possible (and recommended) to set handler before bus init.
     m_event_handler = handler;
 }
 
-template< usart_device dev >
-void usart_bus< dev >::reset_buffers()
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::reset_buffers()
 {
     // TODO: assert if not initialized
     if (!inited()) {
@@ -271,14 +403,14 @@ void usart_bus< dev >::reset_buffers()
     clear_tx_done();
 }
 
-template< usart_device dev >
-void usart_bus< dev >::reset_handler()
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::reset_handler()
 {
     m_event_handler = handler_fn{};
 }
 
-template< usart_device dev >
-ecl::err usart_bus< dev >::do_xfer()
+template< usart_device dev, class dma_config >
+ecl::err usart_bus< dev, dma_config >::do_xfer()
 {
     // TODO: assert if not initialized
     if (!inited()) {
@@ -288,21 +420,40 @@ ecl::err usart_bus< dev >::do_xfer()
     constexpr auto irqn = pick_irqn();
     constexpr auto usart = pick_usart();
 
-    if (m_tx) {
+    if (m_tx && tx_dma) {
+        clear_tx_done();
+        start_tx_dma();
+    } else if (m_tx) {
         m_tx_left = m_tx_size;
         clear_tx_done();
 
         // Bytes will be send in IRQ handler.
-        USART_ITConfig(usart, USART_IT_TXE, ENABLE);
+        ecl::regs::set< txeie >(usart);
     } else {
         // TX is not requested. Assuming that it is has been done some
         // time ago.
         set_tx_done();
     }
 
-    if (m_rx) {
+    if (m_rx && rx_idle()) {
+        m_rx_left = m_rx_size;
         clear_rx_done();
-        USART_ITConfig(usart, USART_IT_RXNE, ENABLE);
+
+        // Clear stale idle event. Sequence is: read SR, then read DR.
+        // Do not drop any byte that is already received.
+        if (ecl::regs::test< sr_idle >(usart) && !ecl::regs::test< sr_rxne >(usart)) {
+            (void) usart->DR;
+        }
+
+        ecl::regs::set< idleie >(usart);
+    }
+
+    if (m_rx && rx_dma) {
+        clear_rx_done();
+        start_rx_dma();
+    } else if (m_rx) {
+        clear_rx_done();
+        ecl::regs::set< rxneie >(usart);
     } else {
         // TX is not requested. Assuming that it is has been done some
         // time ago.
@@ -314,110 +465,102 @@ ecl::err usart_bus< dev >::do_xfer()
     return ecl::err::ok;
 }
 
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::set_rx_idle(bool enable)
+{
+    if (enable) {
+        m_status |= m_rx_idle;
+    } else {
+        m_status &= ~(m_rx_idle);
+    }
+}
+
 // -----------------------------------------------------------------------------
 // Private members
 
-template< usart_device dev >
-constexpr auto usart_bus< dev >::pick_rcc()
+template< usart_device dev, class dma_config >
+constexpr typename usart_bus< dev, dma_config >::periph_info usart_bus< dev, dma_config >::pick_periph()
 {
     // USART1 and USART6 are on APB2
     // USART2, USART3, UART4, UART5 are on APB1
     // See datasheet for detailed explanations
-    // TODO: Switch instead of 'if's
-    constexpr auto usart = pick_usart();
-    if (usart == USART1)
-        return RCC_APB2Periph_USART1;
-    if (usart == USART2)
-        return RCC_APB1Periph_USART2;
-    if (usart == USART3)
-        return RCC_APB1Periph_USART3;
-    if (usart == UART4)
-        return RCC_APB1Periph_UART4;
-    if (usart == UART5)
-        return RCC_APB1Periph_UART5;
-    if (usart == USART6)
-        return RCC_APB2Periph_USART6;
-
-    return static_cast< uint32_t >(-1);
+    constexpr auto usarts = make_lookup_table< usart_device, periph_info >({
+        { usart_device::dev_1, { USART1_BASE, RCC_APB2Periph_USART1, true,  USART1_IRQn } },
+        { usart_device::dev_2, { USART2_BASE, RCC_APB1Periph_USART2, false, USART2_IRQn } },
+        { usart_device::dev_3, { USART3_BASE, RCC_APB1Periph_USART3, false, USART3_IRQn } },
+        { usart_device::dev_4, { UART4_BASE,  RCC_APB1Periph_UART4,  false, UART4_IRQn  } },
+        { usart_device::dev_5, { UART5_BASE,  RCC_APB1Periph_UART5,  false, UART5_IRQn  } },
+        { usart_device::dev_6, { USART6_BASE, RCC_APB2Periph_USART6, true,  USART6_IRQn } },
+    });
+
+    static_assert(usarts.contains(dev), "USART device is not supported");
+
+    return usarts[dev];
 }
 
-template< usart_device dev >
-constexpr auto usart_bus< dev >::pick_rcc_fn()
+template< usart_device dev, class dma_config >
+constexpr auto usart_bus< dev, dma_config >::pick_rcc()
 {
-    // USART1 and USART6 are on APB2
-    // USART2, USART3, UART4, UART5 are on APB1
-    // See datasheet for detailed explanations
-    constexpr auto usart = pick_usart();
-    // TODO: switch instead of 'if's
-    if (usart == USART1 || usart == USART6) {
-        return RCC_APB2PeriphClockCmd;
-    } else if (usart == USART2 || usart == USART3 ||
-               usart == UART4  || usart == UART5) {
-        return RCC_APB1PeriphClockCmd;
-    } else {
-        // TODO: clarify
-        return static_cast< decltype(&RCC_APB1PeriphClockCmd) >(nullptr);
-    }
+    return pick_periph().rcc;
 }
 
-template< usart_device dev >
-constexpr auto usart_bus< dev >::pick_irqn()
+template< usart_device dev, class dma_config >
+constexpr auto usart_bus< dev, dma_config >::pick_rcc_fn()
+{
+    return pick_periph().apb2 ? RCC_APB2PeriphClockCmd : RCC_APB1PeriphClockCmd;
+}
+
+template< usart_device dev, class dma_config >
+constexpr auto usart_bus< dev, dma_config >::pick_irqn()
+{
+    return pick_periph().irqn;
+}
+
+template< usart_device dev, class dma_config >
+constexpr auto usart_bus< dev, dma_config >::pick_usart()
+{
+    return reinterpret_cast< USART_TypeDef* >(pick_periph().base);
+}
+
+template< usart_device dev, class dma_config >
+template< class ie, class flag >
+bool usart_bus< dev, dma_config >::it_pending()
 {
     constexpr auto usart = pick_usart();
 
-    if (usart == USART1) {
-        return USART1_IRQn;
-    } else if (usart == USART2) {
-        return USART2_IRQn;
-    } else if (usart == USART3) {
-        return USART3_IRQn;
-    } else if (usart == UART4) {
-        return UART4_IRQn;
-    } else if (usart == UART5) {
-        return UART5_IRQn;
-    } else if (usart == USART6) {
-        return USART6_IRQn;
-    }
+    return ecl::regs::test< ie >(usart) && ecl::regs::test< flag >(usart);
 }
 
-template< usart_device dev >
-constexpr auto usart_bus< dev >::pick_usart()
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::irq_entry()
 {
-    switch (dev) {
-    case usart_device::dev_1:
-        return USART1;
-    case usart_device::dev_2:
-        return USART2;
-    case usart_device::dev_3:
-        return USART3;
-    case usart_device::dev_4:
-        return UART4;
-    case usart_device::dev_5:
-        return UART5;
-    case usart_device::dev_6:
-        return USART6;
-        // TODO: clarify
-    default:
-        return static_cast< decltype(USART1) >(nullptr);
-    };
+    m_instance->irq_handler();
 }
 
-template< usart_device dev >
-void usart_bus< dev >::irq_handler()
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::dma_irq_entry()
+{
+    m_instance->dma_irq_handler();
+}
+
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::irq_handler()
 {
     constexpr auto usart = pick_usart();
     constexpr auto irqn  = pick_irqn();
-    ITStatus status;
+    bool status;
 
     IRQ_manager::clear(irqn);
 
     // TODO: comment about flags clear sequence
 
-    if (!tx_done()) {
-        status = USART_GetITStatus(usart, USART_IT_TXE);
-        if (status == SET && m_tx) {
+    // TX is served here only if DMA is not used for it. If it is, RX
+    // is not blocked by TX and will be served right away.
+    if (!tx_dma && !tx_done()) {
+        status = it_pending< txeie, sr_txe >();
+        if (status && m_tx) {
             if (m_tx_left) {
-                USART_SendData(usart, *(m_tx + (m_tx_size - m_tx_left)));
+                usart->DR = *(m_tx + (m_tx_size - m_tx_left));
                 m_tx_left--;
                 IRQ_manager::unmask(irqn);
             } else {
@@ -426,13 +569,15 @@ void usart_bus< dev >::irq_handler()
 
                 // Transaction complete.
                 set_tx_done();
-                USART_ITConfig(usart, USART_IT_TXE, DISABLE);
+                ecl::regs::clear< txeie >(usart);
             }
         }
+    } else if (!rx_done() && rx_idle()) {
+        rx_idle_handler();
     } else if (!rx_done()) {  // Perform RX only after TX is finished.
-        status = USART_GetITStatus(usart, USART_IT_RXNE);
+        status = it_pending< rxneie, sr_rxne >();
 
-        if (status == SET) {
+        if (status) {
             // Do not receive more than one byte. This is actually a small
             // adaptation to console purposes. Every symbol must be immediately
             // transfered to the client of the console driver (code that owns
@@ -440,7 +585,7 @@ void usart_bus< dev >::irq_handler()
             // If throughput is the case, additional buffering may be applied,
             // so this usart bus will accumulate some data (in other words,
             // will buffer RX stream) even if the client not requesting anything.
-            auto data = USART_ReceiveData(usart);
+            auto data = usart->DR;
             *m_rx = static_cast< uint8_t >(data);
 
             // Notify about that 1 byte is received.
@@ -448,12 +593,190 @@ void usart_bus< dev >::irq_handler()
 
             // Transaction complete.
             set_rx_done();
-            USART_ITConfig(usart, USART_IT_RXNE, DISABLE);
+            ecl::regs::clear< rxneie >(usart);
 
             // 1 byte is recieved. No need to unmask interrupts.
         }
     }
 
+    check_complete();
+}
+
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::dma_irq_handler()
+{
+    constexpr auto usart      = pick_usart();
+    constexpr auto tx_ht_if   = dma::get_ht_if< dma_config::m_dma_tx_stream >();
+    constexpr auto tx_tc_if   = dma::get_tc_if< dma_config::m_dma_tx_stream >();
+    constexpr auto rx_ht_if   = dma::get_ht_if< dma_config::m_dma_rx_stream >();
+    constexpr auto rx_tc_if   = dma::get_tc_if< dma_config::m_dma_rx_stream >();
+    constexpr auto tx_irqn    = dma::get_irqn< dma_config::m_dma_tx_stream >();
+    constexpr auto rx_irqn    = dma::get_irqn< dma_config::m_dma_rx_stream >();
+
+    if (tx_dma && !tx_done()) {
+        if (dma::get_it_status< dma_config::m_dma_tx_stream, tx_ht_if >()) {
+            dma::clear_flags< dma_config::m_dma_tx_stream, tx_ht_if >();
+
+            auto sent = m_tx_size - dma::get_counter< dma_config::m_dma_tx_stream >();
+            m_event_handler(channel::tx, event::ht, sent);
+        }
+
+        if (dma::get_it_status< dma_config::m_dma_tx_stream, tx_tc_if >()) {
+            dma::clear_flags< dma_config::m_dma_tx_stream, tx_tc_if >();
+
+            dma::disable_irq< dma_config::m_dma_tx_stream, DMA_IT_HT | DMA_IT_TC >();
+            dma::disable< dma_config::m_dma_tx_stream >();
+            ecl::regs::clear< dmat >(usart);
+
+            // Last byte is moved to the data register, but probably
+            // not yet shifted out.
+            set_tx_done();
+            m_event_handler(channel::tx, event::tc, m_tx_size);
+        }
+    }
+
+    if (tx_dma) {
+        // Stream IRQ is masked by IRQ manager before calling this handler
+        IRQ_manager::clear(tx_irqn);
+        IRQ_manager::unmask(tx_irqn);
+    }
+
+    if (rx_dma && !rx_done()) {
+        if (dma::get_it_status< dma_config::m_dma_rx_stream, rx_ht_if >()) {
+            dma::clear_flags< dma_config::m_dma_rx_stream, rx_ht_if >();
+
+            auto received = m_rx_size - dma::get_counter< dma_config::m_dma_rx_stream >();
+            m_event_handler(channel::rx, event::ht, received);
+        }
+
+        if (dma::get_it_status< dma_config::m_dma_rx_stream, rx_tc_if >()) {
+            dma::clear_flags< dma_config::m_dma_rx_stream, rx_tc_if >();
+
+            // Buffer is full before line becomes idle
+            ecl::regs::clear< idleie >(usart);
+            stop_rx_dma();
+
+            set_rx_done();
+            m_event_handler(channel::rx, event::tc, m_rx_size);
+        }
+    }
+
+    if (rx_dma) {
+        // Stream IRQ is masked by IRQ manager before calling this handler
+        IRQ_manager::clear(rx_irqn);
+        IRQ_manager::unmask(rx_irqn);
+    }
+
+    check_complete();
+}
+
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::start_tx_dma()
+{
+    constexpr auto usart    = pick_usart();
+    constexpr auto stream   = dma::get_stream< dma_config::m_dma_tx_stream >();
+
+    DMA_InitTypeDef dma_init;
+    DMA_StructInit(&dma_init);
+
+    dma_init.DMA_Channel             = dma_config::m_dma_tx_channel;
+    dma_init.DMA_DIR                 = DMA_DIR_MemoryToPeripheral;
+    dma_init.DMA_PeripheralBaseAddr  = reinterpret_cast< uint32_t >(&usart->DR);
+    dma_init.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+    dma_init.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+    dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(m_tx);
+    dma_init.DMA_BufferSize          = m_tx_size;
+
+    DMA_DeInit(stream);
+    DMA_Init(stream, &dma_init);
+    dma::enable_irq< dma_config::m_dma_tx_stream, DMA_IT_HT | DMA_IT_TC >();
+    dma::enable< dma_config::m_dma_tx_stream >();
+
+    ecl::regs::set< dmat >(usart);
+}
+
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::start_rx_dma()
+{
+    constexpr auto usart    = pick_usart();
+    constexpr auto stream   = dma::get_stream< dma_config::m_dma_rx_stream >();
+
+    DMA_InitTypeDef dma_init;
+    DMA_StructInit(&dma_init);
+
+    dma_init.DMA_Channel             = dma_config::m_dma_rx_channel;
+    dma_init.DMA_DIR                 = DMA_DIR_PeripheralToMemory;
+    dma_init.DMA_PeripheralBaseAddr  = reinterpret_cast< uint32_t >(&usart->DR);
+    dma_init.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+    dma_init.DMA_MemoryInc           = DMA_MemoryInc_Enable;
+    dma_init.DMA_Memory0BaseAddr     = reinterpret_cast< uint32_t >(m_rx);
+    dma_init.DMA_BufferSize          = m_rx_size;
+
+    DMA_DeInit(stream);
+    DMA_Init(stream, &dma_init);
+    dma::enable_irq< dma_config::m_dma_rx_stream, DMA_IT_HT | DMA_IT_TC >();
+    dma::enable< dma_config::m_dma_rx_stream >();
+
+    ecl::regs::set< dmar >(usart);
+}
+
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::stop_rx_dma()
+{
+    constexpr auto usart    = pick_usart();
+
+    // Interrupts are disabled first, since disabling unfinished stream
+    // raises TC flag.
+    dma::disable_irq< dma_config::m_dma_rx_stream, DMA_IT_HT | DMA_IT_TC >();
+    dma::disable< dma_config::m_dma_rx_stream >();
+    ecl::regs::clear< dmar >(usart);
+}
+
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::rx_idle_handler()
+{
+    constexpr auto usart    = pick_usart();
+    constexpr auto irqn     = pick_irqn();
+
+    bool idle = it_pending< idleie, sr_idle >();
+
+    if (!rx_dma && it_pending< rxneie, sr_rxne >()) {
+        // Reading DR also clears idle flag, if set.
+        auto data = usart->DR;
+        m_rx[m_rx_size - m_rx_left] = static_cast< uint8_t >(data);
+        m_rx_left--;
+    } else if (idle) {
+        // SR is already read, DR read completes idle flag clear sequence.
+        (void) usart->DR;
+    }
+
+    size_t received = rx_dma
+            ? m_rx_size - dma::get_counter< dma_config::m_dma_rx_stream >()
+            : m_rx_size - m_rx_left;
+
+    // Idle line may be detected before a first byte of a frame.
+    if ((idle && received) || received == m_rx_size) {
+        ecl::regs::clear< idleie >(usart);
+
+        if (rx_dma) {
+            stop_rx_dma();
+        } else {
+            ecl::regs::clear< rxneie >(usart);
+        }
+
+        set_rx_done();
+        m_event_handler(channel::rx, event::tc, received);
+    } else {
+        // Frame is not yet complete
+        IRQ_manager::unmask(irqn);
+    }
+}
+
+template< usart_device dev, class dma_config >
+void usart_bus< dev, dma_config >::check_complete()
+{
+    // Both USART and DMA IRQs are of the same priority, so they cannot
+    // preempt each other here.
     if (tx_done() && rx_done()) {
         // Both TX and RX are finished. Notifying.
         m_event_handler(channel::meta, event::tc, 0);
@@ -0,0 +1,246 @@
+#ifndef PLATFORM_WATCHDOG_HPP_
+#define PLATFORM_WATCHDOG_HPP_
+
+//!
+//! \file
+//! \brief Independent watchdog, kicked only while all threads are alive.
+//! Threads register heartbeats and beat in their loops. Supervisor,
+//! i.e. a low priority thread, checks them more often than the watchdog
+//! timeout and kicks IWDG only if every thread beat in time:
+//! \code
+//!     // Worker
+//!     int id = ecl::watchdog::add(worker_id, 500);
+//!     for (;;) {
+//!         ecl::watchdog::beat(id);
+//!         process(queue.wait());
+//!     }
+//!
+//!     // Supervisor
+//!     ecl::watchdog::init();
+//!     if (ecl::watchdog::caused_reset()) {
+//!         report(ecl::watchdog::last_stalled());
+//!     }
+//!     for (;;) {
+//!         ecl::watchdog::supervise();
+//!         ecl::os::this_thread::sleep_for(100);
+//!     }
+//! \endcode
+//! Thread, stuck i.e. waiting for a transfer that never completes, lets
+//! the watchdog reset the part. Its tag is kept in backup SRAM, so it is
+//! known after the reset.
+//!
+
+#include <platform/timebase.hpp>
+
+#include <ecl/thread/heartbeat.hpp>
+
+#include <stm32f4xx_iwdg.h>
+#include <stm32f4xx_dbgmcu.h>
+#include <stm32f4xx_pwr.h>
+#include <stm32f4xx_rcc.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Supervisor of threads, backed by IWDG.
+//! All members are static: there is only one watchdog.
+//! \tparam slots      Maximum amount of registered threads.
+//! \tparam timeout_ms Watchdog timeout, 1 ms to 32 s. Nominal LSI frequency
+//!                    is assumed, actual timeout may differ by tens of percent.
+//! \tparam Clock      Source of microsecond timestamps, must be running.
+//!
+template< size_t slots = 8, uint32_t timeout_ms = 1000, class Clock = timebase >
+class watchdog_unit
+{
+    //! Nominal LSI frequency, in Hz.
+    static constexpr uint32_t lsi = 32000;
+
+    //! Smallest prescaler, that fits the timeout into the reload register.
+    static constexpr uint32_t divider(uint32_t div = 4)
+    {
+        return static_cast< uint64_t >(timeout_ms) * lsi / 1000 / div <= 0xfff || div == 256
+                ? div : divider(div * 2);
+    }
+
+    static_assert(timeout_ms > 0 && timeout_ms <= 32000, "Timeout is out of IWDG range");
+
+public:
+    //! Tag, recorded when the supervisor itself stalled.
+    static constexpr uint32_t no_thread = UINT32_MAX;
+
+    //!
+    //! \brief Starts the watchdog and obtains a record of the previous reset.
+    //! Watchdog can't be stopped afterwards, except by the reset. It is
+    //! frozen while the core is halted by a debugger. Reset flags of RCC
+    //! are cleared, so they must be examined before, if required.
+    //!
+    static void init();
+
+    //!
+    //! \brief Registers a thread.
+    //! \param[in] tag       Identifies the thread after a reset.
+    //! \param[in] period_ms Longest allowed interval between beats.
+    //! \return Slot of the thread, or -1 if all slots are taken.
+    //!
+    static int add(uint32_t tag, uint32_t period_ms);
+
+    //!
+    //! \brief Unregisters a thread, i.e. before it blocks for long.
+    //!
+    static void remove(int id) { m_table.remove(id); }
+
+    //!
+    //! \brief Marks a thread alive. Can be called from ISRs.
+    //!
+    static void beat(int id) { m_table.beat(id, Clock::now_us()); }
+
+    //!
+    //! \brief Kicks the watchdog, if all threads are alive.
+    //! Otherwise records the stalled thread and lets the watchdog expire.
+    //! \retval true  Watchdog is kicked.
+    //! \retval false Thread is stalled, reset is coming.
+    //!
+    static bool supervise();
+
+    //!
+    //! \brief Checks if the last reset was done by the watchdog.
+    //!
+    static bool caused_reset() { return m_reset; }
+
+    //!
+    //! \brief Gets tag of the thread, stalled before the last reset.
+    //! \return Tag, or no_thread if supervisor itself stalled or reset
+    //!         wasn't done by the watchdog.
+    //!
+    static uint32_t last_stalled() { return m_last; }
+
+    //!
+    //! \brief Gets amount of watchdog resets since backup domain power-up.
+    //!
+    static uint32_t resets() { return record()->resets; }
+
+private:
+    //! Record in backup SRAM, survives resets.
+    struct backup_record
+    {
+        uint32_t magic;     //!< Record is valid if it holds a magic value.
+        uint32_t tag;       //!< Tag of the stalled thread.
+        uint32_t resets;    //!< Amount of watchdog resets.
+    };
+
+    static constexpr uint32_t magic = 0x57444f47; // "WDOG"
+
+    //! Record is placed at the end of backup SRAM, to keep the rest for others.
+    static volatile backup_record *record()
+    {
+        return reinterpret_cast< volatile backup_record * >(BKPSRAM_BASE + 4096
+                                                             - sizeof(backup_record));
+    }
+
+    static heartbeat_table< slots > m_table;   //!< Registered threads.
+    static bool                     m_reset;   //!< Last reset was done by the watchdog.
+    static uint32_t                 m_last;    //!< Thread, stalled before the reset.
+    static bool                     m_stalled; //!< Stall is recorded.
+};
+
+//! Default watchdog, with 1 second timeout.
+using watchdog = watchdog_unit<>;
+
+//------------------------------------------------------------------------------
+
+template< size_t slots, uint32_t timeout_ms, class Clock >
+heartbeat_table< slots > watchdog_unit< slots, timeout_ms, Clock >::m_table;
+
+template< size_t slots, uint32_t timeout_ms, class Clock >
+bool watchdog_unit< slots, timeout_ms, Clock >::m_reset;
+
+template< size_t slots, uint32_t timeout_ms, class Clock >
+uint32_t watchdog_unit< slots, timeout_ms, Clock >::m_last = no_thread;
+
+template< size_t slots, uint32_t timeout_ms, class Clock >
+bool watchdog_unit< slots, timeout_ms, Clock >::m_stalled;
+
+template< size_t slots, uint32_t timeout_ms, class Clock >
+void watchdog_unit< slots, timeout_ms, Clock >::init()
+{
+    constexpr uint32_t div = divider();
+    constexpr uint32_t reload = static_cast< uint64_t >(timeout_ms) * lsi / 1000 / div;
+
+    constexpr uint8_t prescaler = div == 4   ? IWDG_Prescaler_4
+                                : div == 8   ? IWDG_Prescaler_8
+                                : div == 16  ? IWDG_Prescaler_16
+                                : div == 32  ? IWDG_Prescaler_32
+                                : div == 64  ? IWDG_Prescaler_64
+                                : div == 128 ? IWDG_Prescaler_128
+                                             : IWDG_Prescaler_256;
+
+    // Backup SRAM is powered from VBAT, its content survives resets
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR, ENABLE);
+    RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_BKPSRAM, ENABLE);
+    PWR_BackupAccessCmd(ENABLE);
+
+    auto rec = record();
+
+    m_reset = RCC_GetFlagStatus(RCC_FLAG_IWDGRST) == SET;
+    RCC_ClearFlag();
+
+    if (rec->magic != magic) {
+        rec->tag = no_thread;
+        rec->resets = 0;
+        rec->magic = magic;
+    }
+
+    if (m_reset) {
+        m_last = rec->tag;
+        rec->resets = rec->resets + 1;
+    }
+
+    // Reset without a recorded stall is blamed on the supervisor
+    rec->tag = no_thread;
+
+    DBGMCU_APB1PeriphConfig(DBGMCU_IWDG_STOP, ENABLE);
+
+    IWDG_WriteAccessCmd(IWDG_WriteAccess_Enable);
+    IWDG_SetPrescaler(prescaler);
+    IWDG_SetReload(reload ? reload : 1);
+    IWDG_ReloadCounter();
+    IWDG_Enable();
+}
+
+template< size_t slots, uint32_t timeout_ms, class Clock >
+int watchdog_unit< slots, timeout_ms, Clock >::add(uint32_t tag, uint32_t period_ms)
+{
+    // Timestamps wrap each 71 minutes, periods must be below half of it
+    if (period_ms > 30 * 60 * 1000u) {
+        return -1;
+    }
+
+    return m_table.add(tag, period_ms * 1000, Clock::now_us());
+}
+
+template< size_t slots, uint32_t timeout_ms, class Clock >
+bool watchdog_unit< slots, timeout_ms, Clock >::supervise()
+{
+    int id = m_table.stalled(Clock::now_us());
+
+    if (id < 0) {
+        IWDG_ReloadCounter();
+        return true;
+    }
+
+    // First stalled thread is the one to blame, others may wait for it
+    if (!m_stalled) {
+        m_stalled = true;
+        record()->tag = m_table.tag(id);
+    }
+
+    return false;
+}
+
+} // namespace ecl
+
+#endif // PLATFORM_WATCHDOG_HPP_
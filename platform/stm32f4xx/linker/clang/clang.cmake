@@ -1,2 +1,9 @@
-# Support is required
-message(FATAL_ERROR "No support for clang suite yet!")
+# LLD understands the GNU linker script, so both toolchains share one layout
+set(CMAKE_C_LINK_FLAGS
+	"-fuse-ld=lld -nostdlib -nostartfiles -T${CMAKE_CURRENT_LIST_DIR}/../gnu/stm32.ld \
+	-flto -Wl,--gc-sections "
+	CACHE STRING "Linker C flags")
+set(CMAKE_CXX_LINK_FLAGS
+	"-fuse-ld=lld -nostdlib -nostartfiles -T${CMAKE_CURRENT_LIST_DIR}/../gnu/stm32.ld \
+	-flto -Wl,--gc-sections "
+	CACHE STRING "Linker C++ flags")
@@ -1,16 +1,41 @@
 #include <platform/irq_manager.hpp>
 #include <platform/utils.hpp>
+// Validates clock configuration at compile time
+#include <platform/clock.hpp>
 #include <misc.h>
 #include <core_cm4.h>
 
 // TODO: move it elsewhere
-std::function< void() > IRQ_manager::m_handlers[82];
+#ifdef CONFIG_IRQ_STATIC_DISPATCH
+constexpr size_t IRQ_manager::core_vectors;
+constexpr size_t IRQ_manager::vectors_count;
+alignas(512) uint32_t IRQ_manager::m_vectors[IRQ_manager::vectors_count];
+#else
+IRQ_manager::handler_type IRQ_manager::m_handlers[IRQ_manager::irq_count];
+#endif
+
+constexpr uint8_t IRQ_manager::max_priority;
+uint8_t IRQ_manager::m_priorities[IRQ_manager::irq_count];
+
+#ifdef CONFIG_IRQ_STATS
+IRQ_manager::stats IRQ_manager::m_stats[IRQ_manager::irq_count];
+#endif
 
 // TODO: decide if to make as a class member or not
 extern "C" __attribute__((used)) void platform_init()
 {
-    // Required for FreeRTOS
+    // Required for FreeRTOS.
+    // All priority bits are used for preemption, so IRQ sub-priorities
+    // are not available, see IRQ_manager::set_priority().
     NVIC_PriorityGroupConfig(NVIC_PriorityGroup_4);
+
+#if (__FPU_USED == 1)
+    // Lazy stacking: exception entry reserves room for FPU registers only
+    // if interrupted code used FPU, and saves them only if the handler uses
+    // FPU as well. FreeRTOS port relies on it to save FPU context of threads,
+    // that use FPU, only. Matches reset state, unless bootloader changed it.
+    FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+#endif
 }
 
 namespace ecl
@@ -31,4 +56,23 @@ void enable_irq()
     __enable_irq();
 }
 
+// Clock of the bus trace, see dev/bus_trace.hpp. Based on DWT cycle counter.
+
+void bus_trace_clock_init()
+{
+    // Cycle counter is a part of debug unit, which must be enabled first
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t bus_trace_clock()
+{
+    return DWT->CYCCNT;
+}
+
+uint32_t bus_trace_clock_hz()
+{
+    return SystemCoreClock;
+}
+
 }
@@ -0,0 +1,242 @@
+#include <platform/power.hpp>
+#include <platform/irq_manager.hpp>
+#include <platform/clock.hpp>
+
+#include <stm32f4xx_exti.h>
+#include <stm32f4xx_pwr.h>
+#include <stm32f4xx_rcc.h>
+#include <stm32f4xx_rtc.h>
+
+// Power modes of idle MCU. Stop mode is entered with main regulator on
+// and flash powered, giving the fastest wake-up of the mode.
+
+namespace ecl
+{
+
+std::atomic< uint32_t > power::m_stop_locks{0};
+std::atomic< size_t > power::m_sleeps{0};
+std::atomic< size_t > power::m_stops{0};
+ecl::err (*power::m_resync)(){nullptr};
+uint32_t power::m_stop_min_us{default_stop_min_us};
+bool power::m_stop_enabled{false};
+
+void power::enable_stop(ecl::err (*resync)(), uint32_t min_idle_us)
+{
+    m_resync = resync;
+    m_stop_min_us = min_idle_us;
+
+    init_wakeup();
+
+    m_stop_enabled = true;
+}
+
+void power::disable_stop()
+{
+    m_stop_enabled = false;
+}
+
+void power::inhibit_stop()
+{
+    ++m_stop_locks;
+}
+
+void power::allow_stop()
+{
+    --m_stop_locks;
+}
+
+power_mode power::select(uint32_t idle_us)
+{
+    if (!m_stop_enabled || m_stop_locks || idle_us < m_stop_min_us) {
+        return power_mode::sleep;
+    }
+
+    return power_mode::stop;
+}
+
+uint32_t power::enter_stop(uint32_t max_us)
+{
+    // Wakeup timer counts RTC clock, divided by 16
+    uint32_t prer = RTC->PRER;
+    uint32_t rtc_hz = ((prer >> 16 & 0x7f) + 1) * ((prer & 0x7fff) + 1);
+    uint64_t counts = static_cast< uint64_t >(max_us) * (rtc_hz / 16) / 1000000;
+
+    if (counts < 2) {
+        return 0;
+    }
+
+    if (counts > 0x10000) {
+        counts = 0x10000;
+    }
+
+    RTC_WakeUpCmd(DISABLE);
+    RTC_SetWakeUpCounter(counts - 1);
+    RTC_ClearITPendingBit(RTC_IT_WUT);
+    EXTI_ClearITPendingBit(EXTI_Line22);
+
+    if (RTC_WakeUpCmd(ENABLE) != SUCCESS) {
+        return 0;
+    }
+
+#if defined(PWR_CR_ODEN)
+    // Over-drive is turned off by hardware in stop mode
+    bool overdrive = PWR->CR & PWR_CR_ODEN;
+#else
+    bool overdrive = false;
+#endif
+
+    uint32_t before = rtc_ticks();
+
+    PWR_EnterSTOPMode(PWR_Regulator_ON, PWR_STOPEntry_WFI);
+
+    // Whatever woke MCU, it runs from HSI now
+    restore_clocks(overdrive);
+
+    bool timed_out = RTC_GetFlagStatus(RTC_FLAG_WUTF) == SET;
+
+    RTC_WakeUpCmd(DISABLE);
+    RTC_ClearITPendingBit(RTC_IT_WUT);
+    EXTI_ClearITPendingBit(EXTI_Line22);
+    IRQ_manager::clear(RTC_WKUP_IRQn);
+
+    // Shadow registers are stale after stop mode
+    RTC_WaitForSynchro();
+
+    uint32_t slept_us;
+
+    if (timed_out) {
+        slept_us = counts * 16 * 1000000 / rtc_hz;
+    } else {
+        constexpr uint32_t secs_per_day = 86400;
+        uint32_t ticks_per_sec = (prer & 0x7fff) + 1;
+        uint32_t ticks_per_day = secs_per_day * ticks_per_sec;
+        uint32_t ticks = (rtc_ticks() + ticks_per_day - before) % ticks_per_day;
+
+        slept_us = static_cast< uint64_t >(ticks) * 1000000 / ticks_per_sec;
+    }
+
+    if (m_resync) {
+        m_resync();
+    }
+
+    ++m_stops;
+
+    return slept_us;
+}
+
+size_t power::sleeps()
+{
+    return m_sleeps;
+}
+
+size_t power::stops()
+{
+    return m_stops;
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+void power::init_wakeup()
+{
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR, ENABLE);
+    PWR_BackupAccessCmd(ENABLE);
+
+    RTC_WakeUpCmd(DISABLE);
+    RTC_WakeUpClockConfig(RTC_WakeUpClock_RTCCLK_Div16);
+    RTC_ITConfig(RTC_IT_WUT, ENABLE);
+
+    // Wakeup timer reaches NVIC through EXTI line 22 only
+    EXTI_InitTypeDef init_struct;
+
+    init_struct.EXTI_Line       = EXTI_Line22;
+    init_struct.EXTI_Mode       = EXTI_Mode_Interrupt;
+    init_struct.EXTI_Trigger    = EXTI_Trigger_Rising;
+    init_struct.EXTI_LineCmd    = ENABLE;
+
+    EXTI_ClearITPendingBit(EXTI_Line22);
+    EXTI_Init(&init_struct);
+
+    // Interrupt must be enabled to wake MCU up from WFI, though it is
+    // cleared before the kernel enables interrupts
+    IRQ_manager::mask(RTC_WKUP_IRQn);
+    IRQ_manager::clear(RTC_WKUP_IRQn);
+    IRQ_manager::subscribe(RTC_WKUP_IRQn, wakeup_irq);
+    IRQ_manager::unmask(RTC_WKUP_IRQn);
+}
+
+uint32_t power::rtc_ticks()
+{
+    // Reading SSR freezes TR and DR until DR is read
+    uint32_t ssr = RTC->SSR & 0xffff;
+    uint32_t tr = RTC->TR;
+    (void)RTC->DR;
+
+    auto bcd = [tr](int shift, uint32_t mask) {
+        uint32_t v = (tr >> shift) & mask;
+        return (v >> 4) * 10 + (v & 0xf);
+    };
+
+    uint32_t sync_prediv = RTC->PRER & 0x7fff;
+    uint32_t secs = bcd(16, 0x3f) * 3600 + bcd(8, 0x7f) * 60 + bcd(0, 0x7f);
+
+    // Sub-second counter runs down from the synchronous prescaler
+    return secs * (sync_prediv + 1) + (sync_prediv - ssr);
+}
+
+void power::restore_clocks(bool overdrive)
+{
+#if (RCC_SYSCLK_SRC == HSE_CLOCK_SOURCE) \
+        || (RCC_SYSCLK_SRC == PLL_CLOCK_SOURCE && RCC_PLL_SRC == HSE_CLOCK_SOURCE)
+    // Bypass setting is kept, oscillator itself is off
+    RCC->CR |= RCC_CR_HSEON;
+    while (!(RCC->CR & RCC_CR_HSERDY)) { }
+#endif
+
+#if (RCC_SYSCLK_SRC == PLL_CLOCK_SOURCE)
+    RCC->CR |= RCC_CR_PLLON;
+    while (!(RCC->CR & RCC_CR_PLLRDY)) { }
+
+#if defined(PWR_CR_ODEN)
+    if (overdrive) {
+        PWR->CR |= PWR_CR_ODEN;
+        while (!(PWR->CSR & PWR_CSR_ODRDY)) { }
+        PWR->CR |= PWR_CR_ODSWEN;
+        while (!(PWR->CSR & PWR_CSR_ODSWRDY)) { }
+    }
+#endif
+
+    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
+    while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL) { }
+#elif (RCC_SYSCLK_SRC == HSE_CLOCK_SOURCE)
+    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_HSE;
+    while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_HSE) { }
+#endif
+
+    (void)overdrive;
+}
+
+void power::wakeup_irq()
+{
+    RTC_ClearITPendingBit(RTC_IT_WUT);
+    EXTI_ClearITPendingBit(EXTI_Line22);
+
+    IRQ_manager::clear(RTC_WKUP_IRQn);
+    IRQ_manager::unmask(RTC_WKUP_IRQn);
+}
+
+} // namespace ecl
+
+//------------------------------------------------------------------------------
+
+extern "C" uint32_t kernel_deep_sleep(uint32_t idle_us)
+{
+    using ecl::power;
+
+    if (power::select(idle_us) == ecl::power_mode::stop) {
+        return power::enter_stop(idle_us);
+    }
+
+    ++power::m_sleeps;
+    return 0;
+}
@@ -12,31 +12,61 @@
 .align
 Reset_Handler:
 			cpsid	i					@ Disable interrupts
-			ldr		r0, =___data_load	@ Obtain data address in ROM
-			ldr		r1, =___data_start  @ Obtain data start address in RAM
-			ldr		r2, =___data_end	@ Obtain data end address in RAM
-			subs	r2, r1				@ Setup a counter
-			beq		copy_data_end		@ If nothing to do
-copy_data:
-/* TODO: what if r2 == 0 ? */
-			subs	r2, r2, #4			@ Decrement a counter
-			ldr		r3, [r0, r2]		@ Load a word of data from ROM
-			str		r3, [r1, r2]		@ Store it to the RAM
-			bne		copy_data			@ If counter greather than 0
 
-copy_data_end:							@ Prepare for bss zeroing
-			ldr		r0, =___bss_start	@ Obtain bss address in RAM
-			ldr		r1, =___bss_end		@ Obtain bss address in ROM
-			subs	r1, r1, r0			@ Setup a counter
-			beq		clear_bss_end		@ If nothing to do
-			mov		r2, #0				@ Use it as a output buffer
-clear_bss:
-/* TODO: what if r1 == 0 ? */
-			subs	r1, r1, #4			@ Decrement a counter
-			str		r2, [r0, r1]		@ Store a zero word to the RAM
-			bne		clear_bss			@ If counter greather than 0
+/* Regions are described by tables, placed by linker script.
+ * Sizes are multiples of 4. Bulk of each region is moved by 16 bytes
+ * with LDM/STM, the rest is moved word by word.
+ */
+			ldr		r4, =___copy_table_start
+			ldr		r5, =___copy_table_end
+copy_table:
+			cmp		r4, r5				@ All regions are copied?
+			bhs		copy_table_end
+			ldmia	r4!, {r0, r1, r2}	@ Load address, start address, size
+			subs	r2, r2, #16			@ Is there at least one block?
+			blo		copy_words
+copy_blocks:
+			ldmia	r0!, {r3, r6, r7, r8}	@ Load 4 words from ROM
+			stmia	r1!, {r3, r6, r7, r8}	@ Store them to the RAM
+			subs	r2, r2, #16
+			bhs		copy_blocks			@ If one more block left
+copy_words:
+			adds	r2, r2, #16			@ Bytes left, 0 to 12
+			beq		copy_table			@ If nothing to do
+copy_word:
+			ldr		r3, [r0], #4		@ Load a word of data from ROM
+			str		r3, [r1], #4		@ Store it to the RAM
+			subs	r2, r2, #4
+			bne		copy_word
+			b		copy_table
+
+copy_table_end:							@ Prepare for zeroing
+			ldr		r4, =___zero_table_start
+			ldr		r5, =___zero_table_end
+			movs	r3, #0				@ Use them as a output buffer
+			movs	r6, #0
+			movs	r7, #0
+			mov		r8, #0
+zero_table:
+			cmp		r4, r5				@ All regions are zeroed?
+			bhs		zero_table_end
+			ldmia	r4!, {r0, r1}		@ Start address, size
+			subs	r1, r1, #16			@ Is there at least one block?
+			blo		zero_words
+zero_blocks:
+			stmia	r0!, {r3, r6, r7, r8}	@ Store 4 zero words to the RAM
+			subs	r1, r1, #16
+			bhs		zero_blocks			@ If one more block left
+zero_words:
+			adds	r1, r1, #16			@ Bytes left, 0 to 12
+			beq		zero_table			@ If nothing to do
+zero_word:
+			str		r3, [r0], #4		@ Store a zero word to the RAM
+			subs	r1, r1, #4
+			bne		zero_word
+			b		zero_table
 
-clear_bss_end:
+zero_table_end:
 			bl		SystemInit			@ Initialize a system
 			blx		core_main			@ Start a core
 			b		board_stop			@ Infinite loop if returned
@@ -44,7 +74,6 @@ clear_bss_end:
 .pool
 .endfunc
 
-/* TODO: assign proper handlers for first 16 interrupts */
 .section	vectors
 			.align	2 /* TODO: clarify */
 			.long  0x20020000
@@ -77,18 +106,14 @@ clear_bss_end:
 board_stop:
 			b		.					@ Infinite loop if returned
 
-.weak NMI_Handler
+/* Faults are recorded, see platform/crash.hpp. The stack, that holds
+ * the exception frame, may be broken, so the record is done on own stack.
+ */
 .weak HardFault_Handler
 .weak MemManage_Handler
 .weak BusFault_Handler
 .weak UsageFault_Handler
-.weak SVC_Handler
-.weak DebugMon_Handler
-.weak PendSV_Handler
-.weak SysTick_Handler
 
-.thumb_func
-NMI_Handler:
 .thumb_func
 HardFault_Handler:
 .thumb_func
@@ -97,6 +122,26 @@ MemManage_Handler:
 BusFault_Handler:
 .thumb_func
 UsageFault_Handler:
+			tst		lr, #4				@ Which stack holds the frame?
+			ite		eq
+			mrseq	r0, msp
+			mrsne	r0, psp
+			mov		r1, lr				@ EXC_RETURN
+			ldr		r2, =___fault_stack_top
+			mov		sp, r2
+			push	{r4-r11}
+			mov		r2, sp				@ Callee-saved registers
+			b		ecl_fault_capture	@ Never returns
+.pool
+
+.weak NMI_Handler
+.weak SVC_Handler
+.weak DebugMon_Handler
+.weak PendSV_Handler
+.weak SysTick_Handler
+
+.thumb_func
+NMI_Handler:
 .thumb_func
 SVC_Handler:
 .thumb_func
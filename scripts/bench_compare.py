@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# Compares results of benchmarks, see ecl/bench.hpp, between builds.
+#
+# Typical use is picking the compiler that produces the faster binary.
+# Build benchmarks with both toolchains and the same float ABI:
+#
+#   cmake -DCMAKE_TOOLCHAIN_FILE=toolchains/arm-cm4-gnu.cmake \
+#         -DCONFIG_FLOAT_ABI=hard -B build-gcc ... && make -C build-gcc benchmarks
+#   cmake -DCMAKE_TOOLCHAIN_FILE=toolchains/clang.cmake -B build-clang ... \
+#         && make -C build-clang benchmarks
+#
+# Run each image on the target, capture its console to a log and compare:
+#
+#   bench_compare.py gcc=gcc.log clang=clang.log [--elf gcc=img clang=img]
+#
+# Median of every benchmark is printed per build, with ratio to the first
+# build. Ratio below 1 means faster. Image sizes are printed, if given.
+
+import argparse
+import re
+import subprocess
+import sys
+
+# <name>: min <n> median <n> max <n> <unit>, ...
+RESULT = re.compile(r'^(\S+): min (\d+) median (\d+) max (\d+) (\S+?)(?:,|$)')
+
+
+def labeled(arg):
+    label, sep, path = arg.partition('=')
+    if not sep:
+        label, path = arg, arg
+    return label, path
+
+
+def parse_log(path):
+    results = {}
+    with open(path, errors='replace') as f:
+        for line in f:
+            m = RESULT.match(line.strip())
+            if m:
+                results[m.group(1)] = (int(m.group(3)), m.group(5))
+    return results
+
+
+def image_size(size_tool, elf):
+    out = subprocess.check_output([size_tool, elf], universal_newlines=True)
+    text, data, bss = out.splitlines()[1].split()[:3]
+    return int(text), int(data), int(bss)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark comparison')
+    parser.add_argument('logs', nargs='+', help='label=log, first is the reference')
+    parser.add_argument('--elf', nargs='*', default=[], help='label=image')
+    parser.add_argument('--size', default='arm-none-eabi-size', help='size of the toolchain')
+    args = parser.parse_args()
+
+    builds = [labeled(a) for a in args.logs]
+    results = [(label, parse_log(path)) for label, path in builds]
+
+    names = []
+    for _, res in results:
+        names.extend(n for n in res if n not in names)
+
+    if not names:
+        print('No benchmark results found', file=sys.stderr)
+        return 1
+
+    width = max(len(n) for n in names)
+    header = '{:<{w}}'.format('benchmark', w=width)
+    for label, _ in results:
+        header += ' {:>12}'.format(label)
+    for label, _ in results[1:]:
+        header += ' {:>8}'.format(label + '/' + results[0][0])
+    print(header)
+
+    ratios = [[] for _ in results[1:]]
+    for name in names:
+        line = '{:<{w}}'.format(name, w=width)
+        for _, res in results:
+            line += ' {:>12}'.format('{} {}'.format(*res[name]) if name in res else '-')
+
+        ref = results[0][1].get(name)
+        for i, (_, res) in enumerate(results[1:]):
+            if ref and ref[0] and name in res:
+                r = res[name][0] / ref[0]
+                ratios[i].append(r)
+                line += ' {:>8.3f}'.format(r)
+            else:
+                line += ' {:>8}'.format('-')
+        print(line)
+
+    # Geometric mean weights every benchmark equally
+    line = '{:<{w}}'.format('geomean', w=width) + ' ' * 13 * len(results)
+    for r in ratios:
+        mean = 1.0
+        for x in r:
+            mean *= x
+        line += ' {:>8.3f}'.format(mean ** (1.0 / len(r)) if r else float('nan'))
+    print(line)
+
+    if args.elf:
+        print()
+        print('{:<12} {:>8} {:>8} {:>8}'.format('image', 'text', 'data', 'bss'))
+        for label, elf in (labeled(a) for a in args.elf):
+            print('{:<12} {:>8} {:>8} {:>8}'.format(label, *image_size(args.size, elf)))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
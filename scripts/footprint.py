@@ -0,0 +1,340 @@
+#!/usr/bin/env python3
+# Reports flash and RAM footprint of a linked image.
+#
+# Sizes are attributed per library, using the linker map file, and per
+# template instantiation, using symbols of the image. Report can be saved
+# and compared against a previous one:
+#
+#   footprint.py --elf app --map app.map --save new.json --baseline old.json
+#
+# Build without LTO, i.e. with the size profile: LTO merges objects of all
+# libraries, so map file no longer tells where code comes from.
+# Code, inlined into callers, is attributed to the callers.
+
+import argparse
+import json
+import re
+import subprocess
+import sys
+
+KINDS = ('text', 'data', 'bss')
+
+# Target of objects, compiled by CMake: CMakeFiles/<target>.dir/...
+CMAKE_OBJECT = re.compile(r'CMakeFiles/([^/]+)\.dir/')
+# Archive member: path/libname.a(object)
+ARCHIVE_MEMBER = re.compile(r'([^/\s]+\.a)\(')
+# Memory region: name origin length [attributes]
+REGION = re.compile(r'^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+# Output section: .name [addr size] [load address addr]
+OUT_SECTION = re.compile(r'^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?')
+# Address, size and input file, either after input section or on the next line
+IN_PLACEMENT = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+
+
+def owner(path):
+    """Gets library or target, that input file belongs to."""
+    m = ARCHIVE_MEMBER.search(path)
+    if m:
+        return m.group(1)
+
+    m = CMAKE_OBJECT.search(path)
+    if m:
+        return m.group(1)
+
+    return path.rsplit('/', 1)[-1]
+
+
+def classify(name, addr, loaded, regions):
+    """Gets kind of the output section, placed at given address."""
+    for region, (origin, length) in regions.items():
+        if origin <= addr < origin + length:
+            if 'flash' in region.lower() or 'rom' in region.lower():
+                return 'text'
+
+            # Section with a load address is copied from flash on startup
+            return 'data' if loaded else 'bss'
+
+    # No memory regions, i.e. on host
+    if name.startswith(('.bss', '.tbss', '.noinit')):
+        return 'bss'
+    if name.startswith(('.data', '.tdata')):
+        return 'data'
+    return 'text'
+
+
+def parse_map(path):
+    """Gets sizes per owner and kind, and usage of memory regions
+    from GNU ld map file."""
+    with open(path) as f:
+        lines = f.read().splitlines()
+
+    regions = {}
+    usage = {}
+    libraries = {}
+    kind = None
+    in_regions = False
+    in_memory_map = False
+    pending = None
+
+    for i, line in enumerate(lines):
+        if line.startswith('Memory Configuration'):
+            in_regions = True
+            continue
+
+        if line.startswith('Linker script and memory map'):
+            in_regions = False
+            in_memory_map = True
+            continue
+
+        if in_regions:
+            m = REGION.match(line)
+            if m and m.group(1) != '*default*' and m.group(1) != 'Name':
+                regions[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+            continue
+
+        if not in_memory_map:
+            continue
+
+        m = OUT_SECTION.match(line)
+        if m:
+            name = m.group(1)
+            # Output sections of debug info are not loaded
+            if name.startswith(('.debug', '.comment', '.ARM.attributes', '.stab')):
+                kind = None
+                continue
+
+            addr, size = m.group(2), m.group(3)
+            if addr is None and i + 1 < len(lines):
+                nxt = re.match(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)', lines[i + 1])
+                addr, size = nxt.groups() if nxt else ('0', '0')
+
+            addr, size = int(addr, 16), int(size, 16)
+            loaded = 'load address' in line or \
+                (i + 1 < len(lines) and 'load address' in lines[i + 1])
+            kind = classify(name, addr, loaded, regions)
+            pending = None
+
+            for region, (origin, length) in regions.items():
+                if origin <= addr < origin + length:
+                    usage[region] = usage.get(region, 0) + size
+                    # Initial values of data are kept in flash
+                    if kind == 'data':
+                        flash = [r for r in regions if 'flash' in r.lower()]
+                        if flash:
+                            usage[flash[0]] = usage.get(flash[0], 0) + size
+            continue
+
+        if kind is None:
+            continue
+
+        if line.startswith(' *fill*'):
+            m = re.match(r'^ \*fill\*\s+0x[0-9a-fA-F]+\s+0x([0-9a-fA-F]+)', line)
+            if m:
+                add(libraries, '(fill)', kind, int(m.group(1), 16))
+            continue
+
+        # Input section: name alone, or name with placement
+        m = re.match(r'^ (\.\S+|COMMON)(.*)$', line)
+        if m:
+            rest = IN_PLACEMENT.match(m.group(2))
+            if rest:
+                add(libraries, owner(rest.group(3)), kind, int(rest.group(2), 16))
+            elif not m.group(2).strip():
+                pending = kind
+            continue
+
+        if pending:
+            m = IN_PLACEMENT.match(line)
+            if m and not m.group(3).startswith(('0x', '*')):
+                add(libraries, owner(m.group(3)), pending, int(m.group(2), 16))
+            pending = None
+
+    budget = {r: {'used': usage.get(r, 0), 'length': length}
+              for r, (origin, length) in regions.items()}
+    return libraries, budget
+
+
+def add(table, key, kind, size):
+    entry = table.setdefault(key, dict.fromkeys(KINDS, 0))
+    entry[kind] += size
+
+
+def strip_args(name):
+    """Gets name of the template, with all arguments removed."""
+    out = []
+    depth = 0
+    for c in name:
+        if c == '<':
+            depth += 1
+        elif c == '>':
+            depth -= 1
+        elif depth == 0:
+            out.append(c)
+    return ''.join(out)
+
+
+def split_scope(name):
+    """Splits qualified name by scope, ignoring scopes in template arguments."""
+    parts = []
+    depth = 0
+    start = 0
+    i = 0
+    while i < len(name):
+        c = name[i]
+        if c in '<(':
+            depth += 1
+        elif c in '>)':
+            depth -= 1
+        elif depth == 0 and name.startswith('::', i):
+            parts.append(name[start:i])
+            start = i + 2
+            i += 1
+        i += 1
+    parts.append(name[start:])
+    return parts
+
+
+def instantiation(symbol):
+    """Gets template instantiation, that symbol belongs to, or None."""
+    # Drop parameters and qualifiers of the function
+    depth = 0
+    for i, c in enumerate(symbol):
+        if c == '<':
+            depth += 1
+        elif c == '>':
+            depth -= 1
+        elif c == '(' and depth == 0:
+            symbol = symbol[:i]
+            break
+
+    parts = split_scope(symbol)
+    for i in range(len(parts) - 1, -1, -1):
+        if '<' in parts[i]:
+            return '::'.join(parts[:i + 1])
+
+    return None
+
+
+def parse_symbols(nm, elf):
+    """Gets sizes per template instantiation from symbols of the image."""
+    out = subprocess.check_output([nm, '-C', '-S', '--size-sort', '-t', 'd', elf],
+                                  universal_newlines=True)
+    instances = {}
+
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) != 4:
+            continue
+
+        size, kind, symbol = int(fields[1]), fields[2].lower(), fields[3]
+        key = instantiation(symbol)
+        if not key:
+            continue
+
+        # Instantiations are weak: W for code, V for objects
+        if kind in 'trw':
+            add(instances, key, 'text', size)
+        elif kind in 'dgvu':
+            add(instances, key, 'data', size)
+        elif kind in 'bs':
+            add(instances, key, 'bss', size)
+
+    templates = {}
+    for key, sizes in instances.items():
+        entry = templates.setdefault(strip_args(key), dict(dict.fromkeys(KINDS, 0), count=0))
+        entry['count'] += 1
+        for k in KINDS:
+            entry[k] += sizes[k]
+
+    return instances, templates
+
+
+def total(entry):
+    return sum(entry[k] for k in KINDS)
+
+
+def print_table(title, table, baseline, top, extra=None):
+    print(title)
+    header = '{:>8} {:>8} {:>8}'.format(*KINDS)
+    if baseline is not None:
+        header += ' {:>8}'.format('delta')
+    if extra:
+        header += ' {:>5}'.format(extra)
+    print(header + '  name')
+
+    rows = sorted(table.items(), key=lambda kv: total(kv[1]), reverse=True)
+    if baseline is not None:
+        # Removed entries are reported as well
+        for key in baseline:
+            if key not in table:
+                rows.append((key, dict(dict.fromkeys(KINDS, 0), count=0)))
+
+    for key, entry in rows[:top] if top else rows:
+        line = '{:>8} {:>8} {:>8}'.format(*(entry[k] for k in KINDS))
+        if baseline is not None:
+            old = total(baseline[key]) if key in baseline else 0
+            line += ' {:>+8}'.format(total(entry) - old)
+        if extra:
+            line += ' {:>5}'.format(entry.get(extra, ''))
+        print(line + '  ' + key)
+
+    sums = [sum(e[k] for e in table.values()) for k in KINDS]
+    line = '{:>8} {:>8} {:>8}'.format(*sums)
+    if baseline is not None:
+        line += ' {:>+8}'.format(sum(sums) - sum(total(e) for e in baseline.values()))
+    print(line + '  (total)\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Flash and RAM footprint report')
+    parser.add_argument('--elf', required=True, help='Linked image')
+    parser.add_argument('--map', help='Linker map file, enables per-library report')
+    parser.add_argument('--nm', default='nm', help='nm of the toolchain')
+    parser.add_argument('--top', type=int, default=25,
+                        help='Instantiations to print, 0 for all')
+    parser.add_argument('--save', help='Writes report as JSON, to be used as baseline')
+    parser.add_argument('--baseline', help='Report, saved earlier, to compare with')
+    args = parser.parse_args()
+
+    report = {}
+    if args.map:
+        report['libraries'], report['regions'] = parse_map(args.map)
+    report['instances'], report['templates'] = parse_symbols(args.nm, args.elf)
+
+    baseline = {}
+    if args.baseline:
+        try:
+            with open(args.baseline) as f:
+                baseline = json.load(f)
+        except (IOError, ValueError) as e:
+            print('Baseline is not used: {}'.format(e), file=sys.stderr)
+            args.baseline = None
+
+    def base(key):
+        return baseline.get(key, {}) if args.baseline else None
+
+    if report.get('regions'):
+        print('Per memory region, bytes:')
+        for region, r in sorted(report['regions'].items()):
+            line = '{:>8} of {:>8} {:>5.1f}%'.format(r['used'], r['length'],
+                                                   100.0 * r['used'] / max(r['length'], 1))
+            old = base('regions')
+            if old is not None and region in old:
+                line += ' {:>+8}'.format(r['used'] - old[region]['used'])
+            print(line + '  ' + region)
+        print()
+
+    if 'libraries' in report:
+        print_table('Per library, bytes:', report['libraries'], base('libraries'), 0)
+    print_table('Per template, all instantiations, bytes:', report['templates'],
+                base('templates'), args.top, extra='count')
+    print_table('Per template instantiation, bytes:', report['instances'],
+                base('instances'), args.top)
+
+    if args.save:
+        with open(args.save, 'w') as f:
+            json.dump(report, f, indent=1, sort_keys=True)
+
+
+if __name__ == '__main__':
+    main()
@@ -1,4 +1,137 @@
-// TODO: fill it when C++ concepts will be ready
-// This header will expose IODevLike concept
-// that will specify constraints for every type
-// that acts like input-output device
+#ifndef SYS_IODEV_IODEV_HPP_
+#define SYS_IODEV_IODEV_HPP_
+
+//!
+//! \file
+//! \brief IODevLike contract.
+//! Any type that moves bytes through
+//! \code
+//!     ssize_t write(const uint8_t *data, size_t count);
+//!     ssize_t read(uint8_t *buffer, size_t size);
+//! \endcode
+//! acts like input-output device, i.e. ecl::bus_pipe. At least one of them
+//! must be present. Both return amount of bytes transferred, or negative
+//! value if error occurred before any byte was transferred.
+//! Optional members:
+//! \code
+//!     ecl::err init();    // Lazy initialization.
+//!     ecl::err flush();   // Pushes pending output to the device.
+//! \endcode
+//! C++14 has no concepts, so the contract is checked by traits below,
+//! intended for static_assert:
+//! \code
+//!     static_assert(ecl::is_iodev< my_device >::value, "Not IODevLike");
+//! \endcode
+//!
+
+#include <ecl/err.hpp>
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace ecl
+{
+
+//! \cond INTERNAL
+namespace iodev_detail
+{
+
+template< class... >
+struct make_void { using type = void; };
+
+template< class... T >
+using void_t = typename make_void< T... >::type;
+
+template< class T, class = void >
+struct has_write : std::false_type { };
+
+template< class T >
+struct has_write< T, void_t< decltype(std::declval< T& >().write(
+    std::declval< const uint8_t * >(), std::declval< size_t >())) > >
+    : std::is_convertible< decltype(std::declval< T& >().write(
+        std::declval< const uint8_t * >(), std::declval< size_t >())), ssize_t > { };
+
+template< class T, class = void >
+struct has_read : std::false_type { };
+
+template< class T >
+struct has_read< T, void_t< decltype(std::declval< T& >().read(
+    std::declval< uint8_t * >(), std::declval< size_t >())) > >
+    : std::is_convertible< decltype(std::declval< T& >().read(
+        std::declval< uint8_t * >(), std::declval< size_t >())), ssize_t > { };
+
+template< class T, class = void >
+struct has_init : std::false_type { };
+
+template< class T >
+struct has_init< T, void_t< decltype(std::declval< T& >().init()) > >
+    : std::is_same< decltype(std::declval< T& >().init()), err > { };
+
+template< class T, class = void >
+struct has_flush : std::false_type { };
+
+template< class T >
+struct has_flush< T, void_t< decltype(std::declval< T& >().flush()) > >
+    : std::is_same< decltype(std::declval< T& >().flush()), err > { };
+
+template< class Dev >
+err init(Dev &dev, std::true_type) { return dev.init(); }
+
+template< class Dev >
+err init(Dev &, std::false_type) { return err::ok; }
+
+template< class Dev >
+err flush(Dev &dev, std::true_type) { return dev.flush(); }
+
+template< class Dev >
+err flush(Dev &, std::false_type) { return err::ok; }
+
+} // namespace iodev_detail
+//! \endcond
+
+//!
+//! \brief Checks if a device can be written.
+//!
+template< class T >
+struct is_writable : iodev_detail::has_write< T > { };
+
+//!
+//! \brief Checks if a device can be read.
+//!
+template< class T >
+struct is_readable : iodev_detail::has_read< T > { };
+
+//!
+//! \brief Checks if a type is IODevLike.
+//!
+template< class T >
+struct is_iodev
+    : std::integral_constant< bool, is_writable< T >::value || is_readable< T >::value > { };
+
+//!
+//! \brief Initializes a device, if it requires initialization.
+//! \return Result of Dev::init(), or err::ok if device has no init().
+//!
+template< class Dev >
+err iodev_init(Dev &dev)
+{
+    return iodev_detail::init(dev, iodev_detail::has_init< Dev >{});
+}
+
+//!
+//! \brief Flushes a device, if it buffers output.
+//! \return Result of Dev::flush(), or err::ok if device has no flush().
+//!
+template< class Dev >
+err iodev_flush(Dev &dev)
+{
+    return iodev_detail::flush(dev, iodev_detail::has_flush< Dev >{});
+}
+
+} // namespace ecl
+
+#endif // SYS_IODEV_IODEV_HPP_
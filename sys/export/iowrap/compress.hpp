@@ -0,0 +1,349 @@
+#ifndef SYS_IOWRAP_COMPRESS_HPP_
+#define SYS_IOWRAP_COMPRESS_HPP_
+
+//!
+//! \file
+//! \brief Streaming LZSS compression with fixed memory.
+//! Format follows heatshrink: stream of bit tokens, MSB first. Token is
+//! either a literal:
+//! \code
+//!     1 | byte (8 bits)
+//! \endcode
+//! or a back reference to recent output:
+//! \code
+//!     0 | distance - 1 (window_bits) | length - min_match (lookahead_bits)
+//! \endcode
+//! Back reference with both fields zero ends a stream, remaining bits
+//! of the last byte are zero. Nothing is allocated dynamically, wrapper
+//! stores three windows of history at most.
+//! Files are wrapped by ecl::iodev_ptr:
+//! \code
+//!     ecl::compress< ecl::iodev_ptr< fs::file_ptr > > log{fs.open("/sd/log.lz")};
+//!     log.write(record, size);
+//!     log.flush();
+//! \endcode
+//!
+
+#include "iowrap.hpp"
+
+namespace ecl
+{
+
+//!
+//! \brief Compresses bytes written to a device and decompresses bytes read
+//! from it.
+//! Encoder holds up to two windows of data until flush() is called.
+//! flush() ends the stream, i.e. next write starts a new one, without
+//! references to previously written data. Reader handles a sequence of
+//! streams transparently.
+//! \tparam Dev            Wrapped device.
+//! \tparam window_bits    Log2 of history size, 4 to 12. Larger window
+//!                        gives better ratio but slower encoding.
+//! \tparam lookahead_bits Log2 of longest match, from 2 to window_bits - 1.
+//!
+template< class Dev, unsigned window_bits = 8, unsigned lookahead_bits = 4 >
+class compress : public iowrap_base< Dev >
+{
+    static_assert(window_bits >= 4 && window_bits <= 12, "Unsupported window");
+    static_assert(lookahead_bits >= 2 && lookahead_bits < window_bits,
+                  "Unsupported lookahead");
+
+    using base = iowrap_base< Dev >;
+
+public:
+    enum : size_t
+    {
+        //! Size of history.
+        window      = 1 << window_bits,
+        //! Shortest match, which takes less bits than literals.
+        min_match   = (1 + window_bits + lookahead_bits) / 9 + 1,
+        //! Longest match.
+        max_match   = (1 << lookahead_bits) - 1 + min_match,
+    };
+
+    using base::base;
+
+    //!
+    //! \brief Compresses bytes into the device.
+    //! \return Amount of bytes accepted, or -1 if device failed.
+    //!
+    ssize_t write(const uint8_t *data, size_t count);
+
+    //!
+    //! \brief Decompresses bytes from the device.
+    //! Device is read byte by byte, wrap it into ecl::buffered if
+    //! it is costly.
+    //! \return Amount of bytes produced, or device error if none were.
+    //!
+    ssize_t read(uint8_t *buffer, size_t count);
+
+    //!
+    //! \brief Ends the stream: encodes pending bytes, sends them and
+    //! flushes wrapped device.
+    //!
+    err flush();
+
+private:
+    enum : uint32_t
+    {
+        literal_bits    = 9,
+        ref_bits        = 1 + window_bits + lookahead_bits,
+        out_size        = 32,
+    };
+
+    //! Encodes buffered bytes. Last max_match bytes are kept, unless
+    //! stream is ending, since longer match may follow.
+    bool encode(bool final);
+
+    //! Finds longest match for given position of the encoder buffer.
+    size_t find_match(size_t pos, size_t avail, size_t &distance) const;
+
+    //! Puts bits of a token to output.
+    bool put_bits(uint32_t bits, unsigned n);
+
+    //! Sends output buffer to the device.
+    bool send_output();
+
+    //! Gets bits of a token from the device, without consuming them.
+    //! \return 1 if bits are obtained, result of device read otherwise.
+    ssize_t get_bits(unsigned n, uint32_t &bits);
+
+    // Encoder
+    uint8_t     m_enc[2 * window];      //!< History and bytes to encode.
+    size_t      m_enc_len = 0;          //!< Bytes in encoder buffer.
+    size_t      m_enc_pos = 0;          //!< First byte to encode.
+    uint8_t     m_out[out_size];        //!< Encoded bytes.
+    size_t      m_out_len = 0;          //!< Amount of encoded bytes.
+    uint32_t    m_out_acc = 0;          //!< Bits of incomplete byte.
+    unsigned    m_out_bits = 0;         //!< Amount of bits in accumulator.
+
+    // Decoder
+    uint8_t     m_win[window];          //!< Decoded history.
+    size_t      m_win_pos = 0;          //!< Next position in history.
+    size_t      m_ref_dist = 0;         //!< Distance of back reference.
+    size_t      m_ref_left = 0;         //!< Bytes left to copy.
+    uint32_t    m_in_acc = 0;           //!< Bits read from the device.
+    unsigned    m_in_bits = 0;          //!< Amount of bits in accumulator.
+};
+
+//------------------------------------------------------------------------------
+
+template< class Dev, unsigned window_bits, unsigned lookahead_bits >
+ssize_t compress< Dev, window_bits, lookahead_bits >::write(const uint8_t *data, size_t count)
+{
+    size_t accepted = 0;
+
+    while (accepted < count) {
+        size_t chunk = std::min(count - accepted, sizeof(m_enc) - m_enc_len);
+        std::copy(data + accepted, data + accepted + chunk, m_enc + m_enc_len);
+        m_enc_len += chunk;
+        accepted += chunk;
+
+        if (m_enc_len == sizeof(m_enc) && !encode(false)) {
+            return -1;
+        }
+    }
+
+    return accepted;
+}
+
+template< class Dev, unsigned window_bits, unsigned lookahead_bits >
+ssize_t compress< Dev, window_bits, lookahead_bits >::read(uint8_t *buffer, size_t count)
+{
+    size_t produced = 0;
+    ssize_t rc = 1;
+    uint32_t bits;
+
+    while (produced < count) {
+        if (m_ref_left) {
+            // Reference may overlap bytes it produces
+            uint8_t byte = m_win[(m_win_pos - m_ref_dist) & (window - 1)];
+            m_win[m_win_pos++ & (window - 1)] = byte;
+            buffer[produced++] = byte;
+            --m_ref_left;
+            continue;
+        }
+
+        if ((rc = get_bits(1, bits)) != 1) {
+            break;
+        }
+
+        if (bits) {
+            if ((rc = get_bits(literal_bits, bits)) != 1) {
+                break;
+            }
+
+            uint8_t byte = bits;
+            m_win[m_win_pos++ & (window - 1)] = byte;
+            buffer[produced++] = byte;
+            m_in_bits -= literal_bits;
+            continue;
+        }
+
+        if ((rc = get_bits(ref_bits, bits)) != 1) {
+            break;
+        }
+
+        m_in_bits -= ref_bits;
+
+        size_t dist = (bits >> lookahead_bits) & (window - 1);
+        size_t len = bits & ((1 << lookahead_bits) - 1);
+
+        if (!dist && !len) {
+            // End of stream, rest of the byte is padding
+            m_in_bits = 0;
+            continue;
+        }
+
+        m_ref_dist = dist + 1;
+        m_ref_left = len + min_match;
+    }
+
+    return produced ? static_cast< ssize_t >(produced) : (rc < 0 ? -1 : 0);
+}
+
+template< class Dev, unsigned window_bits, unsigned lookahead_bits >
+err compress< Dev, window_bits, lookahead_bits >::flush()
+{
+    if (m_enc_len || m_out_bits || m_out_len) {
+        if (!encode(true) || !put_bits(0, ref_bits)) {
+            return err::io;
+        }
+
+        // Stream ends at byte boundary
+        if (m_out_bits % 8 && !put_bits(0, 8 - m_out_bits % 8)) {
+            return err::io;
+        }
+
+        if (!send_output()) {
+            return err::io;
+        }
+
+        m_enc_len = m_enc_pos = 0;
+    }
+
+    return base::flush();
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< class Dev, unsigned window_bits, unsigned lookahead_bits >
+bool compress< Dev, window_bits, lookahead_bits >::encode(bool final)
+{
+    size_t end = final ? m_enc_len : m_enc_len - max_match + 1;
+
+    while (m_enc_pos < end) {
+        size_t distance = 0;
+        size_t len = find_match(m_enc_pos, m_enc_len - m_enc_pos, distance);
+        bool ok;
+
+        if (len) {
+            uint32_t token = (distance - 1) << lookahead_bits | (len - min_match);
+            ok = put_bits(token, ref_bits);
+        } else {
+            len = 1;
+            ok = put_bits(0x100 | m_enc[m_enc_pos], literal_bits);
+        }
+
+        if (!ok) {
+            return false;
+        }
+
+        m_enc_pos += len;
+    }
+
+    // Slide history, so encoder buffer can take more bytes
+    if (!final && m_enc_pos > window) {
+        size_t shift = m_enc_pos - window;
+        std::copy(m_enc + shift, m_enc + m_enc_len, m_enc);
+        m_enc_len -= shift;
+        m_enc_pos -= shift;
+    }
+
+    return true;
+}
+
+template< class Dev, unsigned window_bits, unsigned lookahead_bits >
+size_t compress< Dev, window_bits, lookahead_bits >::find_match(size_t pos, size_t avail,
+                                                                size_t &distance) const
+{
+    size_t limit = std::min< size_t >(avail, max_match);
+    size_t best = 0;
+    size_t first = pos > window ? pos - window : 0;
+
+    if (limit < min_match) {
+        return 0;
+    }
+
+    // Nearest match wins among equal ones
+    for (size_t i = pos; i-- > first; ) {
+        size_t len = 0;
+        while (len < limit && m_enc[i + len] == m_enc[pos + len]) {
+            ++len;
+        }
+
+        // Shortest match at distance 1 is reserved as end of stream
+        if (len > best && !(pos - i == 1 && len == min_match)) {
+            best = len;
+            distance = pos - i;
+
+            if (len == limit) {
+                break;
+            }
+        }
+    }
+
+    return best >= min_match ? best : 0;
+}
+
+template< class Dev, unsigned window_bits, unsigned lookahead_bits >
+bool compress< Dev, window_bits, lookahead_bits >::put_bits(uint32_t bits, unsigned n)
+{
+    m_out_acc = m_out_acc << n | (bits & ((1u << n) - 1));
+    m_out_bits += n;
+
+    while (m_out_bits >= 8) {
+        m_out_bits -= 8;
+        m_out[m_out_len++] = m_out_acc >> m_out_bits;
+
+        if (m_out_len == out_size && !send_output()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template< class Dev, unsigned window_bits, unsigned lookahead_bits >
+bool compress< Dev, window_bits, lookahead_bits >::send_output()
+{
+    size_t len = m_out_len;
+    m_out_len = 0;
+
+    return iowrap_detail::write_all(this->m_dev, m_out, len);
+}
+
+template< class Dev, unsigned window_bits, unsigned lookahead_bits >
+ssize_t compress< Dev, window_bits, lookahead_bits >::get_bits(unsigned n, uint32_t &bits)
+{
+    // Token is consumed by the caller, so incomplete one survives
+    // until device provides the rest
+    while (m_in_bits < n) {
+        uint8_t byte;
+        auto rc = this->m_dev.read(&byte, 1);
+        if (rc != 1) {
+            return rc;
+        }
+
+        m_in_acc = m_in_acc << 8 | byte;
+        m_in_bits += 8;
+    }
+
+    bits = (m_in_acc >> (m_in_bits - n)) & ((1u << n) - 1);
+    return 1;
+}
+
+} // namespace ecl
+
+#endif // SYS_IOWRAP_COMPRESS_HPP_
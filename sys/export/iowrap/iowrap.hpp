@@ -1,4 +1,719 @@
-// TODO: fill it when C++ concepts will be ready
-// This header will expose IOWrapperLike concept
-// that will specify constraints for every type
-// that acts like input-output device wrapper
+#ifndef SYS_IOWRAP_IOWRAP_HPP_
+#define SYS_IOWRAP_IOWRAP_HPP_
+
+//!
+//! \file
+//! \brief IOWrapperLike contract and compile-time device wrappers.
+//! Wrapper is IODevLike itself, and holds wrapped device by value, so
+//! wrappers compose into a pipeline, resolved at compile time:
+//! \code
+//!     ecl::buffered< ecl::crc< ecl::bus_pipe< uart_bus > >, 32 > out;
+//!     out.init();
+//!     out.write(data, size);
+//!     out.flush();
+//!     auto sum = out.device().tx_crc();
+//! \endcode
+//! No calls are virtual, each layer is inlined into its caller.
+//! Constructor arguments of a wrapper are forwarded down to the innermost
+//! device. init() and flush() are forwarded down, if device has them.
+//!
+
+#include <iodev/iodev.hpp>
+
+#include <ecl/crc.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace ecl
+{
+
+//! \cond INTERNAL
+namespace iowrap_detail
+{
+
+template< class T, class = void >
+struct has_device : std::false_type { };
+
+template< class T >
+struct has_device< T, iodev_detail::void_t< typename T::device_type > >
+    : std::is_same< decltype(std::declval< T& >().device()), typename T::device_type & > { };
+
+//! Writes all bytes to a device, or fails.
+template< class Dev >
+bool write_all(Dev &dev, const uint8_t *data, size_t count)
+{
+    while (count) {
+        auto rc = dev.write(data, count);
+        if (rc <= 0) {
+            return false;
+        }
+
+        data += rc;
+        count -= rc;
+    }
+
+    return true;
+}
+
+template< class T, bool = has_device< T >::value >
+struct is_iowrapper : std::false_type { };
+
+template< class T >
+struct is_iowrapper< T, true >
+    : std::integral_constant< bool, is_iodev< T >::value
+                                    && is_iodev< typename T::device_type >::value > { };
+
+} // namespace iowrap_detail
+//! \endcond
+
+//!
+//! \brief Checks if a type is IOWrapperLike: it is IODevLike, names wrapped
+//! device as device_type and exposes it through device().
+//!
+template< class T >
+struct is_iowrapper : iowrap_detail::is_iowrapper< T > { };
+
+//!
+//! \brief Adapts a pointer to a device, so it can be wrapped.
+//! Allows wrapping of devices that can't be held by value, i.e. files
+//! opened by fs::fs::open() or devices shared with other code.
+//! \tparam Ptr Pointer to a device, raw or smart one.
+//!
+template< class Ptr >
+class iodev_ptr
+{
+public:
+    //!
+    //! \brief Constructs adapter, pointing to given device.
+    //!
+    iodev_ptr(Ptr dev) :m_dev{std::move(dev)} { }
+
+    //! \copydoc ecl::bus_pipe::write()
+    ssize_t write(const uint8_t *data, size_t count) { return m_dev->write(data, count); }
+
+    //! \copydoc ecl::bus_pipe::read()
+    ssize_t read(uint8_t *buffer, size_t count) { return m_dev->read(buffer, count); }
+
+    //!
+    //! \brief Gets the pointer.
+    //!
+    Ptr &get() { return m_dev; }
+
+private:
+    Ptr m_dev; //!< Pointer to a device.
+};
+
+//!
+//! \brief Base of device wrappers.
+//! \tparam Dev Wrapped IODevLike device.
+//!
+template< class Dev >
+class iowrap_base
+{
+    static_assert(is_iodev< Dev >::value, "Wrapped type is not IODevLike");
+
+public:
+    //! Wrapped device.
+    using device_type = Dev;
+
+    //!
+    //! \brief Constructs wrapped device using given arguments.
+    //!
+    template< class... Args >
+    explicit iowrap_base(Args&&... args) :m_dev{std::forward< Args >(args)...} { }
+
+    //!
+    //! \brief Initializes wrapped device, if it requires initialization.
+    //!
+    err init() { return iodev_init(m_dev); }
+
+    //!
+    //! \brief Flushes wrapped device, if it buffers output.
+    //!
+    err flush() { return iodev_flush(m_dev); }
+
+    //!
+    //! \brief Gets wrapped device.
+    //!
+    Dev &device() { return m_dev; }
+
+protected:
+    Dev m_dev; //!< Wrapped device.
+};
+
+//!
+//! \brief Buffers bytes written to a device and read from it.
+//! Output is sent when buffer is full or flushed. Writes larger than
+//! buffer bypass it, if it is empty. Input is read in chunks of buffer
+//! size, so read buffering suits devices completing reads partially,
+//! i.e. on idle line.
+//! \tparam Dev  Wrapped device.
+//! \tparam size Size of each buffer.
+//!
+template< class Dev, size_t size = 64 >
+class buffered : public iowrap_base< Dev >
+{
+    static_assert(size > 0, "Buffer must not be empty");
+
+    using base = iowrap_base< Dev >;
+
+public:
+    using base::base;
+
+    //!
+    //! \brief Buffers bytes, sending them to device when buffer is full.
+    //! \return Amount of bytes accepted, or -1 if nothing was accepted
+    //!         because device failed.
+    //!
+    ssize_t write(const uint8_t *data, size_t count);
+
+    //!
+    //! \brief Reads bytes, buffered or obtained from device.
+    //! \return Amount of bytes read, or device error if nothing was read.
+    //!
+    ssize_t read(uint8_t *buffer, size_t count);
+
+    //!
+    //! \brief Sends buffered output and flushes wrapped device.
+    //!
+    err flush();
+
+    //!
+    //! \brief Gets amount of bytes waiting in output buffer.
+    //!
+    size_t pending() const { return m_tx_len; }
+
+private:
+    uint8_t m_tx[size];     //!< Output buffer.
+    size_t  m_tx_len = 0;   //!< Bytes in output buffer.
+    uint8_t m_rx[size];     //!< Input buffer.
+    size_t  m_rx_pos = 0;   //!< First unread byte of input buffer.
+    size_t  m_rx_len = 0;   //!< Bytes in input buffer.
+};
+
+//!
+//! \brief Computes CRC-16/CCITT of bytes passed through a device.
+//! \sa ecl::crc16()
+//! \tparam Dev Wrapped device.
+//!
+template< class Dev >
+class crc : public iowrap_base< Dev >
+{
+    using base = iowrap_base< Dev >;
+
+public:
+    using base::base;
+
+    //! \copydoc ecl::bus_pipe::write()
+    ssize_t write(const uint8_t *data, size_t count);
+
+    //! \copydoc ecl::bus_pipe::read()
+    ssize_t read(uint8_t *buffer, size_t count);
+
+    //!
+    //! \brief Gets CRC of bytes written since last reset.
+    //!
+    uint16_t tx_crc() const { return m_tx_crc; }
+
+    //!
+    //! \brief Gets CRC of bytes read since last reset.
+    //!
+    uint16_t rx_crc() const { return m_rx_crc; }
+
+    //!
+    //! \brief Starts new CRC computation in both directions.
+    //!
+    void reset_crc() { m_tx_crc = m_rx_crc = 0; }
+
+private:
+    uint16_t m_tx_crc = 0;  //!< CRC of output.
+    uint16_t m_rx_crc = 0;  //!< CRC of input.
+};
+
+//!
+//! \brief Splits a byte stream into frames, using SLIP encoding (RFC 1055).
+//! Each write sends one frame, each read returns one frame. Frame is
+//! terminated by END byte, END and ESC bytes inside it are escaped.
+//! \tparam Dev Wrapped device.
+//!
+template< class Dev >
+class framed : public iowrap_base< Dev >
+{
+    using base = iowrap_base< Dev >;
+
+public:
+    //! SLIP special bytes.
+    enum : uint8_t
+    {
+        end     = 0xc0, //!< Frame terminator.
+        esc     = 0xdb, //!< Escape.
+        esc_end = 0xdc, //!< Escaped END.
+        esc_esc = 0xdd, //!< Escaped ESC.
+    };
+
+    using base::base;
+
+    //!
+    //! \brief Sends bytes as a single frame.
+    //! \return Amount of bytes sent, or -1 if device failed.
+    //!
+    ssize_t write(const uint8_t *data, size_t count);
+
+    //!
+    //! \brief Receives a frame. Empty frames are skipped.
+    //! \return Length of the frame, or -1 if device failed or frame is
+    //!         longer than buffer. Such frame is discarded.
+    //!
+    ssize_t read(uint8_t *buffer, size_t count);
+
+private:
+    //! Reads single byte from device.
+    bool get(uint8_t &byte) { return this->m_dev.read(&byte, 1) == 1; }
+};
+
+//!
+//! \brief Compresses bytes written to a device and decompresses bytes read
+//! from it, using PackBits run-length encoding.
+//! Encoder holds pending bytes until run ends or flush() is called.
+//! \tparam Dev Wrapped device.
+//!
+template< class Dev >
+class packbits : public iowrap_base< Dev >
+{
+    using base = iowrap_base< Dev >;
+
+public:
+    using base::base;
+
+    //!
+    //! \brief Compresses bytes into the device.
+    //! \return Amount of bytes accepted, or -1 if device failed.
+    //!
+    ssize_t write(const uint8_t *data, size_t count);
+
+    //!
+    //! \brief Decompresses bytes from the device.
+    //! \return Amount of bytes produced, or device error if none were.
+    //!
+    ssize_t read(uint8_t *buffer, size_t count);
+
+    //!
+    //! \brief Encodes pending bytes and flushes wrapped device.
+    //!
+    err flush();
+
+private:
+    enum : size_t
+    {
+        max_chunk   = 128,  //!< Longest literal or run.
+        min_run     = 3,    //!< Shortest run worth encoding.
+    };
+
+    //! Encodes pending run, keeping short runs as literals.
+    bool end_run();
+
+    //! Sends pending literals.
+    bool send_literals();
+
+    //! Sends pending run.
+    bool send_run();
+
+    uint8_t m_lit[max_chunk];   //!< Pending literal bytes.
+    size_t  m_lit_len = 0;      //!< Amount of pending literal bytes.
+    uint8_t m_run_byte = 0;     //!< Byte of pending run.
+    size_t  m_run_len = 0;      //!< Length of pending run.
+    size_t  m_copy_left = 0;    //!< Literal bytes left to decode.
+    size_t  m_fill_left = 0;    //!< Run bytes left to decode.
+    uint8_t m_fill_byte = 0;    //!< Byte of run being decoded.
+};
+
+//!
+//! \brief Copies traffic of a device into another device, i.e. to log it.
+//! Bytes written to the device and bytes read from it go to the sink.
+//! Sink failures don't affect traffic.
+//! \tparam Dev  Wrapped device.
+//! \tparam Sink Writable device, receiving copy of traffic.
+//!
+template< class Dev, class Sink >
+class tee : public iowrap_base< Dev >
+{
+    static_assert(is_writable< Sink >::value, "Sink must be writable");
+
+    using base = iowrap_base< Dev >;
+
+public:
+    using base::base;
+
+    //! \copydoc ecl::bus_pipe::write()
+    ssize_t write(const uint8_t *data, size_t count);
+
+    //! \copydoc ecl::bus_pipe::read()
+    ssize_t read(uint8_t *buffer, size_t count);
+
+    //!
+    //! \brief Initializes wrapped device and the sink.
+    //!
+    err init();
+
+    //!
+    //! \brief Flushes wrapped device and the sink.
+    //!
+    err flush();
+
+    //!
+    //! \brief Gets the sink.
+    //!
+    Sink &sink() { return m_sink; }
+
+private:
+    Sink m_sink; //!< Receiver of traffic copy.
+};
+
+//------------------------------------------------------------------------------
+
+template< class Dev, size_t size >
+ssize_t buffered< Dev, size >::write(const uint8_t *data, size_t count)
+{
+    size_t accepted = 0;
+
+    while (accepted < count) {
+        size_t left = count - accepted;
+
+        if (!m_tx_len && left >= size) {
+            // Buffer would only add a copy
+            auto rc = this->m_dev.write(data + accepted, left);
+            if (rc <= 0) {
+                break;
+            }
+
+            accepted += rc;
+            continue;
+        }
+
+        size_t chunk = std::min(left, size - m_tx_len);
+        std::copy(data + accepted, data + accepted + chunk, m_tx + m_tx_len);
+        m_tx_len += chunk;
+        accepted += chunk;
+
+        if (m_tx_len == size && flush() != err::ok) {
+            break;
+        }
+    }
+
+    return accepted ? static_cast< ssize_t >(accepted) : (count ? -1 : 0);
+}
+
+template< class Dev, size_t size >
+ssize_t buffered< Dev, size >::read(uint8_t *buffer, size_t count)
+{
+    if (m_rx_pos == m_rx_len) {
+        if (count >= size) {
+            return this->m_dev.read(buffer, count);
+        }
+
+        auto rc = this->m_dev.read(m_rx, size);
+        if (rc <= 0) {
+            return rc;
+        }
+
+        m_rx_pos = 0;
+        m_rx_len = rc;
+    }
+
+    size_t chunk = std::min(count, m_rx_len - m_rx_pos);
+    std::copy(m_rx + m_rx_pos, m_rx + m_rx_pos + chunk, buffer);
+    m_rx_pos += chunk;
+
+    return chunk;
+}
+
+template< class Dev, size_t size >
+err buffered< Dev, size >::flush()
+{
+    if (m_tx_len) {
+        bool ok = iowrap_detail::write_all(this->m_dev, m_tx, m_tx_len);
+        m_tx_len = 0;
+
+        if (!ok) {
+            return err::io;
+        }
+    }
+
+    return base::flush();
+}
+
+//------------------------------------------------------------------------------
+
+template< class Dev >
+ssize_t crc< Dev >::write(const uint8_t *data, size_t count)
+{
+    auto rc = this->m_dev.write(data, count);
+    if (rc > 0) {
+        m_tx_crc = crc16(data, rc, m_tx_crc);
+    }
+
+    return rc;
+}
+
+template< class Dev >
+ssize_t crc< Dev >::read(uint8_t *buffer, size_t count)
+{
+    auto rc = this->m_dev.read(buffer, count);
+    if (rc > 0) {
+        m_rx_crc = crc16(buffer, rc, m_rx_crc);
+    }
+
+    return rc;
+}
+
+//------------------------------------------------------------------------------
+
+template< class Dev >
+ssize_t framed< Dev >::write(const uint8_t *data, size_t count)
+{
+    // Encoded in chunks, room for escaped byte and END is kept
+    uint8_t chunk[32];
+    size_t len = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (data[i] == end) {
+            chunk[len++] = esc;
+            chunk[len++] = esc_end;
+        } else if (data[i] == esc) {
+            chunk[len++] = esc;
+            chunk[len++] = esc_esc;
+        } else {
+            chunk[len++] = data[i];
+        }
+
+        if (len >= sizeof(chunk) - 2) {
+            if (!iowrap_detail::write_all(this->m_dev, chunk, len)) {
+                return -1;
+            }
+
+            len = 0;
+        }
+    }
+
+    chunk[len++] = end;
+
+    if (!iowrap_detail::write_all(this->m_dev, chunk, len)) {
+        return -1;
+    }
+
+    return count;
+}
+
+template< class Dev >
+ssize_t framed< Dev >::read(uint8_t *buffer, size_t count)
+{
+    size_t len = 0;
+    bool overflow = false;
+    uint8_t byte;
+
+    while (true) {
+        if (!get(byte)) {
+            return -1;
+        }
+
+        if (byte == end) {
+            if (overflow) {
+                return -1;
+            }
+
+            if (len) {
+                return len;
+            }
+
+            // Empty frame, usually END sent to flush line noise
+            continue;
+        }
+
+        if (byte == esc) {
+            if (!get(byte)) {
+                return -1;
+            }
+
+            // Protocol violation is passed as is, as RFC suggests
+            if (byte == esc_end) {
+                byte = end;
+            } else if (byte == esc_esc) {
+                byte = esc;
+            }
+        }
+
+        if (len < count) {
+            buffer[len++] = byte;
+        } else {
+            overflow = true;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template< class Dev >
+ssize_t packbits< Dev >::write(const uint8_t *data, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (m_run_len && data[i] == m_run_byte && m_run_len < max_chunk) {
+            ++m_run_len;
+            continue;
+        }
+
+        if (m_run_len && !end_run()) {
+            return -1;
+        }
+
+        m_run_byte = data[i];
+        m_run_len = 1;
+    }
+
+    return count;
+}
+
+template< class Dev >
+ssize_t packbits< Dev >::read(uint8_t *buffer, size_t count)
+{
+    size_t produced = 0;
+
+    while (produced < count) {
+        if (m_fill_left) {
+            size_t chunk = std::min(m_fill_left, count - produced);
+            std::fill_n(buffer + produced, chunk, m_fill_byte);
+            m_fill_left -= chunk;
+            produced += chunk;
+        } else if (m_copy_left) {
+            auto rc = this->m_dev.read(buffer + produced, std::min(m_copy_left, count - produced));
+            if (rc <= 0) {
+                return produced ? static_cast< ssize_t >(produced) : rc;
+            }
+
+            m_copy_left -= rc;
+            produced += rc;
+        } else if (produced) {
+            // Decoded bytes are returned before device is asked for more
+            break;
+        } else {
+            uint8_t header;
+            auto rc = this->m_dev.read(&header, 1);
+            if (rc <= 0) {
+                return rc;
+            }
+
+            auto n = static_cast< int8_t >(header);
+
+            if (n >= 0) {
+                m_copy_left = n + 1;
+            } else if (n != -128) {
+                rc = this->m_dev.read(&m_fill_byte, 1);
+                if (rc <= 0) {
+                    return -1;
+                }
+
+                m_fill_left = 1 - n;
+            }
+        }
+    }
+
+    return produced;
+}
+
+template< class Dev >
+err packbits< Dev >::flush()
+{
+    if (m_run_len && !end_run()) {
+        return err::io;
+    }
+
+    if (m_lit_len && !send_literals()) {
+        return err::io;
+    }
+
+    return base::flush();
+}
+
+//------------------------------------------------------------------------------
+// Private members
+
+template< class Dev >
+bool packbits< Dev >::end_run()
+{
+    bool ok = true;
+
+    if (m_run_len >= min_run) {
+        ok = (!m_lit_len || send_literals()) && send_run();
+    } else {
+        for (size_t i = 0; i < m_run_len && ok; ++i) {
+            m_lit[m_lit_len++] = m_run_byte;
+            if (m_lit_len == max_chunk) {
+                ok = send_literals();
+            }
+        }
+    }
+
+    m_run_len = 0;
+    return ok;
+}
+
+template< class Dev >
+bool packbits< Dev >::send_literals()
+{
+    uint8_t header = m_lit_len - 1;
+    size_t len = m_lit_len;
+    m_lit_len = 0;
+
+    return iowrap_detail::write_all(this->m_dev, &header, 1)
+            && iowrap_detail::write_all(this->m_dev, m_lit, len);
+}
+
+template< class Dev >
+bool packbits< Dev >::send_run()
+{
+    uint8_t chunk[2] = { static_cast< uint8_t >(1 - static_cast< int >(m_run_len)), m_run_byte };
+
+    return iowrap_detail::write_all(this->m_dev, chunk, sizeof(chunk));
+}
+
+//------------------------------------------------------------------------------
+
+template< class Dev, class Sink >
+ssize_t tee< Dev, Sink >::write(const uint8_t *data, size_t count)
+{
+    auto rc = this->m_dev.write(data, count);
+    if (rc > 0) {
+        iowrap_detail::write_all(m_sink, data, rc);
+    }
+
+    return rc;
+}
+
+template< class Dev, class Sink >
+ssize_t tee< Dev, Sink >::read(uint8_t *buffer, size_t count)
+{
+    auto rc = this->m_dev.read(buffer, count);
+    if (rc > 0) {
+        iowrap_detail::write_all(m_sink, buffer, rc);
+    }
+
+    return rc;
+}
+
+template< class Dev, class Sink >
+err tee< Dev, Sink >::init()
+{
+    auto rc = iodev_init(m_sink);
+    return rc == err::ok ? base::init() : rc;
+}
+
+template< class Dev, class Sink >
+err tee< Dev, Sink >::flush()
+{
+    iodev_flush(m_sink);
+    return base::flush();
+}
+
+} // namespace ecl
+
+#endif // SYS_IOWRAP_IOWRAP_HPP_
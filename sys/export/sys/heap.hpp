@@ -0,0 +1,30 @@
+#ifndef SYS_HEAP_HPP_
+#define SYS_HEAP_HPP_
+
+//!
+//! \file
+//! \brief Global heap, backed by ecl pools.
+//! Available if CONFIG_SYS_HEAP is set. Global operator new and delete
+//! are routed to a set of size classes, instead of newlib malloc.
+//!
+
+#include <ecl/pool.hpp>
+
+namespace ecl
+{
+
+//! Count of heap size classes.
+constexpr size_t heap_classes = 3;
+
+//!
+//! \brief Gets usage counters of a heap size class.
+//! Units are blocks of the class. Each allocation also carries a small
+//! header with its size, so it can be released by unsized delete.
+//! \param[in] idx Class index, from the smallest to the largest block.
+//!                Must be less than heap_classes.
+//!
+pool_stats heap_stats(size_t idx);
+
+} // namespace ecl
+
+#endif // SYS_HEAP_HPP_
@@ -0,0 +1,93 @@
+#ifndef SYS_INIT_HPP_
+#define SYS_INIT_HPP_
+
+//!
+//! \file
+//! \brief Startup statistics.
+//! Available if CONFIG_SYS_INIT_STATS is set. Time is measured with DWT
+//! cycle counter from entry to core_main() till the kernel starts: per
+//! startup phase and per global constructor. Heavy globals that are not
+//! needed right away can be made lazy with ecl::static_instance, to reduce
+//! that time. Startup code, that runs before core_main(), i.e. copy of
+//! data and SystemInit(), is not measured.
+//!
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecl
+{
+
+//!
+//! \brief Statistics of global constructors.
+//!
+struct init_stats
+{
+    size_t      count;  //!< Amount of init array entries.
+    uint32_t    cycles; //!< CPU cycles spent running them.
+};
+
+//!
+//! \brief Gets statistics of global constructors, collected at startup.
+//!
+init_stats get_init_stats();
+
+//!
+//! \brief Startup phases, in order of execution.
+//!
+enum class boot_phase
+{
+    platform,   //!< platform_init()
+    board,      //!< board_init()
+    kernel,     //!< kernel_init()
+    ctors,      //!< Global constructors.
+    irq,        //!< IRQ_manager::init()
+    console,    //!< Console initialization.
+    count,      //!< Amount of phases.
+};
+
+//!
+//! \brief Time spent in startup phases.
+//!
+struct boot_profile
+{
+    //! CPU cycles of every phase, indexed by boot_phase.
+    uint32_t    phase_cycles[static_cast< size_t >(boot_phase::count)];
+    //! CPU cycles from entry to core_main() till kernel_main() call.
+    uint32_t    total_cycles;
+};
+
+//!
+//! \brief Time spent in a global constructor.
+//! Constructor is an entry of init array. Use addr2line to get its name.
+//!
+struct init_entry
+{
+    uintptr_t   fn;     //!< Address of the init array entry.
+    uint32_t    cycles; //!< CPU cycles spent running it.
+};
+
+//!
+//! \brief Gets time spent in startup phases.
+//!
+boot_profile get_boot_profile();
+
+//!
+//! \brief Gets time spent in every global constructor.
+//! Only first CONFIG_SYS_INIT_STATS_ENTRIES constructors are recorded.
+//! Rest of them are accounted in init_stats and boot_profile only.
+//! \param[out] count Amount of recorded entries.
+//! \return Entries, in order of execution.
+//!
+const init_entry *get_init_entries(size_t &count);
+
+//!
+//! \brief Prints startup phases and the slowest constructors to the console.
+//! Time is printed in microseconds as well, using current core clock.
+//! \param[in] top Amount of constructors to print.
+//!
+void print_boot_profile(size_t top = 8);
+
+} // namespace ecl
+
+#endif // SYS_INIT_HPP_
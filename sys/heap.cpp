@@ -0,0 +1,116 @@
+#include <sys/heap.hpp>
+
+#include <ecl/size_class_pool.hpp>
+#include <ecl/static_instance.hpp>
+#include <platform/irq_manager.hpp>
+
+#include <cstddef>
+#include <new>
+
+namespace
+{
+
+// Heap is used from ISR as well, e.g. by std::function copies,
+// thus pools are protected by critical sections.
+using heap_type = ecl::size_class_pool<
+    ecl::pool< 16,  CONFIG_SYS_HEAP_SMALL_BLOCKS,   IRQ_lock >,
+    ecl::pool< 64,  CONFIG_SYS_HEAP_MEDIUM_BLOCKS,  IRQ_lock >,
+    ecl::pool< 256, CONFIG_SYS_HEAP_LARGE_BLOCKS,   IRQ_lock > >;
+
+static_assert(heap_type::classes == ecl::heap_classes, "Heap classes are out of sync");
+
+// Allocations are made in these units. First unit holds unit count.
+using unit = std::max_align_t;
+
+// Global constructors may allocate before heap constructor would run,
+// so heap is constructed on first use.
+ecl::static_instance< heap_type > heap;
+
+heap_type &get_heap()
+{
+    return heap.get();
+}
+
+void *heap_alloc(size_t sz)
+{
+    size_t n = (sz + sizeof(unit) - 1) / sizeof(unit) + 1;
+    auto p = get_heap().aligned_alloc< unit >(n);
+
+    if (!p) {
+        return nullptr;
+    }
+
+    *reinterpret_cast< size_t * >(p) = n;
+    return p + 1;
+}
+
+void heap_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    auto p = static_cast< unit * >(ptr) - 1;
+    get_heap().deallocate(p, *reinterpret_cast< size_t * >(p));
+}
+
+void *heap_alloc_or_die(size_t sz)
+{
+    auto p = heap_alloc(sz);
+
+    if (!p) {
+        // Abort - out of memory
+        for (;;);
+    }
+
+    return p;
+}
+
+} // namespace
+
+ecl::pool_stats ecl::heap_stats(size_t idx)
+{
+    return get_heap().class_stats(idx);
+}
+
+//------------------------------------------------------------------------------
+
+void *operator new(size_t sz)
+{
+    return heap_alloc_or_die(sz);
+}
+
+void *operator new[](size_t sz)
+{
+    return heap_alloc_or_die(sz);
+}
+
+void *operator new(size_t sz, const std::nothrow_t &)
+{
+    return heap_alloc(sz);
+}
+
+void *operator new[](size_t sz, const std::nothrow_t &)
+{
+    return heap_alloc(sz);
+}
+
+void operator delete(void *p)
+{
+    heap_free(p);
+}
+
+void operator delete[](void *p)
+{
+    heap_free(p);
+}
+
+void operator delete(void *p, size_t)
+{
+    heap_free(p);
+}
+
+void operator delete[](void *p, size_t)
+{
+    heap_free(p);
+}
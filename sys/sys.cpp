@@ -4,6 +4,10 @@
 #include <platform/irq_manager.hpp>
 #include <ecl/iostream.hpp>
 
+#include <sys/init.hpp>
+
+// With heap enabled, delete is provided by heap.cpp
+#ifndef CONFIG_SYS_HEAP
 // TODO: move it somewhere
 void operator delete(void *)
 {
@@ -17,6 +21,7 @@ void operator delete(void *, unsigned int)
     // Abort - delete is forbidden
     for (;;);
 }
+#endif
 
 
 #if UINT32_MAX == UINTPTR_MAX
@@ -35,38 +40,149 @@ void __stack_chk_fail(void)
     for(;;);
 }
 
+#ifdef CONFIG_SYS_INIT_STATS
+static ecl::boot_profile boot;
+static ecl::init_entry init_entries[CONFIG_SYS_INIT_STATS_ENTRIES];
+static size_t init_entries_count;
+
+ecl::init_stats ecl::get_init_stats()
+{
+    extern uint32_t ___init_array_start;
+    extern uint32_t ___init_array_end;
+
+    return init_stats{
+        static_cast< size_t >(&___init_array_end - &___init_array_start),
+        boot.phase_cycles[static_cast< size_t >(boot_phase::ctors)]
+    };
+}
+
+ecl::boot_profile ecl::get_boot_profile()
+{
+    return boot;
+}
+
+const ecl::init_entry *ecl::get_init_entries(size_t &count)
+{
+    count = init_entries_count;
+    return init_entries;
+}
+
+void ecl::print_boot_profile(size_t top)
+{
+    static const char *names[] = {
+        "platform", "board", "kernel", "ctors", "irq", "console"
+    };
+
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast< size_t >(boot_phase::count),
+                  "Every phase must have a name");
+
+    // Cycles of boot are converted with the clock, that is used now.
+    // Clock is set up by SystemInit(), before any phase, so it is the same.
+    uint32_t mhz = SystemCoreClock / 1000000;
+    if (!mhz) {
+        mhz = 1;
+    }
+
+    ecl::cout << "boot phase       cycles       us" << ecl::endl;
+    for (size_t i = 0; i < static_cast< size_t >(boot_phase::count); ++i) {
+        ecl::cout << ecl::setw(10) << names[i]
+                  << ecl::setw(13) << boot.phase_cycles[i]
+                  << ecl::setw(9) << boot.phase_cycles[i] / mhz << ecl::endl;
+    }
+    ecl::cout << ecl::setw(10) << "total"
+              << ecl::setw(13) << boot.total_cycles
+              << ecl::setw(9) << boot.total_cycles / mhz << ecl::endl;
+
+    // Slowest constructors first, without reordering the record
+    bool printed[CONFIG_SYS_INIT_STATS_ENTRIES] = {};
+
+    ecl::cout << "constructor      cycles       us" << ecl::endl;
+    for (size_t n = 0; n < top && n < init_entries_count; ++n) {
+        size_t slowest = init_entries_count;
+        for (size_t i = 0; i < init_entries_count; ++i) {
+            if (!printed[i] && (slowest == init_entries_count
+                                || init_entries[i].cycles > init_entries[slowest].cycles)) {
+                slowest = i;
+            }
+        }
+
+        printed[slowest] = true;
+        const auto &e = init_entries[slowest];
+
+        ecl::cout << ecl::setw(8) << ecl::setfill('0')
+                  << reinterpret_cast< const void* >(e.fn) << ecl::setfill(' ')
+                  << ecl::setw(13) << e.cycles
+                  << ecl::setw(9) << e.cycles / mhz << ecl::endl;
+    }
+}
+#endif
+
 extern "C" void platform_init();
 extern "C" void board_init();
 extern "C" void kernel_init();
 extern "C" void kernel_main();
 
-namespace ecl {
-extern typename istream< console_driver >::device_type console_device;
-}
-
-extern "C" void core_main(void)
+// Runs global constructors
+static void init_array()
 {
-    platform_init();
-    board_init();
-    kernel_init();
-
 	extern uint32_t ___init_array_start;
 	extern uint32_t ___init_array_end;
 
 	for (uint32_t *p = &___init_array_start; p < &___init_array_end; ++p) {
+#ifdef CONFIG_SYS_INIT_STATS
+		uint32_t start = DWT->CYCCNT;
+#endif
+
 		// Iterator points to a memory which contains an address of a
 		// initialization function.
 		// Equivalent of:
 		// void (*fn)() = p;
 		// fn();
 		((void (*)()) *p)();
-    }
 
-    IRQ_manager::init();
+#ifdef CONFIG_SYS_INIT_STATS
+		if (init_entries_count < CONFIG_SYS_INIT_STATS_ENTRIES) {
+			init_entries[init_entries_count++] = { *p, DWT->CYCCNT - start };
+		}
+#endif
+	}
+}
+
+// Runs startup phase and measures time spent in it
+static inline void boot_step(ecl::boot_phase phase, void (*fn)())
+{
+#ifdef CONFIG_SYS_INIT_STATS
+    uint32_t start = DWT->CYCCNT;
+    fn();
+    boot.phase_cycles[static_cast< size_t >(phase)] = DWT->CYCCNT - start;
+#else
+    (void) phase;
+    fn();
+#endif
+}
+
+extern "C" void core_main(void)
+{
+#ifdef CONFIG_SYS_INIT_STATS
+    // Cycle counter is a part of debug unit, which must be enabled first
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    uint32_t start = DWT->CYCCNT;
+#endif
+
+    boot_step(ecl::boot_phase::platform, platform_init);
+    boot_step(ecl::boot_phase::board, board_init);
+    boot_step(ecl::boot_phase::kernel, kernel_init);
+    boot_step(ecl::boot_phase::ctors, init_array);
+    boot_step(ecl::boot_phase::irq, IRQ_manager::init);
 
     // Due to undefined static init order, this initialization is placed here
-    ecl::console_device.init();
+    boot_step(ecl::boot_phase::console, ecl::init_console);
 
+#ifdef CONFIG_SYS_INIT_STATS
+    boot.total_cycles = DWT->CYCCNT - start;
+#endif
 
     kernel_main();
 }
@@ -39,7 +39,20 @@ set(CC_PLATFORM_FLAGS "-ffreestanding -mcpu=cortex-m4 -mthumb -fdata-sections \
 set(CXX_PLATFORM_FLAGS "-fno-use-cxa-atexit -fno-exceptions -fno-rtti ${CC_PLATFORM_FLAGS}")
 
 # TODO: move std and gdwarf flags out of toolchain into the core listfile itself
-set(C_CXX_EXTRA_FLAGS "-gdwarf-2 -mfpu=fpv4-sp-d16 -mfloat-abi=softfp")
+# Float ABI and FPU use, in one option:
+#	soft   - no FPU, float math is done by library routines
+#	softfp - FPU is used, float arguments are passed in core registers,
+#	         so objects built without FPU can be linked in
+#	hard   - FPU is used, float arguments are passed in FPU registers.
+#	         Fastest, all objects must be built with it. Set it to compare
+#	         with the Clang build as well.
+# Unless soft is set, FPU is enabled on startup with lazy stacking, and FreeRTOS
+# saves FPU context of threads, that used FPU, only. See kernel/freertos.
+set(CONFIG_FLOAT_ABI softfp CACHE STRING "Float ABI: soft, softfp or hard")
+if (NOT CONFIG_FLOAT_ABI MATCHES "^(soft|softfp|hard)$")
+	message(FATAL_ERROR "Unknown float ABI: ${CONFIG_FLOAT_ABI}")
+endif()
+set(C_CXX_EXTRA_FLAGS "-gdwarf-2 -mfpu=fpv4-sp-d16 -mfloat-abi=${CONFIG_FLOAT_ABI}")
 set(CC_EXTRA_FLAGS "-std=c99 ${C_CXX_EXTRA_FLAGS}")
 set(CXX_EXTRA_FLAGS "-std=c++14 ${C_CXX_EXTRA_FLAGS}")
 
@@ -65,10 +78,14 @@ set(CMAKE_C_FLAGS_DEBUG  "-O0 -g3 " CACHE STRING "Debug C flags")
 set(CMAKE_CXX_FLAGS_DEBUG ${CMAKE_C_FLAGS_DEBUG} CACHE STRING "Debug C++ flags")
 
 set(CMAKE_OBJCOPY arm-none-eabi-objcopy CACHE STRING "Objcopy executable")
+set(CMAKE_SIZE arm-none-eabi-size CACHE STRING "Size executable")
+set(CMAKE_NM arm-none-eabi-nm CACHE STRING "Nm executable")
 
+# Float ABI of startup code must match the rest of objects
 set(CMAKE_ASM-ATT_COMPILE_OBJECT
-  "<CMAKE_ASM-ATT_COMPILER> -mcpu=cortex-m4 -o <OBJECT> <SOURCE>")
+  "<CMAKE_ASM-ATT_COMPILER> -mcpu=cortex-m4 -mfpu=fpv4-sp-d16 -mfloat-abi=${CONFIG_FLOAT_ABI} -o <OBJECT> <SOURCE>")
+# Map file is placed next to the image, see footprint target in build_api.cmake
 set(CMAKE_C_LINK_EXECUTABLE
-	"${CMAKE_C_LINKER} <OBJECTS> <CMAKE_C_LINK_FLAGS> <LINK_LIBRARIES> -o <TARGET>")
+	"${CMAKE_C_LINKER} <OBJECTS> <CMAKE_C_LINK_FLAGS> <LINK_LIBRARIES> -Wl,-Map=<TARGET>.map -o <TARGET>")
 set(CMAKE_CXX_LINK_EXECUTABLE
-	"${CMAKE_CXX_LINKER} <OBJECTS> <CMAKE_CXX_LINK_FLAGS> <LINK_LIBRARIES> -o <TARGET>")
+	"${CMAKE_CXX_LINKER} <OBJECTS> <CMAKE_CXX_LINK_FLAGS> <LINK_LIBRARIES> -Wl,-Map=<TARGET>.map -o <TARGET>")
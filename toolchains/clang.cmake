@@ -7,17 +7,87 @@ set(CMAKE_SYSTEM_NAME Generic)
 set(CMAKE_SYSTEM_VERSION 1)
 
 # specify the cross compiler
-# there is no LLVM linker that can work with linker script and true
-# bare metal (or, maybe, I didn't google'd enough?)
-set(CMAKE_C_LINKER arm-none-eabi-ld)
 CMAKE_FORCE_C_COMPILER(clang Clang)
 CMAKE_FORCE_CXX_COMPILER(clang++ Clang)
 
+# Startup code is written for GNU assembler, binutils of ARM GCC are used
+# for the rest of tools as well
+set(CMAKE_ASM-ATT_COMPILER arm-none-eabi-as)
+
 # where is the target environment
-set(CMAKE_FIND_ROOT_PATH /usr/bin)
+set(CMAKE_FIND_ROOT_PATH /usr/arm-none-eabi)
 
 # search for programs in the build host directories
 set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
 # for libraries and headers in the target directories
 set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
-set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
\ No newline at end of file
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
+
+################################################################################
+# Flags and definitions used with Clang
+
+# Headers of newlib, shipped with ARM GCC, are used
+execute_process(COMMAND arm-none-eabi-gcc -print-sysroot
+	OUTPUT_VARIABLE ARM_GCC_SYSROOT
+	OUTPUT_STRIP_TRAILING_WHITESPACE)
+
+# Hard float ABI passes floats in FPU registers. Must match the one
+# of the GCC build to compare binaries. See CONFIG_FLOAT_ABI in arm-cm4-gnu.cmake
+# for other values.
+set(CONFIG_FLOAT_ABI hard CACHE STRING "Float ABI: soft, softfp or hard")
+if (NOT CONFIG_FLOAT_ABI MATCHES "^(soft|softfp|hard)$")
+	message(FATAL_ERROR "Unknown float ABI: ${CONFIG_FLOAT_ABI}")
+endif()
+
+# avoid using any additional flags when linking with shared libraries
+set(CMAKE_SHARED_LIBRARY_LINK_C_FLAGS "")
+
+# common flags for current platform
+set(CC_PLATFORM_FLAGS "--target=arm-none-eabi -mcpu=cortex-m4 -mthumb \
+	-mfpu=fpv4-sp-d16 -mfloat-abi=${CONFIG_FLOAT_ABI} --sysroot=${ARM_GCC_SYSROOT} \
+	-ffreestanding -fdata-sections -ffunction-sections -fno-common")
+
+# -fno-use-cxa-atexit helps resolve issue with DSO handle undefined reference
+set(CXX_PLATFORM_FLAGS "-fno-use-cxa-atexit -fno-exceptions -fno-rtti ${CC_PLATFORM_FLAGS}")
+
+set(C_CXX_EXTRA_FLAGS "-gdwarf-2")
+set(CC_EXTRA_FLAGS "-std=c99 ${C_CXX_EXTRA_FLAGS}")
+set(CXX_EXTRA_FLAGS "-std=c++14 ${C_CXX_EXTRA_FLAGS}")
+
+# Supported modes are normal, release, debug and minimum size
+# Normal mode
+set(CMAKE_C_FLAGS
+	"${CMAKE_C_FLAGS} ${CC_PLATFORM_FLAGS} ${CC_WARN_FLAGS} ${CC_EXTRA_FLAGS}"
+	CACHE STRING "C flags")
+set(CMAKE_CXX_FLAGS
+	"${CMAKE_CXX_FLAGS} ${CXX_PLATFORM_FLAGS} ${CC_WARN_FLAGS} ${CXX_EXTRA_FLAGS}"
+	CACHE STRING "C++ flags")
+
+# Release flags, optimization is on,
+set(CMAKE_C_FLAGS_RELEASE "-O3 -flto " CACHE STRING "Release C flags")
+set(CMAKE_CXX_FLAGS_RELEASE ${CMAKE_C_FLAGS_RELEASE})
+
+# Minimum size release flags, LTO and minimum size
+set(CMAKE_C_FLAGS_MINSIZEREL "-Oz -flto ")
+set(CMAKE_CXX_FLAGS_MINSIZEREL ${CMAKE_C_FLAGS_MINSIZEREL})
+
+# Debug mode, no LTO and maximum debug info
+set(CMAKE_C_FLAGS_DEBUG  "-O0 -g3 " CACHE STRING "Debug C flags")
+set(CMAKE_CXX_FLAGS_DEBUG ${CMAKE_C_FLAGS_DEBUG} CACHE STRING "Debug C++ flags")
+
+set(CMAKE_OBJCOPY arm-none-eabi-objcopy CACHE STRING "Objcopy executable")
+set(CMAKE_SIZE arm-none-eabi-size CACHE STRING "Size executable")
+set(CMAKE_NM arm-none-eabi-nm CACHE STRING "Nm executable")
+
+# Archives must be readable by LLD, when LTO is used
+set(CMAKE_AR llvm-ar CACHE STRING "Archiver executable")
+set(CMAKE_RANLIB llvm-ranlib CACHE STRING "Ranlib executable")
+
+# Float ABI of startup code must match the rest of objects
+set(CMAKE_ASM-ATT_COMPILE_OBJECT
+  "<CMAKE_ASM-ATT_COMPILER> -mcpu=cortex-m4 -mfpu=fpv4-sp-d16 -mfloat-abi=${CONFIG_FLOAT_ABI} -o <OBJECT> <SOURCE>")
+# Map file is placed next to the image, see footprint target in build_api.cmake
+set(CMAKE_C_LINK_EXECUTABLE
+	"<CMAKE_C_COMPILER> <FLAGS> <OBJECTS> <CMAKE_C_LINK_FLAGS> <LINK_LIBRARIES> -Wl,-Map=<TARGET>.map -o <TARGET>")
+set(CMAKE_CXX_LINK_EXECUTABLE
+	"<CMAKE_CXX_COMPILER> <FLAGS> <OBJECTS> <CMAKE_CXX_LINK_FLAGS> <LINK_LIBRARIES> -Wl,-Map=<TARGET>.map -o <TARGET>")